@@ -413,6 +413,12 @@ class RqlQuery(object):
     def avg(self, *args):
         return Avg(self, *[func_wrap(arg) for arg in args])
 
+    def approx_count_distinct(self, *args):
+        return ApproxCountDistinct(self, *[func_wrap(arg) for arg in args])
+
+    def approx_quantile(self, *args):
+        return ApproxQuantile(self, *[func_wrap(arg) for arg in args])
+
     def min(self, *args, **kwargs):
         return Min(self, *[func_wrap(arg) for arg in args], **kwargs)
 
@@ -1262,6 +1268,16 @@ class Avg(RqlMethodQuery):
     st = 'avg'
 
 
+class ApproxCountDistinct(RqlMethodQuery):
+    tt = pTerm.APPROX_COUNT_DISTINCT
+    st = 'approx_count_distinct'
+
+
+class ApproxQuantile(RqlMethodQuery):
+    tt = pTerm.APPROX_QUANTILE
+    st = 'approx_quantile'
+
+
 class Min(RqlMethodQuery):
     tt = pTerm.MIN
     st = 'min'
@@ -1655,6 +1671,11 @@ class Range(RqlTopLevelQuery):
     st = 'range'
 
 
+class Chunks(RqlTopLevelQuery):
+    tt = pTerm.CHUNKS
+    st = 'chunks'
+
+
 class ToISO8601(RqlMethodQuery):
     tt = pTerm.TO_ISO8601
     st = 'to_iso8601'
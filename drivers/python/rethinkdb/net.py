@@ -457,12 +457,32 @@ class ConnectionInstance(object):
             self._socket.close()
             self._header_in_progress = None
 
+    def run_query_with_chunks(self, query, noreply, chunks):
+        # The chunks follow the query without waiting for replies.  When the server
+        # has no room for more of them it stops reading from the connection, so
+        # `sendall` blocks until the query catches up.
+        self._socket.sendall(query.serialize(self._parent._get_json_encoder(query)))
+        for chunk in chunks:
+            chunk = list(chunk)
+            if len(chunk) > 0:
+                self._send_chunk(query, chunk)
+        self._send_chunk(query, [])
+        if noreply:
+            return None
+        return self._handle_response(query)
+
+    def _send_chunk(self, query, docs):
+        chunk_query = Query(pQuery.CHUNK, query.token, docs, {'noreply': True})
+        self._socket.sendall(
+            chunk_query.serialize(self._parent._get_json_encoder(chunk_query)))
+
     def run_query(self, query, noreply):
         self._socket.sendall(query.serialize(self._parent._get_json_encoder(query)))
         if noreply:
             return None
+        return self._handle_response(query)
 
-        # Get response
+    def _handle_response(self, query):
         res = self._read_response(query)
 
         if res.type == pResponse.SUCCESS_ATOM:
@@ -629,7 +649,13 @@ class Connection(object):
         self.check_open()
         if 'db' in global_optargs or self.db is not None:
             global_optargs['db'] = DB(global_optargs.get('db', self.db))
+        # `chunks` is an iterable of lists of documents, which the query reads
+        # with `r.chunks()`.
+        chunks = global_optargs.pop('chunks', None)
         q = Query(pQuery.START, self._new_token(), term, global_optargs)
+        if chunks is not None:
+            return self._instance.run_query_with_chunks(
+                q, global_optargs.get('noreply', False), chunks)
         return self._instance.run_query(q, global_optargs.get('noreply', False))
 
     def _continue(self, cursor):
@@ -3,6 +3,7 @@
 __all__ = [
     'js', 'http', 'json', 'args', 'error', 'random', 'do', 'row', 'branch',
     'union', 'map', 'object', 'binary', 'uuid', 'type_of', 'info', 'range',
+    'chunks',
     'literal', 'asc', 'desc',
     'db', 'db_create', 'db_drop', 'db_list',
     'table', 'table_create', 'table_drop', 'table_list', 'grant',
@@ -241,6 +242,10 @@ def range(*args):
     return ast.Range(*args)
 
 
+def chunks():
+    return ast.Chunks()
+
+
 def time(*args):
     return ast.Time(*args)
 
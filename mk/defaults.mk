@@ -106,6 +106,11 @@ FULL_PERFMON ?= 0
 # Turn on the coroutine profiler
 CORO_PROFILING ?= 0
 
+# Compile in the --inject-disk-faults and --inject-network-faults options in release
+# builds too (debug builds always have them). For benchmarking on slow disks and
+# links; don't use it in production.
+FAULT_INJECTION ?= 0
+
 # Sign the DSC file
 SIGN_PACKAGE ?= 1
 
@@ -130,9 +135,16 @@ UGLIFY ?= 1
 # such as oprofile.
 NO_OMIT_FRAME_POINTER ?= 0
 
+# Use RapidJSON's SSE4.2 code to skip whitespace when parsing JSON. The resulting
+# binary requires a CPU with SSE4.2.
+SIMD_JSON ?= 0
+
 # Check the hash of fetched archives
 VERIFY_FETCH_HASH=1
 
+# Only run the microbenchmarks (`make bench`) whose name contains this string
+BENCHMARK_FILTER ?=
+
 # TODO: Document these variables
 STATIC_LIBGCC ?= 0
 DISABLE_BREAKPOINTS ?= 0
@@ -145,6 +157,7 @@ RT_REDUCE_NATIVE ?= 0
 KEEP_INLINE ?= 0
 NO_EVENTFD ?= 0
 NO_EPOLL ?= 0
+IO_URING_EVENT_QUEUE ?= 0
 UNIT_TEST_FILTER ?= *
 PACKAGE_FOR_SUSE_10 ?= 0
 NO_COMPILE_JS ?= 0
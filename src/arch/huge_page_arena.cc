@@ -0,0 +1,147 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/huge_page_arena.hpp"
+
+#include <stdint.h>
+#ifdef __linux__
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+
+#include "arch/spinlock.hpp"
+#include "config/args.hpp"
+#include "errors.hpp"
+#include "math.hpp"
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE) && !defined(VALGRIND)
+
+static const size_t HUGE_PAGE_SIZE = 2 * MEGABYTE;
+static const size_t NUM_SIZE_CLASSES = MAX_POOLED_BLOCK_BUFFER_SIZE / DEVICE_BLOCK_SIZE;
+
+class huge_page_arena_t {
+public:
+    huge_page_arena_t(char *_begin, size_t size)
+        : begin(_begin), end(_begin + size), next_chunk(0),
+          chunk_size_classes(new uint16_t[size / HUGE_PAGE_SIZE]) { }
+
+    void *allocate(size_t size) {
+        const size_t aligned_size = ceil_aligned(size, DEVICE_BLOCK_SIZE);
+        const size_t size_class = aligned_size / DEVICE_BLOCK_SIZE - 1;
+        size_class_t *sc = &size_classes[size_class];
+        spinlock_acq_t acq(&sc->lock);
+        if (sc->free_buffers != nullptr) {
+            free_buffer_t *buf = sc->free_buffers;
+            sc->free_buffers = buf->next;
+            return buf;
+        }
+        if (static_cast<size_t>(sc->unused_end - sc->unused) < aligned_size) {
+            // What's left of the current chunk is wasted, which is less than one buffer.
+            const size_t offset = next_chunk.fetch_add(HUGE_PAGE_SIZE);
+            if (offset >= static_cast<size_t>(end - begin)) {
+                return nullptr;
+            }
+            chunk_size_classes[offset / HUGE_PAGE_SIZE] = size_class;
+            sc->unused = begin + offset;
+            sc->unused_end = sc->unused + HUGE_PAGE_SIZE;
+        }
+        void *ret = sc->unused;
+        sc->unused += aligned_size;
+        return ret;
+    }
+
+    bool deallocate(void *ptr) {
+        char *p = static_cast<char *>(ptr);
+        if (p < begin || p >= end) {
+            return false;
+        }
+        size_class_t *sc =
+            &size_classes[chunk_size_classes[(p - begin) / HUGE_PAGE_SIZE]];
+        spinlock_acq_t acq(&sc->lock);
+        free_buffer_t *buf = static_cast<free_buffer_t *>(ptr);
+        buf->next = sc->free_buffers;
+        sc->free_buffers = buf;
+        return true;
+    }
+
+private:
+    struct free_buffer_t {
+        free_buffer_t *next;
+    };
+
+    struct size_class_t {
+        size_class_t() : free_buffers(nullptr), unused(nullptr), unused_end(nullptr) { }
+        spinlock_t lock;
+        free_buffer_t *free_buffers;
+        /* The part of this size class's newest chunk that was never handed out */
+        char *unused;
+        char *unused_end;
+    };
+
+    char *const begin;
+    char *const end;
+    std::atomic<size_t> next_chunk;
+    /* Which size class each chunk was handed to. Only chunks below `next_chunk` are
+    valid. */
+    uint16_t *const chunk_size_classes;
+    size_class_t size_classes[NUM_SIZE_CLASSES];
+
+    DISABLE_COPYING(huge_page_arena_t);
+};
+
+/* Set by `enable_huge_page_arena()` before there are other threads, and never
+destroyed, since buffers from it can be freed until the very end. */
+static huge_page_arena_t *arena = nullptr;
+
+bool enable_huge_page_arena(const char **error_out) {
+    guarantee(arena == nullptr);
+    // The reservation is just address space, so we can make it as large as physical
+    // memory without committing to anything.
+    const size_t size = ceil_aligned(
+        static_cast<size_t>(sysconf(_SC_PHYS_PAGES)) * sysconf(_SC_PAGESIZE),
+        HUGE_PAGE_SIZE);
+    void *mapping = mmap(nullptr, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (mapping == MAP_FAILED) {
+        *error_out = "could not reserve address space for it";
+        return false;
+    }
+    // Huge pages have to be aligned to their size.
+    char *begin = reinterpret_cast<char *>(
+        ceil_aligned(reinterpret_cast<uintptr_t>(mapping), HUGE_PAGE_SIZE));
+    if (madvise(begin, size, MADV_HUGEPAGE) != 0) {
+        munmap(mapping, size + HUGE_PAGE_SIZE);
+        *error_out = "transparent huge pages are not supported by the kernel";
+        return false;
+    }
+    arena = new huge_page_arena_t(begin, size);
+    return true;
+}
+
+void *huge_page_arena_allocate(size_t size) {
+    if (arena == nullptr || size == 0 || size > MAX_POOLED_BLOCK_BUFFER_SIZE) {
+        return nullptr;
+    }
+    return arena->allocate(size);
+}
+
+bool huge_page_arena_free(void *ptr) {
+    return arena != nullptr && arena->deallocate(ptr);
+}
+
+#else
+
+bool enable_huge_page_arena(const char **error_out) {
+    *error_out = "huge pages are only supported on Linux";
+    return false;
+}
+
+void *huge_page_arena_allocate(size_t) {
+    return nullptr;
+}
+
+bool huge_page_arena_free(void *) {
+    return false;
+}
+
+#endif
@@ -0,0 +1,31 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef ARCH_HUGE_PAGE_ARENA_HPP_
+#define ARCH_HUGE_PAGE_ARENA_HPP_
+
+#include <stddef.h>
+
+/* With a cache of 100 GB or more, the page cache's block buffers are hundreds of
+millions of small heap allocations spread over as many 4 KiB pages, and missing the TLB
+becomes a noticeable part of the cost of touching a block. With `--huge-pages`, the
+server reserves one large range of address space at startup and asks the kernel to back
+it with transparent 2 MiB huge pages. Every device-block-aligned buffer of up to
+MAX_POOLED_BLOCK_BUFFER_SIZE bytes is then carved out of it.
+
+Each 2 MiB chunk of the arena holds buffers of a single size. A freed buffer goes onto
+the free list for its size instead of back to the operating system, so the arena never
+shrinks. `raw_free_aligned()` recognizes buffers from the arena by their address, so they
+are freed like any other aligned allocation. When the arena is used up, buffers come
+from the heap again. */
+
+/* Must be called before the thread pool starts. Returns false, and sets `*error_out`,
+if the arena couldn't be set up, in which case all buffers keep coming from the heap. */
+bool enable_huge_page_arena(const char **error_out);
+
+/* Returns nullptr if the arena isn't enabled, `size` is too large, or the arena is used
+up. The buffer is DEVICE_BLOCK_SIZE-aligned. */
+void *huge_page_arena_allocate(size_t size);
+
+/* Returns false, without doing anything, if `ptr` isn't from the arena. */
+bool huge_page_arena_free(void *ptr);
+
+#endif  // ARCH_HUGE_PAGE_ARENA_HPP_
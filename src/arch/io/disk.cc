@@ -20,11 +20,14 @@
 #include "arch/types.hpp"
 #include "arch/runtime/thread_pool.hpp"
 #include "arch/runtime/runtime.hpp"
+#include "arch/timing.hpp"
 #include "arch/io/disk/filestat.hpp"
 #include "arch/io/disk/pool.hpp"
+#include "arch/io/disk/uring.hpp"
 #include "arch/io/disk/conflict_resolving.hpp"
 #include "arch/io/disk/stats.hpp"
 #include "arch/io/disk/accounting.hpp"
+#include "arch/io/fault_injection.hpp"
 #include "backtrace.hpp"
 #include "config/args.hpp"
 #include "do_on_thread.hpp"
@@ -50,14 +53,36 @@ public:
     linux_disk_manager_t(linux_event_queue_t *queue,
                          int batch_factor,
                          int max_concurrent_io_requests,
+                         io_backend_t io_backend,
                          perfmon_collection_t *stats) :
         stack_stats(stats, "stack"),
         conflict_resolver(stats),
-        accounter(batch_factor),
+        accounter(batch_factor, stats),
         backend_stats(stats, "backend", accounter.producer),
-        backend(queue, backend_stats.producer, max_concurrent_io_requests),
         outstanding_txn(0)
     {
+        if (io_backend == io_backend_t::io_uring && !uring_diskmgr_t::is_supported()) {
+            logWRN("io_uring is not available on this system, falling back to the "
+                   "thread pool I/O backend.");
+            io_backend = io_backend_t::pool;
+        }
+        switch (io_backend) {
+        case io_backend_t::pool:
+            pool_backend.init(new pool_diskmgr_t(queue, backend_stats.producer,
+                                                 max_concurrent_io_requests));
+            pool_backend->done_fun = std::bind(&stats_diskmgr_2_t::done,
+                                               &backend_stats, ph::_1);
+            break;
+        case io_backend_t::io_uring:
+            uring_backend.init(new uring_diskmgr_t(queue, backend_stats.producer,
+                                                   max_concurrent_io_requests));
+            uring_backend->done_fun = std::bind(&stats_diskmgr_2_t::done,
+                                                &backend_stats, ph::_1);
+            break;
+        default:
+            unreachable();
+        }
+
         /* Hook up the `submit_fun`s of the parts of the IO stack that are above the
         queue. (The parts below the queue use the `passive_producer_t` interface instead
         of a callback function.) */
@@ -66,9 +91,17 @@ public:
         conflict_resolver.submit_fun = std::bind(&accounting_diskmgr_t::submit,
                                                  &accounter, ph::_1);
 
-        /* Hook up everything's `done_fun`. */
-        backend.done_fun = std::bind(&stats_diskmgr_2_t::done, &backend_stats, ph::_1);
+        /* Hook up everything's `done_fun`. (The backend's was set above.) */
         backend_stats.done_fun = std::bind(&accounting_diskmgr_t::done, &accounter, ph::_1);
+#ifdef FAULT_INJECTION_ENABLED
+        const fault_injection_config_t &faults =
+            get_fault_injection_config(fault_injection_target_t::disk);
+        if (faults.is_enabled()) {
+            fault_injector.init(new fault_injector_t(faults));
+            backend_stats.done_fun = std::bind(
+                &linux_disk_manager_t::done_after_injected_delay, this, ph::_1);
+        }
+#endif
         accounter.done_fun = std::bind(&conflict_resolving_diskmgr_t::done,
                                        &conflict_resolver, ph::_1);
         conflict_resolver.done_fun = std::bind(&stats_diskmgr_t::done, &stack_stats, ph::_1);
@@ -81,8 +114,9 @@ public:
                 outstanding_txn);
     }
 
-    void *create_account(int pri, int outstanding_requests_limit) {
-        return new accounting_diskmgr_t::account_t(&accounter, pri, outstanding_requests_limit);
+    void *create_account(io_class_t io_class, int pri, int outstanding_requests_limit) {
+        return new accounting_diskmgr_t::account_t(&accounter, io_class, pri,
+                                                   outstanding_requests_limit);
     }
 
     void destroy_account(void *account) {
@@ -126,6 +160,19 @@ public:
                                a));
     }
 
+    void submit_discard(fd_t fd, size_t count, int64_t offset,
+                        void *account, linux_iocallback_t *cb) {
+        threadnum_t calling_thread = get_thread_id();
+
+        action_t *a = new action_t(calling_thread, cb);
+        a->make_discard(fd, count, offset);
+        a->account = static_cast<accounting_diskmgr_t::account_t *>(account);
+
+        do_on_thread(home_thread(),
+                     std::bind(&linux_disk_manager_t::submit_action_to_stack_stats, this,
+                               a));
+    }
+
 #ifndef USE_WRITEV
 #error "USE_WRITEV not defined.  Did you include pool.hpp?"
 #elif USE_WRITEV
@@ -174,6 +221,23 @@ public:
     }
 
 private:
+    /* Holds back the completion of an operation that the OS has finished, to make the
+    disk look slower than it is. The operation stays outstanding in its account and in
+    the conflict resolver meanwhile, like it would on a slow disk. */
+    void done_after_injected_delay(accounting_payload_t *a) {
+        assert_thread();
+        int64_t delay_us = fault_injector->delay_us(a->get_count(),
+                                                    get_kiloticks().micros);
+        if (delay_us <= 0) {
+            accounter.done(a);
+            return;
+        }
+        coro_t::spawn_sometime([this, a, delay_us]() {
+            nap(ceil_divide(delay_us, THOUSAND));
+            accounter.done(a);
+        });
+    }
+
     /* These fields describe the entire IO stack. At the top level, we allocate a new
     action_t object for each operation and record its callback. Then it passes through
     the conflict resolver, which enforces ordering constraints between IO operations by
@@ -193,24 +257,89 @@ private:
     conflict_resolving_diskmgr_t conflict_resolver;
     accounting_diskmgr_t accounter;
     stats_diskmgr_2_t backend_stats;
-    pool_diskmgr_t backend;
+    // Exactly one of these is initialized, depending on the chosen `io_backend_t`.
+    scoped_ptr_t<pool_diskmgr_t> pool_backend;
+    scoped_ptr_t<uring_diskmgr_t> uring_backend;
 
+    // Only initialized if disk fault injection is turned on.
+    scoped_ptr_t<fault_injector_t> fault_injector;
 
     intptr_t outstanding_txn;
 
     DISABLE_COPYING(linux_disk_manager_t);
 };
 
+class io_backender_t::device_t {
+public:
+    device_t(const std::string &name,
+             int max_concurrent_io_requests,
+             io_backend_t io_backend)
+        : stats_membership(&get_global_perfmon_collection(), &stats, name),
+          diskmgr(&linux_thread_pool_t::get_thread()->queue,
+                  DEFAULT_IO_BATCH_FACTOR,
+                  max_concurrent_io_requests,
+                  io_backend,
+                  &stats) { }
+
+    perfmon_collection_t stats;
+    perfmon_membership_t stats_membership;
+    linux_disk_manager_t diskmgr;
+};
+
 io_backender_t::io_backender_t(file_direct_io_mode_t _direct_io_mode,
-                               int max_concurrent_io_requests)
+                               int _max_concurrent_io_requests,
+                               io_backend_t _io_backend)
     : direct_io_mode(_direct_io_mode),
       diskmgr(new linux_disk_manager_t(&linux_thread_pool_t::get_thread()->queue,
                                        DEFAULT_IO_BATCH_FACTOR,
-                                       max_concurrent_io_requests,
-                                       &stats)) { }
+                                       _max_concurrent_io_requests,
+                                       _io_backend,
+                                       &stats)),
+      max_concurrent_io_requests(_max_concurrent_io_requests),
+      io_backend(_io_backend) { }
 
 io_backender_t::~io_backender_t() { }
 
+void io_backender_t::add_device(const std::string &directory) {
+    assert_thread();
+#ifndef _WIN32
+    struct stat st;
+    int res;
+    do {
+        res = stat(directory.c_str(), &st);
+    } while (res == -1 && get_errno() == EINTR);
+    if (res != 0) {
+        logWRN("Failed to stat '%s' (%s), so its files will share the default disk "
+               "manager.", directory.c_str(), errno_string(get_errno()).c_str());
+        return;
+    }
+    scoped_ptr_t<device_t> *device = &devices[static_cast<uint64_t>(st.st_dev)];
+    if (!device->has()) {
+        device->init(new device_t(
+            "disk[" + directory + "]", max_concurrent_io_requests, io_backend));
+    }
+#else
+    (void)directory;
+#endif
+}
+
+linux_disk_manager_t *io_backender_t::get_diskmgr_ptr(fd_t fd) {
+#ifndef _WIN32
+    if (!devices.empty()) {
+        struct stat st;
+        if (fstat(fd, &st) == 0) {
+            auto it = devices.find(static_cast<uint64_t>(st.st_dev));
+            if (it != devices.end()) {
+                return &it->second->diskmgr;
+            }
+        }
+    }
+#else
+    (void)fd;
+#endif
+    return diskmgr.get();
+}
+
 file_direct_io_mode_t io_backender_t::get_direct_io_mode() const { return direct_io_mode; }
 
 
@@ -222,7 +351,8 @@ linux_file_t::linux_file_t(scoped_fd_t &&_fd, int64_t _file_size, linux_disk_man
     // file_account_t outside of the thread pool?  But they're associated with the diskmgr,
     // aren't they?)
     if (linux_thread_pool_t::get_thread()) {
-        default_account.init(new file_account_t(this, 1, UNLIMITED_OUTSTANDING_REQUESTS));
+        default_account.init(new file_account_t(this, io_class_t::DEFAULT, 1,
+                                                UNLIMITED_OUTSTANDING_REQUESTS));
     }
 }
 
@@ -276,6 +406,25 @@ void linux_file_t::set_file_size_at_least(int64_t size, int64_t extent_size) {
     }
 }
 
+void linux_file_t::discard(int64_t offset, int64_t length) {
+    assert_thread();
+    rassert(diskmgr, "No diskmgr has been constructed (are we running without an event queue?)");
+    rassert(offset >= 0 && length > 0 && offset + length <= file_size);
+
+    struct discard_callback_t : public linux_iocallback_t {
+        void on_io_complete() {
+            delete this;
+        }
+
+        auto_drainer_t::lock_t lock;
+    };
+    discard_callback_t *discard_callback = new discard_callback_t();
+    discard_callback->lock = file_size_ops_drainer.lock();
+    diskmgr->submit_discard(fd.get(), length, offset,
+                            default_account->get_account(),
+                            discard_callback);
+}
+
 void linux_file_t::read_async(int64_t offset, size_t length, void *buf, file_account_t *account, linux_iocallback_t *callback) {
     rassert(diskmgr, "No diskmgr has been constructed (are we running without an event queue?)");
     verify_aligned_file_access(file_size, offset, length, buf);
@@ -367,9 +516,10 @@ bool linux_file_t::coop_lock_and_check() {
 #endif
 }
 
-void *linux_file_t::create_account(int priority, int outstanding_requests_limit) {
+void *linux_file_t::create_account(io_class_t io_class, int priority,
+                                   int outstanding_requests_limit) {
     assert_thread();
-    return diskmgr->create_account(priority, outstanding_requests_limit);
+    return diskmgr->create_account(io_class, priority, outstanding_requests_limit);
 }
 
 void linux_file_t::destroy_account(void *account) {
@@ -585,7 +735,8 @@ file_open_result_t open_file(const char *path, const int mode, io_backender_t *b
     // created file's directory entry is persisted to disk.
     warn_fsync_parent_directory(path);
 
-    out->init(new linux_file_t(std::move(fd), file_size, backender->get_diskmgr_ptr()));
+    linux_disk_manager_t *file_diskmgr = backender->get_diskmgr_ptr(fd.get());
+    out->init(new linux_file_t(std::move(fd), file_size, file_diskmgr));
 
     return open_res;
 }
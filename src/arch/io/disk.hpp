@@ -2,6 +2,9 @@
 #ifndef ARCH_IO_DISK_HPP_
 #define ARCH_IO_DISK_HPP_
 
+#include <map>
+#include <string>
+
 #include "arch/io/io_utils.hpp"
 #include "arch/types.hpp"
 #include "concurrency/auto_drainer.hpp"
@@ -29,9 +32,21 @@ public:
     // stops us from specifying this on a file-by-file basis, but right now there's no desire for
     // that.  See https://github.com/rethinkdb/rethinkdb/issues/97#issuecomment-19778177 .
     io_backender_t(file_direct_io_mode_t direct_io_mode,
-                   int max_concurrent_io_requests = DEFAULT_MAX_CONCURRENT_IO_REQUESTS);
+                   int max_concurrent_io_requests = DEFAULT_MAX_CONCURRENT_IO_REQUESTS,
+                   io_backend_t io_backend = io_backend_t::pool);
     ~io_backender_t();
+
+    /* Gives the files in `directory` a disk manager of their own, with its own queue of
+    requests, its own limit on concurrent requests and its own stats, which show up in
+    the global perfmon collection as `disk[<directory>]`. Directories on the same
+    device share a disk manager. Files on other devices use the default disk manager.
+    This must be called on the home thread, before files are opened from other
+    threads. */
+    void add_device(const std::string &directory);
+
     linux_disk_manager_t *get_diskmgr_ptr() { return diskmgr.get(); }
+    /* Returns the disk manager for the device that the open file `fd` is on. */
+    linux_disk_manager_t *get_diskmgr_ptr(fd_t fd);
     file_direct_io_mode_t get_direct_io_mode() const;
 
 protected:
@@ -40,6 +55,13 @@ protected:
     scoped_ptr_t<linux_disk_manager_t> diskmgr;
 
 private:
+    class device_t;
+
+    const int max_concurrent_io_requests;
+    const io_backend_t io_backend;
+    // Keyed by device number
+    std::map<uint64_t, scoped_ptr_t<device_t> > devices;
+
     DISABLE_COPYING(io_backender_t);
 };
 
@@ -72,6 +94,7 @@ public:
     int64_t get_file_size();
     void set_file_size(int64_t size);
     void set_file_size_at_least(int64_t size, int64_t extent_size);
+    void discard(int64_t offset, int64_t length);
 
     void read_async(int64_t offset, size_t length, void *buf, file_account_t *account, linux_iocallback_t *cb);
     void write_async(int64_t offset, size_t length, const void *buf, file_account_t *account, linux_iocallback_t *cb,
@@ -83,7 +106,8 @@ public:
 
     bool coop_lock_and_check();
 
-    void *create_account(int priority, int outstanding_requests_limit);
+    void *create_account(io_class_t io_class, int priority,
+                         int outstanding_requests_limit);
     void destroy_account(void *account);
 
     ~linux_file_t();
@@ -102,7 +126,7 @@ private:
     scoped_ptr_t<file_account_t> default_account;
 
     // Used to make sure we do not destruct the linux_file_t until all file size
-    // operations have completed.
+    // operations and discards have completed.
     auto_drainer_t file_size_ops_drainer;
 
     DISABLE_COPYING(linux_file_t);
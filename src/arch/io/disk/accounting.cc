@@ -1,21 +1,43 @@
 #include "arch/io/disk/accounting.hpp"
 
+#include <algorithm>
+#include <string>
+
 #include "containers/printf_buffer.hpp"
+#include "perfmon/foreground_load.hpp"
 
 /* Each account on the `accounting_diskmgr_t` has its own
    `unlimited_fifo_queue_t` associated with it. Operations for that account
    queue up on that queue while they wait for the `accounting_queue_t` on the
    `accounting_diskmgr_t` to draw from that account. */
-struct accounting_diskmgr_eager_account_t : public semaphore_available_callback_t {
+struct accounting_diskmgr_eager_account_t
+    : public semaphore_available_callback_t,
+      public intrusive_list_node_t<accounting_diskmgr_eager_account_t> {
     typedef accounting_diskmgr_action_t action_t;
 
-    accounting_diskmgr_eager_account_t(accounting_diskmgr_t *par,
-                                       int pri,
+    accounting_diskmgr_eager_account_t(accounting_diskmgr_t *_par,
+                                       io_class_t _io_class,
+                                       int _pri,
                                        int outstanding_requests_limit) :
+        par(_par),
+        io_class(_io_class),
+        pri(_pri),
         outstanding_requests_limiter(outstanding_requests_limit == UNLIMITED_OUTSTANDING_REQUESTS ? SEMAPHORE_NO_LIMIT : outstanding_requests_limit),
-        account(&par->queue, &queue, pri),
+        account(&par->queue, &queue, scaled_priority()),
         accounter_lock(par->get_auto_drainer()) {
         rassert(outstanding_requests_limit == UNLIMITED_OUTSTANDING_REQUESTS || outstanding_requests_limit > 0);
+        par->eager_accounts.push_back(this);
+    }
+
+    ~accounting_diskmgr_eager_account_t() {
+        par->eager_accounts.remove(this);
+    }
+
+    int scaled_priority() const {
+        return std::max(1, pri * get_io_class_priority_percent(io_class) / 100);
+    }
+    void apply_io_class_priority() {
+        account.set_shares(scaled_priority());
     }
 
     void push(action_t *action) {
@@ -32,6 +54,10 @@ struct accounting_diskmgr_eager_account_t : public semaphore_available_callback_
     }
 
 private:
+    accounting_diskmgr_t *par;
+    io_class_t io_class;
+    int pri;
+
     // It would be nice if we could just use a limited_fifo_queue to
     // implement the limitation of outstanding requests.
     // However this part of the code must not rely on coroutines, therefore
@@ -48,9 +74,10 @@ private:
 };
 
 accounting_diskmgr_account_t::accounting_diskmgr_account_t(accounting_diskmgr_t *_par,
+                                                           io_class_t _io_class,
                                                            int _pri,
                                                            int _outstanding_requests_limit)
-        : par(_par), pri(_pri),
+        : par(_par), io_class(_io_class), pri(_pri),
           outstanding_requests_limit(_outstanding_requests_limit) { }
 
 accounting_diskmgr_account_t::~accounting_diskmgr_account_t() {
@@ -83,7 +110,8 @@ co_semaphore_t *accounting_diskmgr_account_t::get_outstanding_requests_limiter()
 void accounting_diskmgr_account_t::maybe_init(){
     if (!eager_account.has()) {
         par->assert_thread();
-        eager_account.init(new eager_account_t(par, pri, outstanding_requests_limit));
+        eager_account.init(new eager_account_t(par, io_class, pri,
+                                                outstanding_requests_limit));
     }
 }
 
@@ -99,19 +127,82 @@ void debug_print(printf_buffer_t *buf,
 }
 
 
+accounting_diskmgr_class_stats_t::accounting_diskmgr_class_stats_t(
+        perfmon_collection_t *parent, io_class_t io_class) :
+    collection_membership(parent, &collection,
+                          std::string("io_class_") + io_class_name(io_class)),
+    wait_latency(secs_to_ticks(10)),
+    ops(secs_to_ticks(1)),
+    bytes(secs_to_ticks(1)),
+    stats_membership(&collection,
+                     &queued, "queued",
+                     &in_flight, "in_flight",
+                     &wait_latency, "wait_latency",
+                     &ops, "ops_per_sec",
+                     &bytes, "bytes_per_sec") { }
+
+accounting_diskmgr_t::dispatcher_t::dispatcher_t(accounting_diskmgr_t *_parent) :
+    passive_producer_t<accounting_payload_t *>(_parent->queue.available),
+    parent(_parent) { }
+
+accounting_payload_t *accounting_diskmgr_t::dispatcher_t::produce_next_value() {
+    action_t *a = parent->queue.pop();
+    accounting_diskmgr_class_stats_t *stats =
+        parent->get_class_stats(a->account->get_io_class());
+    --stats->queued;
+    ++stats->in_flight;
+    stats->wait_latency.record(
+        ticks_to_secs(ticks_t{get_ticks().nanos - a->queued_time.nanos}));
+    stats->ops.record();
+    stats->bytes.record(a->get_count());
+    return a;
+}
+
+accounting_diskmgr_t::accounting_diskmgr_t(int batch_factor,
+                                           perfmon_collection_t *stats)
+    : producer(&dispatcher),
+      queue(batch_factor),
+      dispatcher(this),
+      applied_priorities_generation(get_io_class_priorities_generation()),
+      auto_drainer(new auto_drainer_t()) {
+    for (int i = 0; i < static_cast<int>(io_class_t::NUM_IO_CLASSES); ++i) {
+        class_stats[i].init(new accounting_diskmgr_class_stats_t(
+            stats, static_cast<io_class_t>(i)));
+    }
+}
+
 accounting_diskmgr_t::~accounting_diskmgr_t() {
     auto_drainer.reset();  // Make absolutely sure this happens first.
 }
 
+void accounting_diskmgr_t::maybe_apply_io_class_priorities() {
+    uint64_t generation = get_io_class_priorities_generation();
+    if (generation == applied_priorities_generation) {
+        return;
+    }
+    applied_priorities_generation = generation;
+    for (accounting_diskmgr_eager_account_t *acct = eager_accounts.head();
+         acct != nullptr;
+         acct = eager_accounts.next(acct)) {
+        acct->apply_io_class_priority();
+    }
+}
+
 void accounting_diskmgr_t::submit(action_t *a) {
+    record_disk_request_started();
+    maybe_apply_io_class_priorities();
+    a->queued_time = get_ticks();
+    ++get_class_stats(a->account->get_io_class())->queued;
     a->account->push(a);
 }
 
 void accounting_diskmgr_t::done(accounting_payload_t *p) {
     // p really is an action_t...
     action_t *a = static_cast<action_t *>(p);
+    --get_class_stats(a->account->get_io_class())->in_flight;
     a->account->get_outstanding_requests_limiter()->unlock(1);
     a->account_acq.reset();
+    record_disk_request_finished();
     done_fun(static_cast<action_t *>(p));
 }
 
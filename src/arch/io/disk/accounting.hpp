@@ -13,24 +13,6 @@
 #include "arch/io/disk.hpp"
 #include "arch/io/disk/stats_2.hpp"
 
-/* `casting_passive_producer_t` is useful when you have a
-`passive_producer_t<X>` but you need a `passive_producer_t<Y>`, where `X` can
-be cast to `Y`. */
-
-template <class input_t, class output_t>
-struct casting_passive_producer_t : public passive_producer_t<output_t> {
-    explicit casting_passive_producer_t(passive_producer_t<input_t> *_source) :
-        passive_producer_t<output_t>(_source->available), source(_source) { }
-
-    output_t produce_next_value() {
-        /* Implicit cast from `input_t` to `output_t` in return */
-        return source->pop();
-    }
-
-private:
-    passive_producer_t<input_t> *source;
-};
-
 /* `accounting_diskmgr_t` shares disk throughput proportionally between a
 number of different "accounts". */
 
@@ -46,6 +28,7 @@ struct accounting_diskmgr_account_t {
     typedef accounting_diskmgr_action_t action_t;
 
     accounting_diskmgr_account_t(accounting_diskmgr_t *_par,
+                                 io_class_t _io_class,
                                  int _pri,
                                  int _outstanding_requests_limit);
 
@@ -54,6 +37,7 @@ struct accounting_diskmgr_account_t {
     void push(action_t *action);
     void on_semaphore_available();
     co_semaphore_t *get_outstanding_requests_limiter();
+    io_class_t get_io_class() const { return io_class; }
 
 private:
     typedef accounting_diskmgr_eager_account_t eager_account_t;
@@ -61,6 +45,7 @@ private:
     void maybe_init();
 
     accounting_diskmgr_t *par;
+    io_class_t io_class;
     int pri;
     int outstanding_requests_limit;
     scoped_ptr_t<eager_account_t> eager_account;
@@ -75,18 +60,32 @@ struct accounting_diskmgr_action_t
       public accounting_payload_t {
     accounting_diskmgr_account_t *account;
     auto_drainer_t::lock_t account_acq;
+    /* When the action was submitted to the `accounting_diskmgr_t`. */
+    ticks_t queued_time;
 };
 
 void debug_print(printf_buffer_t *buf,
                  const accounting_diskmgr_action_t &action);
 
+/* The stats that `accounting_diskmgr_t` keeps for each `io_class_t`. "queued" is the
+number of operations that are waiting for their turn in the `accounting_queue_t`, and
+"wait_latency" is how long they waited. */
+struct accounting_diskmgr_class_stats_t {
+    accounting_diskmgr_class_stats_t(perfmon_collection_t *parent, io_class_t io_class);
+
+    perfmon_collection_t collection;
+    perfmon_membership_t collection_membership;
+    perfmon_counter_t queued, in_flight;
+    perfmon_latency_histogram_t wait_latency;
+    perfmon_rate_monitor_t ops, bytes;
+    perfmon_multi_membership_t stats_membership;
+
+    DISABLE_COPYING(accounting_diskmgr_class_stats_t);
+};
+
 class accounting_diskmgr_t : public home_thread_mixin_t {
 public:
-    explicit accounting_diskmgr_t(int batch_factor)
-        : producer(&caster),
-          queue(batch_factor),
-          caster(&queue),
-          auto_drainer(new auto_drainer_t()) { }
+    accounting_diskmgr_t(int batch_factor, perfmon_collection_t *stats);
 
     ~accounting_diskmgr_t();
 
@@ -108,8 +107,30 @@ public:
 private:
     friend struct accounting_diskmgr_eager_account_t;
 
+    /* Takes actions off of `queue` for the rest of the stack, recording that they're
+    no longer queued. */
+    class dispatcher_t : public passive_producer_t<accounting_payload_t *> {
+    public:
+        explicit dispatcher_t(accounting_diskmgr_t *_parent);
+    private:
+        accounting_payload_t *produce_next_value();
+        accounting_diskmgr_t *parent;
+    };
+
+    accounting_diskmgr_class_stats_t *get_class_stats(io_class_t io_class) {
+        return class_stats[static_cast<int>(io_class)].get();
+    }
+
+    /* Brings the shares of all of the eager accounts up to date with
+    `get_io_class_priority_percent()`. */
+    void maybe_apply_io_class_priorities();
+
     accounting_queue_t<action_t *> queue;
-    casting_passive_producer_t<action_t *, accounting_payload_t *> caster;
+    dispatcher_t dispatcher;
+    scoped_ptr_t<accounting_diskmgr_class_stats_t>
+        class_stats[static_cast<int>(io_class_t::NUM_IO_CLASSES)];
+    intrusive_list_t<accounting_diskmgr_eager_account_t> eager_accounts;
+    uint64_t applied_priorities_generation;
     scoped_ptr_t<auto_drainer_t> auto_drainer;
 
     DISABLE_COPYING(accounting_diskmgr_t);
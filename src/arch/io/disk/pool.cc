@@ -183,6 +183,22 @@ void pool_diskmgr_t::action_t::run() {
         }
 #endif
     } break;
+    case ACTION_DISCARD: {
+        // Discarding is only a hint, so we pretend that it succeeded if the file
+        // system doesn't support it (or if anything else goes wrong).
+#if defined(__linux__) && defined(FALLOC_FL_PUNCH_HOLE)
+        int res;
+        do {
+            res = fallocate(fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                            offset, buf_and_count.iov_len);
+        } while (res == -1 && get_errno() == EINTR);
+        if (res == -1 && get_errno() != EOPNOTSUPP && get_errno() != ENOSYS) {
+            logWRN("Failed to discard %zu bytes at offset %" PRIi64 " of a file: %s",
+                   buf_and_count.iov_len, offset, errno_string(get_errno()).c_str());
+        }
+#endif
+        io_result = buf_and_count.iov_len;
+    } break;
     case ACTION_READ:
     case ACTION_WRITE: {
         // Copy the io vectors because perform_read_write will modify them
@@ -23,23 +23,31 @@ stats_diskmgr_2_t::stats_diskmgr_2_t(
     source(_source),
     read_sampler(secs_to_ticks(1)),
     write_sampler(secs_to_ticks(1)),
+    read_latency(secs_to_ticks(10)),
+    write_latency(secs_to_ticks(10)),
     stats_membership(stats,
                      &read_sampler, (name + "_read").c_str(),
-                     &write_sampler, (name + "_write").c_str()) { }
+                     &write_sampler, (name + "_write").c_str(),
+                     &read_latency, (name + "_read_latency").c_str(),
+                     &write_latency, (name + "_write_latency").c_str()) { }
 
 
 void stats_diskmgr_2_t::done(pool_diskmgr_t::action_t *p) {
     action_t *a = static_cast<action_t *>(p);
+    double latency = ticks_to_secs(ticks_t{get_ticks().nanos - a->submit_time.nanos});
     if (a->get_is_read()) {
         read_sampler.end(&a->start_time);
+        read_latency.record(latency);
     } else {
         write_sampler.end(&a->start_time);
+        write_latency.record(latency);
     }
     done_fun(a);
 }
 
 pool_diskmgr_t::action_t *stats_diskmgr_2_t::produce_next_value() {
     action_t *a = source->pop();
+    a->submit_time = get_ticks();
     if (a->get_is_read()) {
         read_sampler.begin(&a->start_time);
     } else {
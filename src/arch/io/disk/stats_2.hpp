@@ -8,6 +8,8 @@
 
 struct stats_diskmgr_2_action_t : public pool_diskmgr_t::action_t {
     ticks_t start_time;
+    /* Unlike `start_time`, this is set even without `FULL_PERFMON`. */
+    ticks_t submit_time;
 };
 
 void debug_print(printf_buffer_t *buf,
@@ -33,6 +35,7 @@ private:
 
     passive_producer_t<action_t *> *source;
     perfmon_duration_sampler_t read_sampler, write_sampler;
+    perfmon_latency_histogram_t read_latency, write_latency;
     perfmon_multi_membership_t stats_membership;
 };
 
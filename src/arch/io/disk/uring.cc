@@ -0,0 +1,193 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "arch/io/disk/uring.hpp"
+
+#include <limits.h>
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "logger.hpp"
+#include "utils.hpp"
+
+// How many blocker pool threads serve the resizes and datasync-wrapped writes.
+const int URING_FALLBACK_IO_THREADS = 2;
+
+#if IO_URING_SUPPORTED
+
+/* An action that's currently on the ring.  We keep our own copy of the io vectors
+because short transfers get resubmitted with advanced vectors, and because the kernel
+may read them after `io_uring_enter()` returns. */
+struct uring_diskmgr_t::request_t {
+    explicit request_t(action_t *_action)
+        : action(_action), bytes_done(0) {
+        action->copy_vectors(&vectors);
+        vecs = vectors.data();
+        vecs_len = vectors.size();
+        total_bytes = 0;
+        for (size_t i = 0; i < vecs_len; ++i) {
+            total_bytes += vecs[i].iov_len;
+        }
+    }
+
+    action_t *action;
+    scoped_array_t<iovec> vectors;
+    iovec *vecs;
+    size_t vecs_len;
+    int64_t bytes_done;
+    int64_t total_bytes;
+
+    DISABLE_COPYING(request_t);
+};
+
+bool uring_diskmgr_t::is_supported() {
+    return io_uring_ring_t::is_supported();
+}
+
+uring_diskmgr_t::uring_diskmgr_t(linux_event_queue_t *_queue,
+                                 passive_producer_t<action_t *> *_source,
+                                 int max_concurrent_io_requests)
+    : queue(_queue),
+      queue_depth(blocker_pool_queue_depth(max_concurrent_io_requests)),
+      source(_source),
+      ring(new io_uring_ring_t(queue_depth)),
+      n_pending(0),
+      fallback(_queue, &fallback_queue, URING_FALLBACK_IO_THREADS) {
+    guarantee(ring->sq_capacity() >= static_cast<unsigned int>(queue_depth));
+    fallback.done_fun = std::bind(&uring_diskmgr_t::on_fallback_done, this, ph::_1);
+
+    ring->register_eventfd(completion_event.get_notify_fd());
+    queue->watch_event(&completion_event, this);
+
+    if (source->available->get()) { pump(); }
+    source->available->set_callback(this);
+}
+
+uring_diskmgr_t::~uring_diskmgr_t() {
+    assert_thread();
+    rassert(n_pending == 0);
+    source->available->unset_callback();
+    queue->forget_event(&completion_event, this);
+}
+
+void uring_diskmgr_t::on_source_availability_changed() {
+    assert_thread();
+    if (source->available->get()) pump();
+}
+
+void uring_diskmgr_t::pump() {
+    assert_thread();
+    while (source->available->get() && n_pending < queue_depth) {
+        action_t *a = source->pop();
+        n_pending++;
+        if (a->get_is_resize() || a->get_is_discard() || a->wrap_in_datasyncs) {
+            fallback_queue.push(a);
+        } else {
+            prepare_request(new request_t(a));
+        }
+    }
+    // If the kernel is short on resources, the SQEs stay on the ring and get submitted
+    // the next time we're woken up by a completion.
+    UNUSED bool submitted = ring->submit(false);
+}
+
+void uring_diskmgr_t::prepare_request(request_t *request) {
+    // Every request occupies at most one SQE, and the ring has at least `queue_depth`
+    // of them.
+    io_uring_sqe *sqe = ring->get_sqe();
+    guarantee(sqe != nullptr);
+    sqe->opcode = request->action->get_is_read() ? IORING_OP_READV : IORING_OP_WRITEV;
+    sqe->fd = request->action->get_fd();
+    sqe->off = request->action->get_offset() + request->bytes_done;
+    sqe->addr = reinterpret_cast<uintptr_t>(request->vecs);
+    sqe->len = std::min<size_t>(request->vecs_len, IOV_MAX);
+    sqe->user_data = reinterpret_cast<uintptr_t>(request);
+}
+
+void uring_diskmgr_t::on_event(DEBUG_VAR int events) {
+    assert_thread();
+    rassert(events == poll_event_in);
+    completion_event.consume_wakey_wakeys();
+
+    std::vector<action_t *> finished;
+    ring->consume_completions([&](const io_uring_cqe &cqe) {
+        request_t *request = reinterpret_cast<request_t *>(cqe.user_data);
+        if (handle_completion(request, cqe.res)) {
+            finished.push_back(request->action);
+            delete request;
+        }
+    });
+
+    n_pending -= finished.size();
+    pump();
+    for (action_t *a : finished) {
+        done_fun(a);
+    }
+}
+
+bool uring_diskmgr_t::handle_completion(request_t *request, int res) {
+    action_t *a = request->action;
+    if (res == -EINTR || res == -EAGAIN) {
+        prepare_request(request);
+        return false;
+    } else if (res < 0) {
+        a->io_result = res;
+        return true;
+    } else if (res == 0 && a->get_is_write()) {
+        // See `pool_diskmgr_t::action_t::perform_read_write()`.
+        logERR("Failed I/O: vectored write of %" PRIi64 " bytes stopped after "
+               "%" PRIi64 " bytes. Assuming we ran out of disk space.",
+               request->total_bytes, request->bytes_done);
+        a->io_result = -ENOSPC;
+        return true;
+    } else if (res == 0) {
+        logERR("Failed I/O: we tried to read from behind the end of the file. "
+               "Either the file got truncated, or there is a bug in RethinkDB.");
+        a->io_result = -EINVAL;
+        return true;
+    }
+
+    request->bytes_done += action_t::advance_vector(&request->vecs,
+                                                    &request->vecs_len,
+                                                    res);
+    if (request->bytes_done < request->total_bytes) {
+        prepare_request(request);
+        return false;
+    }
+    a->io_result = request->total_bytes;
+    return true;
+}
+
+void uring_diskmgr_t::on_fallback_done(action_t *action) {
+    assert_thread();
+    n_pending--;
+    pump();
+    done_fun(action);
+}
+
+#else  // IO_URING_SUPPORTED
+
+class io_uring_ring_t { };
+
+bool uring_diskmgr_t::is_supported() {
+    return false;
+}
+
+uring_diskmgr_t::uring_diskmgr_t(linux_event_queue_t *_queue,
+                                 passive_producer_t<action_t *> *_source,
+                                 int max_concurrent_io_requests)
+    : queue(_queue),
+      queue_depth(blocker_pool_queue_depth(max_concurrent_io_requests)),
+      source(_source),
+      n_pending(0),
+      fallback(_queue, &fallback_queue, URING_FALLBACK_IO_THREADS) {
+    crash("io_uring is not supported on this platform.");
+}
+
+uring_diskmgr_t::~uring_diskmgr_t() { }
+
+void uring_diskmgr_t::on_source_availability_changed() { unreachable(); }
+
+void uring_diskmgr_t::on_event(int) { unreachable(); }
+
+#endif  // IO_URING_SUPPORTED
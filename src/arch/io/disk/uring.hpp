@@ -0,0 +1,71 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef ARCH_IO_DISK_URING_HPP_
+#define ARCH_IO_DISK_URING_HPP_
+
+#include <functional>
+
+#include "arch/io/disk/pool.hpp"
+#include "arch/runtime/event_queue.hpp"
+#include "arch/runtime/io_uring.hpp"
+#include "arch/runtime/system_event.hpp"
+#include "concurrency/queue/passive_producer.hpp"
+#include "concurrency/queue/unlimited_fifo.hpp"
+#include "containers/scoped.hpp"
+
+class io_uring_ring_t;
+
+/* The io_uring disk manager is a drop-in replacement for `pool_diskmgr_t`.  Instead of
+handing each request to a blocker pool thread, it places reads and writes on an
+io_uring submission queue directly from the event loop thread, submitting everything
+it popped from `source` with a single `io_uring_enter()` call.  The kernel signals
+completions through an eventfd that we watch on the event queue.
+
+Resizes and writes that must be wrapped in datasyncs are rare, so rather than
+depending on recent kernels for `ftruncate` support we hand those to a small internal
+`pool_diskmgr_t`. */
+
+class uring_diskmgr_t : private availability_callback_t,
+                        private linux_event_callback_t,
+                        public home_thread_mixin_debug_only_t {
+public:
+    typedef pool_diskmgr_action_t action_t;
+
+    /* Like `pool_diskmgr_t`, the `uring_diskmgr_t` will draw actions to run from
+    `source` and call `done_fun` on each one when it's done. */
+    uring_diskmgr_t(linux_event_queue_t *queue, passive_producer_t<action_t *> *source,
+                    int max_concurrent_io_requests);
+    std::function<void(action_t *)> done_fun;
+    ~uring_diskmgr_t();
+
+    /* Returns true if the running kernel lets us set up an io_uring. */
+    static bool is_supported();
+
+private:
+    struct request_t;
+
+    void on_source_availability_changed();
+    void on_event(int events);
+
+    void pump();
+    void prepare_request(request_t *request);
+    // Returns true if `request` is finished, false if it was resubmitted.
+    bool handle_completion(request_t *request, int res);
+    void on_fallback_done(action_t *action);
+
+    linux_event_queue_t *const queue;
+    const int queue_depth;
+    passive_producer_t<action_t *> *const source;
+
+    scoped_ptr_t<io_uring_ring_t> ring;
+    system_event_t completion_event;
+
+    // Number of requests that are on the ring, plus the ones given to the fallback.
+    int n_pending;
+
+    unlimited_fifo_queue_t<action_t *> fallback_queue;
+    pool_diskmgr_t fallback;
+
+    DISABLE_COPYING(uring_diskmgr_t);
+};
+
+#endif /* ARCH_IO_DISK_URING_HPP_ */
@@ -0,0 +1,158 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/io/fault_injection.hpp"
+
+#include <stdlib.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "config/args.hpp"
+#include "stl_utils.hpp"
+#include "utils.hpp"
+
+namespace {
+
+fault_injection_config_t disk_fault_injection_config;
+fault_injection_config_t network_fault_injection_config;
+
+bool parse_number(const std::string &str, double *number_out, std::string *suffix_out) {
+    const char *begin = str.c_str();
+    char *end;
+    *number_out = strtod(begin, &end);
+    if (end == begin || !(*number_out >= 0) || std::isinf(*number_out)) {
+        return false;
+    }
+    *suffix_out = std::string(end);
+    return true;
+}
+
+bool parse_duration_us(const std::string &str, int64_t *us_out) {
+    double number;
+    std::string suffix;
+    if (!parse_number(str, &number, &suffix)) {
+        return false;
+    }
+    if (suffix == "us") {
+        *us_out = static_cast<int64_t>(number);
+    } else if (suffix == "ms") {
+        *us_out = static_cast<int64_t>(number * THOUSAND);
+    } else if (suffix == "s") {
+        *us_out = static_cast<int64_t>(number * MILLION);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool parse_bytes(const std::string &str, uint64_t *bytes_out) {
+    double number;
+    std::string suffix;
+    if (!parse_number(str, &number, &suffix)) {
+        return false;
+    }
+    if (suffix == "K") {
+        number *= KILOBYTE;
+    } else if (suffix == "M") {
+        number *= MEGABYTE;
+    } else if (suffix == "G") {
+        number *= GIGABYTE;
+    } else if (!suffix.empty()) {
+        return false;
+    }
+    *bytes_out = static_cast<uint64_t>(number);
+    return true;
+}
+
+}  // namespace
+
+bool parse_fault_injection_config(const std::string &spec,
+                                  fault_injection_config_t *config_out,
+                                  std::string *error_out) {
+    fault_injection_config_t config;
+    std::vector<std::string> settings = split_string(spec, ',');
+    for (const std::string &setting : settings) {
+        size_t equals = setting.find('=');
+        if (equals == std::string::npos) {
+            *error_out = strprintf("expected key=value, got '%s'", setting.c_str());
+            return false;
+        }
+        const std::string key = setting.substr(0, equals);
+        const std::string value = setting.substr(equals + 1);
+        bool ok;
+        if (key == "latency") {
+            ok = parse_duration_us(value, &config.latency_us);
+        } else if (key == "jitter") {
+            ok = parse_duration_us(value, &config.jitter_us);
+        } else if (key == "bandwidth") {
+            ok = parse_bytes(value, &config.bytes_per_sec);
+        } else if (key == "stall") {
+            ok = parse_duration_us(value, &config.stall_us);
+        } else if (key == "stall-probability") {
+            std::string suffix;
+            ok = parse_number(value, &config.stall_probability, &suffix)
+                && suffix.empty() && config.stall_probability <= 1;
+        } else {
+            *error_out = strprintf("unknown setting '%s'", key.c_str());
+            return false;
+        }
+        if (!ok) {
+            *error_out = strprintf("invalid value '%s' for %s",
+                                   value.c_str(), key.c_str());
+            return false;
+        }
+    }
+    *config_out = config;
+    return true;
+}
+
+void set_fault_injection_config(fault_injection_target_t target,
+                                const fault_injection_config_t &config) {
+    switch (target) {
+    case fault_injection_target_t::disk:
+        disk_fault_injection_config = config;
+        break;
+    case fault_injection_target_t::network:
+        network_fault_injection_config = config;
+        break;
+    default:
+        unreachable();
+    }
+}
+
+const fault_injection_config_t &get_fault_injection_config(
+        fault_injection_target_t target) {
+    switch (target) {
+    case fault_injection_target_t::disk:
+        return disk_fault_injection_config;
+    case fault_injection_target_t::network:
+        return network_fault_injection_config;
+    default:
+        unreachable();
+    }
+}
+
+fault_injector_t::fault_injector_t(const fault_injection_config_t &_config)
+    : config(_config), link_free_at_us(0), last_release_us(0) { }
+
+int64_t fault_injector_t::delay_us(size_t size, int64_t now_us) {
+    assert_thread();
+    int64_t start_us = std::max(now_us, link_free_at_us);
+    if (config.bytes_per_sec > 0) {
+        link_free_at_us = start_us + static_cast<int64_t>(
+            static_cast<double>(size) * MILLION / config.bytes_per_sec);
+    } else {
+        link_free_at_us = start_us;
+    }
+    if (config.stall_probability > 0 && rng.randdouble() < config.stall_probability) {
+        link_free_at_us += config.stall_us;
+    }
+
+    int64_t release_us = link_free_at_us + config.latency_us;
+    if (config.jitter_us > 0) {
+        release_us += static_cast<int64_t>(
+            -static_cast<double>(config.jitter_us) * std::log(1.0 - rng.randdouble()));
+    }
+    last_release_us = std::max(release_us, last_release_us);
+    return last_release_us - now_us;
+}
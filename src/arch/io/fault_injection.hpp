@@ -0,0 +1,92 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef ARCH_IO_FAULT_INJECTION_HPP_
+#define ARCH_IO_FAULT_INJECTION_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "errors.hpp"
+#include "random.hpp"
+
+/* Fault injection slows down the disk and the links to other servers, so that things
+like backfill throttling, GC pacing and failover can be measured under realistic
+conditions on a fast test machine. Debug builds always have it; release builds only
+with `make FAULT_INJECTION=1`, so that it can't be turned on by accident in
+production. It's configured with the `--inject-disk-faults` and
+`--inject-network-faults` command line options. */
+#if !defined(NDEBUG) || defined(FAULT_INJECTION)
+#define FAULT_INJECTION_ENABLED
+#endif
+
+struct fault_injection_config_t {
+    fault_injection_config_t()
+        : latency_us(0), jitter_us(0), bytes_per_sec(0), stall_probability(0),
+          stall_us(0) { }
+
+    bool is_enabled() const {
+        return latency_us > 0 || jitter_us > 0 || bytes_per_sec > 0
+            || (stall_probability > 0 && stall_us > 0);
+    }
+
+    // Added to every operation.
+    int64_t latency_us;
+    // The mean of an exponentially distributed latency added on top of `latency_us`.
+    int64_t jitter_us;
+    // Operations are spaced out so that no more than this many bytes go through per
+    // second, or 0 for no limit.
+    uint64_t bytes_per_sec;
+    // The chance that an operation stalls the disk or link for `stall_us`, holding up
+    // every operation behind it too.
+    double stall_probability;
+    int64_t stall_us;
+};
+
+/* Parses a comma-separated list of `key=value` settings:
+
+    latency=<duration>       the fixed latency
+    jitter=<duration>        the mean of the random latency
+    bandwidth=<bytes>        the bandwidth per second, with an optional K, M or G suffix
+    stall=<duration>         how long a stall lasts
+    stall-probability=<p>    the chance of a stall, from 0 to 1
+
+Durations are numbers with a `us`, `ms` or `s` suffix. Returns false and sets
+`error_out` if `spec` is malformed. */
+MUST_USE bool parse_fault_injection_config(const std::string &spec,
+                                           fault_injection_config_t *config_out,
+                                           std::string *error_out);
+
+enum class fault_injection_target_t { disk, network };
+
+/* The configuration is process-wide. It must be set before the thread pool starts,
+and is only read afterwards. */
+void set_fault_injection_config(fault_injection_target_t target,
+                                const fault_injection_config_t &config);
+const fault_injection_config_t &get_fault_injection_config(
+    fault_injection_target_t target);
+
+/* Decides how long to hold back each operation on one disk or link. Operations are
+released in the order they were submitted in, like they would be by a real device
+or TCP connection. Not thread safe; each disk manager and each connection has its
+own. */
+class fault_injector_t : public home_thread_mixin_debug_only_t {
+public:
+    explicit fault_injector_t(const fault_injection_config_t &config);
+
+    // Returns how many microseconds from `now_us` an operation of `size` bytes that
+    // was submitted at `now_us` should be held back for.
+    int64_t delay_us(size_t size, int64_t now_us);
+
+private:
+    const fault_injection_config_t config;
+    rng_t rng;
+    // When the bandwidth limit allows the next operation to start.
+    int64_t link_free_at_us;
+    // When the last operation was released.
+    int64_t last_release_us;
+
+    DISABLE_COPYING(fault_injector_t);
+};
+
+#endif  // ARCH_IO_FAULT_INJECTION_HPP_
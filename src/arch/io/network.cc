@@ -26,6 +26,7 @@
 #include "arch/types.hpp"
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/exponential_backoff.hpp"
+#include "concurrency/scatter_gather.hpp"
 #include "concurrency/wait_any.hpp"
 #include "containers/printf_buffer.hpp"
 #include "logger.hpp"
@@ -522,7 +523,12 @@ linux_tcp_conn_t::write_handler_t::write_handler_t(linux_tcp_conn_t *_parent) :
 
 void linux_tcp_conn_t::write_handler_t::coro_pool_callback(write_queue_op_t *operation, UNUSED signal_t *interruptor) {
     if (operation->buffer != nullptr) {
-        parent->perform_write(operation->buffer, operation->size);
+        if (operation->extra_buffer != nullptr) {
+            parent->perform_write_pair(operation->buffer, operation->size,
+                                       operation->extra_buffer, operation->extra_size);
+        } else {
+            parent->perform_write(operation->buffer, operation->size);
+        }
         if (operation->dealloc != nullptr) {
             parent->release_write_buffer(operation->dealloc);
             parent->write_queue_limiter.unlock(operation->size);
@@ -537,7 +543,9 @@ void linux_tcp_conn_t::write_handler_t::coro_pool_callback(write_queue_op_t *ope
     }
 }
 
-void linux_tcp_conn_t::internal_flush_write_buffer() {
+void linux_tcp_conn_t::internal_flush_write_buffer(const void *extra_buffer,
+                                                   size_t extra_size,
+                                                   cond_t *cond) {
     write_queue_op_t *op = get_write_queue_op();
     assert_thread();
     rassert(write_in_progress);
@@ -546,8 +554,10 @@ void linux_tcp_conn_t::internal_flush_write_buffer() {
        released once the write is over. */
     op->buffer = current_write_buffer->buffer;
     op->size = current_write_buffer->size;
+    op->extra_buffer = extra_buffer;
+    op->extra_size = extra_size;
     op->dealloc = current_write_buffer.release();
-    op->cond = nullptr;
+    op->cond = cond;
     op->keepalive = auto_drainer_t::lock_t(drainer.get());
     current_write_buffer.init(get_write_buffer());
 
@@ -598,8 +608,54 @@ void linux_tcp_conn_t::perform_write(const void *buf, size_t size) {
         rassert(op.nb_bytes == size);  // TODO WINDOWS: does windows guarantee this?
     }
 #else
-    while (size > 0) {
-        ssize_t res = ::write(sock.get(), buf, size);
+    struct iovec iov;
+    iov.iov_base = const_cast<void *>(buf);
+    iov.iov_len = size;
+    perform_writev(&iov, 1);
+#endif
+}
+
+void linux_tcp_conn_t::perform_write_pair(const void *buf1, size_t size1,
+                                          const void *buf2, size_t size2) {
+#ifdef _WIN32
+    perform_write(buf1, size1);
+    perform_write(buf2, size2);
+#else
+    struct iovec iov[2];
+    iov[0].iov_base = const_cast<void *>(buf1);
+    iov[0].iov_len = size1;
+    iov[1].iov_base = const_cast<void *>(buf2);
+    iov[1].iov_len = size2;
+    perform_writev(iov, 2);
+#endif
+}
+
+#ifndef _WIN32
+void linux_tcp_conn_t::perform_writev(struct iovec *iov, int iovcnt) {
+    assert_thread();
+
+    if (write_closed.is_pulsed()) {
+        /* See `perform_write()`. */
+        return;
+    }
+
+    size_t written = 0;
+    while (true) {
+        /* Skip over the buffers that have been written completely, and the part of
+           the next one that has. */
+        while (iovcnt > 0 && written >= iov->iov_len) {
+            written -= iov->iov_len;
+            ++iov;
+            --iovcnt;
+        }
+        if (iovcnt == 0) {
+            break;
+        }
+        iov->iov_base = reinterpret_cast<char *>(iov->iov_base) + written;
+        iov->iov_len -= written;
+        written = 0;
+
+        ssize_t res = ::writev(sock.get(), iov, iovcnt);
 
         if (res == -1 && (get_errno() == EAGAIN || get_errno() == EWOULDBLOCK)) {
             /* Wait for a notification from the event queue, or for an order to
@@ -637,16 +693,14 @@ void linux_tcp_conn_t::perform_write(const void *buf, size_t size) {
             break;
 
         } else {
-            rassert(res <= static_cast<ssize_t>(size));
-            buf = reinterpret_cast<const void *>(reinterpret_cast<const char *>(buf) + res);
-            size -= res;
+            written = res;
             if (write_perfmon) {
                 write_perfmon->record(res);
             }
         }
     }
-#endif
 }
+#endif
 
 void linux_tcp_conn_t::write(const void *buf, size_t size, signal_t *closer) THROWS_ONLY(tcp_conn_write_closed_exc_t) {
     write_op_wrapper_t sentry(this, closer);
@@ -654,20 +708,23 @@ void linux_tcp_conn_t::write(const void *buf, size_t size, signal_t *closer) THR
     write_queue_op_t op;
     cond_t to_signal_when_done;
 
-    /* Flush out any data that's been buffered, so that things don't get out of order */
     if (current_write_buffer->size > 0) {
-        internal_flush_write_buffer();
-    }
-
-    /* Don't bother acquiring the write semaphore because we're going to block
-       until the write is done anyway */
+        /* Data that's been buffered has to go out first, so that things don't get
+           out of order. We send ours along with it. */
+        internal_flush_write_buffer(buf, size, &to_signal_when_done);
+    } else {
+        /* Don't bother acquiring the write semaphore because we're going to block
+           until the write is done anyway */
 
-    /* Enqueue the write so it will happen eventually */
-    op.buffer = buf;
-    op.size = size;
-    op.dealloc = nullptr;
-    op.cond = &to_signal_when_done;
-    write_queue.push(&op);
+        /* Enqueue the write so it will happen eventually */
+        op.buffer = buf;
+        op.size = size;
+        op.extra_buffer = nullptr;
+        op.extra_size = 0;
+        op.dealloc = nullptr;
+        op.cond = &to_signal_when_done;
+        write_queue.push(&op);
+    }
 
     /* Wait for the write to be done. If the write half of the network connection
        is closed before or during our write, then `perform_write()` will turn into a
@@ -737,6 +794,8 @@ void linux_tcp_conn_t::flush_buffer(signal_t *closer) THROWS_ONLY(tcp_conn_write
     write_queue_op_t op;
     cond_t to_signal_when_done;
     op.buffer = nullptr;
+    op.extra_buffer = nullptr;
+    op.extra_size = 0;
     op.dealloc = nullptr;
     op.cond = &to_signal_when_done;
     write_queue.push(&op);
@@ -1118,6 +1177,12 @@ void linux_secure_tcp_conn_t::perform_write(const void *buffer, size_t size) {
     }
 }
 
+void linux_secure_tcp_conn_t::perform_write_pair(const void *buffer1, size_t size1,
+                                                 const void *buffer2, size_t size2) {
+    perform_write(buffer1, size1);
+    perform_write(buffer2, size2);
+}
+
 /* It is not possible to close only the read or write side of a TLS connection
 so we use only a single shutdown method which attempts to shutdown the TLS
 before shutting down the underlying tcp connection */
@@ -1258,10 +1323,12 @@ void linux_tcp_conn_descriptor_t::make_server_connection(
 /* Network listener object */
 linux_nonthrowing_tcp_listener_t::linux_nonthrowing_tcp_listener_t(
          const std::set<ip_address_t> &bind_addresses, int _port,
-         const std::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t> &)> &cb) :
+         const std::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t> &)> &cb,
+         bool _reuse_port) :
     callback(cb),
     local_addresses(bind_addresses),
     port(_port),
+    reuse_port(_reuse_port),
     bound(false),
     socks(),
     last_used_socket_index(0),
@@ -1367,6 +1434,20 @@ int linux_nonthrowing_tcp_listener_t::init_sockets() {
         // to be re-bound quickly (e.g. if you restart the server).
         int res = setsockopt(sock_fd, SOL_SOCKET, SO_REUSEADDR, &sockoptval, sizeof(sockoptval)); 
         guarantee_err(res != -1, "Could not set REUSEADDR option");
+#ifdef SO_REUSEPORT
+        if (reuse_port) {
+            res = setsockopt(sock_fd, SOL_SOCKET, SO_REUSEPORT, &sockoptval,
+                             sizeof(sockoptval));
+            if (res == -1) {
+                // Probably a kernel that doesn't know the option
+                return get_errno();
+            }
+        }
+#else
+        if (reuse_port) {
+            return ENOPROTOOPT;
+        }
+#endif
 #endif
         /* XXX Making our socket NODELAY prevents the problem where responses to
          * pipelined requests are delayed, since the TCP Nagle algorithm will
@@ -1700,6 +1781,78 @@ int linux_tcp_listener_t::get_port() const {
     return listener->get_port();
 }
 
+linux_threaded_tcp_listener_t::linux_threaded_tcp_listener_t(
+        const std::set<ip_address_t> &bind_addresses, int _port,
+        const std::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t> &)> &_callback) :
+    callback(_callback),
+    port(_port),
+    next_thread(0),
+    listeners(get_num_threads()) {
+    if (listen_on_every_thread(bind_addresses)) {
+        return;
+    }
+    destroy_listeners();
+
+    /* Fall back to a single listener that hands the connections out. */
+    port = _port;
+    listeners[get_thread_id().threadnum].init(new linux_nonthrowing_tcp_listener_t(
+        bind_addresses, port,
+        std::bind(&linux_threaded_tcp_listener_t::hand_out, this, ph::_1)));
+    if (!listeners[get_thread_id().threadnum]->begin_listening()) {
+        int failed_port = listeners[get_thread_id().threadnum]->get_port();
+        destroy_listeners();
+        throw address_in_use_exc_t("localhost", failed_port);
+    }
+    port = listeners[get_thread_id().threadnum]->get_port();
+}
+
+linux_threaded_tcp_listener_t::~linux_threaded_tcp_listener_t() {
+    destroy_listeners();
+}
+
+int linux_threaded_tcp_listener_t::get_port() const {
+    return port;
+}
+
+bool linux_threaded_tcp_listener_t::listen_on_every_thread(
+        const std::set<ip_address_t> &bind_addresses) {
+    /* The first listener picks the port if we were given port 0, so the others have
+    to wait for it before they can bind. */
+    for (int i = 0; i < get_num_db_threads(); ++i) {
+        on_thread_t thread_switcher((threadnum_t(i)));
+        listeners[i].init(new linux_nonthrowing_tcp_listener_t(
+            bind_addresses, port, callback, true));
+        if (!listeners[i]->begin_listening()) {
+            return false;
+        }
+        port = listeners[i]->get_port();
+    }
+    return true;
+}
+
+void linux_threaded_tcp_listener_t::destroy_listeners() {
+    /* Each listener's event watchers have to be destroyed on their own thread. */
+    scatter_gather_on_all_threads([&](int32_t thread) {
+        listeners[thread].reset();
+    });
+}
+
+void linux_threaded_tcp_listener_t::hand_out(
+        scoped_ptr_t<linux_tcp_conn_descriptor_t> &nconn) {
+    /* The lock keeps us alive until the callback has started on the other thread. From
+    there on, it's up to the callback's owner to keep things alive. */
+    auto_drainer_t::lock_t lock(&drainer);
+    threadnum_t chosen_thread = threadnum_t(next_thread);
+    next_thread = (next_thread + 1) % get_num_db_threads();
+    on_thread_t thread_switcher(chosen_thread);
+    std::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t> &)> cb = callback;
+    linux_tcp_conn_descriptor_t *raw_conn = nconn.release();
+    coro_t::spawn_now_dangerously([cb, raw_conn]() {
+        scoped_ptr_t<linux_tcp_conn_descriptor_t> conn(raw_conn);
+        cb(conn);
+    });
+}
+
 linux_repeated_nonthrowing_tcp_listener_t::linux_repeated_nonthrowing_tcp_listener_t(
     const std::set<ip_address_t> &bind_addresses,
     int port,
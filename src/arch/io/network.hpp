@@ -17,6 +17,7 @@
 #include <ifaddrs.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#include <sys/uio.h>
 #endif
 
 #include <functional>
@@ -36,6 +37,7 @@
 #include "arch/io/openssl.hpp"
 #include "arch/runtime/event_queue.hpp"
 #include "arch/types.hpp"
+#include "concurrency/auto_drainer.hpp"
 #include "concurrency/cond_var.hpp"
 #include "concurrency/queue/unlimited_fifo.hpp"
 #include "concurrency/semaphore.hpp"
@@ -132,7 +134,10 @@ public:
     /* write() writes 'size' bytes from 'buf' to the socket and blocks until it
     is done. Throws tcp_conn_write_closed_exc_t if the write half of the pipe is closed
     before we can finish. If `closer` is pulsed, closes the write half of the
-    pipe and throws `tcp_conn_write_closed_exc_t`. */
+    pipe and throws `tcp_conn_write_closed_exc_t`. Unlike write_buffered(), it
+    doesn't copy `buf`; any data that's still buffered goes out together with it in
+    a single system call where possible. This makes it the better choice for large
+    writes. */
     void write(const void *buf, size_t size, signal_t *closer)
         THROWS_ONLY(tcp_conn_write_closed_exc_t);
 
@@ -279,6 +284,10 @@ private:
         write_buffer_t *dealloc;
         const void *buffer;
         size_t size;
+        /* Written right after `buffer`, or NULL. `write()` uses this to send the
+        buffered data along with its own without copying either of them. */
+        const void *extra_buffer;
+        size_t extra_size;
         cond_t *cond;
         auto_drainer_t::lock_t keepalive;
     };
@@ -315,8 +324,12 @@ private:
 
     /* Schedules old write buffer's contents to be flushed and swaps in a fresh write buffer.
     Blocks until it can acquire the `write_queue_limiter` semaphore, but doesn't wait for
-    data to be completely written. */
-    void internal_flush_write_buffer();
+    data to be completely written. If `extra_buffer` is given, it's written right after
+    the old write buffer's contents, and `cond` is pulsed once both have been
+    written. */
+    void internal_flush_write_buffer(const void *extra_buffer = nullptr,
+                                     size_t extra_size = 0,
+                                     cond_t *cond = nullptr);
 
     /* Used to queue up buffers to write. The functions in `write_queue` will all be
     `std::bind()`s of the `perform_write()` function below. */
@@ -345,6 +358,17 @@ private:
     /* Used to actually perform a write. If the write end of the connection is open, then
     writes `size` bytes from `buffer` to the socket. */
     virtual void perform_write(const void *buffer, size_t size);
+
+    /* Like `perform_write()`, but writes `buffer2` right after `buffer1`. We use a
+    single `writev()` for both where we can. */
+    virtual void perform_write_pair(const void *buffer1, size_t size1,
+                                    const void *buffer2, size_t size2);
+
+#ifndef _WIN32
+    /* Writes out all of the `iovcnt` buffers in `iov`, which it modifies as it goes
+    along. Does nothing if the write end of the connection is closed. */
+    void perform_writev(struct iovec *iov, int iovcnt);
+#endif
 };
 
 #ifdef ENABLE_TLS
@@ -409,6 +433,10 @@ private:
     writes `size` bytes from `buffer` to the socket. */
     virtual void perform_write(const void *buffer, size_t size);
 
+    /* TLS has no vectored writes, so this calls `perform_write()` for each buffer. */
+    virtual void perform_write_pair(const void *buffer1, size_t size1,
+                                    const void *buffer2, size_t size2);
+
     void shutdown();
     void shutdown_socket();
 
@@ -448,12 +476,15 @@ private:
 
 /* The linux_nonthrowing_tcp_listener_t is used to listen on a network port for incoming
 connections. Create a linux_nonthrowing_tcp_listener_t with some port and then call set_callback();
-the provided callback will be called in a new coroutine every time something connects. */
+the provided callback will be called in a new coroutine every time something connects.
+If `reuse_port` is true, other listeners with `reuse_port` can bind to the same port
+(see `linux_threaded_tcp_listener_t`). */
 
 class linux_nonthrowing_tcp_listener_t : private linux_event_callback_t {
 public:
     linux_nonthrowing_tcp_listener_t(const std::set<ip_address_t> &bind_addresses, int _port,
-        const std::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t> &)> &callback);
+        const std::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t> &)> &callback,
+        bool reuse_port = false);
 
     ~linux_nonthrowing_tcp_listener_t();
 
@@ -499,6 +530,9 @@ private:
     // The port we're asked to bind to
     int port;
 
+    // Whether to set `SO_REUSEPORT` on our sockets
+    bool reuse_port;
+
     // Inidicates successful binding to a port
     bool bound;
 
@@ -539,6 +573,43 @@ private:
     scoped_ptr_t<linux_nonthrowing_tcp_listener_t> listener;
 };
 
+/* Listens on the same port on every DB thread, using `SO_REUSEPORT`, so that the kernel
+spreads incoming connections across the threads and no single thread has to accept all
+of them. `callback` is called on the thread that accepted the connection, so that
+everything the connection does, starting with its handshake, stays on that thread.
+
+If the port can't be shared (because the platform doesn't support `SO_REUSEPORT`),
+there is a single listener on the constructing thread instead, which hands the
+connections out to the DB threads round-robin. Either way, `callback` is called on
+some DB thread. Throws `address_in_use_exc_t` if the port is taken. */
+class linux_threaded_tcp_listener_t {
+public:
+    linux_threaded_tcp_listener_t(const std::set<ip_address_t> &bind_addresses, int port,
+        const std::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t> &)> &callback);
+    ~linux_threaded_tcp_listener_t();
+
+    int get_port() const;
+
+private:
+    bool listen_on_every_thread(const std::set<ip_address_t> &bind_addresses);
+    void destroy_listeners();
+    void hand_out(scoped_ptr_t<linux_tcp_conn_descriptor_t> &nconn);
+
+    std::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t> &)> callback;
+    int port;
+
+    // Used by `hand_out()` for the round-robin
+    int next_thread;
+
+    // `listeners[i]` lives on thread `i`, and is empty on the threads not listening
+    scoped_array_t<scoped_ptr_t<linux_nonthrowing_tcp_listener_t> > listeners;
+
+    // Keeps `hand_out()` from outliving us
+    auto_drainer_t drainer;
+
+    DISABLE_COPYING(linux_threaded_tcp_listener_t);
+};
+
 /* Like a linux tcp listener but repeatedly tries to bind to its port until successful */
 class linux_repeated_nonthrowing_tcp_listener_t {
 public:
@@ -183,6 +183,8 @@ void context_switch(fiber_context_ref_t *curr_context_out, fiber_context_ref_t *
 
 #include "arch/runtime/thread_pool.hpp"
 #include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/numa.hpp"
+#include "arch/runtime/runtime.hpp"
 #include "arch/io/concurrency.hpp"
 #include "containers/scoped.hpp"
 #include "errors.hpp"
@@ -215,6 +217,15 @@ artificial_stack_t::artificial_stack_t(void (*initial_fun)(void), size_t _stack_
     guarantee(stack_size >= static_cast<size_t>(getpagesize()));
     madvise(stack.get(), stack_size - getpagesize(), MADV_DONTNEED);
 
+    // Coroutines can run on other threads for a while (see `on_thread_t`), so the
+    // stack's pages could get allocated on a remote NUMA node. Keep them on the node of
+    // the thread that the coroutine belongs to instead.
+    int numa_node = get_numa_node(get_thread_id());
+    if (numa_node != -1) {
+        prefer_numa_node_for_memory(stack.get(),
+            stack_size - stack_size % getpagesize(), numa_node);
+    }
+
     // Register our stack with Valgrind so that it understands what's going on
     // and doesn't create spurious errors.
 #ifdef VALGRIND
@@ -379,6 +390,24 @@ void artificial_stack_t::disable_overflow_protection() {
 #endif
 }
 
+void artificial_stack_t::release_unused_pages() {
+    if (context.is_nil()) {
+        return;
+    }
+    /* We leave the page below the one that the stack pointer is on alone, just to be
+    safe. The protection page (if any) isn't backed by memory anyway. */
+    const uintptr_t page_size = getpagesize();
+    uintptr_t start = reinterpret_cast<uintptr_t>(stack.get());
+    if (overflow_protection_enabled) {
+        start += page_size;
+    }
+    const uintptr_t sp = reinterpret_cast<uintptr_t>(context.pointer);
+    const uintptr_t end = (sp & ~(page_size - 1)) - page_size;
+    if (end > start) {
+        madvise(reinterpret_cast<void *>(start), end - start, MADV_DONTNEED);
+    }
+}
+
 bool artificial_stack_t::address_in_stack(const void *addr) const {
     return reinterpret_cast<uintptr_t>(addr) >=
             reinterpret_cast<uintptr_t>(get_stack_bound())
@@ -28,6 +28,9 @@ public:
     I think fibers always have some overflow protection though? */
     void enable_overflow_protection() {}
     void disable_overflow_protection() {}
+
+    /* Not implemented for fiber stacks either. */
+    void release_unused_pages() {}
 };
 
 void context_switch(fiber_context_ref_t *current_context_out, fiber_context_ref_t *dest_context_in);
@@ -108,6 +111,11 @@ public:
     /* Disables stack-smashing protection for this stack, if currently enabled */
     void disable_overflow_protection();
 
+    /* Gives the pages below the stack pointer of the swapped-out context back to the
+    operating system. They will read as zeros if the stack grows into them again. Does
+    nothing if the stack's context is currently running. */
+    void release_unused_pages();
+
 private:
     scoped_page_aligned_ptr_t<char> stack;
     size_t stack_size;
@@ -224,9 +232,10 @@ public:
     /* Returns how many more bytes below the given address can be used */
     size_t free_space_below(const void *addr) const;
 
-    /* These two are currently not implemented for threaded stacks. */
+    /* These three are currently not implemented for threaded stacks. */
     void enable_overflow_protection() {}
     void disable_overflow_protection() {}
+    void release_unused_pages() {}
 
 private:
     static void *internal_run(void *p);
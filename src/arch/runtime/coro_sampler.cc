@@ -0,0 +1,230 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/runtime/coro_sampler.hpp"
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <utility>
+
+#include "arch/runtime/thread_pool.hpp"
+#include "arch/spinlock.hpp"
+#include "backtrace.hpp"
+#include "concurrency/cache_line_padded.hpp"
+#include "config/args.hpp"
+#include "rethinkdb_backtrace.hpp"
+#include "time.hpp"
+#include "utils.hpp"
+
+std::atomic<bool> coro_sampler_t::enabled(false);
+
+namespace {
+
+struct site_samples_t {
+    site_samples_t() : resumes(0), running_nanos(0), max_running_nanos(0) { }
+    uint64_t resumes;
+    int64_t running_nanos;
+    int64_t max_running_nanos;
+    std::map<std::vector<void *>, uint64_t> yield_points;
+};
+
+struct thread_samples_t {
+    thread_samples_t() : running_site(nullptr), yields(0) { }
+
+    void clear() {
+        sites.clear();
+        running_site = nullptr;
+        yields = 0;
+    }
+
+    spinlock_t spinlock;
+    std::map<const char *, site_samples_t> sites;
+    /* The spawn site of the coroutine that is currently running on this thread, and
+    when it resumed. `nullptr` if we didn't see it resume. */
+    const char *running_site;
+    ticks_t resumed_at;
+    uint64_t yields;
+};
+
+/* Every sample is recorded on the thread where it happens, so that threads never
+contend for the same lock unless somebody is reading a report. */
+std::array<cache_line_padded_t<thread_samples_t>, MAX_THREADS> *get_thread_samples() {
+    static std::array<cache_line_padded_t<thread_samples_t>, MAX_THREADS> samples;
+    return &samples;
+}
+
+thread_samples_t *get_current_thread_samples() {
+    int threadnum = linux_thread_pool_t::get_thread_id();
+    if (threadnum < 0 || threadnum >= MAX_THREADS) {
+        return nullptr;
+    }
+    return &(*get_thread_samples())[threadnum].value;
+}
+
+/* Protects `enabled_at` and `disabled_at`, and serializes calls to `set_enabled()`. */
+spinlock_t *get_state_spinlock() {
+    static spinlock_t spinlock;
+    return &spinlock;
+}
+ticks_t enabled_at = { 0 };
+ticks_t disabled_at = { 0 };
+
+}  // namespace
+
+std::string format_spawn_site(const char *spawn_site) {
+    std::string site(spawn_site);
+    const std::string marker = "callable_t = ";
+    size_t start = site.find(marker);
+    if (start == std::string::npos) {
+        return site;
+    }
+    start += marker.size();
+    size_t end = site.size();
+    if (end > start && site[end - 1] == ']') {
+        --end;
+    }
+    return site.substr(start, end - start);
+}
+
+void coro_sampler_t::set_enabled(bool _enabled) {
+    spinlock_acq_t state_lock(get_state_spinlock());
+    if (_enabled == is_enabled()) {
+        return;
+    }
+    if (_enabled) {
+        for (auto &thread : *get_thread_samples()) {
+            spinlock_acq_t thread_lock(&thread.value.spinlock);
+            thread.value.clear();
+        }
+        enabled_at = get_ticks();
+    } else {
+        disabled_at = get_ticks();
+    }
+    enabled.store(_enabled);
+}
+
+coro_sampler_t::report_t coro_sampler_t::get_report(size_t max_yield_points) {
+    report_t report;
+    {
+        spinlock_acq_t state_lock(get_state_spinlock());
+        report.enabled = is_enabled();
+        ticks_t until = report.enabled ? get_ticks() : disabled_at;
+        report.sampling_secs = enabled_at.nanos == 0
+            ? 0.0
+            : ticks_to_secs(ticks_t{until.nanos - enabled_at.nanos});
+    }
+
+    /* Merge the samples from all threads. We hold each thread's lock only for as long
+    as it takes to copy its samples; symbols are resolved afterwards. */
+    std::map<const char *, site_samples_t> merged;
+    for (auto &thread : *get_thread_samples()) {
+        spinlock_acq_t thread_lock(&thread.value.spinlock);
+        for (const auto &pair : thread.value.sites) {
+            site_samples_t *site = &merged[pair.first];
+            site->resumes += pair.second.resumes;
+            site->running_nanos += pair.second.running_nanos;
+            site->max_running_nanos =
+                std::max(site->max_running_nanos, pair.second.max_running_nanos);
+            for (const auto &point : pair.second.yield_points) {
+                site->yield_points[point.first] += point.second;
+            }
+        }
+    }
+
+    /* Several spawn sites can have the same name, for example if the same lambda type
+    is spawned from template code. */
+    std::map<std::string, spawn_site_t> by_name;
+    std::map<std::string, std::map<std::vector<void *>, uint64_t> > points_by_name;
+    for (const auto &pair : merged) {
+        std::string name = format_spawn_site(pair.first);
+        spawn_site_t *site = &by_name[name];
+        site->spawn_site = name;
+        site->resumes += pair.second.resumes;
+        site->running_secs += ticks_to_secs(ticks_t{pair.second.running_nanos});
+        site->max_running_secs = std::max(site->max_running_secs,
+            ticks_to_secs(ticks_t{pair.second.max_running_nanos}));
+        for (const auto &point : pair.second.yield_points) {
+            points_by_name[name][point.first] += point.second;
+        }
+    }
+
+    for (auto &pair : by_name) {
+        std::vector<std::pair<uint64_t, const std::vector<void *> *> > points;
+        for (const auto &point : points_by_name[pair.first]) {
+            points.push_back(std::make_pair(point.second, &point.first));
+        }
+        std::sort(points.begin(), points.end(),
+            [](const std::pair<uint64_t, const std::vector<void *> *> &a,
+               const std::pair<uint64_t, const std::vector<void *> *> &b) {
+                return a.first > b.first;
+            });
+        if (points.size() > max_yield_points) {
+            points.resize(max_yield_points);
+        }
+        for (const auto &point : points) {
+            yield_point_t yield_point;
+            yield_point.samples = point.first;
+            for (void *addr : *point.second) {
+                yield_point.backtrace.push_back(
+                    backtrace_frame_t(addr).get_function_name());
+            }
+            pair.second.yield_points.push_back(std::move(yield_point));
+        }
+        report.spawn_sites.push_back(std::move(pair.second));
+    }
+    std::sort(report.spawn_sites.begin(), report.spawn_sites.end(),
+        [](const spawn_site_t &a, const spawn_site_t &b) {
+            return a.running_secs > b.running_secs;
+        });
+    return report;
+}
+
+void coro_sampler_t::do_record_resume(const char *spawn_site) {
+    thread_samples_t *samples = get_current_thread_samples();
+    if (samples == nullptr) {
+        return;
+    }
+    spinlock_acq_t thread_lock(&samples->spinlock);
+    samples->running_site = spawn_site;
+    samples->resumed_at = get_ticks();
+    ++samples->sites[spawn_site].resumes;
+}
+
+void coro_sampler_t::do_record_yield() {
+    thread_samples_t *samples = get_current_thread_samples();
+    if (samples == nullptr) {
+        return;
+    }
+    ticks_t now = get_ticks();
+
+    /* We take the backtrace before acquiring the lock, because it's slow. Strip our own
+    frame and the ones inside `rethinkdb_backtrace()`. */
+    std::vector<void *> frames;
+    bool take_backtrace;
+    {
+        spinlock_acq_t thread_lock(&samples->spinlock);
+        take_backtrace = samples->running_site != nullptr
+            && ++samples->yields % CORO_SAMPLER_YIELD_SAMPLE_INTERVAL == 0;
+    }
+    if (take_backtrace) {
+        const int strip = 1 + NUM_FRAMES_INSIDE_RETHINKDB_BACKTRACE;
+        void *buffer[CORO_SAMPLER_BACKTRACE_DEPTH + strip];
+        int size = rethinkdb_backtrace(buffer, CORO_SAMPLER_BACKTRACE_DEPTH + strip);
+        if (size > strip) {
+            frames.assign(buffer + strip, buffer + size);
+        }
+    }
+
+    spinlock_acq_t thread_lock(&samples->spinlock);
+    if (samples->running_site == nullptr) {
+        // The sampler was turned on while the coroutine was running.
+        return;
+    }
+    site_samples_t *site = &samples->sites[samples->running_site];
+    int64_t running_nanos = now.nanos - samples->resumed_at.nanos;
+    site->running_nanos += running_nanos;
+    site->max_running_nanos = std::max(site->max_running_nanos, running_nanos);
+    if (!frames.empty()) {
+        ++site->yield_points[frames];
+    }
+    samples->running_site = nullptr;
+}
@@ -0,0 +1,90 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef ARCH_RUNTIME_CORO_SAMPLER_HPP_
+#define ARCH_RUNTIME_CORO_SAMPLER_HPP_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+/* How many frames we record when sampling the point where a coroutine yields. */
+#define CORO_SAMPLER_BACKTRACE_DEPTH             12
+
+/* We only take a backtrace for one in this many yields, because backtraces are
+expensive. */
+#define CORO_SAMPLER_YIELD_SAMPLE_INTERVAL       64
+
+/* `coro_sampler_t` is a cheap coroutine profiler that can be switched on and off while
+the server is running. Unlike `coro_profiler_t`, it doesn't need a special build, so we
+can use it on production servers. It's exposed through the `rethinkdb._debug_coro_profile`
+table.
+
+While it's on, it records the following for each spawn site. The spawn site is the type
+of the function that the coroutine was spawned with.
+    - How many times coroutines from that site have resumed running.
+    - How long they have run for in total, and the longest that any of them ran
+      without yielding.
+    - Where they yield. For one in every `CORO_SAMPLER_YIELD_SAMPLE_INTERVAL` yields,
+      we record a short backtrace.
+While it's off, it costs an atomic load each time a coroutine resumes or yields. */
+class coro_sampler_t {
+public:
+    struct yield_point_t {
+        std::vector<std::string> backtrace;
+        uint64_t samples;
+    };
+
+    struct spawn_site_t {
+        std::string spawn_site;
+        uint64_t resumes;
+        double running_secs;
+        double max_running_secs;
+        /* The most frequently sampled yield points, most frequent first */
+        std::vector<yield_point_t> yield_points;
+    };
+
+    struct report_t {
+        bool enabled;
+        /* How long the samples in this report were collected for. */
+        double sampling_secs;
+        /* Ordered by `running_secs`, highest first */
+        std::vector<spawn_site_t> spawn_sites;
+    };
+
+    /* Turning the sampler on discards the samples from any earlier run. Turning it off
+    keeps them around, so they can still be read. Can be called from any thread. */
+    static void set_enabled(bool enabled);
+    static bool is_enabled() {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    /* Collects the samples from all threads. `max_yield_points` limits the number of
+    yield points per spawn site. Can be called from any thread, but it's slow. */
+    static report_t get_report(size_t max_yield_points);
+
+    /* These are called by the coroutine implementation whenever a coroutine starts or
+    stops running on the current thread. */
+    static void record_resume(const char *spawn_site) {
+        if (is_enabled()) {
+            do_record_resume(spawn_site);
+        }
+    }
+    static void record_yield() {
+        if (is_enabled()) {
+            do_record_yield();
+        }
+    }
+
+private:
+    static void do_record_resume(const char *spawn_site);
+    static void do_record_yield();
+
+    static std::atomic<bool> enabled;
+};
+
+/* The spawn site is the pretty function name of `coro_t::get_and_init_coro()`. This
+returns just the type of the callable, which is the interesting part. */
+std::string format_spawn_site(const char *spawn_site);
+
+#endif  // ARCH_RUNTIME_CORO_SAMPLER_HPP_
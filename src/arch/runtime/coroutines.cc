@@ -13,12 +13,14 @@
 
 #include "arch/runtime/context_switching.hpp"
 #include "arch/runtime/coro_profiler.hpp"
+#include "arch/runtime/coro_sampler.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "arch/runtime/thread_pool.hpp"
 #include "config/args.hpp"
 #include "debug.hpp"
 #include "do_on_thread.hpp"
 #include "logger.hpp"
+#include "perfmon/memory_usage.hpp"
 #include "perfmon/perfmon.hpp"
 #include "rethinkdb_backtrace.hpp"
 #include "thread_local.hpp"
@@ -164,10 +166,12 @@ TLS_with_init(int64_t, coro_selfname_counter, 0);
 
 coro_t::coro_t() :
     stack(&coro_t::run, coro_stack_size),
+    stack_size_(coro_stack_size),
     current_thread_(linux_thread_pool_t::get_thread_id()),
     notified_(false),
     waiting_(false),
-    protected_stack_lru_entry_(this)
+    protected_stack_lru_entry_(this),
+    spawn_site_(nullptr)
 #ifndef NDEBUG
     , selfname_number(get_thread_id().threadnum + MAX_THREADS *
           // The comma here is the comma operator, to implement the semantics
@@ -180,6 +184,7 @@ coro_t::coro_t() :
 #endif
 {
     ++pm_allocated_coroutines;
+    add_memory_usage(memory_usage_category_t::COROUTINE_STACKS, stack_size_);
 
 #ifndef NDEBUG
     TLS_get_cglobals()->coro_count++;
@@ -216,6 +221,8 @@ coro_t::~coro_t() {
     TLS_get_cglobals()->coro_count--;
 #endif
     --pm_allocated_coroutines;
+    add_memory_usage(memory_usage_category_t::COROUTINE_STACKS,
+                     -static_cast<int64_t>(stack_size_));
 }
 
 /* Helper function for switching into a new context and making sure that the new context
@@ -230,11 +237,18 @@ void coro_t::switch_to_coro_with_protection(coro_context_ref_t *current_context)
     cglobals->protected_coros_lru.push_back(&protected_stack_lru_entry_);
 
     /* If there are too many protected coroutines, unprotect the oldest one and pop it of
-    the list. */
+    the list. A coroutine that has fallen off the end of the list hasn't run for a while,
+    so it's probably idle, for example waiting for a changefeed or a client connection.
+    We give the memory below its stack pointer back to the operating system. Otherwise
+    every idle coroutine would keep however much stack it had once used. */
     size_t max_protected_coros_per_thread =
         MAX_PROTECTED_COROS / static_cast<size_t>(get_num_threads());
     while (cglobals->protected_coros_lru.size() > max_protected_coros_per_thread) {
-        cglobals->protected_coros_lru.head()->coro->stack.disable_overflow_protection();
+        coro_t *least_recent = cglobals->protected_coros_lru.head()->coro;
+        least_recent->stack.disable_overflow_protection();
+        if (least_recent != this) {
+            least_recent->stack.release_unused_pages();
+        }
         cglobals->protected_coros_lru.pop_front();
     }
 
@@ -274,7 +288,9 @@ void coro_t::run() {
         TLS_get_cglobals()->active_coroutines.insert(coro);
 #endif
         PROFILER_CORO_RESUME;
+        coro_sampler_t::record_resume(coro->spawn_site_);
         coro->action_wrapper.run();
+        coro_sampler_t::record_yield();
         PROFILER_CORO_YIELD(0);
 #ifndef NDEBUG
         TLS_get_cglobals()->running_coroutine_counts[coro->coroutine_type]--;
@@ -361,12 +377,14 @@ void coro_t::wait() {   /* class method */
     self()->waiting_ = true;
 
     PROFILER_CORO_YIELD(1);
+    coro_sampler_t::record_yield();
     if (TLS_get_cglobals()->prev_coro) {
         TLS_get_cglobals()->prev_coro->switch_to_coro_with_protection(
             &self()->stack.context);
     } else {
         switch_to_scheduler(&self()->stack.context, &TLS_get_cglobals()->scheduler);
     }
+    coro_sampler_t::record_resume(self()->spawn_site_);
     PROFILER_CORO_RESUME;
 
     rassert(self());
@@ -404,6 +422,7 @@ void coro_t::notify_now_deprecated() {
 
     if (coro_t::self() != nullptr) {
         PROFILER_CORO_YIELD(1);
+        coro_sampler_t::record_yield();
     }
     coro_t *prev_prev_coro = TLS_get_cglobals()->prev_coro;
     TLS_get_cglobals()->prev_coro = TLS_get_cglobals()->current_coro;
@@ -419,6 +438,7 @@ void coro_t::notify_now_deprecated() {
     TLS_get_cglobals()->current_coro = TLS_get_cglobals()->prev_coro;
     TLS_get_cglobals()->prev_coro = prev_prev_coro;
     if (coro_t::self() != nullptr) {
+        coro_sampler_t::record_resume(coro_t::self()->spawn_site_);
         PROFILER_CORO_RESUME;
     }
 
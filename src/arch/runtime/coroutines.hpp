@@ -109,6 +109,10 @@ public:
     coroutine. */
     static coro_t *self();
 
+    /* Identifies the function the coroutine was spawned with; see
+    `format_spawn_site()`. */
+    const char *get_spawn_site() const { return spawn_site_; }
+
     /* Transfers control immediately to the coroutine. Returns when the
     coroutine calls `wait()`.
 
@@ -190,6 +194,7 @@ private:
 #ifndef NDEBUG
         coro->parse_coroutine_type(CURRENT_FUNCTION_PRETTY);
 #endif
+        coro->spawn_site_ = CURRENT_FUNCTION_PRETTY;
         coro->grab_spawn_backtrace();
         coro->action_wrapper.reset(std::forward<callable_t>(action));
 
@@ -218,6 +223,7 @@ private:
     virtual void on_thread_switch();
 
     coro_stack_t stack;
+    size_t stack_size_;
 
     threadnum_t current_thread_;
 
@@ -230,6 +236,10 @@ private:
     /* Used to eventually unprotect the coroutine if it has been inactive for a while. */
     coro_lru_entry_t protected_stack_lru_entry_;
 
+    /* Identifies the function the coroutine was spawned with, for `coro_sampler_t`
+    and `cpu_profiler_t`. */
+    const char *spawn_site_;
+
 #ifndef NDEBUG
     int64_t selfname_number;
     std::string coroutine_type;
@@ -0,0 +1,201 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/runtime/cpu_profiler.hpp"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <signal.h>
+#ifndef _WIN32
+#include <sys/time.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "arch/runtime/coro_sampler.hpp"
+#include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/runtime_utils.hpp"
+#include "arch/spinlock.hpp"
+#include "backtrace.hpp"
+#include "config/args.hpp"
+#include "rethinkdb_backtrace.hpp"
+#include "time.hpp"
+#include "utils.hpp"
+
+namespace {
+
+/* A sample is written by the signal handler on the thread that was interrupted, and
+only becomes visible to readers once `ready` is set. */
+struct sample_t {
+    std::atomic<bool> ready;
+    const char *spawn_site;
+    int depth;
+    void *frames[CPU_PROFILER_BACKTRACE_DEPTH];
+};
+
+/* The frames that the signal handler itself adds to each backtrace: the handler, the
+kernel's signal trampoline, and the ones inside `rethinkdb_backtrace()`. */
+const int NUM_FRAMES_INSIDE_SIGNAL_HANDLER = 2 + NUM_FRAMES_INSIDE_RETHINKDB_BACKTRACE;
+
+/* `sample_buffer` is allocated the first time the profiler starts and never freed, so
+that a signal that arrives late can't write to freed memory. */
+std::atomic<sample_t *> sample_buffer(nullptr);
+std::atomic<uint64_t> next_sample(0);
+std::atomic<bool> running(false);
+
+/* Protects `started_at` and `stopped_at`, and serializes `start()` and `stop()`. */
+spinlock_t *get_state_spinlock() {
+    static spinlock_t spinlock;
+    return &spinlock;
+}
+ticks_t started_at = { 0 };
+ticks_t stopped_at = { 0 };
+
+#ifndef _WIN32
+/* This must be async-signal-safe, so it doesn't allocate or take any locks. */
+void sigprof_handler(int) {
+    if (!running.load(std::memory_order_relaxed)) {
+        return;
+    }
+    sample_t *buffer = sample_buffer.load(std::memory_order_acquire);
+    uint64_t index = next_sample.fetch_add(1, std::memory_order_relaxed);
+    if (buffer == nullptr || index >= CPU_PROFILER_MAX_SAMPLES) {
+        return;
+    }
+    int saved_errno = errno;
+    sample_t *sample = &buffer[index];
+    coro_t *coro = coro_t::self();
+    sample->spawn_site = coro == nullptr ? nullptr : coro->get_spawn_site();
+    sample->depth = rethinkdb_backtrace(sample->frames, CPU_PROFILER_BACKTRACE_DEPTH);
+    sample->ready.store(true, std::memory_order_release);
+    errno = saved_errno;
+}
+
+void set_profiling_timer(int64_t interval_micros) {
+    struct itimerval timer;
+    timer.it_interval.tv_sec = interval_micros / MILLION;
+    timer.it_interval.tv_usec = interval_micros % MILLION;
+    timer.it_value = timer.it_interval;
+    int res = setitimer(ITIMER_PROF, &timer, nullptr);
+    guarantee_err(res == 0, "Could not set the profiling timer");
+}
+#endif
+
+uint64_t num_samples_taken() {
+    return std::min<uint64_t>(next_sample.load(), CPU_PROFILER_MAX_SAMPLES);
+}
+
+}  // namespace
+
+void cpu_profiler_t::start() {
+#ifndef _WIN32
+    spinlock_acq_t state_lock(get_state_spinlock());
+    if (running.load()) {
+        return;
+    }
+    sample_t *buffer = sample_buffer.load();
+    if (buffer == nullptr) {
+        /* The first call to `backtrace()` may allocate memory to load the unwinder,
+        which we can't do in the signal handler. */
+        void *frames[1];
+        rethinkdb_backtrace(frames, 1);
+
+        buffer = new sample_t[CPU_PROFILER_MAX_SAMPLES]();
+        sample_buffer.store(buffer);
+
+        struct sigaction sa = make_sa_handler(SA_RESTART, &sigprof_handler);
+        int res = sigaction(SIGPROF, &sa, nullptr);
+        guarantee_err(res == 0, "Could not install SIGPROF handler");
+    } else {
+        uint64_t num_samples = num_samples_taken();
+        for (uint64_t i = 0; i < num_samples; ++i) {
+            buffer[i].ready.store(false);
+        }
+    }
+    next_sample.store(0);
+    started_at = get_ticks();
+    running.store(true);
+    set_profiling_timer(MILLION / CPU_PROFILER_FREQUENCY_HZ);
+#endif
+}
+
+void cpu_profiler_t::stop() {
+#ifndef _WIN32
+    spinlock_acq_t state_lock(get_state_spinlock());
+    if (!running.load()) {
+        return;
+    }
+    set_profiling_timer(0);
+    running.store(false);
+    stopped_at = get_ticks();
+#endif
+}
+
+cpu_profiler_t::status_t cpu_profiler_t::get_status() {
+    status_t status;
+    {
+        spinlock_acq_t state_lock(get_state_spinlock());
+        status.running = running.load();
+        ticks_t until = status.running ? get_ticks() : stopped_at;
+        status.sampling_secs = started_at.nanos == 0
+            ? 0.0
+            : ticks_to_secs(ticks_t{until.nanos - started_at.nanos});
+    }
+    uint64_t taken = next_sample.load();
+    status.samples = std::min<uint64_t>(taken, CPU_PROFILER_MAX_SAMPLES);
+    status.dropped_samples = taken - status.samples;
+    return status;
+}
+
+std::string cpu_profiler_t::get_folded_stacks() {
+    sample_t *buffer = sample_buffer.load();
+    if (buffer == nullptr) {
+        return "";
+    }
+
+    /* Count the distinct stacks first, so that we resolve each address only once. */
+    std::map<std::pair<const char *, std::vector<void *> >, uint64_t> stacks;
+    uint64_t num_samples = num_samples_taken();
+    for (uint64_t i = 0; i < num_samples; ++i) {
+        const sample_t &sample = buffer[i];
+        if (!sample.ready.load(std::memory_order_acquire)
+            || sample.depth <= NUM_FRAMES_INSIDE_SIGNAL_HANDLER) {
+            continue;
+        }
+        ++stacks[std::make_pair(
+            sample.spawn_site,
+            std::vector<void *>(sample.frames + NUM_FRAMES_INSIDE_SIGNAL_HANDLER,
+                                sample.frames + sample.depth))];
+    }
+
+    std::map<void *, std::string> frame_names;
+    std::map<const char *, std::string> spawn_site_names;
+    std::string folded;
+    for (const auto &stack : stacks) {
+        const char *spawn_site = stack.first.first;
+        auto site_it = spawn_site_names.find(spawn_site);
+        if (site_it == spawn_site_names.end()) {
+            site_it = spawn_site_names.insert(std::make_pair(spawn_site,
+                spawn_site == nullptr
+                    ? std::string("[not in a coroutine]")
+                    : "[coroutine " + format_spawn_site(spawn_site) + "]")).first;
+        }
+        folded += site_it->second;
+
+        /* Backtraces go from the innermost frame outwards. */
+        const std::vector<void *> &frames = stack.first.second;
+        for (auto it = frames.rbegin(); it != frames.rend(); ++it) {
+            auto name_it = frame_names.find(*it);
+            if (name_it == frame_names.end()) {
+                std::string name = backtrace_frame_t(*it).get_function_name();
+                std::replace(name.begin(), name.end(), ';', ':');
+                name_it = frame_names.insert(std::make_pair(*it, name)).first;
+            }
+            folded += ";" + name_it->second;
+        }
+        folded += strprintf(" %" PRIu64 "\n", stack.second);
+    }
+    return folded;
+}
@@ -0,0 +1,56 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef ARCH_RUNTIME_CPU_PROFILER_HPP_
+#define ARCH_RUNTIME_CPU_PROFILER_HPP_
+
+#include <stdint.h>
+
+#include <string>
+
+/* How many times per second of CPU time we take a sample. */
+#define CPU_PROFILER_FREQUENCY_HZ                100
+
+/* How many frames we record per sample. */
+#define CPU_PROFILER_BACKTRACE_DEPTH             48
+
+/* How many samples we keep. Samples that are taken after this many are dropped. At
+`CPU_PROFILER_FREQUENCY_HZ` this is enough for several minutes of profiling even if all
+threads are busy. The buffer is allocated the first time the profiler is started. */
+#define CPU_PROFILER_MAX_SAMPLES                 100000
+
+/* `cpu_profiler_t` is a sampling CPU profiler that can be started and stopped while the
+server is running, so that we can find CPU hot spots on production servers without
+attaching an external profiler. It's exposed through the `/cpu_profile` route of the
+admin HTTP server.
+
+While it's running, an `ITIMER_PROF` timer raises `SIGPROF` on whichever thread is
+using the CPU, `CPU_PROFILER_FREQUENCY_HZ` times per second of CPU time. The signal
+handler records a backtrace and the spawn site of the running coroutine, if any.
+Symbols are only resolved when the samples are read. While it's stopped, it costs
+nothing. */
+class cpu_profiler_t {
+public:
+    struct status_t {
+        bool running;
+        /* How long the samples were collected for. */
+        double sampling_secs;
+        uint64_t samples;
+        /* The number of samples that didn't fit into the buffer. */
+        uint64_t dropped_samples;
+    };
+
+    /* Starting the profiler discards the samples from any earlier run. Stopping it
+    keeps them around, so they can still be read. Can be called from any thread. */
+    static void start();
+    static void stop();
+
+    static status_t get_status();
+
+    /* Returns the samples in the "folded stacks" format that flame graph tools read.
+    Each line is a distinct stack followed by a space and the number of times it was
+    sampled. The frames are separated by `;` and go from the outermost to the
+    innermost, starting with the coroutine's spawn site. Can be called from any
+    thread, but it's slow because it resolves symbols. */
+    static std::string get_folded_stacks();
+};
+
+#endif  // ARCH_RUNTIME_CPU_PROFILER_HPP_
@@ -35,6 +35,12 @@ typedef iocp_event_queue_t linux_event_queue_t;
 #include "arch/runtime/event_queue/kqueue.hpp"
 typedef kqueue_event_queue_t linux_event_queue_t;
 
+#elif defined(__linux) && defined(IO_URING_EVENT_QUEUE)
+
+// Batch the poll requests and the waiting into single io_uring syscalls
+#include "arch/runtime/event_queue/uring.hpp"
+typedef uring_event_queue_t linux_event_queue_t;
+
 #elif !defined(__linux) || defined(NO_EPOLL)
 
 // Use poll instead of epoll
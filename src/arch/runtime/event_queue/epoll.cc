@@ -18,6 +18,7 @@
 #include "arch/runtime/event_queue.hpp"
 #include "arch/runtime/thread_pool.hpp"
 #include "perfmon/perfmon.hpp"
+#include "time.hpp"
 
 int user_to_epoll(int mode) {
 
@@ -53,13 +54,31 @@ epoll_event_queue_t::epoll_event_queue_t(linux_queue_parent_t *_parent)
     guarantee_err(epoll_fd >= 0, "Could not create epoll fd");
 }
 
+int epoll_event_queue_t::wait_for_events(int64_t spin_nanos) {
+    if (spin_nanos > 0) {
+        /* Poll without blocking for a while before going to sleep. Messages from other
+        threads show up as events on the message hub's eventfd, so we pick those up too.
+        Anything that arrives while we spin is handled without the kernel having to
+        wake the thread up again, which is the expensive part. */
+        const int64_t deadline = get_ticks().nanos + spin_nanos;
+        do {
+            int res = epoll_wait(epoll_fd, events, MAX_IO_EVENT_PROCESSING_BATCH_SIZE, 0);
+            if (res != 0) {
+                return res;
+            }
+        } while (get_ticks().nanos < deadline);
+    }
+    return epoll_wait(epoll_fd, events, MAX_IO_EVENT_PROCESSING_BATCH_SIZE, -1);
+}
+
 void epoll_event_queue_t::run() {
     int res;
+    const int64_t spin_nanos = parent->get_spin_nanos();
 
     // Now, start the loop
     while (!parent->should_shut_down()) {
         // Grab the events from the kernel!
-        res = epoll_wait(epoll_fd, events, MAX_IO_EVENT_PROCESSING_BATCH_SIZE, -1);
+        res = wait_for_events(spin_nanos);
 
         // epoll_wait might return with EINTR in some cases (in
         // particular under GDB), we just need to retry.
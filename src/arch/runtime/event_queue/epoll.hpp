@@ -30,6 +30,9 @@ public:
     void forget_event(system_event_t *, linux_event_callback_t *cb);
 
 private:
+    // Spins for up to `spin_nanos` before blocking. Returns what `epoll_wait()` returns.
+    int wait_for_events(int64_t spin_nanos);
+
     linux_queue_parent_t *parent;
 
     fd_t epoll_fd;
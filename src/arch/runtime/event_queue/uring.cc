@@ -0,0 +1,198 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#if defined(__linux) && defined(IO_URING_EVENT_QUEUE)
+
+#include "arch/runtime/event_queue/uring.hpp"
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+
+#include "config/args.hpp"
+#include "utils.hpp"
+#include "arch/runtime/event_queue.hpp"
+#include "arch/runtime/thread_pool.hpp"
+#include "perfmon/perfmon.hpp"
+
+#if !IO_URING_SUPPORTED
+#error "IO_URING_EVENT_QUEUE requires <linux/io_uring.h>"
+#endif
+
+// The number of SQEs on the ring.  The kernel sizes the completion queue to twice
+// that, and buffers completions internally if we fall behind.
+const unsigned int URING_EVENT_QUEUE_ENTRIES = 4096;
+
+namespace {
+
+int user_to_uring_poll(int mode) {
+    rassert((mode & (poll_event_in | poll_event_out | poll_event_rdhup)) == mode);
+
+    int out_mode = 0;
+    if (mode & poll_event_in) out_mode |= POLLIN;
+    if (mode & poll_event_out) out_mode |= POLLOUT;
+    if (mode & poll_event_rdhup) out_mode |= POLLRDHUP;
+
+    return out_mode;
+}
+
+int uring_poll_to_user(int mode) {
+    int out_mode = 0;
+    if (mode & POLLIN) out_mode |= poll_event_in;
+    if (mode & POLLOUT) out_mode |= poll_event_out;
+    if (mode & POLLERR) out_mode |= poll_event_err;
+    if (mode & POLLHUP) out_mode |= poll_event_hup;
+    if (mode & POLLRDHUP) out_mode |= poll_event_rdhup;
+
+    return out_mode;
+}
+
+}  // namespace
+
+uring_event_queue_t::uring_event_queue_t(linux_queue_parent_t *_parent)
+    : parent(_parent), ring(new io_uring_ring_t(URING_EVENT_QUEUE_ENTRIES)) { }
+
+void uring_event_queue_t::run() {
+    // Now, start the loop
+    while (!parent->should_shut_down()) {
+        // Hand the kernel every poll request made since the last iteration, and grab
+        // the next batch of events, in one go.  This returns false if we got
+        // interrupted (in particular under GDB), in which case we process whatever
+        // events there are and retry.
+        UNUSED bool waited = ring->submit(true);
+
+        block_pm_duration event_loop_timer(pm_eventloop_singleton_t::get());
+
+        ring->consume_completions([this](const io_uring_cqe &cqe) {
+            // Completions of our `IORING_OP_POLL_REMOVE` requests have no user data.
+            if (cqe.user_data != 0) {
+                on_completion(reinterpret_cast<poll_request_t *>(cqe.user_data),
+                              cqe.res, cqe.flags);
+            }
+        });
+
+        parent->pump();
+    }
+}
+
+uring_event_queue_t::~uring_event_queue_t() {
+    // Closing the ring cancels any poll requests that are still on it.
+    ring.reset();
+    for (auto it = live_requests.begin(); it != live_requests.end(); ++it) {
+        delete it->second;
+    }
+    for (poll_request_t *request : cancelled_requests) {
+        delete request;
+    }
+}
+
+void uring_event_queue_t::on_completion(poll_request_t *request, int res,
+                                        unsigned int flags) {
+    const bool more = (flags & IORING_CQE_F_MORE) != 0;
+    if (request->cb == nullptr) {
+        // The resource has been adjusted or forgotten since the event was queued.
+        if (!more) {
+            cancelled_requests.erase(request);
+            delete request;
+        }
+        return;
+    }
+
+    if (res < 0) {
+        // The kernel may end a multishot poll early, for example when it runs out
+        // of memory for completions; we just arm it again.
+        guarantee_xerr(res == -ECANCELED || res == -ENOMEM, -res,
+                       "io_uring poll request failed");
+        rassert(!more);
+        arm(request);
+        return;
+    }
+
+    const int events_gotten = uring_poll_to_user(res);
+    if (events_gotten & poll_event_in) rassert(request->mode & poll_event_in);
+    if (events_gotten & poll_event_out) rassert(request->mode & poll_event_out);
+    // `on_event()` may adjust or forget the resource, so decide first whether we have
+    // to re-arm the multishot poll.
+    if (!more) {
+        arm(request);
+    }
+    request->cb->on_event(events_gotten);
+}
+
+io_uring_sqe *uring_event_queue_t::get_sqe() {
+    io_uring_sqe *sqe = ring->get_sqe();
+    if (sqe == nullptr) {
+        // The submission queue is full, so submit what we have right away.
+        UNUSED bool submitted = ring->submit(false);
+        sqe = ring->get_sqe();
+    }
+    guarantee(sqe != nullptr, "The io_uring submission queue is full");
+    return sqe;
+}
+
+void uring_event_queue_t::arm(poll_request_t *request) {
+    io_uring_sqe *sqe = get_sqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = request->fd;
+    // Without `IORING_POLL_ADD_LEVEL` the poll is edge-triggered, like `EPOLLET`.
+    sqe->poll32_events = user_to_uring_poll(request->mode);
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->user_data = reinterpret_cast<uintptr_t>(request);
+}
+
+void uring_event_queue_t::cancel(poll_request_t *request) {
+    request->cb = nullptr;
+    cancelled_requests.insert(request);
+
+    io_uring_sqe *sqe = get_sqe();
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = reinterpret_cast<uintptr_t>(request);
+    sqe->user_data = 0;
+}
+
+void uring_event_queue_t::watch_resource(fd_t resource, int watch_mode,
+                                         linux_event_callback_t *cb) {
+    rassert(cb);
+    poll_request_t *request = new poll_request_t;
+    request->fd = resource;
+    request->mode = watch_mode;
+    request->cb = cb;
+
+    auto res = live_requests.insert(std::make_pair(resource, request));
+    guarantee(res.second, "Watching a resource that is already being watched");
+    arm(request);
+}
+
+void uring_event_queue_t::adjust_resource(fd_t resource, int watch_mode,
+                                          linux_event_callback_t *cb) {
+    rassert(cb);
+    auto it = live_requests.find(resource);
+    guarantee(it != live_requests.end(), "Could not adjust resource");
+
+    // We can't change the mask of a request that's on the ring, so we replace it.
+    // Events that are queued for the old request get dropped, but since the new
+    // request reports the resource's current state when it gets armed, we don't
+    // lose any that we're still interested in.
+    cancel(it->second);
+    live_requests.erase(it);
+    watch_resource(resource, watch_mode, cb);
+}
+
+void uring_event_queue_t::forget_resource(fd_t resource, DEBUG_VAR linux_event_callback_t *cb) {
+    rassert(cb);
+    auto it = live_requests.find(resource);
+    guarantee(it != live_requests.end(), "Couldn't remove resource from watching");
+    rassert(it->second->cb == cb);
+
+    cancel(it->second);
+    live_requests.erase(it);
+}
+
+void uring_event_queue_t::watch_event(system_event_t *ev, linux_event_callback_t *cb) {
+    watch_resource(ev->get_notify_fd(), poll_event_in, cb);
+}
+
+void uring_event_queue_t::forget_event(system_event_t *ev, linux_event_callback_t *cb) {
+    forget_resource(ev->get_notify_fd(), cb);
+}
+
+#endif  // defined(__linux) && defined(IO_URING_EVENT_QUEUE)
@@ -0,0 +1,65 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef ARCH_RUNTIME_EVENT_QUEUE_URING_HPP_
+#define ARCH_RUNTIME_EVENT_QUEUE_URING_HPP_
+
+#include <map>
+#include <set>
+
+#include "arch/runtime/event_queue_types.hpp"
+#include "arch/runtime/io_uring.hpp"
+#include "arch/runtime/runtime_utils.hpp"
+#include "arch/runtime/system_event.hpp"
+#include "containers/scoped.hpp"
+
+/* An event queue built on io_uring instead of epoll.  Every watched resource has a
+multishot, edge-triggered poll request on the ring, which gives us the same semantics
+as our `EPOLLET` epoll queue.  The difference is in the syscalls: all the watch,
+adjust and forget requests made while handling one batch of events are submitted
+together with the wait for the next batch, in a single `io_uring_enter()` call.  With
+many connections that get re-armed on every read and write, this replaces an
+`epoll_ctl()` per change plus an `epoll_wait()` with one syscall per loop iteration.
+
+Requires a kernel with multishot poll support (Linux 5.13 or later). */
+struct uring_event_queue_t {
+public:
+    explicit uring_event_queue_t(linux_queue_parent_t *parent);
+    void run();
+    ~uring_event_queue_t();
+
+    // These should only be called by the event queue itself or by the
+    // linux_* classes
+    void watch_resource(fd_t resource, int events, linux_event_callback_t *cb);
+    void adjust_resource(fd_t resource, int events, linux_event_callback_t *cb);
+    void forget_resource(fd_t resource, linux_event_callback_t *cb);
+
+    void watch_event(system_event_t *, linux_event_callback_t *cb);
+    void forget_event(system_event_t *, linux_event_callback_t *cb);
+
+private:
+    /* A poll request on the ring.  It is owned by the queue, and stays allocated
+    until the kernel posts its last completion, even when the resource has been
+    forgotten (in which case `cb` is `nullptr`). */
+    struct poll_request_t {
+        fd_t fd;
+        int mode;
+        linux_event_callback_t *cb;
+    };
+
+    io_uring_sqe *get_sqe();
+    void arm(poll_request_t *request);
+    void cancel(poll_request_t *request);
+    void on_completion(poll_request_t *request, int res, unsigned int flags);
+
+    linux_queue_parent_t *parent;
+
+    scoped_ptr_t<io_uring_ring_t> ring;
+
+    // The poll requests of currently watched resources.
+    std::map<fd_t, poll_request_t *> live_requests;
+    // Requests that have been cancelled but whose last completion hasn't arrived yet.
+    std::set<poll_request_t *> cancelled_requests;
+
+    DISABLE_COPYING(uring_event_queue_t);
+};
+
+#endif // ARCH_RUNTIME_EVENT_QUEUE_URING_HPP_
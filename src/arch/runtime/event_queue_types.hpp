@@ -3,6 +3,7 @@
 #define ARCH_RUNTIME_EVENT_QUEUE_TYPES_HPP_
 
 #include <signal.h>
+#include <stdint.h>
 
 // Types that are used, in particular, by poll.hpp and epoll.hpp.
 
@@ -15,6 +16,9 @@ struct linux_event_callback_t {
 struct linux_queue_parent_t {
     virtual void pump() = 0;
     virtual bool should_shut_down() = 0;
+    /* How long the event queue should keep polling for new events before it goes to
+    sleep. Zero means that it goes to sleep right away. */
+    virtual int64_t get_spin_nanos() = 0;
     virtual ~linux_queue_parent_t() {}
 };
 
@@ -0,0 +1,140 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "arch/runtime/io_uring.hpp"
+
+#if IO_URING_SUPPORTED
+
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "utils.hpp"
+
+namespace {
+
+int sys_io_uring_setup(unsigned int entries, io_uring_params *params) {
+    return syscall(__NR_io_uring_setup, entries, params);
+}
+
+int sys_io_uring_enter(int ring_fd, unsigned int to_submit,
+                       unsigned int min_complete, unsigned int flags) {
+    return syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags,
+                   nullptr, 0);
+}
+
+int sys_io_uring_register(int ring_fd, unsigned int opcode, void *arg,
+                          unsigned int nr_args) {
+    return syscall(__NR_io_uring_register, ring_fd, opcode, arg, nr_args);
+}
+
+}  // namespace
+
+io_uring_ring_t::io_uring_ring_t(unsigned int entries) : n_unsubmitted(0) {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd = sys_io_uring_setup(entries, &params);
+    guarantee_err(ring_fd >= 0, "Could not set up an io_uring");
+
+    sq_map_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+        sq_map_size = cq_map_size = std::max(sq_map_size, cq_map_size);
+    }
+
+    sq_map = mmap(nullptr, sq_map_size, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    guarantee_err(sq_map != MAP_FAILED, "Could not map the io_uring submission queue");
+    if (single_mmap) {
+        cq_map = sq_map;
+    } else {
+        cq_map = mmap(nullptr, cq_map_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+        guarantee_err(cq_map != MAP_FAILED, "Could not map the io_uring completion queue");
+    }
+    sqes_map_size = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqes_map = mmap(nullptr, sqes_map_size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+    guarantee_err(sqes_map != MAP_FAILED, "Could not map the io_uring SQE array");
+    sqes = static_cast<io_uring_sqe *>(sqes_map);
+
+    char *sq_base = static_cast<char *>(sq_map);
+    sq_head = reinterpret_cast<unsigned int *>(sq_base + params.sq_off.head);
+    sq_tail = reinterpret_cast<unsigned int *>(sq_base + params.sq_off.tail);
+    sq_mask = *reinterpret_cast<unsigned int *>(sq_base + params.sq_off.ring_mask);
+    sq_entries = *reinterpret_cast<unsigned int *>(sq_base + params.sq_off.ring_entries);
+    sq_array = reinterpret_cast<unsigned int *>(sq_base + params.sq_off.array);
+
+    char *cq_base = static_cast<char *>(cq_map);
+    cq_head = reinterpret_cast<unsigned int *>(cq_base + params.cq_off.head);
+    cq_tail = reinterpret_cast<unsigned int *>(cq_base + params.cq_off.tail);
+    cq_mask = *reinterpret_cast<unsigned int *>(cq_base + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe *>(cq_base + params.cq_off.cqes);
+}
+
+io_uring_ring_t::~io_uring_ring_t() {
+    int res = munmap(sqes, sqes_map_size);
+    guarantee_err(res == 0, "Could not unmap the io_uring SQE array");
+    if (!single_mmap) {
+        res = munmap(cq_map, cq_map_size);
+        guarantee_err(res == 0, "Could not unmap the io_uring completion queue");
+    }
+    res = munmap(sq_map, sq_map_size);
+    guarantee_err(res == 0, "Could not unmap the io_uring submission queue");
+    res = close(ring_fd);
+    guarantee_err(res == 0 || get_errno() == EINTR, "Could not close io_uring");
+}
+
+bool io_uring_ring_t::is_supported() {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int fd = sys_io_uring_setup(1, &params);
+    if (fd < 0) {
+        return false;
+    }
+    int res = close(fd);
+    guarantee_err(res == 0 || get_errno() == EINTR, "Could not close io_uring");
+    return true;
+}
+
+void io_uring_ring_t::register_eventfd(int fd) {
+    int res = sys_io_uring_register(ring_fd, IORING_REGISTER_EVENTFD, &fd, 1);
+    guarantee_err(res == 0, "Could not register an eventfd with io_uring");
+}
+
+io_uring_sqe *io_uring_ring_t::get_sqe() {
+    const unsigned int tail = *sq_tail;
+    if (tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= sq_entries) {
+        return nullptr;
+    }
+    const unsigned int index = tail & sq_mask;
+    io_uring_sqe *sqe = &sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sq_array[index] = index;
+    __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ++n_unsubmitted;
+    return sqe;
+}
+
+bool io_uring_ring_t::submit(bool wait_for_completion) {
+    if (n_unsubmitted == 0 && !wait_for_completion) {
+        return true;
+    }
+    int res = sys_io_uring_enter(ring_fd, n_unsubmitted,
+                                 wait_for_completion ? 1 : 0,
+                                 wait_for_completion ? IORING_ENTER_GETEVENTS : 0);
+    if (res >= 0) {
+        rassert(static_cast<unsigned int>(res) <= n_unsubmitted);
+        n_unsubmitted -= res;
+        return true;
+    }
+    // EINTR happens in particular under GDB.  EAGAIN and EBUSY mean the kernel is
+    // short on resources or has too many completions waiting to be reaped.
+    guarantee_err(get_errno() == EINTR || get_errno() == EAGAIN || get_errno() == EBUSY,
+                  "io_uring_enter failed");
+    return false;
+}
+
+#endif  // IO_URING_SUPPORTED
@@ -0,0 +1,91 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef ARCH_RUNTIME_IO_URING_HPP_
+#define ARCH_RUNTIME_IO_URING_HPP_
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define IO_URING_SUPPORTED 1
+#endif
+#endif
+#ifndef IO_URING_SUPPORTED
+#define IO_URING_SUPPORTED 0
+#endif
+
+#include "errors.hpp"
+
+#if IO_URING_SUPPORTED
+
+#include <linux/io_uring.h>
+
+/* `io_uring_ring_t` owns an io_uring and the memory it shares with the kernel.  We
+talk to the kernel with raw syscalls rather than through liburing.
+
+A ring must only be used from a single thread, so the only synchronization needed is
+against the kernel: we load the indices the kernel writes with acquire semantics and
+store the ones it reads with release semantics. */
+class io_uring_ring_t {
+public:
+    // The kernel may round `entries` up to the next power of two.
+    explicit io_uring_ring_t(unsigned int entries);
+    ~io_uring_ring_t();
+
+    /* Returns true if the running kernel lets us set up an io_uring. */
+    static bool is_supported();
+
+    unsigned int sq_capacity() const { return sq_entries; }
+
+    // Makes the kernel ping `fd` (an eventfd) whenever it posts a completion.
+    void register_eventfd(int fd);
+
+    /* Returns a zeroed SQE to fill in, or `nullptr` if the submission queue is full.
+    The SQE is handed to the kernel by the next call to `submit()`. */
+    io_uring_sqe *get_sqe();
+
+    unsigned int num_unsubmitted() const { return n_unsubmitted; }
+
+    /* Hands every SQE returned by `get_sqe()` to the kernel with a single syscall and,
+    if `wait_for_completion` is true, blocks until at least one completion is posted.
+    Returns false if the kernel was interrupted or is temporarily short on resources;
+    unsubmitted SQEs stay on the ring until the next call. */
+    bool submit(bool wait_for_completion);
+
+    /* Calls `fun(const io_uring_cqe &)` on every completion that's been posted so far
+    and then releases them to the kernel. */
+    template <class fun_t>
+    void consume_completions(const fun_t &fun) {
+        unsigned int head = *cq_head;
+        const unsigned int tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head) {
+            fun(cqes[head & cq_mask]);
+        }
+        __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+    }
+
+private:
+    int ring_fd;
+    bool single_mmap;
+    unsigned int n_unsubmitted;
+
+    void *sq_map;
+    size_t sq_map_size;
+    unsigned int *sq_head;
+    unsigned int *sq_tail;
+    unsigned int sq_mask;
+    unsigned int sq_entries;
+    unsigned int *sq_array;
+    io_uring_sqe *sqes;
+    size_t sqes_map_size;
+
+    void *cq_map;
+    size_t cq_map_size;
+    unsigned int *cq_head;
+    unsigned int *cq_tail;
+    unsigned int cq_mask;
+    io_uring_cqe *cqes;
+
+    DISABLE_COPYING(io_uring_ring_t);
+};
+
+#endif  // IO_URING_SUPPORTED
+
+#endif  // ARCH_RUNTIME_IO_URING_HPP_
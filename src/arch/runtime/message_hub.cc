@@ -24,6 +24,7 @@ linux_message_hub_t::linux_message_hub_t(linux_event_queue_t *queue,
     : queue_(queue),
       thread_pool_(thread_pool),
       is_woken_up_(false),
+      incoming_messages_(nullptr),
       current_thread_(current_thread) {
 
 #ifndef NDEBUG
@@ -47,7 +48,7 @@ linux_message_hub_t::~linux_message_hub_t() {
         guarantee(get_priority_msg_list(p).empty());
     }
 
-    guarantee(incoming_messages_.empty());
+    guarantee(incoming_messages_.load() == nullptr);
 }
 
 void linux_message_hub_t::do_store_message(threadnum_t nthread, linux_thread_message_t *msg) {
@@ -94,15 +95,34 @@ void linux_message_hub_t::store_message_sometime(threadnum_t nthread, linux_thre
 
 
 void linux_message_hub_t::insert_external_message(linux_thread_message_t *msg) {
-    bool do_wake_up;
-    {
-        spinlock_acq_t acq(&incoming_messages_lock_);
-        do_wake_up = !check_and_set_is_woken_up();
-        incoming_messages_.push_back(msg);
+    msg_list_t messages;
+    messages.push_back(msg);
+    push_incoming_messages(&messages);
+}
+
+void linux_message_hub_t::push_incoming_messages(msg_list_t *messages) {
+    rassert(!messages->empty());
+
+    // Link the messages up newest first. `oldest` is going to point at whatever was
+    // on the stack before.
+    linux_thread_message_t *newest = nullptr;
+    linux_thread_message_t *oldest = messages->head();
+    while (linux_thread_message_t *m = messages->head()) {
+        messages->remove(m);
+        m->next_incoming_ = newest;
+        newest = m;
     }
 
-    // Wakey wakey eggs and bakey
-    if (do_wake_up) {
+    linux_thread_message_t *top = incoming_messages_.load(std::memory_order_relaxed);
+    do {
+        oldest->next_incoming_ = top;
+    } while (!incoming_messages_.compare_exchange_weak(top, newest));
+
+    // We only need to do a wake up if we're the first people to do a wake up. The
+    // plain load saves us from taking the cache line away from the other threads that
+    // are pushing messages while the wake up is pending.
+    if (!is_woken_up_.load() && !check_and_set_is_woken_up()) {
+        // Wakey wakey eggs and bakey
         event_.wakey_wakey();
     }
 }
@@ -178,12 +198,7 @@ void linux_message_hub_t::on_event(int events) {
             // Place wakey_wakey and then yield to the event processing.
             // It will wake us up again immediately, but can handle a few
             // OS events (such as timers, network messages etc.) in the meantime.
-            bool do_wake_up;
-            {
-                spinlock_acq_t acq(&incoming_messages_lock_);
-                do_wake_up = !check_and_set_is_woken_up();
-            }
-            if (do_wake_up) {
+            if (!check_and_set_is_woken_up()) {
                 event_.wakey_wakey();
             }
             break;
@@ -192,22 +207,24 @@ void linux_message_hub_t::on_event(int events) {
 }
 
 void linux_message_hub_t::sort_incoming_messages_by_priority() {
-    // We do this in two steps to release the spinlock faster.
-    // append_and_clear is a very cheap operation, while
-    // assigning each message to a different priority queue
-    // is more expensive.
-
-    // 1. Pull the messages
-    msg_list_t new_messages;
-    {
-        spinlock_acq_t acq(&incoming_messages_lock_);
-        new_messages.append_and_clear(&incoming_messages_);
-        is_woken_up_ = false;
+    // 1. Pull the messages. We have to reset `is_woken_up_` first: if another thread
+    // pushes a message after we've emptied the stack, it must wake us up again.
+    is_woken_up_.store(false);
+    linux_thread_message_t *newest = incoming_messages_.exchange(nullptr);
+
+    // 2. Put them back in the order in which they were sent
+    linux_thread_message_t *oldest = nullptr;
+    while (newest != nullptr) {
+        linux_thread_message_t *next = newest->next_incoming_;
+        newest->next_incoming_ = oldest;
+        oldest = newest;
+        newest = next;
     }
 
-    // 2. Sort the messages into their respective priority queues
-    while (linux_thread_message_t *m = new_messages.head()) {
-        new_messages.remove(m);
+    // 3. Sort the messages into their respective priority queues
+    while (linux_thread_message_t *m = oldest) {
+        oldest = m->next_incoming_;
+        m->next_incoming_ = nullptr;
         int effective_priority = m->priority;
         if (m->is_ordered) {
             // Ordered messages are treated as if they had
@@ -222,13 +239,11 @@ void linux_message_hub_t::sort_incoming_messages_by_priority() {
 }
 
 bool linux_message_hub_t::check_and_set_is_woken_up() {
-    const bool was_woken_up = is_woken_up_;
-    is_woken_up_ = true;
-    return was_woken_up;
+    return is_woken_up_.exchange(true);
 }
 
-// Pushes messages collected locally global lists available to all
-// threads.
+// Pushes messages collected locally onto the incoming messages of the
+// threads they're going to.
 void linux_message_hub_t::push_messages() {
     for (int i = 0; i < thread_pool_->n_threads; i++) {
         // Append the local list for ith thread to that thread's global
@@ -236,23 +251,8 @@ void linux_message_hub_t::push_messages() {
         thread_queue_t *queue = &queues_[i];
         if (!queue->msg_local_list.empty()) {
             // Transfer messages to the other core
-
-            bool do_wake_up;
-            {
-                spinlock_acq_t acq(&thread_pool_->threads[i]->message_hub.incoming_messages_lock_);
-
-                // We only need to do a wake up if we're the first people to do a
-                // wake up.
-                do_wake_up =
-                    !thread_pool_->threads[i]->message_hub.check_and_set_is_woken_up();
-
-                thread_pool_->threads[i]->message_hub.incoming_messages_.append_and_clear(&queue->msg_local_list);
-            }
-
-            // Wakey wakey, perhaps eggs and bakey
-            if (do_wake_up) {
-                thread_pool_->threads[i]->message_hub.event_.wakey_wakey();
-            }
+            thread_pool_->threads[i]->message_hub.push_incoming_messages(
+                &queue->msg_local_list);
         }
     }
 }
@@ -4,10 +4,11 @@
 
 #include <pthread.h>
 
+#include <atomic>
+
 #include "arch/runtime/event_queue.hpp"
 #include "arch/runtime/runtime_utils.hpp"
 #include "arch/runtime/system_event.hpp"
-#include "arch/spinlock.hpp"
 #include "config/args.hpp"
 #include "containers/intrusive_list.hpp"
 #include "threading.hpp"
@@ -32,8 +33,8 @@ public:
     linux_message_hub_t(linux_event_queue_t *queue, linux_thread_pool_t *thread_pool,
                         threadnum_t current_thread);
 
-    /* For each thread, transfer messages from our msg_local_list for that thread to our
-    msg_global_list for that thread */
+    /* For each thread, transfer messages from our msg_local_list for that thread to
+    that thread's incoming messages */
     void push_messages();
 
     /* Schedules the given message to be sent to the given thread by pushing it onto our
@@ -61,6 +62,10 @@ private:
 
     msg_list_t &get_priority_msg_list(int priority);
 
+    // Moves all of `messages` onto incoming_messages_, keeping them in order, and wakes
+    // up our thread unless somebody already did. This may be called from any thread.
+    void push_incoming_messages(msg_list_t *messages);
+
     linux_event_queue_t *const queue_;
     linux_thread_pool_t *const thread_pool_;
 
@@ -68,16 +73,21 @@ private:
     struct thread_queue_t {
         //TODO this doesn't need to be a class anymore
 
-        /* Messages are cached here before being pushed to the global list so that we don't
-        have to acquire the spinlock as often */
+        /* Messages are cached here before being pushed to the other thread, so that we
+        only touch its incoming messages and wake it up once per batch */
         msg_list_t msg_local_list;
     } queues_[MAX_THREADS];
 
-    // Must only be used with acquired incoming_messages_lock_
     bool check_and_set_is_woken_up();
-    bool is_woken_up_;
-    msg_list_t incoming_messages_;
-    spinlock_t incoming_messages_lock_;
+    std::atomic<bool> is_woken_up_;
+
+    /* Messages from other threads for this thread. This is a lock-free stack of
+    messages linked through their `next_incoming_` fields. Any thread can push onto it,
+    but only our thread takes messages off, and it always takes all of them at once. So
+    a compare-and-swap on the top of the stack is all the synchronization we need.
+    Each batch is pushed newest message first, so after reversing the whole stack the
+    messages from any one thread come out in the order in which they were stored. */
+    std::atomic<linux_thread_message_t *> incoming_messages_;
 
     // Use `sort_incoming_messages_by_priority()` to sort incoming_messages_ into
     // these lists.
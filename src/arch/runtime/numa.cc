@@ -0,0 +1,147 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/runtime/numa.hpp"
+
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sys/syscall.h>
+#endif
+
+#include <string>
+
+#include "arch/runtime/runtime_utils.hpp"
+#include "utils.hpp"
+
+namespace {
+
+#ifdef __linux__
+/* Parses a CPU list such as "0-7,16-23" as it appears in sysfs. */
+bool parse_cpu_list(const std::string &list, std::vector<int> *cpus_out) {
+    size_t pos = 0;
+    while (pos < list.size() && list[pos] != '\n') {
+        char *end;
+        long first = strtol(list.c_str() + pos, &end, 10);
+        if (end == list.c_str() + pos || first < 0) {
+            return false;
+        }
+        long last = first;
+        pos = end - list.c_str();
+        if (pos < list.size() && list[pos] == '-') {
+            ++pos;
+            last = strtol(list.c_str() + pos, &end, 10);
+            if (end == list.c_str() + pos || last < first) {
+                return false;
+            }
+            pos = end - list.c_str();
+        }
+        for (long cpu = first; cpu <= last; ++cpu) {
+            cpus_out->push_back(static_cast<int>(cpu));
+        }
+        if (pos < list.size() && list[pos] == ',') {
+            ++pos;
+        }
+    }
+    return true;
+}
+
+bool read_file(const std::string &path, std::string *contents_out) {
+    FILE *file = fopen(path.c_str(), "r");
+    if (file == nullptr) {
+        return false;
+    }
+    char buffer[4096];
+    size_t size = fread(buffer, 1, sizeof(buffer), file);
+    fclose(file);
+    contents_out->assign(buffer, size);
+    return true;
+}
+#endif
+
+}  // namespace
+
+const numa_topology_t &numa_topology_t::get() {
+    static numa_topology_t topology;
+    return topology;
+}
+
+numa_topology_t::numa_topology_t() {
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    bool have_allowed = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+    /* Node numbers can have gaps, so we keep going until we've seen a few missing
+    nodes in a row. */
+    for (int node = 0, missing = 0; missing < 8; ++node) {
+        std::string list;
+        if (!read_file(strprintf("/sys/devices/system/node/node%d/cpulist", node),
+                       &list)) {
+            ++missing;
+            continue;
+        }
+        missing = 0;
+        std::vector<int> cpus, usable;
+        if (!parse_cpu_list(list, &cpus)) {
+            node_cpus.clear();
+            break;
+        }
+        for (int cpu : cpus) {
+            if (!have_allowed || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))) {
+                usable.push_back(cpu);
+            }
+        }
+        if (!usable.empty()) {
+            node_cpus.push_back(std::move(usable));
+        }
+    }
+#endif
+    if (node_cpus.empty()) {
+        node_cpus.push_back(std::vector<int>());
+        for (int cpu = 0; cpu < get_cpu_count(); ++cpu) {
+            node_cpus[0].push_back(cpu);
+        }
+    }
+}
+
+int numa_topology_t::cpu_for_thread(int i, int n, int *node_out) const {
+    guarantee(i >= 0 && i < n);
+    int num_cpus = 0;
+    for (const auto &cpus : node_cpus) {
+        num_cpus += cpus.size();
+    }
+    /* If there are more threads than CPUs, we have to double up. Otherwise we leave
+    gaps between the threads' CPUs so that every node gets its share. */
+    int index = n <= num_cpus
+        ? static_cast<int>(static_cast<int64_t>(i) * num_cpus / n)
+        : i % num_cpus;
+    for (size_t node = 0; node < node_cpus.size(); ++node) {
+        if (index < static_cast<int>(node_cpus[node].size())) {
+            *node_out = node;
+            return node_cpus[node][index];
+        }
+        index -= node_cpus[node].size();
+    }
+    unreachable();
+}
+
+void prefer_numa_node_for_memory(void *addr, size_t size, int node) {
+#ifdef __linux__
+    unsigned long nodemask = 0;
+    if (node < 0 || node >= static_cast<int>(sizeof(nodemask) * 8)) {
+        return;
+    }
+    nodemask = 1UL << node;
+    /* The kernel ignores the last bit of `maxnode`, hence the `+ 1`. Errors are
+    ignored; if the kernel was built without NUMA support, the default policy is fine
+    anyway. */
+    UNUSED long res = syscall(SYS_mbind, addr, size, MPOL_PREFERRED, &nodemask,
+                              sizeof(nodemask) * 8 + 1, 0);
+#else
+    (void) addr;
+    (void) size;
+    (void) node;
+#endif
+}
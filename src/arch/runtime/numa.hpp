@@ -0,0 +1,41 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef ARCH_RUNTIME_NUMA_HPP_
+#define ARCH_RUNTIME_NUMA_HPP_
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "errors.hpp"
+
+/* `numa_topology_t` describes which CPUs belong to which NUMA node. It's read from
+`/sys/devices/system/node` once, the first time it's needed. Only the CPUs that the
+process is allowed to run on are included. If we can't tell, for example because we
+aren't running on Linux, all CPUs are treated as a single node 0. */
+class numa_topology_t {
+public:
+    static const numa_topology_t &get();
+
+    int num_nodes() const { return static_cast<int>(node_cpus.size()); }
+
+    /* Picks the CPU that the `i`th of `n` threads should be pinned to. The threads
+    are spread evenly over the CPUs, and consecutive threads are kept on the same node
+    where possible. Returns the node of that CPU in `*node_out`. */
+    int cpu_for_thread(int i, int n, int *node_out) const;
+
+private:
+    numa_topology_t();
+
+    /* The CPUs of each node, in ascending order. No node is empty. */
+    std::vector<std::vector<int> > node_cpus;
+
+    DISABLE_COPYING(numa_topology_t);
+};
+
+/* Asks the kernel to allocate the pages in `[addr, addr + size)` from the given node
+when they are first touched, no matter which thread touches them. `addr` and `size` must
+be page-aligned. Pages that are already allocated don't move. This is only a hint; if
+the kernel doesn't support it, nothing happens. */
+void prefer_numa_node_for_memory(void *addr, size_t size, int node);
+
+#endif  // ARCH_RUNTIME_NUMA_HPP_
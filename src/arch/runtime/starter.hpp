@@ -4,12 +4,22 @@
 
 // Implementation in runtime.cc.
 
+#include <stdint.h>
+
 #include <functional>
 
 /* `run_in_thread_pool()` starts a RethinkDB thread pool, runs the given
 function in a coroutine inside of it, waits for the function to return, and then
-shuts down the thread pool. */
+shuts down the thread pool. If `pin_threads` is true, each worker thread is pinned to
+its own core, and the cores are picked so that neighbouring threads share a NUMA node.
+
+If `event_loop_spin_usecs` is non-zero, a worker thread that runs out of work keeps
+polling for new events for that long before it goes to sleep. Messages from other
+threads and network events that arrive in the meantime are handled without waiting for
+the kernel to wake the thread up, at the cost of burning CPU while the server is idle.
+Only the epoll event queue supports this. */
 
-void run_in_thread_pool(const std::function<void()> &fun, int worker_threads);
+void run_in_thread_pool(const std::function<void()> &fun, int worker_threads,
+                        bool pin_threads = false, int64_t event_loop_spin_usecs = 0);
 
 #endif  // ARCH_RUNTIME_STARTER_HPP_
@@ -15,6 +15,7 @@
 #include "arch/os_signal.hpp"
 #include "arch/io/timer_provider.hpp"
 #include "arch/runtime/event_queue.hpp"
+#include "arch/runtime/numa.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "arch/timing.hpp"
 #include "errors.hpp"
@@ -62,17 +63,25 @@ void linux_thread_pool_t::set_thread(linux_thread_t *val) {
     thread = val;
 }
 
-linux_thread_pool_t::linux_thread_pool_t(int worker_threads, bool _do_set_affinity) :
+linux_thread_pool_t::linux_thread_pool_t(int worker_threads, bool _do_set_affinity,
+                                         int64_t _event_loop_spin_usecs) :
 #ifndef NDEBUG
       coroutine_summary(false),
 #endif
       interrupt_message(nullptr),
       generic_blocker_pool(nullptr),
+      cpu_blocker_pool(nullptr),
       n_threads(worker_threads + 1),    // we create an extra utility thread
-      do_set_affinity(_do_set_affinity)
+      do_set_affinity(_do_set_affinity),
+      event_loop_spin_usecs(_event_loop_spin_usecs)
 {
     rassert(n_threads > 1);             // we want at least one non-utility thread
     rassert(n_threads <= MAX_THREADS);
+    rassert(event_loop_spin_usecs >= 0);
+
+    for (int i = 0; i < MAX_THREADS; ++i) {
+        numa_nodes[i] = -1;
+    }
 
     int res;
 
@@ -105,8 +114,10 @@ struct thread_data_t {
 
 void *linux_thread_pool_t::start_thread(void *arg) {
 #ifndef _WIN32
-    // Block all signals but `SIGSEGV` and `SIGBUS` (will be unblocked by the event
-    // queue in case of poll).
+    // Block all signals but `SIGSEGV`, `SIGBUS` and `SIGPROF` (will be unblocked by
+    // the event queue in case of poll). `SIGPROF` is only raised while
+    // `cpu_profiler_t` is running, and needs to be handled on the thread that was
+    // using the CPU.
     {
         sigset_t sigmask;
         int res = sigfillset(&sigmask);
@@ -116,6 +127,8 @@ void *linux_thread_pool_t::start_thread(void *arg) {
         guarantee_err(res == 0, "Could not remove SIGSEGV from sigmask");
         res = sigdelset(&sigmask, SIGBUS);
         guarantee_err(res == 0, "Could not remove SIGBUS from sigmask");
+        res = sigdelset(&sigmask, SIGPROF);
+        guarantee_err(res == 0, "Could not remove SIGPROF from sigmask");
 
         res = pthread_sigmask(SIG_SETMASK, &sigmask, nullptr);
         guarantee_xerr(res == 0, res, "Could not block signal");
@@ -135,6 +148,7 @@ void *linux_thread_pool_t::start_thread(void *arg) {
         tdata->thread_pool->threads[tdata->current_thread] = &local_thread;
         set_thread(&local_thread);
         blocker_pool_t *generic_blocker_pool = nullptr; // Will only be instantiated by one thread
+        blocker_pool_t *cpu_blocker_pool = nullptr;
 
         /* Install a handler for segmentation faults that just prints a backtrace. If we're
         running under valgrind, we don't install this handler because Valgrind will print the
@@ -168,6 +182,9 @@ void *linux_thread_pool_t::start_thread(void *arg) {
             generic_blocker_pool = new blocker_pool_t(GENERIC_BLOCKER_THREAD_COUNT,
                                                       &local_thread.queue);
             tdata->thread_pool->generic_blocker_pool = generic_blocker_pool;
+            cpu_blocker_pool = new blocker_pool_t(CPU_BLOCKER_THREAD_COUNT,
+                                                  &local_thread.queue);
+            tdata->thread_pool->cpu_blocker_pool = cpu_blocker_pool;
         }
 
         // If one thread is allowed to run before another one has finished
@@ -189,11 +206,15 @@ void *linux_thread_pool_t::start_thread(void *arg) {
         // needed to access.
         tdata->barrier->wait();
 
-        // If this thread created the generic blocker pool, clean it up
+        // If this thread created the blocker pools, clean them up
         if (generic_blocker_pool != nullptr) {
             delete generic_blocker_pool;
             tdata->thread_pool->generic_blocker_pool = nullptr;
         }
+        if (cpu_blocker_pool != nullptr) {
+            delete cpu_blocker_pool;
+            tdata->thread_pool->cpu_blocker_pool = nullptr;
+        }
 
         tdata->thread_pool->threads[tdata->current_thread] = nullptr;
         set_thread(nullptr);
@@ -224,22 +245,32 @@ void linux_thread_pool_t::run_thread_pool(linux_thread_message_t *initial_messag
         // The initial message gets sent to the utility thread.
         tdata->initial_message = is_utility_thread ? initial_message : nullptr;
 
-        int res = pthread_create(&pthreads[i], nullptr, &start_thread, tdata);
-        guarantee_xerr(res == 0, res, "Could not create thread");
+        pthread_attr_t attr;
+        int res = pthread_attr_init(&attr);
+        guarantee_xerr(res == 0, res, "Could not initialize thread attributes");
 
         // Don't set affinity for the utility thread
         if (do_set_affinity && !is_utility_thread) {
             // On Apple, the thread affinity API has awful documentation, so we don't even bother.
 #ifdef _GNU_SOURCE
-            // Distribute threads evenly among CPUs
-            int ncpus = get_cpu_count();
+            /* Distribute threads evenly among CPUs, keeping neighbouring threads on the
+            same NUMA node. We set the affinity before the thread starts so that
+            everything it allocates while starting up is already local to its node. */
+            int cpu = numa_topology_t::get().cpu_for_thread(
+                i, n_threads - 1, &numa_nodes[i]);
             cpu_set_t mask;
             CPU_ZERO(&mask);
-            CPU_SET(i % ncpus, &mask);
-            res = pthread_setaffinity_np(pthreads[i], sizeof(cpu_set_t), &mask);
+            CPU_SET(cpu, &mask);
+            res = pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), &mask);
             guarantee_xerr(res == 0, res, "Could not set thread affinity");
 #endif
         }
+
+        res = pthread_create(&pthreads[i], &attr, &start_thread, tdata);
+        guarantee_xerr(res == 0, res, "Could not create thread");
+
+        res = pthread_attr_destroy(&attr);
+        guarantee_xerr(res == 0, res, "Could not destroy thread attributes");
     }
 
     // Mark the main thread (for use in assertions etc.)
@@ -458,6 +489,9 @@ linux_thread_t::linux_thread_t(linux_thread_pool_t *parent_pool, int thread_id)
     : queue(this),
       message_hub(&queue, parent_pool, threadnum_t(thread_id)),
       timer_handler(&queue),
+      // The utility thread doesn't do anything that is latency-sensitive
+      spin_nanos(thread_id == parent_pool->n_threads - 1
+                 ? 0 : parent_pool->event_loop_spin_usecs * THOUSAND),
       do_shutdown(false)
 #ifndef NDEBUG
       , coroutine_counts_at_shutdown(NULL)
@@ -488,6 +522,10 @@ void linux_thread_t::pump() {
     message_hub.push_messages();
 }
 
+int64_t linux_thread_t::get_spin_nanos() {
+    return spin_nanos;
+}
+
 void linux_thread_t::on_event(int events) {
     // No-op. This is just to make sure that the event queue wakes up
     // so it can shut down.
@@ -16,6 +16,7 @@
 #include "arch/runtime/coroutines.hpp"
 #include "arch/io/blocker_pool.hpp"
 #include "arch/io/timer_provider.hpp"
+#include "arch/spinlock.hpp"
 #include "arch/timer.hpp"
 
 class linux_thread_t;
@@ -41,7 +42,8 @@ and shutting down the threads and event queues. */
 
 class linux_thread_pool_t {
 public:
-    linux_thread_pool_t(int worker_threads, bool do_set_affinity);
+    linux_thread_pool_t(int worker_threads, bool do_set_affinity,
+                        int64_t event_loop_spin_usecs);
 
     // When the process receives a SIGINT or SIGTERM, interrupt_message will be delivered to the
     // same thread that initial_message was delivered to, and interrupt_message will be set to
@@ -92,6 +94,14 @@ private:
     static const int GENERIC_BLOCKER_THREAD_COUNT = 2;
     blocker_pool_t* generic_blocker_pool;
 
+    // The number of threads to allocate for CPU-heavy calls. They get a pool of their
+    // own so that a burst of them doesn't hold up the blocking calls.
+    static const int CPU_BLOCKER_THREAD_COUNT = 4;
+    blocker_pool_t* cpu_blocker_pool;
+
+    template <class Callable>
+    static void run_in_pool(blocker_pool_t *linux_thread_pool_t::*pool, const Callable &);
+
 public:
     pthread_t pthreads[MAX_THREADS];
     linux_thread_t *threads[MAX_THREADS];
@@ -100,9 +110,22 @@ public:
     template <class Callable>
     static void run_in_blocker_pool(const Callable &);
 
+    // Cooperatively run a CPU-heavy function call (for example deriving a password
+    // hash) using the cpu_blocker_pool, so that it doesn't stall the event loop
+    template <class Callable>
+    static void run_in_cpu_blocker_pool(const Callable &);
+
     int n_threads;
     bool do_set_affinity;
 
+    /* How long the worker threads' event loops busy-poll before they go to sleep. See
+    `run_in_thread_pool()`. */
+    int64_t event_loop_spin_usecs;
+
+    /* The NUMA node each thread is pinned to, or -1 if it isn't pinned. Set before the
+    threads start. */
+    int numa_nodes[MAX_THREADS];
+
 #ifdef _WIN32
     static linux_thread_pool_t *get_global_thread_pool();
 #endif
@@ -154,15 +177,28 @@ struct generic_job_t :
 // This should be used for any calls that cannot otherwise be made non-blocking
 template <class Callable>
 void linux_thread_pool_t::run_in_blocker_pool(const Callable &fn)
+{
+    run_in_pool(&linux_thread_pool_t::generic_blocker_pool, fn);
+}
+
+template <class Callable>
+void linux_thread_pool_t::run_in_cpu_blocker_pool(const Callable &fn)
+{
+    run_in_pool(&linux_thread_pool_t::cpu_blocker_pool, fn);
+}
+
+template <class Callable>
+void linux_thread_pool_t::run_in_pool(blocker_pool_t *linux_thread_pool_t::*pool,
+                                      const Callable &fn)
 {
     if (get_thread_pool() != nullptr) {
         generic_job_t<Callable> job;
         job.fn = &fn;
         job.suspended = coro_t::self();
 
-        rassert(get_thread_pool()->generic_blocker_pool != NULL,
-                "thread_pool_t::run_in_blocker_pool called while generic_thread_pool uninitialized");
-        get_thread_pool()->generic_blocker_pool->do_job(&job);
+        rassert(get_thread_pool()->*pool != NULL,
+                "thread_pool_t::run_in_pool called while the blocker pool is uninitialized");
+        (get_thread_pool()->*pool)->do_job(&job);
 
         // Give up execution, to be resumed when the done callback is made
         coro_t::wait();
@@ -190,6 +226,7 @@ public:
 
     void pump();   // Called by the event queue
     bool should_shut_down();   // Called by the event queue
+    int64_t get_spin_nanos();   // Called by the event queue
 #ifndef NDEBUG
     void initiate_shut_down(std::map<std::string, size_t> *coroutine_counts); // Can be called from any thread
 #else
@@ -198,6 +235,8 @@ public:
     void on_event(int events);
 
 private:
+    const int64_t spin_nanos;
+
     volatile bool do_shutdown;
     pthread_mutex_t do_shutdown_mutex;
     system_event_t shutdown_notify_event;
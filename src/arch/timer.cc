@@ -7,11 +7,14 @@
 #include "time.hpp"
 #include "utils.hpp"
 
-class timer_token_t : public intrusive_priority_queue_node_t<timer_token_t> {
+class timer_token_t : public intrusive_priority_queue_node_t<timer_token_t>,
+                      public intrusive_list_node_t<timer_token_t> {
     friend class timer_handler_t;
 
 private:
-    timer_token_t() : interval_nanos(-1), next_time_in_nanos(-1), callback(nullptr) { }
+    timer_token_t()
+        : interval_nanos(-1), next_time_in_nanos(-1), callback(nullptr),
+          wheel_slot(nullptr) { }
 
     friend bool left_is_higher_priority(const timer_token_t *left, const timer_token_t *right);
 
@@ -24,6 +27,9 @@ private:
     // The callback we call upon each 'ring'.
     timer_callback_t *callback;
 
+    // The slot of the wheel that the token is in, or null if it's in the priority queue.
+    intrusive_list_t<timer_token_t> *wheel_slot;
+
     DISABLE_COPYING(timer_token_t);
 };
 
@@ -31,14 +37,22 @@ bool left_is_higher_priority(const timer_token_t *left, const timer_token_t *rig
     return left->next_time_in_nanos < right->next_time_in_nanos;
 }
 
+// With 2^8 ticks in the priority queue, it holds the timers of the next second or so,
+// and the four levels of the wheel reach about 200 days.
+const int64_t timer_handler_t::WHEEL_TICK_NANOS = 4 * MILLION;
+
 timer_handler_t::timer_handler_t(linux_event_queue_t *queue)
     : timer_provider(queue),
-      expected_oneshot_time_in_nanos(0) {
+      oneshot_scheduled(false),
+      expected_oneshot_time_in_nanos(0),
+      wheel_tick(get_ticks().nanos / WHEEL_TICK_NANOS),
+      wheel_size(0) {
     // Right now, we have no tokens.  So we don't ask the timer provider to do anything for us.
 }
 
 timer_handler_t::~timer_handler_t() {
     guarantee(token_queue.empty());
+    guarantee(wheel_size == 0);
 }
 
 void timer_handler_t::on_oneshot() {
@@ -46,7 +60,13 @@ void timer_handler_t::on_oneshot() {
     // bunch of calls to it, returning a tad early over and over again, leading up to a ticks
     // threshold.  So we bump the real time up to the threshold when processing the priority queue.
     int64_t real_ticks = get_ticks().nanos;
-    int64_t ticks = std::max(real_ticks, expected_oneshot_time_in_nanos);
+    int64_t ticks = oneshot_scheduled
+        ? std::max(real_ticks, expected_oneshot_time_in_nanos)
+        : real_ticks;
+    oneshot_scheduled = false;
+
+    // This moves the tokens that are now due within a second into the priority queue.
+    advance_wheel(ticks);
 
     while (!token_queue.empty() && token_queue.peek()->next_time_in_nanos <= ticks) {
         timer_token_t *token = token_queue.pop();
@@ -55,7 +75,7 @@ void timer_handler_t::on_oneshot() {
         // may be canceled).
         if (token->interval_nanos != 0) {
             token->next_time_in_nanos = real_ticks + token->interval_nanos;
-            token_queue.push(token);
+            insert_token(token);
         }
 
         token->callback->on_timer(ticks_t{real_ticks});
@@ -68,7 +88,90 @@ void timer_handler_t::on_oneshot() {
 
     // We've processed young tokens.  Now schedule a new one-shot (if necessary).
     if (!token_queue.empty()) {
-        timer_provider.schedule_oneshot(token_queue.peek()->next_time_in_nanos, this);
+        schedule_oneshot_if_earlier(token_queue.peek()->next_time_in_nanos);
+    }
+    if (wheel_size != 0) {
+        schedule_oneshot_if_earlier(next_cascade_nanos());
+    }
+}
+
+bool timer_handler_t::insert_token(timer_token_t *token) {
+    rassert(token->wheel_slot == nullptr);
+    int64_t tick = token->next_time_in_nanos / WHEEL_TICK_NANOS;
+    int64_t delta = tick - wheel_tick;
+    if (delta >= (int64_t(1) << QUEUE_BITS) && wheel_size == 0) {
+        // The wheel doesn't move while it's empty, so it may be behind.
+        wheel_tick = std::max(wheel_tick, get_ticks().nanos / WHEEL_TICK_NANOS);
+        delta = tick - wheel_tick;
+    }
+    if (delta < (int64_t(1) << QUEUE_BITS)) {
+        token_queue.push(token);
+        return true;
+    }
+
+    int level = 0;
+    while (level + 1 < WHEEL_LEVELS
+           && delta >= (int64_t(1) << (QUEUE_BITS + (level + 1) * WHEEL_LEVEL_BITS))) {
+        ++level;
+    }
+    const int64_t wheel_range =
+        int64_t(1) << (QUEUE_BITS + WHEEL_LEVELS * WHEEL_LEVEL_BITS);
+    if (delta >= wheel_range) {
+        // It's put back into the wheel when its slot comes up.
+        tick = wheel_tick + wheel_range - 1;
+    }
+    int slot = (tick >> (QUEUE_BITS + level * WHEEL_LEVEL_BITS)) & (WHEEL_SLOTS - 1);
+    token->wheel_slot = &wheel[level][slot];
+    token->wheel_slot->push_back(token);
+    ++wheel_size;
+    return false;
+}
+
+void timer_handler_t::advance_wheel(int64_t now_nanos) {
+    int64_t now_tick = now_nanos / WHEEL_TICK_NANOS;
+    while (wheel_size != 0 && wheel_tick < now_tick) {
+        int64_t next_cascade_tick = ((wheel_tick >> QUEUE_BITS) + 1) << QUEUE_BITS;
+        if (next_cascade_tick > now_tick) {
+            break;
+        }
+        wheel_tick = next_cascade_tick;
+        cascade_wheel();
+    }
+    wheel_tick = std::max(wheel_tick, now_tick);
+}
+
+void timer_handler_t::cascade_wheel() {
+    for (int level = 0; level < WHEEL_LEVELS; ++level) {
+        int slot = (wheel_tick >> (QUEUE_BITS + level * WHEEL_LEVEL_BITS))
+            & (WHEEL_SLOTS - 1);
+        intrusive_list_t<timer_token_t> tokens;
+        tokens.append_and_clear(&wheel[level][slot]);
+        // `wheel_size` still counts them, so that `insert_token()` doesn't move the
+        // wheel while we're putting them back.
+        size_t moved = tokens.size();
+        while (!tokens.empty()) {
+            timer_token_t *token = tokens.head();
+            tokens.pop_front();
+            token->wheel_slot = nullptr;
+            insert_token(token);
+        }
+        wheel_size -= moved;
+        // The slots of the next level only come up when this level wraps around.
+        if (slot != 0) {
+            break;
+        }
+    }
+}
+
+int64_t timer_handler_t::next_cascade_nanos() const {
+    return (((wheel_tick >> QUEUE_BITS) + 1) << QUEUE_BITS) * WHEEL_TICK_NANOS;
+}
+
+void timer_handler_t::schedule_oneshot_if_earlier(int64_t time_in_nanos) {
+    if (!oneshot_scheduled || time_in_nanos < expected_oneshot_time_in_nanos) {
+        timer_provider.schedule_oneshot(time_in_nanos, this);
+        oneshot_scheduled = true;
+        expected_oneshot_time_in_nanos = time_in_nanos;
     }
 }
 
@@ -83,22 +186,27 @@ timer_token_t *timer_handler_t::add_timer_internal(
     token->next_time_in_nanos = next_time.nanos;
     token->callback = callback;
 
-    const timer_token_t *top_entry = token_queue.peek();
-    token_queue.push(token);
-
-    if (top_entry == nullptr || next_time.nanos < top_entry->next_time_in_nanos) {
-        timer_provider.schedule_oneshot(next_time.nanos, this);
+    if (insert_token(token)) {
+        schedule_oneshot_if_earlier(next_time.nanos);
+    } else {
+        schedule_oneshot_if_earlier(next_cascade_nanos());
     }
 
     return token;
 }
 
 void timer_handler_t::cancel_timer(timer_token_t *token) {
-    token_queue.remove(token);
+    if (token->wheel_slot != nullptr) {
+        token->wheel_slot->remove(token);
+        --wheel_size;
+    } else {
+        token_queue.remove(token);
+    }
     delete token;
 
-    if (token_queue.empty()) {
+    if (token_queue.empty() && wheel_size == 0 && oneshot_scheduled) {
         timer_provider.unschedule_oneshot();
+        oneshot_scheduled = false;
     }
 }
 
@@ -3,6 +3,7 @@
 #define ARCH_TIMER_HPP_
 
 #include "arch/io/timer_provider.hpp"
+#include "containers/intrusive_list.hpp"
 #include "containers/intrusive_priority_queue.hpp"
 #include "time.hpp"
 
@@ -18,7 +19,14 @@ struct timer_callback_t {
 /* This timer class uses the underlying OS timer provider to get one-shot timing
  * events. It then manages a list of application timers based on that lower level
  * interface. Everyone who needs a timer should use this class (through the thread
- * pool). */
+ * pool).
+ *
+ * Timers that are due within about a second are kept in a priority queue, which makes
+ * them ring on time. Timers that are due later, like most timeouts, which tend to be
+ * cancelled long before they would ring, go into a hierarchical timing wheel instead,
+ * where adding and cancelling them takes constant time. Every time the wheel's
+ * position reaches a new second, the timers of the slot that covers that second are
+ * moved down a level, or into the priority queue once they're due within a second. */
 class timer_handler_t : private timer_provider_callback_t {
 public:
     explicit timer_handler_t(linux_event_queue_t *queue);
@@ -32,16 +40,39 @@ public:
 private:
     void on_oneshot();
 
+    // Adds `token` to the priority queue or the wheel, whichever fits its
+    // `next_time_in_nanos`. Returns true if it went into the priority queue.
+    bool insert_token(timer_token_t *token);
+    // Moves the wheel's position up to `now_nanos`, cascading the slots it passes.
+    void advance_wheel(int64_t now_nanos);
+    void cascade_wheel();
+    int64_t next_cascade_nanos() const;
+    void schedule_oneshot_if_earlier(int64_t time_in_nanos);
+
     // The timer provider, a platform-dependent typedef for interfacing with the OS.
     timer_provider_t timer_provider;
 
-    // The expected time of the next on_oneshot call.  If the oneshot arrived earlier
-    // than this time, we pretend that it had arrived on time.
+    // The expected time of the next on_oneshot call, if `oneshot_scheduled`.  If the
+    // oneshot arrived earlier than this time, we pretend that it had arrived on time.
+    bool oneshot_scheduled;
     int64_t expected_oneshot_time_in_nanos;
 
     // A priority queue of timer tokens, ordered by the soonest.
     intrusive_priority_queue_t<timer_token_t> token_queue;
 
+    // The wheel counts time in ticks of `WHEEL_TICK_NANOS`.  Tokens due within
+    // `2^QUEUE_BITS` ticks of `wheel_tick` are in `token_queue`, those due within
+    // `2^(QUEUE_BITS + (n + 1) * WHEEL_LEVEL_BITS)` ticks are in level `n` of the wheel,
+    // in the slot for their tick.
+    static const int64_t WHEEL_TICK_NANOS;
+    static const int QUEUE_BITS = 8;
+    static const int WHEEL_LEVEL_BITS = 6;
+    static const int WHEEL_LEVELS = 4;
+    static const int WHEEL_SLOTS = 1 << WHEEL_LEVEL_BITS;
+    intrusive_list_t<timer_token_t> wheel[WHEEL_LEVELS][WHEEL_SLOTS];
+    int64_t wheel_tick;
+    size_t wheel_size;
+
     DISABLE_COPYING(timer_handler_t);
 };
 
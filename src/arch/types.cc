@@ -1,5 +1,7 @@
 #include "arch/types.hpp"
 
+#include <atomic>
+
 #include "utils.hpp"
 
 tcp_socket_exc_t::tcp_socket_exc_t(int errsv, int port) {
@@ -16,9 +18,47 @@ address_in_use_exc_t::address_in_use_exc_t(const char* hostname, int port) throw
     }
 }
 
-file_account_t::file_account_t(file_t *par, int pri, int outstanding_requests_limit) :
+const char *io_class_name(io_class_t io_class) {
+    switch (io_class) {
+    case io_class_t::DEFAULT: return "default";
+    case io_class_t::CACHE_READS: return "cache_reads";
+    case io_class_t::CACHE_WARM_UP: return "cache_warm_up";
+    case io_class_t::BACKFILL: return "backfill";
+    case io_class_t::INDEX_CONSTRUCTION: return "index_construction";
+    case io_class_t::BLOCK_WRITES: return "block_writes";
+    case io_class_t::INDEX_WRITES: return "index_writes";
+    case io_class_t::DATA_GC: return "data_gc";
+    case io_class_t::LBA_GC: return "lba_gc";
+    case io_class_t::BACKUP: return "backup";
+    case io_class_t::NUM_IO_CLASSES: // fallthrough
+    default: unreachable();
+    }
+}
+
+static std::atomic<int> io_class_priority_percents[
+    static_cast<int>(io_class_t::NUM_IO_CLASSES)] = {
+    {100}, {100}, {100}, {100}, {100}, {100}, {100}, {100}, {100}, {100}};
+static std::atomic<uint64_t> io_class_priorities_generation(0);
+
+void set_io_class_priority_percent(io_class_t io_class, int percent) {
+    guarantee(percent >= MIN_IO_CLASS_PRIORITY_PERCENT);
+    guarantee(percent <= MAX_IO_CLASS_PRIORITY_PERCENT);
+    io_class_priority_percents[static_cast<int>(io_class)].store(percent);
+    ++io_class_priorities_generation;
+}
+
+int get_io_class_priority_percent(io_class_t io_class) {
+    return io_class_priority_percents[static_cast<int>(io_class)].load();
+}
+
+uint64_t get_io_class_priorities_generation() {
+    return io_class_priorities_generation.load();
+}
+
+file_account_t::file_account_t(file_t *par, io_class_t io_class, int pri,
+                               int outstanding_requests_limit) :
     parent(par),
-    account(parent->create_account(pri, outstanding_requests_limit)) { }
+    account(parent->create_account(io_class, pri, outstanding_requests_limit)) { }
 
 file_account_t::~file_account_t() {
     parent->destroy_account(account);
@@ -88,6 +88,9 @@ typedef linux_nonthrowing_tcp_listener_t non_throwing_tcp_listener_t;
 class linux_tcp_listener_t;
 typedef linux_tcp_listener_t tcp_listener_t;
 
+class linux_threaded_tcp_listener_t;
+typedef linux_threaded_tcp_listener_t threaded_tcp_listener_t;
+
 class linux_repeated_nonthrowing_tcp_listener_t;
 typedef linux_repeated_nonthrowing_tcp_listener_t repeated_nonthrowing_tcp_listener_t;
 
@@ -105,6 +108,42 @@ enum class file_direct_io_mode_t {
     buffered_desired
 };
 
+// Which disk manager actually performs file I/O: a blocker pool doing blocking
+// syscalls, or an io_uring driven from the event loop thread.
+enum class io_backend_t {
+    pool,
+    io_uring
+};
+
+/* What an I/O account is used for. The disk manager keeps stats for each class, and
+the priorities of all of a class's accounts can be scaled at runtime (see
+`set_io_class_priority_percent()`). */
+enum class io_class_t {
+    DEFAULT = 0,
+    CACHE_READS,
+    CACHE_WARM_UP,
+    BACKFILL,
+    INDEX_CONSTRUCTION,
+    BLOCK_WRITES,
+    INDEX_WRITES,
+    DATA_GC,
+    LBA_GC,
+    BACKUP,
+    NUM_IO_CLASSES
+};
+
+const char *io_class_name(io_class_t io_class);
+
+/* The priority of every account of the given class is multiplied by `percent / 100`.
+This isn't persisted; every class starts out at 100 percent when the server starts. The
+disk managers pick up changes the next time they get a request. */
+#define MIN_IO_CLASS_PRIORITY_PERCENT 1
+#define MAX_IO_CLASS_PRIORITY_PERCENT 10000
+void set_io_class_priority_percent(io_class_t io_class, int percent);
+int get_io_class_priority_percent(io_class_t io_class);
+/* Incremented by every call to `set_io_class_priority_percent()`. */
+uint64_t get_io_class_priorities_generation();
+
 // A linux file.  It expects reads and writes and buffers to have an
 // alignment of DEVICE_BLOCK_SIZE.
 class file_t {
@@ -117,6 +156,10 @@ public:
     virtual int64_t get_file_size() = 0;
     virtual void set_file_size(int64_t size) = 0;
     virtual void set_file_size_at_least(int64_t size, int64_t extent_size) = 0;
+    // Tells the storage that the contents of the range are no longer needed, so that
+    // e.g. an SSD can reclaim it.  Reads from the range may return zeros afterwards.
+    // This is only a hint and may do nothing.
+    virtual void discard(int64_t offset, int64_t length) = 0;
 
     virtual void read_async(int64_t offset, size_t length, void *buf,
                             file_account_t *account, linux_iocallback_t *cb) = 0;
@@ -127,7 +170,9 @@ public:
     virtual void writev_async(int64_t offset, size_t length, scoped_array_t<iovec> &&bufs,
                               file_account_t *account, linux_iocallback_t *cb) = 0;
 
-    virtual void *create_account(int priority, int outstanding_requests_limit) = 0;
+    virtual void *create_account(io_class_t io_class,
+                                 int priority,
+                                 int outstanding_requests_limit) = 0;
     virtual void destroy_account(void *account) = 0;
 
     virtual bool coop_lock_and_check() = 0;
@@ -138,7 +183,8 @@ private:
 
 class file_account_t {
 public:
-    file_account_t(file_t *f, int p, int outstanding_requests_limit = UNLIMITED_OUTSTANDING_REQUESTS);
+    file_account_t(file_t *f, io_class_t io_class, int p,
+                   int outstanding_requests_limit = UNLIMITED_OUTSTANDING_REQUESTS);
     ~file_account_t();
     void *get_account() { return account; }
 
@@ -293,6 +293,20 @@ const void *backtrace_frame_t::get_addr() const {
     return addr;
 }
 
+std::string backtrace_frame_t::get_function_name() {
+    if (!symbols_initialized) {
+        initialize_symbols();
+    }
+    try {
+        return get_demangled_name();
+    } catch (const demangle_failed_exc_t &) {
+        if (!function.empty()) {
+            return function;
+        }
+        return strprintf("%p", addr);
+    }
+}
+
 lazy_backtrace_formatter_t::lazy_backtrace_formatter_t() :
     backtrace_t(),
     timestamp(time(nullptr)),
@@ -69,6 +69,9 @@ public:
     std::string get_offset() const;
     std::string get_symbols_line() const;
     const void *get_addr() const;
+    // Initializes the symbols if necessary, and returns the demangled name if
+    // possible, the mangled name otherwise, or the address if there's no name.
+    std::string get_function_name();
 private:
     std::string filename, function, offset, symbols_line;
     bool symbols_initialized;
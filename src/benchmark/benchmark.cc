@@ -0,0 +1,130 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "benchmark/benchmark.hpp"
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "config/args.hpp"
+
+namespace benchmark {
+
+// Calibration stops here even if a call is still too fast to time.
+static const int64_t MAX_ITERATIONS = BILLION;
+
+state_t::state_t(int64_t _iterations)
+    : iterations_(_iterations),
+      paused(false),
+      started(get_ticks()),
+      elapsed(0) { }
+
+void state_t::pause_timing() {
+    guarantee(!paused);
+    elapsed += get_ticks().nanos - started.nanos;
+    paused = true;
+}
+
+void state_t::resume_timing() {
+    guarantee(paused);
+    paused = false;
+    started = get_ticks();
+}
+
+int64_t state_t::elapsed_nanos() const {
+    return paused ? elapsed : elapsed + (get_ticks().nanos - started.nanos);
+}
+
+static std::vector<std::pair<std::string, benchmark_fun_t> > *get_registry() {
+    static std::vector<std::pair<std::string, benchmark_fun_t> > registry;
+    return &registry;
+}
+
+registration_t::registration_t(const char *name, benchmark_fun_t fun) {
+    get_registry()->push_back(std::make_pair(std::string(name), fun));
+}
+
+static int64_t run_once(benchmark_fun_t fun, int64_t iterations) {
+    state_t state(iterations);
+    fun(&state);
+    return state.elapsed_nanos();
+}
+
+static void run_benchmark(const std::string &name,
+                          benchmark_fun_t fun,
+                          const options_t &options) {
+    const int64_t min_nanos = static_cast<int64_t>(options.min_time_secs * BILLION);
+
+    // Find an iteration count for which a single call takes at least `min_nanos`.
+    int64_t iterations = 1;
+    for (;;) {
+        const int64_t nanos = run_once(fun, iterations);
+        if (nanos >= min_nanos || iterations >= MAX_ITERATIONS) {
+            break;
+        }
+        // Aim a little past the target, but grow by at most a factor of ten at a time
+        // because the first calls tend to be slower than the rest.
+        int64_t next = iterations * 10;
+        if (nanos > 0) {
+            next = std::min(next, static_cast<int64_t>(
+                1.2 * static_cast<double>(iterations) * min_nanos / nanos));
+        }
+        iterations = std::min(std::max(next, iterations + 1), MAX_ITERATIONS);
+    }
+
+    std::vector<double> nanos_per_iteration;
+    double sum = 0;
+    for (int i = 0; i < options.repetitions; ++i) {
+        const double value =
+            static_cast<double>(run_once(fun, iterations)) / iterations;
+        nanos_per_iteration.push_back(value);
+        sum += value;
+    }
+    std::sort(nanos_per_iteration.begin(), nanos_per_iteration.end());
+
+    printf("{\"name\":\"%s\",\"iterations\":%" PRIi64 ",\"repetitions\":%d,"
+           "\"ns_per_iteration\":{\"min\":%.3f,\"median\":%.3f,\"mean\":%.3f,"
+           "\"max\":%.3f}}\n",
+           name.c_str(),
+           iterations,
+           options.repetitions,
+           nanos_per_iteration.front(),
+           nanos_per_iteration[nanos_per_iteration.size() / 2],
+           sum / nanos_per_iteration.size(),
+           nanos_per_iteration.back());
+    fflush(stdout);
+}
+
+void run_benchmarks(const options_t &options) {
+    guarantee(options.repetitions > 0);
+
+    std::vector<std::pair<std::string, benchmark_fun_t> > benchmarks = *get_registry();
+    std::sort(benchmarks.begin(), benchmarks.end());
+
+    if (!options.list_only) {
+#ifdef NDEBUG
+        const char *build = "release";
+#else
+        const char *build = "debug";
+#endif
+        printf("{\"version\":\"%s\",\"build\":\"%s\",\"min_time_secs\":%.3f,"
+               "\"repetitions\":%d}\n",
+               RETHINKDB_VERSION, build, options.min_time_secs, options.repetitions);
+        fflush(stdout);
+    }
+
+    for (const auto &benchmark : benchmarks) {
+        if (benchmark.first.find(options.filter) == std::string::npos) {
+            continue;
+        }
+        if (options.list_only) {
+            printf("%s\n", benchmark.first.c_str());
+        } else {
+            run_benchmark(benchmark.first, benchmark.second, options);
+        }
+    }
+}
+
+}  // namespace benchmark
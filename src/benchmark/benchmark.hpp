@@ -0,0 +1,79 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef BENCHMARK_BENCHMARK_HPP_
+#define BENCHMARK_BENCHMARK_HPP_
+
+#include <stdint.h>
+
+#include <string>
+
+#include "errors.hpp"
+#include "time.hpp"
+
+namespace benchmark {
+
+/* A benchmark is a function that runs the code it measures `state->iterations()`
+times.  The runner calls it with increasing iteration counts until a single call takes
+long enough to time reliably, and then a few more times to get a stable result.  Every
+call runs in a coroutine on thread 0 of a two-thread pool.
+
+Benchmarks must be deterministic: use a fixed seed for anything random, so that results
+from two builds can be compared.  Setup that shouldn't be measured goes between
+`pause_timing()` and `resume_timing()`. */
+class state_t {
+public:
+    explicit state_t(int64_t _iterations);
+
+    int64_t iterations() const { return iterations_; }
+
+    void pause_timing();
+    void resume_timing();
+
+    // Only counts time while the timer isn't paused.
+    int64_t elapsed_nanos() const;
+
+private:
+    const int64_t iterations_;
+    bool paused;
+    ticks_t started;
+    int64_t elapsed;
+
+    DISABLE_COPYING(state_t);
+};
+
+typedef void (*benchmark_fun_t)(state_t *state);
+
+/* Registers a benchmark at static initialization time.  Use `BENCHMARK()` instead of
+using this directly. */
+class registration_t {
+public:
+    registration_t(const char *name, benchmark_fun_t fun);
+};
+
+/* Keeps the compiler from optimizing away the computation of `value`. */
+template <class T>
+inline void do_not_optimize(const T &value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+struct options_t {
+    options_t() : min_time_secs(0.5), repetitions(5), list_only(false) { }
+    // Only benchmarks whose name contains `filter` are run.
+    std::string filter;
+    double min_time_secs;
+    int repetitions;
+    bool list_only;
+};
+
+/* Runs all registered benchmarks that match `options` and prints one JSON object per
+line to stdout. */
+void run_benchmarks(const options_t &options);
+
+}  // namespace benchmark
+
+#define BENCHMARK(name)                                                             \
+    void benchmark_##name(::benchmark::state_t *state);                             \
+    static ::benchmark::registration_t benchmark_registration_##name(               \
+        #name, &benchmark_##name);                                                  \
+    void benchmark_##name(::benchmark::state_t *state)
+
+#endif  // BENCHMARK_BENCHMARK_HPP_
@@ -0,0 +1,90 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.hpp"
+#include "btree/leaf_node.hpp"
+#include "btree/node.hpp"
+#include "containers/scoped.hpp"
+#include "repli_timestamp.hpp"
+#include "unittest/btree_utils.hpp"
+
+namespace benchmark {
+
+static const int LEAF_BLOCK_SIZE = 4096;
+
+static std::vector<store_key_t> make_keys(size_t count) {
+    std::mt19937 gen(0);
+    std::uniform_int_distribution<int> dist('a', 'z');
+    std::vector<store_key_t> keys;
+    for (size_t i = 0; i < count; ++i) {
+        std::string key;
+        for (int j = 0; j < 16; ++j) {
+            key.push_back(static_cast<char>(dist(gen)));
+        }
+        keys.push_back(store_key_t(key));
+    }
+    return keys;
+}
+
+/* Fills a 4KB leaf node with 16-byte keys in random order, starting over with an empty
+node once it's full. */
+BENCHMARK(LeafInsert) {
+    state->pause_timing();
+    max_block_size_t bs = max_block_size_t::unsafe_make(LEAF_BLOCK_SIZE);
+    short_value_sizer_t sizer(bs);
+    scoped_malloc_t<leaf_node_t> node(bs.value());
+    leaf::init(&sizer, node.get());
+    std::vector<store_key_t> keys = make_keys(1000);
+    short_value_buffer_t value(std::string(20, 'v'));
+    state->resume_timing();
+
+    size_t next_key = 0;
+    for (int64_t i = 0; i < state->iterations(); ++i) {
+        const btree_key_t *key = keys[next_key].btree_key();
+        next_key = (next_key + 1) % keys.size();
+        if (leaf::is_full(&sizer, node.get(), key, value.data())) {
+            state->pause_timing();
+            leaf::init(&sizer, node.get());
+            state->resume_timing();
+        }
+        leaf::insert(&sizer, node.get(), key, value.data(),
+                     repli_timestamp_t{static_cast<uint64_t>(i + 1)},
+                     repli_timestamp_t{static_cast<uint64_t>(i)},
+                     key_modification_proof_t::real_proof());
+    }
+}
+
+/* Looks up keys that are present in a full 4KB leaf node. */
+BENCHMARK(LeafFindKey) {
+    state->pause_timing();
+    max_block_size_t bs = max_block_size_t::unsafe_make(LEAF_BLOCK_SIZE);
+    short_value_sizer_t sizer(bs);
+    scoped_malloc_t<leaf_node_t> node(bs.value());
+    leaf::init(&sizer, node.get());
+    std::vector<store_key_t> keys = make_keys(1000);
+    short_value_buffer_t value(std::string(20, 'v'));
+    std::vector<store_key_t> present;
+    for (const store_key_t &key : keys) {
+        if (leaf::is_full(&sizer, node.get(), key.btree_key(), value.data())) {
+            break;
+        }
+        leaf::insert(&sizer, node.get(), key.btree_key(), value.data(),
+                     repli_timestamp_t{1}, repli_timestamp_t{0},
+                     key_modification_proof_t::real_proof());
+        present.push_back(key);
+    }
+    state->resume_timing();
+
+    int found = 0;
+    for (int64_t i = 0; i < state->iterations(); ++i) {
+        int index;
+        found += leaf::find_key(node.get(),
+                                present[i % present.size()].btree_key(),
+                                &index);
+    }
+    guarantee(found == state->iterations());
+}
+
+}  // namespace benchmark
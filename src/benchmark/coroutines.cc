@@ -0,0 +1,60 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "arch/compiler.hpp"
+#include "arch/runtime/context_switching.hpp"
+#include "arch/runtime/coroutines.hpp"
+#include "benchmark/benchmark.hpp"
+#include "config/args.hpp"
+
+namespace benchmark {
+
+/* Spawns coroutines that return right away.  Since `spawn_now_dangerously()` switches to
+the new coroutine immediately, this measures a coroutine's whole lifetime: getting one
+from the free list, two context switches, and returning it. */
+BENCHMARK(CoroSpawnNow) {
+    int counter = 0;
+    for (int64_t i = 0; i < state->iterations(); ++i) {
+        coro_t::spawn_now_dangerously([&counter]() { ++counter; });
+    }
+    guarantee(counter == state->iterations());
+}
+
+/* Yields the current coroutine, which puts it at the back of the event queue and
+switches back to it through the scheduler. */
+BENCHMARK(CoroYield) {
+    for (int64_t i = 0; i < state->iterations(); ++i) {
+        coro_t::yield();
+    }
+}
+
+/* The bare `context_switch()` between two stacks, without any of the scheduling that
+coroutines do on top of it.  We can't pass arguments to the stack's function, so it
+finds the contexts in thread-local variables like in the unit tests. */
+
+static THREAD_LOCAL coro_context_ref_t *ping_context = nullptr;
+static THREAD_LOCAL coro_context_ref_t *pong_context = nullptr;
+
+static void pong() {
+    for (;;) {
+        context_switch(pong_context, ping_context);
+    }
+}
+
+BENCHMARK(ContextSwitch) {
+    state->pause_timing();
+    coro_context_ref_t caller_context;
+    coro_stack_t stack(&pong, COROUTINE_STACK_SIZE);
+    ping_context = &caller_context;
+    pong_context = &stack.context;
+    state->resume_timing();
+
+    // Each iteration is a round trip, so two switches.
+    for (int64_t i = 0; i < state->iterations(); ++i) {
+        context_switch(ping_context, pong_context);
+    }
+
+    state->pause_timing();
+    ping_context = nullptr;
+    pong_context = nullptr;
+}
+
+}  // namespace benchmark
@@ -0,0 +1,97 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include <string.h>
+
+#include <string>
+
+#include "benchmark/benchmark.hpp"
+#include "containers/archive/buffer_stream.hpp"
+#include "containers/archive/string_stream.hpp"
+#include "containers/shared_buffer.hpp"
+#include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
+
+namespace benchmark {
+
+/* A document of the size and shape that you'd commonly find in a table. */
+static ql::datum_t make_document() {
+    ql::configured_limits_t limits;
+    ql::datum_object_builder_t address;
+    address.overwrite("street", ql::datum_t("1600 Amphitheatre Parkway"));
+    address.overwrite("city", ql::datum_t("Mountain View"));
+    address.overwrite("zip", ql::datum_t("94043"));
+
+    ql::datum_array_builder_t tags(limits);
+    for (int i = 0; i < 5; ++i) {
+        tags.add(ql::datum_t(datum_string_t(std::string("tag") + std::to_string(i))));
+    }
+    ql::datum_array_builder_t scores(limits);
+    for (int i = 0; i < 10; ++i) {
+        scores.add(ql::datum_t(static_cast<double>(i * 17 % 101)));
+    }
+
+    ql::datum_object_builder_t doc;
+    doc.overwrite("id", ql::datum_t("2d8a4b9e-5e49-4b43-a0a4-7c8b9b3e7d1f"));
+    doc.overwrite("name", ql::datum_t("Jane Doe"));
+    doc.overwrite("age", ql::datum_t(42.0));
+    doc.overwrite("active", ql::datum_t::boolean(true));
+    doc.overwrite("address", std::move(address).to_datum());
+    doc.overwrite("tags", std::move(tags).to_datum());
+    doc.overwrite("scores", std::move(scores).to_datum());
+    return std::move(doc).to_datum();
+}
+
+static std::string serialize_document(const ql::datum_t &doc) {
+    write_message_t wm;
+    datum_serialize(&wm, doc, ql::check_datum_serialization_errors_t::NO);
+    string_stream_t stream;
+    int res = send_write_message(&stream, &wm);
+    guarantee(res == 0);
+    return stream.str();
+}
+
+BENCHMARK(DatumSerialize) {
+    state->pause_timing();
+    ql::datum_t doc = make_document();
+    state->resume_timing();
+
+    for (int64_t i = 0; i < state->iterations(); ++i) {
+        write_message_t wm;
+        datum_serialize(&wm, doc, ql::check_datum_serialization_errors_t::NO);
+        do_not_optimize(wm);
+    }
+}
+
+/* Deserializes a document into a fully materialized datum, like we do for datums that
+come from the network. */
+BENCHMARK(DatumDeserialize) {
+    state->pause_timing();
+    const std::string serialized = serialize_document(make_document());
+    state->resume_timing();
+
+    for (int64_t i = 0; i < state->iterations(); ++i) {
+        buffer_read_stream_t stream(serialized.data(), serialized.size());
+        ql::datum_t doc;
+        archive_result_t res = datum_deserialize(&stream, &doc);
+        guarantee_deserialization(res, "benchmark datum");
+        do_not_optimize(doc);
+    }
+}
+
+/* Deserializes a document lazily from a buffer and reads one field of it, like we do for
+rows that come from the btree. */
+BENCHMARK(DatumDeserializeFromBufGetField) {
+    state->pause_timing();
+    const std::string serialized = serialize_document(make_document());
+    counted_t<shared_buf_t> buf = shared_buf_t::create(serialized.size());
+    memcpy(buf->data(), serialized.data(), serialized.size());
+    shared_buf_ref_t<char> ref(counted_t<const shared_buf_t>(buf), 0);
+    state->resume_timing();
+
+    for (int64_t i = 0; i < state->iterations(); ++i) {
+        ql::datum_t doc = ql::datum_deserialize_from_buf(ref, 0);
+        ql::datum_t name = doc.get_field("name");
+        do_not_optimize(name);
+    }
+}
+
+}  // namespace benchmark
@@ -0,0 +1,54 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include <set>
+
+#include "arch/address.hpp"
+#include "benchmark/benchmark.hpp"
+#include "clustering/administration/metadata.hpp"
+#include "concurrency/cond_var.hpp"
+#include "rpc/connectivity/cluster.hpp"
+#include "rpc/mailbox/mailbox.hpp"
+#include "rpc/mailbox/typed.hpp"
+#include "unittest/dummy_metadata_controller.hpp"
+
+namespace benchmark {
+
+/* Sends messages to a mailbox on the same server and thread, and waits until they've
+all been delivered.  Local messages skip the network, so this measures serialization,
+the mailbox lookup, and the coroutine that delivers each message. */
+BENCHMARK(MailboxSendLocal) {
+    state->pause_timing();
+    connectivity_cluster_t cluster;
+    mailbox_manager_t mailbox_manager(&cluster, 'M');
+    dummy_semilattice_controller_t<heartbeat_semilattice_metadata_t>
+        heartbeat_manager;
+    dummy_semilattice_controller_t<auth_semilattice_metadata_t>
+        auth_manager;
+    connectivity_cluster_t::run_t cluster_run(
+        &cluster,
+        server_id_t::generate_server_id(),
+        get_local_ips(std::set<ip_address_t>(),
+                      local_ip_filter_t::MATCH_FILTER_OR_LOOPBACK),
+        peer_address_t(), 0, ANY_PORT, 0,
+        heartbeat_manager.get_view(), auth_manager.get_view(), nullptr,
+        cluster_compression_t::none, 1);
+
+    int64_t received = 0;
+    cond_t all_received;
+    mailbox_t<int> mailbox(&mailbox_manager,
+        [&](signal_t *, int) {
+            ++received;
+            if (received == state->iterations()) {
+                all_received.pulse();
+            }
+        });
+    state->resume_timing();
+
+    for (int64_t i = 0; i < state->iterations(); ++i) {
+        send(&mailbox_manager, mailbox.get_address(), static_cast<int>(i));
+    }
+    all_received.wait_lazily_unordered();
+
+    state->pause_timing();
+}
+
+}  // namespace benchmark
@@ -0,0 +1,66 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+#include "arch/runtime/starter.hpp"
+#include "benchmark/benchmark.hpp"
+#include "utils.hpp"
+
+static void print_usage(const char *program) {
+    printf("Usage: %s [--filter=SUBSTRING] [--min-time=SECONDS] [--repetitions=N] "
+           "[--list]\n\n"
+           "Runs the microbenchmarks whose name contains SUBSTRING and prints one JSON\n"
+           "object per line: first the settings, then one line per benchmark with\n"
+           "the time per iteration in nanoseconds.\n", program);
+}
+
+static bool parse_flag(const char *arg, const char *name, const char **value_out) {
+    const size_t len = strlen(name);
+    if (strncmp(arg, name, len) == 0 && arg[len] == '=') {
+        *value_out = arg + len + 1;
+        return true;
+    }
+    return false;
+}
+
+int main(int argc, char **argv) {
+    startup_shutdown_t startup_shutdown;
+
+    benchmark::options_t options;
+    for (int i = 1; i < argc; ++i) {
+        const char *value;
+        char *end;
+        if (parse_flag(argv[i], "--filter", &value)) {
+            options.filter = value;
+        } else if (parse_flag(argv[i], "--min-time", &value)) {
+            options.min_time_secs = strtod(value, &end);
+            if (*value == '\0' || *end != '\0' || !(options.min_time_secs >= 0)) {
+                fprintf(stderr, "Invalid --min-time: %s\n", value);
+                return EXIT_FAILURE;
+            }
+        } else if (parse_flag(argv[i], "--repetitions", &value)) {
+            const long res = strtol(value, &end, 10);  // NOLINT(runtime/int)
+            if (*value == '\0' || *end != '\0' || res <= 0 || res > 1000) {
+                fprintf(stderr, "Invalid --repetitions: %s\n", value);
+                return EXIT_FAILURE;
+            }
+            options.repetitions = static_cast<int>(res);
+        } else if (strcmp(argv[i], "--list") == 0) {
+            options.list_only = true;
+        } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            print_usage(argv[0]);
+            return EXIT_SUCCESS;
+        } else {
+            fprintf(stderr, "Unrecognized argument: %s\n", argv[i]);
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Some benchmarks send messages between threads, so we need more than one.
+    run_in_thread_pool([&]() { benchmark::run_benchmarks(options); }, 2);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,118 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "arch/io/disk.hpp"
+#include "benchmark/benchmark.hpp"
+#include "buffer_cache/alt.hpp"
+#include "buffer_cache/cache_balancer.hpp"
+#include "paths.hpp"
+#include "perfmon/perfmon.hpp"
+#include "serializer/log/log_serializer.hpp"
+
+namespace benchmark {
+
+static const size_t NUM_BLOCKS = 1000;
+
+/* A cache on top of a serializer in a temporary directory, with `NUM_BLOCKS` blocks
+that all fit in memory, so that acquiring them never waits for the disk. */
+class cache_fixture_t {
+public:
+    cache_fixture_t()
+        : directory(make_temp_directory()),
+          io_backender(file_direct_io_mode_t::buffered_desired),
+          file_opener(serializer_filepath_t(directory, "page_cache"), &io_backender) {
+        log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+        serializer.init(new log_serializer_t(log_serializer_t::dynamic_config_t(),
+                                             &file_opener,
+                                             &get_global_perfmon_collection()));
+        balancer.init(new dummy_cache_balancer_t(GIGABYTE));
+        cache.init(new cache_t(serializer.get(), balancer.get(),
+                               &get_global_perfmon_collection(),
+                               which_cpu_shard_t{0, 1}));
+        cache_conn.init(new cache_conn_t(cache.get()));
+
+        txn_t txn(cache_conn.get(), write_durability_t::SOFT, NUM_BLOCKS);
+        for (size_t i = 0; i < NUM_BLOCKS; ++i) {
+            buf_lock_t lock(buf_parent_t(&txn), alt_create_t::create);
+            buf_write_t write(&lock);
+            memset(write.get_data_write(), static_cast<int>(i % 256),
+                   cache->max_block_size().value());
+            block_ids.push_back(lock.block_id());
+        }
+        txn.commit();
+    }
+
+    ~cache_fixture_t() {
+        cache_conn.reset();
+        cache.reset();
+        balancer.reset();
+        serializer.reset();
+        remove_directory_recursive(directory.path().c_str());
+    }
+
+    cache_conn_t *conn() { return cache_conn.get(); }
+
+    std::vector<block_id_t> block_ids;
+
+private:
+    static base_path_t make_temp_directory() {
+        char tmpl[] = "/tmp/rdb_benchmark.XXXXXX";
+        guarantee_err(mkdtemp(tmpl) != nullptr, "Couldn't create a temporary directory");
+        base_path_t path((std::string(tmpl)));
+        recreate_temporary_directory(path);
+        return path;
+    }
+
+    base_path_t directory;
+    io_backender_t io_backender;
+    filepath_file_opener_t file_opener;
+    scoped_ptr_t<log_serializer_t> serializer;
+    scoped_ptr_t<dummy_cache_balancer_t> balancer;
+    scoped_ptr_t<cache_t> cache;
+    scoped_ptr_t<cache_conn_t> cache_conn;
+
+    DISABLE_COPYING(cache_fixture_t);
+};
+
+/* Acquires cached blocks for read within a transaction and reads their contents. */
+BENCHMARK(CacheAcquireRead) {
+    state->pause_timing();
+    cache_fixture_t fixture;
+    scoped_ptr_t<txn_t> txn(new txn_t(fixture.conn(), read_access_t::read));
+    state->resume_timing();
+
+    for (int64_t i = 0; i < state->iterations(); ++i) {
+        buf_lock_t lock(buf_parent_t(txn.get()),
+                        fixture.block_ids[i % NUM_BLOCKS],
+                        access_t::read);
+        buf_read_t read(&lock);
+        do_not_optimize(*static_cast<const char *>(read.get_data_read()));
+    }
+
+    state->pause_timing();
+    txn.reset();
+}
+
+/* Starts a read transaction, acquires one cached block and reads it. */
+BENCHMARK(CacheReadTxn) {
+    state->pause_timing();
+    cache_fixture_t fixture;
+    state->resume_timing();
+
+    for (int64_t i = 0; i < state->iterations(); ++i) {
+        txn_t txn(fixture.conn(), read_access_t::read);
+        buf_lock_t lock(buf_parent_t(&txn),
+                        fixture.block_ids[i % NUM_BLOCKS],
+                        access_t::read);
+        buf_read_t read(&lock);
+        do_not_optimize(*static_cast<const char *>(read.get_data_read()));
+    }
+
+    state->pause_timing();
+}
+
+}  // namespace benchmark
@@ -81,6 +81,10 @@ continue_bool_t btree_send_backfill_pre(
             }
         }
 
+        bool prefetch_child(repli_timestamp_t timestamp) {
+            return timestamp > reference_timestamp;
+        }
+
         continue_bool_t handle_pre_leaf(
                 const counted_t<counted_buf_lock_and_read_t> &buf,
                 const btree_key_t *left_excl_or_null,
@@ -311,6 +315,12 @@ public:
         { }
 
 private:
+    /* Subtrees that changed since the reference timestamp are never skipped, so we can
+    load them ahead of time. */
+    bool prefetch_child(repli_timestamp_t timestamp) {
+        return timestamp > reference_timestamp;
+    }
+
     /* Skip B-tree subtrees that haven't changed since the reference timestamp and that
     don't overlap with any pre-items' ranges. */
     continue_bool_t filter_range_ts(
@@ -747,3 +757,46 @@ void btree_receive_backfill_item_update_deletion_timestamps(
     guarantee(res == continue_bool_t::CONTINUE);
 }
 
+
+class backfill_empty_range_checker_t : public depth_first_traversal_callback_t {
+public:
+    backfill_empty_range_checker_t(value_sizer_t *s, const key_range_t &r) :
+        sizer(s), range(r) { }
+    continue_bool_t handle_pre_leaf(
+            const counted_t<counted_buf_lock_and_read_t> &buf,
+            UNUSED const btree_key_t *left_excl_or_null,
+            UNUSED const btree_key_t *right_incl,
+            signal_t *,
+            bool *skip_out) {
+        *skip_out = true;
+        const leaf_node_t *lnode = static_cast<const leaf_node_t *>(
+            buf->read->get_data_read());
+        /* The leaf may extend outside of `range`, so we have to look at the keys of
+        the entries rather than just at `lnode->num_pairs`. */
+        return leaf::visit_entries(
+            sizer, lnode, buf->lock.get_recency(),
+            [&](const btree_key_t *key, repli_timestamp_t, const void *)
+                    -> continue_bool_t {
+                return range.contains_key(key)
+                    ? continue_bool_t::ABORT : continue_bool_t::CONTINUE;
+            });
+    }
+    continue_bool_t handle_pair(scoped_key_value_t &&, signal_t *) {
+        unreachable();
+    }
+private:
+    value_sizer_t *sizer;
+    key_range_t range;
+};
+
+bool btree_receive_backfill_range_is_empty(
+        superblock_t *superblock,
+        release_superblock_t release_superblock,
+        value_sizer_t *sizer,
+        const key_range_t &range,
+        signal_t *interruptor) {
+    backfill_empty_range_checker_t checker(sizer, range);
+    return continue_bool_t::CONTINUE == btree_depth_first_traversal(
+        superblock, range, &checker, access_t::read, FORWARD, release_superblock,
+        interruptor);
+}
@@ -247,5 +247,17 @@ void btree_receive_backfill_item_update_deletion_timestamps(
     const backfill_item_t &item,
     signal_t *interruptor);
 
+/* `btree_receive_backfill_range_is_empty()` returns `true` if the B-tree has neither
+values nor deletion entries for any key in `range`. This is the case when a new replica
+receives its first backfill, and then the RDB protocol code can apply multi-key
+`backfill_item_t`s without first erasing whatever used to be in their range. It stops
+at the first entry it finds, so it's cheap whether or not the range is empty. */
+bool btree_receive_backfill_range_is_empty(
+    superblock_t *superblock,
+    release_superblock_t release_superblock,
+    value_sizer_t *sizer,
+    const key_range_t &range,
+    signal_t *interruptor);
+
 #endif  // BTREE_BACKFILL_HPP_
 
@@ -55,6 +55,11 @@ public:
         return continue_bool_t::CONTINUE;
     }
 
+    // Range scans visit every child in turn, so it's worth loading them early.
+    bool prefetch_child(repli_timestamp_t) {
+        return true;
+    }
+
     void handle_pair_coro(scoped_key_value_t *fragile_keyvalue,
                           semaphore_acq_t *fragile_acq,
                           fifo_enforcer_write_token_t token,
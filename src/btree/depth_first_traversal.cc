@@ -1,6 +1,12 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "btree/depth_first_traversal.hpp"
 
+#include <string.h>
+
+#include <algorithm>
+#include <deque>
+#include <utility>
+
 #include "btree/internal_node.hpp"
 #include "btree/operations.hpp"
 #include "concurrency/interruptor.hpp"
@@ -28,6 +34,22 @@ buf_parent_t scoped_key_value_t::expose_buf() {
     return buf_parent_t(&buf_->lock);
 }
 
+shared_buf_ref_t<char> scoped_key_value_t::expose_page_copy() {
+    guarantee(buf_.has());
+    guarantee(buf_->read.has());
+    uint16_t block_size;
+    const char *page
+        = static_cast<const char *>(buf_->read->get_data_read(&block_size));
+    const char *value = static_cast<const char *>(value_);
+    guarantee(value >= page && value < page + block_size);
+    if (!buf_->page_copy.has()) {
+        counted_t<shared_buf_t> copy = shared_buf_t::create(block_size);
+        memcpy(copy->data(), page, block_size);
+        buf_->page_copy = std::move(copy);
+    }
+    return shared_buf_ref_t<char>(buf_->page_copy, value - page);
+}
+
 // Releases the hold on the buf_lock_t, after which key(), value(), and expose_buf()
 // may not be used.
 void scoped_key_value_t::reset() {
@@ -35,8 +57,40 @@ void scoped_key_value_t::reset() {
 }
 
 
+/* Decides how many children of an internal node a read traversal loads ahead of the
+one it's working on. The depth doubles whenever we get to a child that we loaded ahead
+and it still isn't in memory, so the number of loads in flight grows with the latency
+of the disk. After a long run of children that were ready in time, it shrinks by one
+so that we don't keep pinning blocks we don't need yet. */
+class child_read_ahead_t {
+public:
+    child_read_ahead_t() : depth_(1), ready_streak_(0) { }
+
+    int depth() const { return depth_; }
+
+    void on_child_reached(bool was_ready) {
+        if (!was_ready) {
+            depth_ = std::min(depth_ * 2, MAX_DEPTH);
+            ready_streak_ = 0;
+        } else if (++ready_streak_ >= SHRINK_AFTER) {
+            depth_ = std::max(depth_ - 1, 1);
+            ready_streak_ = 0;
+        }
+    }
+
+private:
+    static const int MAX_DEPTH = 16;
+    static const int SHRINK_AFTER = 32;
+
+    int depth_;
+    int ready_streak_;
+
+    DISABLE_COPYING(child_read_ahead_t);
+};
+
 /* Returns `true` if we reached the end of the subtree or range, and `false` if
-`cb->handle_value()` returned `false`. */
+`cb->handle_value()` returned `false`. `read_ahead` is null when children shouldn't be
+loaded ahead of time. */
 continue_bool_t btree_depth_first_traversal(
         counted_t<counted_buf_lock_and_read_t> block,
         const key_range_t &range,
@@ -45,6 +99,7 @@ continue_bool_t btree_depth_first_traversal(
         direction_t direction,
         const btree_key_t *left_excl_or_null,
         const btree_key_t *right_incl,
+        child_read_ahead_t *read_ahead,
         signal_t *interruptor);
 
 continue_bool_t btree_depth_first_traversal(
@@ -103,9 +158,11 @@ continue_bool_t btree_depth_first_traversal(
             wait_interruptible(root_block->lock.read_acq_signal(), interruptor);
         }
 
+        child_read_ahead_t read_ahead;
         return btree_depth_first_traversal(
             std::move(root_block), range, cb, access, direction,
-            left_excl_or_null, right_incl_buf.btree_key(), interruptor);
+            left_excl_or_null, right_incl_buf.btree_key(),
+            access == access_t::read ? &read_ahead : nullptr, interruptor);
     }
 }
 
@@ -153,6 +210,7 @@ continue_bool_t btree_depth_first_traversal(
         direction_t direction,
         const btree_key_t *left_excl_or_null,
         const btree_key_t *right_incl,
+        child_read_ahead_t *read_ahead,
         signal_t *interruptor) {
     bool skip;
     if (continue_bool_t::ABORT == cb->filter_range_ts(
@@ -163,7 +221,9 @@ continue_bool_t btree_depth_first_traversal(
     if (skip) {
         return continue_bool_t::CONTINUE;
     }
-    block->read.init(new buf_read_t(&block->lock));
+    if (!block->read.has()) {
+        block->read.init(new buf_read_t(&block->lock));
+    }
     const node_t *node = static_cast<const node_t *>(block->read->get_data_read());
     if (node::is_internal(node)) {
         if (continue_bool_t::ABORT == cb->handle_pre_internal(
@@ -180,10 +240,41 @@ continue_bool_t btree_depth_first_traversal(
             r.decrement();
             end_index = internal_node::get_offset_index(inode, r.btree_key()) + 1;
         }
-        for (int i = 0; i < end_index - start_index; ++i) {
-            int true_index = (direction == FORWARD ? start_index + i : (end_index - 1) - i);
+        const int num_children = end_index - start_index;
+        auto index_of_child = [&](int i) {
+            return direction == FORWARD ? start_index + i : (end_index - 1) - i;
+        };
+        // The children after the current one that we've started acquiring, in
+        // traversal order, with their positions.
+        std::deque<std::pair<int, counted_t<counted_buf_lock_and_read_t> > > ahead;
+        int next_ahead = 1;
+        for (int i = 0; i < num_children; ++i) {
+            int true_index = index_of_child(i);
             const btree_internal_pair *pair = internal_node::get_pair_by_index(inode, true_index);
 
+            if (read_ahead != nullptr) {
+                for (; next_ahead < num_children && next_ahead <= i + read_ahead->depth();
+                     ++next_ahead) {
+                    const btree_internal_pair *ahead_pair = internal_node::get_pair_by_index(
+                        inode, index_of_child(next_ahead));
+                    auto ahead_lock = make_counted<counted_buf_lock_and_read_t>(
+                        &block->lock, ahead_pair->lnode, access);
+                    // We don't wait for the acquisition here; if it isn't immediate, the
+                    // block will be loaded when we get to it.
+                    if (ahead_lock->lock.read_acq_signal()->is_pulsed()
+                        && cb->prefetch_child(ahead_lock->lock.get_recency())) {
+                        ahead_lock->read.init(new buf_read_t(&ahead_lock->lock));
+                        ahead_lock->read->start_read();
+                    }
+                    ahead.emplace_back(next_ahead, std::move(ahead_lock));
+                }
+            }
+            counted_t<counted_buf_lock_and_read_t> acquired_ahead;
+            if (!ahead.empty() && ahead.front().first == i) {
+                acquired_ahead = std::move(ahead.front().second);
+                ahead.pop_front();
+            }
+
             // Get the child key range
             const btree_key_t *child_left_excl_or_null;
             const btree_key_t *child_right_incl;
@@ -202,13 +293,21 @@ continue_bool_t btree_depth_first_traversal(
                         cb->get_trace() != nullptr,
                         "Acquire block for read.",
                         cb->get_trace());
-                    lock = make_counted<counted_buf_lock_and_read_t>(
-                        &block->lock, pair->lnode, access);
+                    if (acquired_ahead.has()) {
+                        lock = std::move(acquired_ahead);
+                    } else {
+                        lock = make_counted<counted_buf_lock_and_read_t>(
+                            &block->lock, pair->lnode, access);
+                    }
                     wait_interruptible(lock->lock.read_acq_signal(), interruptor);
                 }
+                if (read_ahead != nullptr && lock->read.has()) {
+                    read_ahead->on_child_reached(lock->read->is_read_ready());
+                }
                 if (continue_bool_t::ABORT == btree_depth_first_traversal(
                         std::move(lock), range, cb, access, direction,
-                        child_left_excl_or_null, child_right_incl, interruptor)) {
+                        child_left_excl_or_null, child_right_incl, read_ahead,
+                        interruptor)) {
                     return continue_bool_t::ABORT;
                 }
             }
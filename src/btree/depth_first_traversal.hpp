@@ -7,6 +7,7 @@
 #include "buffer_cache/alt.hpp"
 #include "containers/archive/archive.hpp"
 #include "containers/counted.hpp"
+#include "containers/shared_buffer.hpp"
 #include "repli_timestamp.hpp"
 
 namespace profile { class trace_t; }
@@ -22,6 +23,9 @@ public:
         : lock(std::forward<Args>(args)...) { }
     buf_lock_t lock;
     scoped_ptr_t<buf_read_t> read;
+    // A copy of the node's contents, made on demand by
+    // `scoped_key_value_t::expose_page_copy()`.
+    counted_t<const shared_buf_t> page_copy;
 };
 
 // A btree leaf key/value pair that also owns a reference to the buf_lock_t that
@@ -45,6 +49,13 @@ public:
     }
     buf_parent_t expose_buf();
 
+    /* Returns a reference into a reference-counted copy of the leaf node, positioned
+    at `value()`.  The copy is made the first time this is called for any key/value
+    pair of the leaf and is then shared by all of them, so that a range read that
+    looks at many values in the same leaf pays for one allocation and one copy.  The
+    returned reference stays valid after `reset()`. */
+    shared_buf_ref_t<char> expose_page_copy();
+
     // Releases the hold on the buf_lock_t, after which key(), value(), and
     // expose_buf() may not be used.
     void reset();
@@ -85,6 +96,15 @@ public:
         return continue_bool_t::CONTINUE;
     }
 
+    /* Read traversals can start loading the next few children of an internal node
+    while they're still working on the current one. This is called for each child that
+    could be loaded early, before `filter_range()` or `filter_range_ts()` has been
+    called for it; return `true` only if the child will probably not be skipped and
+    loading ahead is worth it for this traversal. It must not have side effects. */
+    virtual bool prefetch_child(UNUSED repli_timestamp_t timestamp) {
+        return false;
+    }
+
     /* Called on every leaf node before the calls to `handle_pair()`. If it sets
     `*skip_out` to `true`, the leaf will be ignored. */
     virtual continue_bool_t handle_pre_leaf(
@@ -357,7 +357,28 @@ btree_internal_pair *get_pair_by_index(internal_node_t *node, int index) {
 }
 
 int get_offset_index(const internal_node_t *node, const btree_key_t *key) {
-    return std::lower_bound(node->pair_offsets, node->pair_offsets+node->npairs-1, (uint16_t) internal_key_comp::faux_offset, internal_key_comp(node, key)) - node->pair_offsets;
+    // A lower bound over all pairs except the last, special one.  Like in
+    // `leaf::find_key()`, we keep track of the prefix that key shares with the pairs
+    // bounding the range so that we don't compare it again.
+    int beg = 0;
+    int end = node->npairs - 1;
+    int beg_common = 0;
+    int end_common = 0;
+    while (beg < end) {
+        const int test_point = beg + (end - beg) / 2;
+        int common;
+        const int res = btree_key_cmp_skip_prefix(
+            key, &get_pair_by_index(node, test_point)->key,
+            std::min(beg_common, end_common), &common);
+        if (res > 0) {
+            beg = test_point + 1;
+            beg_common = common;
+        } else {
+            end = test_point;
+            end_common = common;
+        }
+    }
+    return beg;
 }
 
 int nodecmp(const internal_node_t *node1, const internal_node_t *node2) {
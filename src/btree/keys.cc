@@ -23,6 +23,31 @@ int sized_strcmp(const uint8_t *str1, int len1, const uint8_t *str2, int len2) {
     return res;
 }
 
+int btree_key_cmp_skip_prefix(const btree_key_t *left, const btree_key_t *right,
+                              int skip, int *common_out) {
+    const int min_len = std::min(left->size, right->size);
+    rassert(skip >= 0 && skip <= min_len);
+    int i = skip;
+    // Find the first differing word, then the first differing byte in it.
+    while (i + static_cast<int>(sizeof(uint64_t)) <= min_len) {
+        uint64_t left_word, right_word;
+        memcpy(&left_word, left->contents + i, sizeof(uint64_t));
+        memcpy(&right_word, right->contents + i, sizeof(uint64_t));
+        if (left_word != right_word) {
+            break;
+        }
+        i += sizeof(uint64_t);
+    }
+    while (i < min_len && left->contents[i] == right->contents[i]) {
+        ++i;
+    }
+    *common_out = i;
+    if (i < min_len) {
+        return static_cast<int>(left->contents[i]) - static_cast<int>(right->contents[i]);
+    }
+    return left->size - right->size;
+}
+
 bool unescaped_str_to_key(const char *str, int len, store_key_t *buf) {
     if (len <= MAX_KEY_SIZE) {
         memcpy(buf->contents(), str, len);
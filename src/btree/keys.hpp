@@ -52,6 +52,14 @@ inline int btree_key_cmp(const btree_key_t *left, const btree_key_t *right) {
     return sized_strcmp(left->contents, left->size, right->contents, right->size);
 }
 
+/* Compares `left` and `right` like `btree_key_cmp()` when their first `skip` bytes are
+already known to be equal, and sets `*common_out` to the length of their common prefix.
+The node searches use this: every key between two keys that share a prefix with the
+search key shares that prefix too, so it doesn't need to be compared again.  That
+matters for secondary index keys, which often start with the same long prefix. */
+int btree_key_cmp_skip_prefix(const btree_key_t *left, const btree_key_t *right,
+                              int skip, int *common_out);
+
 struct store_key_t {
 public:
     store_key_t() {
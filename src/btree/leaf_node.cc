@@ -1036,6 +1036,28 @@ void split(value_sizer_t *sizer, leaf_node_t *node, leaf_node_t *rnode, btree_ke
     keycpy(median_out, entry_key(get_entry(node, node->pair_offsets[s - 1])));
 }
 
+bool is_past_last_key(const leaf_node_t *node, const btree_key_t *key) {
+    if (node->num_pairs == 0) {
+        return true;
+    }
+    const btree_key_t *last_key =
+        entry_key(get_entry(node, node->pair_offsets[node->num_pairs - 1]));
+    return btree_key_cmp(key, last_key) > 0;
+}
+
+void split_at_end(value_sizer_t *sizer, leaf_node_t *node, leaf_node_t *rnode,
+                  btree_key_t *median_out) {
+    guarantee(node->num_pairs > 0);
+
+    init(sizer, rnode);
+
+    // The last key may belong to a deletion entry, but that's fine: all we need is
+    // for every key in `node` to be less than or equal to the median.
+    keycpy(median_out, entry_key(get_entry(node, node->pair_offsets[node->num_pairs - 1])));
+
+    validate(sizer, node);
+}
+
 void merge(value_sizer_t *sizer, leaf_node_t *left, leaf_node_t *right) {
     rassert(left != right);
 
@@ -1184,6 +1206,11 @@ bool find_key(const leaf_node_t *node, const btree_key_t *key, int *index_out) {
     int beg = 0;
     int end = node->num_pairs;
 
+    // The lengths of the prefixes that key shares with *(beg - 1) and *end.  All
+    // entries in between share the shorter of the two with key.
+    int beg_common = 0;
+    int end_common = 0;
+
     // beg == 0 or key > *(beg - 1).
     // end == num_pairs or key < *end.
 
@@ -1193,14 +1220,18 @@ bool find_key(const leaf_node_t *node, const btree_key_t *key, int *index_out) {
 
         const btree_key_t *ek = entry_key(get_entry(node, node->pair_offsets[test_point]));
 
-        int res = btree_key_cmp(key, ek);
+        int common;
+        int res = btree_key_cmp_skip_prefix(key, ek, std::min(beg_common, end_common),
+                                            &common);
 
         if (res < 0) {
             // key < *test_point.
             end = test_point;
+            end_common = common;
         } else if (res > 0) {
             // key > *test_point.  Since test_point < end, we have test_point + 1 <= end.
             beg = test_point + 1;
+            beg_common = common;
         } else {
             // We found the key!
             *index_out = test_point;
@@ -131,6 +131,16 @@ bool is_underfull(value_sizer_t *sizer, const leaf_node_t *node);
 void split(value_sizer_t *sizer, leaf_node_t *node, leaf_node_t *sibling,
            btree_key_t *median_out);
 
+// Returns true if `key` is greater than every key in `node`.
+bool is_past_last_key(const leaf_node_t *node, const btree_key_t *key);
+
+// Splits a nonempty `node` by leaving all of its entries where they are and making
+// `sibling` an empty node to the right of it.  We use this instead of `split()` when
+// appending to the rightmost leaf of the tree, so that loading keys in ascending
+// order leaves full leaves behind instead of half-full ones.
+void split_at_end(value_sizer_t *sizer, leaf_node_t *node, leaf_node_t *sibling,
+                  btree_key_t *median_out);
+
 void merge(value_sizer_t *sizer, leaf_node_t *left, leaf_node_t *right);
 
 // The pointers in `moved_values_out` point to positions in `node` and
@@ -65,6 +65,11 @@ void detach_all_children(const node_t *node, buf_parent_t parent,
 // Split the node if necessary. If the node is a leaf_node, provide the new
 // value that will be inserted; if it's an internal node, provide NULL (we
 // split internal nodes proactively).
+// `*buf_is_rightmost` says whether `buf` is the rightmost node on its level, and is
+// updated if `buf` ends up being the left half of a split. If `buf` is the rightmost
+// leaf and `key` goes past its last key, we're probably loading keys in ascending
+// order, so we leave `buf` full and start a new empty leaf for `key` instead of
+// splitting `buf` in half.
 // `detacher` is used to detach any values that are removed from `buf`, in
 // case `buf` is a leaf.
 void check_and_handle_split(value_sizer_t *sizer,
@@ -72,7 +77,9 @@ void check_and_handle_split(value_sizer_t *sizer,
                             buf_lock_t *last_buf,
                             superblock_t *sb,
                             const btree_key_t *key, void *new_value,
+                            bool *buf_is_rightmost,
                             const value_deleter_t *detacher) {
+    bool append_split = false;
     {
         buf_read_t buf_read(buf);
         const node_t *node = static_cast<const node_t *>(buf_read.get_data_read());
@@ -80,10 +87,11 @@ void check_and_handle_split(value_sizer_t *sizer,
         // If the node isn't full, we don't need to split, so we're done.
         if (!node::is_internal(node)) { // This should only be called when update_needed.
             rassert(new_value);
-            if (!leaf::is_full(sizer, reinterpret_cast<const leaf_node_t *>(node),
-                               key, new_value)) {
+            const leaf_node_t *leaf = reinterpret_cast<const leaf_node_t *>(node);
+            if (!leaf::is_full(sizer, leaf, key, new_value)) {
                 return;
             }
+            append_split = *buf_is_rightmost && leaf::is_past_last_key(leaf, key);
         } else {
             rassert(!new_value);
             if (!internal_node::is_full(reinterpret_cast<const internal_node_t *>(node))) {
@@ -109,10 +117,17 @@ void check_and_handle_split(value_sizer_t *sizer,
     {
         buf_write_t buf_write(buf);
         buf_write_t rbuf_write(&rbuf);
-        node::split(sizer,
-                    static_cast<node_t *>(buf_write.get_data_write()),
-                    static_cast<node_t *>(rbuf_write.get_data_write()),
-                    median);
+        if (append_split) {
+            leaf::split_at_end(sizer,
+                               static_cast<leaf_node_t *>(buf_write.get_data_write()),
+                               static_cast<leaf_node_t *>(rbuf_write.get_data_write()),
+                               median);
+        } else {
+            node::split(sizer,
+                        static_cast<node_t *>(buf_write.get_data_write()),
+                        static_cast<node_t *>(rbuf_write.get_data_write()),
+                        median);
+        }
 
         // We must detach all entries that we have removed from `buf`.
         buf_read_t rbuf_read(&rbuf);
@@ -154,10 +169,8 @@ void check_and_handle_split(value_sizer_t *sizer,
 
     // We've split the node; now figure out where the key goes and release the other buf (since we're done with it).
     if (0 >= btree_key_cmp(key, median)) {
-        // The key goes in the old buf (the left one).
-
-        // Do nothing.
-
+        // The key goes in the old buf (the left one), which now has a right sibling.
+        *buf_is_rightmost = false;
     } else {
         // The key goes in the new buf (the right one).
         buf->swap(rbuf);
@@ -378,6 +391,7 @@ void find_keyvalue_location_for_write(
 
     buf_lock_t last_buf;
     buf_lock_t buf;
+    bool buf_is_rightmost = true;
     {
         // KSI: We can't acquire the block for write here -- we could, but it would
         // worsen the performance of the program -- sometimes we only end up using
@@ -401,7 +415,8 @@ void find_keyvalue_location_for_write(
             PROFILE_STARTER_IF_ENABLED(
                 trace != nullptr, "Perhaps split node.", trace);
             check_and_handle_split(
-                sizer, &buf, &last_buf, superblock, key, nullptr, balancing_detacher);
+                sizer, &buf, &last_buf, superblock, key, nullptr, &buf_is_rightmost,
+                balancing_detacher);
         }
 
         // Check if the node is underfull, and merge/level if it is.
@@ -435,14 +450,24 @@ void find_keyvalue_location_for_write(
         // value in it. This will allow the backfill logic to efficiently find recently
         // changed nodes. Note that we do this after the split/merge/level logic; this
         // isn't strictly necessary, but it makes the timestamps slightly tighter.
-        buf.set_recency(superceding_recency(buf.get_recency(), timestamp));
+        // Setting the recency touches the node, which makes the transaction flush it,
+        // so we leave the node alone if its recency is already recent enough.
+        {
+            repli_timestamp_t recency = buf.get_recency();
+            repli_timestamp_t new_recency = superceding_recency(recency, timestamp);
+            if (new_recency != recency) {
+                buf.set_recency(new_recency);
+            }
+        }
 
         // Look up and acquire the next node.
         block_id_t node_id;
         {
             buf_read_t read(&buf);
             auto node = static_cast<const internal_node_t *>(read.get_data_read());
-            node_id = internal_node::lookup(node, key);
+            const int index = internal_node::get_offset_index(node, key);
+            node_id = internal_node::get_pair_by_index(node, index)->lnode;
+            buf_is_rightmost = buf_is_rightmost && index == node->npairs - 1;
         }
         rassert(node_id != NULL_BLOCK_ID && node_id != SUPERBLOCK_ID);
 
@@ -471,6 +496,7 @@ void find_keyvalue_location_for_write(
 
     keyvalue_location_out->last_buf.swap(last_buf);
     keyvalue_location_out->buf.swap(buf);
+    keyvalue_location_out->buf_is_rightmost = buf_is_rightmost;
 }
 
 void find_keyvalue_location_for_read(
@@ -575,7 +601,7 @@ void apply_keyvalue_change(
 
         check_and_handle_split(sizer, &kv_loc->buf, &kv_loc->last_buf,
                                kv_loc->superblock, key, kv_loc->value.get(),
-                               balancing_detacher);
+                               &kv_loc->buf_is_rightmost, balancing_detacher);
 
         {
 #ifndef NDEBUG
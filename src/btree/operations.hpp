@@ -101,7 +101,8 @@ class keyvalue_location_t {
 public:
     keyvalue_location_t()
         : superblock(nullptr), pass_back_superblock(nullptr),
-          there_originally_was_value(false), stat_block(NULL_BLOCK_ID) { }
+          buf_is_rightmost(false), there_originally_was_value(false),
+          stat_block(NULL_BLOCK_ID) { }
 
     ~keyvalue_location_t() {
         if (superblock != nullptr) {
@@ -123,6 +124,10 @@ public:
     // The buf owning the leaf node which contains the value.
     buf_lock_t buf;
 
+    // True if `buf` is the rightmost leaf of the tree, so that keys past its last key
+    // are past every key in the tree.
+    bool buf_is_rightmost;
+
     bool there_originally_was_value;
     // If the key/value pair was found, a pointer to a copy of the
     // value, otherwise NULL.
@@ -176,6 +181,7 @@ void check_and_handle_split(value_sizer_t *sizer,
                             buf_lock_t *last_buf,
                             superblock_t *sb,
                             const btree_key_t *key, void *new_value,
+                            bool *buf_is_rightmost,
                             const value_deleter_t *detacher);
 
 void check_and_handle_underfull(value_sizer_t *sizer,
@@ -3,6 +3,7 @@
 
 #include "btree/secondary_operations.hpp"
 #include "buffer_cache/blob.hpp"
+#include "config/args.hpp"
 #include "containers/binary_blob.hpp"
 
 /* This is the actual structure stored on disk for the superblock of a table's primary or
@@ -172,9 +173,40 @@ btree_slice_t::btree_slice_t(cache_t *c, perfmon_collection_t *parent,
     : stats(parent,
             (index_type == index_type_t::SECONDARY ? "index-" : "") + identifier),
       cache_(c),
-      backfill_account_(cache()->create_cache_account(BACKFILL_CACHE_PRIORITY)) { }
+      backfill_account_(cache()->create_cache_account(
+          io_class_t::BACKFILL, BACKFILL_CACHE_PRIORITY,
+          cache_access_pattern_t::SCAN)),
+      low_priority_account_(cache()->create_cache_account(
+          io_class_t::CACHE_READS, LOW_PRIORITY_QUERY_CACHE_PRIORITY,
+          cache_access_pattern_t::REGULAR)) { }
+
+btree_slice_t::~btree_slice_t() {
+    guarantee(shared_scans_.empty());
+}
+
+shared_scan_t::shared_scan_t(btree_slice_t *_slice, const key_range_t &_range)
+    : range(_range), position(_range.left), slice(_slice) {
+    slice->assert_thread();
+    slice->shared_scans_.push_back(this);
+}
+
+shared_scan_t::~shared_scan_t() {
+    slice->assert_thread();
+    slice->shared_scans_.remove(this);
+}
 
-btree_slice_t::~btree_slice_t() { }
+store_key_t shared_scan_t::join_position(btree_slice_t *slice,
+                                         const key_range_t &range) {
+    slice->assert_thread();
+    for (shared_scan_t *scan = slice->shared_scans_.head();
+         scan != nullptr;
+         scan = slice->shared_scans_.next(scan)) {
+        if (scan->range == range) {
+            return scan->position;
+        }
+    }
+    return range.left;
+}
 
 void superblock_metainfo_iterator_t::advance(char * p) {
     char* cur = p;
@@ -3,6 +3,7 @@
 #define BTREE_REQL_SPECIFIC_HPP_
 
 #include "btree/operations.hpp"
+#include "containers/intrusive_list.hpp"
 
 /* Most of the code in the `btree/` directory doesn't "know" about the format of the
 superblock; instead it manipulates the superblock using the abstract `superblock_t`. This
@@ -78,6 +79,30 @@ enum class index_type_t {
 cache for the purpose of storing a B-tree. It is specific to ReQL primary and secondary
 index B-trees. */
 
+class btree_slice_t;
+
+/* A scan of a range of the B-tree that other scans of the same range can start from
+where it is, so that they read the same blocks at about the same time and the cache
+only loads each block once for all of them. The scans have to be ones that don't care
+in which order they see the rows. */
+class shared_scan_t : public intrusive_list_node_t<shared_scan_t> {
+public:
+    shared_scan_t(btree_slice_t *slice, const key_range_t &range);
+    ~shared_scan_t();
+
+    /* Returns where a new scan of `range` should start, which is the position of a
+    scan of the same range that is in progress, or the left edge of `range`. */
+    static store_key_t join_position(btree_slice_t *slice, const key_range_t &range);
+
+    const key_range_t range;
+    /* A key that the scan has recently handled. */
+    store_key_t position;
+
+private:
+    btree_slice_t *const slice;
+    DISABLE_COPYING(shared_scan_t);
+};
+
 class btree_slice_t : public home_thread_mixin_debug_only_t {
 public:
     // Initializes a superblock (presumably, a buf_lock_t constructed with
@@ -97,15 +122,24 @@ public:
 
     cache_t *cache() { return cache_; }
     cache_account_t *get_backfill_account() { return &backfill_account_; }
+    cache_account_t *get_low_priority_account() { return &low_priority_account_; }
 
     btree_stats_t stats;
 
 private:
+    friend class shared_scan_t;
+
     cache_t *cache_;
 
+    // The scans of this B-tree that others can join
+    intrusive_list_t<shared_scan_t> shared_scans_;
+
     // Cache account to be used when backfilling.
     cache_account_t backfill_account_;
 
+    // Cache account to be used by reads of low priority queries.
+    cache_account_t low_priority_account_;
+
     DISABLE_COPYING(btree_slice_t);
 };
 
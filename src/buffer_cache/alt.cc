@@ -30,6 +30,20 @@ const double SOFT_UNWRITTEN_CHANGES_MEMORY_FRACTION = 0.5;
 // proportionally to the unwritten block changes limit
 const int64_t INDEX_CHANGES_LIMIT_FACTOR = 5;
 
+// Once the unwritten block changes fill this fraction of the semaphore's capacity, new
+// write transactions are delayed before they get in line, by an amount that grows
+// with the fill level and with how long the serializer needs to write the
+// transaction's changes. This slows writers down gradually as the flush backlog
+// grows, instead of letting them run at full speed until they hit the limit and then
+// stall them all at once.
+const double BACKPRESSURE_START_FRACTION = 0.5;
+const int64_t MAX_BACKPRESSURE_DELAY_MS = 100;
+
+// How often we fold the written changes into the flush rate estimate, and how much
+// weight a new sample gets.
+const int64_t FLUSH_RATE_SAMPLE_INTERVAL_MS = 100;
+const double FLUSH_RATE_SAMPLE_WEIGHT = 0.25;
+
 // There are very few ASSERT_NO_CORO_WAITING calls (instead we have
 // ASSERT_FINITE_CORO_WAITING) because most of the time we're at the mercy of the
 // page cache, which often may need to load or evict blocks, which may involve a
@@ -66,14 +80,25 @@ alt_txn_throttler_t::alt_txn_throttler_t(int64_t minimum_unwritten_changes_limit
     : minimum_unwritten_changes_limit_(minimum_unwritten_changes_limit),
       unwritten_block_changes_semaphore_(SOFT_UNWRITTEN_CHANGES_LIMIT),
       unwritten_index_changes_semaphore_(
-          SOFT_UNWRITTEN_CHANGES_LIMIT * INDEX_CHANGES_LIMIT_FACTOR) { }
+          SOFT_UNWRITTEN_CHANGES_LIMIT * INDEX_CHANGES_LIMIT_FACTOR),
+      flushed_changes_per_sec_(0),
+      changes_written_since_sample_(0),
+      last_sample_time_(get_ticks()) { }
 
 alt_txn_throttler_t::~alt_txn_throttler_t() { }
 
 throttler_acq_t alt_txn_throttler_t::begin_txn_or_throttle(
         write_durability_t durability,
         int64_t expected_change_count) {
+    // Soft durability transactions don't hold the semaphores until they get flushed,
+    // but their changes add to the backlog all the same, so they get delayed too.
+    const int64_t delay_ms = backpressure_delay_ms(expected_change_count);
+    if (delay_ms > 0) {
+        nap(delay_ms);
+    }
+
     throttler_acq_t acq(durability, expected_change_count);
+    acq.throttler_ = this;
     if (!acq.pre_spawn_flush()) {
         // Changes don't count until we "want" to flush the txn -- which for hard
         // durability is right away, but for soft durability is later.
@@ -103,6 +128,42 @@ void alt_txn_throttler_t::inform_memory_limit_change(uint64_t memory_limit,
     unwritten_block_changes_semaphore_.set_capacity(throttler_limit);
 }
 
+void alt_txn_throttler_t::note_changes_written(int64_t count) {
+    changes_written_since_sample_ += count;
+    const ticks_t now = get_ticks();
+    const double elapsed_secs =
+        ticks_to_secs(ticks_t{now.nanos - last_sample_time_.nanos});
+    if (elapsed_secs * 1000 < FLUSH_RATE_SAMPLE_INTERVAL_MS) {
+        return;
+    }
+    const double sample = changes_written_since_sample_ / elapsed_secs;
+    flushed_changes_per_sec_ = flushed_changes_per_sec_ == 0
+        ? sample
+        : flushed_changes_per_sec_
+            + FLUSH_RATE_SAMPLE_WEIGHT * (sample - flushed_changes_per_sec_);
+    changes_written_since_sample_ = 0;
+    last_sample_time_ = now;
+}
+
+int64_t alt_txn_throttler_t::backpressure_delay_ms(
+        int64_t expected_change_count) const {
+    if (flushed_changes_per_sec_ == 0 || expected_change_count == 0) {
+        // Until we have seen a flush we can't tell how big the backlog is in time, so
+        // we leave it to the semaphores.
+        return 0;
+    }
+    const int64_t capacity = unwritten_block_changes_semaphore_.capacity();
+    const double start = capacity * BACKPRESSURE_START_FRACTION;
+    const double fill = unwritten_block_changes_semaphore_.current();
+    if (fill <= start) {
+        return 0;
+    }
+    // Goes from 0 when the backlog reaches `start`, to 1 when it reaches capacity.
+    const double pressure = std::min(1.0, (fill - start) / (capacity - start));
+    const double flush_time_ms = expected_change_count * 1000 / flushed_changes_per_sec_;
+    return std::min<int64_t>(MAX_BACKPRESSURE_DELAY_MS, pressure * flush_time_ms);
+}
+
 int64_t clamp_ring_length(which_cpu_shard_t w, int64_t interval) {
     if (w.which_shard == 0) {
         return interval;
@@ -141,8 +202,25 @@ void cache_t::configure_flush_interval(flush_interval_t interval) {
         clamp_ring_length(which_cpu_shard_, interval.millis));
 }
 
-cache_account_t cache_t::create_cache_account(int priority) {
-    return page_cache_.create_cache_account(priority);
+void cache_t::configure_group_commit_delay(int64_t delay_ms) {
+    page_cache_.set_group_commit_delay(delay_ms);
+}
+
+void cache_t::configure_balancer_policy(const cache_balancer_policy_t &policy) {
+    page_cache_.evicter().set_balancer_policy(policy);
+}
+
+std::vector<block_id_t> cache_t::hot_block_ids(size_t max_count) {
+    return page_cache_.hot_block_ids(max_count);
+}
+
+void cache_t::warm_up(std::vector<block_id_t> block_ids) {
+    page_cache_.warm_up(std::move(block_ids));
+}
+
+cache_account_t cache_t::create_cache_account(
+        io_class_t io_class, int priority, cache_access_pattern_t access_pattern) {
+    return page_cache_.create_cache_account(io_class, priority, access_pattern);
 }
 
 alt_snapshot_node_t *
@@ -838,6 +916,19 @@ const void *buf_read_t::get_data_read(uint16_t *block_size_out) {
     return page_acq_.get_buf_read();
 }
 
+void buf_read_t::start_read() {
+    guarantee(lock_->read_acq_signal()->is_pulsed());
+    if (!page_acq_.has()) {
+        ASSERT_NO_CORO_WAITING;
+        page_acq_.init(lock_->get_held_page_for_read(), &lock_->cache()->page_cache_,
+                       lock_->txn()->account());
+    }
+}
+
+bool buf_read_t::is_read_ready() {
+    return page_acq_.has() && page_acq_.buf_ready_signal()->is_pulsed();
+}
+
 buf_write_t::buf_write_t(buf_lock_t *lock)
     : lock_(lock) {
     guarantee(lock_->access() == access_t::write);
@@ -31,12 +31,27 @@ public:
     void inform_memory_limit_change(uint64_t memory_limit,
                                     block_size_t max_block_size);
 
+    // Called by the page cache when a flush has written `count` block changes, so
+    // that we can estimate how fast the serializer drains them.
+    void note_changes_written(int64_t count);
+
 private:
+    // How long a new write transaction with `expected_change_count` changes should
+    // wait before it gets in line for the semaphores.
+    int64_t backpressure_delay_ms(int64_t expected_change_count) const;
+
     const int64_t minimum_unwritten_changes_limit_;
 
     new_semaphore_t unwritten_block_changes_semaphore_;
     new_semaphore_t unwritten_index_changes_semaphore_;
 
+    // A moving average of the block changes written per second, or 0 before we have
+    // seen a flush. `changes_written_since_sample_` are the changes written since
+    // `last_sample_time_`, which haven't been folded into the average yet.
+    double flushed_changes_per_sec_;
+    int64_t changes_written_since_sample_;
+    ticks_t last_sample_time_;
+
     DISABLE_COPYING(alt_txn_throttler_t);
 };
 
@@ -60,10 +75,24 @@ public:
     // throttling systems.  TODO: Come up with a consistent priority scheme,
     // i.e. define a "default" priority etc.  TODO: As soon as we can support it, we
     // might consider supporting a mem_cap parameter.
-    cache_account_t create_cache_account(int priority);
+    cache_account_t create_cache_account(
+        io_class_t io_class,
+        int priority,
+        cache_access_pattern_t access_pattern = cache_access_pattern_t::REGULAR);
 
     void configure_flush_interval(flush_interval_t interval);
 
+    // How long hard durability transactions may wait for each other so that they
+    // get written to disk together.  See page_cache_t::set_group_commit_delay().
+    void configure_group_commit_delay(int64_t delay_ms);
+
+    // How the cache balancer should size this cache relative to the other caches.
+    void configure_balancer_policy(const cache_balancer_policy_t &policy);
+
+    // See `page_cache_t::hot_block_ids()` and `page_cache_t::warm_up()`.
+    std::vector<block_id_t> hot_block_ids(size_t max_count);
+    void warm_up(std::vector<block_id_t> block_ids);
+
 private:
     friend class txn_t;
     friend class buf_read_t;
@@ -338,6 +367,12 @@ public:
         return data;
     }
 
+    // Starts loading the block like get_data_read() does, but without waiting for
+    // it.  The lock must already be read-acquired.
+    void start_read();
+    // Returns true if get_data_read() would not have to wait for the block.
+    bool is_read_ready();
+
 private:
     buf_lock_t *lock_;
     alt::page_acq_t page_acq_;
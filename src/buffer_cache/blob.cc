@@ -94,6 +94,10 @@ char *small_buffer(char *ref, int maxreflen) {
     return ref + big_size_offset(maxreflen);
 }
 
+const char *small_buffer(const char *ref, int maxreflen) {
+    return ref + big_size_offset(maxreflen);
+}
+
 int64_t big_size(const char *ref, int maxreflen) {
     return *reinterpret_cast<const int64_t *>(ref + big_size_offset(maxreflen));
 }
@@ -311,8 +315,12 @@ void blob_t::detach_subtrees(buf_parent_t root) {
     }
 }
 
-union temporary_acq_tree_node_t {
+struct temporary_acq_tree_node_t {
+    temporary_acq_tree_node_t() : buf(nullptr), read(nullptr), child(nullptr) { }
+    // For leaf nodes.  When reading, `read` already holds the loaded block.
     buf_lock_t *buf;
+    buf_read_t *read;
+    // For internal nodes.
     temporary_acq_tree_node_t *child;
 };
 
@@ -391,6 +399,14 @@ struct region_tree_filler_t {
                                                             sub_ids);
         } else {
             nodes[i].buf = new buf_lock_t(parent, block_ids[lo + i], mode);
+            if (mode == access_t::read) {
+                // Load the block right here, so that the leaves of a large blob get
+                // read from disk concurrently rather than one by one when
+                // `expose_tree_from_block_ids()` walks over them.
+                nodes[i].read = new buf_read_t(nodes[i].buf);
+                uint16_t block_size;
+                nodes[i].read->get_data_read(&block_size);
+            }
         }
     }
 };
@@ -457,7 +473,8 @@ void expose_tree_from_block_ids(buf_parent_t parent, access_t mode,
             buf_lock_t *buf = tree[i].buf;
             void *leaf_buf;
             if (mode == access_t::read) {
-                buf_read_t *buf_read = new buf_read_t(buf);
+                buf_read_t *buf_read = tree[i].read;
+                rassert(buf_read != nullptr);
                 // We can't assert a specific block size here (without undesirably
                 // intricate logic), because immediately after creation, the blob has
                 // size max_value_size, but after we've written to the block, its
@@ -91,7 +91,7 @@ private:
 };
 
 
-union temporary_acq_tree_node_t;
+struct temporary_acq_tree_node_t;
 
 namespace blob {
 
@@ -134,6 +134,11 @@ struct ref_info_t {
 };
 ref_info_t ref_info(max_block_size_t block_size, const char *ref, int maxreflen);
 
+// Returns true if the blob's data is stored inline in the ref, in which case
+// small_buffer(ref, maxreflen) points at its value_size(ref, maxreflen) bytes.
+bool is_small(const char *ref, int maxreflen);
+const char *small_buffer(const char *ref, int maxreflen);
+
 // Returns the internal block ids of a non-inlined blob ref.
 const block_id_t *block_ids(const char *ref, int maxreflen);
 
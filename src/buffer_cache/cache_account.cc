@@ -3,18 +3,22 @@
 #include "arch/types.hpp"
 
 cache_account_t::cache_account_t()
-    : thread_(-1), io_account_(nullptr) { }
+    : thread_(-1), io_account_(nullptr),
+      access_pattern_(cache_access_pattern_t::REGULAR) { }
 
 cache_account_t::cache_account_t(cache_account_t &&movee)
-    : thread_(movee.thread_), io_account_(movee.io_account_) {
+    : thread_(movee.thread_), io_account_(movee.io_account_),
+      access_pattern_(movee.access_pattern_) {
     movee.thread_ = threadnum_t(-1);
     movee.io_account_ = nullptr;
+    movee.access_pattern_ = cache_access_pattern_t::REGULAR;
 }
 
 cache_account_t &cache_account_t::operator=(cache_account_t &&movee) {
     cache_account_t tmp(std::move(movee));
     std::swap(thread_, tmp.thread_);
     std::swap(io_account_, tmp.io_account_);
+    std::swap(access_pattern_, tmp.access_pattern_);
     return *this;
 }
 
@@ -26,8 +30,9 @@ void cache_account_t::init(threadnum_t thread, file_account_t *io_account) {
 }
 
 
-cache_account_t::cache_account_t(threadnum_t thread, file_account_t *io_account)
-    : thread_(thread), io_account_(io_account) {
+cache_account_t::cache_account_t(threadnum_t thread, file_account_t *io_account,
+                                 cache_access_pattern_t access_pattern)
+    : thread_(thread), io_account_(io_account), access_pattern_(access_pattern) {
     rassert(io_account != nullptr);
 }
 
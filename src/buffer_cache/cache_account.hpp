@@ -9,6 +9,14 @@ namespace alt {
 class page_cache_t;
 }
 
+// How the evicter treats pages that are accessed through a cache account.  `SCAN` is
+// for bulk operations that read most of a table once, such as backfills and secondary
+// index post-construction.  Pages that they load are the first to get evicted (like
+// read-ahead pages), and reading a page through them doesn't count as a use of the
+// page.  A page only becomes "recently used" once a `REGULAR` reader touches it, so a
+// scan can't push the working set of everybody else out of the cache.
+enum class cache_access_pattern_t { REGULAR, SCAN };
+
 class cache_account_t {
 public:
     cache_account_t();
@@ -19,17 +27,23 @@ public:
     file_account_t *get() const {
         return io_account_;
     }
+
+    cache_access_pattern_t access_pattern() const {
+        return access_pattern_;
+    }
 private:
     friend class alt::page_cache_t;
     // Takes ownership of the file_account_t pointee.
     void init(threadnum_t thread, file_account_t *io_account);
-    cache_account_t(threadnum_t thread, file_account_t *io_account);
+    cache_account_t(threadnum_t thread, file_account_t *io_account,
+                    cache_access_pattern_t access_pattern);
     void reset();
 
     // I hate having this thread_ variable.  The file_account_t does need to be
     // destroyed on the right thread, though.
     threadnum_t thread_;
     file_account_t *io_account_;
+    cache_access_pattern_t access_pattern_;
     DISABLE_COPYING(cache_account_t);
 };
 
@@ -21,7 +21,8 @@ alt_cache_balancer_t::cache_data_t::cache_data_t(alt::evicter_t *_evicter) :
     evictable_disk_backed_size(evicter->evictable_disk_backed_size()),
     evictable_unbacked_size(evicter->evictable_unbacked_size()),
     bytes_loaded(evicter->get_bytes_loaded()),
-    access_count(evicter->access_count()) { }
+    access_count(evicter->access_count()),
+    policy(evicter->balancer_policy()) { }
 
 alt_cache_balancer_t::alt_cache_balancer_t(
         clone_ptr_t<watchable_t<uint64_t> > _total_cache_size_watchable) :
@@ -117,16 +118,21 @@ void alt_cache_balancer_t::rebalance_blocking(UNUSED signal_t *interruptor) {
                    this, ph::_1, &cache_data, &zero_access_counts));
 
     bool all_zero_access_counts = true;
-    // Sum up the number of evicters, bytes loaded, and access counts
+    // Sum up the number of evicters, bytes loaded, and access counts.  Each cache's
+    // claim on memory is the bytes it loaded, scaled by the weight in its policy.
     size_t total_evicters = 0;
     uint64_t total_bytes_loaded = 0;
+    double total_weighted_bytes_loaded = 0;
     uint64_t total_access_count = 0;
     for (size_t i = 0; i < num_threads; ++i) {
         total_evicters += cache_data[i].size();
         all_zero_access_counts &= zero_access_counts[i];
         for (size_t j = 0; j < cache_data[i].size(); ++j) {
-            total_bytes_loaded += std::max<int64_t>(0, cache_data[i][j].bytes_loaded);
-            total_access_count += cache_data[i][j].access_count;
+            const cache_data_t &data = cache_data[i][j];
+            uint64_t loaded = std::max<int64_t>(0, data.bytes_loaded);
+            total_bytes_loaded += loaded;
+            total_weighted_bytes_loaded += data.policy.weight * loaded;
+            total_access_count += data.access_count;
         }
     }
 
@@ -163,9 +169,10 @@ void alt_cache_balancer_t::rebalance_blocking(UNUSED signal_t *interruptor) {
                 if (total_cache_size > 0) {
                     double temp = data->old_size;
                     temp /= static_cast<double>(total_cache_size);
-                    temp *= static_cast<double>(total_bytes_loaded);
+                    temp *= total_weighted_bytes_loaded;
 
-                    int64_t new_size = std::max<int64_t>(0, data->bytes_loaded);
+                    int64_t new_size = data->policy.weight
+                        * std::max<int64_t>(0, data->bytes_loaded);
                     new_size -= static_cast<int64_t>(temp);
                     new_size += data->old_size;
                     new_size = std::max<int64_t>(new_size, 0);
@@ -244,6 +251,8 @@ void alt_cache_balancer_t::rebalance_blocking(UNUSED signal_t *interruptor) {
 
         }
 
+        apply_policy_limits(total_cache_size, &cache_data);
+
         // Send new cache sizes to each thread
         pmap(num_threads,
              std::bind(&alt_cache_balancer_t::apply_rebalance_to_thread,
@@ -262,6 +271,71 @@ void alt_cache_balancer_t::rebalance_blocking(UNUSED signal_t *interruptor) {
     }
 }
 
+void alt_cache_balancer_t::apply_policy_limits(
+        uint64_t total_cache_size,
+        scoped_array_t<std::vector<cache_data_t> > *cache_data) {
+    std::vector<cache_data_t *> caches;
+    uint64_t total_min_size = 0;
+    for (size_t i = 0; i < cache_data->size(); ++i) {
+        for (cache_data_t &data : (*cache_data)[i]) {
+            caches.push_back(&data);
+            total_min_size += data.policy.min_size;
+        }
+    }
+
+    // The bounds we actually enforce, after scaling the minimums to fit.
+    std::vector<uint64_t> lower(caches.size());
+    std::vector<uint64_t> upper(caches.size());
+    double min_scale = 1.0;
+    if (total_min_size > total_cache_size) {
+        min_scale = static_cast<double>(total_cache_size)
+            / static_cast<double>(total_min_size);
+    }
+
+    int64_t extra_bytes = 0;
+    for (size_t i = 0; i < caches.size(); ++i) {
+        cache_data_t *data = caches[i];
+        lower[i] = data->policy.min_size * min_scale;
+        upper[i] = std::max(lower[i], data->policy.max_size);
+        uint64_t clamped = std::min(std::max(data->new_size, lower[i]), upper[i]);
+        extra_bytes += static_cast<int64_t>(data->new_size)
+            - static_cast<int64_t>(clamped);
+        data->new_size = clamped;
+    }
+
+    // Hand the bytes that clamping freed up (or took) to the caches that still have
+    // room.  Every round either hands out all of `extra_bytes` or pushes at least one
+    // more cache to its bound, so this terminates.
+    while (extra_bytes != 0) {
+        int64_t num_with_room = 0;
+        for (size_t i = 0; i < caches.size(); ++i) {
+            if (extra_bytes > 0 ? caches[i]->new_size < upper[i]
+                                : caches[i]->new_size > lower[i]) {
+                ++num_with_room;
+            }
+        }
+        if (num_with_room == 0) {
+            break;
+        }
+        int64_t delta = extra_bytes / num_with_room;
+        if (delta == 0) {
+            delta = ((extra_bytes < 0) ? -1 : 1);
+        }
+        for (size_t i = 0; i < caches.size() && extra_bytes != 0; ++i) {
+            cache_data_t *data = caches[i];
+            uint64_t room = (delta > 0) ? upper[i] - data->new_size
+                                        : data->new_size - lower[i];
+            uint64_t wanted = (delta > 0) ? delta : -delta;
+            int64_t change = std::min(room, wanted);
+            if (delta < 0) {
+                change = -change;
+            }
+            data->new_size += change;
+            extra_bytes -= change;
+        }
+    }
+}
+
 void alt_cache_balancer_t::collect_stats_from_thread(
         int index,
         scoped_array_t<std::vector<cache_data_t> > *data_out,
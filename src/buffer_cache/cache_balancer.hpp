@@ -8,6 +8,8 @@
 #include "errors.hpp"
 #include "time.hpp"
 
+#include "buffer_cache/types.hpp"
+
 #include "threading.hpp"
 #include "arch/timing.hpp"
 #include "concurrency/pump_coro.hpp"
@@ -149,8 +151,16 @@ private:
 
         int64_t bytes_loaded;
         uint64_t access_count;
+
+        cache_balancer_policy_t policy;
     };
 
+    // Moves memory between the caches so that each one ends up within the minimum and
+    // maximum size of its policy, keeping the sum of the new sizes the same.  If the
+    // minimums don't all fit in `total_cache_size`, they're scaled down evenly.
+    static void apply_policy_limits(uint64_t total_cache_size,
+                                    scoped_array_t<std::vector<cache_data_t> > *cache_data);
+
     // Helper function to collect stats from each thread so we don't need
     //  atomic variables slowing down normal operations
     void collect_stats_from_thread(int index,
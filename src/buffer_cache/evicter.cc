@@ -8,6 +8,14 @@
 
 namespace alt {
 
+page_cache_stats_t::page_cache_stats_t()
+    : hits_total(),
+      misses_total(),
+      misses_per_sec(secs_to_ticks(1)),
+      evictions_total(),
+      evictions_per_sec(secs_to_ticks(1)),
+      miss_latency(secs_to_ticks(10)) { }
+
 evicter_t::evicter_t()
     : initialized_(false),
       page_cache_(nullptr),
@@ -18,6 +26,10 @@ evicter_t::evicter_t()
       access_count_counter_(0),
       access_time_counter_(INITIAL_ACCESS_TIME),
       evict_if_necessary_active_(false),
+      unevictable_(true),
+      evictable_disk_backed_(true),
+      evictable_unbacked_(true),
+      evicted_(false),
       last_force_flush_time_(ticks_t{0}) { }
 
 evicter_t::~evicter_t() {
@@ -72,6 +84,14 @@ void wake_up_balancer(cache_balancer_t *balancer,
     balancer->wake_up_activity_happened();
 }
 
+void evicter_t::set_balancer_policy(const cache_balancer_policy_t &policy) {
+    guarantee_initialized();
+    guarantee(policy.weight >= 0);
+    guarantee(policy.min_size <= policy.max_size);
+    balancer_policy_ = policy;
+    coro_t::spawn_sometime(std::bind(&wake_up_balancer, balancer_, drainer_.lock()));
+}
+
 void evicter_t::notify_bytes_loading(int64_t in_memory_buf_change) {
     guarantee_initialized();
     bytes_loaded_counter_ += in_memory_buf_change;
@@ -203,6 +223,8 @@ void evicter_t::evict_if_necessary() THROWS_NOTHING {
         evictable_disk_backed_.remove(page, mem_usage);
         evicted_.add(page, mem_usage);
         page->evict_self(page_cache_);
+        ++stats_.evictions_total;
+        stats_.evictions_per_sec.record();
         page_cache_->consider_evicting_current_page(page->block_id());
     }
 
@@ -6,9 +6,11 @@
 #include <functional>
 
 #include "buffer_cache/eviction_bag.hpp"
+#include "buffer_cache/types.hpp"
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/cache_line_padded.hpp"
 #include "concurrency/pubsub.hpp"
+#include "perfmon/perfmon.hpp"
 #include "threading.hpp"
 #include "time.hpp"
 
@@ -19,6 +21,25 @@ namespace alt {
 
 class page_cache_t;
 
+/* How well the cache is doing. `alt_cache_stats_t` adds these to the cache's perfmon
+collection. A hit is an acquisition of a page that was already in memory, and a miss
+one that had to wait for the page to be read from disk. Hits happen on every block
+acquisition, so we only count them with a `perfmon_counter_t`, which doesn't have to
+read the clock. */
+struct page_cache_stats_t {
+    page_cache_stats_t();
+
+    perfmon_counter_t hits_total;
+    perfmon_counter_t misses_total;
+    perfmon_rate_monitor_t misses_per_sec;
+    perfmon_counter_t evictions_total;
+    perfmon_rate_monitor_t evictions_per_sec;
+    // How long it took to read the pages that missed.
+    perfmon_latency_histogram_t miss_latency;
+
+    DISABLE_COPYING(page_cache_stats_t);
+};
+
 class evicter_t : public home_thread_mixin_debug_only_t {
 public:
     void add_not_yet_loaded(page_t *page);
@@ -47,6 +68,14 @@ public:
                              uint64_t access_count_accounted_for,
                              bool read_ahead_ok);
 
+    // Changes how the balancer weighs this cache against the others.  It takes effect
+    // the next time the balancer rebalances.
+    void set_balancer_policy(const cache_balancer_policy_t &policy);
+    const cache_balancer_policy_t &balancer_policy() const {
+        guarantee_initialized();
+        return balancer_policy_;
+    }
+
     uint64_t next_access_time() {
         guarantee_initialized();
         return ++access_time_counter_;
@@ -78,6 +107,8 @@ public:
         return bytes_loaded_counter_;
     }
 
+    page_cache_stats_t *stats() { return &stats_; }
+
 
     uint64_t in_memory_size() const;
 
@@ -85,6 +116,13 @@ public:
     // rollovers.
     static const uint64_t INITIAL_ACCESS_TIME = UINT64_MAX - 100;
 
+    // The access time of pages that were read ahead and haven't been used yet.  We
+    // pick a weird that forces the logic and performance to not spaz out if the
+    // access time counter overflows.  Performance degradation is "smooth" if
+    // access_time_counter_ loops around past INITIAL_ACCESS_TIME -- which shouldn't be
+    // a problem for now, as long as we increment it one value at a time.
+    static const uint64_t READ_AHEAD_ACCESS_TIME = INITIAL_ACCESS_TIME - 1;
+
 private:
     void guarantee_initialized() const {
         assert_thread();
@@ -108,6 +146,8 @@ private:
 
     uint64_t memory_limit_;
 
+    cache_balancer_policy_t balancer_policy_;
+
     // These are updated every time a page is loaded, created, or destroyed, and
     // cleared when cache memory limits are re-evaluated.  This value can go
     // negative, if you keep deleting blocks or suddenly drop a snapshot.
@@ -129,6 +169,8 @@ private:
 
     ticks_t last_force_flush_time_;
 
+    page_cache_stats_t stats_;
+
     auto_drainer_t drainer_;
 
     DISABLE_COPYING(evicter_t);
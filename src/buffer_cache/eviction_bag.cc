@@ -3,13 +3,14 @@
 #include <inttypes.h>
 
 #include "buffer_cache/page.hpp"
+#include "perfmon/memory_usage.hpp"
 #include "random.hpp"
 #include "utils.hpp"
 
 namespace alt {
 
-eviction_bag_t::eviction_bag_t()
-    : bag_(), size_(0) { }
+eviction_bag_t::eviction_bag_t(bool in_memory)
+    : bag_(), size_(0), in_memory_(in_memory) { }
 
 eviction_bag_t::~eviction_bag_t() {
     guarantee(bag_.size() == 0);
@@ -19,11 +20,17 @@ eviction_bag_t::~eviction_bag_t() {
 void eviction_bag_t::change_size(int64_t adjustment) {
     rassert(adjustment >= 0 || size_ >= static_cast<uint64_t>(-adjustment));
     size_ += adjustment;
+    if (in_memory_) {
+        add_memory_usage(memory_usage_category_t::PAGE_CACHE, adjustment);
+    }
 }
 
 void eviction_bag_t::add(page_t *page, uint32_t ser_buf_size) {
     bag_.add(page);
     size_ += ser_buf_size;
+    if (in_memory_) {
+        add_memory_usage(memory_usage_category_t::PAGE_CACHE, ser_buf_size);
+    }
 }
 
 void eviction_bag_t::remove(page_t *page, uint32_t ser_buf_size) {
@@ -32,6 +39,10 @@ void eviction_bag_t::remove(page_t *page, uint32_t ser_buf_size) {
     rassert(value <= size_, "value = %" PRIu64 ", size_ = %" PRIu64,
             value, size_);
     size_ -= value;
+    if (in_memory_) {
+        add_memory_usage(memory_usage_category_t::PAGE_CACHE,
+                         -static_cast<int64_t>(value));
+    }
 }
 
 bool eviction_bag_t::has_page(page_t *page) const {
@@ -12,7 +12,9 @@ class page_cache_t;
 
 class eviction_bag_t {
 public:
-    eviction_bag_t();
+    // `in_memory` says whether the pages in this bag are loaded, and so whether its
+    // size counts towards the page cache's memory usage.
+    explicit eviction_bag_t(bool in_memory);
     ~eviction_bag_t();
 
     // Adjusts the size, given how much the size has changed of one of the pages in
@@ -42,6 +44,7 @@ private:
     backindex_bag_t<page_t *> bag_;
     // The size in memory.
     uint64_t size_;
+    const bool in_memory_;
 
     DISABLE_COPYING(eviction_bag_t);
 };
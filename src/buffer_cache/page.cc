@@ -45,13 +45,20 @@ private:
     DISABLE_COPYING(instant_page_loader_t);
 };
 
-// We pick a weird that forces the logic and performance to not spaz out if the
-// access time counter overflows.  Performance degradation is "smooth" if
-// access_time_counter_ loops around past INITIAL_ACCESS_TIME -- which shouldn't be a
-// problem for now, as long as we increment it one value at a time.
-static const uint64_t READ_AHEAD_ACCESS_TIME = evicter_t::INITIAL_ACCESS_TIME - 1;
+// Pages that a scan loads are as good an eviction candidate as read-ahead pages.  See
+// `cache_access_pattern_t`.
+static uint64_t initial_access_time(page_cache_t *page_cache,
+                                    cache_account_t *account) {
+    if (account != nullptr
+        && account->access_pattern() == cache_access_pattern_t::SCAN) {
+        return evicter_t::READ_AHEAD_ACCESS_TIME;
+    }
+    return page_cache->evicter().next_access_time();
+}
 
 
+SLAB_ALLOCATED_IMPL(page_t, "cache_pages");
+
 page_t::page_t(block_id_t _block_id, page_cache_t *page_cache)
     : block_id_(_block_id),
       loader_(nullptr),
@@ -69,7 +76,7 @@ page_t::page_t(block_id_t _block_id, page_cache_t *page_cache,
                cache_account_t *account)
     : block_id_(_block_id),
       loader_(nullptr),
-      access_time_(page_cache->evicter().next_access_time()),
+      access_time_(initial_access_time(page_cache, account)),
       snapshot_refcount_(0) {
     page_cache->evicter().add_not_yet_loaded(this);
 
@@ -99,7 +106,7 @@ page_t::page_t(block_id_t _block_id,
       loader_(nullptr),
       buf_(std::move(buf)),
       block_token_(_block_token),
-      access_time_(READ_AHEAD_ACCESS_TIME),
+      access_time_(evicter_t::READ_AHEAD_ACCESS_TIME),
       snapshot_refcount_(0) {
     rassert(buf_.has());
     page_cache->evicter().add_to_evictable_disk_backed(this);
@@ -108,7 +115,7 @@ page_t::page_t(block_id_t _block_id,
 page_t::page_t(page_t *copyee, page_cache_t *page_cache, cache_account_t *account)
     : block_id_(copyee->block_id_),
       loader_(nullptr),
-      access_time_(page_cache->evicter().next_access_time()),
+      access_time_(initial_access_time(page_cache, account)),
       snapshot_refcount_(0) {
     page_cache->evicter().add_not_yet_loaded(this);
     coro_t::spawn_now_dangerously(std::bind(&page_t::load_from_copyee,
@@ -349,6 +356,7 @@ void page_t::load_with_block_id(page_t *page, block_id_t block_id,
     buf_ptr_t buf;
     counted_t<block_token_t> block_token;
 
+    const ticks_t read_start = get_ticks();
     {
         serializer_t *const serializer = page_cache->serializer();
         on_thread_t th(serializer->home_thread());
@@ -357,6 +365,8 @@ void page_t::load_with_block_id(page_t *page, block_id_t block_id,
         buf = serializer->block_read(block_token,
                                      account->get());
     }
+    page_cache->evicter().stats()->miss_latency.record(
+        ticks_to_secs(ticks_t{get_ticks().nanos - read_start.nanos}));
 
     ASSERT_FINITE_CORO_WAITING;
     if (loader.abandon_page()) {
@@ -415,9 +425,15 @@ void page_t::add_waiter(page_acq_t *acq, cache_account_t *account) {
         = acq->page_cache()->evicter().correct_eviction_category(this);
     waiters_.push_front(acq);
     acq->page_cache()->evicter().change_to_correct_eviction_bag(old_bag, this);
+    page_cache_stats_t *stats = acq->page_cache()->evicter().stats();
     if (buf_.has()) {
+        ++stats->hits_total;
         acq->buf_ready_signal_.pulse();
-    } else if (loader_ != nullptr) {
+        return;
+    }
+    ++stats->misses_total;
+    stats->misses_per_sec.record();
+    if (loader_ != nullptr) {
         loader_->added_waiter(acq->page_cache(), account);
     } else if (block_token_.has()) {
         coro_t::spawn_now_dangerously(std::bind(&page_t::load_using_block_token,
@@ -446,6 +462,7 @@ void page_t::load_using_block_token(page_t *page, page_cache_t *page_cache,
     rassert(block_token.has());
 
     buf_ptr_t buf;
+    const ticks_t read_start = get_ticks();
     {
         serializer_t *const serializer = page_cache->serializer();
 
@@ -453,6 +470,8 @@ void page_t::load_using_block_token(page_t *page, page_cache_t *page_cache,
         buf = serializer->block_read(block_token,
                                      account->get());
     }
+    page_cache->evicter().stats()->miss_latency.record(
+        ticks_to_secs(ticks_t{get_ticks().nanos - read_start.nanos}));
 
     ASSERT_FINITE_CORO_WAITING;
     if (loader.abandon_page()) {
@@ -515,9 +534,12 @@ uint32_t page_t::hypothetical_memory_usage(page_cache_t *page_cache) const {
     }
 }
 
-void *page_t::get_page_buf(page_cache_t *page_cache) {
+void *page_t::get_page_buf(page_cache_t *page_cache,
+                           cache_access_pattern_t access_pattern) {
     rassert(buf_.has());
-    access_time_ = page_cache->evicter().next_access_time();
+    if (access_pattern == cache_access_pattern_t::REGULAR) {
+        access_time_ = page_cache->evicter().next_access_time();
+    }
     return buf_.cache_data();
 }
 
@@ -587,7 +609,9 @@ void page_t::init_block_token(counted_t<block_token_t> token,
 
 
 
-page_acq_t::page_acq_t() : page_(nullptr), page_cache_(nullptr) {
+page_acq_t::page_acq_t()
+    : page_(nullptr), page_cache_(nullptr),
+      access_pattern_(cache_access_pattern_t::REGULAR) {
 }
 
 void page_acq_t::init(page_t *page, page_cache_t *_page_cache,
@@ -597,6 +621,9 @@ void page_acq_t::init(page_t *page, page_cache_t *_page_cache,
     rassert(!buf_ready_signal_.is_pulsed());
     page_ = page;
     page_cache_ = _page_cache;
+    access_pattern_ = account != nullptr
+        ? account->access_pattern()
+        : cache_access_pattern_t::REGULAR;
     page_->add_waiter(this, account);
 }
 
@@ -621,12 +648,12 @@ void *page_acq_t::get_buf_write(block_size_t block_size) {
     buf_ready_signal_.wait();
     page_->reset_block_token(page_cache_);
     page_->set_page_buf_size(block_size, page_cache_);
-    return page_->get_page_buf(page_cache_);
+    return page_->get_page_buf(page_cache_, access_pattern_);
 }
 
 const void *page_acq_t::get_buf_read() {
     buf_ready_signal_.wait();
-    return page_->get_page_buf(page_cache_);
+    return page_->get_page_buf(page_cache_, access_pattern_);
 }
 
 void page_ptr_t::init(page_t *page) {
@@ -1,15 +1,15 @@
 #ifndef BUFFER_CACHE_PAGE_HPP_
 #define BUFFER_CACHE_PAGE_HPP_
 
+#include "buffer_cache/cache_account.hpp"
 #include "concurrency/cond_var.hpp"
+#include "concurrency/slab_allocator.hpp"
 #include "containers/backindex_bag.hpp"
 #include "containers/half_intrusive_list.hpp"
 #include "repli_timestamp.hpp"
 #include "serializer/buf_ptr.hpp"
 #include "serializer/types.hpp"
 
-class cache_account_t;
-
 namespace alt {
 
 class page_cache_t;
@@ -37,13 +37,16 @@ public:
     page_t(page_t *copyee, page_cache_t *page_cache, cache_account_t *account);
     ~page_t();
 
+    SLAB_ALLOCATED(page_t);
+
     page_t *make_copy(page_cache_t *page_cache, cache_account_t *account);
 
     void add_waiter(page_acq_t *acq, cache_account_t *account);
     void remove_waiter(page_acq_t *acq);
 
     // These may not be called until the page_acq_t's buf_ready_signal is pulsed.
-    void *get_page_buf(page_cache_t *page_cache);
+    // Updates the access time, unless the page is accessed by a scan.
+    void *get_page_buf(page_cache_t *page_cache, cache_access_pattern_t access_pattern);
     void reset_block_token(page_cache_t *page_cache);
     void set_page_buf_size(block_size_t block_size, page_cache_t *page_cache);
 
@@ -132,14 +135,15 @@ private:
 
     uint64_t access_time_;
 
-    // How many page_ptr_t's point at this page, expecting nothing to modify it,
-    // other than themselves.
-    size_t snapshot_refcount_;
-
     // A list of waiters that expect the value to be loaded, and (as long as there
     // are waiters) expect the value to never be evicted.
     half_intrusive_list_t<page_acq_t> waiters_;
 
+    // How many page_ptr_t's point at this page, expecting nothing to modify it,
+    // other than themselves.  (Next to eviction_index_, so that the two share a
+    // word.)
+    uint32_t snapshot_refcount_;
+
     // This page_t's index into its eviction bag (managed by the page_cache_t -- one
     // of unevictable_pages_, etc).  Which bag we should be in:
     //
@@ -250,6 +254,7 @@ public:
     page_acq_t(page_acq_t &&other) noexcept
         : half_intrusive_list_node_t<page_acq_t>(std::move(other)),
           page_(other.page_), page_cache_(other.page_cache_),
+          access_pattern_(other.access_pattern_),
           buf_ready_signal_(std::move(other.buf_ready_signal_)) {
         other.page_ = nullptr;
         other.page_cache_ = nullptr;
@@ -282,6 +287,8 @@ private:
 
     page_t *page_;
     page_cache_t *page_cache_;
+    // The access pattern of the cache account we were acquired with.
+    cache_access_pattern_t access_pattern_;
     cond_t buf_ready_signal_;
     DISABLE_COPYING(page_acq_t);
 };
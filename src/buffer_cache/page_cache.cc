@@ -8,8 +8,10 @@
 #include "arch/runtime/coroutines.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "arch/runtime/runtime_utils.hpp"
+#include "arch/timing.hpp"
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/new_mutex.hpp"
+#include "buffer_cache/alt.hpp"
 #include "buffer_cache/cache_balancer.hpp"
 #include "do_on_thread.hpp"
 #include "serializer/serializer.hpp"
@@ -50,6 +52,9 @@ void throttler_acq_t::update_dirty_page_count(int64_t new_count) {
 }
 
 void throttler_acq_t::mark_dirty_pages_written() {
+    if (throttler_ != nullptr) {
+        throttler_->note_changes_written(block_changes_semaphore_acq_.count());
+    }
     block_changes_semaphore_acq_.change_count(0);
 }
 
@@ -70,6 +75,11 @@ void throttler_acq_t::merge(throttler_acq_t &&other) {
     // guess we'll count its pages... if any more are acquired.
     prevent_updates_ &= other.prevent_updates_;
 
+    if (throttler_ == nullptr) {
+        throttler_ = other.throttler_;
+    }
+    other.throttler_ = nullptr;
+
     if (!has_txn_throttler()) {
         block_changes_semaphore_acq_ = std::move(other.block_changes_semaphore_acq_);
         index_changes_semaphore_acq_ = std::move(other.index_changes_semaphore_acq_);
@@ -133,7 +143,7 @@ void page_cache_t::consider_evicting_current_page(block_id_t block_id) {
     // We can't do anything until read-ahead is done, because it uses the existence
     // of a current_page_t entry to figure out whether the read-ahead page could be
     // out of date.
-    if (read_ahead_cb_ != nullptr) {
+    if (read_ahead_cb_ != nullptr || warm_ups_active_ > 0) {
         return;
     }
 
@@ -225,6 +235,113 @@ void page_cache_t::consider_evicting_all_current_pages(page_cache_t *page_cache,
     }
 }
 
+std::vector<block_id_t> page_cache_t::hot_block_ids(size_t max_count) {
+    assert_thread();
+    // Access times count up from where the evicter is now, so we sort by how long ago
+    // each page was used, which also works when the counter has wrapped around.
+    const uint64_t now = evicter_.next_access_time();
+    std::vector<std::pair<uint64_t, block_id_t> > pages;
+    for (const auto &pair : current_pages_) {
+        current_page_t *cp = pair.second;
+        if (cp->is_deleted() || !cp->page_.has()) {
+            continue;
+        }
+        page_t *page = cp->page_.get_page_for_read();
+        if (page->is_loaded()
+            && page->access_time() != evicter_t::READ_AHEAD_ACCESS_TIME) {
+            pages.emplace_back(now - page->access_time(), pair.first);
+        }
+    }
+    size_t count = std::min(max_count, pages.size());
+    std::partial_sort(pages.begin(), pages.begin() + count, pages.end());
+    std::vector<block_id_t> block_ids;
+    block_ids.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        block_ids.push_back(pages[i].second);
+    }
+    return block_ids;
+}
+
+void page_cache_t::warm_up(std::vector<block_id_t> block_ids) {
+    assert_thread();
+    if (!block_ids.empty()) {
+        coro_t::spawn_sometime(std::bind(&page_cache_t::do_warm_up,
+                                         this,
+                                         std::move(block_ids),
+                                         drainer_->lock()));
+    }
+}
+
+void page_cache_t::do_warm_up(page_cache_t *page_cache,
+                              std::vector<block_id_t> block_ids,
+                              auto_drainer_t::lock_t lock) {
+    // Blocks are read and handed to the cache in batches of this size, so that we
+    // don't switch threads for every block.
+    static const size_t BATCH_SIZE = 64;
+
+    page_cache->assert_thread();
+    ++page_cache->warm_ups_active_;
+    serializer_t *serializer = page_cache->serializer_;
+    {
+        on_thread_t thread_switcher(serializer->home_thread());
+        scoped_ptr_t<file_account_t> io_account(
+            serializer->make_io_account(io_class_t::CACHE_WARM_UP,
+                                        CACHE_WARM_UP_IO_PRIORITY));
+
+        std::vector<std::pair<block_id_t, counted_t<block_token_t> > > tokens;
+        tokens.reserve(block_ids.size());
+        for (block_id_t block_id : block_ids) {
+            counted_t<block_token_t> token = serializer->index_read(block_id);
+            if (token.has()) {
+                tokens.emplace_back(block_id, std::move(token));
+            }
+        }
+        std::sort(tokens.begin(), tokens.end(),
+                  [](const std::pair<block_id_t, counted_t<block_token_t> > &a,
+                     const std::pair<block_id_t, counted_t<block_token_t> > &b) {
+                      return a.second->offset() < b.second->offset();
+                  });
+
+        for (size_t i = 0; i < tokens.size(); i += BATCH_SIZE) {
+            if (lock.get_drain_signal()->is_pulsed()) {
+                break;
+            }
+            const size_t end = std::min(tokens.size(), i + BATCH_SIZE);
+            std::vector<buf_ptr_t> bufs;
+            bufs.reserve(end - i);
+            for (size_t j = i; j < end; ++j) {
+                bufs.push_back(serializer->block_read(tokens[j].second,
+                                                      io_account.get()));
+            }
+
+            on_thread_t thread_switcher_2(page_cache->home_thread());
+            for (size_t j = i; j < end; ++j) {
+                page_cache->add_warm_up_buf(tokens[j].first, std::move(bufs[j - i]),
+                                            tokens[j].second);
+            }
+        }
+    }
+
+    --page_cache->warm_ups_active_;
+    if (page_cache->warm_ups_active_ == 0 && page_cache->read_ahead_cb_ == nullptr) {
+        coro_t::spawn_sometime(std::bind(
+            &page_cache_t::consider_evicting_all_current_pages, page_cache, lock));
+    }
+}
+
+void page_cache_t::add_warm_up_buf(block_id_t block_id,
+                                   buf_ptr_t buf,
+                                   const counted_t<block_token_t> &token) {
+    assert_thread();
+    rassert(warm_ups_active_ > 0);
+
+    // Like with read-ahead, if there's no current_page_t for the block, nobody has
+    // acquired it since we read its token, so the buf we read is up to date.
+    if (current_pages_.count(block_id) > 0) {
+        return;
+    }
+    current_pages_[block_id] = new current_page_t(block_id, std::move(buf), token, this);
+}
 
 void page_cache_t::read_ahead_cb_is_destroyed() {
     assert_thread();
@@ -246,8 +363,11 @@ page_cache_t::page_cache_t(serializer_t *_serializer,
       serializer_(_serializer),
       // Start the counter at 1 so we can distinguish empty values.
       next_block_version_(block_version_t().subsequent()),
+      group_commit_delay_ms_(0),
+      group_commit_pending_(false),
       free_list_(_serializer),
       evicter_(),
+      warm_ups_active_(0),
       read_ahead_cb_(nullptr),
       drainer_(make_scoped<auto_drainer_t>()) {
 
@@ -263,7 +383,9 @@ page_cache_t::page_cache_t(serializer_t *_serializer,
             local_read_ahead_cb = new page_read_ahead_cb_t(_serializer, this);
         }
         default_reads_account_.init(_serializer->home_thread(),
-                                    _serializer->make_io_account(CACHE_READS_IO_PRIORITY));
+                                    _serializer->make_io_account(
+                                        io_class_t::CACHE_READS,
+                                        CACHE_READS_IO_PRIORITY));
         index_write_sink_.init(new page_cache_index_write_sink_t);
         recencies_ = _serializer->get_all_recencies();
     }
@@ -331,6 +453,12 @@ void page_cache_t::begin_flush_pending_txns(bool asap, ticks_t soft_deadline) {
         std::move(flush_set.begin(), flush_set.end(),
                   std::back_inserter(full_flush_set));
     }
+    if (group_commit_pending_) {
+        // Hard durability txn's are waiting for a group commit.  We might as well take
+        // them along, but then the flush mustn't be spread out over time.
+        take_group_commit_txns(&full_flush_set);
+        asap = true;
+    }
     if (!full_flush_set.empty()) {
         spawn_flush_flushables(std::move(full_flush_set), asap, soft_deadline);
     }
@@ -343,6 +471,12 @@ void page_cache_t::soft_durability_interval_flush(ticks_t soft_deadline) {
     }
 }
 
+void page_cache_t::set_group_commit_delay(int64_t delay_ms) {
+    assert_thread();
+    rassert(delay_ms >= 0);
+    group_commit_delay_ms_ = delay_ms;
+}
+
 void page_cache_t::flush_and_destroy_txn(
         scoped_ptr_t<page_txn_t> &&txn,
         write_durability_t durability,
@@ -439,7 +573,8 @@ current_page_t *page_cache_t::internal_page_for_new_chosen(block_id_t block_id)
     return inserted_page.first->second;
 }
 
-cache_account_t page_cache_t::create_cache_account(int priority) {
+cache_account_t page_cache_t::create_cache_account(
+        io_class_t io_class, int priority, cache_access_pattern_t access_pattern) {
     // We assume that a priority of 100 means that the transaction should have the
     // same priority as all the non-accounted transactions together. Not sure if this
     // makes sense.
@@ -457,14 +592,17 @@ cache_account_t page_cache_t::create_cache_account(int priority) {
         // Ideally we shouldn't have to switch to the serializer thread.  But that's
         // what the file account API is right now, deep in the I/O layer.
         on_thread_t thread_switcher(serializer_->home_thread());
-        io_account = serializer_->make_io_account(io_priority,
+        io_account = serializer_->make_io_account(io_class,
+                                                  io_priority,
                                                   outstanding_requests_limit);
     }
 
-    return cache_account_t(serializer_->home_thread(), io_account);
+    return cache_account_t(serializer_->home_thread(), io_account, access_pattern);
 }
 
 
+SLAB_ALLOCATED_IMPL(current_page_acq_t, "cache_page_acqs");
+
 current_page_acq_t::current_page_acq_t()
     : page_cache_(nullptr), the_txn_(nullptr) { }
 
@@ -572,7 +710,12 @@ current_page_acq_t::~current_page_acq_t() {
             snapshotted_page_.reset_page_ptr(page_cache_);
             current_page_->remove_keepalive();
         }
-        page_cache_->consider_evicting_current_page(block_id_);
+        // Pages that were just used are nearly always loaded and so stay, and asking
+        // `current_page_` directly saves looking it up by block id for every read of
+        // a hot page.
+        if (current_page_->should_be_evicted()) {
+            page_cache_->consider_evicting_current_page(block_id_);
+        }
     }
 }
 
@@ -642,16 +785,16 @@ repli_timestamp_t current_page_acq_t::recency() {
 // Doesn't do everything -- caller will need to disconnect dirtier->pages_dirtied_last_.
 void page_cache_t::help_take_snapshotted_dirtied_page(
         current_page_t *cp, block_id_t block_id, page_txn_t *dirtier) {
-    rassert(cp->last_dirtier_ == dirtier);
+    rassert(cp->last_dirtier() == dirtier);
     dirtier->add_snapshotted_dirtied_page(
-        block_id, cp->last_dirtier_version_,
-        cp->last_dirtier_recency_,
+        block_id, cp->txn_links_->last_dirtier_version,
+        cp->txn_links_->last_dirtier_recency,
         page_ptr_t(cp->the_page_for_read_or_deleted(current_page_help_t(block_id, this))));
 }
 
 void current_page_acq_t::dirty_the_page() {
     dirtied_page_ = true;
-    page_txn_t *prec = current_page_->last_dirtier_;
+    page_txn_t *prec = current_page_->last_dirtier();
     if (prec != the_txn_) {
 
         if (prec != nullptr) {
@@ -674,9 +817,10 @@ void current_page_acq_t::dirty_the_page() {
             prec->throttler_acq_.update_dirty_page_count(prec->dirtied_page_count());
         }
     }
-    current_page_->last_dirtier_ = the_txn_;
-    current_page_->last_dirtier_recency_ = page_cache_->recency_for_block_id(block_id_);
-    current_page_->last_dirtier_version_ = block_version_;
+    current_page_->set_last_dirtier(the_txn_);
+    current_page_txn_links_t *links = current_page_->txn_links();
+    links->last_dirtier_recency = page_cache_->recency_for_block_id(block_id_);
+    links->last_dirtier_version = block_version_;
 }
 
 page_t *current_page_acq_t::current_page_for_write(cache_account_t *account) {
@@ -697,8 +841,8 @@ void current_page_acq_t::set_recency(repli_timestamp_t _recency) {
     rassert(current_page_ != nullptr);
     touched_page_ = true;
     page_cache_->set_recency_for_block_id(block_id_, _recency);
-    if (current_page_->last_dirtier_ == the_txn_) {
-        current_page_->last_dirtier_recency_ = _recency;
+    if (current_page_->last_dirtier() == the_txn_) {
+        current_page_->txn_links_->last_dirtier_recency = _recency;
     }
 }
 
@@ -711,8 +855,8 @@ void current_page_acq_t::mark_deleted() {
     dirty_the_page();
     current_page_->mark_deleted(help());
     // HSI: This is gross and fragile that we need this knowledge here.
-    if (current_page_->last_dirtier_ == the_txn_) {
-        current_page_->last_dirtier_recency_ = repli_timestamp_t::invalid;
+    if (current_page_->last_dirtier() == the_txn_) {
+        current_page_->txn_links_->last_dirtier_recency = repli_timestamp_t::invalid;
     }
     // No need to call consider_evicting_current_page here -- there's a
     // current_page_acq_t for it: ourselves.
@@ -743,24 +887,25 @@ void current_page_acq_t::pulse_write_available() {
     write_cond_.pulse_if_not_already_pulsed();
 }
 
+SLAB_ALLOCATED_IMPL(current_page_t, "cache_current_pages");
+SLAB_ALLOCATED_IMPL(current_page_txn_links_t, "cache_current_page_txn_links");
+
 current_page_t::current_page_t(block_id_t block_id, page_cache_t *page_cache)
     : block_id_(block_id),
-      is_deleted_(false),
-      last_write_acquirer_(nullptr),
+      txn_links_(nullptr),
       last_write_acquirer_version_(page_cache->gen_block_version()),
-      last_dirtier_(nullptr),
-      num_keepalives_(0) { }
+      num_keepalives_(0),
+      is_deleted_(false) { }
 
 current_page_t::current_page_t(block_id_t block_id,
                                buf_ptr_t buf,
                                page_cache_t *page_cache)
     : block_id_(block_id),
       page_(new page_t(block_id, std::move(buf), page_cache)),
-      is_deleted_(false),
-      last_write_acquirer_(nullptr),
+      txn_links_(nullptr),
       last_write_acquirer_version_(page_cache->gen_block_version()),
-      last_dirtier_(nullptr),
-      num_keepalives_(0) { }
+      num_keepalives_(0),
+      is_deleted_(false) { }
 
 current_page_t::current_page_t(block_id_t block_id,
                                buf_ptr_t buf,
@@ -768,11 +913,10 @@ current_page_t::current_page_t(block_id_t block_id,
                                page_cache_t *page_cache)
     : block_id_(block_id),
       page_(new page_t(block_id, std::move(buf), token, page_cache)),
-      is_deleted_(false),
-      last_write_acquirer_(nullptr),
+      txn_links_(nullptr),
       last_write_acquirer_version_(page_cache->gen_block_version()),
-      last_dirtier_(nullptr),
-      num_keepalives_(0) { }
+      num_keepalives_(0),
+      is_deleted_(false) { }
 
 current_page_t::~current_page_t() {
     // Check that reset() has been called.
@@ -780,6 +924,7 @@ current_page_t::~current_page_t() {
 
     // An imperfect sanity check.
     rassert(!page_.has());
+    rassert(txn_links_ == nullptr);
     rassert(num_keepalives_ == 0);
 }
 
@@ -787,14 +932,15 @@ void current_page_t::reset(page_cache_t *page_cache) {
     rassert(acquirers_.empty());
     rassert(num_keepalives_ == 0);
 
-    // last_write_acquirer_ has to be null (flush started) so that we don't lose track
+    // last_write_acquirer() has to be null (flush started) so that we don't lose track
     // of our in-memory block_version_t values that track which version of a buf is
     // newer in compute_changes.  current_page_t::should_be_evicted tests for this being
     // null.
-    rassert(last_write_acquirer_ == nullptr);
+    rassert(last_write_acquirer() == nullptr);
 
     // HSI: Should this be null, or might it need to snapshot the dirtied page?
-    rassert(last_dirtier_ == nullptr);
+    rassert(last_dirtier() == nullptr);
+    rassert(txn_links_ == nullptr);
 
     page_.reset_page_ptr(page_cache);
     // No need to call consider_evicting_current_page here -- we're already getting
@@ -817,13 +963,13 @@ bool current_page_t::should_be_evicted() const {
         return false;
     }
 
-    // A reason: We still have a connection to last_write_acquirer_.  (Important.)
-    if (last_write_acquirer_ != nullptr) {
+    // A reason: We still have a connection to last_write_acquirer().  (Important.)
+    if (last_write_acquirer() != nullptr) {
         return false;
     }
 
     // A reason: We have a last dirtier.
-    if (last_dirtier_ != nullptr) {
+    if (last_dirtier() != nullptr) {
         return false;
     }
 
@@ -848,6 +994,40 @@ bool current_page_t::should_be_evicted() const {
     return true;
 }
 
+current_page_txn_links_t *current_page_t::txn_links() {
+    if (txn_links_ == nullptr) {
+        txn_links_ = new current_page_txn_links_t();
+    }
+    return txn_links_;
+}
+
+void current_page_t::free_txn_links_if_unused() {
+    if (txn_links_ != nullptr
+        && txn_links_->last_write_acquirer == nullptr
+        && txn_links_->last_dirtier == nullptr) {
+        delete txn_links_;
+        txn_links_ = nullptr;
+    }
+}
+
+void current_page_t::set_last_write_acquirer(page_txn_t *txn) {
+    if (txn != nullptr) {
+        txn_links()->last_write_acquirer = txn;
+    } else if (txn_links_ != nullptr) {
+        txn_links_->last_write_acquirer = nullptr;
+        free_txn_links_if_unused();
+    }
+}
+
+void current_page_t::set_last_dirtier(page_txn_t *txn) {
+    if (txn != nullptr) {
+        txn_links()->last_dirtier = txn;
+    } else if (txn_links_ != nullptr) {
+        txn_links_->last_dirtier = nullptr;
+        free_txn_links_if_unused();
+    }
+}
+
 void current_page_t::add_acquirer(current_page_acq_t *acq) {
     const block_version_t prev_version = last_write_acquirer_version_;
 
@@ -860,11 +1040,11 @@ void current_page_t::add_acquirer(current_page_acq_t *acq) {
 
         last_write_acquirer_version_ = v;
 
-        if (last_write_acquirer_ != acq_txn) {
+        if (last_write_acquirer() != acq_txn) {
             rassert(!acq_txn->pages_write_acquired_last_.has_element(this));
 
-            if (last_write_acquirer_ != nullptr) {
-                page_txn_t *prec = last_write_acquirer_;
+            if (last_write_acquirer() != nullptr) {
+                page_txn_t *prec = last_write_acquirer();
 
                 rassert(prec->pages_write_acquired_last_.has_element(this));
                 prec->pages_write_acquired_last_.remove(this);
@@ -873,7 +1053,7 @@ void current_page_t::add_acquirer(current_page_acq_t *acq) {
             }
 
             acq_txn->pages_write_acquired_last_.add(this);
-            last_write_acquirer_ = acq_txn;
+            set_last_write_acquirer(acq_txn);
         }
     } else {
         rassert(acq->the_txn_ == nullptr);
@@ -1179,11 +1359,11 @@ bool merge_replace(std::vector<T> *vec, T replacee, T replacement) {
 }
 
 void update_backindex_back_pointer(current_page_t *cp, page_txn_t *txn) {
-    cp->last_write_acquirer_ = txn;
+    cp->set_last_write_acquirer(txn);
 }
 
 void update_backindex_back_pointer(current_page_dirtier_t cp, page_txn_t *txn) {
-    cp.current_page->last_dirtier_ = txn;
+    cp.current_page->set_last_dirtier(txn);
 }
 
 template <class T, size_t N>
@@ -1415,7 +1595,7 @@ void page_cache_t::remove_txn_set_from_graph(
         while (txn->pages_write_acquired_last_.size() != 0) {
             current_page_t *current_page
                 = txn->pages_write_acquired_last_.access_random(0);
-            rassert(current_page->last_write_acquirer_ == txn);
+            rassert(current_page->last_write_acquirer() == txn);
 
 #ifndef NDEBUG
             // All existing acquirers should be read acquirers, since this txn _was_ the
@@ -1429,7 +1609,7 @@ void page_cache_t::remove_txn_set_from_graph(
 #endif
 
             txn->pages_write_acquired_last_.remove(current_page);
-            current_page->last_write_acquirer_ = nullptr;
+            current_page->set_last_write_acquirer(nullptr);
             page_cache->consider_evicting_current_page(current_page->block_id_);
         }
 
@@ -1441,7 +1621,7 @@ void page_cache_t::remove_txn_set_from_graph(
                 dirtier.current_page, dirtier.current_page->block_id_, txn);
 
             txn->pages_dirtied_last_.remove(dirtier);
-            dirtier.current_page->last_dirtier_ = nullptr;
+            dirtier.current_page->set_last_dirtier(nullptr);
 
             page_cache->consider_evicting_current_page(dirtier.current_page->block_id_);
         }
@@ -2026,6 +2206,19 @@ void page_cache_t::begin_waiting_for_flush(
         page_txn_t *base_unscoped = base.release();
         want_to_spawn_flush_.push_back(base_unscoped);
 
+        if (durability == write_durability_t::HARD && group_commit_delay_ms_ > 0) {
+            // The txn stays in want_to_spawn_flush_ until do_group_commit picks it up
+            // together with the other hard durability txn's that arrive in the
+            // meantime.  Writing them all at once means we only wait for one index
+            // write (and one metablock write) instead of one for each txn.
+            if (!group_commit_pending_) {
+                group_commit_pending_ = true;
+                coro_t::spawn_sometime(std::bind(&page_cache_t::do_group_commit,
+                                                 this, drainer_->lock()));
+            }
+            return;
+        }
+
         std::vector<scoped_ptr_t<page_txn_t>> flush_set
             = page_cache_t::maximal_flushable_txn_set(base_unscoped);
 
@@ -2036,5 +2229,51 @@ void page_cache_t::begin_waiting_for_flush(
     }
 }
 
+void page_cache_t::do_group_commit(page_cache_t *page_cache,
+                                   auto_drainer_t::lock_t lock) {
+    try {
+        nap(page_cache->group_commit_delay_ms_, lock.get_drain_signal());
+    } catch (const interrupted_exc_t &) {
+        // The page cache is getting destroyed.  Its destructor flushes the txn's.
+        return;
+    }
+    if (!page_cache->group_commit_pending_) {
+        // begin_flush_pending_txns already took the txn's.
+        return;
+    }
+    std::vector<scoped_ptr_t<page_txn_t>> flush_set;
+    page_cache->take_group_commit_txns(&flush_set);
+    if (!flush_set.empty()) {
+        page_cache->spawn_flush_flushables(std::move(flush_set), true,
+                                           ticks_t{0} /* no soft deadline */);
+    }
+}
+
+void page_cache_t::take_group_commit_txns(
+        std::vector<scoped_ptr_t<page_txn_t>> *flush_set_out) {
+    ASSERT_NO_CORO_WAITING;
+    group_commit_pending_ = false;
+
+    // remove_txn_set_from_graph removes txn's from want_to_spawn_flush_, so we can't
+    // iterate over the list directly.  Txn's that can't be flushed yet (because
+    // they're waiting for a preceder) stay in the list, as they would have without
+    // the group commit delay.
+    std::vector<page_txn_t *> bases;
+    for (page_txn_t *ptr = want_to_spawn_flush_.head(); ptr != nullptr;
+         ptr = want_to_spawn_flush_.next(ptr)) {
+        bases.push_back(ptr);
+    }
+    for (page_txn_t *base : bases) {
+        if (base->spawned_flush_) {
+            // Already part of a flush set we've taken from a previous base.
+            continue;
+        }
+        std::vector<scoped_ptr_t<page_txn_t>> flush_set
+            = page_cache_t::maximal_flushable_txn_set(base);
+        page_cache_t::remove_txn_set_from_graph(this, flush_set);
+        std::move(flush_set.begin(), flush_set.end(),
+                  std::back_inserter(*flush_set_out));
+    }
+}
 
 }  // namespace alt
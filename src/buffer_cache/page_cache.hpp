@@ -9,6 +9,7 @@
 #include <utility>
 #include <vector>
 
+#include "arch/types.hpp"
 #include "buffer_cache/block_version.hpp"
 #include "buffer_cache/cache_account.hpp"
 #include "buffer_cache/evicter.hpp"
@@ -87,6 +88,36 @@ namespace alt {
 // known by the current_page_acq_t.
 class current_page_help_t;
 
+// The links between a current_page_t and the page_txn_t's that last write-acquired
+// and last dirtied it.  Most cached pages haven't been touched by a transaction that is
+// still waiting to be flushed, so instead of making every current_page_t bigger, these
+// are allocated only while one of the two txn pointers is non-null.
+class current_page_txn_links_t {
+public:
+    current_page_txn_links_t()
+        : last_write_acquirer(nullptr), last_dirtier(nullptr) { }
+
+    SLAB_ALLOCATED(current_page_txn_links_t);
+
+    // The last write acquirer for this page.
+    page_txn_t *last_write_acquirer;
+    // Our index into the last_write_acquirer->pages_write_acquired_last_.
+    backindex_bag_index_t last_write_acquirer_index;
+
+    page_txn_t *last_dirtier;
+    backindex_bag_index_t last_dirtier_index;
+
+    // The version and recency of the page, that the last dirtier had.  We merely set
+    // and read these values, the only thing it affects is compute_changes, later.
+    // Maybe we should replace last_dirtier with last_toucher_or_dirtier.  Then we
+    // wouldn't need this recency field.
+    block_version_t last_dirtier_version;
+    repli_timestamp_t last_dirtier_recency;
+
+private:
+    DISABLE_COPYING(current_page_txn_links_t);
+};
+
 class current_page_t {
 public:
     current_page_t(block_id_t block_id, buf_ptr_t buf, page_cache_t *page_cache);
@@ -99,6 +130,8 @@ public:
     // You MUST call reset() before destructing a current_page_t!
     ~current_page_t();
 
+    SLAB_ALLOCATED(current_page_t);
+
     // You can only call this when it's safe to do so!  (Beware of
     // current_page_acq_t's, last write acquirer page_txn_t's, and read-ahead logic.)
     void reset(page_cache_t *page_cache);
@@ -145,6 +178,20 @@ private:
 
     bool is_deleted() const { return is_deleted_; }
 
+    page_txn_t *last_write_acquirer() const {
+        return txn_links_ == nullptr ? nullptr : txn_links_->last_write_acquirer;
+    }
+    page_txn_t *last_dirtier() const {
+        return txn_links_ == nullptr ? nullptr : txn_links_->last_dirtier;
+    }
+    // Setting both of them to null frees txn_links_, so the page must have been
+    // removed from the txn's bag first.
+    void set_last_write_acquirer(page_txn_t *txn);
+    void set_last_dirtier(page_txn_t *txn);
+    // Allocates txn_links_ if necessary.
+    current_page_txn_links_t *txn_links();
+    void free_txn_links_if_unused();
+
     // KSI: We could get rid of this variable if
     // page_txn_t::pages_write_acquired_last_ noted each page's block_id_t.  Other
     // space reductions are more important.
@@ -156,27 +203,15 @@ private:
     // be used to access this variable.
     // KSI: Could we encapsulate that rule?
     page_ptr_t page_;
-    // True if the block is in a deleted state.  page_ will be null.
-    bool is_deleted_;
 
-    // The last write acquirer for this page.
-    page_txn_t *last_write_acquirer_;
-    // Our index into the last_write_acquirer_->pages_write_acquired_last_.
-    backindex_bag_index_t last_write_acquirer_index_;
+    // The links to the last write acquirer and the last dirtier, or null if there
+    // are neither.
+    current_page_txn_links_t *txn_links_;
 
-    // The version of the page, that the last write acquirer had.
+    // The version of the page, that the last write acquirer had.  (Unlike the
+    // last write acquirer itself, this is needed for as long as the page exists.)
     block_version_t last_write_acquirer_version_;
 
-    page_txn_t *last_dirtier_;
-    backindex_bag_index_t last_dirtier_index_;
-
-    // The version and recency of the page, that the last dirtier had.  We merely set
-    // and read these values, the only thing it affects is compute_changes, later.
-    // Maybe we should replace last_dirtier_ with last_toucher_or_dirtier_.  Then we
-    // wouldn't need this recency field.
-    block_version_t last_dirtier_version_;
-    repli_timestamp_t last_dirtier_recency_;
-
     // Instead of storing the recency here, we store it page_cache_t::recencies_.
 
     // All list elements have current_page_ != NULL, snapshotted_page_ == NULL.
@@ -185,13 +220,16 @@ private:
     // Avoids eviction if > 0. This is used by snapshotted current_page_acq_t's
     // that have a snapshotted version of this block. If the current_page_t
     // would be evicted that would mess with the block version.
-    intptr_t num_keepalives_;
+    int32_t num_keepalives_;
+    // True if the block is in a deleted state.  page_ will be null.  (Next to
+    // num_keepalives_, so that they share a word.)
+    bool is_deleted_;
 
     DISABLE_COPYING(current_page_t);
 };
 
 inline backindex_bag_index_t *access_backindex(current_page_t *current_page) {
-    return &current_page->last_write_acquirer_index_;
+    return &current_page->txn_links()->last_write_acquirer_index;
 }
 
 // Distinguishes type for access_backindex overloading.
@@ -199,7 +237,7 @@ struct current_page_dirtier_t {
     current_page_t *current_page;
 };
 inline backindex_bag_index_t *access_backindex(current_page_dirtier_t dirtier) {
-    return &dirtier.current_page->last_dirtier_index_;
+    return &dirtier.current_page->txn_links()->last_dirtier_index;
 }
 
 
@@ -224,6 +262,8 @@ public:
                        read_access_t read);
     ~current_page_acq_t();
 
+    SLAB_ALLOCATED(current_page_acq_t);
+
     // Declares ourself snapshotted.  (You must be readonly to do this.)
     void declare_snapshotted();
 
@@ -333,16 +373,19 @@ class throttler_acq_t {
 public:
     explicit throttler_acq_t(write_durability_t durability,
                              int64_t expected_change_count)
-        : prevent_updates_(false),
+        : throttler_(nullptr),
+          prevent_updates_(false),
           expected_change_count_(expected_change_count),
           pre_spawn_flush_(durability == write_durability_t::HARD) { }
     ~throttler_acq_t() { }
     throttler_acq_t(throttler_acq_t &&movee)
-        : prevent_updates_(movee.prevent_updates_),
+        : throttler_(movee.throttler_),
+          prevent_updates_(movee.prevent_updates_),
           expected_change_count_(movee.expected_change_count_),
           pre_spawn_flush_(movee.pre_spawn_flush_),
           block_changes_semaphore_acq_(std::move(movee.block_changes_semaphore_acq_)),
           index_changes_semaphore_acq_(std::move(movee.index_changes_semaphore_acq_)) {
+        movee.throttler_ = nullptr;
         movee.prevent_updates_ = false;
         movee.pre_spawn_flush_ = false;
         movee.expected_change_count_ = 0;
@@ -380,6 +423,10 @@ public:
     void set_prevent_updates();
 
 private:
+    // The throttler whose semaphores we hold, which we tell about written changes, or
+    // null for read transactions.
+    alt_txn_throttler_t *throttler_;
+
     // Prevents pages the semaphores from updating their dirty page count when true,
     // despite update_dirty_page_count getting called.  (Allows
     // mark_dirty_pages_written.)
@@ -445,6 +492,11 @@ public:
     // Starts an official soft durability interval flush, if one isn't running already.
     void soft_durability_interval_flush(ticks_t soft_deadline);
 
+    // Makes hard durability txn's wait up to `delay_ms` milliseconds for other hard
+    // durability txn's, so that they all get written with a single flush (and a
+    // single index write).  0 (the default) flushes every txn right away.
+    void set_group_commit_delay(int64_t delay_ms);
+
     // Takes a txn to be flushed.  Pulses on_complete_or_null when done.
     void flush_and_destroy_txn(
             scoped_ptr_t<page_txn_t> &&txn,
@@ -466,7 +518,10 @@ public:
 
     max_block_size_t max_block_size() const { return max_block_size_; }
 
-    cache_account_t create_cache_account(int priority);
+    cache_account_t create_cache_account(
+        io_class_t io_class,
+        int priority,
+        cache_access_pattern_t access_pattern = cache_access_pattern_t::REGULAR);
 
     cache_account_t *default_reads_account() {
         return &default_reads_account_;
@@ -482,6 +537,16 @@ public:
 
     void have_read_ahead_cb_destroyed();
 
+    // Returns the block ids of up to `max_count` of the pages that are in memory and
+    // have been used, the most recently used first.
+    std::vector<block_id_t> hot_block_ids(size_t max_count);
+
+    // Reads the given blocks into the cache in the background, in the order in which
+    // they're stored on disk, so that a restarted server gets back the working set
+    // that `hot_block_ids()` returned before.  Blocks that don't exist anymore, or
+    // that get acquired before the warm-up reaches them, are skipped.
+    void warm_up(std::vector<block_id_t> block_ids);
+
     evicter_t &evicter() { return evicter_; }
 
     auto_drainer_t::lock_t drainer_lock() { return drainer_->lock(); }
@@ -498,6 +563,13 @@ private:
 
     void read_ahead_cb_is_destroyed();
 
+    static void do_warm_up(page_cache_t *page_cache,
+                           std::vector<block_id_t> block_ids,
+                           auto_drainer_t::lock_t lock);
+    void add_warm_up_buf(block_id_t block_id,
+                         buf_ptr_t buf,
+                         const counted_t<block_token_t> &token);
+
 
     current_page_t *internal_page_for_new_chosen(block_id_t block_id);
 
@@ -548,6 +620,13 @@ private:
     void begin_waiting_for_flush(scoped_ptr_t<page_txn_t> &&txn,
                                  write_durability_t durability);
 
+    // Waits for the group commit delay, then flushes the hard durability txn's that
+    // have been waiting for it.
+    static void do_group_commit(page_cache_t *page_cache, auto_drainer_t::lock_t lock);
+    // Appends all txn's in want_to_spawn_flush_ that can presently be flushed to
+    // flush_set_out, disconnecting them from the graph.
+    void take_group_commit_txns(std::vector<scoped_ptr_t<page_txn_t>> *flush_set_out);
+
     // "asap = true" says to flush immediately, a hard durability transaction (or
     // otherwise high priority) is waiting.  flush_set must not be empty.
     void spawn_flush_flushables(std::vector<scoped_ptr_t<page_txn_t>> &&flush_set,
@@ -638,10 +717,21 @@ private:
     // pre_spawn_flush_ true.
     intrusive_list_t<page_txn_t> want_to_spawn_flush_;
 
+    // See set_group_commit_delay().  group_commit_pending_ is true while hard
+    // durability txn's sit in want_to_spawn_flush_ waiting for a do_group_commit
+    // coroutine.
+    int64_t group_commit_delay_ms_;
+    bool group_commit_pending_;
+
     free_list_t free_list_;
 
     evicter_t evicter_;
 
+    // The number of do_warm_up() coroutines that are running.  Like during read-ahead,
+    // we don't destroy any current_page_t's while this is nonzero, so that a block
+    // without one can't have been modified since the warm-up read its token.
+    int warm_ups_active_;
+
     // KSI: I bet this read_ahead_cb_ and read_ahead_cb_existence_ type could be
     // packaged in some new cross_thread_ptr type.
     page_read_ahead_cb_t *read_ahead_cb_;
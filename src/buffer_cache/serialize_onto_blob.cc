@@ -1,5 +1,13 @@
 #include "buffer_cache/serialize_onto_blob.hpp"
 
+#include <string.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "containers/archive/string_stream.hpp"
+
 void write_onto_blob(buf_parent_t parent, blob_t *blob,
                      const write_message_t &wm) {
     blob->clear(parent);
@@ -18,3 +26,45 @@ void write_onto_blob(buf_parent_t parent, blob_t *blob,
               "Blob not filled by write_message_t (Was it made too big?)");
 }
 
+bool patch_blob_in_place(buf_parent_t parent, blob_t *blob,
+                         const write_message_t &wm) {
+    if (blob->valuesize() != static_cast<int64_t>(wm.size())) {
+        return false;
+    }
+
+    string_stream_t stream;
+    int res = send_write_message(&stream, &wm);
+    guarantee(res == 0, "Failed to put write_message_t into a string.");
+    const std::string &data = stream.str();
+
+    // Each buffer that `expose_all` gives us is the part of the blob that lives in one
+    // block, so we compare them one by one and collect the runs of adjacent blocks
+    // that change, as (offset, size) pairs.
+    std::vector<std::pair<int64_t, int64_t> > changed_runs;
+    {
+        blob_acq_t acq;
+        buffer_group_t group;
+        blob->expose_all(parent, access_t::read, &group, &acq);
+
+        int64_t offset = 0;
+        for (size_t i = 0; i < group.num_buffers(); ++i) {
+            buffer_group_t::buffer_t buffer = group.get_buffer(i);
+            if (memcmp(buffer.data, data.data() + offset, buffer.size) != 0) {
+                if (!changed_runs.empty()
+                    && changed_runs.back().first + changed_runs.back().second
+                       == offset) {
+                    changed_runs.back().second += buffer.size;
+                } else {
+                    changed_runs.push_back(std::make_pair(offset, buffer.size));
+                }
+            }
+            offset += buffer.size;
+        }
+        guarantee(offset == static_cast<int64_t>(data.size()));
+    }
+
+    for (const auto &run : changed_runs) {
+        blob->write_from_string(data.substr(run.first, run.second), parent, run.first);
+    }
+    return true;
+}
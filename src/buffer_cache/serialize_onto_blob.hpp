@@ -11,6 +11,13 @@
 void write_onto_blob(buf_parent_t parent, blob_t *blob,
                      const write_message_t &wm);
 
+// Like `write_onto_blob`, but for when `wm` is exactly as long as the blob already is:
+// the blob keeps its blocks, and only the blocks whose contents actually change are
+// acquired for write, so they are the only ones that get written back to disk. Returns
+// false without touching the blob if the sizes differ.
+bool patch_blob_in_place(buf_parent_t parent, blob_t *blob,
+                         const write_message_t &wm);
+
 template <cluster_version_t W, class T>
 void serialize_onto_blob(buf_parent_t parent, blob_t *blob,
                          const T &value) {
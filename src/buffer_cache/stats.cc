@@ -11,6 +11,13 @@ alt_cache_stats_t::alt_cache_stats_t(alt::page_cache_t *_page_cache,
     in_use_bytes(this),
     in_use_bytes_membership(&cache_collection,
                             &in_use_bytes, "in_use_bytes"),
+    page_cache_stats_membership(&cache_collection,
+        &page_cache->evicter().stats()->hits_total, "hits_total",
+        &page_cache->evicter().stats()->misses_total, "misses_total",
+        &page_cache->evicter().stats()->misses_per_sec, "misses_per_sec",
+        &page_cache->evicter().stats()->evictions_total, "evictions_total",
+        &page_cache->evicter().stats()->evictions_per_sec, "evictions_per_sec",
+        &page_cache->evicter().stats()->miss_latency, "miss_latency"),
     cache_collection_membership(&cache_collection) { }
 
 alt_cache_stats_t::perfmon_value_t::perfmon_value_t(alt_cache_stats_t *_parent) :
@@ -28,6 +28,8 @@ public:
     perfmon_value_t in_use_bytes;
     perfmon_membership_t in_use_bytes_membership;
 
+    // The counters in `page_cache->evicter().stats()`.
+    perfmon_multi_membership_t page_cache_stats_membership;
 
     perfmon_multi_membership_t cache_collection_membership;
 };
@@ -22,6 +22,18 @@ struct flush_interval_t {
     int64_t millis;
 };
 
+// How the cache balancer treats one cache relative to the others.  A cache's share
+// of the total cache size follows how much it has been loading from disk, scaled by
+// `weight`, and is then kept between `min_size` and `max_size` bytes as far as the
+// total cache size allows.
+struct cache_balancer_policy_t {
+    cache_balancer_policy_t() : weight(1.0), min_size(0), max_size(UINT64_MAX) { }
+
+    double weight;
+    uint64_t min_size;
+    uint64_t max_size;
+};
+
 typedef uint32_t block_magic_comparison_t;
 
 struct block_magic_t {
@@ -99,6 +99,10 @@ RT_CXXFLAGS += "-DRAPIDJSON_HAS_STDSTRING"
 # Set RapidJSON to exact double parsing mode
 RT_CXXFLAGS += "-DRAPIDJSON_PARSE_DEFAULT_FLAGS=kParseFullPrecisionFlag"
 
+ifeq ($(SIMD_JSON),1)
+  RT_CXXFLAGS += -DRAPIDJSON_SSE42 -msse4.2
+endif
+
 # Force 64-bit off_t size on Linux -- also, sizeof(off_t) will be
 # checked by a compile-time assertion.
 ifeq ($(OS),Linux)
@@ -211,6 +215,10 @@ ifeq ($(NO_EPOLL),1)
   RT_CXXFLAGS += -DNO_EPOLL
 endif
 
+ifeq ($(IO_URING_EVENT_QUEUE),1)
+  RT_CXXFLAGS += -DIO_URING_EVENT_QUEUE
+endif
+
 ifeq ($(THREADED_COROUTINES),1)
   RT_CXXFLAGS += -DTHREADED_COROUTINES
 endif
@@ -230,6 +238,10 @@ ifeq ($(FULL_PERFMON),1)
   RT_CXXFLAGS += -DFULL_PERFMON
 endif
 
+ifeq ($(FAULT_INJECTION),1)
+  RT_CXXFLAGS += -DFAULT_INJECTION
+endif
+
 ifeq ($(CORO_PROFILING),1)
   RT_CXXFLAGS += -DENABLE_CORO_PROFILER
 endif
@@ -244,7 +256,8 @@ RT_CXXFLAGS += -I$(PROTO_DIR)
 
 SOURCES := $(shell find $(SOURCE_DIR) -name '*.cc' -not -name '\.*')
 
-SERVER_EXEC_SOURCES := $(filter-out $(SOURCE_DIR)/unittest/%,$(SOURCES))
+SERVER_EXEC_SOURCES := $(filter-out $(SOURCE_DIR)/unittest/% $(SOURCE_DIR)/benchmark/%,$(SOURCES))
+BENCHMARK_SOURCES := $(filter $(SOURCE_DIR)/benchmark/%,$(SOURCES))
 
 QL2_PROTO_NAMES := rdb_protocol/ql2
 QL2_PROTO_SOURCES := $(foreach _,$(QL2_PROTO_NAMES),$(SOURCE_DIR)/$_.proto)
@@ -268,10 +281,12 @@ OBJS := $(QL2_PROTO_OBJS) $(patsubst %,$(OBJ_DIR)/%.o,$(NAMES))
 
 SERVER_EXEC_OBJS := $(OBJ_DIR)/web_assets/web_assets.o $(QL2_PROTO_OBJS) $(patsubst $(SOURCE_DIR)/%.cc,$(OBJ_DIR)/%.o,$(SERVER_EXEC_SOURCES))
 
-SERVER_NOMAIN_OBJS := $(OBJ_DIR)/web_assets/web_assets.o $(QL2_PROTO_OBJS) $(patsubst $(SOURCE_DIR)/%.cc,$(OBJ_DIR)/%.o,$(filter-out %/main.cc,$(SOURCES)))
+SERVER_NOMAIN_OBJS := $(OBJ_DIR)/web_assets/web_assets.o $(QL2_PROTO_OBJS) $(patsubst $(SOURCE_DIR)/%.cc,$(OBJ_DIR)/%.o,$(filter-out %/main.cc $(BENCHMARK_SOURCES),$(SOURCES)))
 
 SERVER_UNIT_TEST_OBJS := $(SERVER_NOMAIN_OBJS) $(OBJ_DIR)/unittest/main.o
 
+SERVER_BENCHMARK_OBJS := $(filter-out $(OBJ_DIR)/main.o,$(SERVER_EXEC_OBJS)) $(patsubst $(SOURCE_DIR)/%.cc,$(OBJ_DIR)/%.o,$(BENCHMARK_SOURCES))
+
 ##### Version number handling
 
 RT_CXXFLAGS += -DRETHINKDB_VERSION=\"$(RETHINKDB_VERSION)\"
@@ -284,7 +299,7 @@ ALL += $(SOURCE_DIR)
 $(SOURCE_DIR)/all: $(BUILD_DIR)/$(SERVER_EXEC_NAME) $(BUILD_DIR)/$(GDB_FUNCTIONS_NAME) | $(BUILD_DIR)/.
 
 ifeq ($(UNIT_TESTS),1)
-  $(SOURCE_DIR)/all: $(BUILD_DIR)/$(SERVER_UNIT_TEST_NAME)
+  $(SOURCE_DIR)/all: $(BUILD_DIR)/$(SERVER_UNIT_TEST_NAME) $(BUILD_DIR)/$(SERVER_BENCHMARK_NAME)
 endif
 
 .PHONY: unit
@@ -292,6 +307,11 @@ unit: $(BUILD_DIR)/$(SERVER_UNIT_TEST_NAME)
 	$P RUN $(SERVER_UNIT_TEST_NAME)
 	$(BUILD_DIR)/$(SERVER_UNIT_TEST_NAME) --gtest_filter=$(UNIT_TEST_FILTER)
 
+.PHONY: bench
+bench: $(BUILD_DIR)/$(SERVER_BENCHMARK_NAME)
+	$P RUN $(SERVER_BENCHMARK_NAME)
+	$(BUILD_DIR)/$(SERVER_BENCHMARK_NAME) --filter=$(BENCHMARK_FILTER)
+
 .PRECIOUS: $(PROTO_DIR)/. $(QL2_PROTO_HEADERS) $(QL2_PROTO_CODE)
 
 $(PROTO_DIR)/%.pb.h $(PROTO_DIR)/%.pb.cc: $(SOURCE_DIR)/%.proto $(PROTOC_BIN_DEP) | $(PROTO_DIR)/.
@@ -361,6 +381,10 @@ $(BUILD_DIR)/$(SERVER_UNIT_TEST_NAME): $(SERVER_UNIT_TEST_OBJS) $(GTEST_LIBS_DEP
 	$P LD $@
 	$(RT_CXX) $(SERVER_UNIT_TEST_OBJS) $(RT_LDFLAGS) $(GTEST_LIBS) -o $@ $(LD_OUTPUT_FILTER)
 
+$(BUILD_DIR)/$(SERVER_BENCHMARK_NAME): $(SERVER_BENCHMARK_OBJS) | $(BUILD_DIR)/. $(RETHINKDB_DEPENDENCIES_LIBS)
+	$P LD $@
+	$(RT_CXX) $(SERVER_BENCHMARK_OBJS) $(RT_LDFLAGS) -o $@ $(LD_OUTPUT_FILTER)
+
 $(BUILD_DIR)/$(GDB_FUNCTIONS_NAME): | $(BUILD_DIR)/.
 	$P CP $@
 	cp $(SCRIPTS_DIR)/$(GDB_FUNCTIONS_NAME) $@
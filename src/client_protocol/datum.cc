@@ -0,0 +1,83 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "client_protocol/datum.hpp"
+
+#include <vector>
+
+#include "arch/io/network.hpp"
+#include "client_protocol/json.hpp"
+#include "client_protocol/protocols.hpp"
+#include "containers/archive/archive.hpp"
+#include "rdb_protocol/query_params.hpp"
+#include "rdb_protocol/rdb_backtrace.hpp"
+#include "rdb_protocol/response.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
+
+scoped_ptr_t<ql::query_params_t> datum_protocol_t::parse_query(
+        tcp_conn_t *conn,
+        signal_t *interruptor,
+        ql::query_cache_t *query_cache) {
+    return json_protocol_t::parse_query(
+        conn, interruptor, query_cache, &datum_protocol_t::send_response);
+}
+
+// The same fields as in the JSON encoding.
+ql::datum_t response_to_datum(const ql::response_t &response) {
+    ql::datum_object_builder_t builder;
+    builder.overwrite("t", ql::datum_t(static_cast<double>(response.type())));
+    if (response.type() == Response::RUNTIME_ERROR && response.error_type()) {
+        builder.overwrite(
+            "e", ql::datum_t(static_cast<double>(*response.error_type())));
+    }
+    builder.overwrite(
+        "r",
+        ql::datum_t(std::vector<ql::datum_t>(response.data()),
+                    ql::datum_t::no_array_size_limit_check_t()));
+    if (response.backtrace()) {
+        builder.overwrite("b", *response.backtrace());
+    }
+    if (response.profile()) {
+        builder.overwrite("p", *response.profile());
+    }
+    if (response.type() == Response::SUCCESS_PARTIAL ||
+        response.type() == Response::SUCCESS_SEQUENCE) {
+        std::vector<ql::datum_t> notes;
+        for (const auto &note : response.notes()) {
+            notes.push_back(ql::datum_t(static_cast<double>(note)));
+        }
+        builder.overwrite(
+            "n",
+            ql::datum_t(std::move(notes), ql::datum_t::no_array_size_limit_check_t()));
+    }
+    return std::move(builder).to_datum();
+}
+
+void datum_protocol_t::send_response(ql::response_t *response,
+                                     int64_t token,
+                                     tcp_conn_t *conn,
+                                     signal_t *interruptor) {
+    write_message_t wm;
+    ql::datum_serialize(&wm, response_to_datum(*response),
+                        ql::check_datum_serialization_errors_t::NO);
+    size_t payload_size = wm.size();
+
+    if (payload_size >= wire_protocol_t::TOO_LARGE_RESPONSE_SIZE) {
+        response->fill_error(Response::RUNTIME_ERROR,
+                             Response::RESOURCE_LIMIT,
+                             wire_protocol_t::too_large_response_message(payload_size),
+                             ql::backtrace_registry_t::EMPTY_BACKTRACE);
+        send_response(response, token, conn, interruptor);
+        return;
+    }
+
+    uint32_t data_size = static_cast<uint32_t>(payload_size);
+#ifdef __s390x__
+    token = __builtin_bswap64(token);
+    data_size = __builtin_bswap32(data_size);
+#endif
+    conn->write_buffered(&token, sizeof(token), interruptor);
+    conn->write_buffered(&data_size, sizeof(data_size), interruptor);
+    intrusive_list_t<write_buffer_t> *buffers = wm.unsafe_expose_buffers();
+    for (write_buffer_t *p = buffers->head(); p != nullptr; p = buffers->next(p)) {
+        conn->write_buffered(p->data, p->size, interruptor);
+    }
+}
@@ -0,0 +1,35 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CLIENT_PROTOCOL_DATUM_HPP_
+#define CLIENT_PROTOCOL_DATUM_HPP_
+
+#include <stdint.h>
+
+#include "arch/types.hpp"
+#include "containers/scoped.hpp"
+
+class signal_t;
+
+namespace ql {
+class response_t;
+class query_cache_t;
+class query_params_t;
+}
+
+// Queries are read as JSON like with `json_protocol_t`, but responses are sent in
+// the datum serialization format (see `datum_serialize`) instead of being encoded
+// as JSON. Clients ask for it with `protocol_version` 1 in the V1_0 handshake.
+class datum_protocol_t {
+public:
+    static scoped_ptr_t<ql::query_params_t> parse_query(tcp_conn_t *conn,
+                                                        signal_t *interruptor,
+                                                        ql::query_cache_t *query_cache);
+
+    // Like `json_protocol_t::send_response()`, this leaves the response in `conn`'s
+    // write buffer for the caller to flush.
+    static void send_response(ql::response_t *response,
+                              int64_t token,
+                              tcp_conn_t *conn,
+                              signal_t *interruptor);
+};
+
+#endif // CLIENT_PROTOCOL_DATUM_HPP_
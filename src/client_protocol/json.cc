@@ -1,10 +1,12 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "client_protocol/json.hpp"
 
+#include <vector>
+
 #include "arch/io/network.hpp"
 #include "arch/timing.hpp"
 #include "client_protocol/protocols.hpp"
-#include "concurrency/pmap.hpp"
+#include "concurrency/spread_across_threads.hpp"
 #include "containers/scoped.hpp"
 #include "rapidjson/document.h"
 #include "rapidjson/stringbuffer.h"
@@ -48,7 +50,8 @@ scoped_ptr_t<ql::query_params_t> json_protocol_t::parse_query_from_buffer(
 scoped_ptr_t<ql::query_params_t> json_protocol_t::parse_query(
         tcp_conn_t *conn,
         signal_t *interruptor,
-        ql::query_cache_t *query_cache) {
+        ql::query_cache_t *query_cache,
+        void (*send_error)(ql::response_t *, int64_t, tcp_conn_t *, signal_t *)) {
     int64_t token;
     uint32_t size;
     conn->read_buffered(&token, sizeof(token), interruptor);
@@ -75,7 +78,8 @@ scoped_ptr_t<ql::query_params_t> json_protocol_t::parse_query(
             conn->pop(size, &pop_interruptor);
         }
 
-        send_response(&error, token, conn, interruptor);
+        send_error(&error, token, conn, interruptor);
+        conn->flush_buffer(interruptor);
         throw tcp_conn_read_closed_exc_t();
     }
 
@@ -91,13 +95,21 @@ scoped_ptr_t<ql::query_params_t> json_protocol_t::parse_query(
         parse_query_from_buffer(std::move(data), 0, query_cache, token, &error);
 
     if (!res.has()) {
-        send_response(&error, token, conn, interruptor);
+        send_error(&error, token, conn, interruptor);
+        conn->flush_buffer(interruptor);
     }
     return res;
 }
 
+/* Serializes `response` into `buffer_out`. If `rows_out` is given, large responses
+leave their rows out of `buffer_out`: they are serialized in chunks, each into its own
+buffer holding a JSON array of consecutive rows, and the rows belong at
+`*rows_offset_out`. That way they don't have to be copied into one big buffer before
+they're sent. */
 void write_response_internal(ql::response_t *response,
                              rapidjson::StringBuffer *buffer_out,
+                             std::vector<rapidjson::StringBuffer> *rows_out,
+                             size_t *rows_offset_out,
                              bool throw_errors) {
     rapidjson::Writer<rapidjson::StringBuffer> writer(*buffer_out);
     size_t start_offset = buffer_out->GetSize();
@@ -116,37 +128,35 @@ void write_response_internal(ql::response_t *response,
         writer.StartArray();
         const size_t PARALLELIZATION_THRESHOLD = 500;
         if (response->data().size() > PARALLELIZATION_THRESHOLD) {
-            int64_t num_threads = std::min<int64_t>(16, get_num_db_threads());
-            int32_t thread_offset = get_thread_id().threadnum;
-            std::vector<rapidjson::StringBuffer> buffers(num_threads);
-
-            size_t per_thread = response->data().size() / num_threads;
-            pmap(num_threads, [&](int64_t m) {
-                    int32_t target_thread =
-                        (thread_offset + static_cast<int32_t>(m)) % get_num_db_threads();
-                    on_thread_t rethreader((threadnum_t(target_thread)));
-                    rapidjson::StringBuffer *thread_buffer = &buffers[m];
+            // Each chunk is serialized into its own buffer by whichever thread gets to
+            // it first, and then we splice the buffers together in order.
+            const size_t CHUNK_SIZE = 1000;
+            const size_t num_chunks =
+                (response->data().size() + CHUNK_SIZE - 1) / CHUNK_SIZE;
+            std::vector<rapidjson::StringBuffer> buffers(num_chunks);
+
+            spread_across_threads(num_chunks, 16, [&](size_t chunk) {
                     rapidjson::Writer<rapidjson::StringBuffer>
-                        thread_writer(*thread_buffer);
+                        thread_writer(buffers[chunk]);
 
                     thread_writer.StartArray();
-                    size_t offset = per_thread * m;
-                    size_t end = (m == num_threads - 1) ?
-                        response->data().size() : (per_thread * (m + 1));
-
-                    for (size_t i = offset; i < end; ++i) {
-                        const size_t YIELD_INTERVAL = 2000;
-                        if ((i + 1) % YIELD_INTERVAL == 0) {
-                            coro_t::yield();
-                        }
+                    size_t end = std::min(response->data().size(),
+                                          CHUNK_SIZE * (chunk + 1));
+                    for (size_t i = CHUNK_SIZE * chunk; i < end; ++i) {
                         response->data()[i].write_json(&thread_writer);
                     }
-
                     thread_writer.EndArray();
                 });
 
-            for (const auto &buffer : buffers) {
-                writer.SpliceArray(buffer);
+            if (rows_out != nullptr) {
+                *rows_offset_out = buffer_out->GetSize();
+                for (auto &buffer : buffers) {
+                    rows_out->push_back(std::move(buffer));
+                }
+            } else {
+                for (const auto &buffer : buffers) {
+                    writer.SpliceArray(buffer);
+                }
             }
         } else {
             for (const auto &item : response->data()) {
@@ -175,32 +185,45 @@ void write_response_internal(ql::response_t *response,
         guarantee(writer.IsComplete());
     } catch (const ql::base_exc_t &ex) {
         buffer_out->Pop(buffer_out->GetSize() - start_offset);
+        if (rows_out != nullptr) {
+            rows_out->clear();
+        }
         response->fill_error(Response::RUNTIME_ERROR, Response::QUERY_LOGIC,
                              ex.what(), ql::backtrace_registry_t::EMPTY_BACKTRACE);
-        write_response_internal(response, buffer_out, true);
+        write_response_internal(response, buffer_out, rows_out, rows_offset_out, true);
     } catch (const std::exception &ex) {
         if (throw_errors) {
             throw;
         }
 
         buffer_out->Pop(buffer_out->GetSize() - start_offset);
+        if (rows_out != nullptr) {
+            rows_out->clear();
+        }
         response->fill_error(Response::RUNTIME_ERROR, Response::INTERNAL,
             strprintf("Internal error in json_protocol_t::write: %s", ex.what()),
             ql::backtrace_registry_t::EMPTY_BACKTRACE);
-        write_response_internal(response, buffer_out, true);
+        write_response_internal(response, buffer_out, rows_out, rows_offset_out, true);
     }
 }
 
 // Small wrapper - in debug mode we would rather crash than send the error back
-void json_protocol_t::write_response_to_buffer(ql::response_t *response,
-                                               rapidjson::StringBuffer *buffer_out) {
+void write_response_checked(ql::response_t *response,
+                            rapidjson::StringBuffer *buffer_out,
+                            std::vector<rapidjson::StringBuffer> *rows_out,
+                            size_t *rows_offset_out) {
 #ifdef NDEBUG
-    write_response_internal(response, buffer_out, false);
+    write_response_internal(response, buffer_out, rows_out, rows_offset_out, false);
 #else
-    write_response_internal(response, buffer_out, true);
+    write_response_internal(response, buffer_out, rows_out, rows_offset_out, true);
 #endif
 }
 
+void json_protocol_t::write_response_to_buffer(ql::response_t *response,
+                                               rapidjson::StringBuffer *buffer_out) {
+    write_response_checked(response, buffer_out, nullptr, nullptr);
+}
+
 void json_protocol_t::send_response(ql::response_t *response,
                                     int64_t token,
                                     tcp_conn_t *conn,
@@ -212,8 +235,15 @@ void json_protocol_t::send_response(ql::response_t *response,
     rapidjson::StringBuffer buffer;
     buffer.Push(prefix_size);
 
-    write_response_to_buffer(response, &buffer);
+    std::vector<rapidjson::StringBuffer> rows;
+    size_t rows_offset = 0;
+    write_response_checked(response, &buffer, &rows, &rows_offset);
     int64_t payload_size = buffer.GetSize() - prefix_size;
+    for (size_t i = 0; i < rows.size(); ++i) {
+        // The rows without their square brackets, and a comma before every chunk
+        // but the first.
+        payload_size += rows[i].GetSize() - 2 + (i == 0 ? 0 : 1);
+    }
     guarantee(payload_size > 0);
 
     static_assert(std::is_same<decltype(wire_protocol_t::TOO_LARGE_RESPONSE_SIZE),
@@ -247,6 +277,23 @@ void json_protocol_t::send_response(ql::response_t *response,
             reinterpret_cast<const char *>(&data_size)[i];
     }
 
-    conn->write(buffer.GetString(), buffer.GetSize(), interruptor);
-}
+    if (rows.empty()) {
+        conn->write_buffered(buffer.GetString(), buffer.GetSize(), interruptor);
+        return;
+    }
 
+    // Everything up to the rows and each comma go into the connection's write
+    // buffer, and out together with the next chunk of rows, which we write without
+    // copying it. Each chunk is freed as soon as it's been sent.
+    conn->write_buffered(buffer.GetString(), rows_offset, interruptor);
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (i != 0) {
+            conn->write_buffered(",", 1, interruptor);
+        }
+        conn->write(rows[i].GetString() + 1, rows[i].GetSize() - 2, interruptor);
+        rows[i] = rapidjson::StringBuffer();
+    }
+    conn->write_buffered(buffer.GetString() + rows_offset,
+                         buffer.GetSize() - rows_offset,
+                         interruptor);
+}
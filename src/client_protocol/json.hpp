@@ -25,14 +25,21 @@ public:
             ql::query_cache_t *query_cache, int64_t token,
             ql::response_t *error_out);
 
-    static scoped_ptr_t<ql::query_params_t> parse_query(tcp_conn_t *conn,
-                                                        signal_t *interruptor,
-                                                        ql::query_cache_t *query_cache);
+    // Errors in reading the query are reported with `send_error`, so that protocols
+    // that only differ in how they encode responses can share this.
+    static scoped_ptr_t<ql::query_params_t> parse_query(
+            tcp_conn_t *conn,
+            signal_t *interruptor,
+            ql::query_cache_t *query_cache,
+            void (*send_error)(ql::response_t *, int64_t, tcp_conn_t *, signal_t *)
+                = &json_protocol_t::send_response);
 
     // Used by the HTTP ReQL server to write the query response into the HTTP response
     static void write_response_to_buffer(ql::response_t *response,
                                          rapidjson::StringBuffer *buffer_out);
 
+    // Puts the response into `conn`'s write buffer. It isn't necessarily sent until
+    // the caller flushes the buffer, so that several responses can go out together.
     static void send_response(ql::response_t *response,
                               int64_t token,
                               tcp_conn_t *conn,
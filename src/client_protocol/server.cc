@@ -19,6 +19,7 @@
 #include "arch/arch.hpp"
 #include "arch/io/network.hpp"
 #include "client_protocol/client_server_error.hpp"
+#include "client_protocol/datum.hpp"
 #include "client_protocol/protocols.hpp"
 #include "clustering/administration/auth/authentication_error.hpp"
 #include "clustering/administration/auth/plaintext_authenticator.hpp"
@@ -43,22 +44,26 @@
 #include "rdb_protocol/query_cache.hpp"
 #include "rdb_protocol/response.hpp"
 
-http_conn_cache_t::http_conn_t::http_conn_t(rdb_context_t *rdb_ctx,
-                                            ip_and_port_t client_addr_port) :
+http_conn_cache_t::http_conn_t::http_conn_t(rdb_context_t *_rdb_ctx,
+                                            ip_and_port_t _client_addr_port) :
+    rdb_ctx(_rdb_ctx),
+    client_addr_port(_client_addr_port),
     last_accessed(time(nullptr)),
-    // We always return empty normal batches after the timeout for HTTP
-    // connections; I think we have to do this to keep the conn cache
-    // from timing out.
-    query_cache(
-        new ql::query_cache_t(
-            rdb_ctx,
-            client_addr_port,
-            ql::return_empty_normal_batches_t::YES,
-            auth::user_context_t(auth::username_t("admin")))),
-    counter(&rdb_ctx->stats.client_connections) { }
+    counter(&_rdb_ctx->stats.client_connections) { }
 
 ql::query_cache_t *http_conn_cache_t::http_conn_t::get_query_cache() {
     last_accessed = time(nullptr);
+    if (!query_cache.has()) {
+        // We always return empty normal batches after the timeout for HTTP
+        // connections; I think we have to do this to keep the conn cache
+        // from timing out.
+        query_cache.init(
+            new ql::query_cache_t(
+                rdb_ctx,
+                client_addr_port,
+                ql::return_empty_normal_batches_t::YES,
+                auth::user_context_t(auth::username_t("admin"))));
+    }
     return query_cache.get();
 }
 
@@ -196,13 +201,11 @@ query_server_t::query_server_t(rdb_context_t *_rdb_ctx,
         tls_ctx(_tls_ctx),
         rdb_ctx(_rdb_ctx),
         handler(_handler),
-        http_conn_cache(http_timeout_sec),
-        next_thread(0) {
+        http_conn_cache(http_timeout_sec) {
     rassert(rdb_ctx != nullptr);
     try {
-        tcp_listener.init(new tcp_listener_t(local_addresses, port,
-            std::bind(&query_server_t::handle_conn,
-                      this, ph::_1, auto_drainer_t::lock_t(&drainer))));
+        tcp_listener.init(new threaded_tcp_listener_t(local_addresses, port,
+            std::bind(&query_server_t::handle_conn, this, ph::_1)));
     } catch (const address_in_use_exc_t &ex) {
         throw address_in_use_exc_t(
             strprintf("Could not bind to RDB protocol port: %s", ex.what()));
@@ -250,18 +253,15 @@ ql::datum_t read_datum(tcp_conn_t *connection, signal_t *interruptor) {
     }
 }
 
-void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &nconn,
-                                 auto_drainer_t::lock_t keepalive) {
-    threadnum_t chosen_thread = threadnum_t(next_thread);
-    next_thread = (next_thread + 1) % get_num_db_threads();
-
-    cross_thread_signal_t ct_keepalive(keepalive.get_drain_signal(), chosen_thread);
-    on_thread_t rethreader(chosen_thread);
+void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &nconn) {
+    // We're already on the thread that the connection will be running on
+    auto_drainer_t::lock_t keepalive(conn_drainers.get());
+    signal_t *drain_signal = keepalive.get_drain_signal();
 
     scoped_ptr_t<tcp_conn_t> conn;
 
     try {
-        nconn->make_server_connection(tls_ctx, &conn, &ct_keepalive);
+        nconn->make_server_connection(tls_ctx, &conn, drain_signal);
     } catch (const interrupted_exc_t &) {
         // TLS handshake was interrupted.
         return;
@@ -273,6 +273,7 @@ void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &ncon
 
     uint8_t version = 0;
     std::unique_ptr<auth::base_authenticator_t> authenticator;
+    bool datum_responses = false;
     uint32_t error_code = 0;
     std::string error_message;
     try {
@@ -280,7 +281,7 @@ void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &ncon
 
         int32_t client_magic_number;
         conn->read_buffered(
-            &client_magic_number, sizeof(client_magic_number), &ct_keepalive);
+            &client_magic_number, sizeof(client_magic_number), drain_signal);
 #ifdef __s390x__
         client_magic_number = __builtin_bswap32(client_magic_number);
 #endif
@@ -318,7 +319,7 @@ void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &ncon
                 new auth::plaintext_authenticator_t(rdb_ctx->get_auth_watchable()));
 
             uint32_t auth_key_size;
-            conn->read_buffered(&auth_key_size, sizeof(uint32_t), &ct_keepalive);
+            conn->read_buffered(&auth_key_size, sizeof(uint32_t), drain_signal);
 #ifdef __s390x__
             auth_key_size = __builtin_bswap32(auth_key_size);
 #endif
@@ -328,7 +329,7 @@ void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &ncon
             }
 
             scoped_array_t<char> auth_key_buffer(auth_key_size);
-            conn->read_buffered(auth_key_buffer.data(), auth_key_size, &ct_keepalive);
+            conn->read_buffered(auth_key_buffer.data(), auth_key_size, drain_signal);
 
             try {
                 authenticator->next_message(
@@ -340,7 +341,7 @@ void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &ncon
             }
 
             int32_t wire_protocol;
-            conn->read_buffered(&wire_protocol, sizeof(wire_protocol), &ct_keepalive);
+            conn->read_buffered(&wire_protocol, sizeof(wire_protocol), drain_signal);
 #ifdef __s390x__
             wire_protocol = __builtin_bswap32(wire_protocol);
 #endif
@@ -359,7 +360,7 @@ void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &ncon
             }
 
             char const *success_msg = "SUCCESS";
-            conn->write(success_msg, strlen(success_msg) + 1, &ct_keepalive);
+            conn->write(success_msg, strlen(success_msg) + 1, drain_signal);
         } else {
             authenticator.reset(
                 new auth::scram_authenticator_t(rdb_ctx->get_auth_watchable()));
@@ -367,7 +368,7 @@ void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &ncon
             {
                 ql::datum_object_builder_t datum_object_builder;
                 datum_object_builder.overwrite("success", ql::datum_t::boolean(true));
-                datum_object_builder.overwrite("max_protocol_version", ql::datum_t(0.0));
+                datum_object_builder.overwrite("max_protocol_version", ql::datum_t(1.0));
                 datum_object_builder.overwrite("min_protocol_version", ql::datum_t(0.0));
                 datum_object_builder.overwrite(
                     "server_version", ql::datum_t(RETHINKDB_VERSION));
@@ -375,11 +376,11 @@ void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &ncon
                 write_datum(
                     conn.get(),
                     std::move(datum_object_builder).to_datum(),
-                    &ct_keepalive);
+                    drain_signal);
             }
 
             {
-                ql::datum_t datum = read_datum(conn.get(), &ct_keepalive);
+                ql::datum_t datum = read_datum(conn.get(), drain_signal);
 
                 ql::datum_t protocol_version =
                     datum.get_field("protocol_version", ql::NOTHROW);
@@ -387,7 +388,10 @@ void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &ncon
                     throw client_protocol::client_server_error_t(
                         1, "Expected a number for `protocol_version`.");
                 }
-                if (protocol_version.as_num() != 0.0) {
+                if (protocol_version.as_num() == 1.0) {
+                    // Responses in the datum serialization format rather than JSON
+                    datum_responses = true;
+                } else if (protocol_version.as_num() != 0.0) {
                     throw client_protocol::client_server_error_t(
                         2, "Unsupported `protocol_version`.");
                 }
@@ -420,11 +424,11 @@ void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &ncon
                 write_datum(
                     conn.get(),
                     std::move(datum_object_builder).to_datum(),
-                    &ct_keepalive);
+                    drain_signal);
             }
 
             {
-                ql::datum_t datum = read_datum(conn.get(), &ct_keepalive);
+                ql::datum_t datum = read_datum(conn.get(), drain_signal);
 
                 ql::datum_t authentication =
                     datum.get_field("authentication", ql::NOTHROW);
@@ -443,7 +447,7 @@ void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &ncon
                 write_datum(
                     conn.get(),
                     std::move(datum_object_builder).to_datum(),
-                    &ct_keepalive);
+                    drain_signal);
             }
         }
 
@@ -459,13 +463,18 @@ void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &ncon
                 : ql::return_empty_normal_batches_t::NO,
             auth::user_context_t(authenticator->get_authenticated_username()));
 
-        connection_loop<json_protocol_t>(
-            conn.get(),
-            (version < 4)
-                ? 1
-                : 1024,
-            &query_cache,
-            &ct_keepalive);
+        if (datum_responses) {
+            connection_loop<datum_protocol_t>(
+                conn.get(), 1024, &query_cache, drain_signal);
+        } else {
+            connection_loop<json_protocol_t>(
+                conn.get(),
+                (version < 4)
+                    ? 1
+                    : 1024,
+                &query_cache,
+                drain_signal);
+        }
     } catch (client_protocol::client_server_error_t const &error) {
         // We can't write the response here due to coroutine switching inside an
         // exception handler
@@ -494,7 +503,7 @@ void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &ncon
         try {
             if (version < 10) {
                 std::string error = "ERROR: " + error_message + "\n";
-                conn->write(error.c_str(), error.length() + 1, &ct_keepalive);
+                conn->write(error.c_str(), error.length() + 1, drain_signal);
             } else {
                 ql::datum_object_builder_t datum_object_builder;
                 datum_object_builder.overwrite("success", ql::datum_t::boolean(false));
@@ -505,7 +514,7 @@ void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &ncon
                 write_datum(
                     conn.get(),
                     std::move(datum_object_builder).to_datum(),
-                    &ct_keepalive);
+                    drain_signal);
             }
 
             conn->shutdown_write();
@@ -578,6 +587,29 @@ void query_server_t::connection_loop(tcp_conn_t *conn,
     wait_any_t interruptor(drain_signal, &abort);
 #endif  // __linux
 
+    /* Responses only go into the connection's write buffer, and the last of the
+    coroutines sending a response at the time flushes it. So when many queries finish
+    at about the same time, their responses go out in a few large writes instead of
+    one write each. Responses are sent as their queries finish, in any order. */
+    size_t senders = 0;
+    auto send_response = [&](ql::response_t *response,
+                             int64_t token,
+                             signal_t *lock_interruptor,
+                             signal_t *send_interruptor) {
+        ++senders;
+        try {
+            new_mutex_acq_t send_lock(&send_mutex, lock_interruptor);
+            protocol_t::send_response(response, token, conn, send_interruptor);
+            if (senders == 1) {
+                conn->flush_buffer(send_interruptor);
+            }
+        } catch (...) {
+            --senders;
+            throw;
+        }
+        --senders;
+    };
+
     new_semaphore_t sem(max_concurrent_queries);
     auto_drainer_t coro_drainer;
     while (!err) {
@@ -600,9 +632,8 @@ void query_server_t::connection_loop(tcp_conn_t *conn,
                 save_exception(&err, &err_str, &abort, [&]() {
                     handler->run_query(query.get(), &response, &cb_interruptor);
                     if (!query->noreply) {
-                        new_mutex_acq_t send_lock(&send_mutex, &cb_interruptor);
-                        protocol_t::send_response(&response, query->token,
-                                                  conn, &cb_interruptor);
+                        send_response(&response, query->token,
+                                      &cb_interruptor, &cb_interruptor);
                         replied = true;
                     }
                 });
@@ -610,9 +641,8 @@ void query_server_t::connection_loop(tcp_conn_t *conn,
                     if (!replied && !query->noreply) {
                         make_error_response(drain_signal->is_pulsed(), *conn,
                                             err_str, &response);
-                        new_mutex_acq_t send_lock(&send_mutex, drain_signal);
-                        protocol_t::send_response(&response, query->token,
-                                                  conn, &cb_interruptor);
+                        send_response(&response, query->token,
+                                      drain_signal, &cb_interruptor);
                     }
                 });
             });
@@ -629,6 +659,27 @@ void query_server_t::connection_loop(tcp_conn_t *conn,
     }
 }
 
+/* Appends `response` to `body_data` with the same framing as on a driver connection
+using the JSON protocol. */
+static void append_http_response(int64_t token,
+                                 ql::response_t *response,
+                                 std::string *body_data) {
+    rapidjson::StringBuffer buffer;
+    json_protocol_t::write_response_to_buffer(response, &buffer);
+
+    uint32_t size = static_cast<uint32_t>(buffer.GetSize());
+#ifdef __s390x__
+    size = __builtin_bswap32(size);
+    token = __builtin_bswap64(token);
+#endif
+    char header_buffer[sizeof(token) + sizeof(size)];
+    memcpy(&header_buffer[0], &token, sizeof(token));
+    memcpy(&header_buffer[sizeof(token)], &size, sizeof(size));
+
+    body_data->append(&header_buffer[0], sizeof(header_buffer));
+    body_data->append(buffer.GetString(), buffer.GetSize());
+}
+
 void query_server_t::handle(const http_req_t &req,
                             http_res_t *result,
                             signal_t *interruptor) {
@@ -659,6 +710,61 @@ void query_server_t::handle(const http_req_t &req,
         return;
     }
 
+    counted_t<http_conn_cache_t::http_conn_t> conn = http_conn_cache.find(conn_id);
+
+    if (req.method == http_method_t::POST &&
+        req.resource.as_string().find("batch") != std::string::npos) {
+        /* A batch holds several queries, each framed like on a driver connection
+        using the JSON protocol: an 8 byte token, a 4 byte length and then the query.
+        They are run one after the other, and the body of the result holds their
+        responses in the same order. This saves clients one HTTP round trip per
+        query. */
+        std::string body_data;
+        size_t pos = 0;
+        while (pos < req.body.size()) {
+            int64_t token;
+            uint32_t size;
+            if (req.body.size() - pos < sizeof(token) + sizeof(size)) {
+                *result = http_res_t(http_status_code_t::BAD_REQUEST, "application/text",
+                                     "Client is buggy (truncated batch).");
+                return;
+            }
+            memcpy(&token, req.body.data() + pos, sizeof(token));
+            memcpy(&size, req.body.data() + pos + sizeof(token), sizeof(size));
+#ifdef __s390x__
+            token = __builtin_bswap64(token);
+            size = __builtin_bswap32(size);
+#endif
+            pos += sizeof(token) + sizeof(size);
+            if (req.body.size() - pos < size) {
+                *result = http_res_t(http_status_code_t::BAD_REQUEST, "application/text",
+                                     "Client is buggy (truncated batch).");
+                return;
+            }
+
+            scoped_array_t<char> query_buf(size + 1);
+            memcpy(query_buf.data(), req.body.data() + pos, size);
+            query_buf[size] = '\0';
+            pos += size;
+
+            ql::response_t response;
+            if (!conn.has()) {
+                response.fill_error(Response::CLIENT_ERROR, Response::INTERNAL,
+                                    "This HTTP connection is not open.",
+                                    ql::backtrace_registry_t::EMPTY_BACKTRACE);
+            } else if (!run_http_query(conn.get(), token, std::move(query_buf), 0,
+                                       interruptor, &response)) {
+                response.fill_error(Response::CLIENT_ERROR, Response::INTERNAL,
+                                    "noreply queries are not supported over HTTP",
+                                    ql::backtrace_registry_t::EMPTY_BACKTRACE);
+            }
+            append_http_response(token, &response, &body_data);
+        }
+        result->set_body("application/octet-stream", body_data);
+        result->code = http_status_code_t::OK;
+        return;
+    }
+
     int64_t token = 0;
     if (req.body.size() < sizeof(token)) {
         *result = http_res_t(http_status_code_t::BAD_REQUEST, "application/text",
@@ -672,99 +778,95 @@ void query_server_t::handle(const http_req_t &req,
     body_buf[req.body.size()] = '\0';
 
     // Parse the token out from the start of the request
-    char *data = body_buf.data();
-    token = *reinterpret_cast<const int64_t *>(data);
+    token = *reinterpret_cast<const int64_t *>(body_buf.data());
 #ifdef __s390x__
     token = __builtin_bswap64(token);
 #endif
-    data += sizeof(token);
 
     ql::response_t response;
-    counted_t<http_conn_cache_t::http_conn_t> conn = http_conn_cache.find(conn_id);
     if (!conn.has()) {
         response.fill_error(Response::CLIENT_ERROR, Response::INTERNAL,
                             "This HTTP connection is not open.",
                             ql::backtrace_registry_t::EMPTY_BACKTRACE);
-    } else {
-        scoped_ptr_t<ql::query_params_t> query =
-            json_protocol_t::parse_query_from_buffer(std::move(body_buf),
-                                                     sizeof(token),
-                                                     conn->get_query_cache(),
-                                                     token,
-                                                     &response);
-
-        if (query.has()) {
-            // Check for noreply, which we don't support here, as it causes
-            // problems with interruption
-            if (query->noreply) {
-                *result = http_res_t(http_status_code_t::BAD_REQUEST,
-                                     "application/text",
-                                     "noreply queries are not supported over HTTP\n");
-                return;
-            }
+    } else if (!run_http_query(conn.get(), token, std::move(body_buf), sizeof(token),
+                               interruptor, &response)) {
+        // Check for noreply, which we don't support here, as it causes
+        // problems with interruption
+        *result = http_res_t(http_status_code_t::BAD_REQUEST,
+                             "application/text",
+                             "noreply queries are not supported over HTTP\n");
+        return;
+    }
 
-            wait_any_t true_interruptor(interruptor, conn->get_interruptor(),
-                                        drainer.get_drain_signal());
+    std::string body_data;
+    append_http_response(token, &response, &body_data);
+    result->set_body("application/octet-stream", body_data);
+    result->code = http_status_code_t::OK;
+}
 
-            try {
-                ticks_t start = get_ticks();
-                // We don't throttle HTTP queries.
-                handler->run_query(query.get(), &response, &true_interruptor);
-                ticks_t ticks = ticks_t{get_ticks().nanos - start.nanos};
-
-                if (!response.profile()) {
-                    ql::datum_array_builder_t array_builder(
-                        ql::configured_limits_t::unlimited);
-                    ql::datum_object_builder_t object_builder;
-                    object_builder.overwrite("duration(ms)",
-                        ql::datum_t(static_cast<double>(ticks.nanos) / MILLION));
-                    array_builder.add(std::move(object_builder).to_datum());
-                    response.set_profile(std::move(array_builder).to_datum());
-                }
-            } catch (const interrupted_exc_t &ex) {
-                if (http_conn_cache.is_expired(*conn)) {
-                    response.fill_error(Response::RUNTIME_ERROR,
-                                        Response::OP_INDETERMINATE,
-                                        http_conn_cache.expired_error_message(),
-                                        ql::backtrace_registry_t::EMPTY_BACKTRACE);
-                } else if (interruptor->is_pulsed()) {
-                    response.fill_error(Response::RUNTIME_ERROR,
-                                        Response::OP_INDETERMINATE,
-                                        "This ReQL connection has been terminated.",
-                                        ql::backtrace_registry_t::EMPTY_BACKTRACE);
-                } else if (drainer.is_draining()) {
-                    response.fill_error(Response::RUNTIME_ERROR,
-                                        Response::OP_INDETERMINATE,
-                                        "Server is shutting down.",
-                                        ql::backtrace_registry_t::EMPTY_BACKTRACE);
-                } else if (conn->get_interruptor()->is_pulsed()) {
-                    response.fill_error(Response::RUNTIME_ERROR,
-                                        Response::OP_INDETERMINATE,
-                                        "This ReQL connection has been terminated.",
-                                        ql::backtrace_registry_t::EMPTY_BACKTRACE);
-                } else {
-                    throw;
-                }
-            }
-        }
+bool query_server_t::run_http_query(http_conn_cache_t::http_conn_t *conn,
+                                    int64_t token,
+                                    scoped_array_t<char> &&buffer,
+                                    size_t offset,
+                                    signal_t *interruptor,
+                                    ql::response_t *response_out) {
+    scoped_ptr_t<ql::query_params_t> query =
+        json_protocol_t::parse_query_from_buffer(std::move(buffer),
+                                                 offset,
+                                                 conn->get_query_cache(),
+                                                 token,
+                                                 response_out);
+    if (!query.has()) {
+        // `parse_query_from_buffer()` has put the error into `response_out`
+        return true;
     }
 
-    rapidjson::StringBuffer buffer;
-    json_protocol_t::write_response_to_buffer(&response, &buffer);
+    if (query->noreply) {
+        return false;
+    }
 
-    uint32_t size = static_cast<uint32_t>(buffer.GetSize());
-#ifdef __s390x__
-    size = __builtin_bswap32(size);
-    token = __builtin_bswap64(token);
-#endif
-    char header_buffer[sizeof(token) + sizeof(size)];
-    memcpy(&header_buffer[0], &token, sizeof(token));
-    memcpy(&header_buffer[sizeof(token)], &size, sizeof(size));
+    wait_any_t true_interruptor(interruptor, conn->get_interruptor(),
+                                drainer.get_drain_signal());
 
-    std::string body_data;
-    body_data.reserve(sizeof(header_buffer) + buffer.GetSize());
-    body_data.append(&header_buffer[0], sizeof(header_buffer));
-    body_data.append(buffer.GetString(), buffer.GetSize());
-    result->set_body("application/octet-stream", body_data);
-    result->code = http_status_code_t::OK;
+    try {
+        ticks_t start = get_ticks();
+        // We don't throttle HTTP queries.
+        handler->run_query(query.get(), response_out, &true_interruptor);
+        ticks_t ticks = ticks_t{get_ticks().nanos - start.nanos};
+
+        if (!response_out->profile()) {
+            ql::datum_array_builder_t array_builder(
+                ql::configured_limits_t::unlimited);
+            ql::datum_object_builder_t object_builder;
+            object_builder.overwrite("duration(ms)",
+                ql::datum_t(static_cast<double>(ticks.nanos) / MILLION));
+            array_builder.add(std::move(object_builder).to_datum());
+            response_out->set_profile(std::move(array_builder).to_datum());
+        }
+    } catch (const interrupted_exc_t &ex) {
+        if (http_conn_cache.is_expired(*conn)) {
+            response_out->fill_error(Response::RUNTIME_ERROR,
+                                     Response::OP_INDETERMINATE,
+                                     http_conn_cache.expired_error_message(),
+                                     ql::backtrace_registry_t::EMPTY_BACKTRACE);
+        } else if (interruptor->is_pulsed()) {
+            response_out->fill_error(Response::RUNTIME_ERROR,
+                                     Response::OP_INDETERMINATE,
+                                     "This ReQL connection has been terminated.",
+                                     ql::backtrace_registry_t::EMPTY_BACKTRACE);
+        } else if (drainer.is_draining()) {
+            response_out->fill_error(Response::RUNTIME_ERROR,
+                                     Response::OP_INDETERMINATE,
+                                     "Server is shutting down.",
+                                     ql::backtrace_registry_t::EMPTY_BACKTRACE);
+        } else if (conn->get_interruptor()->is_pulsed()) {
+            response_out->fill_error(Response::RUNTIME_ERROR,
+                                     Response::OP_INDETERMINATE,
+                                     "This ReQL connection has been terminated.",
+                                     ql::backtrace_registry_t::EMPTY_BACKTRACE);
+        } else {
+            throw;
+        }
+    }
+    return true;
 }
@@ -16,6 +16,7 @@
 #include "arch/timing.hpp"
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/cross_thread_signal.hpp"
+#include "concurrency/one_per_thread.hpp"
 #include "containers/archive/archive.hpp"
 #include "containers/counted.hpp"
 #include "http/http.hpp"
@@ -48,8 +49,12 @@ public:
         time_t last_accessed_time() const;
 
     private:
+        rdb_context_t *rdb_ctx;
+        ip_and_port_t client_addr_port;
         cond_t interruptor;
         time_t last_accessed;
+        /* Created by the first query, so that opening a connection is cheap for
+        clients that never send one. */
         scoped_ptr_t<ql::query_cache_t> query_cache;
         scoped_perfmon_counter_t counter;
         DISABLE_COPYING(http_conn_t);
@@ -115,8 +120,7 @@ private:
                              ql::response_t *response_out);
 
     // For the client driver socket
-    void handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &nconn,
-                     auto_drainer_t::lock_t);
+    void handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &nconn);
 
     // This is templatized based on the wire protocol requested by the client
     template<class protocol_t>
@@ -130,16 +134,26 @@ private:
                 http_res_t *result,
                 signal_t *interruptor);
 
+    /* Runs one query that arrived over HTTP, starting at `offset` in `buffer`. Returns
+    false if the query is a noreply query, which HTTP doesn't support. */
+    bool run_http_query(http_conn_cache_t::http_conn_t *conn,
+                        int64_t token,
+                        scoped_array_t<char> &&buffer,
+                        size_t offset,
+                        signal_t *interruptor,
+                        ql::response_t *response_out);
+
     tls_ctx_t *tls_ctx;
     rdb_context_t *const rdb_ctx;
     query_handler_t *const handler;
 
     /* WARNING: The order here is fragile. */
     auto_drainer_t drainer;
+    /* Driver connections run on the thread that accepted them, so each thread has
+    its own drainer for them. */
+    one_per_thread_t<auto_drainer_t> conn_drainers;
     http_conn_cache_t http_conn_cache;
-    scoped_ptr_t<tcp_listener_t> tcp_listener;
-
-    int next_thread;
+    scoped_ptr_t<threaded_tcp_listener_t> tcp_listener;
 };
 
 #endif /* CLIENT_PROTOCOL_SERVER_HPP_ */
@@ -107,6 +107,8 @@ bool artificial_reql_cluster_interface_t::table_create(
         const table_generate_config_params_t &config_params,
         const std::string &primary_key,
         write_durability_t durability,
+        int cpu_sharding_factor,
+        int block_size,
         signal_t *interruptor,
         ql::datum_t *result_out,
         admin_err_t *error_out) {
@@ -124,6 +126,8 @@ bool artificial_reql_cluster_interface_t::table_create(
         config_params,
         primary_key,
         durability,
+        cpu_sharding_factor,
+        block_size,
         interruptor,
         result_out,
         error_out);
@@ -235,6 +239,32 @@ bool artificial_reql_cluster_interface_t::table_estimate_doc_counts(
     }
 }
 
+bool artificial_reql_cluster_interface_t::table_shard_map(
+        auth::user_context_t const &user_context,
+        counted_t<const ql::db_t> db,
+        const name_string_t &name,
+        ql::env_t *env,
+        ql::datum_t *shard_map_out,
+        admin_err_t *error_out) {
+    if (db->name == artificial_reql_cluster_interface_t::database_name) {
+        if (m_table_backends.find(name) != m_table_backends.end()) {
+            /* System tables aren't sharded, so there's nothing for a driver to route
+            by. */
+            *shard_map_out = ql::datum_t::null();
+            return true;
+        } else {
+            *error_out = admin_err_t{
+                strprintf("Table `%s.%s` does not exist.",
+                          artificial_reql_cluster_interface_t::database_name.c_str(), name.c_str()),
+                query_state_t::FAILED};
+            return false;
+        }
+    } else {
+        return next_or_error(error_out) && m_next->table_shard_map(
+            user_context, db, name, env, shard_map_out, error_out);
+    }
+}
+
 bool artificial_reql_cluster_interface_t::table_config(
         auth::user_context_t const &user_context,
         counted_t<const ql::db_t> db,
@@ -842,6 +872,19 @@ artificial_reql_cluster_backends_t::artificial_reql_cluster_backends_t(
         name_string_t::guarantee_valid("_debug_stats"),
         std::make_pair(debug_stats_backend.get(), debug_stats_backend.get()));
 
+    debug_coro_profile_backend.init(
+        new debug_coro_profile_artificial_table_backend_t(
+            rdb_context,
+            name_resolver,
+            directory_map_view,
+            server_config_client,
+            mailbox_manager));
+    debug_coro_profile_sentry = backend_sentry_t(
+        artificial_reql_cluster_interface->get_table_backends_map_mutable(),
+        name_string_t::guarantee_valid("_debug_coro_profile"),
+        std::make_pair(debug_coro_profile_backend.get(),
+                       debug_coro_profile_backend.get()));
+
     debug_table_status_backend.init(
         new debug_table_status_artificial_table_backend_t(
             rdb_context,
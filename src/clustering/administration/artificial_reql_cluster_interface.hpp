@@ -10,6 +10,7 @@
 #include "clustering/administration/metadata.hpp"
 #include "clustering/administration/servers/server_config.hpp"
 #include "clustering/administration/servers/server_status.hpp"
+#include "clustering/administration/stats/debug_coro_profile_backend.hpp"
 #include "clustering/administration/stats/debug_stats_backend.hpp"
 #include "clustering/administration/stats/stats_backend.hpp"
 #include "clustering/administration/tables/db_config.hpp"
@@ -85,6 +86,8 @@ public:
             const table_generate_config_params_t &config_params,
             const std::string &primary_key,
             write_durability_t durability,
+            int cpu_sharding_factor,
+            int block_size,
             signal_t *interruptor,
             ql::datum_t *result_out,
             admin_err_t *error_out);
@@ -109,6 +112,13 @@ public:
             ql::env_t *env,
             std::vector<int64_t> *doc_counts_out,
             admin_err_t *error_out);
+    bool table_shard_map(
+            auth::user_context_t const &user_context,
+            counted_t<const ql::db_t> db,
+            const name_string_t &name,
+            ql::env_t *env,
+            ql::datum_t *shard_map_out,
+            admin_err_t *error_out);
     bool table_config(
             auth::user_context_t const &user_context,
             counted_t<const ql::db_t> db,
@@ -344,6 +354,9 @@ private:
 
     scoped_ptr_t<debug_stats_artificial_table_backend_t> debug_stats_backend;
     backend_sentry_t debug_stats_sentry;
+    scoped_ptr_t<debug_coro_profile_artificial_table_backend_t>
+        debug_coro_profile_backend;
+    backend_sentry_t debug_coro_profile_sentry;
 
     scoped_ptr_t<debug_table_status_artificial_table_backend_t>
         debug_table_status_backend;
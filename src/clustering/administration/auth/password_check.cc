@@ -0,0 +1,99 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "clustering/administration/auth/password_check.hpp"
+
+#include <array>
+#include <exception>
+
+#include "arch/runtime/thread_pool.hpp"
+#include "arch/spinlock.hpp"
+#include "arch/types.hpp"
+#include "containers/lru_cache.hpp"
+#include "crypto/compare_equal.hpp"
+#include "crypto/hash.hpp"
+#include "crypto/pbkcs5_pbkdf2_hmac.hpp"
+
+namespace auth {
+
+namespace {
+
+struct password_cache_entry_t {
+    std::array<unsigned char, password_t::salt_length> salt;
+    uint32_t iteration_count;
+    std::array<unsigned char, SHA256_DIGEST_LENGTH> hash;
+    std::array<unsigned char, SHA256_DIGEST_LENGTH> fingerprint;
+};
+
+/* The cache is shared by all threads, but it's only held for a lookup or an insert. */
+class password_cache_t {
+public:
+    password_cache_t() : cache(PASSWORD_CACHE_SIZE) { }
+
+    spinlock_t lock;
+    lru_cache_t<username_t, password_cache_entry_t> cache;
+};
+
+password_cache_t *get_password_cache() {
+    static password_cache_t password_cache;
+    return &password_cache;
+}
+
+std::array<unsigned char, SHA256_DIGEST_LENGTH> fingerprint_password(
+        std::string const &password, password_t const &expected) {
+    std::string salted(expected.get_salt().begin(), expected.get_salt().end());
+    salted += password;
+    return crypto::sha256(salted);
+}
+
+}  // namespace
+
+bool check_password(
+        username_t const &username,
+        std::string const &password,
+        password_t const &expected) {
+    std::array<unsigned char, SHA256_DIGEST_LENGTH> fingerprint =
+        fingerprint_password(password, expected);
+
+    password_cache_t *password_cache = get_password_cache();
+    {
+        spinlock_acq_t acq(&password_cache->lock);
+        auto it = password_cache->cache.find(username);
+        if (it != password_cache->cache.end()
+                && it->second.salt == expected.get_salt()
+                && it->second.iteration_count == expected.get_iteration_count()
+                && it->second.hash == expected.get_hash()
+                && crypto::compare_equal(it->second.fingerprint, fingerprint)) {
+            return true;
+        }
+    }
+
+    std::array<unsigned char, SHA256_DIGEST_LENGTH> hash;
+    std::exception_ptr error;
+    thread_pool_t::run_in_cpu_blocker_pool([&]() {
+        try {
+            hash = crypto::pbkcs5_pbkdf2_hmac_sha256(
+                password, expected.get_salt(), expected.get_iteration_count());
+        } catch (...) {
+            error = std::current_exception();
+        }
+    });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    if (!crypto::compare_equal(expected.get_hash(), hash)) {
+        return false;
+    }
+
+    password_cache_entry_t entry;
+    entry.salt = expected.get_salt();
+    entry.iteration_count = expected.get_iteration_count();
+    entry.hash = expected.get_hash();
+    entry.fingerprint = fingerprint;
+    {
+        spinlock_acq_t acq(&password_cache->lock);
+        password_cache->cache[username] = entry;
+    }
+    return true;
+}
+
+}  // namespace auth
@@ -0,0 +1,29 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_ADMINISTRATION_AUTH_PASSWORD_CHECK_HPP
+#define CLUSTERING_ADMINISTRATION_AUTH_PASSWORD_CHECK_HPP
+
+#include <string>
+
+#include "clustering/administration/auth/password.hpp"
+#include "clustering/administration/auth/username.hpp"
+
+namespace auth {
+
+/* Checks `password` against the stored `expected` password of `username`. Deriving the
+hash takes thousands of HMAC iterations, so it runs in the thread pool's CPU blocker
+pool instead of on the calling thread, which keeps serving its other coroutines in the
+meantime. The hashes of recently authenticated users are cached, so a client that
+reconnects over and over only pays for the iterations once. The cache doesn't keep the
+password itself, only a salted SHA-256 of it, and changing the password changes the
+salt so the old entry stops matching. Must be called from a coroutine. */
+bool check_password(
+        username_t const &username,
+        std::string const &password,
+        password_t const &expected);
+
+/* The size of the cache of derived keys */
+const size_t PASSWORD_CACHE_SIZE = 1024;
+
+}  // namespace auth
+
+#endif  // CLUSTERING_ADMINISTRATION_AUTH_PASSWORD_CHECK_HPP
@@ -2,9 +2,8 @@
 #include "clustering/administration/auth/plaintext_authenticator.hpp"
 
 #include "clustering/administration/auth/authentication_error.hpp"
+#include "clustering/administration/auth/password_check.hpp"
 #include "clustering/administration/metadata.hpp"
-#include "crypto/compare_equal.hpp"
-#include "crypto/pbkcs5_pbkdf2_hmac.hpp"
 #include "crypto/saslprep.hpp"
 
 namespace auth {
@@ -34,13 +33,8 @@ plaintext_authenticator_t::plaintext_authenticator_t(
         throw authentication_error_t(17, "Unknown user");
     }
 
-    std::array<unsigned char, SHA256_DIGEST_LENGTH> hash =
-        crypto::pbkcs5_pbkdf2_hmac_sha256(
-            crypto::saslprep(password),
-            user->get_password().get_salt(),
-            user->get_password().get_iteration_count());
-
-    if (!crypto::compare_equal(user->get_password().get_hash(), hash)) {
+    if (!check_password(
+            m_username, crypto::saslprep(password), user->get_password())) {
         throw authentication_error_t(12, "Wrong password");
     }
 
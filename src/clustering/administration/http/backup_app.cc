@@ -0,0 +1,91 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "clustering/administration/http/backup_app.hpp"
+
+#include <string>
+
+#include "clustering/administration/persist/table_interface.hpp"
+#include "concurrency/cross_thread_signal.hpp"
+#include "containers/uuid.hpp"
+#include "logger.hpp"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+#include "rdb_protocol/datum.hpp"
+#include "time.hpp"
+
+backup_http_app_t::backup_http_app_t(
+        real_table_persistence_interface_t *_persistence_interface) :
+    persistence_interface(_persistence_interface),
+    persistence_thread(get_thread_id()) { }
+
+void backup_http_app_t::handle(const http_req_t &req,
+                               http_res_t *result,
+                               signal_t *interruptor) {
+    http_req_t::resource_t::iterator it = req.resource.begin();
+    if (it == req.resource.end()) {
+        *result = http_res_t(http_status_code_t::NOT_FOUND);
+        return;
+    }
+    namespace_id_t table_id;
+    if (!str_to_uuid(*it, &table_id)) {
+        *result = http_error_res(strprintf("`%s` isn't a table UUID.", it->c_str()));
+        return;
+    }
+    ++it;
+    if (it != req.resource.end()) {
+        *result = http_res_t(http_status_code_t::NOT_FOUND);
+        return;
+    }
+    if (req.method != http_method_t::POST) {
+        *result = http_res_t(http_status_code_t::METHOD_NOT_ALLOWED);
+        return;
+    }
+
+    optional<std::string> path = req.find_query_param("path");
+    if (!path.has_value() || path->empty()) {
+        *result = http_error_res("Expected the `path` query parameter.");
+        return;
+    }
+    optional<std::string> compress_param = req.find_query_param("compress");
+    bool compress = false;
+    if (compress_param.has_value()) {
+        if (*compress_param == "true") {
+            compress = true;
+        } else if (*compress_param != "false") {
+            *result = http_error_res("`compress` must be `true` or `false`.");
+            return;
+        }
+    }
+    if (persistence_interface == nullptr) {
+        *result = http_error_res("Proxies don't store any tables.");
+        return;
+    }
+
+    logNTC("Writing a backup of table %s to `%s`.\n",
+           uuid_to_str(table_id).c_str(), path->c_str());
+    ticks_t start = get_ticks();
+    std::string error;
+    bool success;
+    {
+        cross_thread_signal_t ct_interruptor(interruptor, persistence_thread);
+        on_thread_t thread_switcher(persistence_thread);
+        success = persistence_interface->backup_table(
+            table_id, *path, compress, &ct_interruptor, &error);
+    }
+    if (!success) {
+        logWRN("The backup of table %s failed: %s",
+               uuid_to_str(table_id).c_str(), error.c_str());
+        *result = http_error_res(error, http_status_code_t::INTERNAL_SERVER_ERROR);
+        return;
+    }
+
+    ql::datum_object_builder_t builder;
+    builder.overwrite("table", ql::datum_t(datum_string_t(uuid_to_str(table_id))));
+    builder.overwrite("path", ql::datum_t(datum_string_t(*path)));
+    ticks_t duration{get_ticks().nanos - start.nanos};
+    builder.overwrite("duration", ql::datum_t(ticks_to_secs(duration)));
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    std::move(builder).to_datum().write_json(&writer);
+    *result = http_res_t(http_status_code_t::OK, "application/json",
+                         std::string(buffer.GetString(), buffer.GetSize()));
+}
@@ -0,0 +1,29 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_ADMINISTRATION_HTTP_BACKUP_APP_HPP_
+#define CLUSTERING_ADMINISTRATION_HTTP_BACKUP_APP_HPP_
+
+#include "http/http.hpp"
+#include "threading.hpp"
+
+class real_table_persistence_interface_t;
+
+/* `backup_http_app_t` makes block backups (see `serializer/backup.hpp`) of the tables
+that this server has a replica of:
+    - `POST /backup/<table uuid>?path=<file>` writes a backup of the table's data file
+      to `<file>` on this server, and returns once it's complete. Adding
+      `&compress=true` compresses the blocks.
+Each replica of a table is backed up on its own, from its own copy of the data. */
+class backup_http_app_t : public http_app_t {
+public:
+    /* `persistence_interface` is `nullptr` on proxies, which have no tables. */
+    explicit backup_http_app_t(
+        real_table_persistence_interface_t *persistence_interface);
+
+    void handle(const http_req_t &req, http_res_t *result, signal_t *interruptor);
+
+private:
+    real_table_persistence_interface_t *const persistence_interface;
+    const threadnum_t persistence_thread;
+};
+
+#endif /* CLUSTERING_ADMINISTRATION_HTTP_BACKUP_APP_HPP_ */
@@ -0,0 +1,69 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "clustering/administration/http/cpu_profile_app.hpp"
+
+#include <string>
+
+#include "arch/runtime/cpu_profiler.hpp"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+#include "rdb_protocol/datum.hpp"
+
+static std::string format_status_as_json(const cpu_profiler_t::status_t &status) {
+    ql::datum_object_builder_t builder;
+    builder.overwrite("running", ql::datum_t::boolean(status.running));
+    builder.overwrite("sampling_time", ql::datum_t(status.sampling_secs));
+    builder.overwrite("samples",
+                      ql::datum_t(static_cast<double>(status.samples)));
+    builder.overwrite("dropped_samples",
+                      ql::datum_t(static_cast<double>(status.dropped_samples)));
+
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    std::move(builder).to_datum().write_json(&writer);
+    return std::string(buffer.GetString(), buffer.GetSize());
+}
+
+void cpu_profile_http_app_t::handle(const http_req_t &req,
+                                    http_res_t *result,
+                                    UNUSED signal_t *interruptor) {
+    http_req_t::resource_t::iterator it = req.resource.begin();
+    if (it == req.resource.end()) {
+        if (req.method != http_method_t::GET && req.method != http_method_t::HEAD) {
+            *result = http_res_t(http_status_code_t::METHOD_NOT_ALLOWED);
+            return;
+        }
+        *result = http_res_t(http_status_code_t::OK, "text/plain; charset=utf-8",
+                             cpu_profiler_t::get_folded_stacks());
+        return;
+    }
+
+    std::string action = *it;
+    ++it;
+    if (it != req.resource.end()) {
+        *result = http_res_t(http_status_code_t::NOT_FOUND);
+        return;
+    }
+
+    if (action == "start" || action == "stop") {
+        if (req.method != http_method_t::POST) {
+            *result = http_res_t(http_status_code_t::METHOD_NOT_ALLOWED);
+            return;
+        }
+        if (action == "start") {
+            cpu_profiler_t::start();
+        } else {
+            cpu_profiler_t::stop();
+        }
+    } else if (action == "status") {
+        if (req.method != http_method_t::GET && req.method != http_method_t::HEAD) {
+            *result = http_res_t(http_status_code_t::METHOD_NOT_ALLOWED);
+            return;
+        }
+    } else {
+        *result = http_res_t(http_status_code_t::NOT_FOUND);
+        return;
+    }
+
+    *result = http_res_t(http_status_code_t::OK, "application/json",
+                         format_status_as_json(cpu_profiler_t::get_status()));
+}
@@ -0,0 +1,19 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_ADMINISTRATION_HTTP_CPU_PROFILE_APP_HPP_
+#define CLUSTERING_ADMINISTRATION_HTTP_CPU_PROFILE_APP_HPP_
+
+#include "http/http.hpp"
+
+/* `cpu_profile_http_app_t` controls this server's `cpu_profiler_t`:
+    - `POST /cpu_profile/start` starts the profiler, discarding earlier samples.
+    - `POST /cpu_profile/stop` stops it.
+    - `GET /cpu_profile/status` returns whether it's running and how many samples it
+      has as a JSON object. The `POST`s return the same thing.
+    - `GET /cpu_profile` returns the samples as folded stacks, which can be turned into
+      a flame graph. It works whether or not the profiler is still running. */
+class cpu_profile_http_app_t : public http_app_t {
+public:
+    void handle(const http_req_t &req, http_res_t *result, signal_t *interruptor);
+};
+
+#endif /* CLUSTERING_ADMINISTRATION_HTTP_CPU_PROFILE_APP_HPP_ */
@@ -0,0 +1,71 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "clustering/administration/http/io_priorities_app.hpp"
+
+#include "arch/types.hpp"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+#include "rdb_protocol/datum.hpp"
+#include "utils.hpp"
+
+static bool parse_io_class(const std::string &name, io_class_t *io_class_out) {
+    for (int i = 0; i < static_cast<int>(io_class_t::NUM_IO_CLASSES); ++i) {
+        if (name == io_class_name(static_cast<io_class_t>(i))) {
+            *io_class_out = static_cast<io_class_t>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+void io_priorities_http_app_t::handle(const http_req_t &req,
+                                      http_res_t *result,
+                                      UNUSED signal_t *interruptor) {
+    if (req.resource.begin() != req.resource.end()) {
+        *result = http_res_t(http_status_code_t::NOT_FOUND);
+        return;
+    }
+
+    if (req.method == http_method_t::POST || req.method == http_method_t::PUT) {
+        optional<std::string> class_param = req.find_query_param("class");
+        optional<std::string> percent_param = req.find_query_param("percent");
+        if (!class_param.has_value() || !percent_param.has_value()) {
+            *result = http_error_res(
+                "Expected the `class` and `percent` query parameters.");
+            return;
+        }
+        io_class_t io_class;
+        if (!parse_io_class(*class_param, &io_class)) {
+            *result = http_error_res(
+                strprintf("Unknown I/O class `%s`.", class_param->c_str()));
+            return;
+        }
+        int64_t percent;
+        if (!strtoi64_strict(*percent_param, 10, &percent)
+            || percent < MIN_IO_CLASS_PRIORITY_PERCENT
+            || percent > MAX_IO_CLASS_PRIORITY_PERCENT) {
+            *result = http_error_res(
+                strprintf("`percent` must be an integer between %d and %d.",
+                          MIN_IO_CLASS_PRIORITY_PERCENT,
+                          MAX_IO_CLASS_PRIORITY_PERCENT));
+            return;
+        }
+        set_io_class_priority_percent(io_class, static_cast<int>(percent));
+    } else if (req.method != http_method_t::GET && req.method != http_method_t::HEAD) {
+        *result = http_res_t(http_status_code_t::METHOD_NOT_ALLOWED);
+        return;
+    }
+
+    ql::datum_object_builder_t percents;
+    for (int i = 0; i < static_cast<int>(io_class_t::NUM_IO_CLASSES); ++i) {
+        io_class_t io_class = static_cast<io_class_t>(i);
+        percents.overwrite(io_class_name(io_class),
+                           ql::datum_t(static_cast<double>(
+                               get_io_class_priority_percent(io_class))));
+    }
+
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    std::move(percents).to_datum().write_json(&writer);
+    *result = http_res_t(http_status_code_t::OK, "application/json",
+                         std::string(buffer.GetString(), buffer.GetSize()));
+}
@@ -0,0 +1,20 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_ADMINISTRATION_HTTP_IO_PRIORITIES_APP_HPP_
+#define CLUSTERING_ADMINISTRATION_HTTP_IO_PRIORITIES_APP_HPP_
+
+#include "http/http.hpp"
+
+/* `io_priorities_http_app_t` shows and changes how much disk throughput each
+`io_class_t` gets on this server, as a percentage of its built-in priority. A `GET`
+returns a JSON object mapping each class's name to its percentage; a `POST` or `PUT`
+with the `class` and `percent` query parameters changes one class first. For example,
+`POST /io_priorities?class=backfill&percent=50` halves the share that backfills get
+relative to everything else.
+
+The change only applies to this server and is forgotten when it restarts. */
+class io_priorities_http_app_t : public http_app_t {
+public:
+    void handle(const http_req_t &req, http_res_t *result, signal_t *interruptor);
+};
+
+#endif /* CLUSTERING_ADMINISTRATION_HTTP_IO_PRIORITIES_APP_HPP_ */
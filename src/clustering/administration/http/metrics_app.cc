@@ -0,0 +1,112 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "clustering/administration/http/metrics_app.hpp"
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "containers/uuid.hpp"
+#include "perfmon/collect.hpp"
+#include "utils.hpp"
+
+static const char *const metric_prefix = "rethinkdb";
+static const char *const openmetrics_content_type =
+    "application/openmetrics-text; version=1.0.0; charset=utf-8";
+
+/* Metric names may only contain `[a-zA-Z0-9_:]`. */
+static std::string sanitize_metric_name_component(const std::string &s) {
+    std::string res;
+    res.reserve(s.size());
+    for (char c : s) {
+        bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+            || (c >= '0' && c <= '9') || c == '_';
+        res.push_back(ok ? c : '_');
+    }
+    return res;
+}
+
+/* Maps metric names to their samples. Each sample is the formatted label set and the
+value. We group them so that all the samples of a family come after its `# TYPE` line,
+as OpenMetrics requires. */
+typedef std::map<std::string, std::vector<std::pair<std::string, double> > >
+    metric_families_t;
+
+static void collect_metrics(const ql::datum_t &datum,
+                            const std::string &name,
+                            const std::string &labels,
+                            metric_families_t *families_out) {
+    switch (datum.get_type()) {
+    case ql::datum_t::R_NUM:
+        (*families_out)[name].push_back(std::make_pair(labels, datum.as_num()));
+        break;
+    case ql::datum_t::R_BOOL:
+        (*families_out)[name].push_back(
+            std::make_pair(labels, datum.as_bool() ? 1.0 : 0.0));
+        break;
+    case ql::datum_t::R_OBJECT:
+        for (size_t i = 0; i < datum.obj_size(); ++i) {
+            std::pair<datum_string_t, ql::datum_t> pair = datum.get_pair(i);
+            std::string key = pair.first.to_std();
+            uuid_u table_id;
+            if (labels.empty() && str_to_uuid(key, &table_id)) {
+                collect_metrics(pair.second, name,
+                                strprintf("table=\"%s\"", key.c_str()), families_out);
+            } else {
+                collect_metrics(pair.second,
+                                name + "_" + sanitize_metric_name_component(key),
+                                labels, families_out);
+            }
+        }
+        break;
+    case ql::datum_t::R_ARRAY:    // fallthrough
+    case ql::datum_t::R_BINARY:   // fallthrough
+    case ql::datum_t::R_NULL:     // fallthrough
+    case ql::datum_t::R_STR:      // fallthrough
+    case ql::datum_t::UNINITIALIZED:  // fallthrough
+    case ql::datum_t::MINVAL:         // fallthrough
+    case ql::datum_t::MAXVAL:
+        /* Strings (such as the server id), the raw histogram buckets and the values
+        of empty histograms aren't samples. */
+        break;
+    default:
+        unreachable();
+    }
+}
+
+std::string format_perfmon_stats_as_openmetrics(const ql::datum_t &stats) {
+    metric_families_t families;
+    collect_metrics(stats, metric_prefix, "", &families);
+
+    std::string res;
+    for (const auto &family : families) {
+        /* Perfmon doesn't tell us whether a value is a counter or a gauge. */
+        res += strprintf("# TYPE %s unknown\n", family.first.c_str());
+        for (const auto &sample : family.second) {
+            if (sample.first.empty()) {
+                res += strprintf("%s %.17g\n", family.first.c_str(), sample.second);
+            } else {
+                res += strprintf("%s{%s} %.17g\n",
+                                 family.first.c_str(), sample.first.c_str(),
+                                 sample.second);
+            }
+        }
+    }
+    res += "# EOF\n";
+    return res;
+}
+
+void metrics_http_app_t::handle(const http_req_t &req,
+                                http_res_t *result,
+                                UNUSED signal_t *interruptor) {
+    if (req.method != http_method_t::GET && req.method != http_method_t::HEAD) {
+        *result = http_res_t(http_status_code_t::METHOD_NOT_ALLOWED);
+        return;
+    }
+    if (req.resource.begin() != req.resource.end()) {
+        *result = http_res_t(http_status_code_t::NOT_FOUND);
+        return;
+    }
+
+    std::string body = format_perfmon_stats_as_openmetrics(perfmon_get_stats());
+    *result = http_res_t(http_status_code_t::OK, openmetrics_content_type, body);
+}
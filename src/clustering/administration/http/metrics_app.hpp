@@ -0,0 +1,26 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_ADMINISTRATION_HTTP_METRICS_APP_HPP_
+#define CLUSTERING_ADMINISTRATION_HTTP_METRICS_APP_HPP_
+
+#include <string>
+
+#include "http/http.hpp"
+#include "rdb_protocol/datum.hpp"
+
+/* `metrics_http_app_t` serves this server's perfmon stats in the OpenMetrics text
+format, so that a monitoring system can scrape them directly from the admin port.
+Unlike `rethinkdb.stats`, it only looks at the local `perfmon_collection_t`s and never
+talks to other servers.
+
+Every number in the perfmon tree becomes a sample whose name is its path, joined with
+underscores and prefixed with `rethinkdb_`. Path components that are table ids turn
+into a `table` label instead, so that each table doesn't get its own metric family. */
+class metrics_http_app_t : public http_app_t {
+public:
+    void handle(const http_req_t &req, http_res_t *result, signal_t *interruptor);
+};
+
+/* Formats the output of `perfmon_get_stats()`. Exposed for the unit tests. */
+std::string format_perfmon_stats_as_openmetrics(const ql::datum_t &stats);
+
+#endif /* CLUSTERING_ADMINISTRATION_HTTP_METRICS_APP_HPP_ */
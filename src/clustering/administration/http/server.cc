@@ -1,7 +1,12 @@
 // Copyright 2010-2012 RethinkDB, all rights reserved.
 #include "clustering/administration/http/server.hpp"
 
+#include "clustering/administration/http/backup_app.hpp"
+#include "clustering/administration/http/cpu_profile_app.hpp"
 #include "clustering/administration/http/cyanide.hpp"
+#include "clustering/administration/http/io_priorities_app.hpp"
+#include "clustering/administration/http/metrics_app.hpp"
+#include "clustering/administration/http/traces_app.hpp"
 #include "http/file_app.hpp"
 #include "http/http.hpp"
 #include "http/routing_app.hpp"
@@ -11,11 +16,18 @@ administrative_http_server_manager_t::administrative_http_server_manager_t(
         const std::set<ip_address_t> &local_addresses,
         int port,
         http_app_t *reql_app,
+        rdb_context_t *rdb_ctx,
+        real_table_persistence_interface_t *table_persistence_interface,
         std::string path,
         tls_ctx_t *tls_ctx)
 {
 
     file_app.init(new file_http_app_t(path));
+    backup_app.init(new backup_http_app_t(table_persistence_interface));
+    cpu_profile_app.init(new cpu_profile_http_app_t);
+    io_priorities_app.init(new io_priorities_http_app_t);
+    metrics_app.init(new metrics_http_app_t);
+    traces_app.init(new traces_http_app_t(rdb_ctx));
 
 #ifndef NDEBUG
     cyanide_app.init(new cyanide_http_app_t);
@@ -28,6 +40,11 @@ administrative_http_server_manager_t::administrative_http_server_manager_t(
 
     std::map<std::string, http_app_t *> root_routes;
     root_routes["ajax"] = ajax_routing_app.get();
+    root_routes["backup"] = backup_app.get();
+    root_routes["cpu_profile"] = cpu_profile_app.get();
+    root_routes["io_priorities"] = io_priorities_app.get();
+    root_routes["metrics"] = metrics_app.get();
+    root_routes["traces"] = traces_app.get();
     root_routing_app.init(new routing_http_app_t(file_app.get(), root_routes));
 
     server.init(new http_server_t(tls_ctx, local_addresses, port, root_routing_app.get()));
@@ -14,8 +14,15 @@
 
 class http_server_t;
 class routing_http_app_t;
+class backup_http_app_t;
 class file_http_app_t;
 class cyanide_http_app_t;
+class cpu_profile_http_app_t;
+class io_priorities_http_app_t;
+class metrics_http_app_t;
+class traces_http_app_t;
+class rdb_context_t;
+class real_table_persistence_interface_t;
 
 class real_reql_cluster_interface_t;
 
@@ -26,6 +33,8 @@ public:
         const std::set<ip_address_t> &local_addresses,
         int port,
         http_app_t *reql_app,
+        rdb_context_t *rdb_ctx,
+        real_table_persistence_interface_t *table_persistence_interface,
         std::string _path,
         tls_ctx_t *tls_ctx);
     ~administrative_http_server_manager_t();
@@ -34,6 +43,11 @@ public:
 private:
 
     scoped_ptr_t<file_http_app_t> file_app;
+    scoped_ptr_t<backup_http_app_t> backup_app;
+    scoped_ptr_t<cpu_profile_http_app_t> cpu_profile_app;
+    scoped_ptr_t<io_priorities_http_app_t> io_priorities_app;
+    scoped_ptr_t<metrics_http_app_t> metrics_app;
+    scoped_ptr_t<traces_http_app_t> traces_app;
 #ifndef NDEBUG
     scoped_ptr_t<cyanide_http_app_t> cyanide_app;
 #endif
@@ -0,0 +1,47 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "clustering/administration/http/traces_app.hpp"
+
+#include <vector>
+
+#include "arch/runtime/runtime.hpp"
+#include "concurrency/pmap.hpp"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+#include "rdb_protocol/context.hpp"
+
+traces_http_app_t::traces_http_app_t(rdb_context_t *_rdb_ctx) :
+    rdb_ctx(_rdb_ctx) { }
+
+void traces_http_app_t::handle(const http_req_t &req,
+                               http_res_t *result,
+                               UNUSED signal_t *interruptor) {
+    if (req.method != http_method_t::GET && req.method != http_method_t::HEAD) {
+        *result = http_res_t(http_status_code_t::METHOD_NOT_ALLOWED);
+        return;
+    }
+    if (req.resource.begin() != req.resource.end()) {
+        *result = http_res_t(http_status_code_t::NOT_FOUND);
+        return;
+    }
+
+    std::vector<std::vector<ql::datum_t> > spans_per_thread(get_num_threads());
+    pmap(get_num_threads(), [&](int32_t threadnum) {
+        on_thread_t thread((threadnum_t(threadnum)));
+        for (const auto &span : rdb_ctx->get_query_spans_for_this_thread()->spans()) {
+            spans_per_thread[threadnum].push_back(span.to_datum());
+        }
+    });
+
+    ql::datum_array_builder_t spans(ql::configured_limits_t::unlimited);
+    for (auto &&thread_spans : spans_per_thread) {
+        for (auto &&span : thread_spans) {
+            spans.add(std::move(span));
+        }
+    }
+
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    std::move(spans).to_datum().write_json(&writer);
+    *result = http_res_t(http_status_code_t::OK, "application/json",
+                         std::string(buffer.GetString(), buffer.GetSize()));
+}
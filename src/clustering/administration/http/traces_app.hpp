@@ -0,0 +1,24 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_ADMINISTRATION_HTTP_TRACES_APP_HPP_
+#define CLUSTERING_ADMINISTRATION_HTTP_TRACES_APP_HPP_
+
+#include "http/http.hpp"
+
+class rdb_context_t;
+
+/* `traces_http_app_t` serves the spans of the queries that were recently traced on
+this server, as a JSON array. A query is traced if the client passed a sampled
+`traceparent` global optarg, or at random for a small fraction of queries. Each span
+contains the query's profile, which shows the time spent on each hop. */
+class traces_http_app_t : public http_app_t {
+public:
+    explicit traces_http_app_t(rdb_context_t *_rdb_ctx);
+    void handle(const http_req_t &req, http_res_t *result, signal_t *interruptor);
+
+private:
+    rdb_context_t *rdb_ctx;
+
+    DISABLE_COPYING(traces_http_app_t);
+};
+
+#endif /* CLUSTERING_ADMINISTRATION_HTTP_TRACES_APP_HPP_ */
@@ -58,6 +58,9 @@ public:
             admin_err_t *error_out);
 
 private:
+    /* Every user sees the same rows, so changefeeds share one set of machinery. */
+    bool rows_depend_on_user() const { return false; }
+
     std::vector<scoped_ptr_t<issue_t> > all_issues(signal_t *interruptor) const;
 
     admin_identifier_format_t identifier_format;
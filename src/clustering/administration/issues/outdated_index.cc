@@ -73,6 +73,10 @@ outdated_index_issue_tracker_t::outdated_index_issue_tracker_t(
         table_meta_client(_table_meta_client) { }
 
 bool outdated_index_issue_tracker_t::is_acceptable_outdated(const sindex_config_t &sindex_config) {
+    if (sindex_config.func_version == reql_version_t::v2_3) {
+        // Since then only the keys got shorter; the functions behave the same.
+        return true;
+    }
     if (sindex_config.func.is_simple_selector()) {
         switch(sindex_config.func_version) {
             // A version should return false if it breaks compatibility for even simple sindexes.
@@ -80,7 +84,8 @@ bool outdated_index_issue_tracker_t::is_acceptable_outdated(const sindex_config_
         case reql_version_t::v2_0:
         case reql_version_t::v2_1:
         case reql_version_t::v2_2:
-        case reql_version_t::v2_3_is_latest:
+        case reql_version_t::v2_3:
+        case reql_version_t::v2_6_is_latest:
         default:
             return true;
         }
@@ -1,6 +1,7 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "clustering/administration/jobs/manager.hpp"
 
+#include <algorithm>
 #include <functional>
 #include <iterator>
 
@@ -92,7 +93,14 @@ void jobs_manager_t::on_get_job_reports(
 
                     std::string render = pprint::pretty_print_as_js(
                         printed_query_columns,
-                        pair.second->term_storage->root_term());
+                        pair.second->root_term());
+
+                    ql::query_resource_usage_t resource_usage =
+                        pair.second->resource_usage;
+                    if (pair.second->evaluating_since.has_value()) {
+                        resource_usage.evaluation_micros += std::max<int64_t>(0,
+                            kticks.micros - pair.second->evaluating_since->micros);
+                    }
 
                     query_job_reports_inner.emplace_back(
                         pair.second->job_id,
@@ -100,7 +108,8 @@ void jobs_manager_t::on_get_job_reports(
                         server_id,
                         query_cache->get_client_addr_port(),
                         std::move(render),
-                        query_cache->get_user_context());
+                        query_cache->get_user_context(),
+                        resource_usage);
                 }
             }
         }
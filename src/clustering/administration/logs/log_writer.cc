@@ -323,11 +323,11 @@ public:
     log_message_t assemble_log_message(log_level_t level, const std::string &m);
 
 private:
-    friend void log_coro(thread_pool_log_writer_t *writer, log_level_t level, const std::string &message, auto_drainer_t::lock_t);
+    friend void log_coro(thread_pool_log_writer_t *writer, auto_drainer_t::lock_t);
     friend void log_internal(const char *src_file, int src_line, log_level_t level, const char *format, ...);
     friend void vlog_internal(const char *src_file, int src_line, log_level_t level, const char *format, va_list args);
 
-    bool write(const log_message_t &msg, std::string *error_out);
+    bool write(const std::vector<log_message_t> &msgs, std::string *error_out);
     void initiate_write(log_level_t level, const std::string &message);
     base_path_t filename;
     struct timespec uptime_reference;
@@ -435,58 +435,72 @@ log_message_t fallback_log_writer_t::assemble_log_message(
     return log_message_t(timestamp, uptime, level, m);
 }
 
-// WINDOWS TODO: this function could benefit from some refactoring
-bool fallback_log_writer_t::write(const log_message_t &msg, std::string *error_out) {
-    std::string formatted = format_log_message(msg) + "\n";
-
-    FILE* write_stream = nullptr;
-    fd_t filefd = INVALID_FD;
-    switch (msg.level) {
-        case log_level_info:
-            // no message on stdout/stderr
-            break;
-        case log_level_notice:
-            write_stream = stdout;
-            filefd = STDOUT_FD;
-            break;
-        case log_level_debug:
-        case log_level_warn:
-        case log_level_error:
-            write_stream = stderr;
-            filefd = STDERR_FD;
-            break;
-        default:
-            unreachable();
-    }
-
-    if (msg.level != log_level_info) {
-        // Write to stdout/stderr for all log levels but info (#3040)
-        std::string console_formatted = format_log_message(msg, true) + "\n";
+// Writes `formatted` to stdout or stderr, if there's anything to write.
+static bool write_to_console(FILE *write_stream,
+                             UNUSED fd_t filefd,
+                             const std::string &formatted,
+                             std::string *error_out) {
+    if (formatted.empty()) {
+        return true;
+    }
 #ifdef _WIN32
-        // WINDOWS TODO
-        (void) write_stream;
+    // WINDOWS TODO
 #else
-        flockfile(write_stream);
+    flockfile(write_stream);
 #endif
 
-        size_t write_res = ::fwrite(console_formatted.data(), 1, console_formatted.length(), write_stream);
-        if (write_res != console_formatted.length()) {
-            error_out->assign("cannot write to stdout/stderr: " + errno_string(get_errno()));
-            return false;
-        }
+    bool ok = true;
+    size_t write_res = ::fwrite(formatted.data(), 1, formatted.length(), write_stream);
+    if (write_res != formatted.length()) {
+        error_out->assign("cannot write to stdout/stderr: " + errno_string(get_errno()));
+        ok = false;
+    }
 
 #ifdef _WIN32
-        // WINDOWS TODO
+    // WINDOWS TODO
 #else
+    if (ok) {
         int fsync_res = fsync(filefd);
         if (fsync_res != 0 && !(get_errno() == EROFS || get_errno() == EINVAL ||
                 get_errno() == ENOTSUP)) {
             error_out->assign("cannot flush stdout/stderr: " + errno_string(get_errno()));
-            return false;
+            ok = false;
         }
+    }
 
-        funlockfile(write_stream);
+    funlockfile(write_stream);
 #endif
+    return ok;
+}
+
+// WINDOWS TODO: this function could benefit from some refactoring
+bool fallback_log_writer_t::write(const std::vector<log_message_t> &msgs,
+                                  std::string *error_out) {
+    std::string formatted;
+    std::string stdout_formatted;
+    std::string stderr_formatted;
+    for (const log_message_t &msg : msgs) {
+        formatted += format_log_message(msg) + "\n";
+        // Write to stdout/stderr for all log levels but info (#3040)
+        switch (msg.level) {
+            case log_level_info:
+                break;
+            case log_level_notice:
+                stdout_formatted += format_log_message(msg, true) + "\n";
+                break;
+            case log_level_debug:
+            case log_level_warn:
+            case log_level_error:
+                stderr_formatted += format_log_message(msg, true) + "\n";
+                break;
+            default:
+                unreachable();
+        }
+    }
+
+    if (!write_to_console(stdout, STDOUT_FD, stdout_formatted, error_out)
+        || !write_to_console(stderr, STDERR_FD, stderr_formatted, error_out)) {
+        return false;
     }
 
     if (fd.get() == INVALID_FD) {
@@ -528,9 +542,9 @@ bool fallback_log_writer_t::write(const log_message_t &msg, std::string *error_o
 }
 
 void fallback_log_writer_t::initiate_write(log_level_t level, const std::string &message) {
-    log_message_t log_msg = assemble_log_message(level, message);
+    std::vector<log_message_t> log_msgs(1, assemble_log_message(level, message));
     std::string error_message;
-    if (!write(log_msg, &error_message)) {
+    if (!write(log_msgs, &error_message)) {
         fprintf(stderr, "Previous message may not have been written to the log file (%s).\n", error_message.c_str());
     }
 }
@@ -540,9 +554,16 @@ typedef auto_drainer_t * type;
 TLS_with_init(thread_pool_log_writer_t *, global_log_writer, nullptr);
 TLS_with_init(auto_drainer_t *, global_log_drainer, nullptr);
 TLS_with_init(int, log_writer_block, 0);
+// The messages logged on this thread that haven't been handed to the writer yet, and
+// how many were dropped because there were too many of them
+TLS_with_init(std::vector<log_message_t> *, pending_log_messages, nullptr);
+TLS_with_init(uint64_t, dropped_log_messages, 0);
+
+const size_t thread_pool_log_writer_t::MAX_PENDING_MESSAGES_PER_THREAD = 1000;
+const size_t thread_pool_log_writer_t::MAX_PENDING_MESSAGES = 10000;
 
 thread_pool_log_writer_t::thread_pool_log_writer_t()
-        : has_parse_error(false) {
+        : dropped_messages(0), writing(false), has_parse_error(false) {
     pmap(
         get_num_threads(),
         std::bind(&thread_pool_log_writer_t::install_on_thread, this, ph::_1));
@@ -604,6 +625,7 @@ std::vector<log_message_t> thread_pool_log_writer_t::tail(
 void thread_pool_log_writer_t::install_on_thread(int i) {
     on_thread_t thread_switcher((threadnum_t(i)));
     guarantee(TLS_get_global_log_writer() == nullptr);
+    TLS_set_pending_log_messages(new std::vector<log_message_t>());
     TLS_set_global_log_drainer(new auto_drainer_t);
     TLS_set_global_log_writer(this);
 }
@@ -614,22 +636,55 @@ void thread_pool_log_writer_t::uninstall_on_thread(int i) {
     TLS_set_global_log_writer(nullptr);
     delete TLS_get_global_log_drainer();
     TLS_set_global_log_drainer(nullptr);
+    delete TLS_get_pending_log_messages();
+    TLS_set_pending_log_messages(nullptr);
 }
 
-void thread_pool_log_writer_t::write(const log_message_t &lm) {
-    mutex_t::acq_t write_mutex_acq(&write_mutex);
-    std::string error_message;
-    bool ok;
-    thread_pool_t::run_in_blocker_pool(std::bind(&thread_pool_log_writer_t::write_blocking, this, lm, &error_message, &ok));
-    if (ok) {
-        log_write_issue_tracker.report_success();
-    } else {
-        log_write_issue_tracker.report_error(error_message);
+void thread_pool_log_writer_t::write(std::vector<log_message_t> &&messages,
+                                     uint64_t dropped) {
+    assert_thread();
+    dropped_messages += dropped;
+    for (log_message_t &msg : messages) {
+        if (pending_messages.size() < MAX_PENDING_MESSAGES) {
+            pending_messages.push_back(std::move(msg));
+        } else {
+            ++dropped_messages;
+        }
+    }
+    if (writing) {
+        // They go into the next batch of whoever is writing.
+        return;
     }
+
+    writing = true;
+    while (!pending_messages.empty() || dropped_messages != 0) {
+        std::vector<log_message_t> batch;
+        batch.swap(pending_messages);
+        if (dropped_messages != 0) {
+            batch.push_back(fallback_log_writer.assemble_log_message(
+                log_level_warn,
+                strprintf("%" PRIu64 " log messages were dropped because they came in "
+                          "faster than they could be written.\n", dropped_messages)));
+            dropped_messages = 0;
+        }
+        std::string error_message;
+        bool ok;
+        thread_pool_t::run_in_blocker_pool(std::bind(
+            &thread_pool_log_writer_t::write_blocking,
+            this, std::cref(batch), &error_message, &ok));
+        if (ok) {
+            log_write_issue_tracker.report_success();
+        } else {
+            log_write_issue_tracker.report_error(error_message);
+        }
+    }
+    writing = false;
 }
 
-void thread_pool_log_writer_t::write_blocking(const log_message_t &msg, std::string *error_out, bool *ok_out) {
-    *ok_out = fallback_log_writer.write(msg, error_out);
+void thread_pool_log_writer_t::write_blocking(const std::vector<log_message_t> &messages,
+                                              std::string *error_out,
+                                              bool *ok_out) {
+    *ok_out = fallback_log_writer.write(messages, error_out);
     return;
 }
 
@@ -694,11 +749,16 @@ void thread_pool_log_writer_t::tail_blocking(
     }
 }
 
-void log_coro(thread_pool_log_writer_t *writer, log_level_t level, const std::string &message, auto_drainer_t::lock_t) {
-    on_thread_t thread_switcher(writer->home_thread());
+void log_coro(thread_pool_log_writer_t *writer, auto_drainer_t::lock_t) {
+    // Everything that was logged on this thread since this coroutine was spawned goes
+    // to the writer together.
+    std::vector<log_message_t> messages;
+    messages.swap(*TLS_get_pending_log_messages());
+    uint64_t dropped = TLS_get_dropped_log_messages();
+    TLS_set_dropped_log_messages(0);
 
-    log_message_t log_msg = fallback_log_writer.assemble_log_message(level, message);
-    writer->write(log_msg);
+    on_thread_t thread_switcher(writer->home_thread());
+    writer->write(std::move(messages), dropped);
 }
 
 /* Declared in `logger.hpp`, not `clustering/administration/logs/logger.hpp` like the
@@ -713,10 +773,20 @@ void log_internal(const char *src_file, int src_line, log_level_t level, const c
 void vlog_internal(UNUSED const char *src_file, UNUSED int src_line, log_level_t level, const char *format, va_list args) {
     thread_pool_log_writer_t *writer;
     if ((writer = TLS_get_global_log_writer()) && TLS_get_log_writer_block() == 0) {
-        auto_drainer_t::lock_t lock(TLS_get_global_log_drainer());
+        std::vector<log_message_t> *pending = TLS_get_pending_log_messages();
+        if (pending->size()
+                >= thread_pool_log_writer_t::MAX_PENDING_MESSAGES_PER_THREAD) {
+            TLS_set_dropped_log_messages(TLS_get_dropped_log_messages() + 1);
+            return;
+        }
 
         std::string message = vstrprintf(format, args);
-        coro_t::spawn_sometime(std::bind(&log_coro, writer, level, message, lock));
+        // The timestamp is taken now, rather than when the message gets written.
+        pending->push_back(fallback_log_writer.assemble_log_message(level, message));
+        if (pending->size() == 1) {
+            auto_drainer_t::lock_t lock(TLS_get_global_log_drainer());
+            coro_t::spawn_sometime(std::bind(&log_coro, writer, lock));
+        }
 
     } else {
         std::string message = vstrprintf(format, args);
@@ -64,6 +64,12 @@ private:
 void log_internal(const char *src_file, int src_line, log_level_t level, const char *format, ...) ATTR_FORMAT(printf, 4, 5);
 void vlog_internal(const char *src_file, int src_line, log_level_t level, const char *format, va_list args) ATTR_FORMAT(printf, 4, 0);
 
+/* Log messages from the threads of the thread pool are collected in a buffer on each
+thread, and each buffer is handed to the writer's home thread in one go. The writer
+writes everything that came in while it was busy with the last batch in one write to
+the log file. Logging never waits for the disk; when messages come in faster than they
+can be written, the ones that don't fit in the buffers are dropped, and the log says
+how many. */
 class thread_pool_log_writer_t : public home_thread_mixin_t {
 public:
     thread_pool_log_writer_t();
@@ -76,13 +82,16 @@ public:
     }
 
 private:
-    friend void log_coro(thread_pool_log_writer_t *writer, log_level_t level, const std::string &message, auto_drainer_t::lock_t lock);
+    friend void log_coro(thread_pool_log_writer_t *writer, auto_drainer_t::lock_t lock);
     friend void log_internal(const char *src_file, int src_line, log_level_t level, const char *format, ...);
     friend void vlog_internal(const char *src_file, int src_line, log_level_t level, const char *format, va_list args);
     void install_on_thread(int i);
     void uninstall_on_thread(int i);
-    void write(const log_message_t &msg);
-    void write_blocking(const log_message_t &msg, std::string *error_out, bool *ok_out);
+    // `dropped` is how many messages the calling thread had to drop.
+    void write(std::vector<log_message_t> &&messages, uint64_t dropped);
+    void write_blocking(const std::vector<log_message_t> &messages,
+                        std::string *error_out,
+                        bool *ok_out);
     void tail_blocking(int max_lines,
                        struct timespec min_timestamp,
                        struct timespec max_timestamp,
@@ -91,7 +100,15 @@ private:
                        std::string *error_out,
                        bool *ok_out);
 
-    mutex_t write_mutex;
+    // How many messages each thread, and the home thread, keeps for the next batch
+    static const size_t MAX_PENDING_MESSAGES_PER_THREAD;
+    static const size_t MAX_PENDING_MESSAGES;
+
+    // The messages for the next batch, and whether a batch is being written
+    std::vector<log_message_t> pending_messages;
+    uint64_t dropped_messages;
+    bool writing;
+
     log_write_issue_tracker_t log_write_issue_tracker;
     bool has_parse_error;
 
@@ -10,6 +10,8 @@
 
 #include <inttypes.h>
 #include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
 #if defined(__MACH__)
@@ -311,19 +313,23 @@ uint64_t get_avail_mem_size() {
     return ret;
 #else
 	uint64_t page_size = sysconf(_SC_PAGESIZE);
-	{
-        uint64_t memory;
-        if (get_proc_meminfo_available_memory_size(&memory)) {
-            return memory;
-        } else {
-            logERR("Could not parse /proc/meminfo, so we will treat cached file memory "
-                "as if it were unavailable.");
-
-            // This just returns what /proc/meminfo would report as "MemFree".
-            uint64_t avail_mem_pages = sysconf(_SC_AVPHYS_PAGES);
-            return avail_mem_pages * page_size;
-        }
+    uint64_t memory;
+    if (!get_proc_meminfo_available_memory_size(&memory)) {
+        logERR("Could not parse /proc/meminfo, so we will treat cached file memory "
+            "as if it were unavailable.");
+
+        // This just returns what /proc/meminfo would report as "MemFree".
+        uint64_t avail_mem_pages = sysconf(_SC_AVPHYS_PAGES);
+        memory = avail_mem_pages * page_size;
+    }
+    // In a container, /proc/meminfo describes the whole host, and it's the cgroup's
+    // limit that gets us killed.
+    uint64_t cgroup_limit, cgroup_usage;
+    if (get_cgroup_memory_limit(&cgroup_limit, &cgroup_usage)) {
+        memory = std::min(memory,
+                          cgroup_limit > cgroup_usage ? cgroup_limit - cgroup_usage : 0);
     }
+    return memory;
 #endif
 }
 
@@ -368,3 +374,99 @@ void log_warnings_for_cache_size(uint64_t bytes) {
         logWRN("Cache size is very low and may impact performance.");
     }
 }
+
+bool parse_cgroup_memory_value(const std::string &contents, uint64_t *value_out) {
+    size_t end = contents.find_first_of(" \t\n");
+    if (end == std::string::npos) {
+        end = contents.size();
+    }
+    uint64_t value;
+    if (!strtou64_strict(contents.substr(0, end), 10, &value)) {
+        // cgroup v2 says "max" when there's no limit
+        return false;
+    }
+    // cgroup v1 says there's no limit with a number close to 2^63.
+    if (value >= (static_cast<uint64_t>(1) << 60)) {
+        return false;
+    }
+    *value_out = value;
+    return true;
+}
+
+bool parse_memory_pressure(const std::string &contents, double *some_avg10_out) {
+    // The line we want looks like "some avg10=1.53 avg60=0.87 avg300=0.22 total=1234"
+    size_t line_begin = 0;
+    while (line_begin < contents.size()) {
+        size_t line_end = contents.find('\n', line_begin);
+        if (line_end == std::string::npos) {
+            line_end = contents.size();
+        }
+        const std::string line = contents.substr(line_begin, line_end - line_begin);
+        line_begin = line_end + 1;
+        if (line.compare(0, 5, "some ") != 0) {
+            continue;
+        }
+        const size_t avg10 = line.find("avg10=");
+        if (avg10 == std::string::npos) {
+            return false;
+        }
+        const char *begin = line.c_str() + avg10 + strlen("avg10=");
+        char *end;
+        const double value = strtod(begin, &end);
+        if (end == begin || value < 0) {
+            return false;
+        }
+        *some_avg10_out = value;
+        return true;
+    }
+    return false;
+}
+
+#if defined(__linux__)
+static bool read_cgroup_memory_value(const char *path, uint64_t *value_out) {
+    std::string contents;
+    bool ok;
+    thread_pool_t::run_in_blocker_pool([&]() {
+        ok = blocking_read_file(path, &contents);
+    });
+    return ok && parse_cgroup_memory_value(contents, value_out);
+}
+#endif
+
+bool get_cgroup_memory_limit(uint64_t *limit_out, uint64_t *usage_out) {
+#if defined(__linux__)
+    // With cgroup namespaces, which container runtimes set up, our own cgroup is
+    // mounted at the root of /sys/fs/cgroup.
+    if (read_cgroup_memory_value("/sys/fs/cgroup/memory.max", limit_out)) {
+        return read_cgroup_memory_value("/sys/fs/cgroup/memory.current", usage_out);
+    }
+    if (read_cgroup_memory_value("/sys/fs/cgroup/memory/memory.limit_in_bytes",
+                                 limit_out)) {
+        return read_cgroup_memory_value("/sys/fs/cgroup/memory/memory.usage_in_bytes",
+                                        usage_out);
+    }
+#else
+    (void)limit_out;
+    (void)usage_out;
+#endif
+    return false;
+}
+
+bool get_memory_pressure(double *some_avg10_out) {
+#if defined(__linux__)
+    for (const char *path : {"/sys/fs/cgroup/memory.pressure",
+                             "/proc/pressure/memory"}) {
+        std::string contents;
+        bool ok;
+        thread_pool_t::run_in_blocker_pool([&]() {
+            ok = blocking_read_file(path, &contents);
+        });
+        if (ok && parse_memory_pressure(contents, some_avg10_out)) {
+            return true;
+        }
+    }
+#else
+    (void)some_avg10_out;
+#endif
+    return false;
+}
@@ -9,5 +9,20 @@ uint64_t get_max_total_cache_size();
 uint64_t get_default_total_cache_size();
 void log_warnings_for_cache_size(uint64_t);
 
+/* The memory limit and usage of the cgroup we're in, for when we run in a container.
+Both cgroup v2 (`memory.max`) and v1 (`memory.limit_in_bytes`) are understood. Returns
+false if there's no cgroup limit, or it couldn't be read. */
+bool get_cgroup_memory_limit(uint64_t *limit_out, uint64_t *usage_out);
+
+/* The share of the last ten seconds, in percent, during which some task waited for
+memory, from the pressure stall information of our cgroup or else of the whole system.
+Returns false on kernels without it. */
+bool get_memory_pressure(double *some_avg10_out);
+
+/* Parse the contents of a cgroup memory file such as `memory.max`, and of a pressure
+file such as `memory.pressure`. They're exposed for the unit tests. */
+bool parse_cgroup_memory_value(const std::string &contents, uint64_t *value_out);
+bool parse_memory_pressure(const std::string &contents, double *some_avg10_out);
+
 #endif  // CLUSTERING_ADMINISTRATION_MAIN_CACHE_SIZE_HPP_
 
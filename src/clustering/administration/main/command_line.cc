@@ -39,10 +39,12 @@
 #include <re2/re2.h>
 
 #include "arch/io/disk.hpp"
+#include "arch/io/fault_injection.hpp"
 #include "arch/io/openssl.hpp"
 #include "arch/os_signal.hpp"
 #include "arch/runtime/starter.hpp"
 #include "arch/filesystem.hpp"
+#include "arch/huge_page_arena.hpp"
 
 #include "extproc/extproc_spawner.hpp"
 #include "clustering/administration/main/cache_size.hpp"
@@ -855,6 +857,73 @@ private:
     FILE *fp;
 };
 
+/* Lets drivers that reconnect resume their TLS session instead of doing a full
+handshake. OpenSSL keeps a cache of sessions and also hands out session tickets, which
+it encrypts with a key of its own. Each server picks a random ticket key at startup, so
+a ticket is only good on the server that issued it, unless the servers all load the
+same key from `--driver-tls-ticket-key`. */
+bool configure_driver_tls_sessions(
+    const std::map<std::string, options::values_t> &opts, SSL_CTX *driver_tls) {
+    /* Sessions can only be resumed in the context they were made in. Without this,
+    OpenSSL won't resume them at all when client certificates are required. */
+    static const char session_id_context[] = "rethinkdb-driver";
+    if (0 == SSL_CTX_set_session_id_context(
+            driver_tls,
+            reinterpret_cast<const unsigned char *>(session_id_context),
+            sizeof(session_id_context) - 1)) {
+        ERR_print_errors_fp(stderr);
+        return false;
+    }
+    SSL_CTX_set_session_cache_mode(driver_tls, SSL_SESS_CACHE_SERVER);
+
+    optional<std::string> timeout_opt = get_optional_option(
+        opts, "--driver-tls-session-timeout");
+    if (timeout_opt) {
+        uint64_t timeout_secs;
+        if (!strtou64_strict(*timeout_opt, 10, &timeout_secs)
+                || timeout_secs > static_cast<uint64_t>(INT_MAX)) {
+            logERR("--driver-tls-session-timeout should be a number of seconds, "
+                   "got '%s'.", timeout_opt->c_str());
+            return false;
+        }
+        SSL_CTX_set_timeout(driver_tls, static_cast<long>(timeout_secs));  // NOLINT
+        if (timeout_secs == 0) {
+            SSL_CTX_set_session_cache_mode(driver_tls, SSL_SESS_CACHE_OFF);
+            SSL_CTX_set_options(driver_tls, SSL_OP_NO_TICKET);
+        }
+    }
+
+    optional<std::string> ticket_key_filename = get_optional_option(
+        opts, "--driver-tls-ticket-key");
+    if (ticket_key_filename) {
+        const long key_size =  // NOLINT(runtime/int)
+            SSL_CTX_get_tlsext_ticket_keys(driver_tls, nullptr, 0);
+        fp_wrapper_t key_fp(ticket_key_filename->c_str(), "rb");
+        if (nullptr == key_fp.get()) {
+            logERR(
+                "Unable to open '%s' for reading: %s",
+                ticket_key_filename->c_str(),
+                errno_string(get_errno()).c_str());
+            return false;
+        }
+        /* Read one byte more than we need, to tell a key that is too long. */
+        std::vector<char> key(key_size + 1);
+        size_t bytes_read = fread(key.data(), 1, key.size(), key_fp.get());
+        if (bytes_read != static_cast<size_t>(key_size)) {
+            logERR("The TLS session ticket key in '%s' must be exactly %ld bytes, "
+                   "for example from `openssl rand %ld`.",
+                   ticket_key_filename->c_str(), key_size, key_size);
+            return false;
+        }
+        if (1 != SSL_CTX_set_tlsext_ticket_keys(driver_tls, key.data(), key_size)) {
+            ERR_print_errors_fp(stderr);
+            return false;
+        }
+    }
+
+    return true;
+}
+
 bool initialize_tls_ctx(
     const std::map<std::string, options::values_t> &opts,
     shared_ssl_ctx_t *tls_ctx_out) {
@@ -888,6 +957,23 @@ bool initialize_tls_ctx(
         tls_ctx_out->get(),
         SSL_OP_CIPHER_SERVER_PREFERENCE|SSL_OP_SINGLE_DH_USE|SSL_OP_SINGLE_ECDH_USE);
 
+    /* With kernel TLS offload, OpenSSL hands the session keys to the kernel after the
+    handshake, and the records are then encrypted and decrypted in the socket layer
+    instead of by OpenSSL on our event loop threads. `SSL_read()` and `SSL_write()`
+    keep working as before, so `linux_secure_tcp_conn_t` doesn't need to know about
+    it. OpenSSL quietly keeps doing the encryption itself for connections where the
+    kernel can't, e.g. if the `tls` module isn't loaded or for a cipher suite that
+    the kernel doesn't support (AES-GCM, which is the default, is supported). */
+    if (exists_option(opts, "--tls-kernel-offload")) {
+#ifdef SSL_OP_ENABLE_KTLS
+        SSL_CTX_set_options(tls_ctx_out->get(), SSL_OP_ENABLE_KTLS);
+#else
+        logERR("The TLS library that RethinkDB was built with doesn't support kernel "
+               "TLS offload (it needs OpenSSL 3.0 or later, built with kTLS).");
+        return false;
+#endif
+    }
+
     /* This is pretty important. We want to use the most secure TLS cipher
     suite that we can. Our default list only allows ciphers suites which employ
     ECDHE (Elliptic Curve Diffie-Hellman with Ephemeral keys) for encryption
@@ -1018,7 +1104,8 @@ bool configure_tls(
         || exists_option(opts, "--driver-tls-cert")
         || exists_option(opts, "--driver-tls-ca")) {
         if (!(initialize_tls_ctx(opts, &(tls_configs_out->driver)) &&
-              configure_driver_tls(opts, tls_configs_out->driver.get())
+              configure_driver_tls(opts, tls_configs_out->driver.get()) &&
+              configure_driver_tls_sessions(opts, tls_configs_out->driver.get())
             )) {
             return false;
         }
@@ -1045,6 +1132,7 @@ void run_rethinkdb_create(const base_path_t &base_path,
                           optional<uint64_t> total_cache_size,
                           const file_direct_io_mode_t direct_io_mode,
                           const int max_concurrent_io_requests,
+                          const io_backend_t io_backend,
                           bool *const result_out) {
     server_id_t our_server_id = server_id_t::generate_server_id();
 
@@ -1058,7 +1146,7 @@ void run_rethinkdb_create(const base_path_t &base_path,
     server_config.config.cache_size_bytes = total_cache_size;
     server_config.version = 1;
 
-    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests);
+    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests, io_backend);
 
     perfmon_collection_t metadata_perfmon_collection;
     perfmon_membership_t metadata_perfmon_membership(&get_global_perfmon_collection(), &metadata_perfmon_collection, "metadata");
@@ -1139,6 +1227,7 @@ void run_rethinkdb_serve(const base_path_t &base_path,
                          const std::string &initial_password,
                          const file_direct_io_mode_t direct_io_mode,
                          const int max_concurrent_io_requests,
+                         const io_backend_t io_backend,
                          const optional<optional<uint64_t> >
                             &total_cache_size,
                          const server_id_t *our_server_id,
@@ -1156,7 +1245,15 @@ void run_rethinkdb_serve(const base_path_t &base_path,
 
     logNTC("Loading data from directory %s\n", base_path.path().c_str());
 
-    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests);
+    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests, io_backend);
+    if (!serve_info->extra_data_paths.empty()) {
+        /* Give each data directory's device its own disk queue and stats */
+        io_backender.add_device(base_path.path());
+        for (const base_path_t &path : serve_info->extra_data_paths) {
+            logNTC("Storing table data in directory %s as well\n", path.path().c_str());
+            io_backender.add_device(path.path());
+        }
+    }
 
     perfmon_collection_t metadata_perfmon_collection;
     perfmon_membership_t metadata_perfmon_membership(&get_global_perfmon_collection(), &metadata_perfmon_collection, "metadata");
@@ -1284,6 +1381,7 @@ void run_rethinkdb_porcelain(const base_path_t &base_path,
                              const std::string &initial_password,
                              const file_direct_io_mode_t direct_io_mode,
                              const int max_concurrent_io_requests,
+                             const io_backend_t io_backend,
                              const optional<optional<uint64_t> >
                                 &total_cache_size,
                              const bool new_directory,
@@ -1292,7 +1390,7 @@ void run_rethinkdb_porcelain(const base_path_t &base_path,
                              bool *const result_out) {
     if (!new_directory) {
         run_rethinkdb_serve(base_path, serve_info, initial_password, direct_io_mode,
-                            max_concurrent_io_requests, total_cache_size,
+                            max_concurrent_io_requests, io_backend, total_cache_size,
                             nullptr, nullptr, nullptr, data_directory_lock,
                             result_out);
     } else {
@@ -1329,6 +1427,7 @@ void run_rethinkdb_porcelain(const base_path_t &base_path,
 
         run_rethinkdb_serve(base_path, serve_info, initial_password, direct_io_mode,
                             max_concurrent_io_requests,
+                            io_backend,
                             optional<optional<uint64_t> >(),
                             &our_server_id, &server_config, &cluster_metadata,
                             data_directory_lock, result_out);
@@ -1354,6 +1453,54 @@ void run_rethinkdb_proxy(
     }
 }
 
+/* Parses one of the `--backfill-target-*` options; zero (the default) disables it. */
+uint64_t parse_backfill_target_option(
+        const std::map<std::string, options::values_t> &opts,
+        const std::string &name) {
+    const std::string target_opt = get_single_option(opts, name);
+    uint64_t target;
+    if (!strtou64_strict(target_opt, 10, &target)) {
+        throw std::runtime_error(strprintf(
+                "ERROR: %s should be a number, got '%s'",
+                name.c_str() + 2, target_opt.c_str()));
+    }
+    return target;
+}
+
+std::vector<base_path_t> parse_data_directory_options(
+        const std::map<std::string, options::values_t> &opts) {
+    std::vector<base_path_t> paths;
+    for (const std::string &directory : all_options(opts, "--data-directory")) {
+        base_path_t path(directory);
+        if (!check_existence(path)) {
+            throw std::runtime_error(strprintf(
+                "ERROR: data directory not found '%s'", directory.c_str()));
+        }
+        path.make_absolute();
+        recreate_temporary_directory(path);
+        paths.push_back(path);
+    }
+    return paths;
+}
+
+backfill_load_targets_t parse_backfill_load_targets_options(
+        const std::map<std::string, options::values_t> &opts) {
+    backfill_load_targets_t targets;
+    targets.query_latency_ms = parse_backfill_target_option(
+        opts, "--backfill-target-query-latency");
+    targets.disk_queue_depth = parse_backfill_target_option(
+        opts, "--backfill-target-disk-queue");
+    uint64_t cpu_percent = parse_backfill_target_option(
+        opts, "--backfill-target-cpu");
+    if (cpu_percent > 100) {
+        throw std::runtime_error(strprintf(
+                "ERROR: backfill-target-cpu is a percentage, got %" PRIu64,
+                cpu_percent));
+    }
+    targets.cpu_usage = cpu_percent / 100.0;
+    return targets;
+}
+
 options::help_section_t get_server_options(std::vector<options::option_t> *options_out) {
     options::help_section_t help("Server options");
     options_out->push_back(options::option_t(options::names_t("--server-name", "-n"),
@@ -1402,11 +1549,22 @@ options::help_section_t get_file_options(std::vector<options::option_t> *options
                                              options::OPTIONAL,
                                              "rethinkdb_data"));
     help.add("-d [ --directory ] path", "specify directory to store data and metadata");
+    options_out->push_back(options::option_t(options::names_t("--data-directory"),
+                                             options::OPTIONAL_REPEAT));
+    help.add("--data-directory path",
+             "an additional existing directory to store table data files in, e.g. on "
+             "another disk; may be specified multiple times");
     options_out->push_back(options::option_t(options::names_t("--io-threads"),
                                              options::OPTIONAL,
                                              strprintf("%d", DEFAULT_MAX_CONCURRENT_IO_REQUESTS)));
     help.add("--io-threads n",
              "how many simultaneous I/O operations can happen at the same time");
+    options_out->push_back(options::option_t(options::names_t("--io-backend"),
+                                             options::OPTIONAL,
+                                             "pool"));
+    help.add("--io-backend {pool|io_uring}",
+             "how to perform disk I/O: with a pool of threads, or with io_uring "
+             "(Linux only, falls back to the thread pool if unavailable)");
 #ifndef _WIN32
     // TODO WINDOWS: accept this option, but error out if it is passed
     options_out->push_back(options::option_t(options::names_t("--direct-io"),
@@ -1417,6 +1575,15 @@ options::help_section_t get_file_options(std::vector<options::option_t> *options
                                              options::OPTIONAL));
     help.add("--cache-size mb", "total cache size (in megabytes) for the process. Can "
         "be 'auto'.");
+    options_out->push_back(options::option_t(options::names_t("--huge-pages"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--huge-pages", "back the cache's block buffers with transparent huge "
+        "pages (Linux only)");
+    options_out->push_back(options::option_t(options::names_t("--idle-table-timeout"),
+                                             options::OPTIONAL, "0"));
+    help.add("--idle-table-timeout secs", "let tables that haven't been used for this "
+        "long give up their cache memory until they are used again, and load tables "
+        "lazily at startup (0 to keep all tables loaded)");
     return help;
 }
 
@@ -1624,6 +1791,19 @@ options::help_section_t get_network_options(const bool join_required, std::vecto
                                                     "before giving up, the default is "
                                                     "24 hours");
 
+    options_out->push_back(options::option_t(options::names_t("--cluster-compression"),
+                                             options::OPTIONAL,
+                                             "none"));
+    help.add("--cluster-compression {none|zlib}", "compress large messages sent to "
+             "other servers, which saves bandwidth at the cost of CPU time");
+
+    options_out->push_back(options::option_t(options::names_t("--cluster-connections-per-peer"),
+                                             options::OPTIONAL,
+                                             "1"));
+    help.add("--cluster-connections-per-peer n", "open up to n TCP connections to each "
+             "other server, so that large transfers such as backfills don't delay "
+             "smaller messages");
+
     return help;
 }
 
@@ -1633,6 +1813,15 @@ options::help_section_t get_cpu_options(std::vector<options::option_t> *options_
                                              options::OPTIONAL,
                                              strprintf("%d", get_cpu_count())));
     help.add("-c [ --cores ] n", "the number of cores to use");
+    options_out->push_back(options::option_t(options::names_t("--pin-threads"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--pin-threads", "pin each thread to a core, and keep the CPU shards of "
+             "each table on a single NUMA node");
+    options_out->push_back(options::option_t(options::names_t("--event-loop-spin"),
+                                             options::OPTIONAL, "0"));
+    help.add("--event-loop-spin usecs", "keep polling for this many microseconds "
+             "before an idle thread goes to sleep, trading CPU time for lower latency "
+             "(0 to disable)");
     return help;
 }
 
@@ -1647,6 +1836,104 @@ MUST_USE bool parse_cores_option(const std::map<std::string, options::values_t>
     return true;
 }
 
+/* Spinning for longer than this would just be burning a core */
+const uint64_t MAX_EVENT_LOOP_SPIN_USECS = MILLION;
+
+MUST_USE bool parse_event_loop_spin_option(
+        const std::map<std::string, options::values_t> &opts,
+        int64_t *spin_usecs_out) {
+    const std::string spin_opt = get_single_option(opts, "--event-loop-spin");
+    uint64_t spin_usecs;
+    if (!strtou64_strict(spin_opt, 10, &spin_usecs)
+            || spin_usecs > MAX_EVENT_LOOP_SPIN_USECS) {
+        fprintf(stderr, "ERROR: event-loop-spin must be a number of microseconds "
+                "between 0 and %" PRIu64 "\n", MAX_EVENT_LOOP_SPIN_USECS);
+        return false;
+    }
+    *spin_usecs_out = static_cast<int64_t>(spin_usecs);
+    return true;
+}
+
+options::help_section_t get_backfill_options(std::vector<options::option_t> *options_out) {
+    options::help_section_t help("Backfill options");
+    options_out->push_back(options::option_t(
+        options::names_t("--backfill-target-query-latency"), options::OPTIONAL, "0"));
+    help.add("--backfill-target-query-latency ms",
+             "slow down backfills while the mean query latency on this server is "
+             "above this many milliseconds (0 to disable)");
+    options_out->push_back(options::option_t(
+        options::names_t("--backfill-target-disk-queue"), options::OPTIONAL, "0"));
+    help.add("--backfill-target-disk-queue n",
+             "slow down backfills while more than this many disk requests are queued "
+             "on this server (0 to disable)");
+    options_out->push_back(options::option_t(
+        options::names_t("--backfill-target-cpu"), options::OPTIONAL, "0"));
+    help.add("--backfill-target-cpu percent",
+             "slow down backfills while this server uses more than this percentage of "
+             "its cores (0 to disable)");
+    return help;
+}
+
+options::help_section_t get_query_capture_options(
+        std::vector<options::option_t> *options_out) {
+    options::help_section_t help("Query capture options");
+    options_out->push_back(options::option_t(options::names_t("--capture-queries"),
+                                             options::OPTIONAL));
+    help.add("--capture-queries file",
+             "record the queries that clients send to this server in this file, so "
+             "that they can be replayed with test/performance/replay.py");
+    options_out->push_back(options::option_t(options::names_t("--capture-sample-rate"),
+                                             options::OPTIONAL, "1"));
+    help.add("--capture-sample-rate fraction",
+             "only capture this fraction of the queries, from 0 to 1");
+    options_out->push_back(options::option_t(options::names_t("--capture-redact"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--capture-redact",
+             "replace the strings and numbers in the captured queries with "
+             "placeholders, keeping table, field and index names");
+    return help;
+}
+
+options::help_section_t get_user_quota_options(
+        std::vector<options::option_t> *options_out) {
+    options::help_section_t help("Per-user quota options");
+    options_out->push_back(options::option_t(
+        options::names_t("--user-max-concurrent-queries"), options::OPTIONAL, "0"));
+    help.add("--user-max-concurrent-queries n",
+             "let each user other than admin run at most this many queries on this "
+             "server at a time; others wait (0 for no limit)");
+    options_out->push_back(options::option_t(
+        options::names_t("--user-max-rows-read-per-sec"), options::OPTIONAL, "0"));
+    help.add("--user-max-rows-read-per-sec n",
+             "slow down the queries of users that read more rows from tables than "
+             "this per second (0 for no limit)");
+    options_out->push_back(options::option_t(
+        options::names_t("--user-max-bytes-returned-per-sec"), options::OPTIONAL, "0"));
+    help.add("--user-max-bytes-returned-per-sec n",
+             "slow down the queries of users that are sent more than this many bytes "
+             "of results per second (0 for no limit)");
+    return help;
+}
+
+#ifdef FAULT_INJECTION_ENABLED
+options::help_section_t get_fault_injection_options(
+        std::vector<options::option_t> *options_out) {
+    options::help_section_t help("Fault injection options (for testing)");
+    options_out->push_back(options::option_t(
+        options::names_t("--inject-disk-faults"), options::OPTIONAL));
+    help.add("--inject-disk-faults settings",
+             "make this server's disks slower, with comma-separated settings like "
+             "latency=2ms,jitter=1ms,bandwidth=100M,stall=500ms,"
+             "stall-probability=0.001");
+    options_out->push_back(options::option_t(
+        options::names_t("--inject-network-faults"), options::OPTIONAL));
+    help.add("--inject-network-faults settings",
+             "make the connections from this server to other servers slower, with the "
+             "same settings as --inject-disk-faults");
+    return help;
+}
+#endif  // FAULT_INJECTION_ENABLED
+
 options::help_section_t get_service_options(std::vector<options::option_t> *options_out) {
     options::help_section_t help("Service options");
     options_out->push_back(options::option_t(options::names_t("--pid-file"),
@@ -1700,9 +1987,21 @@ options::help_section_t get_tls_options(std::vector<options::option_t> *options_
     help.add(
         "--driver-tls-cert cert_filename",
         "certificate to use for client driver connection TLS");
+    options_out->push_back(options::option_t(
+        options::names_t("--driver-tls-session-timeout"), options::OPTIONAL));
+    options_out->push_back(options::option_t(
+        options::names_t("--driver-tls-ticket-key"), options::OPTIONAL));
     help.add(
         "--driver-tls-ca ca_filename",
         "CA certificate bundle used to verify client certificates; TLS client authentication disabled if omitted");
+    help.add(
+        "--driver-tls-session-timeout seconds",
+        "how long reconnecting drivers can resume their TLS session without a full "
+        "handshake; 0 turns resumption off; default is 300");
+    help.add(
+        "--driver-tls-ticket-key key_filename",
+        "file with the key for encrypting TLS session tickets; servers with the same "
+        "key accept each other's tickets; a random key is used if omitted");
 
     // Client Driver TLS options.
     options_out->push_back(options::option_t(options::names_t("--cluster-tls-key"),
@@ -1730,6 +2029,8 @@ options::help_section_t get_tls_options(std::vector<options::option_t> *options_
                                              options::OPTIONAL));
     options_out->push_back(options::option_t(options::names_t("--tls-dhparams"),
                                              options::OPTIONAL));
+    options_out->push_back(options::option_t(options::names_t("--tls-kernel-offload"),
+                                             options::OPTIONAL_NO_PARAMETER));
     help.add(
         "--tls-min-protocol protocol",
         "the minimum TLS protocol version that the server accepts; options are "
@@ -1744,6 +2045,10 @@ options::help_section_t get_tls_options(std::vector<options::option_t> *options_
         "--tls-dhparams dhparams_filename",
         "provide parameters for DHE key agreement; REQUIRED if using DHE cipher suites; "
         "at least 2048-bit recommended");
+    help.add(
+        "--tls-kernel-offload",
+        "have the kernel encrypt and decrypt TLS connections after the handshake, "
+        "where the OS and TLS library support it");
 
     return help;
 }
@@ -1781,6 +2086,12 @@ void get_rethinkdb_serve_options(std::vector<options::help_section_t> *help_out,
     help_out->push_back(get_auth_options(options_out));
     help_out->push_back(get_web_options(options_out));
     help_out->push_back(get_cpu_options(options_out));
+    help_out->push_back(get_backfill_options(options_out));
+    help_out->push_back(get_query_capture_options(options_out));
+    help_out->push_back(get_user_quota_options(options_out));
+#ifdef FAULT_INJECTION_ENABLED
+    help_out->push_back(get_fault_injection_options(options_out));
+#endif
     help_out->push_back(get_service_options(options_out));
     help_out->push_back(get_setuser_options(options_out));
     help_out->push_back(get_help_options(options_out));
@@ -1796,6 +2107,11 @@ void get_rethinkdb_proxy_options(std::vector<options::help_section_t> *help_out,
 #endif
     help_out->push_back(get_auth_options(options_out));
     help_out->push_back(get_web_options(options_out));
+    help_out->push_back(get_query_capture_options(options_out));
+    help_out->push_back(get_user_quota_options(options_out));
+#ifdef FAULT_INJECTION_ENABLED
+    help_out->push_back(get_fault_injection_options(options_out));
+#endif
     help_out->push_back(get_service_options(options_out));
     help_out->push_back(get_setuser_options(options_out));
     help_out->push_back(get_help_options(options_out));
@@ -1814,6 +2130,12 @@ void get_rethinkdb_porcelain_options(std::vector<options::help_section_t> *help_
     help_out->push_back(get_auth_options(options_out));
     help_out->push_back(get_web_options(options_out));
     help_out->push_back(get_cpu_options(options_out));
+    help_out->push_back(get_backfill_options(options_out));
+    help_out->push_back(get_query_capture_options(options_out));
+    help_out->push_back(get_user_quota_options(options_out));
+#ifdef FAULT_INJECTION_ENABLED
+    help_out->push_back(get_fault_injection_options(options_out));
+#endif
     help_out->push_back(get_service_options(options_out));
     help_out->push_back(get_setuser_options(options_out));
     help_out->push_back(get_help_options(options_out));
@@ -1887,18 +2209,154 @@ MUST_USE bool parse_io_threads_option(const std::map<std::string, options::value
     return true;
 }
 
+MUST_USE bool parse_io_backend_option(const std::map<std::string, options::values_t> &opts,
+                                      io_backend_t *io_backend_out) {
+    const std::string io_backend = get_single_option(opts, "--io-backend");
+    if (io_backend == "pool") {
+        *io_backend_out = io_backend_t::pool;
+    } else if (io_backend == "io_uring") {
+        *io_backend_out = io_backend_t::io_uring;
+    } else {
+        fprintf(stderr, "ERROR: io-backend must be either 'pool' or 'io_uring'\n");
+        return false;
+    }
+    return true;
+}
+
 update_check_t parse_update_checking_option(const std::map<std::string, options::values_t> &opts) {
     return exists_option(opts, "--no-update-check")
         ? update_check_t::do_not_perform
         : update_check_t::perform;
 }
 
+/* Has to happen before the thread pool starts. Not being able to use huge pages isn't
+fatal, since it only costs performance. */
+void parse_huge_pages_option(const std::map<std::string, options::values_t> &opts) {
+    if (!exists_option(opts, "--huge-pages")) {
+        return;
+    }
+    const char *error;
+    if (!enable_huge_page_arena(&error)) {
+        fprintf(stderr, "WARNING: not using huge pages because %s\n", error);
+    }
+}
+
+int64_t parse_idle_table_timeout_option(
+        const std::map<std::string, options::values_t> &opts) {
+    const std::string opt = get_single_option(opts, "--idle-table-timeout");
+    uint64_t secs;
+    if (!strtou64_strict(opt, 10, &secs) || secs > INT32_MAX) {
+        throw std::runtime_error(strprintf(
+                "ERROR: idle-table-timeout should be a number of seconds, got '%s'",
+                opt.c_str()));
+    }
+    return secs;
+}
+
 file_direct_io_mode_t parse_direct_io_mode_option(const std::map<std::string, options::values_t> &opts) {
     return exists_option(opts, "--direct-io") ?
         file_direct_io_mode_t::direct_desired :
         file_direct_io_mode_t::buffered_desired;
 }
 
+cluster_compression_t parse_cluster_compression_option(
+        const std::map<std::string, options::values_t> &opts) {
+    const std::string compression_opt = get_single_option(opts, "--cluster-compression");
+    if (compression_opt == "none") {
+        return cluster_compression_t::none;
+    } else if (compression_opt == "zlib") {
+        return cluster_compression_t::zlib;
+    }
+    throw std::runtime_error(strprintf(
+            "ERROR: cluster-compression should be 'none' or 'zlib', got '%s'",
+            compression_opt.c_str()));
+}
+
+int parse_cluster_connections_per_peer_option(
+        const std::map<std::string, options::values_t> &opts) {
+    const std::string connections_opt =
+        get_single_option(opts, "--cluster-connections-per-peer");
+    uint64_t connections;
+    if (!strtou64_strict(connections_opt, 10, &connections)
+            || connections < 1
+            || connections > connectivity_cluster_t::max_connections_per_peer) {
+        throw std::runtime_error(strprintf(
+                "ERROR: cluster-connections-per-peer should be a number from 1 to %d, "
+                "got '%s'",
+                connectivity_cluster_t::max_connections_per_peer,
+                connections_opt.c_str()));
+    }
+    return static_cast<int>(connections);
+}
+
+optional<query_capture_config_t> parse_query_capture_options(
+        const std::map<std::string, options::values_t> &opts) {
+    optional<std::string> path = get_optional_option(opts, "--capture-queries");
+    if (!path.has_value()) {
+        return r_nullopt;
+    }
+    query_capture_config_t config;
+    config.path = *path;
+    const std::string rate_opt = get_single_option(opts, "--capture-sample-rate");
+    char *end;
+    config.sample_rate = strtod(rate_opt.c_str(), &end);
+    if (rate_opt.empty() || *end != '\0'
+            || !(config.sample_rate >= 0.0 && config.sample_rate <= 1.0)) {
+        throw std::runtime_error(strprintf(
+                "ERROR: capture-sample-rate should be a number from 0 to 1, got '%s'",
+                rate_opt.c_str()));
+    }
+    config.redact = exists_option(opts, "--capture-redact");
+    return make_optional(config);
+}
+
+static uint64_t parse_user_quota_option(
+        const std::map<std::string, options::values_t> &opts,
+        const std::string &name) {
+    const std::string opt = get_single_option(opts, name);
+    uint64_t value;
+    if (!strtou64_strict(opt, 10, &value)) {
+        throw std::runtime_error(strprintf(
+                "ERROR: %s should be a non-negative integer, got '%s'",
+                name.substr(2).c_str(), opt.c_str()));
+    }
+    return value;
+}
+
+#ifdef FAULT_INJECTION_ENABLED
+void apply_fault_injection_options(
+        const std::map<std::string, options::values_t> &opts) {
+    const std::pair<const char *, fault_injection_target_t> targets[] = {
+        {"--inject-disk-faults", fault_injection_target_t::disk},
+        {"--inject-network-faults", fault_injection_target_t::network}};
+    for (const auto &target : targets) {
+        optional<std::string> spec = get_optional_option(opts, target.first);
+        if (!spec.has_value()) {
+            continue;
+        }
+        fault_injection_config_t config;
+        std::string error;
+        if (!parse_fault_injection_config(*spec, &config, &error)) {
+            throw std::runtime_error(strprintf(
+                    "ERROR: %s: %s", target.first + 2, error.c_str()));
+        }
+        set_fault_injection_config(target.second, config);
+    }
+}
+#endif  // FAULT_INJECTION_ENABLED
+
+user_quota_config_t parse_user_quota_options(
+        const std::map<std::string, options::values_t> &opts) {
+    user_quota_config_t config;
+    config.max_concurrent_queries =
+        parse_user_quota_option(opts, "--user-max-concurrent-queries");
+    config.max_rows_read_per_sec =
+        parse_user_quota_option(opts, "--user-max-rows-read-per-sec");
+    config.max_bytes_returned_per_sec =
+        parse_user_quota_option(opts, "--user-max-bytes-returned-per-sec");
+    return config;
+}
+
 int main_rethinkdb_create(int argc, char *argv[]) {
     std::vector<options::option_t> options;
     std::vector<options::help_section_t> help;
@@ -1929,6 +2387,11 @@ int main_rethinkdb_create(int argc, char *argv[]) {
             return EXIT_FAILURE;
         }
 
+        io_backend_t io_backend;
+        if (!parse_io_backend_option(opts, &io_backend)) {
+            return EXIT_FAILURE;
+        }
+
         const int num_workers = get_cpu_count();
 
         bool is_new_directory = false;
@@ -1958,6 +2421,7 @@ int main_rethinkdb_create(int argc, char *argv[]) {
                                      total_cache_size,
                                      direct_io_mode,
                                      max_concurrent_io_requests,
+                                     io_backend,
                                      &result),
                            num_workers);
 
@@ -2052,11 +2516,23 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
             return EXIT_FAILURE;
         }
 
+        int64_t event_loop_spin_usecs;
+        if (!parse_event_loop_spin_option(opts, &event_loop_spin_usecs)) {
+            return EXIT_FAILURE;
+        }
+
+        parse_huge_pages_option(opts);
+
         int max_concurrent_io_requests;
         if (!parse_io_threads_option(opts, &max_concurrent_io_requests)) {
             return EXIT_FAILURE;
         }
 
+        io_backend_t io_backend;
+        if (!parse_io_backend_option(opts, &io_backend)) {
+            return EXIT_FAILURE;
+        }
+
         update_check_t do_update_checking = parse_update_checking_option(opts);
 
         optional<optional<uint64_t> > total_cache_size =
@@ -2076,6 +2552,8 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
 
         recreate_temporary_directory(base_path);
 
+        std::vector<base_path_t> extra_data_paths = parse_data_directory_options(opts);
+
         if (check_pid_file(opts) != EXIT_SUCCESS) {
             return EXIT_FAILURE;
         }
@@ -2108,6 +2586,17 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
                                 join_delay_secs.value_or(0),
                                 node_reconnect_timeout_secs.value_or(cluster_defaults::reconnect_timeout),
                                 tls_configs);
+        serve_info.backfill_load_targets = parse_backfill_load_targets_options(opts);
+        serve_info.extra_data_paths = std::move(extra_data_paths);
+        serve_info.idle_table_timeout_secs = parse_idle_table_timeout_option(opts);
+        serve_info.cluster_compression = parse_cluster_compression_option(opts);
+        serve_info.cluster_connections_per_peer =
+            parse_cluster_connections_per_peer_option(opts);
+        serve_info.query_capture = parse_query_capture_options(opts);
+        serve_info.user_quotas = parse_user_quota_options(opts);
+#ifdef FAULT_INJECTION_ENABLED
+        apply_fault_injection_options(opts);
+#endif
 
         const file_direct_io_mode_t direct_io_mode = parse_direct_io_mode_option(opts);
 
@@ -2118,13 +2607,16 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
                                      initial_password,
                                      direct_io_mode,
                                      max_concurrent_io_requests,
+                                     io_backend,
                                      total_cache_size,
                                      static_cast<server_id_t*>(nullptr),
                                      static_cast<server_config_versioned_t *>(nullptr),
                                      static_cast<cluster_semilattice_metadata_t*>(nullptr),
                                      &data_directory_lock,
                                      &result),
-                           num_workers);
+                           num_workers,
+                           exists_option(opts, "--pin-threads"),
+                           event_loop_spin_usecs);
         return result ? EXIT_SUCCESS : EXIT_FAILURE;
     } catch (const options::named_error_t &ex) {
         output_named_error(ex, help);
@@ -2211,6 +2703,14 @@ int main_rethinkdb_proxy(int argc, char *argv[]) {
                                 join_delay_secs.value_or(0),
                                 node_reconnect_timeout_secs.value_or(cluster_defaults::reconnect_timeout),
                                 tls_configs);
+        serve_info.cluster_compression = parse_cluster_compression_option(opts);
+        serve_info.cluster_connections_per_peer =
+            parse_cluster_connections_per_peer_option(opts);
+        serve_info.query_capture = parse_query_capture_options(opts);
+        serve_info.user_quotas = parse_user_quota_options(opts);
+#ifdef FAULT_INJECTION_ENABLED
+        apply_fault_injection_options(opts);
+#endif
 
         bool result;
         run_in_thread_pool(
@@ -2323,11 +2823,23 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
             return EXIT_FAILURE;
         }
 
+        int64_t event_loop_spin_usecs;
+        if (!parse_event_loop_spin_option(opts, &event_loop_spin_usecs)) {
+            return EXIT_FAILURE;
+        }
+
+        parse_huge_pages_option(opts);
+
         int max_concurrent_io_requests;
         if (!parse_io_threads_option(opts, &max_concurrent_io_requests)) {
             return EXIT_FAILURE;
         }
 
+        io_backend_t io_backend;
+        if (!parse_io_backend_option(opts, &io_backend)) {
+            return EXIT_FAILURE;
+        }
+
         update_check_t do_update_checking = parse_update_checking_option(opts);
 
         optional<int> join_delay_secs = parse_join_delay_secs_option(opts);
@@ -2353,6 +2865,8 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
 
         recreate_temporary_directory(base_path);
 
+        std::vector<base_path_t> extra_data_paths = parse_data_directory_options(opts);
+
         name_string_t server_name;
         if (is_new_directory) {
             server_name = parse_server_name_option(opts);
@@ -2401,6 +2915,17 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
                                 join_delay_secs.value_or(0),
                                 node_reconnect_timeout_secs.value_or(cluster_defaults::reconnect_timeout),
                                 tls_configs);
+        serve_info.backfill_load_targets = parse_backfill_load_targets_options(opts);
+        serve_info.extra_data_paths = std::move(extra_data_paths);
+        serve_info.idle_table_timeout_secs = parse_idle_table_timeout_option(opts);
+        serve_info.cluster_compression = parse_cluster_compression_option(opts);
+        serve_info.cluster_connections_per_peer =
+            parse_cluster_connections_per_peer_option(opts);
+        serve_info.query_capture = parse_query_capture_options(opts);
+        serve_info.user_quotas = parse_user_quota_options(opts);
+#ifdef FAULT_INJECTION_ENABLED
+        apply_fault_injection_options(opts);
+#endif
 
         const file_direct_io_mode_t direct_io_mode = parse_direct_io_mode_option(opts);
 
@@ -2412,12 +2937,15 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
                                      initial_password,
                                      direct_io_mode,
                                      max_concurrent_io_requests,
+                                     io_backend,
                                      total_cache_size,
                                      is_new_directory,
                                      &serve_info,
                                      &data_directory_lock,
                                      &result),
-                           num_workers);
+                           num_workers,
+                           exists_option(opts, "--pin-threads"),
+                           event_loop_spin_usecs);
 
         return result ? EXIT_SUCCESS : EXIT_FAILURE;
     } catch (const options::named_error_t &ex) {
@@ -236,7 +236,9 @@ bool do_serve(io_backender_t *io_backender,
                 serve_info.ports.client_port,
                 semilattice_manager_heartbeat.get_root_view(),
                 semilattice_manager_auth.get_root_view(),
-                serve_info.tls_configs.cluster.get()));
+                serve_info.tls_configs.cluster.get(),
+                serve_info.cluster_compression,
+                serve_info.cluster_connections_per_peer));
         } catch (const address_in_use_exc_t &ex) {
             throw address_in_use_exc_t(strprintf("Could not bind to cluster port: %s", ex.what()));
         }
@@ -283,7 +285,14 @@ bool do_serve(io_backender_t *io_backender,
                               nullptr,   /* we'll fill this in later */
                               semilattice_manager_auth.get_root_view(),
                               &get_global_perfmon_collection(),
-                              serve_info.reql_http_proxy);
+                              serve_info.reql_http_proxy,
+                              io_backender,
+                              base_path);
+        scoped_ptr_t<user_quotas_t> user_quotas;
+        if (!serve_info.user_quotas.is_unlimited()) {
+            user_quotas.init(new user_quotas_t(serve_info.user_quotas));
+            rdb_ctx.user_quotas = user_quotas.get();
+        }
         {
             /* Extract a subview of the directory with all the table meta manager
             business cards. */
@@ -311,8 +320,10 @@ bool do_serve(io_backender_t *io_backender,
                         io_backender,
                         cache_balancer.get(),
                         base_path,
+                        serve_info.extra_data_paths,
                         &rdb_ctx,
-                        metadata_file));
+                        metadata_file,
+                        serve_info.idle_table_timeout_secs * THOUSAND));
                 multi_table_manager.init(new multi_table_manager_t(
                     server_id,
                     &mailbox_manager,
@@ -324,6 +335,8 @@ bool do_serve(io_backender_t *io_backender,
                     base_path,
                     io_backender,
                     &perfmon_collection_repo));
+                multi_table_manager->get_backfill_throttler()->set_load_targets(
+                    serve_info.backfill_load_targets);
             } else {
                 /* Proxies still need a `multi_table_manager_t` because it takes care of
                 receiving table names, databases, and primary keys from other servers and
@@ -464,6 +477,7 @@ bool do_serve(io_backender_t *io_backender,
                 multi_table_manager->get_multi_table_manager_bcard(),
                 jobs_manager.get_business_card(),
                 stat_manager.get_address(),
+                stat_manager.get_coro_profile_address(),
                 log_server.get_business_card(),
                 i_am_a_server
                     ? local_issue_server->get_bcard()
@@ -543,7 +557,8 @@ bool do_serve(io_backender_t *io_backender,
                     &rdb_ctx,
                     &server_config_client,
                     server_id,
-                    serve_info.tls_configs.driver.get());
+                    serve_info.tls_configs.driver.get(),
+                    serve_info.query_capture);
                 logNTC("Listening for client driver connections on port %d\n",
                        rdb_query_server.get_port());
                 /* If `serve_info.ports.reql_port` was zero then the OS assigned us a
@@ -595,6 +610,8 @@ bool do_serve(io_backender_t *io_backender,
                                 serve_info.ports.local_addresses_http,
                                 serve_info.ports.http_port,
                                 rdb_query_server.get_http_app(),
+                                &rdb_ctx,
+                                table_persistence_interface.get_or_null(),
                                 serve_info.web_assets,
                                 serve_info.tls_configs.web.get()));
                         logNTC("Listening for administrative HTTP connections on port %d\n",
@@ -11,8 +11,13 @@
 #include "clustering/administration/metadata.hpp"
 #include "clustering/administration/persist/file.hpp"
 #include "clustering/administration/main/version_check.hpp"
+#include "clustering/immediate_consistency/standard_backfill_throttler.hpp"
 #include "arch/address.hpp"
 #include "arch/io/openssl.hpp"
+#include "paths.hpp"
+#include "rdb_protocol/query_capture.hpp"
+#include "rdb_protocol/user_quotas.hpp"
+#include "rpc/connectivity/message_compression.hpp"
 
 class os_signal_cond_t;
 
@@ -129,7 +134,10 @@ public:
         config_file(_config_file),
         argv(std::move(_argv)),
         join_delay_secs(_join_delay_secs),
-        node_reconnect_timeout_secs(_node_reconnect_timeout_secs)
+        node_reconnect_timeout_secs(_node_reconnect_timeout_secs),
+        cluster_compression(cluster_compression_t::none),
+        cluster_connections_per_peer(1),
+        idle_table_timeout_secs(0)
     {
         tls_configs = _tls_configs;
     }
@@ -150,7 +158,22 @@ public:
     std::vector<std::string> argv;
     int join_delay_secs;
     int node_reconnect_timeout_secs;
+    /* Set after construction, like `backfill_load_targets`. */
+    cluster_compression_t cluster_compression;
+    int cluster_connections_per_peer;
     tls_configs_t tls_configs;
+    /* Set after construction, since only servers (not proxies) use it. */
+    backfill_load_targets_t backfill_load_targets;
+    /* Directories besides the main data directory to spread table data files over,
+    from `--data-directory`. Also only used by servers. */
+    std::vector<base_path_t> extra_data_paths;
+    /* From `--idle-table-timeout`; 0 if tables never go idle. Also only used by
+    servers. */
+    int64_t idle_table_timeout_secs;
+    /* From `--capture-queries`, if it was given. */
+    optional<query_capture_config_t> query_capture;
+    /* From the `--user-max-*` options */
+    user_quota_config_t user_quotas;
 };
 
 /* This has been factored out from `command_line.hpp` because it takes a very
@@ -32,7 +32,7 @@ RDB_IMPL_SERIALIZABLE_9_FOR_CLUSTER(proc_directory_metadata_t,
     canonical_addresses,
     argv);
 
-RDB_IMPL_SERIALIZABLE_12_FOR_CLUSTER(cluster_directory_metadata_t,
+RDB_IMPL_SERIALIZABLE_13_FOR_CLUSTER(cluster_directory_metadata_t,
      server_id,
      peer_id,
      proc,
@@ -40,6 +40,7 @@ RDB_IMPL_SERIALIZABLE_12_FOR_CLUSTER(cluster_directory_metadata_t,
      multi_table_manager_bcard,
      jobs_mailbox,
      get_stats_mailbox_address,
+     coro_profile_mailbox_address,
      log_mailbox,
      local_issue_bcard,
      server_config,
@@ -125,6 +125,7 @@ public:
             const multi_table_manager_bcard_t &mtmbc,
             const jobs_manager_business_card_t& _jobs_mailbox,
             const get_stats_mailbox_address_t& _stats_mailbox,
+            const coro_profile_mailbox_address_t &_coro_profile_mailbox,
             const log_server_business_card_t &lmb,
             const local_issue_bcard_t &lib,
             const server_config_versioned_t &sc,
@@ -137,6 +138,7 @@ public:
         multi_table_manager_bcard(mtmbc),
         jobs_mailbox(_jobs_mailbox),
         get_stats_mailbox_address(_stats_mailbox),
+        coro_profile_mailbox_address(_coro_profile_mailbox),
         log_mailbox(lmb),
         local_issue_bcard(lib),
         server_config(sc),
@@ -159,6 +161,7 @@ public:
     multi_table_manager_bcard_t multi_table_manager_bcard;
     jobs_manager_business_card_t jobs_mailbox;
     get_stats_mailbox_address_t get_stats_mailbox_address;
+    coro_profile_mailbox_address_t coro_profile_mailbox_address;
     log_server_business_card_t log_mailbox;
     local_issue_bcard_t local_issue_bcard;
 
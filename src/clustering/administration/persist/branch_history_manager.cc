@@ -103,6 +103,19 @@ void real_branch_history_manager_t::prepare_gc(
 void real_branch_history_manager_t::perform_gc(
         const std::set<branch_id_t> &remove_branches)
         THROWS_NOTHING {
+    /* The executor tries to GC after every change to the Raft state, and usually there
+    is nothing to remove. Don't pay for a metadata transaction in that case. */
+    bool any_known = false;
+    for (const branch_id_t &bid : remove_branches) {
+        if (is_branch_known(bid)) {
+            any_known = true;
+            break;
+        }
+    }
+    if (!any_known) {
+        return;
+    }
+
     cond_t non_interruptor;
     metadata_file_t::write_txn_t write_txn(metadata_file, &non_interruptor);
     for (const branch_id_t &bid : remove_branches) {
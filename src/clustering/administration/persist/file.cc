@@ -9,6 +9,7 @@
 #include "clustering/administration/persist/migrate/migrate_v1_16.hpp"
 #include "clustering/administration/persist/migrate/migrate_v2_1.hpp"
 #include "clustering/administration/persist/migrate/migrate_v2_3.hpp"
+#include "clustering/administration/persist/migrate/migrate_v2_5.hpp"
 #include "clustering/administration/persist/migrate/rewrite.hpp"
 #include "config/args.hpp"
 #include "logger.hpp"
@@ -18,6 +19,12 @@
 
 const uint64_t METADATA_CACHE_SIZE = 32 * MEGABYTE;
 
+/* How long a committed write transaction waits for others before the cache writes them
+to disk together. When hundreds of tables are reconfigured at once, their Raft
+states and branch histories get written by hundreds of transactions, and this turns
+hundreds of flushes into a few. */
+const int64_t METADATA_GROUP_COMMIT_DELAY_MS = 2;
+
 ATTR_PACKED(struct metadata_disk_superblock_t {
     block_magic_t magic;
 
@@ -27,7 +34,7 @@ ATTR_PACKED(struct metadata_disk_superblock_t {
 
 // Etymology: In version 1.13, the magic was 'RDmd', for "(R)ethink(D)B (m)eta(d)ata".
 // Every subsequent version, the last character has been incremented.
-static const block_magic_t metadata_sb_magic = { { 'R', 'D', 'm', 'm' } };
+static const block_magic_t metadata_sb_magic = { { 'R', 'D', 'm', 'n' } };
 
 void init_metadata_superblock(void *sb_void, size_t block_size) {
     memset(sb_void, 0, block_size);
@@ -58,14 +65,15 @@ cluster_version_t magic_to_version(block_magic_t magic) {
     case 'j': return cluster_version_t::v2_2;
     case 'k': return cluster_version_t::v2_3;
     case 'l': return cluster_version_t::v2_4;
-    case 'm': return cluster_version_t::v2_5_is_latest_disk;
+    case 'm': return cluster_version_t::v2_5;
+    case 'n': return cluster_version_t::v2_6_is_latest_disk;
     default:
         fail_due_to_user_error("You're trying to use an earlier version of RethinkDB "
             "to open a database created by a later version of RethinkDB.");
     }
     // This is here so you don't forget to add new versions above.
     // Please also update the value of metadata_sb_magic at the top of this file!
-    static_assert(cluster_version_t::LATEST_DISK == cluster_version_t::v2_5,
+    static_assert(cluster_version_t::LATEST_DISK == cluster_version_t::v2_6,
         "Please add new version to magic_to_version.");
 }
 
@@ -260,6 +268,15 @@ metadata_file_t::write_txn_t::write_txn_t(
     read_txn_t(_file, write_access_t::write, interruptor)
     { }
 
+void metadata_file_t::write_txn_t::commit() {
+    /* The changes are in the cache by now, so the next write transaction can make its
+    own while this one is being flushed. The cache keeps the order of the flushes
+    right. Holding on to the lock until the flush is done would mean that the group
+    commit never finds more than one transaction to write. */
+    release_lock();
+    get_txn()->commit();
+}
+
 void metadata_file_t::write_txn_t::write_bin(
         const store_key_t &key,
         const write_message_t *msg,
@@ -308,6 +325,7 @@ metadata_file_t::metadata_file_t(
     balancer.init(new dummy_cache_balancer_t(METADATA_CACHE_SIZE));
     cache.init(new cache_t(serializer.get(), balancer.get(), perfmon_parent,
                            which_cpu_shard_t{0, 1}));
+    cache->configure_group_commit_delay(METADATA_GROUP_COMMIT_DELAY_MS);
     cache_conn.init(new cache_conn_t(cache.get()));
 
     /* Migrate data if necessary */
@@ -375,9 +393,22 @@ metadata_file_t::metadata_file_t(
             // The metadata is now serialized using the latest serialization version
             metadata_version = cluster_version_t::LATEST_DISK;
         } // fallthrough intentional
-        case cluster_version_t::v2_4: {
+        case cluster_version_t::v2_4: // fallthrough intentional
+        case cluster_version_t::v2_5: {
+            if (sb_lock.has()) {
+                update_metadata_superblock_version(sb_data);
+                sb_write.reset();
+                sb_lock.reset();
+            }
+
+            logNTC("Migrating cluster metadata to v2.6");
+            migrate_metadata_v2_5_to_v2_6(
+                metadata_version, &write_txn, &non_interruptor);
+
+            // The metadata is now serialized using the latest serialization version
+            metadata_version = cluster_version_t::LATEST_DISK;
         } // fallthrough intentional
-        case cluster_version_t::v2_5_is_latest_disk:
+        case cluster_version_t::v2_6_is_latest_disk:
             break;  // up-to-date, do nothing
         default: unreachable();
         }
@@ -400,6 +431,7 @@ metadata_file_t::metadata_file_t(
     init_serializer(&file_opener, perfmon_parent);
     balancer.init(new dummy_cache_balancer_t(METADATA_CACHE_SIZE));
     cache.init(new cache_t(serializer.get(), balancer.get(), perfmon_parent, which_cpu_shard_t{0, 1}));
+    cache->configure_group_commit_delay(METADATA_GROUP_COMMIT_DELAY_MS);
     cache_conn.init(new cache_conn_t(cache.get()));
 
     {
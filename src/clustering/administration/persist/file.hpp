@@ -90,6 +90,10 @@ public:
             return &txn;
         }
 
+        void release_lock() {
+            rwlock_acq.reset();
+        }
+
     private:
         friend class metadata_file_t;
 
@@ -140,9 +144,9 @@ public:
         // This acts as a safety check to make sure a transaction
         // is not interrupted in the middle, which could leave the
         // metadata in an inconsistent state.
-        void commit() {
-            get_txn()->commit();
-        }
+        // Returns once the changes are on disk. Other transactions can start while
+        // it waits, so that several commits get written to disk together.
+        void commit();
 
     private:
         friend class metadata_file_t;
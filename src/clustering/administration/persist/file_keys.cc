@@ -49,6 +49,17 @@ metadata_file_t::key_t<table_raft_stored_snapshot_t>
     return metadata_file_t::key_t<table_raft_stored_snapshot_t>("table.snapshot/");
 }
 
+metadata_file_t::key_t<std::vector<std::vector<block_id_t> > >
+        mdprefix_table_hot_blocks() {
+    return metadata_file_t::key_t<std::vector<std::vector<block_id_t> > >(
+        "table.hot_blocks/");
+}
+
+metadata_file_t::key_t<std::string>
+        mdprefix_table_data_directory() {
+    return metadata_file_t::key_t<std::string>("table.data_directory/");
+}
+
 metadata_file_t::key_t<raft_log_entry_t<table_raft_state_t> >
         mdprefix_table_raft_log() {
     return metadata_file_t::key_t<raft_log_entry_t<table_raft_state_t> >("table.log/");
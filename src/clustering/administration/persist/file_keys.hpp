@@ -2,8 +2,12 @@
 #ifndef CLUSTERING_ADMINISTRATION_PERSIST_FILE_KEYS_HPP_
 #define CLUSTERING_ADMINISTRATION_PERSIST_FILE_KEYS_HPP_
 
+#include <string>
+#include <vector>
+
 #include "clustering/administration/persist/file.hpp"
 #include "containers/uuid.hpp"
+#include "serializer/types.hpp"
 
 class auth_semilattice_metadata_t;
 class branch_birth_certificate_t;
@@ -43,6 +47,16 @@ metadata_file_t::key_t<table_raft_stored_header_t>
 metadata_file_t::key_t<table_raft_stored_snapshot_t>
     mdprefix_table_raft_snapshot();
 
+/* The blocks that were hot in the cache of each of the table's CPU shards, so that we
+can read them back in after a restart. */
+metadata_file_t::key_t<std::vector<std::vector<block_id_t> > >
+    mdprefix_table_hot_blocks();
+
+/* The directory that holds the table's data file, if it isn't the main data directory
+(see `--data-directory`). */
+metadata_file_t::key_t<std::string>
+    mdprefix_table_data_directory();
+
 /* This prefix should be followed by a string of the form `TABLE/LOG_INDEX`, where
 `TABLE` is a UUID as before, and `LOG_INDEX` is a 16-digit hexadecimal. */
 metadata_file_t::key_t<raft_log_entry_t<table_raft_state_t> >
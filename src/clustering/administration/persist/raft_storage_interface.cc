@@ -62,7 +62,7 @@ table_raft_storage_interface_t::table_raft_storage_interface_t(
                 str_to_log_index(index_str),
                 index_str.c_str(),
                 state.log.get_latest_index() + 1);
-            state.log.append(entry);
+            state.log.append(std::move(entry));
         },
         interruptor);
 }
@@ -1,41 +1,72 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "clustering/administration/persist/table_interface.hpp"
 
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
 #include <algorithm>
 #include <array>
 
+#include "arch/runtime/thread_pool.hpp"
+#include "arch/timing.hpp"
 #include "clustering/administration/persist/branch_history_manager.hpp"
 #include "clustering/administration/persist/file_keys.hpp"
 #include "clustering/administration/persist/raft_storage_interface.hpp"
 #include "clustering/administration/perfmon_collection_repo.hpp"
+#include "concurrency/cross_thread_signal.hpp"
+#include "concurrency/pump_coro.hpp"
+#include "concurrency/wait_any.hpp"
 #include "logger.hpp"
 #include "rdb_protocol/store.hpp"
+#include "serializer/backup.hpp"
 #include "serializer/log/log_serializer.hpp"
 #include "serializer/merger.hpp"
 #include "serializer/translator.hpp"
 
+/* How much of a dropped table's data file `reclaim_dropped_file()` frees at a time, and
+how long it waits in between, so that a big table doesn't keep the disk busy for as
+long as it takes to free all of it. */
+static const int64_t DROPPED_FILE_TRUNCATE_STEP = 64 * MEGABYTE;
+static const int64_t DROPPED_FILE_TRUNCATE_INTERVAL_MS = 50;
+
 class real_multistore_ptr_t :
     public multistore_ptr_t {
 public:
     real_multistore_ptr_t(
-            const namespace_id_t &table_id,
+            const namespace_id_t &_table_id,
             const serializer_filepath_t &path,
+            int _cpu_sharding_factor,
+            int block_size,
             scoped_ptr_t<real_branch_history_manager_t> &&bhm,
             const base_path_t &base_path,
             io_backender_t *io_backender,
             cache_balancer_t *cache_balancer,
             rdb_context_t *rdb_context,
             perfmon_collection_t *perfmon_collection_serializers,
+            metadata_file_t *_metadata_file,
+            std::vector<std::vector<block_id_t> > &&hot_blocks,
+            int64_t _idle_timeout_ms,
             scoped_ptr_t<thread_allocation_t> &&serializer_thread,
             std::vector<scoped_ptr_t<thread_allocation_t> > &&store_threads,
             std::map<
                 namespace_id_t, std::pair<real_multistore_ptr_t *, auto_drainer_t::lock_t>
             > *real_multistores) :
+        table_id(_table_id),
+        cpu_sharding_factor(_cpu_sharding_factor),
+        metadata_file(_metadata_file),
+        metadata_thread(get_thread_id()),
+        idle_timeout_ms(_idle_timeout_ms),
+        hot_blocks_saved_while_idle(false),
         branch_history_manager(std::move(bhm)),
+        stores(_cpu_sharding_factor),
         serializer_thread_allocation(std::move(serializer_thread)),
         store_thread_allocations(std::move(store_threads)),
         map_insertion_sentry(
-            real_multistores, table_id, std::make_pair(this, drainer.lock()))
+            real_multistores, _table_id, std::make_pair(this, drainer.lock())),
+        save_hot_blocks_pump([this](signal_t *) { save_hot_blocks(); }),
+        idle_check_pump([this](signal_t *) { check_idle(); })
     {
         // TODO: If the server gets killed when starting up, we can
         // get a database in an invalid startup state.
@@ -54,9 +85,9 @@ public:
         filepath_file_opener_t file_opener(path, io_backender);
 
         if (create) {
-            log_serializer_t::create(
-                &file_opener,
-                log_serializer_t::static_config_t());
+            log_serializer_t::static_config_t static_config;
+            static_config.block_size_ = block_size;
+            log_serializer_t::create(&file_opener, static_config);
         }
 
         // TODO: Could we handle failure when loading the serializer?  Right
@@ -73,18 +104,21 @@ public:
         std::vector<serializer_t *> ptrs;
         ptrs.push_back(serializer.get());
         if (create) {
-            serializer_multiplexer_t::create(ptrs, CPU_SHARDING_FACTOR);
+            serializer_multiplexer_t::create(ptrs, cpu_sharding_factor);
         }
         multiplexer.init(new serializer_multiplexer_t(ptrs));
+        guarantee(multiplexer->proxies.size() == stores.size(),
+            "The number of CPU shards in the table's data file doesn't match its "
+            "configuration.");
 
-        pmap(CPU_SHARDING_FACTOR, [&](int ix) {
+        pmap(cpu_sharding_factor, [&](int ix) {
             // TODO: Exceptions? If exceptions are being thrown in here, nothing is
             // handling them.
 
             on_thread_t thread_switcher_2(store_thread_allocations[ix]->get_thread());
 
             stores[ix].init(new store_t(
-                cpu_sharding_subspace(ix),
+                cpu_sharding_subspace(ix, cpu_sharding_factor),
                 multiplexer->proxies[ix],
                 cache_balancer,
                 strprintf("shard_%d", ix),
@@ -95,7 +129,7 @@ public:
                 base_path,
                 table_id,
                 update_sindexes_t::UPDATE,
-                which_cpu_shard_t{ix, CPU_SHARDING_FACTOR}));
+                which_cpu_shard_t{ix, cpu_sharding_factor}));
 
             /* Initialize the metainfo if necessary */
             if (create) {
@@ -111,20 +145,46 @@ public:
                     &write_token,
                     write_durability_t::HARD,
                     &non_interruptor);
+            } else if (hot_blocks.size() == stores.size()) {
+                if (idle_timeout_ms != 0) {
+                    /* Tables start out idle, so that the ones that aren't used don't
+                    take up cache memory or disk bandwidth. The blocks that were hot
+                    before the restart are read back in when the table is first
+                    used. */
+                    stores[ix]->enter_idle_mode(std::move(hot_blocks[ix]));
+                } else {
+                    /* Read the blocks that were hot before the restart back into the
+                    cache. This happens in the background. */
+                    stores[ix]->warm_up_cache(std::move(hot_blocks[ix]));
+                }
             }
         });
 
         if (create) {
             file_opener.move_serializer_file_to_permanent_location();
         }
+
+        on_thread_t thread_switcher_3(metadata_thread);
+        save_hot_blocks_timer.init(new repeating_timer_t(
+            CACHE_WARM_UP_SAVE_INTERVAL_MS,
+            [this]() { save_hot_blocks_pump.notify(); }));
+        if (idle_timeout_ms != 0) {
+            idle_check_timer.init(new repeating_timer_t(
+                idle_timeout_ms,
+                [this]() { idle_check_pump.notify(); }));
+        }
     }
 
     ~real_multistore_ptr_t() {
+        idle_check_timer.reset();
+        idle_check_pump.drain();
+        save_hot_blocks_timer.reset();
+        save_hot_blocks_pump.drain();
         serializer_thread_allocation.reset();
         store_thread_allocations.clear();
         map_insertion_sentry.reset();
         drainer.drain();
-        pmap(CPU_SHARDING_FACTOR, [this](int ix) {
+        pmap(cpu_sharding_factor, [this](int ix) {
             if (stores[ix].has()) {
                 on_thread_t thread_switcher(stores[ix]->home_thread());
                 stores[ix].reset();
@@ -147,6 +207,10 @@ public:
         return serializer.get_or_null();
     }
 
+    int get_cpu_sharding_factor() {
+        return cpu_sharding_factor;
+    }
+
     store_view_t *get_cpu_sharded_store(size_t i) {
         return stores[i].get();
     }
@@ -165,10 +229,68 @@ public:
     }
 
 private:
+    /* Records which blocks are hot in each store's cache in the metadata file, so that
+    the next time we load the table we can warm up the caches with them. */
+    void save_hot_blocks() {
+        std::vector<std::vector<block_id_t> > hot_blocks(cpu_sharding_factor);
+        std::vector<bool> idle(cpu_sharding_factor);
+        pmap(cpu_sharding_factor, [&](int ix) {
+            on_thread_t thread_switcher(stores[ix]->home_thread());
+            hot_blocks[ix] = stores[ix]->get_hot_block_ids(CACHE_WARM_UP_MAX_BLOCKS);
+            idle[ix] = stores[ix]->is_idle();
+        });
+        on_thread_t thread_switcher(metadata_thread);
+        /* The hot blocks of an idle store don't change, so once they have been saved
+        we don't write them again until the table is used. */
+        bool all_idle = std::find(idle.begin(), idle.end(), false) == idle.end();
+        if (all_idle && hot_blocks_saved_while_idle) {
+            return;
+        }
+        hot_blocks_saved_while_idle = all_idle;
+        cond_t non_interruptor;
+        metadata_file_t::write_txn_t write_txn(metadata_file, &non_interruptor);
+        write_txn.write(
+            mdprefix_table_hot_blocks().suffix(uuid_to_str(table_id)),
+            hot_blocks,
+            &non_interruptor);
+        write_txn.commit();
+    }
+
+    /* Puts the stores into idle mode if none of them has been used since the last
+    check, so a table goes idle after between one and two `idle_timeout_ms` without
+    being used. */
+    void check_idle() {
+        std::vector<uint64_t> access_counts(cpu_sharding_factor);
+        pmap(cpu_sharding_factor, [&](int ix) {
+            on_thread_t thread_switcher(stores[ix]->home_thread());
+            access_counts[ix] = stores[ix]->get_access_count();
+        });
+        on_thread_t thread_switcher(metadata_thread);
+        if (access_counts != last_access_counts) {
+            last_access_counts = std::move(access_counts);
+            return;
+        }
+        pmap(cpu_sharding_factor, [&](int ix) {
+            on_thread_t thread_switcher_2(stores[ix]->home_thread());
+            if (!stores[ix]->is_idle()) {
+                stores[ix]->enter_idle_mode(
+                    stores[ix]->get_hot_block_ids(CACHE_WARM_UP_MAX_BLOCKS));
+            }
+        });
+    }
+
+    const namespace_id_t table_id;
+    const int cpu_sharding_factor;
+    metadata_file_t * const metadata_file;
+    const threadnum_t metadata_thread;
+    /* From `--idle-table-timeout`, or 0 if tables never go idle */
+    const int64_t idle_timeout_ms;
+    std::vector<uint64_t> last_access_counts;
+    bool hot_blocks_saved_while_idle;
     scoped_ptr_t<real_branch_history_manager_t> branch_history_manager;
     scoped_ptr_t<serializer_t> serializer;
     scoped_ptr_t<serializer_multiplexer_t> multiplexer;
-    scoped_ptr_t<store_t> stores[CPU_SHARDING_FACTOR];
+    std::vector<scoped_ptr_t<store_t> > stores;
 
     scoped_ptr_t<thread_allocation_t> serializer_thread_allocation;
     std::vector<scoped_ptr_t<thread_allocation_t> > store_thread_allocations;
@@ -178,6 +300,12 @@ private:
         namespace_id_t, std::pair<real_multistore_ptr_t *, auto_drainer_t::lock_t>
     > map_insertion_sentry;
 
+    pump_coro_t save_hot_blocks_pump;
+    scoped_ptr_t<repeating_timer_t> save_hot_blocks_timer;
+
+    pump_coro_t idle_check_pump;
+    scoped_ptr_t<repeating_timer_t> idle_check_timer;
+
     DISABLE_COPYING(real_multistore_ptr_t);
 };
 
@@ -254,6 +382,12 @@ void real_table_persistence_interface_t::write_metadata_inactive(
         &non_interruptor);
     table_raft_storage_interface_t::erase(&write_txn, table_id);
     real_branch_history_manager_t::erase(&write_txn, table_id);
+    write_txn.erase(
+        mdprefix_table_hot_blocks().suffix(uuid_to_str(table_id)),
+        &non_interruptor);
+    write_txn.erase(
+        mdprefix_table_data_directory().suffix(uuid_to_str(table_id)),
+        &non_interruptor);
     write_txn.commit();
 }
 
@@ -270,11 +404,19 @@ void real_table_persistence_interface_t::delete_metadata(
         &non_interruptor);
     table_raft_storage_interface_t::erase(&write_txn, table_id);
     real_branch_history_manager_t::erase(&write_txn, table_id);
+    write_txn.erase(
+        mdprefix_table_hot_blocks().suffix(uuid_to_str(table_id)),
+        &non_interruptor);
+    write_txn.erase(
+        mdprefix_table_data_directory().suffix(uuid_to_str(table_id)),
+        &non_interruptor);
     write_txn.commit();
 }
 
 void real_table_persistence_interface_t::load_multistore(
         const namespace_id_t &table_id,
+        int cpu_sharding_factor,
+        int block_size,
         metadata_file_t::read_txn_t *metadata_read_txn,
         scoped_ptr_t<multistore_ptr_t> *multistore_ptr_out,
         signal_t *interruptor,
@@ -283,22 +425,39 @@ void real_table_persistence_interface_t::load_multistore(
         new real_branch_history_manager_t(
             table_id, metadata_file, metadata_read_txn, interruptor));
 
+    table_data_paths[table_id] =
+        find_data_path(table_id, metadata_read_txn, interruptor);
+
+    std::vector<std::vector<block_id_t> > hot_blocks;
+    metadata_read_txn->read_maybe(
+        mdprefix_table_hot_blocks().suffix(uuid_to_str(table_id)),
+        &hot_blocks,
+        interruptor);
+
     scoped_ptr_t<thread_allocation_t> serializer_thread(
         new thread_allocation_t(&thread_allocator));
+    /* The CPU shards go on the serializer's NUMA node, so that their page caches don't
+    have to talk to the serializer across nodes. */
     std::vector<scoped_ptr_t<thread_allocation_t> > store_threads;
-    for (size_t i = 0; i < CPU_SHARDING_FACTOR; ++i) {
-        store_threads.emplace_back(new thread_allocation_t(&thread_allocator));
+    for (int i = 0; i < cpu_sharding_factor; ++i) {
+        store_threads.emplace_back(new thread_allocation_t(
+            &thread_allocator, serializer_thread->get_thread()));
     }
 
     multistore_ptr_out->init(new real_multistore_ptr_t(
         table_id,
         file_name_for(table_id),
+        cpu_sharding_factor,
+        block_size,
         std::move(bhm),
         base_path,
         io_backender,
         cache_balancer,
         rdb_context,
         perfmon_collection_serializers,
+        metadata_file,
+        std::move(hot_blocks),
+        idle_table_timeout_ms,
         std::move(serializer_thread),
         std::move(store_threads),
         &real_multistores));
@@ -306,13 +465,42 @@ void real_table_persistence_interface_t::load_multistore(
 
 void real_table_persistence_interface_t::create_multistore(
         const namespace_id_t &table_id,
+        int cpu_sharding_factor,
+        int block_size,
         scoped_ptr_t<multistore_ptr_t> *multistore_ptr_out,
         signal_t *interruptor,
         perfmon_collection_t *perfmon_collection_serializers) {
+    if (data_paths.size() > 1) {
+        /* If the table doesn't have a data file yet, decide where to put it. Data files
+        in the main data directory don't get a record, so that they are found even
+        after the extra data directories have been removed from the command line. */
+        bool has_record;
+        {
+            metadata_file_t::read_txn_t read_txn(metadata_file, interruptor);
+            std::string directory;
+            has_record = read_txn.read_maybe(
+                mdprefix_table_data_directory().suffix(uuid_to_str(table_id)),
+                &directory,
+                interruptor);
+        }
+        serializer_filepath_t default_path(base_path, uuid_to_str(table_id));
+        if (!has_record && access(default_path.permanent_path().c_str(), F_OK) != 0) {
+            size_t data_path_index = pick_data_path();
+            if (data_path_index != 0) {
+                metadata_file_t::write_txn_t write_txn(metadata_file, interruptor);
+                write_txn.write(
+                    mdprefix_table_data_directory().suffix(uuid_to_str(table_id)),
+                    data_paths[data_path_index].path(),
+                    interruptor);
+                write_txn.commit();
+            }
+        }
+    }
+
     metadata_file_t::read_txn_t read_txn(metadata_file, interruptor);
     load_multistore(
-        table_id, &read_txn, multistore_ptr_out, interruptor,
-        perfmon_collection_serializers);
+        table_id, cpu_sharding_factor, block_size, &read_txn, multistore_ptr_out,
+        interruptor, perfmon_collection_serializers);
 }
 
 void real_table_persistence_interface_t::destroy_multistore(
@@ -322,15 +510,137 @@ void real_table_persistence_interface_t::destroy_multistore(
     multistore_ptr_in->reset();
 
     std::string filepath = file_name_for(table_id).permanent_path();
+    std::string dropped_path =
+        temporary_directory_path(data_paths[table_data_paths.at(table_id)])
+        + PATH_SEPARATOR + uuid_to_str(table_id) + ".drop";
+    table_data_paths.erase(table_id);
     logNTC("Removing file %s\n", filepath.c_str());
-    const int res = ::unlink(filepath.c_str());
-    guarantee_err(res == 0 || get_errno() == ENOENT,
-                  "unlink failed for file %s", filepath.c_str());
+
+    /* Deleting a big file can keep the thread busy for a long time, and so can freeing
+    its disk space. So we only move the file into the temporary directory here, which
+    is quick, and free its space in the background. If we crash before that's done,
+    the file is deleted along with the rest of the temporary directory when the
+    server starts, so it doesn't leak. */
+    int res = ::rename(filepath.c_str(), dropped_path.c_str());
+    if (res == 0) {
+        coro_t::spawn_sometime(std::bind(
+            &real_table_persistence_interface_t::reclaim_dropped_file, this,
+            dropped_path, drainer.lock()));
+    } else if (get_errno() != ENOENT) {
+        res = ::unlink(filepath.c_str());
+        guarantee_err(res == 0 || get_errno() == ENOENT,
+                      "unlink failed for file %s", filepath.c_str());
+    }
+}
+
+void real_table_persistence_interface_t::reclaim_dropped_file(
+        const std::string &path,
+        auto_drainer_t::lock_t keepalive) {
+    try {
+#ifndef _WIN32
+        /* Shrinking the file frees its disk space from the end, so we can spread the
+        work out. The `unlink()` below then has little left to do. */
+        int64_t size = 0;
+        thread_pool_t::run_in_blocker_pool([&]() {
+            struct stat file_stat;
+            if (::stat(path.c_str(), &file_stat) == 0) {
+                size = file_stat.st_size;
+            }
+        });
+        while (size > 0) {
+            size = std::max<int64_t>(0, size - DROPPED_FILE_TRUNCATE_STEP);
+            int res;
+            thread_pool_t::run_in_blocker_pool([&]() {
+                res = ::truncate(path.c_str(), size);
+            });
+            if (res != 0) {
+                break;
+            }
+            nap(DROPPED_FILE_TRUNCATE_INTERVAL_MS, keepalive.get_drain_signal());
+        }
+#endif
+        int error = 0;
+        thread_pool_t::run_in_blocker_pool([&]() {
+            if (::unlink(path.c_str()) != 0) {
+                error = get_errno();
+            }
+        });
+        if (error != 0 && error != ENOENT) {
+            logWRN("Failed to delete the data file of a dropped table %s: %s",
+                   path.c_str(), errno_string(error).c_str());
+        }
+    } catch (const interrupted_exc_t &) {
+        /* We're shutting down */
+    }
+}
+
+size_t real_table_persistence_interface_t::find_data_path(
+        const namespace_id_t &table_id,
+        metadata_file_t::read_txn_t *metadata_read_txn,
+        signal_t *interruptor) {
+    std::string directory;
+    if (!metadata_read_txn->read_maybe(
+            mdprefix_table_data_directory().suffix(uuid_to_str(table_id)),
+            &directory,
+            interruptor)) {
+        return 0;
+    }
+    for (size_t i = 0; i < data_paths.size(); ++i) {
+        if (data_paths[i].path() == directory) {
+            return i;
+        }
+    }
+    fail_due_to_user_error(
+        "The data file of table %s is in the directory '%s', which isn't one of the "
+        "server's data directories. Restart the server with `--data-directory %s`.",
+        uuid_to_str(table_id).c_str(), directory.c_str(), directory.c_str());
+}
+
+size_t real_table_persistence_interface_t::pick_data_path() {
+    std::vector<size_t> num_tables(data_paths.size(), 0);
+    for (const auto &pair : table_data_paths) {
+        ++num_tables[pair.second];
+    }
+    return std::min_element(num_tables.begin(), num_tables.end()) - num_tables.begin();
 }
 
 serializer_filepath_t real_table_persistence_interface_t::file_name_for(
         const namespace_id_t &table_id) {
-    return serializer_filepath_t(base_path, uuid_to_str(table_id));
+    auto it = table_data_paths.find(table_id);
+    guarantee(it != table_data_paths.end());
+    return serializer_filepath_t(data_paths[it->second], uuid_to_str(table_id));
+}
+
+bool real_table_persistence_interface_t::backup_table(
+        const namespace_id_t &table_id,
+        const std::string &path,
+        bool compress,
+        signal_t *interruptor,
+        std::string *error_out)
+        THROWS_ONLY(interrupted_exc_t) {
+    auto it = real_multistores.find(table_id);
+    if (it == real_multistores.end() || it->second.first->get_serializer() == nullptr) {
+        *error_out = "This server doesn't have a replica of the table.";
+        return false;
+    }
+    serializer_t *serializer = it->second.first->get_serializer();
+    /* This keeps the data file open until the backup is done. Closing the file, for
+    example because the table is dropped, interrupts the backup. */
+    auto_drainer_t::lock_t keepalive = it->second.second;
+    try {
+        wait_any_t combined_interruptor(interruptor, keepalive.get_drain_signal());
+        cross_thread_signal_t ct_interruptor(
+            &combined_interruptor, serializer->home_thread());
+        on_thread_t thread_switcher(serializer->home_thread());
+        return write_serializer_backup(
+            serializer, path, compress, &ct_interruptor, error_out);
+    } catch (const interrupted_exc_t &) {
+        if (interruptor->is_pulsed()) {
+            throw;
+        }
+        *error_out = "The table's data file was closed during the backup.";
+        return false;
+    }
 }
 
 bool real_table_persistence_interface_t::is_gc_active() const {
@@ -2,6 +2,10 @@
 #ifndef CLUSTERING_ADMINISTRATION_PERSIST_TABLE_INTERFACE_HPP_
 #define CLUSTERING_ADMINISTRATION_PERSIST_TABLE_INTERFACE_HPP_
 
+#include <map>
+#include <string>
+#include <vector>
+
 #include "clustering/administration/perfmon_collection_repo.hpp"
 #include "clustering/administration/persist/raft_storage_interface.hpp"
 #include "clustering/table_manager/table_metadata.hpp"
@@ -18,20 +22,26 @@ public:
             io_backender_t *_io_backender,
             cache_balancer_t *_cache_balancer,
             const base_path_t &_base_path,
+            const std::vector<base_path_t> &extra_data_paths,
             rdb_context_t *_rdb_context,
-            metadata_file_t *_metadata_file) :
+            metadata_file_t *_metadata_file,
+            int64_t _idle_table_timeout_ms) :
         io_backender(_io_backender),
         cache_balancer(_cache_balancer),
         base_path(_base_path),
         rdb_context(_rdb_context),
         metadata_file(_metadata_file),
+        idle_table_timeout_ms(_idle_table_timeout_ms),
         /* We assign threads from the lowest thread number upwards. This is to reduce
         the potential for conflicting with cluster connection threads, which are
         assigned from the highest thread number downwards. */
         thread_allocator([](threadnum_t a, threadnum_t b) {
             return a.threadnum < b.threadnum;
-        })
-        { }
+        }) {
+        data_paths.push_back(base_path);
+        data_paths.insert(
+            data_paths.end(), extra_data_paths.begin(), extra_data_paths.end());
+    }
 
     void read_all_metadata(
         const std::function<void(
@@ -57,12 +67,16 @@ public:
 
     void load_multistore(
         const namespace_id_t &table_id,
+        int cpu_sharding_factor,
+        int block_size,
         metadata_file_t::read_txn_t *metadata_read_txn,
         scoped_ptr_t<multistore_ptr_t> *multistore_ptr_out,
         signal_t *interruptor,
         perfmon_collection_t *perfmon_collection_serializers);
     void create_multistore(
         const namespace_id_t &table_id,
+        int cpu_sharding_factor,
+        int block_size,
         scoped_ptr_t<multistore_ptr_t> *multistore_ptr_out,
         signal_t *interruptor,
         perfmon_collection_t *perfmon_collection_serializers);
@@ -72,15 +86,47 @@ public:
 
     bool is_gc_active() const;
 
+    /* Writes a block backup of the table's data file to `path` (see
+    `serializer/backup.hpp`). Returns false and sets `*error_out` if this server
+    doesn't have the table, the table is closed in the meantime, or the file can't be
+    written. */
+    bool backup_table(
+        const namespace_id_t &table_id,
+        const std::string &path,
+        bool compress,
+        signal_t *interruptor,
+        std::string *error_out)
+        THROWS_ONLY(interrupted_exc_t);
+
 private:
+    /* Returns the index in `data_paths` of the directory that holds (or will hold) the
+    table's data file, according to the metadata. */
+    size_t find_data_path(
+        const namespace_id_t &table_id,
+        metadata_file_t::read_txn_t *metadata_read_txn,
+        signal_t *interruptor);
+    /* Picks the directory for a new data file: the one that holds the fewest loaded
+    tables, preferring the main data directory on ties. */
+    size_t pick_data_path();
+
     serializer_filepath_t file_name_for(const namespace_id_t &table_id);
     threadnum_t pick_thread();
 
+    /* Frees the disk space of a dropped table's data file a step at a time, and then
+    deletes it. See `destroy_multistore()`. */
+    void reclaim_dropped_file(const std::string &path, auto_drainer_t::lock_t keepalive);
+
     io_backender_t * const io_backender;
     cache_balancer_t * const cache_balancer;
     base_path_t const base_path;
+    /* `base_path` followed by the extra directories for table data files. New tables'
+    data files are spread over these. */
+    std::vector<base_path_t> data_paths;
     rdb_context_t * const rdb_context;
     metadata_file_t * const metadata_file;
+    /* From `--idle-table-timeout`. Tables that haven't been used for this long give up
+    their cache memory until they are used again. 0 if they never do. */
+    const int64_t idle_table_timeout_ms;
 
     std::map<
         namespace_id_t, std::pair<real_multistore_ptr_t *, auto_drainer_t::lock_t>
@@ -89,8 +135,15 @@ private:
     std::map<namespace_id_t, scoped_ptr_t<table_raft_storage_interface_t> >
         storage_interfaces;
 
+    /* The index in `data_paths` of the directory of each loaded table's data file */
+    std::map<namespace_id_t, size_t> table_data_paths;
+
     /* Used to distribute objects evenly over threads */
     thread_allocator_t thread_allocator;
+
+    /* Stops `reclaim_dropped_file()` when we shut down. Whatever is left of the file is
+    deleted with the rest of the temporary directory when the server starts again. */
+    auto_drainer_t drainer;
 };
 
 #endif /* CLUSTERING_ADMINISTRATION_PERSIST_TABLE_INTERFACE_HPP_ */
@@ -6,6 +6,7 @@
 #include "clustering/administration/datum_adapter.hpp"
 #include "clustering/administration/main/watchable_fields.hpp"
 #include "clustering/administration/servers/config_client.hpp"
+#include "clustering/administration/servers/server_status.hpp"
 #include "clustering/administration/tables/calculate_status.hpp"
 #include "clustering/administration/tables/generate_config.hpp"
 #include "clustering/administration/tables/split_points.hpp"
@@ -55,7 +56,9 @@ real_reql_cluster_interface_t::real_reql_cluster_interface_t(
             return this->m_namespace_repo.get_namespace_interface(id, interruptor);
         },
         name_resolver),
-    m_server_config_client(server_config_client)
+    m_read_cache(&m_changefeed_client, m_table_meta_client),
+    m_server_config_client(server_config_client),
+    m_table_query_directory(table_query_directory)
 {
     guarantee(m_auth_semilattice_view->home_thread() == home_thread());
     guarantee(m_cluster_semilattice_view->home_thread() == home_thread());
@@ -292,6 +295,8 @@ bool real_reql_cluster_interface_t::table_create(
         const table_generate_config_params_t &config_params,
         const std::string &primary_key,
         write_durability_t durability,
+        int cpu_sharding_factor,
+        int block_size,
         signal_t *interruptor_on_caller,
         ql::datum_t *result_out,
         admin_err_t *error_out) {
@@ -335,6 +340,9 @@ bool real_reql_cluster_interface_t::table_create(
         config.config.write_ack_config = write_ack_config_t::MAJORITY;
         config.config.durability = durability;
         config.config.user_data = default_user_data();
+        config.config.cpu_sharding_factor = cpu_sharding_factor;
+        config.config.block_size = block_size;
+        config.config.read_cache = false;
 
         table_id = generate_uuid();
         m_table_meta_client->create(table_id, config, &interruptor_on_home);
@@ -479,7 +487,8 @@ bool real_reql_cluster_interface_t::table_find(
             m_namespace_repo.get_namespace_interface(table_id, interruptor_on_caller),
             primary_key,
             &m_changefeed_client,
-            m_table_meta_client));
+            m_table_meta_client,
+            &m_read_cache));
 
         return true;
     } CATCH_NAME_ERRORS(db->name, name, error_out)
@@ -509,7 +518,7 @@ bool real_reql_cluster_interface_t::table_estimate_doc_counts(
 
         /* Perform a distribution query against the database */
         std::map<store_key_t, int64_t> counts;
-        fetch_distribution(table_id, this, &interruptor_on_home, &counts);
+        fetch_distribution(table_id, this, &interruptor_on_home, &counts, nullptr);
 
         /* Match the results of the distribution query against the table's shard
         boundaries */
@@ -539,6 +548,96 @@ bool real_reql_cluster_interface_t::table_estimate_doc_counts(
       CATCH_OP_ERRORS(db->name, name, error_out, "", "")
 }
 
+bool real_reql_cluster_interface_t::table_shard_map(
+        auth::user_context_t const &user_context,
+        counted_t<const ql::db_t> db,
+        const name_string_t &name,
+        UNUSED ql::env_t *env,
+        ql::datum_t *shard_map_out,
+        admin_err_t *error_out) {
+    guarantee(db->name != name_string_t::guarantee_valid("rethinkdb"),
+        "real_reql_cluster_interface_t should never get queries for system tables");
+
+    try {
+        on_thread_t thread_switcher(home_thread());
+
+        namespace_id_t table_id;
+        m_table_meta_client->find(db->id, name, &table_id);
+
+        user_context.require_read_permission(m_rdb_context, db->id, table_id);
+
+        /* These are the same directory entries that `table_query_client_t` builds its
+        relationships from, so a driver routing by this map reaches the same primaries
+        that the server would forward the query to. */
+        std::map<key_range_t, peer_id_t> primaries;
+        m_table_query_directory->read_all(
+            [&](const std::pair<peer_id_t, std::pair<namespace_id_t, branch_id_t> > &key,
+                    const table_query_bcard_t *bcard) {
+                if (key.second.first == table_id &&
+                        static_cast<bool>(bcard->primary)) {
+                    primaries[bcard->region.inner] = key.first;
+                }
+            });
+
+        ql::datum_array_builder_t shards_builder(ql::configured_limits_t::unlimited);
+        for (const auto &pair : primaries) {
+            optional<server_id_t> server_id =
+                m_server_config_client->get_peer_to_server_map()->get_key(pair.second);
+            if (!static_cast<bool>(server_id)) {
+                /* The server disconnected after we read the directory */
+                continue;
+            }
+            ql::datum_object_builder_t primary_builder;
+            primary_builder.overwrite("server_id", convert_server_id_to_datum(*server_id));
+            m_server_config_client->get_server_config_map()->read_key(*server_id,
+                [&](const server_config_versioned_t *config) {
+                    if (config != nullptr) {
+                        primary_builder.overwrite("server",
+                            convert_name_to_datum(config->config.name));
+                    }
+                });
+            m_server_config_client->get_directory_view()->read_key(pair.second,
+                [&](const cluster_directory_metadata_t *metadata) {
+                    if (metadata != nullptr) {
+                        primary_builder.overwrite("reql_port",
+                            convert_port_to_datum(metadata->proc.reql_port));
+                        primary_builder.overwrite("canonical_addresses",
+                            convert_set_to_datum<host_and_port_t>(
+                                &convert_host_and_port_to_datum,
+                                metadata->proc.canonical_addresses));
+                    }
+                });
+
+            /* The bounds are the server's internal primary key encoding, which is what
+            the driver has to compute for a key before looking it up in the map. */
+            ql::datum_array_builder_t range_builder(ql::configured_limits_t::unlimited);
+            range_builder.add(ql::datum_t::binary(datum_string_t(
+                pair.first.left.size(),
+                reinterpret_cast<const char *>(pair.first.left.contents()))));
+            range_builder.add(pair.first.right.unbounded
+                ? ql::datum_t::null()
+                : ql::datum_t::binary(datum_string_t(
+                    pair.first.right.key().size(),
+                    reinterpret_cast<const char *>(pair.first.right.key().contents()))));
+
+            ql::datum_object_builder_t shard_builder;
+            shard_builder.overwrite("key_range", std::move(range_builder).to_datum());
+            shard_builder.overwrite("primary", std::move(primary_builder).to_datum());
+            shards_builder.add(std::move(shard_builder).to_datum());
+        }
+        ql::datum_t shards = std::move(shards_builder).to_datum();
+
+        /* Drivers compare `version` against the one they cached to find out if the
+        routing changed, e.g. after a failover or a reshard. */
+        ql::datum_object_builder_t builder;
+        builder.overwrite("version", ql::datum_t(datum_string_t(strprintf(
+            "%016zx", std::hash<std::string>()(shards.print())))));
+        builder.overwrite("shards", shards);
+        *shard_map_out = std::move(builder).to_datum();
+        return true;
+    } CATCH_NAME_ERRORS(db->name, name, error_out)
+}
+
 bool real_reql_cluster_interface_t::table_config(
         auth::user_context_t const &user_context,
         counted_t<const ql::db_t> db,
@@ -691,6 +790,10 @@ void real_reql_cluster_interface_t::reconfigure_internal(
     new_config.config.write_ack_config = old_config.config.write_ack_config;
     new_config.config.durability = old_config.config.durability;
     new_config.config.user_data = old_config.config.user_data;
+    new_config.config.cpu_sharding_factor = old_config.config.cpu_sharding_factor;
+    new_config.config.block_size = old_config.config.block_size;
+    new_config.config.expiry_field = old_config.config.expiry_field;
+    new_config.config.read_cache = old_config.config.read_cache;
 
     calculate_split_points_intelligently(
         table_id,
@@ -1010,14 +1113,21 @@ void real_reql_cluster_interface_t::rebalance_internal(
         throw no_such_table_exc_t();
     }
 
-    std::map<store_key_t, int64_t> counts;
-    fetch_distribution(table_id, this, interruptor_on_home, &counts);
+    std::map<store_key_t, int64_t> counts, loads;
+    fetch_distribution(table_id, this, interruptor_on_home, &counts, &loads);
 
     /* If there's not enough data to rebalance, return `rebalanced: 0` but don't report
-    an error */
-    bool actually_rebalanced = calculate_split_points_with_distribution(
-        counts, config.config.shards.size(), &config.shard_scheme);
-    if (actually_rebalanced) {
+    an error. Split points that are already close to where they should be stay where
+    they are, so that rebalancing a table that's nearly balanced moves little data. */
+    table_shard_scheme_t new_shard_scheme;
+    bool actually_rebalanced = adjust_split_points_with_distribution(
+        combine_distribution_with_loads(counts, loads),
+        config.shard_scheme,
+        REBALANCE_TOLERANCE,
+        &new_shard_scheme);
+    if (actually_rebalanced
+            && new_shard_scheme.split_points != config.shard_scheme.split_points) {
+        config.shard_scheme = std::move(new_shard_scheme);
         table_config_and_shards_change_t table_config_and_shards_change(
             table_config_and_shards_change_t::set_table_config_and_shards_t{ config });
         m_table_meta_client->set_config(
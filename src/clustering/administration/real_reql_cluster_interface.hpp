@@ -12,6 +12,7 @@
 #include "concurrency/cross_thread_watchable.hpp"
 #include "concurrency/watchable.hpp"
 #include "rdb_protocol/context.hpp"
+#include "rdb_protocol/read_cache.hpp"
 #include "rpc/semilattice/view.hpp"
 
 class artificial_reql_cluster_interface_t;
@@ -86,6 +87,8 @@ public:
             const table_generate_config_params_t &config_params,
             const std::string &primary_key,
             write_durability_t durability,
+            int cpu_sharding_factor,
+            int block_size,
             signal_t *interruptor,
             ql::datum_t *result_out,
             admin_err_t *error_out);
@@ -114,6 +117,13 @@ public:
             ql::env_t *env,
             std::vector<int64_t> *doc_counts_out,
             admin_err_t *error_out);
+    bool table_shard_map(
+            auth::user_context_t const &user_context,
+            counted_t<const ql::db_t> db,
+            const name_string_t &name,
+            ql::env_t *env,
+            ql::datum_t *shard_map_out,
+            admin_err_t *error_out);
     bool table_config(
             auth::user_context_t const &user_context,
             counted_t<const ql::db_t> db,
@@ -285,7 +295,11 @@ private:
 
     namespace_repo_t m_namespace_repo;
     ql::changefeed::client_t m_changefeed_client;
+    read_cache_t m_read_cache;
     server_config_client_t *m_server_config_client;
+    watchable_map_t<
+        std::pair<peer_id_t, std::pair<namespace_id_t, branch_id_t> >,
+        table_query_bcard_t> *m_table_query_directory;
 
     void wait_for_cluster_metadata_to_propagate(
             const cluster_semilattice_metadata_t &metadata,
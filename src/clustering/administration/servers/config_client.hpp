@@ -41,6 +41,12 @@ public:
         return &server_to_peer_map;
     }
 
+    /* `get_directory_view()` returns the directory metadata of every connected server,
+    indexed by peer ID. */
+    watchable_map_t<peer_id_t, cluster_directory_metadata_t> *get_directory_view() {
+        return directory_view;
+    }
+
     /* This map contains the pair (X, Y) if we can see server X and server X can see
     server Y. */
     watchable_map_t<std::pair<server_id_t, server_id_t>, empty_value_t>
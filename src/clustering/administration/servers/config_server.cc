@@ -1,10 +1,21 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "clustering/administration/servers/config_server.hpp"
 
+#include <algorithm>
+
 #include "clustering/administration/main/cache_size.hpp"
 #include "clustering/administration/persist/file.hpp"
 #include "clustering/administration/persist/file_keys.hpp"
 
+/* An automatically sized cache shrinks by an eighth every time some task has been
+waiting for memory for at least `SHRINK_MEMORY_PRESSURE` percent of the last ten seconds,
+or our cgroup uses more than 90% of its limit. It grows back by a sixteenth when
+there's almost no pressure and the cgroup is below 80% of its limit. Growing slower than
+we shrink keeps it from oscillating. */
+static const double SHRINK_MEMORY_PRESSURE = 10.0;
+static const double GROW_MEMORY_PRESSURE = 1.0;
+static const uint64_t MIN_AUTO_CACHE_SIZE = 100 * MEGABYTE;
+
 server_config_server_t::server_config_server_t(
         mailbox_manager_t *_mailbox_manager,
         metadata_file_t *_file) :
@@ -12,9 +23,13 @@ server_config_server_t::server_config_server_t(
     file(_file),
     my_config(server_config_versioned_t()),
     actual_cache_size_bytes(0),
+    auto_cache_size_target(0),
+    adjusting_cache_size(false),
     set_config_mailbox(mailbox_manager,
         std::bind(&server_config_server_t::on_set_config, this,
-            ph::_1, ph::_2, ph::_3))
+            ph::_1, ph::_2, ph::_3)),
+    memory_pressure_timer(CACHE_SIZE_MEMORY_PRESSURE_INTERVAL_MS,
+        std::bind(&server_config_server_t::on_memory_pressure_timer, this))
 {
     cond_t non_interruptor;
     metadata_file_t::read_txn_t read_txn(file, &non_interruptor);
@@ -70,8 +85,10 @@ void server_config_server_t::on_set_config(
 void server_config_server_t::update_actual_cache_size(
         const optional<uint64_t> &setting) {
     uint64_t actual_size;
+    auto_cache_size_target = 0;
     if (!static_cast<bool>(setting)) {
         actual_size = get_default_total_cache_size();
+        auto_cache_size_target = actual_size;
         logINF("Automatically using cache size of %" PRIu64 " MB",
             actual_size / static_cast<uint64_t>(MEGABYTE));
     } else {
@@ -96,3 +113,48 @@ void server_config_server_t::update_actual_cache_size(
     actual_cache_size_bytes.set_value(actual_size);
 }
 
+void server_config_server_t::on_memory_pressure_timer() {
+    if (auto_cache_size_target != 0 && !adjusting_cache_size) {
+        coro_t::spawn_sometime(std::bind(
+            &server_config_server_t::adjust_cache_size_for_memory_pressure,
+            this, drainer.lock()));
+    }
+}
+
+void server_config_server_t::adjust_cache_size_for_memory_pressure(
+        UNUSED auto_drainer_t::lock_t keepalive) {
+    assert_thread();
+    adjusting_cache_size = true;
+    double pressure;
+    const bool have_pressure = get_memory_pressure(&pressure);
+    uint64_t cgroup_limit, cgroup_usage;
+    const bool have_cgroup = get_cgroup_memory_limit(&cgroup_limit, &cgroup_usage);
+    adjusting_cache_size = false;
+
+    // The setting may have changed while we were reading the files.
+    if (auto_cache_size_target == 0 || (!have_pressure && !have_cgroup)) {
+        return;
+    }
+
+    const uint64_t current_size = actual_cache_size_bytes.get_ref();
+    uint64_t new_size = current_size;
+    if ((have_pressure && pressure >= SHRINK_MEMORY_PRESSURE)
+            || (have_cgroup && cgroup_usage > cgroup_limit / 10 * 9)) {
+        new_size = std::max(
+            current_size - current_size / 8,
+            std::min(MIN_AUTO_CACHE_SIZE, auto_cache_size_target));
+        new_size = std::min(new_size, current_size);
+    } else if ((!have_pressure || pressure < GROW_MEMORY_PRESSURE)
+            && (!have_cgroup || cgroup_usage < cgroup_limit / 10 * 8)) {
+        new_size = std::min(current_size + current_size / 16, auto_cache_size_target);
+        new_size = std::max(new_size, current_size);
+    }
+
+    if (new_size != current_size) {
+        logDBG("Changing the cache size from %" PRIu64 " MB to %" PRIu64 " MB because "
+               "of memory pressure.",
+               current_size / static_cast<uint64_t>(MEGABYTE),
+               new_size / static_cast<uint64_t>(MEGABYTE));
+        actual_cache_size_bytes.set_value(new_size);
+    }
+}
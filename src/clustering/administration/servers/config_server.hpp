@@ -4,8 +4,10 @@
 
 #include <set>
 
+#include "arch/timing.hpp"
 #include "clustering/administration/metadata.hpp"
 #include "clustering/administration/servers/server_metadata.hpp"
+#include "concurrency/auto_drainer.hpp"
 
 class metadata_file_t;
 
@@ -23,7 +25,9 @@ public:
 
     /* Returns the actual cache size, not the cache size setting. If the cache size
     setting is "auto", the actual cache size will be some reasonable automatically
-    selected value; otherwise, the actual cache size will be the cache size setting. */
+    selected value, which shrinks while the server or its container is short of memory
+    and grows back afterwards; otherwise, the actual cache size will be the cache size
+    setting. */
     clone_ptr_t<watchable_t<uint64_t> > get_actual_cache_size_bytes() {
         return actual_cache_size_bytes.get_watchable();
     }
@@ -37,13 +41,25 @@ private:
 
     void update_actual_cache_size(const optional<uint64_t> &setting);
 
+    void on_memory_pressure_timer();
+    void adjust_cache_size_for_memory_pressure(auto_drainer_t::lock_t keepalive);
+
     mailbox_manager_t *const mailbox_manager;
     metadata_file_t *const file;
     server_id_t my_server_id;
     watchable_variable_t<server_config_versioned_t> my_config;
     watchable_variable_t<uint64_t> actual_cache_size_bytes;
 
+    /* If the cache size setting is "auto", the size it would have without memory
+    pressure, which the actual cache size grows back to; otherwise 0. */
+    uint64_t auto_cache_size_target;
+    bool adjusting_cache_size;
+
     server_config_business_card_t::set_config_mailbox_t set_config_mailbox;
+
+    // The timer must be destroyed before the drainer, because it acquires locks on it.
+    auto_drainer_t drainer;
+    repeating_timer_t memory_pressure_timer;
 };
 
 #endif /* CLUSTERING_ADMINISTRATION_SERVERS_CONFIG_SERVER_HPP_ */
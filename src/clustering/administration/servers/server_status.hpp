@@ -13,6 +13,8 @@
 
 class server_config_client_t;
 
+ql::datum_t convert_host_and_port_to_datum(const host_and_port_t &x);
+
 class server_status_artificial_table_backend_t :
     public common_server_artificial_table_backend_t
 {
@@ -0,0 +1,130 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "clustering/administration/stats/debug_coro_profile_backend.hpp"
+
+#include "clustering/administration/datum_adapter.hpp"
+#include "clustering/administration/servers/config_client.hpp"
+#include "concurrency/cross_thread_signal.hpp"
+
+debug_coro_profile_artificial_table_backend_t::
+        debug_coro_profile_artificial_table_backend_t(
+            rdb_context_t *rdb_context,
+            lifetime_t<name_resolver_t const &> name_resolver,
+            watchable_map_t<peer_id_t, cluster_directory_metadata_t> *_directory,
+            server_config_client_t *_server_config_client,
+            mailbox_manager_t *_mailbox_manager)
+    : common_server_artificial_table_backend_t(
+        name_string_t::guarantee_valid("_debug_coro_profile"),
+        rdb_context,
+        name_resolver,
+        _server_config_client,
+        _directory),
+      mailbox_manager(_mailbox_manager) {
+}
+
+debug_coro_profile_artificial_table_backend_t::
+        ~debug_coro_profile_artificial_table_backend_t() {
+    begin_changefeed_destruction();
+}
+
+bool debug_coro_profile_artificial_table_backend_t::write_row(
+        auth::user_context_t const &user_context,
+        ql::datum_t primary_key,
+        UNUSED bool pkey_was_autogenerated,
+        ql::datum_t *new_value_inout,
+        signal_t *interruptor_on_caller,
+        admin_err_t *error_out) {
+    user_context.require_admin_user();
+
+    cross_thread_signal_t interruptor_on_home(interruptor_on_caller, home_thread());
+    on_thread_t thread_switcher(home_thread());
+    server_id_t server_id;
+    peer_id_t peer_id;
+    cluster_directory_metadata_t metadata;
+    if (!lookup(primary_key, &server_id, &peer_id, &metadata)) {
+        if (new_value_inout->has()) {
+            *error_out = admin_err_t{"It's illegal to insert new rows into the "
+                                     "`rethinkdb._debug_coro_profile` system table.",
+                                     query_state_t::FAILED};
+            return false;
+        } else {
+            /* The user is re-deleting an already-absent row. OK. */
+            return true;
+        }
+    }
+    if (!new_value_inout->has()) {
+        *error_out = admin_err_t{
+            "It's illegal to delete rows from the `rethinkdb._debug_coro_profile` "
+            "system table.",
+            query_state_t::FAILED};
+        return false;
+    }
+
+    /* Only `enabled` can be changed. The other fields are the sampler's output, so we
+    accept them but ignore their values. */
+    converter_from_datum_object_t converter;
+    ql::datum_t enabled_datum, ignored;
+    if (!converter.init(*new_value_inout, error_out) ||
+            !converter.get("enabled", &enabled_datum, error_out)) {
+        error_out->msg = "The row you're trying to put into "
+            "`rethinkdb._debug_coro_profile` has the wrong format. " + error_out->msg;
+        return false;
+    }
+    for (const char *key : {"id", "name", "sampling_secs", "spawn_sites", "error"}) {
+        converter.get_optional(key, &ignored);
+    }
+    if (!converter.check_no_extra_keys(error_out)) {
+        error_out->msg = "The row you're trying to put into "
+            "`rethinkdb._debug_coro_profile` has the wrong format. " + error_out->msg;
+        return false;
+    }
+    if (enabled_datum.get_type() != ql::datum_t::R_BOOL) {
+        *error_out = admin_err_t{
+            "In `rethinkdb._debug_coro_profile`, `enabled` must be a boolean.",
+            query_state_t::FAILED};
+        return false;
+    }
+
+    ql::datum_t profile;
+    return fetch_coro_profile_from_server(
+        mailbox_manager,
+        metadata.coro_profile_mailbox_address,
+        make_optional(enabled_datum.as_bool()),
+        &interruptor_on_home,
+        &profile,
+        error_out);
+}
+
+bool debug_coro_profile_artificial_table_backend_t::format_row(
+        auth::user_context_t const &user_context,
+        server_id_t const & server_id,
+        UNUSED peer_id_t const & peer_id,
+        cluster_directory_metadata_t const & metadata,
+        signal_t *interruptor_on_home,
+        ql::datum_t *row_out,
+        UNUSED admin_err_t *error_out) {
+    user_context.require_admin_user();
+
+    ql::datum_t profile;
+    admin_err_t profile_error;
+    if (fetch_coro_profile_from_server(
+            mailbox_manager,
+            metadata.coro_profile_mailbox_address,
+            optional<bool>(),
+            interruptor_on_home,
+            &profile,
+            &profile_error)) {
+        ql::datum_object_builder_t builder(profile);
+        builder.overwrite("name", convert_name_to_datum(
+            metadata.server_config.config.name));
+        builder.overwrite("id", convert_uuid_to_datum(server_id.get_uuid()));
+        *row_out = std::move(builder).to_datum();
+    } else {
+        ql::datum_object_builder_t builder;
+        builder.overwrite("name", convert_name_to_datum(
+            metadata.server_config.config.name));
+        builder.overwrite("id", convert_uuid_to_datum(server_id.get_uuid()));
+        builder.overwrite("error", ql::datum_t(datum_string_t(profile_error.msg)));
+        *row_out = std::move(builder).to_datum();
+    }
+    return true;
+}
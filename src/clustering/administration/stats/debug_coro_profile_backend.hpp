@@ -0,0 +1,48 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_ADMINISTRATION_STATS_DEBUG_CORO_PROFILE_BACKEND_HPP_
+#define CLUSTERING_ADMINISTRATION_STATS_DEBUG_CORO_PROFILE_BACKEND_HPP_
+
+#include "clustering/administration/metadata.hpp"
+#include "clustering/administration/servers/server_common.hpp"
+#include "clustering/administration/stats/stat_manager.hpp"
+#include "rdb_protocol/artificial_table/backend.hpp"
+
+class server_config_client_t;
+
+/* The `rethinkdb._debug_coro_profile` table has one row per server with that server's
+`coro_sampler_t` report. Setting a row's `enabled` field turns the sampler on that
+server on or off. */
+class debug_coro_profile_artificial_table_backend_t :
+    public common_server_artificial_table_backend_t
+{
+public:
+    debug_coro_profile_artificial_table_backend_t(
+            rdb_context_t *rdb_context,
+            lifetime_t<name_resolver_t const &> name_resolver,
+            watchable_map_t<peer_id_t, cluster_directory_metadata_t> *_directory,
+            server_config_client_t *_server_config_client,
+            mailbox_manager_t *_mailbox_manager);
+    ~debug_coro_profile_artificial_table_backend_t();
+
+    bool write_row(
+            auth::user_context_t const &user_context,
+            ql::datum_t primary_key,
+            bool pkey_was_autogenerated,
+            ql::datum_t *new_value_inout,
+            signal_t *interruptor_on_caller,
+            admin_err_t *error_out);
+
+private:
+    bool format_row(
+            auth::user_context_t const &user_context,
+            server_id_t const & server_id,
+            peer_id_t const & peer_id,
+            cluster_directory_metadata_t const & metadata,
+            signal_t *interruptor_on_home,
+            ql::datum_t *row_out,
+            admin_err_t *error_out);
+
+    mailbox_manager_t *mailbox_manager;
+};
+
+#endif /* CLUSTERING_ADMINISTRATION_STATS_DEBUG_CORO_PROFILE_BACKEND_HPP_ */
@@ -31,6 +31,50 @@ const char *table_server_stats_request_t::table_server_request_type = "table_ser
     (BUILDER).overwrite(#NAME, ql::datum_t( \
         (STATS).accumulate_server(SERVER, &parsed_stats_t::table_stats_t::NAME)));
 
+// Latencies are reported in milliseconds
+static ql::datum_t latency_histogram_to_datum(const latency_histogram_t &histogram) {
+    ql::datum_object_builder_t builder;
+    static const std::pair<const char *, double> percentiles[] = {
+        {"p50", 0.5}, {"p90", 0.9}, {"p99", 0.99}, {"p999", 0.999} };
+    for (const auto &p : percentiles) {
+        builder.overwrite(p.first, histogram.count() > 0
+            ? ql::datum_t(histogram.percentile(p.second) * THOUSAND)
+            : ql::datum_t::null());
+    }
+    builder.overwrite("max", histogram.count() > 0
+        ? ql::datum_t(histogram.max() * THOUSAND)
+        : ql::datum_t::null());
+    return std::move(builder).to_datum();
+}
+
+// Sums up the cache stats of the given table/server pairs. The hit ratio is over
+// the lifetime of the caches, because we don't keep a rate of hits.
+static ql::datum_t cache_stats_to_datum(
+        const std::vector<const parsed_stats_t::table_stats_t *> &tables) {
+    double hits_total = 0, misses_total = 0, misses_per_sec = 0;
+    double evictions_total = 0, evictions_per_sec = 0;
+    latency_histogram_t miss_latency;
+    for (const parsed_stats_t::table_stats_t *table : tables) {
+        hits_total += table->cache_hits_total;
+        misses_total += table->cache_misses_total;
+        misses_per_sec += table->cache_misses_per_sec;
+        evictions_total += table->cache_evictions_total;
+        evictions_per_sec += table->cache_evictions_per_sec;
+        miss_latency.aggregate(table->cache_miss_latency);
+    }
+    ql::datum_object_builder_t builder;
+    builder.overwrite("hits_total", ql::datum_t(hits_total));
+    builder.overwrite("misses_total", ql::datum_t(misses_total));
+    builder.overwrite("hit_ratio", hits_total + misses_total > 0
+        ? ql::datum_t(hits_total / (hits_total + misses_total))
+        : ql::datum_t::null());
+    builder.overwrite("misses_per_sec", ql::datum_t(misses_per_sec));
+    builder.overwrite("evictions_total", ql::datum_t(evictions_total));
+    builder.overwrite("evictions_per_sec", ql::datum_t(evictions_per_sec));
+    builder.overwrite("miss_latency_ms", latency_histogram_to_datum(miss_latency));
+    return std::move(builder).to_datum();
+}
+
 parsed_stats_t::server_stats_t::server_stats_t() :
     responsive(false),
     queries_per_sec(0), queries_total(0),
@@ -42,7 +86,9 @@ parsed_stats_t::table_stats_t::table_stats_t() :
     in_use_bytes(0), metadata_bytes(0), data_bytes(0),
     garbage_bytes(0), preallocated_bytes(0),
     read_bytes_per_sec(0), read_bytes_total(0),
-    written_bytes_per_sec(0), written_bytes_total(0) { }
+    written_bytes_per_sec(0), written_bytes_total(0),
+    cache_hits_total(0), cache_misses_total(0), cache_misses_per_sec(0),
+    cache_evictions_total(0), cache_evictions_per_sec(0) { }
 
 parsed_stats_t::parsed_stats_t(const std::vector<ql::datum_t> &stats) {
     for (auto const &s : stats) {
@@ -65,6 +111,9 @@ parsed_stats_t::parsed_stats_t(const std::vector<ql::datum_t> &stats) {
             std::pair<datum_string_t, ql::datum_t> perf_pair = s.get_pair(i);
             if (perf_pair.first == "query_engine") {
                 store_query_engine_stats(perf_pair.second, &serv_stats);
+            } else if (perf_pair.first == "memory") {
+                r_sanity_check(perf_pair.second.get_type() == ql::datum_t::R_OBJECT);
+                serv_stats.memory = perf_pair.second;
             } else {
                 namespace_id_t table_id;
                 res = str_to_uuid(perf_pair.first.to_std(), &table_id);
@@ -101,6 +150,32 @@ void parsed_stats_t::add_perfmon_value(const ql::datum_t &perf,
     }
 }
 
+void parsed_stats_t::add_perfmon_histogram(const ql::datum_t &perf,
+                                           const std::string &key,
+                                           latency_histogram_t *histogram_out) {
+    ql::datum_t v = perf.get_field(key.c_str(), ql::throw_bool_t::NOTHROW);
+    if (!v.has()) {
+        return;
+    }
+    r_sanity_check(v.get_type() == ql::datum_t::R_OBJECT);
+    ql::datum_t buckets = v.get_field("buckets", ql::throw_bool_t::NOTHROW);
+    if (!buckets.has()) {
+        return;
+    }
+    r_sanity_check(buckets.get_type() == ql::datum_t::R_ARRAY);
+    for (size_t i = 0; i < buckets.arr_size(); ++i) {
+        ql::datum_t pair = buckets.get(i);
+        r_sanity_check(pair.get_type() == ql::datum_t::R_ARRAY && pair.arr_size() == 2);
+        int bucket = static_cast<int>(pair.get(0).as_num());
+        // Ignore buckets we don't know about, in case another server's histograms
+        // are laid out differently.
+        if (bucket >= 0 && bucket < latency_histogram_t::NUM_BUCKETS) {
+            histogram_out->add_to_bucket(
+                bucket, static_cast<uint64_t>(pair.get(1).as_num()));
+        }
+    }
+}
+
 void parsed_stats_t::store_shard_values(const ql::datum_t &shard_perf,
                                         table_stats_t *stats_out) {
     r_sanity_check(shard_perf.get_type() == ql::datum_t::R_OBJECT);
@@ -125,6 +200,18 @@ void parsed_stats_t::store_shard_values(const ql::datum_t &shard_perf,
                 } else if (key == "cache") {
                     add_perfmon_value(sub_pair.second, "in_use_bytes",
                                       &stats_out->in_use_bytes);
+                    add_perfmon_value(sub_pair.second, "hits_total",
+                                      &stats_out->cache_hits_total);
+                    add_perfmon_value(sub_pair.second, "misses_total",
+                                      &stats_out->cache_misses_total);
+                    add_perfmon_value(sub_pair.second, "misses_per_sec",
+                                      &stats_out->cache_misses_per_sec);
+                    add_perfmon_value(sub_pair.second, "evictions_total",
+                                      &stats_out->cache_evictions_total);
+                    add_perfmon_value(sub_pair.second, "evictions_per_sec",
+                                      &stats_out->cache_evictions_per_sec);
+                    add_perfmon_histogram(sub_pair.second, "miss_latency",
+                                          &stats_out->cache_miss_latency);
                 }
             }
         }
@@ -142,6 +229,8 @@ void parsed_stats_t::store_serializer_values(const ql::datum_t &ser_perf,
                         &stats_out->written_bytes_per_sec);
     store_perfmon_value(ser_perf, "serializer_written_bytes_total",
                         &stats_out->written_bytes_total);
+    add_perfmon_histogram(ser_perf, "serializer_block_read_latency",
+                          &stats_out->read_latency);
 
     store_perfmon_value(ser_perf, "serializer_data_extents",
                         &stats_out->data_bytes);
@@ -167,6 +256,7 @@ void parsed_stats_t::store_query_engine_stats(const ql::datum_t &qe_perf,
     store_perfmon_value(qe_perf, "queries_total", &stats_out->queries_total);
     store_perfmon_value(qe_perf, "client_connections", &stats_out->client_connections);
     store_perfmon_value(qe_perf, "clients_active", &stats_out->clients_active);
+    add_perfmon_histogram(qe_perf, "query_latency", &stats_out->query_latency);
 }
 
 void parsed_stats_t::store_table_stats(const namespace_id_t &table_id,
@@ -207,6 +297,15 @@ double parsed_stats_t::accumulate(double table_stats_t::*field) const {
     return res;
 }
 
+latency_histogram_t parsed_stats_t::accumulate(
+        latency_histogram_t server_stats_t::*field) const {
+    latency_histogram_t res;
+    for (auto const &pair : servers) {
+        res.aggregate(pair.second.*field);
+    }
+    return res;
+}
+
 double parsed_stats_t::accumulate_table(const namespace_id_t &table_id,
                                         double table_stats_t::*field) const {
     double res = 0;
@@ -312,6 +411,8 @@ bool cluster_stats_request_t::to_datum(const parsed_stats_t &stats,
     ADD_CLUSTER_SERVER_STAT(qe_builder, stats, clients_active);
     ADD_CLUSTER_TABLE_STAT(qe_builder, stats, read_docs_per_sec);
     ADD_CLUSTER_TABLE_STAT(qe_builder, stats, written_docs_per_sec);
+    qe_builder.overwrite("query_latency_ms", latency_histogram_to_datum(
+        stats.accumulate(&parsed_stats_t::server_stats_t::query_latency)));
     row_builder.overwrite("query_engine", std::move(qe_builder).to_datum());
 
     *result_out = std::move(row_builder).to_datum();
@@ -344,7 +445,8 @@ table_stats_request_t::table_stats_request_t(const namespace_id_t &_table_id) :
 
 std::set<std::vector<std::string> > table_stats_request_t::get_filter() const {
     return std::set<std::vector<std::string> >({
-        { uuid_to_str(table_id), "serializers", "shard_[0-9]+", "btree-.*", "keys_.*" }
+        { uuid_to_str(table_id), "serializers", "shard_[0-9]+", "btree-.*", "keys_.*" },
+        { uuid_to_str(table_id), "serializers", "shard_[0-9]+", "cache" }
         });
 }
 
@@ -376,6 +478,17 @@ bool table_stats_request_t::to_datum(const parsed_stats_t &stats,
     ADD_TABLE_STAT(qe_builder, stats, table_id, written_docs_per_sec);
     row_builder.overwrite("query_engine", std::move(qe_builder).to_datum());
 
+    std::vector<const parsed_stats_t::table_stats_t *> tables;
+    for (auto const &server_pair : stats.servers) {
+        auto const table_it = server_pair.second.tables.find(table_id);
+        if (table_it != server_pair.second.tables.end()) {
+            tables.push_back(&table_it->second);
+        }
+    }
+    ql::datum_object_builder_t se_builder;
+    se_builder.overwrite("cache", cache_stats_to_datum(tables));
+    row_builder.overwrite("storage_engine", std::move(se_builder).to_datum());
+
     *result_out = std::move(row_builder).to_datum();
     return true;
 }
@@ -407,7 +520,9 @@ server_stats_request_t::server_stats_request_t(const server_id_t &_server_id) :
 std::set<std::vector<std::string> > server_stats_request_t::get_filter() const {
     return std::set<std::vector<std::string> >(
         { {"query_engine"},
-          {".*", "serializers", "shard_[0-9]+", "btree-.*" } });
+          {"memory"},
+          {".*", "serializers", "shard_[0-9]+", "btree-.*" },
+          {".*", "serializers", "shard_[0-9]+", "cache" } });
 }
 
 std::vector<peer_id_t> server_stats_request_t::get_peers(
@@ -456,7 +571,21 @@ bool server_stats_request_t::to_datum(const parsed_stats_t &stats,
         ADD_SERVER_STAT(qe_builder, stats, server_id, read_docs_total);
         ADD_SERVER_STAT(qe_builder, stats, server_id, written_docs_per_sec);
         ADD_SERVER_STAT(qe_builder, stats, server_id, written_docs_total);
+        qe_builder.overwrite("query_latency_ms",
+                             latency_histogram_to_datum(server_stats.query_latency));
         row_builder.overwrite("query_engine", std::move(qe_builder).to_datum());
+
+        std::vector<const parsed_stats_t::table_stats_t *> tables;
+        for (auto const &table_pair : server_stats.tables) {
+            tables.push_back(&table_pair.second);
+        }
+        ql::datum_object_builder_t se_builder;
+        se_builder.overwrite("cache", cache_stats_to_datum(tables));
+        row_builder.overwrite("storage_engine", std::move(se_builder).to_datum());
+
+        if (server_stats.memory.has()) {
+            row_builder.overwrite("memory", server_stats.memory);
+        }
     }
     *result_out = std::move(row_builder).to_datum();
     return true;
@@ -550,7 +679,8 @@ bool table_server_stats_request_t::to_datum(const parsed_stats_t &stats,
         ADD_STAT(qe_builder, table_stats, written_docs_per_sec);
         ADD_STAT(qe_builder, table_stats, written_docs_total);
 
-        ql::datum_object_builder_t se_cache_builder;
+        ql::datum_object_builder_t se_cache_builder(
+            cache_stats_to_datum({ &table_stats }));
         ADD_STAT(se_cache_builder, table_stats, in_use_bytes);
 
         ql::datum_object_builder_t se_disk_space_builder;
@@ -564,6 +694,8 @@ bool table_server_stats_request_t::to_datum(const parsed_stats_t &stats,
         ADD_STAT(se_disk_builder, table_stats, read_bytes_total);
         ADD_STAT(se_disk_builder, table_stats, written_bytes_per_sec);
         ADD_STAT(se_disk_builder, table_stats, written_bytes_total);
+        se_disk_builder.overwrite("read_latency_ms",
+                                  latency_histogram_to_datum(table_stats.read_latency));
         se_disk_builder.overwrite("space_usage", std::move(se_disk_space_builder).to_datum());
 
         ql::datum_object_builder_t se_builder;
@@ -9,6 +9,7 @@
 
 #include "clustering/administration/metadata.hpp"
 #include "containers/uuid.hpp"
+#include "perfmon/perfmon.hpp"
 #include "rdb_protocol/datum.hpp"
 
 class server_config_client_t;
@@ -36,6 +37,13 @@ public:
         double read_bytes_total;
         double written_bytes_per_sec;
         double written_bytes_total;
+        latency_histogram_t read_latency;
+        double cache_hits_total;
+        double cache_misses_total;
+        double cache_misses_per_sec;
+        double cache_evictions_total;
+        double cache_evictions_per_sec;
+        latency_histogram_t cache_miss_latency;
     };
 
     struct server_stats_t {
@@ -46,6 +54,10 @@ public:
         double queries_total;
         double client_connections;
         double clients_active;
+        latency_histogram_t query_latency;
+        // The server's `memory` perfmon collection, if it reported one. See
+        // perfmon/memory_usage.hpp.
+        ql::datum_t memory;
 
         std::map<namespace_id_t, table_stats_t> tables;
     };
@@ -58,6 +70,9 @@ public:
     // Accumulate a field in all tables (across all servers)
     double accumulate(double table_stats_t::*field) const;
 
+    // Combine a latency histogram from all servers
+    latency_histogram_t accumulate(latency_histogram_t server_stats_t::*field) const;
+
     // Accumulate a field in a specific table (across all servers)
     double accumulate_table(const namespace_id_t &table_id,
                             double table_stats_t::*field) const;
@@ -81,6 +96,11 @@ private:
                              const std::string &key,
                              double *value_out);
 
+    // Adds the buckets of a `perfmon_latency_histogram_t` to `histogram_out`.
+    void add_perfmon_histogram(const ql::datum_t &perf,
+                               const std::string &key,
+                               latency_histogram_t *histogram_out);
+
     void store_shard_values(const ql::datum_t &shard_perf,
                             table_stats_t *stats_out);
 
@@ -3,6 +3,7 @@
 
 #include <functional>
 
+#include "arch/runtime/coro_sampler.hpp"
 #include "clustering/administration/datum_adapter.hpp"
 #include "concurrency/watchable.hpp"
 #include "perfmon/collect.hpp"
@@ -13,22 +14,47 @@ stat_manager_t::stat_manager_t(mailbox_manager_t* mm,
                                server_id_t _own_server_id) :
     own_server_id(_own_server_id),
     mailbox_manager(mm),
+    cached_stats_ticks({0}),
     get_stats_mailbox(mailbox_manager,
                       std::bind(&stat_manager_t::on_stats_request,
-                                this, ph::_1, ph::_2, ph::_3))
+                                this, ph::_1, ph::_2, ph::_3)),
+    coro_profile_mailbox(mailbox_manager,
+                         std::bind(&stat_manager_t::on_coro_profile_request,
+                                   this, ph::_1, ph::_2, ph::_3))
     { }
 
 get_stats_mailbox_address_t stat_manager_t::get_address() {
     return get_stats_mailbox.get_address();
 }
 
+coro_profile_mailbox_address_t stat_manager_t::get_coro_profile_address() {
+    return coro_profile_mailbox.get_address();
+}
+
+/* How old the stats that we send can be. The stats that are rates are averaged over
+at least a second anyway. */
+const int64_t STATS_CACHE_MAX_AGE_MS = 1000;
+
+ql::datum_t stat_manager_t::get_cached_stats(signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t) {
+    new_mutex_acq_t acq(&cached_stats_mutex, interruptor);
+    ticks_t now = get_ticks();
+    if (!cached_stats.has()
+            || now.nanos - cached_stats_ticks.nanos > STATS_CACHE_MAX_AGE_MS * MILLION) {
+        cached_stats = perfmon_get_stats();
+        /* The time the collection started, since some of the stats might have been
+        taken right then. */
+        cached_stats_ticks = now;
+    }
+    return cached_stats;
+}
+
 void stat_manager_t::on_stats_request(
-        UNUSED signal_t *interruptor,
+        signal_t *interruptor,
         const return_address_t& reply_address,
         const std::set<std::vector<stat_id_t> >& requested_stats) {
     perfmon_filter_t request(requested_stats);
-    ql::datum_t perfmon_result(perfmon_get_stats());
-    perfmon_result = request.filter(perfmon_result);
+    ql::datum_t perfmon_result = request.filter(get_cached_stats(interruptor));
 
     // Add in our own server id so the other side does not need to perform lookups
     ql::datum_object_builder_t stats(perfmon_result);
@@ -36,6 +62,53 @@ void stat_manager_t::on_stats_request(
     send(mailbox_manager, reply_address, std::move(stats).to_datum());
 }
 
+/* How many of the most frequent yield points we report for each spawn site */
+const size_t CORO_PROFILE_MAX_YIELD_POINTS = 5;
+
+static ql::datum_t convert_coro_profile_to_datum(const coro_sampler_t::report_t &report) {
+    ql::datum_array_builder_t sites_builder(ql::configured_limits_t::unlimited);
+    for (const auto &site : report.spawn_sites) {
+        ql::datum_array_builder_t points_builder(ql::configured_limits_t::unlimited);
+        for (const auto &point : site.yield_points) {
+            ql::datum_array_builder_t frames_builder(ql::configured_limits_t::unlimited);
+            for (const std::string &frame : point.backtrace) {
+                frames_builder.add(ql::datum_t(datum_string_t(frame)));
+            }
+            ql::datum_object_builder_t point_builder;
+            point_builder.overwrite("samples",
+                ql::datum_t(static_cast<double>(point.samples)));
+            point_builder.overwrite("backtrace",
+                std::move(frames_builder).to_datum());
+            points_builder.add(std::move(point_builder).to_datum());
+        }
+        ql::datum_object_builder_t site_builder;
+        site_builder.overwrite("spawn_site",
+            ql::datum_t(datum_string_t(site.spawn_site)));
+        site_builder.overwrite("resumes",
+            ql::datum_t(static_cast<double>(site.resumes)));
+        site_builder.overwrite("running_secs", ql::datum_t(site.running_secs));
+        site_builder.overwrite("max_running_secs", ql::datum_t(site.max_running_secs));
+        site_builder.overwrite("yield_points", std::move(points_builder).to_datum());
+        sites_builder.add(std::move(site_builder).to_datum());
+    }
+    ql::datum_object_builder_t builder;
+    builder.overwrite("enabled", ql::datum_t::boolean(report.enabled));
+    builder.overwrite("sampling_secs", ql::datum_t(report.sampling_secs));
+    builder.overwrite("spawn_sites", std::move(sites_builder).to_datum());
+    return std::move(builder).to_datum();
+}
+
+void stat_manager_t::on_coro_profile_request(
+        UNUSED signal_t *interruptor,
+        const return_address_t& reply_address,
+        const optional<bool> &set_enabled) {
+    if (set_enabled.has_value()) {
+        coro_sampler_t::set_enabled(*set_enabled);
+    }
+    send(mailbox_manager, reply_address, convert_coro_profile_to_datum(
+        coro_sampler_t::get_report(CORO_PROFILE_MAX_YIELD_POINTS)));
+}
+
 bool fetch_stats_from_server(
         mailbox_manager_t *mailbox_manager,
         const get_stats_mailbox_address_t &request_addr,
@@ -74,3 +147,41 @@ bool fetch_stats_from_server(
     return true;
 }
 
+bool fetch_coro_profile_from_server(
+        mailbox_manager_t *mailbox_manager,
+        const coro_profile_mailbox_address_t &request_addr,
+        const optional<bool> &set_enabled,
+        signal_t *interruptor,
+        ql::datum_t *profile_out,
+        admin_err_t *error_out) {
+    cond_t done;
+    mailbox_t<ql::datum_t> return_mailbox(mailbox_manager,
+        [&](signal_t *, ql::datum_t p) {
+            *profile_out = p;
+            done.pulse();
+        });
+
+    disconnect_watcher_t disconnect_watcher(mailbox_manager, request_addr.get_peer());
+
+    send(mailbox_manager, request_addr, return_mailbox.get_address(), set_enabled);
+
+    signal_timer_t timeout;
+    timeout.start(5000);
+
+    wait_any_t waiter(&done, &disconnect_watcher, &timeout);
+    wait_interruptible(&waiter, interruptor);
+
+    if (disconnect_watcher.is_pulsed()) {
+        *error_out = admin_err_t{"Server disconnected.", query_state_t::FAILED};
+        return false;
+    }
+
+    if (timeout.is_pulsed()) {
+        *error_out = admin_err_t{"Coroutine profile request timed out.",
+                                 query_state_t::FAILED};
+        return false;
+    }
+
+    guarantee(done.is_pulsed());
+    return true;
+}
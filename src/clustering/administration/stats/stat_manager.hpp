@@ -6,8 +6,11 @@
 #include <set>
 #include <string>
 
+#include "concurrency/new_mutex.hpp"
+#include "containers/optional.hpp"
 #include "perfmon/types.hpp"
 #include "rpc/mailbox/typed.hpp"
+#include "time.hpp"
 
 struct admin_err_t;
 
@@ -17,11 +20,15 @@ public:
     typedef mailbox_addr_t<ql::datum_t> return_address_t;
     typedef mailbox_t<return_address_t, std::set<std::vector<stat_id_t> >> get_stats_mailbox_t;
     typedef get_stats_mailbox_t::address_t get_stats_mailbox_address_t;
+    /* If the `optional<bool>` is set, the coroutine sampler is turned on or off before
+    the reply is sent. The reply is the sampler's report. See `coro_sampler_t`. */
+    typedef mailbox_t<return_address_t, optional<bool> > coro_profile_mailbox_t;
 
     explicit stat_manager_t(mailbox_manager_t* mailbox_manager,
                             server_id_t _own_server_id);
 
     get_stats_mailbox_address_t get_address();
+    coro_profile_mailbox_t::address_t get_coro_profile_address();
 
 private:
     void on_stats_request(
@@ -29,14 +36,34 @@ private:
         const return_address_t& reply_address,
         const std::set<std::vector<stat_id_t> >& requested_stats);
 
+    /* Returns all of the server's stats, collected at most `STATS_CACHE_MAX_AGE_MS`
+    ago. The web UI and monitoring poll the stats table all the time, and walking
+    the whole perfmon tree on every thread for each of their requests is costly. */
+    ql::datum_t get_cached_stats(signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t);
+
+    void on_coro_profile_request(
+        signal_t *interruptor,
+        const return_address_t& reply_address,
+        const optional<bool> &set_enabled);
+
     server_id_t own_server_id;
     mailbox_manager_t *mailbox_manager;
+
+    /* Requests that come in while the stats are being collected wait for that
+    collection instead of starting their own. */
+    new_mutex_t cached_stats_mutex;
+    ql::datum_t cached_stats;
+    ticks_t cached_stats_ticks;
+
     get_stats_mailbox_t get_stats_mailbox;
+    coro_profile_mailbox_t coro_profile_mailbox;
 
     DISABLE_COPYING(stat_manager_t);
 };
 
 typedef stat_manager_t::get_stats_mailbox_t::address_t get_stats_mailbox_address_t;
+typedef stat_manager_t::coro_profile_mailbox_t::address_t coro_profile_mailbox_address_t;
 
 bool fetch_stats_from_server(
         mailbox_manager_t *mailbox_manager,
@@ -46,5 +73,15 @@ bool fetch_stats_from_server(
         ql::datum_t *stats_out,
         admin_err_t *error_out);
 
+/* Fetches the coroutine sampler's report from the given server, turning the sampler
+on or off first if `set_enabled` is set. */
+bool fetch_coro_profile_from_server(
+        mailbox_manager_t *mailbox_manager,
+        const coro_profile_mailbox_address_t &request_addr,
+        const optional<bool> &set_enabled,
+        signal_t *interruptor,
+        ql::datum_t *profile_out,
+        admin_err_t *error_out);
+
 #endif /* CLUSTERING_ADMINISTRATION_STATS_STAT_MANAGER_HPP_ */
 
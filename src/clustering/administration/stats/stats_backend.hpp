@@ -53,6 +53,9 @@ public:
             admin_err_t *error_out);
 
 private:
+    /* Every user sees the same rows, so changefeeds share one set of machinery. */
+    bool rows_depend_on_user() const { return false; }
+
     void get_peer_stats(const peer_id_t &peer,
                         const std::set<std::vector<std::string> > &filter,
                         ql::datum_t *result_out,
@@ -1,5 +1,7 @@
 #include "clustering/administration/tables/split_points.hpp"
 
+#include <cmath>
+
 #include "clustering/administration/real_reql_cluster_interface.hpp"
 #include "math.hpp"   /* for `clamp()` */
 #include "rdb_protocol/real_table.hpp"
@@ -89,7 +91,8 @@ void fetch_distribution(
         const namespace_id_t &table_id,
         real_reql_cluster_interface_t *reql_cluster_interface,
         signal_t *interruptor,
-        std::map<store_key_t, int64_t> *counts_out)
+        std::map<store_key_t, int64_t> *counts_out,
+        std::map<store_key_t, int64_t> *loads_out)
         THROWS_ONLY(interrupted_exc_t, failed_table_op_exc_t, no_such_table_exc_t) {
     namespace_interface_access_t ns_if_access =
         reql_cluster_interface->get_namespace_repo()->get_namespace_interface(
@@ -97,7 +100,8 @@ void fetch_distribution(
     static const int depth = 2;
     static const int limit = 128;
     distribution_read_t inner_read(depth, limit);
-    read_t read(inner_read, profile_bool_t::DONT_PROFILE, read_mode_t::OUTDATED);
+    read_t read(inner_read, profile_bool_t::DONT_PROFILE,
+        loads_out != nullptr ? read_mode_t::SINGLE : read_mode_t::OUTDATED);
     read_response_t resp;
     try {
         ns_if_access.get()->read(
@@ -113,8 +117,40 @@ void fetch_distribution(
         /* If `get_name()` didn't throw, the table exists but is inaccessible */
         throw failed_table_op_exc_t();
     }
-    *counts_out = std::move(
-        boost::get<distribution_read_response_t>(resp.response).key_counts);
+    distribution_read_response_t *dist_resp =
+        boost::get<distribution_read_response_t>(&resp.response);
+    *counts_out = std::move(dist_resp->key_counts);
+    if (loads_out != nullptr) {
+        *loads_out = std::move(dist_resp->key_loads);
+    }
+}
+
+std::map<store_key_t, int64_t> combine_distribution_with_loads(
+        const std::map<store_key_t, int64_t> &counts,
+        const std::map<store_key_t, int64_t> &loads) {
+    int64_t total_count = 0, total_load = 0;
+    for (const auto &pair : counts) {
+        total_count += pair.second;
+    }
+    for (const auto &pair : loads) {
+        total_load += pair.second;
+    }
+    if (total_count == 0 || total_load == 0) {
+        return counts;
+    }
+
+    /* Each range's count is weighted by `total_load` and each key's load by
+    `total_count`, so the two halves of the result have equal totals. A key with a load
+    becomes the left end of a range of its own in the result; the keys of the range it
+    lands in stay with that range's left end, which is close enough for our purposes. */
+    std::map<store_key_t, int64_t> combined;
+    for (const auto &pair : counts) {
+        combined[pair.first] += pair.second * total_load;
+    }
+    for (const auto &pair : loads) {
+        combined[pair.first] += pair.second * total_count;
+    }
+    return combined;
 }
 
 bool calculate_split_points_with_distribution(
@@ -156,6 +192,151 @@ bool calculate_split_points_with_distribution(
     return true;
 }
 
+/* `split_range_with_distribution()` appends `num_pieces - 1` keys from `counts` to
+`split_points_out` that divide the documents in `range` about evenly. The keys lie
+strictly inside `range`. Returns `false` if there are fewer than `num_pieces` keys with
+documents in `range`. */
+static bool split_range_with_distribution(
+        const std::map<store_key_t, int64_t> &counts,
+        const key_range_t &range,
+        size_t num_pieces,
+        std::vector<store_key_t> *split_points_out) {
+    /* The number of documents before each key, and the key */
+    std::vector<std::pair<int64_t, store_key_t> > pairs;
+    int64_t total_count = 0;
+    for (auto it = counts.lower_bound(range.left);
+            it != counts.end() && range.contains_key(it->first);
+            ++it) {
+        if (it->second != 0) {
+            pairs.push_back(std::make_pair(total_count, it->first));
+            total_count += it->second;
+        }
+    }
+    if (pairs.size() < num_pieces) {
+        return false;
+    }
+
+    /* The first key can't be a split point, because it's the start of the range as far
+    as the documents are concerned. Each split point leaves enough keys after it for the
+    ones that come after it. */
+    size_t previous = 0;
+    for (size_t piece = 1; piece < num_pieces; ++piece) {
+        int64_t split_count = (piece * total_count) / num_pieces;
+        size_t index = previous + 1;
+        size_t last_index = pairs.size() - (num_pieces - piece);
+        while (index < last_index && pairs[index].first < split_count) {
+            ++index;
+        }
+        split_points_out->push_back(pairs[index].second);
+        previous = index;
+    }
+    return true;
+}
+
+bool calculate_split_points_with_minimal_movement(
+        const std::map<store_key_t, int64_t> &counts,
+        size_t num_shards,
+        const table_shard_scheme_t &old_split_points,
+        table_shard_scheme_t *split_points_out) {
+    guarantee(num_shards >= 1);
+    std::vector<int64_t> shard_counts(old_split_points.num_shards(), 0);
+    for (const auto &pair : counts) {
+        shard_counts[old_split_points.find_shard_for_key(pair.first)] += pair.second;
+    }
+
+    std::vector<store_key_t> split_points;
+    if (num_shards <= old_split_points.num_shards()) {
+        split_points = old_split_points.split_points;
+        while (split_points.size() + 1 > num_shards) {
+            size_t best = 0;
+            for (size_t i = 1; i + 1 < shard_counts.size(); ++i) {
+                if (shard_counts[i] + shard_counts[i + 1]
+                        < shard_counts[best] + shard_counts[best + 1]) {
+                    best = i;
+                }
+            }
+            shard_counts[best] += shard_counts[best + 1];
+            shard_counts.erase(shard_counts.begin() + best + 1);
+            split_points.erase(split_points.begin() + best);
+        }
+    } else {
+        /* Each additional shard goes to the old shard that has the most documents per
+        piece so far. */
+        std::vector<size_t> num_pieces(old_split_points.num_shards(), 1);
+        for (size_t n = old_split_points.num_shards(); n < num_shards; ++n) {
+            size_t best = 0;
+            for (size_t i = 1; i < num_pieces.size(); ++i) {
+                if (static_cast<double>(shard_counts[i]) / num_pieces[i]
+                        > static_cast<double>(shard_counts[best]) / num_pieces[best]) {
+                    best = i;
+                }
+            }
+            ++num_pieces[best];
+        }
+        for (size_t i = 0; i < old_split_points.num_shards(); ++i) {
+            if (i != 0) {
+                split_points.push_back(old_split_points.split_points[i - 1]);
+            }
+            if (num_pieces[i] > 1 && !split_range_with_distribution(
+                    counts, old_split_points.get_shard_range(i), num_pieces[i],
+                    &split_points)) {
+                return false;
+            }
+        }
+    }
+    for (size_t i = 1; i < split_points.size(); ++i) {
+        guarantee(split_points[i - 1] < split_points[i]);
+    }
+    split_points_out->split_points = std::move(split_points);
+    return true;
+}
+
+bool adjust_split_points_with_distribution(
+        const std::map<store_key_t, int64_t> &counts,
+        const table_shard_scheme_t &old_split_points,
+        double tolerance,
+        table_shard_scheme_t *split_points_out) {
+    const size_t num_shards = old_split_points.num_shards();
+    table_shard_scheme_t even_split_points;
+    if (!calculate_split_points_with_distribution(
+            counts, num_shards, &even_split_points)) {
+        return false;
+    }
+    int64_t total_count = 0;
+    for (const auto &pair : counts) {
+        total_count += pair.second;
+    }
+    const double slack = tolerance * total_count / num_shards;
+
+    std::vector<store_key_t> split_points;
+    auto it = counts.begin();
+    int64_t count_before = 0;
+    for (size_t i = 0; i < old_split_points.split_points.size(); ++i) {
+        const store_key_t &old_split_point = old_split_points.split_points[i];
+        while (it != counts.end() && it->first < old_split_point) {
+            count_before += it->second;
+            ++it;
+        }
+        int64_t even_count_before = ((i + 1) * total_count) / num_shards;
+        if (std::abs(static_cast<double>(count_before - even_count_before)) <= slack) {
+            split_points.push_back(old_split_point);
+        } else {
+            split_points.push_back(even_split_points.split_points[i]);
+        }
+    }
+
+    /* A kept split point can end up next to a moved one that passed it. That only
+    happens when the data moved a lot, so we move all of them. */
+    for (size_t i = 1; i < split_points.size(); ++i) {
+        if (!(split_points[i - 1] < split_points[i])) {
+            *split_points_out = even_split_points;
+            return true;
+        }
+    }
+    split_points_out->split_points = std::move(split_points);
+    return true;
+}
+
 store_key_t key_for_uuid(uint64_t first_8_bytes) {
     uuid_u uuid;
     memset(uuid.data(), 0, uuid_u::static_size());
@@ -225,9 +406,10 @@ void calculate_split_points_intelligently(
         THROWS_ONLY(interrupted_exc_t, failed_table_op_exc_t, no_such_table_exc_t) {
     if (num_shards > old_split_points.num_shards()) {
         std::map<store_key_t, int64_t> counts;
-        fetch_distribution(table_id, reql_cluster_interface, interruptor, &counts);
-        if (!calculate_split_points_with_distribution(
-                counts, num_shards, split_points_out)) {
+        fetch_distribution(
+            table_id, reql_cluster_interface, interruptor, &counts, nullptr);
+        if (!calculate_split_points_with_minimal_movement(
+                counts, num_shards, old_split_points, split_points_out)) {
             /* There aren't enough documents to calculate distribution. We'll just assume
             the user is going to use UUID primary keys. If we got it wrong, they will end
             up with horribly unbalanced data, but it's the best we can do. */
@@ -236,8 +418,23 @@ void calculate_split_points_intelligently(
     } else if (num_shards == old_split_points.num_shards()) {
         *split_points_out = old_split_points;
     } else {
-        calculate_split_points_by_interpolation(
-            num_shards, old_split_points, split_points_out);
+        /* Merging shards doesn't need the distribution to be correct, only to be good,
+        so we don't let a shard that can't be read stop us. */
+        std::map<store_key_t, int64_t> counts;
+        try {
+            fetch_distribution(
+                table_id, reql_cluster_interface, interruptor, &counts, nullptr);
+        } catch (const failed_table_op_exc_t &) {
+            counts.clear();
+        }
+        if (counts.empty()) {
+            calculate_split_points_by_interpolation(
+                num_shards, old_split_points, split_points_out);
+        } else {
+            bool ok = calculate_split_points_with_minimal_movement(
+                counts, num_shards, old_split_points, split_points_out);
+            guarantee(ok, "Merging shards can't fail");
+        }
     }
 }
 
@@ -14,14 +14,26 @@ class real_reql_cluster_interface_t;
 class signal_t;
 class table_shard_scheme_t;
 
-/* `fetch_distribution` fetches the distribution information from the database. */
+/* `fetch_distribution` fetches the distribution information from the database. If
+`loads_out` isn't null, it also fetches the sampled load of the busiest keys; that
+requires reaching the primaries, since they are the replicas that see the reads. */
 void fetch_distribution(
         const namespace_id_t &table_id,
         real_reql_cluster_interface_t *reql_cluster_interface,
         signal_t *interruptor,
-        std::map<store_key_t, int64_t> *counts_out)
+        std::map<store_key_t, int64_t> *counts_out,
+        std::map<store_key_t, int64_t> *loads_out)
         THROWS_ONLY(interrupted_exc_t, failed_table_op_exc_t, no_such_table_exc_t);
 
+/* `combine_distribution_with_loads` weights the key counts from `fetch_distribution()`
+with the sampled loads, so that the key counts and the loads each make up half of the
+total. Passing the result to `calculate_split_points_with_distribution()` gives split
+points that spread both the data and the traffic, instead of leaving a small but busy
+range of keys on a single shard. */
+std::map<store_key_t, int64_t> combine_distribution_with_loads(
+        const std::map<store_key_t, int64_t> &counts,
+        const std::map<store_key_t, int64_t> &loads);
+
 /* `calculate_split_points_with_distribution` generates a set of split points that are
 guaranteed to divide the data approximately evenly, using the results of
 `fetch_distribution()`. It returns `false` if there are too few documents in the
@@ -31,6 +43,37 @@ bool calculate_split_points_with_distribution(
         size_t num_shards,
         table_shard_scheme_t *split_points_out);
 
+/* `calculate_split_points_with_minimal_movement` changes the number of shards from
+`old_split_points.num_shards()` to `num_shards` while moving as little data as
+possible. The old split points stay where they are; new shards are made by splitting
+the old shards with the most documents (according to `counts`) into even pieces, and
+shards are removed by merging the adjacent pairs with the fewest documents. That way
+each new shard lies within an old one or is the union of old ones, so only the data
+of the shards that are split or merged has to change hands. It returns `false` if a
+shard that has to be split has too few documents to split it. */
+bool calculate_split_points_with_minimal_movement(
+        const std::map<store_key_t, int64_t> &counts,
+        size_t num_shards,
+        const table_shard_scheme_t &old_split_points,
+        table_shard_scheme_t *split_points_out);
+
+/* `rebalance` leaves a split point where it is unless it's off from where an even split
+would put it by more than this fraction of a shard's share of the documents. Moving a
+split point backfills the data between its old and new positions, which isn't worth it
+for a small improvement. */
+const double REBALANCE_TOLERANCE = 0.1;
+
+/* `adjust_split_points_with_distribution` is like
+`calculate_split_points_with_distribution` for the same number of shards as
+`old_split_points`, but only moves the split points that are off by more than
+`tolerance` (see `REBALANCE_TOLERANCE`). It returns `false` if there are too few
+documents in the database. */
+bool adjust_split_points_with_distribution(
+        const std::map<store_key_t, int64_t> &counts,
+        const table_shard_scheme_t &old_split_points,
+        double tolerance,
+        table_shard_scheme_t *split_points_out);
+
 /* `calculate_split_points_for_uuids` generates a set of split points that will divide
 the range of UUIDs evenly. */
 void calculate_split_points_for_uuids(
@@ -47,9 +90,12 @@ void calculate_split_points_by_interpolation(
         table_shard_scheme_t *split_points_out);
 
 /* `calculate_split_points_intelligently` picks one of the above methods based on its
-input. If the number of shards is being increased, it takes a distribution; if the number
-is being decreased, it interpolates; and if the number stays the same, it uses the old
-split points. It fails if it can't read the distribution from the database. */
+input. If the number of shards changes, it reads the distribution and changes the
+number with minimal movement; if the number stays the same, it uses the old split
+points. If there are too few documents, it falls back to split points for UUIDs when
+the number of shards is being increased, and to interpolation when it's being
+decreased. It fails if it can't read the distribution from the database when the
+number of shards is being increased. */
 void calculate_split_points_intelligently(
         namespace_id_t table_id,
         real_reql_cluster_interface_t *reql_cluster_interface,
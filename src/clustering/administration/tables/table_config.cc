@@ -5,9 +5,11 @@
 #include "clustering/administration/metadata.hpp"
 #include "clustering/administration/tables/generate_config.hpp"
 #include "clustering/administration/tables/split_points.hpp"
+#include "clustering/table_contract/cpu_sharding.hpp"
 #include "clustering/table_manager/table_meta_client.hpp"
 #include "concurrency/cross_thread_signal.hpp"
 #include "containers/archive/string_stream.hpp"
+#include "rdb_protocol/func.hpp"
 #include "rdb_protocol/terms/write_hook.hpp"
 
 table_config_artificial_table_backend_t::table_config_artificial_table_backend_t(
@@ -248,6 +250,52 @@ ql::datum_t convert_flush_interval_to_datum(
         flush_interval.variant);
 }
 
+bool convert_cpu_sharding_factor_from_datum(
+        const ql::datum_t &datum,
+        int32_t *cpu_sharding_factor_out,
+        admin_err_t *error_out) {
+    if (datum.get_type() != ql::datum_t::R_NUM) {
+        *error_out = admin_err_t{
+            "Expected a number, got: " + datum.print(),
+            query_state_t::FAILED};
+        return false;
+    }
+    double val = datum.as_num();
+    if (val != std::trunc(val) || val < 1 || val > MAX_CPU_SHARDING_FACTOR) {
+        *error_out = admin_err_t{
+            strprintf("Expected an integer between 1 and %d, got: %s",
+                      MAX_CPU_SHARDING_FACTOR, datum.print().c_str()),
+            query_state_t::FAILED};
+        return false;
+    }
+    *cpu_sharding_factor_out = static_cast<int32_t>(val);
+    return true;
+}
+
+bool convert_block_size_from_datum(
+        const ql::datum_t &datum,
+        int32_t *block_size_out,
+        admin_err_t *error_out) {
+    if (datum.get_type() != ql::datum_t::R_NUM) {
+        *error_out = admin_err_t{
+            "Expected a number, got: " + datum.print(),
+            query_state_t::FAILED};
+        return false;
+    }
+    double val = datum.as_num();
+    if (val != std::trunc(val)
+            || !is_valid_table_block_size(static_cast<int64_t>(val))) {
+        *error_out = admin_err_t{
+            strprintf("Expected a power of two between %lld and %lld, got: %s",
+                      MIN_BTREE_BLOCK_SIZE, MAX_BTREE_BLOCK_SIZE,
+                      datum.print().c_str()),
+            query_state_t::FAILED};
+        return false;
+    }
+    *block_size_out = static_cast<int32_t>(val);
+    return true;
+}
+
 bool convert_flush_interval_from_datum(
         const ql::datum_t &datum,
         flush_interval_config_t *flush_interval_out,
@@ -461,6 +509,15 @@ ql::datum_t convert_table_config_to_datum(
     builder.overwrite("flush_interval",
         convert_flush_interval_to_datum(config.flush_interval));
     builder.overwrite("data", config.user_data.datum);
+    builder.overwrite("cpu_shards",
+        ql::datum_t(static_cast<double>(config.cpu_sharding_factor)));
+    builder.overwrite("block_size",
+        ql::datum_t(static_cast<double>(config.block_size)));
+    builder.overwrite("expiry_field",
+        static_cast<bool>(config.expiry_field)
+            ? convert_string_to_datum(*config.expiry_field)
+            : ql::datum_t::null());
+    builder.overwrite("read_cache", ql::datum_t::boolean(config.read_cache));
     return std::move(builder).to_datum();
 }
 
@@ -531,7 +588,8 @@ bool convert_table_config_and_name_from_datum(
     }
 
     /* As a special case, we allow the user to omit `indexes`, `primary_key`, `shards`,
-    `write_acks`, `durability`, and/or `data` for newly-created tables. */
+    `write_acks`, `durability`, `data`, `cpu_shards`, `block_size`, `expiry_field`,
+    and/or `read_cache` for newly-created tables. */
 
     if (converter.has("indexes")) {
         ql::datum_t indexes_datum;
@@ -703,6 +761,96 @@ bool convert_table_config_and_name_from_datum(
         config_out->user_data = default_user_data();
     }
 
+    if (existed_before || converter.has("cpu_shards")) {
+        ql::datum_t cpu_shards_datum;
+        if (!converter.get("cpu_shards", &cpu_shards_datum, error_out)) {
+            return false;
+        }
+        if (!convert_cpu_sharding_factor_from_datum(
+                cpu_shards_datum, &config_out->cpu_sharding_factor, error_out)) {
+            error_out->msg = "In `cpu_shards`: " + error_out->msg;
+            return false;
+        }
+        if (existed_before &&
+                config_out->cpu_sharding_factor != old_config.config.cpu_sharding_factor) {
+            error_out->msg = "The `cpu_shards` field is read-only and can't be changed "
+                             "after the table has been created.";
+            return false;
+        }
+    } else {
+        config_out->cpu_sharding_factor = CPU_SHARDING_FACTOR;
+    }
+
+    if (existed_before || converter.has("block_size")) {
+        ql::datum_t block_size_datum;
+        if (!converter.get("block_size", &block_size_datum, error_out)) {
+            return false;
+        }
+        if (!convert_block_size_from_datum(
+                block_size_datum, &config_out->block_size, error_out)) {
+            error_out->msg = "In `block_size`: " + error_out->msg;
+            return false;
+        }
+        if (existed_before &&
+                config_out->block_size != old_config.config.block_size) {
+            error_out->msg = "The `block_size` field is read-only and can't be changed "
+                             "after the table has been created.";
+            return false;
+        }
+    } else {
+        config_out->block_size = DEFAULT_BTREE_BLOCK_SIZE;
+    }
+
+    config_out->expiry_field = r_nullopt;
+    if (existed_before || converter.has("expiry_field")) {
+        ql::datum_t expiry_field_datum;
+        if (!converter.get("expiry_field", &expiry_field_datum, error_out)) {
+            return false;
+        }
+        if (expiry_field_datum.get_type() != ql::datum_t::R_NULL) {
+            std::string expiry_field;
+            if (!convert_string_from_datum(
+                    expiry_field_datum, &expiry_field, error_out)) {
+                error_out->msg = "In `expiry_field`: " + error_out->msg;
+                return false;
+            }
+            if (expiry_field.empty()) {
+                error_out->msg = "In `expiry_field`: The field name can't be empty.";
+                return false;
+            }
+            config_out->expiry_field.set(expiry_field);
+        }
+    }
+    /* The background expiry finds the expired rows through a secondary index with the
+    same name as the field. We create it here unless the table already has an index of
+    that name, in which case it's used as it is. */
+    if (config_out->expiry_field &&
+            config_out->sindexes.count(*config_out->expiry_field) == 0) {
+        config_out->sindexes.insert(std::make_pair(
+            *config_out->expiry_field,
+            sindex_config_t(
+                ql::map_wire_func_t(ql::new_get_field_func(
+                    ql::datum_t(datum_string_t(*config_out->expiry_field)),
+                    ql::backtrace_id_t::empty())),
+                reql_version_t::LATEST,
+                sindex_multi_bool_t::SINGLE,
+                sindex_geo_bool_t::REGULAR)));
+    }
+
+    config_out->read_cache = false;
+    if (existed_before || converter.has("read_cache")) {
+        ql::datum_t read_cache_datum;
+        if (!converter.get("read_cache", &read_cache_datum, error_out)) {
+            return false;
+        }
+        if (read_cache_datum.get_type() != ql::datum_t::R_BOOL) {
+            error_out->msg = "In `read_cache`: Expected a boolean; got "
+                + read_cache_datum.print() + ".";
+            return false;
+        }
+        config_out->read_cache = read_cache_datum.as_bool();
+    }
+
     if (!converter.check_no_extra_keys(error_out)) {
         return false;
     }
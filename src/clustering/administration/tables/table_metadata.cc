@@ -2,6 +2,7 @@
 #include "clustering/administration/tables/table_metadata.hpp"
 
 #include "clustering/administration/tables/database_metadata.hpp"
+#include "clustering/table_contract/cpu_sharding.hpp"
 #include "containers/archive/archive.hpp"
 #include "containers/archive/boost_types.hpp"
 #include "containers/archive/stl_types.hpp"
@@ -68,6 +69,10 @@ archive_result_t deserialize_table_config_pre_v2_4(
     tc->durability = std::move(durability);
     tc->flush_interval = default_flush_interval_config();
     tc->user_data = default_user_data();
+    tc->cpu_sharding_factor = CPU_SHARDING_FACTOR;
+    tc->block_size = DEFAULT_BTREE_BLOCK_SIZE;
+    tc->expiry_field = r_nullopt;
+    tc->read_cache = false;
 
     return res;
 }
@@ -108,7 +113,11 @@ archive_result_t deserialize_table_config_v2_4(
                          std::move(write_ack_config),
                          std::move(durability),
                          default_flush_interval_config(),
-                         default_user_data()};
+                         default_user_data(),
+                         CPU_SHARDING_FACTOR,
+                         DEFAULT_BTREE_BLOCK_SIZE,
+                         r_nullopt,
+                         false};
 
     return res;
 }
@@ -137,13 +146,55 @@ archive_result_t deserialize<cluster_version_t::v2_4>(
     return deserialize_table_config_v2_4(s, tc);
 }
 
-RDB_IMPL_SERIALIZABLE_8_SINCE_v2_5(table_config_t,
+template <>
+archive_result_t deserialize<cluster_version_t::v2_5>(
+    read_stream_t *s, table_config_t *tc) {
+    const cluster_version_t W = cluster_version_t::v2_5;
+    archive_result_t res;
+
+    // Same field order as the `RDB_IMPL_SERIALIZABLE_*` below.
+    res = deserialize<W>(s, &tc->basic);
+    if (bad(res)) { return res; }
+    res = deserialize<W>(s, &tc->shards);
+    if (bad(res)) { return res; }
+    res = deserialize<W>(s, &tc->write_hook);
+    if (bad(res)) { return res; }
+    res = deserialize<W>(s, &tc->sindexes);
+    if (bad(res)) { return res; }
+    res = deserialize<W>(s, &tc->write_ack_config);
+    if (bad(res)) { return res; }
+    res = deserialize<W>(s, &tc->durability);
+    if (bad(res)) { return res; }
+    res = deserialize<W>(s, &tc->flush_interval);
+    if (bad(res)) { return res; }
+    res = deserialize<W>(s, &tc->user_data);
+    if (bad(res)) { return res; }
+
+    // Tables created before v2.6 always have the default number of CPU shards and
+    // the default block size, and no expiry or read cache.
+    tc->cpu_sharding_factor = CPU_SHARDING_FACTOR;
+    tc->block_size = DEFAULT_BTREE_BLOCK_SIZE;
+    tc->expiry_field = r_nullopt;
+    tc->read_cache = false;
+
+    return res;
+}
+
+RDB_IMPL_SERIALIZABLE_12_SINCE_v2_6(table_config_t,
     basic, shards, write_hook, sindexes, write_ack_config, durability,
-    flush_interval, user_data);
+    flush_interval, user_data, cpu_sharding_factor, block_size, expiry_field,
+    read_cache);
 
-RDB_IMPL_EQUALITY_COMPARABLE_8(table_config_t,
+RDB_IMPL_EQUALITY_COMPARABLE_12(table_config_t,
     basic, shards, write_hook, sindexes, write_ack_config, durability,
-    flush_interval, user_data);
+    flush_interval, user_data, cpu_sharding_factor, block_size, expiry_field,
+    read_cache);
+
+bool is_valid_table_block_size(int64_t block_size) {
+    return block_size >= MIN_BTREE_BLOCK_SIZE
+        && block_size <= MAX_BTREE_BLOCK_SIZE
+        && (block_size & (block_size - 1)) == 0;
+}
 
 RDB_IMPL_SERIALIZABLE_1_SINCE_v1_16(table_shard_scheme_t, split_points);
 RDB_IMPL_EQUALITY_COMPARABLE_1(table_shard_scheme_t, split_points);
@@ -107,10 +107,29 @@ public:
     write_durability_t durability;
     flush_interval_config_t flush_interval;
     user_data_t user_data;  // has user-exposed name "data"
+    /* The number of CPU shards; see `cpu_sharding.hpp`. It's fixed when the table is
+    created. */
+    int32_t cpu_sharding_factor;  // has user-exposed name "cpu_shards"
+    /* The size of the blocks in the table's data file, which must satisfy
+    `is_valid_table_block_size()`. Like the number of CPU shards, it's fixed when the
+    table is created. */
+    int32_t block_size;
+    /* If set, rows whose value for this field is a time in the past are deleted in the
+    background by the primary replicas, see `rdb_protocol/table_expiry.hpp`. They are
+    found through the secondary index of the same name. */
+    optional<std::string> expiry_field;
+    /* If true, servers keep the results of point reads of the table that they route,
+    and forget them as the changes to the rows reach them through their changefeed
+    client, see `rdb_protocol/read_cache.hpp`. */
+    bool read_cache;
 };
 
 RDB_DECLARE_EQUALITY_COMPARABLE(table_config_t);
 
+/* Block sizes are powers of two between `MIN_BTREE_BLOCK_SIZE` and
+`MAX_BTREE_BLOCK_SIZE`. */
+bool is_valid_table_block_size(int64_t block_size);
+
 RDB_DECLARE_SERIALIZABLE(table_config_t::shard_t);
 RDB_DECLARE_EQUALITY_COMPARABLE(table_config_t::shard_t);
 
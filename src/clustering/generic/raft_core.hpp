@@ -747,9 +747,15 @@ private:
     the maximum value set here: */
     const int32_t election_retry_timeout_max_ms = 30000;
 
-    /* When the number of committed entries in the log exceeds this number, we will take
-    a snapshot to compress them. */
+    /* When the number of committed entries in the log exceeds `snapshot_threshold`, we
+    will take a snapshot to compress them. But if we're the leader and a follower is
+    only a few entries behind, we hold off: we can bring it up to date by sending just
+    the entries it's missing, whereas once they're gone we have to send it the entire
+    state in an install-snapshot RPC. We never let the log grow beyond
+    `snapshot_threshold_max` committed entries, so a follower that goes away for a long
+    time can't make the log grow without bound. */
     const size_t snapshot_threshold = 20;
+    const size_t snapshot_threshold_max = 200;
 
     /* Note: Methods prefixed with `follower_`, `candidate_`, or `leader_` are methods
     that are only used when in that state. This convention will hopefully make the code
@@ -1173,9 +1173,19 @@ void raft_member_t<state_t>::update_commit_index(
     so that the tests will exercise many different code paths. */
     bool should_take_snapshot = (randint(3) == 0);
 #else
-    /* In release mode, snapshot when the log grows beyond a certain margin. */
+    /* In release mode, snapshot when the log grows beyond a certain margin, unless a
+    follower that's catching up still needs the entries. */
     size_t num_committed_entries = new_commit_index - ps().log.prev_index;
-    bool should_take_snapshot = (num_committed_entries > snapshot_threshold);
+    bool should_take_snapshot = (num_committed_entries > snapshot_threshold_max);
+    if (!should_take_snapshot && num_committed_entries > snapshot_threshold) {
+        should_take_snapshot = true;
+        for (const auto &pair : match_indexes) {
+            if (pair.second > ps().log.prev_index && pair.second < new_commit_index) {
+                should_take_snapshot = false;
+                break;
+            }
+        }
+    }
 #endif /* NDEBUG */
     if (should_take_snapshot) {
         /* Take a snapshot as described in Section 7.
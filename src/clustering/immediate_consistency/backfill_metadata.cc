@@ -3,14 +3,15 @@
 
 backfill_config_t::backfill_config_t() :
     item_queue_mem_size(4 * MEGABYTE),
+    max_item_queue_mem_size(32 * MEGABYTE),
     item_chunk_mem_size(100 * KILOBYTE),
     pre_item_queue_mem_size(4 * MEGABYTE),
     pre_item_chunk_mem_size(100 * KILOBYTE)
     { }
 
-RDB_IMPL_SERIALIZABLE_4_FOR_CLUSTER(backfill_config_t,
-    item_queue_mem_size, item_chunk_mem_size, pre_item_queue_mem_size,
-    pre_item_chunk_mem_size);
+RDB_IMPL_SERIALIZABLE_5_FOR_CLUSTER(backfill_config_t,
+    item_queue_mem_size, max_item_queue_mem_size, item_chunk_mem_size,
+    pre_item_queue_mem_size, pre_item_chunk_mem_size);
 
 RDB_IMPL_SERIALIZABLE_8_FOR_CLUSTER(backfiller_bcard_t::intro_2_t,
     common_version, final_version_history, pre_items_mailbox, begin_session_mailbox,
@@ -23,6 +23,13 @@ public:
     backfillee. */
     size_t item_queue_mem_size;
 
+    /* The backfiller starts out allowing `item_queue_mem_size` bytes of items to be in
+    flight or queued on the backfillee. If the link has a high latency, that isn't enough
+    to keep it busy, so the backfiller grows the limit towards twice the measured
+    bandwidth-delay product, but never beyond `max_item_queue_mem_size`. If this is no
+    larger than `item_queue_mem_size`, the limit stays fixed. */
+    size_t max_item_queue_mem_size;
+
     /* The maximum size, in bytes, of a chunk of items sent over the network from the
     backfiller to the backfillee. */
     size_t item_chunk_mem_size;
@@ -0,0 +1,59 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "clustering/immediate_consistency/backfill_throttler.hpp"
+
+#include <algorithm>
+
+#include "arch/timing.hpp"
+
+/* A backfill that has been idle may save up at most `MAX_BURST_MS` worth of its pace,
+and once it has to wait it waits until it has `RESUME_MS` worth. Waiting for more than
+the bare minimum matters because every pause ends a call to `receive_backfill()`, which
+flushes the store. */
+static const int64_t MAX_BURST_MS = 1000;
+static const int64_t RESUME_MS = 100;
+
+/* `wait_for_pace()` naps for at most this long at a time, so that it notices if the
+throttler raises the pace in the meantime. */
+static const int64_t MAX_PACE_NAP_MS = 100;
+
+bool backfill_throttler_t::lock_t::pace(size_t mem_size) {
+    assert_thread();
+    parent->paced_bytes.fetch_add(mem_size, std::memory_order_relaxed);
+    if (refill_budget() == 0) {
+        return true;
+    }
+    budget -= mem_size;
+    return budget > 0;
+}
+
+void backfill_throttler_t::lock_t::wait_for_pace(signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t) {
+    assert_thread();
+    while (true) {
+        int64_t rate = refill_budget();
+        int64_t wanted = rate * RESUME_MS / THOUSAND;
+        if (rate == 0 || budget >= wanted) {
+            return;
+        }
+        int64_t ms = (wanted - budget) * THOUSAND / rate + 1;
+        nap(std::min(ms, MAX_PACE_NAP_MS), interruptor);
+    }
+}
+
+int64_t backfill_throttler_t::lock_t::refill_budget() {
+    ticks_t now = get_ticks();
+    int64_t rate = parent->pace_bytes_per_sec.load(std::memory_order_relaxed);
+    if (rate == 0) {
+        budget = 0;
+    } else {
+        /* Compute in floating point because `rate` times a long idle period in
+        nanoseconds could overflow */
+        double earned = static_cast<double>(rate)
+            * (now.nanos - last_refill.nanos) / BILLION;
+        int64_t max_budget = rate * MAX_BURST_MS / THOUSAND;
+        budget = earned >= max_budget
+            ? max_budget : std::min(budget + static_cast<int64_t>(earned), max_budget);
+    }
+    last_refill = now;
+    return rate;
+}
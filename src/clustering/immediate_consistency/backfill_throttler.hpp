@@ -2,6 +2,7 @@
 #ifndef CLUSTERING_IMMEDIATE_CONSISTENCY_BACKFILL_THROTTLER_HPP_
 #define CLUSTERING_IMMEDIATE_CONSISTENCY_BACKFILL_THROTTLER_HPP_
 
+#include <atomic>
 #include <map>
 
 #include "concurrency/interruptor.hpp"
@@ -9,6 +10,7 @@
 #include "containers/scoped.hpp"
 #include "rpc/connectivity/peer_id.hpp"
 #include "threading.hpp"
+#include "time.hpp"
 
 /* `backfill_throttler_t` controls which backfills are allowed to run when. It can block
 backfills from starting and also preempt already-running backfills. It's abstract to make
@@ -47,7 +49,7 @@ public:
                const priority_t &_priority,
                signal_t *interruptor)
             THROWS_ONLY(interrupted_exc_t) :
-            priority(_priority), parent(p)
+            priority(_priority), parent(p), budget(0), last_refill(get_ticks())
         {
             parent->enter(this, interruptor);
         }
@@ -57,16 +59,35 @@ public:
         signal_t *get_preempt_signal() {
             return &preempt_signal;
         }
+
+        /* The backfill calls `pace()` with the mem size of every item it applies. If it
+        returns `false`, the backfill has used up the rate that the throttler allows it
+        right now, and it should call `wait_for_pace()` before applying more items.
+        Unlike preemption, pacing doesn't give up the lock. */
+        bool pace(size_t mem_size);
+        void wait_for_pace(signal_t *interruptor) THROWS_ONLY(interrupted_exc_t);
+
         const priority_t priority;
     private:
         friend class backfill_throttler_t;
+
+        /* Adds to `budget` whatever the current pace allows for the time since
+        `last_refill`, and returns the pace. */
+        int64_t refill_budget();
+
         backfill_throttler_t *parent;
         cond_t preempt_signal;
+
+        /* The number of bytes the backfill may still apply before it has to wait. This
+        goes negative because we only learn an item's size after it's been applied. */
+        int64_t budget;
+        ticks_t last_refill;
     };
 
 protected:
     friend class lock_t;
 
+    backfill_throttler_t() : pace_bytes_per_sec(0), paced_bytes(0) { }
     virtual ~backfill_throttler_t() { }
 
     virtual void enter(lock_t *lock, signal_t *interruptor) = 0;
@@ -77,6 +98,21 @@ protected:
     void preempt(lock_t *lock) {
         lock->preempt_signal.pulse();
     }
+
+    /* Subclasses call `set_pace()` to limit how fast each backfill may apply items,
+    or pass zero to remove the limit. `get_paced_bytes()` is the total mem size of the
+    items that backfills have passed to `pace()`, so subclasses can measure how fast the
+    backfills are actually going. Both can be called from any thread. */
+    void set_pace(int64_t bytes_per_sec) {
+        pace_bytes_per_sec.store(bytes_per_sec, std::memory_order_relaxed);
+    }
+    int64_t get_paced_bytes() const {
+        return paced_bytes.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<int64_t> pace_bytes_per_sec;
+    std::atomic<int64_t> paced_bytes;
 };
 
 #endif  // CLUSTERING_IMMEDIATE_CONSISTENCY_BACKFILL_THROTTLER_HPP_
@@ -40,7 +40,8 @@ public:
         sent_end_session(false),
         metainfo(region_map_t<version_t>::empty()),
         metainfo_binary(region_map_t<binary_blob_t>::empty()),
-        pulse_when_items_arrive(nullptr)
+        pulse_when_items_arrive(nullptr),
+        paused_for_pace(false)
     {
         coro_t::spawn_sometime(std::bind(
             &session_t::run, this, drainer.lock()));
@@ -123,6 +124,15 @@ private:
                     wait_interruptible(&waiter, keepalive.get_drain_signal());
                 }
 
+                /* If the callback told us to slow down, wait until it lets us go on.
+                We ack the items we've applied first, so the backfiller doesn't sit on
+                them while we wait. */
+                if (paused_for_pace) {
+                    send_ack_items();
+                    callback->wait_for_pace(keepalive.get_drain_signal());
+                    paused_for_pace = false;
+                }
+
                 /* Set up a `region_t` describing the range that still needs to be
                 backfilled */
                 region_t subregion = parent->store->get_region();
@@ -142,11 +152,18 @@ private:
                             bool *is_item_out,
                             backfill_item_t *item_out,
                             key_range_t::right_bound_t *empty_range_out) THROWS_NOTHING {
-                        if (!parent->items.empty_of_items()) {
+                        if (parent->paused_for_pace) {
+                            /* Break out of `receive_backfill()` so that `run()` can
+                            wait for the callback's pace. */
+                            return continue_bool_t::ABORT;
+                        } else if (!parent->items.empty_of_items()) {
                             /* This is the common case. */
                             *is_item_out = true;
                             *item_out = parent->items.front();
                             parent->items.pop_front();
+                            if (!parent->callback->pace(item_out->get_mem_size())) {
+                                parent->paused_for_pace = true;
+                            }
                             return continue_bool_t::CONTINUE;
                         } else if (!parent->items.empty_domain()) {
                             /* There aren't any more items left in the queue, but there's
@@ -307,6 +324,11 @@ private:
     `items`. */
     cond_t *pulse_when_items_arrive;
 
+    /* `paused_for_pace` is set when `callback->pace()` returns `false`. The producer
+    then stops handing items to the store, and `run()` calls `callback->wait_for_pace()`
+    before it goes on. */
+    bool paused_for_pace;
+
     /* `run()` pulses this when the session is completely over */
     cond_t done_cond;
 
@@ -52,6 +52,16 @@ public:
     public:
         virtual bool on_progress(
             const region_map_t<version_t> &chunk) THROWS_NOTHING = 0;
+
+        /* `pace()` is called with the mem size of every backfill item before it's
+        applied. If it returns `false`, the backfillee applies that item but then stops
+        and calls `wait_for_pace()` before it applies any more. This lets the callback
+        limit the rate of the backfill without ending the session. */
+        virtual bool pace(UNUSED size_t mem_size) THROWS_NOTHING {
+            return true;
+        }
+        virtual void wait_for_pace(UNUSED signal_t *interruptor)
+            THROWS_ONLY(interrupted_exc_t) { }
     protected:
         virtual ~callback_t() { }
     };
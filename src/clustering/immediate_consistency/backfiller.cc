@@ -1,6 +1,8 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "clustering/immediate_consistency/backfiller.hpp"
 
+#include <algorithm>
+
 #include "clustering/immediate_consistency/history.hpp"
 #include "rdb_protocol/distribution_progress.hpp"
 #include "rdb_protocol/protocol.hpp"
@@ -27,6 +29,11 @@ backfiller_t::client_t::client_t(
         key_range_t::right_bound_t(full_region.inner.left)),
     item_throttler(intro.config.item_queue_mem_size),
     item_throttler_acq(&item_throttler, 0),
+    items_sent(0),
+    items_acked(0),
+    last_ack_time(get_ticks()),
+    min_ack_rtt_nanos(-1),
+    ack_bytes_per_nano(0),
     pre_items_mailbox(parent->mailbox_manager,
         std::bind(&client_t::on_pre_items, this, ph::_1, ph::_2, ph::_3)),
     begin_session_mailbox(parent->mailbox_manager,
@@ -363,6 +370,7 @@ private:
                     ownership. */
                     sem_acq.change_count(chunk.get_mem_size());
                     parent->item_throttler_acq.transfer_in(std::move(sem_acq));
+                    parent->on_sent_items(chunk.get_mem_size());
 
                     /* Update `threshold` */
                     guarantee(chunk.get_left_key() == threshold);
@@ -482,6 +490,48 @@ void backfiller_t::client_t::on_ack_items(
 
     guarantee(static_cast<int64_t>(mem_size) <= item_throttler_acq.count());
     item_throttler_acq.change_count(item_throttler_acq.count() - mem_size);
+    adjust_item_window(mem_size);
+}
+
+void backfiller_t::client_t::on_sent_items(size_t mem_size) {
+    items_sent += mem_size;
+    unacked_chunks.push_back(std::make_pair(items_sent, get_ticks()));
+}
+
+void backfiller_t::client_t::adjust_item_window(size_t acked_mem_size) {
+    ticks_t now = get_ticks();
+    items_acked += acked_mem_size;
+
+    /* The backfillee acknowledges items once it has applied them, so the time from
+    sending a chunk until it's fully acknowledged is an upper bound on the round-trip
+    time. */
+    while (!unacked_chunks.empty() && unacked_chunks.front().first <= items_acked) {
+        int64_t rtt = now.nanos - unacked_chunks.front().second.nanos;
+        if (min_ack_rtt_nanos == -1 || rtt < min_ack_rtt_nanos) {
+            min_ack_rtt_nanos = rtt;
+        }
+        unacked_chunks.pop_front();
+    }
+
+    int64_t elapsed = std::max<int64_t>(now.nanos - last_ack_time.nanos, 1);
+    last_ack_time = now;
+    double rate = static_cast<double>(acked_mem_size) / elapsed;
+    ack_bytes_per_nano = ack_bytes_per_nano == 0
+        ? rate : ack_bytes_per_nano * 0.875 + rate * 0.125;
+
+    size_t min_window = intro.config.item_queue_mem_size;
+    size_t max_window = intro.config.max_item_queue_mem_size;
+    if (max_window <= min_window || min_ack_rtt_nanos == -1) {
+        return;
+    }
+
+    /* Keeping twice the bandwidth-delay product in flight means the backfillee's queue
+    doesn't run dry while the acknowledgements travel back to us. If we're the ones who
+    are slow, the measured rate is low and the window stays small, which is fine. */
+    double target = 2 * ack_bytes_per_nano * min_ack_rtt_nanos;
+    size_t window = std::min(max_window,
+        std::max(min_window, static_cast<size_t>(target)));
+    item_throttler.set_capacity(window);
 }
 
 void backfiller_t::client_t::on_pre_items(
@@ -2,6 +2,7 @@
 #ifndef CLUSTERING_IMMEDIATE_CONSISTENCY_BACKFILLER_HPP_
 #define CLUSTERING_IMMEDIATE_CONSISTENCY_BACKFILLER_HPP_
 
+#include <deque>
 #include <map>
 #include <utility>
 
@@ -9,6 +10,7 @@
 #include "clustering/immediate_consistency/history.hpp"
 #include "clustering/immediate_consistency/backfill_metadata.hpp"
 #include "store_view.hpp"
+#include "time.hpp"
 
 class backfill_progress_tracker_t;
 
@@ -61,6 +63,13 @@ private:
             const fifo_enforcer_write_token_t &write_token,
             backfill_item_seq_t<backfill_pre_item_t> &&chunk);
 
+        /* `session_t` calls `on_sent_items()` whenever it sends a chunk of items to the
+        backfillee. `on_ack_items()` matches the acknowledgements against the chunks to
+        measure the round-trip time and the rate at which the backfillee consumes items,
+        and then calls `adjust_item_window()` to resize `item_throttler`. */
+        void on_sent_items(size_t mem_size);
+        void adjust_item_window(size_t acked_mem_size);
+
         backfiller_t *const parent;
 
         /* `intro` is what we received from the backfillee in the initial handshake. */
@@ -100,6 +109,18 @@ private:
         new_semaphore_t item_throttler;
         new_semaphore_in_line_t item_throttler_acq;
 
+        /* These track the items in flight, so that we can size `item_throttler` to keep
+        the link to the backfillee busy. `unacked_chunks` holds the value that
+        `items_sent` had right after each chunk we haven't seen acknowledged yet, along
+        with the time when we sent the chunk. `min_ack_rtt` is the smallest round-trip
+        time we've seen; we use the smallest rather than the average because items that
+        wait in the backfillee's queue make the round trip look longer than it is. */
+        uint64_t items_sent, items_acked;
+        std::deque<std::pair<uint64_t, ticks_t> > unacked_chunks;
+        ticks_t last_ack_time;
+        int64_t min_ack_rtt_nanos;
+        double ack_bytes_per_nano;
+
         scoped_ptr_t<session_t> current_session;
 
         backfiller_bcard_t::pre_items_mailbox_t pre_items_mailbox;
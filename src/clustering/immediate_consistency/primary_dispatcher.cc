@@ -1,8 +1,13 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "clustering/immediate_consistency/primary_dispatcher.hpp"
 
-/* Limits how many writes should be sent to a dispatchee at once. */
+/* Limits how many writes should be sent to a dispatchee at once. A write to a remote
+dispatchee spends most of its time on the network, and the secondary applies the writes
+it has received concurrently (the B-tree only orders them while they hold the
+superblock). So the number of writes in flight to a secondary bounds how fast it can
+apply them, and we allow more of them than for the primary's own store. */
 const size_t DISPATCH_WRITES_CORO_POOL_SIZE = 64;
+const size_t DISPATCH_REMOTE_WRITES_CORO_POOL_SIZE = 256;
 
 primary_dispatcher_t::dispatchee_registration_t::dispatchee_registration_t(
         primary_dispatcher_t *_parent,
@@ -15,13 +20,16 @@ primary_dispatcher_t::dispatchee_registration_t::dispatchee_registration_t(
     server_id(_server_id),
     priority(_priority),
     is_ready(false),
+    lagged_too_far(false),
     queue_count_membership(
         &parent->perfmon_collection,
         &queue_count,
         uuid_to_str(server_id.get_uuid()) + "_broadcast_queue_count"),
     background_write_queue(&queue_count),
     background_write_workers(
-        DISPATCH_WRITES_CORO_POOL_SIZE,
+        dispatchee->is_primary()
+            ? DISPATCH_WRITES_CORO_POOL_SIZE
+            : DISPATCH_REMOTE_WRITES_CORO_POOL_SIZE,
         &background_write_queue,
         &background_write_caller),
     latest_acked_write(state_timestamp_t::zero())
@@ -106,7 +114,7 @@ void primary_dispatcher_t::read(
         std::pair<state_timestamp_t, double> best;
         for (const auto &pair : dispatchees) {
             dispatchee_registration_t *d = pair.first;
-            if (!d->is_ready) {
+            if (!d->is_ready || d->lagged_too_far) {
                 continue;
             }
             if (_read.route_to_primary() && !d->dispatchee->is_primary()) {
@@ -187,10 +195,29 @@ void primary_dispatcher_t::spawn_write(
     guarantee(cb->write == nullptr);
     cb->write = incomplete_write.get();
 
+    bool dropped_dispatchee = false;
     for (const auto &pair : dispatchees) {
-        pair.first->background_write_queue.push(
+        dispatchee_registration_t *d = pair.first;
+        if (d->lagged_too_far) {
+            continue;
+        }
+        size_t max_queued = d->dispatchee->max_queued_writes();
+        if (max_queued != 0
+                && static_cast<size_t>(d->background_write_queue.size()) >= max_queued) {
+            d->lagged_too_far = true;
+            dropped_dispatchee = true;
+            auto_drainer_t::lock_t keepalive = pair.second;
+            coro_t::spawn_sometime([d, keepalive]() {
+                d->dispatchee->on_lagged_too_far();
+            });
+            continue;
+        }
+        d->background_write_queue.push(
             std::bind(&primary_dispatcher_t::background_write, this,
-                pair.first, pair.second, incomplete_write));
+                d, pair.second, incomplete_write));
+    }
+    if (dropped_dispatchee) {
+        refresh_ready_dispatchees_as_set();
     }
 }
 
@@ -212,6 +239,10 @@ void primary_dispatcher_t::background_write(
         dispatchee_registration_t *dispatchee,
         auto_drainer_t::lock_t dispatchee_lock,
         counted_t<incomplete_write_t> write) THROWS_NOTHING {
+    if (dispatchee->lagged_too_far) {
+        /* The dispatchee will catch up with a backfill instead. */
+        return;
+    }
     try {
         /* Use a special path for dummy writes.
         dummy writes are used to check the table status, so we don't want to generate
@@ -271,7 +302,7 @@ void primary_dispatcher_t::refresh_ready_dispatchees_as_set() {
     dispatchee before we realize that its original dispatchee is no longer valid. */
     std::set<server_id_t> ready;
     for (const auto &pair : dispatchees) {
-        if (pair.first->is_ready) {
+        if (pair.first->is_ready && !pair.first->lagged_too_far) {
             ready.insert(pair.first->server_id);
         }
     }
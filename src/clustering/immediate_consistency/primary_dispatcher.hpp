@@ -61,6 +61,17 @@ public:
         virtual void do_dummy_write(
             signal_t *interruptor,
             write_response_t *response_out) = 0;
+
+        /* Replicas that don't count towards write acks can ask the
+        `primary_dispatcher_t` not to let them slow it down. If more than
+        `max_queued_writes()` writes are waiting to be sent to such a dispatchee, the
+        `primary_dispatcher_t` stops sending it reads and writes and calls
+        `on_lagged_too_far()` (in a separate coroutine). The dispatchee is then expected
+        to deregister and catch up with a backfill. Zero means there is no limit. */
+        virtual size_t max_queued_writes() const {
+            return 0;
+        }
+        virtual void on_lagged_too_far() { }
     protected:
         virtual ~dispatchee_t() { }
     };
@@ -101,6 +112,10 @@ public:
 
         bool is_ready;
 
+        /* Set once we've given up on the dispatchee because of `max_queued_writes()`.
+        From then on it doesn't get any reads or writes. */
+        bool lagged_too_far;
+
         perfmon_counter_t queue_count;
         perfmon_membership_t queue_count_membership;
 
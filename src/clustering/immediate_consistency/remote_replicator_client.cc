@@ -4,9 +4,27 @@
 #include "clustering/immediate_consistency/backfill_throttler.hpp"
 #include "clustering/immediate_consistency/backfillee.hpp"
 #include "clustering/table_manager/backfill_progress_tracker.hpp"
+#include "concurrency/pmap.hpp"
+#include "concurrency/wait_any.hpp"
 #include "stl_utils.hpp"
 #include "store_view.hpp"
 
+/* `pending_write_t` keeps a write in `pending_writes_` for as long as it exists. */
+class remote_replicator_client_t::pending_write_t {
+public:
+    pending_write_t(remote_replicator_client_t *_parent, state_timestamp_t _timestamp) :
+            parent(_parent), timestamp(_timestamp) {
+        parent->pending_writes_.insert(std::make_pair(timestamp, get_ticks()));
+    }
+    ~pending_write_t() {
+        parent->pending_writes_.erase(timestamp);
+    }
+private:
+    remote_replicator_client_t *parent;
+    state_timestamp_t timestamp;
+    DISABLE_COPYING(pending_write_t);
+};
+
 class remote_replicator_client_t::timestamp_range_tracker_t {
 public:
     timestamp_range_tracker_t(
@@ -152,7 +170,7 @@ remote_replicator_client_t::remote_replicator_client_t(
         store_view_t *store,
         branch_history_manager_t *branch_history_manager,
 
-        signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) :
+        signal_t *outer_interruptor) THROWS_ONLY(interrupted_exc_t) :
 
     mailbox_manager_(mailbox_manager),
     store_(store),
@@ -168,13 +186,27 @@ remote_replicator_client_t::remote_replicator_client_t(
     write_sync_mailbox_(mailbox_manager,
         std::bind(&remote_replicator_client_t::on_write_sync, this,
             ph::_1, ph::_2, ph::_3, ph::_4, ph::_5, ph::_6)),
+    write_sync_batch_mailbox_(mailbox_manager,
+        std::bind(&remote_replicator_client_t::on_write_sync_batch, this,
+            ph::_1, ph::_2)),
     dummy_write_mailbox_(mailbox_manager,
         std::bind(&remote_replicator_client_t::on_dummy_write, this,
             ph::_1, ph::_2)),
     read_mailbox_(mailbox_manager,
         std::bind(&remote_replicator_client_t::on_read, this,
-            ph::_1, ph::_2, ph::_3, ph::_4))
+            ph::_1, ph::_2, ph::_3, ph::_4)),
+    lagged_too_far_mailbox_(mailbox_manager,
+        [this](signal_t *) {
+            if (!lagged_too_far_.is_pulsed()) {
+                lagged_too_far_.pulse();
+            }
+        })
 {
+    /* If the primary gives up on us while we're still backfilling, the streaming
+    writes stop arriving, so the backfill could never finish. */
+    wait_any_t interruptor_or_lagged(outer_interruptor, &lagged_too_far_);
+    signal_t *interruptor = &interruptor_or_lagged;
+
     guarantee(remote_replicator_server_bcard.branch == branch_id);
     guarantee(remote_replicator_server_bcard.region == region_);
 
@@ -210,8 +242,11 @@ remote_replicator_client_t::remote_replicator_client_t(
             intro_mailbox.get_address(),
             write_async_mailbox_.get_address(),
             write_sync_mailbox_.get_address(),
+            write_sync_batch_mailbox_.get_address(),
             dummy_write_mailbox_.get_address(),
-            read_mailbox_.get_address() };
+            read_mailbox_.get_address(),
+            is_critical_priority == backfill_throttler_t::priority_t::critical_t::NO,
+            lagged_too_far_mailbox_.get_address() };
         registrant_.init(new registrant_t<remote_replicator_client_bcard_t>(
             mailbox_manager, remote_replicator_server_bcard.registrar, our_bcard));
         wait_interruptible(&got_intro, interruptor);
@@ -270,8 +305,8 @@ remote_replicator_client_t::remote_replicator_client_t(
         lock tells us to pause again */
         class callback_t : public backfillee_t::callback_t {
         public:
-            callback_t(remote_replicator_client_t *p, signal_t *ps) :
-                parent(p), preempt_signal(ps) { }
+            callback_t(remote_replicator_client_t *p, backfill_throttler_t::lock_t *l) :
+                parent(p), throttler_lock(l), preempt_signal(l->get_preempt_signal()) { }
             bool on_progress(const region_map_t<version_t> &chunk) THROWS_NOTHING {
                 mutex_assertion_t::acq_t mutex_assertion_acq(&parent->mutex_assertion_);
                 chunk.visit(chunk.get_domain(),
@@ -289,9 +324,26 @@ remote_replicator_client_t::remote_replicator_client_t(
                 return parent->store_->check_ok_to_receive_backfill()
                     && !preempt_signal->is_pulsed();
             }
+            /* The backfill throttler may also slow us down when the server is busy
+            with queries. */
+            bool pace(size_t mem_size) THROWS_NOTHING {
+                return throttler_lock->pace(mem_size);
+            }
+            void wait_for_pace(signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) {
+                wait_any_t waiter(preempt_signal, interruptor);
+                try {
+                    throttler_lock->wait_for_pace(&waiter);
+                } catch (const interrupted_exc_t &) {
+                    if (interruptor->is_pulsed()) {
+                        throw;
+                    }
+                    /* We were preempted; `on_progress()` will end the session. */
+                }
+            }
             remote_replicator_client_t *parent;
+            backfill_throttler_t::lock_t *throttler_lock;
             signal_t *preempt_signal;
-        } callback(this, backfill_throttler_lock.get_preempt_signal());
+        } callback(this, &backfill_throttler_lock);
 
         backfillee.go(
             &callback,
@@ -366,6 +418,13 @@ remote_replicator_client_t::~remote_replicator_client_t() {
     destructor for `timestamp_range_tracker_t` */
 }
 
+int64_t remote_replicator_client_t::get_lag_ms() const {
+    if (pending_writes_.empty()) {
+        return 0;
+    }
+    return (get_ticks().nanos - pending_writes_.begin()->second.nanos) / MILLION;
+}
+
 void remote_replicator_client_t::on_write_async(
         signal_t *interruptor,
         write_t &&write,
@@ -373,6 +432,7 @@ void remote_replicator_client_t::on_write_async(
         order_token_t order_token,
         const mailbox_t<>::address_t &ack_addr)
         THROWS_ONLY(interrupted_exc_t) {
+    pending_write_t pending_write(this, timestamp);
     wait_interruptible(&registered_, interruptor);
 
     timestamp_enforcer_->wait_all_before(timestamp.pred(), interruptor);
@@ -457,6 +517,7 @@ void remote_replicator_client_t::on_write_sync(
     /* The current implementation of the dispatcher will never send us an async write
     once it's started sending sync writes, but we don't want to rely on that detail, so
     we pass sync writes through the timestamp enforcer too. */
+    pending_write_t pending_write(this, timestamp);
     timestamp_enforcer_->complete(timestamp);
 
     write_response_t response;
@@ -466,6 +527,26 @@ void remote_replicator_client_t::on_write_sync(
     send(mailbox_manager_, ack_addr, response);
 }
 
+void remote_replicator_client_t::on_write_sync_batch(
+        signal_t *interruptor,
+        const std::vector<remote_replicator_sync_write_t> &writes)
+        THROWS_ONLY(interrupted_exc_t) {
+    /* The writes are applied concurrently, just as if they had arrived in separate
+    messages; `replica_` takes care of ordering them by timestamp. */
+    pmap(writes.size(), [&](size_t i) {
+        const remote_replicator_sync_write_t &w = writes[i];
+        try {
+            on_write_sync(interruptor, w.write, w.timestamp, w.order_token,
+                w.durability, w.ack_addr);
+        } catch (const interrupted_exc_t &) {
+            /* We'll notice the interruption below */
+        }
+    });
+    if (interruptor->is_pulsed()) {
+        throw interrupted_exc_t();
+    }
+}
+
 void remote_replicator_client_t::on_dummy_write(
         signal_t *interruptor,
         const mailbox_t<write_response_t>::address_t &ack_addr)
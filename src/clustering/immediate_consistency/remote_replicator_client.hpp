@@ -2,6 +2,7 @@
 #ifndef CLUSTERING_IMMEDIATE_CONSISTENCY_REMOTE_REPLICATOR_CLIENT_HPP_
 #define CLUSTERING_IMMEDIATE_CONSISTENCY_REMOTE_REPLICATOR_CLIENT_HPP_
 
+#include <map>
 #include <queue>
 
 #include "clustering/generic/registrant.hpp"
@@ -11,6 +12,7 @@
 #include "concurrency/coro_pool.hpp"
 #include "concurrency/queue/disk_backed_queue_wrapper.hpp"
 #include "concurrency/semaphore.hpp"
+#include "time.hpp"
 
 class backfill_progress_tracker_t;
 
@@ -75,11 +77,26 @@ public:
 
     ~remote_replicator_client_t();
 
+    /* Returns how many milliseconds the store is behind the writes we've received from
+    the primary: the age of the oldest write that has arrived but hasn't been applied
+    yet, or zero if there is none. Must be called on the store's thread. */
+    int64_t get_lag_ms() const;
+
+    /* Pulsed if we're a non-voting replica and the primary stopped sending us writes
+    because we fell too far behind. The caller should then destroy the
+    `remote_replicator_client_t` and construct a new one, which will catch up with a
+    backfill. Lives on the store's thread. */
+    signal_t *get_lagged_too_far_signal() {
+        return &lagged_too_far_;
+    }
+
 private:
     class timestamp_range_tracker_t;
+    class pending_write_t;
 
-    /* `on_write_async()`, `on_write_sync()`, `on_dummy_write()`, and `on_read()`
-    are mailbox callbacks for `write_async_mailbox_`, `write_sync_mailbox_`,
+    /* `on_write_async()`, `on_write_sync()`, `on_write_sync_batch()`,
+    `on_dummy_write()`, and `on_read()` are mailbox callbacks for
+    `write_async_mailbox_`, `write_sync_mailbox_`, `write_sync_batch_mailbox_`,
     `dummy_write_mailbox_` and `read_mailbox_`. */
     void on_write_async(
             signal_t *interruptor,
@@ -98,6 +115,11 @@ private:
             const mailbox_t<write_response_t>::address_t &ack_addr)
         THROWS_ONLY(interrupted_exc_t);
 
+    void on_write_sync_batch(
+            signal_t *interruptor,
+            const std::vector<remote_replicator_sync_write_t> &writes)
+        THROWS_ONLY(interrupted_exc_t);
+
     void on_dummy_write(
             signal_t *interruptor,
             const mailbox_t<write_response_t>::address_t &ack_addr)
@@ -165,15 +187,25 @@ private:
     `on_write_async()` has to wait for it before proceeding. */
     cond_t registered_;
 
+    /* `lagged_too_far_` is pulsed via `lagged_too_far_mailbox_`. */
+    cond_t lagged_too_far_;
+
     /* `cleanup_rwlock_` is used to temporarily lock out writes when doing the very last
     phase of the backfill. Writes acquire it in read mode; the last phase of the backfill
     acquires it in write mode. */
     rwlock_t cleanup_rwlock_;
 
+    /* `pending_writes_` maps the timestamp of every streaming write that has arrived
+    but hasn't been applied yet to the time it arrived, for `get_lag_ms()`. */
+    std::map<state_timestamp_t, ticks_t> pending_writes_;
+
     remote_replicator_client_bcard_t::write_async_mailbox_t write_async_mailbox_;
     remote_replicator_client_bcard_t::write_sync_mailbox_t write_sync_mailbox_;
+    remote_replicator_client_bcard_t::write_sync_batch_mailbox_t
+        write_sync_batch_mailbox_;
     remote_replicator_client_bcard_t::dummy_write_mailbox_t dummy_write_mailbox_;
     remote_replicator_client_bcard_t::read_mailbox_t read_mailbox_;
+    remote_replicator_client_bcard_t::lagged_too_far_mailbox_t lagged_too_far_mailbox_;
 
     /* We use `registrant_` to subscribe to a stream of reads and writes from the
     dispatcher via the `remote_replicator_server_t`. */
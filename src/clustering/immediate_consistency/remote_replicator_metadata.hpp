@@ -4,6 +4,7 @@
 
 #include "clustering/generic/registration_metadata.hpp"
 #include "clustering/immediate_consistency/history.hpp"
+#include "containers/archive/stl_types.hpp"
 #include "rdb_protocol/protocol.hpp"
 
 class remote_replicator_client_intro_t {
@@ -16,6 +17,19 @@ public:
 
 RDB_DECLARE_SERIALIZABLE(remote_replicator_client_intro_t);
 
+/* One of the writes in a message to `write_sync_batch_mailbox`. Each write is acked
+separately, exactly as if it had been sent to `write_sync_mailbox`. */
+class remote_replicator_sync_write_t {
+public:
+    write_t write;
+    state_timestamp_t timestamp;
+    order_token_t order_token;
+    write_durability_t durability;
+    mailbox_t<write_response_t>::address_t ack_addr;
+};
+
+RDB_DECLARE_SERIALIZABLE(remote_replicator_sync_write_t);
+
 class remote_replicator_client_bcard_t {
 public:
     typedef mailbox_t<
@@ -29,6 +43,9 @@ public:
         write_t, state_timestamp_t, order_token_t, write_durability_t,
         mailbox_t<write_response_t>::address_t
         > write_sync_mailbox_t;
+    typedef mailbox_t<
+        std::vector<remote_replicator_sync_write_t>
+        > write_sync_batch_mailbox_t;
     typedef mailbox_t<
         mailbox_t<write_response_t>::address_t
         > dummy_write_mailbox_t;
@@ -36,13 +53,22 @@ public:
         read_t, state_timestamp_t,
         mailbox_t<read_response_t>::address_t
         > read_mailbox_t;
+    typedef mailbox_t<> lagged_too_far_mailbox_t;
 
     server_id_t server_id;
     intro_mailbox_t::address_t intro_mailbox;
     write_async_mailbox_t::address_t write_async_mailbox;
     write_sync_mailbox_t::address_t write_sync_mailbox;
+    write_sync_batch_mailbox_t::address_t write_sync_batch_mailbox;
     dummy_write_mailbox_t::address_t dummy_write_mailbox;
     read_mailbox_t::address_t read_mailbox;
+
+    /* If `lag_tolerant` is true, the primary may stop sending us writes if we fall too
+    far behind. It tells us so via `lagged_too_far_mailbox`; we then have to reconnect
+    and backfill. Non-voting replicas use this so that they can't hold up the primary
+    if they're far away. */
+    bool lag_tolerant;
+    lagged_too_far_mailbox_t::address_t lagged_too_far_mailbox;
 };
 
 RDB_DECLARE_SERIALIZABLE(remote_replicator_client_bcard_t);
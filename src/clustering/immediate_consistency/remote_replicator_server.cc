@@ -1,6 +1,21 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "clustering/immediate_consistency/remote_replicator_server.hpp"
 
+#include "arch/timing.hpp"
+
+/* How long a synchronous write may wait for other writes to share its replication
+message with. With a delay of zero, a batch only collects the writes that the
+dispatcher hands us before the flushing coroutine gets to run. */
+const int64_t REPLICATION_BATCH_MAX_DELAY_MS = 0;
+
+/* A batch is sent right away once it has this many writes in it. */
+const size_t REPLICATION_BATCH_MAX_WRITES = 64;
+
+/* How many writes may queue up in the `primary_dispatcher_t` for a lag-tolerant
+replica before we make it catch up with a backfill instead. This is on top of the
+writes that are already in flight to it. */
+const size_t LAG_TOLERANT_REPLICA_MAX_QUEUED_WRITES = 16384;
+
 remote_replicator_server_t::remote_replicator_server_t(
         mailbox_manager_t *_mailbox_manager,
         primary_dispatcher_t *_primary) :
@@ -14,6 +29,7 @@ remote_replicator_server_t::proxy_replica_t::proxy_replica_t(
         const remote_replicator_client_bcard_t &_client_bcard,
         UNUSED signal_t *interruptor) :
     client_bcard(_client_bcard), parent(_parent), is_ready(false),
+    flush_pending(false),
     ready_mailbox(
         parent->mailbox_manager,
         std::bind(&proxy_replica_t::on_ready, this, ph::_1))
@@ -60,11 +76,45 @@ void remote_replicator_server_t::proxy_replica_t::do_write_sync(
             *response_out = response;
             got_response.pulse();
         });
-    send(parent->mailbox_manager, client_bcard.write_sync_mailbox,
-        write, timestamp, order_token, durability, response_mailbox.get_address());
+    write_batch.push_back(remote_replicator_sync_write_t {
+        write, timestamp, order_token, durability, response_mailbox.get_address() });
+    if (write_batch.size() >= REPLICATION_BATCH_MAX_WRITES) {
+        flush_write_batch(auto_drainer_t::lock_t(&flush_drainer));
+    } else if (!flush_pending) {
+        flush_pending = true;
+        auto_drainer_t::lock_t keepalive(&flush_drainer);
+        coro_t::spawn_sometime([this, keepalive]() {
+            try {
+                if (REPLICATION_BATCH_MAX_DELAY_MS > 0) {
+                    nap(REPLICATION_BATCH_MAX_DELAY_MS, keepalive.get_drain_signal());
+                }
+            } catch (const interrupted_exc_t &) {
+                /* Send the batch anyway; the writes' callers will notice that they
+                were interrupted. */
+            }
+            flush_pending = false;
+            flush_write_batch(keepalive);
+        });
+    }
     wait_interruptible(&got_response, interruptor);
 }
 
+void remote_replicator_server_t::proxy_replica_t::flush_write_batch(
+        UNUSED auto_drainer_t::lock_t keepalive) {
+    if (write_batch.empty()) {
+        return;
+    }
+    std::vector<remote_replicator_sync_write_t> batch;
+    batch.swap(write_batch);
+    if (batch.size() == 1) {
+        const remote_replicator_sync_write_t &w = batch[0];
+        send(parent->mailbox_manager, client_bcard.write_sync_mailbox,
+            w.write, w.timestamp, w.order_token, w.durability, w.ack_addr);
+    } else {
+        send(parent->mailbox_manager, client_bcard.write_sync_batch_mailbox, batch);
+    }
+}
+
 void remote_replicator_server_t::proxy_replica_t::do_dummy_write(
         signal_t *interruptor,
         write_response_t *response_out) {
@@ -95,6 +145,14 @@ void remote_replicator_server_t::proxy_replica_t::do_write_async(
     wait_interruptible(&got_ack, interruptor);
 }
 
+size_t remote_replicator_server_t::proxy_replica_t::max_queued_writes() const {
+    return client_bcard.lag_tolerant ? LAG_TOLERANT_REPLICA_MAX_QUEUED_WRITES : 0;
+}
+
+void remote_replicator_server_t::proxy_replica_t::on_lagged_too_far() {
+    send(parent->mailbox_manager, client_bcard.lagged_too_far_mailbox);
+}
+
 void remote_replicator_server_t::proxy_replica_t::on_ready(signal_t *) {
     // Can't block here, or we would need an auto drainer.
     ASSERT_FINITE_CORO_WAITING;
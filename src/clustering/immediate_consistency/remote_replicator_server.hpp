@@ -2,9 +2,12 @@
 #ifndef CLUSTERING_IMMEDIATE_CONSISTENCY_REMOTE_REPLICATOR_SERVER_HPP_
 #define CLUSTERING_IMMEDIATE_CONSISTENCY_REMOTE_REPLICATOR_SERVER_HPP_
 
+#include <vector>
+
 #include "clustering/generic/registrar.hpp"
 #include "clustering/immediate_consistency/primary_dispatcher.hpp"
 #include "clustering/immediate_consistency/remote_replicator_metadata.hpp"
+#include "concurrency/auto_drainer.hpp"
 
 /* `remote_replicator_server_t` takes reads and writes from the `primary_dispatcher_t`
 and sends them over the network to `remote_replicator_client_t`s on other machines.
@@ -63,13 +66,28 @@ private:
             signal_t *interruptor,
             write_response_t *response_out);
 
+        size_t max_queued_writes() const;
+        void on_lagged_too_far();
+
     private:
         void on_ready(signal_t *interruptor);
 
+        /* Sends everything in `write_batch` to the client in a single message. */
+        void flush_write_batch(auto_drainer_t::lock_t keepalive);
+
         remote_replicator_client_bcard_t client_bcard;
         remote_replicator_server_t *parent;
         bool is_ready;
 
+        /* `do_write_sync()` doesn't send its write right away. Instead it adds it to
+        `write_batch` and, if there isn't one pending already, spawns a coroutine that
+        calls `flush_write_batch()` after `REPLICATION_BATCH_MAX_DELAY_MS`. This way
+        writes that the `primary_dispatcher_t` sends us at nearly the same time share a
+        message. `flush_pending` is true while that coroutine is waiting. */
+        std::vector<remote_replicator_sync_write_t> write_batch;
+        bool flush_pending;
+        auto_drainer_t flush_drainer;
+
         // The destruction order matters: The `ready_mailbox` callback assumes
         // that `registration` is still valid.
         scoped_ptr_t<primary_dispatcher_t::dispatchee_registration_t> registration;
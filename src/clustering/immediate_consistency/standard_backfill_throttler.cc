@@ -1,16 +1,79 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "clustering/immediate_consistency/standard_backfill_throttler.hpp"
 
+#include <algorithm>
+
 #include "concurrency/cross_thread_signal.hpp"
 #include "concurrency/wait_any.hpp"
 
 static const size_t max_active_backfills = 8;
 
+/* How often we sample the foreground load and adjust the pace of the backfills */
+static const int64_t pace_update_interval_ms = 500;
+
+/* When we limit the backfills, we never limit them to less than this in total, so that
+they still finish eventually on a server that's always busy. */
+static const int64_t min_total_pace = MEGABYTE;
+
 standard_backfill_throttler_t::~standard_backfill_throttler_t() {
+    pace_timer.reset();
     guarantee(active.empty());
     guarantee(waiting.empty());
 }
 
+void standard_backfill_throttler_t::set_load_targets(
+        const backfill_load_targets_t &targets) {
+    assert_thread();
+    load_targets = targets;
+    total_pace = 0;
+    set_pace(0);
+    if (load_targets.any()) {
+        load_sampler.init(new foreground_load_sampler_t);
+        last_paced_bytes = get_paced_bytes();
+        last_update = get_ticks();
+        pace_timer.init(new repeating_timer_t(pace_update_interval_ms,
+            [this]() { update_pace(); }));
+    } else {
+        pace_timer.reset();
+        load_sampler.reset();
+    }
+}
+
+void standard_backfill_throttler_t::update_pace() {
+    assert_thread();
+    foreground_load_sampler_t::sample_t load = load_sampler->sample();
+    bool overloaded =
+        (load_targets.query_latency_ms > 0
+            && load.query_latency_ms > load_targets.query_latency_ms)
+        || (load_targets.disk_queue_depth > 0
+            && load.disk_queue_depth > load_targets.disk_queue_depth)
+        || (load_targets.cpu_usage > 0 && load.cpu_usage > load_targets.cpu_usage);
+
+    /* How fast the backfills actually applied items since the last update */
+    ticks_t now = get_ticks();
+    int64_t paced_bytes = get_paced_bytes();
+    double elapsed_secs = std::max<double>(now.nanos - last_update.nanos, 1) / BILLION;
+    int64_t actual_pace = static_cast<int64_t>(
+        (paced_bytes - last_paced_bytes) / elapsed_secs);
+    last_paced_bytes = paced_bytes;
+    last_update = now;
+
+    if (overloaded) {
+        /* Start from what the backfills actually did, in case they weren't using all of
+        the pace we allowed them. */
+        int64_t base = total_pace == 0 ? actual_pace : std::min(total_pace, actual_pace);
+        total_pace = std::max(min_total_pace, base / 2);
+    } else if (total_pace != 0) {
+        total_pace += total_pace / 4;
+        /* Once the backfills can't keep up with the pace anyway, lift the limit */
+        if (total_pace > 4 * actual_pace + min_total_pace) {
+            total_pace = 0;
+        }
+    }
+    set_pace(total_pace == 0 ? 0
+        : std::max<int64_t>(total_pace / std::max<size_t>(active.size(), 1), 1));
+}
+
 void standard_backfill_throttler_t::enter(lock_t *lock, signal_t *interruptor_on_lock) {
     cross_thread_signal_t interruptor_on_home(interruptor_on_lock, home_thread());
     on_thread_t thread_switcher(home_thread());
@@ -4,27 +4,67 @@
 
 #include <set>
 
+#include "arch/timing.hpp"
 #include "clustering/immediate_consistency/backfill_throttler.hpp"
 #include "concurrency/new_mutex.hpp"
+#include "perfmon/foreground_load.hpp"
+
+/* `backfill_load_targets_t` describes how much foreground load the server may be under
+before `standard_backfill_throttler_t` slows the backfills down. A value of zero disables
+the corresponding target; by default they're all disabled. */
+class backfill_load_targets_t {
+public:
+    backfill_load_targets_t() :
+        query_latency_ms(0), disk_queue_depth(0), cpu_usage(0) { }
+    bool any() const {
+        return query_latency_ms > 0 || disk_queue_depth > 0 || cpu_usage > 0;
+    }
+    /* The mean latency of queries, in milliseconds. */
+    double query_latency_ms;
+    /* The number of disk requests that are queued or running. */
+    int64_t disk_queue_depth;
+    /* The CPU usage of the process, as a fraction of all of its threads. */
+    double cpu_usage;
+};
 
 /* `standard_backfill_throttler_t` is the `backfill_throttler_t` that is used in
 production. It allows a fixed number of backfills total (currently 8); if there are more
 than 8 backfills trying to run, it will always allow the highest-priority backfills to go
-first, preempting the lower-priority backfills if necessary. */
+first, preempting the lower-priority backfills if necessary.
+
+If any load targets are set, it also samples the foreground load a few times a second.
+While the load is above a target it halves the total rate at which backfills may apply
+items, and while it's below all of them it raises the rate again, until the limit is
+lifted. The rate is shared evenly between the running backfills. */
 
 class standard_backfill_throttler_t : public backfill_throttler_t {
 public:
-    standard_backfill_throttler_t() { }
+    standard_backfill_throttler_t() :
+        total_pace(0), last_paced_bytes(0), last_update(get_ticks()) { }
     ~standard_backfill_throttler_t();
 
+    void set_load_targets(const backfill_load_targets_t &targets);
+
 private:
     void enter(lock_t *lock, signal_t *interruptor);
     void exit(lock_t *lock);
 
+    void update_pace();
+
     std::multimap<priority_t, std::pair<lock_t *, cond_t *> > waiting;
     std::set<std::pair<priority_t, lock_t *> > active;
 
     new_mutex_t mutex;
+
+    /* These are only used if `load_targets.any()`. `total_pace` is the rate in bytes
+    per second that all the backfills together may apply items, or zero if there's no
+    limit. */
+    backfill_load_targets_t load_targets;
+    scoped_ptr_t<foreground_load_sampler_t> load_sampler;
+    int64_t total_pace;
+    int64_t last_paced_bytes;
+    ticks_t last_update;
+    scoped_ptr_t<repeating_timer_t> pace_timer;
 };
 
 #endif /* CLUSTERING_IMMEDIATE_CONSISTENCY_STANDARD_BACKFILL_THROTTLER_HPP_ */
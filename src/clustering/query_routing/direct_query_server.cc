@@ -10,45 +10,82 @@ direct_query_server_t::direct_query_server_t(
     mailbox_manager(mm),
     svs(svs_),
     read_mailbox(mm, std::bind(&direct_query_server_t::on_read, this,
-                               ph::_1, ph::_2, ph::_3))
+                               ph::_1, ph::_2, ph::_3)),
+    bounded_read_mailbox(mm, std::bind(&direct_query_server_t::on_bounded_read, this,
+                                       ph::_1, ph::_2, ph::_3))
     { }
 
 direct_query_bcard_t direct_query_server_t::get_bcard() {
-    return direct_query_bcard_t(read_mailbox.get_address());
+    return direct_query_bcard_t(
+        read_mailbox.get_address(), bounded_read_mailbox.get_address());
+}
+
+direct_query_server_t::lag_source_t::lag_source_t(
+        direct_query_server_t *_parent,
+        const std::function<int64_t()> &_get_lag_ms) :
+        parent(_parent) {
+    guarantee(!parent->get_lag_ms);
+    parent->get_lag_ms = _get_lag_ms;
+}
+
+direct_query_server_t::lag_source_t::~lag_source_t() {
+    parent->get_lag_ms = nullptr;
 }
 
 void direct_query_server_t::on_read(
         signal_t *interruptor,
         const read_t &read,
         const mailbox_addr_t<read_response_t> &cont) {
+    try {
+        read_response_t response;
+        do_read(read, &response, interruptor);
+        send(mailbox_manager, cont, response);
+    } catch (const interrupted_exc_t &) {
+        /* ignore */
+    }
+}
 
+void direct_query_server_t::on_bounded_read(
+        signal_t *interruptor,
+        const read_t &read,
+        const mailbox_addr_t<optional<read_response_t> > &cont) {
+    if (!get_lag_ms || get_lag_ms() > read.max_staleness_ms) {
+        send(mailbox_manager, cont, optional<read_response_t>());
+        return;
+    }
+    try {
+        read_response_t response;
+        do_read(read, &response, interruptor);
+        send(mailbox_manager, cont, make_optional(std::move(response)));
+    } catch (const interrupted_exc_t &) {
+        /* ignore */
+    }
+}
+
+void direct_query_server_t::do_read(
+        const read_t &read,
+        read_response_t *response,
+        signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t) {
     // Shortcut: Dummy reads for checking table status are fulfilled
     // without hitting the store.
     if (boost::get<dummy_read_t>(&read.read) != nullptr) {
-        read_response_t response;
-        response.response = dummy_read_response_t();
-        response.n_shards = 1;
-        send(mailbox_manager, cont, response);
+        response->response = dummy_read_response_t();
+        response->n_shards = 1;
         return;
     }
 
-    try {
-        /* Leave the token empty. We're not actually interested in ordering here. */
-        read_token_t token;
+    /* Leave the token empty. We're not actually interested in ordering here. */
+    read_token_t token;
 
 #ifndef NDEBUG
-        metainfo_checker_t metainfo_checker(svs->get_region(),
-            [](const region_t &, const binary_blob_t &) { });
+    metainfo_checker_t metainfo_checker(svs->get_region(),
+        [](const region_t &, const binary_blob_t &) { });
 #endif
 
-        read_response_t response;
-        svs->read(DEBUG_ONLY(metainfo_checker, )
-                  read,
-                  &response,
-                  &token,
-                  interruptor);
-        send(mailbox_manager, cont, response);
-    } catch (const interrupted_exc_t &) {
-        /* ignore */
-    }
+    svs->read(DEBUG_ONLY(metainfo_checker, )
+              read,
+              response,
+              &token,
+              interruptor);
 }
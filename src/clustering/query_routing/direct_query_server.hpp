@@ -2,6 +2,8 @@
 #ifndef CLUSTERING_QUERY_ROUTING_DIRECT_QUERY_SERVER_HPP_
 #define CLUSTERING_QUERY_ROUTING_DIRECT_QUERY_SERVER_HPP_
 
+#include <functional>
+
 #include "clustering/query_routing/metadata.hpp"
 #include "concurrency/fifo_checker.hpp"
 
@@ -21,18 +23,47 @@ public:
 
     direct_query_bcard_t get_bcard();
 
+    /* While a `lag_source_t` exists, the `direct_query_server_t` calls `get_lag_ms` to
+    find out how many milliseconds the store is behind the primary replica, and serves
+    bounded-staleness reads whose bound that is within. Without one it refuses them,
+    since it can't tell how stale its data is. Must be constructed and destroyed on
+    the `direct_query_server_t`'s thread. */
+    class lag_source_t {
+    public:
+        lag_source_t(direct_query_server_t *parent,
+                     const std::function<int64_t()> &_get_lag_ms);
+        ~lag_source_t();
+    private:
+        direct_query_server_t *parent;
+        DISABLE_COPYING(lag_source_t);
+    };
+
 private:
     void on_read(
             signal_t *interruptor,
             const read_t &,
             const mailbox_addr_t<read_response_t> &);
 
+    void on_bounded_read(
+            signal_t *interruptor,
+            const read_t &,
+            const mailbox_addr_t<optional<read_response_t> > &);
+
+    void do_read(
+            const read_t &read,
+            read_response_t *response,
+            signal_t *interruptor)
+            THROWS_ONLY(interrupted_exc_t);
+
     mailbox_manager_t *mailbox_manager;
     store_view_t *svs;
 
     order_source_t order_source;  // TODO: order_token_t::ignore
 
+    std::function<int64_t()> get_lag_ms;
+
     direct_query_bcard_t::read_mailbox_t read_mailbox;
+    direct_query_bcard_t::bounded_read_mailbox_t bounded_read_mailbox;
 };
 
 #endif /* CLUSTERING_QUERY_ROUTING_DIRECT_QUERY_SERVER_HPP_ */
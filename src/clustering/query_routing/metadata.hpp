@@ -11,6 +11,7 @@
 #include "clustering/generic/registration_metadata.hpp"
 #include "concurrency/fifo_checker.hpp"
 #include "concurrency/fifo_enforcer.hpp"
+#include "containers/archive/optional.hpp"
 #include "rdb_protocol/protocol.hpp"
 #include "rpc/mailbox/typed.hpp"
 
@@ -77,11 +78,18 @@ secondary replica for. */
 class direct_query_bcard_t {
 public:
     typedef mailbox_t<read_t, mailbox_addr_t<read_response_t>> read_mailbox_t;
+    /* Reads sent to `bounded_read_mailbox` get an empty response if the replica is
+    further behind the primary than `read_t::max_staleness_ms`. */
+    typedef mailbox_t<read_t, mailbox_addr_t<optional<read_response_t>>>
+        bounded_read_mailbox_t;
 
     direct_query_bcard_t() { }
-    explicit direct_query_bcard_t(const read_mailbox_t::address_t &rm) : read_mailbox(rm) { }
+    direct_query_bcard_t(const read_mailbox_t::address_t &rm,
+                         const bounded_read_mailbox_t::address_t &brm)
+        : read_mailbox(rm), bounded_read_mailbox(brm) { }
 
     read_mailbox_t::address_t read_mailbox;
+    bounded_read_mailbox_t::address_t bounded_read_mailbox;
 };
 
 RDB_DECLARE_SERIALIZABLE(direct_query_bcard_t);
@@ -1,15 +1,38 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "clustering/query_routing/table_query_client.hpp"
 
+#include <algorithm>
 #include <functional>
 
+#include "arch/timing.hpp"
 #include "clustering/query_routing/primary_query_client.hpp"
 #include "clustering/table_contract/cpu_sharding.hpp"
 #include "clustering/table_manager/multi_table_manager.hpp"
 #include "concurrency/cross_thread_signal.hpp"
 #include "concurrency/fifo_enforcer.hpp"
+#include "concurrency/scatter_gather.hpp"
+#include "concurrency/wait_any.hpp"
 #include "concurrency/watchable.hpp"
 #include "rdb_protocol/env.hpp"
+#include "time.hpp"
+
+/* How long `write()` keeps retrying a write that failed because the table's primary
+replicas are changing. A hand-over normally takes well under this. */
+static const int64_t PRIMARY_CHANGE_WRITE_RETRY_MS = 10000;
+
+/* How recently a primary must have appeared or disappeared for a failed write to be
+retried at all. */
+static const int64_t PRIMARY_CHANGE_WINDOW_MS = 10000;
+
+/* While the primaries are changing, we retry at least this often even if we don't see
+another change, because the new primary may reject writes for a moment while it
+connects to its secondaries. */
+static const int64_t PRIMARY_CHANGE_RETRY_INTERVAL_MS = 100;
+
+/* The old primary fails its held writes at the moment it steps down, which can be
+slightly before we see it disappear from the directory. So even if the primaries
+haven't changed recently, we wait this long for a change before giving up. */
+static const int64_t PRIMARY_CHANGE_SETTLE_MS = 200;
 
 table_query_client_t::table_query_client_t(
         const namespace_id_t &_table_id,
@@ -26,6 +49,8 @@ table_query_client_t::table_query_client_t(
       m_table_meta_client(table_meta_client),
       start_count(0),
       starting_up(true),
+      primary_changes(0),
+      last_primary_change(0),
       subs(directory,
         std::bind(&table_query_client_t::update_registrant,
             this, ph::_1, ph::_2),
@@ -120,6 +145,19 @@ void table_query_client_t::read(
            `dispatch_outdated_read` needs to be able to see `outdated_read_info_t`,
            which is defined in the `private` section. */
         dispatch_outdated_read(r, response, interruptor);
+    } else if (r.read_mode == read_mode_t::BOUNDED_STALENESS) {
+        guarantee(!r.route_to_primary());
+        if (!dispatch_outdated_read(r, response, interruptor)) {
+            /* Some replica we picked was too far behind, so read from the primaries
+            instead. */
+            read_t up_to_date_read = r;
+            up_to_date_read.read_mode = read_mode_t::SINGLE;
+            dispatch_immediate_op<
+                    read_t, fifo_enforcer_sink_t::exit_read_t, read_response_t>(
+                &primary_query_client_t::new_read_token,
+                &primary_query_client_t::read,
+                up_to_date_read, response, order_token, interruptor);
+        }
     } else if (r.read_mode == read_mode_t::DEBUG_DIRECT) {
         guarantee(!r.route_to_primary());
         dispatch_debug_direct_read(r, response, interruptor);
@@ -150,10 +188,66 @@ void table_query_client_t::write(
     user_context.require_write_permission(ctx, table_basic_config.database, table_id);
 
     order_token.assert_write_mode();
-    dispatch_immediate_op<write_t, fifo_enforcer_sink_t::exit_write_t, write_response_t>(
-        &primary_query_client_t::new_write_token,
-        &primary_query_client_t::write,
-        w, response, order_token, interruptor);
+    /* A write that fails with `query_state_t::FAILED` wasn't performed on any shard, so
+    it's safe to try it again. We do that when the failure was most likely caused by a
+    primary replica changing, so that reconfiguring a table or restarting one server at
+    a time doesn't surface errors to the user. */
+    int64_t deadline = get_ticks().nanos + PRIMARY_CHANGE_WRITE_RETRY_MS * MILLION;
+    for (;;) {
+        uint64_t changes_seen = primary_changes.get_watchable()->get();
+        optional<cannot_perform_query_exc_t> failure;
+        try {
+            dispatch_immediate_op<
+                    write_t, fifo_enforcer_sink_t::exit_write_t, write_response_t>(
+                &primary_query_client_t::new_write_token,
+                &primary_query_client_t::write,
+                w, response, order_token, interruptor);
+            return;
+        } catch (const cannot_perform_query_exc_t &e) {
+            if (e.get_query_state() != query_state_t::FAILED) {
+                throw;
+            }
+            /* We can't block inside of a `catch` block */
+            failure.set(e);
+        }
+        if (!wait_to_retry_write(changes_seen, deadline, interruptor)) {
+            throw *failure;
+        }
+    }
+}
+
+bool table_query_client_t::wait_to_retry_write(
+        uint64_t changes_seen,
+        int64_t deadline,
+        signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t) {
+    int64_t now = get_ticks().nanos;
+    if (now >= deadline) {
+        return false;
+    }
+    bool changing = last_primary_change != 0 &&
+        now - last_primary_change < PRIMARY_CHANGE_WINDOW_MS * MILLION;
+    int64_t wait_ms = std::min<int64_t>(
+        (deadline - now) / MILLION,
+        changing ? PRIMARY_CHANGE_RETRY_INTERVAL_MS : PRIMARY_CHANGE_SETTLE_MS);
+
+    signal_timer_t timer;
+    timer.start(wait_ms);
+    wait_any_t waiter(&timer, interruptor);
+    try {
+        primary_changes.get_watchable()->run_until_satisfied(
+            [&](uint64_t changes) { return changes != changes_seen; },
+            &waiter);
+    } catch (const interrupted_exc_t &) {
+        if (interruptor->is_pulsed()) {
+            throw;
+        }
+        /* The timer went off without the primaries changing. That's expected while a
+        new primary is starting up, but otherwise the error is probably not going to
+        go away. */
+        return changing;
+    }
+    return true;
 }
 
 std::set<region_t> table_query_client_t::get_sharding_scheme()
@@ -331,7 +425,7 @@ void table_query_client_t::perform_immediate_op(
     }
 }
 
-void table_query_client_t::dispatch_outdated_read(
+bool table_query_client_t::dispatch_outdated_read(
     const read_t &op,
     read_response_t *response,
     signal_t *interruptor)
@@ -361,7 +455,7 @@ void table_query_client_t::dispatch_outdated_read(
             }
             if (!chosen_relationship && !potential_relationships.empty()) {
                 chosen_relationship
-                    = potential_relationships[randint(potential_relationships.size())];
+                    = choose_outdated_read_replica(potential_relationships);
             }
             if (!chosen_relationship) {
                 /* Don't bother looking for masters; if there are no direct
@@ -370,7 +464,7 @@ void table_query_client_t::dispatch_outdated_read(
                     "no replica is available",
                     query_state_t::FAILED);
             }
-            new_op_info->direct_bcard = chosen_relationship->direct_bcard;
+            new_op_info->relationship = chosen_relationship;
             new_op_info->keepalive = auto_drainer_t::lock_t(
                 &chosen_relationship->drainer);
             replicas_to_contact.push_back(std::move(new_op_info));
@@ -391,9 +485,44 @@ void table_query_client_t::dispatch_outdated_read(
             // Reads are never indeterminate.
             throw cannot_perform_query_exc_t(failures[i], query_state_t::FAILED);
         }
+        if (replicas_to_contact[i]->too_stale) {
+            return false;
+        }
     }
 
     op.unshard(results.data(), results.size(), response, ctx, interruptor);
+    return true;
+}
+
+/* We'd like outdated reads to spread over the replicas in proportion to how fast
+they can answer them. Sampling two replicas at random and taking the less loaded
+one ("power of two choices") gets most of the benefit of always taking the least
+loaded one, without making every server that routes reads herd onto the same
+replica whenever its statistics look good. */
+table_query_client_t::relationship_t *
+table_query_client_t::choose_outdated_read_replica(
+        const std::vector<relationship_t *> &candidates) {
+    guarantee(!candidates.empty());
+    relationship_t *first = candidates[randint(candidates.size())];
+    if (candidates.size() == 1) {
+        return first;
+    }
+    relationship_t *second = candidates[randint(candidates.size() - 1)];
+    if (second == first) {
+        second = candidates.back();
+    }
+    /* The expected time until a new read completes is roughly the replica's
+    latency times the number of reads that are ahead of it. */
+    auto expected_cost = [](const relationship_t *rel) {
+        return rel->outdated_read_latency * (rel->outdated_reads_in_flight + 1);
+    };
+    double first_cost = expected_cost(first);
+    double second_cost = expected_cost(second);
+    if (first_cost != second_cost) {
+        return first_cost < second_cost ? first : second;
+    }
+    return first->outdated_reads_in_flight <= second->outdated_reads_in_flight
+        ? first : second;
 }
 
 void table_query_client_t::perform_outdated_read(
@@ -403,7 +532,10 @@ void table_query_client_t::perform_outdated_read(
         size_t i,
         signal_t *interruptor) THROWS_NOTHING {
     outdated_read_info_t *replica_to_contact = (*replicas_to_contact)[i].get();
+    /* `keepalive` keeps the relationship alive until we return */
+    relationship_t *relationship = replica_to_contact->relationship;
 
+    ++relationship->outdated_reads_in_flight;
     try {
         cond_t done;
         mailbox_t<read_response_t> cont(mailbox_manager,
@@ -411,14 +543,41 @@ void table_query_client_t::perform_outdated_read(
                 results->at(i) = res;
                 done.pulse();
             });
+        mailbox_t<optional<read_response_t> > bounded_cont(mailbox_manager,
+            [&](signal_t *, const optional<read_response_t> &res) {
+                if (res.has_value()) {
+                    results->at(i) = *res;
+                } else {
+                    replica_to_contact->too_stale = true;
+                }
+                done.pulse();
+            });
 
-        send(mailbox_manager,
-            replica_to_contact->direct_bcard->read_mailbox,
-            replica_to_contact->sharded_op,
-            cont.get_address());
+        ticks_t start_time = get_ticks();
+        if (replica_to_contact->sharded_op.read_mode
+                == read_mode_t::BOUNDED_STALENESS) {
+            send(mailbox_manager,
+                relationship->direct_bcard->bounded_read_mailbox,
+                replica_to_contact->sharded_op,
+                bounded_cont.get_address());
+        } else {
+            send(mailbox_manager,
+                relationship->direct_bcard->read_mailbox,
+                replica_to_contact->sharded_op,
+                cont.get_address());
+        }
         wait_any_t waiter(replica_to_contact->keepalive.get_drain_signal(), &done);
         wait_interruptible(&waiter, interruptor);
-        if (!done.is_pulsed()) {
+        if (done.is_pulsed()) {
+            static const double latency_weight = 0.2;
+            double latency = (get_ticks().nanos - start_time.nanos) / 1000.0;
+            if (relationship->outdated_read_latency == 0) {
+                relationship->outdated_read_latency = latency;
+            } else {
+                relationship->outdated_read_latency +=
+                    latency_weight * (latency - relationship->outdated_read_latency);
+            }
+        } else {
             /* `wait_interruptible()` returned because
             `replica_to_contact->keepalive.get_drain_signal()` was pulsed */
             failures->at(i).assign("lost contact with replica");
@@ -427,6 +586,7 @@ void table_query_client_t::perform_outdated_read(
         /* Return immediately. `dispatch_immediate_op()` will notice that the
         interruptor has been pulsed. */
     }
+    --relationship->outdated_reads_in_flight;
 }
 
 void table_query_client_t::dispatch_debug_direct_read(
@@ -444,35 +604,44 @@ void table_query_client_t::dispatch_debug_direct_read(
                 "This server does not have any data available for the given table.",
                 query_state_t::FAILED);
         }
-        std::vector<read_response_t> responses;
-        pmap(CPU_SHARDING_FACTOR, [&](size_t shard_number) {
+        /* Shard the read and set up the interruptors here, so that only the reads
+        themselves run on the stores' threads. */
+        const int cpu_sharding_factor = multistore->get_cpu_sharding_factor();
+        std::vector<int> shard_numbers;
+        std::vector<read_t> subreads;
+        std::vector<threadnum_t> store_threads;
+        std::vector<scoped_ptr_t<cross_thread_signal_t> > interruptors_on_store;
+        for (int shard_number = 0; shard_number < cpu_sharding_factor; ++shard_number) {
+            read_t subread;
+            if (!op.shard(cpu_sharding_subspace(shard_number, cpu_sharding_factor),
+                          &subread)) {
+                continue;
+            }
+            threadnum_t thread =
+                multistore->get_cpu_sharded_store(shard_number)->home_thread();
+            shard_numbers.push_back(shard_number);
+            subreads.push_back(std::move(subread));
+            store_threads.push_back(thread);
+            interruptors_on_store.push_back(make_scoped<cross_thread_signal_t>(
+                &interruptor_on_mtm, thread));
+        }
+        std::vector<read_response_t> responses(subreads.size());
+        scatter_gather(store_threads, [&](int64_t i) {
             try {
-                region_t region = cpu_sharding_subspace(shard_number);
-                read_t subread;
-                if (!op.shard(region, &subread)) {
-                    return;
-                }
-                read_response_t subresponse;
-                {
-                    store_view_t *store =
-                        multistore->get_cpu_sharded_store(shard_number);
-                    cross_thread_signal_t interruptor_on_store(
-                        &interruptor_on_mtm, store->home_thread());
-                    on_thread_t thread_switcher_2(store->home_thread());
+                store_view_t *store = multistore->get_cpu_sharded_store(shard_numbers[i]);
 #ifndef NDEBUG
-                    metainfo_checker_t checker(
-                        region, [](const region_t &, const binary_blob_t &) {});
+                metainfo_checker_t checker(
+                    cpu_sharding_subspace(shard_numbers[i], cpu_sharding_factor),
+                    [](const region_t &, const binary_blob_t &) {});
 #endif /* NDEBUG */
-                    read_token_t token;
-                    store->new_read_token(&token);
-                    store->read(
-                        DEBUG_ONLY(checker, )
-                        subread, &subresponse, &token,
-                        &interruptor_on_store);
-                }
-                responses.push_back(subresponse);
+                read_token_t token;
+                store->new_read_token(&token);
+                store->read(
+                    DEBUG_ONLY(checker, )
+                    subreads[i], &responses[i], &token,
+                    interruptors_on_store[i].get());
             } catch (const interrupted_exc_t &) {
-                /* ignore; we'll catch it outside the pmap */
+                /* ignore; we'll catch it outside the `scatter_gather()` */
             }
         });
         if (interruptor_on_mtm.is_pulsed()) {
@@ -526,6 +695,11 @@ private:
     value_t value;
 };
 
+void table_query_client_t::note_primary_change() {
+    last_primary_change = get_ticks().nanos;
+    primary_changes.set_value(primary_changes.get_watchable()->get() + 1);
+}
+
 void table_query_client_t::relationship_coroutine(
         const std::pair<peer_id_t, uuid_u> &key,
         const table_query_bcard_t &bcard,
@@ -553,9 +727,14 @@ void table_query_client_t::relationship_coroutine(
         } else {
             relationship_record.direct_bcard = nullptr;
         }
+        relationship_record.outdated_read_latency = 0;
+        relationship_record.outdated_reads_in_flight = 0;
 
         region_map_set_membership_t<relationship_t *> relationship_map_insertion(
             &relationships, bcard.region, &relationship_record);
+        if (static_cast<bool>(bcard.primary)) {
+            note_primary_change();
+        }
 
         if (is_start) {
             guarantee(start_count > 0);
@@ -571,6 +750,10 @@ void table_query_client_t::relationship_coroutine(
         /* do nothing */
     }
 
+    if (static_cast<bool>(bcard.primary)) {
+        note_primary_change();
+    }
+
     if (is_start) {
         guarantee(start_count > 0);
         start_count--;
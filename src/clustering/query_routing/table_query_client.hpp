@@ -13,6 +13,7 @@
 #include "clustering/query_routing/metadata.hpp"
 #include "containers/clone_ptr.hpp"
 #include "concurrency/fifo_enforcer.hpp"
+#include "concurrency/watchable.hpp"
 #include "concurrency/watchable_map.hpp"
 #include "protocol_api.hpp"
 #include "rdb_protocol/protocol.hpp"
@@ -74,6 +75,16 @@ private:
         region_t region;
         primary_query_client_t *primary_client;
         const direct_query_bcard_t *direct_bcard;
+
+        /* Load statistics for outdated reads sent through `direct_bcard`, used by
+        `dispatch_outdated_read()` to pick between replicas. `outdated_read_latency`
+        is an exponentially weighted moving average of the response times in
+        microseconds; it stays zero until the first read completes, so that new
+        replicas get tried. `outdated_reads_in_flight` is the number of reads that
+        were sent but haven't returned yet. */
+        double outdated_read_latency;
+        int outdated_reads_in_flight;
+
         auto_drainer_t drainer;
     };
 
@@ -93,8 +104,11 @@ private:
     class outdated_read_info_t {
     public:
         read_t sharded_op;
-        const direct_query_bcard_t *direct_bcard;
+        relationship_t *relationship;
         auto_drainer_t::lock_t keepalive;
+        /* Set if `sharded_op` is a bounded-staleness read and the replica was too far
+        behind the primary to serve it. */
+        bool too_stale;
     };
 
     template <class op_type, class fifo_enforcer_token_type, class op_response_type>
@@ -123,12 +137,17 @@ private:
             signal_t *interruptor)
         THROWS_NOTHING;
 
-    void dispatch_outdated_read(
+    /* Also handles bounded-staleness reads. Returns `false` without filling in
+    `response` if one of the replicas was too stale for a bounded-staleness read. */
+    bool dispatch_outdated_read(
             const read_t &op,
             read_response_t *response,
             signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t, cannot_perform_query_exc_t);
 
+    static relationship_t *choose_outdated_read_replica(
+            const std::vector<relationship_t *> &candidates);
+
     void perform_outdated_read(
             std::vector<scoped_ptr_t<outdated_read_info_t> > *direct_readers_to_contact,
             std::vector<read_response_t> *results,
@@ -143,9 +162,21 @@ private:
             signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t, cannot_perform_query_exc_t);
 
+    /* Called by `write()` after a write failed without being performed. Waits until
+    it makes sense to try the write again and returns `true`, or returns `false` if the
+    error should go to the user. `changes_seen` is the value of `primary_changes` from
+    before the failed attempt; `deadline` is in the nanoseconds of `get_ticks()`. */
+    bool wait_to_retry_write(
+            uint64_t changes_seen,
+            int64_t deadline,
+            signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t);
+
     void update_registrant(const std::pair<peer_id_t, uuid_u> &key,
                            const table_query_bcard_t *bcard);
 
+    void note_primary_change();
+
     void relationship_coroutine(
         const std::pair<peer_id_t, uuid_u> &key,
         const table_query_bcard_t &bcard,
@@ -172,6 +203,15 @@ private:
     int start_count;
     bool starting_up;
 
+    /* `primary_changes` is incremented every time a primary replica appears or
+    disappears, and `last_primary_change` is when that last happened, in the
+    nanoseconds of `get_ticks()`. While the primary
+    of a shard is being handed over to another server, writes to it fail without being
+    performed; `write()` uses these to tell that situation apart from a table that is
+    simply unavailable, and to retry the write as soon as the new primary shows up. */
+    watchable_variable_t<uint64_t> primary_changes;
+    int64_t last_primary_change;
+
     auto_drainer_t relationship_coroutine_auto_drainer;
 
     watchable_map_t<std::pair<peer_id_t, uuid_u>, table_query_bcard_t>::all_subs_t subs;
@@ -45,6 +45,13 @@ optional<raft_log_index_t> contract_coordinator_t::change_config(
         [&](const raft_member_t<table_raft_state_t>::state_and_config_t *state) {
             change.new_config = state->state.config;
             changer(&change.new_config);
+            /* The number of CPU shards and the block size are fixed when the table is
+            created, because each CPU shard has its own store on disk, and the block
+            size is recorded in the table's data file. */
+            change.new_config.config.cpu_sharding_factor =
+                state->state.config.config.cpu_sharding_factor;
+            change.new_config.config.block_size =
+                state->state.config.config.block_size;
             log_index = state->log_index;
             is_noop = (change.new_config == state->state.config);
         });
@@ -1,34 +1,45 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "clustering/table_contract/cpu_sharding.hpp"
 
-static const uint64_t CPU_SHARD_WIDTH = HASH_REGION_HASH_SIZE / CPU_SHARDING_FACTOR;
+#include <algorithm>
 
-region_t cpu_sharding_subspace(int subregion_number) {
+static uint64_t cpu_shard_width(int cpu_sharding_factor) {
+    guarantee(cpu_sharding_factor >= 1);
+    guarantee(cpu_sharding_factor <= MAX_CPU_SHARDING_FACTOR);
+    return HASH_REGION_HASH_SIZE / cpu_sharding_factor;
+}
+
+region_t cpu_sharding_subspace(int subregion_number, int cpu_sharding_factor) {
+    const uint64_t width = cpu_shard_width(cpu_sharding_factor);
     guarantee(subregion_number >= 0);
-    guarantee(subregion_number < CPU_SHARDING_FACTOR);
+    guarantee(subregion_number < cpu_sharding_factor);
 
     /* Changing this implementation would break backwards compatibility in the disk
     format. */
 
     // We have to be careful with the math here, to avoid overflow.
-    uint64_t beg = CPU_SHARD_WIDTH * subregion_number;
-    uint64_t end = subregion_number + 1 == CPU_SHARDING_FACTOR
-        ? HASH_REGION_HASH_SIZE : beg + CPU_SHARD_WIDTH;
+    uint64_t beg = width * subregion_number;
+    uint64_t end = subregion_number + 1 == cpu_sharding_factor
+        ? HASH_REGION_HASH_SIZE : beg + width;
 
     return region_t(beg, end, key_range_t::universe());
 }
 
-int get_cpu_shard_number(const region_t &region) {
-    int subregion_number = region.beg / CPU_SHARD_WIDTH;
-    guarantee(region.beg == subregion_number * CPU_SHARD_WIDTH);
+int get_cpu_shard_number(const region_t &region, int cpu_sharding_factor) {
+    const uint64_t width = cpu_shard_width(cpu_sharding_factor);
+    int subregion_number = region.beg / width;
+    guarantee(subregion_number < cpu_sharding_factor);
+    guarantee(region.beg == subregion_number * width);
     guarantee(region.end == (
-        subregion_number + 1 == CPU_SHARDING_FACTOR
+        subregion_number + 1 == cpu_sharding_factor
             ? HASH_REGION_HASH_SIZE
-            : region.beg + CPU_SHARD_WIDTH));
+            : region.beg + width));
     return subregion_number;
 }
 
-int get_cpu_shard_approx_number(const region_t &region) {
-    return region.beg / CPU_SHARD_WIDTH;
+int get_cpu_shard_approx_number(const region_t &region, int cpu_sharding_factor) {
+    // The last CPU shard also covers the rounding remainder at the end of the hash
+    // space.
+    return std::min<uint64_t>(
+        region.beg / cpu_shard_width(cpu_sharding_factor), cpu_sharding_factor - 1);
 }
-
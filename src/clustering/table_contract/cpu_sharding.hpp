@@ -8,33 +8,44 @@
 
 class store_t;
 
-/* Changing this number would break backwards compatibility in the disk format. */
+/* The number of CPU shards of a table is chosen when the table is created and stored in
+its `table_config_t`; it can't be changed afterwards, since every CPU shard is a separate
+B-tree on disk. `CPU_SHARDING_FACTOR` is the default for new tables, and the number of
+CPU shards of every table created before the number became configurable. Changing it
+would break backwards compatibility in the disk format. */
 #define CPU_SHARDING_FACTOR 8
+#define MAX_CPU_SHARDING_FACTOR 64
 
 /* `cpu_sharding_subspace()` returns a `region_t` that contains the full key-range space
-but only 1/CPU_SHARDING_FACTOR of the shard space. */
-region_t cpu_sharding_subspace(int subregion_number);
+but only 1/`cpu_sharding_factor` of the shard space. */
+region_t cpu_sharding_subspace(
+    int subregion_number, int cpu_sharding_factor = CPU_SHARDING_FACTOR);
 
 /* `get_cpu_shard_number()` is the reverse of `cpu_sharding_subspace()`; it returns the
 subregion number for `region`'s hash subspace. It ignores `region`'s key boundaries. If
 `region`'s hash subspace doesn't exactly correspond to a specific CPU sharding region, it
 crashes. */
-int get_cpu_shard_number(const region_t &region);
+int get_cpu_shard_number(
+    const region_t &region, int cpu_sharding_factor = CPU_SHARDING_FACTOR);
 
 /* `get_cpu_shard_approx_number()` is like `get_cpu_shard_number()`, except that if the
 input doesn't correspond exactly to a CPU shard, it returns an estimate. */
-int get_cpu_shard_approx_number(const region_t &region);
+int get_cpu_shard_approx_number(
+    const region_t &region, int cpu_sharding_factor = CPU_SHARDING_FACTOR);
 
 /* `multistore_ptr_t` is a bundle of `store_view_t`s, one for each CPU shard. The rule
-is that `get_cpu_sharded_store(i)->get_region() == cpu_sharding_subspace(i)`. The
-individual stores' home threads may be different from the `multistore_ptr_t`'s home
-thread. */
+is that `get_cpu_sharded_store(i)->get_region() ==
+cpu_sharding_subspace(i, get_cpu_sharding_factor())`. The individual stores' home
+threads may be different from the `multistore_ptr_t`'s home thread. */
 class multistore_ptr_t : public home_thread_mixin_t {
 public:
     virtual ~multistore_ptr_t() { }
 
     virtual branch_history_manager_t *get_branch_history_manager() = 0;
 
+    /* The number of CPU shards, and thus the number of stores. */
+    virtual int get_cpu_sharding_factor() = 0;
+
     virtual store_view_t *get_cpu_sharded_store(size_t i) = 0;
 
     /* The `sindex_manager_t` uses this interface to get at the underlying `store_t`s so
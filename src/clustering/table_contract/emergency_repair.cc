@@ -124,6 +124,12 @@ void calculate_emergency_repair(
             old_state.config.config.write_ack_config;
         new_state_out->config.config.durability = old_state.config.config.durability;
         new_state_out->config.config.user_data = old_state.config.config.user_data;
+        new_state_out->config.config.cpu_sharding_factor =
+            old_state.config.config.cpu_sharding_factor;
+        new_state_out->config.config.block_size = old_state.config.config.block_size;
+        new_state_out->config.config.expiry_field =
+            old_state.config.config.expiry_field;
+        new_state_out->config.config.read_cache = old_state.config.config.read_cache;
 
         /* We first calculate all the voting and nonvoting replicas for each range in a
         `range_map_t`. */
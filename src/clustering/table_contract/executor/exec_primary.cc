@@ -1,6 +1,7 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "clustering/table_contract/executor/exec_primary.hpp"
 
+#include "arch/timing.hpp"
 #include "clustering/administration/admin_op_exc.hpp"
 #include "clustering/immediate_consistency/local_replicator.hpp"
 #include "clustering/immediate_consistency/primary_dispatcher.hpp"
@@ -8,14 +9,28 @@
 #include "clustering/query_routing/direct_query_server.hpp"
 #include "concurrency/cross_thread_signal.hpp"
 #include "concurrency/promise.hpp"
+#include "rdb_protocol/pseudo_time.hpp"
+#include "rdb_protocol/table_expiry.hpp"
 #include "store_view.hpp"
 
+/* How long `hold_write_during_hand_over()` holds a write at most, and how often it
+checks whether the hand-over is over. */
+static const int64_t HAND_OVER_MAX_WRITE_HOLD_MS = 5000;
+static const int64_t HAND_OVER_POLL_INTERVAL_MS = 20;
+
+/* How long `expire_rows()` waits after a batch of expired rows, and how long it waits
+before looking again when it didn't find any. */
+static const int64_t EXPIRY_BATCH_INTERVAL_MS = 10;
+static const int64_t EXPIRY_POLL_INTERVAL_MS = 1000;
+
 primary_execution_t::primary_execution_t(
         const execution_t::context_t *_context,
         execution_t::params_t *_params,
         const contract_id_t &contract_id,
         const table_raft_state_t &raft_state) :
-    execution_t(_context, _params), our_dispatcher(nullptr)
+    execution_t(_context, _params),
+    primary_key(raft_state.config.config.basic.primary_key),
+    our_dispatcher(nullptr)
 {
     const contract_t &contract = raft_state.contracts.at(contract_id).second;
     guarantee(static_cast<bool>(contract.primary));
@@ -23,7 +38,8 @@ primary_execution_t::primary_execution_t(
     guarantee(raft_state.contracts.at(contract_id).first == region);
     latest_contract_home_thread = make_counted<contract_info_t>(
         contract_id, contract, raft_state.config.config.durability,
-        raft_state.config.config.write_ack_config);
+        raft_state.config.config.write_ack_config,
+        raft_state.config.config.expiry_field);
     latest_contract_store_thread = latest_contract_home_thread;
     begin_write_mutex_assertion.rethread(store->home_thread());
     coro_t::spawn_sometime(std::bind(&primary_execution_t::run, this, drainer.lock()));
@@ -70,7 +86,8 @@ void primary_execution_t::update_contract_or_raft_state(
         contract_id,
         contract,
         raft_state.config.config.durability,
-        raft_state.config.config.write_ack_config);
+        raft_state.config.config.write_ack_config,
+        raft_state.config.config.expiry_field);
 
     /* Exit early if there aren't actually any changes. This is for performance reasons.
     */
@@ -130,6 +147,9 @@ void primary_execution_t::run(auto_drainer_t::lock_t keepalive) {
         direct_query_server_t direct_query_server(
             context->mailbox_manager,
             store);
+        /* The primary is never behind itself */
+        direct_query_server_t::lag_source_t lag_source(
+            &direct_query_server, []() -> int64_t { return 0; });
 
         on_thread_t thread_switcher_2(home_thread());
 
@@ -200,6 +220,10 @@ void primary_execution_t::run(auto_drainer_t::lock_t keepalive) {
             region,
             this);
 
+        coro_t::spawn_sometime(std::bind(
+            &primary_execution_t::expire_rows, this,
+            primary_dispatcher_drainer.lock()));
+
         on_thread_t thread_switcher_4(home_thread());
 
         /* OK, now we have to make sure that `sync_contract_with_replicas()` gets called
@@ -318,6 +342,10 @@ bool primary_execution_t::on_write(
     counted_t<contract_info_t> contract_snapshot = latest_contract_store_thread;
 
     if (static_cast<bool>(contract_snapshot->contract.primary->hand_over)) {
+        DEBUG_ONLY(finite_coro_waiting.reset());
+        begin_write_mutex_acq.reset();
+        exiter->end();
+        hold_write_during_hand_over(contract_snapshot, interruptor);
         *error_out = admin_err_t{
             "The primary replica is currently changing from one replica to "
             "another. The write was not performed. This error should go away in a "
@@ -365,6 +393,99 @@ bool primary_execution_t::on_write(
     return res;
 }
 
+void primary_execution_t::hold_write_during_hand_over(
+        const counted_t<contract_info_t> &contract_snapshot,
+        signal_t *interruptor) {
+    store->assert_thread();
+    /* `interruptor` is the `primary_query_server_t`'s shutdown signal, which is pulsed
+    when we stop being the primary, i.e. when the hand-over completes. We must not throw
+    when it's pulsed; we still have to send the client its error. */
+    signal_timer_t timeout;
+    timeout.start(HAND_OVER_MAX_WRITE_HOLD_MS);
+    wait_any_t waiter(&timeout, interruptor);
+    counted_t<contract_info_t> contract = contract_snapshot;
+    while (static_cast<bool>(contract->contract.primary->hand_over) &&
+           !waiter.is_pulsed()) {
+        try {
+            nap(HAND_OVER_POLL_INTERVAL_MS, &waiter);
+        } catch (const interrupted_exc_t &) {
+            /* The loop condition will take care of this */
+        }
+        contract = latest_contract_store_thread;
+    }
+}
+
+void primary_execution_t::expire_rows(auto_drainer_t::lock_t keepalive) {
+    store->assert_thread();
+    fifo_enforcer_source_t fifo_source;
+    fifo_enforcer_sink_t fifo_sink;
+    order_source_t order_source;
+    try {
+        for (;;) {
+            /* `latest_contract_store_thread` carries the table's current
+            `expiry_field`, so this notices when the user sets or clears it. */
+            optional<std::string> expiry_field =
+                latest_contract_store_thread->expiry_field;
+            bool found_rows = static_cast<bool>(expiry_field) &&
+                expire_some_rows(*expiry_field, &fifo_source, &fifo_sink,
+                                 &order_source, keepalive.get_drain_signal());
+            nap(found_rows ? EXPIRY_BATCH_INTERVAL_MS : EXPIRY_POLL_INTERVAL_MS,
+                keepalive.get_drain_signal());
+        }
+    } catch (const interrupted_exc_t &) {
+        /* We're no longer the primary, or we're shutting down */
+    }
+}
+
+bool primary_execution_t::expire_some_rows(
+        const std::string &expiry_field,
+        fifo_enforcer_source_t *fifo_source,
+        fifo_enforcer_sink_t *fifo_sink,
+        order_source_t *order_source,
+        signal_t *interruptor) {
+    /* Failures are expected here, for example while the expiry index is being built
+    or while we don't have a majority of the replicas. We don't report them; we just
+    try again later.
+
+    `our_dispatcher` is reset just before `interruptor` is pulsed, so we have to check
+    it before every call to `on_read()` or `on_write()`. */
+    if (interruptor->is_pulsed()) {
+        throw interrupted_exc_t();
+    }
+    ql::datum_t now = ql::pseudo::time_now();
+    read_response_t read_response;
+    admin_err_t error;
+    {
+        fifo_enforcer_sink_t::exit_read_t exiter(fifo_sink, fifo_source->enter_read());
+        if (!on_read(make_expired_rows_read(expiry_field, region, now),
+                     &exiter,
+                     order_source->check_in("expire_rows").with_read_mode(),
+                     interruptor,
+                     &read_response,
+                     &error)) {
+            return false;
+        }
+    }
+
+    std::vector<store_key_t> keys;
+    if (!get_expired_row_keys(read_response, primary_key, &keys) || keys.empty()) {
+        return false;
+    }
+
+    if (interruptor->is_pulsed()) {
+        throw interrupted_exc_t();
+    }
+    write_response_t write_response;
+    fifo_enforcer_sink_t::exit_write_t exiter(fifo_sink, fifo_source->enter_write());
+    return on_write(
+        make_expire_rows_write(std::move(keys), primary_key, expiry_field, now),
+        &exiter,
+        order_source->check_in("expire_rows"),
+        interruptor,
+        &write_response,
+        &error);
+}
+
 bool primary_execution_t::sync_committed_read(const read_t &read_request,
                                               order_token_t order_token,
                                               signal_t *interruptor,
@@ -437,7 +558,8 @@ bool primary_execution_t::on_read(
         }
         break;
     case read_mode_t::OUTDATED: // Fallthrough intentional
-    case read_mode_t::DEBUG_DIRECT:
+    case read_mode_t::DEBUG_DIRECT: // Fallthrough intentional
+    case read_mode_t::BOUNDED_STALENESS:
     default:
         // These read modes should not come through the `primary_exection_t`.
         unreachable();
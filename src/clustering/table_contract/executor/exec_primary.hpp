@@ -64,23 +64,27 @@ private:
         contract_info_t(const contract_id_t &_contract_id,
                         const contract_t &_contract,
                         write_durability_t _default_write_durability,
-                        write_ack_config_t _write_ack_config) :
+                        write_ack_config_t _write_ack_config,
+                        const optional<std::string> &_expiry_field) :
                 contract_id(_contract_id),
                 contract(_contract),
                 default_write_durability(_default_write_durability),
-                write_ack_config(_write_ack_config) {
+                write_ack_config(_write_ack_config),
+                expiry_field(_expiry_field) {
         }
         bool equivalent(const contract_info_t &other) const {
             /* This method is called `equivalent` rather than `operator==` to avoid
             confusion, because it doesn't actually compare every member */
             return contract_id == other.contract_id &&
                 default_write_durability == other.default_write_durability &&
-                write_ack_config == other.write_ack_config;
+                write_ack_config == other.write_ack_config &&
+                expiry_field == other.expiry_field;
         }
         contract_id_t contract_id;
         contract_t contract;
         write_durability_t default_write_durability;
         write_ack_config_t write_ack_config;
+        optional<std::string> expiry_field;
         cond_t obsolete;
     };
 
@@ -106,6 +110,30 @@ private:
         read_response_t *response_out,
         admin_err_t *error_out);
 
+    /* `hold_write_during_hand_over()` is called by `on_write()` for writes that arrive
+    while we're handing over to another primary. Instead of failing them right away, it
+    blocks until the hand-over is over (or a timeout passes), so that the client sees
+    the failure at the moment the new primary is about to take over and can send the
+    write there. The write is never performed here. */
+    void hold_write_during_hand_over(
+        const counted_t<contract_info_t> &contract_snapshot,
+        signal_t *interruptor);
+
+    /* `expire_rows()` runs on the store's thread for as long as `our_dispatcher`
+    exists. Whenever the table has an `expiry_field`, it deletes the expired rows in
+    our region in batches, through `on_read()` and `on_write()` like any other query;
+    see `rdb_protocol/table_expiry.hpp`. */
+    void expire_rows(auto_drainer_t::lock_t keepalive);
+
+    /* Deletes one batch of expired rows. Returns true if it found any, in which case
+    there may be more. */
+    bool expire_some_rows(
+        const std::string &expiry_field,
+        fifo_enforcer_source_t *fifo_source,
+        fifo_enforcer_sink_t *fifo_sink,
+        order_source_t *order_source,
+        signal_t *interruptor);
+
     /* `sync_majority()` is used after a read in 'majority' mode, and will perform a
     `sync` operation across a majority of replicas to make sure what has just been read
     has been committed to disk on a majority of replicas for each shard. */
@@ -147,6 +175,8 @@ private:
         counted_t<contract_info_t> contract,
         primary_dispatcher_t *dispatcher);
 
+    const std::string primary_key;
+
     optional<branch_id_t> our_branch_id;
 
     /* `latest_contract_*` stores the latest contract we've received, along with its ack
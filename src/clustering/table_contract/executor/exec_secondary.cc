@@ -186,6 +186,15 @@ void secondary_execution_t::run(auto_drainer_t::lock_t keepalive) {
                 context->branch_history_manager,
                 &stop_signal_on_store_thread);
 
+            /* Now that we're streaming, we know how far behind the primary we are, so
+            we can serve bounded-staleness reads */
+            direct_query_server_t::lag_source_t lag_source(
+                &direct_query_server,
+                [&]() { return remote_replicator_client.get_lag_ms(); });
+
+            cross_thread_signal_t lagged_too_far(
+                remote_replicator_client.get_lagged_too_far_signal(), home_thread());
+
             on_thread_t thread_switcher_4(home_thread());
 
             /* Now that we've backfilled, it's safe to call `enable_gc()`. */
@@ -206,8 +215,11 @@ void secondary_execution_t::run(auto_drainer_t::lock_t keepalive) {
                     context->local_table_query_bcards, generate_uuid(), tq_bcard);
             }
 
-            /* Wait until we lose contact with the primary or we get interrupted */
-            stop_signal.wait_lazily_unordered();
+            /* Wait until we lose contact with the primary or we get interrupted. If we
+            are a non-voting replica and fall too far behind the primary, we also start
+            over, which will catch us up with a backfill. */
+            wait_any_t stop_or_lagged(&stop_signal, &lagged_too_far);
+            stop_or_lagged.wait_lazily_unordered();
 
         } catch (const interrupted_exc_t &) {
             /* do nothing */
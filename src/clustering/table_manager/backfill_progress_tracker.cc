@@ -2,6 +2,10 @@
 
 #include "clustering/table_manager/backfill_progress_tracker.hpp"
 
+#include <vector>
+
+#include "concurrency/scatter_gather.hpp"
+
 backfill_progress_tracker_t::progress_tracker_t *
 backfill_progress_tracker_t::insert_progress_tracker(const region_t &region) {
     return &progress_trackers.get()->insert(
@@ -11,17 +15,16 @@ backfill_progress_tracker_t::insert_progress_tracker(const region_t &region) {
 
 std::map<region_t, backfill_progress_tracker_t::progress_tracker_t>
 backfill_progress_tracker_t::get_progress_trackers() {
+    std::vector<std::map<region_t, progress_tracker_t> > per_thread(get_num_threads());
+    scatter_gather_on_all_threads([&](int32_t thread) {
+        per_thread[thread] = *progress_trackers.get();
+    });
     std::map<region_t, progress_tracker_t> output;
-    pmap(get_num_threads(), [&](int thread) {
-        std::map<region_t, progress_tracker_t> inner;
-        {
-            on_thread_t on_thread((threadnum_t(thread)));
-            inner = *progress_trackers.get();
-        }
+    for (auto &&inner : per_thread) {
         for (const auto &pair : inner) {
             auto res = output.insert(std::move(pair));
             guarantee(res.second);
         }
-    });
+    }
     return output;
 }
@@ -26,7 +26,7 @@ void flush_interval_manager_t::update_blocking(signal_t *interruptor) {
         flush_interval = get_flush_interval(*config);
     });
 
-    for (size_t i = 0; i < CPU_SHARDING_FACTOR; ++i) {
+    for (int i = 0; i < multistore->get_cpu_sharding_factor(); ++i) {
         store_t *store = multistore->get_underlying_store(i);
         cross_thread_signal_t ct_interruptor(interruptor, store->home_thread());
         on_thread_t thread_switcher(store->home_thread());
@@ -3,6 +3,7 @@
 
 #include "clustering/generic/raft_core.tcc"
 #include "clustering/table_manager/table_manager.hpp"
+#include "concurrency/pmap.hpp"
 #include "logger.hpp"
 
 multi_table_manager_t::multi_table_manager_t(
@@ -31,27 +32,37 @@ multi_table_manager_t::multi_table_manager_t(
     io_backender(_io_backender),
     perfmon_collection_repo(_perfmon_collection_repo) {
 
-    /* Resurrect any tables that were sitting on disk from when we last shut down */
+    /* Resurrect any tables that were sitting on disk from when we last shut down.
+    Opening a table's data file (reading its metablock and LBA) is by far the slowest
+    part of this, so we first collect the active tables from the metadata, then open
+    up to `MAX_CONCURRENT_TABLE_LOADS` data files at a time, and only then start up the
+    tables' `active_table_t`s one after the other. */
+    struct pending_load_t {
+        namespace_id_t table_id;
+        table_active_persistent_state_t state;
+        raft_storage_interface_t<table_raft_state_t> *raft_storage;
+        int cpu_sharding_factor;
+        int block_size;
+        table_t *table;
+    };
+    std::vector<pending_load_t> pending_loads;
     cond_t non_interruptor;
     persistence_interface->read_all_metadata(
         [&](const namespace_id_t &table_id,
                 const table_active_persistent_state_t &state,
                 raft_storage_interface_t<table_raft_state_t> *raft_storage,
-                metadata_file_t::read_txn_t *metadata_read_txn) {
+                metadata_file_t::read_txn_t *) {
             guarantee(tables.count(table_id) == 0);
             table_t *table;
             tables[table_id].init(table = new table_t);
-            rwlock_acq_t table_lock_acq(&table->access_rwlock, access_t::write);
-            perfmon_collection_repo_t::collections_t *perfmon_collections =
-                perfmon_collection_repo->get_perfmon_collections_for_namespace(table_id);
             table->status = table_t::status_t::ACTIVE;
-            persistence_interface->load_multistore(
-                table_id, metadata_read_txn, &table->multistore_ptr, &non_interruptor,
-                &perfmon_collections->serializers_collection);
-            table->active = make_scoped<active_table_t>(
-                this, table, table_id, state.epoch, state.raft_member_id, raft_storage,
-                raft_start_election_immediately_t::NO, table->multistore_ptr.get(),
-                &perfmon_collections->namespace_collection);
+            /* The number of CPU shards and the block size never change, so it doesn't
+            matter that the snapshot might be older than the latest config. */
+            const table_config_t &config =
+                raft_storage->get()->snapshot_state.config.config;
+            pending_loads.push_back(pending_load_t{
+                table_id, state, raft_storage,
+                config.cpu_sharding_factor, config.block_size, table});
         },
         [&](const namespace_id_t &table_id,
                 const table_inactive_persistent_state_t &state,
@@ -66,6 +77,44 @@ multi_table_manager_t::multi_table_manager_t(
         },
         &non_interruptor);
 
+    if (!pending_loads.empty()) {
+        logNTC("Loading data for %zu tables...\n", pending_loads.size());
+    }
+    size_t num_loaded = 0;
+    throttled_pmap(pending_loads.size(), [&](int64_t i) {
+        const pending_load_t &load = pending_loads[i];
+        rwlock_acq_t table_lock_acq(&load.table->access_rwlock, access_t::write);
+        perfmon_collection_repo_t::collections_t *perfmon_collections =
+            perfmon_collection_repo->get_perfmon_collections_for_namespace(
+                load.table_id);
+        /* Unlike `load_multistore()`, `create_multistore()` reads the table's metadata
+        in a transaction of its own, so we can call it for many tables at once. The
+        data file exists, so it will be loaded rather than created. */
+        persistence_interface->create_multistore(
+            load.table_id, load.cpu_sharding_factor, load.block_size,
+            &load.table->multistore_ptr, &non_interruptor,
+            &perfmon_collections->serializers_collection);
+        ++num_loaded;
+        /* Report progress roughly every 10% */
+        if (num_loaded * 10 / pending_loads.size()
+                != (num_loaded - 1) * 10 / pending_loads.size()) {
+            logNTC("Loaded data for %zu of %zu tables.\n",
+                num_loaded, pending_loads.size());
+        }
+    }, MAX_CONCURRENT_TABLE_LOADS);
+
+    for (const pending_load_t &load : pending_loads) {
+        rwlock_acq_t table_lock_acq(&load.table->access_rwlock, access_t::write);
+        perfmon_collection_repo_t::collections_t *perfmon_collections =
+            perfmon_collection_repo->get_perfmon_collections_for_namespace(
+                load.table_id);
+        load.table->active = make_scoped<active_table_t>(
+            this, load.table, load.table_id, load.state.epoch,
+            load.state.raft_member_id, load.raft_storage,
+            raft_start_election_immediately_t::NO, load.table->multistore_ptr.get(),
+            &perfmon_collections->namespace_collection);
+    }
+
     help_construct();
 }
 
@@ -402,6 +451,8 @@ void multi_table_manager_t::on_action(
             cond_t non_interruptor;
             persistence_interface->create_multistore(
                 table_id,
+                initial_raft_state->snapshot_state.config.config.cpu_sharding_factor,
+                initial_raft_state->snapshot_state.config.config.block_size,
                 &table->multistore_ptr,
                 &non_interruptor,
                 &perfmon_collections->serializers_collection);
@@ -116,6 +116,12 @@ public:
         return &table_basic_configs;
     }
 
+    /* The server uses this to pass on the backfill load targets from the command
+    line. */
+    standard_backfill_throttler_t *get_backfill_throttler() {
+        return &backfill_throttler;
+    }
+
     /* Calls `callable` for each active table, it must have a signature of:
            void(const namespace_id_t &table_id, multistore_ptr_t *, table_manager_t *)
     `access` must be `access_t::write` if you change the state or configuration of
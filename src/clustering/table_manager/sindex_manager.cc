@@ -1,10 +1,12 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved
 #include "clustering/table_manager/sindex_manager.hpp"
 
+#include <vector>
+
 #include "clustering/administration/issues/outdated_index.hpp"
 
 #include "concurrency/cross_thread_signal.hpp"
-#include "concurrency/pmap.hpp"
+#include "concurrency/scatter_gather.hpp"
 #include "rdb_protocol/store.hpp"
 
 sindex_manager_t::sindex_manager_t(
@@ -38,16 +40,24 @@ sindex_manager_t::get_status(signal_t *interruptor) const {
         }
     });
 
-    pmap(static_cast<int64_t>(0), static_cast<int64_t>(CPU_SHARDING_FACTOR),
-    [&](int64_t i) {
-        std::map<std::string, std::pair<sindex_config_t, sindex_status_t> > store_state;
-        store_t *store = multistore->get_underlying_store(i);
-        cross_thread_signal_t ct_interruptor(interruptor, store->home_thread());
-        {
-            on_thread_t thread_switcher(store->home_thread());
-            store_state = store->sindex_list(&ct_interruptor);
-        }
+    /* The interruptors have to be created on this thread, so we do that before we
+    fan out to the stores' threads. */
+    const size_t num_stores = multistore->get_cpu_sharding_factor();
+    std::vector<threadnum_t> store_threads;
+    std::vector<scoped_ptr_t<cross_thread_signal_t> > ct_interruptors(num_stores);
+    for (size_t i = 0; i < num_stores; ++i) {
+        threadnum_t thread = multistore->get_underlying_store(i)->home_thread();
+        store_threads.push_back(thread);
+        ct_interruptors[i].init(new cross_thread_signal_t(interruptor, thread));
+    }
+    std::vector<std::map<std::string, std::pair<sindex_config_t, sindex_status_t> > >
+        store_states(num_stores);
+    scatter_gather(store_threads, [&](int64_t i) {
+        store_states[i] = multistore->get_underlying_store(i)->sindex_list(
+            ct_interruptors[i].get());
+    });
 
+    for (const auto &store_state : store_states) {
         for (auto &&pair : res) {
             auto it = store_state.find(pair.first);
             /* Note that we treat an index with the wrong definition like a missing
@@ -58,7 +68,7 @@ sindex_manager_t::get_status(signal_t *interruptor) const {
                 pair.second.second.ready = false;
             }
         }
-    });
+    }
 
     return res;
 }
@@ -69,7 +79,7 @@ void sindex_manager_t::update_blocking(signal_t *interruptor) {
         goal = config->sindexes;
     });
 
-    for (size_t i = 0; i < CPU_SHARDING_FACTOR; ++i) {
+    for (int i = 0; i < multistore->get_cpu_sharding_factor(); ++i) {
         store_t *store = multistore->get_underlying_store(i);
         cross_thread_signal_t ct_interruptor(interruptor, store->home_thread());
         on_thread_t thread_switcher(store->home_thread());
@@ -340,14 +340,25 @@ public:
     virtual void delete_metadata(
         const namespace_id_t &table_id) = 0;
 
+    /* `load_multistore()` and `create_multistore()` open the table's data file, which
+    must have (or will be created with) `cpu_sharding_factor` CPU shards, as given by
+    the table's config. A new data file is created with blocks of `block_size` bytes;
+    an existing one keeps the block size it was created with. `create_multistore()`
+    opens an existing data file as well. It
+    reads the table's metadata in a transaction of its own, so it can be called for
+    several tables concurrently. */
     virtual void load_multistore(
         const namespace_id_t &table_id,
+        int cpu_sharding_factor,
+        int block_size,
         metadata_file_t::read_txn_t *metadata_read_txn,
         scoped_ptr_t<multistore_ptr_t> *multistore_ptr_out,
         signal_t *interruptor,
         perfmon_collection_t *perfmon_collection_serializers) = 0;
     virtual void create_multistore(
         const namespace_id_t &table_id,
+        int cpu_sharding_factor,
+        int block_size,
         scoped_ptr_t<multistore_ptr_t> *multistore_ptr_out,
         signal_t *interruptor,
         perfmon_collection_t *perfmon_collection_serializers) = 0;
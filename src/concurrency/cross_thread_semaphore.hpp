@@ -2,6 +2,9 @@
 #ifndef CONCURRENCY_CROSS_THREAD_SEMAPHORE_HPP_
 #define CONCURRENCY_CROSS_THREAD_SEMAPHORE_HPP_
 
+#include <functional>
+#include <utility>
+
 #include "containers/scoped.hpp"
 #include "containers/intrusive_list.hpp"
 #include "concurrency/interruptor.hpp"
@@ -32,7 +35,13 @@ public:
     class lock_t {
     public:
         explicit lock_t(cross_thread_semaphore_t *_parent, signal_t *interruptor) :
-            parent(_parent), value(parent->lock(interruptor)) { }
+            parent(_parent), value(parent->lock(interruptor, nullptr)) { }
+
+        // Takes an available element for which `preferred` returns true if there is
+        //  one, and otherwise behaves like the constructor above
+        lock_t(cross_thread_semaphore_t *_parent, signal_t *interruptor,
+               const std::function<bool(const value_t *)> &preferred) :
+            parent(_parent), value(parent->lock(interruptor, &preferred)) { }
 
         ~lock_t() {
             parent->unlock(value);
@@ -92,7 +101,8 @@ private:
         request_node_t *request;
     };
 
-    value_t *lock(signal_t *interruptor);
+    value_t *lock(signal_t *interruptor,
+                  const std::function<bool(const value_t *)> *preferred);
     void unlock(value_t *value);
 
     // Mutex to control access, since a lock may be constructed from any thread
@@ -114,7 +124,7 @@ private:
 template <class value_t>
 cross_thread_semaphore_t<value_t>::~cross_thread_semaphore_t() {
     for (size_t i = 0; i < values.size(); ++i) {
-        delete lock(nullptr);
+        delete lock(nullptr, nullptr);
     }
 }
 
@@ -134,7 +144,9 @@ void cross_thread_semaphore_t<value_t>::pass_value_coroutine(request_node_t *req
 }
 
 template <class value_t>
-value_t *cross_thread_semaphore_t<value_t>::lock(signal_t *interruptor) {
+value_t *cross_thread_semaphore_t<value_t>::lock(
+        signal_t *interruptor,
+        const std::function<bool(const value_t *)> *preferred) {
     system_mutex_t::lock_t _lock(&mutex);
     value_t *result = nullptr;
 
@@ -143,6 +155,15 @@ value_t *cross_thread_semaphore_t<value_t>::lock(signal_t *interruptor) {
         _lock.unlock();
         result = request.wait_and_get(interruptor);
     } else {
+        if (preferred != nullptr) {
+            // Move the first preferred element (if any) to the front of the available ones
+            for (size_t i = available_value_index; i < values.size(); ++i) {
+                if ((*preferred)(values[i])) {
+                    std::swap(values[i], values[available_value_index]);
+                    break;
+                }
+            }
+        }
         result = values[available_value_index];
         values[available_value_index] = nullptr;
         ++available_value_index;
@@ -4,6 +4,7 @@
 
 #include "arch/runtime/runtime.hpp"
 #include "concurrency/pmap.hpp"
+#include "concurrency/scatter_gather.hpp"
 #include "containers/scoped.hpp"
 #include "containers/object_buffer.hpp"
 
@@ -14,13 +15,12 @@ public:
         one_per_thread_t *parent_;
         explicit construct_0_t(one_per_thread_t *p) : parent_(p) { }
         void operator()(int thread) const {
-            on_thread_t th((threadnum_t(thread)));
             parent_->array[thread].create();
         }
     };
 
     one_per_thread_t() : array(get_num_threads()) {
-        pmap(get_num_threads(), construct_0_t(this));
+        scatter_gather_on_all_threads(construct_0_t(this));
     }
 
     template <class arg1_t>
@@ -30,7 +30,6 @@ public:
         construct_1_t(one_per_thread_t *p, const arg1_t &arg1) : parent_(p), arg1_(arg1) { }
 
         void operator()(int thread) const {
-            on_thread_t th((threadnum_t(thread)));
             parent_->array[thread].create(arg1_);
         }
     };
@@ -38,7 +37,7 @@ public:
 
     template<class arg1_t>
     explicit one_per_thread_t(const arg1_t &arg1) : array(get_num_threads()) {
-        pmap(get_num_threads(), construct_1_t<arg1_t>(this, arg1));
+        scatter_gather_on_all_threads(construct_1_t<arg1_t>(this, arg1));
     }
 
     template <class arg1_t, class arg2_t>
@@ -49,14 +48,13 @@ public:
         construct_2_t(one_per_thread_t *p, const arg1_t &arg1, const arg2_t &arg2) : parent_(p), arg1_(arg1), arg2_(arg2) { }
 
         void operator()(int thread) const {
-            on_thread_t th((threadnum_t(thread)));
             parent_->array[thread].create(arg1_, arg2_);
         }
     };
 
     template<class arg1_t, class arg2_t>
     one_per_thread_t(const arg1_t &arg1, const arg2_t &arg2) : array(get_num_threads()) {
-        pmap(get_num_threads(), construct_2_t<arg1_t, arg2_t>(this, arg1, arg2));
+        scatter_gather_on_all_threads(construct_2_t<arg1_t, arg2_t>(this, arg1, arg2));
     }
 
 
@@ -64,13 +62,12 @@ public:
         one_per_thread_t *parent_;
         explicit destruct_t(one_per_thread_t *p) : parent_(p) { }
         void operator()(int thread) const {
-            on_thread_t th((threadnum_t(thread)));
             parent_->array[thread].reset();
         }
     };
 
     ~one_per_thread_t() {
-        pmap(get_num_threads(), destruct_t(this));
+        scatter_gather_on_all_threads(destruct_t(this));
     }
 
     inner_t *get() {
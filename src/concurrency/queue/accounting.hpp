@@ -62,6 +62,16 @@ public:
             parent->available_control.set_available(!parent->active_accounts.empty());
         }
 
+        /* Changes the account's share without disturbing whatever is queued on it. */
+        void set_shares(int _shares) {
+            parent->assert_thread();
+            rassert(_shares > 0);
+            if (active) {
+                parent->total_shares += _shares - shares;
+            }
+            shares = _shares;
+        }
+
     private:
         friend class accounting_queue_t;
 
@@ -0,0 +1,27 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "concurrency/scatter_gather.hpp"
+
+scatter_gather_completion_t::scatter_gather_completion_t(int64_t count)
+    : outstanding(count), home_thread(get_thread_id()) {
+    rassert(count > 0);
+}
+
+void scatter_gather_completion_t::finish_one() {
+    if (outstanding.fetch_sub(1) != 1) {
+        return;
+    }
+    /* We're the last one. As soon as `done` is pulsed, the caller may destroy us, so we
+    mustn't touch anything afterwards. */
+    if (continue_on_thread(home_thread, this)) {
+        done.pulse();
+    }
+}
+
+void scatter_gather_completion_t::wait() {
+    rassert(get_thread_id() == home_thread);
+    done.wait();
+}
+
+void scatter_gather_completion_t::on_thread_switch() {
+    done.pulse();
+}
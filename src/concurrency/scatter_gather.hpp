@@ -0,0 +1,144 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CONCURRENCY_SCATTER_GATHER_HPP_
+#define CONCURRENCY_SCATTER_GATHER_HPP_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <vector>
+
+#include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/runtime.hpp"
+#include "arch/runtime/runtime_utils.hpp"
+#include "concurrency/cond_var.hpp"
+#include "containers/scoped.hpp"
+#include "threading.hpp"
+
+/* `scatter_gather()` calls `fun(i)` for every `i` in `[0, threads.size())`, each in
+its own coroutine on the thread `threads[i]`, and returns once all of the calls are
+done. `fun` must not throw.
+
+It does the same thing as a `pmap()` whose callback starts with an `on_thread_t`, but
+with a lot fewer thread switches when there are many items. With `pmap()`, every item
+costs a message to the target thread, a message back, and a wakeup of the calling
+thread. Here every target thread gets a single message for all of its items, the
+coroutines finish on the thread that they ran on, and the calling coroutine is woken up
+once, by whichever item finishes last. Items for the calling thread don't switch
+threads at all. The coroutines get the calling coroutine's priority. */
+
+/* Counts down the outstanding items on any thread, and pulses `done` on the calling
+thread when the last one finishes. */
+class scatter_gather_completion_t : private linux_thread_message_t {
+public:
+    explicit scatter_gather_completion_t(int64_t count);
+
+    void finish_one();
+    void wait();
+
+private:
+    void on_thread_switch();
+
+    std::atomic<int64_t> outstanding;
+    const threadnum_t home_thread;
+    cond_t done;
+
+    DISABLE_COPYING(scatter_gather_completion_t);
+};
+
+/* The items that are to run on one thread. The batch itself counts as one of the
+outstanding items until it has spawned all of its coroutines, so that nobody destroys it
+while it's still going through `items`. */
+template <class callable_t>
+class scatter_gather_batch_t : public linux_thread_message_t {
+public:
+    scatter_gather_batch_t(const callable_t *_fun,
+                           scatter_gather_completion_t *_completion,
+                           int _priority)
+        : linux_thread_message_t(_priority), fun(_fun), completion(_completion) { }
+
+    void run() {
+        const callable_t *f = fun;
+        scatter_gather_completion_t *c = completion;
+        const int p = get_priority();
+        for (int64_t i : items) {
+            coro_t::spawn_now_dangerously([f, c, p, i]() {
+                coro_t::self()->set_priority(p);
+                (*f)(i);
+                c->finish_one();
+            });
+        }
+        completion->finish_one();
+    }
+
+    std::vector<int64_t> items;
+
+private:
+    void on_thread_switch() {
+        run();
+    }
+
+    const callable_t *const fun;
+    scatter_gather_completion_t *const completion;
+
+    DISABLE_COPYING(scatter_gather_batch_t);
+};
+
+template <class callable_t>
+void scatter_gather(const std::vector<threadnum_t> &threads, const callable_t &fun) {
+    rassert(coro_t::self() != nullptr);
+    if (threads.empty()) {
+        return;
+    }
+    const int priority = coro_t::self()->get_priority();
+
+    std::vector<std::vector<int64_t> > items_by_thread(get_num_threads());
+    int64_t num_batches = 0;
+    for (size_t i = 0; i < threads.size(); ++i) {
+        assert_good_thread_id(threads[i]);
+        std::vector<int64_t> *items = &items_by_thread[threads[i].threadnum];
+        if (items->empty()) {
+            ++num_batches;
+        }
+        items->push_back(static_cast<int64_t>(i));
+    }
+
+    scatter_gather_completion_t completion(
+        static_cast<int64_t>(threads.size()) + num_batches);
+    std::vector<scoped_ptr_t<scatter_gather_batch_t<callable_t> > > batches(
+        items_by_thread.size());
+    for (size_t t = 0; t < items_by_thread.size(); ++t) {
+        if (!items_by_thread[t].empty()) {
+            batches[t].init(
+                new scatter_gather_batch_t<callable_t>(&fun, &completion, priority));
+            batches[t]->items = std::move(items_by_thread[t]);
+        }
+    }
+
+    /* Send the other threads their batches before we start on our own, so that they
+    can work in parallel with us. */
+    const threadnum_t self_thread = get_thread_id();
+    for (size_t t = 0; t < batches.size(); ++t) {
+        if (batches[t].has() && static_cast<int32_t>(t) != self_thread.threadnum) {
+            continue_on_thread(threadnum_t(static_cast<int32_t>(t)), batches[t].get());
+        }
+    }
+    if (batches[self_thread.threadnum].has()) {
+        batches[self_thread.threadnum]->run();
+    }
+    completion.wait();
+}
+
+/* Calls `fun(thread)` on every thread in the thread pool. */
+template <class callable_t>
+void scatter_gather_on_all_threads(const callable_t &fun) {
+    std::vector<threadnum_t> threads;
+    threads.reserve(get_num_threads());
+    for (int32_t t = 0; t < get_num_threads(); ++t) {
+        threads.push_back(threadnum_t(t));
+    }
+    scatter_gather(threads, [&](int64_t t) {
+        fun(static_cast<int32_t>(t));
+    });
+}
+
+#endif  // CONCURRENCY_SCATTER_GATHER_HPP_
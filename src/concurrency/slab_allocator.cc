@@ -0,0 +1,160 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "concurrency/slab_allocator.hpp"
+
+#include <algorithm>
+
+#include "arch/runtime/runtime.hpp"
+#include "memory_utils.hpp"
+#include "utils.hpp"
+
+static const size_t SLAB_BLOCK_ALIGNMENT = 16;
+
+static size_t round_up_to_alignment(size_t size) {
+    return (size + SLAB_BLOCK_ALIGNMENT - 1) / SLAB_BLOCK_ALIGNMENT
+        * SLAB_BLOCK_ALIGNMENT;
+}
+
+slab_allocator_t::slab_allocator_t(size_t object_size, const char *name)
+    : block_size(round_up_to_alignment(std::max(object_size, sizeof(free_block_t)))),
+      blocks_per_slab((SLAB_SIZE - round_up_to_alignment(sizeof(slab_t))) / block_size),
+      allocated_name(strprintf("%s_allocated", name)),
+      bytes_name(strprintf("%s_bytes", name)),
+      slabs_name(strprintf("%s_slabs", name)),
+      pm_membership(&get_global_perfmon_collection(),
+          &pm_allocated, allocated_name.c_str(),
+          &pm_bytes, bytes_name.c_str(),
+          &pm_slabs, slabs_name.c_str()) {
+    // Otherwise most of every slab would be wasted
+    guarantee(blocks_per_slab >= 8);
+}
+
+slab_allocator_t::~slab_allocator_t() {
+    for (auto &thread : threads) {
+        per_thread_t *pt = &thread.value;
+        take_remote_frees(pt);
+        while (slab_t *slab = pt->partial_slabs.head()) {
+            pt->partial_slabs.remove(slab);
+            // Slabs that still have blocks in use are leaked rather than freed, in case
+            // something still refers to them during shutdown.
+            if (slab->num_allocated == 0) {
+                slab->~slab_t();
+                raw_free_aligned(slab);
+            }
+        }
+        if (pt->empty_slab != nullptr) {
+            pt->empty_slab->~slab_t();
+            raw_free_aligned(pt->empty_slab);
+        }
+    }
+}
+
+void *slab_allocator_t::allocate() {
+    const int32_t thread = get_thread_id().threadnum;
+    guarantee(thread >= 0 && thread < MAX_THREADS,
+              "slab_allocator_t can only be used inside the thread pool");
+    per_thread_t *pt = &threads[thread].value;
+
+    if (pt->partial_slabs.empty()) {
+        take_remote_frees(pt);
+    }
+    if (pt->partial_slabs.empty()) {
+        slab_t *slab;
+        if (pt->empty_slab != nullptr) {
+            slab = pt->empty_slab;
+            pt->empty_slab = nullptr;
+        } else {
+            slab = new_slab(thread);
+        }
+        pt->partial_slabs.push_front(slab);
+    }
+
+    slab_t *slab = pt->partial_slabs.head();
+    void *block;
+    if (slab->free_blocks != nullptr) {
+        block = slab->free_blocks;
+        slab->free_blocks = slab->free_blocks->next;
+    } else {
+        block = slab->unused;
+        slab->unused += block_size;
+    }
+    ++slab->num_allocated;
+    if (slab->num_allocated == blocks_per_slab) {
+        pt->partial_slabs.remove(slab);
+    }
+    ++pm_allocated;
+    pm_bytes += block_size;
+    return block;
+}
+
+void slab_allocator_t::deallocate(void *ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+    slab_t *slab = slab_of(ptr);
+    const int32_t thread = get_thread_id().threadnum;
+    if (thread == slab->owner_thread) {
+        free_locally(&threads[thread].value, ptr);
+    } else {
+        /* The owner will pick it up later. We can't touch the slab itself, because the
+        owner might be using it right now. */
+        std::atomic<free_block_t *> *remote_frees =
+            &threads[slab->owner_thread].value.remote_frees;
+        free_block_t *block = static_cast<free_block_t *>(ptr);
+        block->next = remote_frees->load(std::memory_order_relaxed);
+        while (!remote_frees->compare_exchange_weak(block->next, block,
+                std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+}
+
+slab_allocator_t::slab_t *slab_allocator_t::new_slab(int32_t thread) {
+    void *memory = raw_malloc_aligned(SLAB_SIZE, SLAB_SIZE);
+    slab_t *slab = new (memory) slab_t();
+    slab->owner_thread = thread;
+    slab->num_allocated = 0;
+    slab->free_blocks = nullptr;
+    slab->unused = static_cast<char *>(memory) + round_up_to_alignment(sizeof(slab_t));
+    ++pm_slabs;
+    return slab;
+}
+
+void slab_allocator_t::free_locally(per_thread_t *pt, void *ptr) {
+    slab_t *slab = slab_of(ptr);
+    free_block_t *block = static_cast<free_block_t *>(ptr);
+    block->next = slab->free_blocks;
+    slab->free_blocks = block;
+    if (slab->num_allocated == blocks_per_slab) {
+        /* The slab was full, so it wasn't in the list. Put it first so that the block
+        we just freed, which is probably still in the CPU cache, is handed out next. */
+        pt->partial_slabs.push_front(slab);
+    }
+    --slab->num_allocated;
+    --pm_allocated;
+    pm_bytes -= block_size;
+    if (slab->num_allocated == 0) {
+        pt->partial_slabs.remove(slab);
+        if (pt->empty_slab == nullptr) {
+            // Start over with a clean slab, so blocks are handed out in address order
+            slab->free_blocks = nullptr;
+            slab->unused = reinterpret_cast<char *>(slab)
+                + round_up_to_alignment(sizeof(slab_t));
+            pt->empty_slab = slab;
+        } else {
+            slab->~slab_t();
+            raw_free_aligned(slab);
+            --pm_slabs;
+        }
+    }
+}
+
+void slab_allocator_t::take_remote_frees(per_thread_t *pt) {
+    if (pt->remote_frees.load(std::memory_order_relaxed) == nullptr) {
+        return;
+    }
+    free_block_t *block = pt->remote_frees.exchange(nullptr, std::memory_order_acquire);
+    while (block != nullptr) {
+        free_block_t *next = block->next;
+        free_locally(pt, block);
+        block = next;
+    }
+}
@@ -0,0 +1,103 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CONCURRENCY_SLAB_ALLOCATOR_HPP_
+#define CONCURRENCY_SLAB_ALLOCATOR_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+#include <atomic>
+#include <string>
+
+#include "concurrency/cache_line_padded.hpp"
+#include "config/args.hpp"
+#include "containers/intrusive_list.hpp"
+#include "errors.hpp"
+#include "perfmon/perfmon.hpp"
+
+/* `slab_allocator_t` hands out fixed-size blocks for objects that are allocated and
+freed all the time, like the buffer cache's `page_t`. Every thread carves blocks out of
+its own slabs, so allocating and freeing on one thread never touches shared state or the
+global heap lock, and objects that are alive at the same time stay close together.
+
+A block that is freed on a thread other than the one it came from is pushed onto its
+owner's lock-free list of remote frees. The owner takes them back the next time it runs
+out of free blocks. Slabs that become completely empty are returned to the heap, except
+for one spare per thread.
+
+The number of blocks in use, the bytes they take up, and the number of slabs show up in
+the global stats as `<name>_allocated`, `<name>_bytes` and `<name>_slabs`. For the
+buffer cache, the `_bytes` stats add up to its per-block metadata overhead.
+
+Allocating outside of the thread pool isn't allowed. Use `SLAB_ALLOCATED()` to make a
+class's `operator new` use a slab allocator. */
+class slab_allocator_t {
+public:
+    slab_allocator_t(size_t object_size, const char *name);
+    ~slab_allocator_t();
+
+    void *allocate();
+    void deallocate(void *ptr);
+
+    static const size_t SLAB_SIZE = 64 * KILOBYTE;
+
+private:
+    struct free_block_t {
+        free_block_t *next;
+    };
+
+    struct slab_t : public intrusive_list_node_t<slab_t> {
+        int32_t owner_thread;
+        size_t num_allocated;
+        /* Blocks that were allocated and freed again */
+        free_block_t *free_blocks;
+        /* Blocks past this point have never been allocated */
+        char *unused;
+    };
+
+    struct per_thread_t {
+        per_thread_t() : empty_slab(nullptr), remote_frees(nullptr) { }
+        /* Slabs that have at least one free block */
+        intrusive_list_t<slab_t> partial_slabs;
+        slab_t *empty_slab;
+        std::atomic<free_block_t *> remote_frees;
+    };
+
+    static slab_t *slab_of(void *ptr) {
+        return reinterpret_cast<slab_t *>(
+            reinterpret_cast<uintptr_t>(ptr) & ~static_cast<uintptr_t>(SLAB_SIZE - 1));
+    }
+
+    slab_t *new_slab(int32_t thread);
+    void free_locally(per_thread_t *pt, void *ptr);
+    void take_remote_frees(per_thread_t *pt);
+
+    const size_t block_size;
+    const size_t blocks_per_slab;
+    std::array<cache_line_padded_t<per_thread_t>, MAX_THREADS> threads;
+
+    const std::string allocated_name, bytes_name, slabs_name;
+    perfmon_counter_t pm_allocated, pm_bytes, pm_slabs;
+    perfmon_multi_membership_t pm_membership;
+
+    DISABLE_COPYING(slab_allocator_t);
+};
+
+/* Put `SLAB_ALLOCATED(class_name)` in the public part of a class definition, and
+`SLAB_ALLOCATED_IMPL(class_name, name)` in the `.cc` file. Subclasses, if any, must
+define their own `operator new`. */
+#define SLAB_ALLOCATED(class_name)                                              \
+    static void *operator new(size_t size);                                    \
+    static void operator delete(void *ptr)
+
+#define SLAB_ALLOCATED_IMPL(class_name, name)                                   \
+    static slab_allocator_t class_name##_slab_allocator(sizeof(class_name), name); \
+    void *class_name::operator new(size_t size) {                              \
+        guarantee(size == sizeof(class_name));                                 \
+        return class_name##_slab_allocator.allocate();                         \
+    }                                                                          \
+    void class_name::operator delete(void *ptr) {                              \
+        class_name##_slab_allocator.deallocate(ptr);                           \
+    }
+
+#endif  // CONCURRENCY_SLAB_ALLOCATOR_HPP_
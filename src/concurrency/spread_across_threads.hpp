@@ -0,0 +1,62 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CONCURRENCY_SPREAD_ACROSS_THREADS_HPP_
+#define CONCURRENCY_SPREAD_ACROSS_THREADS_HPP_
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+#include "arch/runtime/coroutines.hpp"
+#include "concurrency/pmap.hpp"
+#include "threading.hpp"
+
+/* `spread_across_threads()` is for CPU-heavy work that can be split into independent
+chunks, such as serializing a large query result. It calls `fun(i)` once for every `i`
+in `[0, num_chunks)`, and returns when all of the calls are done.
+
+Coroutines stay on the thread that spawned them, so without this the work would all
+land on whichever thread the query happens to be running on. Instead, we start a worker
+on each of up to `max_threads` threads. Each worker repeatedly takes the next chunk that
+no one has started yet. A thread that is busy with other work gets through fewer chunks,
+and the idle threads pick up the rest. The workers yield between chunks, so the other
+coroutines on their threads still get to run.
+
+`fun` must be thread-agnostic: it's called on several threads at once, so it may only
+touch things that are safe to use from any thread. If it throws, no further chunks are
+started, and the first exception is rethrown on the calling thread once the other
+workers have stopped. */
+template <class callable_t>
+void spread_across_threads(size_t num_chunks, int max_threads, const callable_t &fun) {
+    const int num_threads = static_cast<int>(std::min<int64_t>(
+        std::min(max_threads, get_num_db_threads()), num_chunks));
+    const int32_t thread_offset = get_thread_id().threadnum;
+
+    std::atomic<size_t> next_chunk(0);
+    std::atomic<bool> failed(false);
+    std::exception_ptr error;
+    pmap(num_threads, [&](int64_t m) {
+        int32_t target_thread =
+            (thread_offset + static_cast<int32_t>(m)) % get_num_db_threads();
+        on_thread_t rethreader((threadnum_t(target_thread)));
+        try {
+            for (size_t i = next_chunk++; i < num_chunks; i = next_chunk++) {
+                if (failed.load()) {
+                    break;
+                }
+                fun(i);
+                coro_t::yield();
+            }
+        } catch (...) {
+            if (!failed.exchange(true)) {
+                error = std::current_exception();
+            }
+        }
+    });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+#endif  // CONCURRENCY_SPREAD_ACROSS_THREADS_HPP_
@@ -22,8 +22,8 @@
  */
 
 // The number of hash-based CPU shards per table.
-// This "must" be hard-coded because a cluster cannot run with
-// differing cpu sharding factors.
+// The default number of CPU shards for new tables.  The actual number is part of
+// each table's config, because every server hosting a table must agree on it.
 #define CPU_SHARDING_FACTOR                       8
 
 // Defines the maximum size of the batch of IO events to process on
@@ -66,14 +66,38 @@
 // 0 = minimal priority
 #define SINDEX_POST_CONSTRUCTION_CACHE_PRIORITY   5
 
+// The cache priority for reads of queries run with `priority: 'low'`, on the same
+// scale
+#define LOW_PRIORITY_QUERY_CACHE_PRIORITY         25
+
+// After a restart, each table's cache reads back the blocks that were hot before
+// (see `page_cache_t::warm_up()`).  These reads use their own I/O account with this
+// priority, so that they don't hold up the reads of queries that come in meanwhile.
+#define CACHE_WARM_UP_IO_PRIORITY                 (CACHE_READS_IO_PRIORITY / 8)
+
+// How many blocks of each CPU shard we remember for the cache warm-up, at most, and
+// how often we remember them.
+#define CACHE_WARM_UP_MAX_BLOCKS                  (64 * THOUSAND)
+#define CACHE_WARM_UP_SAVE_INTERVAL_MS            (5 * 60 * THOUSAND)
+
 // Size of the buffer used to perform IO operations (in bytes).
 #define IO_BUFFER_SIZE                            (4 * KILOBYTE)
 
 // Size of the device block size (in bytes)
 #define DEVICE_BLOCK_SIZE                         512
 
-// Size of each btree node (in bytes) on disk
+// Freed block buffers of up to MAX_POOLED_BLOCK_BUFFER_SIZE bytes are kept around for
+// reuse, up to BLOCK_BUFFER_POOL_SIZE bytes of them per thread (see
+// serializer/block_buffer_pool.hpp).
+#define MAX_POOLED_BLOCK_BUFFER_SIZE              (64 * KILOBYTE)
+#define BLOCK_BUFFER_POOL_SIZE                    (4 * MEGABYTE)
+
+// Size of each btree node (in bytes) on disk. Each table can pick a power of two
+// between MIN_BTREE_BLOCK_SIZE and MAX_BTREE_BLOCK_SIZE when it's created. The
+// maximum is limited by the 16-bit block sizes in the LBA.
 #define DEFAULT_BTREE_BLOCK_SIZE                  (4 * KILOBYTE)
+#define MIN_BTREE_BLOCK_SIZE                      (4 * KILOBYTE)
+#define MAX_BTREE_BLOCK_SIZE                      (32 * KILOBYTE)
 
 // Size of each extent (in bytes)
 // This should not be too small, or garbage collection will become
@@ -83,6 +107,9 @@
 // Ratio of free ram to use for the cache by default
 #define DEFAULT_MAX_CACHE_RATIO                   2
 
+// How often an automatically sized cache is shrunk or grown according to memory pressure
+#define CACHE_SIZE_MEMORY_PRESSURE_INTERVAL_MS    (5 * THOUSAND)
+
 // The maximum number of concurrently active
 // index writes per merger serializer.
 // The smaller the number, the more effective
@@ -92,6 +119,9 @@
 // small values of this variable.
 #define MERGER_SERIALIZER_MAX_ACTIVE_WRITES       1
 
+// How many tables' data files we open concurrently when the server starts up
+#define MAX_CONCURRENT_TABLE_LOADS                8
+
 // I/O priority of block writes in the merger_serializer_t
 #define MERGER_BLOCK_WRITE_IO_PRIORITY            64
 
@@ -120,12 +150,23 @@
 #define LBA_MIN_SIZE_FOR_GC                       (MEGABYTE * 1)
 #define LBA_MIN_UNGARBAGE_FRACTION                0.5
 
+// On a clean shutdown, we compact every LBA shard in which no more than
+// LBA_SHUTDOWN_MIN_UNGARBAGE_FRACTION of the entries are live. This bounds how much
+// of the LBA has to be replayed when the serializer starts up again.
+#define LBA_SHUTDOWN_MIN_UNGARBAGE_FRACTION       0.8
+
 // I/O priority for LBA garbage collection
 #define LBA_GC_IO_PRIORITY                        8
 
 // How many block ids should the LBA garbage collector rewrite before yielding?
 #define LBA_GC_BATCH_SIZE                         (1024 * 8)
 
+// Backups of table data files (see `serializer/backup.hpp`) read this many blocks at
+// a time with this I/O priority, and write the backup file in chunks of this size.
+#define BACKUP_IO_PRIORITY                        8
+#define BACKUP_READ_BATCH_SIZE                    64
+#define BACKUP_WRITE_CHUNK_SIZE                   (4 * MEGABYTE)
+
 // How many LBA structures to have for each file (This value defines the disk format!
 // It can't change unless you're very careful.)
 #define LBA_SHARD_FACTOR                          4
@@ -180,6 +221,10 @@
 #define CORO_PRIORITY_RESET_DATA                (-2)
 #define CORO_PRIORITY_DIRECTORY_CHANGES         (-2)
 #define CORO_PRIORITY_LBA_GC                    (-2)
+// Queries run with `priority: 'low'` stay ahead of backfills and index construction,
+// and `priority: 'high'` ones ahead of all other queries.
+#define CORO_PRIORITY_LOW_PRIORITY_QUERY        (-1)
+#define CORO_PRIORITY_HIGH_PRIORITY_QUERY       1
 
 #endif  // CONFIG_ARGS_HPP_
 
@@ -1,6 +1,7 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "containers/archive/archive.hpp"
 
+#include <stdlib.h>
 #include <string.h>
 
 #ifdef _WIN32
@@ -10,9 +11,11 @@
 #endif
 
 #include <algorithm>
+#include <new>
 
 #include "containers/archive/versioned.hpp"
 #include "containers/uuid.hpp"
+#include "memory_utils.hpp"
 #include "rpc/serialize_macros.hpp"
 
 const char *archive_result_as_str(archive_result_t archive_result) {
@@ -58,21 +61,48 @@ int64_t force_read(read_stream_t *s, void *p, int64_t n) {
     return written_so_far;
 }
 
+const int write_buffer_t::INITIAL_CAPACITY;
+const int write_buffer_t::MAX_CAPACITY;
+
+write_buffer_t::write_buffer_t(int _capacity)
+    : size(0),
+      capacity(_capacity),
+      data(reinterpret_cast<char *>(this + 1)) { }
+
+write_buffer_t *write_buffer_t::create(int capacity) {
+    rassert(capacity > 0);
+    void *mem = rmalloc(sizeof(write_buffer_t) + capacity);
+    return new (mem) write_buffer_t(capacity);
+}
+
+void write_buffer_t::destroy(write_buffer_t *buffer) {
+    buffer->~write_buffer_t();
+    free(buffer);
+}
+
 write_message_t::~write_message_t() {
     while (write_buffer_t *buffer = buffers_.head()) {
         buffers_.remove(buffer);
-        delete buffer;
+        write_buffer_t::destroy(buffer);
     }
 }
 
 void write_message_t::append(const void *p, int64_t n) {
     while (n > 0) {
-        if (buffers_.empty() || buffers_.tail()->size == write_buffer_t::DATA_SIZE) {
-            buffers_.push_back(new write_buffer_t);
+        if (buffers_.empty() || buffers_.tail()->size == buffers_.tail()->capacity) {
+            int capacity = buffers_.empty()
+                ? write_buffer_t::INITIAL_CAPACITY
+                : std::min(std::max(buffers_.tail()->capacity * 2,
+                                    write_buffer_t::INITIAL_CAPACITY),
+                           write_buffer_t::MAX_CAPACITY);
+            // A big append gets a buffer of its own size right away.
+            capacity = std::max<int64_t>(
+                capacity, std::min<int64_t>(n, write_buffer_t::MAX_CAPACITY));
+            buffers_.push_back(write_buffer_t::create(capacity));
         }
 
         write_buffer_t *b = buffers_.tail();
-        int64_t k = std::min<int64_t>(n, write_buffer_t::DATA_SIZE - b->size);
+        int64_t k = std::min<int64_t>(n, b->capacity - b->size);
 
         memcpy(b->data + b->size, p, k);
         b->size += k;
@@ -89,6 +119,24 @@ size_t write_message_t::size() const {
     return ret;
 }
 
+void write_message_t::prepend(const void *p, int64_t n) {
+    if (n == 0) {
+        return;
+    }
+    guarantee(n <= write_buffer_t::MAX_CAPACITY);
+    write_buffer_t *b = write_buffer_t::create(n);
+    memcpy(b->data, p, n);
+    b->size = n;
+    buffers_.push_front(b);
+}
+
+void write_message_t::copy_to(char *out) const {
+    for (write_buffer_t *h = buffers_.head(); h != nullptr; h = buffers_.next(h)) {
+        memcpy(out, h->data, h->size);
+        out += h->size;
+    }
+}
+
 int send_write_message(write_stream_t *s, const write_message_t *wm) {
     intrusive_list_t<write_buffer_t> *list = const_cast<write_message_t *>(wm)->unsafe_expose_buffers();
     for (write_buffer_t *p = list->head(); p; p = list->next(p)) {
@@ -91,15 +91,25 @@ private:
     DISABLE_COPYING(write_stream_t);
 };
 
+// A buffer of `capacity` bytes, allocated along with the buffer itself.  A
+// `write_message_t` starts with a small one and makes every next one twice as big,
+// up to `MAX_CAPACITY`, so large messages don't take an allocation per 4 KB.
 class write_buffer_t : public intrusive_list_node_t<write_buffer_t> {
 public:
-    write_buffer_t() : size(0) { }
+    static const int INITIAL_CAPACITY = 4096;
+    static const int MAX_CAPACITY = 1024 * 1024;
+
+    static write_buffer_t *create(int capacity);
+    static void destroy(write_buffer_t *buffer);
 
-    static const int DATA_SIZE = 4096;
     int size;
-    char data[DATA_SIZE];
+    const int capacity;
+    char *const data;
 
 private:
+    explicit write_buffer_t(int _capacity);
+    ~write_buffer_t() { }
+
     DISABLE_COPYING(write_buffer_t);
 };
 
@@ -117,8 +127,15 @@ public:
 
     void append(const void *p, int64_t n);
 
+    // Puts `n` bytes in front of what has been appended so far, for headers whose
+    // contents depend on the rest of the message.
+    void prepend(const void *p, int64_t n);
+
     size_t size() const;
 
+    // Copies the message to `out`, which must have room for `size()` bytes.
+    void copy_to(char *out) const;
+
     intrusive_list_t<write_buffer_t> *unsafe_expose_buffers() { return &buffers_; }
 
 private:
@@ -142,6 +159,12 @@ struct serialized_size_t;
 template <class T>
 struct serialize_universal_size_t;
 
+// True for the types whose serialization is their raw bytes, in every cluster
+// version.  Arrays of them are serialized with a single `append`, see the
+// serialization of `std::vector<T>`.
+template <class T>
+struct is_raw_serializable_t : public std::false_type { };
+
 // Makes typ1 serializable, sending a typ2 over the wire.  Has range
 // checking on the closed interval [lo, hi] when deserializing.
 #define ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(typ1, typ2, lo, hi)       \
@@ -221,6 +244,9 @@ struct serialize_universal_size_t;
     }                                                                   \
                                                                         \
     template <>                                                         \
+    struct is_raw_serializable_t<typ>                                   \
+        : public std::true_type { }; /* NOLINT(readability/braces) */  \
+    template <>                                                         \
     struct serialized_size_t<typ>                                       \
         : public std::integral_constant<size_t, sizeof(typ)> { }; /* NOLINT(readability/braces) */       \
     template <>                                                         \
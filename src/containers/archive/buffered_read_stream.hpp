@@ -0,0 +1,50 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CONTAINERS_ARCHIVE_BUFFERED_READ_STREAM_HPP_
+#define CONTAINERS_ARCHIVE_BUFFERED_READ_STREAM_HPP_
+
+#include <string.h>
+
+#include "containers/archive/archive.hpp"
+#include "containers/scoped.hpp"
+
+// Reads from another stream in chunks of up to `BUFFER_SIZE` bytes. Deserializing a
+// message reads it a few bytes at a time, which for a socket would otherwise mean a
+// system call for every single field. Data that has been read ahead is only kept in
+// this object, so everything must be read through it for as long as it exists.
+class buffered_read_stream_t : public read_stream_t {
+public:
+    static const int64_t BUFFER_SIZE = 64 * 1024;
+
+    explicit buffered_read_stream_t(read_stream_t *inner)
+        : inner_(inner), buf_(BUFFER_SIZE), pos_(0), end_(0) { }
+    virtual ~buffered_read_stream_t() { }
+
+    virtual MUST_USE int64_t read(void *p, int64_t n) {
+        if (pos_ == end_) {
+            // Large reads bypass the buffer, so we don't copy their data twice.
+            if (n >= BUFFER_SIZE) {
+                return inner_->read(p, n);
+            }
+            int64_t res = inner_->read(buf_.data(), BUFFER_SIZE);
+            if (res <= 0) {
+                return res;
+            }
+            pos_ = 0;
+            end_ = res;
+        }
+        int64_t num_to_read = n < end_ - pos_ ? n : end_ - pos_;
+        memcpy(p, buf_.data() + pos_, num_to_read);
+        pos_ += num_to_read;
+        return num_to_read;
+    }
+
+private:
+    read_stream_t *inner_;
+    scoped_array_t<char> buf_;
+    int64_t pos_;
+    int64_t end_;
+
+    DISABLE_COPYING(buffered_read_stream_t);
+};
+
+#endif  // CONTAINERS_ARCHIVE_BUFFERED_READ_STREAM_HPP_
@@ -40,7 +40,7 @@ inline MUST_USE archive_result_t deserialize_cluster_version(
         crash("Outdated index handling did not crash or throw.");
     } else {
         if (raw >= static_cast<int8_t>(cluster_version_t::v1_14)
-            && raw <= static_cast<int8_t>(cluster_version_t::v2_5)) {
+            && raw <= static_cast<int8_t>(cluster_version_t::v2_6)) {
             *thing = static_cast<cluster_version_t>(raw);
         } else {
             throw archive_exc_t{"Unrecognized cluster serialization version."};
@@ -113,8 +113,10 @@ archive_result_t deserialize_for_version(cluster_version_t version,
         return deserialize<cluster_version_t::v2_3>(s, thing);
     case cluster_version_t::v2_4:
         return deserialize<cluster_version_t::v2_4>(s, thing);
-    case cluster_version_t::v2_5_is_latest:
-        return deserialize<cluster_version_t::v2_5_is_latest>(s, thing);
+    case cluster_version_t::v2_5:
+        return deserialize<cluster_version_t::v2_5>(s, thing);
+    case cluster_version_t::v2_6_is_latest:
+        return deserialize<cluster_version_t::v2_6_is_latest>(s, thing);
     default:
         unreachable("deserialize_for_version: unsupported cluster version");
     }
@@ -145,8 +147,10 @@ size_t serialized_size_for_version(cluster_version_t version,
         return serialized_size<cluster_version_t::v2_3>(thing);
     case cluster_version_t::v2_4:
         return serialized_size<cluster_version_t::v2_4>(thing);
-    case cluster_version_t::v2_5_is_latest:
-        return serialized_size<cluster_version_t::v2_5_is_latest>(thing);
+    case cluster_version_t::v2_5:
+        return serialized_size<cluster_version_t::v2_5>(thing);
+    case cluster_version_t::v2_6_is_latest:
+        return serialized_size<cluster_version_t::v2_6_is_latest>(thing);
     default:
         unreachable("serialize_size_for_version: unsupported version");
     }
@@ -202,7 +206,9 @@ size_t serialized_size_for_version(cluster_version_t version,
             read_stream_t *, typ *);                                             \
     template archive_result_t deserialize<cluster_version_t::v2_4>(              \
             read_stream_t *, typ *);                                             \
-    template archive_result_t deserialize<cluster_version_t::v2_5_is_latest>(    \
+    template archive_result_t deserialize<cluster_version_t::v2_5>(              \
+            read_stream_t *, typ *);                                             \
+    template archive_result_t deserialize<cluster_version_t::v2_6_is_latest>(    \
             read_stream_t *, typ *)
 
 #define INSTANTIATE_SERIALIZABLE_SINCE_v1_13(typ)        \
@@ -222,7 +228,9 @@ size_t serialized_size_for_version(cluster_version_t version,
             read_stream_t *, typ *);                                             \
     template archive_result_t deserialize<cluster_version_t::v2_4>(              \
             read_stream_t *, typ *);                                             \
-    template archive_result_t deserialize<cluster_version_t::v2_5_is_latest>(    \
+    template archive_result_t deserialize<cluster_version_t::v2_5>(              \
+            read_stream_t *, typ *);                                             \
+    template archive_result_t deserialize<cluster_version_t::v2_6_is_latest>(    \
             read_stream_t *, typ *)
 
 #define INSTANTIATE_SERIALIZABLE_SINCE_v1_16(typ)        \
@@ -238,7 +246,9 @@ size_t serialized_size_for_version(cluster_version_t version,
             read_stream_t *, typ *);                                             \
     template archive_result_t deserialize<cluster_version_t::v2_4>(              \
             read_stream_t *, typ *);                                             \
-    template archive_result_t deserialize<cluster_version_t::v2_5_is_latest>(    \
+    template archive_result_t deserialize<cluster_version_t::v2_5>(              \
+            read_stream_t *, typ *);                                             \
+    template archive_result_t deserialize<cluster_version_t::v2_6_is_latest>(    \
             read_stream_t *, typ *)
 
 #define INSTANTIATE_SERIALIZABLE_SINCE_v2_1(typ)         \
@@ -252,7 +262,9 @@ size_t serialized_size_for_version(cluster_version_t version,
             read_stream_t *, typ *);                                             \
     template archive_result_t deserialize<cluster_version_t::v2_4>(              \
             read_stream_t *, typ *);                                             \
-    template archive_result_t deserialize<cluster_version_t::v2_5_is_latest>(    \
+    template archive_result_t deserialize<cluster_version_t::v2_5>(              \
+            read_stream_t *, typ *);                                             \
+    template archive_result_t deserialize<cluster_version_t::v2_6_is_latest>(    \
             read_stream_t *, typ *)
 
 #define INSTANTIATE_SERIALIZABLE_SINCE_v2_2(typ)         \
@@ -264,7 +276,9 @@ size_t serialized_size_for_version(cluster_version_t version,
             read_stream_t *, typ *);                                             \
     template archive_result_t deserialize<cluster_version_t::v2_4>(              \
             read_stream_t *, typ *);                                             \
-    template archive_result_t deserialize<cluster_version_t::v2_5_is_latest>(    \
+    template archive_result_t deserialize<cluster_version_t::v2_5>(              \
+            read_stream_t *, typ *);                                             \
+    template archive_result_t deserialize<cluster_version_t::v2_6_is_latest>(    \
             read_stream_t *, typ *)
 
 #define INSTANTIATE_SERIALIZABLE_SINCE_v2_3(typ)         \
@@ -274,7 +288,9 @@ size_t serialized_size_for_version(cluster_version_t version,
 #define INSTANTIATE_DESERIALIZE_SINCE_v2_4(typ)                         \
     template archive_result_t deserialize<cluster_version_t::v2_4>(     \
             read_stream_t *, typ *);                                    \
-    template archive_result_t deserialize<cluster_version_t::v2_5_is_latest>( \
+    template archive_result_t deserialize<cluster_version_t::v2_5>(     \
+            read_stream_t *, typ *);                                    \
+    template archive_result_t deserialize<cluster_version_t::v2_6_is_latest>( \
             read_stream_t *, typ *)
 
 #define INSTANTIATE_SERIALIZABLE_SINCE_v2_4(typ)         \
@@ -282,13 +298,23 @@ size_t serialized_size_for_version(cluster_version_t version,
     INSTANTIATE_DESERIALIZE_SINCE_v2_4(typ)
 
 #define INSTANTIATE_DESERIALIZE_SINCE_v2_5(typ)                         \
-    template archive_result_t deserialize<cluster_version_t::v2_5_is_latest>( \
-            read_stream_t *, typ *);
+    template archive_result_t deserialize<cluster_version_t::v2_5>(     \
+            read_stream_t *, typ *);                                    \
+    template archive_result_t deserialize<cluster_version_t::v2_6_is_latest>( \
+            read_stream_t *, typ *)
 
 #define INSTANTIATE_SERIALIZABLE_SINCE_v2_5(typ) \
     INSTANTIATE_SERIALIZE_FOR_CLUSTER_AND_DISK(typ); \
     INSTANTIATE_DESERIALIZE_SINCE_v2_5(typ)
 
+#define INSTANTIATE_DESERIALIZE_SINCE_v2_6(typ)                         \
+    template archive_result_t deserialize<cluster_version_t::v2_6_is_latest>( \
+            read_stream_t *, typ *)
+
+#define INSTANTIATE_SERIALIZABLE_SINCE_v2_6(typ) \
+    INSTANTIATE_SERIALIZE_FOR_CLUSTER_AND_DISK(typ); \
+    INSTANTIATE_DESERIALIZE_SINCE_v2_6(typ)
+
 #define INSTANTIATE_SERIALIZABLE_FOR_CLUSTER(typ)                      \
     INSTANTIATE_SERIALIZE_FOR_CLUSTER(typ);                            \
     template archive_result_t deserialize<cluster_version_t::CLUSTER>( \
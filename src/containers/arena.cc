@@ -0,0 +1,78 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "containers/arena.hpp"
+
+#include <stdlib.h>
+
+#include <algorithm>
+
+#include "memory_utils.hpp"
+
+arena_t::arena_t()
+    : chunks(nullptr),
+      chunk_position(nullptr),
+      chunk_end(nullptr),
+      next_chunk_size(FIRST_CHUNK_SIZE) {
+    for (size_t i = 0; i < sizeof(free_lists) / sizeof(free_lists[0]); ++i) {
+        free_lists[i] = nullptr;
+    }
+}
+
+arena_t::~arena_t() {
+    while (chunks != nullptr) {
+        chunk_t *next = chunks->next;
+        ::free(chunks);
+        chunks = next;
+    }
+}
+
+void *arena_t::allocate(size_t size) {
+    if (size > MAX_BLOCK_SIZE) {
+        return ::rmalloc(size);
+    }
+    const size_t cls = size_class(size);
+    if (free_lists[cls] != nullptr) {
+        free_block_t *block = free_lists[cls];
+        free_lists[cls] = block->next;
+        return block;
+    }
+    const size_t rounded_size = std::max<size_t>(cls, 1) * ALIGNMENT;
+    if (static_cast<size_t>(chunk_end - chunk_position) < rounded_size) {
+        return allocate_from_new_chunk(rounded_size);
+    }
+    void *res = chunk_position;
+    chunk_position += rounded_size;
+    return res;
+}
+
+void arena_t::deallocate(void *ptr, size_t size) {
+    if (size > MAX_BLOCK_SIZE) {
+        ::free(ptr);
+        return;
+    }
+    const size_t cls = size_class(size);
+    free_block_t *block = static_cast<free_block_t *>(ptr);
+    block->next = free_lists[cls];
+    free_lists[cls] = block;
+}
+
+void *arena_t::allocate_from_new_chunk(size_t rounded_size) {
+    // The rest of the current chunk is wasted, which is at most `MAX_BLOCK_SIZE`
+    // bytes per chunk.  The chunk header takes up `ALIGNMENT` bytes so that the
+    // blocks after it stay aligned.
+    CT_ASSERT(sizeof(chunk_t) <= ALIGNMENT);
+    const size_t chunk_size = next_chunk_size;
+    if (next_chunk_size < MAX_CHUNK_SIZE) {
+        next_chunk_size *= 2;
+    }
+
+    chunk_t *chunk = static_cast<chunk_t *>(::rmalloc(chunk_size));
+    chunk->next = chunks;
+    chunks = chunk;
+    chunk_position = reinterpret_cast<char *>(chunk) + ALIGNMENT;
+    chunk_end = reinterpret_cast<char *>(chunk) + chunk_size;
+
+    guarantee(static_cast<size_t>(chunk_end - chunk_position) >= rounded_size);
+    void *res = chunk_position;
+    chunk_position += rounded_size;
+    return res;
+}
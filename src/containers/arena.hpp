@@ -0,0 +1,91 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef CONTAINERS_ARENA_HPP_
+#define CONTAINERS_ARENA_HPP_
+
+#include <stddef.h>
+
+#include "config/args.hpp"
+#include "errors.hpp"
+
+/* `arena_t` hands out small blocks of memory carved from a few large chunks, and
+returns all of them to the heap at once when it is destroyed.  Blocks that are freed
+before that go on a free list for their size and get reused, so a container that keeps
+inserting and erasing elements doesn't make the arena grow without bound.  Blocks
+larger than `MAX_BLOCK_SIZE` come straight from the heap.
+
+An arena must outlive everything allocated from it, and isn't thread-safe.  It is meant
+for short-lived scratch containers, like the `std::map` in `datum_object_builder_t`,
+which would otherwise make one heap allocation per element. */
+class arena_t {
+public:
+    arena_t();
+    ~arena_t();
+
+    void *allocate(size_t size);
+    // `size` must be the size that `ptr` was allocated with.
+    void deallocate(void *ptr, size_t size);
+
+    static const size_t ALIGNMENT = 16;
+    static const size_t MAX_BLOCK_SIZE = 256;
+
+private:
+    static const size_t FIRST_CHUNK_SIZE = KILOBYTE;
+    static const size_t MAX_CHUNK_SIZE = 64 * KILOBYTE;
+
+    struct free_block_t {
+        free_block_t *next;
+    };
+
+    struct chunk_t {
+        chunk_t *next;
+    };
+
+    static size_t size_class(size_t size) {
+        return (size + ALIGNMENT - 1) / ALIGNMENT;
+    }
+
+    void *allocate_from_new_chunk(size_t rounded_size);
+
+    chunk_t *chunks;
+    char *chunk_position;
+    char *chunk_end;
+    size_t next_chunk_size;
+    free_block_t *free_lists[MAX_BLOCK_SIZE / ALIGNMENT + 1];
+
+    DISABLE_COPYING(arena_t);
+};
+
+/* A standard library allocator that allocates from an `arena_t`. */
+template <class T>
+class arena_allocator_t {
+public:
+    typedef T value_type;
+
+    explicit arena_allocator_t(arena_t *_arena) : arena(_arena) { }
+    template <class U>
+    arena_allocator_t(const arena_allocator_t<U> &other)  // NOLINT(runtime/explicit)
+        : arena(other.arena) { }
+
+    T *allocate(size_t n) {
+        return static_cast<T *>(arena->allocate(n * sizeof(T)));
+    }
+    void deallocate(T *ptr, size_t n) {
+        arena->deallocate(ptr, n * sizeof(T));
+    }
+
+    template <class U>
+    bool operator==(const arena_allocator_t<U> &other) const {
+        return arena == other.arena;
+    }
+    template <class U>
+    bool operator!=(const arena_allocator_t<U> &other) const {
+        return arena != other.arena;
+    }
+
+private:
+    template <class U> friend class arena_allocator_t;
+
+    arena_t *arena;
+};
+
+#endif  // CONTAINERS_ARENA_HPP_
@@ -50,11 +50,13 @@ private:
     template <class, size_t>
     friend class backindex_bag_t;
 
-    static const size_t NOT_IN_A_BAG = SIZE_MAX;
+    static const uint32_t NOT_IN_A_BAG = UINT32_MAX;
 
     // The item's index into a (specific) backindex_bag_t, or NOT_IN_A_BAG if it
-    // doesn't belong to the backindex_bag_t.
-    size_t index_;
+    // doesn't belong to the backindex_bag_t.  32 bits, because the buffer cache has
+    // one of these in the metadata of every page, and no bag gets anywhere near 2^32
+    // elements.
+    uint32_t index_;
 
     DISABLE_COPYING(backindex_bag_index_t);
 };
@@ -90,9 +92,9 @@ public:
         rassert(backindex->index_ != backindex_bag_index_t::NOT_IN_A_BAG);
         guarantee(backindex->index_ < vector_.size(),
                   "early index has wrong value: index=%zu, size=%zu",
-                  backindex->index_, vector_.size());
+                  static_cast<size_t>(backindex->index_), vector_.size());
 
-        const size_t index = backindex->index_;
+        const uint32_t index = backindex->index_;
 
         // Move the element in the last position to the removed element's position.
         // The code here feels weird when back_element == element (i.e. when
@@ -105,7 +107,7 @@ public:
         rassert(back_element_backindex->index_ == vector_.size() - 1,
                 "bag %p: index %p has wrong value: index_ = %zu, size = %zu",
                 this, back_element_backindex,
-                back_element_backindex->index_, vector_.size());
+                static_cast<size_t>(back_element_backindex->index_), vector_.size());
 
         back_element_backindex->index_ = index;
         vector_[index] = back_element;
@@ -121,8 +123,9 @@ public:
             = access_backindex(element);
         guarantee(backindex->index_ == backindex_bag_index_t::NOT_IN_A_BAG,
                   "bag %p, backindex = %p", this, backindex);
+        guarantee(vector_.size() < backindex_bag_index_t::NOT_IN_A_BAG);
 
-        backindex->index_ = vector_.size();
+        backindex->index_ = static_cast<uint32_t>(vector_.size());
         vector_.push_back(element);
     }
 
@@ -252,8 +252,7 @@ inline void counted_release(const slow_atomic_countable_t<T> *p) {
 
 template <class T>
 inline intptr_t counted_use_count(const slow_atomic_countable_t<T> *p) {
-    // Finally a practical use for volatile.
-    intptr_t tmp = static_cast<const volatile intptr_t&>(p->refcount_);
+    intptr_t tmp = p->refcount_.load();
     rassert(tmp > 0);
     return tmp;
 }
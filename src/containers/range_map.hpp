@@ -162,9 +162,12 @@ public:
             return;
         }
         bool empty_before = empty_domain();
-        zones.insert(
-            std::make_move_iterator(other.zones.begin()),
-            std::make_move_iterator(other.zones.end()));
+        /* All of `other`'s zones go after ours, so inserting them with `end()` as the
+        hint takes amortized constant time per zone. This makes building a
+        `range_map_t` from left to right (as `map()` and `mask()` do) linear. */
+        for (auto &&pair : other.zones) {
+            zones.emplace_hint(zones.end(), pair.first, std::move(pair.second));
+        }
         if (!empty_before) {
             coalesce_at(other.left);
         }
@@ -180,7 +183,7 @@ public:
             return;
         }
         bool empty_before = empty_domain();
-        zones.insert(std::make_pair(r, std::move(v)));
+        zones.emplace_hint(zones.end(), r, std::move(v));
         if (!empty_before) {
             coalesce_at(l);
         }
@@ -195,9 +198,11 @@ public:
             return;
         }
         bool empty_before = empty_domain();
-        zones.insert(
-            std::make_move_iterator(other.zones.begin()),
-            std::make_move_iterator(other.zones.end()));
+        /* Likewise, all of `other`'s zones go before ours. */
+        auto hint = zones.begin();
+        for (auto &&pair : other.zones) {
+            zones.emplace_hint(hint, pair.first, std::move(pair.second));
+        }
         if (!empty_before) {
             coalesce_at(left);
         }
@@ -211,7 +216,7 @@ public:
             return;
         }
         bool empty_before = empty_domain();
-        zones.insert(std::make_pair(r, std::move(v)));
+        zones.emplace_hint(zones.begin(), r, std::move(v));
         if (!empty_before) {
             coalesce_at(r);
         }
@@ -254,10 +259,12 @@ public:
         }
         zones.erase(zones.upper_bound(other.left_edge()), end);
 
-        /* Move all the zones from `other` into us */
-        zones.insert(
-            std::make_move_iterator(other.zones.begin()),
-            std::make_move_iterator(other.zones.end()));
+        /* Move all the zones from `other` into us. They all go right before `end`, so
+        with it as the hint each insertion takes amortized constant time instead of a
+        search from the root. */
+        for (auto &&pair : other.zones) {
+            zones.emplace_hint(end, pair.first, std::move(pair.second));
+        }
 
         /* Coalesce adjacent zones if appropriate */
         if (left_edge() != other.left_edge()) {
@@ -3,6 +3,7 @@
 
 #include <stdlib.h>
 
+#include "perfmon/memory_usage.hpp"
 #include "utils.hpp"
 
 counted_t<shared_buf_t> shared_buf_t::create(size_t size) {
@@ -12,9 +13,15 @@ counted_t<shared_buf_t> shared_buf_t::create(size_t size) {
     shared_buf_t *result = static_cast<shared_buf_t *>(raw_result);
     result->refcount_ = 0;
     result->size_ = size;
+    add_memory_usage(memory_usage_category_t::QUERY_DATUMS, memory_size);
     return counted_t<shared_buf_t>(result);
 }
 
+shared_buf_t::~shared_buf_t() {
+    add_memory_usage(memory_usage_category_t::QUERY_DATUMS,
+                     -static_cast<int64_t>(sizeof(shared_buf_t) + size_ - 1));
+}
+
 void shared_buf_t::operator delete(void *p) {
     ::free(p);
 }
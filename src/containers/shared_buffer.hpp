@@ -9,10 +9,12 @@
 
 /* A `shared_buffer_t` is a reference counted binary buffer.
 You can have multiple `shared_buf_ref_t`s pointing to different offsets in
-the same `shared_buffer_t`. */
+the same `shared_buffer_t`. Since they mostly hold datums, their memory is reported
+as the `query_datums` memory usage (see perfmon/memory_usage.hpp). */
 class shared_buf_t {
 public:
     shared_buf_t() = delete;
+    ~shared_buf_t();
 
     static counted_t<shared_buf_t> create(size_t _size);
     static void operator delete(void *p);
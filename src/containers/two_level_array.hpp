@@ -36,6 +36,7 @@ private:
         value_t values[CHUNK_SIZE];
     };
     std::vector<chunk_t *> chunks;
+    size_t num_chunks;
 
     static size_t chunk_for_key(size_t key) {
         size_t chunk_id = key / CHUNK_SIZE;
@@ -46,7 +47,7 @@ private:
     }
 
 public:
-    two_level_array_t() { }
+    two_level_array_t() : num_chunks(0) { }
     ~two_level_array_t() {
         for (auto it = chunks.begin(); it != chunks.end(); ++it) {
             delete *it;
@@ -72,6 +73,7 @@ public:
                     chunks.resize(chunk_id + 1, nullptr);
                 }
                 chunks[chunk_id] = new chunk_t;
+                ++num_chunks;
             }
         }
 
@@ -88,12 +90,18 @@ public:
         if (chunk->count == 0) {
             chunks[chunk_id] = nullptr;
             delete chunk;
+            --num_chunks;
 
             while (!chunks.empty() && chunks.back() == nullptr) {
                 chunks.pop_back();
             }
         }
     }
+
+    // The number of bytes the array has allocated.
+    size_t memory_usage() const {
+        return chunks.capacity() * sizeof(chunk_t *) + num_chunks * sizeof(chunk_t);
+    }
 };
 
 #endif // CONTAINERS_TWO_LEVEL_ARRAY_HPP_
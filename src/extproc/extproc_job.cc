@@ -15,11 +15,15 @@ extproc_job_t::extproc_job_t(extproc_pool_t *_pool,
         combined_interruptor.add(user_interruptor);
     }
 
+    ticks_t start_ticks = get_ticks();
     worker_lock.create(pool->get_worker_semaphore(), &combined_interruptor);
 
     try {
         worker_lock.get()->get_value()->acquired(&combined_interruptor);
-        extproc_pool_t::worker_acq_t worker_acq(pool);
+        // The pool uses the time spent waiting for a worker (including spawning its
+        //  process) to decide whether to keep more processes around
+        ticks_t wait_ticks = { get_ticks().nanos - start_ticks.nanos };
+        worker_acq.create(pool, wait_ticks);
         worker_lock.get()->get_value()->run_job(worker_fn);
     } catch (...) {
         user_error = true;
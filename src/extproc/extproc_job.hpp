@@ -10,8 +10,7 @@
 #include "concurrency/wait_any.hpp"
 #include "concurrency/cross_thread_semaphore.hpp"
 #include "containers/object_buffer.hpp"
-
-class extproc_pool_t;
+#include "extproc/extproc_pool.hpp"
 class extproc_worker_t;
 
 // Error that may be thrown when something goes wrong with a worker
@@ -48,6 +47,9 @@ private:
     signal_t *user_interruptor;
     wait_any_t combined_interruptor;
     object_buffer_t<cross_thread_semaphore_t<extproc_worker_t>::lock_t> worker_lock;
+    // Declared after `worker_lock` so that the worker stops counting as busy before
+    //  it goes back to the semaphore
+    object_buffer_t<extproc_pool_t::worker_acq_t> worker_acq;
 };
 
 #endif /* EXTPROC_EXTPROC_JOB_HPP_ */
@@ -1,16 +1,31 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
-#include "containers/object_buffer.hpp"
 #include "extproc/extproc_pool.hpp"
+
+#include <algorithm>
+
+#include "config/args.hpp"
+#include "extproc/extproc_job.hpp"
 #include "extproc/extproc_spawner.hpp"
 
+// Runs in a freshly spawned worker process so that it is ready before a real job
+//  needs it
+bool worker_warm_up_fn(read_stream_t *, write_stream_t *) {
+    return true;
+}
+
 extproc_pool_t::extproc_pool_t(size_t worker_count) :
     ct_interruptors(&interruptor),
-    worker_cnt(0),
-    prev_worker_cnt(0),
-    dealloc_timer(DEALLOC_TIMER_FREQ_MS, this),
+    max_worker_cnt(static_cast<int>(worker_count)),
+    busy_worker_cnt(0),
+    peak_busy_worker_cnt(0),
+    live_worker_cnt(0),
+    delayed_job_cnt(0),
+    spare_worker_cnt(MIN_SPARE_WORKERS),
+    rebalance_timer(REBALANCE_TIMER_FREQ_MS, this),
     worker_semaphore(worker_count,
-                     extproc_spawner_t::get_instance()),
-    dealloc_pumper([this](signal_t *interruptor_) { dealloc_blocking(interruptor_); })
+                     extproc_spawner_t::get_instance(),
+                     this),
+    rebalance_pumper([this](signal_t *interruptor_) { rebalance_blocking(interruptor_); })
     { }
 
 extproc_pool_t::~extproc_pool_t() {
@@ -30,32 +45,91 @@ signal_t *extproc_pool_t::get_shutdown_signal() {
 }
 
 void extproc_pool_t::on_ring() {
-    dealloc_pumper.notify();
+    rebalance_pumper.notify();
 }
 
-void extproc_pool_t::dealloc_blocking(UNUSED signal_t *interruptor_) {
-    int cur_worker_cnt = worker_cnt;
-    int dealloc_cnt = (prev_worker_cnt - cur_worker_cnt) / 2;
-    prev_worker_cnt = cur_worker_cnt;
+void extproc_pool_t::rebalance_blocking(signal_t *interruptor_) {
+    int busy_cnt = busy_worker_cnt;
+    int peak_cnt = peak_busy_worker_cnt.exchange(busy_cnt);
+    int delayed_cnt = delayed_job_cnt.exchange(0);
 
-    for (int i = 0; i < dealloc_cnt; ++i) {
-        object_buffer_t<cross_thread_semaphore_t<extproc_worker_t>::lock_t> worker_lock;
-        worker_lock.create(get_worker_semaphore(), get_shutdown_signal());
+    // Be generous with spares after jobs had to wait, and slowly give them back
+    if (delayed_cnt > 0) {
+        spare_worker_cnt = std::min(spare_worker_cnt * 2, max_worker_cnt);
+    } else if (spare_worker_cnt > MIN_SPARE_WORKERS) {
+        --spare_worker_cnt;
+    }
+
+    int target_cnt = std::min(std::max(peak_cnt, busy_cnt) + spare_worker_cnt,
+                              max_worker_cnt);
+    int live_cnt = live_worker_cnt;
 
-        if (worker_lock.get()->get_value()->is_process_alive()) {
-            worker_lock.get()->get_value()->kill_process();
+    if (live_cnt < target_cnt) {
+        // Spawn the missing processes by running an empty job in workers without one
+        for (int i = live_cnt; i < target_cnt; ++i) {
+            cross_thread_semaphore_t<extproc_worker_t>::lock_t worker_lock(
+                get_worker_semaphore(), interruptor_,
+                [](const extproc_worker_t *w) { return !w->is_process_alive(); });
+            extproc_worker_t *worker = worker_lock.get_value();
+            if (worker->is_process_alive()) {
+                // All idle workers are already running
+                break;
+            }
+
+            bool errored = false;
+            try {
+                worker->acquired(interruptor_);
+                worker->run_job(&worker_warm_up_fn);
+            } catch (const extproc_worker_exc_t &) {
+                errored = true;
+            } catch (const interrupted_exc_t &) {
+                worker->released(true, interruptor_);
+                throw;
+            }
+            worker->released(errored, interruptor_);
+            if (errored) {
+                break;
+            }
+        }
+    } else if (live_cnt > target_cnt) {
+        // Kill half of the surplus idle processes at a time, in case the load picks up
+        //  again
+        int dealloc_cnt = (live_cnt - target_cnt + 1) / 2;
+        for (int i = 0; i < dealloc_cnt; ++i) {
+            cross_thread_semaphore_t<extproc_worker_t>::lock_t worker_lock(
+                get_worker_semaphore(), interruptor_,
+                [](const extproc_worker_t *w) { return w->is_process_alive(); });
+            extproc_worker_t *worker = worker_lock.get_value();
+            if (!worker->is_process_alive()) {
+                // No idle worker is running anything
+                break;
+            }
+            worker->kill_process();
         }
     }
 }
 
-void extproc_pool_t::on_worker_acquired()
-{
-    ++worker_cnt;
+void extproc_pool_t::on_worker_acquired(ticks_t wait_ticks) {
+    int busy_cnt = ++busy_worker_cnt;
+    int peak_cnt = peak_busy_worker_cnt;
+    while (busy_cnt > peak_cnt &&
+           !peak_busy_worker_cnt.compare_exchange_weak(peak_cnt, busy_cnt)) { }
+
+    if (wait_ticks.nanos >= DELAYED_JOB_THRESHOLD_MS * MILLION) {
+        ++delayed_job_cnt;
+    }
 }
 
-void extproc_pool_t::on_worker_released()
-{
-    --worker_cnt;
+void extproc_pool_t::on_worker_released() {
+    --busy_worker_cnt;
+}
+
+void extproc_pool_t::on_worker_spawned() {
+    ++live_worker_cnt;
+}
+
+void extproc_pool_t::on_worker_killed() {
+    --live_worker_cnt;
 }
 
 extproc_pool_t::ct_interruptors_t::ct_interruptors_t(signal_t *shutdown_signal) :
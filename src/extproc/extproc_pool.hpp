@@ -5,6 +5,7 @@
 #include <atomic>
 
 #include "arch/timing.hpp"
+#include "time.hpp"
 #include "utils.hpp"
 #include "containers/scoped.hpp"
 #include "concurrency/cond_var.hpp"
@@ -15,6 +16,13 @@
 
 // Extproc pool is used to acquire and release workers from any thread,
 //  must be created from within the thread pool
+//
+// The pool has room for `worker_count` workers, but only keeps as many worker
+//  processes running as recent load calls for.  Every `REBALANCE_TIMER_FREQ_MS` it
+//  compares the number of running processes against the peak number of busy workers
+//  since the last check plus a number of warm spares, spawning processes ahead of
+//  time or killing idle ones to match.  The number of spares doubles whenever jobs
+//  had to wait for a worker, and decays again while the load is steady.
 class extproc_pool_t : public home_thread_mixin_t,
                        public repeating_timer_callback_t {
 public:
@@ -28,10 +36,11 @@ public:
     // Get the semaphore of workers to obtain a lock (may be done from any thread)
     cross_thread_semaphore_t<extproc_worker_t> *get_worker_semaphore();
 
+    // Constructed by a job for as long as it holds a worker
     class worker_acq_t {
     public:
-        explicit worker_acq_t(extproc_pool_t *_pool) : pool(_pool) {
-            pool->on_worker_acquired();
+        worker_acq_t(extproc_pool_t *_pool, ticks_t wait_ticks) : pool(_pool) {
+            pool->on_worker_acquired(wait_ticks);
         }
         ~worker_acq_t() {
             pool->on_worker_released();
@@ -42,6 +51,8 @@ public:
     };
 
 private:
+    friend class extproc_worker_t;
+
     // The interruptor to be pulsed when shutting down
     cond_t interruptor;
 
@@ -55,33 +66,49 @@ private:
         scoped_array_t<scoped_ptr_t<cross_thread_signal_t> > ct_signals;
     } ct_interruptors;
 
-    // Worker counters for the deallocation window.
-	std::atomic<int> worker_cnt;
-	int prev_worker_cnt;
+    const int max_worker_cnt;
+
+    // Worker counters, updated from any thread.  `peak_busy_worker_cnt` and
+    //  `delayed_job_cnt` are reset by every rebalance.
+    std::atomic<int> busy_worker_cnt;
+    std::atomic<int> peak_busy_worker_cnt;
+    std::atomic<int> live_worker_cnt;
+    std::atomic<int> delayed_job_cnt;
+
+    // The number of idle worker processes to keep around, only used by the rebalance
+    int spare_worker_cnt;
 
     // Acquire / Release worker notifications.
-    void on_worker_acquired();
+    void on_worker_acquired(ticks_t wait_ticks);
     void on_worker_released();
 
-    // Timer to trigger worker deallocation.
-    repeating_timer_t dealloc_timer;
-    static const int64_t DEALLOC_TIMER_FREQ_MS = 2000;
+    // Worker process notifications, from `extproc_worker_t`
+    void on_worker_spawned();
+    void on_worker_killed();
+
+    // Jobs that waited at least this long for their worker count as delayed
+    static const int64_t DELAYED_JOB_THRESHOLD_MS = 10;
+    static const int MIN_SPARE_WORKERS = 1;
+
+    // Timer to trigger rebalancing.
+    repeating_timer_t rebalance_timer;
+    static const int64_t REBALANCE_TIMER_FREQ_MS = 2000;
 
-    // Worker deallocation timer callback.
+    // Rebalance timer callback.
     void on_ring();
 
-    // Callback that handles worker deallocations in a coro pool, so we don't block the
-    // timer callback or have multiple deallocations happening at once
-    void dealloc_blocking(UNUSED signal_t *interruptor);
+    // Callback that spawns or kills worker processes in a coro pool, so we don't block
+    // the timer callback or have multiple rebalances happening at once
+    void rebalance_blocking(signal_t *interruptor);
 
     // Cross-threaded semaphore allowing workers to be acquired from any thread
     cross_thread_semaphore_t<extproc_worker_t> worker_semaphore;
 
-    // This `pump_coro_t` spawns `dealloc_blocking()` on request, making sure that there
-    // are never two copies running at once. Destructor order is important:
-    // `dealloc_pumper` must be destroyed before everything else because it stops
-    // `dealloc_blocking()`.
-    pump_coro_t dealloc_pumper;
+    // This `pump_coro_t` spawns `rebalance_blocking()` on request, making sure that
+    // there are never two copies running at once. Destructor order is important:
+    // `rebalance_pumper` must be destroyed before everything else because it stops
+    // `rebalance_blocking()`.
+    pump_coro_t rebalance_pumper;
 };
 
 #endif /* EXTPROC_EXTPROC_POOL_HPP_ */
@@ -15,6 +15,7 @@
 #include "extproc/extproc_spawner.hpp"
 #include "extproc/extproc_worker.hpp"
 #include "arch/fd_send_recv.hpp"
+#include "containers/archive/buffered_read_stream.hpp"
 #include "utils.hpp"
 
 extproc_spawner_t *extproc_spawner_t::instance = nullptr;
@@ -23,7 +24,9 @@ extproc_spawner_t *extproc_spawner_t::instance = nullptr;
 class worker_run_t {
 public:
     worker_run_t(fd_t _socket, process_id_t _spawner_pid) :
-        socket(_socket), socket_stream(socket.get(), make_scoped<blocking_fd_watcher_t>()) {
+        socket(_socket),
+        socket_stream(socket.get(), make_scoped<blocking_fd_watcher_t>()),
+        read_stream(&socket_stream) {
 
 #ifdef _WIN32
         // TODO WINDOWS: make sure the worker process gets killed
@@ -66,18 +69,18 @@ public:
         bool (*fn) (read_stream_t *, write_stream_t *);
         while (true) {
             int64_t read_size = sizeof(fn);
-            const int64_t read_res = force_read(&socket_stream, &fn, read_size);
+            const int64_t read_res = force_read(&read_stream, &fn, read_size);
             if (read_res != read_size) {
                 break;
             }
-            if (!fn(&socket_stream, &socket_stream)) {
+            if (!fn(&read_stream, &socket_stream)) {
                 break;
             }
             // Trade magic numbers with the parent
             uint64_t magic_from_parent;
             {
                 archive_result_t res =
-                    deserialize<cluster_version_t::LATEST_OVERALL>(&socket_stream,
+                    deserialize<cluster_version_t::LATEST_OVERALL>(&read_stream,
                                                                    &magic_from_parent);
                 if (res != archive_result_t::SUCCESS ||
                     magic_from_parent != extproc_worker_t::parent_to_worker_magic) {
@@ -108,6 +111,8 @@ private:
 
     scoped_fd_t socket;
     socket_stream_t socket_stream;
+    // Everything we read from the main process goes through this
+    buffered_read_stream_t read_stream;
 };
 
 #ifndef _WIN32
@@ -9,6 +9,7 @@
 #include "arch/runtime/runtime.hpp"
 #include "containers/archive/socket_stream.hpp"
 #include "extproc/extproc_job.hpp"
+#include "extproc/extproc_pool.hpp"
 
 // Guaranteed to be random, chosen by fair dice roll
 const uint64_t extproc_worker_t::parent_to_worker_magic = 0x700168fe5380e17bLL;
@@ -22,8 +23,10 @@ NORETURN bool worker_exit_fn(read_stream_t *stream_in, write_stream_t *) {
     ::_exit(exit_code);
 }
 
-extproc_worker_t::extproc_worker_t(extproc_spawner_t *_spawner) :
+extproc_worker_t::extproc_worker_t(extproc_spawner_t *_spawner,
+                                   extproc_pool_t *_pool) :
     spawner(_spawner),
+    pool(_pool),
     worker_pid(INVALID_PROCESS_ID),
     interruptor(NULL) { }
 
@@ -69,6 +72,7 @@ void extproc_worker_t::acquired(signal_t *_interruptor) {
 #endif
     if (worker_pid == INVALID_PROCESS_ID) {
         socket.reset(spawner->spawn(&worker_pid));
+        pool->on_worker_spawned();
 
 #ifdef _WIN32
         new_worker = true;
@@ -88,6 +92,7 @@ void extproc_worker_t::acquired(signal_t *_interruptor) {
     interruptor = _interruptor;
     guarantee(interruptor != nullptr);
     socket_stream.get()->set_interruptor(interruptor);
+    read_stream.create(socket_stream.get());
 
 #ifdef _WIN32
     if (new_worker) {
@@ -124,7 +129,7 @@ void extproc_worker_t::released(bool user_error, signal_t *user_interruptor) {
 
             uint64_t magic_from_child;
             archive_result_t res
-                = deserialize<cluster_version_t::LATEST_OVERALL>(socket_stream.get(),
+                = deserialize<cluster_version_t::LATEST_OVERALL>(read_stream.get(),
                                                                  &magic_from_child);
             if (bad(res) || magic_from_child != worker_to_parent_magic) {
                 throw extproc_worker_exc_t("did not receive magic number");
@@ -139,6 +144,7 @@ void extproc_worker_t::released(bool user_error, signal_t *user_interruptor) {
         }
     }
 
+    read_stream.reset();
     socket_stream.reset();
     interruptor = nullptr;
 
@@ -170,12 +176,13 @@ void extproc_worker_t::kill_process() {
 #endif
 
     worker_pid = INVALID_PROCESS_ID;
+    pool->on_worker_killed();
 
     // Clean up our socket fd
     socket.reset();
 }
 
-bool extproc_worker_t::is_process_alive() {
+bool extproc_worker_t::is_process_alive() const {
     return (worker_pid != INVALID_PROCESS_ID);
 }
 
@@ -190,7 +197,7 @@ void extproc_worker_t::run_job(bool (*fn) (read_stream_t *, write_stream_t *)) {
 }
 
 read_stream_t *extproc_worker_t::get_read_stream() {
-    return socket_stream.get();
+    return read_stream.get();
 }
 
 write_stream_t *extproc_worker_t::get_write_stream() {
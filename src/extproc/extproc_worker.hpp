@@ -9,14 +9,16 @@
 #include "concurrency/cross_thread_signal.hpp"
 #include "containers/object_buffer.hpp"
 #include "containers/scoped.hpp"
+#include "containers/archive/buffered_read_stream.hpp"
 #include "containers/archive/socket_stream.hpp"
 #include "containers/archive/archive.hpp"
 
+class extproc_pool_t;
 class extproc_spawner_t;
 
 class extproc_worker_t {
 public:
-    explicit extproc_worker_t(extproc_spawner_t *_spawner);
+    extproc_worker_t(extproc_spawner_t *_spawner, extproc_pool_t *_pool);
     ~extproc_worker_t();
 
     // Called whenever the worker changes hands (system -> user -> system)
@@ -31,7 +33,7 @@ public:
     write_stream_t *get_write_stream();
 
     void kill_process();
-    bool is_process_alive();
+    bool is_process_alive() const;
 
     static const uint64_t parent_to_worker_magic;
     static const uint64_t worker_to_parent_magic;
@@ -44,10 +46,14 @@ private:
     void spawn_internal();
 
     extproc_spawner_t *spawner;
+    // Notified whenever a worker process is spawned or killed
+    extproc_pool_t *pool;
     process_id_t worker_pid;
     scoped_fd_t socket;
 
     object_buffer_t<socket_stream_t> socket_stream;
+    // Everything we read from the worker goes through this
+    object_buffer_t<buffered_read_stream_t> read_stream;
 
 #ifdef _WIN32
     object_buffer_t<windows_event_watcher_t> socket_event_watcher;
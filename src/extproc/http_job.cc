@@ -54,24 +54,29 @@ public:
     const std::string error_string;
 };
 
-class scoped_curl_handle_t {
+// Each worker process keeps a single curl handle around between requests, so that
+// requests to the same servers reuse their connections and TLS sessions instead of
+// connecting and doing a handshake every time. Everything else about the previous
+// request, including its cookies, is cleared out before the handle is used again.
+class reusable_curl_handle_t {
 public:
-    scoped_curl_handle_t() :
-        curl_handle(curl_easy_init()) {
-    }
-
-    ~scoped_curl_handle_t() {
-        curl_easy_cleanup(curl_handle);
-    }
-
-    CURL *get() {
-        return curl_handle;
+    // Returns nullptr if no handle could be created.
+    static CURL *acquire() {
+        if (handle == nullptr) {
+            handle = curl_easy_init();
+        } else {
+            curl_easy_reset(handle);
+            curl_easy_setopt(handle, CURLOPT_COOKIELIST, "ALL");
+        }
+        return handle;
     }
 
 private:
-    CURL *curl_handle;
+    static CURL *handle;
 };
 
+CURL *reusable_curl_handle_t::handle = nullptr;
+
 // Used for adding headers, which cannot be freed until after the request is done
 class scoped_curl_slist_t {
 public:
@@ -531,6 +536,12 @@ void set_default_opts(CURL *curl_handle,
 
     exc_setopt(curl_handle, CURLOPT_NOSIGNAL, 1, "NOSIGNAL");
 
+#ifdef CURL_HTTP_VERSION_2TLS
+    // Negotiate HTTP/2 with servers that support it over TLS. This fails if libcurl
+    // was built without HTTP/2 support, in which case we just stay on HTTP/1.1.
+    curl_easy_setopt(curl_handle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+#endif
+
     // Enable cookies - needed for multiple requests like redirects or digest auth
     exc_setopt(curl_handle, CURLOPT_COOKIEFILE, "", "COOKIEFILE");
 
@@ -542,22 +553,22 @@ void set_default_opts(CURL *curl_handle,
 
 // TODO: implement streaming API support
 void perform_http(http_opts_t *opts, http_result_t *res_out) {
-    scoped_curl_handle_t curl_handle;
+    CURL *curl_handle = reusable_curl_handle_t::acquire();
     curl_data_t curl_data;
 
-    if (curl_handle.get() == nullptr) {
+    if (curl_handle == nullptr) {
         res_out->error.assign("initialization");
         return;
     }
 
-    set_default_opts(curl_handle.get(), opts->proxy, curl_data);
-    transfer_opts(opts, curl_handle.get(), &curl_data);
+    set_default_opts(curl_handle, opts->proxy, curl_data);
+    transfer_opts(opts, curl_handle, &curl_data);
 
     CURLcode curl_res = CURLE_OK;
     long response_code = 0; // NOLINT(runtime/int)
     for (uint64_t attempts = 0; attempts < opts->attempts; ++attempts) {
         // Do the HTTP operation, then check for errors
-        curl_res = curl_easy_perform(curl_handle.get());
+        curl_res = curl_easy_perform(curl_handle);
 
         if (curl_res == CURLE_SEND_ERROR ||
             curl_res == CURLE_RECV_ERROR ||
@@ -569,7 +580,7 @@ void perform_http(http_opts_t *opts, http_result_t *res_out) {
             return;
         }
 
-        curl_res = curl_easy_getinfo(curl_handle.get(),
+        curl_res = curl_easy_getinfo(curl_handle,
                                      CURLINFO_RESPONSE_CODE,
                                      &response_code);
 
@@ -610,7 +621,7 @@ void perform_http(http_opts_t *opts, http_result_t *res_out) {
         res_out->error = strprintf("status code %ld", response_code);
     } else {
         parse_header(header_data, res_out);
-        save_cookies(curl_handle.get(), res_out);
+        save_cookies(curl_handle, res_out);
 
         // If this was a HEAD request, we should not be handling data, just return R_NULL
         // so the user knows the request succeeded
@@ -626,7 +637,7 @@ void perform_http(http_opts_t *opts, http_result_t *res_out) {
             {
                 std::string content_type;
                 char *content_type_buffer = nullptr;
-                curl_easy_getinfo(curl_handle.get(),
+                curl_easy_getinfo(curl_handle,
                                   CURLINFO_CONTENT_TYPE,
                                   &content_type_buffer);
 
@@ -7,9 +7,11 @@
 #include <stdint.h>
 
 #include <limits>
+#include <memory>
 
 #include "containers/archive/boost_types.hpp"
 #include "containers/archive/stl_types.hpp"
+#include "containers/lru_cache.hpp"
 #include "extproc/extproc_job.hpp"
 #include "math.hpp"
 #include "rdb_protocol/pseudo_time.hpp"
@@ -22,6 +24,9 @@ const js_id_t MAX_ID = std::numeric_limits<js_id_t>::max();
 // Picked from a hat.
 #define TO_JSON_RECURSION_LIMIT  500
 
+// How many compiled scripts each worker process keeps around
+const size_t SCRIPT_CACHE_SIZE = 100;
+
 // Returns an empty counted_t on error.
 ql::datum_t js_to_datum(const v8::Handle<v8::Value> &value,
                         const ql::configured_limits_t &limits,
@@ -116,6 +121,34 @@ public:
     v8::Persistent<v8::Value> value;
 };
 
+// Wrapper around `v8::Persistent<v8::UnboundScript> >` that calls `Reset()` on
+// destruction
+class persistent_script_t {
+public:
+    ~persistent_script_t() {
+        script.Reset();
+    }
+    v8::Persistent<v8::UnboundScript> script;
+};
+
+// Compiled scripts, by their source. Worker processes outlive the jobs that run in
+// them, so the same `r.js` sources coming back in later queries don't have to be
+// compiled again. Unbound scripts don't belong to any context, so each evaluation
+// still runs in a clean context of its own.
+class script_cache_t {
+public:
+    // Returns an empty handle on error and sets `err_out` accordingly.
+    static v8::Local<v8::Script> compile(const std::string &source,
+                                         const v8::TryCatch &try_catch,
+                                         std::string *err_out);
+
+private:
+    static lru_cache_t<std::string, std::shared_ptr<persistent_script_t> > *cache;
+};
+
+lru_cache_t<std::string, std::shared_ptr<persistent_script_t> > *script_cache_t::cache
+    = nullptr;
+
 // Worker-side JS evaluation environment.
 class js_env_t {
 public:
@@ -152,7 +185,8 @@ enum js_task_t {
     TASK_EVAL,
     TASK_CALL,
     TASK_RELEASE,
-    TASK_EXIT
+    TASK_EXIT,
+    TASK_CALL_BATCH
 };
 
 // The job_t runs in the context of the main rethinkdb process
@@ -209,6 +243,35 @@ js_result_t js_job_t::call(js_id_t id, const std::vector<ql::datum_t> &args) {
     return result;
 }
 
+std::vector<js_result_t> js_job_t::call_batch(
+        js_id_t id, const std::vector<std::vector<ql::datum_t> > &args_batch) {
+    js_task_t task = js_task_t::TASK_CALL_BATCH;
+    write_message_t wm;
+    wm.append(&task, sizeof(task));
+    serialize<cluster_version_t::LATEST_OVERALL>(&wm, id);
+    serialize<cluster_version_t::LATEST_OVERALL>(&wm, args_batch);
+    serialize<cluster_version_t::LATEST_OVERALL>(&wm, limits);
+    {
+        int res = send_write_message(extproc_job.write_stream(), &wm);
+        if (res != 0) {
+            throw extproc_worker_exc_t("failed to send data to the worker");
+        }
+    }
+
+    std::vector<js_result_t> results;
+    archive_result_t res
+        = deserialize<cluster_version_t::LATEST_OVERALL>(extproc_job.read_stream(),
+                                                         &results);
+    if (bad(res)) {
+        throw extproc_worker_exc_t(strprintf("failed to deserialize call result from worker "
+                                             "(%s)", archive_result_as_str(res)));
+    }
+    if (results.size() != args_batch.size()) {
+        throw extproc_worker_exc_t("worker returned the wrong number of call results");
+    }
+    return results;
+}
+
 void js_job_t::release(js_id_t id) {
     js_task_t task = js_task_t::TASK_RELEASE;
     write_message_t wm;
@@ -341,6 +404,42 @@ bool run_call(read_stream_t *stream_in,
     return send_js_result(stream_out, js_result);
 }
 
+bool run_call_batch(read_stream_t *stream_in,
+                    write_stream_t *stream_out,
+                    js_env_t *js_env,
+                    uint64_t task_counter) {
+    js_id_t id;
+    std::vector<std::vector<ql::datum_t> > args_batch;
+    ql::configured_limits_t limits;
+    {
+        archive_result_t res
+            = deserialize<cluster_version_t::LATEST_OVERALL>(stream_in, &id);
+        if (bad(res)) { return false; }
+        res = deserialize<cluster_version_t::LATEST_OVERALL>(stream_in, &args_batch);
+        if (bad(res)) { return false; }
+        res = deserialize<cluster_version_t::LATEST_OVERALL>(stream_in, &limits);
+        if (bad(res)) { return false; }
+    }
+
+    std::vector<js_result_t> js_results;
+    js_results.reserve(args_batch.size());
+    for (const std::vector<ql::datum_t> &args : args_batch) {
+        try {
+            js_results.push_back(js_env->call(id, args, limits));
+        } catch (const std::exception &e) {
+            js_results.push_back(std::string(e.what()));
+        } catch (...) {
+            js_results.push_back(std::string("encountered an unknown exception"));
+        }
+    }
+
+    js_env->run_other_tasks(task_counter);
+    write_message_t wm;
+    serialize<cluster_version_t::LATEST_OVERALL>(&wm, js_results);
+    int res = send_write_message(stream_out, &wm);
+    return res == 0;
+}
+
 bool run_release(read_stream_t *stream_in,
                  write_stream_t *stream_out,
                  js_env_t *js_env,
@@ -390,6 +489,11 @@ bool js_job_t::worker_fn(read_stream_t *stream_in, write_stream_t *stream_out) {
                 return false;
             }
             break;
+        case TASK_CALL_BATCH:
+            if (!run_call_batch(stream_in, stream_out, &js_env, task_counter)) {
+                return false;
+            }
+            break;
         case TASK_EXIT:
             return run_exit(stream_out);
         default:
@@ -408,6 +512,43 @@ static void append_caught_error(std::string *err_out, const v8::TryCatch &try_ca
     err_out->append(message, strlen(message));
 }
 
+v8::Local<v8::Script> script_cache_t::compile(const std::string &source,
+                                              const v8::TryCatch &try_catch,
+                                              std::string *err_out) {
+    v8::Isolate *isolate = js_instance_t::isolate();
+    if (cache == nullptr) {
+        cache = new lru_cache_t<std::string, std::shared_ptr<persistent_script_t> >(
+            SCRIPT_CACHE_SIZE);
+    }
+
+    auto it = cache->find(source);
+    if (it != cache->end()) {
+        return v8::Local<v8::UnboundScript>::New(isolate, it->second->script)
+            ->BindToCurrentContext();
+    }
+
+    // TODO: use an "external resource" to avoid copy?
+    v8::Handle<v8::String> src = v8::String::NewFromUtf8(isolate,
+                                                         source.data(),
+                                                         v8::String::NewStringType::kNormalString,
+                                                         source.size());
+
+    // Compilation may fail (because of say a syntax error)
+    v8::ScriptCompiler::Source script_source(src);
+    v8::Local<v8::UnboundScript> unbound =
+        v8::ScriptCompiler::CompileUnbound(isolate, &script_source);
+    if (unbound.IsEmpty()) {
+        // Get the error out of the TryCatch object
+        append_caught_error(err_out, try_catch);
+        return v8::Local<v8::Script>();
+    }
+
+    std::shared_ptr<persistent_script_t> persistent_script(new persistent_script_t());
+    persistent_script->script.Reset(isolate, unbound);
+    (*cache)[source] = persistent_script;
+    return unbound->BindToCurrentContext();
+}
+
 // The env_t runs in the context of the worker process
 js_env_t::js_env_t() :
     next_id(MIN_ID) { }
@@ -422,22 +563,14 @@ js_result_t js_env_t::eval(const std::string &source,
 
     v8::HandleScope handle_scope(isolate);
 
-    // TODO: use an "external resource" to avoid copy?
-    v8::Handle<v8::String> src = v8::String::NewFromUtf8(isolate,
-                                                         source.data(),
-                                                         v8::String::NewStringType::kNormalString,
-                                                         source.size());
-
     // This constructor registers itself with v8 so that any errors generated
     // within v8 will be available within this object.
     v8::TryCatch try_catch;
 
-    // Firstly, compilation may fail (because of say a syntax error)
-    v8::Handle<v8::Script> script = v8::Script::Compile(src);
-    if (script.IsEmpty()) {
-        // Get the error out of the TryCatch object
-        append_caught_error(err_out, try_catch);
-    } else {
+    // Firstly, compilation may fail (because of say a syntax error), in which case
+    // `compile()` has already set `err_out`
+    v8::Handle<v8::Script> script = script_cache_t::compile(source, try_catch, err_out);
+    if (!script.IsEmpty()) {
         // Secondly, evaluation may fail because of an exception generated
         // by the code
         v8::Handle<v8::Value> result_val = script->Run();
@@ -6,6 +6,7 @@
 #include <map>
 
 #include "extproc/js_job.hpp"
+#include "perfmon/memory_usage.hpp"
 #include "time.hpp"
 #include "utils.hpp"
 
@@ -48,11 +49,13 @@ class js_runner_t::job_data_t {
 public:
     job_data_t(extproc_pool_t *pool, signal_t *interruptor,
                const ql::configured_limits_t &limits) :
+        memory_usage(memory_usage_category_t::EXTPROC, sizeof(job_data_t)),
         combined_interruptor(interruptor, js_timeout.get_signal()),
         js_job(pool, &combined_interruptor, limits) { }
 
     explicit job_data_t(extproc_pool_t *pool,
                         const ql::configured_limits_t &limits) :
+        memory_usage(memory_usage_category_t::EXTPROC, sizeof(job_data_t)),
         js_job(pool, js_timeout.get_signal(), limits) { }
 
     struct func_info_t {
@@ -63,6 +66,13 @@ public:
         kiloticks_t timestamp;
     };
 
+    // Returns roughly how much memory an entry of `id_cache` takes up.
+    static int64_t id_cache_entry_size(const std::string &source) {
+        return sizeof(std::pair<const std::string, func_info_t>) + source.capacity();
+    }
+
+    // Covers this object and the entries of `id_cache`.
+    memory_usage_tracker_t memory_usage;
     std::map<std::string, func_info_t> id_cache;
     js_timeout_t js_timeout;
     wait_any_t combined_interruptor;
@@ -225,6 +235,65 @@ js_result_t js_runner_t::call(const std::string &source,
     return result;
 }
 
+std::vector<js_result_t> js_runner_t::call_batch(
+        const std::string &source,
+        const std::vector<std::vector<ql::datum_t> > &args_batch,
+        const req_config_t &config) {
+    assert_thread();
+    guarantee(job_data.has());
+
+    // This will retrieve the function from the cache if it's there, or re-eval it
+    js_result_t fn_result = eval(source, config);
+    js_id_t *fn_id = boost::get<js_id_t>(&fn_result);
+    if (fn_id == nullptr) {
+        if (boost::get<ql::datum_t>(&fn_result) != nullptr) {
+            fn_result = strprintf("Javascript query `%s` returned a value when it "
+                                  "should have returned a function.", source.c_str());
+        }
+        return std::vector<js_result_t>(args_batch.size(), fn_result);
+    }
+    if (args_batch.empty()) {
+        return std::vector<js_result_t>();
+    }
+
+    object_buffer_t<js_timeout_t::sentry_t> sentry;
+    sentry.create(&job_data->js_timeout, config.timeout_ms * args_batch.size());
+
+    std::vector<js_result_t> results;
+    bool is_timeout = false;
+    try {
+        try {
+            results = job_data->js_job.call_batch(*fn_id, args_batch);
+        } catch (...) {
+            // This inner try-catch block deals with cleanup after an exception, but due
+            // to this we must store whether we triggered the timeout signal.
+            is_timeout = job_data->js_timeout.get_signal()->is_pulsed();
+
+            // Sentry must be destroyed before the js_timeout
+            sentry.reset();
+            // This will mark the worker as errored so we don't try to re-sync with it
+            //  on the next line (since we're in a catch statement, we aren't allowed)
+            job_data->js_job.worker_error();
+            job_data.reset();
+
+            throw;
+        }
+    } catch (interrupted_exc_t const &e) {
+        // This outer try-catch block explicitly checks whether it was an
+        // `interrupted_exc_t`, and if so deals with the timeout if set.
+        if (is_timeout) {
+            js_result_t timeout_result = strprintf(
+                "JavaScript query `%s` timed out after %" PRIu64 ".%03" PRIu64 " seconds.",
+                source.c_str(), config.timeout_ms / 1000, config.timeout_ms % 1000);
+            return std::vector<js_result_t>(args_batch.size(), timeout_result);
+        } else {
+            throw;
+        }
+    }
+
+    return results;
+}
+
 void js_runner_t::cache_id(js_id_t id, const std::string &source) {
     guarantee(job_data.has());
     guarantee(id != INVALID_ID);
@@ -234,6 +303,8 @@ void js_runner_t::cache_id(js_id_t id, const std::string &source) {
     auto cache_res = job_data->id_cache.insert(std::make_pair(source,
                                                               job_data_t::func_info_t(id)));
     guarantee(cache_res.second, "js_runner_t cached two functions with the same source");
+    job_data->memory_usage.add(
+        job_data_t::id_cache_entry_size(cache_res.first->first));
 }
 
 void js_runner_t::release_id(js_id_t id) {
@@ -257,6 +328,8 @@ void js_runner_t::trim_cache() {
 
     try {
         release_id(oldest_func->second.id);
+        job_data->memory_usage.add(
+            -job_data_t::id_cache_entry_size(oldest_func->first));
         job_data->id_cache.erase(oldest_func);
     } catch (...) {
         // This will mark the worker as errored so we don't try to re-sync with it
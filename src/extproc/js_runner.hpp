@@ -57,6 +57,13 @@ public:
                      const std::vector<ql::datum_t> &args,
                      const req_config_t &config);
 
+    // Calls a previously compiled function once for each set of arguments, with a
+    // single round trip to the worker. The timeout applies to each call on average.
+    std::vector<js_result_t> call_batch(
+        const std::string &source,
+        const std::vector<std::vector<ql::datum_t> > &args_batch,
+        const req_config_t &config);
+
 private:
     static const size_t CACHE_SIZE;
 
@@ -1,6 +1,7 @@
 // Copyright 2010-2012 RethinkDB, all rights reserved.
 
 #include <time.h>
+#include <zlib.h>
 
 #include <string>
 
@@ -13,9 +14,38 @@
 #include "time.hpp"
 #include "http/web_assets.hpp"
 
+static std::string make_etag(const std::string &data) {
+    uLong crc = crc32(0L, Z_NULL, 0);
+    crc = crc32(crc, reinterpret_cast<const Bytef *>(data.data()), data.size());
+    return strprintf("\"%08lx-%zx\"", crc, data.size());
+}
+
+/* Returns true if the "If-None-Match" header of `req` lists `etag`. */
+static bool etag_matches(const http_req_t &req, const std::string &etag) {
+    optional<std::string> if_none_match = req.find_header_line("If-None-Match");
+    if (!if_none_match) {
+        return false;
+    }
+    return if_none_match.get() == "*" ||
+        if_none_match.get().find(etag) != std::string::npos;
+}
+
 file_http_app_t::file_http_app_t(std::string _asset_dir)
     : asset_dir(_asset_dir)
-{ }
+{
+    if (asset_dir.empty()) {
+        for (const auto &pair : static_web_assets) {
+            web_asset_t *asset = &web_assets[pair.first];
+            asset->etag = make_etag(pair.second);
+            // `maybe_gzip_response()` doesn't bother with small bodies either
+            if (pair.second.size() >= 512) {
+                if (!gzip_string(pair.second, &asset->gzipped)) {
+                    asset->gzipped.clear();
+                }
+            }
+        }
+    }
+}
 
 bool ends_with(const std::string& str, const std::string& end) {
     return str.rfind(end) == str.length() - end.length();
@@ -91,6 +121,21 @@ void file_http_app_t::handle(const http_req_t &req, http_res_t *result, signal_t
     result->add_header_line("Content-Type", mimetype);
 
     if (asset_dir.empty()) {
+        const web_asset_t &asset = web_assets.at(filename);
+        result->add_header_line("ETag", asset.etag);
+        if (etag_matches(req, asset.etag)) {
+            result->code = http_status_code_t::NOT_MODIFIED;
+            return;
+        }
+        if (!asset.gzipped.empty()) {
+            result->add_header_line("Vary", "Accept-Encoding");
+            if (accepts_gzip_encoding(req)) {
+                result->add_header_line("Content-Encoding", "gzip");
+                result->body = asset.gzipped;
+                result->code = http_status_code_t::OK;
+                return;
+            }
+        }
         result->body.assign(resource_data.begin(), resource_data.end());
         result->code = http_status_code_t::OK;
     } else {
@@ -98,6 +143,13 @@ void file_http_app_t::handle(const http_req_t &req, http_res_t *result, signal_t
 
         if (result->code == http_status_code_t::NOT_FOUND) {
             logNTC("File %s was requested and is on the whitelist but we didn't find it in the directory.", (asset_dir + filename).c_str());
+        } else if (result->code == http_status_code_t::OK) {
+            std::string etag = make_etag(result->body);
+            result->add_header_line("ETag", etag);
+            if (etag_matches(req, etag)) {
+                result->body.clear();
+                result->code = http_status_code_t::NOT_MODIFIED;
+            }
         }
     }
 }
@@ -2,19 +2,32 @@
 #ifndef HTTP_FILE_APP_HPP_
 #define HTTP_FILE_APP_HPP_
 
+#include <map>
 #include <string>
 
 #include "http/http.hpp"
 
+/* Serves the web UI, either from the assets compiled into the binary or from
+`asset_dir`. Every response has an ETag, so that browsers can revalidate their cached
+copies with a 304 response instead of fetching them again. */
 class file_http_app_t : public http_app_t {
 public:
     explicit file_http_app_t(std::string _asset_dir);
 
     void handle(const http_req_t &, http_res_t *result, signal_t *interruptor);
 private:
+    /* What we work out about a compiled-in asset once, when the app is created,
+    instead of on every request. */
+    struct web_asset_t {
+        std::string etag;
+        /* The asset compressed with gzip, or empty if compressing doesn't pay */
+        std::string gzipped;
+    };
+
     void handle_blocking(std::string filename, http_res_t *res_out);
 
     std::string asset_dir;
+    std::map<std::string, web_asset_t> web_assets;
 };
 
 #endif /* HTTP_FILE_APP_HPP_ */
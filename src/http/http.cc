@@ -11,6 +11,8 @@
 #include <boost/algorithm/string.hpp>
 
 #include "arch/io/network.hpp"
+#include "arch/timing.hpp"
+#include "concurrency/wait_any.hpp"
 #include "logger.hpp"
 #include "math.hpp"
 
@@ -201,13 +203,7 @@ void http_res_t::set_body(const std::string& content_type, const std::string& co
     body = content;
 }
 
-bool maybe_gzip_response(const http_req_t &req, http_res_t *res) {
-    // Don't bother zipping anything less than 0.5k
-    size_t body_size = res->body.size();
-    if (body_size < 512) {
-        return false;
-    }
-
+bool accepts_gzip_encoding(const http_req_t &req) {
     // See the specification for the "Accept-Encoding" header line here:
     // http://www.w3.org/Protocols/rfc2616/rfc2616-sec14.html#sec14.3
     // We do not implement the entire standard, that is, we will always fallback to
@@ -295,7 +291,11 @@ bool maybe_gzip_response(const http_req_t &req, http_res_t *res) {
         return false;
     }
 
-    // Gzip is supported and preferred, gzip the body of the result
+    return true;
+}
+
+bool gzip_string(const std::string &in, std::string *out) {
+    size_t body_size = in.size();
     scoped_array_t<char> out_buffer(body_size);
 
     z_stream zstream;
@@ -304,7 +304,7 @@ bool maybe_gzip_response(const http_req_t &req, http_res_t *res) {
     zstream.opaque = Z_NULL;
     zstream.avail_in = body_size;
     zstream.avail_out = body_size;
-    zstream.next_in = reinterpret_cast<unsigned char*>(const_cast<char *>(res->body.data()));
+    zstream.next_in = reinterpret_cast<unsigned char*>(const_cast<char *>(in.data()));
     zstream.next_out = reinterpret_cast<unsigned char*>(out_buffer.data());
     zstream.total_in = 0;
     zstream.total_out = 0;
@@ -333,11 +333,36 @@ bool maybe_gzip_response(const http_req_t &req, http_res_t *res) {
     }
 
     // Would be nice if we could do this without copying
-    res->body.assign(out_buffer.data(), zstream.total_out);
+    out->assign(out_buffer.data(), zstream.total_out);
+    return true;
+}
+
+bool maybe_gzip_response(const http_req_t &req, http_res_t *res) {
+    // Leave responses alone that the application has already encoded itself, such as
+    // the static web assets that `file_http_app_t` keeps compressed.
+    if (res->header_lines.find("content-encoding") != res->header_lines.end()) {
+        return false;
+    }
+
+    // Don't bother zipping anything less than 0.5k
+    if (res->body.size() < 512) {
+        return false;
+    }
+
+    if (!accepts_gzip_encoding(req)) {
+        return false;
+    }
+
+    // Gzip is supported and preferred, gzip the body of the result
+    std::string compressed;
+    if (!gzip_string(res->body, &compressed)) {
+        return false;
+    }
+    res->body = std::move(compressed);
 
     // Update the body size in the headers
     if (res->header_lines.find("content-length") != res->header_lines.end()){
-        res->header_lines["content-length"] = strprintf("%lu", zstream.total_out);
+        res->header_lines["content-length"] = strprintf("%zu", res->body.size());
     }
 
     res->add_header_line("Content-Encoding", "gzip");
@@ -378,6 +403,8 @@ std::string human_readable_status(http_status_code_t code) {
     switch (code) {
     case http_status_code_t::OK:
         return "OK";
+    case http_status_code_t::NOT_MODIFIED:
+        return "Not Modified";
     case http_status_code_t::BAD_REQUEST:
         return "Bad Request";
     case http_status_code_t::FORBIDDEN:
@@ -419,38 +446,87 @@ void http_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &nconn
         return;
     }
 
-    http_req_t req;
-    tcp_http_msg_parser_t http_msg_parser;
-
-    // Parse the request
+    // Serve requests until the client closes the connection or asks us to
     try {
-        http_res_t res;
-        UNUSED bool peer_res = conn->getpeername(&req.peer);
+        for (;;) {
+            /* Between requests the connection is idle, so it is closed if the next
+            request doesn't arrive in time. */
+            signal_timer_t idle_timer;
+            idle_timer.start(KEEPALIVE_TIMEOUT_MS);
+            wait_any_t interruptor(&idle_timer, keepalive.get_drain_signal());
+
+            http_req_t req;
+            tcp_http_msg_parser_t http_msg_parser;
+            http_res_t res;
+            UNUSED bool peer_res = conn->getpeername(&req.peer);
+
+            bool parsed;
+            try {
+                /* Wait for the first byte of the request with the idle timeout, then
+                parse the rest of it without. */
+                conn->peek(1, &interruptor);
+                parsed = http_msg_parser.parse(
+                    conn.get(), &req, keepalive.get_drain_signal());
+            } catch (const interrupted_exc_t &) {
+                if (keepalive.get_drain_signal()->is_pulsed()) {
+                    throw;
+                }
+                // The connection was idle for too long
+                return;
+            }
 
-        if (http_msg_parser.parse(conn.get(), &req, keepalive.get_drain_signal())) {
-            application->handle(req, &res, keepalive.get_drain_signal());
-            res.version = req.version;
-            maybe_gzip_response(req, &res);
-        } else {
-            res = http_res_t(http_status_code_t::BAD_REQUEST);
-        }
+            if (parsed) {
+                application->handle(req, &res, keepalive.get_drain_signal());
+                res.version = req.version;
+                maybe_gzip_response(req, &res);
+            } else {
+                res = http_res_t(http_status_code_t::BAD_REQUEST);
+                res.add_header_line("Connection", "close");
+            }
+
+            // Disable keepalive on Safari because it seems like a partial cause of #3983
+            auto user_agent = req.header_lines.find("user-agent");
+            if (user_agent != req.header_lines.end()) {
+                if (user_agent->second.find("Safari") != std::string::npos) {
+                    // Chrome also has "Safari" in the user-agent string.
+                    if (user_agent->second.find("Chrome") == std::string::npos) {
+                        res.add_header_line("Connection", "close");
+                    }
+                }
+            }
 
-        // Disable keepalive on Safari because it seems like a partial cause of #3983
-        auto user_agent = req.header_lines.find("user-agent");
-        if (user_agent != req.header_lines.end()) {
-            if (user_agent->second.find("Safari") != std::string::npos) {
-                // Chrome also has "Safari" in the user-agent string.
-                if (user_agent->second.find("Chrome") == std::string::npos) {
+            /* HTTP/1.1 connections are kept alive unless the client says otherwise;
+            HTTP/1.0 connections only if the client asks for it. */
+            optional<std::string> req_connection = req.find_header_line("Connection");
+            if (req_connection) {
+                boost::to_lower(req_connection.get());
+            }
+            if (req.version == "1.1") {
+                if (req_connection && req_connection.get() == "close") {
                     res.add_header_line("Connection", "close");
                 }
+            } else if (req_connection && req_connection.get() == "keep-alive") {
+                res.add_header_line("Connection", "keep-alive");
+            } else {
+                res.add_header_line("Connection", "close");
+            }
+
+            // The client can only find the end of the response by its length
+            res.add_header_line("Content-Length", strprintf("%zu", res.body.size()));
+
+            write_http_msg(conn.get(), res, keepalive.get_drain_signal());
+
+            auto res_connection = res.header_lines.find("connection");
+            if (res_connection != res.header_lines.end() &&
+                res_connection->second == "close") {
+                return;
             }
         }
-        write_http_msg(conn.get(), res, keepalive.get_drain_signal());
     } catch (const interrupted_exc_t &) {
         // The query was interrupted, no response since we are shutting down
     } catch (const tcp_conn_read_closed_exc_t &) {
         // Someone disconnected before sending us all the information we
-        // needed... oh well.
+        // needed, or closed a kept-alive connection... oh well.
     } catch (const tcp_conn_write_closed_exc_t &) {
         // We were trying to write to someone and they didn't stick around long
         // enough to write it.
@@ -82,6 +82,7 @@ int content_length(const http_req_t&);
 
 enum class http_status_code_t {
     OK = 200,
+    NOT_MODIFIED = 304,
     BAD_REQUEST = 400,
     FORBIDDEN = 403,
     NOT_FOUND = 404,
@@ -105,6 +106,16 @@ public:
                const std::string &content);
 };
 
+/* Returns true if the request's "Accept-Encoding" header prefers gzip to the identity
+encoding. */
+bool accepts_gzip_encoding(const http_req_t &req);
+
+/* Compresses `in` with gzip into `*out`. Returns false if that fails or doesn't make
+`in` any smaller. */
+bool gzip_string(const std::string &in, std::string *out);
+
+/* Compresses the body of `res` if the client accepts it, unless the body is small or
+`res` already has a "Content-Encoding". */
 bool maybe_gzip_response(const http_req_t &req, http_res_t *res);
 
 http_res_t http_error_res(const std::string &content,
@@ -148,7 +159,9 @@ protected:
 /* creating an http server will bind to the specified port and listen for http
  * connections, the data from incoming connections will be parsed into
  * http_req_ts and passed to the handle function which must then return an http
- * msg that's a meaningful response */
+ * msg that's a meaningful response. Connections are kept alive between requests
+ * unless the client asks otherwise, and are closed after being idle for
+ * `KEEPALIVE_TIMEOUT_MS`. */
 class http_server_t {
 public:
     http_server_t(
@@ -156,6 +169,8 @@ public:
         int port, http_app_t *application);
     ~http_server_t();
     int get_port() const;
+
+    static const int64_t KEEPALIVE_TIMEOUT_MS = 60 * 1000;
 private:
     void handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &conn, auto_drainer_t::lock_t);
     http_app_t *application;
@@ -13,6 +13,8 @@
 #endif
 #endif  // _WIN32
 
+#include "arch/huge_page_arena.hpp"
+#include "config/args.hpp"
 #include "errors.hpp"
 
 void *raw_malloc_aligned(size_t size, size_t alignment) {
@@ -43,10 +45,21 @@ void *raw_malloc_page_aligned(size_t size) {
 }
 #endif
 
+void *raw_malloc_device_block_aligned(size_t size) {
+    void *ptr = huge_page_arena_allocate(size);
+    if (ptr != nullptr) {
+        return ptr;
+    }
+    return raw_malloc_aligned(size, DEVICE_BLOCK_SIZE);
+}
+
 void raw_free_aligned(void *ptr) {
 #ifdef _WIN32
     _aligned_free(ptr);
 #else
+    if (huge_page_arena_free(ptr)) {
+        return;
+    }
     free(ptr);
 #endif
 }
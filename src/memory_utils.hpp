@@ -6,6 +6,10 @@
 void *raw_malloc_aligned(size_t size, size_t alignment);
 void raw_free_aligned(void *ptr);
 
+/* Like `raw_malloc_aligned(size, DEVICE_BLOCK_SIZE)`, but takes the buffer from the
+huge page arena if it's enabled (see arch/huge_page_arena.hpp). */
+void *raw_malloc_device_block_aligned(size_t size);
+
 #ifndef _WIN32
 void *raw_malloc_page_aligned(size_t size);
 #endif
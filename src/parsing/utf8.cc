@@ -1,5 +1,6 @@
 #include "parsing/utf8.hpp"
 
+#include <stdint.h>
 #include <string.h>
 #include <string>
 
@@ -68,6 +69,26 @@ inline bool is_valid_internal(Iterator begin, Iterator end, reason_t *reason) {
     return true;
 }
 
+bool is_ascii(const char *start, const char *end) {
+    rassert(start <= end);
+    const uint64_t high_bits = 0x8080808080808080ull;
+    uint64_t seen = 0;
+    for (; end - start >= static_cast<ptrdiff_t>(sizeof(uint64_t));
+         start += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, start, sizeof(word));
+        seen |= word;
+    }
+    for (; start < end; ++start) {
+        seen |= static_cast<uint8_t>(*start);
+    }
+    return (seen & high_bits) == 0;
+}
+
+bool is_ascii(const std::string &str) {
+    return is_ascii(str.data(), str.data() + str.size());
+}
+
 size_t count_codepoints(const char *start, const char *end) {
     rassert(start <= end);
     size_t ret = 0;
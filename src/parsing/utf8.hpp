@@ -20,6 +20,11 @@ size_t count_codepoints(const char *start, const char *end);
 size_t index_codepoints(const datum_string_t &, size_t n);
 size_t index_codepoints(const char *start, const char *end, size_t n);
 
+// Returns whether the string is all ASCII, so that it can be processed a byte at a
+// time instead of a codepoint at a time. Checks eight bytes at once.
+bool is_ascii(const char *start, const char *end);
+bool is_ascii(const std::string &);
+
 // Simple UTF-8 validation.
 bool is_valid(const std::string &);
 bool is_valid(const char *, const char *);
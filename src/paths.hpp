@@ -60,6 +60,10 @@ private:
     const std::string temporary_path_;
 };
 
+// The directory for files that are being created or deleted; see
+// `recreate_temporary_directory()`, which empties it when the server starts.
+std::string temporary_directory_path(const base_path_t& base_path);
+
 void recreate_temporary_directory(const base_path_t& base_path);
 
 void remove_directory_recursive(const char *path);
@@ -0,0 +1,94 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "perfmon/foreground_load.hpp"
+
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+
+#include "arch/runtime/runtime.hpp"
+#include "concurrency/cache_line_padded.hpp"
+#include "config/args.hpp"
+
+struct query_latency_counts_t {
+    std::atomic<int64_t> count;
+    std::atomic<int64_t> nanos;
+};
+
+/* The query counts are kept per thread so that threads don't contend for one cache
+line on every query. */
+static cache_line_padded_t<query_latency_counts_t> query_latency_counts[MAX_THREADS];
+static std::atomic<int64_t> disk_queue_depth(0);
+
+void record_foreground_query_latency(ticks_t latency) {
+    query_latency_counts_t *counts = &query_latency_counts[get_thread_id().threadnum].value;
+    counts->count.fetch_add(1, std::memory_order_relaxed);
+    counts->nanos.fetch_add(latency.nanos, std::memory_order_relaxed);
+}
+
+void record_disk_request_started() {
+    disk_queue_depth.fetch_add(1, std::memory_order_relaxed);
+}
+
+void record_disk_request_finished() {
+    disk_queue_depth.fetch_sub(1, std::memory_order_relaxed);
+}
+
+int64_t get_disk_queue_depth() {
+    return disk_queue_depth.load(std::memory_order_relaxed);
+}
+
+static int64_t get_process_cpu_nanos() {
+#ifdef _WIN32
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * BILLION
+        + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * THOUSAND;
+#endif
+}
+
+static void get_query_totals(int64_t *count_out, int64_t *nanos_out) {
+    *count_out = 0;
+    *nanos_out = 0;
+    for (int i = 0; i < MAX_THREADS; ++i) {
+        *count_out += query_latency_counts[i].value.count.load(
+            std::memory_order_relaxed);
+        *nanos_out += query_latency_counts[i].value.nanos.load(
+            std::memory_order_relaxed);
+    }
+}
+
+foreground_load_sampler_t::foreground_load_sampler_t() :
+    last_time(get_ticks()), last_cpu_nanos(get_process_cpu_nanos()) {
+    get_query_totals(&last_query_count, &last_query_nanos);
+}
+
+foreground_load_sampler_t::sample_t foreground_load_sampler_t::sample() {
+    sample_t s;
+
+    int64_t query_count, query_nanos;
+    get_query_totals(&query_count, &query_nanos);
+    s.query_latency_ms = query_count == last_query_count ? 0.0
+        : static_cast<double>(query_nanos - last_query_nanos)
+            / (query_count - last_query_count) / MILLION;
+    last_query_count = query_count;
+    last_query_nanos = query_nanos;
+
+    s.disk_queue_depth = get_disk_queue_depth();
+
+    ticks_t now = get_ticks();
+    int64_t cpu_nanos = get_process_cpu_nanos();
+    int64_t elapsed = std::max<int64_t>(now.nanos - last_time.nanos, 1);
+    s.cpu_usage = static_cast<double>(cpu_nanos - last_cpu_nanos)
+        / (static_cast<double>(elapsed) * get_num_threads());
+    last_time = now;
+    last_cpu_nanos = cpu_nanos;
+
+    return s;
+}
@@ -0,0 +1,51 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef PERFMON_FOREGROUND_LOAD_HPP_
+#define PERFMON_FOREGROUND_LOAD_HPP_
+
+#include <stdint.h>
+
+#include "errors.hpp"
+#include "time.hpp"
+
+/* These keep a few cheap, process-wide measures of how busy the server is with work
+that clients are waiting for. Background work like backfilling reads them through a
+`foreground_load_sampler_t` to decide whether it should slow down. Unlike the perfmons,
+recording is just an atomic add, so it's fine to do on every query and disk request. */
+
+/* Called by the query server when it has finished running a query. Safe to call from
+any thread. */
+void record_foreground_query_latency(ticks_t latency);
+
+/* Called by the disk I/O layer when an I/O request is queued and when it completes. */
+void record_disk_request_started();
+void record_disk_request_finished();
+
+/* The number of disk requests that are queued or running right now. */
+int64_t get_disk_queue_depth();
+
+class foreground_load_sampler_t {
+public:
+    struct sample_t {
+        /* The mean latency of the queries that finished since the previous sample, or
+        zero if there weren't any. */
+        double query_latency_ms;
+        /* The number of disk requests that are queued or running right now. */
+        int64_t disk_queue_depth;
+        /* The CPU time the process used since the previous sample, as a fraction of the
+        wall-clock time times the number of threads. */
+        double cpu_usage;
+    };
+
+    foreground_load_sampler_t();
+
+    sample_t sample();
+
+private:
+    ticks_t last_time;
+    int64_t last_cpu_nanos;
+    int64_t last_query_count, last_query_nanos;
+
+    DISABLE_COPYING(foreground_load_sampler_t);
+};
+
+#endif  // PERFMON_FOREGROUND_LOAD_HPP_
@@ -0,0 +1,85 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "perfmon/memory_usage.hpp"
+
+#include <string>
+
+#include "arch/runtime/runtime.hpp"
+#include "containers/scoped.hpp"
+#include "perfmon/perfmon.hpp"
+
+namespace {
+
+const size_t NUM_MEMORY_USAGE_CATEGORIES =
+    static_cast<size_t>(memory_usage_category_t::NUM_CATEGORIES);
+
+class memory_usage_stats_t {
+public:
+    memory_usage_stats_t()
+        : collection_membership(&get_global_perfmon_collection(), &collection,
+                                "memory") {
+        for (size_t i = 0; i < NUM_MEMORY_USAGE_CATEGORIES; ++i) {
+            memberships[i].init(new perfmon_membership_t(
+                &collection, &counters[i],
+                std::string(memory_usage_category_name(
+                    static_cast<memory_usage_category_t>(i))) + "_bytes"));
+        }
+    }
+
+    perfmon_counter_t counters[NUM_MEMORY_USAGE_CATEGORIES];
+
+private:
+    perfmon_collection_t collection;
+    perfmon_membership_t collection_membership;
+    scoped_ptr_t<perfmon_membership_t> memberships[NUM_MEMORY_USAGE_CATEGORIES];
+
+    DISABLE_COPYING(memory_usage_stats_t);
+};
+
+memory_usage_stats_t *get_memory_usage_stats() {
+    static memory_usage_stats_t stats;
+    return &stats;
+}
+
+// Registers the counters before the server starts, so that they show up in the stats
+// even while they are all zero.
+UNUSED memory_usage_stats_t *const memory_usage_stats_at_startup =
+    get_memory_usage_stats();
+
+}  // namespace
+
+const char *memory_usage_category_name(memory_usage_category_t category) {
+    switch (category) {
+    case memory_usage_category_t::PAGE_CACHE: return "page_cache";
+    case memory_usage_category_t::LBA_INDEX: return "lba_index";
+    case memory_usage_category_t::COROUTINE_STACKS: return "coroutine_stacks";
+    case memory_usage_category_t::QUERY_DATUMS: return "query_datums";
+    case memory_usage_category_t::CHANGEFEED_QUEUES: return "changefeed_queues";
+    case memory_usage_category_t::MAILBOX_BUFFERS: return "mailbox_buffers";
+    case memory_usage_category_t::EXTPROC: return "extproc";
+    case memory_usage_category_t::NUM_CATEGORIES:
+    default: unreachable();
+    }
+}
+
+void add_memory_usage(memory_usage_category_t category, int64_t bytes) {
+    rassert(category != memory_usage_category_t::NUM_CATEGORIES);
+    if (bytes == 0 || get_thread_id().threadnum < 0) {
+        return;
+    }
+    get_memory_usage_stats()->counters[static_cast<size_t>(category)] += bytes;
+}
+
+memory_usage_tracker_t::memory_usage_tracker_t(memory_usage_category_t category,
+                                               int64_t bytes)
+    : category_(category), bytes_(bytes) {
+    add_memory_usage(category_, bytes_);
+}
+
+memory_usage_tracker_t::~memory_usage_tracker_t() {
+    add_memory_usage(category_, -bytes_);
+}
+
+void memory_usage_tracker_t::set(int64_t bytes) {
+    add_memory_usage(category_, bytes - bytes_);
+    bytes_ = bytes;
+}
@@ -0,0 +1,64 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef PERFMON_MEMORY_USAGE_HPP_
+#define PERFMON_MEMORY_USAGE_HPP_
+
+#include <stdint.h>
+
+#include "errors.hpp"
+
+/* These break down the server's memory usage by subsystem, so that we can tell what is
+using the memory of a server that uses more than it should. Each category is a
+`perfmon_counter_t` in the global perfmon collection, under `memory`, and the server
+rows of `rethinkdb.stats` report them as well. Like any `perfmon_counter_t`, updating
+them only touches a per-thread value, so it's cheap enough for hot paths.
+
+The counters track the memory that each subsystem is responsible for, not every
+allocation it makes, so they don't add up to the process's resident size. */
+enum class memory_usage_category_t {
+    /* The pages that the buffer caches hold in memory. */
+    PAGE_CACHE = 0,
+    /* The serializers' in-memory LBA indexes. */
+    LBA_INDEX,
+    /* The stacks of the allocated coroutines, including the ones on the free lists. */
+    COROUTINE_STACKS,
+    /* The shared buffers that hold datum strings, binary data and serialized
+    documents. */
+    QUERY_DATUMS,
+    /* The changes that are queued up for changefeed subscriptions. */
+    CHANGEFEED_QUEUES,
+    /* Cluster messages that have been received but not yet handled by their
+    mailbox. */
+    MAILBOX_BUFFERS,
+    /* What we keep in this process for the JavaScript workers, such as the cache of
+    compiled functions. The workers' own memory isn't included. */
+    EXTPROC,
+    NUM_CATEGORIES
+};
+
+const char *memory_usage_category_name(memory_usage_category_t category);
+
+/* Adds `bytes`, which may be negative, to the given category. Memory may be released
+on a different thread than the one it was recorded on. Calls from threads outside of
+the thread pool are ignored. */
+void add_memory_usage(memory_usage_category_t category, int64_t bytes);
+
+/* A `memory_usage_tracker_t` reports an amount of memory that changes over time to one
+of the categories, and takes it back out when it's destroyed. */
+class memory_usage_tracker_t {
+public:
+    explicit memory_usage_tracker_t(memory_usage_category_t category,
+                                    int64_t bytes = 0);
+    ~memory_usage_tracker_t();
+
+    void set(int64_t bytes);
+    void add(int64_t bytes) { set(bytes_ + bytes); }
+    int64_t get() const { return bytes_; }
+
+private:
+    const memory_usage_category_t category_;
+    int64_t bytes_;
+
+    DISABLE_COPYING(memory_usage_tracker_t);
+};
+
+#endif  // PERFMON_MEMORY_USAGE_HPP_
@@ -3,6 +3,7 @@
 
 #include <stdarg.h>
 
+#include <algorithm>
 #include <cmath>
 #include <map>
 
@@ -16,6 +17,7 @@ static const char *stat_per_sec = "per_sec";
 static const char *stat_count = "count";
 static const char *stat_mean = "mean";
 static const char *stat_std_dev = "std_dev";
+static const char *stat_buckets = "buckets";
 
 
 #ifdef FULL_PERFMON
@@ -241,6 +243,159 @@ void perfmon_stddev_t::record(double value) {
     thread_data[get_thread_id().threadnum].value.add(value);
 }
 
+/* perfmon_latency_histogram_t */
+
+latency_histogram_t::latency_histogram_t() : total(0) {
+    std::fill(buckets, buckets + NUM_BUCKETS, 0);
+}
+
+int latency_histogram_t::bucket_for_micros(uint64_t micros) {
+    if (micros < static_cast<uint64_t>(SUB_BUCKETS)) {
+        return static_cast<int>(micros);
+    }
+    int magnitude = 63 - __builtin_clzll(micros);
+    if (magnitude >= MAX_MAGNITUDE) {
+        return NUM_BUCKETS - 1;
+    }
+    int shift = magnitude - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKETS + static_cast<int>((micros >> shift) - SUB_BUCKETS);
+}
+
+uint64_t latency_histogram_t::bucket_end_micros(int bucket) {
+    rassert(bucket >= 0 && bucket < NUM_BUCKETS);
+    if (bucket < SUB_BUCKETS) {
+        return bucket + 1;
+    }
+    int shift = bucket / SUB_BUCKETS - 1;
+    uint64_t sub_bucket = bucket % SUB_BUCKETS + SUB_BUCKETS;
+    return (sub_bucket + 1) << shift;
+}
+
+void latency_histogram_t::record(double secs) {
+    uint64_t micros = secs > 0 ? static_cast<uint64_t>(secs * MILLION) : 0;
+    ++buckets[bucket_for_micros(micros)];
+    ++total;
+}
+
+void latency_histogram_t::add_to_bucket(int bucket, uint64_t n) {
+    guarantee(bucket >= 0 && bucket < NUM_BUCKETS);
+    buckets[bucket] += n;
+    total += n;
+}
+
+void latency_histogram_t::aggregate(const latency_histogram_t &other) {
+    if (other.total == 0) {
+        return;
+    }
+    for (int i = 0; i < NUM_BUCKETS; ++i) {
+        buckets[i] += other.buckets[i];
+    }
+    total += other.total;
+}
+
+double latency_histogram_t::percentile(double fraction) const {
+    guarantee(total > 0);
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(ceil(fraction * total)));
+    uint64_t seen = 0;
+    for (int i = 0; i < NUM_BUCKETS; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return bucket_end_micros(i) / static_cast<double>(MILLION);
+        }
+    }
+    unreachable();
+}
+
+double latency_histogram_t::max() const {
+    guarantee(total > 0);
+    for (int i = NUM_BUCKETS - 1; i >= 0; --i) {
+        if (buckets[i] != 0) {
+            return bucket_end_micros(i) / static_cast<double>(MILLION);
+        }
+    }
+    unreachable();
+}
+
+perfmon_latency_histogram_t::perfmon_latency_histogram_t(ticks_t _length)
+    : perfmon_perthread_t<latency_histogram_t>(), length(_length) { }
+
+perfmon_latency_histogram_t::thread_info_t *
+perfmon_latency_histogram_t::get_thread_info(ticks_t now) {
+    int64_t interval = now.nanos / length.nanos;
+    rassert(get_thread_id().threadnum >= 0);
+    std::unique_ptr<thread_info_t> &thread = thread_data[get_thread_id().threadnum];
+    if (!thread) {
+        thread.reset(new thread_info_t);
+        thread->current_interval = interval;
+    } else if (thread->current_interval == interval) {
+        /* We're up to date; nothing to do */
+    } else if (thread->current_interval + 1 == interval) {
+        /* We're one step behind */
+        thread->last_stats = thread->current_stats;
+        thread->current_stats = latency_histogram_t();
+        thread->current_interval++;
+    } else {
+        /* We're more than one step behind */
+        thread->last_stats = thread->current_stats = latency_histogram_t();
+        thread->current_interval = interval;
+    }
+    return thread.get();
+}
+
+void perfmon_latency_histogram_t::record(double secs) {
+    get_thread_info(get_ticks())->current_stats.record(secs);
+}
+
+void perfmon_latency_histogram_t::get_thread_stat(latency_histogram_t *stat) {
+    rassert(get_thread_id().threadnum >= 0);
+    if (thread_data[get_thread_id().threadnum]) {
+        /* As in `perfmon_sampler_t`, we report the last complete interval. */
+        *stat = get_thread_info(get_ticks())->last_stats;
+    }
+}
+
+latency_histogram_t perfmon_latency_histogram_t::combine_stats(
+        const latency_histogram_t *stats) {
+    latency_histogram_t aggregated;
+    for (int i = 0; i < get_num_threads(); i++) {
+        aggregated.aggregate(stats[i]);
+    }
+    return aggregated;
+}
+
+ql::datum_t perfmon_latency_histogram_t::output_stat(
+        const latency_histogram_t &aggregated) {
+    ql::datum_object_builder_t builder;
+
+    builder.overwrite(stat_count,
+                      ql::datum_t(static_cast<double>(aggregated.count())));
+    static const std::pair<const char *, double> percentiles[] = {
+        {"p50", 0.5}, {"p90", 0.9}, {"p99", 0.99}, {"p999", 0.999} };
+    for (const auto &p : percentiles) {
+        builder.overwrite(p.first, aggregated.count() > 0
+            ? ql::datum_t(aggregated.percentile(p.second))
+            : ql::datum_t::null());
+    }
+    builder.overwrite(stat_max, aggregated.count() > 0
+        ? ql::datum_t(aggregated.max())
+        : ql::datum_t::null());
+
+    /* The non-empty buckets, as `[bucket, count]` pairs */
+    ql::datum_array_builder_t buckets_builder(ql::configured_limits_t::unlimited);
+    for (int i = 0; i < latency_histogram_t::NUM_BUCKETS; ++i) {
+        if (aggregated.bucket_count(i) != 0) {
+            ql::datum_array_builder_t pair_builder(ql::configured_limits_t::unlimited);
+            pair_builder.add(ql::datum_t(static_cast<double>(i)));
+            pair_builder.add(
+                ql::datum_t(static_cast<double>(aggregated.bucket_count(i))));
+            buckets_builder.add(std::move(pair_builder).to_datum());
+        }
+    }
+    builder.overwrite(stat_buckets, std::move(buckets_builder).to_datum());
+
+    return std::move(builder).to_datum();
+}
+
 /* perfmon_rate_monitor_t */
 
 perfmon_rate_monitor_t::perfmon_rate_monitor_t(ticks_t _length)
@@ -188,6 +188,73 @@ private:
     cache_line_padded_t<stddev_t> thread_data[MAX_THREADS];
 };
 
+/* `latency_histogram_t` counts durations in logarithmically sized buckets, in the
+ * style of an HDR histogram: every power of two (in microseconds) is split into
+ * `SUB_BUCKETS` equally sized buckets, so the percentiles that it reports are within
+ * about 6% of the true value no matter how large they are. Unlike `stddev_t` it can
+ * tell us about tail latencies, and two histograms can be combined exactly by adding
+ * up their buckets, even if they come from different threads or servers.
+ */
+class latency_histogram_t {
+public:
+    static const int SUB_BUCKET_BITS = 4;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    /* Durations of 2^36 microseconds (about 19 hours) or more all end up in the last
+    bucket. */
+    static const int MAX_MAGNITUDE = 36;
+    static const int NUM_BUCKETS = (MAX_MAGNITUDE - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    latency_histogram_t();
+
+    void record(double secs);
+    void add_to_bucket(int bucket, uint64_t n);
+    void aggregate(const latency_histogram_t &other);
+
+    uint64_t count() const { return total; }
+    uint64_t bucket_count(int bucket) const { return buckets[bucket]; }
+
+    /* Returns the smallest duration (in seconds) that at least `fraction` of the
+    recorded durations don't exceed, rounded up to the end of its bucket. Must not be
+    called on an empty histogram. */
+    double percentile(double fraction) const;
+
+    /* The end of the highest non-empty bucket, in seconds. */
+    double max() const;
+
+    static int bucket_for_micros(uint64_t micros);
+    static uint64_t bucket_end_micros(int bucket);
+
+private:
+    uint64_t buckets[NUM_BUCKETS];
+    uint64_t total;
+};
+
+/* `perfmon_latency_histogram_t` keeps a `latency_histogram_t` of the durations that
+ * were recorded during the last complete period of `length` ticks. It reports the
+ * count, some percentiles and the maximum (in seconds), as well as the non-empty
+ * buckets so that the histograms of several servers can be combined. Each thread's
+ * histograms are allocated when that thread first records something.
+ */
+class perfmon_latency_histogram_t : public perfmon_perthread_t<latency_histogram_t> {
+    struct thread_info_t {
+        latency_histogram_t current_stats, last_stats;
+        int64_t current_interval;
+    };
+
+    std::unique_ptr<thread_info_t> thread_data[MAX_THREADS];
+
+    thread_info_t *get_thread_info(ticks_t now);
+
+    void get_thread_stat(latency_histogram_t *);
+    latency_histogram_t combine_stats(const latency_histogram_t *);
+    ql::datum_t output_stat(const latency_histogram_t &);
+
+    ticks_t length;
+public:
+    explicit perfmon_latency_histogram_t(ticks_t _length);
+    void record(double secs);
+};
+
 /* `perfmon_rate_monitor_t` keeps track of the number of times some event
  * happens per second. It is different from `perfmon_sampler_t` in that it does
  * not associate a number with each event, but you can record many events at
@@ -625,6 +625,7 @@ private:
         case Term::MOD:
         case Term::OBJECT:
         case Term::RANGE:
+        case Term::CHUNKS:
         case Term::DB_CREATE:
         case Term::DB_DROP:
         case Term::DB_LIST:
@@ -949,6 +950,8 @@ static void pprint_update_reminder() {
     case Term::COUNT:
     case Term::SUM:
     case Term::AVG:
+    case Term::APPROX_COUNT_DISTINCT:
+    case Term::APPROX_QUANTILE:
     case Term::MIN:
     case Term::MAX:
     case Term::UNION:
@@ -962,6 +965,7 @@ static void pprint_update_reminder() {
     case Term::EQ_JOIN:
     case Term::ZIP:
     case Term::RANGE:
+    case Term::CHUNKS:
     case Term::INSERT_AT:
     case Term::DELETE_AT:
     case Term::CHANGE_AT:
@@ -173,12 +173,14 @@ ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(durability_requirement_t,
                                       DURABILITY_REQUIREMENT_DEFAULT,
                                       DURABILITY_REQUIREMENT_SOFT);
 
-enum class read_mode_t { MAJORITY, SINGLE, OUTDATED, DEBUG_DIRECT };
+/* `BOUNDED_STALENESS` reads are served by any replica that is no further behind the
+primary replica than `read_t::max_staleness_ms`, and by the primary otherwise. */
+enum class read_mode_t { MAJORITY, SINGLE, OUTDATED, DEBUG_DIRECT, BOUNDED_STALENESS };
 
 ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(read_mode_t,
                                       int8_t,
                                       read_mode_t::MAJORITY,
-                                      read_mode_t::DEBUG_DIRECT);
+                                      read_mode_t::BOUNDED_STALENESS);
 
 ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(
         reql_version_t, int8_t,
@@ -19,7 +19,7 @@ void caching_cfeed_artificial_table_backend_t::notify_row(const ql::datum_t &pke
             individual row */
             if (caching_machinery.second->dirtiness !=
                     caching_machinery_t::dirtiness_t::none_or_some) {
-                return;
+                continue;
             }
             caching_machinery.second->dirty_keys.insert(pkey);
             if (caching_machinery.second->waker != nullptr) {
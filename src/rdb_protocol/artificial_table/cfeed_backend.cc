@@ -21,7 +21,8 @@ void cfeed_artificial_table_backend_t::machinery_t::send_all_change(
                 index_vals_t(),
                 pkey,
                 old_val,
-                new_val}));
+                new_val,
+                0}));
 }
 
 void cfeed_artificial_table_backend_t::machinery_t::send_all_stop() {
@@ -90,7 +91,9 @@ bool cfeed_artificial_table_backend_t::read_changes(
     on_thread_t thread_switcher(home_thread());
     new_mutex_acq_t mutex_lock(&mutex, &interruptor2);
 
-    auth::user_context_t user_context = env->get_user_context();
+    auth::user_context_t user_context = rows_depend_on_user()
+        ? env->get_user_context()
+        : auth::user_context_t();
     auto &machinery = machineries[user_context];
     if (!machinery.has()) {
         machinery = construct_changefeed_machinery(
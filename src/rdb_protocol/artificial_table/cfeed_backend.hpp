@@ -83,6 +83,13 @@ protected:
     /* `cfeed_artificial_table_backend_t` guarantees that it will never have two sets of
     machinery in existence at the same time. */
 
+    /* There is one set of machinery for each user with changefeeds on the table,
+    because the rows that a user sees can depend on their permissions. Subclasses
+    whose rows are the same for every user should return `false`, so that all the
+    changefeeds share one set of machinery and the rows are only fetched and compared
+    once, however many users are subscribed. */
+    virtual bool rows_depend_on_user() const { return true; }
+
     /* Subclasses should override this to return their own subclass of `machinery_t`. */
     virtual scoped_ptr_t<machinery_t> construct_changefeed_machinery(
         lifetime_t<name_resolver_t const &> name_resolver,
@@ -13,6 +13,11 @@ namespace ql {
 static const int64_t DEFAULT_MIN_ELS = 1;
 static const int64_t DEFAULT_FIRST_SCALEDOWN = 4;
 static const int64_t DEFAULT_MAX_SIZE = MEGABYTE;
+// How far `adaptive_batch_size_t` may scale up `DEFAULT_MAX_SIZE`
+static const int64_t MAX_ADAPTIVE_SCALE = 16;
+// A client that takes this many times longer with a batch than we took to read it
+// gets smaller batches.
+static const int64_t SLOW_CLIENT_FACTOR = 8;
 // The maximum duration of a batch in microseconds.
 static const kiloticks_t DEFAULT_MAX_DURATION{500 * 1000};
 // These numbers are sort of arbitrary, but they seem to work. See `scale_down()`
@@ -22,8 +27,10 @@ static const int64_t DIVISOR_SCALING_FACTOR = 8;
 // Make sure that `with_at_most` followed by `scale_down` sometimes undersizes
 // batches in debug mode so that we can test `batchspec_t::all()` logic.
 static const int64_t SCALE_CONSTANT = 0;
+static const int64_t LIMIT_SCALE_CONSTANT = 1;
 #else
 static const int64_t SCALE_CONSTANT = 32;
+static const int64_t LIMIT_SCALE_CONSTANT = 2;
 #endif // NDEBUG
 
 batchspec_t::batchspec_t(
@@ -79,7 +86,7 @@ static bool set_if_present(const char *argname, env_t *env, datum_t * dest) {
     }
 }
 
-batchspec_t batchspec_t::user(batch_type_t batch_type, env_t *env) {
+batchspec_t batchspec_t::user(batch_type_t batch_type, env_t *env, int64_t size_scale) {
     const double SECS_TO_USECS = 1000 * 1000;
     // Kind of arbitrarily set to 1 day, but makes sure we don't overflow when
     // casting from double to int64_t
@@ -101,7 +108,9 @@ batchspec_t batchspec_t::user(batch_type_t batch_type, env_t *env) {
     int64_t min_els = min_els_d.has()
                       ? min_els_d.as_int()
                       : std::min<int64_t>(max_els, DEFAULT_MIN_ELS);
-    int64_t max_size = max_size_d.has() ? max_size_d.as_int() : DEFAULT_MAX_SIZE;
+    int64_t max_size = max_size_d.has()
+                       ? max_size_d.as_int()
+                       : DEFAULT_MAX_SIZE * size_scale;
     int64_t first_sd = first_scaledown_d.has()
                        ? first_scaledown_d.as_int()
                        : DEFAULT_FIRST_SCALEDOWN;
@@ -137,6 +146,31 @@ batchspec_t batchspec_t::user(batch_type_t batch_type, env_t *env) {
                        get_kiloticks());
 }
 
+adaptive_batch_size_t::adaptive_batch_size_t()
+    : scale(1), has_sent(false), last_sent{0}, last_duration{0} { }
+
+void adaptive_batch_size_t::note_request(kiloticks_t now) {
+    if (!has_sent) {
+        return;
+    }
+    int64_t gap = now.micros - last_sent.micros;
+    if (gap < last_duration.micros) {
+        scale = std::min(scale * 2, MAX_ADAPTIVE_SCALE);
+    } else if (gap > SLOW_CLIENT_FACTOR * last_duration.micros) {
+        scale = std::max<int64_t>(scale / 2, 1);
+    }
+}
+
+void adaptive_batch_size_t::note_sent(kiloticks_t now, kiloticks_t duration) {
+    has_sent = true;
+    last_sent = now;
+    last_duration = duration;
+}
+
+batchspec_t adaptive_batch_size_t::user(batch_type_t batch_type, env_t *env) const {
+    return batchspec_t::user(batch_type, env, scale);
+}
+
 batchspec_t batchspec_t::with_new_batch_type(batch_type_t new_batch_type) const {
     return batchspec_t(new_batch_type, min_els, max_els, max_size,
                        first_scaledown_factor, max_dur, start_time);
@@ -175,6 +209,18 @@ batchspec_t batchspec_t::with_at_most(uint64_t raw_max_els) const {
         start_time);
 }
 
+batchspec_t batchspec_t::with_limit(uint64_t _limit) const {
+    batchspec_t ret = with_at_most(_limit);
+    ret.limit.set(_limit);
+    return ret;
+}
+
+batchspec_t batchspec_t::with_everything() const {
+    batchspec_t ret = all();
+    ret.lazy_sorting_override = lazy_sorting_override;
+    return ret;
+}
+
 batchspec_t batchspec_t::with_lazy_sorting_override(sorting_t sort) const {
     batchspec_t ret = *this;
     ret.lazy_sorting_override.set(sort);
@@ -199,6 +245,25 @@ batchspec_t batchspec_t::scale_down(int64_t divisor) const {
             : std::min(max_size, (max_size * DIVISOR_SCALING_FACTOR
                                   / ((DIVISOR_SCALING_FACTOR - 1) * divisor))
                                  + SCALE_CONSTANT);
+    if (limit.has_value()) {
+        // The shards only have to find `*limit` rows between all of them, but each
+        // of them would look for up to that many (after skipping past the rows that
+        // don't pass the filters) if we let the constant above decide. So every
+        // shard looks for its share plus a little slack instead. If the rows are
+        // spread out unevenly, the reader reads again, but not from the parts of
+        // the table that are exhausted or whose rows weren't all used yet (see
+        // `active_ranges_to_hints()`).
+        int64_t wanted = std::min(
+            max_els, static_cast<int64_t>(std::min<uint64_t>(
+                *limit, std::numeric_limits<int64_t>::max())));
+        int64_t share = wanted / divisor
+            + wanted / ((DIVISOR_SCALING_FACTOR - 1) * divisor)
+            + LIMIT_SCALE_CONSTANT;
+        new_max_els = std::min(new_max_els, share);
+        return batchspec_t(batch_type, std::min(min_els, new_max_els), new_max_els,
+                           new_max_size, first_scaledown_factor, max_dur, start_time);
+    }
+
     // to avoid problems when the batches get really tiny, we clamp new_max_els
     // to be at least min_els.
     new_max_els = std::max(min_els, new_max_els);
@@ -79,7 +79,9 @@ private:
 
 class batchspec_t {
 public:
-    static batchspec_t user(batch_type_t batch_type, env_t *env);
+    // `size_scale` multiplies the default byte limit of a batch, but not one the
+    // user set with `max_batch_bytes`.
+    static batchspec_t user(batch_type_t batch_type, env_t *env, int64_t size_scale = 1);
     static batchspec_t all(); // Gimme everything.
     static batchspec_t empty() { return batchspec_t(); }
     static batchspec_t default_for(batch_type_t batch_type);
@@ -88,6 +90,12 @@ public:
     batchspec_t with_min_els(int64_t new_min_els) const;
     batchspec_t with_max_dur(kiloticks_t new_max_dur) const;
     batchspec_t with_at_most(uint64_t max_els) const;
+    // Like `with_at_most`, for a stream that's cut off after `limit` more rows (by
+    // `limit`, `slice` or `nth`). The shards of a range read then only look for
+    // their share of those rows, see `scale_down()`.
+    batchspec_t with_limit(uint64_t limit) const;
+    // Like `all()`, but keeps the ordering override below.
+    batchspec_t with_everything() const;
 
     // These are used to allow batchspecs to override the default ordering on a
     // stream.  This is only really useful when a stream is being treated as a
@@ -119,9 +127,35 @@ private:
     kiloticks_t max_dur;
     kiloticks_t start_time;
     optional<sorting_t> lazy_sorting_override;
+    // Set by `with_limit()`. Like `lazy_sorting_override` it's only used on the
+    // server that splits up the read, so it isn't serialized.
+    optional<uint64_t> limit;
 };
 RDB_DECLARE_SERIALIZABLE(batchspec_t);
 
+/* Sizes the batches of a stream that's served to a client by how quickly the client
+comes back for more. A client that asks for the next batch in less time than it took
+us to read the last one is waiting on us, so it gets bigger batches and fewer round
+trips. One that takes much longer than that is the bottleneck itself, so it gets
+smaller batches again, which are cheaper to hold on to. */
+class adaptive_batch_size_t {
+public:
+    adaptive_batch_size_t();
+
+    // When the client asks for the next batch
+    void note_request(kiloticks_t now);
+    // When a batch that took `duration` to read is handed to the client
+    void note_sent(kiloticks_t now, kiloticks_t duration);
+
+    batchspec_t user(batch_type_t batch_type, env_t *env) const;
+
+private:
+    int64_t scale;
+    bool has_sent;
+    kiloticks_t last_sent;
+    kiloticks_t last_duration;
+};
+
 } // namespace ql
 
 #endif // RDB_PROTOCOL_BATCHING_HPP_
@@ -10,6 +10,9 @@
 
 #include "btree/concurrent_traversal.hpp"
 #include "btree/get_distribution.hpp"
+#include "btree/internal_node.hpp"
+#include "btree/leaf_node.hpp"
+#include "btree/node.hpp"
 #include "btree/operations.hpp"
 #include "btree/reql_specific.hpp"
 #include "btree/superblock.hpp"
@@ -20,17 +23,22 @@
 #include "containers/archive/boost_types.hpp"
 #include "containers/archive/buffer_group_stream.hpp"
 #include "containers/archive/buffer_stream.hpp"
+#include "containers/archive/vector_stream.hpp"
 #include "containers/scoped.hpp"
 #include "rdb_protocol/geo/exceptions.hpp"
 #include "rdb_protocol/geo/indexing.hpp"
 #include "rdb_protocol/blob_wrapper.hpp"
+#include "rdb_protocol/filter_kernel.hpp"
 #include "rdb_protocol/func.hpp"
 #include "rdb_protocol/geo_traversal.hpp"
 #include "rdb_protocol/lazy_btree_val.hpp"
+#include "rdb_protocol/parallel_transform.hpp"
 #include "rdb_protocol/pseudo_geometry.hpp"
 #include "rdb_protocol/serialize_datum_onto_blob.hpp"
 #include "rdb_protocol/shards.hpp"
 #include "rdb_protocol/table_common.hpp"
+#include "random.hpp"
+#include "time.hpp"
 
 #include "debug.hpp"
 
@@ -135,23 +143,63 @@ void kv_location_delete(keyvalue_location_t *kv_location,
             deletion_context->balancing_detacher(), &null_cb, delete_mode);
 }
 
+/* Usually the new value is written onto newly allocated blob blocks, and the old value's
+blocks are freed once the secondary indexes have been updated. If
+`may_patch_in_place` is true and the new value serializes to exactly as many bytes as
+the old one, which is stored outside the leaf node, we instead overwrite the old
+value's blocks, so that only the blocks that actually change get written. This is the
+common case for updates like `{counter: x + 1}` on large rows. The caller must make
+sure that no secondary index points at the row's blocks, since those would otherwise
+see the new value under the old index entries. */
 MUST_USE ql::serialization_result_t
 kv_location_set(keyvalue_location_t *kv_location,
                 const store_key_t &key,
                 ql::datum_t data,
                 repli_timestamp_t timestamp,
                 const deletion_context_t *deletion_context,
+                bool may_patch_in_place,
                 rdb_modification_info_t *mod_info_out) THROWS_NOTHING {
-    scoped_malloc_t<rdb_value_t> new_value(blob::btree_maxreflen);
-    memset(new_value.get(), 0, blob::btree_maxreflen);
+    // Check for errors to enforce the static array size limit when writing to disk
+    write_message_t wm;
+    ql::serialization_result_t res =
+        datum_serialize(&wm, data, ql::check_datum_serialization_errors_t::YES);
+    if (bad(res)) return res;
 
     const max_block_size_t block_size = kv_location->buf.cache()->max_block_size();
+
+    if (may_patch_in_place
+        && kv_location->value.has()
+        && !kv_location->value_as<rdb_value_t>()->is_inline()) {
+        rdb_value_t *old_value = kv_location->value_as<rdb_value_t>();
+        blob_t blob(block_size, old_value->value_ref(), blob::btree_maxreflen);
+        if (patch_blob_in_place(buf_parent_t(&kv_location->buf), &blob, wm)) {
+            if (mod_info_out != nullptr) {
+                // The old and the new value have the same ref, which tells
+                // `rdb_update_sindexes` not to delete the blocks.
+                guarantee(mod_info_out->added.second.empty());
+                guarantee(mod_info_out->deleted.second.empty());
+                mod_info_out->added.second.assign(
+                    old_value->value_ref(),
+                    old_value->value_ref() + old_value->inline_size(block_size));
+                mod_info_out->deleted.second = mod_info_out->added.second;
+            }
+
+            // The leaf still has to be touched, to update its recency for backfills.
+            null_key_modification_callback_t null_cb;
+            rdb_value_sizer_t sizer(block_size);
+            apply_keyvalue_change(&sizer, kv_location, key.btree_key(),
+                                  timestamp,
+                                  deletion_context->balancing_detacher(), &null_cb,
+                                  delete_mode_t::REGULAR_QUERY);
+            return ql::serialization_result_t::SUCCESS;
+        }
+    }
+
+    scoped_malloc_t<rdb_value_t> new_value(blob::btree_maxreflen);
+    memset(new_value.get(), 0, blob::btree_maxreflen);
     {
         blob_t blob(block_size, new_value->value_ref(), blob::btree_maxreflen);
-        ql::serialization_result_t res
-            = datum_serialize_onto_blob(buf_parent_t(&kv_location->buf),
-                                        &blob, data);
-        if (bad(res)) return res;
+        write_onto_blob(buf_parent_t(&kv_location->buf), &blob, wm);
     }
 
     if (mod_info_out) {
@@ -213,6 +261,7 @@ batched_replace_response_t rdb_replace_and_return_superblock(
     const btree_loc_info_t &info,
     const btree_point_replacer_t *replacer,
     const deletion_context_t *deletion_context,
+    bool may_patch_in_place,
     promise_t<superblock_t *> *superblock_promise,
     rdb_modification_info_t *mod_info_out,
     profile::trace_t *trace) {
@@ -272,7 +321,7 @@ batched_replace_response_t rdb_replace_and_return_superblock(
                 ql::serialization_result_t res =
                     kv_location_set(&kv_location, *info.key, new_val,
                                     info.btree->timestamp, deletion_context,
-                                    mod_info_out);
+                                    may_patch_in_place, mod_info_out);
                 if (res & ql::serialization_result_t::ARRAY_TOO_BIG) {
                     rfail_typed_target(&new_val, "Array too large for disk writes "
                                        "(limit 100,000 elements).");
@@ -336,16 +385,18 @@ ql::datum_t btree_batched_replacer_t::apply_write_hook(
         }
         ql::datum_t modified;
         try {
-            cond_t non_interruptor;
-            ql::env_t write_hook_env(&non_interruptor,
-                                     ql::return_empty_normal_batches_t::NO,
-                                     reql_version_t::LATEST);
+            if (!write_hook_env.has()) {
+                write_hook_env.init(
+                    new ql::env_t(&write_hook_non_interruptor,
+                                  ql::return_empty_normal_batches_t::NO,
+                                  reql_version_t::LATEST));
+            }
 
             ql::datum_object_builder_t builder;
             builder.overwrite("primary_key", std::move(primary_key));
             builder.overwrite("timestamp", write_timestamp);
 
-            modified = write_hook->call(&write_hook_env,
+            modified = write_hook->call(write_hook_env.get(),
                                         std::vector<ql::datum_t>{
                                             std::move(builder).to_datum(),
                                                 d,
@@ -398,6 +449,7 @@ void do_a_replace_from_batched_replace(
     const ql::configured_limits_t &limits,
     promise_t<superblock_t *> *superblock_promise,
     rdb_modification_report_cb_t *mod_cb,
+    bool may_patch_in_place,
     bool update_pkey_cfeeds,
     batched_replace_response_t *stats_out,
     profile::trace_t *trace,
@@ -413,8 +465,8 @@ void do_a_replace_from_batched_replace(
     rdb_live_deletion_context_t deletion_context;
     rdb_modification_report_t mod_report(*info.key);
     ql::datum_t res = rdb_replace_and_return_superblock(
-        info, &one_replace, &deletion_context, superblock_promise, &mod_report.info,
-        trace);
+        info, &one_replace, &deletion_context, may_patch_in_place, superblock_promise,
+        &mod_report.info, trace);
     *stats_out = (*stats_out).merge(res, ql::stats_merge, limits, conditions);
 
     // We wait to make sure we acquire `acq` in the same order we were
@@ -462,16 +514,33 @@ batched_replace_response_t rdb_batched_replace(
                 f();
             }
         } callback;
-        const size_t MAX_CONCURRENT_REPLACES = 8;
+        // Keys that share a leaf wait for each other on the leaf's lock, so this
+        // has to be well above the number of leaves we want to work on at once.
+        const size_t MAX_CONCURRENT_REPLACES = 32;
         coro_pool_t<std::function<void()> > coro_pool(
             MAX_CONCURRENT_REPLACES, &coro_queue, &callback);
         // We release the superblock either before or after draining on all the
         // write operations depending on the presence of limit changefeeds.
         scoped_ptr_t<real_superblock_t> current_superblock(superblock->release());
         bool update_pkey_cfeeds = sindex_cb->has_pkey_cfeeds(keys);
+        // Rows can only be patched in place if no secondary index tree shares their
+        // blob blocks.
+        bool may_patch_in_place = !sindex_cb->has_sindexes();
+        // We replace the keys in key order, so that the replaces that go to the same
+        // leaf follow each other and find it in the cache, and the ones that are
+        // running at the same time are spread over neighboring leaves. The sort is
+        // stable so that several replaces of the same key still happen in the order
+        // they were given in.
+        std::vector<size_t> order(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return keys[a] < keys[b];
+        });
         {
             auto_drainer_t drainer;
-            for (size_t i = 0; i < keys.size(); ++i) {
+            for (size_t i : order) {
                 promise_t<superblock_t *> superblock_promise;
                 coro_queue.push(
                     std::bind(
@@ -484,6 +553,7 @@ batched_replace_response_t rdb_batched_replace(
                         limits,
                         &superblock_promise,
                         sindex_cb,
+                        may_patch_in_place,
                         update_pkey_cfeeds,
                         &stats,
                         trace,
@@ -539,7 +609,7 @@ void rdb_set(const store_key_t &key,
     if (overwrite || !had_value) {
         ql::serialization_result_t res =
             kv_location_set(&kv_location, key, data, timestamp, deletion_context,
-                            mod_info);
+                            false, mod_info);
         if (res & ql::serialization_result_t::ARRAY_TOO_BIG) {
             rfail_typed_target(&data, "Array too large for disk writes "
                                "(limit 100,000 elements).");
@@ -606,13 +676,37 @@ public:
                        key_range_t *_active_region_range_inout,
                        reql_version_t wire_func_reql_version,
                        ql::map_wire_func_t wire_func,
-                       sindex_multi_bool_t _multi)
+                       sindex_multi_bool_t _multi,
+                       const std::vector<transform_variant_t> &transforms,
+                       const std::vector<sindex_intersection_t> &_intersections)
         : pkey_range(std::move(_pkey_range)),
           datumspec(std::move(_datumspec)),
           active_region_range_inout(_active_region_range_inout),
           func_reql_version(wire_func_reql_version),
           func(wire_func.compile_wire_func()),
-          multi(_multi) {
+          multi(_multi),
+          covered_by_key(false) {
+        if (multi == sindex_multi_bool_t::SINGLE && !transforms.empty()) {
+            key_projection = ql::sindex_key_projection_t::make(func, func_reql_version);
+        }
+        if (key_projection.has()) {
+            if (const ql::filter_wire_func_t *filter =
+                    boost::get<ql::filter_wire_func_t>(&transforms[0])) {
+                key_filter = ql::sindex_key_filter_t::make(
+                    key_projection.get(), *filter);
+            }
+            // Rows rebuilt from the key can't be checked against other indexes.
+            covered_by_key = _intersections.empty()
+                && is_covered(*key_projection, transforms);
+        }
+        for (const sindex_intersection_t &intersection : _intersections) {
+            intersections.push_back(intersection_t{
+                intersection.info.mapping.compile_wire_func(),
+                intersection.info.mapping_version_info.latest_compatible_reql_version,
+                intersection.info.multi,
+                intersection.key,
+                intersection.primary_keys});
+        }
         datumspec.visit<void>(
             [&](const ql::datum_range_t &r) {
                 lbound_trunc_key = r.get_left_bound_trunc_key(func_reql_version);
@@ -622,12 +716,65 @@ public:
     }
 private:
     friend class rget_cb_t;
+
+    // Whether `transforms` are some `filter`s and a `map` that only look at the
+    // fields in the index key, so the row itself doesn't matter.
+    static bool is_covered(const ql::sindex_key_projection_t &projection,
+                           const std::vector<transform_variant_t> &transforms) {
+        if (transforms.empty()) {
+            return false;
+        }
+        for (size_t i = 0; i + 1 < transforms.size(); ++i) {
+            const ql::filter_wire_func_t *filter =
+                boost::get<ql::filter_wire_func_t>(&transforms[i]);
+            if (filter == nullptr
+                || filter->default_filter_val.has_value()
+                || !projection.covers(filter->filter_func.compile_wire_func())) {
+                return false;
+            }
+        }
+        const ql::map_wire_func_t *map =
+            boost::get<ql::map_wire_func_t>(&transforms.back());
+        return map != nullptr && projection.covers(map->compile_wire_func());
+    }
+
+    // Whether the primary key `pkey` is among those collected for every
+    // intersected index that has them.
+    bool may_be_intersected(const std::string &pkey) const {
+        for (const intersection_t &intersection : intersections) {
+            if (intersection.primary_keys.has_value()
+                && !std::binary_search(intersection.primary_keys->begin(),
+                                       intersection.primary_keys->end(),
+                                       pkey)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    struct intersection_t {
+        counted_t<const ql::func_t> func;
+        reql_version_t func_reql_version;
+        sindex_multi_bool_t multi;
+        ql::datum_t key;
+        optional<std::vector<std::string> > primary_keys;
+    };
+
     const key_range_t pkey_range;
     const ql::datumspec_t datumspec;
     key_range_t *active_region_range_inout;
     const reql_version_t func_reql_version;
     const counted_t<const ql::func_t> func;
     const sindex_multi_bool_t multi;
+    // Set if we can get the indexed fields of a row from its key
+    scoped_ptr_t<ql::sindex_key_projection_t> key_projection;
+    // Set if the first transformation is a `filter` we can check against the keys
+    scoped_ptr_t<ql::sindex_key_filter_t> key_filter;
+    // Whether the transformations only need the indexed fields, so that rows can be
+    // rebuilt from their keys instead of being loaded
+    bool covered_by_key;
+    // The other indexes that `get_all` with `intersect` has rows match
+    std::vector<intersection_t> intersections;
     // The (truncated) boundary keys for the datum range stored in `datumspec`.
     std::string lbound_trunc_key;
     std::string rbound_trunc_key;
@@ -657,6 +804,7 @@ public:
             transformers.push_back(ql::make_op(_transforms[i]));
         }
         guarantee(transformers.size() == _transforms.size());
+        parallel = ql::parallel_transformer_t::make(env, _transforms);
     }
     job_data_t(job_data_t &&) = default;
 
@@ -668,6 +816,8 @@ private:
     ql::env_t *const env;
     scoped_ptr_t<ql::batcher_t> batcher;
     std::vector<scoped_ptr_t<ql::op_t> > transformers;
+    // Empty unless `transformers` may run on other threads
+    scoped_ptr_t<ql::parallel_transformer_t> parallel;
     sorting_t sorting;
     scoped_ptr_t<ql::accumulator_t> accumulator;
 };
@@ -697,11 +847,24 @@ public:
         THROWS_ONLY(interrupted_exc_t);
     void finish(continue_bool_t last_cb) THROWS_ONLY(interrupted_exc_t);
 private:
+    // Used instead of the rest of `handle_pair` once `job.parallel` is active.
+    continue_bool_t defer_pair(store_key_t &&key, ql::datums_t &&rows)
+        THROWS_ONLY(interrupted_exc_t, ql::base_exc_t);
+    continue_bool_t flush_deferred() THROWS_ONLY(interrupted_exc_t, ql::base_exc_t);
+    // Whether `val` has the key of every index in `sindex->intersections`
+    bool matches_intersections(const ql::datum_t &val);
+
     const rget_io_data_t io; // How do get data in/out.
     job_data_t job; // What to do next (stateful).
     const optional<rget_sindex_data_t> sindex; // Optional sindex information.
 
     scoped_ptr_t<ql::env_t> sindex_env;
+    std::vector<scoped_ptr_t<ql::env_t> > intersection_envs;
+
+    // Rows we've read in order but haven't transformed yet, and their keys
+    std::vector<store_key_t> deferred_keys;
+    std::vector<ql::datums_t> deferred_rows;
+    bool deferred_aborted;
 
     // State for internal bookkeeping.
     bool bad_init;
@@ -741,15 +904,25 @@ rget_cb_t::rget_cb_t(rget_io_data_t &&_io,
     : io(std::move(_io)),
       job(std::move(_job)),
       sindex(std::move(_sindex)),
+      deferred_aborted(false),
       bad_init(false) {
 
     if (sindex) {
+        // The secondary index bookkeeping in `handle_pair` has to see every row as
+        // it's transformed.
+        job.parallel.reset();
         // Secondary index functions are deterministic (so no need for an
         // rdb_context_t) and evaluated in a pristine environment (without global
         // optargs).
         sindex_env.init(new ql::env_t(job.env->interruptor,
                                       ql::return_empty_normal_batches_t::NO,
                                       sindex->func_reql_version));
+        for (const auto &intersection : sindex->intersections) {
+            intersection_envs.push_back(make_scoped<ql::env_t>(
+                job.env->interruptor,
+                ql::return_empty_normal_batches_t::NO,
+                intersection.func_reql_version));
+        }
     }
 
     // We must disable profiler events for subtasks, because multiple instances
@@ -761,9 +934,93 @@ rget_cb_t::rget_cb_t(rget_io_data_t &&_io,
 }
 
 void rget_cb_t::finish(continue_bool_t last_cb) THROWS_ONLY(interrupted_exc_t) {
+    if (!deferred_rows.empty()
+        && boost::get<ql::exc_t>(&io.response->result) == nullptr) {
+        try {
+            if (flush_deferred() == continue_bool_t::ABORT) {
+                last_cb = continue_bool_t::ABORT;
+            }
+        } catch (const ql::exc_t &e) {
+            io.response->result = e;
+        } catch (const ql::datum_exc_t &e) {
+            io.response->result = ql::exc_t(e, ql::backtrace_id_t::empty());
+        }
+    }
     job.accumulator->finish(last_cb, &io.response->result);
 }
 
+continue_bool_t rget_cb_t::defer_pair(store_key_t &&key, ql::datums_t &&rows)
+    THROWS_ONLY(interrupted_exc_t, ql::base_exc_t) {
+    if (deferred_aborted) {
+        return continue_bool_t::ABORT;
+    }
+    deferred_keys.push_back(std::move(key));
+    deferred_rows.push_back(std::move(rows));
+    if (deferred_rows.size() < job.parallel->batch_rows()) {
+        return continue_bool_t::CONTINUE;
+    }
+    return flush_deferred();
+}
+
+continue_bool_t rget_cb_t::flush_deferred()
+    THROWS_ONLY(interrupted_exc_t, ql::base_exc_t) {
+    if (job.env->interruptor->is_pulsed()) {
+        throw interrupted_exc_t();
+    }
+    job.parallel->transform(&deferred_rows);
+    guarantee(deferred_rows.size() == deferred_keys.size());
+
+    // Rows after the one that filled up the batch were read ahead of time, but the
+    // accumulator never sees them, so the next batch starts right after the last row
+    // that made it in.
+    continue_bool_t cont = continue_bool_t::CONTINUE;
+    for (size_t i = 0; i < deferred_rows.size() && cont == continue_bool_t::CONTINUE;
+         ++i) {
+        ql::groups_t data;
+        if (!deferred_rows[i].empty()) {
+            data[ql::datum_t()] = std::move(deferred_rows[i]);
+        }
+        cont = (*job.accumulator)(
+            job.env, &data, deferred_keys[i], []() { return ql::datum_t(); });
+    }
+    deferred_keys.clear();
+    deferred_rows.clear();
+    if (cont == continue_bool_t::ABORT) {
+        deferred_aborted = true;
+    }
+    return cont;
+}
+
+bool rget_cb_t::matches_intersections(const ql::datum_t &val) {
+    if (!sindex) {
+        return true;
+    }
+    for (size_t i = 0; i < sindex->intersections.size(); ++i) {
+        const auto &intersection = sindex->intersections[i];
+        ql::datum_t index_val;
+        try {
+            index_val = intersection.func->call(
+                intersection_envs[i].get(), val)->as_datum();
+        } catch (const ql::base_exc_t &) {
+            // Rows the index function fails on aren't in the index.
+            return false;
+        }
+        bool found = false;
+        if (intersection.multi == sindex_multi_bool_t::MULTI
+            && index_val.get_type() == ql::datum_t::R_ARRAY) {
+            for (size_t j = 0; j < index_val.arr_size() && !found; ++j) {
+                found = index_val.get(j) == intersection.key;
+            }
+        } else {
+            found = index_val == intersection.key;
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    return true;
+}
+
 // Handle a keyvalue pair.  Returns whether or not we're done early.
 continue_bool_t rget_cb_t::handle_pair(
     scoped_key_value_t &&keyvalue,
@@ -784,19 +1041,30 @@ continue_bool_t rget_cb_t::handle_pair(
     if (sindex && !sindex->pkey_range.contains_key(ql::datum_t::extract_primary(key))) {
         return continue_bool_t::CONTINUE;
     }
-    lazy_btree_val_t row(static_cast<const rdb_value_t *>(keyvalue.value()),
-                         keyvalue.expose_buf());
     ql::datum_t val;
     // Count stats whether or not we deserialize the value
     io.slice->stats.pm_keys_read.record();
     io.slice->stats.pm_total_keys_read += 1;
-    // We only load the value if we actually use it (`count` does not).
-    if (job.accumulator->uses_val() || job.transformers.size() != 0 || sindex) {
-        val = row.get();
-    } else {
-        row.reset();
+    // Rows the key alone rules out still go through the ordered part below, so that
+    // the active region range covers them.
+    const bool filtered_by_key = sindex
+        && ((sindex->key_filter.has()
+             && !sindex->key_filter->may_match(key, job.env->limits()))
+            || (!sindex->intersections.empty()
+                && !sindex->may_be_intersected(key_to_unescaped_str(
+                       ql::datum_t::extract_primary(key)))));
+    // We only load the value if we actually use it (`count` does not).  Since this is
+    // a read, inline values can point into the leaf's page copy rather than each
+    // getting a buffer of their own.
+    if (!filtered_by_key
+        && (job.accumulator->uses_val() || job.transformers.size() != 0 || sindex)) {
+        if (sindex && sindex->covered_by_key) {
+            val = sindex->key_projection->row_from_key(key);
+        }
+        if (!val.has()) {
+            val = get_data_from_page(&keyvalue);
+        }
     }
-    guarantee(!row.references_parent());
     keyvalue.reset();
     waiter.wait_interruptible(); // This enforces ordering.
 
@@ -847,6 +1115,9 @@ continue_bool_t rget_cb_t::handle_pair(
                 }
             }
         }
+        if (filtered_by_key || !matches_intersections(val)) {
+            return continue_bool_t::CONTINUE;
+        }
 
         // There are certain transformations and accumulators that need the
         // secondary index value, though many don't. We don't want to compute
@@ -976,11 +1247,20 @@ continue_bool_t rget_cb_t::handle_pair(
             }
         }
 
+        if (job.parallel.has() && job.parallel->is_active()) {
+            return defer_pair(std::move(key), ql::datums_t(copies, val));
+        }
+
         ql::groups_t data = {{ql::datum_t(), ql::datums_t(copies, val)}};
 
+        ticks_t transform_start = get_ticks();
         for (auto it = job.transformers.begin(); it != job.transformers.end(); ++it) {
             (**it)(job.env, &data, lazy_sindex_val);
         }
+        if (job.parallel.has()) {
+            job.parallel->note_inline_row(
+                ticks_t{get_ticks().nanos - transform_start.nanos});
+        }
         // We need lots of extra data for the accumulation because we might be
         // accumulating `rget_item_t`s for a batch.
         continue_bool_t cont = (*job.accumulator)(job.env, &data, key, lazy_sindex_val);
@@ -1007,6 +1287,89 @@ continue_bool_t rget_cb_t::handle_pair(
 }
 
 // TODO: Having two functions which are 99% the same sucks.
+/* Whether a primary index scan gives the same result no matter in which order it
+sees the rows, so that it can start in the middle of its range and wrap around (see
+`shared_scan_t`). That's the case for the terminals that add up the rows, when the
+transformations before them only look at one row at a time. */
+static bool can_share_scan(sorting_t sorting,
+                           const std::vector<transform_variant_t> &transforms,
+                           const optional<terminal_variant_t> &terminal) {
+    if (sorting != sorting_t::UNORDERED || !terminal.has_value()) {
+        return false;
+    }
+    if (boost::get<ql::count_wire_func_t>(&*terminal) == nullptr
+        && boost::get<ql::sum_wire_func_t>(&*terminal) == nullptr
+        && boost::get<ql::avg_wire_func_t>(&*terminal) == nullptr) {
+        return false;
+    }
+    for (const auto &transform : transforms) {
+        if (boost::get<ql::distinct_wire_func_t>(&transform) != nullptr
+            || boost::get<ql::zip_wire_func_t>(&transform) != nullptr) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* `apply_keyvalue_change()` keeps the number of keys in the B-tree in the stat block,
+so a count of all of them doesn't have to read any rows. Other ranges still have to be
+traversed, because the stat block only has the total. */
+static bool can_count_from_stat_block(
+        const key_range_t &range,
+        const optional<std::map<store_key_t, uint64_t> > &primary_keys,
+        const std::vector<transform_variant_t> &transforms,
+        const optional<terminal_variant_t> &terminal) {
+    return range == key_range_t::universe()
+        && !primary_keys.has_value()
+        && transforms.empty()
+        && terminal.has_value()
+        && boost::get<ql::count_wire_func_t>(&*terminal) != nullptr;
+}
+
+/* Returns false if the B-tree has no stat block. The stat block isn't part of the
+superblock's snapshot, so the count can include writes that came in after the read
+started, as a traversal that runs concurrently with them could. */
+static bool read_population(superblock_t *superblock, uint64_t *population_out) {
+    block_id_t stat_block_id = superblock->get_stat_block_id();
+    if (stat_block_id == NULL_BLOCK_ID) {
+        return false;
+    }
+    buf_lock_t stat_block(buf_parent_t(superblock->expose_buf().txn()),
+                          stat_block_id, access_t::read);
+    buf_read_t read(&stat_block);
+    uint16_t sb_size;
+    const btree_statblock_t *sb_data =
+        static_cast<const btree_statblock_t *>(read.get_data_read(&sb_size));
+    guarantee(sb_size == BTREE_STATBLOCK_SIZE);
+    if (sb_data->population < 0) {
+        return false;
+    }
+    *population_out = static_cast<uint64_t>(sb_data->population);
+    return true;
+}
+
+/* Keeps the position of a `shared_scan_t` up to date for the scans that join it. */
+class shared_scan_cb_t : public concurrent_traversal_callback_t {
+public:
+    shared_scan_cb_t(concurrent_traversal_callback_t *_cb, shared_scan_t *_scan)
+        : cb(_cb), scan(_scan), pairs_seen(0) { }
+    virtual continue_bool_t handle_pair(
+        scoped_key_value_t &&keyvalue,
+        concurrent_traversal_fifo_enforcer_signal_t waiter)
+        THROWS_ONLY(interrupted_exc_t) {
+        // The position only needs to be roughly right, so we don't copy every key
+        if (pairs_seen++ % POSITION_UPDATE_INTERVAL == 0) {
+            scan->position = store_key_t(keyvalue.key());
+        }
+        return cb->handle_pair(std::move(keyvalue), std::move(waiter));
+    }
+private:
+    static const uint64_t POSITION_UPDATE_INTERVAL = 16;
+    concurrent_traversal_callback_t *cb;
+    shared_scan_t *scan;
+    uint64_t pairs_seen;
+};
+
 void rdb_rget_slice(
         btree_slice_t *slice,
         const region_t &shard,
@@ -1026,6 +1389,21 @@ void rdb_rget_slice(
         "Do range scan on primary index.",
         ql_env->trace);
 
+    uint64_t population;
+    if (can_count_from_stat_block(range, primary_keys, transforms, terminal)
+        && read_population(superblock, &population)) {
+        if (release_superblock == release_superblock_t::RELEASE) {
+            superblock->release();
+        }
+        // This is what the count terminal's accumulator would have produced
+        response->result = ql::grouped_t<uint64_t>();
+        if (population > 0) {
+            boost::get<ql::grouped_t<uint64_t> >(&response->result)->insert(
+                std::make_pair(ql::datum_t(), population));
+        }
+        return;
+    }
+
     rget_cb_t callback(
         rget_io_data_t(response, slice),
         job_data_t(ql_env,
@@ -1071,6 +1449,33 @@ void rdb_rget_slice(
                 }
             }
         }
+    } else if (can_share_scan(sorting, transforms, terminal)) {
+        /* If another scan of the same range is in progress, we start where it is and
+        read the rest of the range right behind it, then wrap around to read the part
+        it had already read. Both traversals use the same snapshot. */
+        store_key_t start = shared_scan_t::join_position(slice, range);
+        shared_scan_t scan(slice, range);
+        rget_cb_wrapper_t wrapper(&callback, 1, r_nullopt);
+        shared_scan_cb_t scan_wrapper(&wrapper, &scan);
+        if (range.left < start) {
+            key_range_t head(
+                key_range_t::closed, range.left, key_range_t::open, start);
+            key_range_t tail = range;
+            tail.left = start;
+            scan.position = start;
+            cont = btree_concurrent_traversal(
+                superblock, tail, &scan_wrapper, direction,
+                release_superblock_t::KEEP);
+            if (cont == continue_bool_t::CONTINUE) {
+                cont = btree_concurrent_traversal(
+                    superblock, head, &scan_wrapper, direction, release_superblock);
+            }
+            // Otherwise, if required the superblock will get released further up the
+            // stack.
+        } else {
+            cont = btree_concurrent_traversal(
+                superblock, range, &scan_wrapper, direction, release_superblock);
+        }
     } else {
         rget_cb_wrapper_t wrapper(&callback, 1, r_nullopt);
         cont = btree_concurrent_traversal(
@@ -1079,6 +1484,60 @@ void rdb_rget_slice(
     callback.finish(cont);
 }
 
+// More rows than this under the key of an intersected index make it not selective
+// enough to be worth skipping rows by; we check the rows we load instead.
+static const size_t MAX_INTERSECTED_PRIMARY_KEYS = 16384;
+
+class intersected_primary_keys_cb_t : public depth_first_traversal_callback_t {
+public:
+    intersected_primary_keys_cb_t(const key_range_t *_pk_range,
+                                  std::vector<std::string> *_primary_keys_out)
+        : pk_range(_pk_range), primary_keys_out(_primary_keys_out) { }
+    continue_bool_t handle_pair(scoped_key_value_t &&keyvalue, signal_t *) {
+        store_key_t pkey =
+            ql::datum_t::extract_primary(store_key_t(keyvalue.key()));
+        if (!pk_range->contains_key(pkey)) {
+            return continue_bool_t::CONTINUE;
+        }
+        if (primary_keys_out->size() == MAX_INTERSECTED_PRIMARY_KEYS) {
+            return continue_bool_t::ABORT;
+        }
+        primary_keys_out->push_back(key_to_unescaped_str(pkey));
+        return continue_bool_t::CONTINUE;
+    }
+private:
+    const key_range_t *pk_range;
+    std::vector<std::string> *primary_keys_out;
+};
+
+optional<std::vector<std::string> > rdb_get_intersected_primary_keys(
+        sindex_superblock_t *superblock,
+        const ql::datum_t &key,
+        const sindex_disk_info_t &sindex_info,
+        const key_range_t &pk_range,
+        signal_t *interruptor) {
+    guarantee(sindex_info.geo == sindex_geo_bool_t::REGULAR);
+    std::vector<std::string> primary_keys;
+    intersected_primary_keys_cb_t cb(&pk_range, &primary_keys);
+    continue_bool_t cont = btree_depth_first_traversal(
+        superblock,
+        ql::datum_range_t(key).to_sindex_keyrange(
+            sindex_info.mapping_version_info.latest_compatible_reql_version),
+        &cb,
+        access_t::read,
+        FORWARD,
+        release_superblock_t::RELEASE,
+        interruptor);
+    if (cont == continue_bool_t::ABORT) {
+        return r_nullopt;
+    }
+    // A multi index can have the same row under the key more than once.
+    std::sort(primary_keys.begin(), primary_keys.end());
+    primary_keys.erase(std::unique(primary_keys.begin(), primary_keys.end()),
+                       primary_keys.end());
+    return make_optional(std::move(primary_keys));
+}
+
 void rdb_rget_secondary_slice(
         btree_slice_t *slice,
         const region_t &shard,
@@ -1094,7 +1553,8 @@ void rdb_rget_secondary_slice(
         require_sindexes_t require_sindex_val,
         const sindex_disk_info_t &sindex_info,
         rget_read_response_t *response,
-        release_superblock_t release_superblock) {
+        release_superblock_t release_superblock,
+        const std::vector<sindex_intersection_t> &intersections) {
     r_sanity_check(boost::get<ql::exc_t>(&response->result) == nullptr);
     guarantee(sindex_info.geo == sindex_geo_bool_t::REGULAR);
     PROFILE_STARTER_IF_ENABLED(
@@ -1124,7 +1584,9 @@ void rdb_rget_secondary_slice(
             &active_region_range,
             sindex_func_reql_version,
             sindex_info.mapping,
-            sindex_info.multi)));
+            sindex_info.multi,
+            transforms,
+            intersections)));
 
     direction_t direction = reversed(sorting) ? BACKWARD : FORWARD;
     auto cb = [&](const std::pair<ql::datum_range_t, uint64_t> &pair, bool is_last) {
@@ -1214,13 +1676,18 @@ void rdb_get_nearest_slice(
     const reql_version_t sindex_func_reql_version =
         sindex_info.mapping_version_info.latest_compatible_reql_version;
 
-    // TODO (daniel): Instead of calling this multiple times until we are done,
-    //   results should be streamed lazily. Also, even if we don't do that,
-    //   the copying of the result we do here is bad.
+    // Each pass over the index looks at the next batch of grid cells in the order
+    // of their distance from `center`, until the remaining cells can't hold any
+    // nearer results.
     nearest_traversal_state_t state(center, max_results, max_dist, geo_system);
-    response->results_or_error = nearest_geo_read_response_t::result_t();
-    do {
-        nearest_geo_read_response_t partial_response;
+    while (state.proceed_to_next_batch() == continue_bool_t::CONTINUE) {
+        PROFILE_STARTER_IF_ENABLED(
+            ql_env->profile() == profile_bool_t::PROFILE,
+            strprintf("Nearest traversal pass over %zu grid cells "
+                      "(%zu visited in total).",
+                      state.cells_in_batch(), state.cells_visited()),
+            ql_env->trace);
+        optional<ql::exc_t> error;
         try {
             nearest_traversal_cb_t callback(
                 slice,
@@ -1232,25 +1699,20 @@ void rdb_get_nearest_slice(
                 superblock, key_range_t::universe(), &callback,
                 direction_t::FORWARD,
                 release_superblock_t::KEEP);
-            callback.finish(&partial_response);
+            error = callback.finish();
         } catch (const geo_exception_t &e) {
-            partial_response.results_or_error =
-                ql::exc_t(ql::base_exc_t::LOGIC, e.what(),
-                          ql::backtrace_id_t::empty());
+            error.set(ql::exc_t(ql::base_exc_t::LOGIC, e.what(),
+                                ql::backtrace_id_t::empty()));
         }
-        if (boost::get<ql::exc_t>(&partial_response.results_or_error)) {
-            response->results_or_error = partial_response.results_or_error;
+        if (error) {
+            response->results_or_error = *error;
             return;
-        } else {
-            auto partial_res = boost::get<nearest_geo_read_response_t::result_t>(
-                &partial_response.results_or_error);
-            guarantee(partial_res != nullptr);
-            auto full_res = boost::get<nearest_geo_read_response_t::result_t>(
-                &response->results_or_error);
-            std::move(partial_res->begin(), partial_res->end(),
-                      std::back_inserter(*full_res));
-        }
-    } while (state.proceed_to_next_batch() == continue_bool_t::CONTINUE);
+        }
+    }
+
+    nearest_geo_read_response_t::result_t results;
+    state.finish(&results);
+    response->results_or_error = std::move(results);
 }
 
 void rdb_distribution_get(int max_depth,
@@ -1277,6 +1739,169 @@ void rdb_distribution_get(int max_depth,
     }
 }
 
+/* A walk goes down from the root to a random one of the children that overlap the
+range at every level, and then to a random row of the range in the leaf. If there were
+`f_1, ..., f_h` children or rows to choose from on the way, the walk ends at its row with
+probability `1 / (f_1 * ... * f_h)`, so the rows in sparse parts of the tree would come
+up more often than the others. To make every row equally likely, a walk is only kept
+with probability `(f_1 / m_1) * ... * (f_h / m_h)`, where `m_i` is the largest number of
+choices seen at that depth. (This is Olken's acceptance/rejection sampling, except that
+the bounds are learned from the walks rather than known in advance.)
+
+The average of `f_1 * ... * f_h` over all of the walks, including the ones that are
+thrown away, is an unbiased estimate of the number of rows in the range. */
+class btree_sampler_t {
+public:
+    btree_sampler_t(const key_range_t &_range, real_superblock_t *_superblock)
+        : range(_range), superblock(_superblock),
+          root_id(superblock->get_root_block_id()),
+          walks(0), inverse_probability_sum(0) { }
+
+    bool empty() const {
+        return root_id == NULL_BLOCK_ID;
+    }
+
+    void walk() {
+        ++walks;
+        std::vector<uint64_t> fanouts;
+        buf_lock_t lock(superblock->expose_buf(), root_id, access_t::read);
+        for (;;) {
+            block_id_t child_id;
+            {
+                buf_read_t read(&lock);
+                const node_t *node = static_cast<const node_t *>(read.get_data_read());
+                if (node::is_leaf(node)) {
+                    visit_leaf(reinterpret_cast<const leaf_node_t *>(node),
+                               buf_parent_t(&lock), &fanouts);
+                    return;
+                }
+                const internal_node_t *inode =
+                    reinterpret_cast<const internal_node_t *>(node);
+                int start_index =
+                    internal_node::get_offset_index(inode, range.left.btree_key());
+                int end_index;
+                if (range.right.unbounded) {
+                    end_index = inode->npairs;
+                } else {
+                    store_key_t r = range.right.key();
+                    r.decrement();
+                    end_index =
+                        internal_node::get_offset_index(inode, r.btree_key()) + 1;
+                }
+                fanouts.push_back(end_index - start_index);
+                int index = start_index + randint(end_index - start_index);
+                child_id = internal_node::get_pair_by_index(inode, index)->lnode;
+            }
+            buf_lock_t child(&lock, child_id, access_t::read);
+            lock = std::move(child);
+        }
+    }
+
+    double population() const {
+        return walks == 0 ? 0 : inverse_probability_sum / walks;
+    }
+
+    uint64_t walks_done() const {
+        return walks;
+    }
+
+    std::vector<ql::datum_t> rows;
+
+private:
+    void visit_leaf(const leaf_node_t *leaf,
+                    buf_parent_t parent,
+                    std::vector<uint64_t> *fanouts) {
+        leaf::iterator begin =
+            leaf::inclusive_lower_bound(range.left.btree_key(), *leaf);
+        uint64_t count = 0;
+        for (leaf::iterator it = begin; it != leaf::end(*leaf); ++it) {
+            if (!range.right.unbounded
+                && btree_key_cmp((*it).first, range.right.key().btree_key()) >= 0) {
+                break;
+            }
+            ++count;
+        }
+        if (count == 0) {
+            return;
+        }
+        fanouts->push_back(count);
+
+        if (max_fanouts.size() < fanouts->size()) {
+            max_fanouts.resize(fanouts->size(), 0);
+        }
+        double inverse_probability = 1;
+        double acceptance = 1;
+        for (size_t i = 0; i < fanouts->size(); ++i) {
+            max_fanouts[i] = std::max(max_fanouts[i], (*fanouts)[i]);
+            inverse_probability *= (*fanouts)[i];
+            acceptance *= static_cast<double>((*fanouts)[i]) / max_fanouts[i];
+        }
+        inverse_probability_sum += inverse_probability;
+        if (randdouble() >= acceptance) {
+            return;
+        }
+
+        leaf::iterator it = begin;
+        for (uint64_t i = randuint64(count); i > 0; --i) {
+            ++it;
+        }
+        store_key_t key((*it).first);
+        if (!seen.insert(key).second) {
+            return;
+        }
+        rows.push_back(get_data(static_cast<const rdb_value_t *>((*it).second), parent));
+    }
+
+    const key_range_t range;
+    real_superblock_t *const superblock;
+    const block_id_t root_id;
+    std::vector<uint64_t> max_fanouts;
+    std::set<store_key_t> seen;
+    uint64_t walks;
+    double inverse_probability_sum;
+};
+
+void rdb_sample_slice(const key_range_t &range,
+                      uint64_t num,
+                      real_superblock_t *superblock,
+                      signal_t *interruptor,
+                      sample_read_response_t *response)
+    THROWS_ONLY(interrupted_exc_t) {
+    // The population estimate needs some walks even if few rows were asked for
+    static const uint64_t MIN_WALKS = 64;
+    static const uint64_t MAX_WALKS_PER_ROW = 32;
+    // Below this many rows per sampled row, a full scan isn't much more expensive
+    static const uint64_t MIN_ROWS_PER_SAMPLE = 4;
+
+    btree_sampler_t sampler(range, superblock);
+    if (sampler.empty()) {
+        superblock->release();
+        response->complete = true;
+        return;
+    }
+    const uint64_t max_walks = MIN_WALKS + MAX_WALKS_PER_ROW * num;
+    while (sampler.rows.size() < num || sampler.walks_done() < MIN_WALKS) {
+        if (sampler.walks_done() >= max_walks
+            || (sampler.walks_done() >= MIN_WALKS
+                && sampler.population() < MIN_ROWS_PER_SAMPLE * num)) {
+            break;
+        }
+        if (interruptor->is_pulsed()) {
+            throw interrupted_exc_t();
+        }
+        sampler.walk();
+    }
+    superblock->release();
+
+    response->population = sampler.population();
+    response->complete = sampler.rows.size() >= num
+        && response->population >= MIN_ROWS_PER_SAMPLE * num;
+    if (response->complete) {
+        sampler.rows.resize(num);
+        response->rows = std::move(sampler.rows);
+    }
+}
+
 static const int8_t HAS_VALUE = 0;
 static const int8_t HAS_NO_VALUE = 1;
 
@@ -1393,6 +2018,7 @@ void rdb_modification_report_cb_t::on_mod_report(
     bool update_pkey_cfeeds,
     new_mutex_in_line_t *sindex_spot,
     rwlock_in_line_t *cfeed_stamp_spot) {
+    store_->row_cache.invalidate(report.primary_key);
     if (report.info.deleted.first.has() || report.info.added.first.has()) {
         // We spawn the sindex update in its own coroutine because we don't want to
         // hold the sindex update for the changefeed update or vice-versa.
@@ -1443,7 +2069,8 @@ void rdb_modification_report_cb_t::on_mod_report(
                         new_cfeed_keys,
                         report.primary_key,
                         report.info.deleted.first,
-                        report.info.added.first}),
+                        report.info.added.first,
+                        0}),
                 report.primary_key,
                 cfeed_stamp_spot,
                 cserver.second);
@@ -1536,6 +2163,13 @@ void compute_keys(const store_key_t &primary_key,
     ql::datum_t index =
         index_info.mapping.compile_wire_func()->call(&sindex_env, doc)->as_datum();
 
+    // `null` can't be stored in an index, so the row doesn't go into this one. That's
+    // how partial indexes (see `new_partial_index_func()`) leave out the rows their
+    // filter rejects, so we skip it here rather than have `print_secondary()` throw.
+    if (index.get_type() == ql::datum_t::R_NULL) {
+        return;
+    }
+
     if (index_info.multi == sindex_multi_bool_t::MULTI
         && index.get_type() == ql::datum_t::R_ARRAY) {
         for (uint64_t i = 0; i < index.arr_size(); ++i) {
@@ -1663,7 +2297,8 @@ void deserialize_sindex_info(
     case cluster_version_t::v2_2:
     case cluster_version_t::v2_3:
     case cluster_version_t::v2_4:
-    case cluster_version_t::v2_5_is_latest:
+    case cluster_version_t::v2_5:
+    case cluster_version_t::v2_6_is_latest:
         success = deserialize_reql_version(
                 &read_stream,
                 &info_out->mapping_version_info.original_reql_version,
@@ -1701,7 +2336,8 @@ void deserialize_sindex_info(
     case cluster_version_t::v2_2: // fallthru
     case cluster_version_t::v2_3: // fallthru
     case cluster_version_t::v2_4: // fallthru
-    case cluster_version_t::v2_5_is_latest:
+    case cluster_version_t::v2_5: // fallthru
+    case cluster_version_t::v2_6_is_latest:
         success = deserialize_for_version(cluster_version, &read_stream, &info_out->geo);
         throw_if_bad_deserialization(success, "sindex description");
         break;
@@ -1735,6 +2371,42 @@ void deserialize_sindex_info_or_crash(
         });
 }
 
+/* Whether the index function of `sindex_info` gives the same keys for `old_row` and
+`new_row`, because it only reads top-level fields and those hold the same values in
+both rows.  The values have to be byte-identical, not just equal: `1` and `1.0`, or the
+same time in two timezones, compare equal but the index function can tell them apart. */
+bool sindex_keys_unchanged(const sindex_disk_info_t &sindex_info,
+                           const ql::datum_t &old_row,
+                           const ql::datum_t &new_row) {
+    std::set<datum_string_t> fields;
+    if (!ql::get_top_level_fields_read(sindex_info.mapping.compile_wire_func(),
+                                       &fields)) {
+        return false;
+    }
+    for (const datum_string_t &field : fields) {
+        ql::datum_t old_val = old_row.get_field(field, ql::NOTHROW);
+        ql::datum_t new_val = new_row.get_field(field, ql::NOTHROW);
+        if (old_val.has() != new_val.has()) {
+            return false;
+        }
+        if (!old_val.has()) {
+            continue;
+        }
+        write_message_t old_wm, new_wm;
+        serialize<cluster_version_t::LATEST_DISK>(&old_wm, old_val);
+        serialize<cluster_version_t::LATEST_DISK>(&new_wm, new_val);
+        vector_stream_t old_stream, new_stream;
+        int res = send_write_message(&old_stream, &old_wm);
+        guarantee(res == 0);
+        res = send_write_message(&new_stream, &new_wm);
+        guarantee(res == 0);
+        if (old_stream.vector() != new_stream.vector()) {
+            return false;
+        }
+    }
+    return true;
+}
+
 /* Used below by rdb_update_sindexes. */
 void rdb_update_single_sindex(
         store_t *store,
@@ -1756,12 +2428,7 @@ void rdb_update_single_sindex(
     guarantee(cfeed_old_keys_out == nullptr || cfeed_old_keys_out->size() == 0);
     guarantee(cfeed_new_keys_out == nullptr || cfeed_new_keys_out->size() == 0);
 
-    sindex_disk_info_t sindex_info;
-    try {
-        deserialize_sindex_info_or_crash(sindex->sindex.opaque_definition, &sindex_info);
-    } catch (const archive_exc_t &e) {
-        crash("%s", e.what());
-    }
+    const sindex_disk_info_t &sindex_info = *sindex->info;
     // TODO(2015-01): Actually get real profiling information for
     // secondary index updates.
     profile::trace_t *const trace = nullptr;
@@ -1770,7 +2437,23 @@ void rdb_update_single_sindex(
 
     auto cserver = store->changefeed_server(modification->primary_key);
 
-    if (modification->info.deleted.first.has()) {
+    if (!sindex->sindex.being_deleted) {
+        store->materialized_aggregates.apply(
+            sindex->sindex.id, sindex->write_ticket, sindex_info, *modification);
+    }
+
+    // If the update didn't touch the fields the index function reads, the row keeps
+    // its index keys.  We then only compute them for the new row, and overwrite the
+    // entries under them instead of deleting them and inserting them again.
+    const bool keys_unchanged =
+        !sindex->sindex.being_deleted
+        && modification->info.deleted.first.has()
+        && modification->info.added.first.has()
+        && sindex_keys_unchanged(sindex_info,
+                                 modification->info.deleted.first,
+                                 modification->info.added.first);
+
+    if (modification->info.deleted.first.has() && !keys_unchanged) {
         guarantee(!modification->info.deleted.second.empty());
         try {
             ql::datum_t deleted = modification->info.deleted.first;
@@ -1848,6 +2531,9 @@ void rdb_update_single_sindex(
             compute_keys(
                 modification->primary_key, added, sindex_info,
                 &keys, cfeed_new_keys_out);
+            if (keys_unchanged && cfeed_old_keys_out != nullptr) {
+                *cfeed_old_keys_out = *cfeed_new_keys_out;
+            }
             if (keys_available_cond != nullptr) {
                 guarantee(*updates_left > 0);
                 decremented_updates_left = true;
@@ -1866,7 +2552,10 @@ void rdb_update_single_sindex(
                         ql::changefeed::limit_manager_t *lm) {
                         guarantee(clients_spot->read_signal()->is_pulsed());
                         guarantee(limit_clients_spot->read_signal()->is_pulsed());
-                        for (const auto &pair :keys) {
+                        for (const auto &pair : keys) {
+                            if (keys_unchanged) {
+                                lm->del(lm_spot, pair.first, is_primary_t::NO);
+                            }
                             lm->add(lm_spot, pair.first, is_primary_t::NO,
                                     pair.second, added);
                         }
@@ -2004,8 +2693,10 @@ void rdb_update_sindexes(
     }
 
     /* All of the sindex have been updated now it's time to actually clear the
-     * deleted blob if it exists. */
-    if (modification->info.deleted.first.has()) {
+     * deleted blob if it exists. If the row was patched in place, the old and the new
+     * value share their blocks, which we must keep. */
+    if (modification->info.deleted.first.has()
+        && modification->info.deleted.second != modification->info.added.second) {
         deletion_context->post_deleter()->delete_value(buf_parent_t(txn),
                 modification->info.deleted.second.data());
     }
@@ -2034,6 +2725,10 @@ public:
     }
 
     ~post_construct_traversal_helper_t() {
+        if (wtxn_.has()) {
+            new_mutex_acq_t wtxn_acq(&wtxn_lock_);
+            apply_pending_writes(&wtxn_acq);
+        }
         sindexes_.clear();
         if (wtxn_.has()) {
             wtxn_->commit();
@@ -2067,23 +2762,28 @@ public:
                 std::vector<char>(rdb_value->value_ref(),
                     rdb_value->value_ref() + rdb_value->inline_size(block_size)));
 
-        // Store the value into the secondary indexes
+        // Compute the secondary index keys for the value. We don't write them to the
+        // indexes right away, but collect them for the whole chunk so that we can
+        // apply them in key order (see `apply_pending_writes()`).
         {
-            // We need this mutex because we don't want `wtxn` to be destructed,
-            // but also because only one coroutine can be traversing the indexes
-            // through `rdb_update_sindexes` at a time (or else the btree will get
-            // corrupted!).
+            // We need this mutex because we don't want `wtxn` and `sindexes_` to be
+            // destructed while we use them.
             new_mutex_acq_t wtxn_acq(&wtxn_lock_, interruptor_);
             guarantee(wtxn_.has());
-            const rdb_post_construction_deletion_context_t deletion_context;
-            rdb_update_sindexes(store_,
-                                sindexes_,
-                                &mod_report,
-                                wtxn_.get(),
-                                &deletion_context,
-                                nullptr,
-                                nullptr,
-                                nullptr);
+            for (size_t i = 0; i < sindexes_.size(); ++i) {
+                std::vector<std::pair<store_key_t, ql::datum_t> > keys;
+                try {
+                    compute_keys(primary_key, mod_report.info.added.first,
+                                 *sindexes_[i]->info, &keys, nullptr);
+                } catch (const ql::base_exc_t &) {
+                    // Do nothing (we just drop the row from the index).
+                    continue;
+                }
+                for (auto &&pair : keys) {
+                    pending_writes_[i].emplace_back(
+                        std::move(pair.first), mod_report.info.added.second);
+                }
+            }
         }
 
         // Account for the sindex writes in the stats
@@ -2105,6 +2805,7 @@ public:
             ++current_chunk_size_;
             if (current_chunk_size_ >= MAX_CHUNK_SIZE) {
                 current_chunk_size_ = 0;
+                apply_pending_writes(&wtxn_acq);
                 sindexes_.clear();
                 wtxn_->commit();
                 wtxn_.reset();
@@ -2182,12 +2883,59 @@ private:
             on_indexes_deleted_->pulse_if_not_already_pulsed();
         }
 
-        // We pretend that the indexes have been fully constructed, so that when we call
-        // `rdb_update_sindexes` above, it actually updates the range we're currently
-        // constructing. This is a bit hacky, but works.
-        for (auto &&access : sindexes_) {
-            access->sindex.needs_post_construction_range = key_range_t::empty();
+        pending_writes_.resize(sindexes_.size());
+    }
+
+    // Writes the keys that we've collected for the current chunk into the secondary
+    // indexes. A chunk's keys are spread out over the whole index, so inserting them
+    // in the order in which we traverse the primary btree would pretty much go to a
+    // random leaf node each time. Sorting them first means that consecutive insertions
+    // share most of their path through the tree, and that appending to the right edge
+    // of an index can use `leaf::split_at_end()`.
+    void apply_pending_writes(new_mutex_acq_t *wtxn_acq) {
+        wtxn_acq->guarantee_is_holding(&wtxn_lock_);
+        guarantee(wtxn_.has());
+        guarantee(pending_writes_.size() == sindexes_.size());
+
+        const rdb_post_construction_deletion_context_t deletion_context;
+        for (size_t i = 0; i < sindexes_.size(); ++i) {
+            std::vector<std::pair<store_key_t, std::vector<char> > > *writes =
+                &pending_writes_[i];
+            std::sort(writes->begin(), writes->end(),
+                [](const std::pair<store_key_t, std::vector<char> > &a,
+                   const std::pair<store_key_t, std::vector<char> > &b) {
+                    return a.first < b.first;
+                });
+            // Limit changefeeds can't exist on an index that isn't ready yet, so
+            // unlike `rdb_update_single_sindex()` we don't have to notify them.
+            superblock_t *superblock = sindexes_[i]->superblock.get();
+            rdb_value_sizer_t sizer(superblock->cache()->max_block_size());
+            for (const auto &write : *writes) {
+                promise_t<superblock_t *> return_superblock_local;
+                {
+                    keyvalue_location_t kv_location;
+                    find_keyvalue_location_for_write(
+                        &sizer,
+                        superblock,
+                        write.first.btree_key(),
+                        repli_timestamp_t::distant_past,
+                        deletion_context.balancing_detacher(),
+                        &kv_location,
+                        nullptr,
+                        &return_superblock_local);
+
+                    ql::serialization_result_t res =
+                        kv_location_set(&kv_location, write.first, write.second,
+                                        repli_timestamp_t::distant_past,
+                                        &deletion_context);
+                    // this particular context cannot fail AT THE MOMENT.
+                    guarantee(!bad(res));
+                    // The keyvalue location gets destroyed here.
+                }
+                superblock = return_superblock_local.wait();
+            }
         }
+        pending_writes_.clear();
     }
 
     store_t *store_;
@@ -2212,8 +2960,12 @@ private:
     // are already live will also be delayed.
     scoped_ptr_t<txn_t> wtxn_;
     store_t::sindex_access_vector_t sindexes_;
+    // Parallel to `sindexes_`. The (sindex key, value) pairs that we have yet to write
+    // into each index for the current chunk.
+    std::vector<std::vector<std::pair<store_key_t, std::vector<char> > > >
+        pending_writes_;
     int current_chunk_size_;
-    // Controls access to `sindexes_` and `wtxn_`.
+    // Controls access to `sindexes_`, `pending_writes_` and `wtxn_`.
     new_mutex_t wtxn_lock_;
 };
 
@@ -2258,8 +3010,11 @@ void post_construct_secondary_index_range(
         check_should_abort,
         interruptor);
 
-    cache_account
-        = txn->cache()->create_cache_account(SINDEX_POST_CONSTRUCTION_CACHE_PRIORITY);
+    // The traversal reads the whole primary btree once, so we don't want it to push
+    // more useful pages out of the cache.
+    cache_account = txn->cache()->create_cache_account(
+        io_class_t::INDEX_CONSTRUCTION, SINDEX_POST_CONSTRUCTION_CACHE_PRIORITY,
+        cache_access_pattern_t::SCAN);
     txn->set_account(&cache_account);
 
     continue_bool_t cont = btree_concurrent_traversal(
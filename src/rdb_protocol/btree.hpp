@@ -10,6 +10,7 @@
 
 #include "btree/types.hpp"
 #include "concurrency/auto_drainer.hpp"
+#include "concurrency/cond_var.hpp"
 #include "rdb_protocol/datum.hpp"
 #include "rdb_protocol/func.hpp"
 #include "rdb_protocol/protocol.hpp"
@@ -23,6 +24,7 @@ template <class> class promise_t;
 struct rdb_value_t;
 class refcount_superblock_t;
 struct sindex_disk_info_t;
+struct sindex_intersection_t;
 
 
 bool btree_value_fits(max_block_size_t bs, int data_length, const rdb_value_t *value);
@@ -103,6 +105,13 @@ struct btree_batched_replacer_t {
         const ql::datum_t &res_,
         const ql::datum_t &write_timestamp,
         const counted_t<const ql::func_t> &write_hook) const;
+
+private:
+    // The write hook is called for every row of the batch, and they can all share
+    // one environment instead of setting up a new one each time. Created on first
+    // use, on the store's thread.
+    mutable cond_t write_hook_non_interruptor;
+    mutable scoped_ptr_t<ql::env_t> write_hook_env;
 };
 struct btree_point_replacer_t {
     virtual ~btree_point_replacer_t() { }
@@ -169,7 +178,9 @@ void rdb_rget_secondary_slice(
     require_sindexes_t require_sindex_val,
     const sindex_disk_info_t &sindex_info,
     rget_read_response_t *response,
-    release_superblock_t release_superblock);
+    release_superblock_t release_superblock,
+    const std::vector<sindex_intersection_t> &intersections =
+        std::vector<sindex_intersection_t>());
 
 void rdb_get_intersecting_slice(
     btree_slice_t *slice,
@@ -203,6 +214,16 @@ void rdb_distribution_get(int max_depth,
                           real_superblock_t *superblock,
                           distribution_read_response_t *response);
 
+/* Chooses `num` distinct rows of `range` uniformly at random, by walking down the
+B-tree to a random leaf entry and throwing away some of the walks (see the comment in
+the implementation). Releases the superblock. */
+void rdb_sample_slice(const key_range_t &range,
+                      uint64_t num,
+                      real_superblock_t *superblock,
+                      signal_t *interruptor,
+                      sample_read_response_t *response)
+    THROWS_ONLY(interrupted_exc_t);
+
 /* Secondary Indexes */
 
 struct rdb_modification_info_t {
@@ -271,6 +292,26 @@ struct sindex_disk_info_t {
     sindex_geo_bool_t geo;
 };
 
+/* A secondary index that `get_all` with `intersect` also has to match, and the key it
+has to match. `primary_keys` are the sorted primary keys of the rows under that key in
+the index, unless there were too many of them to collect. */
+struct sindex_intersection_t {
+    sindex_disk_info_t info;
+    ql::datum_t key;
+    optional<std::vector<std::string> > primary_keys;
+};
+
+/* Returns the sorted primary keys in `pk_range` of the rows that `superblock`'s index
+has under `key`, or nothing if there are more of them than are worth keeping. Since
+long keys are truncated in the index, there can be some rows that don't actually match
+`key` among them. */
+optional<std::vector<std::string> > rdb_get_intersected_primary_keys(
+    sindex_superblock_t *superblock,
+    const ql::datum_t &key,
+    const sindex_disk_info_t &sindex_info,
+    const key_range_t &pk_range,
+    signal_t *interruptor);
+
 void serialize_sindex_info(write_message_t *wm,
                            const sindex_disk_info_t &info);
 
@@ -307,6 +348,8 @@ public:
                        new_mutex_in_line_t *sindex_spot,
                        rwlock_in_line_t *stamp_spot);
     bool has_pkey_cfeeds(const std::vector<store_key_t> &keys);
+    /* Includes the indexes that are still being constructed or deleted. */
+    bool has_sindexes() const { return !sindexes_.empty(); }
     void finish(btree_slice_t *btree, real_superblock_t *superblock);
 
 private:
@@ -327,6 +370,15 @@ private:
     store_t::sindex_access_vector_t sindexes_;
 };
 
+/* Computes the keys `doc` has in the index, with the index value each stands for.
+Throws `ql::base_exc_t` if the index function fails on `doc`; rows whose index value
+is `null` get no keys. */
+void compute_keys(const store_key_t &primary_key,
+                  ql::datum_t doc,
+                  const sindex_disk_info_t &index_info,
+                  std::vector<std::pair<store_key_t, ql::datum_t> > *keys_out,
+                  std::vector<index_pair_t> *cfeed_keys_out);
+
 void rdb_update_sindexes(
     store_t *store,
     const store_t::sindex_access_vector_t &sindexes,
@@ -1,6 +1,7 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include "rdb_protocol/store.hpp"  // NOLINT(build/include_order)
 
+#include <algorithm>  // NOLINT(build/include_order)
 #include <functional>  // NOLINT(build/include_order)
 
 #include "arch/runtime/coroutines.hpp"
@@ -94,7 +95,9 @@ store_t::store_t(const region_t &_region,
       perfmon_collection_membership(parent_perfmon_collection, &perfmon_collection, perfmon_name),
       ctx(_ctx),
       table_id(_table_id),
-      write_superblock_acq_semaphore(WRITE_SUPERBLOCK_ACQ_WAITERS_LIMIT)
+      write_superblock_acq_semaphore(WRITE_SUPERBLOCK_ACQ_WAITERS_LIMIT),
+      idle(false),
+      access_count(0)
 {
     cache.init(new cache_t(serializer, balancer, &perfmon_collection, which_cpu_shard));
     general_cache_conn.init(new cache_conn_t(cache.get()));
@@ -191,12 +194,17 @@ void store_t::read(
         signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t) {
     assert_thread();
+    note_access();
+    with_priority_t p(query_coro_priority(_read.priority));
     scoped_ptr_t<txn_t> txn;
     scoped_ptr_t<real_superblock_t> superblock;
 
     acquire_superblock_for_read(token, &txn, &superblock,
                                 interruptor,
                                 _read.use_snapshot());
+    if (_read.priority == query_priority_t::LOW) {
+        txn->set_account(btree->get_low_priority_account());
+    }
     DEBUG_ONLY_CODE(metainfo->visit(
         superblock.get(), metainfo_checker.region, metainfo_checker.callback));
     protocol_read(_read, response, superblock.get(), interruptor);
@@ -214,6 +222,8 @@ void store_t::write(
         signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t) {
     assert_thread();
+    note_access();
+    with_priority_t p(query_coro_priority(_write.priority));
 
     scoped_ptr_t<txn_t> txn;
     scoped_ptr_t<real_superblock_t> real_superblock;
@@ -275,6 +285,16 @@ void store_t::reset_data(
         an inconsistent state. */
         cond_t non_interruptor;
 
+        /* Without secondary indexes nothing needs the erased documents, so we let
+        `rdb_erase_small_range()` delete the values without loading them or making
+        modification reports. */
+        bool has_sindexes;
+        {
+            std::map<sindex_name_t, secondary_index_t> sindexes;
+            get_secondary_indexes(&sindex_block, &sindexes);
+            has_sindexes = !sindexes.empty();
+        }
+
         rdb_live_deletion_context_t deletion_context;
         std::vector<rdb_modification_report_t> mod_reports;
         key_range_t deleted_range;
@@ -285,9 +305,12 @@ void store_t::reset_data(
                                              &deletion_context,
                                              &non_interruptor,
                                              max_erased_per_pass,
-                                             &mod_reports,
+                                             has_sindexes ? &mod_reports : nullptr,
                                              &deleted_range);
 
+        // Without secondary indexes there are no modification reports to do this.
+        row_cache.invalidate_range(deleted_range);
+
         region_t deleted_region(subregion.beg, subregion.end, deleted_range);
         metainfo->update(superblock.get(),
                          region_map_t<binary_blob_t>(deleted_region, zero_metainfo));
@@ -491,6 +514,54 @@ void store_t::configure_flush_interval(flush_interval_t interval) {
     cache->configure_flush_interval(interval);
 }
 
+void store_t::configure_cache_balancer_policy(const cache_balancer_policy_t &policy) {
+    balancer_policy = policy;
+    if (!idle) {
+        cache->configure_balancer_policy(policy);
+    }
+}
+
+std::vector<block_id_t> store_t::get_hot_block_ids(size_t max_count) {
+    assert_thread();
+    if (idle) {
+        std::vector<block_id_t> res(
+            idle_hot_block_ids.begin(),
+            idle_hot_block_ids.begin()
+                + std::min(max_count, idle_hot_block_ids.size()));
+        return res;
+    }
+    return cache->hot_block_ids(max_count);
+}
+
+void store_t::warm_up_cache(std::vector<block_id_t> block_ids) {
+    assert_thread();
+    cache->warm_up(std::move(block_ids));
+}
+
+void store_t::enter_idle_mode(std::vector<block_id_t> &&hot_block_ids) {
+    assert_thread();
+    if (idle) {
+        return;
+    }
+    idle = true;
+    idle_hot_block_ids = std::move(hot_block_ids);
+    cache_balancer_policy_t idle_policy;
+    idle_policy.weight = 0;
+    idle_policy.max_size = 0;
+    cache->configure_balancer_policy(idle_policy);
+}
+
+void store_t::note_access() {
+    assert_thread();
+    ++access_count;
+    if (UNLIKELY(idle)) {
+        idle = false;
+        cache->configure_balancer_policy(balancer_policy);
+        cache->warm_up(std::move(idle_hot_block_ids));
+        idle_hot_block_ids.clear();
+    }
+}
+
 new_mutex_in_line_t store_t::get_in_line_for_sindex_queue(buf_lock_t *sindex_block) {
     assert_thread();
     // The line for the sindex queue is there to guarantee that we push things to
@@ -555,6 +626,9 @@ void store_t::update_sindexes(
             buf_lock_t *sindex_block,
             const std::vector<rdb_modification_report_t> &mod_reports,
             bool release_sindex_block) {
+    for (const auto &mod_report : mod_reports) {
+        row_cache.invalidate(mod_report.primary_key);
+    }
     new_mutex_in_line_t acq = get_in_line_for_sindex_queue(sindex_block);
     {
         sindex_access_vector_t sindexes;
@@ -917,6 +991,7 @@ void store_t::drop_sindex(uuid_u sindex_id) THROWS_NOTHING {
     ::delete_secondary_index(&sindex_block, compute_sindex_deletion_name(sindex.id));
     size_t num_erased = secondary_index_slices.erase(sindex.id);
     guarantee(num_erased == 1);
+    sindex_infos.erase(sindex.id);
 
     sindex_superblock_lock.reset_buf_lock();
     sindex_block.reset_buf_lock();
@@ -1015,6 +1090,9 @@ MUST_USE bool store_t::mark_secondary_index_deleted(
     slice_it->second->assert_thread();
     slice_it->second->stats.hide();
 
+    // Reads can't use the index anymore, and writes stop updating it
+    materialized_aggregates.drop_sindex(sindex.id);
+
     return true;
 }
 
@@ -1026,31 +1104,62 @@ MUST_USE bool store_t::acquire_sindex_superblock_for_read(
         std::vector<char> *opaque_definition_out,
         uuid_u *sindex_uuid_out)
     THROWS_ONLY(sindex_not_ready_exc_t) {
-    assert_thread();
     rassert(opaque_definition_out != NULL);
     rassert(sindex_uuid_out != NULL);
 
+    std::vector<scoped_ptr_t<sindex_superblock_t> > sindex_sbs;
+    std::vector<std::vector<char> > opaque_definitions;
+    std::vector<uuid_u> sindex_uuids;
+    bool found = acquire_sindex_superblocks_for_read(
+        std::vector<sindex_name_t>{name},
+        table_name,
+        superblock,
+        &sindex_sbs,
+        &opaque_definitions,
+        &sindex_uuids);
+    if (found) {
+        *sindex_sb_out = std::move(sindex_sbs[0]);
+    }
+    if (!opaque_definitions.empty()) {
+        *opaque_definition_out = std::move(opaque_definitions[0]);
+        *sindex_uuid_out = sindex_uuids[0];
+    }
+    return found;
+}
+
+MUST_USE bool store_t::acquire_sindex_superblocks_for_read(
+        const std::vector<sindex_name_t> &names,
+        const std::string &table_name,
+        real_superblock_t *superblock,
+        std::vector<scoped_ptr_t<sindex_superblock_t> > *sindex_sbs_out,
+        std::vector<std::vector<char> > *opaque_definitions_out,
+        std::vector<uuid_u> *sindex_uuids_out)
+    THROWS_ONLY(sindex_not_ready_exc_t) {
+    assert_thread();
+
     /* Acquire the sindex block. */
     buf_lock_t sindex_block(superblock->expose_buf(), superblock->get_sindex_block_id(),
                             access_t::read);
     superblock->release();
 
-    /* Figure out what the superblock for this index is. */
-    secondary_index_t sindex;
-    if (!::get_secondary_index(&sindex_block, name, &sindex)) {
-        return false;
-    }
+    for (const sindex_name_t &name : names) {
+        /* Figure out what the superblock for this index is. */
+        secondary_index_t sindex;
+        if (!::get_secondary_index(&sindex_block, name, &sindex)) {
+            return false;
+        }
 
-    *opaque_definition_out = sindex.opaque_definition;
-    *sindex_uuid_out = sindex.id;
+        opaque_definitions_out->push_back(sindex.opaque_definition);
+        sindex_uuids_out->push_back(sindex.id);
 
-    if (!sindex.is_ready()) {
-        throw sindex_not_ready_exc_t(name.name, sindex, table_name);
-    }
+        if (!sindex.is_ready()) {
+            throw sindex_not_ready_exc_t(name.name, sindex, table_name);
+        }
 
-    buf_lock_t superblock_lock(&sindex_block, sindex.superblock, access_t::read);
-    sindex_block.reset_buf_lock();
-    sindex_sb_out->init(new sindex_superblock_t(std::move(superblock_lock)));
+        buf_lock_t superblock_lock(&sindex_block, sindex.superblock, access_t::read);
+        sindex_sbs_out->push_back(
+            make_scoped<sindex_superblock_t>(std::move(superblock_lock)));
+    }
     return true;
 }
 
@@ -1092,11 +1201,15 @@ MUST_USE bool store_t::acquire_sindex_superblock_for_write(
 store_t::sindex_access_t::sindex_access_t(btree_slice_t *_btree,
                                           sindex_name_t _name,
                                           secondary_index_t _sindex,
-                                          scoped_ptr_t<sindex_superblock_t> _superblock)
+                                          std::shared_ptr<const sindex_disk_info_t> _info,
+                                          scoped_ptr_t<sindex_superblock_t> _superblock,
+                                          uint64_t _write_ticket)
     : btree(_btree),
       name(std::move(_name)),
       sindex(std::move(_sindex)),
-      superblock(std::move(_superblock))
+      info(std::move(_info)),
+      superblock(std::move(_superblock)),
+      write_ticket(_write_ticket)
 { }
 
 store_t::sindex_access_t::~sindex_access_t() { }
@@ -1146,19 +1259,42 @@ bool store_t::acquire_sindex_superblocks_for_write(
 
         buf_lock_t superblock_lock(
                 sindex_block, it->second.superblock, access_t::write);
+        // Taken without yielding after getting in line, like reads take theirs.
+        uint64_t write_ticket = materialized_aggregates.take_write_ticket();
 
         sindex_sbs_out->push_back(
                 make_scoped<sindex_access_t>(
                         get_sindex_slice(it->second.id),
                         it->first,
                         it->second,
-                        make_scoped<sindex_superblock_t>(std::move(superblock_lock))));
+                        get_sindex_info(it->second.id,
+                                        it->second.opaque_definition),
+                        make_scoped<sindex_superblock_t>(std::move(superblock_lock)),
+                        write_ticket));
     }
 
     // return's true if we got all of the sindexes requested.
     return !sindexes_to_acquire || sindex_sbs_out->size() == sindexes_to_acquire->size();
 }
 
+std::shared_ptr<const sindex_disk_info_t> store_t::get_sindex_info(
+        const uuid_u &sindex_id,
+        const std::vector<char> &opaque_definition) {
+    assert_thread();
+    auto it = sindex_infos.find(sindex_id);
+    if (it != sindex_infos.end() && it->second.first == opaque_definition) {
+        return it->second.second;
+    }
+    std::shared_ptr<sindex_disk_info_t> info = std::make_shared<sindex_disk_info_t>();
+    try {
+        deserialize_sindex_info_or_crash(opaque_definition, info.get());
+    } catch (const archive_exc_t &e) {
+        crash("%s", e.what());
+    }
+    sindex_infos[sindex_id] = std::make_pair(opaque_definition, info);
+    return info;
+}
+
 region_map_t<binary_blob_t> store_t::get_metainfo(
         UNUSED order_token_t order_token,  // TODO
         read_token_t *token,
@@ -1,7 +1,9 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "rdb_protocol/changefeed.hpp"
 
+#include <iterator>
 #include <queue>
+#include <unordered_map>
 
 #include "btree/reql_specific.hpp"
 #include "clustering/administration/auth/user_context.hpp"
@@ -9,6 +11,9 @@
 #include "concurrency/cross_thread_signal.hpp"
 #include "concurrency/interruptor.hpp"
 #include "containers/archive/boost_types.hpp"
+#include "containers/archive/string_stream.hpp"
+#include "perfmon/memory_usage.hpp"
+#include "perfmon/perfmon.hpp"
 #include "rdb_protocol/artificial_table/backend.hpp"
 #include "rdb_protocol/btree.hpp"
 #include "rdb_protocol/env.hpp"
@@ -65,11 +70,13 @@ void debug_print(printf_buffer_t *buf, const stamped_range_t &rng) {
 
 struct change_val_t {
     change_val_t(std::pair<uuid_u, uint64_t> _source_stamp,
+                 uint64_t _position,
                  const store_key_t &_pkey,
                  optional<indexed_datum_t> _old_val,
                  optional<indexed_datum_t> _new_val
                  DEBUG_ONLY(, optional<std::string> _sindex))
         : source_stamp(std::move(_source_stamp)),
+          position(_position),
           pkey(_pkey),
           old_val(std::move(_old_val)),
           new_val(std::move(_new_val))
@@ -82,6 +89,8 @@ struct change_val_t {
         }
     }
     std::pair<uuid_u, uint64_t> source_stamp;
+    // The `msg_t::change_t::position` of the change this came from
+    uint64_t position;
     store_key_t pkey;
     optional<indexed_datum_t> old_val;
     optional<indexed_datum_t> new_val;
@@ -164,27 +173,108 @@ void debug_print(printf_buffer_t *buf, const T &t) {
     buf->appendf("%s", debug::print(t).c_str());
 }
 
+namespace {
+
+/* These count the changes that are queued up for all changefeed subscriptions on this
+server, and how many changes were squashed into ones that were already queued, under
+`changefeed_queues` in the global perfmon collection. */
+class changefeed_queue_stats_t {
+public:
+    changefeed_queue_stats_t()
+        : collection_membership(&get_global_perfmon_collection(), &collection,
+                                "changefeed_queues"),
+          queued_changes_membership(&collection, &queued_changes, "queued_changes"),
+          squashed_changes_membership(&collection, &squashed_changes,
+                                      "squashed_changes_total") { }
+
+    // Like `add_memory_usage()`, this ignores calls from outside the thread pool.
+    void add(perfmon_counter_t *counter, int64_t delta) {
+        if (delta != 0 && get_thread_id().threadnum >= 0) {
+            *counter += delta;
+        }
+    }
+
+    perfmon_counter_t queued_changes;
+    perfmon_counter_t squashed_changes;
+
+private:
+    perfmon_collection_t collection;
+    perfmon_membership_t collection_membership;
+    perfmon_membership_t queued_changes_membership;
+    perfmon_membership_t squashed_changes_membership;
+
+    DISABLE_COPYING(changefeed_queue_stats_t);
+};
+
+changefeed_queue_stats_t *get_changefeed_queue_stats() {
+    static changefeed_queue_stats_t stats;
+    return &stats;
+}
+
+// Registers the counters before the server starts, so that they show up in the stats
+// even while they are all zero.
+UNUSED changefeed_queue_stats_t *const changefeed_queue_stats_at_startup =
+    get_changefeed_queue_stats();
+
+// FNV-1a, so that looking up a key doesn't have to copy it into a `std::string`.
+struct store_key_hash_t {
+    size_t operator()(const store_key_t &key) const {
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for (int i = 0; i < key.size(); ++i) {
+            h ^= key.contents()[i];
+            h *= 0x100000001b3ULL;
+        }
+        return h;
+    }
+};
+
+}  // namespace
+
 enum class pop_type_t { RANGE, POINT };
 class maybe_squashing_queue_t {
 public:
-    virtual ~maybe_squashing_queue_t() { }
+    maybe_squashing_queue_t()
+        : memory_usage(memory_usage_category_t::CHANGEFEED_QUEUES),
+          reported_size(0) { }
+    virtual ~maybe_squashing_queue_t() {
+        get_changefeed_queue_stats()->add(
+            &get_changefeed_queue_stats()->queued_changes,
+            -static_cast<int64_t>(reported_size));
+    }
     virtual void add(change_val_t change_val) = 0;
     virtual size_t size() const = 0;
     virtual void clear() = 0;
     virtual change_val_t pop() = 0;
     virtual const change_val_t &peek() = 0;
     virtual void purge_below(std::map<uuid_u, uint64_t> stamps) = 0;
+protected:
+    // Must be called whenever the size changes. The values of the changes are
+    // mostly held in shared buffers, which count as `query_datums` already, so we
+    // only count the changes themselves here.
+    void update_memory_usage() {
+        memory_usage.set(size() * sizeof(change_val_t));
+        get_changefeed_queue_stats()->add(
+            &get_changefeed_queue_stats()->queued_changes,
+            static_cast<int64_t>(size()) - static_cast<int64_t>(reported_size));
+        reported_size = size();
+    }
+private:
+    memory_usage_tracker_t memory_usage;
+    // What we last added to the `queued_changes` stat.
+    size_t reported_size;
 };
 
 class nonsquashing_queue_t final : public maybe_squashing_queue_t {
     void add(change_val_t change_val) final {
         queue.push_back(std::move(change_val));
+        update_memory_usage();
     }
     size_t size() const final {
         return queue.size();
     }
     void clear() final {
         queue.clear();
+        update_memory_usage();
     }
     const change_val_t &peek() final {
         guarantee(size() != 0);
@@ -194,6 +284,7 @@ class nonsquashing_queue_t final : public maybe_squashing_queue_t {
         guarantee(size() != 0);
         auto ret = std::move(queue.front());
         queue.pop_front();
+        update_memory_usage();
         return ret;
     }
     void purge_below(std::map<uuid_u, uint64_t> stamps) final {
@@ -213,24 +304,32 @@ class nonsquashing_queue_t final : public maybe_squashing_queue_t {
                 add(std::move(cv));
             }
         }
+        update_memory_usage();
     }
     std::deque<change_val_t> queue;
 };
 
+/* The squashing queue keeps the changes in the order their keys were first queued in,
+with at most one change per key. The changes live in `slots`, a deque of in-place
+values, so queueing a change doesn't allocate a tree node and a list node the way a
+`std::map` plus a `std::list` would, and `index` finds the slot of a key by hash. A
+change that squashes away to nothing leaves an empty slot behind. Empty slots at the
+front are dropped as soon as they get there, and the rest are dropped all at once when
+they outnumber the changes, so that the cost of removing them is amortized. */
 class squashing_queue_t final : public maybe_squashing_queue_t {
 public:
+    squashing_queue_t() : first_slot_number(0) { }
     void add(change_val_t change_val) final {
-        auto it = queue.find(change_val.pkey);
-        if (it == queue.end()) {
-            auto order_it = queue_order.insert(queue_order.end(), change_val.pkey);
-            auto pkey = change_val.pkey;
-            auto pair = std::make_pair(
-                std::move(pkey), std::make_pair(std::move(change_val), order_it));
-            auto res = queue.insert(std::move(pair));
-            it = res.first;
-            guarantee(res.second);
+        auto it = index.find(change_val.pkey);
+        if (it == index.end()) {
+            index.insert(std::make_pair(change_val.pkey,
+                                        first_slot_number + slots.size()));
+            slots.push_back(make_optional(std::move(change_val)));
         } else {
-            change_val_t *change = &it->second.first;
+            get_changefeed_queue_stats()->add(
+                &get_changefeed_queue_stats()->squashed_changes, 1);
+            optional<change_val_t> *slot = &slots[it->second - first_slot_number];
+            change_val_t *change = &**slot;
             change_val.old_val = std::move(change->old_val);
             *change = std::move(change_val);
             bool has_old_val = change->old_val
@@ -240,32 +339,34 @@ public:
             if ((!has_old_val && !has_new_val)
                 || (change->old_val && change->new_val
                     && change->old_val->val == change->new_val->val)) {
-                queue_order.erase(it->second.second);
-                queue.erase(it);
+                slot->reset();
+                index.erase(it);
+                drop_empty_slots();
             }
         }
+        update_memory_usage();
     }
     size_t size() const final {
-        guarantee(queue.size() == queue_order.size());
-        return queue.size();
+        return index.size();
     }
     void clear() final {
-        queue.clear();
-        queue_order.clear();
+        slots.clear();
+        index.clear();
+        first_slot_number = 0;
+        update_memory_usage();
     }
     const change_val_t &peek() final {
         guarantee(size() != 0);
-        auto it = queue.find(*queue_order.begin());
-        guarantee(it != queue.end());
-        return it->second.first;
+        return *slots.front();
     }
     change_val_t pop() final {
         guarantee(size() != 0);
-        auto it = queue.find(*queue_order.begin());
-        guarantee(it != queue.end());
-        auto ret = std::move(it->second.first);
-        queue.erase(it);
-        queue_order.pop_front();
+        change_val_t ret = std::move(*slots.front());
+        index.erase(ret.pkey);
+        slots.pop_front();
+        ++first_slot_number;
+        drop_empty_slots();
+        update_memory_usage();
         return ret;
     }
     void purge_below(std::map<uuid_u, uint64_t>) final {
@@ -273,9 +374,34 @@ public:
         r_sanity_fail();
     }
 private:
-    std::map<store_key_t,
-             std::pair<change_val_t, std::list<store_key_t>::iterator> > queue;
-    std::list<store_key_t> queue_order;
+    // Below this many empty slots, we don't bother compacting.
+    static const size_t MIN_EMPTY_SLOTS_TO_COMPACT = 64;
+
+    void drop_empty_slots() {
+        while (!slots.empty() && !slots.front().has_value()) {
+            slots.pop_front();
+            ++first_slot_number;
+        }
+        size_t empty_slots = slots.size() - index.size();
+        if (empty_slots >= MIN_EMPTY_SLOTS_TO_COMPACT && empty_slots > index.size()) {
+            std::deque<optional<change_val_t> > compacted;
+            for (auto &&slot : slots) {
+                if (slot.has_value()) {
+                    index.find(slot->pkey)->second =
+                        first_slot_number + compacted.size();
+                    compacted.push_back(std::move(slot));
+                }
+            }
+            slots.swap(compacted);
+        }
+        guarantee(slots.empty() || slots.front().has_value());
+    }
+
+    // Slot `n` is `slots[n - first_slot_number]`, so that popping from the front
+    // doesn't have to renumber the slots in `index`.
+    std::deque<optional<change_val_t> > slots;
+    uint64_t first_slot_number;
+    std::unordered_map<store_key_t, uint64_t, store_key_hash_t> index;
 };
 
 optional<datum_t> apply_ops(
@@ -318,6 +444,7 @@ server_t::server_t(mailbox_manager_t *_manager, store_t *_parent)
     : uuid(generate_uuid()),
       manager(_manager),
       parent(_parent),
+      last_position(0),
       stop_mailbox(manager,
                    std::bind(&server_t::stop_mailbox_cb, this, ph::_1, ph::_2)),
       limit_stop_mailbox(manager, std::bind(&server_t::limit_stop_mailbox_cb,
@@ -499,6 +626,54 @@ struct stamped_msg_t {
 
 RDB_MAKE_SERIALIZABLE_3(stamped_msg_t, server_uuid, stamp, submsg);
 
+// The most messages that we put in one batch for a client.  A large write can change
+// an awful lot of rows before the batch gets sent.
+static const size_t MAX_CLIENT_BATCH_SIZE = 1000;
+
+// How many of its most recent changes a `server_t` keeps for feeds that resume.
+static const size_t RECENT_CHANGES_LIMIT = 1000;
+
+bool server_t::add_pending(client_info_t *info, msg_t msg) {
+    // We don't need a write lock as long as we make sure the coroutine doesn't block
+    // between reading and updating the stamp.
+    ASSERT_NO_CORO_WAITING;
+    info->pending.push_back(std::make_pair(info->stamp++, std::move(msg)));
+    return info->pending.size() == 1;
+}
+
+std::vector<stamped_msg_t> server_t::take_pending(client_info_t *info) {
+    ASSERT_NO_CORO_WAITING;
+    std::vector<stamped_msg_t> msgs;
+    msgs.reserve(info->pending.size());
+    for (auto &&pair : info->pending) {
+        msgs.push_back(stamped_msg_t(uuid, pair.first, std::move(pair.second)));
+    }
+    info->pending.clear();
+    return msgs;
+}
+
+// Sends the messages that have accumulated for a client.  This runs some time after
+// the first of those messages was added, so the changes from other writes that were
+// running at the same time end up in the same batch.
+void server_t::send_pending_cb(
+        client_t::addr_t addr,
+        auto_drainer_t::lock_t keepalive) {
+    keepalive.assert_is_holding(&drainer);
+    std::vector<stamped_msg_t> msgs;
+    {
+        rwlock_acq_t acq(&clients_lock, access_t::read);
+        auto it = clients.find(addr);
+        // If the client was removed, its messages were sent along with the `stop_t`.
+        if (it == clients.end()) {
+            return;
+        }
+        msgs = take_pending(&it->second);
+    }
+    if (!msgs.empty()) {
+        send(manager, addr, msgs);
+    }
+}
+
 // This function takes a `lock_t` to make sure you have one.  (We can't just
 // always acquire a drainer lock before sending because we sometimes send a
 // `stop_t` during destruction, and you can't acquire a drain lock on a draining
@@ -508,14 +683,10 @@ void server_t::send_one_with_lock(
         msg_t msg,
         const auto_drainer_t::lock_t &keepalive) {
     keepalive.assert_is_holding(&drainer);
-    uint64_t stamp;
-    {
-        // We don't need a write lock as long as we make sure the coroutine
-        // doesn't block between reading and updating the stamp.
-        ASSERT_NO_CORO_WAITING;
-        stamp = client->second.stamp++;
-    }
-    send(manager, client->first, stamped_msg_t(uuid, stamp, std::move(msg)));
+    // We send this message right away, along with any changes that were waiting to
+    // be sent before it.
+    add_pending(&client->second, std::move(msg));
+    send(manager, client->first, take_pending(&client->second));
 }
 
 void server_t::send_all(
@@ -527,22 +698,42 @@ void server_t::send_all(
     stamp_spot->guarantee_is_for_lock(&parent->cfeed_stamp_lock);
     stamp_spot->write_signal()->wait_lazily_unordered();
 
+    msg_t positioned_msg = msg;
+    if (auto *change = boost::get<msg_t::change_t>(&positioned_msg.op)) {
+        change->position = ++last_position;
+        recent_changes.push_back(*change);
+        if (recent_changes.size() > RECENT_CHANGES_LIMIT) {
+            recent_changes.pop_front();
+        }
+    }
+
     rwlock_acq_t acq(&clients_lock, access_t::read);
-    std::map<client_t::addr_t, uint64_t> stamps;
+    // Instead of sending a message for every change, we stamp the change and add it
+    // to the client's batch.  The first change in a batch spawns the coroutine that
+    // sends it, and batches that are full get sent right away.
+    std::vector<client_t::addr_t> new_batches;
+    std::vector<std::pair<client_t::addr_t, std::vector<stamped_msg_t> > > full_batches;
     for (auto &&pair : clients) {
-        // We don't need a write lock as long as we make sure the coroutine
-        // doesn't block between reading and updating the stamp.
         ASSERT_NO_CORO_WAITING;
         if (std::any_of(pair.second.regions.begin(),
                         pair.second.regions.end(),
                         std::bind(&region_contains_key, ph::_1, std::cref(key)))) {
-            stamps[pair.first] = pair.second.stamp++;
+            if (add_pending(&pair.second, positioned_msg)) {
+                new_batches.push_back(pair.first);
+            } else if (pair.second.pending.size() >= MAX_CLIENT_BATCH_SIZE) {
+                full_batches.push_back(
+                    std::make_pair(pair.first, take_pending(&pair.second)));
+            }
         }
     }
     acq.reset();
     stamp_spot->reset(); // Done stamping, no need to hold onto it while we send.
-    for (const auto &pair : stamps) {
-        send(manager, pair.first, stamped_msg_t(uuid, pair.second, msg));
+    for (const auto &addr : new_batches) {
+        coro_t::spawn_sometime(
+            std::bind(&server_t::send_pending_cb, this, addr, keepalive));
+    }
+    for (const auto &pair : full_batches) {
+        send(manager, pair.first, pair.second);
     }
 }
 
@@ -557,15 +748,37 @@ server_t::limit_addr_t server_t::get_limit_stop_addr() {
 optional<uint64_t> server_t::get_stamp(
         const client_t::addr_t &addr,
         const auto_drainer_t::lock_t &keepalive) {
+    uint64_t position;
+    optional<std::vector<msg_t::change_t> > resumed_changes;
+    return get_stamp(addr, r_nullopt, &position, &resumed_changes, keepalive);
+}
+
+optional<uint64_t> server_t::get_stamp(
+        const client_t::addr_t &addr,
+        const optional<uint64_t> &resume_from,
+        uint64_t *position_out,
+        optional<std::vector<msg_t::change_t> > *resumed_changes_out,
+        const auto_drainer_t::lock_t &keepalive) {
     keepalive.assert_is_holding(&drainer);
     rwlock_acq_t stamp_acq(&parent->cfeed_stamp_lock, access_t::read);
     rwlock_acq_t client_acq(&clients_lock, access_t::read);
     auto it = clients.find(addr);
     if (it == clients.end()) {
         return r_nullopt;
-    } else {
-        return make_optional(it->second.stamp);
     }
+    *position_out = last_position;
+    if (resume_from && *resume_from <= last_position) {
+        // `recent_changes` is only empty if there haven't been any changes yet.
+        uint64_t oldest = recent_changes.empty()
+            ? last_position + 1
+            : recent_changes.front().position;
+        if (*resume_from + 1 >= oldest) {
+            resumed_changes_out->set(std::vector<msg_t::change_t>(
+                recent_changes.begin() + (*resume_from + 1 - oldest),
+                recent_changes.end()));
+        }
+    }
+    return make_optional(it->second.stamp);
 }
 
 uuid_u server_t::get_uuid() {
@@ -841,6 +1054,9 @@ bool limit_order_t::operator()(const std::string &a, const std::string &b) const
     unreachable();
 }
 
+// The most items past the top `n` that a `limit_manager_t` keeps in memory.
+static const size_t MAX_LIMIT_SHADOW_SIZE = 100;
+
 void limit_manager_t::send(msg_t &&msg) {
     if (!parent->drainer.is_draining()) {
         auto_drainer_t::lock_t drain_lock(&parent->drainer);
@@ -872,6 +1088,7 @@ limit_manager_t::limit_manager_t(
       spec(std::move(_spec)),
       gt(std::move(_gt)),
       item_queue(gt),
+      shadow_queue(gt),
       aborted(false) {
     guarantee(clients_lock->read_signal()->is_pulsed());
 
@@ -941,14 +1158,16 @@ public:
                   const keyspec_t::limit_t *_spec,
                   sorting_t _sorting,
                   optional<item_t> _start,
-                  const item_queue_t *_item_queue)
+                  const item_queue_t *_item_queue,
+                  size_t _extra)
         : env(_env),
           ops(_ops),
           pk_range(_pk_range),
           spec(_spec),
           sorting(_sorting),
           start(std::move(_start)),
-          item_queue(_item_queue) { }
+          item_queue(_item_queue),
+          extra(_extra) { }
 
     std::vector<item_t> operator()(const primary_ref_t &ref) {
         rget_read_response_t resp;
@@ -971,7 +1190,7 @@ public:
         case sorting_t::UNORDERED: // fallthru
         default: unreachable();
         }
-        size_t n = spec->limit - item_queue->size();
+        size_t n = spec->limit - item_queue->size() + extra;
         rdb_rget_slice(
             ref.btree,
             region_t(),
@@ -1026,7 +1245,7 @@ public:
                 [](const datum_range_t &) { return true; },
                 [](const std::map<datum_t, uint64_t> &) { return false; }));
         datum_range_t srange = spec->range.datumspec.covering_range();
-        size_t n = spec->limit - item_queue->size();
+        size_t n = spec->limit - item_queue->size() + extra;
         if (start) {
             datum_t dstart = start->second.first;
             switch (sorting) {
@@ -1104,6 +1323,8 @@ private:
     sorting_t sorting;
     optional<item_t> start;
     const item_queue_t *item_queue;
+    // How many items to read beyond the ones needed to fill up `item_queue`.
+    size_t extra;
 };
 
 std::vector<item_t> limit_manager_t::read_more(
@@ -1111,10 +1332,31 @@ std::vector<item_t> limit_manager_t::read_more(
     const optional<item_t> &start) {
     guarantee(item_queue.size() < spec.limit);
     ref_visitor_t visitor(
-        env.get(), &ops, &region.inner, &spec, spec.range.sorting, start, &item_queue);
+        env.get(), &ops, &region.inner, &spec, spec.range.sorting, start, &item_queue,
+        shadow_size());
     return boost::apply_visitor(visitor, ref);
 }
 
+size_t limit_manager_t::shadow_size() const {
+    return std::min<size_t>(spec.limit, MAX_LIMIT_SHADOW_SIZE);
+}
+
+std::vector<std::string> limit_manager_t::truncate_to_shadow() {
+    // Everything in the shadow set is worse than everything in the active set, so the
+    // items we kick out of the active set become the best ones in the shadow set.
+    std::vector<std::string> truncated;
+    while (item_queue.size() > spec.limit) {
+        auto it = item_queue.begin();
+        item_t item = **it;
+        item_queue.erase(it);
+        truncated.push_back(item.first);
+        bool inserted = shadow_queue.insert(std::move(item)).second;
+        guarantee(inserted);
+    }
+    shadow_queue.truncate_top(shadow_size());
+    return truncated;
+}
+
 void limit_manager_t::commit(
     rwlock_in_line_t *spot,
     const boost::variant<primary_ref_t, sindex_ref_t> &sindex_ref) THROWS_NOTHING {
@@ -1140,6 +1382,10 @@ void limit_manager_t::commit(
         if (data_deleted) {
             bool inserted = real_deleted.insert(id).second;
             guarantee(inserted);
+        } else {
+            // Deleting from the shadow set doesn't change what's in it: it's still
+            // exactly the items that follow the active set.
+            UNUSED bool shadow_deleted = shadow_queue.del_id(id);
         }
     }
     deleted.clear();
@@ -1156,13 +1402,20 @@ void limit_manager_t::commit(
             guarantee(inserted);
             inserted = real_added.insert(pair).second;
             guarantee(inserted);
+        } else if (shadow_queue.size() != 0
+                   && !gt(item_t(pair), item_t(**shadow_queue.begin()))) {
+            // It doesn't make it into the active set, but it beats something we're
+            // keeping in the shadow set, so it belongs there too.
+            bool inserted = shadow_queue.insert(pair).second;
+            guarantee(inserted);
         } else {
             added_on_disk = true;
         }
     }
     added.clear();
+    shadow_queue.truncate_top(shadow_size());
 
-    std::vector<std::string> truncated = item_queue.truncate_top(spec.limit);
+    std::vector<std::string> truncated = truncate_to_shadow();
     for (auto &&id : truncated) {
         auto it = real_added.find_id(id);
         if (it != real_added.end()) {
@@ -1173,12 +1426,36 @@ void limit_manager_t::commit(
         }
     }
 
+    // If we lost items from the active set, we first replace them with the best
+    // items from the shadow set, which are the next best items in the table.
+    while (item_queue.size() < spec.limit && shadow_queue.size() != 0) {
+        auto it = std::prev(shadow_queue.end());
+        item_t item = **it;
+        shadow_queue.erase(it);
+        bool inserted = item_queue.insert(item).second;
+        guarantee(inserted);
+        inserted = real_added.insert(std::move(item)).second;
+        guarantee(inserted);
+    }
+
     bool anything_on_disk = real_deleted.size() != 0 || added_on_disk;
     if (item_queue.size() < spec.limit && anything_on_disk) {
+        // The shadow set is empty now, and the active set holds every item up to its
+        // worst one (which might be better than `active_boundary` if we deleted
+        // it), so we continue reading from there.  We read some extra items to
+        // fill up the shadow set again, so that we don't have to come back to the
+        // disk for the next few items that leave the active set.
+        guarantee(shadow_queue.size() == 0);
+        optional<item_t> start;
+        if (item_queue.size() != 0) {
+            start.set(**item_queue.begin());
+        } else {
+            start = active_boundary;
+        }
         std::vector<item_t> s;
         optional<exc_t> exc;
         try {
-            s = read_more(sindex_ref, active_boundary);
+            s = read_more(sindex_ref, start);
         } catch (const exc_t &e) {
             exc.set(e);
         }
@@ -1196,9 +1473,9 @@ void limit_manager_t::commit(
                 guarantee(added_insert);
             }
         }
-        // We need to truncate again because `read_more` may read too much in
-        // the secondary index case.
-        std::vector<std::string> read_trunc = item_queue.truncate_top(spec.limit);
+        // We need to truncate again because `read_more` reads extra items for the
+        // shadow set (and may read too much in the secondary index case).
+        std::vector<std::string> read_trunc = truncate_to_shadow();
         for (auto &&id : read_trunc) {
             auto it = real_added.find_id(id);
             if (it != real_added.end()) {
@@ -1258,9 +1535,9 @@ RDB_IMPL_SERIALIZABLE_3(msg_t::limit_change_t, sub, old_key, new_val);
 INSTANTIATE_SERIALIZABLE_FOR_CLUSTER(msg_t::limit_change_t);
 RDB_IMPL_SERIALIZABLE_2(msg_t::limit_stop_t, sub, exc);
 INSTANTIATE_SERIALIZABLE_FOR_CLUSTER(msg_t::limit_stop_t);
-RDB_IMPL_SERIALIZABLE_5(
+RDB_IMPL_SERIALIZABLE_6(
     msg_t::change_t,
-    old_indexes, new_indexes, pkey, old_val, new_val);
+    old_indexes, new_indexes, pkey, old_val, new_val, position);
 INSTANTIATE_SERIALIZABLE_FOR_CLUSTER(msg_t::change_t);
 RDB_IMPL_SERIALIZABLE_0_SINCE_v1_13(msg_t::stop_t);
 
@@ -1551,6 +1828,7 @@ public:
     virtual void add_el(
         const uuid_u &shard_uuid,
         uint64_t stamp,
+        uint64_t position,
         const store_key_t &pkey,
         const optional<std::string> &DEBUG_ONLY(sindex),
         optional<indexed_datum_t> old_val,
@@ -1564,6 +1842,7 @@ public:
             last_stamp = stamp_pair;
             queue->add(change_val_t(
                 std::make_pair(shard_uuid, stamp),
+                position,
                 pkey,
                 std::move(old_val),
                 std::move(new_val)
@@ -1619,6 +1898,11 @@ public:
     void add_limit_sub(limit_sub_t *sub, const uuid_u &uuid) THROWS_NOTHING;
     void del_limit_sub(limit_sub_t *sub, const uuid_u &uuid) THROWS_NOTHING;
 
+    void add_watcher(change_watcher_t *watcher) THROWS_NOTHING;
+    void del_watcher(change_watcher_t *watcher) THROWS_NOTHING;
+    void each_watcher(const auto_drainer_t::lock_t &lock,
+                      const std::function<void(change_watcher_t *)> &f) THROWS_NOTHING;
+
     void each_range_sub(const auto_drainer_t::lock_t &lock,
                         const std::function<void(range_sub_t *)> &f) THROWS_NOTHING;
     void update_stamps(uuid_u server_uuid, uint64_t stamp);
@@ -1688,6 +1972,9 @@ private:
     rwlock_t range_subs_lock;
     std::map<uuid_u, std::vector<std::set<limit_sub_t *> > > limit_subs;
     rwlock_t limit_subs_lock;
+    // Watchers count as subscriptions, so that the feed stays around for them.
+    std::vector<std::set<change_watcher_t *> > watchers;
+    rwlock_t watchers_lock;
 
     // This stores the latest stamps we've received.  It's OK for this to
     // be a tiny bit behind what we've sent the subs.
@@ -1740,14 +2027,14 @@ private:
     virtual void maybe_remove_feed() { client->maybe_remove_feed(client_lock, table_id); }
     virtual void stop_limit_sub(limit_sub_t *sub);
 
-    void mailbox_cb(signal_t *interruptor, stamped_msg_t msg);
+    void mailbox_cb(signal_t *interruptor, std::vector<stamped_msg_t> msgs);
     void constructor_cb();
 
     auto_drainer_t::lock_t client_lock;
     client_t *client;
     namespace_id_t table_id;
     mailbox_manager_t *manager;
-    mailbox_t<stamped_msg_t> mailbox;
+    mailbox_t<std::vector<stamped_msg_t> > mailbox;
     std::vector<server_t::addr_t> stop_addrs;
     std::vector<scoped_ptr_t<disconnect_watcher_t> > disconnect_watchers;
 
@@ -2075,6 +2362,7 @@ public:
         uint64_t start_stamp = resp->stamp.second;
         initial_val.set(change_val_t(
                resp->stamp,
+               0,
                store_key_t(pkey.print_primary()),
                r_nullopt,
                make_optional(indexed_datum_t(resp->initial_val, r_nullopt))
@@ -2126,6 +2414,7 @@ public:
         }
         initial_val.set(change_val_t(
             std::make_pair(nil_uuid(), 0),
+            0,
             store_key_t(pkey.print_primary()),
             r_nullopt,
             make_optional(indexed_datum_t(initial, r_nullopt))
@@ -2155,6 +2444,33 @@ counted_t<splice_stream_t> make_splice_stream(Args &&...args) {
     return make_counted<splice_stream_t>(std::forward<Args>(args)...);
 }
 
+// Returns true if the results of a transformation only depend on the value it's
+// applied to, so that subscriptions with the same transformations can share them.
+class shareable_transform_visitor_t : public boost::static_visitor<bool> {
+public:
+    bool operator()(const map_wire_func_t &f) const {
+        return is_shareable(f);
+    }
+    bool operator()(const filter_wire_func_t &f) const {
+        return is_shareable(f.filter_func)
+            && (!f.default_filter_val || is_shareable(*f.default_filter_val));
+    }
+    bool operator()(const concatmap_wire_func_t &f) const {
+        return is_shareable(f);
+    }
+    template<class T>
+    bool operator()(const T &) const {
+        return false;
+    }
+private:
+    static bool is_shareable(const wire_func_t &f) {
+        // All of our subscriptions run on this server, but each query has its own
+        // value of `r.now()`.
+        return f.compile_wire_func()->is_deterministic().test(
+            single_server_t::yes, constant_now_t::no);
+    }
+};
+
 class range_sub_t : public flat_sub_t {
 public:
     // Throws QL exceptions.
@@ -2165,6 +2481,8 @@ public:
                 const datum_t &_squash,
                 bool _include_states,
                 bool _include_types,
+                bool _include_positions,
+                optional<std::map<uuid_u, uint64_t> > _resume_from,
                 env_t *outer_env,
                 keyspec_t::range_t _spec)
         // We don't turn on squashing until later for range subs.  (We need to
@@ -2177,6 +2495,8 @@ public:
                      _squash,
                      _include_states,
                      _include_types),
+          include_positions(_include_positions),
+          resume_from(std::move(_resume_from)),
           spec(std::move(_spec)),
           state(state_t::READY),
           sent_state(state_t::NONE),
@@ -2185,6 +2505,7 @@ public:
         for (const auto &transform : spec.transforms) {
             ops.push_back(make_op(transform));
         }
+        ops_sharing_key = make_ops_sharing_key(outer_env);
         store_keys = spec.datumspec.primary_key_map();
         if (!store_keys.has_value()) {
             store_key_range.set(spec.datumspec.covering_range().to_primary_keyrange());
@@ -2242,6 +2563,123 @@ public:
     optional<datum_t> maybe_apply_ops(datum_t val) {
         return has_ops() ? apply_ops(std::move(val)) : make_optional(std::move(val));
     }
+    // Subscriptions with the same non-empty key apply the same transformations in
+    // equivalent environments, so they get the same results from `apply_ops`.
+    const std::string &get_ops_sharing_key() const { return ops_sharing_key; }
+
+    // Works out which elements `change` adds to the subscription, and calls
+    // `add(old_val, new_val)` for each of them.  Values that the transformations
+    // produce are shared through `shared_vals` (if it isn't null) with the other
+    // subscriptions with the same sharing key.
+    template<class F>
+    void each_el(const msg_t::change_t &change,
+                 std::map<std::string, std::pair<datum_t, datum_t> > *shared_vals,
+                 const F &add) {
+        datum_t null = datum_t::null();
+        datum_t new_val = null, old_val = null;
+        if (!active()) return;
+        bool trivial = false;
+        if (has_ops()) {
+            const std::string &key = get_ops_sharing_key();
+            if (key.empty()) {
+                shared_vals = nullptr;
+            }
+            const std::pair<datum_t, datum_t> *shared = nullptr;
+            if (shared_vals != nullptr) {
+                auto it = shared_vals->find(key);
+                if (it != shared_vals->end()) {
+                    shared = &it->second;
+                }
+            }
+            if (shared != nullptr) {
+                new_val = shared->first;
+                old_val = shared->second;
+            } else {
+                if (change.new_val.has()) {
+                    if (optional<datum_t> d = apply_ops(change.new_val)) {
+                        new_val = *d;
+                    }
+                }
+                if (!active()) return;
+                if (change.old_val.has()) {
+                    if (optional<datum_t> d = apply_ops(change.old_val)) {
+                        old_val = *d;
+                    }
+                }
+                if (!active()) return;
+                if (shared_vals != nullptr) {
+                    shared_vals->insert(
+                        std::make_pair(key, std::make_pair(new_val, old_val)));
+                }
+            }
+            // Duplicate values are caught before being written to disk and
+            // don't generate a `mod_report`, but if we have transforms the
+            // values might have changed.
+            trivial = (new_val == old_val);
+        } else {
+            guarantee(change.old_val.has() || change.new_val.has());
+            if (change.new_val.has()) {
+                new_val = change.new_val;
+            }
+            if (change.old_val.has()) {
+                old_val = change.old_val;
+            }
+        }
+        ASSERT_NO_CORO_WAITING;
+        optional<std::string> sindex_name = sindex();
+        if (sindex_name) {
+            std::vector<indexed_datum_t> old_idxs, new_idxs;
+            auto old_it = change.old_indexes.find(*sindex_name);
+            if (old_it != change.old_indexes.end()) {
+                for (const auto &idx : old_it->second) {
+                    for (size_t i = 0; i < copies(idx.first); ++i) {
+                        old_idxs.push_back(
+                            indexed_datum_t(old_val, make_optional(idx.second)));
+                    }
+                }
+            }
+            auto new_it = change.new_indexes.find(*sindex_name);
+            if (new_it != change.new_indexes.end()) {
+                for (const auto &idx : new_it->second) {
+                    for (size_t i = 0; i < copies(idx.first); ++i) {
+                        new_idxs.push_back(
+                            indexed_datum_t(new_val, make_optional(idx.second)));
+                    }
+                }
+            }
+            while (old_idxs.size() > 0 && new_idxs.size() > 0) {
+                if (!trivial) {
+                    add(make_optional(std::move(old_idxs.back())),
+                        make_optional(std::move(new_idxs.back())));
+                }
+                old_idxs.pop_back();
+                new_idxs.pop_back();
+            }
+            while (old_idxs.size() > 0) {
+                guarantee(new_idxs.size() == 0);
+                if (old_val != null) {
+                    add(make_optional(std::move(old_idxs.back())),
+                        r_nullopt);
+                }
+                old_idxs.pop_back();
+            }
+            while (new_idxs.size() > 0) {
+                guarantee(old_idxs.size() == 0);
+                if (new_val != null) {
+                    add(r_nullopt,
+                        make_optional(std::move(new_idxs.back())));
+                }
+                new_idxs.pop_back();
+            }
+        } else {
+            if (!trivial) {
+                for (size_t i = 0; i < copies(change.pkey); ++i) {
+                    add(make_optional(indexed_datum_t(old_val, r_nullopt)),
+                        make_optional(indexed_datum_t(new_val, r_nullopt)));
+                }
+            }
+        }
+    }
 
     bool update_stamp(const uuid_u &uuid, uint64_t new_stamp) final {
         guarantee(active());
@@ -2259,8 +2697,21 @@ public:
             if (artificial_include_initial && artificial_initial_vals.size() == 0) {
                 state = state_t::READY;
             }
-            return maybe_add_type(state_datum(sent_state),
-                                  change_type_t::STATE);
+            datum_t d = maybe_add_type(state_datum(sent_state), change_type_t::STATE);
+            return sent_state == state_t::READY ? maybe_add_position(std::move(d)) : d;
+        }
+        if (!resumed_vals.empty()) {
+            change_val_t cv = std::move(resumed_vals.front());
+            resumed_vals.pop_front();
+            note_position(cv);
+            if (resumed_vals.empty()) {
+                // Everything up to the positions from the stamp read has been seen.
+                for (const auto &pair : stamp_positions) {
+                    positions[pair.first] = std::max(positions[pair.first], pair.second);
+                }
+            }
+            return maybe_add_position(
+                change_val_to_change(cv, false, false, include_types));
         }
         if (artificial_initial_vals.size() != 0) {
             datum_t d = artificial_initial_vals.back();
@@ -2272,17 +2723,41 @@ public:
                 vals_to_change(datum_t(), d, true),
                 change_type_t::INITIAL);
         }
-        return change_val_to_change(pop_change_val(),
-                                    false,
-                                    false,
-                                    include_types);
+        change_val_t cv = pop_change_val();
+        note_position(cv);
+        return maybe_add_position(
+            change_val_to_change(cv, false, false, include_types));
     }
     bool has_el() final {
         return (include_states && state != sent_state)
+            || !resumed_vals.empty()
             || artificial_initial_vals.size() != 0
             || has_change_val();
     }
 
+    void note_position(const change_val_t &cv) {
+        uint64_t *position = &positions[cv.source_stamp.first];
+        *position = std::max(*position, cv.position);
+    }
+    // Positions are only handed out once the initial values (if any) have all been
+    // sent, since a feed that resumes doesn't get them again.
+    datum_t maybe_add_position(datum_t &&datum) {
+        if (!include_positions || !datum.has() || state != state_t::READY) {
+            return std::move(datum);
+        }
+        std::map<datum_string_t, datum_t> position;
+        for (const auto &pair : positions) {
+            position[datum_string_t(uuid_to_str(pair.first))] =
+                datum_t(static_cast<double>(pair.second));
+        }
+        return datum.merge(
+            datum_t{
+                std::map<datum_string_t, datum_t>{
+                    std::pair<datum_string_t, datum_t>{
+                        datum_string_t("position"),
+                        datum_t(std::move(position))}}});
+    }
+
     void maybe_enable_squashing() {
         if (squash) {
             scoped_ptr_t<maybe_squashing_queue_t> old_queue = std::move(queue);
@@ -2305,10 +2780,12 @@ public:
         r_sanity_check(self.get() == this);
 
         read_response_t read_resp;
+        changefeed_stamp_t stamp(addr);
+        stamp.resume_from = resume_from;
         // Note that we use the `outer_env`'s interruptor for the read.
         nif->read(
             outer_env->get_user_context(),
-            read_t(changefeed_stamp_t(addr),
+            read_t(std::move(stamp),
                    profile_bool_t::DONT_PROFILE,
                    read_mode_t::SINGLE),
             &read_resp, order_token_t::ignore, outer_env->interruptor);
@@ -2316,6 +2793,45 @@ public:
         guarantee(resp != nullptr);
         rcheck_datum(resp->stamp_infos.has_value(), base_exc_t::RESUMABLE_OP_FAILED,
                      "Unable to retrieve the start stamps.  Did you just reshard?");
+        if (resume_from) {
+            // The feed can only resume if every changefeed server it was getting
+            // changes from is still there and still has the changes it missed.
+            bool resumable = resume_from->size() == resp->stamp_infos->size();
+            for (const auto &pair : *resp->stamp_infos) {
+                resumable = resumable && pair.second.resumed_changes.has_value();
+            }
+            rcheck_datum(resumable, base_exc_t::OP_FAILED,
+                         "Cannot resume the changefeed from this position, because "
+                         "the table was resharded, a server restarted, or too many "
+                         "changes happened since.  Open it again with "
+                         "`include_initial` instead.");
+            positions = *resume_from;
+            for (const auto &pair : *resp->stamp_infos) {
+                for (const msg_t::change_t &change : *pair.second.resumed_changes) {
+                    each_el(
+                        change,
+                        nullptr,
+                        [&](optional<indexed_datum_t> &&old_val,
+                            optional<indexed_datum_t> &&new_val) {
+                            resumed_vals.push_back(change_val_t(
+                                std::make_pair(pair.first, 0),
+                                change.position,
+                                change.pkey,
+                                std::move(old_val),
+                                std::move(new_val)
+                                DEBUG_ONLY(, sindex())));
+                        });
+                }
+            }
+        }
+        for (const auto &pair : *resp->stamp_infos) {
+            stamp_positions[pair.first] = pair.second.position;
+        }
+        if (resumed_vals.empty()) {
+            for (const auto &pair : stamp_positions) {
+                positions[pair.first] = std::max(positions[pair.first], pair.second);
+            }
+        }
         std::map<uuid_u, uint64_t> purge_stamps;
         for (const auto &pair : *resp->stamp_infos) {
             const auto id_stamp_pair = std::make_pair(pair.first, pair.second.stamp);
@@ -2358,6 +2874,8 @@ public:
         backtrace_id_t bt) {
         assert_thread();
         r_sanity_check(self.get() == this);
+        rcheck_datum(!include_positions && !resume_from, base_exc_t::LOGIC,
+                     "Changefeeds on system tables can't be resumed.");
 
         artificial_include_initial = include_initial;
 
@@ -2396,13 +2914,46 @@ private:
                 nullptr/*don't profile*/);
     }
 
+    std::string make_ops_sharing_key(env_t *outer_env) {
+        if (!has_ops() || outer_env->get_rdb_ctx() == nullptr) {
+            return std::string();
+        }
+        for (const auto &transform : spec.transforms) {
+            if (!boost::apply_visitor(shareable_transform_visitor_t(), transform)) {
+                return std::string();
+            }
+        }
+        // Two subscriptions get the same key if the functions in their
+        // transformations serialize the same way and their queries were run with the
+        // same global optargs.
+        write_message_t wm;
+        serialize<cluster_version_t::CLUSTER>(&wm, spec.transforms);
+        serialize<cluster_version_t::CLUSTER>(
+            &wm, outer_env->get_serializable_env().global_optargs);
+        string_stream_t stream;
+        int res = send_write_message(&stream, &wm);
+        guarantee(res == 0);
+        return stream.str();
+    }
+
     scoped_ptr_t<env_t> env;
     std::vector<scoped_ptr_t<op_t> > ops;
+    std::string ops_sharing_key;
 
     // The stamp (see `stamped_msg_t`) associated with our `changefeed_stamp_t`
     // read.  We use these to make sure we don't see changes from writes before
     // our subscription.
     std::map<uuid_u, uint64_t> orig_stamps, next_stamps;
+
+    // See `server_t::get_stamp()`.  `positions` has the position of the last change
+    // we've sent from each changefeed server, and `stamp_positions` the positions at
+    // our `changefeed_stamp_t` read.  If we resumed from an earlier feed's position,
+    // `resumed_vals` has the changes it missed, and we send them first.
+    const bool include_positions;
+    const optional<std::map<uuid_u, uint64_t> > resume_from;
+    std::map<uuid_u, uint64_t> positions, stamp_positions;
+    std::deque<change_val_t> resumed_vals;
+
     keyspec_t::range_t spec;
     optional<std::map<store_key_t, uint64_t> > store_keys;
     optional<key_range_t> store_key_range;
@@ -2836,102 +3387,29 @@ public:
             });
     }
     void operator()(const msg_t::change_t &change) const {
-        datum_t null = datum_t::null();
+        // Many clients often subscribe to the same transformed changefeed, so we
+        // remember the transformed values by sharing key and only compute them once
+        // per change on each thread.  (The subscriptions on different threads are
+        // handled concurrently, so each thread gets its own map.)
+        std::vector<std::map<std::string, std::pair<datum_t, datum_t> > >
+            shared_vals(get_num_threads());
 
         feed->each_range_sub(*lock, [&](range_sub_t *sub) {
-            datum_t new_val = null, old_val = null;
-            if (!sub->active()) return;
-            bool trivial = false;
-            if (sub->has_ops()) {
-                if (change.new_val.has()) {
-                    if (optional<datum_t> d = sub->apply_ops(change.new_val)) {
-                        new_val = *d;
-                    }
-                }
-                if (!sub->active()) return;
-                if (change.old_val.has()) {
-                    if (optional<datum_t> d = sub->apply_ops(change.old_val)) {
-                        old_val = *d;
-                    }
-                }
-                if (!sub->active()) return;
-                // Duplicate values are caught before being written to disk and
-                // don't generate a `mod_report`, but if we have transforms the
-                // values might have changed.
-                trivial = (new_val == old_val);
-            } else {
-                guarantee(change.old_val.has() || change.new_val.has());
-                if (change.new_val.has()) {
-                    new_val = change.new_val;
-                }
-                if (change.old_val.has()) {
-                    old_val = change.old_val;
-                }
-            }
-            ASSERT_NO_CORO_WAITING;
-            optional<std::string> sindex = sub->sindex();
-            if (sindex) {
-                std::vector<indexed_datum_t> old_idxs, new_idxs;
-                auto old_it = change.old_indexes.find(*sindex);
-                if (old_it != change.old_indexes.end()) {
-                    for (const auto &idx : old_it->second) {
-                        for (size_t i = 0; i < sub->copies(idx.first); ++i) {
-                            old_idxs.push_back(
-                                indexed_datum_t(old_val, make_optional(idx.second)));
-                        }
-                    }
-                }
-                auto new_it = change.new_indexes.find(*sindex);
-                if (new_it != change.new_indexes.end()) {
-                    for (const auto &idx : new_it->second) {
-                        for (size_t i = 0; i < sub->copies(idx.first); ++i) {
-                            new_idxs.push_back(
-                                indexed_datum_t(new_val, make_optional(idx.second)));
-                        }
-                    }
-                }
-                while (old_idxs.size() > 0 && new_idxs.size() > 0) {
-                    if (!trivial) {
-                        sub->add_el(server_uuid, stamp, change.pkey, sindex,
-                                    make_optional(std::move(old_idxs.back())),
-                                    make_optional(std::move(new_idxs.back())));
-                    }
-                    old_idxs.pop_back();
-                    new_idxs.pop_back();
-                }
-                while (old_idxs.size() > 0) {
-                    guarantee(new_idxs.size() == 0);
-                    if (old_val != null) {
-                        sub->add_el(server_uuid, stamp, change.pkey, sindex,
-                                    make_optional(std::move(old_idxs.back())),
-                                    r_nullopt);
-                    }
-                    old_idxs.pop_back();
-                }
-                while (new_idxs.size() > 0) {
-                    guarantee(old_idxs.size() == 0);
-                    if (new_val != null) {
-                        sub->add_el(server_uuid, stamp, change.pkey, sindex,
-                                    r_nullopt,
-                                    make_optional(std::move(new_idxs.back())));
-                    }
-                    new_idxs.pop_back();
-                }
-            } else {
-                if (!trivial) {
-                    for (size_t i = 0; i < sub->copies(change.pkey); ++i) {
-                        sub->add_el(server_uuid, stamp, change.pkey, sindex,
-                                    make_optional(indexed_datum_t(old_val, r_nullopt)),
-                                    make_optional(indexed_datum_t(new_val, r_nullopt)));
-                    }
-                }
-            }
+            const optional<std::string> sindex = sub->sindex();
+            sub->each_el(
+                change,
+                &shared_vals[get_thread_id().threadnum],
+                [&](optional<indexed_datum_t> &&old_val,
+                    optional<indexed_datum_t> &&new_val) {
+                    sub->add_el(server_uuid, stamp, change.position, change.pkey,
+                                sindex, std::move(old_val), std::move(new_val));
+                });
         });
         feed->on_point_sub(
             change.pkey,
             *lock,
             [&](point_sub_t *sub) {
-                sub->add_el(server_uuid, stamp, change.pkey, r_nullopt,
+                sub->add_el(server_uuid, stamp, change.position, change.pkey, r_nullopt,
                             change.old_val.has()
                                 ? optional<indexed_datum_t>(
                                         indexed_datum_t(change.old_val, r_nullopt))
@@ -2941,6 +3419,9 @@ public:
                                         indexed_datum_t(change.new_val, r_nullopt))
                                 : r_nullopt);
             });
+        feed->each_watcher(*lock, [&](change_watcher_t *watcher) {
+                watcher->on_change(change.pkey);
+            });
     }
     void operator()(const msg_t::stop_t &) const {
         feed->abort_feed();
@@ -2962,7 +3443,7 @@ void msg_visit(feed_t *feed,
     feed->update_stamps(server_uuid, stamp);
 }
 
-void real_feed_t::mailbox_cb(signal_t *, stamped_msg_t msg) {
+void real_feed_t::mailbox_cb(signal_t *, std::vector<stamped_msg_t> msgs) {
     // We stop receiving messages when detached (we're only receiving
     // messages because we haven't managed to get a message to the
     // stop mailboxes for some of the primary replicas yet).  This also stops
@@ -2977,9 +3458,12 @@ void real_feed_t::mailbox_cb(signal_t *, stamped_msg_t msg) {
         wait_any.wait_lazily_unordered();
         if (detached) return;
         if (!lock.get_drain_signal()->is_pulsed()) {
+            // A batch only ever comes from one server.
+            guarantee(!msgs.empty());
+            const uuid_u server_uuid = msgs[0].server_uuid;
             // We don't need a lock for this because the set of `uuid_u`s never
             // changes after it's initialized.
-            auto it = queues.find(msg.server_uuid);
+            auto it = queues.find(server_uuid);
             guarantee(it != queues.end());
             queue_t *queue = it->second.get();
             guarantee(queue != NULL);
@@ -2989,8 +3473,11 @@ void real_feed_t::mailbox_cb(signal_t *, stamped_msg_t msg) {
             if (detached) return;
 
             // Add us to the queue.
-            guarantee(msg.stamp >= queue->next);
-            queue->map.push(std::move(msg));
+            for (auto &&msg : msgs) {
+                guarantee(msg.server_uuid == server_uuid);
+                guarantee(msg.stamp >= queue->next);
+                queue->map.push(std::move(msg));
+            }
 
             // Read as much as we can from the queue (this enforces ordering.)
             while (queue->map.size() != 0 && queue->map.top().stamp == queue->next) {
@@ -3042,6 +3529,7 @@ private:
             if (read_once) {
                 while (sub->has_change_val() && !batcher.should_send_batch()) {
                     change_val_t cv = sub->pop_change_val();
+                    sub->note_position(cv);
                     // Note that `discard` updates the `stamped_ranges`.
                     datum_t el = change_val_to_change(
                         cv,
@@ -3584,6 +4072,27 @@ void feed_t::each_sub_in_vec(
          });
 }
 
+void feed_t::add_watcher(change_watcher_t *watcher) THROWS_NOTHING {
+    add_sub_with_lock(&watchers_lock, [this, watcher]() {
+        auto pair = watchers[watcher->home_thread().threadnum].insert(watcher);
+        guarantee(pair.second);
+    });
+}
+
+void feed_t::del_watcher(change_watcher_t *watcher) THROWS_NOTHING {
+    del_sub_with_lock(&watchers_lock, [this, watcher]() {
+        return watchers[watcher->home_thread().threadnum].erase(watcher);
+    });
+}
+
+void feed_t::each_watcher(
+    const auto_drainer_t::lock_t &lock,
+    const std::function<void(change_watcher_t *)> &f) THROWS_NOTHING {
+    assert_thread();
+    rwlock_in_line_t spot(&watchers_lock, access_t::read);
+    each_sub_in_vec(watchers, &spot, lock, f);
+}
+
 void feed_t::each_range_sub(
     const auto_drainer_t::lock_t &lock,
     const std::function<void(range_sub_t *)> &f) THROWS_NOTHING {
@@ -3719,6 +4228,19 @@ void feed_t::stop_subs(const auto_drainer_t::lock_t &lock) {
         }
         limit_subs.clear();
     }
+    {
+        rwlock_in_line_t spot(&watchers_lock, access_t::write);
+        spot.write_signal()->wait_lazily_unordered();
+        each_sub_in_vec<change_watcher_t>(
+            watchers, &spot, lock, [](change_watcher_t *watcher) {
+                watcher->feed = nullptr;
+                watcher->on_stop();
+            });
+        for (auto &&set : watchers) {
+            num_subs -= set.size();
+            set.clear();
+        }
+    }
     guarantee(num_subs == 0);
 }
 
@@ -3729,6 +4251,7 @@ feed_t::feed_t(
     num_subs(0),
     empty_subs(get_num_threads()),
     range_subs(get_num_threads()),
+    watchers(get_num_threads()),
     table_id(_table_id),
     name_resolver(_name_resolver) { }
 
@@ -3771,6 +4294,8 @@ scoped_ptr_t<subscription_t> new_sub(
                 ss->squash,
                 ss->include_states,
                 ss->include_types,
+                ss->include_positions,
+                ss->resume_from,
                 env,
                 range);
         }
@@ -3815,6 +4340,10 @@ scoped_ptr_t<subscription_t> new_sub(
         feed_t *feed;
         const streamspec_t *ss;
     };
+    rcheck_datum((!ss.include_positions && !ss.resume_from)
+                     || boost::get<keyspec_t::range_t>(&ss.spec) != nullptr,
+                 base_exc_t::LOGIC,
+                 "Only changefeeds on tables and ranges can have positions.");
     return scoped_ptr_t<subscription_t>(
         boost::apply_visitor(spec_visitor_t(env, feed, &ss), ss.spec));
 }
@@ -3824,6 +4353,8 @@ streamspec_t::streamspec_t(counted_t<datum_stream_t> _maybe_src,
                            bool _include_offsets,
                            bool _include_states,
                            bool _include_types,
+                           bool _include_positions,
+                           optional<std::map<uuid_u, uint64_t> > _resume_from,
                            configured_limits_t _limits,
                            datum_t _squash,
                            keyspec_t::spec_t _spec) :
@@ -3832,6 +4363,8 @@ streamspec_t::streamspec_t(counted_t<datum_stream_t> _maybe_src,
     include_offsets(std::move(_include_offsets)),
     include_states(std::move(_include_states)),
     include_types(std::move(_include_types)),
+    include_positions(_include_positions),
+    resume_from(std::move(_resume_from)),
     limits(std::move(_limits)),
     squash(std::move(_squash)),
     spec(std::move(_spec)) { }
@@ -3934,6 +4467,47 @@ counted_t<datum_stream_t> client_t::new_stream(
     }
 }
 
+void client_t::add_watcher(const namespace_id_t &table_id,
+                           change_watcher_t *watcher,
+                           signal_t *interruptor) {
+    watcher->assert_thread();
+    guarantee(watcher->feed == nullptr);
+    cross_thread_signal_t ct_interruptor(interruptor, home_thread());
+    on_thread_t th(home_thread());
+    auto_drainer_t::lock_t lock(&drainer, throw_if_draining_t::YES);
+    rwlock_in_line_t spot(&feeds_lock, access_t::write);
+    spot.read_signal()->wait_lazily_unordered();
+    auto feed_it = feeds.find(table_id);
+    if (feed_it == feeds.end()) {
+        spot.write_signal()->wait_lazily_unordered();
+        namespace_interface_access_t access =
+            namespace_source(table_id, &ct_interruptor);
+        auto val = make_scoped<real_feed_t>(
+            lock,
+            this,
+            manager,
+            access.get(),
+            table_id,
+            &ct_interruptor,
+            make_lifetime(name_resolver));
+        feed_it = feeds.insert(std::make_pair(table_id, std::move(val))).first;
+    }
+    // As in `new_stream()`, we subscribe while holding `feeds_lock`, so that the feed
+    // can't be removed in the meantime.
+    real_feed_t *feed = feed_it->second.get();
+    watcher->feed = feed;
+    feed->add_watcher(watcher);
+}
+
+void client_t::remove_watcher(change_watcher_t *watcher) {
+    watcher->assert_thread();
+    feed_t *feed = watcher->feed;
+    if (feed != nullptr) {
+        watcher->feed = nullptr;
+        feed->del_watcher(watcher);
+    }
+}
+
 void client_t::maybe_remove_feed(
     const auto_drainer_t::lock_t &lock, const uuid_u &uuid) {
     assert_thread();
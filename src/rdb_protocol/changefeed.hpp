@@ -103,6 +103,8 @@ struct msg_t {
         `new_val` is an empty `datum_t`. */
         datum_t old_val;
         datum_t new_val;
+        /* Set by the `server_t` that sends the change. See `server_t::get_stamp()`. */
+        uint64_t position;
         RDB_DECLARE_ME_SERIALIZABLE(change_t);
     };
     struct stop_t {
@@ -129,10 +131,12 @@ struct msg_t {
 
 RDB_DECLARE_SERIALIZABLE(msg_t);
 
+class feed_t;
 class real_feed_t;
 struct stamped_msg_t;
 
-typedef mailbox_addr_t<stamped_msg_t> client_addr_t;
+// Servers send changes to clients in batches.
+typedef mailbox_addr_t<std::vector<stamped_msg_t> > client_addr_t;
 
 struct keyspec_t {
     struct range_t {
@@ -184,6 +188,10 @@ struct streamspec_t {
     bool include_offsets;
     bool include_states;
     bool include_types;
+    // Whether changes carry the position to resume from after them, and the
+    // position to resume from, if any.  Only range feeds on real tables have them.
+    bool include_positions;
+    optional<std::map<uuid_u, uint64_t> > resume_from;
     configured_limits_t limits;
     datum_t squash;
     keyspec_t::spec_t spec;
@@ -192,6 +200,8 @@ struct streamspec_t {
                  bool _include_offsets,
                  bool _include_states,
                  bool _include_types,
+                 bool _include_positions,
+                 optional<std::map<uuid_u, uint64_t> > _resume_from,
                  configured_limits_t _limits,
                  datum_t _squash,
                  keyspec_t::spec_t _spec);
@@ -202,6 +212,27 @@ RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(keyspec_t::empty_t);
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(keyspec_t::limit_t);
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(keyspec_t::point_t);
 
+// Hears about every change to a table, from the same feed as the table's
+// subscriptions but without their queues and stamps.  The read cache (see
+// `rdb_protocol/read_cache.hpp`) uses it to forget rows.  The callbacks are called
+// on the thread the watcher was created on, and must not block.
+class change_watcher_t : public home_thread_mixin_t {
+public:
+    // The row with this primary key changed.
+    virtual void on_change(const store_key_t &pkey) = 0;
+    // The feed stopped (for example because a server became unreachable), and
+    // there won't be any more changes.  The watcher is removed from the client.
+    virtual void on_stop() = 0;
+protected:
+    change_watcher_t() : feed(nullptr) { }
+    virtual ~change_watcher_t() { }
+private:
+    friend class client_t;
+    friend class feed_t;
+    feed_t *feed;
+    DISABLE_COPYING(change_watcher_t);
+};
+
 // The `client_t` exists on the server handling the changefeed query, in the
 // `rdb_context_t`.  When a query subscribes to the changes on a table, it
 // should call `new_stream`.  The `client_t` will give it back a stream of rows.
@@ -228,6 +259,14 @@ public:
         const streamspec_t &ss,
         const namespace_id_t &table_id,
         backtrace_id_t bt);
+    // Starts telling `watcher` about changes to the table, subscribing to the
+    // table's shards first if no one has yet.  Throws `cannot_perform_query_exc_t`
+    // if they can't be reached.
+    void add_watcher(const namespace_id_t &table_id,
+                     change_watcher_t *watcher,
+                     signal_t *interruptor);
+    // Must be called before `watcher` is destroyed, unless it was stopped.
+    void remove_watcher(change_watcher_t *watcher);
     void maybe_remove_feed(
         const auto_drainer_t::lock_t &lock, const namespace_id_t &uuid);
     scoped_ptr_t<real_feed_t> detach_feed(
@@ -437,6 +476,10 @@ private:
     std::vector<item_t> read_more(
         const boost::variant<primary_ref_t, sindex_ref_t> &ref,
         const optional<item_t> &start);
+    size_t shadow_size() const;
+    // Truncates `item_queue` to `spec.limit` items and returns the ids that were
+    // removed, which are moved to `shadow_queue`.
+    std::vector<std::string> truncate_to_shadow();
     void send(msg_t &&msg);
 
     scoped_ptr_t<env_t> env;
@@ -449,6 +492,11 @@ private:
 
     limit_order_t gt;
     item_queue_t item_queue;
+    /* The items that come right after the ones in `item_queue`, up to
+    `shadow_size()` of them.  When items leave the active set, we replace them from
+    here instead of reading from disk.  We only refill this when we have to read from
+    disk anyway. */
+    item_queue_t shadow_queue;
 
     std::map<std::string, std::pair<datum_t, datum_t> > added;
     std::set<std::string> deleted;
@@ -496,6 +544,19 @@ public:
     optional<uint64_t> get_stamp(
         const client_t::addr_t &addr,
         const auto_drainer_t::lock_t &keepalive);
+    // Every change the server sends out gets the next position, and the server keeps
+    // the most recent ones so that a feed can pick up where an earlier one left off.
+    // Like the other `get_stamp()`, but also sets `*position_out` to the position of
+    // the last change sent out before the stamp.  If `resume_from` is set,
+    // `*resumed_changes_out` gets the changes after that position (up to and
+    // including `*position_out`), or stays empty if the server no longer has all of
+    // them.
+    optional<uint64_t> get_stamp(
+        const client_t::addr_t &addr,
+        const optional<uint64_t> &resume_from,
+        uint64_t *position_out,
+        optional<std::vector<msg_t::change_t> > *resumed_changes_out,
+        const auto_drainer_t::lock_t &keepalive);
     uuid_u get_uuid();
     // `f` will be called with a read lock on `clients` and a write lock on the
     // limit manager.
@@ -534,6 +595,8 @@ private:
         client_info_t();
         scoped_ptr_t<cond_t> cond;
         uint64_t stamp;
+        // Messages that have been stamped but not sent yet, in stamp order.
+        std::vector<std::pair<uint64_t, msg_t> > pending;
         std::vector<region_t> regions;
         std::map<optional<std::string>,
                  std::vector<scoped_ptr_t<limit_manager_t>>> limit_clients;
@@ -552,6 +615,13 @@ private:
                             msg_t msg,
                             const auto_drainer_t::lock_t &lock);
 
+    // Stamps `msg` and adds it to the client's pending messages.  Returns true if
+    // there weren't any pending messages before, in which case the caller should
+    // make sure that they get sent.
+    bool add_pending(client_info_t *info, msg_t msg);
+    std::vector<stamped_msg_t> take_pending(client_info_t *info);
+    void send_pending_cb(client_t::addr_t addr, auto_drainer_t::lock_t keepalive);
+
     // Controls access to `clients`.  A `server_t` needs to read `clients` when:
     // * `send_all` is called
     // * `get_stamp` is called
@@ -566,6 +636,11 @@ private:
     // We need access to the stamp lock that exists on the parent.
     store_t *parent;
 
+    // The position of the last change sent out, and the most recent changes in order
+    // of position.  Both are protected by the parent's stamp lock, like the stamps.
+    uint64_t last_position;
+    std::deque<msg_t::change_t> recent_changes;
+
     auto_drainer_t drainer;
     // Clients send a message to this mailbox with their address when they want
     // to unsubscribe.  The callback of this mailbox acquires the drainer, so it
@@ -0,0 +1,56 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/client_chunks.hpp"
+
+#include "assignment_sentry.hpp"
+#include "concurrency/cond_var.hpp"
+#include "concurrency/interruptor.hpp"
+
+namespace ql {
+
+client_chunks_t::client_chunks_t()
+    : room(CLIENT_CHUNKS_BUFFER_SIZE),
+      next_push(0),
+      next_pop(0),
+      pushed_end(false),
+      popped_end(false),
+      next_chunk_arrived(nullptr) { }
+
+bool client_chunks_t::push(std::vector<datum_t> &&docs, signal_t *interruptor) {
+    if (pushed_end) {
+        return false;
+    }
+    pushed_end = docs.empty();
+    uint64_t number = next_push++;
+    new_semaphore_in_line_t acq(&room, 1);
+    wait_interruptible(acq.acquisition_signal(), interruptor);
+
+    auto res = chunks.insert(std::make_pair(number, chunk_t()));
+    guarantee(res.second);
+    res.first->second.docs = std::move(docs);
+    res.first->second.room = std::move(acq);
+    if (number == next_pop && next_chunk_arrived != nullptr) {
+        next_chunk_arrived->pulse_if_not_already_pulsed();
+    }
+    return true;
+}
+
+std::vector<datum_t> client_chunks_t::pop(signal_t *interruptor) {
+    if (popped_end) {
+        return std::vector<datum_t>();
+    }
+    auto it = chunks.find(next_pop);
+    if (it == chunks.end()) {
+        cond_t arrived;
+        assignment_sentry_t<cond_t *> sentry(&next_chunk_arrived, &arrived);
+        wait_interruptible(&arrived, interruptor);
+        it = chunks.find(next_pop);
+        guarantee(it != chunks.end());
+    }
+    std::vector<datum_t> docs = std::move(it->second.docs);
+    chunks.erase(it);
+    ++next_pop;
+    popped_end = docs.empty();
+    return docs;
+}
+
+}  // namespace ql
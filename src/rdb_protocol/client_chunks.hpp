@@ -0,0 +1,68 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_CLIENT_CHUNKS_HPP_
+#define RDB_PROTOCOL_CLIENT_CHUNKS_HPP_
+
+#include <stdint.h>
+
+#include <map>
+#include <vector>
+
+#include "concurrency/new_semaphore.hpp"
+#include "errors.hpp"
+#include "rdb_protocol/datum.hpp"
+
+class cond_t;
+class signal_t;
+
+namespace ql {
+
+/* How many chunks a query holds on to before the `CHUNK` queries sending it more
+have to wait. */
+const int64_t CLIENT_CHUNKS_BUFFER_SIZE = 4;
+
+/* The documents a client sends to a running query with `CHUNK` queries on the
+query's token, which the query reads with `r.chunks()`. An empty chunk ends them.
+
+A `CHUNK` query that finds the buffer full waits, and keeps its place among the
+connection's concurrent queries while it does, so a client that sends chunks faster
+than the query can use them is eventually no longer read from. That lets a loader
+send `tbl.insert(r.chunks())` and then its documents without waiting for replies,
+while the server writes each chunk as it arrives and holds only a few of them. */
+class client_chunks_t {
+public:
+    client_chunks_t();
+
+    /* The `CHUNK` queries must call this in the order they arrived, which they do
+    because it's called before they block for the first time. Returns `false` if the
+    chunks already ended. */
+    MUST_USE bool push(std::vector<datum_t> &&docs, signal_t *interruptor);
+
+    /* Waits for the next chunk. Returns an empty vector once the chunks ended. */
+    std::vector<datum_t> pop(signal_t *interruptor);
+
+    bool has_ended() const { return popped_end; }
+
+private:
+    struct chunk_t {
+        std::vector<datum_t> docs;
+        // Released when the chunk is popped
+        new_semaphore_in_line_t room;
+    };
+
+    new_semaphore_t room;
+    // Chunks can finish waiting for room in a different order than they arrived in,
+    // so they're numbered.
+    uint64_t next_push;
+    uint64_t next_pop;
+    std::map<uint64_t, chunk_t> chunks;
+    bool pushed_end;
+    bool popped_end;
+    // Set while `pop` waits for the next chunk
+    cond_t *next_chunk_arrived;
+
+    DISABLE_COPYING(client_chunks_t);
+};
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_CLIENT_CHUNKS_HPP_
@@ -0,0 +1,471 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "rdb_protocol/compiled_func.hpp"
+
+#include <algorithm>
+
+#include "math.hpp"
+#include "rdb_protocol/configured_limits.hpp"
+#include "rdb_protocol/error.hpp"
+#include "rdb_protocol/ql2proto.hpp"
+#include "rdb_protocol/term_storage.hpp"
+
+namespace ql {
+
+counted_t<const compiled_func_t> compiled_func_t::compile(
+        const std::vector<sym_t> &arg_names,
+        const raw_term_t &body) {
+    if (arg_names.size() != 1) {
+        return counted_t<const compiled_func_t>();
+    }
+    counted_t<compiled_func_t> compiled(new compiled_func_t());
+    size_t result_register;
+    if (!compiled->compile_term(body, arg_names[0].value, &result_register)
+        || compiled->instructions.size() > MAX_INSTRUCTIONS) {
+        return counted_t<const compiled_func_t>();
+    }
+    guarantee(result_register + 1 == compiled->instructions.size());
+    return compiled;
+}
+
+bool compiled_func_t::compile_term(const raw_term_t &term,
+                                   int64_t arg_var,
+                                   size_t *register_out) {
+    // `pluck` on a sequence becomes a `map` over `row.pluck(..., _NO_RECURSE_: true)`.
+    const size_t allowed_optargs =
+        term.type() == Term::PLUCK && term.optarg("_NO_RECURSE_").has_value() ? 1 : 0;
+    if (term.num_optargs() != allowed_optargs
+        || instructions.size() >= MAX_INSTRUCTIONS) {
+        return false;
+    }
+
+    instruction_t instruction;
+    switch (static_cast<int>(term.type())) {
+    case Term::VAR: {
+        if (term.num_args() != 1 || term.arg(0).type() != Term::DATUM) {
+            return false;
+        }
+        datum_t name = term.arg(0).datum();
+        if (name.get_type() != datum_t::R_NUM || name.as_num() != arg_var) {
+            // A variable from the captured scope.
+            return false;
+        }
+        instruction.opcode = opcode_t::ARG;
+    } break;
+    case Term::IMPLICIT_VAR: {
+        // See `function_emits_implicit_variable()`.
+        if (term.num_args() != 0 || arg_var < 0) {
+            return false;
+        }
+        instruction.opcode = opcode_t::ARG;
+    } break;
+    case Term::DATUM: {
+        instruction.opcode = opcode_t::CONSTANT;
+        instruction.constant
+            = term.datum(configured_limits_t::unlimited, reql_version_t::LATEST);
+    } break;
+    case Term::BRACKET: // fallthru
+    case Term::GET_FIELD: {
+        if (term.num_args() != 2 || term.arg(1).type() != Term::DATUM) {
+            return false;
+        }
+        datum_t field = term.arg(1).datum();
+        if (field.get_type() != datum_t::R_STR) {
+            // `bracket` with a number is `nth`.
+            return false;
+        }
+        instruction.opcode = opcode_t::GET_FIELD;
+        instruction.fields.push_back(field.as_str());
+    } break;
+    case Term::PLUCK: // fallthru
+    case Term::HAS_FIELDS: {
+        if (term.num_args() < 1) {
+            return false;
+        }
+        for (size_t i = 1; i < term.num_args(); ++i) {
+            if (term.arg(i).type() != Term::DATUM) {
+                return false;
+            }
+            datum_t field = term.arg(i).datum();
+            if (field.get_type() != datum_t::R_STR) {
+                return false;
+            }
+            instruction.fields.push_back(field.as_str());
+        }
+        instruction.opcode = term.type() == Term::PLUCK
+            ? opcode_t::PLUCK
+            : opcode_t::HAS_FIELDS;
+    } break;
+    case Term::NOT: {
+        if (term.num_args() != 1) {
+            return false;
+        }
+        instruction.opcode = opcode_t::NOT;
+    } break;
+    case Term::AND: instruction.opcode = opcode_t::AND; break;
+    case Term::OR: instruction.opcode = opcode_t::OR; break;
+    case Term::EQ: instruction.opcode = opcode_t::EQ; break;
+    case Term::NE: instruction.opcode = opcode_t::NE; break;
+    case Term::LT: instruction.opcode = opcode_t::LT; break;
+    case Term::LE: instruction.opcode = opcode_t::LE; break;
+    case Term::GT: instruction.opcode = opcode_t::GT; break;
+    case Term::GE: instruction.opcode = opcode_t::GE; break;
+    case Term::ADD: instruction.opcode = opcode_t::ADD; break;
+    case Term::SUB: instruction.opcode = opcode_t::SUB; break;
+    case Term::MUL: instruction.opcode = opcode_t::MUL; break;
+    case Term::MAKE_ARRAY: instruction.opcode = opcode_t::MAKE_ARRAY; break;
+    default:
+        return false;
+    }
+
+    switch (instruction.opcode) {
+    case opcode_t::EQ: // fallthru
+    case opcode_t::NE: // fallthru
+    case opcode_t::LT: // fallthru
+    case opcode_t::LE: // fallthru
+    case opcode_t::GT: // fallthru
+    case opcode_t::GE:
+        // The interpreter rejects comparisons with fewer than two arguments.
+        if (term.num_args() < 2) {
+            return false;
+        }
+        // fallthru
+    case opcode_t::ADD: // fallthru
+    case opcode_t::SUB: // fallthru
+    case opcode_t::MUL:
+        if (term.num_args() < 1) {
+            return false;
+        }
+        // fallthru
+    case opcode_t::NOT: // fallthru
+    case opcode_t::AND: // fallthru
+    case opcode_t::OR: // fallthru
+    case opcode_t::MAKE_ARRAY:
+        for (size_t i = 0; i < term.num_args(); ++i) {
+            size_t arg_register;
+            if (!compile_term(term.arg(i), arg_var, &arg_register)) {
+                return false;
+            }
+            instruction.args.push_back(arg_register);
+        }
+        break;
+    case opcode_t::GET_FIELD: // fallthru
+    case opcode_t::HAS_FIELDS: // fallthru
+    case opcode_t::PLUCK: {
+        size_t arg_register;
+        if (!compile_term(term.arg(0), arg_var, &arg_register)) {
+            return false;
+        }
+        instruction.args.push_back(arg_register);
+    } break;
+    case opcode_t::ARG: // fallthru
+    case opcode_t::CONSTANT:
+        break;
+    default:
+        unreachable();
+    }
+
+    if (instructions.size() >= MAX_INSTRUCTIONS) {
+        return false;
+    }
+    instructions.push_back(std::move(instruction));
+    *register_out = instructions.size() - 1;
+    return true;
+}
+
+compiled_func_t::result_t compiled_func_t::call(
+        const datum_t &arg, const configured_limits_t &limits) const {
+    result_t registers[MAX_INSTRUCTIONS];
+    auto reg = [&](size_t i) -> const result_t & { return registers[i]; };
+    for (size_t i = 0; i < instructions.size(); ++i) {
+        execute(instructions[i], arg, reg, limits, &registers[i]);
+    }
+    return std::move(registers[instructions.size() - 1]);
+}
+
+void compiled_func_t::call_batch(const std::vector<datum_t> &args,
+                                 const configured_limits_t &limits,
+                                 std::vector<result_t> *results_out) const {
+    std::vector<std::vector<result_t> > columns(instructions.size());
+    for (size_t i = 0; i < instructions.size(); ++i) {
+        columns[i].resize(args.size());
+        for (size_t row = 0; row < args.size(); ++row) {
+            auto reg = [&](size_t r) -> const result_t & { return columns[r][row]; };
+            execute(instructions[i], args[row], reg, limits, &columns[i][row]);
+        }
+    }
+    *results_out = std::move(columns.back());
+}
+
+bool compiled_func_t::get_field_projection(std::vector<datum_string_t> *fields_out,
+                                           bool *is_array_out) const {
+    auto get_field_of_arg = [&](size_t r) -> bool {
+        const instruction_t &instruction = instructions[r];
+        if (instruction.opcode != opcode_t::GET_FIELD
+            || instructions[instruction.args[0]].opcode != opcode_t::ARG) {
+            return false;
+        }
+        fields_out->push_back(instruction.fields[0]);
+        return true;
+    };
+
+    fields_out->clear();
+    const instruction_t &result = instructions.back();
+    if (result.opcode == opcode_t::MAKE_ARRAY) {
+        for (size_t r : result.args) {
+            if (!get_field_of_arg(r)) {
+                return false;
+            }
+        }
+        *is_array_out = true;
+        return true;
+    } else {
+        *is_array_out = false;
+        return get_field_of_arg(instructions.size() - 1);
+    }
+}
+
+bool compiled_func_t::only_reads_fields(
+        const std::vector<datum_string_t> &fields) const {
+    if (instructions.back().opcode == opcode_t::ARG) {
+        return false;
+    }
+    for (const instruction_t &instruction : instructions) {
+        for (size_t r : instruction.args) {
+            if (instructions[r].opcode != opcode_t::ARG) {
+                continue;
+            }
+            if (instruction.opcode != opcode_t::GET_FIELD
+                && instruction.opcode != opcode_t::HAS_FIELDS
+                && instruction.opcode != opcode_t::PLUCK) {
+                return false;
+            }
+            for (const datum_string_t &field : instruction.fields) {
+                if (std::find(fields.begin(), fields.end(), field) == fields.end()) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+namespace {
+
+// An object we can access fields of without going through the interpreter.
+bool is_plain_object(const datum_t &d) {
+    return d.get_type() == datum_t::R_OBJECT && !d.is_ptype();
+}
+
+bool is_number(const datum_t &d) {
+    return d.get_type() == datum_t::R_NUM;
+}
+
+}  // namespace
+
+template <class register_fun_t>
+void compiled_func_t::execute(const instruction_t &instruction,
+                              const datum_t &arg,
+                              const register_fun_t &reg,
+                              const configured_limits_t &limits,
+                              result_t *out) {
+    // Evaluation failures are recorded in the register, and only become the
+    // function's result if no `and`, `or` or comparison skips over the register
+    // first, like the interpreter's short-circuiting evaluation would.
+    auto fail = [&](status_t status) {
+        out->value.reset();
+        out->status = status;
+    };
+    auto succeed = [&](datum_t value) {
+        out->value = std::move(value);
+        out->status = status_t::OK;
+    };
+
+    try {
+        switch (instruction.opcode) {
+        case opcode_t::ARG: {
+            succeed(arg);
+        } break;
+        case opcode_t::CONSTANT: {
+            succeed(instruction.constant);
+        } break;
+        case opcode_t::GET_FIELD: {
+            const result_t &in = reg(instruction.args[0]);
+            if (in.status != status_t::OK) {
+                *out = in;
+            } else if (!is_plain_object(in.value)) {
+                // Arrays map over their elements, and everything else throws some
+                // error or other; let the interpreter deal with them.
+                fail(status_t::UNKNOWN);
+            } else {
+                datum_t value = in.value.get_field(instruction.fields[0], NOTHROW);
+                if (value.has()) {
+                    succeed(std::move(value));
+                } else {
+                    fail(status_t::NON_EXISTENCE);
+                }
+            }
+        } break;
+        case opcode_t::HAS_FIELDS: {
+            const result_t &in = reg(instruction.args[0]);
+            if (in.status != status_t::OK) {
+                *out = in;
+            } else if (!is_plain_object(in.value)) {
+                fail(status_t::UNKNOWN);
+            } else {
+                bool res = true;
+                for (const datum_string_t &field : instruction.fields) {
+                    datum_t value = in.value.get_field(field, NOTHROW);
+                    if (!value.has() || value.get_type() == datum_t::R_NULL) {
+                        res = false;
+                        break;
+                    }
+                }
+                succeed(datum_t::boolean(res));
+            }
+        } break;
+        case opcode_t::PLUCK: {
+            const result_t &in = reg(instruction.args[0]);
+            if (in.status != status_t::OK) {
+                *out = in;
+            } else if (!is_plain_object(in.value)) {
+                fail(status_t::UNKNOWN);
+            } else {
+                datum_object_builder_t res;
+                for (const datum_string_t &field : instruction.fields) {
+                    datum_t value = in.value.get_field(field, NOTHROW);
+                    if (value.has()) {
+                        res.overwrite(field, std::move(value));
+                    }
+                }
+                succeed(std::move(res).to_datum());
+            }
+        } break;
+        case opcode_t::NOT: {
+            const result_t &in = reg(instruction.args[0]);
+            if (in.status != status_t::OK) {
+                *out = in;
+            } else {
+                succeed(datum_t::boolean(!in.value.as_bool()));
+            }
+        } break;
+        case opcode_t::AND: // fallthru
+        case opcode_t::OR: {
+            // `and` returns the first falsy argument and `or` the first truthy one,
+            // or the last argument if there's none.
+            const bool stop_on = instruction.opcode == opcode_t::OR;
+            succeed(datum_t::boolean(!stop_on));
+            for (size_t r : instruction.args) {
+                *out = reg(r);
+                if (out->status != status_t::OK || out->value.as_bool() == stop_on) {
+                    break;
+                }
+            }
+        } break;
+        case opcode_t::EQ: // fallthru
+        case opcode_t::NE: // fallthru
+        case opcode_t::LT: // fallthru
+        case opcode_t::LE: // fallthru
+        case opcode_t::GT: // fallthru
+        case opcode_t::GE: {
+            const result_t *lhs = &reg(instruction.args[0]);
+            const result_t *failed = lhs->status == status_t::OK ? nullptr : lhs;
+            bool res = true;
+            for (size_t i = 1; failed == nullptr && i < instruction.args.size(); ++i) {
+                const result_t *rhs = &reg(instruction.args[i]);
+                if (rhs->status != status_t::OK) {
+                    failed = rhs;
+                    break;
+                }
+                bool holds;
+                switch (instruction.opcode) {
+                case opcode_t::EQ: // fallthru
+                case opcode_t::NE: holds = lhs->value == rhs->value; break;
+                case opcode_t::LT: holds = lhs->value.cmp(rhs->value) < 0; break;
+                case opcode_t::LE: holds = lhs->value.cmp(rhs->value) <= 0; break;
+                case opcode_t::GT: holds = lhs->value.cmp(rhs->value) > 0; break;
+                case opcode_t::GE: holds = lhs->value.cmp(rhs->value) >= 0; break;
+                default: unreachable();
+                }
+                if (!holds) {
+                    res = false;
+                    break;
+                }
+                lhs = rhs;
+            }
+            if (failed != nullptr) {
+                *out = *failed;
+            } else {
+                // `ne` is the inverse of `eq`, so that `r.ne(1, 2, 3)` makes sense.
+                succeed(datum_t::boolean(res != (instruction.opcode == opcode_t::NE)));
+            }
+        } break;
+        case opcode_t::ADD: // fallthru
+        case opcode_t::SUB: // fallthru
+        case opcode_t::MUL: {
+            const result_t &first = reg(instruction.args[0]);
+            if (first.status != status_t::OK) {
+                *out = first;
+                break;
+            }
+            double acc = 0;
+            bool numeric = is_number(first.value);
+            if (numeric) {
+                acc = first.value.as_num();
+            }
+            const result_t *failed = nullptr;
+            for (size_t i = 1; i < instruction.args.size(); ++i) {
+                const result_t &rhs = reg(instruction.args[i]);
+                if (rhs.status != status_t::OK) {
+                    failed = &rhs;
+                    break;
+                }
+                if (!numeric || !is_number(rhs.value)) {
+                    // Strings, arrays and times.
+                    numeric = false;
+                    break;
+                }
+                switch (instruction.opcode) {
+                case opcode_t::ADD: acc += rhs.value.as_num(); break;
+                case opcode_t::SUB: acc -= rhs.value.as_num(); break;
+                case opcode_t::MUL: acc *= rhs.value.as_num(); break;
+                default: unreachable();
+                }
+            }
+            if (failed != nullptr) {
+                *out = *failed;
+            } else if (!numeric || !risfinite(acc)) {
+                fail(status_t::UNKNOWN);
+            } else if (instruction.args.size() == 1) {
+                *out = first;
+            } else {
+                succeed(datum_t(acc));
+            }
+        } break;
+        case opcode_t::MAKE_ARRAY: {
+            std::vector<datum_t> elements;
+            elements.reserve(instruction.args.size());
+            const result_t *failed = nullptr;
+            for (size_t r : instruction.args) {
+                const result_t &element = reg(r);
+                if (element.status != status_t::OK) {
+                    failed = &element;
+                    break;
+                }
+                elements.push_back(element.value);
+            }
+            if (failed != nullptr) {
+                *out = *failed;
+            } else {
+                succeed(datum_t(std::move(elements), limits));
+            }
+        } break;
+        default:
+            unreachable();
+        }
+    } catch (const base_exc_t &) {
+        // This includes `datum_exc_t`.
+        fail(status_t::UNKNOWN);
+    }
+}
+
+}  // namespace ql
@@ -0,0 +1,133 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_COMPILED_FUNC_HPP_
+#define RDB_PROTOCOL_COMPILED_FUNC_HPP_
+
+#include <vector>
+
+#include "containers/counted.hpp"
+#include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/sym.hpp"
+
+namespace ql {
+
+class configured_limits_t;
+class raw_term_t;
+
+/* A `compiled_func_t` is the body of a one-argument ReQL function, lowered from the
+term tree into a flat list of instructions.  Instruction `i` writes its result to
+register `i`, and only reads registers of earlier instructions, so evaluating the
+function is a single pass over the list with no `val_t`s, no `scope_env_t` and no
+virtual calls.
+
+Only a small set of terms can be compiled: the argument, constants, field access with
+a constant string (`row('a')`), `has_fields` and `pluck` with constant strings, `eq`,
+`ne`, `lt`, `le`, `gt`, `ge`, `not`, `and`, `or`, `add`, `sub` and `mul` on numbers,
+and `make_array`.  That covers most secondary index functions and a good share of `map`
+and `filter` functions.
+
+Compiled functions don't produce error messages.  Whenever the interpreter would throw
+anything (or do something more involved, like mapping `row('a')` over an array), the
+call reports `NON_EXISTENCE` or `UNKNOWN` and the caller must fall back to evaluating
+the term tree, which produces the real result or error. */
+class compiled_func_t : public slow_atomic_countable_t<compiled_func_t> {
+public:
+    enum class status_t {
+        OK,
+        // The interpreter would throw a non-existence error.
+        NON_EXISTENCE,
+        // The interpreter would throw some other error, or do something we don't
+        // support.
+        UNKNOWN
+    };
+
+    struct result_t {
+        result_t() : status(status_t::UNKNOWN) { }
+        // Empty unless `status` is `OK`.
+        datum_t value;
+        status_t status;
+    };
+
+    // Returns an empty pointer if `body` uses terms that we can't compile.
+    static counted_t<const compiled_func_t> compile(const std::vector<sym_t> &arg_names,
+                                                    const raw_term_t &body);
+
+    // Evaluates the function for a single argument without allocating registers.
+    result_t call(const datum_t &arg, const configured_limits_t &limits) const;
+
+    // Evaluates the function for a batch of arguments.  Register `i` becomes a column
+    // holding instruction `i`'s results for all of `args`.
+    void call_batch(const std::vector<datum_t> &args,
+                    const configured_limits_t &limits,
+                    std::vector<result_t> *results_out) const;
+
+    // If the function only picks a top-level field out of its argument (`row('a')`),
+    // or makes an array of them (`[row('a'), row('b')]`), sets `*fields_out` to the
+    // fields, sets `*is_array_out` to whether it was an array and returns true.
+    bool get_field_projection(std::vector<datum_string_t> *fields_out,
+                              bool *is_array_out) const;
+
+    // Whether the function only looks at its argument through `row(f)`,
+    // `has_fields(f, ...)` and `pluck(f, ...)` with every `f` in `fields`, so that
+    // calling it on an object with just those fields gives the same result as calling
+    // it on the whole row.
+    bool only_reads_fields(const std::vector<datum_string_t> &fields) const;
+
+private:
+    enum class opcode_t {
+        ARG,
+        CONSTANT,
+        GET_FIELD,
+        HAS_FIELDS,
+        PLUCK,
+        NOT,
+        AND,
+        OR,
+        EQ,
+        NE,
+        LT,
+        LE,
+        GT,
+        GE,
+        ADD,
+        SUB,
+        MUL,
+        MAKE_ARRAY
+    };
+
+    struct instruction_t {
+        opcode_t opcode;
+        // The registers this instruction reads.
+        std::vector<size_t> args;
+        // For `CONSTANT`.
+        datum_t constant;
+        // For `GET_FIELD` (exactly one), `HAS_FIELDS` and `PLUCK`.
+        std::vector<datum_string_t> fields;
+    };
+
+    // The register file of `call()` lives on the stack, so longer function bodies are
+    // left to the interpreter.
+    static const size_t MAX_INSTRUCTIONS = 64;
+
+    compiled_func_t() { }
+
+    // Appends the instructions for `term` and sets `*register_out` to the register
+    // holding its result.  Returns false if `term` can't be compiled.
+    bool compile_term(const raw_term_t &term, int64_t arg_var, size_t *register_out);
+
+    /* Computes the result of `instruction` into `*out`.  `reg(i)` must return the
+    contents of register `i` for the same argument. */
+    template <class register_fun_t>
+    static void execute(const instruction_t &instruction,
+                        const datum_t &arg,
+                        const register_fun_t &reg,
+                        const configured_limits_t &limits,
+                        result_t *out);
+
+    std::vector<instruction_t> instructions;
+
+    DISABLE_COPYING(compiled_func_t);
+};
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_COMPILED_FUNC_HPP_
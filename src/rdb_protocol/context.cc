@@ -72,13 +72,18 @@ rdb_context_t::stats_t::stats_t(perfmon_collection_t *global_stats)
       queries_per_sec_membership(&qe_stats_collection,
                                  &queries_per_sec, "queries_per_sec"),
       queries_total_membership(&qe_stats_collection,
-                               &queries_total, "queries_total") { }
+                               &queries_total, "queries_total"),
+      query_latency(secs_to_ticks(10)),
+      query_latency_membership(&qe_stats_collection,
+                               &query_latency, "query_latency") { }
 
 rdb_context_t::rdb_context_t()
     : extproc_pool(nullptr),
       cluster_interface(nullptr),
       manager(nullptr),
       reql_http_proxy(),
+      io_backender(nullptr),
+      user_quotas(nullptr),
       stats(&get_global_perfmon_collection()) { }
 
 rdb_context_t::rdb_context_t(
@@ -90,6 +95,8 @@ rdb_context_t::rdb_context_t(
       cluster_interface(_cluster_interface),
       manager(nullptr),
       reql_http_proxy(),
+      io_backender(nullptr),
+      user_quotas(nullptr),
       stats(&get_global_perfmon_collection()) {
     init_auth_watchables(auth_semilattice_view);
 }
@@ -101,11 +108,16 @@ rdb_context_t::rdb_context_t(
         std::shared_ptr<semilattice_read_view_t<auth_semilattice_metadata_t>>
             auth_semilattice_view,
         perfmon_collection_t *global_stats,
-        const std::string &_reql_http_proxy)
+        const std::string &_reql_http_proxy,
+        io_backender_t *_io_backender,
+        const base_path_t &_base_path)
     : extproc_pool(_extproc_pool),
       cluster_interface(_cluster_interface),
       manager(_mailbox_manager),
       reql_http_proxy(_reql_http_proxy),
+      io_backender(_io_backender),
+      base_path(_base_path),
+      user_quotas(nullptr),
       stats(global_stats) {
     init_auth_watchables(auth_semilattice_view);
 }
@@ -129,6 +141,10 @@ std::set<ql::query_cache_t *> *rdb_context_t::get_query_caches_for_this_thread()
     return query_caches.get();
 }
 
+ql::query_span_log_t *rdb_context_t::get_query_spans_for_this_thread() {
+    return query_spans.get();
+}
+
 clone_ptr_t<watchable_t<auth_semilattice_metadata_t>>
         rdb_context_t::get_auth_watchable() const{
     return m_cross_thread_auth_watchables[get_thread_id().threadnum]->get_watchable();
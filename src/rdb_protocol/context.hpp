@@ -15,12 +15,14 @@
 #include "containers/optional.hpp"
 #include "containers/scoped.hpp"
 #include "containers/uuid.hpp"
+#include "paths.hpp"
 #include "perfmon/perfmon.hpp"
 #include "protocol_api.hpp"
 #include "rdb_protocol/changefeed.hpp"
 #include "rdb_protocol/datum.hpp"
 #include "rdb_protocol/geo/distances.hpp"
 #include "rdb_protocol/geo/lon_lat_types.hpp"
+#include "rdb_protocol/query_trace.hpp"
 #include "rdb_protocol/shards.hpp"
 #include "rdb_protocol/wire_func.hpp"
 
@@ -45,8 +47,10 @@ ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(
 class auth_semilattice_metadata_t;
 class ellipsoid_spec_t;
 class extproc_pool_t;
+class io_backender_t;
 class name_string_t;
 class namespace_interface_t;
+class user_quotas_t;
 template <class> class cross_thread_watchable_variable_t;
 template <class> class semilattice_read_view_t;
 
@@ -171,6 +175,19 @@ public:
 
     virtual ql::datum_t read_row(ql::env_t *env,
         ql::datum_t pval, read_mode_t read_mode) = 0;
+    /* Like `read_row()`, but the row may be cut down to the fields that `pluck()`
+    would keep for `paths`. Tables that can't do that just return the whole row. */
+    virtual ql::datum_t read_row_projected(ql::env_t *env,
+        ql::datum_t pval, ql::datum_t, read_mode_t read_mode) {
+        return read_row(env, pval, read_mode);
+    }
+    /* Sets `*rows_out` to `num` distinct rows chosen at random, without reading all of
+    the rows. Returns false if the table can't do that or doesn't have enough rows for
+    it to be worthwhile, in which case the rows have to be sampled from a full scan. */
+    virtual bool read_sample(ql::env_t *, uint64_t, read_mode_t,
+                             std::vector<ql::datum_t> *) {
+        return false;
+    }
     virtual counted_t<ql::datum_stream_t> read_all(
         ql::env_t *env,
         const std::string &sindex,
@@ -179,6 +196,19 @@ public:
         const ql::datumspec_t &datumspec,
         sorting_t sorting,
         read_mode_t read_mode) = 0;
+    /* Like `read_all()` for the `get_all` keys in `datumspec`, but only returns the
+    rows that also have the key `intersect[index]` in each of the other indexes. */
+    virtual counted_t<ql::datum_stream_t> read_all_intersected(
+        ql::env_t *,
+        const std::string &,
+        ql::backtrace_id_t,
+        const std::string &,
+        const ql::datumspec_t &,
+        const std::map<std::string, ql::datum_t> &,
+        read_mode_t) {
+        rfail_datum(ql::base_exc_t::OP_FAILED,
+                    "This table doesn't support `get_all` with `intersect`.");
+    }
     virtual counted_t<ql::datum_stream_t> read_changes(
         ql::env_t *env,
         const ql::changefeed::streamspec_t &ss,
@@ -275,6 +305,8 @@ public:
             const table_generate_config_params_t &config_params,
             const std::string &primary_key,
             write_durability_t durability,
+            int cpu_sharding_factor,
+            int block_size,
             signal_t *interruptor,
             ql::datum_t *result_out,
             admin_err_t *error_out) = 0;
@@ -299,6 +331,13 @@ public:
             ql::env_t *env,
             std::vector<int64_t> *doc_counts_out,
             admin_err_t *error_out) = 0;
+    virtual bool table_shard_map(
+            auth::user_context_t const &user_context,
+            counted_t<const ql::db_t> db,
+            const name_string_t &name,
+            ql::env_t *env,
+            ql::datum_t *shard_map_out,
+            admin_err_t *error_out) = 0;
     virtual bool table_config(
             auth::user_context_t const &user_context,
             counted_t<const ql::db_t> db,
@@ -468,7 +507,9 @@ public:
         std::shared_ptr<semilattice_read_view_t<auth_semilattice_metadata_t>>
             auth_semilattice_view,
         perfmon_collection_t *global_stats,
-        const std::string &_reql_http_proxy);
+        const std::string &_reql_http_proxy,
+        io_backender_t *_io_backender,
+        const base_path_t &_base_path);
 
     ~rdb_context_t();
 
@@ -479,6 +520,16 @@ public:
 
     const std::string reql_http_proxy;
 
+    // Where queries can put temporary files, for example the runs of an `order_by`
+    // that doesn't fit into memory. `io_backender` is `nullptr` on proxies and in
+    // most unit tests, in which case such queries have to stay in memory.
+    io_backender_t *io_backender;
+    const base_path_t base_path;
+
+    // Set by the server if it was started with per-user limits, and `nullptr`
+    // otherwise. Like `cluster_interface`, it's filled in after construction.
+    user_quotas_t *user_quotas;
+
     class stats_t {
     public:
         explicit stats_t(perfmon_collection_t *global_stats);
@@ -493,12 +544,17 @@ public:
         perfmon_membership_t queries_per_sec_membership;
         perfmon_counter_t queries_total;
         perfmon_membership_t queries_total_membership;
+        perfmon_latency_histogram_t query_latency;
+        perfmon_membership_t query_latency_membership;
     private:
         DISABLE_COPYING(stats_t);
     } stats;
 
     std::set<ql::query_cache_t *> *get_query_caches_for_this_thread();
 
+    // Spans of the traced queries that ran on this thread
+    ql::query_span_log_t *get_query_spans_for_this_thread();
+
     clone_ptr_t<watchable_t<auth_semilattice_metadata_t>> get_auth_watchable() const;
 
 private:
@@ -510,6 +566,7 @@ private:
         auth_semilattice_metadata_t>>> m_cross_thread_auth_watchables;
 
     one_per_thread_t<std::set<ql::query_cache_t *> > query_caches;
+    one_per_thread_t<ql::query_span_log_t> query_spans;
 
     DISABLE_COPYING(rdb_context_t);
 };
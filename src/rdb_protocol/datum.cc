@@ -5,9 +5,11 @@
 #include <math.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <algorithm>
 #include <cmath>
+#include <deque>
 #include <functional>
 #include <iterator>
 
@@ -18,6 +20,7 @@
 #include "cjson/json.hpp"
 #include "containers/archive/stl_types.hpp"
 #include "containers/scoped.hpp"
+#include "containers/uuid.hpp"
 #include "rapidjson/prettywriter.h"
 #include "rapidjson/rapidjson.h"
 #include "rapidjson/stringbuffer.h"
@@ -510,6 +513,101 @@ datum_t to_datum(const rapidjson::Value &json, const configured_limits_t &limits
     }
 }
 
+/* Builds a datum from RapidJSON's SAX events, with the same checks as `to_datum` on
+a `rapidjson::Value`. The reader runs in iterative mode and the nesting is kept on
+`frames`, so deep documents don't need a deep stack. */
+class datum_json_handler_t
+    : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, datum_json_handler_t> {
+public:
+    explicit datum_json_handler_t(const configured_limits_t &_limits)
+        : limits(_limits) { }
+
+    bool Null() { return add(datum_t::null()); }
+    bool Bool(bool b) { return add(datum_t::boolean(b)); }
+    bool Int(int i) { return add(datum_t(static_cast<double>(i))); }
+    bool Uint(unsigned u) { return add(datum_t(static_cast<double>(u))); }
+    bool Int64(int64_t i) { return add(datum_t(static_cast<double>(i))); }
+    bool Uint64(uint64_t u) { return add(datum_t(static_cast<double>(u))); }
+    bool Double(double d) { return add(datum_t(d)); }
+
+    bool String(const char *str, rapidjson::SizeType length, bool) {
+        fail_if_invalid(str, length);
+        return add(datum_t(datum_string_t(length, str)));
+    }
+
+    bool StartObject() {
+        frames.emplace_back(true, limits);
+        return true;
+    }
+    bool Key(const char *str, rapidjson::SizeType length, bool) {
+        fail_if_invalid(str, length);
+        frames.back().key = datum_string_t(length, str);
+        return true;
+    }
+    bool EndObject(rapidjson::SizeType) {
+        const std::set<std::string> pts = { pseudo::literal_string };
+        datum_t res = std::move(frames.back().object).to_datum(pts);
+        frames.pop_back();
+        return add(std::move(res));
+    }
+
+    bool StartArray() {
+        frames.emplace_back(false, limits);
+        return true;
+    }
+    bool EndArray(rapidjson::SizeType) {
+        datum_t res = std::move(frames.back().array).to_datum();
+        frames.pop_back();
+        return add(std::move(res));
+    }
+
+    datum_t result;
+
+private:
+    struct frame_t {
+        frame_t(bool _is_object, const configured_limits_t &_limits)
+            : is_object(_is_object), array(_limits) { }
+        bool is_object;
+        datum_object_builder_t object;
+        datum_array_builder_t array;
+        datum_string_t key;
+    };
+
+    bool add(datum_t &&val) {
+        if (frames.empty()) {
+            result = std::move(val);
+        } else if (frames.back().is_object) {
+            frame_t *frame = &frames.back();
+            bool dup = frame->object.add(frame->key, std::move(val));
+            rcheck_datum(!dup, base_exc_t::LOGIC,
+                         strprintf("Duplicate key %s in JSON.",
+                                   datum_t(frame->key).print().c_str()));
+        } else {
+            frames.back().array.add(std::move(val));
+        }
+        return true;
+    }
+
+    const configured_limits_t &limits;
+    // A deque, so that the builders never have to move
+    std::deque<frame_t> frames;
+};
+
+datum_t parse_json_to_datum(char *json,
+                            const configured_limits_t &limits,
+                            rapidjson::ParseResult *result_out) {
+    rapidjson::InsituStringStream stream(json);
+    rapidjson::Reader reader;
+    datum_json_handler_t handler(limits);
+    *result_out = reader.Parse<rapidjson::kParseInsituFlag
+                               | rapidjson::kParseIterativeFlag
+                               | rapidjson::kParseDefaultFlags>(stream, handler);
+    if (result_out->IsError()) {
+        return datum_t();
+    }
+    return handler.result;
+}
+
 const shared_buf_ref_t<char> *datum_t::get_buf_ref() const {
     if (data.get_internal_type() == internal_type_t::BUF_R_ARRAY
         || data.get_internal_type() == internal_type_t::BUF_R_OBJECT) {
@@ -646,9 +744,24 @@ void datum_t::num_to_str_key(std::string *str_out) const {
         // highest bit flipped as well).
         packed.u ^= (1ULL << 63);
     }
-    // The formatting here is sensitive.  Talk to mlucy before changing it.
-    str_out->append(strprintf("%.*" PRIx64, static_cast<int>(sizeof(double)*2), packed.u));
-    str_out->append(strprintf("#%" PR_RECONSTRUCTABLE_DOUBLE, value));
+    // The formatting here is sensitive.  Talk to mlucy before changing it.  This is
+    // the same as `"%.16" PRIx64 "#%" PR_RECONSTRUCTABLE_DOUBLE`, but only doubles
+    // that aren't integers go through `printf`.  Integers with at most 16 digits come
+    // out of `%.20g` as plain decimal integers.
+    static const char hex_digits[] = "0123456789abcdef";
+    char hex[sizeof(double) * 2];
+    for (size_t i = sizeof(hex); i > 0; --i) {
+        hex[i - 1] = hex_digits[packed.u & 0xf];
+        packed.u >>= 4;
+    }
+    str_out->append(hex, sizeof(hex));
+    str_out->push_back('#');
+    int64_t integer;
+    if (number_as_integer(value, &integer)) {
+        str_out->append(std::to_string(integer));
+    } else {
+        str_out->append(strprintf("%" PR_RECONSTRUCTABLE_DOUBLE, value));
+    }
 }
 
 void datum_t::binary_to_str_key(std::string *str_out) const {
@@ -1086,7 +1199,8 @@ bool tag_skey_version(skey_version_t skey_version, std::string *s) {
     guarantee(s->size() > 0);
     guarantee(!((*s)[0] & 0x80)); // None of our types have the top bit set
     switch (skey_version) {
-    case skey_version_t::post_1_16:
+    case skey_version_t::post_1_16: // fallthru
+    case skey_version_t::post_2_6:
         (*s)[0] |= 0x80; // Flip the top bit to indicate 1.16+ skey_version.
         return true;
     default: unreachable();
@@ -1094,6 +1208,36 @@ bool tag_skey_version(skey_version_t skey_version, std::string *s) {
     unreachable();
 }
 
+// The primary key part of a secondary index key starts with a type prefix, which is
+// always of the form 010xxxxx. A primary key that's a UUID string is instead stored
+// as this byte followed by the 16 bytes of the UUID, which sort in the same order as
+// the lowercase strings they come from.
+static const char COMPACT_UUID_PRIMARY_KEY_PREFIX = '\x60';
+static const size_t UUID_PRIMARY_KEY_SIZE = 1 + uuid_u::kStringSize;
+
+static void compact_uuid_primary_key(std::string *primary) {
+    uuid_u uuid;
+    if (primary->size() != UUID_PRIMARY_KEY_SIZE
+        || (*primary)[0] != 'S'
+        || !str_to_uuid(primary->substr(1), &uuid)
+        || "S" + uuid_to_str(uuid) != *primary) {
+        // Only the canonical form, so that the key can be given back unchanged.
+        return;
+    }
+    primary->assign(1, COMPACT_UUID_PRIMARY_KEY_PREFIX);
+    primary->append(reinterpret_cast<const char *>(uuid.data()), uuid_u::kStaticSize);
+}
+
+static void expand_uuid_primary_key(std::string *primary) {
+    if (primary->size() != 1 + uuid_u::kStaticSize
+        || (*primary)[0] != COMPACT_UUID_PRIMARY_KEY_PREFIX) {
+        return;
+    }
+    uuid_u uuid;
+    memcpy(uuid.data(), primary->data() + 1, uuid_u::kStaticSize);
+    *primary = "S" + uuid_to_str(uuid);
+}
+
 std::string datum_t::mangle_secondary(
     skey_version_t skey_version,
     const std::string &secondary,
@@ -1138,6 +1282,9 @@ std::string datum_t::compose_secondary(
         base_exc_t::LOGIC, strprintf("Primary key too long (max %zu characters): %s",
                                        rdb_protocol::MAX_PRIMARY_KEY_SIZE - 1,
                                        key_to_debug_str(primary_key).c_str()));
+    if (skey_version == skey_version_t::post_2_6) {
+        compact_uuid_primary_key(&primary_key_string);
+    }
 
     std::string tag_string;
     if (tag_num.has_value()) {
@@ -1192,7 +1339,8 @@ std::string datum_t::print_secondary(reql_version_t reql_version,
     }
 
     switch (skey_version) {
-    case skey_version_t::post_1_16:
+    case skey_version_t::post_1_16: // fallthru
+    case skey_version_t::post_2_6:
         secondary_key_string.append(1, '\x00');
         break;
     default: unreachable();
@@ -1201,10 +1349,13 @@ std::string datum_t::print_secondary(reql_version_t reql_version,
     return compose_secondary(skey_version, secondary_key_string, primary_key, tag_num);
 }
 
-skey_version_t skey_version_from_reql_version(reql_version_t) {
-    // We only have one value at the moment, since we've dropped support for pre-1.16
-    // indexes.
-    return skey_version_t::post_1_16;
+skey_version_t skey_version_from_reql_version(reql_version_t rv) {
+    // We've dropped support for pre-1.16 indexes.
+    if (rv < reql_version_t::v2_6) {
+        return skey_version_t::post_1_16;
+    } else {
+        return skey_version_t::post_2_6;
+    }
 }
 
 escape_nulls_t escape_nulls_from_reql_version_for_sindex(reql_version_t rv) {
@@ -1243,6 +1394,7 @@ components_t parse_secondary(const std::string &key) THROWS_NOTHING {
     guarantee(start_of_primary < end_of_primary);
     std::string primary =
         key.substr(start_of_primary, end_of_primary - start_of_primary);
+    expand_uuid_primary_key(&primary);
 
     std::string tag_str = key.substr(start_of_tag, key.size() - (start_of_tag + 2));
     optional<uint64_t> tag_num;
@@ -1280,6 +1432,92 @@ std::string datum_t::extract_secondary(const std::string &secondary_and_primary)
     return components.secondary;
 }
 
+namespace {
+
+// Reads the escaped bytes of a string or binary key up to the next null byte.
+std::string decode_escaped_key_string(const std::string &key, size_t *pos) {
+    std::string out;
+    while (*pos < key.size() && key[*pos] != '\x00') {
+        if (key[*pos] == '\x01' && *pos + 1 < key.size()) {
+            out.push_back(key[*pos + 1] == '\x01' ? '\x00' : '\x01');
+            *pos += 2;
+        } else {
+            out.push_back(key[*pos]);
+            ++*pos;
+        }
+    }
+    return out;
+}
+
+// Decodes the value starting at `*pos` and leaves `*pos` on the null byte that ends
+// it, or returns an empty datum.
+datum_t decode_key_value(const std::string &key, size_t *pos) {
+    if (*pos >= key.size()) {
+        return datum_t();
+    }
+    switch (key[(*pos)++]) {
+    case 'N': {
+        // The sortable hex digits, then `#` and the number itself.
+        size_t hash = *pos + sizeof(double) * 2;
+        size_t end = key.find('\x00', hash);
+        if (hash >= key.size() || key[hash] != '#' || end == std::string::npos) {
+            return datum_t();
+        }
+        std::string printed = key.substr(hash + 1, end - hash - 1);
+        char *printed_end;
+        double d = strtod(printed.c_str(), &printed_end);
+        if (printed.empty() || *printed_end != '\0' || !risfinite(d)) {
+            return datum_t();
+        }
+        *pos = end;
+        return datum_t(d);
+    }
+    case 'S':
+        return datum_t(datum_string_t(decode_escaped_key_string(key, pos)));
+    case 'B':
+        if (*pos >= key.size() || (key[*pos] != 't' && key[*pos] != 'f')) {
+            return datum_t();
+        }
+        return datum_t::boolean(key[(*pos)++] == 't');
+    case 'P': {
+        const std::string binary_key_prefix("BINARY:");
+        if (key.compare(*pos, binary_key_prefix.size(), binary_key_prefix) != 0) {
+            return datum_t();
+        }
+        *pos += binary_key_prefix.size();
+        return datum_t::binary(datum_string_t(decode_escaped_key_string(key, pos)));
+    }
+    case 'A': {
+        // Every element is followed by a null byte, and another null byte where the
+        // next element would start ends the array.
+        std::vector<datum_t> items;
+        while (*pos < key.size() && key[*pos] != '\x00') {
+            datum_t item = decode_key_value(key, pos);
+            if (!item.has() || *pos >= key.size() || key[*pos] != '\x00') {
+                return datum_t();
+            }
+            ++*pos;
+            items.push_back(std::move(item));
+        }
+        return datum_t(std::move(items), configured_limits_t::unlimited);
+    }
+    default:
+        return datum_t();
+    }
+}
+
+}  // namespace
+
+datum_t datum_t::decode_secondary(const std::string &secondary) {
+    size_t pos = 0;
+    datum_t value = decode_key_value(secondary, &pos);
+    // `print_secondary` ends every value with a null byte.
+    if (!value.has() || pos + 1 != secondary.size() || secondary[pos] != '\x00') {
+        return datum_t();
+    }
+    return value;
+}
+
 std::string datum_t::extract_truncated_secondary(
     const std::string &secondary_and_primary) {
     components_t components = parse_secondary(secondary_and_primary);
@@ -1339,7 +1577,8 @@ store_key_t datum_t::truncated_secondary(
     skey_version_t skey_version = skey_version_from_reql_version(reql_version);
 
     // Since 1.16, we add a null byte to the end of the secondary index key.
-    guarantee(skey_version == skey_version_t::post_1_16);
+    guarantee(skey_version == skey_version_t::post_1_16
+              || skey_version == skey_version_t::post_2_6);
     s.push_back('\0');
 
     // Truncate the key if necessary
@@ -1487,37 +1726,52 @@ std::pair<datum_string_t, datum_t> datum_t::unchecked_get_pair(size_t index) con
 }
 
 datum_t datum_t::get_field(const datum_string_t &key, throw_bool_t throw_bool) const {
-    // Use binary search on top of unchecked_get_pair()
-    size_t range_beg = 0;
+    return get_field(key.size(), key.data(), throw_bool);
+}
+
+datum_t datum_t::get_field(const char *key, throw_bool_t throw_bool) const {
+    return get_field(strlen(key), key, throw_bool);
+}
+
+datum_t datum_t::get_field(size_t key_size,
+                           const char *key_data,
+                           throw_bool_t throw_bool) const {
     // The obj_size() also makes sure that this has the right type (R_OBJECT)
     size_t range_end = obj_size();
-    while (range_beg < range_end) {
-        const size_t center = range_beg + ((range_end - range_beg) / 2);
-        auto center_pair = unchecked_get_pair(center);
-        const int cmp_res = key.compare(center_pair.first);
-        if (cmp_res == 0) {
-            // Found it
-            return center_pair.second;
-        } else if (cmp_res < 0) {
-            range_end = center;
-        } else {
-            range_beg = center + 1;
+    if (data.get_internal_type() == internal_type_t::BUF_R_OBJECT) {
+        datum_t res;
+        if (datum_get_field_from_buf(data.buf_ref, key_size, key_data, &res)) {
+            return res;
+        }
+    } else {
+        // Use binary search on top of unchecked_get_pair()
+        size_t range_beg = 0;
+        while (range_beg < range_end) {
+            const size_t center = range_beg + ((range_end - range_beg) / 2);
+            const std::pair<datum_string_t, datum_t> &center_pair =
+                (*data.r_object)[center];
+            const int cmp_res = center_pair.first.compare(key_size, key_data);
+            if (cmp_res == 0) {
+                // Found it
+                return center_pair.second;
+            } else if (cmp_res > 0) {
+                range_end = center;
+            } else {
+                range_beg = center + 1;
+            }
+            rassert(range_beg <= range_end);
         }
-        rassert(range_beg <= range_end);
     }
 
     // Didn't find it
     if (throw_bool == THROW) {
         rfail(base_exc_t::NON_EXISTENCE,
-              "No attribute `%s` in object:\n%s", key.to_std().c_str(), print().c_str());
+              "No attribute `%s` in object:\n%s",
+              std::string(key_data, key_size).c_str(), print().c_str());
     }
     return datum_t();
 }
 
-datum_t datum_t::get_field(const char *key, throw_bool_t throw_bool) const {
-    return get_field(datum_string_t(key), throw_bool);
-}
-
 template <class json_writer_t>
 void datum_t::write_json_unchecked_stack(json_writer_t *writer) const {
     switch (get_type()) {
@@ -1835,6 +2089,24 @@ int datum_t::cmp_unchecked_stack(const datum_t &rhs) const {
 }
 
 int datum_t::cmp(const datum_t &rhs) const {
+    // Only arrays and objects can be pseudo-types or need a deep stack, so comparing
+    // two numbers or two strings, which is most of what sorting does, takes a
+    // shortcut.
+    const type_t type = get_type();
+    if (type == rhs.get_type()) {
+        switch (type) {
+        case R_NUM: return derived_cmp(as_num(), rhs.as_num());
+        case R_STR: return as_str().compare(rhs.as_str());
+        case R_BOOL: return derived_cmp(as_bool(), rhs.as_bool());
+        case R_OBJECT: {
+            int res;
+            if (pseudo::cmp_if_times(*this, rhs, &res)) {
+                return res;
+            }
+        } break;
+        default: break;
+        }
+    }
     return call_with_enough_stack_datum<int>([&] {
             return this->cmp_unchecked_stack(rhs);
         });
@@ -2043,10 +2315,17 @@ datum_t stats_merge(UNUSED const datum_string_t &key,
     return l;
 }
 
-datum_object_builder_t::datum_object_builder_t(const datum_t &copy_from) {
+// A tree node is the value plus three pointers and a color, and nodes that are too big
+// for the arena would each come from the heap again.
+CT_ASSERT(sizeof(std::pair<const datum_string_t, datum_t>) + 4 * sizeof(void *)
+          <= arena_t::MAX_BLOCK_SIZE);
+
+datum_object_builder_t::datum_object_builder_t(const datum_t &copy_from)
+    : map(map_t::allocator_type(&arena)) {
     const size_t copy_from_sz = copy_from.obj_size();
     for (size_t i = 0; i < copy_from_sz; ++i) {
-        map.insert(copy_from.get_pair(i));
+        // The pairs come in key order, so each one goes at the end of the map.
+        map.insert(map.end(), copy_from.get_pair(i));
     }
 }
 
@@ -2159,24 +2438,52 @@ datum_t datum_object_builder_t::try_get(const datum_string_t &key) const {
     return it == map.end() ? datum_t() : it->second;
 }
 
+std::vector<std::pair<datum_string_t, datum_t> >
+datum_object_builder_t::take_sorted_vec() {
+    std::vector<std::pair<datum_string_t, datum_t> > sorted_vec;
+    sorted_vec.reserve(map.size());
+    for (auto it = map.begin(); it != map.end(); ++it) {
+        sorted_vec.push_back(std::make_pair(std::move(it->first), std::move(it->second)));
+    }
+    map.clear();
+    return sorted_vec;
+}
+
 datum_t datum_object_builder_t::to_datum() RVALUE_THIS {
-    return datum_t(std::move(map));
+    return datum_t(take_sorted_vec());
 }
 
 datum_t datum_object_builder_t::to_datum(
         const std::set<std::string> &permissible_ptypes) RVALUE_THIS {
-    return datum_t(std::move(map), permissible_ptypes);
+    return datum_t(take_sorted_vec(), permissible_ptypes);
 }
 
 datum_array_builder_t::datum_array_builder_t(const datum_t &copy_from,
                                              const configured_limits_t &_limits)
     : limits(_limits) {
+    copy_elements(copy_from);
+    rcheck_array_size_datum(vector, limits);
+}
+
+datum_array_builder_t::datum_array_builder_t(datum_t &&steal_from,
+                                             const configured_limits_t &_limits)
+    : limits(_limits) {
+    if (steal_from.data.get_internal_type() == datum_t::internal_type_t::R_ARRAY
+        && steal_from.data.r_array.unique()) {
+        // `steal_from` is left holding an empty array.
+        vector = std::move(*steal_from.data.r_array);
+    } else {
+        copy_elements(steal_from);
+    }
+    rcheck_array_size_datum(vector, limits);
+}
+
+void datum_array_builder_t::copy_elements(const datum_t &copy_from) {
     const size_t copy_from_sz = copy_from.arr_size();
     vector.reserve(copy_from_sz);
     for (size_t i = 0; i < copy_from_sz; ++i) {
         vector.push_back(copy_from.get(i));
     }
-    rcheck_array_size_datum(vector, limits);
 }
 
 void datum_array_builder_t::reserve(size_t n) { vector.reserve(n); }
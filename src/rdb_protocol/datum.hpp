@@ -13,6 +13,7 @@
 
 #include "cjson/json.hpp"
 #include "containers/archive/archive.hpp"
+#include "containers/arena.hpp"
 #include "containers/counted.hpp"
 #include "containers/optional.hpp"
 #include "rdb_protocol/datum_string.hpp"
@@ -90,8 +91,10 @@ void debug_print(printf_buffer_t *, const datum_t &);
 // updated if more versions are added.
 enum class skey_version_t {
     // We used to distinguish between pre 1.16 and post 1.16 secondary index keys.
-    // At the moment we only have one format.
-    post_1_16 = 1
+    post_1_16 = 1,
+    // Like `post_1_16`, but primary keys that are UUID strings are stored in 17 bytes
+    // instead of 37. Keys of both versions are parsed the same way.
+    post_2_6 = 2
 };
 skey_version_t skey_version_from_reql_version(reql_version_t rv);
 
@@ -257,6 +260,10 @@ public:
         const std::string &secondary_and_primary);
     static optional<uint64_t> extract_tag(const store_key_t &key);
     static components_t extract_all(const std::string &secondary_and_primary);
+    /* The inverse of the value encoding in `print_secondary`, for the secondary part
+    of a key that wasn't truncated and was written with `escape_nulls_t::YES`. Returns
+    an empty datum if it can't tell the value (e.g. for times). */
+    static datum_t decode_secondary(const std::string &secondary);
     store_key_t truncated_secondary(
         reql_version_t reql_version,
         extrema_ok_t extrema_ok = extrema_ok_t::NOT_OK) const;
@@ -372,6 +379,10 @@ private:
     template <class json_writer_t>
     void write_json_unchecked_stack(json_writer_t *writer) const;
 
+    // The two public `get_field()`s forward to this one.
+    datum_t get_field(size_t key_size, const char *key_data,
+                      throw_bool_t throw_bool) const;
+
     // Same as get_pair() / get(), but don't perform boundary or type checks.
     // For internal use to improve performance.
     std::pair<datum_string_t, datum_t> unchecked_get_pair(size_t index) const;
@@ -458,6 +469,7 @@ private:
     } data;
 
     friend void ::ql::debug_print(printf_buffer_t *, const datum_t &);
+    friend class datum_array_builder_t;
 
 public:
     static const datum_string_t reql_type_string;
@@ -469,6 +481,14 @@ datum_t to_datum(
     const configured_limits_t &,
     reql_version_t);
 
+// Parses the null-terminated `json` straight into a datum, without building a
+// `rapidjson::Document` first. `json` is modified in place. On a syntax error this
+// returns an empty datum and fills in `result_out`.
+datum_t parse_json_to_datum(
+    char *json,
+    const configured_limits_t &,
+    rapidjson::ParseResult *result_out);
+
 // DEPRECATED: Used in the r.json term for pre 2.1 backwards compatibility
 datum_t to_datum(cJSON *json, const configured_limits_t &, reql_version_t);
 
@@ -485,7 +505,7 @@ int64_t checked_convert_to_int(const rcheckable_t *target, double d);
 // Useful for building an object datum and doing mutation operations
 class datum_object_builder_t {
 public:
-    datum_object_builder_t() { }
+    datum_object_builder_t() : map(map_t::allocator_type(&arena)) { }
     explicit datum_object_builder_t(const datum_t &copy_from);
 
     bool empty() const {
@@ -518,7 +538,16 @@ public:
             const std::set<std::string> &permissible_ptypes) RVALUE_THIS;
 
 private:
-    std::map<datum_string_t, datum_t> map;
+    typedef std::map<datum_string_t, datum_t, std::less<datum_string_t>,
+                     arena_allocator_t<std::pair<const datum_string_t, datum_t> > >
+        map_t;
+
+    std::vector<std::pair<datum_string_t, datum_t> > take_sorted_vec();
+
+    // The nodes of `map` come from `arena`, so building an object takes a handful of
+    // allocations instead of one per field.
+    arena_t arena;
+    map_t map;
     DISABLE_COPYING(datum_object_builder_t);
 };
 
@@ -530,6 +559,10 @@ public:
         const configured_limits_t &_limits) : limits(_limits) {}
     explicit datum_array_builder_t(
         const datum_t &copy_from, const configured_limits_t &);
+    // Takes the elements over from `steal_from` instead of copying them when nothing
+    // else refers to its array, so that e.g. chained `append`s don't copy the whole
+    // array every time.
+    datum_array_builder_t(datum_t &&steal_from, const configured_limits_t &);
 
     bool empty() const { return vector.empty(); }
     size_t size() const { return vector.size(); }
@@ -553,6 +586,8 @@ public:
     datum_t to_datum() RVALUE_THIS;
 
 private:
+    void copy_elements(const datum_t &copy_from);
+
     std::vector<datum_t> vector;
     configured_limits_t limits;
 
@@ -0,0 +1,123 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_DATUM_HASH_MAP_HPP_
+#define RDB_PROTOCOL_DATUM_HASH_MAP_HPP_
+
+#include <utility>
+#include <vector>
+
+#include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/datum_utils.hpp"
+
+namespace ql {
+
+/* An open-addressing hash table keyed on (possibly empty) datums, for building up
+groups without a `std::map`'s rebalancing and datum comparisons on every insert. The
+entries are kept contiguous in insertion order and the slots only hold their indices,
+so a probe runs over one small array and compares datums only when the full hashes
+match. Iteration is in insertion order, which has nothing to do with the datum order,
+so whatever comes out of here must be sorted before it reaches the user. Like with a
+`std::vector`, inserting invalidates iterators. */
+template <class T>
+class datum_hash_map_t {
+public:
+    typedef std::pair<datum_t, T> value_type;
+    typedef typename std::vector<value_type>::iterator iterator;
+
+    datum_hash_map_t() { }
+
+    iterator begin() { return entries.begin(); }
+    iterator end() { return entries.end(); }
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+
+    void clear() {
+        entries.clear();
+        hashes.clear();
+        slots.clear();
+    }
+
+    // Like `std::map::insert`.
+    std::pair<iterator, bool> insert(value_type &&val) {
+        if ((entries.size() + 1) * 2 > slots.size()) {
+            grow();
+        }
+        size_t hash = optional_datum_hash(val.first);
+        size_t i = find_slot(val.first, hash);
+        if (slots[i] != 0) {
+            return std::make_pair(entries.begin() + (slots[i] - 1), false);
+        }
+        slots[i] = entries.size() + 1;
+        hashes.push_back(hash);
+        entries.push_back(std::move(val));
+        return std::make_pair(entries.end() - 1, true);
+    }
+
+    iterator find(const datum_t &key) {
+        if (entries.empty()) {
+            return entries.end();
+        }
+        size_t i = find_slot(key, optional_datum_hash(key));
+        return slots[i] == 0 ? entries.end() : entries.begin() + (slots[i] - 1);
+    }
+
+    T &operator[](const datum_t &key) {
+        return insert(std::make_pair(key, T())).first->second;
+    }
+
+    // Removes the entry that was inserted last. Nothing probed past its slot, since
+    // every other entry was inserted (or re-inserted by `grow`) before it, so simply
+    // freeing the slot is enough.
+    void pop_back() {
+        guarantee(!entries.empty());
+        size_t mask = slots.size() - 1;
+        size_t i = hashes.back() & mask;
+        while (slots[i] != entries.size()) {
+            i = (i + 1) & mask;
+        }
+        slots[i] = 0;
+        hashes.pop_back();
+        entries.pop_back();
+    }
+
+private:
+    // The slot holding `key`, or the empty slot where it would go.
+    size_t find_slot(const datum_t &key, size_t hash) const {
+        size_t mask = slots.size() - 1;
+        size_t i = hash & mask;
+        optional_datum_equal_t equal;
+        for (; slots[i] != 0; i = (i + 1) & mask) {
+            size_t e = slots[i] - 1;
+            if (hashes[e] == hash && equal(entries[e].first, key)) {
+                break;
+            }
+        }
+        return i;
+    }
+
+    void grow() {
+        std::vector<size_t> new_slots(slots.empty() ? 16 : slots.size() * 2, 0);
+        size_t mask = new_slots.size() - 1;
+        for (size_t e = 0; e < entries.size(); ++e) {
+            size_t i = hashes[e] & mask;
+            while (new_slots[i] != 0) {
+                i = (i + 1) & mask;
+            }
+            new_slots[i] = e + 1;
+        }
+        slots.swap(new_slots);
+        entries.reserve(slots.size() / 2);
+        hashes.reserve(slots.size() / 2);
+    }
+
+    std::vector<value_type> entries;
+    // The hash of each entry's key, so that neither probing nor `grow` has to
+    // rehash a datum
+    std::vector<size_t> hashes;
+    // Indices into `entries` plus one, or zero for an empty slot. Always a power of
+    // two in size and at most half full.
+    std::vector<size_t> slots;
+};
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_DATUM_HASH_MAP_HPP_
@@ -4,9 +4,13 @@
 #include <map>
 
 #include "rdb_protocol/batching.hpp"
+#include "rdb_protocol/client_chunks.hpp"
 #include "rdb_protocol/datum_stream/array.hpp"
+#include "rdb_protocol/datum_stream/chunks.hpp"
 #include "rdb_protocol/datum_stream/eq_join.hpp"
+#include "rdb_protocol/datum_stream/external_sort.hpp"
 #include "rdb_protocol/datum_stream/fold.hpp"
+#include "rdb_protocol/datum_stream/hash_join.hpp"
 #include "rdb_protocol/datum_stream/indexed_sort.hpp"
 #include "rdb_protocol/datum_stream/lazy.hpp"
 #include "rdb_protocol/datum_stream/map.hpp"
@@ -32,6 +36,7 @@
 #include "rdb_protocol/geo/s2/s2polygon.h"
 #include "rdb_protocol/geo/s2/s2polyline.h"
 #include "rdb_protocol/math_utils.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
 #include "rdb_protocol/term.hpp"
 #include "rdb_protocol/val.hpp"
 #include "utils.hpp"
@@ -45,6 +50,7 @@ read_mode_t up_to_date_read_mode(read_mode_t in) {
     case read_mode_t::MAJORITY: return in;
     case read_mode_t::SINGLE:   return in;
     case read_mode_t::OUTDATED: return read_mode_t::SINGLE;
+    case read_mode_t::BOUNDED_STALENESS: return read_mode_t::SINGLE;
     case read_mode_t::DEBUG_DIRECT:
         rfail_datum(base_exc_t::LOGIC,
                     "DEBUG_DIRECT is not a legal read mode for this operation "
@@ -535,7 +541,8 @@ rget_response_reader_t::rget_response_reader_t(
     : table(_table),
       started(false),
       readgen(std::move(_readgen)),
-      items_index(0) { }
+      items_index(0),
+      snapshot_reads(false) { }
 
 void rget_response_reader_t::add_transformation(transform_variant_t &&tv) {
     r_sanity_check(!started);
@@ -609,9 +616,21 @@ std::vector<datum_t> rget_response_reader_t::next_batch(
     case batch_type_t::NORMAL: // fallthru
     case batch_type_t::NORMAL_FIRST: // fallthru
     case batch_type_t::TERMINAL: {
-        res.reserve(items.size() - items_index);
-        for (; items_index < items.size(); ++items_index) {
-            res.push_back(std::move(items[items_index].data));
+        if (snapshot_reads && batchspec.get_batch_type() != batch_type_t::TERMINAL) {
+            // `items` holds everything, so we cut the batch down to size here.
+            batcher_t batcher = batchspec.to_batcher();
+            while (items_index < items.size()) {
+                res.push_back(std::move(items[items_index].data));
+                ++items_index;
+                if (batcher.note_el(res.back())) {
+                    break;
+                }
+            }
+        } else {
+            res.reserve(items.size() - items_index);
+            for (; items_index < items.size(); ++items_index) {
+                res.push_back(std::move(items[items_index].data));
+            }
         }
     } break;
     case batch_type_t::SINDEX_CONSTANT: {
@@ -680,19 +699,46 @@ bool rget_response_reader_t::is_finished() const {
 rget_read_response_t rget_response_reader_t::do_read(env_t *env, const read_t &read) {
     read_response_t res;
     table->read_with_profile(env, read, &res);
-    auto rget_res = boost::get<rget_read_response_t>(&res.response);
+    return take_rget_response(env, &res);
+}
+
+rget_read_response_t rget_response_reader_t::take_rget_response(
+        env_t *env, read_response_t *res) {
+    auto rget_res = boost::get<rget_read_response_t>(&res->response);
     r_sanity_check(rget_res != NULL);
     if (auto e = boost::get<exc_t>(&rget_res->result)) {
         throw *e;
     }
+    if (env->resource_usage() != nullptr) {
+        if (auto stream = boost::get<grouped_t<stream_t> >(&rget_res->result)) {
+            for (const auto &pair : *stream) {
+                for (const auto &substream : pair.second.substreams) {
+                    env->resource_usage()->rows_read += substream.second.stream.size();
+                }
+            }
+        }
+    }
     return std::move(*rget_res);
 }
 
+class rget_reader_t::prefetch_t {
+public:
+    explicit prefetch_t(read_t &&_read) : read(std::move(_read)) { }
+
+    const read_t read;
+    read_response_t response;
+    std::exception_ptr error;
+    // Pulsed when `response` or `error` is set.
+    cond_t done;
+};
+
 rget_reader_t::rget_reader_t(
     const counted_t<real_table_t> &_table,
     scoped_ptr_t<readgen_t> &&_readgen)
     : rget_response_reader_t(_table, std::move(_readgen)) { }
 
+rget_reader_t::~rget_reader_t() { }
+
 void rget_reader_t::accumulate_all(env_t *env, eager_acc_t *acc) {
     r_sanity_check(!started);
     started = true;
@@ -718,9 +764,13 @@ void rget_reader_t::accumulate_all(env_t *env, eager_acc_t *acc) {
 
 std::vector<rget_item_t>
 rget_reader_t::do_range_read(env_t *env, const read_t &read) {
+    return unshard_range_read(read, do_read(env, read));
+}
+
+std::vector<rget_item_t> rget_reader_t::unshard_range_read(
+        const read_t &read, rget_read_response_t &&res) {
     auto *rr = boost::get<rget_read_t>(&read.read);
     r_sanity_check(rr);
-    rget_read_response_t res = do_read(env, read);
 
     r_sanity_check(stamp.has_value() == rr->stamp.has_value());
     validate_and_record_stamps(stamp, res.stamp_response, &shard_stamp_infos);
@@ -728,19 +778,84 @@ rget_reader_t::do_range_read(env_t *env, const read_t &read) {
     return unshard(rr->sorting, std::move(res));
 }
 
-bool rget_reader_t::load_items(env_t *env, const batchspec_t &batchspec) {
+void rget_reader_t::maybe_start_prefetch(env_t *env, const batchspec_t &batchspec) {
+    // `NORMAL_FIRST` batches are left alone, because streams that only ever need
+    // one batch (e.g. because of a `limit`) would waste the prefetched one. Profiled
+    // reads would be missing the prefetch from their profile, and changefeed stamps
+    // must be read in order.
+    if (prefetch.has()
+        || shards_exhausted()
+        || snapshot_reads
+        || stamp.has_value()
+        || batchspec.get_batch_type() != batch_type_t::NORMAL
+        || readgen->sorting(batchspec) == sorting_t::UNORDERED
+        || env->profile() == profile_bool_t::PROFILE) {
+        return;
+    }
+    // The next read only depends on `active_ranges`, which only changes when a
+    // response is unsharded, so it's the read `load_items` would do next.
+    prefetch.init(new prefetch_t(readgen->next_read(
+        active_ranges, reql_version, stamp, transforms, batchspec)));
+
+    prefetch_t *p = prefetch.get();
+    counted_t<real_table_t> t = table;
+    rdb_context_t *ctx = env->get_rdb_ctx();
+    serializable_env_t s_env = env->get_serializable_env();
+    query_priority_t priority = env->query_priority();
+    auto_drainer_t::lock_t lock(&prefetch_drainer);
+    coro_t::spawn_sometime([p, t, ctx, s_env, priority, lock]() {
+        env_t prefetch_env(ctx,
+                           return_empty_normal_batches_t::NO,
+                           lock.get_drain_signal(),
+                           s_env,
+                           nullptr);
+        prefetch_env.set_query_priority(priority);
+        try {
+            t->read_with_profile(&prefetch_env, p->read, &p->response);
+        } catch (const interrupted_exc_t &) {
+            // The reader is going away.
+            return;
+        } catch (...) {
+            // Rethrown when the batch is asked for.
+            p->error = std::current_exception();
+        }
+        p->done.pulse();
+    });
+}
+
+std::vector<rget_item_t> rget_reader_t::wait_for_prefetch(env_t *env) {
+    // If we get interrupted, the prefetch is left for the next call.
+    wait_interruptible(&prefetch->done, env->interruptor);
+    scoped_ptr_t<prefetch_t> p;
+    p.swap(prefetch);
+    if (p->error) {
+        std::rethrow_exception(p->error);
+    }
+    // `read_with_profile` only counts the shards for the query's own env.
+    if (env->resource_usage() != nullptr) {
+        env->resource_usage()->shard_reads += p->response.n_shards;
+    }
+    return unshard_range_read(p->read, take_rget_response(env, &p->response));
+}
+
+bool rget_reader_t::load_items(env_t *env, const batchspec_t &_batchspec) {
     started = true;
+    const batchspec_t batchspec =
+        snapshot_reads ? _batchspec.with_everything() : _batchspec;
     while (items_index >= items.size() && !shards_exhausted()) {
         items_index = 0;
         // `active_range` is guaranteed to be full after the `do_range_read`,
         // because `do_range_read` is responsible for updating the active range.
-        items = do_range_read(
-            env,
-            readgen->next_read(
-                active_ranges, reql_version, stamp, transforms, batchspec));
+        items = prefetch.has()
+            ? wait_for_prefetch(env)
+            : do_range_read(
+                env,
+                readgen->next_read(
+                    active_ranges, reql_version, stamp, transforms, batchspec));
         r_sanity_check(active_ranges);
         readgen->sindex_sort(&items, batchspec);
     }
+    maybe_start_prefetch(env, batchspec);
     return items_index < items.size();
 }
 
@@ -1114,7 +1229,8 @@ sindex_readgen_t::sindex_readgen_t(
     profile_bool_t _profile,
     read_mode_t _read_mode,
     sorting_t _sorting,
-    require_sindexes_t _require_sindex_val)
+    require_sindexes_t _require_sindex_val,
+    std::map<std::string, datum_t> _intersect)
     : rget_readgen_t(
         std::move(s_env),
         std::move(_table_name),
@@ -1124,6 +1240,7 @@ sindex_readgen_t::sindex_readgen_t(
         _sorting,
         _require_sindex_val),
       sindex(_sindex),
+      intersect(std::move(_intersect)),
       sent_first_read(false) { }
 
 scoped_ptr_t<readgen_t> sindex_readgen_t::make(
@@ -1133,7 +1250,8 @@ scoped_ptr_t<readgen_t> sindex_readgen_t::make(
     const std::string &sindex,
     const datumspec_t &datumspec,
     sorting_t sorting,
-    require_sindexes_t require_sindex_val) {
+    require_sindexes_t require_sindex_val,
+    std::map<std::string, datum_t> intersect) {
     return scoped_ptr_t<readgen_t>(
         new sindex_readgen_t(
             env->get_serializable_env(),
@@ -1143,7 +1261,8 @@ scoped_ptr_t<readgen_t> sindex_readgen_t::make(
             env->profile(),
             read_mode,
             sorting,
-            require_sindex_val));
+            require_sindex_val,
+            std::move(intersect)));
 }
 
 void sindex_readgen_t::sindex_sort(
@@ -1196,7 +1315,8 @@ rget_read_t sindex_readgen_t::next_read_impl(
         make_optional(sindex_rangespec_t(sindex,
                                          std::move(region),
                                          std::move(ds),
-                                         require_sindex_val)),
+                                         require_sindex_val,
+                                         intersect)),
         sorting(batchspec));
 }
 
@@ -1210,6 +1330,8 @@ optional<std::string> sindex_readgen_t::sindex_name() const {
 
 changefeed::keyspec_t::range_t sindex_readgen_t::get_range_spec(
         std::vector<transform_variant_t> transforms) const {
+    rcheck_datum(intersect.empty(), base_exc_t::LOGIC,
+                 "Cannot call `changes` on a `get_all` with `intersect`.");
     return changefeed::keyspec_t::range_t{
         std::move(transforms), sindex_name(), sorting_, datumspec, r_nullopt};
 }
@@ -1560,6 +1682,20 @@ bool array_datum_stream_t::is_infinite() const {
     return false;
 }
 
+scoped_ptr_t<val_t> array_datum_stream_t::run_terminal(
+    env_t *env, const terminal_variant_t &tv) {
+    // `sum`, `avg`, `min` and `max` of an array of numbers don't need to batch the
+    // elements up and feed them through an accumulator one by one.
+    if (index == 0 && !ops_to_do() && !is_grouped()) {
+        datum_t res = run_numeric_terminal(tv, arr);
+        if (res.has()) {
+            index = arr.arr_size();
+            return make_scoped<val_t>(res, backtrace());
+        }
+    }
+    return datum_stream_t::run_terminal(env, tv);
+}
+
 std::vector<datum_t>
 array_datum_stream_t::next_raw_batch(env_t *env, const batchspec_t &batchspec) {
     std::vector<datum_t> v;
@@ -1585,10 +1721,7 @@ bool array_datum_stream_t::is_array() const {
 // INDEXED_SORT_DATUM_STREAM_T
 indexed_sort_datum_stream_t::indexed_sort_datum_stream_t(
     counted_t<datum_stream_t> stream,
-    std::function<bool(env_t *,  // NOLINT(readability/casting)
-                       profile::sampler_t *,
-                       const datum_t &,
-                       const datum_t &)> _lt_cmp)
+    const lt_cmp_t &_lt_cmp)
     : wrapper_datum_stream_t(stream), lt_cmp(_lt_cmp), index(0) { }
 
 std::vector<datum_t>
@@ -1611,8 +1744,7 @@ indexed_sort_datum_stream_t::next_raw_batch(env_t *env, const batchspec_t &batch
             if (index >= data.size()) {
                 return ret;
             }
-            std::stable_sort(data.begin(), data.end(),
-                             std::bind(lt_cmp, env, &sampler, ph::_1, ph::_2));
+            lt_cmp.sort(env, &sampler, &data);
         }
         for (; index < data.size() && !batcher.should_send_batch(); ++index) {
             batcher.note_el(data[index]);
@@ -1622,6 +1754,402 @@ indexed_sort_datum_stream_t::next_raw_batch(env_t *env, const batchspec_t &batch
     return ret;
 }
 
+// EXTERNAL_SORT_DATUM_STREAM_T
+external_sort_datum_stream_t::external_sort_datum_stream_t(
+    backtrace_id_t _bt,
+    io_backender_t *_io_backender,
+    const base_path_t &_base_path,
+    const lt_cmp_t &_lt_cmp)
+    : eager_datum_stream_t(_bt),
+      io_backender(_io_backender),
+      base_path(_base_path),
+      lt_cmp(_lt_cmp) { }
+
+void external_sort_datum_stream_t::spill_run(
+        env_t *env, std::vector<datum_t> &&rows) {
+    r_sanity_check(heap.empty());
+    {
+        profile::sampler_t sampler("Sorting a run for an external sort.", env->trace);
+        lt_cmp.sort(env, &sampler, &rows);
+    }
+    scoped_ptr_t<run_t> run(new run_t());
+    run->queue.init(new disk_backed_queue_t<datum_t>(
+        io_backender,
+        serializer_filepath_t(base_path, "sort_" + uuid_to_str(generate_uuid())),
+        &perfmon_collection));
+    run->queue->push(rows);
+    run->index = 0;
+    runs.push_back(std::move(run));
+}
+
+void external_sort_datum_stream_t::finish(
+        env_t *env, std::vector<datum_t> &&rows) {
+    r_sanity_check(heap.empty());
+    profile::sampler_t sampler("Merging the runs of an external sort.", env->trace);
+    lt_cmp.sort(env, &sampler, &rows);
+    scoped_ptr_t<run_t> run(new run_t());
+    run->rows = std::move(rows);
+    run->index = 0;
+    runs.push_back(std::move(run));
+
+    for (size_t i = 0; i < runs.size(); ++i) {
+        advance(env, runs[i].get());
+        if (runs[i]->head.has()) {
+            heap.push_back(i);
+            std::push_heap(heap.begin(), heap.end(),
+                           std::bind(&external_sort_datum_stream_t::run_greater,
+                                     this, &sampler, ph::_1, ph::_2));
+        }
+    }
+}
+
+void external_sort_datum_stream_t::advance(env_t *env, run_t *run) {
+    if (run->queue.has()) {
+        if (run->queue->empty()) {
+            run->head.reset();
+            run->queue.reset();
+        } else {
+            run->queue->pop(&run->head);
+        }
+    } else if (run->index < run->rows.size()) {
+        run->head = std::move(run->rows[run->index++]);
+    } else {
+        run->head.reset();
+    }
+    if (run->head.has()) {
+        run->head_keys = lt_cmp.keys(env, run->head);
+    }
+}
+
+bool external_sort_datum_stream_t::run_greater(
+        profile::sampler_t *sampler, size_t a, size_t b) {
+    // Ties go to the earlier run, which holds the earlier rows of the input.
+    const datum_t *a_keys = runs[a]->head_keys.data();
+    const datum_t *b_keys = runs[b]->head_keys.data();
+    if (lt_cmp.keys_lt(sampler, b_keys, a_keys)) {
+        return true;
+    } else if (lt_cmp.keys_lt(sampler, a_keys, b_keys)) {
+        return false;
+    } else {
+        return a > b;
+    }
+}
+
+std::vector<datum_t>
+external_sort_datum_stream_t::next_raw_batch(env_t *env, const batchspec_t &batchspec) {
+    std::vector<datum_t> ret;
+    batcher_t batcher = batchspec.to_batcher();
+
+    profile::sampler_t sampler("Merging the runs of an external sort.", env->trace);
+    auto greater = std::bind(&external_sort_datum_stream_t::run_greater,
+                             this, &sampler, ph::_1, ph::_2);
+    while (!heap.empty() && !batcher.should_send_batch()) {
+        std::pop_heap(heap.begin(), heap.end(), greater);
+        run_t *run = runs[heap.back()].get();
+        batcher.note_el(run->head);
+        ret.push_back(std::move(run->head));
+        advance(env, run);
+        if (run->head.has()) {
+            std::push_heap(heap.begin(), heap.end(), greater);
+        } else {
+            heap.pop_back();
+        }
+    }
+    return ret;
+}
+
+bool external_sort_datum_stream_t::is_exhausted() const {
+    return heap.empty();
+}
+
+feed_type_t external_sort_datum_stream_t::cfeed_type() const {
+    return feed_type_t::not_feed;
+}
+
+bool external_sort_datum_stream_t::is_array() const {
+    return false;
+}
+
+bool external_sort_datum_stream_t::is_infinite() const {
+    return false;
+}
+
+// HASH_JOIN_DATUM_STREAM_T
+hash_join_datum_stream_t::hash_join_datum_stream_t(
+    counted_t<datum_stream_t> _left,
+    counted_t<datum_stream_t> _right,
+    counted_t<const func_t> _left_key,
+    counted_t<const func_t> _right_key,
+    counted_t<const func_t> _predicate,
+    bool _outer,
+    io_backender_t *_io_backender,
+    const base_path_t &_base_path,
+    backtrace_id_t _bt)
+    : eager_datum_stream_t(_bt),
+      left(std::move(_left)),
+      right(std::move(_right)),
+      left_key(std::move(_left_key)),
+      right_key(std::move(_right_key)),
+      predicate(std::move(_predicate)),
+      outer(_outer),
+      io_backender(_io_backender),
+      base_path(_base_path),
+      built(false),
+      done(false),
+      table_rows(0),
+      table_size(0),
+      left_partitioned(false),
+      partitions_loaded(0) { }
+
+datum_t hash_join_datum_stream_t::join_key(
+        env_t *env, const counted_t<const func_t> &f, const datum_t &row) {
+    datum_t key;
+    try {
+        key = f->call(env, row)->as_datum();
+    } catch (const exc_t &e) {
+        if (e.get_type() == base_exc_t::NON_EXISTENCE) {
+            return datum_t();
+        } else {
+            throw;
+        }
+    }
+    return key.get_type() == datum_t::R_NULL ? datum_t() : key;
+}
+
+void hash_join_datum_stream_t::add_to_table(datum_t &&key, datum_t &&row) {
+    table[key].push_back(std::move(row));
+    ++table_rows;
+}
+
+hash_join_datum_stream_t::partition_t *
+hash_join_datum_stream_t::partition_for(const datum_t &key) {
+    // The table uses the low bits of the hash, so take the partition from the high
+    // bits of a multiplicative hash instead.
+    uint64_t h = optional_datum_hash(key) * 0x9e3779b97f4a7c15ULL;
+    return partitions[(h >> 32) % partitions.size()].get();
+}
+
+void hash_join_datum_stream_t::partition_table() {
+    r_sanity_check(partitions.empty());
+    for (size_t i = 0; i < HASH_JOIN_PARTITIONS; ++i) {
+        scoped_ptr_t<partition_t> p(new partition_t());
+        p->left.init(new disk_backed_queue_t<datum_t>(
+            io_backender,
+            serializer_filepath_t(base_path, "join_" + uuid_to_str(generate_uuid())),
+            &perfmon_collection));
+        p->right.init(new disk_backed_queue_t<datum_t>(
+            io_backender,
+            serializer_filepath_t(base_path, "join_" + uuid_to_str(generate_uuid())),
+            &perfmon_collection));
+        partitions.push_back(std::move(p));
+    }
+    for (auto &&pair : table) {
+        partition_t *p = partition_for(pair.first);
+        for (auto &&row : pair.second) {
+            p->right->push(datum_t(std::vector<datum_t>{pair.first, row},
+                                   configured_limits_t::unlimited));
+        }
+    }
+    table.clear();
+    table_rows = 0;
+    table_size = 0;
+}
+
+void hash_join_datum_stream_t::build(env_t *env) {
+    const bool can_spill = io_backender != nullptr;
+    batchspec_t batchspec = batchspec_t::user(batch_type_t::TERMINAL, env);
+    profile::sampler_t sampler("Building the hash table of a hash join.", env->trace);
+    for (;;) {
+        std::vector<datum_t> batch = right->next_batch(env, batchspec);
+        if (batch.empty()) {
+            break;
+        }
+        for (auto &&row : batch) {
+            datum_t key = join_key(env, right_key, row);
+            if (!key.has()) {
+                // It can never match anything.
+                continue;
+            }
+            if (!partitions.empty()) {
+                datum_t entry(std::vector<datum_t>{key, row},
+                              configured_limits_t::unlimited);
+                partition_for(key)->right->push(entry);
+            } else {
+                if (can_spill) {
+                    table_size +=
+                        serialized_size<cluster_version_t::LATEST_OVERALL>(key)
+                        + serialized_size<cluster_version_t::LATEST_OVERALL>(row);
+                }
+                add_to_table(std::move(key), std::move(row));
+            }
+            sampler.new_sample();
+        }
+        if (partitions.empty()) {
+            if (can_spill
+                && (table_rows > env->limits().array_size_limit()
+                    || table_size > HASH_JOIN_MEMORY_BUDGET)) {
+                partition_table();
+            } else {
+                rcheck(table_rows <= env->limits().array_size_limit(),
+                       base_exc_t::RESOURCE,
+                       format_array_size_error(
+                           env->limits().array_size_limit()).c_str());
+            }
+        }
+    }
+}
+
+void hash_join_datum_stream_t::partition_left(env_t *env) {
+    batchspec_t batchspec = batchspec_t::user(batch_type_t::TERMINAL, env);
+    profile::sampler_t sampler("Partitioning the left side of a hash join.",
+                               env->trace);
+    for (;;) {
+        std::vector<datum_t> batch = left->next_batch(env, batchspec);
+        if (batch.empty()) {
+            break;
+        }
+        for (auto &&row : batch) {
+            datum_t key = join_key(env, left_key, row);
+            if (key.has()) {
+                datum_t entry(std::vector<datum_t>{key, row},
+                              configured_limits_t::unlimited);
+                partition_for(key)->left->push(entry);
+            } else if (outer) {
+                // Any partition will do, as long as it comes out again.
+                datum_t entry(std::vector<datum_t>{row},
+                              configured_limits_t::unlimited);
+                partitions[0]->left->push(entry);
+            }
+            sampler.new_sample();
+        }
+    }
+}
+
+bool hash_join_datum_stream_t::load_next_partition(env_t *env) {
+    table.clear();
+    if (partitions_loaded > 0) {
+        // This removes its files.
+        partitions[partitions_loaded - 1].reset();
+    }
+    if (partitions_loaded == partitions.size()) {
+        return false;
+    }
+    partition_t *p = partitions[partitions_loaded++].get();
+    profile::sampler_t sampler("Loading a partition of a hash join.", env->trace);
+    while (!p->right->empty()) {
+        datum_t entry;
+        p->right->pop(&entry);
+        add_to_table(entry.get(0), entry.get(1));
+        sampler.new_sample();
+    }
+    p->right.reset();
+    return true;
+}
+
+void hash_join_datum_stream_t::probe(env_t *env,
+                                     const datum_t &key,
+                                     const datum_t &row,
+                                     batcher_t *batcher,
+                                     std::vector<datum_t> *out) {
+    datum_string_t left_str("left");
+    datum_string_t right_str("right");
+    bool matched = false;
+    if (key.has()) {
+        auto it = table.find(key);
+        if (it != table.end()) {
+            for (const datum_t &other : it->second) {
+                if (!predicate->call(env, std::vector<datum_t>{row, other})
+                        ->as_datum().as_bool()) {
+                    continue;
+                }
+                matched = true;
+                datum_object_builder_t res_item;
+                bool conflict = true;
+                conflict &= res_item.add(left_str, row);
+                conflict &= res_item.add(right_str, other);
+                guarantee(!conflict);
+                datum_t res_datum = std::move(res_item).to_datum();
+                batcher->note_el(res_datum);
+                out->push_back(std::move(res_datum));
+            }
+        }
+    }
+    if (outer && !matched) {
+        datum_object_builder_t res_item;
+        bool conflict = res_item.add(left_str, row);
+        guarantee(!conflict);
+        datum_t res_datum = std::move(res_item).to_datum();
+        batcher->note_el(res_datum);
+        out->push_back(std::move(res_datum));
+    }
+}
+
+std::vector<datum_t>
+hash_join_datum_stream_t::next_raw_batch(env_t *env, const batchspec_t &batchspec) {
+    if (!built) {
+        build(env);
+        built = true;
+    }
+    std::vector<datum_t> ret;
+    batcher_t batcher = batchspec.to_batcher();
+
+    if (partitions.empty()) {
+        profile::sampler_t sampler("Probing the hash table of a hash join.",
+                                   env->trace);
+        while (!done && !batcher.should_send_batch()) {
+            std::vector<datum_t> batch = left->next_batch(env, batchspec);
+            if (batch.empty()) {
+                done = true;
+                break;
+            }
+            for (const datum_t &row : batch) {
+                probe(env, join_key(env, left_key, row), row, &batcher, &ret);
+                sampler.new_sample();
+            }
+        }
+    } else {
+        if (!left_partitioned) {
+            partition_left(env);
+            left_partitioned = true;
+            done = !load_next_partition(env);
+        }
+        profile::sampler_t sampler("Probing the partitions of a hash join.",
+                                   env->trace);
+        while (!done && !batcher.should_send_batch()) {
+            partition_t *p = partitions[partitions_loaded - 1].get();
+            if (p->left->empty()) {
+                done = !load_next_partition(env);
+                continue;
+            }
+            datum_t entry;
+            p->left->pop(&entry);
+            if (entry.arr_size() == 2) {
+                probe(env, entry.get(0), entry.get(1), &batcher, &ret);
+            } else {
+                probe(env, datum_t(), entry.get(0), &batcher, &ret);
+            }
+            sampler.new_sample();
+        }
+    }
+    return ret;
+}
+
+bool hash_join_datum_stream_t::is_exhausted() const {
+    return done && batch_cache_exhausted();
+}
+
+feed_type_t hash_join_datum_stream_t::cfeed_type() const {
+    return feed_type_t::not_feed;
+}
+
+bool hash_join_datum_stream_t::is_array() const {
+    return false;
+}
+
+bool hash_join_datum_stream_t::is_infinite() const {
+    return false;
+}
+
 // ORDERED_DISTINCT_DATUM_STREAM_T
 ordered_distinct_datum_stream_t::ordered_distinct_datum_stream_t(
     counted_t<datum_stream_t> _source) : wrapper_datum_stream_t(_source) { }
@@ -1728,7 +2256,7 @@ slice_datum_stream_t::next_raw_batch(env_t *env, const batchspec_t &batchspec) {
     while (index < left) {
         sampler.new_sample();
         std::vector<datum_t> v =
-            source->next_batch(env, batchspec.with_at_most(right - index));
+            source->next_batch(env, batchspec.with_limit(right - index));
         if (v.size() == 0) {
             return ret;
         }
@@ -1753,7 +2281,7 @@ slice_datum_stream_t::next_raw_batch(env_t *env, const batchspec_t &batchspec) {
         if (source->cfeed_type() != feed_type_t::not_feed && ret.size() > 0) break;
         sampler.new_sample();
         std::vector<datum_t> v =
-            source->next_batch(env, batchspec.with_at_most(right - index));
+            source->next_batch(env, batchspec.with_limit(right - index));
         if (v.size() == 0) {
             return ret;
         }
@@ -2020,6 +2548,7 @@ union_datum_stream_t::union_datum_stream_t(
         drainer.get_drain_signal(),
         env->get_serializable_env(),
         trace.has() ? trace.get() : nullptr);
+    coro_env->set_resource_usage(env->resource_usage());
 
     coro_streams.reserve(streams.size());
     for (auto &&stream : streams) {
@@ -2220,6 +2749,35 @@ bool range_datum_stream_t::is_exhausted() const {
     return !is_infinite_range && start >= stop && batch_cache_exhausted();
 }
 
+// CHUNKS_DATUM_STREAM_T
+chunks_datum_stream_t::chunks_datum_stream_t(client_chunks_t *_chunks,
+                                             backtrace_id_t _bt)
+    : eager_datum_stream_t(_bt),
+      chunks(_chunks),
+      index(0) { }
+
+std::vector<datum_t>
+chunks_datum_stream_t::next_raw_batch(env_t *env, const batchspec_t &batchspec) {
+    if (index == chunk.size()) {
+        // Only the client knows when the next chunk comes, so there's no timeout.
+        chunk = chunks->pop(env->interruptor);
+        index = 0;
+    }
+    std::vector<datum_t> batch;
+    batcher_t batcher = batchspec.to_batcher();
+    while (index < chunk.size()) {
+        batch.push_back(std::move(chunk[index++]));
+        if (batcher.note_el(batch.back())) {
+            break;
+        }
+    }
+    return batch;
+}
+
+bool chunks_datum_stream_t::is_exhausted() const {
+    return chunks->has_ended() && index == chunk.size() && batch_cache_exhausted();
+}
+
 // MAP_DATUM_STREAM_T
 map_datum_stream_t::map_datum_stream_t(
         std::vector<counted_t<datum_stream_t> > &&_streams,
@@ -2312,59 +2870,126 @@ eq_join_datum_stream_t::eq_join_datum_stream_t(counted_t<datum_stream_t> _stream
     is_infinite_eq_join(stream->is_infinite()),
     eq_join_type(stream->cfeed_type()) { }
 
+void eq_join_datum_stream_t::fill_lookups(
+        env_t *env,
+        const batchspec_t &inner_batchspec,
+        const batchspec_t &batchspec) {
+    while (lookups.size() < MAX_EQ_JOIN_LOOKUPS_IN_FLIGHT && !stream->is_exhausted()) {
+        if (!lookups.empty() && stream->cfeed_type() != feed_type_t::not_feed) {
+            // Waiting for changes could take forever, and we have results to emit.
+            break;
+        }
+        // Get a new batch of keys
+        std::vector<datum_t> stream_batch = stream->next_batch(env, inner_batchspec);
+        if (stream_batch.empty()) {
+            // We got an empty batch from the input stream. It's either exhausted
+            // or a changefeed. In either case we emit what we have.
+            break;
+        }
+        // Basically do a get all on the new keys
+        // but we get the reader directly so we can read the sindex from the lookup.
+        scoped_ptr_t<lookup_t> lookup(new lookup_t());
+        std::map<datum_t, uint64_t> keys;
+        for (size_t i = 0; i < stream_batch.size(); ++i) {
+            datum_t key_val;
+            try {
+                key_val = predicate->call(
+                    env,
+                    std::vector<datum_t>{stream_batch[i]})->as_datum();
+            } catch (const exc_t &e) {
+                if (e.get_type() == base_exc_t::NON_EXISTENCE) {
+                    continue;
+                } else {
+                    throw;
+                }
+            }
+            // Build a multimap from sindex value to datums from left side stream.
+            if (key_val.get_type() != datum_t::type_t::R_NULL) {
+                lookup->sindex_to_datum.insert(std::pair<datum_t, datum_t>{
+                        key_val, stream_batch[i]});
+                keys[key_val] = 1;
+            }
+        }
+        if (keys.empty()) {
+            continue;
+        }
+        lookup->reader = table->get_all_with_sindexes(
+            env,
+            datumspec_t(std::move(keys)),
+            join_index.to_std(),
+            backtrace());
+        auto_drainer_t::lock_t lock(&drainer);
+        lookup_t *l = lookup.get();
+        coro_t::spawn_sometime([this, l, batchspec, lock]() {
+            read_lookup(l, batchspec, lock);
+        });
+        lookups.push_back(std::move(lookup));
+    }
+}
+
+void eq_join_datum_stream_t::read_lookup(
+        lookup_t *lookup,
+        const batchspec_t &batchspec,
+        auto_drainer_t::lock_t lock) {
+    lock.assert_is_holding(&drainer);
+    try {
+        lookup->items = lookup->reader->raw_next_batch(coro_env.get(), batchspec);
+    } catch (const interrupted_exc_t &) {
+        // We're being destroyed, so nobody is waiting for the result.
+    } catch (...) {
+        lookup->exc = std::current_exception();
+    }
+    lookup->done.pulse();
+}
+
 std::vector<datum_t> eq_join_datum_stream_t::next_raw_batch(
     env_t *env,
     const batchspec_t &batchspec) {
+    home_thread_mixin_t::assert_thread();
     batcher_t batcher = batchspec.to_batcher();
 
     batchspec_t inner_batchspec = ordered ?
         batchspec_t::all().with_at_most(1) :
         batchspec;
 
+    if (!coro_env.has()) {
+        if (env->trace != nullptr) {
+            trace = make_scoped<profile::trace_t>();
+            disabler = make_scoped<profile::disabler_t>(trace.get());
+        }
+        coro_env = make_scoped<env_t>(
+            env->get_rdb_ctx(),
+            env->return_empty_normal_batches,
+            drainer.get_drain_signal(),
+            env->get_serializable_env(),
+            trace.has() ? trace.get() : nullptr);
+    }
+
     std::vector<datum_t> res;
     while (!is_exhausted() && !batcher.should_send_batch()) {
-        if (!get_all_reader.has() ||
-            (get_all_reader->is_finished() &&
-             get_all_items.empty())) {
-            // Get a new batch of keys
-            std::vector<datum_t> stream_batch = stream->next_batch(env,
-                                                                   inner_batchspec);
-            if (stream_batch.empty()) {
-                // We got an empty batch from the input stream. It's either exhausted
-                // or a changefeed. In either case we abort and emit our current results.
+        if (get_all_items.empty() &&
+            (!get_all_reader.has() || get_all_reader->is_finished())) {
+            // Move on to the next lookup, starting new ones as needed.
+            fill_lookups(env, inner_batchspec, batchspec);
+            if (lookups.empty()) {
                 break;
             }
-            // Basically do a get all on the new keys
-            // but we get the reader directly so we can read the sindex from the lookup.
-            sindex_to_datum.clear();
-            std::map<datum_t, uint64_t> keys;
-            for (size_t i = 0; i < stream_batch.size(); ++i) {
-                datum_t key_val;
-                try {
-                    key_val = predicate->call(
-                        env,
-                        std::vector<datum_t>{stream_batch[i]})->as_datum();
-                } catch (const exc_t &e) {
-                    if (e.get_type() == base_exc_t::NON_EXISTENCE) {
-                        continue;
-                    } else {
-                        throw;
-                    }
-                }
-                // Build a multimap from sindex value to datums from left side stream.
-                if (key_val.get_type() != datum_t::type_t::R_NULL) {
-                    sindex_to_datum.insert(std::pair<datum_t, datum_t>{
-                            key_val, stream_batch[i]});
-                    keys[key_val] = 1;
-                }
+            scoped_ptr_t<lookup_t> lookup = std::move(lookups.front());
+            lookups.pop_front();
+            wait_interruptible(&lookup->done, env->interruptor);
+            if (lookup->exc) {
+                std::rethrow_exception(lookup->exc);
             }
-            get_all_reader = table->get_all_with_sindexes(
-                env,
-                datumspec_t(std::move(keys)),
-                join_index.to_std(),
-                backtrace());
+            sindex_to_datum = std::move(lookup->sindex_to_datum);
+            get_all_reader = std::move(lookup->reader);
+            get_all_items = std::move(lookup->items);
+            // Keep the pipeline full while we work through this one.
+            fill_lookups(env, inner_batchspec, batchspec);
         }
         if (get_all_items.empty()) {
+            if (get_all_reader->is_finished()) {
+                continue;
+            }
             get_all_items = get_all_reader->raw_next_batch(env, batchspec);
         }
         rget_item_t item;
@@ -2401,6 +3026,7 @@ std::vector<datum_t> eq_join_datum_stream_t::next_raw_batch(
 
 bool eq_join_datum_stream_t::is_exhausted() const {
     if (stream->is_exhausted() &&
+        lookups.empty() &&
         get_all_items.empty() &&
         (!get_all_reader.has() || get_all_reader->is_finished())) {
         return batch_cache_exhausted();
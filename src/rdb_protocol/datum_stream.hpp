@@ -70,10 +70,15 @@ public:
     virtual void add_transformation(transform_variant_t &&tv, backtrace_id_t bt) = 0;
     virtual bool add_stamp(changefeed_stamp_t stamp);
     virtual optional<active_state_t> get_active_state();
+    /* Makes a table read get all of its rows with one read per shard, so that the
+    rows from each shard come from a single snapshot of it, however many batches the
+    stream is consumed in. The cost is that the rows are held in memory until they
+    have been consumed. Streams that don't read a table ignore this. */
+    virtual void use_snapshot_reads() { }
     void add_grouping(transform_variant_t &&tv,
                       backtrace_id_t bt);
 
-    scoped_ptr_t<val_t> run_terminal(env_t *env, const terminal_variant_t &tv);
+    virtual scoped_ptr_t<val_t> run_terminal(env_t *env, const terminal_variant_t &tv);
     scoped_ptr_t<val_t> to_array(env_t *env);
 
     // stream -> stream (always eager)
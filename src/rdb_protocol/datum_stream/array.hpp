@@ -12,6 +12,7 @@ public:
     virtual bool is_exhausted() const;
     virtual feed_type_t cfeed_type() const;
     virtual bool is_infinite() const;
+    virtual scoped_ptr_t<val_t> run_terminal(env_t *env, const terminal_variant_t &tv);
 
 private:
     virtual bool is_array() const;
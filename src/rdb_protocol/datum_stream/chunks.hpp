@@ -0,0 +1,42 @@
+#ifndef RDB_PROTOCOL_DATUM_STREAM_CHUNKS_HPP_
+#define RDB_PROTOCOL_DATUM_STREAM_CHUNKS_HPP_
+
+#include <vector>
+
+#include "rdb_protocol/datum_stream.hpp"
+
+namespace ql {
+
+class client_chunks_t;
+
+/* The stream of `r.chunks()`, which reads the documents the client sends with `CHUNK`
+queries. Batches are cut from the chunks as the batchspec says, so how the client
+splits its documents doesn't matter to whatever reads the stream. */
+class chunks_datum_stream_t : public eager_datum_stream_t {
+public:
+    chunks_datum_stream_t(client_chunks_t *_chunks, backtrace_id_t bt);
+
+    virtual std::vector<datum_t>
+    next_raw_batch(env_t *env, const batchspec_t &batchspec);
+
+    virtual bool is_array() const {
+        return false;
+    }
+    virtual bool is_exhausted() const;
+    virtual feed_type_t cfeed_type() const {
+        return feed_type_t::not_feed;
+    }
+    virtual bool is_infinite() const {
+        return false;
+    }
+
+private:
+    // Owned by the query's entry in the `query_cache_t`, which outlives the stream
+    client_chunks_t *const chunks;
+    std::vector<datum_t> chunk;
+    size_t index;
+};
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_DATUM_STREAM_CHUNKS_HPP_
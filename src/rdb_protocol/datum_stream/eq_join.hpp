@@ -1,11 +1,26 @@
 #ifndef RDB_PROTOCOL_DATUM_STREAM_EQ_JOIN_HPP_
 #define RDB_PROTOCOL_DATUM_STREAM_EQ_JOIN_HPP_
 
+#include <deque>
+#include <exception>
+#include <map>
+#include <vector>
+
+#include "concurrency/auto_drainer.hpp"
+#include "concurrency/cond_var.hpp"
 #include "rdb_protocol/datum_stream.hpp"
 
 namespace ql {
 
-class eq_join_datum_stream_t : public eager_datum_stream_t {
+const size_t MAX_EQ_JOIN_LOOKUPS_IN_FLIGHT = 4;
+
+/* Each batch of the left-hand stream becomes one `get_all` on the right-hand table,
+which the cluster splits into one multi-key read per shard. To hide the round trips,
+the lookups for up to `MAX_EQ_JOIN_LOOKUPS_IN_FLIGHT` batches run in the background
+while we're still emitting the results of earlier ones. They're consumed in the order
+of the left-hand stream, so `ordered` joins stay ordered. */
+class eq_join_datum_stream_t : public eager_datum_stream_t,
+                               public home_thread_mixin_t {
 public:
     eq_join_datum_stream_t(counted_t<datum_stream_t> _stream,
                            counted_t<table_t> _table,
@@ -30,6 +45,26 @@ public:
     }
 
 private:
+    // A lookup for one batch of the left-hand stream whose first batch of results
+    // is being read in the background.
+    struct lookup_t {
+        std::multimap<datum_t, datum_t> sindex_to_datum;
+        scoped_ptr_t<reader_t> reader;
+        std::vector<rget_item_t> items;
+        std::exception_ptr exc;
+        // Pulsed once `items` or `exc` is set
+        cond_t done;
+    };
+
+    // Reads batches of the left-hand stream and starts their lookups until the
+    // pipeline is full. Won't block on a changefeed while there are lookups left.
+    void fill_lookups(env_t *env,
+                      const batchspec_t &inner_batchspec,
+                      const batchspec_t &batchspec);
+    void read_lookup(lookup_t *lookup,
+                     const batchspec_t &batchspec,
+                     auto_drainer_t::lock_t lock);
+
     counted_t<datum_stream_t> stream;
     scoped_ptr_t<reader_t> get_all_reader;
     std::vector<rget_item_t> get_all_items;
@@ -47,6 +82,17 @@ private:
     bool is_array_eq_join;
     bool is_infinite_eq_join;
     feed_type_t eq_join_type;
+
+    std::deque<scoped_ptr_t<lookup_t> > lookups;
+
+    // Set the first time `next_raw_batch` is called, for the background reads
+    scoped_ptr_t<profile::trace_t> trace;
+    scoped_ptr_t<profile::disabler_t> disabler;
+    scoped_ptr_t<env_t> coro_env;
+
+    // Must be last, so that the background reads stop before anything they use is
+    // destroyed.
+    auto_drainer_t drainer;
 };
 
 
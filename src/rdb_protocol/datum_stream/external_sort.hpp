@@ -0,0 +1,75 @@
+#ifndef RDB_PROTOCOL_DATUM_STREAM_EXTERNAL_SORT_HPP_
+#define RDB_PROTOCOL_DATUM_STREAM_EXTERNAL_SORT_HPP_
+
+#include <vector>
+
+#include "containers/disk_backed_queue.hpp"
+#include "paths.hpp"
+#include "perfmon/core.hpp"
+#include "rdb_protocol/datum_stream.hpp"
+#include "rdb_protocol/order_util.hpp"
+
+class io_backender_t;
+
+namespace ql {
+
+// How much an unindexed `order_by` keeps in memory before it spills a sorted run of
+// its input to disk.
+const size_t EXTERNAL_SORT_MEMORY_BUDGET = 64 * MEGABYTE;
+
+/* The result of an unindexed `order_by` that doesn't fit into memory. The input is
+sorted in runs, and every run but the last is written to a temporary file. Reading the
+stream merges the runs. Equal rows keep their input order, just like with the
+in-memory `std::stable_sort`. */
+class external_sort_datum_stream_t : public eager_datum_stream_t {
+public:
+    external_sort_datum_stream_t(
+        backtrace_id_t bt,
+        io_backender_t *io_backender,
+        const base_path_t &base_path,
+        const lt_cmp_t &lt_cmp);
+
+    // Sorts `rows` and writes them to a new temporary file.
+    void spill_run(env_t *env, std::vector<datum_t> &&rows);
+
+    // Sorts the last run, which stays in memory, and gets ready for merging. Must be
+    // called exactly once, after all the calls to `spill_run`.
+    void finish(env_t *env, std::vector<datum_t> &&rows);
+
+private:
+    struct run_t {
+        // `nullptr` for the in-memory run
+        scoped_ptr_t<disk_backed_queue_t<datum_t> > queue;
+        std::vector<datum_t> rows;
+        size_t index;
+        // The smallest row of the run not returned yet, empty once the run is done
+        datum_t head;
+        // `lt_cmp.keys(head)`, so that merging doesn't call the comparison functions
+        // over and over for the same rows
+        std::vector<datum_t> head_keys;
+    };
+
+    void advance(env_t *env, run_t *run);
+    bool run_greater(profile::sampler_t *sampler, size_t a, size_t b);
+
+    virtual std::vector<datum_t>
+    next_raw_batch(env_t *env, const batchspec_t &batchspec);
+
+    virtual bool is_exhausted() const;
+    virtual feed_type_t cfeed_type() const;
+    virtual bool is_array() const;
+    virtual bool is_infinite() const;
+
+    io_backender_t *io_backender;
+    const base_path_t base_path;
+    const lt_cmp_t lt_cmp;
+
+    perfmon_collection_t perfmon_collection;
+    std::vector<scoped_ptr_t<run_t> > runs;
+    // A min-heap of the indices of the runs that still have rows
+    std::vector<size_t> heap;
+};
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_DATUM_STREAM_EXTERNAL_SORT_HPP_
@@ -0,0 +1,98 @@
+#ifndef RDB_PROTOCOL_DATUM_STREAM_HASH_JOIN_HPP_
+#define RDB_PROTOCOL_DATUM_STREAM_HASH_JOIN_HPP_
+
+#include <vector>
+
+#include "containers/disk_backed_queue.hpp"
+#include "paths.hpp"
+#include "perfmon/core.hpp"
+#include "rdb_protocol/datum_hash_map.hpp"
+#include "rdb_protocol/datum_stream.hpp"
+
+class io_backender_t;
+
+namespace ql {
+
+// How much of the right-hand side a hash join keeps in memory before it partitions
+// both sides to disk.
+const size_t HASH_JOIN_MEMORY_BUDGET = 64 * MEGABYTE;
+const size_t HASH_JOIN_PARTITIONS = 16;
+
+/* `inner_join` and `outer_join` with `left_key` and `right_key`. The right-hand side
+is read into a hash table on its key, then every row of the left-hand side looks up
+its key there and is matched against the rows it finds with the join predicate. Rows
+without a key (or with a `null` one) never match, like with `eq_join`.
+
+If the right-hand side outgrows `HASH_JOIN_MEMORY_BUDGET` and we have somewhere to put
+temporary files, both sides are split by key hash into `HASH_JOIN_PARTITIONS`
+partitions on disk and joined one partition at a time. The results then come out
+grouped by partition instead of in the order of the left-hand side. */
+class hash_join_datum_stream_t : public eager_datum_stream_t {
+public:
+    hash_join_datum_stream_t(counted_t<datum_stream_t> left,
+                             counted_t<datum_stream_t> right,
+                             counted_t<const func_t> left_key,
+                             counted_t<const func_t> right_key,
+                             counted_t<const func_t> predicate,
+                             bool outer,
+                             io_backender_t *io_backender,
+                             const base_path_t &base_path,
+                             backtrace_id_t bt);
+
+private:
+    struct partition_t {
+        // Entries are `[key, row]`, or `[row]` for left-hand rows without a key.
+        scoped_ptr_t<disk_backed_queue_t<datum_t> > left;
+        scoped_ptr_t<disk_backed_queue_t<datum_t> > right;
+    };
+
+    virtual std::vector<datum_t>
+    next_raw_batch(env_t *env, const batchspec_t &batchspec);
+
+    virtual bool is_exhausted() const;
+    virtual feed_type_t cfeed_type() const;
+    virtual bool is_array() const;
+    virtual bool is_infinite() const;
+
+    // Returns an empty datum if `row` has no key.
+    datum_t join_key(env_t *env, const counted_t<const func_t> &f, const datum_t &row);
+
+    void build(env_t *env);
+    void add_to_table(datum_t &&key, datum_t &&row);
+    void partition_table();
+    partition_t *partition_for(const datum_t &key);
+    void partition_left(env_t *env);
+    // Drops the partition we were probing and loads the right-hand side of the next
+    // one into `table`. Returns false if there are no partitions left.
+    bool load_next_partition(env_t *env);
+
+    void probe(env_t *env,
+               const datum_t &key,
+               const datum_t &row,
+               batcher_t *batcher,
+               std::vector<datum_t> *out);
+
+    counted_t<datum_stream_t> left, right;
+    counted_t<const func_t> left_key, right_key, predicate;
+    const bool outer;
+    io_backender_t *io_backender;
+    const base_path_t base_path;
+
+    bool built;
+    bool done;
+    datum_hash_map_t<std::vector<datum_t> > table;
+    // The number of right-hand rows in `table`, and their serialized size
+    size_t table_rows;
+    size_t table_size;
+
+    perfmon_collection_t perfmon_collection;
+    std::vector<scoped_ptr_t<partition_t> > partitions;
+    bool left_partitioned;
+    // How many partitions we've started probing; the left-hand rows of the last one
+    // are what we're probing with.
+    size_t partitions_loaded;
+};
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_DATUM_STREAM_HASH_JOIN_HPP_
@@ -27,6 +27,9 @@ public:
     virtual optional<active_state_t> get_active_state() {
         return reader->get_active_state();
     }
+    virtual void use_snapshot_reads() {
+        reader->use_snapshot_reads();
+    }
 
 private:
     virtual std::vector<changespec_t> get_changespecs() {
@@ -22,6 +22,8 @@ public:
     virtual std::vector<rget_item_t> raw_next_batch(
         env_t *, const batchspec_t &) { unreachable(); }
     virtual bool is_finished() const = 0;
+    // See `datum_stream_t::use_snapshot_reads()`.
+    virtual void use_snapshot_reads() { }
 
     virtual changefeed::keyspec_t get_changespec() const = 0;
 };
@@ -125,6 +127,7 @@ public:
     virtual std::vector<rget_item_t> raw_next_batch(env_t *env,
                                                     const batchspec_t &batchspec);
     virtual bool is_finished() const;
+    virtual void use_snapshot_reads() { snapshot_reads = true; }
 
     virtual changefeed::keyspec_t get_changespec() const {
         return changefeed::keyspec_t(
@@ -147,6 +150,8 @@ protected:
     // Overwrite this in an implementation
     virtual bool load_items(env_t *env, const batchspec_t &batchspec) = 0;
     rget_read_response_t do_read(env_t *env, const read_t &read);
+    // The part of `do_read` after the read came back.
+    rget_read_response_t take_rget_response(env_t *env, read_response_t *res);
 
     counted_t<real_table_t> table;
     std::vector<transform_variant_t> transforms;
@@ -161,6 +166,10 @@ protected:
     // We need this to handle the SINDEX_CONSTANT case.
     std::vector<rget_item_t> items;
     size_t items_index;
+
+    // If set, `load_items` reads everything that's left in one read, and
+    // `next_batch` hands it out in batches of the requested size.
+    bool snapshot_reads;
 };
 
 class rget_reader_t : public rget_response_reader_t {
@@ -168,6 +177,7 @@ public:
     rget_reader_t(
         const counted_t<real_table_t> &_table,
         scoped_ptr_t<readgen_t> &&readgen);
+    ~rget_reader_t();
     virtual void accumulate_all(env_t *env, eager_acc_t *acc);
 
 protected:
@@ -177,6 +187,21 @@ protected:
 
 private:
     std::vector<rget_item_t> do_range_read(env_t *env, const read_t &read);
+    std::vector<rget_item_t> unshard_range_read(
+        const read_t &read, rget_read_response_t &&res);
+
+    // Starts reading the next batch in the background, if it's worth it.
+    void maybe_start_prefetch(env_t *env, const batchspec_t &batchspec);
+    std::vector<rget_item_t> wait_for_prefetch(env_t *env);
+
+    /* An ordered range read has to wait for every shard before it can merge their
+    batches, so once a stream has asked for a second batch we start reading the next
+    one right away. The shards then work on it while the current batch is merged,
+    evaluated and sent. There's at most one of these in flight per reader. */
+    class prefetch_t;
+    scoped_ptr_t<prefetch_t> prefetch;
+    // Declared last, so that it stops the prefetch before the rest goes away.
+    auto_drainer_t prefetch_drainer;
 };
 
 // intersecting_reader_t performs filtering for duplicate documents in the stream,
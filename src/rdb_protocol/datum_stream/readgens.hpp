@@ -134,7 +134,8 @@ public:
         const std::string &sindex,
         const datumspec_t &datumspec = datumspec_t(datum_range_t::universe()),
         sorting_t sorting = sorting_t::UNORDERED,
-        require_sindexes_t require_sindex_val = require_sindexes_t::NO);
+        require_sindexes_t require_sindex_val = require_sindexes_t::NO,
+        std::map<std::string, datum_t> intersect = std::map<std::string, datum_t>());
 
     virtual void sindex_sort(std::vector<rget_item_t> *vec,
                              const batchspec_t &batchspec) const;
@@ -150,7 +151,8 @@ private:
         profile_bool_t profile,
         read_mode_t read_mode,
         sorting_t sorting,
-        require_sindexes_t require_sindex_val);
+        require_sindexes_t require_sindex_val,
+        std::map<std::string, datum_t> intersect);
     virtual rget_read_t next_read_impl(
         const optional<active_ranges_t> &active_ranges,
         const optional<reql_version_t> &reql_version,
@@ -162,6 +164,8 @@ private:
         std::vector<transform_variant_t> transforms) const;
 
     const std::string sindex;
+    // See `sindex_rangespec_t::intersect`.
+    const std::map<std::string, datum_t> intersect;
     bool sent_first_read;
 };
 
@@ -7,6 +7,8 @@
 
 #include <algorithm>
 #include <limits>
+#include <new>
+#include <utility>
 
 #include "containers/archive/archive.hpp"
 #include "containers/archive/buffer_stream.hpp"
@@ -15,6 +17,12 @@
 #include "debug.hpp"
 #include "utils.hpp"
 
+static_assert(alignof(shared_buf_t) >= 2,
+              "datum_string_t uses the low bit of shared_buf_t pointers as a tag");
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "datum_string_t expects the low byte of a pointer to come first"
+#endif
+
 datum_string_t::datum_string_t() {
     init(0, "");
 }
@@ -24,10 +32,14 @@ datum_string_t::datum_string_t(size_t _size, const char *_data) {
 }
 
 datum_string_t::datum_string_t(const shared_buf_ref_t<char> &_ref)
-    : data_(_ref) { }
+    : data_(_ref) {
+    rassert(!is_inline());
+}
 
 datum_string_t::datum_string_t(shared_buf_ref_t<char> &&_ref)
-    : data_(std::move(_ref)) { }
+    : data_(std::move(_ref)) {
+    rassert(!is_inline());
+}
 
 datum_string_t::datum_string_t(const char *c_str) {
     init(strlen(c_str), c_str);
@@ -37,15 +49,77 @@ datum_string_t::datum_string_t(const std::string &str) {
     init(str.size(), str.data());
 }
 
+datum_string_t::datum_string_t(const datum_string_t &copyee) {
+    if (copyee.is_inline()) {
+        inline_ = copyee.inline_;
+    } else {
+        new (&data_) shared_buf_ref_t<char>(copyee.data_);
+    }
+}
+
+datum_string_t::datum_string_t(datum_string_t &&movee) noexcept {
+    assign_move(&movee);
+}
+
+datum_string_t::~datum_string_t() {
+    destruct();
+}
+
+datum_string_t &datum_string_t::operator=(const datum_string_t &copyee) {
+    datum_string_t tmp(copyee);
+    return *this = std::move(tmp);
+}
+
+datum_string_t &datum_string_t::operator=(datum_string_t &&movee) noexcept {
+    if (this != &movee) {
+        destruct();
+        assign_move(&movee);
+    }
+    return *this;
+}
+
 void datum_string_t::init(size_t _size, const char *_data) {
+    static_assert(sizeof(inline_string_t) == sizeof(shared_buf_ref_t<char>),
+                  "inline_string_t should use exactly the space of a shared_buf_ref_t");
+    if (_size <= MAX_INLINE_SIZE) {
+        inline_.tag = static_cast<uint8_t>((_size << 1) | 1);
+        memcpy(inline_.data, _data, _size);
+        return;
+    }
     const size_t str_offset = varint_uint64_serialized_size(_size);
     counted_t<shared_buf_t> buffer = shared_buf_t::create(str_offset + _size);
     serialize_varint_uint64_into_buf(_size, reinterpret_cast<uint8_t *>(buffer->data()));
     memcpy(buffer->data() + str_offset, _data, _size);
-    data_ = shared_buf_ref_t<char>(std::move(buffer), 0);
+    new (&data_) shared_buf_ref_t<char>(std::move(buffer), 0);
+    rassert(!is_inline());
+}
+
+bool datum_string_t::is_inline() const {
+    return (inline_.tag & 1) != 0;
+}
+
+// `movee` stays valid: an inline string is simply copied, and if `movee` had a buffer
+// it is left as an empty string.
+void datum_string_t::assign_move(datum_string_t *movee) noexcept {
+    if (movee->is_inline()) {
+        inline_ = movee->inline_;
+    } else {
+        new (&data_) shared_buf_ref_t<char>(std::move(movee->data_));
+        movee->destruct();
+        movee->inline_.tag = 1;
+    }
+}
+
+void datum_string_t::destruct() {
+    if (!is_inline()) {
+        data_.~shared_buf_ref_t<char>();
+    }
 }
 
 const char *datum_string_t::data() const {
+    if (is_inline()) {
+        return inline_.data;
+    }
     const size_t str_size = size();
     size_t data_offset = varint_uint64_serialized_size(str_size);
     data_.guarantee_in_boundary(data_offset + str_size);
@@ -53,6 +127,9 @@ const char *datum_string_t::data() const {
 }
 
 size_t datum_string_t::size() const {
+    if (is_inline()) {
+        return inline_.tag >> 1;
+    }
     uint64_t res = 0;
     static_assert(sizeof(uint8_t) == sizeof(char), "sizeof(uint8_t) != sizeof(char)");
     buffer_read_stream_t data_stream(data_.get(), data_.get_safety_boundary());
@@ -126,16 +203,21 @@ std::string datum_string_t::to_std() const {
 datum_string_t concat(const datum_string_t &a, const datum_string_t &b) {
     const size_t a_size = a.size();
     const size_t b_size = b.size();
+    if (a_size + b_size <= datum_string_t::MAX_INLINE_SIZE) {
+        char data[datum_string_t::MAX_INLINE_SIZE];
+        memcpy(data, a.data(), a_size);
+        memcpy(data + a_size, b.data(), b_size);
+        return datum_string_t(a_size + b_size, data);
+    }
     const size_t str_offset = varint_uint64_serialized_size(a_size + b_size);
     counted_t<shared_buf_t> buf = shared_buf_t::create(str_offset + a_size + b_size);
     serialize_varint_uint64_into_buf(a_size + b_size,
                                      reinterpret_cast<uint8_t *>(buf->data(0)));
-    memcpy(buf->data(str_offset), a.data(), a.size());
-    memcpy(buf->data(str_offset + a.size()), b.data(), b.size());
+    memcpy(buf->data(str_offset), a.data(), a_size);
+    memcpy(buf->data(str_offset + a_size), b.data(), b_size);
     return datum_string_t(shared_buf_ref_t<char>(std::move(buf), 0));
 }
 
-
 void debug_print(printf_buffer_t *buf, const datum_string_t &s) {
     debug_print_quoted_string(buf, reinterpret_cast<const uint8_t *>(s.data()),
                               s.size());
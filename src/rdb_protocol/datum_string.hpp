@@ -2,6 +2,8 @@
 #ifndef RDB_PROTOCOL_DATUM_STRING_HPP_
 #define RDB_PROTOCOL_DATUM_STRING_HPP_
 
+#include <stdint.h>
+
 #include <string>
 
 #include "containers/archive/archive.hpp"
@@ -12,11 +14,16 @@
  * - it can be efficiently serialized and deserialized
  * - it can contain any character, including '\0'
  *
- * Underneath `datum_string_t` uses a `shared_buf_ref_t`. This makes it
- * relatively cheap to copy.
+ * Strings of up to `MAX_INLINE_SIZE` bytes, which covers most field names, are
+ * stored inside the object itself, so creating them doesn't allocate. Longer strings
+ * use a `shared_buf_ref_t`, which makes them relatively cheap to copy. Note that
+ * `data()` points into the object for short strings, so it must not be used after
+ * the `datum_string_t` is gone, even if a copy of it is still around.
  */
 class datum_string_t {
 public:
+    static const size_t MAX_INLINE_SIZE = 15;
+
     // Creates an empty datum_string_t
     datum_string_t();
 
@@ -35,6 +42,13 @@ public:
     explicit datum_string_t(const shared_buf_ref_t<char> &_ref);
     explicit datum_string_t(shared_buf_ref_t<char> &&_ref);
 
+    datum_string_t(const datum_string_t &copyee);
+    datum_string_t(datum_string_t &&movee) noexcept;
+    ~datum_string_t();
+
+    datum_string_t &operator=(const datum_string_t &copyee);
+    datum_string_t &operator=(datum_string_t &&movee) noexcept;
+
     // The result of data() is not automatically null terminated. Do not use
     // as a C string.
     const char *data() const;
@@ -42,6 +56,7 @@ public:
     bool empty() const;
 
     int compare(const datum_string_t &other) const;
+    int compare(size_t other_size, const char *other_data) const;
 
     // Short cut for comparing to C-strings and STD strings
     bool operator==(const char *other) const;
@@ -57,11 +72,24 @@ public:
 
 private:
     void init(size_t _size, const char *_data);
-    int compare(size_t other_size, const char *other_data) const;
 
-    // Contains the length of the string in varint encoding, followed by the actual
-    // string content.
-    shared_buf_ref_t<char> data_;
+    bool is_inline() const;
+    void assign_move(datum_string_t *movee) noexcept;
+    void destruct();
+
+    struct inline_string_t {
+        // `(size << 1) | 1`. This overlaps the low byte of the buffer pointer in
+        // `data_`, which is always even, so the low bit tells which one is in use.
+        uint8_t tag;
+        char data[MAX_INLINE_SIZE];
+    };
+
+    union {
+        // Contains the length of the string in varint encoding, followed by the
+        // actual string content.
+        shared_buf_ref_t<char> data_;
+        inline_string_t inline_;
+    };
 };
 
 datum_string_t concat(const datum_string_t &a, const datum_string_t &b);
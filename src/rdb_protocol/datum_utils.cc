@@ -0,0 +1,98 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/datum_utils.hpp"
+
+#include "arch/runtime/coroutines.hpp"
+#include "rdb_protocol/pseudo_geometry.hpp"
+#include "rdb_protocol/pseudo_time.hpp"
+
+namespace {
+
+const size_t MIN_HASH_STACK_SPACE = 16 * KILOBYTE;
+
+size_t hash_combine(size_t seed, size_t h) {
+    return seed ^ (h + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+// FNV-1a
+size_t hash_bytes(const char *data, size_t size) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < size; ++i) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+size_t hash_string(const datum_string_t &s) {
+    return hash_bytes(s.data(), s.size());
+}
+
+size_t hash_num(double d) {
+    // `-0.0 == 0.0`, so they have to hash the same.
+    if (d == 0) {
+        d = 0;
+    }
+    return hash_bytes(reinterpret_cast<const char *>(&d), sizeof(d));
+}
+
+size_t datum_hash(const ql::datum_t &d);
+
+size_t datum_hash_unchecked_stack(const ql::datum_t &d) {
+    // This mirrors `datum_t::cmp_unchecked_stack`: pseudotypes other than geometry
+    // compare by their value rather than by their object representation.
+    if (d.is_ptype() && !d.is_ptype(ql::pseudo::geometry_string)) {
+        if (d.get_type() == ql::datum_t::R_BINARY) {
+            return hash_combine(ql::datum_t::R_BINARY, hash_string(d.as_binary()));
+        } else if (d.get_reql_type() == ql::pseudo::time_string) {
+            return hash_combine(
+                ql::datum_t::R_OBJECT, hash_num(ql::pseudo::time_to_epoch_time(d)));
+        }
+    }
+
+    size_t h = d.get_type();
+    switch (d.get_type()) {
+    case ql::datum_t::R_NULL: // fallthru
+    case ql::datum_t::MINVAL: // fallthru
+    case ql::datum_t::MAXVAL:
+        return h;
+    case ql::datum_t::R_BOOL:
+        return hash_combine(h, d.as_bool());
+    case ql::datum_t::R_NUM:
+        return hash_combine(h, hash_num(d.as_num()));
+    case ql::datum_t::R_STR:
+        return hash_combine(h, hash_string(d.as_str()));
+    case ql::datum_t::R_BINARY:
+        return hash_combine(h, hash_string(d.as_binary()));
+    case ql::datum_t::R_ARRAY:
+        for (size_t i = 0; i < d.arr_size(); ++i) {
+            h = hash_combine(h, datum_hash(d.get(i)));
+        }
+        return h;
+    case ql::datum_t::R_OBJECT:
+        for (size_t i = 0; i < d.obj_size(); ++i) {
+            auto pair = d.get_pair(i);
+            h = hash_combine(h, hash_string(pair.first));
+            h = hash_combine(h, datum_hash(pair.second));
+        }
+        return h;
+    case ql::datum_t::UNINITIALIZED: // fallthru
+    default:
+        unreachable();
+    }
+}
+
+size_t datum_hash(const ql::datum_t &d) {
+    if (d.get_type() == ql::datum_t::R_ARRAY || d.get_type() == ql::datum_t::R_OBJECT) {
+        return call_with_enough_stack<size_t>([&]() {
+                return datum_hash_unchecked_stack(d);
+            }, MIN_HASH_STACK_SPACE);
+    } else {
+        return datum_hash_unchecked_stack(d);
+    }
+}
+
+}  // namespace
+
+size_t optional_datum_hash(const ql::datum_t &d) {
+    return d.has() ? datum_hash(d) : 0;
+}
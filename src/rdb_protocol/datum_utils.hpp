@@ -17,4 +17,29 @@ public:
     }
 };
 
+// A hash that agrees with `datum_t::operator==`, so equal datums hash the same even
+// if they are represented differently (e.g. `0` and `-0`, or the same time in two
+// different timezones). Empty datums are allowed.
+size_t optional_datum_hash(const ql::datum_t &d);
+
+class optional_datum_hash_t {
+public:
+    optional_datum_hash_t() { }
+    size_t operator()(const ql::datum_t &d) const {
+        return optional_datum_hash(d);
+    }
+};
+
+class optional_datum_equal_t {
+public:
+    optional_datum_equal_t() { }
+    bool operator()(const ql::datum_t &a, const ql::datum_t &b) const {
+        if (a.has()) {
+            return b.has() && a == b;
+        } else {
+            return !b.has();
+        }
+    }
+};
+
 #endif /* RDB_PROTOCOL_DATUM_UTILS_HPP_ */
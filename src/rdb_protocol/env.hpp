@@ -11,7 +11,6 @@
 #include "clustering/administration/auth/user_context.hpp"
 #include "concurrency/one_per_thread.hpp"
 #include "containers/counted.hpp"
-#include "containers/lru_cache.hpp"
 #include "extproc/js_runner.hpp"
 #include "rdb_protocol/configured_limits.hpp"
 #include "rdb_protocol/context.hpp"
@@ -19,27 +18,20 @@
 #include "rdb_protocol/error.hpp"
 #include "rdb_protocol/optargs.hpp"
 #include "rdb_protocol/protocol.hpp"
+#include "rdb_protocol/resource_usage.hpp"
 #include "rdb_protocol/val.hpp"
 #include "rdb_protocol/var_types.hpp"
 #include "rdb_protocol/wire_func.hpp"
 
 class extproc_pool_t;
 
-namespace re2 {
-class RE2;
-}
-
 namespace ql {
+class client_chunks_t;
 class datum_t;
 class term_t;
 
 scoped_ptr_t<profile::trace_t> maybe_make_profile_trace(profile_bool_t profile);
 
-struct regex_cache_t {
-    explicit regex_cache_t(size_t cache_size) : regexes(cache_size) {}
-    lru_cache_t<std::string, std::shared_ptr<re2::RE2> > regexes;
-};
-
 class env_t : public home_thread_mixin_t {
 public:
     // This is _not_ to be used for secondary index function evaluation -- it doesn't
@@ -89,6 +81,19 @@ public:
     void set_eval_callback(eval_callback_t *callback);
     void do_eval_callback();
 
+    // Where the reads and writes done in this environment are tallied. This is
+    // `nullptr` unless the environment belongs to a client query.
+    void set_resource_usage(query_resource_usage_t *usage) { resource_usage_ = usage; }
+    query_resource_usage_t *resource_usage() const { return resource_usage_; }
+
+    // The reads and writes of the query carry this to the shards.
+    void set_query_priority(query_priority_t priority) { query_priority_ = priority; }
+    query_priority_t query_priority() const { return query_priority_; }
+
+    // Where `r.chunks()` reads the documents sent by `CHUNK` queries. This is
+    // `nullptr` unless the environment belongs to a client query.
+    void set_client_chunks(client_chunks_t *chunks) { client_chunks_ = chunks; }
+    client_chunks_t *client_chunks() const { return client_chunks_; }
 
     const global_optargs_t &get_all_optargs() const {
         return serializable_.global_optargs;
@@ -126,8 +131,6 @@ public:
         }
     }
 
-    regex_cache_t &regex_cache() { return regex_cache_; }
-
     reql_version_t reql_version() const { return reql_version_; }
 
 private:
@@ -141,9 +144,6 @@ private:
     // earlier value.
     const reql_version_t reql_version_;
 
-    // query specific cache parameters; for example match regexes.
-    regex_cache_t regex_cache_;
-
 public:
     const return_empty_normal_batches_t return_empty_normal_batches;
 
@@ -167,6 +167,12 @@ private:
 
     eval_callback_t *eval_callback_;
 
+    query_resource_usage_t *resource_usage_;
+
+    query_priority_t query_priority_;
+
+    client_chunks_t *client_chunks_;
+
     DISABLE_COPYING(env_t);
 };
 
@@ -175,8 +181,15 @@ private:
 class compile_env_t {
 public:
     explicit compile_env_t(var_visibility_t &&_visibility)
-        : visibility(std::move(_visibility)) { }
+        : visibility(std::move(_visibility)), unfoldable_terms(0) { }
     var_visibility_t visibility;
+
+    // Used by `fold_term()` (see `term_folding.hpp`) within one function body: how
+    // often each field selection occurs in it, the ids of the ones that are shared,
+    // and how many of the terms compiled so far can't be folded.
+    std::map<std::string, size_t> selection_counts;
+    std::map<std::string, uint64_t> selection_ids;
+    size_t unfoldable_terms;
 };
 
 // This is an environment for evaluating things that use variables in scope.  It
@@ -188,6 +201,10 @@ public:
     env_t *const env;
     const var_scope_t scope;
 
+    // The values of the shared field selections (see `term_folding.hpp`) that have
+    // been evaluated in this scope, by id.
+    std::map<uint64_t, datum_t> shared_selections;
+
     DISABLE_COPYING(scope_env_t);
 };
 
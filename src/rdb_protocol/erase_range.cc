@@ -77,9 +77,10 @@ continue_bool_t rdb_erase_small_range(
         uint64_t max_keys_to_erase,
         std::vector<rdb_modification_report_t> *mod_reports_out,
         key_range_t *deleted_out) {
-    rassert(mod_reports_out != nullptr);
     rassert(deleted_out != nullptr);
-    mod_reports_out->clear();
+    if (mod_reports_out != nullptr) {
+        mod_reports_out->clear();
+    }
     *deleted_out = key_range_t::empty();
 
     /* Step 1: Collect all keys that we want to erase using a depth-first traversal. */
@@ -121,24 +122,32 @@ continue_bool_t rdb_erase_small_range(
             // is going on.
             guarantee(kv_location.value.has());
 
-            // The mod_report we generate is a simple delete. While there is generally
-            // a difference between an erase and a delete (deletes get backfilled,
-            // while an erase is as if the value had never existed), that
-            // difference is irrelevant in the case of secondary indexes.
-            rdb_modification_report_t mod_report;
-            mod_report.primary_key = key;
-            // Get the full data
-            const rdb_value_t *rdb_value = kv_location.value_as<rdb_value_t>();
-            mod_report.info.deleted.first = get_data(rdb_value,
-                                                     buf_parent_t(&kv_location.buf));
-            // Get the inline value
-            mod_report.info.deleted.second.assign(rdb_value->value_ref(),
-                rdb_value->value_ref() + rdb_value->inline_size(max_block_size));
-            mod_reports_out->push_back(mod_report);
-
-            // Detach the value
-            deletion_context->in_tree_deleter()->delete_value(
-                buf_parent_t(&kv_location.buf), kv_location.value.get());
+            if (mod_reports_out == nullptr) {
+                // Nothing needs the document, so we delete the value right away
+                // without loading it.
+                deletion_context->post_deleter()->delete_value(
+                    buf_parent_t(&kv_location.buf), kv_location.value.get());
+            } else {
+                // The mod_report we generate is a simple delete. While there is
+                // generally a difference between an erase and a delete (deletes get
+                // backfilled, while an erase is as if the value had never existed),
+                // that difference is irrelevant in the case of secondary indexes.
+                rdb_modification_report_t mod_report;
+                mod_report.primary_key = key;
+                // Get the full data
+                const rdb_value_t *rdb_value = kv_location.value_as<rdb_value_t>();
+                mod_report.info.deleted.first =
+                    get_data(rdb_value, buf_parent_t(&kv_location.buf));
+                // Get the inline value
+                mod_report.info.deleted.second.assign(rdb_value->value_ref(),
+                    rdb_value->value_ref() + rdb_value->inline_size(max_block_size));
+                mod_reports_out->push_back(mod_report);
+
+                // Detach the value
+                deletion_context->in_tree_deleter()->delete_value(
+                    buf_parent_t(&kv_location.buf), kv_location.value.get());
+            }
+
             // Erase the entry from the leaf node
             kv_location.value.reset();
             null_key_modification_callback_t null_cb;
@@ -0,0 +1,362 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/explain.hpp"
+
+#include <ctype.h>
+#include <inttypes.h>
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "clustering/administration/admin_op_exc.hpp"
+#include "clustering/administration/auth/permission_error.hpp"
+#include "rdb_protocol/context.hpp"
+#include "rdb_protocol/env.hpp"
+#include "rdb_protocol/val.hpp"
+
+namespace ql {
+
+namespace {
+
+/* Terms that take a table as their first argument without reading its rows. */
+const std::set<Term::TermType> table_admin_terms = {
+    Term::INSERT,
+    Term::CONFIG,
+    Term::STATUS,
+    Term::WAIT,
+    Term::RECONFIGURE,
+    Term::REBALANCE,
+    Term::SYNC,
+    Term::GRANT,
+    Term::INFO,
+    Term::INDEX_CREATE,
+    Term::INDEX_DROP,
+    Term::INDEX_LIST,
+    Term::INDEX_STATUS,
+    Term::INDEX_WAIT,
+    Term::INDEX_RENAME,
+    Term::SET_WRITE_HOOK,
+    Term::GET_WRITE_HOOK,
+};
+
+/* Terms that transform a table's stream row by row, which the shards do when the
+stream comes straight from a table. */
+const std::set<Term::TermType> pushable_transform_terms = {
+    Term::MAP,
+    Term::FILTER,
+    Term::CONCAT_MAP,
+    Term::WITH_FIELDS,
+    Term::HAS_FIELDS,
+    Term::PLUCK,
+    Term::WITHOUT,
+    Term::MERGE,
+};
+
+/* Terms that reduce a table's stream, which the shards also do in parallel. */
+const std::set<Term::TermType> pushable_terminal_terms = {
+    Term::COUNT,
+    Term::SUM,
+    Term::AVG,
+    Term::APPROX_COUNT_DISTINCT,
+    Term::APPROX_QUANTILE,
+    Term::MIN,
+    Term::MAX,
+    Term::REDUCE,
+    Term::GROUP,
+    Term::IS_EMPTY,
+};
+
+std::string operation_name(Term::TermType type) {
+    std::string name = Term::TermType_Name(type);
+    for (char &c : name) {
+        c = tolower(c);
+    }
+    return name;
+}
+
+optional<std::string> literal_string(const raw_term_t &term) {
+    if (term.type() == Term::DATUM) {
+        datum_t d = term.datum();
+        if (d.get_type() == datum_t::R_STR) {
+            return make_optional(d.as_str().to_std());
+        }
+    }
+    return r_nullopt;
+}
+
+class query_explainer_t {
+public:
+    explicit query_explainer_t(env_t *_env)
+        : env(_env), warnings(configured_limits_t::unlimited) { }
+
+    datum_t explain(const raw_term_t &root) {
+        plan_t plan = explain_term(root);
+        datum_object_builder_t result;
+        result.overwrite("plan", plan.node.has() ? plan.node : datum_t::null());
+        result.overwrite("warnings", std::move(warnings).to_datum());
+        return std::move(result).to_datum();
+    }
+
+private:
+    struct plan_t {
+        plan_t() : on_shards(false) { }
+        plan_t(datum_t _node, bool _on_shards) : node(_node), on_shards(_on_shards) { }
+        // Empty if the term doesn't read any tables.
+        datum_t node;
+        // Whether the term's stream is still being produced by the shards, so that
+        // transformations and reductions applied to it are pushed down to them.
+        bool on_shards;
+    };
+
+    plan_t explain_term(const raw_term_t &term) {
+        Term::TermType type = term.type();
+        switch (type) {
+        case Term::TABLE: {
+            std::string table = table_name(term);
+            datum_t estimate = estimate_table_rows(term);
+            std::string size;
+            if (estimate.get_type() == datum_t::R_NUM) {
+                size = strprintf(" (about %" PRIi64 " rows)",
+                                 static_cast<int64_t>(estimate.as_num()));
+            }
+            warnings.add(datum_t(datum_string_t(strprintf(
+                "`%s` is read with a full table scan%s. Use `get_all`, `between` or "
+                "`order_by` with an index to read only part of it.",
+                table.c_str(), size.c_str()))));
+            return plan_t(access_node("table_scan", table, estimate), true);
+        }
+        case Term::GET:
+            if (term.num_args() > 0 && term.arg(0).type() == Term::TABLE) {
+                std::string table = table_name(term.arg(0));
+                return plan_t(access_node("primary_key_get", table, datum_t(1.0)),
+                              false);
+            }
+            break;
+        case Term::GET_ALL:
+            if (term.num_args() > 0 && term.arg(0).type() == Term::TABLE) {
+                std::string table = table_name(term.arg(0));
+                datum_t table_estimate = estimate_table_rows(term.arg(0));
+                optional<std::string> index = index_optarg(term);
+                datum_t estimate = index.has_value()
+                    ? datum_t::null()
+                    : datum_t(static_cast<double>(term.num_args() - 1));
+                datum_t node = access_node(
+                    index.has_value() ? "secondary_index_lookup" : "primary_key_lookup",
+                    table,
+                    estimate,
+                    index,
+                    table_estimate);
+                return plan_t(node, true);
+            }
+            break;
+        case Term::BETWEEN:
+        case Term::BETWEEN_DEPRECATED:
+        case Term::GET_INTERSECTING:
+        case Term::GET_NEAREST:
+            if (term.num_args() > 0 && term.arg(0).type() == Term::TABLE) {
+                std::string table = table_name(term.arg(0));
+                datum_t table_estimate = estimate_table_rows(term.arg(0));
+                const char *access = type == Term::GET_INTERSECTING
+                                     || type == Term::GET_NEAREST
+                    ? "geospatial_index_scan"
+                    : "index_range_scan";
+                return plan_t(access_node(access, table, datum_t::null(),
+                                          index_optarg(term), table_estimate),
+                              type != Term::GET_NEAREST);
+            }
+            break;
+        case Term::ORDER_BY:
+            if (term.num_args() > 0 && term.arg(0).type() == Term::TABLE
+                && term.optarg("index").has_value()) {
+                std::string table = table_name(term.arg(0));
+                datum_t estimate = estimate_table_rows(term.arg(0));
+                return plan_t(access_node("index_ordered_scan", table, estimate,
+                                          index_optarg(term)),
+                              true);
+            }
+            if (term.num_args() > 0) {
+                plan_t source = explain_term(term.arg(0));
+                if (source.node.has()) {
+                    warnings.add(datum_t(
+                        "`order_by` without an index sorts its whole input in "
+                        "memory, which is subject to the array size limit."));
+                    return plan_t(operation_node(type, false, source.node), false);
+                }
+            }
+            break;
+        default:
+            if (table_admin_terms.count(type) != 0
+                && term.num_args() > 0 && term.arg(0).type() == Term::TABLE) {
+                std::string table = table_name(term.arg(0));
+                datum_object_builder_t node;
+                node.overwrite("operation",
+                               datum_t(datum_string_t(operation_name(type))));
+                node.overwrite("table", datum_t(datum_string_t(table)));
+                return plan_t(std::move(node).to_datum(), false);
+            }
+            break;
+        }
+
+        if ((pushable_transform_terms.count(type) != 0
+             || pushable_terminal_terms.count(type) != 0)
+            && term.num_args() > 0) {
+            plan_t source = explain_term(term.arg(0));
+            std::vector<datum_t> others = explain_args(term, 1);
+            if (source.node.has()) {
+                others.insert(others.begin(), source.node);
+                bool transform = pushable_transform_terms.count(type) != 0;
+                return plan_t(operation_node(type, source.on_shards, others),
+                              transform && source.on_shards);
+            }
+            if (!others.empty()) {
+                return plan_t(operation_node(type, false, others), false);
+            }
+            return plan_t();
+        }
+
+        std::vector<datum_t> children = explain_args(term, 0);
+        if (children.empty()) {
+            return plan_t();
+        }
+        return plan_t(operation_node(type, false, children), false);
+    }
+
+    /* Explains the arguments from `first` on, as well as the optargs, and returns the
+    nodes of the ones that read tables. Those are usually subqueries, e.g. in the
+    function passed to `map`. */
+    std::vector<datum_t> explain_args(const raw_term_t &term, size_t first) {
+        std::vector<datum_t> nodes;
+        for (size_t i = first; i < term.num_args(); ++i) {
+            plan_t plan = explain_term(term.arg(i));
+            if (plan.node.has()) {
+                nodes.push_back(plan.node);
+            }
+        }
+        term.each_optarg([&](const raw_term_t &optarg, const std::string &) {
+            plan_t plan = explain_term(optarg);
+            if (plan.node.has()) {
+                nodes.push_back(plan.node);
+            }
+        });
+        return nodes;
+    }
+
+    datum_t operation_node(Term::TermType type,
+                           bool pushed_to_shards,
+                           const datum_t &source) {
+        return operation_node(type, pushed_to_shards, std::vector<datum_t>{source});
+    }
+
+    datum_t operation_node(Term::TermType type,
+                           bool pushed_to_shards,
+                           const std::vector<datum_t> &inputs) {
+        datum_object_builder_t node;
+        node.overwrite("operation", datum_t(datum_string_t(operation_name(type))));
+        node.overwrite("pushed_to_shards", datum_t::boolean(pushed_to_shards));
+        node.overwrite("inputs", datum_t(std::vector<datum_t>(inputs),
+                                         configured_limits_t::unlimited));
+        return std::move(node).to_datum();
+    }
+
+    datum_t access_node(const char *access,
+                        const std::string &table,
+                        const datum_t &estimated_rows,
+                        const optional<std::string> &index = r_nullopt,
+                        const datum_t &table_rows = datum_t()) {
+        datum_object_builder_t node;
+        node.overwrite("operation", datum_t(access));
+        node.overwrite("table", datum_t(datum_string_t(table)));
+        if (index.has_value()) {
+            node.overwrite("index", datum_t(datum_string_t(*index)));
+        }
+        node.overwrite("estimated_rows", estimated_rows);
+        if (table_rows.has()) {
+            node.overwrite("estimated_table_rows", table_rows);
+        }
+        return std::move(node).to_datum();
+    }
+
+    optional<std::string> index_optarg(const raw_term_t &term) {
+        optional<raw_term_t> index = term.optarg("index");
+        if (!index.has_value()) {
+            return r_nullopt;
+        }
+        optional<std::string> name = literal_string(*index);
+        return name.has_value() ? name : make_optional(std::string("<computed>"));
+    }
+
+    /* Finds the names of the database and table that a `TABLE` term reads, as long
+    as they're literals. */
+    void get_table_names(const raw_term_t &table_term,
+                         optional<std::string> *db_name_out,
+                         optional<std::string> *table_name_out) {
+        if (table_term.num_args() == 1) {
+            *table_name_out = literal_string(table_term.arg(0));
+            try {
+                db_name_out->set(env->get_optarg(env, "db")->as_db()->name.str());
+            } catch (const base_exc_t &) {
+                // The default database doesn't exist; the query would fail anyway.
+            }
+        } else if (table_term.num_args() == 2) {
+            *table_name_out = literal_string(table_term.arg(1));
+            raw_term_t db_term = table_term.arg(0);
+            if (db_term.type() == Term::DB && db_term.num_args() == 1) {
+                *db_name_out = literal_string(db_term.arg(0));
+            }
+        }
+    }
+
+    std::string table_name(const raw_term_t &table_term) {
+        optional<std::string> db_name, table_name;
+        get_table_names(table_term, &db_name, &table_name);
+        return strprintf("%s.%s",
+            db_name.has_value() ? db_name->c_str() : "<computed>",
+            table_name.has_value() ? table_name->c_str() : "<computed>");
+    }
+
+    /* Returns the estimated number of rows in the table, or `null` if we can't tell
+    which table it is without running the query. */
+    datum_t estimate_table_rows(const raw_term_t &table_term) {
+        optional<std::string> db_name, table_name;
+        get_table_names(table_term, &db_name, &table_name);
+        name_string_t db_name_string, table_name_string;
+        if (!db_name.has_value() || !table_name.has_value()
+            || !db_name_string.assign_value(*db_name)
+            || !table_name_string.assign_value(*table_name)) {
+            return datum_t::null();
+        }
+        admin_err_t error;
+        counted_t<const db_t> db;
+        if (!env->reql_cluster_interface()->db_find(
+                db_name_string, env->interruptor, &db, &error)) {
+            return datum_t::null();
+        }
+        std::vector<int64_t> doc_counts;
+        try {
+            if (!env->reql_cluster_interface()->table_estimate_doc_counts(
+                    env->get_user_context(), db, table_name_string, env,
+                    &doc_counts, &error)) {
+                return datum_t::null();
+            }
+        } catch (const auth::permission_error_t &) {
+            return datum_t::null();
+        }
+        int64_t total = 0;
+        for (int64_t count : doc_counts) {
+            total += count;
+        }
+        return datum_t(static_cast<double>(total));
+    }
+
+    env_t *env;
+    datum_array_builder_t warnings;
+};
+
+}  // namespace
+
+datum_t explain_query(env_t *env, const raw_term_t &root) {
+    query_explainer_t explainer(env);
+    return explainer.explain(root);
+}
+
+}  // namespace ql
@@ -0,0 +1,26 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_EXPLAIN_HPP_
+#define RDB_PROTOCOL_EXPLAIN_HPP_
+
+#include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/term_storage.hpp"
+
+namespace ql {
+
+class env_t;
+
+/* `explain_query()` describes how a query would read its tables, without running it.
+It's what a query returns when the client passes the `explain` global optarg.
+
+The result has a `plan` field, which is a tree with one node for each term that reads
+a table or processes what was read. Access nodes say how the table is read (a primary
+key get, an index lookup or range scan, or a full table scan) along with an estimate of
+how many rows that reads, which comes from the tables' key distributions. Nodes above
+them say whether their operation is pushed down to the shards or runs on the server
+that parses the query. The `warnings` field lists the full table scans and in-memory
+sorts, since those are the usual reasons for a query being slow. */
+datum_t explain_query(env_t *env, const raw_term_t &root);
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_EXPLAIN_HPP_
@@ -0,0 +1,153 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "rdb_protocol/filter_kernel.hpp"
+
+#include "rdb_protocol/func.hpp"
+#include "rdb_protocol/ql2proto.hpp"
+#include "rdb_protocol/term.hpp"
+#include "rdb_protocol/wire_func.hpp"
+
+namespace ql {
+
+class reql_func_body_visitor_t : public func_visitor_t {
+public:
+    reql_func_body_visitor_t() : reql_func(nullptr) { }
+    void on_reql_func(const reql_func_t *_reql_func) {
+        reql_func = _reql_func;
+    }
+    void on_js_func(const js_func_t *) { }
+    const reql_func_t *reql_func;
+};
+
+scoped_ptr_t<filter_kernel_t> filter_kernel_t::compile(
+        const counted_t<const func_t> &f) {
+    reql_func_body_visitor_t visitor;
+    f->visit(&visitor);
+    const reql_func_t *reql_func = visitor.reql_func;
+    if (reql_func == nullptr || !reql_func->compiled.has()) {
+        return scoped_ptr_t<filter_kernel_t>();
+    }
+    const raw_term_t &body = reql_func->body->get_src();
+    // Objects returned by these are matched against the row by `filter_match()`.
+    if (body.type() == Term::MAKE_OBJ || body.type() == Term::DATUM) {
+        return scoped_ptr_t<filter_kernel_t>();
+    }
+    return scoped_ptr_t<filter_kernel_t>(new filter_kernel_t(reql_func->compiled));
+}
+
+void filter_kernel_t::eval(const std::vector<datum_t> &rows,
+                           const configured_limits_t &limits,
+                           std::vector<result_t> *results_out) const {
+    std::vector<compiled_func_t::result_t> values;
+    predicate->call_batch(rows, limits, &values);
+
+    results_out->clear();
+    results_out->reserve(values.size());
+    for (const compiled_func_t::result_t &value : values) {
+        switch (value.status) {
+        case compiled_func_t::status_t::OK:
+            results_out->push_back(value.value.as_bool()
+                                   ? result_t::MATCH
+                                   : result_t::NO_MATCH);
+            break;
+        case compiled_func_t::status_t::NON_EXISTENCE:
+            results_out->push_back(result_t::NON_EXISTENCE);
+            break;
+        case compiled_func_t::status_t::UNKNOWN:
+            results_out->push_back(result_t::UNKNOWN);
+            break;
+        default:
+            unreachable();
+        }
+    }
+}
+
+namespace {
+
+const reql_func_t *get_reql_func(const counted_t<const func_t> &f) {
+    reql_func_body_visitor_t visitor;
+    f->visit(&visitor);
+    return visitor.reql_func;
+}
+
+}  // namespace
+
+scoped_ptr_t<sindex_key_projection_t> sindex_key_projection_t::make(
+        const counted_t<const func_t> &sindex_func,
+        reql_version_t sindex_func_reql_version) {
+    // Older indexes don't escape null bytes in strings, so their compound keys are
+    // ambiguous.
+    if (escape_nulls_from_reql_version_for_sindex(sindex_func_reql_version)
+        != escape_nulls_t::YES) {
+        return scoped_ptr_t<sindex_key_projection_t>();
+    }
+    const reql_func_t *reql_func = get_reql_func(sindex_func);
+    std::vector<datum_string_t> fields;
+    bool is_compound;
+    if (reql_func == nullptr
+        || !reql_func->compiled.has()
+        || !reql_func->compiled->get_field_projection(&fields, &is_compound)) {
+        return scoped_ptr_t<sindex_key_projection_t>();
+    }
+    return scoped_ptr_t<sindex_key_projection_t>(
+        new sindex_key_projection_t(std::move(fields), is_compound));
+}
+
+bool sindex_key_projection_t::covers(const counted_t<const func_t> &f) const {
+    const reql_func_t *reql_func = get_reql_func(f);
+    return reql_func != nullptr
+        && reql_func->compiled.has()
+        && reql_func->compiled->only_reads_fields(fields);
+}
+
+datum_t sindex_key_projection_t::row_from_key(const store_key_t &key) const {
+    if (datum_t::key_is_truncated(key)) {
+        return datum_t();
+    }
+    datum_t value = datum_t::decode_secondary(
+        datum_t::extract_secondary(key_to_unescaped_str(key)));
+    if (!value.has()) {
+        return datum_t();
+    }
+
+    datum_object_builder_t row;
+    if (is_compound) {
+        if (value.get_type() != datum_t::R_ARRAY || value.arr_size() != fields.size()) {
+            return datum_t();
+        }
+        for (size_t i = 0; i < fields.size(); ++i) {
+            row.overwrite(fields[i], value.get(i));
+        }
+    } else {
+        row.overwrite(fields[0], value);
+    }
+    return std::move(row).to_datum();
+}
+
+scoped_ptr_t<sindex_key_filter_t> sindex_key_filter_t::make(
+        const sindex_key_projection_t *projection,
+        const filter_wire_func_t &filter) {
+    counted_t<const func_t> filter_func = filter.filter_func.compile_wire_func();
+    if (!projection->covers(filter_func)) {
+        return scoped_ptr_t<sindex_key_filter_t>();
+    }
+    // Objects returned by these are matched against the row by `filter_match()`.
+    const reql_func_t *reql_func = get_reql_func(filter_func);
+    const raw_term_t &body = reql_func->body->get_src();
+    if (body.type() == Term::MAKE_OBJ || body.type() == Term::DATUM) {
+        return scoped_ptr_t<sindex_key_filter_t>();
+    }
+    return scoped_ptr_t<sindex_key_filter_t>(
+        new sindex_key_filter_t(projection, reql_func->compiled));
+}
+
+bool sindex_key_filter_t::may_match(const store_key_t &key,
+                                    const configured_limits_t &limits) const {
+    datum_t row = projection->row_from_key(key);
+    if (!row.has()) {
+        return true;
+    }
+    compiled_func_t::result_t res = predicate->call(row, limits);
+    return res.status != compiled_func_t::status_t::OK || res.value.as_bool();
+}
+
+}  // namespace ql
@@ -0,0 +1,115 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_FILTER_KERNEL_HPP_
+#define RDB_PROTOCOL_FILTER_KERNEL_HPP_
+
+#include <utility>
+#include <vector>
+
+#include "btree/keys.hpp"
+#include "containers/counted.hpp"
+#include "containers/scoped.hpp"
+#include "rdb_protocol/compiled_func.hpp"
+#include "rdb_protocol/datum.hpp"
+
+namespace ql {
+
+class configured_limits_t;
+class filter_wire_func_t;
+class func_t;
+
+/* A `filter_kernel_t` evaluates a simple `filter` predicate over a whole batch of rows
+at once, without going through the term tree.  The predicate must be a function that
+`compiled_func_t` can compile, and each of its instructions computes one column of
+values for the whole batch from the columns of the instructions it depends on.
+
+Rows for which the kernel can't tell what the interpreter would do (most of all,
+rows on which the interpreter would throw something other than a non-existence
+error) are reported as `UNKNOWN`, and must be handed to `func_t::filter_call()`. */
+class filter_kernel_t {
+public:
+    enum class result_t {
+        NO_MATCH,
+        MATCH,
+        // The predicate threw a non-existence error, e.g. because of a missing field.
+        NON_EXISTENCE,
+        UNKNOWN
+    };
+
+    // Returns an empty pointer if `f` isn't a predicate that we know how to compile.
+    static scoped_ptr_t<filter_kernel_t> compile(const counted_t<const func_t> &f);
+
+    void eval(const std::vector<datum_t> &rows,
+              const configured_limits_t &limits,
+              std::vector<result_t> *results_out) const;
+
+private:
+    explicit filter_kernel_t(const counted_t<const compiled_func_t> &_predicate)
+        : predicate(_predicate) { }
+
+    counted_t<const compiled_func_t> predicate;
+
+    DISABLE_COPYING(filter_kernel_t);
+};
+
+/* A `sindex_key_projection_t` rebuilds part of a row from a secondary index key. That
+works when the index function picks top-level fields out of the row (`row('a')`, or a
+compound index like `[row('a'), row('b')]`): the key then holds the values of those
+fields, and a function that only looks at them (see
+`compiled_func_t::only_reads_fields()`) gives the same result on an object with just
+those fields as on the whole row. Keys that were truncated, or that hold values we
+can't decode, don't give a row. */
+class sindex_key_projection_t {
+public:
+    // Returns an empty pointer if `sindex_func` (of a non-multi index) isn't a
+    // projection we can undo.
+    static scoped_ptr_t<sindex_key_projection_t> make(
+        const counted_t<const func_t> &sindex_func,
+        reql_version_t sindex_func_reql_version);
+
+    // Whether `f` only looks at the fields stored in the key.
+    bool covers(const counted_t<const func_t> &f) const;
+
+    // Returns an object with the indexed fields of the row stored under `key`, or an
+    // empty datum.
+    datum_t row_from_key(const store_key_t &key) const;
+
+private:
+    sindex_key_projection_t(std::vector<datum_string_t> &&_fields, bool _is_compound)
+        : fields(std::move(_fields)), is_compound(_is_compound) { }
+
+    // The fields that make up the index, in order
+    std::vector<datum_string_t> fields;
+    bool is_compound;
+
+    DISABLE_COPYING(sindex_key_projection_t);
+};
+
+/* A `sindex_key_filter_t` evaluates the `filter` right after a secondary index read
+against the part of the row we can get from the index key, so that rows it rejects
+never have to be loaded. Rows for which we don't get a definite answer are let
+through, and the `filter` itself still runs on every row that does get through, so
+this only ever saves work. */
+class sindex_key_filter_t {
+public:
+    // Returns an empty pointer if the filter needs more than `projection` provides.
+    static scoped_ptr_t<sindex_key_filter_t> make(
+        const sindex_key_projection_t *projection,
+        const filter_wire_func_t &filter);
+
+    // Returns false if the row stored under `key` certainly doesn't pass the filter.
+    bool may_match(const store_key_t &key, const configured_limits_t &limits) const;
+
+private:
+    sindex_key_filter_t(const sindex_key_projection_t *_projection,
+                        const counted_t<const compiled_func_t> &_predicate)
+        : projection(_projection), predicate(_predicate) { }
+
+    const sindex_key_projection_t *projection;
+    counted_t<const compiled_func_t> predicate;
+
+    DISABLE_COPYING(sindex_key_filter_t);
+};
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_FILTER_KERNEL_HPP_
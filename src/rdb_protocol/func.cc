@@ -7,6 +7,7 @@
 #include "rdb_protocol/minidriver.hpp"
 #include "rdb_protocol/pseudo_literal.hpp"
 #include "rdb_protocol/ql2proto.hpp"
+#include "rdb_protocol/term_folding.hpp"
 #include "rdb_protocol/term_walker.hpp"
 #include "stl_utils.hpp"
 
@@ -41,11 +42,13 @@ void func_t::assert_deterministic(constant_now_t cn, const char *extra_msg) cons
 
 reql_func_t::reql_func_t(const var_scope_t &_captured_scope,
                          std::vector<sym_t> _arg_names,
-                         counted_t<const term_t> _body)
+                         counted_t<const term_t> _body,
+                         counted_t<const compiled_func_t> _compiled)
     : func_t(_body->backtrace()),
       captured_scope(_captured_scope),
       arg_names(std::move(_arg_names)),
-      body(std::move(_body)) { }
+      body(std::move(_body)),
+      compiled(std::move(_compiled)) { }
 
 reql_func_t::reql_func_t(scoped_ptr_t<term_storage_t> &&_storage,
                          const var_scope_t &_captured_scope,
@@ -55,7 +58,8 @@ reql_func_t::reql_func_t(scoped_ptr_t<term_storage_t> &&_storage,
       captured_scope(_captured_scope),
       arg_names(std::move(_arg_names)),
       term_storage(std::move(_storage)),
-      body(std::move(_body)) { }
+      body(std::move(_body)),
+      compiled(compiled_func_t::compile(arg_names, body->get_src())) { }
 
 reql_func_t::~reql_func_t() { }
 
@@ -75,6 +79,15 @@ scoped_ptr_t<val_t> reql_func_t::call(env_t *env,
                          arg_names.size(),
                          (arg_names.size() == 1 ? "" : "s")));
 
+        if (compiled.has() && args.size() == 1 && eval_flags == NO_FLAGS) {
+            compiled_func_t::result_t res = compiled->call(args[0], env->limits());
+            if (res.status == compiled_func_t::status_t::OK) {
+                return make_scoped<val_t>(std::move(res.value), body->backtrace());
+            }
+            // Let the interpreter produce the error, or whatever else it is that
+            // the compiled function didn't know how to do.
+        }
+
         var_scope_t new_scope = arg_names.size() == 0
             ? captured_scope
             : captured_scope.with_func_arg_list(arg_names, args);
@@ -136,6 +149,44 @@ scoped_ptr_t<val_t> js_func_t::call(
     }
 }
 
+std::vector<datum_t> js_func_t::call_batch(
+    env_t *env,
+    const std::vector<datum_t> &rows) const {
+    try {
+        js_runner_t::req_config_t config;
+        config.timeout_ms = js_timeout_ms;
+
+        r_sanity_check(!js_source.empty());
+        std::vector<std::vector<datum_t> > args_batch;
+        args_batch.reserve(rows.size());
+        for (const datum_t &row : rows) {
+            args_batch.push_back(std::vector<datum_t>{row});
+        }
+        std::vector<js_result_t> results;
+
+        try {
+            results = env->get_js_runner()->call_batch(js_source, args_batch, config);
+        } catch (const extproc_worker_exc_t &e) {
+            rfail(base_exc_t::INTERNAL,
+                  "Javascript query `%s` caused a crash in a worker process.",
+                  js_source.c_str());
+        }
+
+        std::vector<datum_t> out;
+        out.reserve(results.size());
+        for (const js_result_t &result : results) {
+            scoped_ptr_t<val_t> val(
+                boost::apply_visitor(
+                    js_result_visitor_t(js_source, js_timeout_ms, this), result));
+            out.push_back(val->as_datum());
+        }
+        return out;
+    } catch (const datum_exc_t &e) {
+        rfail(e.get_type(), "%s", e.what());
+        unreachable();
+    }
+}
+
 optional<size_t> js_func_t::arity() const {
     return r_nullopt;
 }
@@ -197,6 +248,7 @@ func_term_t::func_term_t(compile_env_t *env, const raw_term_t &t)
 
     var_visibility_t varname_visibility = env->visibility.with_func_arg_name_list(args);
     compile_env_t body_env(std::move(varname_visibility));
+    count_selections(&body_env, raw_body);
 
     counted_t<const term_t> compiled_body = compile_term(&body_env, raw_body);
     r_sanity_check(compiled_body.has());
@@ -212,6 +264,7 @@ func_term_t::func_term_t(compile_env_t *env, const raw_term_t &t)
 
     arg_names = std::move(args);
     body = std::move(compiled_body);
+    compiled = compiled_func_t::compile(arg_names, raw_body);
     external_captures = std::move(captures);
 }
 
@@ -228,7 +281,7 @@ scoped_ptr_t<val_t> func_term_t::term_eval(scope_env_t *env,
 
 counted_t<const func_t> func_term_t::eval_to_func(const var_scope_t &env_scope) const {
     return make_counted<reql_func_t>(env_scope.filtered_by_captures(external_captures),
-                                     arg_names, body);
+                                     arg_names, body, compiled);
 }
 
 deterministic_t func_term_t::is_deterministic() const {
@@ -422,6 +475,214 @@ counted_t<const func_t> new_page_func(datum_t method, backtrace_id_t bt) {
     return counted_t<const func_t>();
 }
 
+namespace {
+
+class unary_reql_func_visitor_t : public func_visitor_t {
+public:
+    unary_reql_func_visitor_t() : reql_func(nullptr) { }
+    void on_reql_func(const reql_func_t *f) final {
+        if (f->arity() == make_optional<size_t>(1)) {
+            reql_func = f;
+        }
+    }
+    void on_js_func(const js_func_t *) final { }
+    const reql_func_t *reql_func;
+};
+
+// Rebuilds the `FUNC` term that `f` was compiled from.
+minidriver_t::reql_t func_to_term(minidriver_t *r,
+                                  const std::vector<sym_t> &arg_names,
+                                  const raw_term_t &body) {
+    minidriver_t::reql_t args = r->array();
+    for (const sym_t &arg : arg_names) {
+        args.add_arg(static_cast<double>(arg.value));
+    }
+    return args.call(Term::FUNC, r->expr(body));
+}
+
+}  // namespace
+
+counted_t<const func_t> new_partial_index_func(const counted_t<const func_t> &mapping,
+                                               const counted_t<const func_t> &predicate,
+                                               backtrace_id_t bt) {
+    unary_reql_func_visitor_t mapping_visitor;
+    mapping->visit(&mapping_visitor);
+    unary_reql_func_visitor_t predicate_visitor;
+    predicate->visit(&predicate_visitor);
+    const reql_func_t *m = mapping_visitor.reql_func;
+    const reql_func_t *p = predicate_visitor.reql_func;
+    rcheck_src(bt, m != nullptr && p != nullptr, base_exc_t::LOGIC,
+               "The index function and the `filter` of a partial index must both be "
+               "ReQL functions of one argument.");
+
+    // The two functions can come from different queries (when the index function is
+    // one returned by `index_status`), so the new function captures the variables of
+    // both.
+    optional<var_scope_t> scope = m->captured_scope.merged_with(p->captured_scope);
+    rcheck_src(bt, scope.has_value(), base_exc_t::LOGIC,
+               "The index function and the `filter` of a partial index can't be "
+               "combined.");
+
+    minidriver_t r(bt);
+    auto row = minidriver_t::dummy_var_t::PARTIAL_INDEX_ROW;
+    minidriver_t::reql_t body = r.branch(
+        func_to_term(&r, p->arg_names, p->body->get_src())(r.var(row)),
+        func_to_term(&r, m->arg_names, m->body->get_src())(r.var(row)),
+        r.null());
+    compile_env_t compile_env(scope->compute_visibility());
+    counted_t<func_term_t> func_term =
+        make_counted<func_term_t>(&compile_env, r.fun(row, body).root_term());
+    return func_term->eval_to_func(*scope);
+}
+
+counted_t<const func_t> new_expiry_func(const datum_string_t &field,
+                                        datum_t now,
+                                        backtrace_id_t bt) {
+    minidriver_t r(bt);
+    auto row = minidriver_t::dummy_var_t::EXPIRY_ROW;
+    datum_t field_datum(field);
+    minidriver_t::reql_t expired =
+        (r.expr(row)[field_datum].call(Term::TYPE_OF) == datum_t("PTYPE<TIME>")
+         && r.expr(row)[field_datum] < now).default_(false);
+    compile_env_t empty_compile_env((var_visibility_t()));
+    counted_t<func_term_t> func_term =
+        make_counted<func_term_t>(&empty_compile_env,
+                                  r.fun(row, r.branch(expired, r.null(), r.var(row)))
+                                      .root_term());
+    return func_term->eval_to_func(var_scope_t());
+}
+
+namespace {
+
+// Adds the variables a `FUNC` term binds to `*vars_out`.
+void get_func_arg_syms(const raw_term_t &func, std::vector<int64_t> *vars_out) {
+    raw_term_t vars = func.arg(0);
+    if (vars.type() == Term::DATUM) {
+        datum_t d = vars.datum();
+        for (size_t i = 0; i < d.arr_size(); ++i) {
+            vars_out->push_back(static_cast<int64_t>(d.get(i).as_num()));
+        }
+    } else {
+        for (size_t i = 0; i < vars.num_args(); ++i) {
+            vars_out->push_back(static_cast<int64_t>(vars.arg(i).datum().as_num()));
+        }
+    }
+}
+
+bool is_row_var(const raw_term_t &term, const std::set<int64_t> &row_vars) {
+    return term.type() == Term::VAR
+        && row_vars.count(static_cast<int64_t>(term.arg(0).datum().as_num())) != 0;
+}
+
+/* Returns false if `term` uses one of the `row_vars` in any way other than to take
+top-level fields out of it, and adds the fields it takes to `*fields_out` otherwise.
+The function arguments are validated terms, so we don't need to worry about their
+shape beyond what we look at. */
+bool collect_fields_read(const raw_term_t &term,
+                         std::set<int64_t> *row_vars,
+                         std::set<datum_string_t> *fields_out) {
+    switch (term.type()) {
+    case Term::IMPLICIT_VAR:
+        return false;
+    case Term::VAR:
+        return !is_row_var(term, *row_vars);
+    case Term::GET_FIELD: // fallthru
+    case Term::BRACKET: // fallthru
+    case Term::PLUCK: // fallthru
+    case Term::HAS_FIELDS:
+        if (term.num_args() >= 1 && is_row_var(term.arg(0), *row_vars)) {
+            if (term.num_optargs() != 0 || term.num_args() < 2) {
+                return false;
+            }
+            for (size_t i = 1; i < term.num_args(); ++i) {
+                raw_term_t field = term.arg(i);
+                if (field.type() != Term::DATUM) {
+                    return false;
+                }
+                datum_t d = field.datum();
+                if (d.get_type() != datum_t::R_STR) {
+                    return false;
+                }
+                fields_out->insert(d.as_str());
+            }
+            return true;
+        }
+        break;
+    case Term::FUNCALL:
+        // `(function(y) { ... })(row)`, which is how `new_partial_index_func()` calls
+        // the functions it combines, makes `y` another name for the row.
+        if (term.num_args() == 2
+            && term.arg(0).type() == Term::FUNC
+            && is_row_var(term.arg(1), *row_vars)) {
+            std::vector<int64_t> vars;
+            get_func_arg_syms(term.arg(0), &vars);
+            if (vars.size() == 1) {
+                row_vars->insert(vars[0]);
+                return collect_fields_read(term.arg(0).arg(1), row_vars, fields_out);
+            }
+        }
+        break;
+    case Term::FUNC:
+        // The first argument is the list of variables.
+        return collect_fields_read(term.arg(1), row_vars, fields_out);
+    default:
+        break;
+    }
+    for (size_t i = 0; i < term.num_args(); ++i) {
+        if (!collect_fields_read(term.arg(i), row_vars, fields_out)) {
+            return false;
+        }
+    }
+    bool ok = true;
+    term.each_optarg([&](const raw_term_t &optarg, const std::string &) {
+            ok = ok && collect_fields_read(optarg, row_vars, fields_out);
+        });
+    return ok;
+}
+
+}  // namespace
+
+bool get_top_level_fields_read(const counted_t<const func_t> &f,
+                               std::set<datum_string_t> *fields_out) {
+    unary_reql_func_visitor_t visitor;
+    f->visit(&visitor);
+    if (visitor.reql_func == nullptr) {
+        return false;
+    }
+    std::set<int64_t> row_vars;
+    row_vars.insert(visitor.reql_func->arg_names[0].value);
+    std::set<datum_string_t> fields;
+    if (!collect_fields_read(visitor.reql_func->body->get_src(), &row_vars, &fields)) {
+        return false;
+    }
+    *fields_out = std::move(fields);
+    return true;
+}
+
+optional<datum_string_t> get_selected_field(const counted_t<const func_t> &f) {
+    unary_reql_func_visitor_t visitor;
+    f->visit(&visitor);
+    if (visitor.reql_func == nullptr
+        || visitor.reql_func->captured_scope.size() != 0) {
+        return r_nullopt;
+    }
+    std::set<int64_t> row_vars;
+    row_vars.insert(visitor.reql_func->arg_names[0].value);
+    const raw_term_t &body = visitor.reql_func->body->get_src();
+    if ((body.type() != Term::GET_FIELD && body.type() != Term::BRACKET)
+        || body.num_args() != 2
+        || body.num_optargs() != 0
+        || !is_row_var(body.arg(0), row_vars)
+        || body.arg(1).type() != Term::DATUM) {
+        return r_nullopt;
+    }
+    datum_t field = body.arg(1).datum();
+    if (field.get_type() != datum_t::R_STR) {
+        return r_nullopt;
+    }
+    return make_optional(field.as_str());
+}
+
 val_t *js_result_visitor_t::operator()(const std::string &err_val) const {
     rfail_target(parent, base_exc_t::LOGIC, "%s", err_val.c_str());
     unreachable();
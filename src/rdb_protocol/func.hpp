@@ -3,6 +3,7 @@
 #define RDB_PROTOCOL_FUNC_HPP_
 
 #include <map>
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
@@ -12,6 +13,7 @@
 
 #include "containers/counted.hpp"
 #include "containers/uuid.hpp"
+#include "rdb_protocol/compiled_func.hpp"
 #include "rdb_protocol/datum.hpp"
 #include "rdb_protocol/env.hpp"
 #include "rdb_protocol/op.hpp"
@@ -80,10 +82,12 @@ private:
 
 class reql_func_t : public func_t {
 public:
-    // Used when constructing in an existing environment - reusing another term storage
+    // Used when constructing in an existing environment - reusing another term storage.
+    // `compiled` is `body` lowered by `compiled_func_t::compile()`, or empty.
     reql_func_t(const var_scope_t &captured_scope,
                 std::vector<sym_t> arg_names,
-                counted_t<const term_t> body);
+                counted_t<const term_t> body,
+                counted_t<const compiled_func_t> compiled);
 
     // Used when constructing from a function read off the wire
     reql_func_t(scoped_ptr_t<term_storage_t> &&_storage,
@@ -111,6 +115,15 @@ public:
 
 private:
     template <cluster_version_t> friend class wire_func_serialization_visitor_t;
+    friend class filter_kernel_t;
+    friend class sindex_key_filter_t;
+    friend class sindex_key_projection_t;
+    friend counted_t<const func_t> new_partial_index_func(
+        const counted_t<const func_t> &, const counted_t<const func_t> &,
+        backtrace_id_t);
+    friend bool get_top_level_fields_read(
+        const counted_t<const func_t> &, std::set<datum_string_t> *);
+    friend optional<datum_string_t> get_selected_field(const counted_t<const func_t> &);
     bool filter_helper(env_t *env, datum_t arg) const;
 
     // Only contains the parts of the scope that `body` uses.
@@ -126,6 +139,10 @@ private:
     // The body of the function, which gets ->eval(...) called when call(...) is called.
     counted_t<const term_t> body;
 
+    // If the body is simple enough, a compiled version of it that call(...) tries
+    // before evaluating `body`.
+    counted_t<const compiled_func_t> compiled;
+
     DISABLE_COPYING(reql_func_t);
 };
 
@@ -142,6 +159,10 @@ public:
                              const std::vector<datum_t> &args,
                              eval_flags_t eval_flags) const;
 
+    // Calls the function on each of `rows` in a single round trip to the JS worker,
+    // and returns the results in order. Throws the error of the first row that fails.
+    std::vector<datum_t> call_batch(env_t *env, const std::vector<datum_t> &rows) const;
+
     optional<size_t> arity() const;
 
     deterministic_t is_deterministic() const;
@@ -179,6 +200,34 @@ counted_t<const func_t> new_get_field_func(datum_t obj, backtrace_id_t bt);
 counted_t<const func_t> new_eq_comparison_func(datum_t obj, backtrace_id_t bt);
 counted_t<const func_t> new_page_func(datum_t method, backtrace_id_t bt);
 
+// The index function of a partial secondary index: returns what `mapping` returns for
+// the rows that `predicate` accepts, and `null` (which never gets indexed) for all
+// others.  Both must be ReQL functions of one argument.
+counted_t<const func_t> new_partial_index_func(const counted_t<const func_t> &mapping,
+                                               const counted_t<const func_t> &predicate,
+                                               backtrace_id_t bt);
+
+// The function that tables with an `expiry_field` replace their expired rows with:
+// returns `null` (which deletes the row) if the row's value for `field` is a time
+// before `now`, and the row itself otherwise.  The row is checked again because it
+// may have changed since it was found through the expiry index.
+counted_t<const func_t> new_expiry_func(const datum_string_t &field,
+                                        datum_t now,
+                                        backtrace_id_t bt);
+
+// If `f` is a ReQL function of one argument that only looks at top-level fields of its
+// argument (through `row('a')`, `row.pluck('a', ...)` or `row.has_fields('a', ...)`),
+// sets `*fields_out` to those fields and returns true.  A deterministic `f` then gives
+// the same result on any two objects with the same values in those fields.
+bool get_top_level_fields_read(const counted_t<const func_t> &f,
+                               std::set<datum_string_t> *fields_out);
+
+// If `f` is a ReQL function of one argument that returns a top-level field of it
+// (`row('a')`, which is also what a field name passed to `sum` and the like turns
+// into), returns that field.  Unlike the function's serialization, this doesn't
+// depend on the variable names the client picked.
+optional<datum_string_t> get_selected_field(const counted_t<const func_t> &f);
+
 class js_result_visitor_t : public boost::static_visitor<val_t *> {
 public:
     js_result_visitor_t(const std::string &_code,
@@ -221,6 +270,8 @@ private:
 
     std::vector<sym_t> arg_names;
     counted_t<const term_t> body;
+    // Shared by all the `reql_func_t`s we evaluate to.
+    counted_t<const compiled_func_t> compiled;
 
     var_captures_t external_captures;
 };
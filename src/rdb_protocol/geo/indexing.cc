@@ -2,12 +2,15 @@
 #include "rdb_protocol/geo/indexing.hpp"
 
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "btree/keys.hpp"
 #include "btree/leaf_node.hpp"
 #include "concurrency/interruptor.hpp"
 #include "concurrency/signal.hpp"
+#include "containers/archive/vector_stream.hpp"
+#include "containers/lru_cache.hpp"
 #include "containers/scoped.hpp"
 #include "rdb_protocol/geo/exceptions.hpp"
 #include "rdb_protocol/geo/geojson.hpp"
@@ -21,6 +24,7 @@
 #include "rdb_protocol/geo/s2/strings/strutil.h"
 #include "rdb_protocol/datum.hpp"
 #include "rdb_protocol/pseudo_geometry.hpp"
+#include "thread_local.hpp"
 
 using geo::S2Cell;
 using geo::S2CellId;
@@ -36,6 +40,9 @@ using ql::datum_t;
 //   (...at index creation?)
 extern const int GEO_INDEX_GOAL_GRID_CELLS = 8;
 
+// How many query shapes `get_geo_query_shape()` keeps around on each thread
+const size_t GEO_QUERY_SHAPE_CACHE_SIZE = 64;
+
 class compute_covering_t : public s2_geo_visitor_t<scoped_ptr_t<std::vector<S2CellId> > > {
 public:
     explicit compute_covering_t(int goal_cells) {
@@ -177,7 +184,8 @@ std::pair<S2CellId, bool> order_btree_key_relative_to_s2cellid_keys(
     version is 1.16 or higher, the high bit on the 'G' will be set. */
     uint8_t first_char;
     switch (skey_version) {
-        case ql::skey_version_t::post_1_16:
+        case ql::skey_version_t::post_1_16: // fallthru
+        case ql::skey_version_t::post_2_6:
             first_char = static_cast<uint8_t>('G') | 0x80; break;
         default: unreachable();
     }
@@ -304,6 +312,47 @@ std::vector<S2CellId> compute_interior_cell_covering(
     return *covering;
 }
 
+geo_query_shape_t::geo_query_shape_t(
+        const ql::datum_t &query_geometry, int goal_cells)
+    : covering(compute_cell_covering(query_geometry, goal_cells)),
+      interior_covering(compute_interior_cell_covering(query_geometry, covering)),
+      geometry(query_geometry) { }
+
+// Query shapes are keyed by the serialized query geometry (and the number of cells in
+// the covering), so that only identical geometries share an entry.
+typedef lru_cache_t<std::pair<int, std::vector<char> >,
+                    std::shared_ptr<const geo_query_shape_t> > geo_query_shape_cache_t;
+
+TLS_with_init(geo_query_shape_cache_t *, geo_query_shape_cache, nullptr)
+
+std::shared_ptr<const geo_query_shape_t> get_geo_query_shape(
+        const ql::datum_t &query_geometry,
+        int goal_cells) {
+    // Constructed lazily, so it's constructed on the thread that uses it.
+    if (TLS_get_geo_query_shape_cache() == nullptr) {
+        TLS_set_geo_query_shape_cache(
+            new geo_query_shape_cache_t(GEO_QUERY_SHAPE_CACHE_SIZE));
+    }
+    geo_query_shape_cache_t *cache = TLS_get_geo_query_shape_cache();
+
+    write_message_t wm;
+    serialize<cluster_version_t::LATEST_DISK>(&wm, query_geometry);
+    vector_stream_t stream;
+    int res = send_write_message(&stream, &wm);
+    guarantee(res == 0);
+    std::pair<int, std::vector<char> > key(goal_cells, stream.vector());
+
+    auto it = cache->find(key);
+    if (it != cache->end()) {
+        return it->second;
+    }
+    // This can throw a `geo_exception_t`, in which case nothing gets cached.
+    std::shared_ptr<const geo_query_shape_t> shape =
+        std::make_shared<const geo_query_shape_t>(query_geometry, goal_cells);
+    (*cache)[std::move(key)] = shape;
+    return shape;
+}
+
 geo_index_traversal_helper_t::geo_index_traversal_helper_t(
         ql::skey_version_t skey_version, const signal_t *interruptor)
     : is_initialized_(false), skey_version_(skey_version), interruptor_(interruptor) { }
@@ -2,11 +2,13 @@
 #ifndef RDB_PROTOCOL_GEO_INDEXING_HPP_
 #define RDB_PROTOCOL_GEO_INDEXING_HPP_
 
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "btree/concurrent_traversal.hpp"
 #include "containers/counted.hpp"
+#include "rdb_protocol/geo/intersection.hpp"
 #include "rdb_protocol/geo/s2/s2cellid.h"
 
 namespace ql {
@@ -36,6 +38,26 @@ std::vector<geo::S2CellId> compute_interior_cell_covering(
         const ql::datum_t &key,
         const std::vector<geo::S2CellId> &exterior_covering);
 
+/* Everything we need to know about the geometry of a `getIntersecting` query: its cell
+covering, its interior cell covering, and the geometry itself for the intersection tests
+on the candidates we find in the index. */
+class geo_query_shape_t {
+public:
+    geo_query_shape_t(const ql::datum_t &query_geometry, int goal_cells);
+
+    const std::vector<geo::S2CellId> covering;
+    const std::vector<geo::S2CellId> interior_covering;
+    const prepared_geometry_t geometry;
+};
+
+/* Returns the `geo_query_shape_t` for `query_geometry`. Clients tend to run the same
+queries over and over (think of a fixed set of delivery zones), so the shapes of
+recently used query geometries are cached on each thread. The result must not be
+passed to another thread. */
+std::shared_ptr<const geo_query_shape_t> get_geo_query_shape(
+        const ql::datum_t &query_geometry,
+        int goal_cells);
+
 // TODO (daniel): Support compound indexes somehow.
 class geo_index_traversal_helper_t : public concurrent_traversal_callback_t {
 public:
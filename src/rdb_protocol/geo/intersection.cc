@@ -6,6 +6,7 @@
 #include "rdb_protocol/geo/geojson.hpp"
 #include "rdb_protocol/geo/geo_visitor.hpp"
 #include "rdb_protocol/geo/s2/s2.h"
+#include "rdb_protocol/geo/s2/s2latlngrect.h"
 #include "rdb_protocol/geo/s2/s2polygon.h"
 #include "rdb_protocol/geo/s2/s2polyline.h"
 #include "rdb_protocol/datum.hpp"
@@ -70,6 +71,52 @@ bool geo_does_intersect(const ql::datum_t &g1,
     return visit_geojson(&tester, g1);
 }
 
+class prepared_geometry_builder_t : public s2_geo_visitor_t<void> {
+public:
+    explicit prepared_geometry_builder_t(prepared_geometry_t *out) : out_(out) { }
+
+    void on_point(const S2Point &point) {
+        out_->point.init(new S2Point(point));
+    }
+    void on_line(const S2Polyline &line) {
+        out_->line.init(line.Clone());
+    }
+    void on_polygon(const S2Polygon &polygon) {
+        out_->polygon.init(new S2Polygon());
+        out_->polygon->Copy(&polygon);
+    }
+    void on_latlngrect(const S2LatLngRect &rect) {
+        out_->rect.init(new S2LatLngRect(rect));
+    }
+
+private:
+    prepared_geometry_t *out_;
+};
+
+prepared_geometry_t::prepared_geometry_t(const ql::datum_t &geojson) {
+    prepared_geometry_builder_t builder(this);
+    visit_geojson(&builder, geojson);
+}
+
+prepared_geometry_t::~prepared_geometry_t() { }
+
+bool prepared_geometry_t::intersects(const ql::datum_t &other) const {
+    if (point.has()) {
+        inner_intersection_tester_t<S2Point> tester(point.get());
+        return visit_geojson(&tester, other);
+    } else if (line.has()) {
+        inner_intersection_tester_t<S2Polyline> tester(line.get());
+        return visit_geojson(&tester, other);
+    } else if (polygon.has()) {
+        inner_intersection_tester_t<S2Polygon> tester(polygon.get());
+        return visit_geojson(&tester, other);
+    } else {
+        guarantee(rect.has());
+        inner_intersection_tester_t<S2LatLngRect> tester(rect.get());
+        return visit_geojson(&tester, other);
+    }
+}
+
 bool geo_does_intersect(const S2Point &point,
                         const S2Point &other_point) {
     return point == other_point;
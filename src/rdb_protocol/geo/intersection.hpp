@@ -3,6 +3,7 @@
 #define RDB_PROTOCOL_GEO_INTERSECTION_HPP_
 
 #include "containers/counted.hpp"
+#include "containers/scoped.hpp"
 #include "rdb_protocol/geo/s2/util/math/vector3.h"
 
 namespace geo {
@@ -20,6 +21,30 @@ class datum_t;
 bool geo_does_intersect(const ql::datum_t &g1,
                         const ql::datum_t &g2);
 
+/* A GeoJSON object that has been converted to its S2 type once, so that it can be
+tested against many other objects without converting it again each time. For polygons
+this also keeps around the edge indexes that S2 builds up over the course of the
+tests. Not thread safe, because S2 builds those indexes lazily. */
+class prepared_geometry_t {
+public:
+    explicit prepared_geometry_t(const ql::datum_t &geojson);
+    ~prepared_geometry_t();
+
+    // Same as `geo_does_intersect(geojson, other)`
+    bool intersects(const ql::datum_t &other) const;
+
+private:
+    friend class prepared_geometry_builder_t;
+
+    // Exactly one of these is set
+    scoped_ptr_t<geo::S2Point> point;
+    scoped_ptr_t<geo::S2Polyline> line;
+    scoped_ptr_t<geo::S2Polygon> polygon;
+    scoped_ptr_t<geo::S2LatLngRect> rect;
+
+    DISABLE_COPYING(prepared_geometry_t);
+};
+
 /* Variants for each pair of S2 geometry */
 bool geo_does_intersect(const geo::S2Point &point,
                         const geo::S2Point &other_point);
@@ -46,9 +46,9 @@ lon_lat_line_t build_circle(
     return result;
 }
 
-/* WARNING: This function is used by nearest_traversal_cb_t::init_query_geometry()
- * and must provide some strict guarantees. Read the notes in that function before
- * modifying this. */
+/* The resulting polygon must intersect (using spherical geometry) with *every* point
+ * x that has a distance (on the given ellipsoid) dist(center, x) <= min_inradius.
+ * There is a unit test in geo_primitives.cc to verify this numerically. */
 lon_lat_line_t build_polygon_with_inradius_at_least(
         const lon_lat_point_t &center,
         double min_inradius,
@@ -83,9 +83,9 @@ lon_lat_line_t build_polygon_with_inradius_at_least(
     return build_circle(center, ex_r, num_vertices, e);
 }
 
-/* WARNING: This function is used by nearest_traversal_cb_t::init_query_geometry()
- * and must provide some strict guarantees. Read the notes in that function before
- * modifying this. */
+/* The resulting polygon must *not* intersect (using spherical geometry) with any
+ * point x that has a distance (on the given ellipsoid) dist(center, x) > max_exradius.
+ * There is a unit test in geo_primitives.cc to verify this numerically. */
 lon_lat_line_t build_polygon_with_exradius_at_most(
         const lon_lat_point_t &center,
         double max_exradius,
@@ -13,12 +13,19 @@
 #include "rdb_protocol/geo/geojson.hpp"
 #include "rdb_protocol/geo/intersection.hpp"
 #include "rdb_protocol/geo/lon_lat_types.hpp"
-#include "rdb_protocol/geo/primitives.hpp"
+#include "rdb_protocol/geo/s2/s1angle.h"
 #include "rdb_protocol/geo/s2/s2.h"
+#include "rdb_protocol/geo/s2/s2cap.h"
+#include "rdb_protocol/geo/s2/s2cell.h"
+#include "rdb_protocol/geo/s2/s2cellid.h"
 #include "rdb_protocol/geo/s2/s2latlng.h"
 #include "rdb_protocol/lazy_btree_val.hpp"
 #include "rdb_protocol/profile.hpp"
 
+using geo::S1Angle;
+using geo::S2Cap;
+using geo::S2Cell;
+using geo::S2CellId;
 using geo::S2Point;
 using geo::S2LatLng;
 
@@ -31,20 +38,18 @@ const size_t MAX_PROCESSED_SET_SIZE = 10000;
 // the CPU overhead for computing the grid covering.
 const int QUERYING_GOAL_GRID_CELLS = 16;
 
-// The radius used for the first batch of a get_nearest traversal.
-// As a fraction of the equator's radius.
+// The size of the grid cells that a get_nearest traversal looks at right around
+// its center. As a fraction of the equator's radius.
 // The current value is equivalent to a radius of 10m on earth.
 const double NEAREST_INITIAL_RADIUS_FRACTION = 10.0 / 6378137.0;
 
-// By which factor to increase the radius between nearest batches (at maximum)
-const double NEAREST_MAX_GROWTH_FACTOR = 2.0;
+// How large a grid cell visited by a get_nearest traversal can be, relative to its
+// distance from the center. Larger cells are split up before they are visited.
+const double NEAREST_CELL_SIZE_FACTOR = 0.5;
 
-// The desired result size of each nearest batch
-const double NEAREST_GOAL_BATCH_SIZE = 100.0;
-
-// Number of vertices used in get_nearest traversal for approximating the
-// current search range through a polygon.
-const unsigned int NEAREST_NUM_VERTICES = 8;
+// The maximal number of grid cells that a get_nearest traversal visits in one pass
+// over the index.
+const size_t NEAREST_MAX_BATCH_CELLS = 16;
 
 
 geo_job_data_t::geo_job_data_t(
@@ -99,11 +104,14 @@ geo_intersecting_cb_t::geo_intersecting_cb_t(
 }
 
 void geo_intersecting_cb_t::init_query(const ql::datum_t &_query_geometry) {
-    query_geometry = _query_geometry;
-    std::vector<geo::S2CellId> covering(
-        compute_cell_covering(query_geometry, QUERYING_GOAL_GRID_CELLS));
+    query_shape = get_geo_query_shape(_query_geometry, QUERYING_GOAL_GRID_CELLS);
     geo_index_traversal_helper_t::init_query(
-        covering, compute_interior_cell_covering(query_geometry, covering));
+        query_shape->covering, query_shape->interior_covering);
+}
+
+void geo_intersecting_cb_t::init_query_cells(const std::vector<geo::S2CellId> &cells) {
+    query_shape.reset();
+    geo_index_traversal_helper_t::init_query(cells, std::vector<geo::S2CellId>());
 }
 
 continue_bool_t geo_intersecting_cb_t::on_candidate(
@@ -111,7 +119,6 @@ continue_bool_t geo_intersecting_cb_t::on_candidate(
         concurrent_traversal_fifo_enforcer_signal_t waiter,
         bool definitely_intersects_if_point)
         THROWS_ONLY(interrupted_exc_t) {
-    guarantee(query_geometry.has());
     sampler->new_sample();
 
     store_key_t store_key(keyvalue.key());
@@ -152,7 +159,7 @@ continue_bool_t geo_intersecting_cb_t::on_candidate(
 
     try {
         // Post-filter the geometry based on an actual intersection test with
-        // query_geometry.
+        // the query geometry.
         ql::env_t sindex_env(env->interruptor,
                              ql::return_empty_normal_batches_t::NO,
                              sindex.func_reql_version);
@@ -174,9 +181,9 @@ continue_bool_t geo_intersecting_cb_t::on_candidate(
             }
         }
 
-        // TODO (daniel): This is a little inefficient because we re-parse
-        // the query_geometry for each test.
-        if ((definitely_intersects || geo_does_intersect(query_geometry, sindex_val))
+        if ((definitely_intersects
+             || !query_shape
+             || query_shape->geometry.intersects(sindex_val))
             && post_filter(sindex_val, val)) {
             if (distinct_emitted->size() >= env->limits().array_size_limit()) {
                 emit_error(ql::exc_t(ql::base_exc_t::RESOURCE,
@@ -267,136 +274,124 @@ nearest_traversal_state_t::nearest_traversal_state_t(
         uint64_t _max_results,
         double _max_radius,
         const ellipsoid_spec_t &_reference_ellipsoid) :
-    previous_size(0),
-    processed_inradius(0.0),
-    current_inradius(std::min(_max_radius,
-            NEAREST_INITIAL_RADIUS_FRACTION * _reference_ellipsoid.equator_radius())),
+    num_cells_visited(0),
     center(_center),
     max_results(_max_results),
     max_radius(_max_radius),
-    reference_ellipsoid(_reference_ellipsoid) { }
+    reference_ellipsoid(_reference_ellipsoid) {
+    for (int face = 0; face < S2CellId::kNumFaces; ++face) {
+        const S2CellId cell = S2CellId::FromFacePosLevel(face, 0, 0);
+        cell_queue.push(std::make_pair(min_distance(cell), cell));
+    }
+}
 
-continue_bool_t nearest_traversal_state_t::proceed_to_next_batch() {
-    // Estimate the result density based on the previous batch
-    const size_t previous_num_results = distinct_emitted.size() - previous_size;
-    const double previous_area = M_PI *
-        (current_inradius * current_inradius - processed_inradius * processed_inradius);
-    const double previous_density =
-        static_cast<double>(previous_num_results) / previous_area;
-
-    processed_inradius = current_inradius;
-    previous_size = distinct_emitted.size();
-
-    // Adapt the radius based on the density of the previous batch.
-    // Solve for current_inradius: NEAREST_GOAL_BATCH_SIZE =
-    //   M_PI * (current_inradius^2 - processed_inradius^2) * previous_density
-    // <=> current_inradius^2 =
-    //   NEAREST_GOAL_BATCH_SIZE / M_PI / previous_density + processed_inradius^2
-    if (previous_density != 0.0) {
-        current_inradius = sqrt((NEAREST_GOAL_BATCH_SIZE / M_PI / previous_density)
-                                + (processed_inradius * processed_inradius));
-    } else {
-        current_inradius = processed_inradius * NEAREST_MAX_GROWTH_FACTOR;
+double nearest_traversal_state_t::min_distance(const S2CellId &cell) const {
+    /*
+    Note that S2 cells live on a sphere, while our distance metric is defined on
+    an ellipsoid. On an ellipsoid with equator radius a and poles radius b, both
+    radii of curvature are at least b^2/a everywhere, so the distance between two
+    points is at least b^2/a times the angle between them on the unit sphere.
+    */
+    const S2Point s2center =
+        S2LatLng::FromDegrees(center.latitude, center.longitude).ToPoint();
+    const S2Cap cap = S2Cell(cell).GetCapBound();
+    const double angle = S1Angle(s2center, cap.axis()).radians() - cap.angle().radians();
+    const double min_radius = reference_ellipsoid.poles_radius()
+        * reference_ellipsoid.poles_radius() / reference_ellipsoid.equator_radius();
+    return std::max(0.0, angle) * min_radius;
+}
+
+double nearest_traversal_state_t::needed_distance() const {
+    if (nearest_distances.size() < max_results) {
+        return max_radius;
     }
+    return std::min(nearest_distances.top(), max_radius);
+}
 
-    // In addition, put a limit on how fast the radius can grow, so we don't
-    // increase it to ridiculous sizes just to encounter some cluster of results
-    // later.
-    current_inradius =
-        std::min(current_inradius,
-                 std::min(current_inradius * NEAREST_MAX_GROWTH_FACTOR, max_radius));
+continue_bool_t nearest_traversal_state_t::proceed_to_next_batch() {
+    current_cells.clear();
+    while (!cell_queue.empty() && current_cells.size() < NEAREST_MAX_BATCH_CELLS) {
+        // The queue is ordered by distance, so once a cell is too far away to hold
+        // any of the results, all remaining ones are as well.
+        if (cell_queue.top().first > needed_distance()) {
+            break;
+        }
+        const queued_cell_t next = cell_queue.top();
+        cell_queue.pop();
+
+        const double max_cell_angle = NEAREST_CELL_SIZE_FACTOR * std::max(
+            next.first / reference_ellipsoid.equator_radius(),
+            NEAREST_INITIAL_RADIUS_FRACTION);
+        if (!next.second.is_leaf()
+            && S2Cell(next.second).GetCapBound().angle().radians() > max_cell_angle) {
+            for (S2CellId child = next.second.child_begin();
+                 child != next.second.child_end();
+                 child = child.next()) {
+                cell_queue.push(std::make_pair(min_distance(child), child));
+            }
+        } else {
+            current_cells.push_back(next.second);
+        }
+    }
+    num_cells_visited += current_cells.size();
 
-    if (processed_inradius >= max_radius || distinct_emitted.size() >= max_results) {
+    if (current_cells.empty()) {
         return continue_bool_t::ABORT;
     } else {
         return continue_bool_t::CONTINUE;
     }
 }
 
+bool nearest_pairs_less(
+        const std::pair<double, ql::datum_t> &p1,
+        const std::pair<double, ql::datum_t> &p2) {
+    // We only care about the distance, don't compare the actual data.
+    return p1.first < p2.first;
+}
+
+void nearest_traversal_state_t::finish(
+        nearest_geo_read_response_t::result_t *results_out) {
+    guarantee(results_out != NULL);
+    std::sort(results.begin(), results.end(), &nearest_pairs_less);
+    if (results.size() > max_results) {
+        results.resize(max_results);
+    }
+    *results_out = std::move(results);
+}
+
 nearest_traversal_cb_t::nearest_traversal_cb_t(
         btree_slice_t *_slice,
         geo_sindex_data_t &&_sindex,
         ql::env_t *_env,
         nearest_traversal_state_t *_state) :
     geo_intersecting_cb_t(_slice, std::move(_sindex), _env, &_state->distinct_emitted),
+    last_distance(0.0),
     state(_state) {
-    init_query_geometry();
-}
-
-void nearest_traversal_cb_t::init_query_geometry() {
-    /*
-    Note that S2 performs intersection tests on a sphere, while our distance
-    metric is defined on an ellipsoid.
-
-    The following must hold for this to work:
-
-     A polygon constructed through build_polygon_with_exradius_at_most(center, r),
-     must *not* intersect (using spherical geometry) with any point x that has
-     a distance (on any given oblate ellipsoid) dist(center, x) > r.
-
-     Similarly, a polygon constructed through
-     build_polygon_with_inradius_at_least(center, r) must intersect (using
-     spherical geometry) with *every* point x that has a distance (on any given
-     ellipsoid) dist(center, x) <= r.
-
-    There is a unit test in geo_primitives.cc to verify this numerically.
-    */
-
-    try {
-        // 1. Construct a shape with an exradius of no more than state->processed_inradius.
-        //    This is what we don't have to process again.
-        std::vector<lon_lat_line_t> holes;
-        if (state->processed_inradius > 0.0) {
-            holes.push_back(build_polygon_with_exradius_at_most(
-                state->center, state->processed_inradius,
-                NEAREST_NUM_VERTICES, state->reference_ellipsoid));
-        }
-
-        // 2. Construct the outer shell, a shape with an inradius of at least
-        //    state->current_inradius.
-        lon_lat_line_t shell = build_polygon_with_inradius_at_least(
-            state->center, state->current_inradius,
-            NEAREST_NUM_VERTICES, state->reference_ellipsoid);
-
-        ql::datum_t _query_geometry =
-            construct_geo_polygon(shell, holes, ql::configured_limits_t::unlimited);
-        init_query(_query_geometry);
-    } catch (const geo_range_exception_t &e) {
-        // The radius has become too large for constructing the query geometry.
-        // Abort.
-        throw geo_range_exception_t(strprintf(
-            "The distance has become too large for continuing the indexed nearest "
-            "traversal.  Consider specifying a smaller `max_dist` parameter.  "
-            "(%s)", e.what()));
-    } catch (const geo_exception_t &e) {
-        crash("Geo exception thrown while initializing nearest query geometry: %s",
-              e.what());
-    }
+    init_query_cells(state->current_cells);
 }
 
 bool nearest_traversal_cb_t::post_filter(
         const ql::datum_t &sindex_val,
         UNUSED const ql::datum_t &val)
         THROWS_ONLY(interrupted_exc_t, ql::base_exc_t, geo_exception_t) {
-
-    // Filter out results that are outside of the current inradius
     const S2Point s2center =
         S2LatLng::FromDegrees(state->center.latitude, state->center.longitude).ToPoint();
-    const double dist = geodesic_distance(s2center, sindex_val, state->reference_ellipsoid);
-    return dist <= state->current_inradius;
+    last_distance =
+        geodesic_distance(s2center, sindex_val, state->reference_ellipsoid);
+    return last_distance <= state->max_radius;
 }
 
 continue_bool_t nearest_traversal_cb_t::emit_result(
-        ql::datum_t &&sindex_val,
+        UNUSED ql::datum_t &&sindex_val,
         UNUSED store_key_t &&key,
         ql::datum_t &&val)
         THROWS_ONLY(interrupted_exc_t, ql::base_exc_t, geo_exception_t) {
-    // TODO (daniel): Could we avoid re-computing the distance? We have already
-    //   done it in post_filter().
-    const S2Point s2center =
-        S2LatLng::FromDegrees(state->center.latitude, state->center.longitude).ToPoint();
-    const double dist = geodesic_distance(s2center, sindex_val, state->reference_ellipsoid);
-    result_acc.push_back(std::make_pair(dist, std::move(val)));
+    // `on_candidate()` calls this right after `post_filter()` on the same document.
+    state->results.push_back(std::make_pair(last_distance, std::move(val)));
+    state->nearest_distances.push(last_distance);
+    if (state->nearest_distances.size() > state->max_results) {
+        state->nearest_distances.pop();
+    }
 
     return continue_bool_t::CONTINUE;
 }
@@ -407,20 +402,6 @@ void nearest_traversal_cb_t::emit_error(
     error.set(_error);
 }
 
-bool nearest_pairs_less(
-        const std::pair<double, ql::datum_t> &p1,
-        const std::pair<double, ql::datum_t> &p2) {
-    // We only care about the distance, don't compare the actual data.
-    return p1.first < p2.first;
-}
-
-void nearest_traversal_cb_t::finish(
-        nearest_geo_read_response_t *resp_out) {
-    guarantee(resp_out != NULL);
-    if (error) {
-        resp_out->results_or_error = error.get();
-    } else {
-        std::sort(result_acc.begin(), result_acc.end(), &nearest_pairs_less);
-        resp_out->results_or_error = std::move(result_acc);
-    }
+optional<ql::exc_t> nearest_traversal_cb_t::finish() {
+    return error;
 }
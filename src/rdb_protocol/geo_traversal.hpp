@@ -2,6 +2,9 @@
 #ifndef RDB_PROTOCOL_GEO_TRAVERSAL_HPP_
 #define RDB_PROTOCOL_GEO_TRAVERSAL_HPP_
 
+#include <functional>
+#include <memory>
+#include <queue>
 #include <set>
 #include <utility>
 #include <vector>
@@ -89,6 +92,9 @@ public:
     virtual ~geo_intersecting_cb_t() { }
 
     void init_query(const ql::datum_t &_query_geometry);
+    // Instead of testing documents for intersection with a query geometry, hands
+    // every document stored in one of `cells` to `post_filter()`.
+    void init_query_cells(const std::vector<geo::S2CellId> &cells);
 
     continue_bool_t on_candidate(scoped_key_value_t &&keyvalue,
                                  concurrent_traversal_fifo_enforcer_signal_t waiter,
@@ -114,7 +120,8 @@ protected:
 private:
     btree_slice_t *slice;
     geo_sindex_data_t sindex;
-    ql::datum_t query_geometry;
+    // Empty if the query was initialized with `init_query_cells()`.
+    std::shared_ptr<const geo_query_shape_t> query_shape;
 
     ql::env_t *env;
 
@@ -167,6 +174,13 @@ private:
 };
 
 
+/* A `get_nearest` traversal visits the cells of the S2 grid best-first, in order of
+how close they could possibly be to `center`. Cells that are large compared to their
+distance from `center` are split into their children before they are looked at, so
+the cells that do get visited grow with their distance, and every part of the grid is
+visited at most once. Each traversal of the index covers a batch of cells, and we
+stop as soon as no cell left in the queue can hold anything nearer than the
+`max_results` nearest documents found so far. */
 class nearest_traversal_state_t {
 public:
     nearest_traversal_state_t(
@@ -175,18 +189,38 @@ public:
             double _max_radius,
             const ellipsoid_spec_t &_reference_ellipsoid);
 
-    // Modifies the state such that the next batch will be generated the next
-    // time this state is used.
+    // Picks the cells for the next traversal of the index, or returns `ABORT` if
+    // we're done.
     continue_bool_t proceed_to_next_batch();
+
+    // Moves the nearest `max_results` documents found, sorted by increasing
+    // distance, to `*results_out`.
+    void finish(nearest_geo_read_response_t::result_t *results_out);
+
+    size_t cells_in_batch() const { return current_cells.size(); }
+    size_t cells_visited() const { return num_cells_visited; }
+
 private:
     friend class nearest_traversal_cb_t;
 
-    /* State that changes over time */
+    // A lower bound (in meters) for the distance between `center` and any point in
+    // `cell`.
+    double min_distance(const geo::S2CellId &cell) const;
+    // The distance of the `max_results`-th nearest document found so far, or
+    // `max_radius` if we don't have that many yet.
+    double needed_distance() const;
+
+    typedef std::pair<double, geo::S2CellId> queued_cell_t;
+    std::priority_queue<queued_cell_t,
+                        std::vector<queued_cell_t>,
+                        std::greater<queued_cell_t> > cell_queue;
+    std::vector<geo::S2CellId> current_cells;
+    size_t num_cells_visited;
+
     std::set<std::pair<store_key_t, optional<uint64_t> > > distinct_emitted;
-    size_t previous_size;
-    // Which radius around `center` has been previously processed?
-    double processed_inradius;
-    double current_inradius;
+    nearest_geo_read_response_t::result_t results;
+    // The distances of the `max_results` nearest documents found so far (a max-heap)
+    std::priority_queue<double> nearest_distances;
 
     /* Constant data, initialized by the constructor */
     const lon_lat_point_t center;
@@ -195,7 +229,8 @@ private:
     const ellipsoid_spec_t reference_ellipsoid;
 };
 
-// Generates a batch of results, sorted by increasing distance.
+// Collects the documents in the current batch of cells of a `nearest_traversal_state_t`
+// together with their distances.
 class nearest_traversal_cb_t : public geo_intersecting_cb_t {
 public:
     nearest_traversal_cb_t(
@@ -204,7 +239,8 @@ public:
             ql::env_t *_env,
             nearest_traversal_state_t *_state);
 
-    void finish(nearest_geo_read_response_t *resp_out);
+    // Returns the error that stopped the traversal, if any.
+    optional<ql::exc_t> finish();
 
 protected:
     bool post_filter(
@@ -223,11 +259,9 @@ protected:
             THROWS_ONLY(interrupted_exc_t);
 
 private:
-    void init_query_geometry();
-
-    // Accumulate results for the current batch until finish() is called
-    std::vector<std::pair<double, ql::datum_t> > result_acc;
     optional<ql::exc_t> error;
+    // The distance computed by the last call to `post_filter()`, for `emit_result()`
+    double last_distance;
 
     nearest_traversal_state_t *state;
 };
@@ -0,0 +1,62 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/key_load_sampler.hpp"
+
+const uint64_t key_load_sampler_t::SAMPLE_INTERVAL = 16;
+const uint64_t key_load_sampler_t::DECAY_INTERVAL = 4096;
+const size_t key_load_sampler_t::MAX_SAMPLED_KEYS = 1024;
+const int64_t key_load_sampler_t::WRITE_WEIGHT = 4;
+
+key_load_sampler_t::key_load_sampler_t() :
+    ops_until_sample(SAMPLE_INTERVAL),
+    samples_until_decay(DECAY_INTERVAL) { }
+
+void key_load_sampler_t::on_read(const store_key_t &key) {
+    sample(key, 1);
+}
+
+void key_load_sampler_t::on_write(const store_key_t &key) {
+    sample(key, WRITE_WEIGHT);
+}
+
+void key_load_sampler_t::get_loads(
+        const key_range_t &range,
+        std::map<store_key_t, int64_t> *loads_out) const {
+    for (auto it = loads.lower_bound(range.left);
+         it != loads.end() && range.contains_key(it->first);
+         ++it) {
+        (*loads_out)[it->first] += it->second;
+    }
+}
+
+void key_load_sampler_t::sample(const store_key_t &key, int64_t weight) {
+    --ops_until_sample;
+    if (ops_until_sample != 0) {
+        return;
+    }
+    ops_until_sample = SAMPLE_INTERVAL;
+
+    loads[key] += weight;
+
+    --samples_until_decay;
+    if (samples_until_decay == 0) {
+        samples_until_decay = DECAY_INTERVAL;
+        decay();
+    }
+    /* Under uniform load nearly every sample is a new key, so we may have to decay
+    early to stay within our memory budget. That's fine: hot keys survive it, and
+    those are the ones we care about. */
+    while (loads.size() > MAX_SAMPLED_KEYS) {
+        decay();
+    }
+}
+
+void key_load_sampler_t::decay() {
+    for (auto it = loads.begin(); it != loads.end();) {
+        it->second /= 2;
+        if (it->second == 0) {
+            it = loads.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
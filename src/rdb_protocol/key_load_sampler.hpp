@@ -0,0 +1,49 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_KEY_LOAD_SAMPLER_HPP_
+#define RDB_PROTOCOL_KEY_LOAD_SAMPLER_HPP_
+
+#include <map>
+
+#include "btree/keys.hpp"
+
+/* `key_load_sampler_t` keeps a rough record of which primary keys of a store are
+being read and written. The distribution query only reports how many keys each part of
+the table holds, so without this a range that gets a lot of queries but holds few
+documents looks perfectly balanced to `rebalance()`.
+
+We only look at one in every `SAMPLE_INTERVAL` operations, and we halve every load
+once we've taken `DECAY_INTERVAL` samples, so the loads describe recent traffic rather
+than everything that has happened since the server started. Keys that decay to zero
+are dropped, which keeps the map small. */
+class key_load_sampler_t {
+public:
+    key_load_sampler_t();
+
+    void on_read(const store_key_t &key);
+    void on_write(const store_key_t &key);
+
+    /* Adds the sampled load of every key in `range` to `*loads_out`, in units of
+    sampled reads. */
+    void get_loads(
+        const key_range_t &range,
+        std::map<store_key_t, int64_t> *loads_out) const;
+
+private:
+    void sample(const store_key_t &key, int64_t weight);
+    void decay();
+
+    static const uint64_t SAMPLE_INTERVAL;
+    static const uint64_t DECAY_INTERVAL;
+    static const size_t MAX_SAMPLED_KEYS;
+    /* A write costs the primary a lot more than a read does: it has to be replicated,
+    flushed to disk and applied to every secondary index. */
+    static const int64_t WRITE_WEIGHT;
+
+    uint64_t ops_until_sample;
+    uint64_t samples_until_decay;
+    std::map<store_key_t, int64_t> loads;
+
+    DISABLE_COPYING(key_load_sampler_t);
+};
+
+#endif  // RDB_PROTOCOL_KEY_LOAD_SAMPLER_HPP_
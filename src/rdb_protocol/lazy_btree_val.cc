@@ -4,6 +4,7 @@
 #include "containers/archive/buffer_group_stream.hpp"
 #include "containers/archive/versioned.hpp"
 #include "rdb_protocol/blob_wrapper.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
 
 ql::datum_t get_data(const rdb_value_t *value, buf_parent_t parent) {
     // TODO: Just use deserialize_from_blob?
@@ -24,6 +25,15 @@ ql::datum_t get_data(const rdb_value_t *value, buf_parent_t parent) {
     return data;
 }
 
+ql::datum_t get_data_from_page(scoped_key_value_t *keyvalue) {
+    const rdb_value_t *value = static_cast<const rdb_value_t *>(keyvalue->value());
+    if (!value->is_inline()) {
+        return get_data(value, keyvalue->expose_buf());
+    }
+    return ql::datum_deserialize_from_buf(keyvalue->expose_page_copy(),
+                                          value->inline_data_offset());
+}
+
 const ql::datum_t &lazy_btree_val_t::get() const {
     guarantee(pointee.has());
     if (!pointee->ptr.has()) {
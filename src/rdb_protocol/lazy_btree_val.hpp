@@ -2,6 +2,7 @@
 #ifndef RDB_PROTOCOL_LAZY_BTREE_VAL_HPP_
 #define RDB_PROTOCOL_LAZY_BTREE_VAL_HPP_
 
+#include "btree/depth_first_traversal.hpp"
 #include "buffer_cache/alt.hpp"
 #include "buffer_cache/blob.hpp"
 #include "rdb_protocol/datum.hpp"
@@ -18,6 +19,17 @@ public:
         return blob::value_size(contents, blob::btree_maxreflen);
     }
 
+    // True if the serialized value is stored in the leaf node rather than in
+    // separate blob blocks.
+    bool is_inline() const {
+        return blob::is_small(contents, blob::btree_maxreflen);
+    }
+
+    // The offset of the inline serialized value from `contents`.
+    size_t inline_data_offset() const {
+        return blob::small_buffer(contents, blob::btree_maxreflen) - contents;
+    }
+
     const char *value_ref() const {
         return contents;
     }
@@ -30,6 +42,12 @@ public:
 ql::datum_t get_data(const rdb_value_t *value,
                      buf_parent_t parent);
 
+/* Like `get_data()`, but for a value found by a read-only traversal.  If the value is
+stored inline, the datum is built directly on top of the leaf node's shared page copy
+(see `scoped_key_value_t::expose_page_copy()`) instead of being copied into a buffer
+of its own. */
+ql::datum_t get_data_from_page(scoped_key_value_t *keyvalue);
+
 class lazy_btree_val_pointee_t
         : public single_threaded_countable_t<lazy_btree_val_pointee_t> {
     lazy_btree_val_pointee_t(const rdb_value_t *_rdb_value, buf_parent_t _parent)
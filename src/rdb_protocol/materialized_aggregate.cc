@@ -0,0 +1,291 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/materialized_aggregate.hpp"
+
+#include "rdb_protocol/btree.hpp"
+#include "rdb_protocol/func.hpp"
+
+/* Per group, the number of index entries for a `count`, or the sum of the values of
+the field and how many rows had it for a `sum` or `avg`. While the aggregate is being
+built, it only holds the changes of the writes the building read doesn't see, so the
+numbers can be negative. */
+struct group_state_t {
+    group_state_t() : n(0), sum(0) { }
+    int64_t n;
+    double sum;
+};
+
+class materialized_aggregates_t::aggregate_t {
+public:
+    aggregate_t(uint64_t _ticket, optional<datum_string_t> _field)
+        : ticket(_ticket), field(std::move(_field)), ready(false) { }
+
+    /* Returns false if the aggregate has to be dropped, because the write made a
+    query of its shape fail or there are too many groups. */
+    bool apply(const store_key_t &primary_key,
+               const sindex_disk_info_t &sindex_info,
+               const ql::datum_t &row,
+               int64_t sign) {
+        std::vector<std::pair<store_key_t, ql::datum_t> > keys;
+        try {
+            compute_keys(primary_key, row, sindex_info, &keys, nullptr);
+        } catch (const ql::base_exc_t &) {
+            // The row isn't in the index, so it isn't in any group either.
+            return true;
+        }
+        if (keys.empty()) {
+            return true;
+        }
+        guarantee(keys.size() == 1);
+        double value = 0;
+        if (field.has_value()) {
+            ql::datum_t d = row.get_field(*field, ql::NOTHROW);
+            if (!d.has()) {
+                // `sum` and `avg` skip rows without the field.
+                return true;
+            }
+            if (d.get_type() != ql::datum_t::R_NUM) {
+                return false;
+            }
+            value = d.as_num();
+        }
+        group_state_t *group = &groups[keys[0].second];
+        group->n += sign;
+        group->sum += sign * value;
+        if (ready && group->n == 0) {
+            // This also forgets any rounding errors the group's sum picked up.
+            groups.erase(keys[0].second);
+        }
+        return groups.size() <= MAX_GROUPS;
+    }
+
+    void add_built(ql::result_t *built) {
+        if (!field.has_value()) {
+            ql::grouped_t<uint64_t> *counts =
+                boost::get<ql::grouped_t<uint64_t> >(built);
+            guarantee(counts != nullptr);
+            for (auto it = counts->begin(); it != counts->end(); ++it) {
+                groups[it->first].n += it->second;
+            }
+        } else {
+            ql::grouped_t<std::pair<double, uint64_t> > *sums =
+                boost::get<ql::grouped_t<std::pair<double, uint64_t> > >(built);
+            guarantee(sums != nullptr);
+            for (auto it = sums->begin(); it != sums->end(); ++it) {
+                group_state_t *group = &groups[it->first];
+                group->n += it->second.second;
+                group->sum += it->second.first;
+            }
+        }
+        for (auto it = groups.begin(); it != groups.end();) {
+            if (it->second.n == 0) {
+                groups.erase(it++);
+            } else {
+                ++it;
+            }
+        }
+        ready = true;
+    }
+
+    void read(const ql::terminal_variant_t &terminal, ql::result_t *result_out) const {
+        if (boost::get<ql::count_wire_func_t>(&terminal) != nullptr) {
+            ql::grouped_t<uint64_t> counts;
+            for (const auto &pair : groups) {
+                if (pair.second.n > 0) {
+                    counts[pair.first] = pair.second.n;
+                }
+            }
+            *result_out = std::move(counts);
+        } else if (boost::get<ql::sum_wire_func_t>(&terminal) != nullptr) {
+            ql::grouped_t<double> sums;
+            for (const auto &pair : groups) {
+                if (pair.second.n > 0) {
+                    sums[pair.first] = pair.second.sum;
+                }
+            }
+            *result_out = std::move(sums);
+        } else {
+            guarantee(boost::get<ql::avg_wire_func_t>(&terminal) != nullptr);
+            ql::grouped_t<std::pair<double, uint64_t> > avgs;
+            for (const auto &pair : groups) {
+                if (pair.second.n > 0) {
+                    avgs[pair.first] = std::make_pair(pair.second.sum,
+                                                      pair.second.n);
+                }
+            }
+            *result_out = std::move(avgs);
+        }
+    }
+
+    // Writes with tickets up to this one were seen by the read that built this.
+    const uint64_t ticket;
+    // The field that's summed, or none for a `count`
+    const optional<datum_string_t> field;
+    bool ready;
+
+private:
+    std::map<ql::datum_t, group_state_t, optional_datum_less_t> groups;
+
+    DISABLE_COPYING(aggregate_t);
+};
+
+materialized_aggregates_t::materialized_aggregates_t() : last_write_ticket(0) { }
+
+materialized_aggregates_t::~materialized_aggregates_t() { }
+
+// The function a `sum` or `avg` terminal sums, if it has one.
+static counted_t<const ql::func_t> get_summed_func(
+        const ql::terminal_variant_t &terminal) {
+    if (const ql::sum_wire_func_t *sum = boost::get<ql::sum_wire_func_t>(&terminal)) {
+        return sum->compile_wire_func_or_null();
+    } else if (const ql::avg_wire_func_t *avg =
+                   boost::get<ql::avg_wire_func_t>(&terminal)) {
+        return avg->compile_wire_func_or_null();
+    } else {
+        return counted_t<const ql::func_t>();
+    }
+}
+
+optional<std::string> materialized_aggregates_t::aggregate_key(
+        const rget_read_t &rget,
+        const sindex_disk_info_t &sindex_info) {
+    if (rget.stamp.has_value()
+        || !rget.sindex.has_value()
+        || !rget.sindex->datumspec.is_universe()
+        || !rget.sindex->intersect.empty()
+        || (rget.sindex->region.has_value()
+            && rget.sindex->region->inner != key_range_t::universe())
+        || rget.region.inner != key_range_t::universe()
+        || rget.primary_keys.has_value()
+        || !rget.terminal.has_value()
+        || rget.transforms.size() != 1
+        || sindex_info.geo == sindex_geo_bool_t::GEO
+        || sindex_info.multi == sindex_multi_bool_t::MULTI) {
+        return r_nullopt;
+    }
+    const ql::group_wire_func_t *group =
+        boost::get<ql::group_wire_func_t>(&rget.transforms[0]);
+    if (group == nullptr
+        || !group->should_append_index()
+        || group->is_multi()
+        || !group->compile_funcs().empty()) {
+        return r_nullopt;
+    }
+    if (boost::get<ql::count_wire_func_t>(&*rget.terminal) != nullptr) {
+        return make_optional(std::string("count"));
+    }
+    counted_t<const ql::func_t> func = get_summed_func(*rget.terminal);
+    if (!func.has()) {
+        return r_nullopt;
+    }
+    optional<datum_string_t> field = ql::get_selected_field(func);
+    if (!field.has_value()) {
+        return r_nullopt;
+    }
+    return make_optional("field:" + field->to_std());
+}
+
+bool materialized_aggregates_t::read(const uuid_u &sindex_id,
+                                     const std::string &key,
+                                     const ql::terminal_variant_t &terminal,
+                                     ql::result_t *result_out) const {
+    auto sindex_it = aggregates.find(sindex_id);
+    if (sindex_it == aggregates.end()) {
+        return false;
+    }
+    auto it = sindex_it->second.find(key);
+    if (it == sindex_it->second.end() || !it->second->ready) {
+        return false;
+    }
+    it->second->read(terminal, result_out);
+    return true;
+}
+
+bool materialized_aggregates_t::start(const uuid_u &sindex_id,
+                                      const std::string &key,
+                                      const ql::terminal_variant_t &terminal,
+                                      uint64_t ticket,
+                                      ql::terminal_variant_t *build_terminal_out) {
+    std::map<std::string, scoped_ptr_t<aggregate_t> > *sindex_aggregates =
+        &aggregates[sindex_id];
+    if (sindex_aggregates->count(key) != 0
+        || sindex_aggregates->size() >= MAX_AGGREGATES_PER_SINDEX) {
+        return false;
+    }
+    counted_t<const ql::func_t> func = get_summed_func(terminal);
+    optional<datum_string_t> field;
+    if (func.has()) {
+        field = ql::get_selected_field(func);
+        guarantee(field.has_value());
+        // `avg` gives us both the sums and how many rows had the field.
+        *build_terminal_out = ql::avg_wire_func_t(ql::backtrace_id_t::empty(), func);
+    } else {
+        *build_terminal_out = ql::count_wire_func_t();
+    }
+    (*sindex_aggregates)[key] = make_scoped<aggregate_t>(ticket, std::move(field));
+    return true;
+}
+
+bool materialized_aggregates_t::finish(const uuid_u &sindex_id,
+                                       const std::string &key,
+                                       ql::result_t *built) {
+    auto sindex_it = aggregates.find(sindex_id);
+    if (sindex_it == aggregates.end()) {
+        return false;
+    }
+    auto it = sindex_it->second.find(key);
+    if (it == sindex_it->second.end()) {
+        return false;
+    }
+    guarantee(!it->second->ready);
+    if (boost::get<ql::exc_t>(built) != nullptr) {
+        sindex_it->second.erase(it);
+        return false;
+    }
+    it->second->add_built(built);
+    return true;
+}
+
+void materialized_aggregates_t::abandon(const uuid_u &sindex_id,
+                                        const std::string &key) {
+    auto sindex_it = aggregates.find(sindex_id);
+    if (sindex_it != aggregates.end()) {
+        sindex_it->second.erase(key);
+    }
+}
+
+void materialized_aggregates_t::apply(const uuid_u &sindex_id,
+                                      uint64_t ticket,
+                                      const sindex_disk_info_t &sindex_info,
+                                      const rdb_modification_report_t &modification) {
+    auto sindex_it = aggregates.find(sindex_id);
+    if (sindex_it == aggregates.end()) {
+        return;
+    }
+    const rdb_modification_info_t &info = modification.info;
+    for (auto it = sindex_it->second.begin(); it != sindex_it->second.end();) {
+        aggregate_t *aggregate = it->second.get();
+        bool ok = true;
+        if (ticket > aggregate->ticket) {
+            if (info.deleted.first.has()) {
+                ok = aggregate->apply(modification.primary_key, sindex_info,
+                                      info.deleted.first, -1);
+            }
+            if (ok && info.added.first.has()) {
+                ok = aggregate->apply(modification.primary_key, sindex_info,
+                                      info.added.first, 1);
+            }
+        }
+        if (ok) {
+            ++it;
+        } else {
+            // A query of this shape fails now, or there are too many groups to
+            // keep. If the building read is still running, `finish()` won't find
+            // the aggregate.
+            sindex_it->second.erase(it++);
+        }
+    }
+}
+
+void materialized_aggregates_t::drop_sindex(const uuid_u &sindex_id) {
+    aggregates.erase(sindex_id);
+}
@@ -0,0 +1,99 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_MATERIALIZED_AGGREGATE_HPP_
+#define RDB_PROTOCOL_MATERIALIZED_AGGREGATE_HPP_
+
+#include <map>
+#include <string>
+
+#include "containers/optional.hpp"
+#include "containers/scoped.hpp"
+#include "containers/uuid.hpp"
+#include "rdb_protocol/protocol.hpp"
+
+struct rdb_modification_report_t;
+struct sindex_disk_info_t;
+
+/* A store keeps the results of `group({index: ...})` followed by `count`, `sum` or
+`avg` over its whole range, once such a query has run, and updates them on every write
+from the same modification reports that update the secondary index. Later queries of
+the same shape are answered from them in time proportional to the number of groups,
+instead of reading every entry of the index.
+
+A materialized aggregate starts out empty when the first query of its shape acquires
+the index, and from then on every write that updates the index adds its changes to it.
+The query then reads the index as it was when it acquired it and adds that in too.
+Writes take a ticket when they get in line for an index, in the same order as the
+query's acquisition, so that each write is counted by exactly one of the two.
+
+The aggregates live in memory only, and are built again by the first query of their
+shape after a restart. */
+class materialized_aggregates_t {
+public:
+    materialized_aggregates_t();
+    ~materialized_aggregates_t();
+
+    /* Returns which materialized aggregate can answer `rget`, if any. That's the case
+    for a read of the whole of a non-geo, non-multi index in a store that covers the
+    whole key range, that groups by the index value and has a `count`, or a `sum` or
+    `avg` of a field (`sum('price')`). A `sum` and an `avg` of the same field share
+    an aggregate. */
+    static optional<std::string> aggregate_key(const rget_read_t &rget,
+                                               const sindex_disk_info_t &sindex_info);
+
+    /* Every write that acquires an index to update it takes a ticket, right when it
+    gets in line for the index's superblock. */
+    uint64_t take_write_ticket() { return ++last_write_ticket; }
+    /* The ticket of the most recent write to get in line for any index. A read that
+    takes this right when it gets in line itself sees the writes up to this ticket. */
+    uint64_t current_write_ticket() const { return last_write_ticket; }
+
+    /* Answers `terminal` from the materialized aggregate `key` of the index. Returns
+    false if there's no such aggregate or it's still being built. */
+    bool read(const uuid_u &sindex_id,
+              const std::string &key,
+              const ql::terminal_variant_t &terminal,
+              ql::result_t *result_out) const;
+
+    /* Starts materializing the aggregate `key`, counting the writes with tickets
+    after `ticket`, and sets `*build_terminal_out` to the terminal to read the index
+    with in place of `terminal`. Returns false if the aggregate exists already or the
+    index has as many as it may have. */
+    bool start(const uuid_u &sindex_id,
+               const std::string &key,
+               const ql::terminal_variant_t &terminal,
+               uint64_t ticket,
+               ql::terminal_variant_t *build_terminal_out);
+
+    /* Adds the result of the read with the terminal from `start()`. Returns false,
+    and drops the aggregate, if the read failed or the aggregate was dropped in the
+    meantime. */
+    bool finish(const uuid_u &sindex_id,
+                const std::string &key,
+                ql::result_t *built);
+
+    /* For a read from `start()` that didn't get to `finish()`. */
+    void abandon(const uuid_u &sindex_id, const std::string &key);
+
+    /* Called with the index's superblock held for writing, by the write with ticket
+    `ticket`. */
+    void apply(const uuid_u &sindex_id,
+               uint64_t ticket,
+               const sindex_disk_info_t &sindex_info,
+               const rdb_modification_report_t &modification);
+
+    void drop_sindex(const uuid_u &sindex_id);
+
+private:
+    class aggregate_t;
+
+    /* Past these, an aggregate is dropped (or not started). */
+    static const size_t MAX_GROUPS = 100000;
+    static const size_t MAX_AGGREGATES_PER_SINDEX = 8;
+
+    uint64_t last_write_ticket;
+    std::map<uuid_u, std::map<std::string, scoped_ptr_t<aggregate_t> > > aggregates;
+
+    DISABLE_COPYING(materialized_aggregates_t);
+};
+
+#endif  // RDB_PROTOCOL_MATERIALIZED_AGGREGATE_HPP_
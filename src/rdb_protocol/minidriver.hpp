@@ -51,7 +51,9 @@ public:
         FUNC_EQCOMPARISON,
         FUNC_PAGE,
         DISTINCT_ROW,
-        REPLACE_HELPER_ROW
+        REPLACE_HELPER_ROW,
+        PARTIAL_INDEX_ROW,
+        EXPIRY_ROW
     };
 
     /** reql_t
@@ -55,6 +55,7 @@ static const std::set<std::string> acceptable_optargs({
     "durability",
     "emergency_repair",
     "emit",
+    "explain",
     "fill",
     "final_emit",
     "first_batch_scaledown_factor",
@@ -67,6 +68,7 @@ static const std::set<std::string> acceptable_optargs({
     "ignore_write_hook",
     "include_initial",
     "include_offsets",
+    "include_positions",
     "include_states",
     "include_types",
     "index",
@@ -78,6 +80,7 @@ static const std::set<std::string> acceptable_optargs({
     "max_batch_seconds",
     "max_dist",
     "max_results",
+    "max_staleness",
     "method",
     "min_batch_rows",
     "multi",
@@ -91,11 +94,13 @@ static const std::set<std::string> acceptable_optargs({
     "params",
     "primary_key",
     "primary_replica_tag",
+    "priority",
     "profile",
     "read_mode",
     "redirects",
     "replicas",
     "result_format",
+    "resume_from",
     "return_changes",
     "return_vals",
     "right_bound",
@@ -103,6 +108,7 @@ static const std::set<std::string> acceptable_optargs({
     "squash",
     "time_format",
     "timeout",
+    "traceparent",
     "unit",
     "use_outdated", // Only so we can detect it and error.
     "verify",
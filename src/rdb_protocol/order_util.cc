@@ -1,8 +1,10 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "rdb_protocol/order_util.hpp"
 
+#include <algorithm>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "rdb_protocol/datum_stream.hpp"
 #include "rdb_protocol/error.hpp"
@@ -94,6 +96,34 @@ build_comparisons_from_optional_terms(const term_t *target,
 lt_cmp_t::lt_cmp_t(std::vector<std::pair<order_direction_t, counted_t<const func_t> > > _comparisons)
             : comparisons(std::move(_comparisons)) { }
 
+namespace {
+
+datum_t sort_key(env_t *env, const func_t *f, const datum_t &row) {
+    try {
+        return f->call(env, row)->as_datum();
+    } catch (const base_exc_t &e) {
+        if (e.get_type() != base_exc_t::NON_EXISTENCE) {
+            throw;
+        }
+        return datum_t();
+    }
+}
+
+// Missing keys sort before everything else, and `DESC` reverses the order.
+int cmp_sort_keys(order_direction_t direction, const datum_t &l, const datum_t &r) {
+    int res;
+    if (!l.has()) {
+        res = r.has() ? -1 : 0;
+    } else if (!r.has()) {
+        res = 1;
+    } else {
+        res = l.cmp(r);
+    }
+    return direction == DESC ? -res : res;
+}
+
+}  // namespace
+
 bool lt_cmp_t::operator()(env_t *env,
                           profile::sampler_t *sampler,
                           datum_t l,
@@ -104,41 +134,73 @@ bool lt_cmp_t::operator()(env_t *env,
     }
 
     for (auto it = comparisons.begin(); it != comparisons.end(); ++it) {
-        datum_t lval;
-        datum_t rval;
-        try {
-            lval = it->second->call(env, l)->as_datum();
-        } catch (const base_exc_t &e) {
-            if (e.get_type() != base_exc_t::NON_EXISTENCE) {
-                throw;
-            }
+        datum_t lval = sort_key(env, it->second.get(), l);
+        datum_t rval = sort_key(env, it->second.get(), r);
+        int cmp_res = cmp_sort_keys(it->first, lval, rval);
+        if (cmp_res != 0) {
+            return cmp_res < 0;
         }
+    }
 
-        try {
-            rval = it->second->call(env, r)->as_datum();
-        } catch (const base_exc_t &e) {
-            if (e.get_type() != base_exc_t::NON_EXISTENCE) {
-                throw;
-            }
-        }
+    return false;
+}
 
-        if (!lval.has() && !rval.has()) {
-            continue;
-        }
-        if (!lval.has()) {
-            return true != (it->first == DESC);
-        }
-        if (!rval.has()) {
-            return false != (it->first == DESC);
+std::vector<datum_t> lt_cmp_t::keys(env_t *env, const datum_t &row) const {
+    std::vector<datum_t> ret;
+    ret.reserve(comparisons.size());
+    for (const auto &comparison : comparisons) {
+        ret.push_back(sort_key(env, comparison.second.get(), row));
+    }
+    return ret;
+}
+
+bool lt_cmp_t::keys_lt(profile::sampler_t *sampler,
+                       const datum_t *l_keys,
+                       const datum_t *r_keys) const {
+    if (sampler != nullptr) {
+        sampler->new_sample();
+    }
+
+    for (size_t i = 0; i < comparisons.size(); ++i) {
+        int cmp_res = cmp_sort_keys(comparisons[i].first, l_keys[i], r_keys[i]);
+        if (cmp_res != 0) {
+            return cmp_res < 0;
         }
-        int cmp_res = lval.cmp(rval);
-        if (cmp_res == 0) {
-            continue;
+    }
+    return false;
+}
+
+void lt_cmp_t::sort(env_t *env,
+                    profile::sampler_t *sampler,
+                    std::vector<datum_t> *rows) const {
+    const size_t num_keys = comparisons.size();
+    if (rows->size() < 2 || num_keys == 0) {
+        return;
+    }
+
+    // The keys of row `i` are `all_keys[i * num_keys]` up to `(i + 1) * num_keys`.
+    std::vector<datum_t> all_keys;
+    all_keys.reserve(rows->size() * num_keys);
+    for (const datum_t &row : *rows) {
+        for (const auto &comparison : comparisons) {
+            all_keys.push_back(sort_key(env, comparison.second.get(), row));
         }
-        return (cmp_res < 0) != (it->first == DESC);
     }
 
-    return false;
+    std::vector<size_t> order(rows->size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return keys_lt(sampler, &all_keys[a * num_keys], &all_keys[b * num_keys]);
+    });
+
+    std::vector<datum_t> sorted;
+    sorted.reserve(rows->size());
+    for (size_t i : order) {
+        sorted.push_back(std::move((*rows)[i]));
+    }
+    *rows = std::move(sorted);
 }
 
 } // namespace ql
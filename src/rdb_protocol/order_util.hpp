@@ -5,6 +5,7 @@
 
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "errors.hpp"
 
@@ -54,6 +55,20 @@ public:
                     datum_t l,
                     datum_t r) const;
 
+    // The results of the comparison functions for `row`. A result is empty if the
+    // function looked for a field that the row doesn't have.
+    std::vector<datum_t> keys(env_t *env, const datum_t &row) const;
+    // Compares rows by their `keys`, without calling the comparison functions again.
+    bool keys_lt(profile::sampler_t *sampler,
+                 const datum_t *l_keys,
+                 const datum_t *r_keys) const;
+
+    // Sorts `rows` the way `std::stable_sort` with this comparison would, but calls
+    // the comparison functions once per row, rather than twice per comparison.
+    void sort(env_t *env,
+              profile::sampler_t *sampler,
+              std::vector<datum_t> *rows) const;
+
 private:
     const std::vector<std::pair<order_direction_t, counted_t<const func_t> > >
         comparisons;
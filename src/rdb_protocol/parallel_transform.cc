@@ -0,0 +1,184 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/parallel_transform.hpp"
+
+#include <algorithm>
+
+#include "concurrency/cond_var.hpp"
+#include "concurrency/spread_across_threads.hpp"
+#include "containers/archive/boost_types.hpp"
+#include "containers/archive/vector_stream.hpp"
+#include "do_on_thread.hpp"
+#include "math.hpp"
+#include "rdb_protocol/env.hpp"
+#include "rdb_protocol/protocol.hpp"
+
+namespace ql {
+
+namespace {
+
+void serialize_rows(const datums_t *begin,
+                    const datums_t *end,
+                    std::vector<char> *out) {
+    write_message_t wm;
+    serialize<cluster_version_t::CLUSTER>(&wm, static_cast<uint64_t>(end - begin));
+    for (const datums_t *it = begin; it != end; ++it) {
+        serialize<cluster_version_t::CLUSTER>(&wm, *it);
+    }
+    vector_stream_t stream;
+    int res = send_write_message(&stream, &wm);
+    guarantee(res == 0);
+    stream.swap(out);
+}
+
+// Appends the rows in `serialized` to `out`.
+void deserialize_rows(std::vector<char> &&serialized, std::vector<datums_t> *out) {
+    vector_read_stream_t stream(std::move(serialized));
+    uint64_t count;
+    archive_result_t res = deserialize<cluster_version_t::CLUSTER>(&stream, &count);
+    guarantee_deserialization(res, "parallel transform row count");
+    out->reserve(out->size() + count);
+    for (uint64_t i = 0; i < count; ++i) {
+        out->emplace_back();
+        res = deserialize<cluster_version_t::CLUSTER>(&stream, &out->back());
+        guarantee_deserialization(res, "parallel transform rows");
+    }
+}
+
+bool is_stateless(const transform_variant_t &t) {
+    return boost::get<map_wire_func_t>(&t) != nullptr
+        || boost::get<filter_wire_func_t>(&t) != nullptr
+        || boost::get<concatmap_wire_func_t>(&t) != nullptr
+        || boost::get<zip_wire_func_t>(&t) != nullptr;
+}
+
+}  // namespace
+
+class parallel_transformer_t::worker_t {
+public:
+    worker_t(rdb_context_t *rdb_ctx, std::vector<char> serialized_job) {
+        vector_read_stream_t stream(std::move(serialized_job));
+        serializable_env_t s_env;
+        archive_result_t res = deserialize<cluster_version_t::CLUSTER>(&stream, &s_env);
+        guarantee_deserialization(res, "parallel transform environment");
+        std::vector<transform_variant_t> transforms;
+        res = deserialize<cluster_version_t::CLUSTER>(&stream, &transforms);
+        guarantee_deserialization(res, "parallel transforms");
+
+        env.init(new env_t(rdb_ctx,
+                           return_empty_normal_batches_t::NO,
+                           &non_interruptor,
+                           std::move(s_env),
+                           nullptr));
+        for (const auto &t : transforms) {
+            ops.push_back(make_op(t));
+        }
+    }
+
+    void transform(std::vector<datums_t> *rows) {
+        for (auto &&row : *rows) {
+            groups_t data = {{datum_t(), std::move(row)}};
+            for (auto &&op : ops) {
+                (*op)(env.get(), &data, []() { return datum_t(); });
+            }
+            row = data.empty() ? datums_t() : std::move(data.begin()->second);
+        }
+    }
+
+private:
+    // A round only has `PARALLEL_TRANSFORM_ROWS_PER_THREAD` rows, so the workers
+    // don't bother with the query's interruptor; the shard checks it between rounds.
+    cond_t non_interruptor;
+    scoped_ptr_t<env_t> env;
+    std::vector<scoped_ptr_t<op_t> > ops;
+};
+
+scoped_ptr_t<parallel_transformer_t> parallel_transformer_t::make(
+        env_t *env, const std::vector<transform_variant_t> &transforms) {
+    if (transforms.empty()
+        || get_num_db_threads() < 2
+        || env->get_rdb_ctx() == nullptr) {
+        return scoped_ptr_t<parallel_transformer_t>();
+    }
+    for (const auto &t : transforms) {
+        if (!is_stateless(t)) {
+            return scoped_ptr_t<parallel_transformer_t>();
+        }
+    }
+    return scoped_ptr_t<parallel_transformer_t>(
+        new parallel_transformer_t(env, transforms));
+}
+
+parallel_transformer_t::parallel_transformer_t(
+        env_t *env, const std::vector<transform_variant_t> &transforms)
+    : rdb_ctx(env->get_rdb_ctx()),
+      rows_timed(0),
+      nanos_timed(0),
+      workers(get_num_threads(), nullptr) {
+    write_message_t wm;
+    serialize<cluster_version_t::CLUSTER>(&wm, env->get_serializable_env());
+    serialize<cluster_version_t::CLUSTER>(&wm, transforms);
+    vector_stream_t stream;
+    int res = send_write_message(&stream, &wm);
+    guarantee(res == 0);
+    stream.swap(&serialized_job);
+}
+
+parallel_transformer_t::~parallel_transformer_t() {
+    for (size_t i = 0; i < workers.size(); ++i) {
+        if (workers[i] != nullptr) {
+            worker_t *worker = workers[i];
+            do_on_thread(threadnum_t(i), [worker]() { delete worker; });
+        }
+    }
+}
+
+bool parallel_transformer_t::is_active() const {
+    return rows_timed >= PARALLEL_TRANSFORM_SAMPLE_ROWS
+        && nanos_timed / static_cast<int64_t>(rows_timed)
+           >= PARALLEL_TRANSFORM_MIN_ROW_NANOS;
+}
+
+void parallel_transformer_t::note_inline_row(ticks_t duration) {
+    if (rows_timed < PARALLEL_TRANSFORM_SAMPLE_ROWS) {
+        ++rows_timed;
+        nanos_timed += duration.nanos;
+    }
+}
+
+size_t parallel_transformer_t::batch_rows() const {
+    return PARALLEL_TRANSFORM_ROWS_PER_THREAD * get_num_db_threads();
+}
+
+void parallel_transformer_t::transform(std::vector<datums_t> *rows) {
+    const size_t num_chunks = ceil_divide(rows->size(),
+                                          PARALLEL_TRANSFORM_ROWS_PER_THREAD);
+    std::vector<std::vector<char> > chunks(num_chunks);
+    for (size_t i = 0; i < num_chunks; ++i) {
+        size_t begin = i * PARALLEL_TRANSFORM_ROWS_PER_THREAD;
+        size_t end = std::min(begin + PARALLEL_TRANSFORM_ROWS_PER_THREAD, rows->size());
+        serialize_rows(rows->data() + begin, rows->data() + end, &chunks[i]);
+    }
+    rows->clear();
+
+    spread_across_threads(num_chunks, get_num_db_threads(), [&](size_t i) {
+        std::vector<datums_t> chunk;
+        deserialize_rows(std::move(chunks[i]), &chunk);
+        get_worker()->transform(&chunk);
+        serialize_rows(chunk.data(), chunk.data() + chunk.size(), &chunks[i]);
+    });
+
+    for (size_t i = 0; i < num_chunks; ++i) {
+        deserialize_rows(std::move(chunks[i]), rows);
+    }
+}
+
+parallel_transformer_t::worker_t *parallel_transformer_t::get_worker() {
+    // Only this thread ever touches its own slot.
+    worker_t **worker = &workers[get_thread_id().threadnum];
+    if (*worker == nullptr) {
+        *worker = new worker_t(rdb_ctx, serialized_job);
+    }
+    return *worker;
+}
+
+}  // namespace ql
@@ -0,0 +1,80 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_PARALLEL_TRANSFORM_HPP_
+#define RDB_PROTOCOL_PARALLEL_TRANSFORM_HPP_
+
+#include <vector>
+
+#include "config/args.hpp"
+#include "containers/scoped.hpp"
+#include "rdb_protocol/shards.hpp"
+#include "time.hpp"
+
+class rdb_context_t;
+
+namespace ql {
+
+class env_t;
+
+// Rows are transformed inline until we've timed this many of them, and only handed
+// to other threads if they took at least `PARALLEL_TRANSFORM_MIN_ROW_NANOS` each on
+// average. Cheaper transformations wouldn't make up for copying the rows around.
+const size_t PARALLEL_TRANSFORM_SAMPLE_ROWS = 16;
+const int64_t PARALLEL_TRANSFORM_MIN_ROW_NANOS = 20 * THOUSAND;
+// How many rows each thread gets per round.
+const size_t PARALLEL_TRANSFORM_ROWS_PER_THREAD = 16;
+
+/* Runs the transformations of a range read on all of the threads instead of only on
+the one the shard lives on. That only works for transformations which look at one row
+at a time and don't keep any state between rows (`map`, `filter`, `concat_map` and
+`zip`), so that it doesn't matter in which order or on which thread each row gets
+transformed.
+
+Nothing the query is made of can be shared across threads, so the transformations
+and the query's serializable environment are serialized once and then compiled
+separately on every thread that ends up running them. The rows make the same round
+trip for every batch. */
+class parallel_transformer_t {
+public:
+    // Returns an empty pointer if `transforms` can't be run in parallel (or there's
+    // nowhere to run them).
+    static scoped_ptr_t<parallel_transformer_t> make(
+        env_t *env, const std::vector<transform_variant_t> &transforms);
+    ~parallel_transformer_t();
+
+    // Whether the rows we've timed so far are expensive enough to transform them in
+    // parallel.
+    bool is_active() const;
+    void note_inline_row(ticks_t duration);
+
+    // How many rows to collect before calling `transform`
+    size_t batch_rows() const;
+
+    // Transforms every element of `rows` as if it were a separate group. Throws
+    // whatever the transformations throw.
+    void transform(std::vector<datums_t> *rows);
+
+private:
+    class worker_t;
+
+    parallel_transformer_t(env_t *env,
+                           const std::vector<transform_variant_t> &transforms);
+
+    worker_t *get_worker();
+
+    rdb_context_t *rdb_ctx;
+    // The serialized `serializable_env_t` followed by the transformations
+    std::vector<char> serialized_job;
+
+    size_t rows_timed;
+    int64_t nanos_timed;
+
+    // Indexed by thread number. Every worker is only used on (and destroyed on) its
+    // own thread.
+    std::vector<worker_t *> workers;
+
+    DISABLE_COPYING(parallel_transformer_t);
+};
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_PARALLEL_TRANSFORM_HPP_
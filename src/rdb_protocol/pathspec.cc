@@ -140,6 +140,37 @@ void pathspec_t::init_from(const pathspec_t &other) {
 }
 
 
+void project_helper(datum_object_builder_t *res,
+                    const datum_t &datum,
+                    const pathspec_t &pathspec,
+                    const configured_limits_t &limits) {
+    if (const datum_string_t *str = pathspec.as_str()) {
+        const datum_t val = datum.get_field(*str, NOTHROW);
+        if (val.has()) {
+            res->overwrite(*str, val);
+        }
+    } else if (const std::vector<pathspec_t> *vec = pathspec.as_vec()) {
+        for (auto it = vec->begin(); it != vec->end(); ++it) {
+            project_helper(res, datum, *it, limits);
+        }
+    } else if (const std::map<datum_string_t, pathspec_t> *map = pathspec.as_map()) {
+        for (auto it = map->begin(); it != map->end(); ++it) {
+            const datum_t val = datum.get_field(it->first, NOTHROW);
+            if (val.has()) {
+                try {
+                    datum_t sub_result =
+                        project(val, it->second, RECURSE, limits);
+                    res->overwrite(it->first, sub_result);
+                } catch (const datum_exc_t &e) {
+                    // do nothing
+                }
+            }
+        }
+    } else {
+        unreachable();
+    }
+}
+
 /* Limit the datum to only the paths specified by the pathspec. */
 datum_t project(datum_t datum,
                 const pathspec_t &pathspec, recurse_flag_t recurse,
@@ -152,37 +183,10 @@ datum_t project(datum_t datum,
         }
         return std::move(res).to_datum();
     } else {
+        // All the paths are added to the one builder, rather than projecting each
+        // of them into an object of its own and copying the fields over.
         datum_object_builder_t res;
-        if (pathspec.as_str() != NULL) {
-            datum_string_t str(*pathspec.as_str());
-            const datum_t val = datum.get_field(str, NOTHROW);
-            if (val.has()) {
-                res.overwrite(std::move(str), val);
-            }
-        } else if (const std::vector<pathspec_t> *vec = pathspec.as_vec()) {
-            for (auto it = vec->begin(); it != vec->end(); ++it) {
-                datum_t sub_result = project(datum, *it, recurse, limits);
-                for (size_t i = 0; i < sub_result.obj_size(); ++i) {
-                    auto pair = sub_result.get_pair(i);
-                    res.overwrite(pair.first, pair.second);
-                }
-            }
-        } else if (const std::map<datum_string_t, pathspec_t> *map = pathspec.as_map()) {
-            for (auto it = map->begin(); it != map->end(); ++it) {
-                const datum_t val = datum.get_field(it->first, NOTHROW);
-                if (val.has()) {
-                    try {
-                        datum_t sub_result =
-                            project(val, it->second, RECURSE, limits);
-                        res.overwrite(it->first, sub_result);
-                    } catch (const datum_exc_t &e) {
-                        // do nothing
-                    }
-                }
-            }
-        } else {
-            unreachable();
-        }
+        project_helper(&res, datum, pathspec, limits);
         return std::move(res).to_datum();
     }
 }
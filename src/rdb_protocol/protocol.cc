@@ -4,12 +4,14 @@
 #include <algorithm>
 #include <functional>
 
+#include "random.hpp"
 #include "stl_utils.hpp"
 
 #include "btree/operations.hpp"
 #include "btree/reql_specific.hpp"
 #include "concurrency/cross_thread_signal.hpp"
 #include "concurrency/cross_thread_watchable.hpp"
+#include "config/args.hpp"
 #include "containers/archive/boost_types.hpp"
 #include "containers/archive/optional.hpp"
 #include "containers/disk_backed_queue.hpp"
@@ -27,6 +29,15 @@ store_key_t key_max(sorting_t sorting) {
     return !reversed(sorting) ? store_key_t::max() : store_key_t::min();
 }
 
+int query_coro_priority(query_priority_t priority) {
+    switch (priority) {
+    case query_priority_t::LOW: return CORO_PRIORITY_LOW_PRIORITY_QUERY;
+    case query_priority_t::NORMAL: return MESSAGE_SCHEDULER_DEFAULT_PRIORITY;
+    case query_priority_t::HIGH: return CORO_PRIORITY_HIGH_PRIORITY_QUERY;
+    default: unreachable();
+    }
+}
+
 namespace rdb_protocol {
 
 void post_construct_and_drain_queue(
@@ -252,8 +263,7 @@ void post_construct_and_drain_queue(
             // Pretend that the indexes in `sindexes` have been post-constructed up to
             // the new range. This is important to make the call to
             // `rdb_update_sindexes()` below actually update the indexes.
-            // We use the same trick in the `post_construct_traversal_helper_t`.
-            // TODO: Avoid this hackery (here and in `post_construct_traversal_helper_t`)
+            // TODO: Avoid this hackery
             for (auto &&access : sindexes) {
                 access->sindex.needs_post_construction_range = *construction_range_inout;
             }
@@ -482,6 +492,10 @@ struct rdb_r_get_region_visitor : public boost::static_visitor<region_t> {
     region_t operator()(const dummy_read_t &d) const {
         return d.region;
     }
+
+    region_t operator()(const sample_read_t &s) const {
+        return s.region;
+    }
 };
 
 region_t read_t::get_region() const THROWS_NOTHING {
@@ -642,6 +656,10 @@ struct rdb_r_shard_visitor_t : public boost::static_visitor<bool> {
         return rangey_read(d);
     }
 
+    bool operator()(const sample_read_t &s) const {
+        return rangey_read(s);
+    }
+
     region_t region;
     read_t::variant_t *payload_out;
 };
@@ -651,6 +669,8 @@ bool read_t::shard(const hash_region_t<key_range_t> &region,
     read_t::variant_t payload;
     bool result = boost::apply_visitor(rdb_r_shard_visitor_t(&region, &payload), read);
     *read_out = read_t(payload, profile, read_mode);
+    read_out->max_staleness_ms = max_staleness_ms;
+    read_out->priority = priority;
     return result;
 }
 
@@ -709,6 +729,7 @@ public:
     void operator()(const changefeed_stamp_t &);
     void operator()(const changefeed_point_stamp_t &);
     void operator()(const dummy_read_t &);
+    void operator()(const sample_read_t &);
 
 private:
     // Shared by rget_read_t and intersecting_geo_read_t operators
@@ -970,6 +991,13 @@ void rdb_r_unshard_visitor_t::operator()(const distribution_read_t &dg) {
     std::sort(results.begin(), results.end(), distribution_read_response_less_t());
 
     distribution_read_response_t res;
+    /* Unlike the key counts, the loads were actually observed rather than estimated,
+    so every shard's loads count in full. */
+    for (const distribution_read_response_t &result : results) {
+        for (const auto &pair : result.key_loads) {
+            res.key_loads[pair.first] += pair.second;
+        }
+    }
     size_t i = 0;
     while (i < results.size()) {
         // Find the largest hash shard for this key range
@@ -1028,6 +1056,57 @@ void rdb_r_unshard_visitor_t::operator()(const dummy_read_t &) {
     *response_out = responses[0];
 }
 
+void rdb_r_unshard_visitor_t::operator()(const sample_read_t &s) {
+    sample_read_response_t res;
+    res.complete = true;
+    std::vector<sample_read_response_t *> results(count);
+    for (size_t i = 0; i < count; ++i) {
+        results[i] = boost::get<sample_read_response_t>(&responses[i].response);
+        guarantee(results[i] != nullptr, "Bad boost::get\n");
+        res.population += results[i]->population;
+        res.complete = res.complete && results[i]->complete;
+    }
+
+    if (res.complete) {
+        /* Each shard's rows are a uniform sample of that shard, so we take the next
+        row from a shard with a probability proportional to how many of its rows we
+        haven't taken yet. That makes the combined rows a uniform sample of all of
+        the shards. */
+        std::vector<size_t> taken(count, 0);
+        std::vector<double> remaining(count);
+        for (size_t i = 0; i < count; ++i) {
+            remaining[i] = results[i]->population;
+        }
+        while (res.rows.size() < s.num) {
+            double total = 0;
+            size_t last = count;
+            for (size_t i = 0; i < count; ++i) {
+                if (taken[i] < results[i]->rows.size()) {
+                    total += remaining[i];
+                    last = i;
+                }
+            }
+            if (last == count) {
+                break;
+            }
+            double choice = randdouble() * total;
+            size_t i = 0;
+            for (;; ++i) {
+                if (taken[i] < results[i]->rows.size()) {
+                    if (i == last || choice < remaining[i]) {
+                        break;
+                    }
+                    choice -= remaining[i];
+                }
+            }
+            res.rows.push_back(std::move(results[i]->rows[taken[i]++]));
+            remaining[i] = std::max(remaining[i] - 1.0, 0.0);
+        }
+    }
+
+    response_out->response = std::move(res);
+}
+
 void read_t::unshard(read_response_t *responses, size_t count,
                      read_response_t *response_out, rdb_context_t *ctx,
                      signal_t *interruptor) const
@@ -1076,6 +1155,7 @@ struct use_snapshot_visitor_t : public boost::static_visitor<bool> {
     bool operator()(const changefeed_stamp_t &) const {           return false; }
     bool operator()(const changefeed_point_stamp_t &) const {     return false; }
     bool operator()(const distribution_read_t &) const {          return true;  }
+    bool operator()(const sample_read_t &) const {                return true;  }
 };
 
 // Only use snapshotting if we're doing a range get.
@@ -1101,6 +1181,7 @@ struct route_to_primary_visitor_t : public boost::static_visitor<bool> {
     bool operator()(const changefeed_stamp_t &) const {           return true;  }
     bool operator()(const changefeed_point_stamp_t &) const {     return true;  }
     bool operator()(const distribution_read_t &) const {          return false; }
+    bool operator()(const sample_read_t &) const {                return false; }
 };
 
 // Route changefeed reads to the primary replica. For other reads we don't care.
@@ -1311,6 +1392,7 @@ bool write_t::shard(const region_t &region,
     const rdb_w_shard_visitor_t v(&region, &payload);
     bool result = boost::apply_visitor(v, write);
     *write_out = write_t(payload, durability_requirement, profile, limits);
+    write_out->priority = priority;
     return result;
 }
 
@@ -1466,17 +1548,19 @@ int write_t::expected_document_changes() const {
 RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(point_read_response_t, data);
 ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(
     ql::skey_version_t, int8_t,
-    ql::skey_version_t::post_1_16, ql::skey_version_t::post_1_16);
+    ql::skey_version_t::post_1_16, ql::skey_version_t::post_2_6);
 RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(
     rget_read_response_t, stamp_response, result, reql_version);
 RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(nearest_geo_read_response_t, results_or_error);
-RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(distribution_read_response_t, region, key_counts);
+RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(
+    distribution_read_response_t, region, key_counts, key_loads);
 RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(
     changefeed_subscribe_response_t, server_uuids, addrs);
 RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(
     changefeed_limit_subscribe_response_t, shards, limit_addrs);
-RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(
-    shard_stamp_info_t, stamp, shard_region, last_read_start);
+RDB_IMPL_SERIALIZABLE_5_FOR_CLUSTER(
+    shard_stamp_info_t, stamp, shard_region, last_read_start, position,
+    resumed_changes);
 RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(changefeed_stamp_response_t, stamp_infos);
 
 RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(
@@ -1486,17 +1570,20 @@ RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(
 
 RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(read_response_t, response, event_log, n_shards);
 RDB_IMPL_SERIALIZABLE_0_FOR_CLUSTER(dummy_read_response_t);
+RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(
+    sample_read_response_t, rows, population, complete);
 
 RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(
     serializable_env_t, global_optargs, user_context, deterministic_time);
 
-RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(point_read_t, key);
+RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(point_read_t, key, projection);
 RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(dummy_read_t, region);
-RDB_IMPL_SERIALIZABLE_4_FOR_CLUSTER(sindex_rangespec_t,
+RDB_IMPL_SERIALIZABLE_5_FOR_CLUSTER(sindex_rangespec_t,
                                     id,
                                     region,
                                     datumspec,
-                                    require_sindex_val);
+                                    require_sindex_val,
+                                    intersect);
 
 ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(
         sorting_t, int8_t,
@@ -1540,6 +1627,8 @@ RDB_IMPL_SERIALIZABLE_8_FOR_CLUSTER(
 RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(
         distribution_read_t, max_depth, result_limit, region);
 
+RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(sample_read_t, num, region);
+
 RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(changefeed_subscribe_t, addr, shard_region);
 RDB_IMPL_SERIALIZABLE_7_FOR_CLUSTER(
     changefeed_limit_subscribe_t,
@@ -1550,10 +1639,11 @@ RDB_IMPL_SERIALIZABLE_7_FOR_CLUSTER(
     serializable_env,
     region,
     current_shard);
-RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(changefeed_stamp_t, addr, region);
+RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(changefeed_stamp_t, addr, region, resume_from);
 RDB_IMPL_SERIALIZABLE_2_FOR_CLUSTER(changefeed_point_stamp_t, addr, key);
 
-RDB_IMPL_SERIALIZABLE_3_FOR_CLUSTER(read_t, read, profile, read_mode);
+RDB_IMPL_SERIALIZABLE_5_FOR_CLUSTER(
+    read_t, read, profile, read_mode, max_staleness_ms, priority);
 
 RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(point_write_response_t, result);
 RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(point_delete_response_t, result);
@@ -1586,7 +1676,7 @@ RDB_IMPL_SERIALIZABLE_1_SINCE_v1_13(point_delete_t, key);
 RDB_IMPL_SERIALIZABLE_1_SINCE_v1_13(sync_t, region);
 RDB_IMPL_SERIALIZABLE_1_FOR_CLUSTER(dummy_write_t, region);
 
-RDB_IMPL_SERIALIZABLE_4_FOR_CLUSTER(
-    write_t, write, durability_requirement, profile, limits);
+RDB_IMPL_SERIALIZABLE_5_FOR_CLUSTER(
+    write_t, write, durability_requirement, profile, limits, priority);
 
 
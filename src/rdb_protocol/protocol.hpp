@@ -49,6 +49,21 @@ ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(
         profile_bool_t, int8_t,
         profile_bool_t::PROFILE, profile_bool_t::DONT_PROFILE);
 
+/* Set with the `priority` optarg of `run`. Reads and writes carry it to the shards,
+which run them at the matching coroutine priority (see `query_coro_priority()`), and
+low priority reads also go through their own cache account so that their disk reads
+queue behind everyone else's. */
+enum class query_priority_t {
+    LOW,
+    NORMAL,
+    HIGH
+};
+ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(
+        query_priority_t, int8_t,
+        query_priority_t::LOW, query_priority_t::HIGH);
+
+int query_coro_priority(query_priority_t priority);
+
 enum class point_write_result_t {
     STORED,
     DUPLICATE
@@ -108,6 +123,10 @@ struct shard_stamp_info_t {
     region_t shard_region;
     // The starting points of the reads (assuming left to right traversal)
     store_key_t last_read_start;
+    // See `ql::changefeed::server_t::get_stamp()`.  `resumed_changes` is only set if
+    // the stamp read asked to resume and the server still has the changes.
+    uint64_t position;
+    optional<std::vector<ql::changefeed::msg_t::change_t> > resumed_changes;
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(shard_stamp_info_t);
 
@@ -161,6 +180,9 @@ struct distribution_read_response_t {
     // key_counts[kn] = the number of keys in [kn, right_key)
     region_t region;
     std::map<store_key_t, int64_t> key_counts;
+    // The sampled load of the busiest keys in the region; see `key_load_sampler_t`.
+    // Unlike `key_counts`, this only contains individual keys, not ranges.
+    std::map<store_key_t, int64_t> key_loads;
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(distribution_read_response_t);
 
@@ -203,6 +225,19 @@ struct dummy_read_response_t {
 
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(dummy_read_response_t);
 
+struct sample_read_response_t {
+    sample_read_response_t() : population(0), complete(false) { }
+    // Distinct rows of the region, chosen uniformly at random.
+    std::vector<ql::datum_t> rows;
+    // An estimate of the number of rows in the region, for weighing the rows against
+    // those of the other shards.
+    double population;
+    // False if the region doesn't have enough rows for random walks to find the
+    // requested number, in which case the rows have to be sampled from a full scan.
+    bool complete;
+};
+RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(sample_read_response_t);
+
 struct serializable_env_t {
     // The global optargs values passed to .run(...) in the Python, Ruby, and JS
     // drivers.
@@ -228,7 +263,8 @@ struct read_response_t {
                            changefeed_stamp_response_t,
                            changefeed_point_stamp_response_t,
                            distribution_read_response_t,
-                           dummy_read_response_t> variant_t;
+                           dummy_read_response_t,
+                           sample_read_response_t> variant_t;
     variant_t response;
     profile::event_log_t event_log;
     size_t n_shards;
@@ -243,8 +279,13 @@ class point_read_t {
 public:
     point_read_t() { }
     explicit point_read_t(const store_key_t& _key) : key(_key) { }
+    point_read_t(const store_key_t& _key, const ql::datum_t &_projection)
+        : key(_key), projection(make_optional(_projection)) { }
 
     store_key_t key;
+    /* If set, the shard only sends back the fields of the row that `pluck` would keep
+    for these paths. */
+    optional<ql::datum_t> projection;
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(point_read_t);
 
@@ -266,11 +307,14 @@ struct sindex_rangespec_t {
                        // dealing with truncated keys.
                        optional<region_t> _region,
                        ql::datumspec_t _datumspec,
-                       require_sindexes_t _require_sindex_val = require_sindexes_t::NO)
+                       require_sindexes_t _require_sindex_val = require_sindexes_t::NO,
+                       std::map<std::string, ql::datum_t> _intersect
+                           = std::map<std::string, ql::datum_t>())
         : id(_id),
           region(std::move(_region)),
           datumspec(std::move(_datumspec)),
-          require_sindex_val(_require_sindex_val){ }
+          require_sindex_val(_require_sindex_val),
+          intersect(std::move(_intersect)) { }
     std::string id; // What sindex we're using.
     // What keyspace we're currently operating on.  If empty, assume the
     // original range and create the readgen on the shards.
@@ -279,6 +323,9 @@ struct sindex_rangespec_t {
     ql::datumspec_t datumspec;
     // For forcing sindex values to be returned with sorting::UNORDERED, used in eq_join.
     require_sindexes_t require_sindex_val;
+    // Other indexes, and a key that the rows must also have in each of them (see the
+    // `intersect` optarg of `get_all`).
+    std::map<std::string, ql::datum_t> intersect;
 };
 
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(sindex_rangespec_t);
@@ -289,6 +336,9 @@ struct changefeed_stamp_t {
         : addr(std::move(_addr)), region(region_t::universe()) { }
     ql::changefeed::client_t::addr_t addr;
     region_t region;
+    // The position of the last change a feed saw on each changefeed server, if the
+    // feed resumes from there.
+    optional<std::map<uuid_u, uint64_t> > resume_from;
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(changefeed_stamp_t);
 
@@ -439,6 +489,18 @@ public:
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(distribution_read_t);
 
+/* Reads `num` rows chosen at random from the region, by walking down the B-tree instead
+of reading all of its rows; see `rdb_sample_slice()`. */
+class sample_read_t {
+public:
+    sample_read_t() : num(0), region(region_t::universe()) { }
+    explicit sample_read_t(uint64_t _num) : num(_num), region(region_t::universe()) { }
+
+    uint64_t num;
+    region_t region;
+};
+RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(sample_read_t);
+
 struct changefeed_subscribe_t {
     changefeed_subscribe_t() { }
     explicit changefeed_subscribe_t(ql::changefeed::client_t::addr_t _addr)
@@ -490,11 +552,15 @@ struct read_t {
                            changefeed_limit_subscribe_t,
                            changefeed_point_stamp_t,
                            distribution_read_t,
-                           dummy_read_t> variant_t;
+                           dummy_read_t,
+                           sample_read_t> variant_t;
 
     variant_t read;
     profile_bool_t profile;
     read_mode_t read_mode;
+    // Only meaningful if `read_mode` is `BOUNDED_STALENESS`.
+    int64_t max_staleness_ms;
+    query_priority_t priority;
 
     region_t get_region() const THROWS_NOTHING;
     // Returns true if the read has any operation for this region.  Returns
@@ -507,10 +573,13 @@ struct read_t {
                  signal_t *interruptor) const
         THROWS_ONLY(interrupted_exc_t);
 
-    read_t() : profile(profile_bool_t::DONT_PROFILE), read_mode(read_mode_t::SINGLE) { }
+    read_t()
+        : profile(profile_bool_t::DONT_PROFILE), read_mode(read_mode_t::SINGLE),
+          max_staleness_ms(0), priority(query_priority_t::NORMAL) { }
     template<class T>
     read_t(T &&_read, profile_bool_t _profile, read_mode_t _read_mode)
-        : read(std::forward<T>(_read)), profile(_profile), read_mode(_read_mode) { }
+        : read(std::forward<T>(_read)), profile(_profile), read_mode(_read_mode),
+          max_staleness_ms(0), priority(query_priority_t::NORMAL) { }
 
     // We use snapshotting for queries that acquire-and-hold large portions of the
     // table, so that they don't block writes.
@@ -678,6 +747,7 @@ struct write_t {
     durability_requirement_t durability_requirement;
     profile_bool_t profile;
     ql::configured_limits_t limits;
+    query_priority_t priority;
 
     region_t get_region() const THROWS_NOTHING;
     // Returns true if the write had any side effects applicable to the
@@ -707,7 +777,8 @@ struct write_t {
     write_t() :
         durability_requirement(DURABILITY_REQUIREMENT_DEFAULT),
         profile(profile_bool_t::DONT_PROFILE),
-        limits() {}
+        limits(),
+        priority(query_priority_t::NORMAL) {}
     /*  Note that for durability != DURABILITY_REQUIREMENT_HARD, sync might
      *  not have the desired effect (of writing unsaved data to disk).
      *  However there are cases where we use sync internally (such as when
@@ -721,14 +792,14 @@ struct write_t {
             const ql::configured_limits_t &_limits)
         : write(std::forward<T>(t)),
           durability_requirement(_durability), profile(_profile),
-          limits(_limits) { }
+          limits(_limits), priority(query_priority_t::NORMAL) { }
     template<class T>
     write_t(T &&t, profile_bool_t _profile,
             const ql::configured_limits_t &_limits)
         : write(std::forward<T>(t)),
           durability_requirement(DURABILITY_REQUIREMENT_DEFAULT),
           profile(_profile),
-          limits(_limits) { }
+          limits(_limits), priority(query_priority_t::NORMAL) { }
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(write_t);
 
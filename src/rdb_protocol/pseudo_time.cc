@@ -473,6 +473,24 @@ int time_cmp(const datum_t &x, const datum_t &y) {
     return x.get_field(epoch_time_key).cmp(y.get_field(epoch_time_key));
 }
 
+bool is_time_object(const datum_t &d) {
+    if (d.get_type() != datum_t::R_OBJECT) {
+        return false;
+    }
+    datum_t reql_type = d.get_field(datum_t::reql_type_string, NOTHROW);
+    return reql_type.has()
+        && reql_type.get_type() == datum_t::R_STR
+        && reql_type.as_str() == time_string;
+}
+
+bool cmp_if_times(const datum_t &x, const datum_t &y, int *cmp_out) {
+    if (!is_time_object(x) || !is_time_object(y)) {
+        return false;
+    }
+    *cmp_out = x.get_field(epoch_time_key).cmp(y.get_field(epoch_time_key));
+    return true;
+}
+
 double sanitize_epoch_sec(double d) {
     return round(d * 1000) / 1000;
 }
@@ -568,11 +586,13 @@ datum_t time_in_tz(datum_t t, datum_t tz) {
 }
 
 datum_t make_time(double epoch_time, std::string tz) {
-    std::map<datum_string_t, datum_t> map
-        = { { datum_string_t(datum_t::reql_type_string), datum_t(time_string) },
-            { datum_string_t(epoch_time_key), datum_t(epoch_time) },
-            { datum_string_t(timezone_key), datum_t(datum_string_t(tz)) } };
-    return datum_t(std::move(map));
+    // The fields are already in key order, so they don't have to go through a map.
+    std::vector<std::pair<datum_string_t, datum_t> > fields;
+    fields.reserve(3);
+    fields.emplace_back(datum_t::reql_type_string, datum_t(time_string));
+    fields.emplace_back(datum_string_t(epoch_time_key), datum_t(epoch_time));
+    fields.emplace_back(datum_string_t(timezone_key), datum_t(datum_string_t(tz)));
+    return datum_t(std::move(fields));
 }
 
 datum_t make_time(
@@ -680,7 +700,9 @@ datum_t time_of_day(datum_t time) {
 void time_to_str_key(const datum_t &d, std::string *str_out) {
     // We need to prepend "P" and append a character less than [a-zA-Z] so that
     // different pseudotypes sort correctly.
-    str_out->append(std::string("P") + time_string + ":");
+    str_out->push_back('P');
+    str_out->append(time_string);
+    str_out->push_back(':');
     d.get_field(epoch_time_key).num_to_str_key(str_out);
 }
 
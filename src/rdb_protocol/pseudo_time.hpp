@@ -25,6 +25,10 @@ datum_t time_tz(datum_t time);
 datum_t time_in_tz(datum_t t, datum_t tz);
 
 int time_cmp(const datum_t &x, const datum_t &y);
+// Sets `*cmp_out` to `time_cmp(x, y)` and returns true if `x` and `y` are both times,
+// and returns false otherwise.  This takes two field lookups per time, rather than
+// the handful that the general pseudotype checks in `datum_t::cmp()` need.
+bool cmp_if_times(const datum_t &x, const datum_t &y, int *cmp_out);
 void sanitize_time(datum_t *time);
 datum_t make_time(double epoch_time, std::string tz);
 datum_t make_time(
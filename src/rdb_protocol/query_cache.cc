@@ -1,13 +1,27 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "rdb_protocol/query_cache.hpp"
 
+#include <algorithm>
+#include <limits>
+
+#include "logger.hpp"
+#include "pprint/js_pprint.hpp"
 #include "rdb_protocol/env.hpp"
+#include "rdb_protocol/explain.hpp"
+#include "rdb_protocol/func.hpp"
 #include "rdb_protocol/pseudo_time.hpp"
 #include "rdb_protocol/response.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
 #include "rdb_protocol/term_walker.hpp"
+#include "rdb_protocol/user_quotas.hpp"
 
 namespace ql {
 
+/* Queries that spend longer than this evaluating are written to the log, which is
+also the `rethinkdb.logs` table. */
+const uint64_t SLOW_QUERY_LOG_THRESHOLD_MICROS = 1 * MILLION;
+const size_t SLOW_QUERY_LOG_MAX_QUERY_LENGTH = 1000;
+
 query_cache_t::query_cache_t(
             rdb_context_t *_rdb_ctx,
             ip_and_port_t _client_addr_port,
@@ -17,6 +31,7 @@ query_cache_t::query_cache_t(
         client_addr_port(_client_addr_port),
         return_empty_normal_batches(_return_empty_normal_batches),
         user_context(std::move(_user_context)),
+        next_prepared_query_handle(0),
         next_query_id(0),
         oldest_outstanding_query_id(0) {
     auto res = rdb_ctx->get_query_caches_for_this_thread()->insert(this);
@@ -36,26 +51,16 @@ query_cache_t::const_iterator query_cache_t::end() const {
     return queries.end();
 }
 
-scoped_ptr_t<query_cache_t::ref_t> query_cache_t::create(query_params_t *query_params,
-                                                         ql::datum_t &&deterministic_time,
-                                                         signal_t *interruptor) {
-    guarantee(this == query_params->query_cache);
-    query_params->maybe_release_query_id();
-    if (queries.find(query_params->token) != queries.end()) {
-        throw bt_exc_t(Response::CLIENT_ERROR, Response::QUERY_LOGIC,
-            strprintf("ERROR: duplicate token %" PRIi64, query_params->token),
-            backtrace_registry_t::EMPTY_BACKTRACE);
-    }
-
-    global_optargs_t global_optargs;
-    counted_t<const term_t> term_tree;
+void query_cache_t::compile_query(query_params_t *query_params,
+                                  global_optargs_t *global_optargs_out,
+                                  counted_t<const term_t> *term_tree_out) {
     try {
         query_params->term_storage->preprocess();
-        global_optargs = query_params->term_storage->global_optargs();
+        *global_optargs_out = query_params->term_storage->global_optargs();
 
         compile_env_t compile_env((var_visibility_t()));
-        term_tree = compile_term(&compile_env, query_params->term_storage->root_term());
-
+        *term_tree_out = compile_term(&compile_env,
+                                      query_params->term_storage->root_term());
     } catch (const exc_t &e) {
         throw bt_exc_t(Response::COMPILE_ERROR,
             e.get_error_type(),
@@ -67,10 +72,72 @@ scoped_ptr_t<query_cache_t::ref_t> query_cache_t::create(query_params_t *query_p
                        e.what(),
                        backtrace_registry_t::EMPTY_BACKTRACE);
     }
+}
+
+scoped_ptr_t<query_cache_t::ref_t> query_cache_t::create(query_params_t *query_params,
+                                                         ql::datum_t &&deterministic_time,
+                                                         signal_t *interruptor) {
+    guarantee(this == query_params->query_cache);
+    query_params->maybe_release_query_id();
+    if (queries.find(query_params->token) != queries.end()) {
+        throw bt_exc_t(Response::CLIENT_ERROR, Response::QUERY_LOGIC,
+            strprintf("ERROR: duplicate token %" PRIi64, query_params->token),
+            backtrace_registry_t::EMPTY_BACKTRACE);
+    }
+
+    query_priority_t priority = query_priority_t::NORMAL;
+    if (query_params->priority.has_value()) {
+        const std::string &str = *query_params->priority;
+        if (str == "low") {
+            priority = query_priority_t::LOW;
+        } else if (str == "high") {
+            priority = query_priority_t::HIGH;
+        } else if (str != "normal") {
+            throw bt_exc_t(Response::COMPILE_ERROR, Response::QUERY_LOGIC,
+                strprintf("Priority `%s` unrecognized (options are \"low\", "
+                          "\"normal\", and \"high\").", str.c_str()),
+                backtrace_registry_t::EMPTY_BACKTRACE);
+        }
+    }
+
+    global_optargs_t global_optargs;
+    counted_t<const term_t> term_tree;
+    counted_t<const prepared_query_t> prepared_query;
+    std::vector<datum_t> args;
+    if (query_params->type == Query::EXECUTE) {
+        int64_t handle = query_params->term_storage->prepared_query_handle();
+        auto it = prepared_queries.find(handle);
+        if (it == prepared_queries.end()) {
+            throw bt_exc_t(Response::CLIENT_ERROR, Response::QUERY_LOGIC,
+                strprintf("Prepared query handle %" PRIi64 " not found.", handle),
+                backtrace_registry_t::EMPTY_BACKTRACE);
+        }
+        try {
+            // Like the contents of `DATUM` terms, the arguments aren't subject to the
+            // array size limit until they're used.
+            args = query_params->term_storage->prepared_query_args(
+                configured_limits_t::unlimited);
+        } catch (const base_exc_t &e) {
+            throw bt_exc_t(Response::COMPILE_ERROR,
+                           e.get_error_type(),
+                           e.what(),
+                           backtrace_registry_t::EMPTY_BACKTRACE);
+        }
+        prepared_query = it->second;
+        global_optargs = prepared_query->global_optargs;
+        term_tree = prepared_query->func_term;
+    } else {
+        r_sanity_check(query_params->type == Query::START);
+        compile_query(query_params, &global_optargs, &term_tree);
+    }
+
     scoped_ptr_t<entry_t> entry(new entry_t(query_params,
                                             std::move(global_optargs),
                                             std::move(deterministic_time),
-                                            std::move(term_tree)));
+                                            std::move(term_tree),
+                                            std::move(prepared_query),
+                                            std::move(args),
+                                            priority));
 
     scoped_ptr_t<ref_t> ref(new ref_t(this,
                                       query_params->token,
@@ -117,6 +184,91 @@ void query_cache_t::noreply_wait(const query_params_t &query_params,
         }, interruptor);
 }
 
+int64_t query_cache_t::prepare(query_params_t *query_params) {
+    r_sanity_check(query_params->type == Query::PREPARE);
+    guarantee(this == query_params->query_cache);
+    assert_thread();
+    query_params->maybe_release_query_id();
+
+    global_optargs_t global_optargs;
+    counted_t<const term_t> term_tree;
+    compile_query(query_params, &global_optargs, &term_tree);
+    if (query_params->term_storage->root_term().type() != Term::FUNC) {
+        throw bt_exc_t(Response::COMPILE_ERROR, Response::QUERY_LOGIC,
+            "Expected a PREPARE query to contain a function.",
+            backtrace_registry_t::EMPTY_BACKTRACE);
+    }
+
+    int64_t handle = next_prepared_query_handle++;
+    auto insert_res = prepared_queries.insert(std::make_pair(handle,
+        make_counted<prepared_query_t>(std::move(query_params->term_storage),
+                                       std::move(global_optargs),
+                                       std::move(term_tree))));
+    guarantee(insert_res.second);
+    return handle;
+}
+
+void query_cache_t::unprepare(query_params_t *query_params) {
+    r_sanity_check(query_params->type == Query::UNPREPARE);
+    guarantee(this == query_params->query_cache);
+    assert_thread();
+    query_params->maybe_release_query_id();
+
+    int64_t handle = query_params->term_storage->prepared_query_handle();
+    if (prepared_queries.erase(handle) == 0) {
+        throw bt_exc_t(Response::CLIENT_ERROR, Response::QUERY_LOGIC,
+            strprintf("Prepared query handle %" PRIi64 " not found.", handle),
+            backtrace_registry_t::EMPTY_BACKTRACE);
+    }
+}
+
+void query_cache_t::push_chunk(query_params_t *query_params, signal_t *interruptor) {
+    r_sanity_check(query_params->type == Query::CHUNK);
+    guarantee(this == query_params->query_cache);
+    assert_thread();
+    query_params->maybe_release_query_id();
+
+    auto it = queries.find(query_params->token);
+    if (it == queries.end()) {
+        throw bt_exc_t(Response::CLIENT_ERROR, Response::QUERY_LOGIC,
+            strprintf("Token %" PRIi64 " not in stream cache.", query_params->token),
+            backtrace_registry_t::EMPTY_BACKTRACE);
+    }
+    entry_t *entry = it->second.get();
+
+    std::vector<datum_t> docs;
+    try {
+        // Like the arguments of `EXECUTE` queries, a chunk isn't subject to the array
+        // size limit, since it's never an array in the query.
+        docs = query_params->term_storage->chunk_docs(configured_limits_t::unlimited);
+    } catch (const base_exc_t &e) {
+        throw bt_exc_t(Response::COMPILE_ERROR,
+                       e.get_error_type(),
+                       e.what(),
+                       backtrace_registry_t::EMPTY_BACKTRACE);
+    }
+
+    // The entry goes away when the query ends, whether or not it read the chunk.
+    auto_drainer_t::lock_t lock(&entry->drainer);
+    wait_any_t query_ended(lock.get_drain_signal(), &entry->persistent_interruptor);
+    wait_any_t combined_interruptor(interruptor, &query_ended);
+    bool pushed;
+    try {
+        pushed = entry->chunks.push(std::move(docs), &combined_interruptor);
+    } catch (const interrupted_exc_t &) {
+        if (interruptor->is_pulsed()) {
+            throw;
+        }
+        pushed = false;
+    }
+    if (!pushed) {
+        throw bt_exc_t(Response::CLIENT_ERROR, Response::QUERY_LOGIC,
+            strprintf("The query with token %" PRIi64 " doesn't read any more "
+                      "chunks.", query_params->token),
+            backtrace_registry_t::EMPTY_BACKTRACE);
+    }
+}
+
 void query_cache_t::stop_query(query_params_t *query_params, signal_t *interruptor) {
     r_sanity_check(query_params->type == Query::STOP);
     guarantee(this == query_params->query_cache);
@@ -151,13 +303,52 @@ query_cache_t::ref_t::ref_t(query_cache_t *_query_cache,
                             signal_t *interruptor) :
         entry(_entry),
         token(_token),
-        trace(maybe_make_profile_trace(entry->profile)),
+        request_time(get_kiloticks()),
+        trace(maybe_make_profile_trace(entry->trace_context.has_value()
+                                           ? profile_bool_t::PROFILE
+                                           : entry->profile)),
         query_cache(_query_cache),
         throttler(std::move(_throttler)),
         drainer_lock(&entry->drainer),
         combined_interruptor(interruptor, &entry->persistent_interruptor),
         mutex_lock(&entry->mutex) {
     wait_interruptible(mutex_lock.acq_signal(), interruptor);
+    entry->evaluating_since.set(get_kiloticks());
+}
+
+void query_cache_t::maybe_log_slow_query(const entry_t *entry) const {
+    const query_resource_usage_t &usage = entry->resource_usage;
+    // Changefeeds spend most of their time waiting for changes.
+    if (usage.evaluation_micros < SLOW_QUERY_LOG_THRESHOLD_MICROS
+        || (entry->stream.has()
+            && entry->stream->cfeed_type() != feed_type_t::not_feed)) {
+        return;
+    }
+    std::string query = pprint::pretty_print_as_js(
+        std::numeric_limits<size_t>::max(), entry->root_term());
+    if (query.size() > SLOW_QUERY_LOG_MAX_QUERY_LENGTH) {
+        query.resize(SLOW_QUERY_LOG_MAX_QUERY_LENGTH);
+        query += "...";
+    }
+    logINF("Slow query from %s:%d (%s): %s",
+           client_addr_port.ip().to_string().c_str(),
+           client_addr_port.port().value(),
+           usage.to_string().c_str(),
+           query.c_str());
+}
+
+void query_cache_t::record_span(const entry_t *entry,
+                                kiloticks_t request_time,
+                                profile::trace_t *trace) {
+    query_span_t span;
+    span.context = *entry->trace_context;
+    span.span_id = generate_span_id();
+    span.duration.micros = get_kiloticks().micros - request_time.micros;
+    span.start_time = current_microtime() - span.duration.micros;
+    span.query = pprint::pretty_print_as_js(
+        std::numeric_limits<size_t>::max(), entry->root_term());
+    span.profile = trace->as_datum();
+    rdb_ctx->get_query_spans_for_this_thread()->record(std::move(span));
 }
 
 void query_cache_t::async_destroy_entry(query_cache_t::entry_t *entry) {
@@ -168,7 +359,13 @@ query_cache_t::ref_t::~ref_t() {
     query_cache->assert_thread();
     guarantee(entry->state != entry_t::state_t::START);
 
+    entry->resource_usage.evaluation_micros += std::max<int64_t>(
+        0, get_kiloticks().micros - entry->evaluating_since->micros);
+    entry->evaluating_since.reset();
+
     if (entry->state == entry_t::state_t::DONE) {
+        query_cache->maybe_log_slow_query(entry);
+
         // We do not delete the entry in this context for reasons:
         //  1. If there is an active exception, we aren't allowed to switch coroutines
         //  2. This will block until all auto-drainer locks on the entry have been
@@ -199,6 +396,13 @@ void query_cache_t::ref_t::fill_response(response_t *res) {
     }
 
     try {
+        with_priority_t p(query_coro_priority(entry->priority));
+        user_quotas_t *user_quotas = query_cache->rdb_ctx->user_quotas;
+        scoped_ptr_t<user_quotas_t::admission_t> admission;
+        if (user_quotas != nullptr) {
+            admission.init(new user_quotas_t::admission_t(
+                user_quotas, query_cache->get_user_context(), &combined_interruptor));
+        }
         serializable_env_t serializable{
                 entry->global_optargs,
                 query_cache->get_user_context(),
@@ -209,6 +413,9 @@ void query_cache_t::ref_t::fill_response(response_t *res) {
             &combined_interruptor,
             serializable,
             trace.get_or_null());
+        env.set_resource_usage(&entry->resource_usage);
+        env.set_query_priority(entry->priority);
+        env.set_client_chunks(&entry->chunks);
 
         if (entry->state == entry_t::state_t::START) {
             run(&env, res);
@@ -219,7 +426,25 @@ void query_cache_t::ref_t::fill_response(response_t *res) {
             serve(&env, res);
         }
 
-        if (trace.has()) {
+        if (admission.has()) {
+            // Rows read by prefetches since the last batch are charged too.
+            uint64_t bytes_returned = 0;
+            if (user_quotas->get_config().max_bytes_returned_per_sec != 0) {
+                for (const datum_t &d : res->data()) {
+                    bytes_returned += datum_serialized_size(
+                        d, check_datum_serialization_errors_t::NO);
+                }
+            }
+            admission->charge(
+                entry->resource_usage.rows_read - entry->rows_read_charged,
+                bytes_returned);
+            entry->rows_read_charged = entry->resource_usage.rows_read;
+        }
+
+        if (entry->trace_context.has_value()) {
+            query_cache->record_span(entry, request_time, trace.get());
+        }
+        if (entry->profile == profile_bool_t::PROFILE) {
             res->set_profile(trace->as_datum());
         }
     } catch (const interrupted_exc_t &ex) {
@@ -256,13 +481,13 @@ void query_cache_t::ref_t::fill_response(response_t *res) {
         throw bt_exc_t(Response::RUNTIME_ERROR,
                        ex.get_error_type(),
                        ex.what(),
-                       entry->term_storage->backtrace_registry().datum_backtrace(ex));
+                       entry->backtrace_registry().datum_backtrace(ex));
     } catch (const datum_exc_t &ex) {
         query_cache->terminate_internal(entry);
         throw bt_exc_t(Response::RUNTIME_ERROR,
                        ex.get_error_type(),
                        ex.what(),
-                       entry->term_storage->backtrace_registry().datum_backtrace(
+                       entry->backtrace_registry().datum_backtrace(
                             backtrace_id_t::empty(), 0));
     } catch (const std::exception &ex) {
         query_cache->terminate_internal(entry);
@@ -274,18 +499,30 @@ void query_cache_t::ref_t::fill_response(response_t *res) {
 }
 
 void query_cache_t::ref_t::run(env_t *env, response_t *res) {
+    if (entry->explain) {
+        res->set_type(Response::SUCCESS_ATOM);
+        res->set_data(explain_query(env, entry->root_term()));
+        entry->state = entry_t::state_t::DONE;
+        return;
+    }
+
     scope_env_t scope_env(env, var_scope_t());
     scoped_ptr_t<val_t> val = entry->term_tree->eval(&scope_env);
+    if (entry->prepared_query.has()) {
+        val = val->as_func()->call(env, entry->args);
+    }
 
     if (val->get_type().is_convertible(val_t::type_t::DATUM)) {
         res->set_type(Response::SUCCESS_ATOM);
         res->set_data(val->as_datum());
+        entry->resource_usage.rows_returned += 1;
         entry->state = entry_t::state_t::DONE;
     } else if (counted_t<grouped_data_t> gd =
             val->maybe_as_promiscuous_grouped_data(scope_env.env)) {
         datum_t d = to_datum_for_client_serialization(std::move(*gd), env->limits());
         res->set_type(Response::SUCCESS_ATOM);
         res->set_data(d);
+        entry->resource_usage.rows_returned += 1;
         entry->state = entry_t::state_t::DONE;
     } else if (val->get_type().is_convertible(val_t::type_t::SEQUENCE)) {
         counted_t<datum_stream_t> seq = val->as_seq(env);
@@ -293,6 +530,7 @@ void query_cache_t::ref_t::run(env_t *env, response_t *res) {
         if (arr.has()) {
             res->set_type(Response::SUCCESS_ATOM);
             res->set_data(arr);
+            entry->resource_usage.rows_returned += arr.arr_size();
             entry->state = entry_t::state_t::DONE;
         } else {
             entry->stream = seq;
@@ -316,13 +554,29 @@ void query_cache_t::ref_t::serve(env_t *env, response_t *res) {
         throttler.reset();
     }
 
-    batch_type_t batch_type = entry->has_sent_batch
-                                  ? batch_type_t::NORMAL
-                                  : batch_type_t::NORMAL_FIRST;
-    std::vector<datum_t> ds = entry->stream->next_batch(
-            env, batchspec_t::user(batch_type, env));
+    entry->batch_size.note_request(request_time);
+    kiloticks_t duration{0};
+    if (entry->prefetch_error) {
+        std::exception_ptr error;
+        std::swap(error, entry->prefetch_error);
+        std::rethrow_exception(error);
+    } else if (entry->prefetched_batch.has_value()) {
+        res->set_data(std::move(*entry->prefetched_batch));
+        entry->prefetched_batch.reset();
+        duration = entry->prefetch_duration;
+    } else {
+        batch_type_t batch_type = entry->has_sent_batch
+                                      ? batch_type_t::NORMAL
+                                      : batch_type_t::NORMAL_FIRST;
+        kiloticks_t start_time = get_kiloticks();
+        std::vector<datum_t> ds = entry->stream->next_batch(
+                env, entry->batch_size.user(batch_type, env));
+        duration.micros = get_kiloticks().micros - start_time.micros;
+        res->set_data(std::move(ds));
+    }
     entry->has_sent_batch = true;
-    res->set_data(std::move(ds));
+    entry->batch_size.note_sent(get_kiloticks(), duration);
+    entry->resource_usage.rows_returned += res->data().size();
 
     // Note that `SUCCESS_SEQUENCE` is possible for feeds if you call `.limit`
     // after the feed.
@@ -358,25 +612,112 @@ void query_cache_t::ref_t::serve(env_t *env, response_t *res) {
     default: unreachable();
     }
     entry->stream->set_notes(res);
+
+    // Read the next batch while the client is busy with this one. Feeds are left
+    // alone because they can block forever, and profiled queries because the
+    // prefetch would be missing from the profile.
+    if (res->type() == Response::SUCCESS_PARTIAL
+        && cfeed_type == feed_type_t::not_feed
+        && !trace.has()) {
+        auto_drainer_t::lock_t lock(&entry->drainer);
+        query_cache_t *cache = query_cache;
+        entry_t *e = entry;
+        coro_t::spawn_sometime([cache, e, lock]() {
+            cache->prefetch(e, lock);
+        });
+    }
+}
+
+void query_cache_t::prefetch(entry_t *entry, auto_drainer_t::lock_t lock) {
+    assert_thread();
+    wait_any_t interruptor(lock.get_drain_signal(), &entry->persistent_interruptor);
+    try {
+        // If the client's `CONTINUE` got here first, it has served the batch and
+        // started another prefetch.
+        new_mutex_in_line_t mutex_lock(&entry->mutex);
+        wait_interruptible(mutex_lock.acq_signal(), &interruptor);
+        if (entry->state != entry_t::state_t::STREAM
+            || entry->prefetched_batch.has_value()
+            || entry->prefetch_error) {
+            return;
+        }
+
+        with_priority_t p(query_coro_priority(entry->priority));
+        serializable_env_t serializable{
+                entry->global_optargs,
+                get_user_context(),
+                entry->deterministic_time};
+        env_t env(rdb_ctx,
+                  return_empty_normal_batches,
+                  &interruptor,
+                  serializable,
+                  nullptr);
+        env.set_resource_usage(&entry->resource_usage);
+        env.set_query_priority(entry->priority);
+        kiloticks_t start_time = get_kiloticks();
+        try {
+            entry->prefetched_batch.set(entry->stream->next_batch(
+                &env, entry->batch_size.user(batch_type_t::NORMAL, &env)));
+        } catch (const interrupted_exc_t &) {
+            throw;
+        } catch (...) {
+            entry->prefetch_error = std::current_exception();
+        }
+        entry->prefetch_duration.micros = get_kiloticks().micros - start_time.micros;
+        entry->resource_usage.evaluation_micros += entry->prefetch_duration.micros;
+    } catch (const interrupted_exc_t &) {
+        // The query is being stopped or deleted; the next `CONTINUE`, if any, sees
+        // the same interruption.
+    }
 }
 
 query_cache_t::entry_t::entry_t(query_params_t *query_params,
                                 global_optargs_t &&_global_optargs,
                                 ql::datum_t && _deterministic_time,
-                                counted_t<const term_t> &&_term_tree) :
+                                counted_t<const term_t> &&_term_tree,
+                                counted_t<const prepared_query_t> &&_prepared_query,
+                                std::vector<datum_t> &&_args,
+                                query_priority_t _priority) :
         state(state_t::START),
         interrupt_reason(interrupt_reason_t::UNKNOWN),
         job_id(generate_uuid()),
         noreply(query_params->noreply),
         profile(query_params->profile ? profile_bool_t::PROFILE :
                                         profile_bool_t::DONT_PROFILE),
+        explain(query_params->explain),
+        trace_context(trace_context_t::maybe_sample(query_params->trace_context)),
+        priority(_priority),
         term_storage(std::move(query_params->term_storage)),
         global_optargs(std::move(_global_optargs)),
         deterministic_time(_deterministic_time),
         start_time(get_kiloticks()),
+        prepared_query(std::move(_prepared_query)),
+        args(std::move(_args)),
         term_tree(std::move(_term_tree)),
-        has_sent_batch(false) { }
+        has_sent_batch(false),
+        prefetch_duration{0},
+        rows_read_charged(0) { }
 
 query_cache_t::entry_t::~entry_t() { }
 
+raw_term_t query_cache_t::entry_t::root_term() const {
+    return prepared_query.has()
+        ? prepared_query->term_storage->root_term()
+        : term_storage->root_term();
+}
+
+const backtrace_registry_t &query_cache_t::entry_t::backtrace_registry() const {
+    return prepared_query.has()
+        ? prepared_query->term_storage->backtrace_registry()
+        : term_storage->backtrace_registry();
+}
+
+query_cache_t::prepared_query_t::prepared_query_t(
+        scoped_ptr_t<term_storage_t> &&_term_storage,
+        global_optargs_t &&_global_optargs,
+        counted_t<const term_t> &&_func_term) :
+    term_storage(std::move(_term_storage)),
+    global_optargs(std::move(_global_optargs)),
+    func_term(std::move(_func_term)) { }
+
 } // namespace ql
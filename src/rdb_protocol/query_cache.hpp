@@ -8,6 +8,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "arch/address.hpp"
 #include "clustering/administration/auth/user_context.hpp"
@@ -20,6 +21,8 @@
 #include "containers/counted.hpp"
 #include "containers/intrusive_list.hpp"
 #include "containers/object_buffer.hpp"
+#include "rdb_protocol/batching.hpp"
+#include "rdb_protocol/client_chunks.hpp"
 #include "rdb_protocol/datum_stream.hpp"
 #include "rdb_protocol/rdb_backtrace.hpp"
 #include "rdb_protocol/error.hpp"
@@ -29,6 +32,7 @@
 #include "rdb_protocol/term.hpp"
 #include "rdb_protocol/term_storage.hpp"
 #include "rdb_protocol/wire_func.hpp"
+#include "time.hpp"
 
 namespace ql {
 
@@ -62,6 +66,8 @@ public:
 
         query_cache_t::entry_t *const entry;
         const int64_t token;
+        // When the query arrived, before we waited for the entry's mutex
+        const kiloticks_t request_time;
         const scoped_ptr_t<profile::trace_t> trace;
 
         query_cache_t *query_cache;
@@ -81,7 +87,8 @@ public:
     // Helper function used by the jobs table
     ip_and_port_t get_client_addr_port() const { return client_addr_port; }
 
-    // Methods to obtain a unique reference to a given entry in the cache
+    // Methods to obtain a unique reference to a given entry in the cache.  `create`
+    // accepts `START` and `EXECUTE` queries.
     scoped_ptr_t<ref_t> create(query_params_t *query_params,
                                ql::datum_t &&deterministic_time,
                                signal_t *interruptor);
@@ -92,6 +99,15 @@ public:
     void noreply_wait(const query_params_t &query_params,
                       signal_t *interruptor);
 
+    // Compiles the function in a `PREPARE` query and returns the handle that
+    // `EXECUTE` queries use to call it.
+    int64_t prepare(query_params_t *query_params);
+    void unprepare(query_params_t *query_params);
+
+    // Hands the documents in a `CHUNK` query to the running query with the same
+    // token, waiting until it has room for them.
+    void push_chunk(query_params_t *query_params, signal_t *interruptor);
+
     // Issue a stop query to the cache
     void stop_query(query_params_t *query_params, signal_t *interruptor);
 
@@ -103,20 +119,52 @@ public:
     auth::user_context_t const &get_user_context() const;
 
 private:
+    // A function compiled by a `PREPARE` query.  Entries for `EXECUTE` queries hold a
+    // reference to it, so it stays alive until they finish even if it is unprepared.
+    class prepared_query_t : public single_threaded_countable_t<prepared_query_t> {
+    public:
+        prepared_query_t(scoped_ptr_t<term_storage_t> &&_term_storage,
+                         global_optargs_t &&_global_optargs,
+                         counted_t<const term_t> &&_func_term);
+
+        const scoped_ptr_t<const term_storage_t> term_storage;
+        const global_optargs_t global_optargs;
+        const counted_t<const term_t> func_term;
+
+    private:
+        DISABLE_COPYING(prepared_query_t);
+    };
+
     class entry_t {
     public:
         entry_t(query_params_t *query_params,
                 global_optargs_t &&_global_optargs,
                 ql::datum_t &&_deterministic_time,
-                counted_t<const term_t> &&_term_tree);
+                counted_t<const term_t> &&_term_tree,
+                counted_t<const prepared_query_t> &&_prepared_query,
+                std::vector<datum_t> &&_args,
+                query_priority_t _priority);
         ~entry_t();
 
+        // The term the query evaluates, which for an `EXECUTE` query is the prepared
+        // function.
+        raw_term_t root_term() const;
+        const backtrace_registry_t &backtrace_registry() const;
+
         enum class state_t { START, STREAM, DONE, DELETING } state;
         interrupt_reason_t interrupt_reason;
 
         const uuid_u job_id;
         const bool noreply;
         const profile_bool_t profile;
+        // If set, the query returns `explain_query()`'s description of how it would
+        // run instead of running.
+        const bool explain;
+        // Set if the query is traced, in which case it's profiled whether or not the
+        // client asked for the profile.
+        const optional<trace_context_t> trace_context;
+        // From the `priority` global optarg
+        const query_priority_t priority;
         const scoped_ptr_t<const term_storage_t> term_storage;
         const global_optargs_t global_optargs;
         // TODO: deterministic_time and start_time represent approximately the same
@@ -125,6 +173,21 @@ private:
         const ql::datum_t deterministic_time;
         const kiloticks_t start_time;
 
+        // This must outlive `stream`, whose environments may point to it.
+        query_resource_usage_t resource_usage;
+        // Set while a `ref_t` holds `mutex`, so that the jobs table can include the
+        // time spent on the current request in `resource_usage.evaluation_micros`.
+        optional<kiloticks_t> evaluating_since;
+
+        // For `EXECUTE` queries `term_tree` is the prepared function, which is called
+        // with `args`.
+        const counted_t<const prepared_query_t> prepared_query;
+        const std::vector<datum_t> args;
+
+        // What `CHUNK` queries on the token sent. This must outlive `stream`, which
+        // may read from it.
+        client_chunks_t chunks;
+
         cond_t persistent_interruptor;
 
         // This will be empty if the root term has already been run
@@ -135,6 +198,18 @@ private:
         // stream is finished
         counted_t<datum_stream_t> stream;
         bool has_sent_batch;
+        adaptive_batch_size_t batch_size;
+
+        // The next batch of `stream`, read while the client was busy with the last
+        // one (see `query_cache_t::prefetch`), and how long that took. If reading it
+        // failed, `prefetch_error` is rethrown by the next `CONTINUE` instead.
+        optional<std::vector<datum_t> > prefetched_batch;
+        kiloticks_t prefetch_duration;
+        std::exception_ptr prefetch_error;
+
+        // How much of `resource_usage.rows_read` was charged to the user's
+        // `user_quotas_t` budget so far
+        uint64_t rows_read_charged;
 
         // The order of these is very important, do not move them around
         new_mutex_t mutex; // Only one coroutine may be using this query at a time
@@ -146,12 +221,30 @@ private:
 
     static void async_destroy_entry(entry_t *entry);
 
+    // Writes finished queries that took a long time to evaluate to the log.
+    void maybe_log_slow_query(const entry_t *entry) const;
+
+    // Records a request of a traced query in `rdb_ctx`'s span log.
+    void record_span(const entry_t *entry,
+                     kiloticks_t request_time,
+                     profile::trace_t *trace);
+
+    // Reads the next batch of a stream ahead of the client's `CONTINUE`.
+    void prefetch(entry_t *entry, auto_drainer_t::lock_t lock);
+
+    static void compile_query(query_params_t *query_params,
+                              global_optargs_t *global_optargs_out,
+                              counted_t<const term_t> *term_tree_out);
+
     rdb_context_t *const rdb_ctx;
     ip_and_port_t client_addr_port;
     return_empty_normal_batches_t return_empty_normal_batches;
     auth::user_context_t user_context;
     std::map<int64_t, scoped_ptr_t<entry_t> > queries;
 
+    int64_t next_prepared_query_handle;
+    std::map<int64_t, counted_t<const prepared_query_t> > prepared_queries;
+
     // Used for noreply waiting, this contains all allocated-but-incomplete query ids
     friend class query_params_t::query_id_t;
     uint64_t next_query_id;
@@ -0,0 +1,272 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/query_capture.hpp"
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "arch/runtime/thread_pool.hpp"
+#include "logger.hpp"
+#include "random.hpp"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+#include "rdb_protocol/ql2proto.hpp"
+#include "rdb_protocol/query_cache.hpp"
+#include "rdb_protocol/query_params.hpp"
+#include "utils.hpp"
+
+namespace {
+
+typedef rapidjson::Writer<rapidjson::StringBuffer> json_writer_t;
+
+/* Terms whose literal arguments are names, or change what the query does, rather than
+being data. */
+bool keeps_literal_args(int type) {
+    switch (type) {
+    case Term::DB:
+    case Term::TABLE:
+    case Term::DB_CREATE:
+    case Term::DB_DROP:
+    case Term::TABLE_CREATE:
+    case Term::TABLE_DROP:
+    case Term::INDEX_CREATE:
+    case Term::INDEX_DROP:
+    case Term::INDEX_RENAME:
+    case Term::INDEX_STATUS:
+    case Term::INDEX_WAIT:
+    case Term::GET_FIELD:
+    case Term::BRACKET:
+    case Term::PLUCK:
+    case Term::WITHOUT:
+    case Term::HAS_FIELDS:
+    case Term::ORDER_BY:
+    case Term::ASC:
+    case Term::DESC:
+    case Term::GROUP:
+    case Term::LIMIT:
+    case Term::SKIP:
+    case Term::NTH:
+    case Term::SLICE:
+    case Term::VAR:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool is_literal(const rapidjson::Value &value) {
+    return !value.IsArray() && !value.IsObject();
+}
+
+void write_redacted_literal(json_writer_t *writer, const rapidjson::Value &value) {
+    switch (value.GetType()) {
+    case rapidjson::kStringType: {
+        std::string placeholder(value.GetStringLength(), 'x');
+        writer->String(placeholder.data(), placeholder.size());
+    } break;
+    case rapidjson::kNumberType:
+        writer->Int(0);
+        break;
+    case rapidjson::kArrayType:
+        writer->StartArray();
+        for (auto it = value.Begin(); it != value.End(); ++it) {
+            write_redacted_literal(writer, *it);
+        }
+        writer->EndArray();
+        break;
+    case rapidjson::kObjectType:
+        writer->StartObject();
+        for (auto it = value.MemberBegin(); it != value.MemberEnd(); ++it) {
+            writer->Key(it->name.GetString(), it->name.GetStringLength(), true);
+            write_redacted_literal(writer, it->value);
+        }
+        writer->EndObject();
+        break;
+    case rapidjson::kNullType:
+    case rapidjson::kFalseType:
+    case rapidjson::kTrueType:
+    default:
+        value.Accept(*writer);
+        break;
+    }
+}
+
+void write_redacted_term(json_writer_t *writer, const rapidjson::Value &term);
+
+/* Optargs are kept unless they are terms, since their literal values are almost
+always settings such as `index` or `durability`. */
+void write_redacted_optargs(json_writer_t *writer, const rapidjson::Value &optargs) {
+    if (!optargs.IsObject()) {
+        optargs.Accept(*writer);
+        return;
+    }
+    writer->StartObject();
+    for (auto it = optargs.MemberBegin(); it != optargs.MemberEnd(); ++it) {
+        writer->Key(it->name.GetString(), it->name.GetStringLength(), true);
+        if (is_literal(it->value)) {
+            it->value.Accept(*writer);
+        } else {
+            write_redacted_term(writer, it->value);
+        }
+    }
+    writer->EndObject();
+}
+
+/* A term is either `[type, args, optargs]`, an object that is shorthand for a
+`MAKE_OBJ`, or a literal. */
+void write_redacted_term(json_writer_t *writer, const rapidjson::Value &term) {
+    if (term.IsObject()) {
+        writer->StartObject();
+        for (auto it = term.MemberBegin(); it != term.MemberEnd(); ++it) {
+            writer->Key(it->name.GetString(), it->name.GetStringLength(), true);
+            write_redacted_term(writer, it->value);
+        }
+        writer->EndObject();
+        return;
+    } else if (is_literal(term)) {
+        write_redacted_literal(writer, term);
+        return;
+    } else if (term.Size() == 0 || !term[0].IsInt()) {
+        // This isn't a valid term, so the query will fail anyway.
+        term.Accept(*writer);
+        return;
+    }
+
+    int type = term[0].GetInt();
+    writer->StartArray();
+    writer->Int(type);
+    for (rapidjson::SizeType i = 1; i < term.Size(); ++i) {
+        const rapidjson::Value &part = term[i];
+        if (type == Term::DATUM) {
+            write_redacted_literal(writer, part);
+        } else if (i == 1 && part.IsArray()) {
+            writer->StartArray();
+            for (rapidjson::SizeType j = 0; j < part.Size(); ++j) {
+                const rapidjson::Value &arg = part[j];
+                if (type == Term::FUNC && j == 0) {
+                    // The function's variable ids
+                    arg.Accept(*writer);
+                } else if (keeps_literal_args(type) && is_literal(arg)) {
+                    arg.Accept(*writer);
+                } else {
+                    write_redacted_term(writer, arg);
+                }
+            }
+            writer->EndArray();
+        } else {
+            write_redacted_optargs(writer, part);
+        }
+    }
+    writer->EndArray();
+}
+
+/* A query is `[type, term, global_optargs]`. */
+void write_redacted_query(json_writer_t *writer, const rapidjson::Value &query) {
+    if (!query.IsArray() || query.Size() == 0) {
+        query.Accept(*writer);
+        return;
+    }
+    writer->StartArray();
+    query[0].Accept(*writer);
+    for (rapidjson::SizeType i = 1; i < query.Size(); ++i) {
+        if (i == 1) {
+            write_redacted_term(writer, query[i]);
+        } else {
+            write_redacted_optargs(writer, query[i]);
+        }
+    }
+    writer->EndArray();
+}
+
+}  // namespace
+
+std::string redacted_query_json(const rapidjson::Value &query) {
+    rapidjson::StringBuffer buffer;
+    json_writer_t writer(buffer);
+    write_redacted_query(&writer, query);
+    return std::string(buffer.GetString(), buffer.GetSize());
+}
+
+query_capture_t::query_capture_t(const query_capture_config_t &_config) :
+    config(_config),
+    started_at(get_ticks()) {
+#ifdef _WIN32
+    fd.reset(CreateFile(config.path.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ, NULL,
+                        CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL));
+    std::string error = fd.get() == INVALID_FD ? winerr_string(GetLastError()) : "";
+#else
+    int res;
+    do {
+        res = open(config.path.c_str(), O_WRONLY|O_APPEND|O_CREAT|O_TRUNC, 0644);
+    } while (res == INVALID_FD && get_errno() == EINTR);
+    fd.reset(res);
+    std::string error = fd.get() == INVALID_FD ? errno_string(get_errno()) : "";
+#endif
+
+    if (fd.get() == INVALID_FD) {
+        logERR("Could not open the query capture file '%s', so no queries will be "
+               "captured: %s", config.path.c_str(), error.c_str());
+    } else {
+        logNTC("Capturing %g%% of the queries to '%s'%s.\n",
+               config.sample_rate * 100, config.path.c_str(),
+               config.redact ? ", with their values redacted" : "");
+    }
+}
+
+query_capture_t::~query_capture_t() { }
+
+optional<query_capture_t::captured_query_t> query_capture_t::maybe_capture(
+        const ql::query_params_t &query_params) {
+    if (fd.get() == INVALID_FD
+        || query_params.type != Query::START
+        || randdouble() >= config.sample_rate) {
+        return r_nullopt;
+    }
+
+    captured_query_t query;
+    query.connection = query_params.query_cache->get_client_addr_port().to_string();
+    query.token = query_params.token;
+    query.noreply = query_params.noreply;
+
+    const rapidjson::Value &json = query_params.term_storage->original_query_json();
+    if (config.redact) {
+        query.query_json = redacted_query_json(json);
+    } else {
+        rapidjson::StringBuffer buffer;
+        json_writer_t writer(buffer);
+        json.Accept(writer);
+        query.query_json.assign(buffer.GetString(), buffer.GetSize());
+    }
+    return make_optional(std::move(query));
+}
+
+void query_capture_t::record(const captured_query_t &query,
+                             ticks_t start,
+                             ticks_t latency) {
+    std::string line = strprintf(
+        "{\"time\":%.6f,\"connection\":\"%s\",\"token\":%" PRIi64 ","
+        "\"noreply\":%s,\"latency_ms\":%.3f,\"query\":%s}\n",
+        ticks_to_secs(ticks_t{start.nanos - started_at.nanos}),
+        query.connection.c_str(),
+        query.token,
+        query.noreply ? "true" : "false",
+        ticks_to_secs(latency) * 1000.0,
+        query.query_json.c_str());
+    /* The file is opened with `O_APPEND`, so lines that are written concurrently by
+    different threads don't get mixed up. */
+    thread_pool_t::run_in_blocker_pool([&]() { write_blocking(line); });
+}
+
+void query_capture_t::write_blocking(const std::string &line) {
+#ifdef _WIN32
+    DWORD bytes_written;
+    UNUSED BOOL res = WriteFile(fd.get(), line.data(), line.size(), &bytes_written,
+                                nullptr);
+#else
+    // If the disk is full we just lose the line, there is nothing better to do.
+    UNUSED ssize_t res = ::write(fd.get(), line.data(), line.size());
+#endif
+}
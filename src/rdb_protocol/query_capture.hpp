@@ -0,0 +1,85 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_QUERY_CAPTURE_HPP_
+#define RDB_PROTOCOL_QUERY_CAPTURE_HPP_
+
+#include <stdint.h>
+
+#include <string>
+
+#include "arch/io/io_utils.hpp"
+#include "containers/optional.hpp"
+#include "rapidjson/document.h"
+#include "time.hpp"
+
+namespace ql {
+class query_params_t;
+}
+
+/* From `--capture-queries`, `--capture-sample-rate` and `--capture-redact`. */
+struct query_capture_config_t {
+    query_capture_config_t() : sample_rate(1.0), redact(false) { }
+
+    std::string path;
+    /* The fraction of queries to capture, from 0 to 1. */
+    double sample_rate;
+    /* Whether to replace the values in the queries with placeholders. */
+    bool redact;
+};
+
+/* Returns the query, which is in the JSON protocol, with its values replaced by
+placeholders as described below. */
+std::string redacted_query_json(const rapidjson::Value &query);
+
+/* `query_capture_t` records the queries that clients send to this server, so that
+`test/performance/replay.py` can replay them against a test cluster with the same
+concurrency and pacing. Each captured query is one line of JSON in the capture file:
+
+    {"time": 12.5, "connection": "10.0.0.5:51234", "token": 7, "noreply": false,
+     "latency_ms": 1.2, "query": [1, [15, [[14, ["test"]], "users"]], {}]}
+
+`time` is when the query arrived, in seconds since the capture started, and
+`latency_ms` is how long this server took to run it. `query` is the query as the
+client sent it, in the JSON protocol.
+
+Only `START` queries are captured. `CONTINUE`s are left to the replaying driver, and
+`EXECUTE`s can't be replayed without the `PREPARE` that they refer to.
+
+When redaction is on, strings in the query are replaced by runs of `x` of the same
+length and numbers by zero, so that the capture doesn't leak the data, but the query
+still has the same shape and roughly the same size. Table, database, field and index
+names are kept, as are the arguments that change what the query does, like those of
+`limit` and the optargs, so that the query still runs. */
+class query_capture_t {
+public:
+    /* What we have to take from a query before it runs, since running it consumes its
+    term storage. */
+    class captured_query_t {
+    public:
+        std::string connection;
+        int64_t token;
+        bool noreply;
+        std::string query_json;
+    };
+
+    explicit query_capture_t(const query_capture_config_t &config);
+    ~query_capture_t();
+
+    /* Returns the query if it was picked to be captured. */
+    optional<captured_query_t> maybe_capture(const ql::query_params_t &query_params);
+
+    /* Appends the query to the capture file. This blocks the calling coroutine while
+    the line is written on the blocker pool, but only the sampled queries pay for it,
+    and only after their latency has been measured. */
+    void record(const captured_query_t &query, ticks_t start, ticks_t latency);
+
+private:
+    void write_blocking(const std::string &line);
+
+    const query_capture_config_t config;
+    const ticks_t started_at;
+    scoped_fd_t fd;
+
+    DISABLE_COPYING(query_capture_t);
+};
+
+#endif  // RDB_PROTOCOL_QUERY_CAPTURE_HPP_
@@ -68,11 +68,22 @@ query_params_t::query_params_t(int64_t _token,
                                scoped_ptr_t<term_storage_t> &&_term_storage) :
         query_cache(_query_cache),
         term_storage(std::move(_term_storage)),
-        id(query_cache), token(_token), noreply(false), profile(false) {
+        id(query_cache), token(_token), noreply(false), profile(false),
+        explain(false) {
     // Parse out information that is needed before query evaluation
     type = term_storage->query_type();
     noreply = term_storage->static_optarg_as_bool("noreply", noreply);
     profile = term_storage->static_optarg_as_bool("profile", profile);
+    explain = term_storage->static_optarg_as_bool("explain", explain);
+    if (type == Query::START || type == Query::EXECUTE) {
+        optional<std::string> traceparent =
+            term_storage->static_optarg_as_string("traceparent");
+        trace_context_t context;
+        if (traceparent.has_value() && trace_context_t::parse(*traceparent, &context)) {
+            trace_context.set(std::move(context));
+        }
+        priority = term_storage->static_optarg_as_string("priority");
+    }
 }
 
 } // namespace ql
@@ -4,9 +4,11 @@
 
 #include "concurrency/new_semaphore.hpp"
 #include "containers/intrusive_list.hpp"
+#include "containers/optional.hpp"
 #include "containers/scoped.hpp"
 #include "rdb_protocol/error.hpp"
 #include "rdb_protocol/ql2proto.hpp"
+#include "rdb_protocol/query_trace.hpp"
 
 namespace ql {
 
@@ -45,6 +47,11 @@ public:
     Query::QueryType type;
     bool noreply;
     bool profile;
+    bool explain;
+    // From the `traceparent` global optarg, if the client passed a valid one
+    optional<trace_context_t> trace_context;
+    // The `priority` global optarg, if the client passed a string
+    optional<std::string> priority;
 
     new_semaphore_in_line_t throttler;
 
@@ -1,6 +1,7 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "rdb_protocol/query_server.hpp"
 
+#include "perfmon/foreground_load.hpp"
 #include "perfmon/perfmon.hpp"
 #include "rdb_protocol/pseudo_time.hpp"
 #include "rdb_protocol/rdb_backtrace.hpp"
@@ -12,7 +13,8 @@
 rdb_query_server_t::rdb_query_server_t(
     const std::set<ip_address_t> &local_addresses, int port,
     rdb_context_t *_rdb_ctx, server_config_client_t *_server_config_client,
-    const server_id_t &_server_id, tls_ctx_t *tls_ctx
+    const server_id_t &_server_id, tls_ctx_t *tls_ctx,
+    const optional<query_capture_config_t> &query_capture_config
 ) :
     server(
         _rdb_ctx, local_addresses, port, this, default_http_timeout_sec, tls_ctx
@@ -20,7 +22,11 @@ rdb_query_server_t::rdb_query_server_t(
     rdb_ctx(_rdb_ctx),
     server_config_client(_server_config_client),
     server_id(_server_id),
-    thread_counters(0) { }
+    thread_counters(0) {
+    if (query_capture_config.has_value()) {
+        query_capture.init(new query_capture_t(*query_capture_config));
+    }
+}
 
 http_app_t *rdb_query_server_t::get_http_app() {
     return &server;
@@ -40,11 +46,25 @@ void rdb_query_server_t::run_query(ql::query_params_t *query_params,
         scoped_perfmon_counter_t client_active(&rdb_ctx->stats.clients_active);
 
         switch (query_params->type) {
-        case Query::START: {
+        case Query::START: // fallthru
+        case Query::EXECUTE: {
+            optional<query_capture_t::captured_query_t> captured;
+            if (query_capture.has()) {
+                captured = query_capture->maybe_capture(*query_params);
+            }
+            ticks_t start = get_ticks();
             scoped_ptr_t<ql::query_cache_t::ref_t> query_ref =
                 query_params->query_cache->create(query_params, ql::pseudo::time_now(),
                                                   interruptor);
             query_ref->fill_response(response_out);
+            /* We don't record `CONTINUE`s, because on a changefeed they wait for
+            changes rather than doing work. */
+            ticks_t latency{get_ticks().nanos - start.nanos};
+            record_foreground_query_latency(latency);
+            rdb_ctx->stats.query_latency.record(ticks_to_secs(latency));
+            if (captured.has_value()) {
+                query_capture->record(*captured, start, latency);
+            }
         } break;
         case Query::CONTINUE: {
             scoped_ptr_t<ql::query_cache_t::ref_t> query_ref =
@@ -63,6 +83,19 @@ void rdb_query_server_t::run_query(ql::query_params_t *query_params,
             fill_server_info(response_out);
             response_out->set_type(Response::SERVER_INFO);
         } break;
+        case Query::PREPARE: {
+            int64_t handle = query_params->query_cache->prepare(query_params);
+            response_out->set_type(Response::SUCCESS_ATOM);
+            response_out->set_data(ql::datum_t(static_cast<double>(handle)));
+        } break;
+        case Query::UNPREPARE: {
+            query_params->query_cache->unprepare(query_params);
+            response_out->set_type(Response::SUCCESS_SEQUENCE);
+        } break;
+        case Query::CHUNK: {
+            query_params->query_cache->push_chunk(query_params, interruptor);
+            response_out->set_type(Response::SUCCESS_SEQUENCE);
+        } break;
         default: unreachable();
         }
     } catch (const ql::bt_exc_t &ex) {
@@ -9,6 +9,8 @@
 #include "concurrency/one_per_thread.hpp"
 #include "client_protocol/server.hpp"
 #include "clustering/administration/servers/config_client.hpp"
+#include "containers/scoped.hpp"
+#include "rdb_protocol/query_capture.hpp"
 
 namespace ql {
 class query_params_t;
@@ -23,7 +25,8 @@ public:
     rdb_query_server_t(
       const std::set<ip_address_t> &local_addresses, int port,
       rdb_context_t *_rdb_ctx, server_config_client_t *_server_config_client,
-      const server_id_t &_server_id, tls_ctx_t *tls_ctx);
+      const server_id_t &_server_id, tls_ctx_t *tls_ctx,
+      const optional<query_capture_config_t> &query_capture_config);
 
     http_app_t *get_http_app();
     int get_port() const;
@@ -41,6 +44,7 @@ private:
     server_config_client_t *server_config_client;
     server_id_t server_id;
     one_per_thread_t<int> thread_counters;
+    scoped_ptr_t<query_capture_t> query_capture;
 
     DISABLE_COPYING(rdb_query_server_t);
 };
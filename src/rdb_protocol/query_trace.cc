@@ -0,0 +1,105 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/query_trace.hpp"
+
+#include <stdlib.h>
+
+#include "containers/uuid.hpp"
+#include "random.hpp"
+
+namespace ql {
+
+/* One in this many queries is traced even if the client didn't ask for it. */
+const int QUERY_TRACE_SAMPLE_ONE_IN = 1000;
+/* The number of spans each thread keeps. */
+const size_t QUERY_SPAN_LOG_SIZE = 100;
+
+static bool is_lowercase_hex(const std::string &s) {
+    for (char c : s) {
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::string random_hex(size_t num_digits) {
+    static const char digits[] = "0123456789abcdef";
+    std::string res;
+    while (res.size() < num_digits) {
+        uuid_u uuid = generate_uuid();
+        for (size_t i = 0; i < uuid_u::static_size() && res.size() < num_digits; ++i) {
+            res.push_back(digits[uuid.data()[i] >> 4]);
+            res.push_back(digits[uuid.data()[i] & 0xf]);
+        }
+    }
+    return res;
+}
+
+bool trace_context_t::parse(const std::string &traceparent, trace_context_t *out) {
+    // "00-" + 32 + "-" + 16 + "-" + 2
+    if (traceparent.size() != 55
+        || traceparent.compare(0, 3, "00-") != 0
+        || traceparent[35] != '-'
+        || traceparent[52] != '-') {
+        return false;
+    }
+    std::string trace_id = traceparent.substr(3, 32);
+    std::string parent_id = traceparent.substr(36, 16);
+    std::string flags = traceparent.substr(53, 2);
+    if (!is_lowercase_hex(trace_id) || !is_lowercase_hex(parent_id)
+        || !is_lowercase_hex(flags)
+        || trace_id == std::string(32, '0') || parent_id == std::string(16, '0')) {
+        return false;
+    }
+    out->trace_id = std::move(trace_id);
+    out->parent_id = std::move(parent_id);
+    out->sampled = (strtol(flags.c_str(), nullptr, 16) & 1) != 0;
+    return true;
+}
+
+optional<trace_context_t> trace_context_t::maybe_sample(
+        const optional<trace_context_t> &from_client) {
+    if (from_client.has_value() && from_client->sampled) {
+        return from_client;
+    }
+    if (randint(QUERY_TRACE_SAMPLE_ONE_IN) != 0) {
+        return r_nullopt;
+    }
+    trace_context_t res;
+    if (from_client.has_value()) {
+        res = *from_client;
+    } else {
+        res.trace_id = random_hex(32);
+    }
+    res.sampled = true;
+    return make_optional(res);
+}
+
+datum_t query_span_t::to_datum() const {
+    datum_object_builder_t builder;
+    builder.overwrite("trace_id", datum_t(datum_string_t(context.trace_id)));
+    builder.overwrite("span_id", datum_t(datum_string_t(span_id)));
+    builder.overwrite("parent_id", context.parent_id.empty()
+        ? datum_t::null()
+        : datum_t(datum_string_t(context.parent_id)));
+    builder.overwrite("start_time",
+        datum_t(static_cast<double>(start_time) / MILLION));
+    builder.overwrite("duration_sec",
+        datum_t(static_cast<double>(duration.micros) / MILLION));
+    builder.overwrite("query", datum_t(datum_string_t(query)));
+    builder.overwrite("profile", profile.has() ? profile : datum_t::null());
+    return std::move(builder).to_datum();
+}
+
+void query_span_log_t::record(query_span_t &&span) {
+    spans_.push_back(std::move(span));
+    while (spans_.size() > QUERY_SPAN_LOG_SIZE) {
+        spans_.pop_front();
+    }
+}
+
+std::string generate_span_id() {
+    return random_hex(16);
+}
+
+}  // namespace ql
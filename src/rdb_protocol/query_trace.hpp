@@ -0,0 +1,66 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_QUERY_TRACE_HPP_
+#define RDB_PROTOCOL_QUERY_TRACE_HPP_
+
+#include <deque>
+#include <string>
+
+#include "containers/optional.hpp"
+#include "rdb_protocol/datum.hpp"
+#include "time.hpp"
+
+namespace ql {
+
+/* `trace_context_t` identifies the trace a query belongs to, in the style of the W3C
+`traceparent` header: `00-<trace id>-<parent span id>-<flags>`, where the ids are 32 and
+16 lowercase hexadecimal digits and bit 0 of the flags means "sampled". Clients pass
+it in the `traceparent` global optarg. */
+class trace_context_t {
+public:
+    // Returns `false` if `traceparent` isn't a valid version 00 `traceparent`.
+    static bool parse(const std::string &traceparent, trace_context_t *out);
+
+    // Decides whether a query should be traced. Queries whose client sampled them are
+    // always traced; others are traced with a small probability, starting a new trace
+    // if the client didn't pass one.
+    static optional<trace_context_t> maybe_sample(
+        const optional<trace_context_t> &from_client);
+
+    std::string trace_id;
+    // Empty if the trace started on this server.
+    std::string parent_id;
+    bool sampled;
+};
+
+/* A `query_span_t` covers one request (`START`, `EXECUTE` or `CONTINUE`) of a traced
+query. `profile` is the query's `profile::trace_t`, which has the time spent on each
+hop, including the shards and replicas that the reads and writes were sent to. */
+class query_span_t {
+public:
+    datum_t to_datum() const;
+
+    trace_context_t context;
+    std::string span_id;
+    microtime_t start_time;
+    kiloticks_t duration;
+    std::string query;
+    datum_t profile;
+};
+
+/* Keeps the spans most recently recorded on one thread, for the admin HTTP server's
+`/traces` endpoint. */
+class query_span_log_t {
+public:
+    void record(query_span_t &&span);
+    const std::deque<query_span_t> &spans() const { return spans_; }
+
+private:
+    std::deque<query_span_t> spans_;
+};
+
+// Returns a new random span id.
+std::string generate_span_id();
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_QUERY_TRACE_HPP_
@@ -0,0 +1,201 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/read_cache.hpp"
+
+#include "arch/runtime/coroutines.hpp"
+#include "clustering/administration/tables/table_metadata.hpp"
+#include "clustering/table_manager/table_meta_client.hpp"
+#include "concurrency/auto_drainer.hpp"
+#include "rdb_protocol/changefeed.hpp"
+#include "time.hpp"
+
+/* How often each thread checks whether a table still has the cache turned on. */
+static const time_t READ_CACHE_RECHECK_SECS = 5;
+
+/* The number of rows each thread keeps per table. Past this, rows are evicted in key
+order, which is as good as any for the small tables the cache is meant for. */
+static const size_t READ_CACHE_MAX_ROWS = 10000;
+
+class read_cache_t::table_cache_t : public ql::changefeed::change_watcher_t {
+public:
+    table_cache_t(const namespace_id_t &_table_id,
+                  ql::changefeed::client_t *_changefeed_client,
+                  table_meta_client_t *_table_meta_client,
+                  auto_drainer_t *_drainer)
+        : table_id(_table_id),
+          changefeed_client(_changefeed_client),
+          table_meta_client(_table_meta_client),
+          drainer(_drainer),
+          watching(false),
+          refreshing(false),
+          next_check({0}),
+          generation(0),
+          stops(0) { }
+
+    ~table_cache_t() {
+        if (watching) {
+            changefeed_client->remove_watcher(this);
+        }
+    }
+
+    /* Starts checking the table's config in the background if it's time to. */
+    void maybe_refresh() {
+        if (!refreshing && get_ticks().nanos >= next_check.nanos) {
+            refreshing = true;
+            coro_t::spawn_sometime(
+                std::bind(&table_cache_t::refresh, this, drainer->lock()));
+        }
+    }
+
+    bool is_active() const { return watching; }
+
+    const ql::datum_t *find(const store_key_t &key) const {
+        auto it = rows.find(key);
+        return it == rows.end() ? nullptr : &it->second;
+    }
+
+    uint64_t get_generation() const { return generation; }
+
+    void insert(const store_key_t &key, const ql::datum_t &row) {
+        guarantee(watching);
+        if (rows.size() >= READ_CACHE_MAX_ROWS) {
+            rows.erase(rows.begin());
+        }
+        rows[key] = row;
+    }
+
+    /* Forgets all rows, and keeps reads that are in flight from adding theirs. */
+    void forget_all() {
+        ++generation;
+        rows.clear();
+    }
+
+    void on_change(const store_key_t &pkey) final {
+        ++generation;
+        rows.erase(pkey);
+    }
+
+    void on_stop() final {
+        ++stops;
+        watching = false;
+        forget_all();
+        // Try to watch the table again on the next read.
+        next_check = get_ticks();
+    }
+
+private:
+    void refresh(auto_drainer_t::lock_t keepalive) {
+        bool enabled;
+        try {
+            table_config_and_shards_t config;
+            table_meta_client->get_config(
+                table_id, keepalive.get_drain_signal(), &config);
+            enabled = config.config.read_cache;
+        } catch (const no_such_table_exc_t &) {
+            enabled = false;
+        } catch (const failed_table_op_exc_t &) {
+            enabled = false;
+        } catch (const interrupted_exc_t &) {
+            return;
+        }
+        if (enabled && !watching) {
+            uint64_t stops_before = stops;
+            try {
+                changefeed_client->add_watcher(
+                    table_id, this, keepalive.get_drain_signal());
+                // If the feed stopped while we were waiting, the watcher was already
+                // removed again.
+                watching = (stops == stops_before);
+            } catch (const cannot_perform_query_exc_t &) {
+                // We'll try again at the next check.
+            } catch (const interrupted_exc_t &) {
+                return;
+            }
+        } else if (!enabled && watching) {
+            watching = false;
+            forget_all();
+            changefeed_client->remove_watcher(this);
+        }
+        next_check.nanos =
+            get_ticks().nanos + secs_to_ticks(READ_CACHE_RECHECK_SECS).nanos;
+        refreshing = false;
+    }
+
+    const namespace_id_t table_id;
+    ql::changefeed::client_t *const changefeed_client;
+    table_meta_client_t *const table_meta_client;
+    auto_drainer_t *const drainer;
+
+    // Whether we're hearing about the changes to the table. Rows are only cached
+    // while we are.
+    bool watching;
+    bool refreshing;
+    ticks_t next_check;
+
+    std::map<store_key_t, ql::datum_t> rows;
+    // Goes up with every change, so that a read can tell whether the row it read may
+    // have changed before it got to insert it.
+    uint64_t generation;
+    uint64_t stops;
+};
+
+class read_cache_t::thread_cache_t {
+public:
+    thread_cache_t() { }
+
+    table_cache_t *get_table(read_cache_t *parent, const namespace_id_t &table_id) {
+        auto it = tables.find(table_id);
+        if (it == tables.end()) {
+            it = tables.insert(std::make_pair(
+                table_id,
+                make_scoped<table_cache_t>(table_id,
+                                           parent->changefeed_client,
+                                           parent->table_meta_client,
+                                           &drainer))).first;
+        }
+        return it->second.get();
+    }
+
+    table_cache_t *find_table(const namespace_id_t &table_id) {
+        auto it = tables.find(table_id);
+        return it == tables.end() ? nullptr : it->second.get();
+    }
+
+private:
+    std::map<namespace_id_t, scoped_ptr_t<table_cache_t> > tables;
+    // Destroyed first, so that the refreshes are done before the tables go away.
+    auto_drainer_t drainer;
+
+    DISABLE_COPYING(thread_cache_t);
+};
+
+read_cache_t::read_cache_t(ql::changefeed::client_t *_changefeed_client,
+                           table_meta_client_t *_table_meta_client)
+    : changefeed_client(_changefeed_client),
+      table_meta_client(_table_meta_client) { }
+
+read_cache_t::~read_cache_t() { }
+
+ql::datum_t read_cache_t::read_row(const namespace_id_t &table_id,
+                                   const store_key_t &key,
+                                   const std::function<ql::datum_t()> &read) {
+    table_cache_t *table = caches.get()->get_table(this, table_id);
+    table->maybe_refresh();
+    if (!table->is_active()) {
+        return read();
+    }
+    if (const ql::datum_t *row = table->find(key)) {
+        return *row;
+    }
+    uint64_t generation = table->get_generation();
+    ql::datum_t row = read();
+    if (table->is_active() && table->get_generation() == generation) {
+        table->insert(key, row);
+    }
+    return row;
+}
+
+void read_cache_t::note_write(const namespace_id_t &table_id) {
+    if (table_cache_t *table = caches.get()->find_table(table_id)) {
+        table->forget_all();
+    }
+}
@@ -0,0 +1,57 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_READ_CACHE_HPP_
+#define RDB_PROTOCOL_READ_CACHE_HPP_
+
+#include <functional>
+#include <map>
+
+#include "btree/keys.hpp"
+#include "concurrency/one_per_thread.hpp"
+#include "containers/uuid.hpp"
+#include "rdb_protocol/datum.hpp"
+
+class table_meta_client_t;
+namespace ql {
+namespace changefeed {
+class client_t;
+}
+}
+
+/* `read_cache_t` keeps the results of the point reads that a server routes for the
+tables whose config has `read_cache` set, so that repeated `get`s of the same rows are
+answered without going to the shards. Each thread has its own cache, which watches the
+table through the server's changefeed client and forgets a row when a change to it
+arrives.
+
+Changes made through other servers (or other threads of this one) reach the cache a
+little after they're acknowledged, so a cached read can miss a write that has just
+finished elsewhere, much like an `outdated` read. A connection's own writes are never
+missed, since they go through the same thread's cache. `majority` reads always go to
+the shards. */
+class read_cache_t {
+public:
+    read_cache_t(ql::changefeed::client_t *changefeed_client,
+                 table_meta_client_t *table_meta_client);
+    ~read_cache_t();
+
+    /* Returns the row with the primary key `key` from the cache if the table has the
+    cache turned on and the row is in it, and what `read` returns otherwise. */
+    ql::datum_t read_row(const namespace_id_t &table_id,
+                         const store_key_t &key,
+                         const std::function<ql::datum_t()> &read);
+
+    /* Called before and after each write to the table through this thread. */
+    void note_write(const namespace_id_t &table_id);
+
+private:
+    class table_cache_t;
+    class thread_cache_t;
+
+    ql::changefeed::client_t *const changefeed_client;
+    table_meta_client_t *const table_meta_client;
+    one_per_thread_t<thread_cache_t> caches;
+
+    DISABLE_COPYING(read_cache_t);
+};
+
+#endif  // RDB_PROTOCOL_READ_CACHE_HPP_
@@ -15,7 +15,21 @@
 #include "rdb_protocol/func.hpp"
 #include "rdb_protocol/math_utils.hpp"
 #include "rdb_protocol/protocol.hpp"
-
+#include "rdb_protocol/read_cache.hpp"
+
+/* Bounded-staleness reads take their bound from the `max_staleness` optarg to `run`,
+in seconds. */
+static void set_max_staleness(ql::env_t *env, read_t *read) {
+    r_sanity_check(read->read_mode == read_mode_t::BOUNDED_STALENESS);
+    scoped_ptr_t<ql::val_t> v = env->get_optarg(env, "max_staleness");
+    rcheck_datum(v.has(), ql::base_exc_t::LOGIC,
+        "Read mode `bounded` requires the `max_staleness` optarg to `run`.");
+    double seconds = v->as_num();
+    rcheck_datum(seconds >= 0 && seconds <= 365 * 24 * 3600, ql::base_exc_t::LOGIC,
+        strprintf("`max_staleness` must be between 0 and one year (got %g seconds).",
+                  seconds));
+    read->max_staleness_ms = static_cast<int64_t>(seconds * 1000);
+}
 
 namespace_id_t real_table_t::get_id() const {
     return uuid;
@@ -27,7 +41,30 @@ const std::string &real_table_t::get_pkey() const {
 
 ql::datum_t real_table_t::read_row(
     ql::env_t *env, ql::datum_t pval, read_mode_t read_mode) {
-    read_t read(point_read_t(store_key_t(pval.print_primary())),
+    store_key_t key(pval.print_primary());
+    auto do_read = [&]() {
+        read_t read(point_read_t(key), env->profile(), read_mode);
+        read_response_t res;
+        read_with_profile(env, read, &res);
+        point_read_response_t *p_res =
+            boost::get<point_read_response_t>(&res.response);
+        r_sanity_check(p_res);
+        return p_res->data;
+    };
+    /* `majority` reads must see every acknowledged write, and profiled reads should
+    show where the time goes, so neither is answered from the cache. */
+    if (read_cache != nullptr
+        && read_mode != read_mode_t::MAJORITY
+        && read_mode != read_mode_t::DEBUG_DIRECT
+        && env->profile() == profile_bool_t::DONT_PROFILE) {
+        return read_cache->read_row(uuid, key, do_read);
+    }
+    return do_read();
+}
+
+ql::datum_t real_table_t::read_row_projected(
+    ql::env_t *env, ql::datum_t pval, ql::datum_t paths, read_mode_t read_mode) {
+    read_t read(point_read_t(store_key_t(pval.print_primary()), paths),
                 env->profile(), read_mode);
     read_response_t res;
     read_with_profile(env, read, &res);
@@ -36,6 +73,20 @@ ql::datum_t real_table_t::read_row(
     return p_res->data;
 }
 
+bool real_table_t::read_sample(ql::env_t *env, uint64_t num, read_mode_t read_mode,
+                               std::vector<ql::datum_t> *rows_out) {
+    read_t read(sample_read_t(num), env->profile(), read_mode);
+    read_response_t res;
+    read_with_profile(env, read, &res);
+    sample_read_response_t *s_res = boost::get<sample_read_response_t>(&res.response);
+    r_sanity_check(s_res);
+    if (!s_res->complete) {
+        return false;
+    }
+    *rows_out = std::move(s_res->rows);
+    return true;
+}
+
 scoped_ptr_t<ql::reader_t> real_table_t::read_all_with_sindexes(
         ql::env_t *env,
         const std::string &sindex,
@@ -104,6 +155,34 @@ counted_t<ql::datum_stream_t> real_table_t::read_all(
     }
 }
 
+counted_t<ql::datum_stream_t> real_table_t::read_all_intersected(
+        ql::env_t *env,
+        const std::string &sindex,
+        ql::backtrace_id_t bt,
+        const std::string &table_name,
+        const ql::datumspec_t &datumspec,
+        const std::map<std::string, ql::datum_t> &intersect,
+        read_mode_t read_mode) {
+    // The shards look up the other indexes for the same rows as the main one, which
+    // has to be a secondary index for that.
+    rcheck_datum(sindex != get_pkey(), ql::base_exc_t::LOGIC,
+                 "`get_all` can only use `intersect` with a secondary `index`.");
+    if (datumspec.is_empty()) {
+        return make_counted<ql::lazy_datum_stream_t>(
+            make_scoped<ql::empty_reader_t>(
+                counted_t<real_table_t>(this),
+                table_name),
+            bt);
+    }
+    return make_counted<ql::lazy_datum_stream_t>(
+        make_scoped<ql::rget_reader_t>(
+            counted_t<real_table_t>(this),
+            ql::sindex_readgen_t::make(
+                env, table_name, read_mode, sindex, datumspec, sorting_t::UNORDERED,
+                require_sindexes_t::NO, intersect)),
+        bt);
+}
+
 counted_t<ql::datum_stream_t> real_table_t::read_changes(
         ql::env_t *env,
         const ql::changefeed::streamspec_t &ss,
@@ -149,6 +228,9 @@ ql::datum_t real_table_t::read_nearest(
         sindex,
         env->get_serializable_env());
     read_t read(geo_read, env->profile(), read_mode);
+    if (read_mode == read_mode_t::BOUNDED_STALENESS) {
+        set_max_staleness(env, &read);
+    }
     read_response_t res;
     try {
         namespace_access.get()->read(
@@ -346,18 +428,32 @@ void real_table_t::read_with_profile(ql::env_t *env, const read_t &read,
         env->profile() == profile_bool_t::PROFILE,
         (read.read_mode == read_mode_t::OUTDATED ? "Perform outdated read." :
          (read.read_mode == read_mode_t::DEBUG_DIRECT ? "Perform debug_direct read." :
+         (read.read_mode == read_mode_t::BOUNDED_STALENESS ?
+                                            "Perform bounded-staleness read." :
          (read.read_mode == read_mode_t::SINGLE ? "Perform read." :
-                                                  "Perform majority read."))),
+                                                  "Perform majority read.")))),
         env->trace);
     profile::splitter_t splitter(env->trace);
     /* propagate whether or not we're doing profiles */
     r_sanity_check(read.profile == env->profile());
 
+    read_t adjusted_read;
+    const read_t *read_to_send = &read;
+    if (read.read_mode == read_mode_t::BOUNDED_STALENESS
+        || read.priority != env->query_priority()) {
+        adjusted_read = read;
+        if (read.read_mode == read_mode_t::BOUNDED_STALENESS) {
+            set_max_staleness(env, &adjusted_read);
+        }
+        adjusted_read.priority = env->query_priority();
+        read_to_send = &adjusted_read;
+    }
+
     /* Do the actual read. */
     try {
         namespace_access.get()->read(
             env->get_user_context(),
-            read,
+            *read_to_send,
             response,
             order_token_t::ignore,
             env->interruptor);
@@ -367,6 +463,10 @@ void real_table_t::read_with_profile(ql::env_t *env, const read_t &read,
         rfail_datum(ql::base_exc_t::PERMISSION_ERROR, "%s", error.what());
     }
 
+    if (env->resource_usage() != nullptr) {
+        env->resource_usage()->shard_reads += response->n_shards;
+    }
+
     /* Append the results of the profile to the current task */
     splitter.give_splits(response->n_shards, response->event_log);
 }
@@ -378,6 +478,14 @@ void real_table_t::write_with_profile(ql::env_t *env, write_t *write,
     profile::splitter_t splitter(env->trace);
     /* propagate whether or not we're doing profiles */
     write->profile = env->profile();
+    write->priority = env->query_priority();
+
+    /* The cache forgets the table's rows both before and after the write, so that
+    neither reads that are in flight nor later ones keep what the write changed. If
+    the write fails, the feed still lets it know about any rows that did change. */
+    if (read_cache != nullptr) {
+        read_cache->note_write(uuid);
+    }
 
     /* Do the actual write. */
     try {
@@ -403,6 +511,14 @@ void real_table_t::write_with_profile(ql::env_t *env, write_t *write,
         rfail_datum(ql::base_exc_t::PERMISSION_ERROR, "%s", error.what());
     }
 
+    if (read_cache != nullptr) {
+        read_cache->note_write(uuid);
+    }
+
+    if (env->resource_usage() != nullptr) {
+        env->resource_usage()->shard_writes += response->n_shards;
+    }
+
     /* Append the results of the profile to the current task */
     splitter.give_splits(response->n_shards, response->event_log);
 }
@@ -17,6 +17,7 @@ namespace changefeed {
 class client_t;
 }
 }
+class read_cache_t;
 class table_meta_client_t;
 
 /* `real_table_t` is a concrete subclass of `base_table_t` that routes its queries across
@@ -35,17 +36,23 @@ public:
             namespace_interface_access_t _namespace_access,
             const std::string &_pkey,
             ql::changefeed::client_t *_changefeed_client,
-            table_meta_client_t *table_meta_client) :
+            table_meta_client_t *table_meta_client,
+            read_cache_t *_read_cache) :
         uuid(_uuid),
         namespace_access(_namespace_access),
         pkey(_pkey),
         changefeed_client(_changefeed_client),
-        m_table_meta_client(table_meta_client) { }
+        m_table_meta_client(table_meta_client),
+        read_cache(_read_cache) { }
 
     namespace_id_t get_id() const;
     const std::string &get_pkey() const;
 
     ql::datum_t read_row(ql::env_t *env, ql::datum_t pval, read_mode_t read_mode);
+    ql::datum_t read_row_projected(ql::env_t *env, ql::datum_t pval,
+                                   ql::datum_t paths, read_mode_t read_mode);
+    bool read_sample(ql::env_t *env, uint64_t num, read_mode_t read_mode,
+                     std::vector<ql::datum_t> *rows_out);
     counted_t<ql::datum_stream_t> read_all(
         ql::env_t *env,
         const std::string &sindex,
@@ -54,6 +61,14 @@ public:
         const ql::datumspec_t &datumspec,
         sorting_t sorting,
         read_mode_t read_mode);
+    counted_t<ql::datum_stream_t> read_all_intersected(
+        ql::env_t *env,
+        const std::string &sindex,
+        ql::backtrace_id_t bt,
+        const std::string &table_name,
+        const ql::datumspec_t &datumspec,
+        const std::map<std::string, ql::datum_t> &intersect,
+        read_mode_t read_mode);
     counted_t<ql::datum_stream_t> read_changes(
         ql::env_t *env,
         const ql::changefeed::streamspec_t &ss,
@@ -128,6 +143,8 @@ private:
     std::string pkey;
     ql::changefeed::client_t *changefeed_client;
     table_meta_client_t *m_table_meta_client;
+    // May be null, in which case nothing is cached.
+    read_cache_t *read_cache;
 };
 
 #endif /* RDB_PROTOCOL_REAL_TABLE_HPP_ */
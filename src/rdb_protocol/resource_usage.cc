@@ -0,0 +1,43 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/resource_usage.hpp"
+
+#include <inttypes.h>
+
+#include "utils.hpp"
+
+namespace ql {
+
+query_resource_usage_t::query_resource_usage_t() :
+    evaluation_micros(0),
+    shard_reads(0),
+    shard_writes(0),
+    rows_read(0),
+    rows_returned(0) { }
+
+datum_t query_resource_usage_t::to_datum() const {
+    datum_object_builder_t builder;
+    builder.overwrite("evaluation_time",
+        datum_t(static_cast<double>(evaluation_micros) / MILLION));
+    builder.overwrite("shard_reads", datum_t(static_cast<double>(shard_reads)));
+    builder.overwrite("shard_writes", datum_t(static_cast<double>(shard_writes)));
+    builder.overwrite("rows_read", datum_t(static_cast<double>(rows_read)));
+    builder.overwrite("rows_returned", datum_t(static_cast<double>(rows_returned)));
+    return std::move(builder).to_datum();
+}
+
+std::string query_resource_usage_t::to_string() const {
+    return strprintf(
+        "%.3fs evaluating, %" PRIu64 " shard reads, %" PRIu64 " shard writes, "
+        "%" PRIu64 " rows read, %" PRIu64 " rows returned",
+        static_cast<double>(evaluation_micros) / MILLION,
+        shard_reads, shard_writes, rows_read, rows_returned);
+}
+
+RDB_IMPL_SERIALIZABLE_5_FOR_CLUSTER(query_resource_usage_t,
+                                    evaluation_micros,
+                                    shard_reads,
+                                    shard_writes,
+                                    rows_read,
+                                    rows_returned);
+
+}  // namespace ql
@@ -0,0 +1,44 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_RESOURCE_USAGE_HPP_
+#define RDB_PROTOCOL_RESOURCE_USAGE_HPP_
+
+#include <stdint.h>
+
+#include <string>
+
+#include "rdb_protocol/datum.hpp"
+#include "rpc/serialize_macros.hpp"
+
+namespace ql {
+
+/* `query_resource_usage_t` is a cheap tally of the work a query has done. Unlike
+`profile::trace_t`, it's kept for every query, so that `rethinkdb.jobs` and the slow
+query log can show which queries are expensive. The query's `env_t` points to it. */
+class query_resource_usage_t {
+public:
+    query_resource_usage_t();
+
+    /* Microseconds spent evaluating the query on the server that parsed it, including
+    batches that were read ahead of the client but not the time spent waiting for the
+    client. This is wall-clock time, so it also covers time spent waiting for other
+    servers. */
+    uint64_t evaluation_micros;
+
+    /* The number of shards that reads and writes went to, summed over all of the
+    reads and writes the query did. */
+    uint64_t shard_reads;
+    uint64_t shard_writes;
+
+    /* Rows that range reads got back from the shards, and rows sent to the client. */
+    uint64_t rows_read;
+    uint64_t rows_returned;
+
+    datum_t to_datum() const;
+    std::string to_string() const;
+};
+
+RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(query_resource_usage_t);
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_RESOURCE_USAGE_HPP_
@@ -0,0 +1,134 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/row_cache.hpp"
+
+#include <algorithm>
+
+#include "config/args.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
+
+const size_t row_cache_t::MAX_BYTES = 4 * MEGABYTE;
+// Big rows would push out too many others, and cost little to decode compared to
+// sending them anyway.
+const size_t row_cache_t::MAX_ROW_BYTES = 64 * KILOBYTE;
+// Roughly what the map node, the list node and the key cost besides the row
+const size_t row_cache_t::ENTRY_OVERHEAD = 128;
+// Enough counters for a few times as many keys as fit in the cache when rows are
+// small, so that the estimates for the keys that matter are mostly exact.
+const size_t row_cache_t::SKETCH_WIDTH = 16384;
+const size_t row_cache_t::SKETCH_DEPTH = 4;
+const uint8_t row_cache_t::MAX_COUNT = 15;
+const uint64_t row_cache_t::LOOKUPS_PER_HALVING = 10 * row_cache_t::SKETCH_WIDTH;
+
+row_cache_t::row_cache_t() :
+    used_bytes(0),
+    generation(0),
+    sketch(SKETCH_WIDTH * SKETCH_DEPTH, 0),
+    lookups_until_halving(LOOKUPS_PER_HALVING) { }
+
+bool row_cache_t::find(const store_key_t &key, ql::datum_t *row_out) {
+    count_lookup(key);
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        return false;
+    }
+    lru.splice(lru.begin(), lru, it->second.lru_it);
+    *row_out = it->second.row;
+    return true;
+}
+
+void row_cache_t::maybe_insert(const store_key_t &key,
+                               const ql::datum_t &row,
+                               uint64_t read_generation) {
+    if (read_generation != generation || entries.count(key) != 0) {
+        return;
+    }
+    size_t size = ql::datum_serialized_size(
+        row, ql::check_datum_serialization_errors_t::NO) + key.size() + ENTRY_OVERHEAD;
+    if (size > MAX_ROW_BYTES) {
+        return;
+    }
+    if (used_bytes + size > MAX_BYTES) {
+        // Only push out the least recently used row for one that's read more often.
+        if (estimate_lookups(key) <= estimate_lookups(lru.back())) {
+            return;
+        }
+        while (used_bytes + size > MAX_BYTES) {
+            erase(entries.find(lru.back()));
+        }
+    }
+    lru.push_front(key);
+    entry_t entry;
+    entry.row = row;
+    entry.size = size;
+    entry.lru_it = lru.begin();
+    entries.insert(std::make_pair(key, std::move(entry)));
+    used_bytes += size;
+}
+
+void row_cache_t::invalidate(const store_key_t &key) {
+    ++generation;
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        erase(it);
+    }
+}
+
+void row_cache_t::invalidate_range(const key_range_t &range) {
+    ++generation;
+    for (auto it = entries.lower_bound(range.left);
+         it != entries.end() && range.contains_key(it->first);) {
+        erase(it++);
+    }
+}
+
+void row_cache_t::erase(std::map<store_key_t, entry_t>::iterator it) {
+    used_bytes -= it->second.size;
+    lru.erase(it->second.lru_it);
+    entries.erase(it);
+}
+
+/* Hashes `key` once, then derives an independent-enough index for every row of the
+sketch by mixing in the row number (with the finalizer of SplitMix64). */
+static size_t sketch_index(uint64_t key_hash, size_t row, size_t width) {
+    uint64_t h = key_hash + (row + 1) * 0x9e3779b97f4a7c15ULL;
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return row * width + (h % width);
+}
+
+static uint64_t hash_key(const store_key_t &key) {
+    // FNV-1a
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < key.size(); ++i) {
+        h = (h ^ key.contents()[i]) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+void row_cache_t::count_lookup(const store_key_t &key) {
+    uint64_t h = hash_key(key);
+    for (size_t row = 0; row < SKETCH_DEPTH; ++row) {
+        uint8_t *counter = &sketch[sketch_index(h, row, SKETCH_WIDTH)];
+        if (*counter < MAX_COUNT) {
+            ++*counter;
+        }
+    }
+    --lookups_until_halving;
+    if (lookups_until_halving == 0) {
+        // Halving every count makes the sketch describe recent reads.
+        lookups_until_halving = LOOKUPS_PER_HALVING;
+        for (uint8_t &counter : sketch) {
+            counter /= 2;
+        }
+    }
+}
+
+uint8_t row_cache_t::estimate_lookups(const store_key_t &key) const {
+    uint64_t h = hash_key(key);
+    uint8_t estimate = MAX_COUNT;
+    for (size_t row = 0; row < SKETCH_DEPTH; ++row) {
+        estimate = std::min(estimate, sketch[sketch_index(h, row, SKETCH_WIDTH)]);
+    }
+    return estimate;
+}
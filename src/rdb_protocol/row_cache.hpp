@@ -0,0 +1,78 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_ROW_CACHE_HPP_
+#define RDB_PROTOCOL_ROW_CACHE_HPP_
+
+#include <list>
+#include <map>
+#include <vector>
+
+#include "btree/keys.hpp"
+#include "rdb_protocol/datum.hpp"
+
+/* `row_cache_t` keeps the decoded rows of the primary keys that a store's point reads
+ask for most often, so that reading them again skips walking the B-tree, copying the
+value out of its blocks and deserializing it.
+
+The cache holds at most `MAX_BYTES` worth of serialized rows. Whether a row is worth
+a place is decided by how often its key was looked up recently, which is counted in a
+small count-min sketch (like TinyLFU): a row only gets in if its key has been read more
+often than the key of the least recently used row it would push out. That keeps a scan
+over many cold keys from flushing out the hot ones.
+
+The store tells the cache about every change to a row, in the same place that it
+updates the secondary indexes, and about ranges that are erased. Reads remember the
+cache's generation before they go to the B-tree and only add the row if nothing was
+invalidated in the meantime, so a row that changed while it was being read is never
+cached. */
+class row_cache_t {
+public:
+    row_cache_t();
+
+    /* Counts a lookup of `key` and returns whether the row is cached. */
+    bool find(const store_key_t &key, ql::datum_t *row_out);
+
+    uint64_t get_generation() const { return generation; }
+
+    /* Caches `row`, which was read from the B-tree after the cache was at generation
+    `read_generation`, if it's still current and admitted. */
+    void maybe_insert(const store_key_t &key,
+                      const ql::datum_t &row,
+                      uint64_t read_generation);
+
+    void invalidate(const store_key_t &key);
+    void invalidate_range(const key_range_t &range);
+
+private:
+    struct entry_t {
+        ql::datum_t row;
+        size_t size;
+        std::list<store_key_t>::iterator lru_it;
+    };
+
+    void erase(std::map<store_key_t, entry_t>::iterator it);
+
+    // The frequency sketch
+    void count_lookup(const store_key_t &key);
+    uint8_t estimate_lookups(const store_key_t &key) const;
+
+    static const size_t MAX_BYTES;
+    static const size_t MAX_ROW_BYTES;
+    static const size_t ENTRY_OVERHEAD;
+    static const size_t SKETCH_WIDTH;
+    static const size_t SKETCH_DEPTH;
+    static const uint8_t MAX_COUNT;
+    static const uint64_t LOOKUPS_PER_HALVING;
+
+    std::map<store_key_t, entry_t> entries;
+    // Least recently used at the back
+    std::list<store_key_t> lru;
+    size_t used_bytes;
+    uint64_t generation;
+
+    std::vector<uint8_t> sketch;
+    uint64_t lookups_until_halving;
+
+    DISABLE_COPYING(row_cache_t);
+};
+
+#endif  // RDB_PROTOCOL_ROW_CACHE_HPP_
@@ -882,27 +882,43 @@ size_t datum_get_array_size(const shared_buf_ref_t<char> &array) {
     return static_cast<size_t>(num_elements);
 }
 
+/* The layout of a serialized array or object, so that we can find several of its
+elements while parsing the header only once. */
+struct datum_array_layout_t {
+    datum_offset_size_t offset_size;
+    size_t serialized_offset_size;
+    size_t num_elements;
+    // Where the offset table starts
+    size_t offsets_offset;
+    // Where the first element starts
+    size_t data_offset;
+};
+
 /* The format of `array` is:
      varint ser_size
      varint num_elements
      uint*_t offsets[num_elements - 1] // counted from `data`, first element omitted
      T data[num_elements] */
-size_t datum_get_element_offset(const shared_buf_ref_t<char> &array, size_t index) {
+datum_array_layout_t datum_get_array_layout(const shared_buf_ref_t<char> &array) {
     buffer_read_stream_t sz_read_stream(array.get(), array.get_safety_boundary());
     uint64_t ser_size = 0;
     guarantee_deserialization(deserialize_varint_uint64(&sz_read_stream, &ser_size),
                               "datum decode array");
-    const datum_offset_size_t offset_size = get_offset_size_from_inner_size(ser_size);
-    size_t serialized_offset_size;
-    switch (offset_size) {
+    datum_array_layout_t layout;
+    layout.offset_size = get_offset_size_from_inner_size(ser_size);
+    switch (layout.offset_size) {
     case datum_offset_size_t::U8BIT:
-        serialized_offset_size = serialize_universal_size_t<uint8_t>::value; break;
+        layout.serialized_offset_size = serialize_universal_size_t<uint8_t>::value;
+        break;
     case datum_offset_size_t::U16BIT:
-        serialized_offset_size = serialize_universal_size_t<uint16_t>::value; break;
+        layout.serialized_offset_size = serialize_universal_size_t<uint16_t>::value;
+        break;
     case datum_offset_size_t::U32BIT:
-        serialized_offset_size = serialize_universal_size_t<uint32_t>::value; break;
+        layout.serialized_offset_size = serialize_universal_size_t<uint32_t>::value;
+        break;
     case datum_offset_size_t::U64BIT:
-        serialized_offset_size = serialize_universal_size_t<uint64_t>::value; break;
+        layout.serialized_offset_size = serialize_universal_size_t<uint64_t>::value;
+        break;
     default:
         unreachable();
     }
@@ -911,59 +927,120 @@ size_t datum_get_element_offset(const shared_buf_ref_t<char> &array, size_t inde
     guarantee_deserialization(deserialize_varint_uint64(&sz_read_stream, &num_elements),
                               "datum decode array");
     guarantee(num_elements <= std::numeric_limits<size_t>::max());
-    const size_t sz = static_cast<size_t>(num_elements);
-
-    guarantee(index < sz);
+    layout.num_elements = static_cast<size_t>(num_elements);
+
+    layout.offsets_offset = static_cast<size_t>(sz_read_stream.tell());
+    layout.data_offset = layout.num_elements == 0
+        ? layout.offsets_offset
+        : layout.offsets_offset
+          + (layout.num_elements - 1) * layout.serialized_offset_size;
+    return layout;
+}
 
-    rassert(sz > 0);
-    const size_t data_offset =
-        static_cast<size_t>(sz_read_stream.tell())
-        + (num_elements - 1) * serialized_offset_size;
+size_t datum_get_element_offset(const shared_buf_ref_t<char> &array,
+                                const datum_array_layout_t &layout,
+                                size_t index) {
+    guarantee(index < layout.num_elements);
 
     if (index == 0) {
-        return data_offset;
-    } else {
-        const size_t element_offset_offset =
-            static_cast<size_t>(sz_read_stream.tell())
-            + (index - 1) * serialized_offset_size;
+        return layout.data_offset;
+    }
 
-        array.guarantee_in_boundary(element_offset_offset);
-        buffer_read_stream_t read_stream(
-            array.get() + element_offset_offset,
-            array.get_safety_boundary() - element_offset_offset);
+    const size_t element_offset_offset =
+        layout.offsets_offset + (index - 1) * layout.serialized_offset_size;
+
+    array.guarantee_in_boundary(element_offset_offset);
+    buffer_read_stream_t read_stream(
+        array.get() + element_offset_offset,
+        array.get_safety_boundary() - element_offset_offset);
+
+    uint64_t element_offset;
+    switch (layout.offset_size) {
+    case datum_offset_size_t::U8BIT: {
+        uint8_t off;
+        guarantee_deserialization(deserialize_universal(&read_stream, &off),
+                                  "datum decode array offset");
+        element_offset = off;
+    } break;
+    case datum_offset_size_t::U16BIT: {
+        uint16_t off;
+        guarantee_deserialization(deserialize_universal(&read_stream, &off),
+                                  "datum decode array offset");
+        element_offset = off;
+    } break;
+    case datum_offset_size_t::U32BIT: {
+        uint32_t off;
+        guarantee_deserialization(deserialize_universal(&read_stream, &off),
+                                  "datum decode array offset");
+        element_offset = off;
+    } break;
+    case datum_offset_size_t::U64BIT: {
+        uint64_t off;
+        guarantee_deserialization(deserialize_universal(&read_stream, &off),
+                                  "datum decode array offset");
+        element_offset = off;
+    } break;
+    default:
+        unreachable();
+    }
+    guarantee(element_offset <= std::numeric_limits<size_t>::max(),
+              "Datum too large for this architecture.");
 
-        uint64_t element_offset;
-        switch (offset_size) {
-        case datum_offset_size_t::U8BIT: {
-            uint8_t off;
-            guarantee_deserialization(deserialize_universal(&read_stream, &off),
-                                      "datum decode array offset");
-            element_offset = off;
-        } break;
-        case datum_offset_size_t::U16BIT: {
-            uint16_t off;
-            guarantee_deserialization(deserialize_universal(&read_stream, &off),
-                                      "datum decode array offset");
-            element_offset = off;
-        } break;
-        case datum_offset_size_t::U32BIT: {
-            uint32_t off;
-            guarantee_deserialization(deserialize_universal(&read_stream, &off),
-                                      "datum decode array offset");
-            element_offset = off;
-        } break;
-        case datum_offset_size_t::U64BIT: {
-            uint64_t off;
-            guarantee_deserialization(deserialize_universal(&read_stream, &off),
-                                      "datum decode array offset");
-            element_offset = off;
-        } break;
-        }
-        guarantee(element_offset <= std::numeric_limits<size_t>::max(),
-                  "Datum too large for this architecture.");
-
-        return data_offset + static_cast<size_t>(element_offset);
+    return layout.data_offset + static_cast<size_t>(element_offset);
+}
+
+size_t datum_get_element_offset(const shared_buf_ref_t<char> &array, size_t index) {
+    return datum_get_element_offset(array, datum_get_array_layout(array), index);
+}
+
+/* Objects are serialized like arrays whose elements are pairs of a serialized
+`datum_string_t` key (a varint size followed by the characters) and the value, sorted
+by key. We compare the keys right in the buffer, so that a lookup doesn't construct a
+`datum_string_t` or deserialize a value for every key that it looks at. */
+bool datum_get_field_from_buf(const shared_buf_ref_t<char> &object,
+                              size_t key_size,
+                              const char *key_data,
+                              datum_t *value_out) {
+    const datum_array_layout_t layout = datum_get_array_layout(object);
+    size_t range_beg = 0;
+    size_t range_end = layout.num_elements;
+    while (range_beg < range_end) {
+        const size_t center = range_beg + ((range_end - range_beg) / 2);
+        const size_t pair_offset = datum_get_element_offset(object, layout, center);
+
+        object.guarantee_in_boundary(pair_offset);
+        buffer_read_stream_t key_stream(object.get() + pair_offset,
+                                        object.get_safety_boundary() - pair_offset);
+        uint64_t center_key_size;
+        guarantee_deserialization(deserialize_varint_uint64(&key_stream,
+                                                            &center_key_size),
+                                  "datum decode object key");
+        guarantee(center_key_size <= std::numeric_limits<size_t>::max());
+        const size_t center_key_offset =
+            pair_offset + static_cast<size_t>(key_stream.tell());
+        const size_t center_key_end =
+            center_key_offset + static_cast<size_t>(center_key_size);
+        object.guarantee_in_boundary(center_key_end);
+        const char *center_key = object.get() + center_key_offset;
+
+        // The same order as `datum_string_t::compare()`
+        int cmp_res = memcmp(key_data, center_key,
+                             std::min<size_t>(key_size, center_key_size));
+        if (cmp_res == 0) {
+            cmp_res = key_size < center_key_size ? -1
+                : (key_size > center_key_size ? 1 : 0);
+        }
+
+        if (cmp_res == 0) {
+            *value_out = datum_deserialize_from_buf(object, center_key_end);
+            return true;
+        } else if (cmp_res < 0) {
+            range_end = center;
+        } else {
+            range_beg = center + 1;
+        }
     }
+    return false;
 }
 
 size_t datum_serialized_size(const datum_string_t &s) {
@@ -57,6 +57,12 @@ std::pair<datum_string_t, datum_t> datum_deserialize_pair_from_buf(
 size_t datum_get_element_offset(const shared_buf_ref_t<char> &array, size_t index);
 // Reads the number of elements in the array stored in the buffer
 size_t datum_get_array_size(const shared_buf_ref_t<char> &array);
+// Looks up a field of the object stored in the buffer, without deserializing any of
+// its other keys or values. Returns false if the object doesn't have the field.
+bool datum_get_field_from_buf(const shared_buf_ref_t<char> &object,
+                              size_t key_size,
+                              const char *key_data,
+                              datum_t *value_out);
 
 size_t datum_serialized_size(const datum_string_t &s);
 serialization_result_t datum_serialize(write_message_t *wm, const datum_string_t &s);
@@ -7,6 +7,9 @@
 #include <boost/variant.hpp>
 
 #include "debug.hpp"
+#include "math.hpp"
+#include "rdb_protocol/datum_hash_map.hpp"
+#include "rdb_protocol/filter_kernel.hpp"
 #include "rdb_protocol/func.hpp"
 #include "rdb_protocol/profile.hpp"
 #include "rdb_protocol/protocol.hpp"
@@ -76,8 +79,11 @@ protected:
 
     virtual void finish_impl(continue_bool_t, result_t *out) {
         *out = grouped_t<T>();
-        boost::get<grouped_t<T> >(*out).swap(acc);
-        guarantee(acc.size() == 0);
+        grouped_t<T> *res = boost::get<grouped_t<T> >(out);
+        for (auto &&pair : acc) {
+            res->insert(std::move(pair));
+        }
+        acc.clear();
     }
 private:
     virtual continue_bool_t operator()(
@@ -93,7 +99,8 @@ private:
                 keep |= accumulate(env, *el, &t_it->second, key, lazy_sindex_val);
             }
             if (!keep) {
-                acc.erase(t_it);
+                // We only get here if the group was just inserted.
+                acc.pop_back();
             }
         }
         return should_send_batch() ? continue_bool_t::ABORT : continue_bool_t::CONTINUE;
@@ -108,7 +115,7 @@ private:
 
     virtual void unshard(env_t *env, const std::vector<result_t *> &results) {
         guarantee(acc.size() == 0);
-        std::map<datum_t, std::vector<T *>, optional_datum_less_t> vecs;
+        datum_hash_map_t<std::vector<T *> > vecs;
         r_sanity_check(results.size() != 0);
         for (auto res = results.begin(); res != results.end(); ++res) {
             guarantee(*res);
@@ -127,10 +134,12 @@ private:
 
 protected:
     const T *get_default_val() { return &default_val; }
-    grouped_t<T> *get_acc() { return &acc; }
+    datum_hash_map_t<T> *get_acc() { return &acc; }
 private:
     const T default_val;
-    grouped_t<T> acc;
+    // Every batch looks up each of its groups in here, so it's a hash table. The
+    // groups only get ordered once, when they're turned into a `grouped_t`.
+    datum_hash_map_t<T> acc;
 };
 
 class append_t : public grouped_acc_t<stream_t> {
@@ -511,7 +520,7 @@ protected:
     explicit terminal_t(T &&t) : grouped_acc_t<T>(std::move(t)) { }
 private:
     virtual void operator()(env_t *env, groups_t *groups) {
-        grouped_t<T> *_acc = grouped_acc_t<T>::get_acc();
+        datum_hash_map_t<T> *_acc = grouped_acc_t<T>::get_acc();
         const T *_default_val = grouped_acc_t<T>::get_default_val();
         for (auto it = groups->begin(); it != groups->end(); ++it) {
             auto pair = _acc->insert(std::make_pair(it->first, *_default_val));
@@ -521,7 +530,8 @@ private:
                 keep |= accumulate(env, *el, &t_it->second);
             }
             if (!keep) {
-                _acc->erase(t_it);
+                // We only get here if the group was just inserted.
+                _acc->pop_back();
             }
         }
         groups->clear();
@@ -531,7 +541,7 @@ private:
                                              bool is_grouped,
                                              UNUSED const configured_limits_t &limits) {
         accumulator_t::mark_finished();
-        grouped_t<T> *_acc = grouped_acc_t<T>::get_acc();
+        datum_hash_map_t<T> *_acc = grouped_acc_t<T>::get_acc();
         const T *_default_val = grouped_acc_t<T>::get_default_val();
         scoped_ptr_t<val_t> retval;
         if (is_grouped) {
@@ -556,7 +566,7 @@ private:
     virtual datum_t unpack(T *t) = 0;
 
     virtual void add_res(env_t *env, result_t *res, sorting_t) {
-        grouped_t<T> *_acc = grouped_acc_t<T>::get_acc();
+        datum_hash_map_t<T> *_acc = grouped_acc_t<T>::get_acc();
         const T *_default_val = grouped_acc_t<T>::get_default_val();
         if (auto e = boost::get<exc_t>(res)) {
             throw *e;
@@ -564,7 +574,9 @@ private:
         grouped_t<T> *gres = boost::get<grouped_t<T> >(res);
         r_sanity_check(gres);
         if (_acc->size() == 0) {
-            _acc->swap(*gres);
+            for (auto kv = gres->begin(); kv != gres->end(); ++kv) {
+                _acc->insert(std::make_pair(kv->first, std::move(kv->second)));
+            }
         } else {
             // Order in fact does NOT matter here.  The reason is, each `kv->first`
             // value is different, which means each operation works on a different
@@ -773,6 +785,53 @@ private:
     bool (*cmp)(const datum_t &val1, const datum_t &val2);
 };
 
+class approx_count_distinct_terminal_t : public skip_terminal_t<hyperloglog_t> {
+public:
+    explicit approx_count_distinct_terminal_t(
+            const approx_count_distinct_wire_func_t &_f)
+        : skip_terminal_t<hyperloglog_t>(_f, hyperloglog_t()) { }
+private:
+    virtual void maybe_acc(env_t *env,
+                           const datum_t &el,
+                           hyperloglog_t *out,
+                           const acc_func_t &_f) {
+        out->add(_f(env, el));
+    }
+    virtual datum_t unpack(hyperloglog_t *h) {
+        return datum_t(round(h->estimate()));
+    }
+    virtual void unshard_impl(env_t *, hyperloglog_t *out, hyperloglog_t *el) {
+        out->merge(*el);
+    }
+};
+
+class approx_quantile_terminal_t : public skip_terminal_t<quantile_sketch_t> {
+public:
+    explicit approx_quantile_terminal_t(const approx_quantile_wire_func_t &_f)
+        : skip_terminal_t<quantile_sketch_t>(_f, quantile_sketch_t()),
+          quantile(_f.quantile) { }
+private:
+    virtual void maybe_acc(env_t *env,
+                           const datum_t &el,
+                           quantile_sketch_t *out,
+                           const acc_func_t &_f) {
+        out->add(_f(env, el).as_num());
+    }
+    virtual datum_t unpack(quantile_sketch_t *q) {
+        rcheck_datum(!q->empty(), base_exc_t::NON_EXISTENCE,
+                     "Cannot take a quantile of an empty stream.  (If you passed "
+                     "`approx_quantile` a field name, it may be that no elements of "
+                     "the stream had that field.)");
+        return datum_t(q->quantile(quantile));
+    }
+    virtual void unshard_impl(env_t *,
+                              quantile_sketch_t *out,
+                              quantile_sketch_t *el) {
+        out->merge(*el);
+    }
+    double quantile;
+};
+
 const char *const empty_stream_msg =
     "Cannot reduce over an empty stream.";
 
@@ -826,6 +885,12 @@ public:
     T *operator()(const reduce_wire_func_t &f) const {
         return new reduce_terminal_t(f);
     }
+    T *operator()(const approx_count_distinct_wire_func_t &f) const {
+        return new approx_count_distinct_terminal_t(f);
+    }
+    T *operator()(const approx_quantile_wire_func_t &f) const {
+        return new approx_quantile_terminal_t(f);
+    }
     T *operator()(const limit_read_t &lr) const {
         return new limit_append_t(
             lr.is_primary,
@@ -847,6 +912,79 @@ scoped_ptr_t<eager_acc_t> make_eager_terminal(const terminal_variant_t &t) {
             boost::apply_visitor(terminal_visitor_t<eager_acc_t>(), t));
 }
 
+// The results are the same as those of the terminals above, including the order in
+// which the numbers are added up and which of several equal elements `min` and `max`
+// return. Anything that would be an error there, such as an empty array or an element
+// that isn't a number, gets an empty datum here so that the terminal reports it.
+class numeric_terminal_visitor_t : public boost::static_visitor<datum_t> {
+public:
+    explicit numeric_terminal_visitor_t(const datum_t &_arr) : arr(_arr) { }
+
+    datum_t operator()(const sum_wire_func_t &f) const {
+        double sum = 0.0;
+        if (!applies(f) || !for_each_num([&](size_t, double d) { sum += d; })
+            || !risfinite(sum)) {
+            return datum_t();
+        }
+        return datum_t(sum);
+    }
+    datum_t operator()(const avg_wire_func_t &f) const {
+        double sum = 0.0;
+        if (!applies(f) || !for_each_num([&](size_t, double d) { sum += d; })) {
+            return datum_t();
+        }
+        double avg = sum / arr.arr_size();
+        return risfinite(avg) ? datum_t(avg) : datum_t();
+    }
+    datum_t operator()(const min_wire_func_t &f) const {
+        return optimize(f, [](double d, double best) { return d < best; });
+    }
+    datum_t operator()(const max_wire_func_t &f) const {
+        return optimize(f, [](double d, double best) { return d > best; });
+    }
+    template<class T>
+    datum_t operator()(const T &) const {
+        return datum_t();
+    }
+
+private:
+    bool applies(const skip_wire_func_t &f) const {
+        return arr.arr_size() != 0 && !f.compile_wire_func_or_null().has();
+    }
+    template<class callable_t>
+    bool for_each_num(callable_t &&cb) const {
+        const size_t size = arr.arr_size();
+        for (size_t i = 0; i < size; ++i) {
+            datum_t el = arr.get(i);
+            if (el.get_type() != datum_t::R_NUM) {
+                return false;
+            }
+            cb(i, el.as_num());
+        }
+        return true;
+    }
+    template<class beats_t>
+    datum_t optimize(const skip_wire_func_t &f, beats_t &&beats) const {
+        size_t best_index = 0;
+        double best = 0.0;
+        if (!applies(f) || !for_each_num([&](size_t i, double d) {
+                    if (i == 0 || beats(d, best)) {
+                        best_index = i;
+                        best = d;
+                    }
+                })) {
+            return datum_t();
+        }
+        return arr.get(best_index);
+    }
+
+    const datum_t &arr;
+};
+
+datum_t run_numeric_terminal(const terminal_variant_t &t, const datum_t &arr) {
+    return boost::apply_visitor(numeric_terminal_visitor_t(arr), t);
+}
+
 class ungrouped_op_t : public op_t {
 protected:
 private:
@@ -882,6 +1020,9 @@ private:
         if (groups->size() == 0) return;
         r_sanity_check(groups->size() == 1 && !groups->begin()->first.has());
         datums_t *ds = &groups->begin()->second;
+        // Most rows land in a group we've already seen, so we collect them in a hash
+        // table and only put each group into the ordered `groups` once at the end.
+        datum_hash_map_t<datums_t> new_groups;
         for (auto el = ds->begin(); el != ds->end(); ++el) {
             std::vector<datum_t> arr;
             arr.reserve(funcs.size() + append_index);
@@ -908,7 +1049,7 @@ private:
             r_sanity_check(arr.size() == (funcs.size() + append_index));
 
             if (!multi) {
-                add(groups, std::move(arr), *el, env->limits());
+                add(&new_groups, std::move(arr), *el, env->limits());
             } else {
                 std::vector<std::vector<datum_t> > perms(arr.size());
                 for (size_t i = 0; i < arr.size(); ++i) {
@@ -923,21 +1064,25 @@ private:
                 }
                 std::vector<datum_t> instance;
                 instance.reserve(perms.size());
-                add_perms(groups, &instance, &perms, 0, *el, env->limits());
+                add_perms(&new_groups, &instance, &perms, 0, *el, env->limits());
                 r_sanity_check(instance.size() == 0);
             }
 
+            // The `+ 1` is for the ungrouped rows, which this check used to count
+            // as a group when they shared `groups` with the new ones.
             rcheck_src(bt,
-                       groups->size() <= env->limits().array_size_limit(),
+                       new_groups.size() + 1 <= env->limits().array_size_limit(),
                        base_exc_t::RESOURCE,
                        strprintf("Too many groups (> %zu).",
                                  env->limits().array_size_limit()));
         }
-        size_t erased = groups->erase(datum_t());
-        r_sanity_check(erased == 1);
+        groups->clear();
+        for (auto &&pair : new_groups) {
+            groups->insert(std::move(pair));
+        }
     }
 
-    void add(groups_t *groups,
+    void add(datum_hash_map_t<datums_t> *groups,
              std::vector<datum_t> &&arr,
              const datum_t &el,
              const configured_limits_t &limits) {
@@ -948,7 +1093,7 @@ private:
         (*groups)[group].push_back(el);
     }
 
-    void add_perms(groups_t *groups,
+    void add_perms(datum_hash_map_t<datums_t> *groups,
                    std::vector<datum_t> *instance,
                    std::vector<std::vector<datum_t> > *arr,
                    size_t index,
@@ -979,14 +1124,34 @@ private:
     backtrace_id_t bt;
 };
 
+class js_func_visitor_t : public func_visitor_t {
+public:
+    js_func_visitor_t() : js_func(nullptr) { }
+    void on_reql_func(const reql_func_t *) { }
+    void on_js_func(const js_func_t *_js_func) {
+        js_func = _js_func;
+    }
+    const js_func_t *js_func;
+};
+
 class map_trans_t : public ungrouped_op_t {
 public:
     explicit map_trans_t(const map_wire_func_t &_f)
-        : f(_f.compile_wire_func()) { }
+        : f(_f.compile_wire_func()) {
+        js_func_visitor_t visitor;
+        f->visit(&visitor);
+        js_f = visitor.js_func;
+    }
 private:
     virtual void lst_transform(
         env_t *env, datums_t *lst, const std::function<datum_t()> &) {
         try {
+            // A JS function sends the whole batch to its worker process at once,
+            // instead of paying for a round trip per row.
+            if (js_f != nullptr && lst->size() > 1) {
+                *lst = js_f->call_batch(env, *lst);
+                return;
+            }
             for (auto it = lst->begin(); it != lst->end(); ++it) {
                 *it = f->call(env, *it)->as_datum();
             }
@@ -995,6 +1160,8 @@ private:
         }
     }
     counted_t<const func_t> f;
+    // Points into `f` if it's a JS function
+    const js_func_t *js_f;
 };
 
 // Note: this removes duplicates ONLY TO SAVE NETWORK TRAFFIC.  It's possible
@@ -1035,15 +1202,20 @@ public:
         : f(_f.filter_func.compile_wire_func()),
           default_val(_f.default_filter_val.has_value()
                       ? _f.default_filter_val->compile_wire_func()
-                      : counted_t<const func_t>()) { }
+                      : counted_t<const func_t>()),
+          kernel(filter_kernel_t::compile(f)) { }
 private:
     virtual void lst_transform(
         env_t *env, datums_t *lst, const std::function<datum_t()> &) {
+        std::vector<filter_kernel_t::result_t> kernel_results;
+        if (kernel.has()) {
+            kernel->eval(*lst, env->limits(), &kernel_results);
+        }
         auto it = lst->begin();
         auto loc = it;
         try {
             for (it = lst->begin(); it != lst->end(); ++it) {
-                if (f->filter_call(env, *it, default_val)) {
+                if (row_matches(env, *it, kernel_results, it - lst->begin())) {
                     std::swap(*loc, *it);
                     ++loc;
                 }
@@ -1053,7 +1225,33 @@ private:
         }
         lst->erase(loc, lst->end());
     }
+    bool row_matches(env_t *env,
+                     const datum_t &row,
+                     const std::vector<filter_kernel_t::result_t> &kernel_results,
+                     size_t index) const {
+        if (kernel.has()) {
+            switch (kernel_results[index]) {
+            case filter_kernel_t::result_t::MATCH:
+                return true;
+            case filter_kernel_t::result_t::NO_MATCH:
+                return false;
+            case filter_kernel_t::result_t::NON_EXISTENCE:
+                if (!default_val.has()) {
+                    return false;
+                }
+                break;
+            case filter_kernel_t::result_t::UNKNOWN:
+                break;
+            default:
+                unreachable();
+            }
+        }
+        return f->filter_call(env, row, default_val);
+    }
     counted_t<const func_t> f, default_val;
+    // Evaluates simple predicates over the whole batch; rows it can't decide are
+    // passed to `f`.
+    scoped_ptr_t<filter_kernel_t> kernel;
 };
 
 class concatmap_trans_t : public ungrouped_op_t {
@@ -19,6 +19,7 @@
 #include "rdb_protocol/datum.hpp"
 #include "rdb_protocol/datum_utils.hpp"
 #include "rdb_protocol/profile.hpp"
+#include "rdb_protocol/sketch.hpp"
 #include "rdb_protocol/wire_func.hpp"
 #include "region/region.hpp"
 #include "stl_utils.hpp"
@@ -182,6 +183,14 @@ template <cluster_version_t W>
 void serialize_grouped(write_message_t *wm, const datums_t &ds) {
     serialize<W>(wm, ds);
 }
+template <cluster_version_t W>
+void serialize_grouped(write_message_t *wm, const hyperloglog_t &h) {
+    serialize<W>(wm, h);
+}
+template <cluster_version_t W>
+void serialize_grouped(write_message_t *wm, const quantile_sketch_t &q) {
+    serialize<W>(wm, q);
+}
 
 template <cluster_version_t W>
 archive_result_t deserialize_grouped(
@@ -219,6 +228,14 @@ template <cluster_version_t W>
 archive_result_t deserialize_grouped(read_stream_t *s, datums_t *ds) {
     return deserialize<W>(s, ds);
 }
+template <cluster_version_t W>
+archive_result_t deserialize_grouped(read_stream_t *s, hyperloglog_t *h) {
+    return deserialize<W>(s, h);
+}
+template <cluster_version_t W>
+archive_result_t deserialize_grouped(read_stream_t *s, quantile_sketch_t *q) {
+    return deserialize<W>(s, q);
+}
 
 // This is basically a templated typedef with special serialization.
 template<class T>
@@ -345,7 +362,9 @@ typedef boost::variant<
     grouped_t<ql::datum_t>, // Reduce (may be NULL)
     grouped_t<optimizer_t>, // min, max
     grouped_t<stream_t>, // No terminal.
-    exc_t // Don't re-order (we don't want this to initialize to an error.)
+    exc_t, // Don't re-order (we don't want this to initialize to an error.)
+    grouped_t<hyperloglog_t>, // approx_count_distinct
+    grouped_t<quantile_sketch_t> // approx_quantile
     > result_t;
 
 typedef boost::variant<map_wire_func_t,
@@ -384,7 +403,9 @@ typedef boost::variant<count_wire_func_t,
                        min_wire_func_t,
                        max_wire_func_t,
                        reduce_wire_func_t,
-                       limit_read_t
+                       limit_read_t,
+                       approx_count_distinct_wire_func_t,
+                       approx_quantile_wire_func_t
                        > terminal_variant_t;
 
 class accumulator_t {
@@ -430,6 +451,10 @@ scoped_ptr_t<accumulator_t> make_unsharding_append();
 scoped_ptr_t<accumulator_t> make_terminal(const terminal_variant_t &t);
 scoped_ptr_t<eager_acc_t> make_to_array();
 scoped_ptr_t<eager_acc_t> make_eager_terminal(const terminal_variant_t &t);
+// Runs `sum`, `avg`, `min` or `max` without a function straight over an array of
+// numbers. Returns an empty datum for any other terminal or array, which then has to
+// go through `make_eager_terminal()` as usual.
+datum_t run_numeric_terminal(const terminal_variant_t &t, const datum_t &arr);
 scoped_ptr_t<op_t> make_op(const transform_variant_t &tv);
 
 } // namespace ql
@@ -0,0 +1,139 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/sketch.hpp"
+
+#include <math.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "random.hpp"
+#include "rdb_protocol/datum_utils.hpp"
+
+namespace ql {
+
+// `optional_datum_hash()` is made for hash tables, where the low bits matter most. We
+// use all 64, so we mix them some more (this is the finalizer of SplitMix64).
+static uint64_t mix_hash(uint64_t h) {
+    h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+}
+
+void hyperloglog_t::add(const datum_t &d) {
+    if (registers.empty()) {
+        registers.resize(NUM_REGISTERS, 0);
+    }
+    uint64_t h = mix_hash(optional_datum_hash(d));
+    size_t index = h >> (64 - PRECISION);
+    uint64_t rest = h << PRECISION;
+    // The position of the first set bit of what's left of the hash
+    uint8_t rank = 1;
+    while (rank <= 64 - PRECISION && (rest & (1ULL << 63)) == 0) {
+        rest <<= 1;
+        ++rank;
+    }
+    registers[index] = std::max(registers[index], rank);
+}
+
+void hyperloglog_t::merge(const hyperloglog_t &other) {
+    if (other.registers.empty()) {
+        return;
+    }
+    if (registers.empty()) {
+        registers = other.registers;
+        return;
+    }
+    for (size_t i = 0; i < NUM_REGISTERS; ++i) {
+        registers[i] = std::max(registers[i], other.registers[i]);
+    }
+}
+
+double hyperloglog_t::estimate() const {
+    if (registers.empty()) {
+        return 0;
+    }
+    const double m = NUM_REGISTERS;
+    double sum = 0;
+    size_t zeros = 0;
+    for (uint8_t r : registers) {
+        sum += ldexp(1.0, -r);
+        zeros += (r == 0);
+    }
+    double e = (0.7213 / (1 + 1.079 / m)) * m * m / sum;
+    // The estimate is biased for small counts, where counting the registers that
+    // are still empty does better. With a 64-bit hash there's no need for the
+    // correction at the other end.
+    if (e <= 2.5 * m && zeros != 0) {
+        e = m * log(m / zeros);
+    }
+    return e;
+}
+
+void quantile_sketch_t::add(double d) {
+    if (levels.empty()) {
+        levels.resize(1);
+    }
+    levels[0].push_back(d);
+    ++count;
+    if (levels[0].size() >= LEVEL_CAPACITY) {
+        compress();
+    }
+}
+
+void quantile_sketch_t::merge(const quantile_sketch_t &other) {
+    if (levels.size() < other.levels.size()) {
+        levels.resize(other.levels.size());
+    }
+    for (size_t i = 0; i < other.levels.size(); ++i) {
+        levels[i].insert(levels[i].end(),
+                         other.levels[i].begin(), other.levels[i].end());
+    }
+    count += other.count;
+    compress();
+}
+
+void quantile_sketch_t::compress() {
+    for (size_t i = 0; i < levels.size(); ++i) {
+        if (levels[i].size() < LEVEL_CAPACITY) {
+            continue;
+        }
+        std::vector<double> level = std::move(levels[i]);
+        levels[i].clear();
+        std::sort(level.begin(), level.end());
+        // An odd number out stays behind, so that the total weight doesn't change
+        if (level.size() % 2 != 0) {
+            levels[i].push_back(level.back());
+            level.pop_back();
+        }
+        if (i + 1 == levels.size()) {
+            levels.emplace_back();
+        }
+        for (size_t j = randint(2); j < level.size(); j += 2) {
+            levels[i + 1].push_back(level[j]);
+        }
+    }
+}
+
+double quantile_sketch_t::quantile(double q) const {
+    guarantee(!empty());
+    std::vector<std::pair<double, uint64_t> > weighted;
+    uint64_t total = 0;
+    for (size_t i = 0; i < levels.size(); ++i) {
+        for (double d : levels[i]) {
+            weighted.push_back(std::make_pair(d, 1ULL << i));
+            total += 1ULL << i;
+        }
+    }
+    std::sort(weighted.begin(), weighted.end());
+    const double target = q * total;
+    uint64_t seen = 0;
+    for (const auto &pair : weighted) {
+        seen += pair.second;
+        if (seen >= target) {
+            return pair.first;
+        }
+    }
+    return weighted.back().first;
+}
+
+}  // namespace ql
@@ -0,0 +1,71 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_SKETCH_HPP_
+#define RDB_PROTOCOL_SKETCH_HPP_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "containers/archive/stl_types.hpp"
+#include "rdb_protocol/datum.hpp"
+#include "rpc/serialize_macros.hpp"
+
+namespace ql {
+
+/* The sketches below summarize a stream in a fixed amount of memory, no matter how long
+the stream is. Two sketches of different streams can be merged into a sketch of both,
+so each shard builds one over its own rows and the sketches are merged on unshard,
+the same way `sum` adds up the shards' sums. */
+
+/* Estimates the number of distinct datums it has seen (HyperLogLog). The standard
+error of the estimate is about 1.6%. Datums are distinct if they aren't equal according
+to `datum_t::operator==`, as for `distinct()`. */
+class hyperloglog_t {
+public:
+    hyperloglog_t() { }
+
+    void add(const datum_t &d);
+    void merge(const hyperloglog_t &other);
+    double estimate() const;
+
+    RDB_MAKE_ME_SERIALIZABLE_1(hyperloglog_t, registers);
+
+private:
+    // 2^12 registers of a byte each
+    static const int PRECISION = 12;
+    static const size_t NUM_REGISTERS = 1 << PRECISION;
+
+    // Empty until the first `add()`, because every group starts with a copy of an
+    // empty sketch
+    std::vector<uint8_t> registers;
+};
+
+/* Estimates the quantiles of the numbers it has seen, to within about 1% of their
+rank (a KLL sketch with compactors of equal size). Numbers are kept at levels, with
+the ones at level `i` standing for `2^i` of the original numbers. When a level fills
+up it's sorted, and every other number, starting at a random one of the first two,
+moves up a level. */
+class quantile_sketch_t {
+public:
+    quantile_sketch_t() : count(0) { }
+
+    void add(double d);
+    void merge(const quantile_sketch_t &other);
+    bool empty() const { return count == 0; }
+    // `q` is between 0 and 1; 0 gives the smallest number and 1 the largest
+    double quantile(double q) const;
+
+    RDB_MAKE_ME_SERIALIZABLE_2(quantile_sketch_t, levels, count);
+
+private:
+    static const size_t LEVEL_CAPACITY = 256;
+
+    void compress();
+
+    std::vector<std::vector<double> > levels;
+    uint64_t count;
+};
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_SKETCH_HPP_
@@ -15,6 +15,7 @@
 #include "rdb_protocol/env.hpp"
 #include "rdb_protocol/erase_range.hpp"
 #include "rdb_protocol/func.hpp"
+#include "rdb_protocol/pathspec.hpp"
 #include "rdb_protocol/shards.hpp"
 #include "rdb_protocol/table_common.hpp"
 
@@ -151,46 +152,73 @@ void store_t::help_construct_bring_sindexes_up_to_date() {
     txn->commit();
 }
 
-scoped_ptr_t<sindex_superblock_t> acquire_sindex_for_read(
+std::vector<scoped_ptr_t<sindex_superblock_t> > acquire_sindexes_for_read(
     store_t *store,
     real_superblock_t *superblock,
     const std::string &table_name,
-    const std::string &sindex_id,
-    sindex_disk_info_t *sindex_info_out,
-    uuid_u *sindex_uuid_out) {
-    rassert(sindex_info_out != NULL);
-    rassert(sindex_uuid_out != NULL);
-
-    scoped_ptr_t<sindex_superblock_t> sindex_sb;
-    std::vector<char> sindex_mapping_data;
-
-    uuid_u sindex_uuid;
+    const std::vector<std::string> &sindex_ids,
+    std::vector<sindex_disk_info_t> *sindex_infos_out,
+    std::vector<uuid_u> *sindex_uuids_out) {
+    rassert(sindex_infos_out != NULL);
+    rassert(sindex_uuids_out != NULL);
+
+    std::vector<sindex_name_t> names;
+    for (const std::string &id : sindex_ids) {
+        names.push_back(sindex_name_t(id));
+    }
+    std::vector<scoped_ptr_t<sindex_superblock_t> > sindex_sbs;
+    std::vector<std::vector<char> > sindex_mapping_data;
+    std::vector<uuid_u> sindex_uuids;
     try {
-        bool found = store->acquire_sindex_superblock_for_read(
-            sindex_name_t(sindex_id),
+        bool found = store->acquire_sindex_superblocks_for_read(
+            names,
             table_name,
             superblock,
-            &sindex_sb,
+            &sindex_sbs,
             &sindex_mapping_data,
-            &sindex_uuid);
+            &sindex_uuids);
         // TODO: consider adding some logic on the machine handling the
         // query to attach a real backtrace here.
         rcheck_toplevel(found, ql::base_exc_t::OP_FAILED,
                 strprintf("Index `%s` was not found on table `%s`.",
-                          sindex_id.c_str(), table_name.c_str()));
+                          sindex_ids[sindex_sbs.size()].c_str(),
+                          table_name.c_str()));
     } catch (const sindex_not_ready_exc_t &e) {
         throw ql::exc_t(
             ql::base_exc_t::OP_FAILED, e.what(), ql::backtrace_id_t::empty());
     }
 
-    try {
-        deserialize_sindex_info_or_crash(sindex_mapping_data, sindex_info_out);
-    } catch (const archive_exc_t &e) {
-        crash("%s", e.what());
+    for (size_t i = 0; i < sindex_sbs.size(); ++i) {
+        sindex_infos_out->push_back(
+            *store->get_sindex_info(sindex_uuids[i], sindex_mapping_data[i]));
     }
+    *sindex_uuids_out = std::move(sindex_uuids);
+    return sindex_sbs;
+}
 
-    *sindex_uuid_out = sindex_uuid;
-    return sindex_sb;
+scoped_ptr_t<sindex_superblock_t> acquire_sindex_for_read(
+    store_t *store,
+    real_superblock_t *superblock,
+    const std::string &table_name,
+    const std::string &sindex_id,
+    sindex_disk_info_t *sindex_info_out,
+    uuid_u *sindex_uuid_out) {
+    rassert(sindex_info_out != NULL);
+    rassert(sindex_uuid_out != NULL);
+
+    std::vector<sindex_disk_info_t> sindex_infos;
+    std::vector<uuid_u> sindex_uuids;
+    std::vector<scoped_ptr_t<sindex_superblock_t> > sindex_sbs =
+        acquire_sindexes_for_read(
+            store,
+            superblock,
+            table_name,
+            std::vector<std::string>{sindex_id},
+            &sindex_infos,
+            &sindex_uuids);
+    *sindex_info_out = std::move(sindex_infos[0]);
+    *sindex_uuid_out = sindex_uuids[0];
+    return std::move(sindex_sbs[0]);
 }
 
 void do_read(ql::env_t *env,
@@ -225,16 +253,30 @@ void do_read(ql::env_t *env,
         sindex_disk_info_t sindex_info;
         uuid_u sindex_uuid;
         scoped_ptr_t<sindex_superblock_t> sindex_sb;
+        // The indexes that `get_all` was asked to intersect with, acquired along
+        // with the one it reads.
+        std::vector<scoped_ptr_t<sindex_superblock_t> > intersect_sbs;
+        std::vector<sindex_intersection_t> intersections;
         key_range_t sindex_range;
         try {
-            sindex_sb =
-                acquire_sindex_for_read(
+            std::vector<std::string> sindex_ids(1, rget.sindex->id);
+            for (const auto &pair : rget.sindex->intersect) {
+                sindex_ids.push_back(pair.first);
+            }
+            std::vector<sindex_disk_info_t> sindex_infos;
+            std::vector<uuid_u> sindex_uuids;
+            intersect_sbs =
+                acquire_sindexes_for_read(
                     store,
                     superblock,
                     rget.table_name,
-                    rget.sindex->id,
-                    &sindex_info,
-                    &sindex_uuid);
+                    sindex_ids,
+                    &sindex_infos,
+                    &sindex_uuids);
+            sindex_sb = std::move(intersect_sbs[0]);
+            intersect_sbs.erase(intersect_sbs.begin());
+            sindex_info = std::move(sindex_infos[0]);
+            sindex_uuid = sindex_uuids[0];
             if (sindex_id_out != nullptr) {
                 *sindex_id_out = make_optional(sindex_uuid);
             }
@@ -258,6 +300,82 @@ void do_read(ql::env_t *env,
                     ql::backtrace_id_t::empty());
                 return;
             }
+            auto intersect_it = rget.sindex->intersect.begin();
+            for (size_t i = 0; i < intersect_sbs.size(); ++i, ++intersect_it) {
+                if (sindex_infos[i + 1].geo == sindex_geo_bool_t::GEO) {
+                    res->result = ql::exc_t(
+                        ql::base_exc_t::LOGIC,
+                        strprintf(
+                            "Index `%s` is a geospatial index and can't be used "
+                            "with `intersect`.",
+                            intersect_it->first.c_str()),
+                        ql::backtrace_id_t::empty());
+                    return;
+                }
+                sindex_intersection_t intersection;
+                intersection.info = std::move(sindex_infos[i + 1]);
+                intersection.key = intersect_it->second;
+                intersection.primary_keys = rdb_get_intersected_primary_keys(
+                    intersect_sbs[i].get(),
+                    intersection.key,
+                    intersection.info,
+                    rget.region.inner,
+                    env->interruptor);
+                intersections.push_back(std::move(intersection));
+            }
+            intersect_sbs.clear();
+
+            // Whole-index grouped aggregates may be kept up to date by the store.
+            // Taken before anything can yield, so that writes with later tickets are
+            // the ones this read doesn't see.
+            const uint64_t write_ticket =
+                store->materialized_aggregates.current_write_ticket();
+            optional<std::string> aggregate_key =
+                materialized_aggregates_t::aggregate_key(rget, sindex_info);
+            if (aggregate_key.has_value()) {
+                if (store->materialized_aggregates.read(
+                        sindex_uuid, *aggregate_key, *rget.terminal, &res->result)) {
+                    return;
+                }
+                ql::terminal_variant_t build_terminal;
+                if (store->materialized_aggregates.start(
+                        sindex_uuid, *aggregate_key, *rget.terminal, write_ticket,
+                        &build_terminal)) {
+                    rget_read_response_t built;
+                    built.reql_version = reql_version;
+                    try {
+                        rdb_rget_secondary_slice(
+                            store->get_sindex_slice(sindex_uuid),
+                            *rget.current_shard,
+                            rget.sindex->datumspec,
+                            sindex_range,
+                            sindex_sb.get(),
+                            env,
+                            rget.batchspec,
+                            rget.transforms,
+                            make_optional(build_terminal),
+                            rget.region.inner,
+                            rget.sorting,
+                            rget.sindex->require_sindex_val,
+                            sindex_info,
+                            &built,
+                            release_superblock_t::KEEP);
+                    } catch (...) {
+                        store->materialized_aggregates.abandon(
+                            sindex_uuid, *aggregate_key);
+                        throw;
+                    }
+                    if (store->materialized_aggregates.finish(
+                            sindex_uuid, *aggregate_key, &built.result)) {
+                        guarantee(store->materialized_aggregates.read(
+                            sindex_uuid, *aggregate_key, *rget.terminal,
+                            &res->result));
+                        return;
+                    }
+                    // Otherwise we read the index again the usual way, which gives
+                    // the error the query would have given.
+                }
+            }
 
             rdb_rget_secondary_slice(
                 store->get_sindex_slice(sindex_uuid),
@@ -274,7 +392,8 @@ void do_read(ql::env_t *env,
                 rget.sindex->require_sindex_val,
                 sindex_info,
                 res,
-                release_superblock_t::RELEASE);
+                release_superblock_t::RELEASE,
+                intersections);
         } catch (const ql::exc_t &e) {
             res->result = e;
             return;
@@ -401,14 +520,27 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
 
         auto cserver = store->changefeed_server(s.region);
         if (cserver.first != nullptr) {
-            if (optional<uint64_t> stamp
-                    = cserver.first->get_stamp(s.addr, cserver.second)) {
+            const uuid_u server_uuid = cserver.first->get_uuid();
+            optional<uint64_t> resume_from;
+            if (s.resume_from) {
+                auto it = s.resume_from->find(server_uuid);
+                if (it != s.resume_from->end()) {
+                    resume_from.set(it->second);
+                }
+            }
+            uint64_t position;
+            optional<std::vector<ql::changefeed::msg_t::change_t> > resumed_changes;
+            if (optional<uint64_t> stamp = cserver.first->get_stamp(
+                    s.addr, resume_from, &position, &resumed_changes,
+                    cserver.second)) {
                 changefeed_stamp_response_t out;
                 out.stamp_infos.set(std::map<uuid_u, shard_stamp_info_t>());
-                (*out.stamp_infos)[cserver.first->get_uuid()] = shard_stamp_info_t{
+                (*out.stamp_infos)[server_uuid] = shard_stamp_info_t{
                     *stamp,
                     current_shard,
-                    read_start};
+                    read_start,
+                    position,
+                    std::move(resumed_changes)};
                 return out;
             }
         }
@@ -450,7 +582,23 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
         response->response = point_read_response_t();
         point_read_response_t *res =
             boost::get<point_read_response_t>(&response->response);
-        rdb_get(get.key, btree, superblock, res, trace);
+        if (!store->row_cache.find(get.key, &res->data)) {
+            uint64_t generation = store->row_cache.get_generation();
+            rdb_get(get.key, btree, superblock, res, trace);
+            store->row_cache.maybe_insert(get.key, res->data, generation);
+        }
+        store->load_sampler.on_read(get.key);
+        if (get.projection.has_value()
+            && res->data.get_type() == ql::datum_t::R_OBJECT
+            && !res->data.is_ptype()) {
+            // The paths were already checked by the `pluck` term that sent them, so
+            // the pathspec can't fail here.
+            res->data = ql::project(
+                res->data,
+                ql::pathspec_t(*get.projection, nullptr),
+                ql::DONT_RECURSE,
+                ql::configured_limits_t::unlimited);
+        }
     }
 
     void operator()(const intersecting_geo_read_t &geo_read) {
@@ -661,6 +809,8 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
             scale_down_distribution(dg.result_limit, &res->key_counts);
         }
 
+        store->load_sampler.get_loads(dg.region.inner, &res->key_loads);
+
         res->region = dg.region;
     }
 
@@ -668,6 +818,12 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
         response->response = dummy_read_response_t();
     }
 
+    void operator()(const sample_read_t &sample) {
+        response->response = sample_read_response_t();
+        auto *res = boost::get<sample_read_response_t>(&response->response);
+        rdb_sample_slice(sample.region.inner, sample.num, superblock, interruptor, res);
+    }
+
     rdb_read_visitor_t(btree_slice_t *_btree,
                        store_t *_store,
                        real_superblock_t *_superblock,
@@ -819,6 +975,9 @@ struct rdb_write_visitor_t : public boost::static_visitor<void> {
                                  br.f,
                                  write_hook,
                                  br.return_changes);
+        for (const store_key_t &key : br.keys) {
+            store->load_sampler.on_write(key);
+        }
 
         response->response =
             rdb_batched_replace(
@@ -848,6 +1007,7 @@ struct rdb_write_visitor_t : public boost::static_visitor<void> {
         keys.reserve(bi.inserts.size());
         for (auto it = bi.inserts.begin(); it != bi.inserts.end(); ++it) {
             keys.emplace_back(it->get_field(datum_string_t(bi.pkey)).print_primary());
+            store->load_sampler.on_write(keys.back());
         }
         response->response =
             rdb_batched_replace(
@@ -868,6 +1028,7 @@ struct rdb_write_visitor_t : public boost::static_visitor<void> {
             boost::get<point_write_response_t>(&response->response);
 
         backfill_debug_key(w.key, strprintf("upsert %" PRIu64, timestamp.longtime));
+        store->load_sampler.on_write(w.key);
 
         rdb_live_deletion_context_t deletion_context;
         rdb_modification_report_t mod_report(w.key);
@@ -884,6 +1045,7 @@ struct rdb_write_visitor_t : public boost::static_visitor<void> {
             boost::get<point_delete_response_t>(&response->response);
 
         backfill_debug_key(d.key, strprintf("delete %" PRIu64, timestamp.longtime));
+        store->load_sampler.on_write(d.key);
 
         rdb_live_deletion_context_t deletion_context;
         rdb_modification_report_t mod_report(d.key);
@@ -3,6 +3,7 @@
 #define RDB_PROTOCOL_STORE_HPP_
 
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -23,7 +24,10 @@
 #include "paths.hpp"
 #include "protocol_api.hpp"
 #include "rdb_protocol/changefeed.hpp"
+#include "rdb_protocol/key_load_sampler.hpp"
+#include "rdb_protocol/materialized_aggregate.hpp"
 #include "rdb_protocol/protocol.hpp"
+#include "rdb_protocol/row_cache.hpp"
 #include "rdb_protocol/store_metainfo.hpp"
 #include "rpc/mailbox/typed.hpp"
 #include "store_view.hpp"
@@ -38,6 +42,7 @@ class io_backender_t;
 class real_superblock_t;
 class sindex_superblock_t;
 class superblock_t;
+struct sindex_disk_info_t;
 class txn_t;
 class cache_balancer_t;
 struct rdb_modification_report_t;
@@ -201,6 +206,22 @@ public:
             THROWS_ONLY(interrupted_exc_t);
 
     void configure_flush_interval(flush_interval_t interval);
+    void configure_cache_balancer_policy(const cache_balancer_policy_t &policy);
+
+    // The blocks that are hot in this store's cache right now, and a way to read
+    // them back in after a restart.  See `page_cache_t::warm_up()`.
+    std::vector<block_id_t> get_hot_block_ids(size_t max_count);
+    void warm_up_cache(std::vector<block_id_t> block_ids);
+
+    // A store goes idle when its table hasn't been used for a while (see
+    // `--idle-table-timeout`). An idle store's cache gets no memory from the cache
+    // balancer, and the blocks that were hot in it are read back in on the next read,
+    // write or backfill, which also ends the idle mode. `get_hot_block_ids()` returns
+    // those blocks while the store is idle.
+    void enter_idle_mode(std::vector<block_id_t> &&hot_block_ids);
+    bool is_idle() const { return idle; }
+    // How many reads, writes and backfills have gone through the store
+    uint64_t get_access_count() const { return access_count; }
 
     new_mutex_in_line_t get_in_line_for_sindex_queue(buf_lock_t *sindex_block);
     rwlock_in_line_t get_in_line_for_cfeed_stamp(access_t access);
@@ -256,6 +277,18 @@ public:
             uuid_u *sindex_uuid_out)
         THROWS_ONLY(sindex_not_ready_exc_t);
 
+    // Like `acquire_sindex_superblock_for_read()` for several indexes, which can't be
+    // acquired one at a time because that releases `superblock`. If one of them
+    // doesn't exist, returns false with the outputs filled in for the ones before it.
+    MUST_USE bool acquire_sindex_superblocks_for_read(
+            const std::vector<sindex_name_t> &names,
+            const std::string &table_name,
+            real_superblock_t *superblock,  // releases this.
+            std::vector<scoped_ptr_t<sindex_superblock_t> > *sindex_sbs_out,
+            std::vector<std::vector<char> > *opaque_definitions_out,
+            std::vector<uuid_u> *sindex_uuids_out)
+        THROWS_ONLY(sindex_not_ready_exc_t);
+
     MUST_USE bool acquire_sindex_superblock_for_write(
             const sindex_name_t &name,
             const std::string &table_name,
@@ -268,13 +301,19 @@ public:
         sindex_access_t(btree_slice_t *_btree,
                         sindex_name_t _name,
                         secondary_index_t _sindex,
-                        scoped_ptr_t<sindex_superblock_t> _superblock);
+                        std::shared_ptr<const sindex_disk_info_t> _info,
+                        scoped_ptr_t<sindex_superblock_t> _superblock,
+                        uint64_t _write_ticket);
         ~sindex_access_t();
 
         btree_slice_t *btree;
         sindex_name_t name;
         secondary_index_t sindex;
+        // `sindex.opaque_definition`, deserialized
+        std::shared_ptr<const sindex_disk_info_t> info;
         scoped_ptr_t<sindex_superblock_t> superblock;
+        // See `materialized_aggregates_t::take_write_ticket()`.
+        uint64_t write_ticket;
     };
 
     typedef std::vector<scoped_ptr_t<sindex_access_t> > sindex_access_vector_t;
@@ -384,6 +423,18 @@ public:
 
     std::map<uuid_u, scoped_ptr_t<btree_slice_t> > secondary_index_slices;
 
+    // Returns the deserialized definition of the index `sindex_id`. Writes look these
+    // up for every index they update and reads for the index they use, so we keep
+    // them around (together with the serialized definition they came from, which
+    // changes when the index gets upgraded or recreated) instead of deserializing and
+    // compiling the index function every time.
+    std::shared_ptr<const sindex_disk_info_t> get_sindex_info(
+        const uuid_u &sindex_id,
+        const std::vector<char> &opaque_definition);
+    std::map<uuid_u, std::pair<std::vector<char>,
+                               std::shared_ptr<const sindex_disk_info_t> > >
+        sindex_infos;
+
     // We construct secondary indexes by starting with a `universe()` construction_range,
     // and then making the range increasingly smaller until it is `empty()`.
     // While we are in that process, we must put any write for a primary key that is in
@@ -401,6 +452,19 @@ public:
     // `btree.cc`.
     rwlock_t cfeed_stamp_lock;
 
+    // Records which primary keys are busy, for load-aware rebalancing. Distribution
+    // queries report its contents.
+    key_load_sampler_t load_sampler;
+
+    // Grouped aggregates over indexes, kept up to date by the index updates. Writes
+    // take their tickets from it in `acquire_sindex_superblocks_for_write()`.
+    materialized_aggregates_t materialized_aggregates;
+
+    // Decoded copies of the rows that point reads ask for most. Every change to a row
+    // goes through `update_sindexes()` or `rdb_modification_report_cb_t`, which
+    // invalidate it.
+    row_cache_t row_cache;
+
 private:
     rdb_context_t *ctx;
     // We store regions here even though we only really need the key ranges
@@ -440,6 +504,16 @@ private:
     // the superblock, if any).
     new_semaphore_t write_superblock_acq_semaphore;
 
+    // Counts an access, and leaves the idle mode if the store was idle.
+    void note_access();
+
+    bool idle;
+    uint64_t access_count;
+    std::vector<block_id_t> idle_hot_block_ids;
+    // The policy from `configure_cache_balancer_policy()`, which the cache goes back
+    // to when the store stops being idle
+    cache_balancer_policy_t balancer_policy;
+
 public:
     // This lock is used to pause backfills while secondary indexes are being
     // post constructed. Secondary index post construction gets in line for a write
@@ -92,7 +92,7 @@ class receive_backfill_info_t {
 public:
     receive_backfill_info_t(
             cache_conn_t *c, btree_slice_t *s, unsaved_data_limiter_t *l) :
-        cache_conn(c), slice(s), limiter(l),
+        cache_conn(c), slice(s), limiter(l), range_was_empty(false),
         semaphore(MAX_CONCURRENT_BACKFILL_ITEMS) { }
 
     /* `cache_conn` and `slice` are just copied from the corresponding fields of the
@@ -103,6 +103,12 @@ public:
     /* `limiter` lives on the stack in `receive_backfill()` */
     unsaved_data_limiter_t *limiter;
 
+    /* `range_was_empty` is `true` if the B-tree had no entries at all in the range to be
+    backfilled when `receive_backfill()` started, as is the case for a new replica.
+    Nothing but the backfill writes to the part of the range that we haven't reached
+    yet, so `apply_multi_key_item()` can skip erasing the range of each item. */
+    bool range_was_empty;
+
     /* `semaphore` limits how many coroutines can be running at once. */
     new_semaphore_t semaphore;
 
@@ -330,27 +336,34 @@ void apply_multi_key_item(
 
             /* Establish an upper limit on how much of the range we're willing to delete
             in this cycle. We choose the upper limit such that it contains no more than
-            `MAX_CHANGES_PER_TXN / 2` of the pairs in the backfill item. */
+            `MAX_CHANGES_PER_TXN / 2` of the pairs in the backfill item. If there's
+            nothing to delete, all of the changes can go to the pairs. */
+            size_t max_pairs = tokens.info->range_was_empty
+                ? MAX_CHANGES_PER_TXN : MAX_CHANGES_PER_TXN / 2;
             key_range_t range_to_delete;
             range_to_delete.left = threshold.key();
-            if (next_pair + MAX_CHANGES_PER_TXN / 2 + 1 < item.pairs.size()) {
+            if (next_pair + max_pairs + 1 < item.pairs.size()) {
                 range_to_delete.right = key_range_t::right_bound_t(
-                    item.pairs[next_pair + MAX_CHANGES_PER_TXN / 2 + 1].key);
+                    item.pairs[next_pair + max_pairs + 1].key);
             } else {
                 range_to_delete.right = item.range.right;
             }
 
             /* Delete a chunk of the range, making sure to do no more than
             `MAX_CHANGES_PER_TXN / 2` changes at once. */
-            always_true_key_tester_t key_tester;
             key_range_t range_deleted;
-            rdb_live_deletion_context_t deletion_context;
-            continue_bool_t res = rdb_erase_small_range(tokens.info->slice, &key_tester,
-                range_to_delete, superblock.get(), &deletion_context,
-                &non_interruptor, MAX_CHANGES_PER_TXN / 2,
-                &mod_reports, &range_deleted);
-            guarantee(range_deleted.right == range_to_delete.right
-                || res == continue_bool_t::CONTINUE);
+            if (tokens.info->range_was_empty) {
+                range_deleted = range_to_delete;
+            } else {
+                always_true_key_tester_t key_tester;
+                rdb_live_deletion_context_t deletion_context;
+                continue_bool_t res = rdb_erase_small_range(tokens.info->slice,
+                    &key_tester, range_to_delete, superblock.get(), &deletion_context,
+                    &non_interruptor, MAX_CHANGES_PER_TXN / 2,
+                    &mod_reports, &range_deleted);
+                guarantee(range_deleted.right == range_to_delete.right
+                    || res == continue_bool_t::CONTINUE);
+            }
 
             /* Apply any pairs from the item that fall within the deleted region */
             while (next_pair < item.pairs.size() &&
@@ -388,10 +401,21 @@ continue_bool_t store_t::receive_backfill(
         signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t) {
     guarantee(_region.beg == get_region().beg && _region.end == get_region().end);
+    note_access();
 
     unsaved_data_limiter_t unsaved_data_limiter(general_cache_conn.get());
     receive_backfill_info_t info(
         general_cache_conn.get(), btree.get(), &unsaved_data_limiter);
+    {
+        scoped_ptr_t<real_superblock_t> superblock;
+        scoped_ptr_t<txn_t> txn;
+        get_btree_superblock_and_txn_for_reading(general_cache_conn.get(),
+            CACHE_SNAPSHOTTED_NO, &superblock, &txn);
+        rdb_value_sizer_t sizer(superblock->cache()->max_block_size());
+        info.range_was_empty = btree_receive_backfill_range_is_empty(
+            superblock.get(), release_superblock_t::RELEASE, &sizer, _region.inner,
+            interruptor);
+    }
 
     /* `spawn_threshold` is the point up to which we've spawned coroutines.
     `metainfo_threshold` is the point up to which we've applied the metainfo to the
@@ -60,6 +60,7 @@ continue_bool_t store_t::send_backfill_pre(
         backfill_pre_item_consumer_t *pre_item_consumer,
         signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t) {
+    note_access();
     /* `start_point` is in the form of a `region_map_t`, so we might have different
     start timestamps for different regions. But `btree_send_backfill_pre()` expects a
     single homogeneous timestamp. So we have to do each sub-region of `start_point`
@@ -226,6 +227,7 @@ continue_bool_t store_t::send_backfill(
         backfill_item_memory_tracker_t *memory_tracker,
         signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t) {
+    note_access();
     /* Just like in `send_backfill_pre()`, we first break `start_point` up into regions
     with homogeneous start timestamps, then backfill each region as a series of multiple
     B-tree transactions to avoid holding the superblock too long. */
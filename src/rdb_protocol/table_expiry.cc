@@ -0,0 +1,82 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/table_expiry.hpp"
+
+#include <limits>
+
+#include "rdb_protocol/func.hpp"
+#include "rdb_protocol/pseudo_time.hpp"
+#include "rdb_protocol/shards.hpp"
+
+read_t make_expired_rows_read(const std::string &expiry_field,
+                              const region_t &region,
+                              ql::datum_t now) {
+    /* The field can hold values that aren't times, so the lower bound has to be a
+    time too, or we would also read the rows where it's a number, say. */
+    ql::datumspec_t datumspec(ql::datum_range_t(
+        ql::pseudo::make_time(-std::numeric_limits<double>::max(), "+00:00"),
+        key_range_t::closed,
+        now,
+        key_range_t::open));
+    rget_read_t rget(
+        optional<changefeed_stamp_t>(),
+        region,
+        r_nullopt,
+        r_nullopt,
+        serializable_env_t(),
+        "",
+        ql::batchspec_t::default_for(ql::batch_type_t::NORMAL),
+        std::vector<ql::transform_variant_t>(),
+        optional<ql::terminal_variant_t>(),
+        make_optional(sindex_rangespec_t(expiry_field, r_nullopt, datumspec)),
+        sorting_t::UNORDERED);
+    /* This is what `read_t::shard()` would set, but the read is never sent anywhere
+    but to the primary replica of `region`. */
+    rget.current_shard.set(region);
+    return read_t(std::move(rget), profile_bool_t::DONT_PROFILE, read_mode_t::SINGLE);
+}
+
+bool get_expired_row_keys(const read_response_t &response,
+                          const std::string &primary_key,
+                          std::vector<store_key_t> *keys_out) {
+    keys_out->clear();
+    const rget_read_response_t *rget_response =
+        boost::get<rget_read_response_t>(&response.response);
+    if (rget_response == nullptr) {
+        return false;
+    }
+    const ql::grouped_t<ql::stream_t> *groups =
+        boost::get<ql::grouped_t<ql::stream_t> >(&rget_response->result);
+    if (groups == nullptr) {
+        return false;
+    }
+    for (const auto &group : *groups->get_underlying_map()) {
+        for (const auto &substream : group.second.substreams) {
+            for (const ql::rget_item_t &item : substream.second.stream) {
+                ql::datum_t key = item.data.get_field(
+                    datum_string_t(primary_key), ql::NOTHROW);
+                if (key.has()) {
+                    keys_out->push_back(store_key_t(key.print_primary()));
+                }
+            }
+        }
+    }
+    return true;
+}
+
+write_t make_expire_rows_write(std::vector<store_key_t> &&keys,
+                               const std::string &primary_key,
+                               const std::string &expiry_field,
+                               ql::datum_t now) {
+    /* Expiry isn't a write by a user, so it doesn't run the table's write hook. */
+    batched_replace_t replace(
+        std::move(keys),
+        primary_key,
+        ql::new_expiry_func(
+            datum_string_t(expiry_field), now, ql::backtrace_id_t::empty()),
+        r_nullopt,
+        serializable_env_t(),
+        return_changes_t::NO);
+    return write_t(std::move(replace),
+                   profile_bool_t::DONT_PROFILE,
+                   ql::configured_limits_t());
+}
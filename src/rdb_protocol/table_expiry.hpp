@@ -0,0 +1,40 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_TABLE_EXPIRY_HPP_
+#define RDB_PROTOCOL_TABLE_EXPIRY_HPP_
+
+#include <string>
+#include <vector>
+
+#include "rdb_protocol/protocol.hpp"
+
+/* Tables with an `expiry_field` (see `table_config_t`) have the rows whose value for
+that field is a time in the past deleted in the background. The primary replica of
+each shard does this with the functions below, see
+`primary_execution_t::expire_rows()`.
+
+The expired rows are found through the secondary index of the same name as the field,
+so finding them doesn't scan the table. They are deleted with an ordinary
+`batched_replace_t`, so the deletions go to the other replicas, the secondary indexes
+and the changefeeds like any other write. The replacement function checks the row
+again, because the row can change between the read and the write. */
+
+/* Returns a read for the rows in `region` whose value in the expiry index is a time
+before `now`. */
+read_t make_expired_rows_read(const std::string &expiry_field,
+                              const region_t &region,
+                              ql::datum_t now);
+
+/* Sets `*keys_out` to the primary keys of the rows that the read found. Returns false
+if the read failed, which is the case until the expiry index has been built. */
+bool get_expired_row_keys(const read_response_t &response,
+                          const std::string &primary_key,
+                          std::vector<store_key_t> *keys_out);
+
+/* Returns a write that deletes the rows with the given keys if they have still
+expired at `now`. */
+write_t make_expire_rows_write(std::vector<store_key_t> &&keys,
+                               const std::string &primary_key,
+                               const std::string &expiry_field,
+                               ql::datum_t now);
+
+#endif  // RDB_PROTOCOL_TABLE_EXPIRY_HPP_
@@ -10,6 +10,7 @@
 #include "rdb_protocol/minidriver.hpp"
 #include "rdb_protocol/query_cache.hpp"
 #include "rdb_protocol/response.hpp"
+#include "rdb_protocol/term_folding.hpp"
 #include "rdb_protocol/term_walker.hpp"
 #include "rdb_protocol/terms/terms.hpp"
 #include "thread_local.hpp"
@@ -86,6 +87,9 @@ counted_t<const term_t> compile_on_current_stack(
     case Term::COUNT:              return make_count_term(env, t);
     case Term::SUM:                return make_sum_term(env, t);
     case Term::AVG:                return make_avg_term(env, t);
+    case Term::APPROX_COUNT_DISTINCT:
+        return make_approx_count_distinct_term(env, t);
+    case Term::APPROX_QUANTILE:    return make_approx_quantile_term(env, t);
     case Term::MIN:                return make_min_term(env, t);
     case Term::MAX:                return make_max_term(env, t);
     case Term::UNION:              return make_union_term(env, t);
@@ -98,6 +102,7 @@ counted_t<const term_t> compile_on_current_stack(
     case Term::EQ_JOIN:            return make_eq_join_term(env, t);
     case Term::ZIP:                return make_zip_term(env, t);
     case Term::RANGE:              return make_range_term(env, t);
+    case Term::CHUNKS:             return make_chunks_term(env, t);
     case Term::INSERT_AT:          return make_insert_at_term(env, t);
     case Term::DELETE_AT:          return make_delete_at_term(env, t);
     case Term::CHANGE_AT:          return make_change_at_term(env, t);
@@ -216,7 +221,9 @@ counted_t<const term_t> compile_on_current_stack(
 
 counted_t<const term_t> compile_term(compile_env_t *env, const raw_term_t &t) {
     return call_with_enough_stack<counted_t<const term_t> >([&]() {
-            return compile_on_current_stack(env, std::move(t));
+            size_t unfoldable_before = env->unfoldable_terms;
+            return fold_term(env, t, unfoldable_before,
+                             compile_on_current_stack(env, t));
         }, MIN_COMPILE_STACK_SPACE);
 }
 
@@ -62,6 +62,10 @@ public:
 protected:
     explicit runtime_term_t(backtrace_id_t bt);
 private:
+    // The wrappers in `term_folding.cc` evaluate the terms they wrap directly.
+    friend class folded_term_t;
+    friend class shared_selection_term_t;
+
     scoped_ptr_t<val_t> eval_on_current_stack(
             scope_env_t *env,
             eval_flags_t eval_flags) const;
@@ -84,6 +88,7 @@ public:
 protected:
     // Union term is a friend so we can steal arguments from an array in an optarg.
     friend class union_term_t;
+    friend class folded_term_t;
     virtual const std::vector<counted_t<const term_t> > &get_original_args() const {
         rfail(base_exc_t::INTERNAL,
                "This is in term_t to allow stealing args from an"
@@ -0,0 +1,220 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/term_folding.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+#include "arch/runtime/runtime.hpp"
+#include "rdb_protocol/env.hpp"
+#include "rdb_protocol/op.hpp"
+#include "rdb_protocol/term.hpp"
+
+namespace ql {
+
+/* A deterministic term that uses no variables. Its value is kept once it has been
+evaluated, for as long as it's evaluated in the same `env_t`. */
+class folded_term_t : public term_t {
+public:
+    folded_term_t(counted_t<const term_t> &&_inner, deterministic_t _deterministic)
+        : term_t(_inner->get_src()),
+          inner(std::move(_inner)),
+          deterministic(_deterministic),
+          thread(get_thread_id()),
+          value_env(nullptr) { }
+
+    deterministic_t is_deterministic() const final { return deterministic; }
+    const char *name() const final { return inner->name(); }
+    void accumulate_captures(var_captures_t *) const final { }
+    bool is_simple_selector() const final { return inner->is_simple_selector(); }
+
+protected:
+    const std::vector<counted_t<const term_t> > &get_original_args() const final {
+        return inner->get_original_args();
+    }
+
+private:
+    scoped_ptr_t<val_t> term_eval(scope_env_t *env, eval_flags_t eval_flags) const {
+        // Compiled terms can be copied to other threads along with functions, so only
+        // the thread that compiled this one keeps a value in it.
+        if (eval_flags != NO_FLAGS || get_thread_id() != thread) {
+            return inner->term_eval(env, eval_flags);
+        }
+        if (value_env == env->env) {
+            return new_val(value);
+        }
+        scoped_ptr_t<val_t> res = inner->term_eval(env, eval_flags);
+        if (res->get_type().get_raw_type() == val_t::type_t::DATUM) {
+            value = res->as_datum();
+            value_env = env->env;
+        }
+        return res;
+    }
+
+    const counted_t<const term_t> inner;
+    const deterministic_t deterministic;
+    const threadnum_t thread;
+    mutable datum_t value;
+    // Different environments can have different limits, which could make the term
+    // fail in one of them but not in another.
+    mutable env_t *value_env;
+};
+
+/* A field selection on a variable that occurs more than once in a function body. All
+the occurrences have the same id, and the first one to be evaluated in a call of the
+function leaves its value in the `scope_env_t` for the others. */
+class shared_selection_term_t : public term_t {
+public:
+    shared_selection_term_t(counted_t<const term_t> &&_inner, uint64_t _id)
+        : term_t(_inner->get_src()),
+          inner(std::move(_inner)),
+          id(_id) { }
+
+    deterministic_t is_deterministic() const final { return inner->is_deterministic(); }
+    const char *name() const final { return inner->name(); }
+    void accumulate_captures(var_captures_t *captures) const final {
+        inner->accumulate_captures(captures);
+    }
+    bool is_simple_selector() const final { return inner->is_simple_selector(); }
+
+private:
+    scoped_ptr_t<val_t> term_eval(scope_env_t *env, eval_flags_t eval_flags) const {
+        if (eval_flags != NO_FLAGS) {
+            return inner->term_eval(env, eval_flags);
+        }
+        auto it = env->shared_selections.find(id);
+        if (it != env->shared_selections.end()) {
+            return new_val(it->second);
+        }
+        scoped_ptr_t<val_t> res = inner->term_eval(env, eval_flags);
+        if (res->get_type().get_raw_type() == val_t::type_t::DATUM) {
+            env->shared_selections.insert(std::make_pair(id, res->as_datum()));
+        }
+        return res;
+    }
+
+    const counted_t<const term_t> inner;
+    const uint64_t id;
+};
+
+/* If `term` selects one or more fields of a variable, like `row('a')('b')`, sets
+`*key_out` to a string that's the same for every selection of the same fields of the
+same variable. */
+static bool selection_key(const raw_term_t &term, std::string *key_out) {
+    std::vector<std::string> steps;
+    raw_term_t t = term;
+    while (t.type() == Term::GET_FIELD || t.type() == Term::BRACKET) {
+        if (t.num_args() != 2 || t.num_optargs() != 0) {
+            return false;
+        }
+        raw_term_t field = t.arg(1);
+        if (field.type() != Term::DATUM) {
+            return false;
+        }
+        datum_t d = field.datum();
+        if (d.get_type() != datum_t::R_STR) {
+            return false;
+        }
+        steps.push_back(strprintf("%c%zu:",
+                                  t.type() == Term::GET_FIELD ? 'g' : 'b',
+                                  d.as_str().size())
+                        + d.as_str().to_std());
+        t = t.arg(0);
+    }
+    if (steps.empty()) {
+        return false;
+    }
+    if (t.type() == Term::IMPLICIT_VAR && t.num_args() == 0) {
+        *key_out = "r";
+    } else if (t.type() == Term::VAR
+               && t.num_args() == 1
+               && t.arg(0).type() == Term::DATUM
+               && t.arg(0).datum().get_type() == datum_t::R_NUM) {
+        *key_out = strprintf("v%" PRIi64,
+                             static_cast<int64_t>(t.arg(0).datum().as_num()));
+    } else {
+        return false;
+    }
+    std::reverse(steps.begin(), steps.end());
+    for (const std::string &step : steps) {
+        *key_out += step;
+    }
+    return true;
+}
+
+void count_selections(compile_env_t *env, const raw_term_t &body) {
+    // Bodies can be deeply nested, so we don't recurse.
+    std::vector<raw_term_t> to_visit(1, body);
+    while (!to_visit.empty()) {
+        raw_term_t t = to_visit.back();
+        to_visit.pop_back();
+        if (t.type() == Term::FUNC) {
+            // Nested functions are called with their own scopes, and count their own
+            // selections.
+            continue;
+        }
+        std::string key;
+        if (selection_key(t, &key)) {
+            ++env->selection_counts[key];
+        }
+        for (size_t i = 0; i < t.num_args(); ++i) {
+            to_visit.push_back(t.arg(i));
+        }
+        t.each_optarg([&](const raw_term_t &optarg, const std::string &) {
+                to_visit.push_back(optarg);
+            });
+    }
+}
+
+static std::atomic<uint64_t> next_selection_id(0);
+
+counted_t<const term_t> fold_term(compile_env_t *env,
+                                  const raw_term_t &t,
+                                  size_t unfoldable_before,
+                                  counted_t<const term_t> &&compiled) {
+    if (env->visibility.is_empty()) {
+        // Not in a function, so it's evaluated only once anyway.
+        return std::move(compiled);
+    }
+    switch (t.type()) {
+    case Term::DATUM:
+        return std::move(compiled);
+    case Term::FUNC: // fallthru
+    case Term::VAR: // fallthru
+    case Term::IMPLICIT_VAR:
+        ++env->unfoldable_terms;
+        return std::move(compiled);
+    default:
+        break;
+    }
+
+    if (env->unfoldable_terms != unfoldable_before) {
+        // One of its arguments can't be folded, so it can't either. (This also keeps
+        // us from looking at the same terms over and over again.)
+        std::string key;
+        if (selection_key(t, &key) && env->selection_counts[key] >= 2) {
+            auto id_it = env->selection_ids.find(key);
+            if (id_it == env->selection_ids.end()) {
+                id_it = env->selection_ids.insert(
+                    std::make_pair(key, ++next_selection_id)).first;
+            }
+            return make_counted<shared_selection_term_t>(
+                std::move(compiled), id_it->second);
+        }
+        return std::move(compiled);
+    }
+
+    // `r.now()` was already replaced by a datum in `preprocess_term_tree()`, so we
+    // don't need to fold what's left of it.
+    deterministic_t deterministic = compiled->is_deterministic();
+    var_captures_t captures;
+    compiled->accumulate_captures(&captures);
+    if (!deterministic.test(single_server_t::yes, constant_now_t::no)
+        || !captures.vars_captured.empty()
+        || captures.implicit_is_captured) {
+        ++env->unfoldable_terms;
+        return std::move(compiled);
+    }
+    return make_counted<folded_term_t>(std::move(compiled), deterministic);
+}
+
+}  // namespace ql
@@ -0,0 +1,40 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_TERM_FOLDING_HPP_
+#define RDB_PROTOCOL_TERM_FOLDING_HPP_
+
+#include "containers/counted.hpp"
+
+namespace ql {
+
+class compile_env_t;
+class raw_term_t;
+class term_t;
+
+/* Functions like those passed to `map` and `filter` are evaluated once per row, and
+so is every term in them, even the ones that don't depend on the row. `fold_term()` is
+applied to every term compiled inside a function body, and wraps two kinds of terms:
+
+ - Terms that are deterministic and use no variables, like `r.expr([1, 2, 3])` or
+   `r.epoch_time(1e9).add(3600)`, are evaluated the first time they're needed and
+   their value is reused for the rest of the query.
+
+ - Field selections on a variable, like `row('a')('b')`, that occur more than once in
+   the same function body are evaluated only once per call of the function.
+
+Only values that are datums are reused; errors, streams and anything evaluated with
+flags are always evaluated again. The wrappers keep the source and backtrace of the
+term they wrap, so errors and `is_simple_selector()` are unaffected.
+
+`count_selections()` has to be called with the raw body of a function before it's
+compiled, for the field selections to be shared. */
+void count_selections(compile_env_t *env, const raw_term_t &body);
+
+/* `unfoldable_before` is `env->unfoldable_terms` from before `t` was compiled. */
+counted_t<const term_t> fold_term(compile_env_t *env,
+                                  const raw_term_t &t,
+                                  size_t unfoldable_before,
+                                  counted_t<const term_t> &&compiled);
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_TERM_FOLDING_HPP_
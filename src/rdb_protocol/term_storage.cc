@@ -30,6 +30,10 @@ bool query_type_is_valid(Query::QueryType query_type) {
     case Query::STOP:
     case Query::NOREPLY_WAIT:
     case Query::SERVER_INFO:
+    case Query::PREPARE:
+    case Query::EXECUTE:
+    case Query::UNPREPARE:
+    case Query::CHUNK:
         return true;
     default:
         return false;
@@ -229,12 +233,44 @@ bool term_storage_t::static_optarg_as_bool(UNUSED const std::string &key,
     unreachable();
 }
 
+optional<std::string> term_storage_t::static_optarg_as_string(
+        UNUSED const std::string &key) const {
+    r_sanity_check(false, "static_optarg_as_string() is unimplemented "
+                   "for this term_storage_t type");
+    unreachable();
+}
+
+const rapidjson::Value &term_storage_t::original_query_json() const {
+    r_sanity_check(false, "original_query_json() is unimplemented "
+                   "for this term_storage_t type");
+    unreachable();
+}
+
 global_optargs_t term_storage_t::global_optargs() {
     r_sanity_check(false, "global_optargs() is unimplemented "
                    "for this term_storage_t type");
     unreachable();
 }
 
+int64_t term_storage_t::prepared_query_handle() const {
+    r_sanity_check(false, "prepared_query_handle() is unimplemented "
+                   "for this term_storage_t type");
+    unreachable();
+}
+
+std::vector<datum_t> term_storage_t::prepared_query_args(
+        const configured_limits_t &) const {
+    r_sanity_check(false, "prepared_query_args() is unimplemented "
+                   "for this term_storage_t type");
+    unreachable();
+}
+
+std::vector<datum_t> term_storage_t::chunk_docs(const configured_limits_t &) const {
+    r_sanity_check(false, "chunk_docs() is unimplemented "
+                   "for this term_storage_t type");
+    unreachable();
+}
+
 const backtrace_registry_t &term_storage_t::backtrace_registry() const {
     return bt_reg;
 }
@@ -270,6 +306,34 @@ json_term_storage_t::json_term_storage_t(scoped_array_t<char> &&_original_data,
                        backtrace_registry_t::EMPTY_BACKTRACE);
     }
 
+    // `EXECUTE` and `UNPREPARE` queries don't contain a term, they refer to one by
+    // its handle.
+    Query::QueryType type = query_type();
+    if (type == Query::EXECUTE || type == Query::UNPREPARE) {
+        const rapidjson::Value *handle = nullptr;
+        if (query_json.Size() >= 2) {
+            if (type == Query::UNPREPARE) {
+                handle = &query_json[1];
+            } else if (query_json[1].IsArray() && query_json[1].Size() >= 1) {
+                handle = &query_json[1][0];
+            }
+        }
+        if (handle == nullptr || !handle->IsInt64()) {
+            throw bt_exc_t(Response::CLIENT_ERROR, Response::QUERY_LOGIC,
+                           type == Query::UNPREPARE
+                               ? "Expected an UNPREPARE query to contain a handle."
+                               : "Expected an EXECUTE query to contain an array "
+                                 "of a handle followed by the arguments.",
+                           backtrace_registry_t::EMPTY_BACKTRACE);
+        }
+    }
+    if (type == Query::CHUNK
+        && (query_json.Size() < 2 || !query_json[1].IsArray())) {
+        throw bt_exc_t(Response::CLIENT_ERROR, Response::QUERY_LOGIC,
+                       "Expected a CHUNK query to contain an array of documents.",
+                       backtrace_registry_t::EMPTY_BACKTRACE);
+    }
+
     if (query_json.Size() >= 3) {
         if (!query_json[2].IsObject()) {
             throw bt_exc_t(Response::CLIENT_ERROR, Response::QUERY_LOGIC,
@@ -285,6 +349,10 @@ Query::QueryType json_term_storage_t::query_type() const {
     return static_cast<Query::QueryType>(query_json[0].GetInt());
 }
 
+const rapidjson::Value &json_term_storage_t::original_query_json() const {
+    return query_json;
+}
+
 void json_term_storage_t::preprocess() {
     r_sanity_check(query_json.Size() >= 2);
     preprocess_term_tree(&query_json[1], &query_json.GetAllocator(), &bt_reg);
@@ -322,6 +390,24 @@ bool json_term_storage_t::static_optarg_as_bool(const std::string &key,
 
 }
 
+optional<std::string> json_term_storage_t::static_optarg_as_string(
+        const std::string &key) const {
+    r_sanity_check(query_json.IsArray());
+    if (query_json.Size() < 3) {
+        return r_nullopt;
+    }
+
+    const rapidjson::Value *_global_optargs = &query_json[2];
+    r_sanity_check(_global_optargs->IsObject());
+
+    const auto it = _global_optargs->FindMember(key.c_str());
+    if (it == _global_optargs->MemberEnd() || !it->value.IsString()) {
+        return r_nullopt;
+    }
+    return make_optional(
+        std::string(it->value.GetString(), it->value.GetStringLength()));
+}
+
 global_optargs_t json_term_storage_t::global_optargs() {
     auto &allocator = query_json.GetAllocator();
     rapidjson::Value *src;
@@ -361,6 +447,38 @@ global_optargs_t json_term_storage_t::global_optargs() {
     return res;
 }
 
+int64_t json_term_storage_t::prepared_query_handle() const {
+    Query::QueryType type = query_type();
+    r_sanity_check(type == Query::EXECUTE || type == Query::UNPREPARE);
+    return type == Query::UNPREPARE
+        ? query_json[1].GetInt64()
+        : query_json[1][0].GetInt64();
+}
+
+std::vector<datum_t> json_term_storage_t::prepared_query_args(
+        const configured_limits_t &limits) const {
+    r_sanity_check(query_type() == Query::EXECUTE);
+    const rapidjson::Value &array = query_json[1];
+    std::vector<datum_t> res;
+    res.reserve(array.Size() - 1);
+    for (rapidjson::SizeType i = 1; i < array.Size(); ++i) {
+        res.push_back(to_datum(array[i], limits, reql_version_t::LATEST));
+    }
+    return res;
+}
+
+std::vector<datum_t> json_term_storage_t::chunk_docs(
+        const configured_limits_t &limits) const {
+    r_sanity_check(query_type() == Query::CHUNK);
+    const rapidjson::Value &array = query_json[1];
+    std::vector<datum_t> res;
+    res.reserve(array.Size());
+    for (rapidjson::SizeType i = 0; i < array.Size(); ++i) {
+        res.push_back(to_datum(array[i], limits, reql_version_t::LATEST));
+    }
+    return res;
+}
+
 wire_term_storage_t::wire_term_storage_t(scoped_array_t<char> &&_original_data,
                                          rapidjson::Document &&_func_json) :
         original_data(std::move(_original_data)),
@@ -552,7 +670,13 @@ MUST_USE archive_result_t deserialize_term_tree<cluster_version_t::v2_4>(
 }
 
 template <>
-MUST_USE archive_result_t deserialize_term_tree<cluster_version_t::v2_5_is_latest>(
+MUST_USE archive_result_t deserialize_term_tree<cluster_version_t::v2_5>(
+        read_stream_t *s, scoped_ptr_t<term_storage_t> *term_storage_out) {
+    return deserialize_term_tree<cluster_version_t::v2_2>(s, term_storage_out);
+}
+
+template <>
+MUST_USE archive_result_t deserialize_term_tree<cluster_version_t::v2_6_is_latest>(
         read_stream_t *s, scoped_ptr_t<term_storage_t> *term_storage_out) {
     return deserialize_term_tree<cluster_version_t::v2_2>(s, term_storage_out);
 }
@@ -10,6 +10,7 @@
 #include <boost/variant.hpp>
 
 #include "containers/counted.hpp"
+#include "containers/optional.hpp"
 #include "containers/scoped.hpp"
 #include "rapidjson/rapidjson.h"
 #include "rdb_protocol/rdb_backtrace.hpp"
@@ -131,8 +132,18 @@ public:
     virtual Query::QueryType query_type() const;
     virtual bool static_optarg_as_bool(const std::string &key,
                                        bool default_value) const;
+    virtual optional<std::string> static_optarg_as_string(const std::string &key) const;
+    // The whole query as the client sent it, only valid before `preprocess()`
+    virtual const rapidjson::Value &original_query_json() const;
     virtual void preprocess();
     virtual global_optargs_t global_optargs();
+    // For `EXECUTE` and `UNPREPARE` queries
+    virtual int64_t prepared_query_handle() const;
+    // For `EXECUTE` queries
+    virtual std::vector<datum_t> prepared_query_args(
+        const configured_limits_t &limits) const;
+    // For `CHUNK` queries
+    virtual std::vector<datum_t> chunk_docs(const configured_limits_t &limits) const;
 
 protected:
     backtrace_registry_t bt_reg;
@@ -145,9 +156,14 @@ public:
     Query::QueryType query_type() const;
     bool static_optarg_as_bool(const std::string &key,
                                bool default_value) const;
+    optional<std::string> static_optarg_as_string(const std::string &key) const;
+    const rapidjson::Value &original_query_json() const;
     void preprocess();
     raw_term_t root_term() const;
     global_optargs_t global_optargs();
+    int64_t prepared_query_handle() const;
+    std::vector<datum_t> prepared_query_args(const configured_limits_t &limits) const;
+    std::vector<datum_t> chunk_docs(const configured_limits_t &limits) const;
 private:
     scoped_array_t<char> original_data;
     rapidjson::Document query_json;
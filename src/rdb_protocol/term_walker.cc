@@ -280,6 +280,8 @@ bool term_type_is_valid(Term::TermType type) {
     case Term::COUNT:
     case Term::SUM:
     case Term::AVG:
+    case Term::APPROX_COUNT_DISTINCT:
+    case Term::APPROX_QUANTILE:
     case Term::MIN:
     case Term::MAX:
     case Term::UNION:
@@ -293,6 +295,7 @@ bool term_type_is_valid(Term::TermType type) {
     case Term::EQ_JOIN:
     case Term::ZIP:
     case Term::RANGE:
+    case Term::CHUNKS:
     case Term::INSERT_AT:
     case Term::DELETE_AT:
     case Term::CHANGE_AT:
@@ -471,6 +474,8 @@ bool term_is_write_or_meta(Term::TermType type) {
     case Term::COUNT:
     case Term::SUM:
     case Term::AVG:
+    case Term::APPROX_COUNT_DISTINCT:
+    case Term::APPROX_QUANTILE:
     case Term::MIN:
     case Term::MAX:
     case Term::UNION:
@@ -484,6 +489,7 @@ bool term_is_write_or_meta(Term::TermType type) {
     case Term::EQ_JOIN:
     case Term::ZIP:
     case Term::RANGE:
+    case Term::CHUNKS:
     case Term::INSERT_AT:
     case Term::DELETE_AT:
     case Term::CHANGE_AT:
@@ -600,6 +606,8 @@ bool term_forbids_writes(Term::TermType type) {
     case Term::COUNT:
     case Term::SUM:
     case Term::AVG:
+    case Term::APPROX_COUNT_DISTINCT:
+    case Term::APPROX_QUANTILE:
     case Term::MIN:
     case Term::MAX:
         return true;
@@ -658,6 +666,7 @@ bool term_forbids_writes(Term::TermType type) {
     case Term::SKIP:
     case Term::ZIP:
     case Term::RANGE:
+    case Term::CHUNKS:
     case Term::INSERT_AT:
     case Term::DELETE_AT:
     case Term::CHANGE_AT:
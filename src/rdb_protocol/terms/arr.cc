@@ -22,20 +22,13 @@ protected:
     scoped_ptr_t<val_t> pend(scope_env_t *env, args_t *args, which_pend_t which_pend) const {
         datum_t arr = args->arg(env, 0)->as_datum();
         datum_t new_el = args->arg(env, 1)->as_datum();
-        datum_array_builder_t out(env->env->limits());
-        out.reserve(arr.arr_size() + 1);
+        // If `arr` was the result of another term, nothing else refers to it by now
+        // and its elements don't have to be copied.
+        datum_array_builder_t out(std::move(arr), env->env->limits());
         if (which_pend == PRE) {
-            // TODO: this is horrendously inefficient.
-            out.add(new_el);
-            for (size_t i = 0; i < arr.arr_size(); ++i) {
-                out.add(arr.get(i));
-            }
+            out.insert(0, std::move(new_el));
         } else {
-            // TODO: this is horrendously inefficient.
-            for (size_t i = 0; i < arr.arr_size(); ++i) {
-                out.add(arr.get(i));
-            }
-            out.add(new_el);
+            out.add(std::move(new_el));
         }
         return new_val(std::move(out).to_datum());
     }
@@ -110,7 +103,7 @@ scoped_ptr_t<val_t> nth_term_direct_impl(const term_t *term,
 
         batchspec_t batchspec = batchspec_t::user(batch_type_t::TERMINAL, env->env);
         if (n != -1) {
-            batchspec = batchspec.with_at_most(int64_t(n)+1);
+            batchspec = batchspec.with_limit(int64_t(n)+1);
         }
 
         datum_t last_d;
@@ -375,8 +368,9 @@ private:
         std::set<datum_t, optional_datum_less_t> el_set;
         datum_array_builder_t out(env->env->limits());
         for (size_t i = 0; i < arr.arr_size(); ++i) {
-            if (el_set.insert(arr.get(i)).second) {
-                out.add(arr.get(i));
+            datum_t el = arr.get(i);
+            if (el_set.insert(el).second) {
+                out.add(std::move(el));
             }
         }
         if (!std_contains(el_set, new_el)) {
@@ -494,7 +488,10 @@ public:
                         datum_array_builder_t *array) const = 0;
 
     scoped_ptr_t<val_t> eval_impl(scope_env_t *env, args_t *args, eval_flags_t) const {
-        datum_array_builder_t arr(args->arg(env, 0)->as_datum(), env->env->limits());
+        // The value of the first argument has to be gone before the builder is made
+        // for it to take the elements over rather than copy them.
+        datum_t arr_datum = args->arg(env, 0)->as_datum();
+        datum_array_builder_t arr(std::move(arr_datum), env->env->limits());
         size_t index;
         if (index_method_ == ELEMENTS) {
             index = canonicalize(this, args->arg(env, 1)->as_datum().as_int(), arr.size());
@@ -1,35 +1,73 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
 #include "rdb_protocol/terms/terms.hpp"
 
+#include <stdint.h>
+#include <string.h>
+
 #include "rdb_protocol/error.hpp"
 #include "rdb_protocol/op.hpp"
 
 namespace ql {
 
+/* Flips the case of the ASCII letters from `lo` to `hi` in `s`, and leaves every
+other byte alone, just like `toupper` or `tolower` in the C locale would. Since bytes
+of multibyte UTF-8 characters all have their high bit set, this is correct for UTF-8
+too. It works on eight bytes at a time: in each byte, it computes whether the low
+seven bits lie in [lo, hi] without carrying into the next byte, and masks out the
+bytes with the high bit set. */
+static void flip_ascii_case(char lo, char hi, std::string *s) {
+    const uint64_t ones = 0x0101010101010101ull;
+    const uint64_t high_bits = 0x8080808080808080ull;
+    const uint64_t low_bits = 0x7f7f7f7f7f7f7f7full;
+    // Adding these sets a byte's high bit if it's at least `lo` or more than `hi`.
+    const uint64_t add_for_ge_lo = (0x80 - lo) * ones;
+    const uint64_t add_for_gt_hi = (0x7f - hi) * ones;
+
+    char *pos = &(*s)[0];
+    char *const end = pos + s->size();
+    for (; end - pos >= static_cast<ptrdiff_t>(sizeof(uint64_t));
+         pos += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, pos, sizeof(word));
+        const uint64_t heptets = word & low_bits;
+        const uint64_t in_range =
+            (heptets + add_for_ge_lo) & ~(heptets + add_for_gt_hi) & ~word & high_bits;
+        // The case bit is 0x20, two bits below the high bit.
+        word ^= in_range >> 2;
+        memcpy(pos, &word, sizeof(word));
+    }
+    for (; pos < end; ++pos) {
+        if (*pos >= lo && *pos <= hi) {
+            *pos ^= 0x20;
+        }
+    }
+}
+
 class case_term_t : public op_term_t {
 public:
     case_term_t(compile_env_t *env, const raw_term_t &term,
-                const char *_name, int (*_f)(int))
-        : op_term_t(env, term, argspec_t(1)), name_(_name), f(_f) { }
+                const char *_name, char _lo, char _hi)
+        : op_term_t(env, term, argspec_t(1)), name_(_name), lo(_lo), hi(_hi) { }
 private:
     virtual scoped_ptr_t<val_t> eval_impl(scope_env_t *env, args_t *args, eval_flags_t) const {
         std::string s = args->arg(env, 0)->as_str().to_std();
-        std::transform(s.begin(), s.end(), s.begin(), f);
+        flip_ascii_case(lo, hi, &s);
         return new_val(datum_t(datum_string_t(s)));
     }
     virtual const char *name() const { return name_; }
 
     const char *const name_;
-    int (*const f)(int);
+    // The range of letters whose case is flipped.
+    const char lo, hi;
 };
 
 counted_t<term_t> make_upcase_term(
         compile_env_t *env, const raw_term_t &term) {
-    return make_counted<case_term_t>(env, term, "upcase", ::toupper);
+    return make_counted<case_term_t>(env, term, "upcase", 'a', 'z');
 }
 counted_t<term_t> make_downcase_term(
         compile_env_t *env, const raw_term_t &term) {
-    return make_counted<case_term_t>(env, term, "downcase", ::tolower);
+    return make_counted<case_term_t>(env, term, "downcase", 'A', 'Z');
 }
 
 }  // namespace ql
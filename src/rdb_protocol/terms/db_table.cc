@@ -7,6 +7,8 @@
 #include "clustering/administration/admin_op_exc.hpp"
 #include "clustering/administration/auth/permissions.hpp"
 #include "clustering/administration/auth/username.hpp"
+#include "clustering/administration/tables/table_metadata.hpp"
+#include "clustering/table_contract/cpu_sharding.hpp"
 #include "containers/name_string.hpp"
 #include "rdb_protocol/datum_string.hpp"
 #include "rdb_protocol/op.hpp"
@@ -162,7 +164,7 @@ public:
         : meta_op_term_t(env, term, argspec_t(1, 2),
             optargspec_t({"primary_key", "shards", "replicas",
                           "nonvoting_replica_tags", "primary_replica_tag",
-                          "durability"})) { }
+                          "durability", "cpu_shards", "block_size"})) { }
 private:
     virtual scoped_ptr_t<val_t> eval_impl(
             scope_env_t *env, args_t *args, eval_flags_t) const {
@@ -194,6 +196,31 @@ private:
                 DURABILITY_REQUIREMENT_SOFT ?
                     write_durability_t::SOFT : write_durability_t::HARD;
 
+        // Parse the 'cpu_shards' optarg
+        int cpu_sharding_factor = CPU_SHARDING_FACTOR;
+        if (scoped_ptr_t<val_t> v = args->optarg(env, "cpu_shards")) {
+            int64_t cpu_shards = v->as_int();
+            rcheck_target(v,
+                          cpu_shards >= 1 && cpu_shards <= MAX_CPU_SHARDING_FACTOR,
+                          base_exc_t::LOGIC,
+                          strprintf("`cpu_shards` must be between 1 and %d.",
+                                    MAX_CPU_SHARDING_FACTOR));
+            cpu_sharding_factor = cpu_shards;
+        }
+
+        // Parse the 'block_size' optarg
+        int block_size = DEFAULT_BTREE_BLOCK_SIZE;
+        if (scoped_ptr_t<val_t> v = args->optarg(env, "block_size")) {
+            int64_t requested_block_size = v->as_int();
+            rcheck_target(v,
+                          is_valid_table_block_size(requested_block_size),
+                          base_exc_t::LOGIC,
+                          strprintf("`block_size` must be a power of two between "
+                                    "%lld and %lld.",
+                                    MIN_BTREE_BLOCK_SIZE, MAX_BTREE_BLOCK_SIZE));
+            block_size = requested_block_size;
+        }
+
         counted_t<const db_t> db;
         name_string_t tbl_name;
         if (args->num_args() == 1) {
@@ -217,6 +244,8 @@ private:
                     config_params,
                     primary_key,
                     durability,
+                    cpu_sharding_factor,
+                    block_size,
                     env->env->interruptor,
                     &result,
                     &error)) {
@@ -829,6 +858,7 @@ public:
 private:
     virtual scoped_ptr_t<val_t> eval_impl(scope_env_t *env, args_t *args, eval_flags_t) const {
         read_mode_t read_mode = read_mode_t::SINGLE;
+        bool snapshot_reads = false;
         if (scoped_ptr_t<val_t> v = args->optarg(env, "use_outdated")) {
             rfail(base_exc_t::LOGIC, "%s",
                   "The `use_outdated` optarg is no longer supported.  "
@@ -840,13 +870,19 @@ private:
                 read_mode = read_mode_t::MAJORITY;
             } else if (str == "single") {
                 read_mode = read_mode_t::SINGLE;
+            } else if (str == "snapshot") {
+                read_mode = read_mode_t::SINGLE;
+                snapshot_reads = true;
             } else if (str == "outdated") {
                 read_mode = read_mode_t::OUTDATED;
+            } else if (str == "bounded") {
+                read_mode = read_mode_t::BOUNDED_STALENESS;
             } else if (str == "_debug_direct") {
                 read_mode = read_mode_t::DEBUG_DIRECT;
             } else {
                 rfail(base_exc_t::LOGIC, "Read mode `%s` unrecognized (options "
-                      "are \"majority\", \"single\", and \"outdated\").",
+                      "are \"majority\", \"single\", \"snapshot\", "
+                      "\"outdated\", and \"bounded\").",
                       str.to_std().c_str());
             }
         }
@@ -883,8 +919,10 @@ private:
                 identifier_format, env->env->interruptor, &table, &error)) {
             REQL_RETHROW(error);
         }
-        return new_val(make_counted<table_t>(
-            std::move(table), db, table_name.str(), read_mode, backtrace()));
+        counted_t<table_t> t = make_counted<table_t>(
+            std::move(table), db, table_name.str(), read_mode, backtrace());
+        t->snapshot_reads = snapshot_reads;
+        return new_val(std::move(t));
     }
     virtual deterministic_t is_deterministic() const { return deterministic_t::no(); }
     virtual const char *name() const { return "table"; }
@@ -909,11 +947,14 @@ private:
 class get_all_term_t : public op_term_t {
 public:
     get_all_term_t(compile_env_t *env, const raw_term_t &term)
-        : op_term_t(env, term, argspec_t(1, -1), optargspec_t({ "index" })) { }
+        : op_term_t(env, term, argspec_t(1, -1),
+                    optargspec_t({ "index", "intersect" })) { }
 private:
     datum_t get_key_arg(const scoped_ptr_t<val_t> &arg) const {
-        datum_t datum_arg = arg->as_datum();
+        return check_key(arg, arg->as_datum());
+    }
 
+    datum_t check_key(const scoped_ptr_t<val_t> &arg, datum_t datum_arg) const {
         rcheck_target(arg,
                       !datum_arg.is_ptype(pseudo::geometry_string),
                       base_exc_t::LOGIC,
@@ -937,12 +978,28 @@ private:
             keys.insert(std::make_pair(std::move(key), 0)).first->second += 1;
         }
 
+        // `intersect` maps other indexes to a key that the rows must also have in
+        // them, like `{status: 'open'}`.
+        std::map<std::string, datum_t> intersect;
+        if (scoped_ptr_t<val_t> v = args->optarg(env, "intersect")) {
+            datum_t obj = v->as_datum();
+            rcheck_target(v, obj.get_type() == datum_t::R_OBJECT, base_exc_t::LOGIC,
+                          strprintf("Expected `intersect` to be an OBJECT mapping "
+                                    "index names to keys, but found %s.",
+                                    obj.get_type_name().c_str()));
+            for (size_t i = 0; i < obj.obj_size(); ++i) {
+                std::pair<datum_string_t, datum_t> pair = obj.get_pair(i);
+                intersect[pair.first.to_std()] = check_key(v, pair.second);
+            }
+        }
+
         return new_val(
             make_counted<selection_t>(
                 table,
                 table->get_all(env->env,
                                datumspec_t(std::move(keys)),
                                index_str,
+                               intersect,
                                backtrace())));
     }
     virtual const char *name() const { return "get_all"; }
@@ -40,19 +40,20 @@ public:
             }
             str_buf[data.size()] = '\0';
 
-            rapidjson::Document json;
-            // Note: Insitu will cause some parts of `json` to directly point into
-            // `str_buf`. `str_buf`'s life time must be at least as long as `json`'s.
-            json.ParseInsitu(str_buf.data());
+            // Build the datum straight from the parser's events, without a
+            // `rapidjson::Document` in between.
+            rapidjson::ParseResult result;
+            datum_t res = parse_json_to_datum(str_buf.data(),
+                                              env->env->limits(),
+                                              &result);
 
-            rcheck(!json.HasParseError(), base_exc_t::LOGIC,
+            rcheck(!result.IsError(), base_exc_t::LOGIC,
                    strprintf("Failed to parse \"%s\" as JSON: %s",
                        (data.size() > 40
                         ? (data.to_std().substr(0, 37) + "...").c_str()
                         : data.to_std().c_str()),
-                       rapidjson::GetParseError_En(json.GetParseError())));
-            return new_val(to_datum(json, env->env->limits(),
-                                    env->env->reql_version()));
+                       rapidjson::GetParseError_En(result.Code())));
+            return new_val(res);
         }
     }
 
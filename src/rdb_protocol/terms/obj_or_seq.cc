@@ -145,18 +145,39 @@ public:
     pluck_term_t(compile_env_t *env, const raw_term_t &term)
         : obj_or_seq_op_term_t(env, term, MAP, argspec_t(1, -1)) { }
 private:
-    virtual scoped_ptr_t<val_t> obj_eval(
-        scope_env_t *env, args_t *args, const scoped_ptr_t<val_t> &v0) const {
-        datum_t obj = v0->as_datum();
-        r_sanity_check(obj.get_type() == datum_t::R_OBJECT);
-
+    datum_t get_paths(scope_env_t *env, args_t *args) const {
         const size_t n = args->num_args();
         std::vector<datum_t> paths;
         paths.reserve(n - 1);
         for (size_t i = 1; i < n; ++i) {
             paths.push_back(args->arg(env, i)->as_datum());
         }
-        pathspec_t pathspec(datum_t(std::move(paths), env->env->limits()), this);
+        return datum_t(std::move(paths), env->env->limits());
+    }
+    virtual scoped_ptr_t<val_t> eval_impl(
+        scope_env_t *env, args_t *args, eval_flags_t) const {
+        scoped_ptr_t<val_t> v0 = args->arg(env, 0);
+        if (!v0->get_type().is_convertible(val_t::type_t::SINGLE_SELECTION)) {
+            return impl.eval_impl_dereferenced(this, env, args, v0,
+                                               [&]{ return obj_eval(env, args, v0); });
+        }
+        // For `get(...).pluck(...)` the shard only sends back the plucked fields of
+        // the row, rather than the whole document.
+        datum_t paths = get_paths(env, args);
+        pathspec_t pathspec(paths, this);
+        scoped_ptr_t<val_t> row = make_scoped<val_t>(
+            v0->as_single_selection()->get_projected(paths), v0->backtrace());
+        return impl.eval_impl_dereferenced(this, env, args, row, [&]{
+            return new_val(project(row->as_datum(), pathspec, DONT_RECURSE,
+                                   env->env->limits()));
+        });
+    }
+    virtual scoped_ptr_t<val_t> obj_eval(
+        scope_env_t *env, args_t *args, const scoped_ptr_t<val_t> &v0) const {
+        datum_t obj = v0->as_datum();
+        r_sanity_check(obj.get_type() == datum_t::R_OBJECT);
+
+        pathspec_t pathspec(get_paths(env, args), this);
         return new_val(project(obj, pathspec, DONT_RECURSE, env->env->limits()));
     }
     virtual const char *name() const { return "pluck"; }
@@ -48,14 +48,15 @@ public:
                          poly_type_t _poly_type, argspec_t argspec,
                          std::set<std::string> &&ptypes);
 
+protected:
+    obj_or_seq_op_impl_t impl;
+
 private:
     virtual scoped_ptr_t<val_t> obj_eval(scope_env_t *env,
                                          args_t *args,
                                          const scoped_ptr_t<val_t> &v0) const = 0;
 
     virtual scoped_ptr_t<val_t> eval_impl(scope_env_t *env, args_t *args, eval_flags_t) const;
-
-    obj_or_seq_op_impl_t impl;
 };
 
 } // namespace ql
@@ -234,12 +234,23 @@ counted_t<term_t> make_skip_term(
         compile_env_t *env, const raw_term_t &term) {
     return make_counted<skip_term_t>(env, term);
 }
+// With `left_key` or `right_key`, joins are done with a hash table instead of
+// being rewritten into a nested loop.
+bool is_hash_join(const raw_term_t &term) {
+    return term.optarg("left_key").has_value() || term.optarg("right_key").has_value();
+}
 counted_t<term_t> make_inner_join_term(
         compile_env_t *env, const raw_term_t &term) {
+    if (is_hash_join(term)) {
+        return make_hash_join_term(env, term, false);
+    }
     return make_counted<inner_join_term_t>(env, term);
 }
 counted_t<term_t> make_outer_join_term(
         compile_env_t *env, const raw_term_t &term) {
+    if (is_hash_join(term)) {
+        return make_hash_join_term(env, term, true);
+    }
     return make_counted<outer_join_term_t>(env, term);
 }
 counted_t<term_t> make_update_term(
@@ -6,8 +6,11 @@
 #include <vector>
 
 #include "parsing/utf8.hpp"
+#include "rdb_protocol/client_chunks.hpp"
+#include "rdb_protocol/datum_stream/chunks.hpp"
 #include "rdb_protocol/datum_stream/eq_join.hpp"
 #include "rdb_protocol/datum_stream/fold.hpp"
+#include "rdb_protocol/datum_stream/hash_join.hpp"
 #include "rdb_protocol/datum_stream/map.hpp"
 #include "rdb_protocol/datum_stream/ordered_union.hpp"
 #include "rdb_protocol/datum_stream/range.hpp"
@@ -83,6 +86,44 @@ public:
 private:
     virtual const char *name() const { return "avg"; }
 };
+class approx_count_distinct_term_t
+    : public unindexable_map_acc_term_t<approx_count_distinct_wire_func_t> {
+public:
+    template<class... Args> approx_count_distinct_term_t(Args... args)
+        : unindexable_map_acc_term_t<approx_count_distinct_wire_func_t>(args...) { }
+private:
+    virtual const char *name() const { return "approx_count_distinct"; }
+};
+
+/* `approx_quantile` takes the quantile as its second argument, so unlike the terms
+above it can't tell a function from an index by the number of arguments. */
+class approx_quantile_term_t : public grouped_seq_op_term_t {
+public:
+    approx_quantile_term_t(compile_env_t *env, const raw_term_t &term)
+        : grouped_seq_op_term_t(env, term, argspec_t(2, 3)) { }
+private:
+    virtual scoped_ptr_t<val_t> eval_impl(scope_env_t *env, args_t *args,
+                                       eval_flags_t) const {
+        scoped_ptr_t<val_t> v = args->arg(env, 0);
+        double quantile = args->arg(env, 1)->as_num();
+        rcheck(quantile >= 0 && quantile <= 1, base_exc_t::LOGIC,
+               strprintf("Quantile must be between 0 and 1 (got %s).",
+                         datum_t(quantile).print().c_str()));
+        counted_t<const func_t> func;
+        if (args->num_args() == 3) {
+            func = args->arg(env, 2)->as_func(GET_FIELD_SHORTCUT);
+        }
+        counted_t<datum_stream_t> seq = v->as_seq(env->env);
+        if (func.has()) {
+            return seq->run_terminal(
+                env->env, approx_quantile_wire_func_t(quantile, backtrace(), func));
+        } else {
+            return seq->run_terminal(
+                env->env, approx_quantile_wire_func_t(quantile, backtrace()));
+        }
+    }
+    virtual const char *name() const { return "approx_quantile"; }
+};
 
 template<class T>
 class indexable_map_acc_term_t : public map_acc_term_t<T> {
@@ -262,6 +303,55 @@ private:
     }
 };
 
+class hash_join_term_t : public op_term_t {
+public:
+    hash_join_term_t(compile_env_t *env, const raw_term_t &term, bool _outer)
+        : op_term_t(env, term, argspec_t(3), optargspec_t({"left_key", "right_key"})),
+          outer(_outer) { }
+
+    virtual const char *name() const { return outer ? "outer_join" : "inner_join"; }
+private:
+    virtual scoped_ptr_t<val_t> eval_impl(scope_env_t *env,
+                                          args_t *args,
+                                          eval_flags_t) const {
+        counted_t<datum_stream_t> left = args->arg(env, 0)->as_seq(env->env);
+        counted_t<datum_stream_t> right = args->arg(env, 1)->as_seq(env->env);
+        counted_t<const func_t> predicate = args->arg(env, 2)->as_func();
+
+        scoped_ptr_t<val_t> left_key = args->optarg(env, "left_key");
+        scoped_ptr_t<val_t> right_key = args->optarg(env, "right_key");
+        rcheck(left_key.has() && right_key.has(), base_exc_t::LOGIC,
+               strprintf("`%s` needs both `left_key` and `right_key`.", name()));
+        rcheck(left->cfeed_type() == feed_type_t::not_feed
+               && right->cfeed_type() == feed_type_t::not_feed,
+               base_exc_t::LOGIC,
+               strprintf("Cannot `%s` a changefeed.", name()));
+        rcheck(!right->is_infinite(), base_exc_t::LOGIC,
+               strprintf("Cannot use an infinite stream as the right-hand side of "
+                         "`%s`.", name()));
+
+        // Without an `io_backender` (e.g. on a proxy) the right-hand side has to
+        // fit in memory.
+        rdb_context_t *rdb_ctx = env->env->get_rdb_ctx();
+        io_backender_t *io_backender =
+            rdb_ctx != nullptr ? rdb_ctx->io_backender : nullptr;
+        base_path_t base_path =
+            rdb_ctx != nullptr ? rdb_ctx->base_path : base_path_t();
+        return new_val(env->env, make_counted<hash_join_datum_stream_t>(
+            left,
+            right,
+            left_key->as_func(GET_FIELD_SHORTCUT),
+            right_key->as_func(GET_FIELD_SHORTCUT),
+            predicate,
+            outer,
+            io_backender,
+            base_path,
+            backtrace()));
+    }
+
+    const bool outer;
+};
+
 class fold_term_t : public grouped_seq_op_term_t {
 public:
     fold_term_t(compile_env_t *env, const raw_term_t &term)
@@ -529,6 +619,29 @@ struct rcheck_spec_visitor_t : public bt_rcheckable_t,
     env_t *env;
 };
 
+// Parses a `position` from a change back into the positions on each changefeed server.
+static std::map<uuid_u, uint64_t> parse_changefeed_position(
+        const scoped_ptr_t<val_t> &v) {
+    datum_t d = v->as_datum();
+    rcheck_target(v, d.get_type() == datum_t::R_OBJECT && d.obj_size() != 0,
+                  base_exc_t::LOGIC,
+                  strprintf("Expected a changefeed position but found %s.",
+                            d.print().c_str()));
+    std::map<uuid_u, uint64_t> res;
+    for (size_t i = 0; i < d.obj_size(); ++i) {
+        std::pair<datum_string_t, datum_t> pair = d.get_pair(i);
+        uuid_u server_uuid;
+        rcheck_target(v, str_to_uuid(pair.first.to_std(), &server_uuid)
+                         && pair.second.get_type() == datum_t::R_NUM
+                         && pair.second.as_int() >= 0,
+                      base_exc_t::LOGIC,
+                      strprintf("Expected a changefeed position but found %s.",
+                                d.print().c_str()));
+        res[server_uuid] = pair.second.as_int();
+    }
+    return res;
+}
+
 class changes_term_t : public op_term_t {
 public:
     changes_term_t(compile_env_t *env, const raw_term_t &term)
@@ -538,8 +651,10 @@ public:
                           "changefeed_queue_size",
                           "include_initial",
                           "include_offsets",
+                          "include_positions",
                           "include_states",
-                          "include_types"})) { }
+                          "include_types",
+                          "resume_from"})) { }
 private:
     virtual scoped_ptr_t<val_t> eval_impl(
         scope_env_t *env, args_t *args, eval_flags_t) const {
@@ -576,6 +691,23 @@ private:
             include_offsets = v->as_bool();
         }
 
+        bool include_positions = false;
+        if (scoped_ptr_t<val_t> v = args->optarg(env, "include_positions")) {
+            include_positions = v->as_bool();
+        }
+        // Squashing can hold back one change while sending a later one, so the
+        // position after the later one would skip it.
+        rcheck(!include_positions || squash == datum_t::boolean(false),
+               base_exc_t::LOGIC,
+               "Cannot include positions in a squashed changefeed.");
+
+        optional<std::map<uuid_u, uint64_t> > resume_from;
+        if (scoped_ptr_t<val_t> v = args->optarg(env, "resume_from")) {
+            resume_from.set(parse_changefeed_position(v));
+            rcheck_target(v, !include_initial, base_exc_t::LOGIC,
+                          "Cannot use `resume_from` with `include_initial`.");
+        }
+
         scoped_ptr_t<val_t> v = args->arg(env, 0);
         configured_limits_t limits = env->env->limits_with_changefeed_queue_size(
                 args->optarg(env, "changefeed_queue_size"));
@@ -601,6 +733,8 @@ private:
                             include_offsets,
                             include_states,
                             include_types,
+                            include_positions,
+                            resume_from,
                             limits,
                             squash,
                             std::move(changespec.keyspec.spec)),
@@ -635,6 +769,8 @@ private:
                         include_offsets,
                         include_states,
                         include_types,
+                        include_positions,
+                        resume_from,
                         limits,
                         squash,
                         sel->get_spec()),
@@ -861,6 +997,25 @@ private:
     virtual const char *name() const { return "range"; }
 };
 
+class chunks_term_t : public op_term_t {
+public:
+    chunks_term_t(compile_env_t *env, const raw_term_t &term)
+        : op_term_t(env, term, argspec_t(0)) { }
+private:
+    virtual scoped_ptr_t<val_t> eval_impl(scope_env_t *env, args_t *, eval_flags_t) const {
+        client_chunks_t *chunks = env->env->client_chunks();
+        rcheck(chunks != nullptr, base_exc_t::LOGIC,
+               "`chunks` can only be used in a query sent by a client.");
+        return new_val(env->env, make_counted<chunks_datum_stream_t>(
+            chunks, backtrace()));
+    }
+    // The client decides what the chunks are.
+    virtual deterministic_t is_deterministic() const {
+        return deterministic_t::no();
+    }
+    virtual const char *name() const { return "chunks"; }
+};
+
 counted_t<term_t> make_minval_term(
         compile_env_t *env, const raw_term_t &term) {
     return make_counted<minval_term_t>(env, term);
@@ -900,6 +1055,10 @@ counted_t<term_t> make_eq_join_term(
         compile_env_t *env, const raw_term_t &term) {
     return make_counted<eq_join_term_t>(env, term);
 }
+counted_t<term_t> make_hash_join_term(
+        compile_env_t *env, const raw_term_t &term, bool outer) {
+    return make_counted<hash_join_term_t>(env, term, outer);
+}
 
 counted_t<term_t> make_fold_term(
         compile_env_t *env, const raw_term_t &term) {
@@ -935,6 +1094,16 @@ counted_t<term_t> make_sum_term(
     return make_counted<sum_term_t>(env, term);
 }
 
+counted_t<term_t> make_approx_count_distinct_term(
+        compile_env_t *env, const raw_term_t &term) {
+    return make_counted<approx_count_distinct_term_t>(env, term);
+}
+
+counted_t<term_t> make_approx_quantile_term(
+        compile_env_t *env, const raw_term_t &term) {
+    return make_counted<approx_quantile_term_t>(env, term);
+}
+
 counted_t<term_t> make_min_term(
         compile_env_t *env, const raw_term_t &term) {
     return make_counted<min_term_t>(env, term);
@@ -960,4 +1129,9 @@ counted_t<term_t> make_range_term(
     return make_counted<range_term_t>(env, term);
 }
 
+counted_t<term_t> make_chunks_term(
+        compile_env_t *env, const raw_term_t &term) {
+    return make_counted<chunks_term_t>(env, term);
+}
+
 } // namespace ql
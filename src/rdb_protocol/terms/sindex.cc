@@ -154,7 +154,8 @@ ql::datum_t sindex_status_to_datum(
 class sindex_create_term_t : public op_term_t {
 public:
     sindex_create_term_t(compile_env_t *env, const raw_term_t &term)
-        : op_term_t(env, term, argspec_t(2, 3), optargspec_t({"multi", "geo"})) { }
+        : op_term_t(env, term, argspec_t(2, 3),
+                    optargspec_t({"multi", "geo", "filter"})) { }
 
     virtual scoped_ptr_t<val_t> eval_impl(
         scope_env_t *env, args_t *args, eval_flags_t) const {
@@ -203,6 +204,14 @@ public:
             config.func_version = reql_version_t::LATEST;
         }
 
+        /* A partial index only holds the rows that its `filter` accepts. The filter
+        goes into the index function itself, so that the index is stored (and
+        reported by `index_status`) just like any other. */
+        if (scoped_ptr_t<val_t> filter_val = args->optarg(env, "filter")) {
+            config.func = ql::map_wire_func_t(new_partial_index_func(
+                config.func.compile_wire_func(), filter_val->as_func(), backtrace()));
+        }
+
         config.func.compile_wire_func()->assert_deterministic(
                 constant_now_t::no,
                 "Index functions must be deterministic.");
@@ -6,12 +6,14 @@
 
 #include "rdb_protocol/datum_stream.hpp"
 #include "rdb_protocol/datum_stream/array.hpp"
+#include "rdb_protocol/datum_stream/external_sort.hpp"
 #include "rdb_protocol/datum_stream/indexed_sort.hpp"
 #include "rdb_protocol/error.hpp"
 #include "rdb_protocol/func.hpp"
 #include "rdb_protocol/minidriver.hpp"
 #include "rdb_protocol/op.hpp"
 #include "rdb_protocol/order_util.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
 #include "rdb_protocol/term_walker.hpp"
 
 namespace ql {
@@ -105,7 +107,15 @@ private:
             }
             rcheck(!comparisons.empty(), base_exc_t::LOGIC,
                    "Must specify something to order by.");
+            /* If we have somewhere to put temporary files, a sequence that outgrows
+            the array size limit or `EXTERNAL_SORT_MEMORY_BUDGET` is sorted in runs
+            that are spilled to disk instead of failing the query. */
+            rdb_context_t *rdb_ctx = env->env->get_rdb_ctx();
+            const bool can_spill =
+                rdb_ctx != nullptr && rdb_ctx->io_backender != nullptr;
+            counted_t<external_sort_datum_stream_t> external_sort;
             std::vector<datum_t> to_sort;
+            size_t to_sort_size = 0;
             batchspec_t batchspec = batchspec_t::user(batch_type_t::TERMINAL, env->env);
             for (;;) {
                 std::vector<datum_t> data
@@ -113,15 +123,40 @@ private:
                 if (data.size() == 0) {
                     break;
                 }
+                if (can_spill) {
+                    for (const datum_t &d : data) {
+                        to_sort_size +=
+                            serialized_size<cluster_version_t::LATEST_OVERALL>(d);
+                    }
+                }
                 std::move(data.begin(), data.end(), std::back_inserter(to_sort));
-                rcheck_array_size(to_sort, env->env->limits());
+                if (can_spill
+                    && (to_sort.size() > env->env->limits().array_size_limit()
+                        || to_sort_size > EXTERNAL_SORT_MEMORY_BUDGET)) {
+                    if (!external_sort.has()) {
+                        external_sort = make_counted<external_sort_datum_stream_t>(
+                            backtrace(),
+                            rdb_ctx->io_backender,
+                            rdb_ctx->base_path,
+                            lt_cmp);
+                    }
+                    external_sort->spill_run(env->env, std::move(to_sort));
+                    to_sort.clear();
+                    to_sort_size = 0;
+                } else {
+                    rcheck_array_size(to_sort, env->env->limits());
+                }
+            }
+            if (external_sort.has()) {
+                external_sort->finish(env->env, std::move(to_sort));
+                seq = external_sort;
+            } else {
+                profile::sampler_t sampler("Sorting in-memory.", env->env->trace);
+                lt_cmp.sort(env->env, &sampler, &to_sort);
+                seq = make_counted<array_datum_stream_t>(
+                    datum_t(std::move(to_sort), env->env->limits()),
+                    backtrace());
             }
-            profile::sampler_t sampler("Sorting in-memory.", env->env->trace);
-            auto fn = std::bind(lt_cmp, env->env, &sampler, ph::_1, ph::_2);
-            std::stable_sort(to_sort.begin(), to_sort.end(), fn);
-            seq = make_counted<array_datum_stream_t>(
-                datum_t(std::move(to_sort), env->env->limits()),
-                backtrace());
         }
         return tbl_slice.has()
             ? new_val(make_counted<selection_t>(tbl_slice->get_tbl(), seq))
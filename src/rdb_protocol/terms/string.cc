@@ -5,9 +5,11 @@
 
 #include <algorithm>
 
+#include "containers/lru_cache.hpp"
 #include "parsing/utf8.hpp"
 #include "rdb_protocol/error.hpp"
 #include "rdb_protocol/op.hpp"
+#include "thread_local.hpp"
 
 namespace ql {
 
@@ -55,6 +57,45 @@ static bool is_whitespace_character(char32_t c) {
     return is_in_a_range(whitespace_ranges, whitespace_ranges + n, c);
 }
 
+// Whitespace in the ASCII range, which is all of `whitespace_ranges` below 128.
+static bool is_ascii_whitespace_character(char c) {
+    return (c >= 9 && c <= 13) || c == 32;
+}
+
+// This is a totally arbitrary constant limiting the size of the regex cache.  1000
+// was chosen out of a hat; if you have a good argument for it being something else
+// (apart from cache line concerns, which are irrelevant due to the implementation)
+// you're probably right.
+const size_t REGEX_CACHE_SIZE = 1000;
+
+// Compiled regexes are kept per thread rather than per query, so that a filter that
+// runs `match` with the same pattern in many queries only compiles it once. A
+// `re2::RE2` can be used from several coroutines at once, and the `shared_ptr` keeps
+// it alive if it's evicted while one of them is still matching with it.
+typedef lru_cache_t<std::string, std::shared_ptr<re2::RE2> > regex_cache_t;
+
+TLS_with_init(regex_cache_t *, regex_cache, nullptr)
+
+// Returns the compiled regex for `re`, which may not be `ok()`. Only regexes that
+// compiled successfully are cached.
+static std::shared_ptr<re2::RE2> get_regex(const std::string &re) {
+    // Constructed lazily, so it's constructed on the thread that uses it.
+    if (TLS_get_regex_cache() == nullptr) {
+        TLS_set_regex_cache(new regex_cache_t(REGEX_CACHE_SIZE));
+    }
+    regex_cache_t *cache = TLS_get_regex_cache();
+    auto search = cache->find(re);
+    if (search != cache->end()) {
+        return search->second;
+    }
+    std::shared_ptr<re2::RE2> regexp =
+        std::make_shared<re2::RE2>(re, re2::RE2::Quiet);
+    if (regexp->ok()) {
+        (*cache)[re] = regexp;
+    }
+    return regexp;
+}
+
 class match_term_t : public op_term_t {
 public:
     match_term_t(compile_env_t *env, const raw_term_t &term)
@@ -63,23 +104,15 @@ private:
     virtual scoped_ptr_t<val_t> eval_impl(scope_env_t *env, args_t *args, eval_flags_t) const {
         std::string str = args->arg(env, 0)->as_str().to_std();
         std::string re = args->arg(env, 1)->as_str().to_std();
-        std::shared_ptr<re2::RE2> regexp;
-        regex_cache_t &cache = env->env->regex_cache();
-        auto search = cache.regexes.find(re);
-        if (search == cache.regexes.end()) {
-            regexp.reset(new re2::RE2(re, re2::RE2::Quiet));
-            if (!regexp->ok()) {
-                rfail(base_exc_t::LOGIC,
-                      "Error in regexp `%s` (portion `%s`): %s",
-                      regexp->pattern().c_str(),
-                      regexp->error_arg().c_str(),
-                      regexp->error().c_str());
-            }
-            cache.regexes[re] = regexp;
-        } else {
-            regexp = search->second;
-        }
+        std::shared_ptr<re2::RE2> regexp = get_regex(re);
         r_sanity_check(static_cast<bool>(regexp));
+        if (!regexp->ok()) {
+            rfail(base_exc_t::LOGIC,
+                  "Error in regexp `%s` (portion `%s`): %s",
+                  regexp->pattern().c_str(),
+                  regexp->error_arg().c_str(),
+                  regexp->error().c_str());
+        }
         // We add 1 to account for $0.
         int ngroups = regexp->NumberOfCapturingGroups() + 1;
         scoped_array_t<re2::StringPiece> groups(ngroups);
@@ -166,10 +199,28 @@ private:
     std::vector<datum_t> utf8_aware_split(const std::string &s,
                                           const optional<std::string> &delim,
                                           size_t maxnum) const {
+        typedef std::string::const_iterator iter_t;
         const bool is_delim_empty = (delim && delim->size() == 0);
+        // If there are no multibyte characters, every byte is a character and none of
+        // them are combining characters, so we don't have to decode anything.
+        const bool ascii = utf8::is_ascii(s);
+        auto space = [ascii](iter_t start, iter_t end) {
+            return ascii
+                ? std::find_if(start, end, &is_ascii_whitespace_character)
+                : find_space(start, end);
+        };
+        auto non_space = [ascii](iter_t start, iter_t end) {
+            return ascii
+                ? std::find_if_not(start, end, &is_ascii_whitespace_character)
+                : find_non_space(start, end);
+        };
+        auto next_character = [ascii](iter_t start, iter_t end) {
+            return ascii ? start + 1 : utf8::next_codepoint(start, end);
+        };
+
         std::vector<datum_t> res;
-        std::string::const_iterator current = s.cbegin();
-        std::string::const_iterator end = s.cend();
+        iter_t current = s.cbegin();
+        iter_t end = s.cend();
         bool done = false;
         while (!done) {
             if (res.size() == maxnum) {
@@ -178,7 +229,7 @@ private:
                         push_datum(&res, current, end);
                     }
                 } else {
-                    auto start = find_non_space(current, end);
+                    auto start = non_space(current, end);
                     if (start != end) {
                         push_datum(&res, start, end);
                     }
@@ -186,8 +237,8 @@ private:
                 current = end;
                 done = true;
             } else if (is_delim_empty) {
-                auto next = utf8::next_codepoint(current, end);
-                auto with_combining = find_non_combining(next, end);
+                auto next = next_character(current, end);
+                auto with_combining = ascii ? next : find_non_combining(next, end);
 
                 if (current != with_combining) {
                     push_datum(&res, current, with_combining);
@@ -195,7 +246,10 @@ private:
                 current = with_combining;
                 done = (current == end);
             } else if (delim) {
-                auto next = std::search(current, end, delim->begin(), delim->end());
+                // UTF-8 never matches in the middle of a character, so a plain byte
+                // search is correct; `find` uses `memchr` to skip ahead.
+                size_t found = s.find(*delim, current - s.cbegin());
+                auto next = (found == std::string::npos) ? end : s.cbegin() + found;
                 push_datum(&res, current, next);
                 if (next == end) {
                     current = end;
@@ -204,9 +258,9 @@ private:
                     current = next + delim->size();
                 }
             } else {
-                auto next = find_space(current, end);
+                auto next = space(current, end);
                 if (next == end) {
-                    auto start = find_non_space(current, end);
+                    auto start = non_space(current, end);
                     if (start != end) {
                         push_datum(&res, start, end);
                     }
@@ -216,7 +270,7 @@ private:
                     if (current != next) {
                         push_datum(&res, current, next);
                     }
-                    current = utf8::next_codepoint(next, end);
+                    current = next_character(next, end);
                 }
             }
         }
@@ -283,7 +337,8 @@ private:
             break;
         case reql_version_t::v2_1:
         case reql_version_t::v2_2:
-        case reql_version_t::v2_3_is_latest:
+        case reql_version_t::v2_3:
+        case reql_version_t::v2_6_is_latest:
             res = utf8_aware_split(s, delim, maxnum);
             break;
         default:
@@ -227,6 +227,8 @@ counted_t<term_t> make_outer_join_term(
     compile_env_t *env, const raw_term_t &term);
 counted_t<term_t> make_eq_join_term(
     compile_env_t *env, const raw_term_t &term);
+counted_t<term_t> make_hash_join_term(
+    compile_env_t *env, const raw_term_t &term, bool outer);
 counted_t<term_t> make_update_term(
     compile_env_t *env, const raw_term_t &term);
 counted_t<term_t> make_delete_term(
@@ -265,6 +267,10 @@ counted_t<term_t> make_sum_term(
     compile_env_t *env, const raw_term_t &term);
 counted_t<term_t> make_avg_term(
     compile_env_t *env, const raw_term_t &term);
+counted_t<term_t> make_approx_count_distinct_term(
+    compile_env_t *env, const raw_term_t &term);
+counted_t<term_t> make_approx_quantile_term(
+    compile_env_t *env, const raw_term_t &term);
 counted_t<term_t> make_min_term(
     compile_env_t *env, const raw_term_t &term);
 counted_t<term_t> make_max_term(
@@ -275,6 +281,8 @@ counted_t<term_t> make_zip_term(
     compile_env_t *env, const raw_term_t &term);
 counted_t<term_t> make_range_term(
     compile_env_t *env, const raw_term_t &term);
+counted_t<term_t> make_chunks_term(
+    compile_env_t *env, const raw_term_t &term);
 
 // write_hook.cc
 counted_t<term_t> make_set_write_hook_term(
@@ -411,6 +411,24 @@ private:
                 }
                 b |= info.add("doc_count_estimates", std::move(arr).to_datum());
             }
+            {
+                datum_t shard_map;
+                try {
+                    admin_err_t error;
+                    if (!env->env->reql_cluster_interface()->table_shard_map(
+                            env->env->get_user_context(),
+                            table->db,
+                            table_name,
+                            env->env,
+                            &shard_map,
+                            &error)) {
+                        REQL_RETHROW(error);
+                    }
+                } catch (auth::permission_error_t const &permission_error) {
+                    rfail(ql::base_exc_t::PERMISSION_ERROR, "%s", permission_error.what());
+                }
+                b |= info.add("shard_map", shard_map);
+            }
             {
                 admin_err_t error;
                 std::map<std::string, std::pair<sindex_config_t, sindex_status_t> >
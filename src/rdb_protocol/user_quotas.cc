@@ -0,0 +1,124 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/user_quotas.hpp"
+
+#include <algorithm>
+
+#include "arch/runtime/thread_pool.hpp"
+#include "arch/timing.hpp"
+#include "concurrency/cross_thread_signal.hpp"
+#include "concurrency/wait_any.hpp"
+#include "config/args.hpp"
+
+rate_budget_t::rate_budget_t(uint64_t _per_sec, microtime_t now)
+    : per_sec(_per_sec), tokens(_per_sec), last_refill(now) {
+    guarantee(per_sec > 0);
+}
+
+void rate_budget_t::charge(uint64_t amount, microtime_t now) {
+    refill(now);
+    tokens -= amount;
+}
+
+microtime_t rate_budget_t::micros_until_available(microtime_t now) {
+    refill(now);
+    if (tokens >= 0) {
+        return 0;
+    }
+    return static_cast<microtime_t>(-tokens * MILLION / per_sec) + 1;
+}
+
+void rate_budget_t::refill(microtime_t now) {
+    if (now > last_refill) {
+        double refilled = static_cast<double>(now - last_refill) * per_sec / MILLION;
+        tokens = std::min<double>(per_sec, tokens + refilled);
+        last_refill = now;
+    }
+}
+
+class user_quotas_t::user_state_t {
+public:
+    user_state_t(const user_quota_config_t &config, microtime_t now)
+        : slots(std::max<uint64_t>(config.max_concurrent_queries, 1)) {
+        if (config.max_rows_read_per_sec != 0) {
+            rows_read.init(new rate_budget_t(config.max_rows_read_per_sec, now));
+        }
+        if (config.max_bytes_returned_per_sec != 0) {
+            bytes_returned.init(
+                new rate_budget_t(config.max_bytes_returned_per_sec, now));
+        }
+    }
+
+    new_semaphore_t slots;
+    scoped_ptr_t<rate_budget_t> rows_read;
+    scoped_ptr_t<rate_budget_t> bytes_returned;
+};
+
+user_quotas_t::user_quotas_t(const user_quota_config_t &_config)
+    : config(_config) { }
+
+user_quotas_t::~user_quotas_t() { }
+
+user_quotas_t::user_state_t *user_quotas_t::get_user_state(
+        const auth::user_context_t &user_context) {
+    assert_thread();
+    auto it = users.find(user_context);
+    if (it == users.end()) {
+        it = users.insert(std::make_pair(
+            user_context,
+            make_scoped<user_state_t>(config, current_microtime()))).first;
+    }
+    return it->second.get();
+}
+
+user_quotas_t::admission_t::admission_t(user_quotas_t *_parent,
+                                        const auth::user_context_t &user_context,
+                                        signal_t *interruptor)
+    : parent(_parent), user(nullptr), rows_read(0), bytes_returned(0) {
+    if (user_context.is_admin_user()) {
+        return;
+    }
+    cross_thread_signal_t ct_interruptor(interruptor, parent->home_thread());
+    on_thread_t thread_switcher(parent->home_thread());
+    user = parent->get_user_state(user_context);
+    try {
+        if (parent->config.max_concurrent_queries != 0) {
+            slot.init(new new_semaphore_in_line_t(&user->slots, 1));
+            wait_interruptible(slot->acquisition_signal(), &ct_interruptor);
+        }
+        for (rate_budget_t *budget : {user->rows_read.get_or_null(),
+                                      user->bytes_returned.get_or_null()}) {
+            if (budget == nullptr) {
+                continue;
+            }
+            microtime_t wait;
+            while ((wait = budget->micros_until_available(current_microtime())) > 0) {
+                nap(wait / THOUSAND + 1, &ct_interruptor);
+            }
+        }
+    } catch (const interrupted_exc_t &) {
+        // The slot has to go away on this thread.
+        slot.reset();
+        user = nullptr;
+        throw;
+    }
+}
+
+user_quotas_t::admission_t::~admission_t() {
+    if (user == nullptr) {
+        return;
+    }
+    on_thread_t thread_switcher(parent->home_thread());
+    microtime_t now = current_microtime();
+    if (user->rows_read.has()) {
+        user->rows_read->charge(rows_read, now);
+    }
+    if (user->bytes_returned.has()) {
+        user->bytes_returned->charge(bytes_returned, now);
+    }
+    slot.reset();
+}
+
+void user_quotas_t::admission_t::charge(uint64_t _rows_read, uint64_t _bytes_returned) {
+    rows_read += _rows_read;
+    bytes_returned += _bytes_returned;
+}
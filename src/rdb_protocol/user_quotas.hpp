@@ -0,0 +1,109 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_USER_QUOTAS_HPP_
+#define RDB_PROTOCOL_USER_QUOTAS_HPP_
+
+#include <stdint.h>
+
+#include <map>
+
+#include "clustering/administration/auth/user_context.hpp"
+#include "concurrency/new_semaphore.hpp"
+#include "containers/scoped.hpp"
+#include "threading.hpp"
+#include "time.hpp"
+
+class signal_t;
+
+/* From `--user-max-concurrent-queries`, `--user-max-rows-read-per-sec` and
+`--user-max-bytes-returned-per-sec`. Zero means no limit. */
+struct user_quota_config_t {
+    user_quota_config_t()
+        : max_concurrent_queries(0),
+          max_rows_read_per_sec(0),
+          max_bytes_returned_per_sec(0) { }
+
+    bool is_unlimited() const {
+        return max_concurrent_queries == 0
+            && max_rows_read_per_sec == 0
+            && max_bytes_returned_per_sec == 0;
+    }
+
+    uint64_t max_concurrent_queries;
+    uint64_t max_rows_read_per_sec;
+    uint64_t max_bytes_returned_per_sec;
+};
+
+/* A token bucket that refills at `per_sec` and holds at most a second's worth of
+tokens. Work is charged after it's done, since we can't tell how many rows a batch reads
+before it has read them, so the bucket can go into debt; whoever spends from it then
+waits until it's paid back. */
+class rate_budget_t {
+public:
+    rate_budget_t(uint64_t _per_sec, microtime_t now);
+
+    void charge(uint64_t amount, microtime_t now);
+
+    /* How long until the bucket is out of debt, or 0 if it isn't in debt. */
+    microtime_t micros_until_available(microtime_t now);
+
+private:
+    void refill(microtime_t now);
+
+    const uint64_t per_sec;
+    double tokens;
+    microtime_t last_refill;
+};
+
+/* `user_quotas_t` keeps the queries of each user on this server within the limits of a
+`user_quota_config_t`. Every `START`, `CONTINUE` and `EXECUTE` holds an `admission_t`
+while it computes its batch. The admission waits in line for one of the user's slots
+and then until the user's budgets for rows read and bytes returned are out of debt, so
+a user that's over a limit is slowed down rather than turned away. The admin user isn't
+limited.
+
+Every user's state lives on the thread that created the `user_quotas_t`, and
+admissions from other threads switch to it, which is why the server only creates one
+when a limit is set. */
+class user_quotas_t : public home_thread_mixin_t {
+private:
+    class user_state_t;
+
+public:
+    explicit user_quotas_t(const user_quota_config_t &_config);
+    ~user_quotas_t();
+
+    const user_quota_config_t &get_config() const { return config; }
+
+    class admission_t {
+    public:
+        admission_t(user_quotas_t *parent,
+                    const auth::user_context_t &user_context,
+                    signal_t *interruptor);
+        ~admission_t();
+
+        /* What the batch cost, which is charged to the user's budgets when the
+        admission ends. */
+        void charge(uint64_t rows_read, uint64_t bytes_returned);
+
+    private:
+        user_quotas_t *const parent;
+        // `nullptr` if the user isn't limited
+        user_state_t *user;
+        // Allocated on `parent`'s thread, where the user's semaphore is
+        scoped_ptr_t<new_semaphore_in_line_t> slot;
+        uint64_t rows_read;
+        uint64_t bytes_returned;
+
+        DISABLE_COPYING(admission_t);
+    };
+
+private:
+    user_state_t *get_user_state(const auth::user_context_t &user_context);
+
+    const user_quota_config_t config;
+    std::map<auth::user_context_t, scoped_ptr_t<user_state_t> > users;
+
+    DISABLE_COPYING(user_quotas_t);
+};
+
+#endif  // RDB_PROTOCOL_USER_QUOTAS_HPP_
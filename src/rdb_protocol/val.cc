@@ -31,6 +31,12 @@ public:
         }
         return row;
     }
+    virtual datum_t get_projected(const datum_t &paths) {
+        if (row.has()) {
+            return row;
+        }
+        return tbl->get_row_projected(env, key, paths);
+    }
     virtual datum_t replace(
         counted_t<const func_t> f,
         bool nondet_ok,
@@ -180,7 +186,7 @@ counted_t<datum_stream_t> table_t::as_seq(
     backtrace_id_t _bt,
     const datum_range_t &bounds,
     sorting_t sorting) {
-    return tbl->read_all(
+    counted_t<datum_stream_t> seq = tbl->read_all(
         env,
         idx,
         _bt,
@@ -188,6 +194,10 @@ counted_t<datum_stream_t> table_t::as_seq(
         datumspec_t(bounds),
         sorting,
         read_mode);
+    if (snapshot_reads) {
+        seq->use_snapshot_reads();
+    }
+    return seq;
 }
 
 table_t::table_t(counted_t<base_table_t> &&_tbl,
@@ -197,6 +207,7 @@ table_t::table_t(counted_t<base_table_t> &&_tbl,
       db(_db),
       name(_name),
       tbl(std::move(_tbl)),
+      snapshot_reads(false),
       read_mode(_read_mode)
 { }
 
@@ -485,6 +496,14 @@ datum_t table_t::get_row(env_t *env, datum_t pval) {
     return tbl->read_row(env, pval, read_mode);
 }
 
+datum_t table_t::get_row_projected(env_t *env, datum_t pval, datum_t paths) {
+    return tbl->read_row_projected(env, pval, paths, read_mode);
+}
+
+bool table_t::get_sample(env_t *env, uint64_t num, std::vector<datum_t> *rows_out) {
+    return tbl->read_sample(env, num, read_mode, rows_out);
+}
+
 scoped_ptr_t<reader_t> table_t::get_all_with_sindexes(
         env_t *env,
         const datumspec_t &datumspec,
@@ -504,15 +523,29 @@ counted_t<datum_stream_t> table_t::get_all(
         env_t *env,
         const datumspec_t &datumspec,
         const std::string &get_all_sindex_id,
+        const std::map<std::string, datum_t> &intersect,
         backtrace_id_t _bt) {
-    return tbl->read_all(
-        env,
-        get_all_sindex_id,
-        _bt,
-        display_name(),
-        datumspec,
-        sorting_t::UNORDERED,
-        read_mode);
+    counted_t<datum_stream_t> seq = intersect.empty()
+        ? tbl->read_all(
+            env,
+            get_all_sindex_id,
+            _bt,
+            display_name(),
+            datumspec,
+            sorting_t::UNORDERED,
+            read_mode)
+        : tbl->read_all_intersected(
+            env,
+            get_all_sindex_id,
+            _bt,
+            display_name(),
+            datumspec,
+            intersect,
+            read_mode);
+    if (snapshot_reads) {
+        seq->use_snapshot_reads();
+    }
+    return seq;
 }
 
 counted_t<datum_stream_t> table_t::get_intersecting(
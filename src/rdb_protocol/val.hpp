@@ -36,10 +36,18 @@ public:
     namespace_id_t get_id() const;
     const std::string &get_pkey() const;
     datum_t get_row(env_t *env, datum_t pval);
+    // The row cut down to the fields that `pluck(paths)` would keep, if the table
+    // can do that where the row is stored.
+    datum_t get_row_projected(env_t *env, datum_t pval, datum_t paths);
+    // Returns false if the rows have to be sampled from a scan of the table instead.
+    bool get_sample(env_t *env, uint64_t num, std::vector<datum_t> *rows_out);
+    // Only the rows that also have the key `intersect[index]` in each of the other
+    // indexes, see `base_table_t::read_all_intersected()`.
     counted_t<datum_stream_t> get_all(
             env_t *env,
             const datumspec_t &datumspec,
             const std::string &sindex_id,
+            const std::map<std::string, datum_t> &intersect,
             backtrace_id_t bt);
     counted_t<datum_stream_t> get_intersecting(
             env_t *env,
@@ -103,6 +111,9 @@ public:
 
     counted_t<base_table_t> tbl;
 
+    /* Set by `read_mode="snapshot"`, see `datum_stream_t::use_snapshot_reads()`. */
+    bool snapshot_reads;
+
 private:
     datum_t batched_insert_with_keys(
         env_t *env,
@@ -161,6 +172,8 @@ public:
     virtual ~single_selection_t() { }
 
     virtual datum_t get() = 0;
+    // At least the fields of the row that `pluck(paths)` would keep.
+    virtual datum_t get_projected(const datum_t &) { return get(); }
     virtual datum_t replace(
         counted_t<const func_t> f, bool nondet_ok,
         durability_requirement_t dur_req, return_changes_t return_changes,
@@ -87,6 +87,28 @@ var_scope_t var_scope_t::filtered_by_captures(const var_captures_t &captures) co
     return ret;
 }
 
+optional<var_scope_t> var_scope_t::merged_with(const var_scope_t &other) const {
+    if (implicit_depth != other.implicit_depth) {
+        return r_nullopt;
+    }
+    var_scope_t ret = *this;
+    for (const auto &pair : other.vars) {
+        auto res = ret.vars.insert(pair);
+        // Variable names are unique within a query, so the same name stands for the
+        // same value.
+        if (!res.second && res.first->second != pair.second) {
+            return r_nullopt;
+        }
+    }
+    if (!ret.maybe_implicit.has()) {
+        ret.maybe_implicit = other.maybe_implicit;
+    } else if (other.maybe_implicit.has()
+               && other.maybe_implicit != ret.maybe_implicit) {
+        return r_nullopt;
+    }
+    return make_optional(std::move(ret));
+}
+
 datum_t var_scope_t::lookup_var(sym_t varname) const {
     auto it = vars.find(varname);
     // This is a sanity check because we should never have constructed an expression
@@ -197,5 +219,7 @@ deserialize<cluster_version_t::v2_3>(read_stream_t *s, var_scope_t *);
 template archive_result_t
 deserialize<cluster_version_t::v2_4>(read_stream_t *s, var_scope_t *);
 template archive_result_t
-deserialize<cluster_version_t::v2_5_is_latest>(read_stream_t *s, var_scope_t *);
+deserialize<cluster_version_t::v2_5>(read_stream_t *s, var_scope_t *);
+template archive_result_t
+deserialize<cluster_version_t::v2_6_is_latest>(read_stream_t *s, var_scope_t *);
 }  // namespace ql
@@ -24,6 +24,8 @@ public:
 
     bool contains_var(sym_t varname) const;
     bool implicit_is_accessible() const;
+    // True outside of any function, where no variables are visible.
+    bool is_empty() const { return visibles.empty() && implicit_depth == 0; }
 
     uint32_t get_implicit_depth() const { return implicit_depth; }
 
@@ -60,6 +62,10 @@ public:
 
     var_scope_t filtered_by_captures(const var_captures_t &captures) const;
 
+    // Returns a scope with the variables of both scopes, or `r_nullopt` if they
+    // don't agree on the implicit variable.
+    optional<var_scope_t> merged_with(const var_scope_t &other) const;
+
     datum_t lookup_var(sym_t varname) const;
     datum_t lookup_implicit() const;
 
@@ -8,6 +8,7 @@
 #include "rdb_protocol/func.hpp"
 #include "rdb_protocol/protocol.hpp"
 #include "rdb_protocol/ql2proto.hpp"
+#include "rdb_protocol/term_folding.hpp"
 #include "rdb_protocol/term_walker.hpp"
 #include "stl_utils.hpp"
 
@@ -22,8 +23,10 @@ wire_func_t::wire_func_t(const counted_t<const func_t> &f) : func(f) {
 wire_func_t::wire_func_t(const raw_term_t &body,
                          std::vector<sym_t> arg_names) {
     compile_env_t env(var_visibility_t().with_func_arg_name_list(arg_names));
+    count_selections(&env, body);
     func = make_counted<reql_func_t>(var_scope_t(),
-                                     arg_names, compile_term(&env, body));
+                                     arg_names, compile_term(&env, body),
+                                     compiled_func_t::compile(arg_names, body));
 }
 
 wire_func_t::wire_func_t(const wire_func_t &copyee)
@@ -125,6 +128,7 @@ archive_result_t deserialize(read_stream_t *s, wire_func_t *wf) {
         if (bad(res)) { return res; }
 
         compile_env_t env(scope.compute_visibility().with_func_arg_name_list(arg_names));
+        count_selections(&env, term_storage->root_term());
         counted_t<const term_t> term_tree =
             compile_term(&env, term_storage->root_term());
         wf->func = make_counted<reql_func_t>(std::move(term_storage),
@@ -190,6 +194,7 @@ archive_result_t deserialize_wire_func(
         if (bad(res)) { return res; }
 
         compile_env_t env(scope.compute_visibility().with_func_arg_name_list(arg_names));
+        count_selections(&env, term_storage->root_term());
         counted_t<const term_t> term_tree =
             compile_term(&env, term_storage->root_term());
         wf->func = make_counted<reql_func_t>(std::move(term_storage),
@@ -243,9 +248,15 @@ archive_result_t deserialize<cluster_version_t::v2_4>(
 }
 
 template <>
-archive_result_t deserialize<cluster_version_t::v2_5_is_latest>(
+archive_result_t deserialize<cluster_version_t::v2_5>(
         read_stream_t *s, wire_func_t *wf) {
-    return deserialize_wire_func<cluster_version_t::v2_5_is_latest>(s, wf);
+    return deserialize_wire_func<cluster_version_t::v2_5>(s, wf);
+}
+
+template <>
+archive_result_t deserialize<cluster_version_t::v2_6_is_latest>(
+        read_stream_t *s, wire_func_t *wf) {
+    return deserialize_wire_func<cluster_version_t::v2_6_is_latest>(s, wf);
 }
 
 template <cluster_version_t W>
@@ -324,4 +335,21 @@ RDB_IMPL_SERIALIZABLE_2_SINCE_v1_13(filter_wire_func_t, filter_func, default_fil
 
 RDB_MAKE_SERIALIZABLE_1_FOR_CLUSTER(distinct_wire_func_t, use_index);
 
+template <>
+void serialize<cluster_version_t::CLUSTER>(
+        write_message_t *wm, const approx_quantile_wire_func_t &f) {
+    serialize<cluster_version_t::CLUSTER>(
+        wm, static_cast<const maybe_wire_func_t &>(f));
+    serialize<cluster_version_t::CLUSTER>(wm, f.quantile);
+}
+
+template <>
+archive_result_t deserialize<cluster_version_t::CLUSTER>(
+        read_stream_t *s, approx_quantile_wire_func_t *f) {
+    archive_result_t res = deserialize<cluster_version_t::CLUSTER>(
+        s, static_cast<maybe_wire_func_t *>(f));
+    if (bad(res)) { return res; }
+    return deserialize<cluster_version_t::CLUSTER>(s, &f->quantile);
+}
+
 }  // namespace ql
@@ -176,6 +176,21 @@ public:
     template <class... Args>
     explicit max_wire_func_t(Args... args) : skip_wire_func_t(args...) { }
 };
+class approx_count_distinct_wire_func_t : public skip_wire_func_t {
+public:
+    template <class... Args>
+    explicit approx_count_distinct_wire_func_t(Args... args)
+        : skip_wire_func_t(args...) { }
+};
+class approx_quantile_wire_func_t : public skip_wire_func_t {
+public:
+    approx_quantile_wire_func_t() : quantile(0) { }
+    template <class... Args>
+    explicit approx_quantile_wire_func_t(double _quantile, Args... args)
+        : skip_wire_func_t(args...), quantile(_quantile) { }
+    double quantile;
+};
+RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(approx_quantile_wire_func_t);
 
 }  // namespace ql
 
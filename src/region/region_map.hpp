@@ -249,7 +249,7 @@ private:
     friend MUST_USE archive_result_t deserialize(read_stream_t *s, region_map_t<V> *map);
 
     region_map_t(key_range_map_t &&_inner, uint64_t _hash_beg, uint64_t _hash_end) :
-        inner(_inner), hash_beg(_hash_beg), hash_end(_hash_end) { }
+        inner(std::move(_inner)), hash_beg(_hash_beg), hash_end(_hash_end) { }
 
     key_range_map_t inner;
 
@@ -278,7 +278,8 @@ void serialize(write_message_t *wm, const region_map_t<V> &map) {
 template<cluster_version_t W, class V>
 MUST_USE archive_result_t deserialize(read_stream_t *s, region_map_t<V> *map) {
     switch (W) {
-        case cluster_version_t::v2_5_is_latest:
+        case cluster_version_t::v2_6_is_latest:
+        case cluster_version_t::v2_5:
         case cluster_version_t::v2_4:
         case cluster_version_t::v2_3:
         case cluster_version_t::v2_2:
@@ -8,6 +8,7 @@
 #include <algorithm>
 #include <functional>
 
+#include "arch/io/fault_injection.hpp"
 #include "arch/io/network.hpp"
 #include "arch/timing.hpp"
 #include "clustering/administration/metadata.hpp"
@@ -16,11 +17,11 @@
 #include "concurrency/pmap.hpp"
 #include "concurrency/semaphore.hpp"
 #include "config/args.hpp"
-#include "containers/archive/vector_stream.hpp"
 #include "containers/archive/versioned.hpp"
 #include "containers/object_buffer.hpp"
 #include "containers/uuid.hpp"
 #include "logger.hpp"
+#include "rpc/connectivity/failure_detector.hpp"
 #include "rpc/semilattice/watchable.hpp"
 #include "stl_utils.hpp"
 #include "utils.hpp"
@@ -28,12 +29,29 @@
 // Number of messages after which the message handling loop yields
 #define MESSAGE_HANDLER_MAX_BATCH_SIZE           16
 
+// Messages smaller than this are sent uncompressed even on compressed connections.
+// Heartbeats and most mailbox messages are this small, and compressing them would
+// cost CPU time and latency without saving much bandwidth.
+#define CLUSTER_COMPRESSION_MIN_MESSAGE_SIZE     1024
+
+// When there's more than one TCP connection per peer, messages at least this big are
+// sent on the bulk lanes, so that they don't hold up the smaller ones behind them.
+#define CLUSTER_BULK_MESSAGE_SIZE                (32 * KILOBYTE)
+
+// Messages at least this big are written to the network straight from the serialized
+// message, instead of being copied into the connection's write buffer first.
+#define CLUSTER_UNBUFFERED_MESSAGE_SIZE          (64 * KILOBYTE)
+
+// How long an extra lane waits for the connection it belongs to, on top of the join
+// delay, before giving up.
+#define CLUSTER_LANE_ATTACH_TIMEOUT_MS           (30 * THOUSAND)
+
 // The cluster communication protocol version.
-static_assert(cluster_version_t::CLUSTER == cluster_version_t::v2_5_is_latest,
+static_assert(cluster_version_t::CLUSTER == cluster_version_t::v2_6_is_latest,
               "We need to update CLUSTER_VERSION_STRING when we add a new cluster "
               "version.");
 
-#define CLUSTER_VERSION_STRING "2.5.0"
+#define CLUSTER_VERSION_STRING "2.6.0"
 
 const std::string connectivity_cluster_t::cluster_proto_header("RethinkDB cluster\n");
 const std::string connectivity_cluster_t::cluster_version_string(CLUSTER_VERSION_STRING);
@@ -133,18 +151,17 @@ connectivity_cluster_t::connection_t::connection_t(
         const peer_id_t &_peer_id,
         const server_id_t &_server_id,
         keepalive_tcp_conn_stream_t *_conn,
-        const peer_address_t &_peer_address) THROWS_NOTHING :
+        const peer_address_t &_peer_address,
+        cluster_compression_t compression,
+        size_t num_lanes,
+        const uuid_u &_local_connection_id,
+        const uuid_u &_remote_connection_id) THROWS_NOTHING :
     conn(_conn),
     peer_address(_peer_address),
-    flusher([&](signal_t *) {
-        guarantee(this->conn != nullptr);
-        // We need to acquire the send_mutex because flushing the buffer
-        // must not interleave with other writes (restriction of linux_tcp_conn_t).
-        mutex_t::acq_t acq(&this->send_mutex);
-        // We ignore the return value of flush_buffer(). Closed connections
-        // must be handled elsewhere.
-        this->conn->flush_buffer();
-    }, 1),
+    lanes(_conn == nullptr ? 0 : num_lanes),
+    next_bulk_lane(0),
+    local_connection_id(_local_connection_id),
+    remote_connection_id(_remote_connection_id),
     pm_collection(),
     pm_bytes_sent(secs_to_ticks(1), true),
     pm_collection_membership(
@@ -157,6 +174,11 @@ connectivity_cluster_t::connection_t::connection_t(
     server_id(_server_id),
     drainers()
 {
+    if (conn != nullptr) {
+        guarantee(!lanes.empty());
+        lanes[0].init(new lane_t(conn, compression));
+    }
+
     pmap(get_num_threads(), [this](int thread_id) {
         on_thread_t thread_switcher((threadnum_t(thread_id)));
         parent->parent->connections.get()->set_key_no_equals(
@@ -173,8 +195,69 @@ connectivity_cluster_t::connection_t::~connection_t() THROWS_NOTHING {
         drainers.get()->drain();
     });
 
-    /* The drainers have been destroyed, so nothing can be holding the `send_mutex`. */
-    guarantee(!send_mutex.is_locked());
+    /* The drainers have been destroyed, so nothing can be holding a `send_mutex`. The
+    extra lanes have all detached themselves, because they hold locks on the drainers
+    while they're attached. */
+    for (size_t i = 1; i < lanes.size(); ++i) {
+        guarantee(!lanes[i].has());
+    }
+    if (!lanes.empty()) {
+        guarantee(!lanes[0]->send_mutex.is_locked());
+    }
+}
+
+connectivity_cluster_t::connection_t::lane_t::lane_t(
+        keepalive_tcp_conn_stream_t *_conn,
+        cluster_compression_t compression) :
+    conn(_conn),
+    compressor(compression == cluster_compression_t::zlib
+        ? new message_compressor_t()
+        : nullptr),
+    flusher([&](signal_t *) {
+        // We need to acquire the send_mutex because flushing the buffer
+        // must not interleave with other writes (restriction of linux_tcp_conn_t).
+        mutex_t::acq_t acq(&this->send_mutex);
+        // We ignore the return value of flush_buffer(). Closed connections
+        // must be handled elsewhere.
+        this->conn->flush_buffer();
+    }, 1) {
+#ifdef FAULT_INJECTION_ENABLED
+    const fault_injection_config_t &faults =
+        get_fault_injection_config(fault_injection_target_t::network);
+    if (faults.is_enabled()) {
+        fault_injector.init(new fault_injector_t(faults));
+    }
+#endif
+}
+
+connectivity_cluster_t::connection_t::lane_t *
+connectivity_cluster_t::connection_t::choose_lane(
+        message_tag_t tag,
+        size_t message_size) {
+    assert_thread();
+    guarantee(!lanes.empty());
+    size_t index = 0;
+    if (lanes.size() > 1 && tag != heartbeat_tag) {
+        cluster_message_handler_t *handler = parent->parent->message_handlers[tag];
+        if (handler != nullptr && handler->allows_reordering()) {
+            /* With two lanes, the small messages share lane 0 with the ones that must
+            stay in order, and the big ones get lane 1. With more, the small messages
+            get lane 1 to themselves and the big ones take turns on the rest. */
+            if (message_size < CLUSTER_BULK_MESSAGE_SIZE) {
+                index = lanes.size() == 2 ? 0 : 1;
+            } else if (lanes.size() == 2) {
+                index = 1;
+            } else {
+                index = 2 + next_bulk_lane % (lanes.size() - 2);
+                ++next_bulk_lane;
+            }
+        }
+    }
+    if (!lanes[index].has()) {
+        // The lane hasn't attached yet, or it's going away.
+        index = 0;
+    }
+    return lanes[index].get();
 }
 
 // Helper function for the `run_t` constructor's initialization list
@@ -221,11 +304,15 @@ connectivity_cluster_t::run_t::run_t(
             _heartbeat_sl_view,
         std::shared_ptr<semilattice_read_view_t<auth_semilattice_metadata_t> >
             _auth_sl_view,
-        tls_ctx_t *_tls_ctx)
+        tls_ctx_t *_tls_ctx,
+        cluster_compression_t _compression,
+        int _connections_per_peer)
         THROWS_ONLY(address_in_use_exc_t, tcp_socket_exc_t) :
     parent(_parent),
     server_id(_server_id),
     tls_ctx(_tls_ctx),
+    compression(_compression),
+    connections_per_peer(_connections_per_peer),
 
     /* Create the socket to use when listening for connections from peers */
     cluster_listener_socket(new tcp_bound_socket_t(local_addresses, port)),
@@ -257,7 +344,8 @@ connectivity_cluster_t::run_t::run_t(
     `connection_map` on each thread and notifying any listeners that we're now
     connected to ourself. The destructor will remove us from the
     `connection_map` and again notify any listeners. */
-    connection_to_ourself(this, parent->me, _server_id, nullptr, routing_table[parent->me]),
+    connection_to_ourself(this, parent->me, _server_id, nullptr, routing_table[parent->me],
+                          cluster_compression_t::none, 0, nil_uuid(), nil_uuid()),
 
     heartbeat_sl_view(_heartbeat_sl_view),
     auth_sl_view(_auth_sl_view),
@@ -268,6 +356,8 @@ connectivity_cluster_t::run_t::run_t(
                  this, ph::_1, join_delay_secs, auto_drainer_t::lock_t(&drainer))))
 {
     parent->assert_thread();
+    guarantee(connections_per_peer >= 1
+              && connections_per_peer <= max_connections_per_peer);
 }
 
 connectivity_cluster_t::run_t::~run_t() {
@@ -321,7 +411,8 @@ void connectivity_cluster_t::run_t::on_new_connection(
 
     keepalive_tcp_conn_stream_t conn_stream(conn);
 
-    handle(&conn_stream, r_nullopt, r_nullopt, r_nullopt, lock, nullptr, join_delay_secs);
+    handle(&conn_stream, r_nullopt, r_nullopt, r_nullopt, lock, nullptr, join_delay_secs,
+           nullptr);
 }
 
 join_result_t connectivity_cluster_t::run_t::connect_to_peer(
@@ -359,7 +450,8 @@ join_result_t connectivity_cluster_t::run_t::connect_to_peer(
 
             join_result = handle(
                 &conn, expected_id, optional<peer_address_t>(*address),
-                expected_server_id, drainer_lock, successful_join_inout, join_delay_secs);
+                expected_server_id, drainer_lock, successful_join_inout, join_delay_secs,
+                nullptr);
         } catch (const tcp_conn_t::connect_failed_exc_t &) {
             /* Ignore */
         } catch (const crypto::openssl_error_t &) {
@@ -374,6 +466,32 @@ join_result_t connectivity_cluster_t::run_t::connect_to_peer(
     return join_result;
 }
 
+void connectivity_cluster_t::run_t::connect_lane(
+        ip_and_port_t addr,
+        lane_request_t request,
+        peer_id_t expected_id,
+        server_id_t expected_server_id,
+        const int join_delay_secs,
+        auto_drainer_t::lock_t drainer_lock) THROWS_NOTHING {
+    parent->assert_thread();
+    try {
+        /* We never get here with a fixed `cluster_client_port`, because all our
+        connections to the peer would have the same source and destination. */
+        keepalive_tcp_conn_stream_t conn(
+            tls_ctx, addr.ip(), addr.port().value(), drainer_lock.get_drain_signal(),
+            0);
+        handle(&conn, optional<peer_id_t>(expected_id), r_nullopt,
+               optional<server_id_t>(expected_server_id), drainer_lock, nullptr,
+               join_delay_secs, &request);
+    } catch (const tcp_conn_t::connect_failed_exc_t &) {
+        /* Ignore. Messages for the missing lane go on lane 0 instead. */
+    } catch (const crypto::openssl_error_t &) {
+        /* Ignore */
+    } catch (const interrupted_exc_t &) {
+        /* Ignore */
+    }
+}
+
 join_results_t connectivity_cluster_t::run_t::join_blocking(
         const peer_address_t &peer,
         optional<peer_id_t> expected_id,
@@ -452,10 +570,24 @@ private:
     DISABLE_COPYING(cluster_conn_closing_subscription_t);
 };
 
+/* A `phi` of 8 means that a live peer would have been this quiet about once in 10^8
+timer ticks. */
+static const double heartbeat_phi_threshold = 8.0;
+/* Traffic is only observed once per timer tick, so the intervals between arrivals are
+whole numbers of ticks and are often all the same. */
+static const double heartbeat_min_stddev_intervals = 0.5;
+
 /* `heartbeat_manager_t` is responsible for sending heartbeats over a single connection
 and making sure that heartbeats have arrived on time.
 `connectivity_cluster_t::run_t::handle()` constructs one after constructing the
-`connection_t`. */
+`connection_t`.
+
+Any traffic counts as a heartbeat, in both directions: we only send a heartbeat if we
+haven't written anything else for `HEARTBEAT_IDLE_INTERVALS` timer ticks, and any read
+resets the timeout. The connection is killed if nothing has been read for more than
+`HEARTBEAT_TIMEOUT_INTERVALS` ticks (the configured heartbeat timeout), or earlier if
+`failure_detector` considers the silence very unlikely given how regularly traffic has
+been arriving so far. */
 class connectivity_cluster_t::heartbeat_manager_t :
     public keepalive_tcp_conn_stream_t::keepalive_callback_t,
     private repeating_timer_callback_t,
@@ -463,6 +595,14 @@ class connectivity_cluster_t::heartbeat_manager_t :
 {
 public:
     static const int HEARTBEAT_TIMEOUT_INTERVALS = 5;
+    /* Peers running older versions kill the connection after
+    `HEARTBEAT_TIMEOUT_INTERVALS` silent ticks, so this must stay well below that. */
+    static const int HEARTBEAT_IDLE_INTERVALS = 2;
+    /* The failure detector never kills a connection that's been silent for fewer ticks
+    than this, no matter how regular the traffic was. */
+    static const int HEARTBEAT_MIN_SUSPECT_INTERVALS = 3;
+    static const size_t FAILURE_DETECTOR_WINDOW = 100;
+    static const size_t FAILURE_DETECTOR_MIN_SAMPLES = 10;
 
     heartbeat_manager_t(
             connectivity_cluster_t::connection_t *connection_,
@@ -475,6 +615,8 @@ public:
         read_done(false),
         write_done(false),
         intervals_since_last_read_done(0),
+        intervals_since_last_write_done(0),
+        failure_detector(FAILURE_DETECTOR_WINDOW, heartbeat_min_stddev_intervals),
         peer_str(peer_str_),
         timeout(0),
         heartbeat_sl_view(std::move(heartbeat_sl_view_)),
@@ -504,7 +646,8 @@ public:
     void on_ring() {
         ASSERT_FINITE_CORO_WAITING;
 
-        if (intervals_since_last_read_done > HEARTBEAT_TIMEOUT_INTERVALS) {
+        if (intervals_since_last_read_done > HEARTBEAT_TIMEOUT_INTERVALS
+                || peer_suspected()) {
             logERR("Heartbeat timeout, killing connection to peer %s", peer_str.c_str());
 
             /* This won't block if we call it from the same thread. This is an
@@ -515,7 +658,9 @@ public:
         }
         if (write_done) {
             write_done = false;
-        } else {
+            intervals_since_last_write_done = 0;
+        } else if (++intervals_since_last_write_done >= HEARTBEAT_IDLE_INTERVALS) {
+            intervals_since_last_write_done = 0;
             /* The purpose of `heartbeat_manager_keepalive` is to ensure that we don't
             shut down while the heartbeat sending coroutine is still active */
             auto_drainer_t::lock_t this_keepalive(&drainer);
@@ -531,6 +676,7 @@ public:
             /* `intervals_since_last_read_done` may be negative when transitioning
                between timeouts, we should't reset it to zero when it's doing so. */
             if (intervals_since_last_read_done >= 0) {
+                failure_detector.add_interval(intervals_since_last_read_done + 1);
                 intervals_since_last_read_done = 0;
             } else {
                 intervals_since_last_read_done++;
@@ -541,7 +687,7 @@ public:
         }
     }
 
-    void write(write_stream_t *) {
+    void write(write_message_t *) {
         /* Do nothing. The cluster will end up sending just the tag 'H' with no message
         attached, which will trigger `keepalive_read()` on the remote server. */
     }
@@ -568,16 +714,28 @@ public:
         } else {
             intervals_since_last_read_done = 0;
         }
+        /* The intervals we recorded were measured in ticks of the old timer. */
+        failure_detector.reset();
         timeout = timeout_new;
         timer = scoped_ptr_t<repeating_timer_t>(new repeating_timer_t(
             timeout / HEARTBEAT_TIMEOUT_INTERVALS, this));
     }
 
 private:
+    bool peer_suspected() const {
+        return !read_done
+            && intervals_since_last_read_done >= HEARTBEAT_MIN_SUSPECT_INTERVALS
+            && failure_detector.num_intervals() >= FAILURE_DETECTOR_MIN_SAMPLES
+            && failure_detector.phi(intervals_since_last_read_done)
+                > heartbeat_phi_threshold;
+    }
+
     connectivity_cluster_t::connection_t *connection;
     auto_drainer_t::lock_t connection_keepalive;
     bool read_done, write_done;
     int64_t intervals_since_last_read_done;
+    int64_t intervals_since_last_write_done;
+    phi_accrual_detector_t failure_detector;
     std::string peer_str;
     int64_t timeout;
 
@@ -866,7 +1024,9 @@ join_result_t connectivity_cluster_t::run_t::handle(
         optional<server_id_t> expected_server_id,
         auto_drainer_t::lock_t drainer_lock,
         bool *successful_join_inout,
-        const int join_delay_secs) THROWS_NOTHING
+        const int join_delay_secs,
+        /* Non-NULL if we're opening an extra lane for a connection we initiated */
+        const lane_request_t *lane_request) THROWS_NOTHING
 {
     parent->assert_thread();
 
@@ -890,10 +1050,20 @@ join_result_t connectivity_cluster_t::run_t::handle(
     // Get the name of our peer, for error reporting.
     ip_and_port_t peer_addr;
     std::string peerstr = "(unknown)";
-    if (conn->get_underlying_conn()->getpeername(&peer_addr))
+    const bool have_peer_addr = conn->get_underlying_conn()->getpeername(&peer_addr);
+    if (have_peer_addr)
         peerstr = peer_addr.to_string();
     const char *peername = peerstr.c_str();
 
+    /* We only ask for extra lanes if we can open them from a port of our choice. With
+    a fixed `cluster_client_port`, they would all look the same to TCP. */
+    const uint8_t lanes_wanted = cluster_client_port == 0
+        ? static_cast<uint8_t>(connections_per_peer)
+        : 1;
+    const uuid_u local_connection_id = lane_request != nullptr
+        ? lane_request->connection_id
+        : generate_uuid();
+
     // Make sure that if we're ordered to shut down, any pending read
     // or write gets interrupted.
     cluster_conn_closing_subscription_t conn_closer_1(conn);
@@ -920,6 +1090,11 @@ join_result_t connectivity_cluster_t::run_t::handle(
         serialize_universal(&wm, has_admin_password);
         serialize_universal(&wm, parent->me);
         serialize_universal(&wm, routing_table[parent->me].hosts());
+        serialize_universal(&wm, supported_cluster_compression_mask());
+        serialize_universal(&wm, lanes_wanted);
+        serialize_universal(&wm, static_cast<uint8_t>(
+            lane_request != nullptr ? lane_request->lane_index : 0));
+        serialize_universal(&wm, local_connection_id);
         if (send_write_message(conn, &wm)) {
             return join_result_t::TEMPORARY_ERROR; // network error.
         }
@@ -996,17 +1171,11 @@ join_result_t connectivity_cluster_t::run_t::handle(
             fail_handshake(conn, peername, reason);
             return join_result_t::PERMANENT_ERROR;
         }
-
-        if (servers.count(remote_server_id) != 0) {
-            // There currently is another connection open to the server
-            logINF("Rejected a connection from server %s since one is open already.",
-                   remote_server_id.print().c_str());
-            return join_result_t::TEMPORARY_ERROR;
-        }
     }
 
-    set_insertion_sentry_t<server_id_t> remote_server_id_sentry(
-        &servers, remote_server_id);
+    /* Filled in once we know that this isn't an extra lane of an existing
+    connection. */
+    set_insertion_sentry_t<server_id_t> remote_server_id_sentry;
 
     // Check bitsize (e.g. 32bit or 64bit)
     {
@@ -1064,14 +1233,54 @@ join_result_t connectivity_cluster_t::run_t::handle(
         }
     }
 
-    // Receive id, host/ports.
+    /* Receive id, host/ports, the compression codecs the other side supports, how many
+    lanes it wants, and which connection and lane this is. A lane index of 0 means that
+    this is a new connection rather than an extra lane of an existing one. */
     peer_id_t other_id;
     std::set<host_and_port_t> other_peer_addr_hosts;
+    uint8_t other_compression_mask;
+    uint8_t other_lanes_wanted;
+    uint8_t other_lane_index;
+    uuid_u other_connection_id;
     if (deserialize_universal_and_check(conn, &other_id, peername) ||
-        deserialize_universal_and_check(conn, &other_peer_addr_hosts, peername)) {
+        deserialize_universal_and_check(conn, &other_peer_addr_hosts, peername) ||
+        deserialize_universal_and_check(conn, &other_compression_mask, peername) ||
+        deserialize_universal_and_check(conn, &other_lanes_wanted, peername) ||
+        deserialize_universal_and_check(conn, &other_lane_index, peername) ||
+        deserialize_universal_and_check(conn, &other_connection_id, peername)) {
+        return join_result_t::TEMPORARY_ERROR;
+    }
+
+    const bool is_lane = lane_request != nullptr || other_lane_index != 0;
+    if (lane_request != nullptr && other_lane_index != 0) {
+        logERR("Both sides of the connection from %s think that they opened it, "
+               "closing connection.", peername);
         return join_result_t::TEMPORARY_ERROR;
     }
 
+    /* Extra lanes belong to a connection that is already open, so they don't count
+    towards the one connection per server that we allow. */
+    if (!is_lane) {
+        if (servers.count(remote_server_id) != 0) {
+            // There currently is another connection open to the server
+            logINF("Rejected a connection from server %s since one is open already.",
+                   remote_server_id.print().c_str());
+            return join_result_t::TEMPORARY_ERROR;
+        }
+        remote_server_id_sentry.reset(&servers, remote_server_id);
+    }
+
+    const size_t num_lanes = std::max<size_t>(
+        1, std::min<size_t>(lanes_wanted, other_lanes_wanted));
+
+    /* We compress what we send if the other side can decompress it. Each direction is
+    negotiated separately, so a server with compression turned off still decompresses
+    what its peers send it. */
+    const cluster_compression_t send_compression =
+        (other_compression_mask & (1 << static_cast<int>(compression))) != 0
+            ? compression
+            : cluster_compression_t::none;
+
     {
         // Tell the other node that we are happy to connect with it
         write_message_t wm;
@@ -1096,6 +1305,32 @@ join_result_t connectivity_cluster_t::run_t::handle(
         }
     }
 
+    if (is_lane) {
+        if (other_id == parent->me || other_id.is_nil()) {
+            return join_result_t::PERMANENT_ERROR;
+        }
+        if (expected_id && other_id != *expected_id) {
+            logERR("Received inconsistent routing information (wrong ID) from %s, "
+                   "closing connection.", peername);
+            return join_result_t::PERMANENT_ERROR;
+        }
+
+        /* `handle_lane()` makes its own arrangements for closing the connection when
+        we shut down. */
+        conn_closer_1.reset();
+
+        guarantee(resolved_version == cluster_version_t::CLUSTER);
+        if (lane_request != nullptr) {
+            return handle_lane(conn, other_id, lane_request->lane_index,
+                               lane_request->connection_id, true, send_compression,
+                               drainer_lock, join_delay_secs, peername);
+        } else {
+            return handle_lane(conn, other_id, other_lane_index, other_connection_id,
+                               false, send_compression, drainer_lock, join_delay_secs,
+                               peername);
+        }
+    }
+
     // Look up the ip addresses for the other host
     object_buffer_t<peer_address_t> other_peer_addr;
 
@@ -1273,6 +1508,25 @@ join_result_t connectivity_cluster_t::run_t::handle(
         }
     }
 
+    /* If we opened the connection, we also open its extra lanes. They find the
+    `connection_t` once it's been constructed below. */
+    if (expected_address && have_peer_addr && num_lanes > 1
+            && !drainer_lock.get_drain_signal()->is_pulsed()) {
+        for (size_t i = 1; i < num_lanes; ++i) {
+            lane_request_t request;
+            request.lane_index = i;
+            request.connection_id = other_connection_id;
+            coro_t::spawn_sometime(std::bind(
+                &connectivity_cluster_t::run_t::connect_lane, this,
+                peer_addr,
+                request,
+                other_id,
+                remote_server_id,
+                join_delay_secs,
+                drainer_lock));
+        }
+    }
+
     /* Now that we're about to switch threads, it's not safe to try to close
     the connection from this thread anymore. This is safe because we won't do
     anything that permanently blocks before setting up `conn_closer_2`. */
@@ -1317,7 +1571,8 @@ join_result_t connectivity_cluster_t::run_t::handle(
         constructor registers it in the `connectivity_cluster_t`'s connection
         map. */
         connection_t conn_structure(
-            this, other_id, remote_server_id, conn, *other_peer_addr.get());
+            this, other_id, remote_server_id, conn, *other_peer_addr.get(),
+            send_compression, num_lanes, local_connection_id, other_connection_id);
 
         /* `heartbeat_manager` will periodically send a heartbeat message to
         other servers, and it will also close the connection if we don't
@@ -1332,36 +1587,11 @@ join_result_t connectivity_cluster_t::run_t::handle(
         it's closed, which may be due to network events, or the other end
         shutting down, or us shutting down. */
         try {
-            int messages_handled_since_yield = 0;
-            while (true) {
-                message_tag_t tag;
-                archive_result_t res = deserialize_universal(conn, &tag);
-                if (bad(res)) { throw fake_archive_exc_t(); }
-
-                /* Ignore messages tagged with the heartbeat tag. The
-                `keepalive_tcp_conn_stream_t` will have already notified the
-                `heartbeat_manager_t` as soon as the heartbeat arrived. */
-                if (tag != heartbeat_tag) {
-                    cluster_message_handler_t *handler = parent->message_handlers[tag];
-                    guarantee(handler != nullptr, "Got a message for an unfamiliar tag. "
-                        "Apparently we aren't compatible with the cluster on the other "
-                        "end.");
-
-                    /* If you really want to support old cluster versions, the
-                    resolved_version should be passed into the on_message() handler. */
-                    guarantee(resolved_version == cluster_version_t::CLUSTER);
-                    handler->on_message(
-                        &conn_structure,
-                        auto_drainer_t::lock_t(conn_structure.drainers.get()),
-                        conn); // might raise fake_archive_exc_t
-                }
-
-                ++messages_handled_since_yield;
-                if (messages_handled_since_yield >= MESSAGE_HANDLER_MAX_BATCH_SIZE) {
-                    coro_t::yield();
-                    messages_handled_since_yield = 0;
-                }
-            }
+            /* If you really want to support old cluster versions, the
+            resolved_version should be passed into the on_message() handler. */
+            guarantee(resolved_version == cluster_version_t::CLUSTER);
+            read_messages(conn, &conn_structure,
+                          auto_drainer_t::lock_t(conn_structure.drainers.get()));
         } catch (const fake_archive_exc_t &) {
             /* The exception broke us out of the loop, and that's what we
             wanted. This could either be because we lost contact with the peer
@@ -1393,6 +1623,188 @@ join_result_t connectivity_cluster_t::run_t::handle(
     return join_result_t::SUCCESS;
 }
 
+void connectivity_cluster_t::run_t::read_messages(
+        keepalive_tcp_conn_stream_t *conn,
+        connection_t *connection,
+        const auto_drainer_t::lock_t &connection_keepalive)
+        THROWS_ONLY(fake_archive_exc_t) {
+    /* Created when the first compressed message arrives, since the other side
+    might never send us one. */
+    scoped_ptr_t<message_decompressor_t> decompressor;
+    std::vector<char> compressed_data;
+    int messages_handled_since_yield = 0;
+    while (true) {
+        message_tag_t tag;
+        archive_result_t res = deserialize_universal(conn, &tag);
+        if (bad(res)) { throw fake_archive_exc_t(); }
+
+        /* Compressed messages carry their actual tag inside. We decompress
+        them into a buffer and hand that to the message handler instead of the
+        connection. */
+        bool is_compressed = false;
+        std::vector<char> uncompressed_data;
+        if (tag == compressed_tag) {
+            uint64_t uncompressed_size, compressed_size;
+            res = deserialize_universal(conn, &tag);
+            if (bad(res)) { throw fake_archive_exc_t(); }
+            res = deserialize_universal(conn, &uncompressed_size);
+            if (bad(res)) { throw fake_archive_exc_t(); }
+            res = deserialize_universal(conn, &compressed_size);
+            if (bad(res)) { throw fake_archive_exc_t(); }
+            compressed_data.resize(compressed_size);
+            if (force_read(conn, compressed_data.data(), compressed_size)
+                    != static_cast<int64_t>(compressed_size)) {
+                throw fake_archive_exc_t();
+            }
+            if (!decompressor.has()) {
+                decompressor.init(new message_decompressor_t());
+            }
+            if (!decompressor->decompress(compressed_data.data(),
+                                          compressed_size,
+                                          uncompressed_size,
+                                          &uncompressed_data)) {
+                throw fake_archive_exc_t();
+            }
+            is_compressed = true;
+        }
+
+        /* Ignore messages tagged with the heartbeat tag. The
+        `keepalive_tcp_conn_stream_t` will have already notified the
+        `heartbeat_manager_t` as soon as the heartbeat arrived. */
+        if (tag != heartbeat_tag) {
+            cluster_message_handler_t *handler = parent->message_handlers[tag];
+            guarantee(handler != nullptr, "Got a message for an unfamiliar tag. "
+                "Apparently we aren't compatible with the cluster on the other "
+                "end.");
+
+            if (is_compressed) {
+                vector_read_stream_t read_stream(std::move(uncompressed_data));
+                handler->on_message(
+                    connection,
+                    connection_keepalive,
+                    &read_stream); // might raise fake_archive_exc_t
+            } else {
+                handler->on_message(
+                    connection,
+                    connection_keepalive,
+                    conn); // might raise fake_archive_exc_t
+            }
+        }
+
+        ++messages_handled_since_yield;
+        if (messages_handled_since_yield >= MESSAGE_HANDLER_MAX_BATCH_SIZE) {
+            coro_t::yield();
+            messages_handled_since_yield = 0;
+        }
+    }
+}
+
+join_result_t connectivity_cluster_t::run_t::handle_lane(
+        keepalive_tcp_conn_stream_t *conn,
+        const peer_id_t &other_id,
+        size_t lane_index,
+        /* Either our or the other side's id for the connection, depending on
+        `connection_id_is_remote` */
+        const uuid_u &connection_id,
+        bool connection_id_is_remote,
+        cluster_compression_t send_compression,
+        auto_drainer_t::lock_t drainer_lock,
+        const int join_delay_secs,
+        const char *peername) THROWS_NOTHING {
+    parent->assert_thread();
+
+    /* The side that initiated the connection opens the extra lanes as soon as the
+    handshake is done, so they can get here before `handle()` has constructed the
+    `connection_t`. */
+    connection_t *connection = nullptr;
+    auto_drainer_t::lock_t connection_keepalive;
+    try {
+        signal_timer_t timeout;
+        timeout.start(static_cast<int64_t>(join_delay_secs) * 1000
+                      + CLUSTER_LANE_ATTACH_TIMEOUT_MS);
+        wait_any_t interruptor(&timeout, drainer_lock.get_drain_signal());
+        parent->connections.get()->run_key_until_satisfied(other_id,
+            [&](const connection_pair_t *pair) {
+                if (pair == nullptr) {
+                    return false;
+                }
+                const uuid_u &id = connection_id_is_remote
+                    ? pair->first->remote_connection_id
+                    : pair->first->local_connection_id;
+                if (id != connection_id) {
+                    return false;
+                }
+                connection = pair->first;
+                connection_keepalive = pair->second;
+                return true;
+            },
+            &interruptor);
+    } catch (const interrupted_exc_t &) {
+        return join_result_t::TEMPORARY_ERROR;
+    }
+
+    /* `connection_keepalive` is for this thread's drainer, so it has to stay here; it
+    keeps `connection` alive while we switch to the connection's thread and get a
+    lock that we can use there. */
+    const threadnum_t connection_thread = connection->conn->home_thread();
+    rethread_tcp_conn_stream_t unregister_conn(conn, INVALID_THREAD);
+    on_thread_t conn_threader(connection_thread);
+    rethread_tcp_conn_stream_t reregister_conn(conn, get_thread_id());
+
+    auto_drainer_t::lock_t local_keepalive;
+    if (parent->get_connection(other_id, &local_keepalive) != connection) {
+        // The connection is going away.
+        conn->flush_buffer();
+        return join_result_t::TEMPORARY_ERROR;
+    }
+
+    if (lane_index >= connection->lanes.size() || connection->lanes[lane_index].has()) {
+        logWRN("Received an unexpected extra connection from %s, closing it.",
+               peername);
+        conn->flush_buffer();
+        return join_result_t::TEMPORARY_ERROR;
+    }
+
+    // Close the lane when the connection goes away or we're ordered to shut down.
+    // The connection going away covers the latter, because `handle()` closes it.
+    cluster_conn_closing_subscription_t conn_closer_2(conn);
+    conn_closer_2.reset(local_keepalive.get_drain_signal());
+
+    connection->lanes[lane_index].init(
+        new connection_t::lane_t(conn, send_compression));
+
+    try {
+        read_messages(conn, connection, local_keepalive);
+    } catch (const fake_archive_exc_t &) {
+        /* The lane was closed, or we received something invalid on it. */
+    }
+
+    if (conn->is_read_open()) {
+        logWRN("Received invalid data on a cluster connection. Disconnecting.");
+        conn->shutdown_read();
+    }
+    if (conn->is_write_open()) {
+        conn->shutdown_write();
+    }
+
+    /* Whatever was being sent on this lane is lost, but the senders were promised that
+    their messages arrive unless the connection goes down. So we take the rest of the
+    connection down with the lane. */
+    if (!local_keepalive.get_drain_signal()->is_pulsed()) {
+        connection->kill_connection();
+    }
+
+    {
+        /* Take the lane out of `lanes` first, so that nobody picks it while its
+        destructor waits for the senders that are still using it. */
+        scoped_ptr_t<connection_t::lane_t> lane;
+        lane.swap(connection->lanes[lane_index]);
+    }
+
+    conn->flush_buffer();
+    return join_result_t::SUCCESS;
+}
+
 connectivity_cluster_t::connectivity_cluster_t() THROWS_NOTHING :
     me(peer_id_t(generate_uuid())),
     /* We assign threads from the highest thread number downwards. This is to reduce the
@@ -1475,27 +1887,26 @@ void connectivity_cluster_t::send_message(connection_t *connection,
         return;
     }
 
-    /* We currently write the message to a vector_stream_t, then
-       serialize that as a string. It's horribly inefficient, of course. */
-    // TODO: If we don't do it this way, we (or the caller) will need
-    // to worry about having the writer run on the connection thread.
-    vector_stream_t buffer;
-    // Reserve some space to reduce overhead (especially for small messages)
-    buffer.reserve(1024);
+    /* The message stays in the buffers of the `write_message_t` until it goes out.
+    Small buffers are copied straight into the connection's write buffer. */
+    write_message_t wm;
     {
         ASSERT_FINITE_CORO_WAITING;
-        callback->write(&buffer);
+        callback->write(&wm);
     }
+    const size_t message_size = wm.size();
 
 #ifdef CLUSTER_MESSAGE_DEBUGGING
     {
+        std::vector<char> message_data(message_size);
+        wm.copy_to(message_data.data());
         printf_buffer_t buf;
         buf.appendf("from ");
         debug_print(&buf, me);
         buf.appendf(" to ");
         debug_print(&buf, dest);
         buf.appendf("\n");
-        print_hd(buffer.vector().data(), 0, buffer.vector().size());
+        print_hd(message_data.data(), 0, message_data.size());
     }
 #endif
 
@@ -1509,7 +1920,7 @@ void connectivity_cluster_t::send_message(connection_t *connection,
     }
 #endif
 
-    size_t bytes_sent = buffer.vector().size();
+    size_t bytes_sent = message_size;
 
 #ifdef ENABLE_MESSAGE_PROFILER
     std::pair<uint64_t, uint64_t> *stats =
@@ -1520,65 +1931,126 @@ void connectivity_cluster_t::send_message(connection_t *connection,
 
     if (connection->is_loopback()) {
         // We could be on any thread here! Oh no!
-        std::vector<char> buffer_data;
-        buffer.swap(&buffer_data);
+        std::vector<char> buffer_data(message_size);
+        wm.copy_to(buffer_data.data());
         rassert(message_handlers[tag], "No message handler for tag %" PRIu8, tag);
         message_handlers[tag]->on_local_message(connection, connection_keepalive,
             std::move(buffer_data));
     } else {
         on_thread_t threader(connection->conn->home_thread());
 
+        /* Pick the TCP connection to send the message on, and make sure it stays
+        around until we're done with it. */
+        connection_t::lane_t *lane =
+            connection->choose_lane(tag, message_size);
+        auto_drainer_t::lock_t lane_keepalive(&lane->drainer);
+
+        /* If network fault injection is on, wait until the message would have made it
+        through the slow link. The delays keep the messages on a lane in order. */
+        if (lane->fault_injector.has()) {
+            int64_t delay_us = lane->fault_injector->delay_us(message_size,
+                                                              get_kiloticks().micros);
+            if (delay_us > 0) {
+                try {
+                    nap(ceil_divide(delay_us, THOUSAND),
+                        lane_keepalive.get_drain_signal());
+                } catch (const interrupted_exc_t &) {
+                    return;
+                }
+            }
+        }
+
         /* Acquire the send-mutex so we don't collide with other things trying
         to send on the same connection. */
         {
             /* The `true` is for eager waiting, which is a significant performance
             optimization in this case. */
-            mutex_t::acq_t acq(&connection->send_mutex, true);
+            mutex_t::acq_t acq(&lane->send_mutex, true);
+
+            /* Compress the message if the lane is set up for it and the message is big
+            enough to be worth it. This has to happen under the `send_mutex`, because
+            the other side must decompress the messages in the same order. */
+            std::vector<char> compressed_data;
+            const bool compress =
+                lane->compressor.has()
+                && message_size >= CLUSTER_COMPRESSION_MIN_MESSAGE_SIZE;
+            if (compress) {
+                std::vector<char> message_data(message_size);
+                wm.copy_to(message_data.data());
+                lane->compressor->compress(message_data.data(),
+                                           message_data.size(),
+                                           &compressed_data);
+            }
 
             /* Write the tag to the network */
             {
                 // All cluster versions use a uint8_t tag here.
-                write_message_t wm;
+                write_message_t tag_wm;
                 static_assert(std::is_same<message_tag_t, uint8_t>::value,
                               "We expect to be serializing a uint8_t -- if this has "
                               "changed, the cluster communication format has changed and "
                               "you need to ask yourself whether live cluster upgrades work."
                               );
-                serialize_universal(&wm, tag);
-                make_buffered_tcp_conn_stream_wrapper_t buffered_conn(connection->conn);
-                int res = send_write_message(&buffered_conn, &wm);
+                if (compress) {
+                    serialize_universal(&tag_wm, compressed_tag);
+                    serialize_universal(&tag_wm, tag);
+                    serialize_universal(&tag_wm, static_cast<uint64_t>(message_size));
+                    serialize_universal(&tag_wm,
+                        static_cast<uint64_t>(compressed_data.size()));
+                } else {
+                    serialize_universal(&tag_wm, tag);
+                }
+                make_buffered_tcp_conn_stream_wrapper_t buffered_conn(lane->conn);
+                int res = send_write_message(&buffered_conn, &tag_wm);
                 if (res == -1) {
                     /* Close the other half of the connection to make sure that
                        `connectivity_cluster_t::run_t::handle()` notices that something is
                        up */
-                    if (connection->conn->is_read_open()) {
-                        connection->conn->shutdown_read();
+                    if (lane->conn->is_read_open()) {
+                        lane->conn->shutdown_read();
                     }
                     return;
                 }
             }
 
-            /* Write the message itself to the network */
-            {
-                int64_t res = connection->conn->write_buffered(buffer.vector().data(),
-                                                               buffer.vector().size());
+            /* Write the message itself to the network. Big buffers skip the write
+            buffer; they go out together with what's in it in a single system call. */
+            auto write_payload = [&](const char *data, size_t size) -> bool {
+                int64_t res =
+                    size >= CLUSTER_UNBUFFERED_MESSAGE_SIZE
+                        ? lane->conn->write(data, size)
+                        : lane->conn->write_buffered(data, size);
                 if (res == -1) {
-                    if (connection->conn->is_read_open()) {
-                        connection->conn->shutdown_read();
+                    if (lane->conn->is_read_open()) {
+                        lane->conn->shutdown_read();
                     }
+                    return false;
+                }
+                guarantee(res == static_cast<int64_t>(size));
+                return true;
+            };
+            if (compress) {
+                if (!write_payload(compressed_data.data(), compressed_data.size())) {
                     return;
-                } else {
-                    guarantee(res == static_cast<int64_t>(buffer.vector().size()));
+                }
+                bytes_sent = compressed_data.size();
+            } else {
+                intrusive_list_t<write_buffer_t> *buffers = wm.unsafe_expose_buffers();
+                for (write_buffer_t *p = buffers->head(); p != nullptr;
+                     p = buffers->next(p)) {
+                    if (!write_payload(p->data, p->size)) {
+                        return;
+                    }
                 }
             }
         } /* Releases the send_mutex */
 
-        connection->flusher.notify();
+        lane->flusher.notify();
         cond_t dummy_interruptor;
-        connection->flusher.flush(&dummy_interruptor);
-        if (!connection->conn->is_write_open()) {
-            if (connection->conn->is_read_open()) {
-                connection->conn->shutdown_read();
+        lane->flusher.flush(&dummy_interruptor);
+        if (!lane->conn->is_write_open()) {
+            if (lane->conn->is_read_open()) {
+                lane->conn->shutdown_read();
             }
             return;
         }
@@ -1596,6 +2068,9 @@ cluster_message_handler_t::cluster_message_handler_t(
     rassert(tag != connectivity_cluster_t::heartbeat_tag,
         "Tag %" PRIu8 " is reserved for heartbeat messages.",
         connectivity_cluster_t::heartbeat_tag);
+    rassert(tag != connectivity_cluster_t::compressed_tag,
+        "Tag %" PRIu8 " is reserved for compressed messages.",
+        connectivity_cluster_t::compressed_tag);
     rassert(connectivity_cluster->message_handlers[tag] == nullptr);
     connectivity_cluster->message_handlers[tag] = this;
 }
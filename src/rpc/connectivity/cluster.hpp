@@ -19,6 +19,7 @@
 #include "concurrency/pump_coro.hpp"
 #include "perfmon/perfmon.hpp"
 #include "random.hpp"
+#include "rpc/connectivity/message_compression.hpp"
 #include "rpc/connectivity/peer_id.hpp"
 #include "rpc/connectivity/server_id.hpp"
 #include "utils.hpp"
@@ -30,6 +31,7 @@ template <class> class optional;
 class auth_semilattice_metadata_t;
 class cluster_message_handler_t;
 class co_semaphore_t;
+class fault_injector_t;
 class heartbeat_semilattice_metadata_t;
 template <class> class semilattice_read_view_t;
 
@@ -56,8 +58,9 @@ class cluster_send_message_write_callback_t {
 public:
     virtual ~cluster_send_message_write_callback_t() { }
     // write() doesn't take a version argument because the version is always
-    // cluster_version_t::CLUSTER for cluster messages.
-    virtual void write(write_stream_t *stream) = 0;
+    // cluster_version_t::CLUSTER for cluster messages. The message is sent from the
+    // buffers of `wm` as they are, without copying it into one piece first.
+    virtual void write(write_message_t *wm) = 0;
 
 #ifdef ENABLE_MESSAGE_PROFILER
     /* This should return a string that describes the type of message being sent for
@@ -83,7 +86,9 @@ down. Messages cannot be duplicated.
 
 Can messages be reordered? I think the current implementation doesn't ever reorder
 messages, but don't rely on this guarantee. However, some old code may rely on this
-guarantee (I'm not sure) so don't break this property without checking first. */
+guarantee (I'm not sure) so don't break this property without checking first. The one
+exception is that if we open several TCP connections to each peer, messages for handlers
+whose `allows_reordering()` returns true can overtake each other. */
 
 class connectivity_cluster_t :
     public home_thread_mixin_debug_only_t
@@ -105,6 +110,14 @@ public:
     /* This tag is reserved exclusively for heartbeat messages. */
     static const message_tag_t heartbeat_tag = 'H';
 
+    /* This tag is reserved for wrapping compressed messages. It's followed by the tag
+    of the message inside, its uncompressed and compressed sizes, and the compressed
+    data. */
+    static const message_tag_t compressed_tag = 'Z';
+
+    /* The most TCP connections we open to a single peer */
+    static const int max_connections_per_peer = 8;
+
     class run_t;
 
     /* `connection_t` represents an open connection to another server. If we lose
@@ -154,9 +167,56 @@ public:
             const peer_id_t &peer_id,
             const server_id_t &server_id,
             keepalive_tcp_conn_stream_t *,
-            const peer_address_t &peer_address) THROWS_NOTHING;
+            const peer_address_t &peer_address,
+            cluster_compression_t compression,
+            size_t num_lanes,
+            const uuid_u &local_connection_id,
+            const uuid_u &remote_connection_id) THROWS_NOTHING;
         ~connection_t() THROWS_NOTHING;
 
+        /* A lane is one of the TCP connections that carry our messages to the peer.
+        The connection that the handshake happened on is lane 0; if we negotiated
+        more than one connection per peer, the others attach themselves as they
+        arrive. Lanes live on the same thread as the `connection_t`, and are only
+        touched on that thread. */
+        class lane_t {
+        public:
+            lane_t(keepalive_tcp_conn_stream_t *conn,
+                   cluster_compression_t compression);
+
+            keepalive_tcp_conn_stream_t *conn;
+
+            mutex_t send_mutex;
+
+            /* Compresses large outgoing messages, or NULL if we don't compress what
+            we send on this connection. Only used while holding `send_mutex`, because
+            the compressed messages must go out in the order they were compressed
+            in. */
+            scoped_ptr_t<message_compressor_t> compressor;
+
+            /* Calls `conn->flush_buffer()`. Can be used for making sure that a
+            buffered write makes it to the TCP stack. */
+            pump_coro_t flusher;
+
+            /* Holds back outgoing messages to make the link look slower than it is.
+            NULL unless network fault injection is turned on. */
+            scoped_ptr_t<fault_injector_t> fault_injector;
+
+            /* Senders hold a lock on this while they use the lane, so the lane can be
+            removed when its TCP connection goes away. */
+            auto_drainer_t drainer;
+
+        private:
+            DISABLE_COPYING(lane_t);
+        };
+
+        /* Picks the lane to send a message with the given tag and size on. Messages
+        for handlers that can't cope with reordering, and heartbeats, always go on
+        lane 0. So do all messages if there's only one lane. Otherwise, big messages go
+        on the lanes after the first one or two, so they don't hold up small ones.
+        Must be called on the connection's thread. */
+        lane_t *choose_lane(message_tag_t tag, size_t message_size);
+
         /* NULL for the loopback connection (i.e. our "connection" to ourself) */
         keepalive_tcp_conn_stream_t *conn;
 
@@ -165,12 +225,17 @@ public:
         cross-thread to access the routing table. */
         peer_address_t peer_address;
 
-        /* Unused for our connection to ourself */
-        mutex_t send_mutex;
+        /* Empty for our connection to ourself. Slots are empty for lanes that
+        haven't attached yet, or that have gone away. */
+        std::vector<scoped_ptr_t<lane_t> > lanes;
+
+        /* For spreading big messages over the bulk lanes */
+        size_t next_bulk_lane;
 
-        /* Calls `conn->flush_buffer()`. Can be used for making sure that a
-        buffered write makes it to the TCP stack. */
-        pump_coro_t flusher;
+        /* The ids each side picked for this connection in the handshake. Extra lanes
+        use them to find the connection that they belong to. */
+        const uuid_u local_connection_id;
+        const uuid_u remote_connection_id;
 
         perfmon_collection_t pm_collection;
         perfmon_sampler_t pm_bytes_sent;
@@ -203,7 +268,9 @@ public:
                   heartbeat_semilattice_metadata_t> > heartbeat_sl_view,
               std::shared_ptr<semilattice_read_view_t<
                   auth_semilattice_metadata_t> > auth_sl_view,
-              tls_ctx_t *tls_ctx)
+              tls_ctx_t *tls_ctx,
+              cluster_compression_t compression,
+              int connections_per_peer)
             THROWS_ONLY(address_in_use_exc_t, tcp_socket_exc_t);
 
         ~run_t();
@@ -257,6 +324,22 @@ public:
                              const int join_delay_secs,
                              co_semaphore_t *rate_control) THROWS_NOTHING;
 
+        /* Which extra lane to open for a connection that we initiated. The
+        `connection_id` is the id that the other side picked for the connection. */
+        struct lane_request_t {
+            size_t lane_index;
+            uuid_u connection_id;
+        };
+
+        /* `connect_lane()` is spawned for each extra lane of a connection that we
+        initiated, once the handshake on the main connection is done. */
+        void connect_lane(ip_and_port_t addr,
+                          lane_request_t request,
+                          peer_id_t expected_id,
+                          server_id_t expected_server_id,
+                          const int join_delay_secs,
+                          auto_drainer_t::lock_t drainer_lock) THROWS_NOTHING;
+
         /* `join_blocking()` is spawned in a new coroutine by `join()`. It's also run by
         `handle()` when we hear about a new peer from a peer we are connected to, and
         directly by the auto_reconnector_t. For cases where it is used directly, it
@@ -287,7 +370,31 @@ public:
             optional<server_id_t> expected_server_id,
             auto_drainer_t::lock_t,
             bool *successful_join_inout,
-            const int join_delay_secs) THROWS_NOTHING;
+            const int join_delay_secs,
+            const lane_request_t *lane_request) THROWS_NOTHING;
+
+        /* `handle_lane()` takes over from `handle()` once the handshake is done if the
+        TCP connection is an extra lane of an existing connection. It attaches the lane
+        to its `connection_t` and receives messages on it until either of them goes
+        away. */
+        join_result_t handle_lane(keepalive_tcp_conn_stream_t *c,
+            const peer_id_t &other_id,
+            size_t lane_index,
+            const uuid_u &connection_id,
+            bool connection_id_is_remote,
+            cluster_compression_t send_compression,
+            auto_drainer_t::lock_t,
+            const int join_delay_secs,
+            const char *peername) THROWS_NOTHING;
+
+        /* Reads messages off `c` and passes them to the message handlers until the
+        connection is closed or sends us something invalid. `c` is one of the lanes of
+        `connection`, and `connection_keepalive` is a lock on its drainer for the
+        current thread. */
+        void read_messages(keepalive_tcp_conn_stream_t *c,
+                           connection_t *connection,
+                           const auto_drainer_t::lock_t &connection_keepalive)
+            THROWS_ONLY(fake_archive_exc_t);
 
         connectivity_cluster_t *parent;
 
@@ -298,6 +405,14 @@ public:
 
         tls_ctx_t *tls_ctx;
 
+        /* How we'd like to compress the messages we send. We only do it on connections
+        to servers that can decompress them. */
+        cluster_compression_t compression;
+
+        /* How many TCP connections we'd like to have to each peer. We get the smaller
+        of this and the number the peer asks for. */
+        int connections_per_peer;
+
         /* `attempt_table` is a table of all the host:port pairs we're currently
         trying to connect to or have connected to. If we are told to connect to
         an address already in this table, we'll just ignore it. That's important
@@ -436,6 +551,13 @@ protected:
                                   auto_drainer_t::lock_t keepalive,
                                   std::vector<char> &&data);
 
+    /* Returns true if the handler doesn't depend on its messages arriving in the order
+    they were sent. Only those messages are spread over several TCP connections when
+    there is more than one connection to a peer. */
+    virtual bool allows_reordering() const {
+        return false;
+    }
+
 private:
     friend class connectivity_cluster_t;
     connectivity_cluster_t *connectivity_cluster;
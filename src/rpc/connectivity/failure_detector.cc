@@ -0,0 +1,48 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rpc/connectivity/failure_detector.hpp"
+
+#include <math.h>
+
+#include <algorithm>
+
+phi_accrual_detector_t::phi_accrual_detector_t(size_t _max_intervals,
+                                               double _min_stddev) :
+    max_intervals(_max_intervals),
+    min_stddev(_min_stddev),
+    sum(0),
+    sum_of_squares(0) {
+    guarantee(max_intervals > 0);
+    guarantee(min_stddev > 0);
+}
+
+void phi_accrual_detector_t::add_interval(double interval) {
+    if (intervals.size() == max_intervals) {
+        sum -= intervals.front();
+        sum_of_squares -= intervals.front() * intervals.front();
+        intervals.pop_front();
+    }
+    intervals.push_back(interval);
+    sum += interval;
+    sum_of_squares += interval * interval;
+}
+
+void phi_accrual_detector_t::reset() {
+    intervals.clear();
+    sum = 0;
+    sum_of_squares = 0;
+}
+
+double phi_accrual_detector_t::phi(double elapsed) const {
+    guarantee(!intervals.empty());
+    double n = static_cast<double>(intervals.size());
+    double mean = sum / n;
+    /* Rounding errors in the running sums can make the variance slightly negative. */
+    double variance = std::max(0.0, sum_of_squares / n - mean * mean);
+    double stddev = std::max(min_stddev, sqrt(variance));
+
+    /* We model the intervals as normally distributed. This is the probability that a
+    live peer stays silent for at least `elapsed`. If it underflows to zero, `phi` is
+    infinite, which is what we want. */
+    double p_later = 0.5 * erfc((elapsed - mean) / (stddev * M_SQRT2));
+    return -log10(p_later);
+}
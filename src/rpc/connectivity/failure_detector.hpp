@@ -0,0 +1,45 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RPC_CONNECTIVITY_FAILURE_DETECTOR_HPP_
+#define RPC_CONNECTIVITY_FAILURE_DETECTOR_HPP_
+
+#include <stddef.h>
+
+#include <deque>
+
+#include "errors.hpp"
+
+/* `phi_accrual_detector_t` is an accrual failure detector in the style of Hayashibara
+et al. It remembers the last few intervals between arrivals from a peer and, given how
+long it's been since the last arrival, computes `phi`, which is `-log10()` of the
+probability that a live peer would have been silent for that long. A connection whose
+traffic usually arrives like clockwork is suspected quickly, while one whose traffic is
+irregular (for example because the peer is under load) is given more slack.
+
+Intervals are in arbitrary units; `heartbeat_manager_t` counts timer ticks. */
+class phi_accrual_detector_t {
+public:
+    /* `min_stddev` keeps `phi` from blowing up when all of the recorded intervals are
+    the same. */
+    phi_accrual_detector_t(size_t max_intervals, double min_stddev);
+
+    void add_interval(double interval);
+
+    /* Forgets all of the recorded intervals. */
+    void reset();
+
+    size_t num_intervals() const { return intervals.size(); }
+
+    /* Returns `phi` for a peer that's been silent for `elapsed`. Must not be called if
+    no intervals have been recorded. */
+    double phi(double elapsed) const;
+
+private:
+    size_t max_intervals;
+    double min_stddev;
+    std::deque<double> intervals;
+    double sum, sum_of_squares;
+
+    DISABLE_COPYING(phi_accrual_detector_t);
+};
+
+#endif  // RPC_CONNECTIVITY_FAILURE_DETECTOR_HPP_
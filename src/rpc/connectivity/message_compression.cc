@@ -0,0 +1,73 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rpc/connectivity/message_compression.hpp"
+
+#include <string.h>
+#include <zlib.h>
+
+#include "errors.hpp"
+
+uint8_t supported_cluster_compression_mask() {
+    return 1 << static_cast<int>(cluster_compression_t::zlib);
+}
+
+message_compressor_t::message_compressor_t() : stream(new z_stream) {
+    memset(stream.get(), 0, sizeof(z_stream));
+    // We trade some compression ratio for speed, because we compress on the
+    // connection's thread while holding its send mutex.
+    const int res = deflateInit(stream.get(), Z_BEST_SPEED);
+    guarantee(res == Z_OK, "deflateInit failed with error %d", res);
+}
+
+message_compressor_t::~message_compressor_t() {
+    deflateEnd(stream.get());
+}
+
+void message_compressor_t::compress(const char *data, size_t size,
+                                    std::vector<char> *out) {
+    stream->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+    stream->avail_in = size;
+    size_t out_size = out->size();
+    do {
+        // Compressed messages are usually smaller, so this is normally enough room
+        // for a single call to `deflate()`.
+        out->resize(out_size + size / 2 + 64);
+        stream->next_out = reinterpret_cast<Bytef *>(out->data() + out_size);
+        stream->avail_out = out->size() - out_size;
+        const int res = deflate(stream.get(), Z_SYNC_FLUSH);
+        guarantee(res == Z_OK || res == Z_BUF_ERROR,
+                  "deflate failed with error %d", res);
+        out_size = out->size() - stream->avail_out;
+        // If `deflate()` filled the output buffer, it may have more to write.
+    } while (stream->avail_out == 0);
+    guarantee(stream->avail_in == 0);
+    out->resize(out_size);
+}
+
+message_decompressor_t::message_decompressor_t() : stream(new z_stream) {
+    memset(stream.get(), 0, sizeof(z_stream));
+    const int res = inflateInit(stream.get());
+    guarantee(res == Z_OK, "inflateInit failed with error %d", res);
+}
+
+message_decompressor_t::~message_decompressor_t() {
+    inflateEnd(stream.get());
+}
+
+bool message_decompressor_t::decompress(const char *data, size_t size,
+                                        size_t uncompressed_size,
+                                        std::vector<char> *out) {
+    /* We leave room for one extra byte, so that `inflate()` doesn't stop before it
+    has consumed the empty block that ends a flushed message, and so that we notice
+    if the message is longer than it's supposed to be. */
+    out->resize(uncompressed_size + 1);
+    stream->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+    stream->avail_in = size;
+    stream->next_out = reinterpret_cast<Bytef *>(out->data());
+    stream->avail_out = out->size();
+    const int res = inflate(stream.get(), Z_SYNC_FLUSH);
+    if (res != Z_OK || stream->avail_in != 0 || stream->avail_out != 1) {
+        return false;
+    }
+    out->resize(uncompressed_size);
+    return true;
+}
@@ -0,0 +1,62 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RPC_CONNECTIVITY_MESSAGE_COMPRESSION_HPP_
+#define RPC_CONNECTIVITY_MESSAGE_COMPRESSION_HPP_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "containers/scoped.hpp"
+
+struct z_stream_s;
+
+/* Cluster connections can compress the messages that they send. Each side of the
+connection decides for itself whether to compress what it sends, but only uses a codec
+that the other side advertised during the handshake. */
+enum class cluster_compression_t {
+    none = 0,
+    zlib = 1
+};
+
+/* The set of codecs we can decompress, as a bit mask indexed by
+`cluster_compression_t`. It's sent in the cluster handshake. */
+uint8_t supported_cluster_compression_mask();
+
+/* `message_compressor_t` and `message_decompressor_t` are the two ends of a single
+compressed stream that lasts as long as the connection. Each message is flushed
+separately, so the receiver can decode it as soon as it arrives, but later messages
+still benefit from the earlier ones: repeated keys and field names compress well even
+when each message is small. This means that the decompressor must see every compressed
+message from the compressor, in order. */
+class message_compressor_t {
+public:
+    message_compressor_t();
+    ~message_compressor_t();
+
+    /* Appends the compressed form of the `size` bytes at `data` to `out`. */
+    void compress(const char *data, size_t size, std::vector<char> *out);
+
+private:
+    scoped_ptr_t<z_stream_s> stream;
+
+    DISABLE_COPYING(message_compressor_t);
+};
+
+class message_decompressor_t {
+public:
+    message_decompressor_t();
+    ~message_decompressor_t();
+
+    /* Decompresses one message produced by `message_compressor_t::compress()` into
+    `out`, which is resized to `uncompressed_size`. Returns false if the data is
+    corrupt or doesn't decompress to exactly `uncompressed_size` bytes. */
+    MUST_USE bool decompress(const char *data, size_t size, size_t uncompressed_size,
+                             std::vector<char> *out);
+
+private:
+    scoped_ptr_t<z_stream_s> stream;
+
+    DISABLE_COPYING(message_decompressor_t);
+};
+
+#endif  // RPC_CONNECTIVITY_MESSAGE_COMPRESSION_HPP_
@@ -2,11 +2,22 @@
 #ifndef RPC_DIRECTORY_WRITE_MAP_MANAGER_HPP_
 #define RPC_DIRECTORY_WRITE_MAP_MANAGER_HPP_
 
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/new_semaphore.hpp"
 #include "concurrency/watchable_map.hpp"
 #include "rpc/connectivity/cluster.hpp"
 
+/* When a key changes, we wait this long before sending it, so that other keys that
+change at about the same time go out in the same message. Each message carries at most
+`DIRECTORY_MAP_MAX_KEYS_PER_MESSAGE` key-value pairs. */
+#define DIRECTORY_MAP_BATCH_DELAY_MS 10
+#define DIRECTORY_MAP_MAX_KEYS_PER_MESSAGE 256
+
 template<class key_t, class value_t>
 class directory_map_write_manager_t {
 public:
@@ -21,7 +32,7 @@ private:
     for creating the `conn_info_t` and spawning the coroutine; the coroutine is
     responsible for stopping itself and removing the `conn_info_t`. The coroutine's job
     is to check for keys marked as dirty in `dirty_keys` and send those key-value pairs
-    over the network. */
+    over the network, several to a message. */
 
     class update_writer_t;
 
@@ -4,6 +4,7 @@
 
 #include "rpc/directory/map_write_manager.hpp"
 
+#include "arch/timing.hpp"
 #include "concurrency/wait_any.hpp"
 #include "containers/archive/optional.hpp"
 
@@ -42,17 +43,17 @@ class directory_map_write_manager_t<key_t, value_t>::update_writer_t :
 {
 public:
     update_writer_t(
-            uint64_t _timestamp, const key_t &_key, optional<value_t> &&_value) :
-        timestamp(_timestamp), key(_key), value(std::move(_value)) { }
+            uint64_t _timestamp,
+            std::vector<std::pair<key_t, optional<value_t> > > &&_updates) :
+        timestamp(_timestamp), updates(std::move(_updates)) { }
 
-    void write(write_stream_t *s) {
-        write_message_t wm;
-        serialize<cluster_version_t::CLUSTER>(&wm, timestamp);
-        serialize<cluster_version_t::CLUSTER>(&wm, key);
-        serialize<cluster_version_t::CLUSTER>(&wm, value);
-        int res = send_write_message(s, &wm);
-        if (res) {
-            throw fake_archive_exc_t();
+    void write(write_message_t *wm) {
+        serialize<cluster_version_t::CLUSTER>(wm, timestamp);
+        serialize<cluster_version_t::CLUSTER>(
+            wm, static_cast<uint64_t>(updates.size()));
+        for (const auto &update : updates) {
+            serialize<cluster_version_t::CLUSTER>(wm, update.first);
+            serialize<cluster_version_t::CLUSTER>(wm, update.second);
         }
     }
 
@@ -66,8 +67,7 @@ public:
 
 private:
     uint64_t timestamp;
-    key_t key;
-    optional<value_t> value;
+    std::vector<std::pair<key_t, optional<value_t> > > updates;
 };
 
 template<class key_t, class value_t>
@@ -99,31 +99,45 @@ void directory_map_write_manager_t<key_t, value_t>::stream_to_conn(
             connection_keepalive.get_drain_signal(),
             this_keepalive.get_drain_signal());
         while (true) {
-            /* Wait until there is at least one dirty key. */
+            /* Wait until there is at least one dirty key. Then wait a little longer,
+            because keys tend to change in bursts (for example when a server creates the
+            executions for all of its tables), and every key that changes in the
+            meantime can go out in the same message. */
             if (conns_entry->second.dirty_keys.empty()) {
-                cond_t pulse_on_dirty;
-                assignment_sentry_t<cond_t *> cond_sentry(
-                    &conns_entry->second.pulse_on_dirty,
-                    &pulse_on_dirty);
-                wait_interruptible(&pulse_on_dirty, &interruptor);
+                {
+                    cond_t pulse_on_dirty;
+                    assignment_sentry_t<cond_t *> cond_sentry(
+                        &conns_entry->second.pulse_on_dirty,
+                        &pulse_on_dirty);
+                    wait_interruptible(&pulse_on_dirty, &interruptor);
+                }
+                nap(DIRECTORY_MAP_BATCH_DELAY_MS, &interruptor);
             }
 
             /* Copy all dirty keys to a local variable, then iterate over that variable.
-            The naive approach would be to always send the first dirty key in
+            The naive approach would be to always send the first dirty keys in
             `conns_entry` until there are no dirty keys left; but that has starvation
             issues. */
             std::set<key_t> dirty_keys;
             std::swap(dirty_keys, conns_entry->second.dirty_keys);
-            for (const key_t &key : dirty_keys) {
+            auto it = dirty_keys.begin();
+            while (it != dirty_keys.end()) {
                 if (interruptor.is_pulsed()) {
                     throw interrupted_exc_t();
                 }
-                /* If the key changed again since we copied `dirty_keys`, we'll be
-                sending the newest value, because we didn't copy the value at the same
-                time as we copied `dirty_keys`. So it's OK to remove the key from
-                `dirty_keys` to prevent sending a redundant message. */
-                conns_entry->second.dirty_keys.erase(key);
-                update_writer_t writer(timestamp, key, value->get_key(key));
+                std::vector<std::pair<key_t, optional<value_t> > > updates;
+                for (; it != dirty_keys.end() &&
+                        updates.size() < static_cast<size_t>(
+                            DIRECTORY_MAP_MAX_KEYS_PER_MESSAGE);
+                     ++it) {
+                    /* If the key changed again since we copied `dirty_keys`, we'll be
+                    sending the newest value, because we didn't copy the value at the
+                    same time as we copied `dirty_keys`. So it's OK to remove the key
+                    from `dirty_keys` to prevent sending a redundant message. */
+                    conns_entry->second.dirty_keys.erase(*it);
+                    updates.push_back(std::make_pair(*it, value->get_key(*it)));
+                }
+                update_writer_t writer(timestamp, std::move(updates));
                 connectivity_cluster->send_message(
                     connection, connection_keepalive, message_tag, &writer);
             }
@@ -11,6 +11,7 @@
 #include "containers/archive/versioned.hpp"
 #include "concurrency/pmap.hpp"
 #include "logger.hpp"
+#include "perfmon/memory_usage.hpp"
 
 /* raw_mailbox_t */
 
@@ -74,30 +75,26 @@ public:
         subwriter(_subwriter) { }
     virtual ~raw_mailbox_writer_t() { }
 
-    void write(write_stream_t *stream) {
-        write_message_t wm;
+    void write(write_message_t *wm) {
         // Right now, we serialize this length/thread/mailbox information the same
         // way irrespective of version. (Serialization methods for primitive types
         // all behave the same way anyway -- this is just for performance, avoiding
         // unnecessary branching on cluster_version.)  See read_mailbox_header for
         // the deserialization.
-        serialize_universal(&wm, dest_thread);
-        serialize_universal(&wm, dest_mailbox_id);
-        uint64_t prefix_length = static_cast<uint64_t>(wm.size());
+        serialize_universal(wm, dest_thread);
+        serialize_universal(wm, dest_mailbox_id);
+        uint64_t prefix_length = static_cast<uint64_t>(wm->size());
 
-        subwriter->write(cluster_version_t::CLUSTER, &wm);
+        subwriter->write(cluster_version_t::CLUSTER, wm);
 
-        // Prepend the message length.
-        // TODO: It would be more efficient if we could make this part of `msg`.
-        //  e.g. with a `prepend()` method on write_message_t.
+        // Prepend the message length, which we only know now.
         write_message_t length_msg;
         serialize_universal(&length_msg,
-                            static_cast<uint64_t>(wm.size()) - prefix_length);
-
-        int res = send_write_message(stream, &length_msg);
-        if (res) { throw fake_archive_exc_t(); }
-        res = send_write_message(stream, &wm);
-        if (res) { throw fake_archive_exc_t(); }
+                            static_cast<uint64_t>(wm->size()) - prefix_length);
+        guarantee(length_msg.size() == sizeof(uint64_t));
+        char length_buf[sizeof(uint64_t)];
+        length_msg.copy_to(length_buf);
+        wm->prepend(length_buf, sizeof(length_buf));
     }
 
 #ifdef ENABLE_MESSAGE_PROFILER
@@ -251,6 +248,10 @@ void mailbox_manager_t::mailbox_read_coroutine(
         int64_t stream_data_offset,
         force_yield_t force_yield) {
 
+    // The buffer counts as `mailbox_buffers` memory until the message has been handled
+    memory_usage_tracker_t buffer_usage(memory_usage_category_t::MAILBOX_BUFFERS,
+                                        stream_data->capacity());
+
     // Construct a new stream to use
     vector_read_stream_t stream(std::move(*stream_data), stream_data_offset);
     stream_data = nullptr; // <- It is not safe to use `stream_data` anymore once we
@@ -177,6 +177,12 @@ private:
                           auto_drainer_t::lock_t connection_keepalive,
                           std::vector<char> &&data);
 
+    /* Mailbox messages are already handed to the destination thread out of order, so
+    they can be spread over several TCP connections. */
+    bool allows_reordering() const {
+        return true;
+    }
+
     enum force_yield_t {FORCE_YIELD, MAYBE_YIELD};
     void mailbox_read_coroutine(threadnum_t dest_thread,
                                 raw_mailbox_t::id_t dest_mailbox_id,
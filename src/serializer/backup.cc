@@ -0,0 +1,415 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "serializer/backup.hpp"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <vector>
+
+#include "arch/runtime/thread_pool.hpp"
+#include "concurrency/new_mutex.hpp"
+#include "concurrency/pmap.hpp"
+#include "config/args.hpp"
+#include "serializer/buf_ptr.hpp"
+#include "serializer/log/block_compression.hpp"
+#include "serializer/log/log_serializer.hpp"
+#include "serializer/serializer.hpp"
+
+namespace {
+
+const char BACKUP_MAGIC[16] = {
+    'r', 'e', 't', 'h', 'i', 'n', 'k', 'd', 'b', '-', 'b', 'l', 'o', 'c', 'k', 's' };
+const uint32_t BACKUP_FORMAT_VERSION = 1;
+
+ATTR_PACKED(struct backup_file_header_t {
+    char magic[16];
+    uint32_t version;
+    uint32_t max_block_size;
+});
+
+/* Each block is one of these followed by `stored_size` bytes. The end marker is one
+with a `block_id` of `NULL_BLOCK_ID`. */
+ATTR_PACKED(struct backup_block_header_t {
+    uint64_t block_id;
+    uint64_t recency;
+    uint32_t block_size;
+    // Smaller than `block_size` iff the block is compressed
+    uint32_t stored_size;
+});
+
+/* Buffers the backup file in memory, and reads or writes it a chunk at a time in the
+blocker pool. */
+class backup_file_t {
+public:
+    backup_file_t() : file(nullptr), read_offset(0) { }
+    ~backup_file_t() {
+        if (file != nullptr) {
+            thread_pool_t::run_in_blocker_pool([&]() { fclose(file); });
+        }
+    }
+
+    bool open(const std::string &_path, const char *mode, std::string *error_out) {
+        path = _path;
+        int error = 0;
+        thread_pool_t::run_in_blocker_pool([&]() {
+            file = fopen(path.c_str(), mode);
+            error = (file == nullptr) ? get_errno() : 0;
+        });
+        if (file == nullptr) {
+            *error_out = strprintf("Could not open `%s`: %s",
+                                   path.c_str(), errno_string(error).c_str());
+            return false;
+        }
+        return true;
+    }
+
+    void append(const void *data, size_t size) {
+        const char *chars = static_cast<const char *>(data);
+        buffer.insert(buffer.end(), chars, chars + size);
+    }
+
+    bool flush_if_full(std::string *error_out) {
+        return buffer.size() < BACKUP_WRITE_CHUNK_SIZE || flush(error_out);
+    }
+
+    /* Flushes the buffer and makes the file durable. */
+    bool finish_writing(std::string *error_out) {
+        if (!flush(error_out)) {
+            return false;
+        }
+        int error = 0;
+        thread_pool_t::run_in_blocker_pool([&]() {
+            if (fflush(file) != 0) {
+                error = get_errno();
+#ifndef _WIN32
+            } else if (fsync(fileno(file)) != 0) {
+                error = get_errno();
+#endif
+            }
+        });
+        if (error != 0) {
+            *error_out = strprintf("Could not write to `%s`: %s",
+                                   path.c_str(), errno_string(error).c_str());
+            return false;
+        }
+        return true;
+    }
+
+    /* Returns false if the file ends first. */
+    bool read(void *data, size_t size, std::string *error_out) {
+        char *out = static_cast<char *>(data);
+        while (size > 0) {
+            if (read_offset == buffer.size()) {
+                if (!refill(error_out)) {
+                    return false;
+                }
+            }
+            size_t n = std::min(size, buffer.size() - read_offset);
+            memcpy(out, buffer.data() + read_offset, n);
+            read_offset += n;
+            out += n;
+            size -= n;
+        }
+        return true;
+    }
+
+private:
+    bool flush(std::string *error_out) {
+        if (buffer.empty()) {
+            return true;
+        }
+        size_t written;
+        int error = 0;
+        thread_pool_t::run_in_blocker_pool([&]() {
+            written = fwrite(buffer.data(), 1, buffer.size(), file);
+            error = (written != buffer.size()) ? get_errno() : 0;
+        });
+        if (written != buffer.size()) {
+            *error_out = strprintf("Could not write to `%s`: %s",
+                                   path.c_str(), errno_string(error).c_str());
+            return false;
+        }
+        buffer.clear();
+        return true;
+    }
+
+    bool refill(std::string *error_out) {
+        buffer.resize(BACKUP_WRITE_CHUNK_SIZE);
+        size_t size_read;
+        int error = 0;
+        thread_pool_t::run_in_blocker_pool([&]() {
+            size_read = fread(buffer.data(), 1, buffer.size(), file);
+            error = ferror(file) ? get_errno() : 0;
+        });
+        buffer.resize(size_read);
+        read_offset = 0;
+        if (error != 0) {
+            *error_out = strprintf("Could not read `%s`: %s",
+                                   path.c_str(), errno_string(error).c_str());
+            return false;
+        } else if (size_read == 0) {
+            *error_out = strprintf("The backup `%s` is incomplete.", path.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    std::string path;
+    FILE *file;
+    std::vector<char> buffer;
+    size_t read_offset;
+
+    DISABLE_COPYING(backup_file_t);
+};
+
+void append_block(backup_file_t *file,
+                  block_id_t block_id,
+                  repli_timestamp_t recency,
+                  buf_ptr_t *buf,
+                  bool compress) {
+    const ser_buffer_t *data = buf->ser_buffer();
+    block_size_t stored_size = buf->block_size();
+    scoped_device_block_aligned_ptr_t<ser_buffer_t> compressed;
+    if (compress && compress_block(block_compression_t::zlib, buf->ser_buffer(),
+                                   buf->block_size(), &compressed, &stored_size)) {
+        data = compressed.get();
+    }
+
+    backup_block_header_t header;
+    header.block_id = block_id;
+    header.recency = recency.longtime;
+    header.block_size = buf->block_size().ser_value();
+    header.stored_size = stored_size.ser_value();
+    file->append(&header, sizeof(header));
+    file->append(data, stored_size.ser_value());
+}
+
+void write_blocks(serializer_t *serializer,
+                  file_account_t *io_account,
+                  const std::vector<block_id_t> &block_ids,
+                  const std::vector<repli_timestamp_t> &recencies,
+                  std::vector<buf_ptr_t> *bufs) {
+    std::vector<buf_write_info_t> infos;
+    infos.reserve(bufs->size());
+    for (size_t i = 0; i < bufs->size(); ++i) {
+        infos.push_back(buf_write_info_t(
+            (*bufs)[i].ser_buffer(), (*bufs)[i].block_size(), block_ids[i]));
+    }
+
+    struct : public iocallback_t, public cond_t {
+        void on_io_complete() {
+            pulse();
+        }
+    } cb;
+    std::vector<counted_t<block_token_t> > tokens
+        = serializer->block_writes(infos.data(), infos.size(), io_account, &cb);
+    cb.wait();
+
+    std::vector<index_write_op_t> write_ops;
+    write_ops.reserve(tokens.size());
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        // Aux blocks don't have a recency.
+        write_ops.push_back(index_write_op_t(
+            block_ids[i],
+            make_optional(tokens[i]),
+            is_aux_block_id(block_ids[i])
+                ? optional<repli_timestamp_t>()
+                : make_optional(recencies[i])));
+    }
+    // The restore is the only writer, so there is nothing to order the writes with.
+    new_mutex_in_line_t dummy_acq;
+    serializer->index_write(&dummy_acq, []() { }, write_ops);
+}
+
+}  // namespace
+
+bool write_serializer_backup(serializer_t *serializer,
+                             const std::string &path,
+                             bool compress,
+                             signal_t *interruptor,
+                             std::string *error_out) THROWS_ONLY(interrupted_exc_t) {
+    serializer->assert_thread();
+
+    /* The backup is written under another name, so that an incomplete backup never
+    replaces a complete one. */
+    const std::string temporary_path = path + ".tmp";
+    bool success = false;
+    {
+        backup_file_t file;
+        if (!file.open(temporary_path, "wb", error_out)) {
+            return false;
+        }
+        try {
+            scoped_ptr_t<file_account_t> io_account(serializer->make_io_account(
+                io_class_t::BACKUP, BACKUP_IO_PRIORITY));
+            scoped_ptr_t<serializer_snapshot_t> snapshot = serializer->make_snapshot();
+
+            backup_file_header_t header;
+            memcpy(header.magic, BACKUP_MAGIC, sizeof(header.magic));
+            header.version = BACKUP_FORMAT_VERSION;
+            header.max_block_size = serializer->max_block_size().ser_value();
+            file.append(&header, sizeof(header));
+
+            std::vector<block_id_t> block_ids;
+            std::vector<repli_timestamp_t> recencies;
+            std::vector<counted_t<block_token_t> > tokens;
+            std::vector<buf_ptr_t> bufs;
+            bool more = true;
+            while (more) {
+                block_ids.clear();
+                recencies.clear();
+                tokens.clear();
+                while (block_ids.size() < BACKUP_READ_BATCH_SIZE) {
+                    block_id_t block_id;
+                    repli_timestamp_t recency;
+                    counted_t<block_token_t> token;
+                    if (!snapshot->next_block(&block_id, &recency, &token)) {
+                        more = false;
+                        break;
+                    }
+                    block_ids.push_back(block_id);
+                    recencies.push_back(recency);
+                    tokens.push_back(std::move(token));
+                }
+
+                bufs.clear();
+                bufs.resize(tokens.size());
+                pmap(tokens.size(), [&](int64_t i) {
+                    bufs[i] = serializer->block_read(tokens[i], io_account.get());
+                });
+                for (size_t i = 0; i < bufs.size(); ++i) {
+                    append_block(&file, block_ids[i], recencies[i], &bufs[i], compress);
+                }
+                if (!file.flush_if_full(error_out)) {
+                    break;
+                }
+                if (interruptor->is_pulsed()) {
+                    throw interrupted_exc_t();
+                }
+            }
+
+            if (!more) {
+                backup_block_header_t end_marker;
+                memset(&end_marker, 0, sizeof(end_marker));
+                end_marker.block_id = NULL_BLOCK_ID;
+                file.append(&end_marker, sizeof(end_marker));
+                success = file.finish_writing(error_out);
+            }
+        } catch (const interrupted_exc_t &) {
+            thread_pool_t::run_in_blocker_pool([&]() {
+                ::remove(temporary_path.c_str());
+            });
+            throw;
+        }
+    }
+
+    int error = 0;
+    thread_pool_t::run_in_blocker_pool([&]() {
+        if (!success) {
+            ::remove(temporary_path.c_str());
+        } else if (::rename(temporary_path.c_str(), path.c_str()) != 0) {
+            error = get_errno();
+            ::remove(temporary_path.c_str());
+        }
+    });
+    if (error != 0) {
+        *error_out = strprintf("Could not move the backup to `%s`: %s",
+                               path.c_str(), errno_string(error).c_str());
+        return false;
+    }
+    return success;
+}
+
+bool restore_serializer_backup(const std::string &path,
+                               serializer_t *serializer,
+                               signal_t *interruptor,
+                               std::string *error_out) THROWS_ONLY(interrupted_exc_t) {
+    serializer->assert_thread();
+
+    backup_file_t file;
+    if (!file.open(path, "rb", error_out)) {
+        return false;
+    }
+
+    backup_file_header_t header;
+    if (!file.read(&header, sizeof(header), error_out)) {
+        return false;
+    }
+    if (memcmp(header.magic, BACKUP_MAGIC, sizeof(header.magic)) != 0
+        || header.version != BACKUP_FORMAT_VERSION) {
+        *error_out = strprintf("`%s` isn't a block backup.", path.c_str());
+        return false;
+    }
+    const uint32_t max_block_size = serializer->max_block_size().ser_value();
+    if (header.max_block_size != max_block_size) {
+        *error_out = strprintf("The backup `%s` has a block size of %" PRIu32 " bytes, "
+                               "but the data file has a block size of %" PRIu32 ".",
+                               path.c_str(), header.max_block_size, max_block_size);
+        return false;
+    }
+
+    scoped_ptr_t<file_account_t> io_account(serializer->make_io_account(
+        io_class_t::BACKUP, BACKUP_IO_PRIORITY));
+
+    std::vector<block_id_t> block_ids;
+    std::vector<repli_timestamp_t> recencies;
+    std::vector<buf_ptr_t> bufs;
+    std::vector<char> stored;
+    for (;;) {
+        backup_block_header_t block_header;
+        if (!file.read(&block_header, sizeof(block_header), error_out)) {
+            return false;
+        }
+        if (block_header.block_id == NULL_BLOCK_ID) {
+            break;
+        }
+        if (block_header.block_size == 0
+            || block_header.block_size > max_block_size
+            || block_header.stored_size == 0
+            || block_header.stored_size > block_header.block_size) {
+            *error_out = strprintf("The backup `%s` is corrupted.", path.c_str());
+            return false;
+        }
+
+        const block_size_t block_size = block_size_t::unsafe_make(
+            block_header.block_size);
+        buf_ptr_t buf = buf_ptr_t::alloc_uninitialized(block_size);
+        if (block_header.stored_size == block_header.block_size) {
+            if (!file.read(buf.ser_buffer(), block_header.block_size, error_out)) {
+                return false;
+            }
+        } else {
+            stored.resize(block_header.stored_size);
+            if (!file.read(stored.data(), stored.size(), error_out)) {
+                return false;
+            }
+            unpack_disk_block(
+                reinterpret_cast<const ser_buffer_t *>(stored.data()),
+                block_size_t::unsafe_make(block_header.stored_size),
+                block_size,
+                buf.ser_buffer());
+        }
+
+        block_ids.push_back(block_header.block_id);
+        recencies.push_back(repli_timestamp_t{block_header.recency});
+        bufs.push_back(std::move(buf));
+        if (bufs.size() == BACKUP_READ_BATCH_SIZE) {
+            write_blocks(serializer, io_account.get(), block_ids, recencies, &bufs);
+            block_ids.clear();
+            recencies.clear();
+            bufs.clear();
+            if (interruptor->is_pulsed()) {
+                throw interrupted_exc_t();
+            }
+        }
+    }
+    if (!bufs.empty()) {
+        write_blocks(serializer, io_account.get(), block_ids, recencies, &bufs);
+    }
+    return true;
+}
@@ -0,0 +1,41 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef SERIALIZER_BACKUP_HPP_
+#define SERIALIZER_BACKUP_HPP_
+
+#include <string>
+
+#include "concurrency/interruptor.hpp"
+
+class serializer_t;
+
+/* A block backup is a copy of the blocks of a serializer file as they were at one point
+in time, made while the serializer keeps being used (see `serializer_snapshot_t`). Since
+every index write is atomic, the blocks are in a state that the serializer could have
+been left in by a crash, which the btrees on top of it already know how to come back
+from. Making a backup doesn't go through the cache or ReQL, so it costs little more
+than reading the blocks from disk.
+
+The backup file holds a header, then each block in order of block id, and then an end
+marker, so that a backup that was cut short isn't mistaken for a complete one. The
+blocks can be compressed, with the same codec as the blocks in the data files. */
+
+/* Writes a backup of `serializer`'s blocks to the file at `path`, which is replaced
+only once the backup is complete. Must be called on the serializer's thread. Returns
+false and sets `*error_out` if the file can't be written. */
+bool write_serializer_backup(serializer_t *serializer,
+                             const std::string &path,
+                             bool compress,
+                             signal_t *interruptor,
+                             std::string *error_out)
+    THROWS_ONLY(interrupted_exc_t);
+
+/* Writes the blocks of the backup at `path` into `serializer`, which must have just
+been created and have the same block size. Must be called on the serializer's thread.
+Returns false and sets `*error_out` if the backup can't be read or is incomplete. */
+bool restore_serializer_backup(const std::string &path,
+                               serializer_t *serializer,
+                               signal_t *interruptor,
+                               std::string *error_out)
+    THROWS_ONLY(interrupted_exc_t);
+
+#endif  // SERIALIZER_BACKUP_HPP_
@@ -0,0 +1,92 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "serializer/block_buffer_pool.hpp"
+
+#include <utility>
+#include <vector>
+
+#include "arch/runtime/runtime.hpp"
+#include "config/args.hpp"
+#include "math.hpp"
+#include "thread_local.hpp"
+
+class block_buffer_stash_t {
+public:
+    block_buffer_stash_t() : stashed_bytes(0) { }
+
+    scoped_device_block_aligned_ptr_t<ser_buffer_t> take(size_t aligned_size) {
+        std::vector<scoped_device_block_aligned_ptr_t<ser_buffer_t> > *bufs =
+            &stash[size_class(aligned_size)];
+        if (bufs->empty()) {
+            return scoped_device_block_aligned_ptr_t<ser_buffer_t>(aligned_size);
+        }
+        scoped_device_block_aligned_ptr_t<ser_buffer_t> ret = std::move(bufs->back());
+        bufs->pop_back();
+        stashed_bytes -= aligned_size;
+        return ret;
+    }
+
+    void give_back(scoped_device_block_aligned_ptr_t<ser_buffer_t> &&buf,
+                   size_t aligned_size) {
+        if (stashed_bytes + aligned_size > BLOCK_BUFFER_POOL_SIZE) {
+            // The stash is full, so `buf` just gets freed.
+            return;
+        }
+        stash[size_class(aligned_size)].push_back(std::move(buf));
+        stashed_bytes += aligned_size;
+    }
+
+private:
+    static size_t size_class(size_t aligned_size) {
+        return aligned_size / DEVICE_BLOCK_SIZE - 1;
+    }
+
+    std::vector<scoped_device_block_aligned_ptr_t<ser_buffer_t> >
+        stash[MAX_POOLED_BLOCK_BUFFER_SIZE / DEVICE_BLOCK_SIZE];
+    size_t stashed_bytes;
+
+    DISABLE_COPYING(block_buffer_stash_t);
+};
+
+TLS_with_init(block_buffer_stash_t *, block_buffer_stash, nullptr);
+
+// Returns nullptr if we're not on a thread of the thread pool.
+static block_buffer_stash_t *get_block_buffer_stash() {
+    const int thread = get_thread_id().threadnum;
+    if (thread < 0 || thread >= MAX_THREADS) {
+        return nullptr;
+    }
+    // Constructed lazily, so it's constructed on the thread that uses it.
+    if (TLS_get_block_buffer_stash() == nullptr) {
+        TLS_set_block_buffer_stash(new block_buffer_stash_t());
+    }
+    return TLS_get_block_buffer_stash();
+}
+
+scoped_device_block_aligned_ptr_t<ser_buffer_t> take_block_buffer(size_t size) {
+    guarantee(size != 0);
+    const size_t aligned_size = ceil_aligned(size, DEVICE_BLOCK_SIZE);
+    block_buffer_stash_t *stash;
+    if (aligned_size > MAX_POOLED_BLOCK_BUFFER_SIZE
+        || (stash = get_block_buffer_stash()) == nullptr) {
+        return scoped_device_block_aligned_ptr_t<ser_buffer_t>(aligned_size);
+    }
+    return stash->take(aligned_size);
+}
+
+void give_back_block_buffer(scoped_device_block_aligned_ptr_t<ser_buffer_t> &&buf,
+                            size_t size) {
+    scoped_device_block_aligned_ptr_t<ser_buffer_t> local_buf(std::move(buf));
+    if (!local_buf.has()) {
+        return;
+    }
+    // Rounding down, since the buffer might not extend up to the next multiple of
+    // DEVICE_BLOCK_SIZE.
+    const size_t aligned_size = floor_aligned(size, DEVICE_BLOCK_SIZE);
+    block_buffer_stash_t *stash;
+    if (aligned_size == 0
+        || aligned_size > MAX_POOLED_BLOCK_BUFFER_SIZE
+        || (stash = get_block_buffer_stash()) == nullptr) {
+        return;
+    }
+    stash->give_back(std::move(local_buf), aligned_size);
+}
@@ -0,0 +1,28 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef SERIALIZER_BLOCK_BUFFER_POOL_HPP_
+#define SERIALIZER_BLOCK_BUFFER_POOL_HPP_
+
+#include <stddef.h>
+
+#include "containers/scoped.hpp"
+#include "serializer/types.hpp"
+
+/* Every block that is read from or written to the data file goes through a
+DEVICE_BLOCK_SIZE-aligned buffer, and those buffers are allocated and freed all the
+time. Instead of returning a freed buffer to the heap, the serializer and the page
+cache hand it back to the block buffer pool, which keeps it in a per-thread stash for
+its size (rounded up to DEVICE_BLOCK_SIZE). The next request for a buffer of that size
+on the same thread is served from the stash.
+
+Pooled buffers are ordinary `raw_malloc_device_block_aligned()` allocations, which come
+from the huge page arena with `--huge-pages`. A buffer from the pool
+can be freed normally, and any DEVICE_BLOCK_SIZE-aligned buffer can be given back to
+the pool, as long as it was allocated with at least `size` bytes. Buffers larger than
+MAX_POOLED_BLOCK_BUFFER_SIZE, and buffers used outside of the thread pool, bypass the
+pool. */
+
+scoped_device_block_aligned_ptr_t<ser_buffer_t> take_block_buffer(size_t size);
+void give_back_block_buffer(scoped_device_block_aligned_ptr_t<ser_buffer_t> &&buf,
+                            size_t size);
+
+#endif  // SERIALIZER_BLOCK_BUFFER_POOL_HPP_
@@ -3,16 +3,25 @@
 #include <algorithm>
 
 #include "math.hpp"
+#include "serializer/block_buffer_pool.hpp"
 
 buf_ptr_t buf_ptr_t::alloc_uninitialized(block_size_t size) {
     guarantee(size.ser_value() != 0);
     const size_t count = compute_aligned_block_size(size);
     buf_ptr_t ret;
     ret.block_size_ = size;
-    ret.ser_buffer_ = scoped_device_block_aligned_ptr_t<ser_buffer_t>(count);
+    ret.ser_buffer_ = take_block_buffer(count);
     return ret;
 }
 
+void buf_ptr_t::reset() {
+    if (ser_buffer_.has()) {
+        give_back_block_buffer(std::move(ser_buffer_),
+                               compute_aligned_block_size(block_size_));
+    }
+    block_size_ = block_size_t::undefined();
+}
+
 buf_ptr_t buf_ptr_t::alloc_zeroed(block_size_t size) {
     buf_ptr_t ret = alloc_uninitialized(size);
     char *buf = reinterpret_cast<char *>(ret.ser_buffer());
@@ -24,7 +33,7 @@ scoped_device_block_aligned_ptr_t<ser_buffer_t>
 help_allocate_copy(const ser_buffer_t *copyee, size_t amount_to_copy,
                    size_t reserved_size) {
     rassert(amount_to_copy <= reserved_size);
-    auto buf = scoped_device_block_aligned_ptr_t<ser_buffer_t>(reserved_size);
+    auto buf = take_block_buffer(reserved_size);
     memcpy(buf.get(), copyee, amount_to_copy);
     memset(reinterpret_cast<char *>(buf.get()) + amount_to_copy,
            0,
@@ -62,6 +71,7 @@ void buf_ptr_t::resize_fill_zero(block_size_t new_size) {
                                           new_size.ser_value()),
                                  new_reserved);
 
+        give_back_block_buffer(std::move(ser_buffer_), old_reserved);
         ser_buffer_ = std::move(buf);
     }
     block_size_ = new_size;
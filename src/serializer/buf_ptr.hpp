@@ -9,7 +9,8 @@
 #include "serializer/types.hpp"
 
 // Memory-aligned bufs.  This type also keeps the unused part of the buf (up to the
-// DEVICE_BLOCK_SIZE multiple) zeroed out.
+// DEVICE_BLOCK_SIZE multiple) zeroed out.  Buffers are taken from and given back to
+// the block buffer pool (see serializer/block_buffer_pool.hpp).
 
 // Note: This wastes 4 bytes of space on a 64-bit system.  (Arguably, it wastes more
 // than that given that block sizes could be 16 bits and pointers are really 48
@@ -31,6 +32,10 @@ public:
         guarantee(ser_buffer_.has());
     }
 
+    ~buf_ptr_t() {
+        reset();
+    }
+
     buf_ptr_t &operator=(buf_ptr_t &&movee) {
         buf_ptr_t tmp(std::move(movee));
         std::swap(block_size_, tmp.block_size_);
@@ -38,10 +43,8 @@ public:
         return *this;
     }
 
-    void reset() {
-        block_size_ = block_size_t::undefined();
-        ser_buffer_.reset();
-    }
+    // Hands the buffer (if any) back to the block buffer pool.
+    void reset();
 
     // Allocates a block, all of whose bytes are zeroed.
     static buf_ptr_t alloc_zeroed(block_size_t size);
@@ -0,0 +1,127 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "serializer/log/block_checksum.hpp"
+
+#include <inttypes.h>
+#include <string.h>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <nmmintrin.h>
+#define BLOCK_CHECKSUM_SSE42_ 1
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define BLOCK_CHECKSUM_ARM_CRC32_ 1
+#endif
+
+#include "errors.hpp"
+
+namespace {
+
+// The reflected CRC32C polynomial.
+const uint32_t CRC32C_POLYNOMIAL = 0x82f63b78;
+
+class crc32c_table_t {
+public:
+    crc32c_table_t() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc & 1) != 0 ? (crc >> 1) ^ CRC32C_POLYNOMIAL : crc >> 1;
+            }
+            entries[i] = crc;
+        }
+    }
+    uint32_t entries[256];
+};
+
+const crc32c_table_t crc32c_table;
+
+uint32_t crc32c_software(uint32_t crc, const uint8_t *data, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        crc = crc32c_table.entries[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#if defined(BLOCK_CHECKSUM_SSE42_)
+// We don't build with -msse4.2, so this is compiled for SSE 4.2 on its own and only
+// called if the CPU turns out to support it.
+__attribute__((target("sse4.2")))
+uint32_t crc32c_hardware(uint32_t crc, const uint8_t *data, size_t size) {
+    uint64_t crc64 = crc;
+    for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+        data += sizeof(uint64_t);
+    }
+    crc = static_cast<uint32_t>(crc64);
+    for (; size > 0; --size) {
+        crc = _mm_crc32_u8(crc, *data);
+        ++data;
+    }
+    return crc;
+}
+
+bool have_crc32c_hardware() {
+    static const bool res = (__builtin_cpu_init(), __builtin_cpu_supports("sse4.2"));
+    return res;
+}
+#elif defined(BLOCK_CHECKSUM_ARM_CRC32_)
+uint32_t crc32c_hardware(uint32_t crc, const uint8_t *data, size_t size) {
+    for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        crc = __crc32cd(crc, word);
+        data += sizeof(uint64_t);
+    }
+    for (; size > 0; --size) {
+        crc = __crc32cb(crc, *data);
+        ++data;
+    }
+    return crc;
+}
+
+bool have_crc32c_hardware() {
+    return true;
+}
+#else
+uint32_t crc32c_hardware(uint32_t, const uint8_t *, size_t) {
+    unreachable();
+}
+
+bool have_crc32c_hardware() {
+    return false;
+}
+#endif
+
+}  // namespace
+
+uint32_t crc32c(const void *data, size_t size) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    const uint32_t crc = have_crc32c_hardware()
+        ? crc32c_hardware(0xffffffff, bytes, size)
+        : crc32c_software(0xffffffff, bytes, size);
+    return ~crc;
+}
+
+uint32_t compute_block_checksum(const ser_buffer_t *disk_buf,
+                                block_size_t disk_block_size) {
+    const uint32_t crc = crc32c(disk_buf, disk_block_size.ser_value());
+    // A block whose CRC happens to be `NO_BLOCK_CHECKSUM` gets a slightly weaker
+    // checksum, instead of none at all.
+    return crc != NO_BLOCK_CHECKSUM ? crc : 1;
+}
+
+void check_block_checksum(const ser_buffer_t *disk_buf,
+                          block_size_t disk_block_size,
+                          uint32_t checksum,
+                          int64_t offset) {
+    if (checksum == NO_BLOCK_CHECKSUM) {
+        return;
+    }
+    const uint32_t actual = compute_block_checksum(disk_buf, disk_block_size);
+    guarantee(actual == checksum,
+              "Corrupted data block at offset %" PRIi64 " (block id %" PR_BLOCK_ID
+              ", checksum %08" PRIx32 " instead of %08" PRIx32 ").",
+              offset, disk_buf->ser_header.block_id, actual, checksum);
+}
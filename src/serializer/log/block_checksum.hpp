@@ -0,0 +1,35 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef SERIALIZER_LOG_BLOCK_CHECKSUM_HPP_
+#define SERIALIZER_LOG_BLOCK_CHECKSUM_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "serializer/types.hpp"
+
+/* Data blocks can optionally be checksummed.  The checksum is a CRC32C of the block
+as it is stored on disk (that is, after compression), and is kept in the block's LBA
+entry rather than in the block itself, so that a block that was written to the wrong
+place or not at all is detected too.  It's verified whenever the block is read from
+disk, including by read-ahead and the GC. */
+
+// The checksum of blocks that were written without one.
+static const uint32_t NO_BLOCK_CHECKSUM = 0;
+
+// The CRC32C (Castagnoli) of `size` bytes at `data`.  Uses the CPU's CRC32
+// instructions where they're available.
+uint32_t crc32c(const void *data, size_t size);
+
+// Returns the checksum to store for the block of `disk_block_size` bytes in
+// `disk_buf`.  Never returns `NO_BLOCK_CHECKSUM`.
+uint32_t compute_block_checksum(const ser_buffer_t *disk_buf,
+                                block_size_t disk_block_size);
+
+// Crashes if the block read from `offset` into `disk_buf` doesn't match `checksum`.
+// Does nothing if `checksum` is `NO_BLOCK_CHECKSUM`.
+void check_block_checksum(const ser_buffer_t *disk_buf,
+                          block_size_t disk_block_size,
+                          uint32_t checksum,
+                          int64_t offset);
+
+#endif  // SERIALIZER_LOG_BLOCK_CHECKSUM_HPP_
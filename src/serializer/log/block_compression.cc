@@ -0,0 +1,112 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include "serializer/log/block_compression.hpp"
+
+#include <string.h>
+#include <zlib.h>
+
+#include "config/args.hpp"
+#include "math.hpp"
+#include "serializer/block_buffer_pool.hpp"
+
+// The tag stored in the first byte after the `ls_buf_data_t` header of a compressed
+// block.  New codecs must use new values, since these are part of the disk format.
+enum class block_codec_tag_t : uint8_t {
+    zlib = 1
+};
+
+ATTR_PACKED(struct compressed_ser_buffer_t {
+    ls_buf_data_t ser_header;
+    block_codec_tag_t codec;
+    char payload[];
+});
+
+bool compress_block(block_compression_t compression,
+                    const ser_buffer_t *buf,
+                    block_size_t block_size,
+                    scoped_device_block_aligned_ptr_t<ser_buffer_t> *compressed_out,
+                    block_size_t *disk_block_size_out) {
+    switch (compression) {
+    case block_compression_t::none:
+        return false;
+    case block_compression_t::zlib:
+        break;
+    default:
+        unreachable();
+    }
+
+    const size_t aligned_size = ceil_aligned(block_size.ser_value(), DEVICE_BLOCK_SIZE);
+    if (aligned_size <= DEVICE_BLOCK_SIZE) {
+        // There's no device block to save.
+        return false;
+    }
+    // We only bother if we end up at least one device block smaller.
+    const size_t max_disk_size = aligned_size - DEVICE_BLOCK_SIZE;
+    const size_t header_size = offsetof(compressed_ser_buffer_t, payload);
+    if (max_disk_size <= header_size) {
+        return false;
+    }
+
+    scoped_device_block_aligned_ptr_t<ser_buffer_t> compressed
+        = take_block_buffer(max_disk_size);
+    compressed_ser_buffer_t *out
+        = reinterpret_cast<compressed_ser_buffer_t *>(compressed.get());
+
+    uLongf payload_size = max_disk_size - header_size;
+    const int res = compress2(reinterpret_cast<Bytef *>(out->payload),
+                              &payload_size,
+                              reinterpret_cast<const Bytef *>(buf->cache_data),
+                              block_size.value(),
+                              Z_BEST_SPEED);
+    if (res == Z_BUF_ERROR) {
+        // The block doesn't compress well enough.
+        give_back_block_buffer(std::move(compressed), max_disk_size);
+        return false;
+    }
+    guarantee(res == Z_OK, "compress2 failed with error %d", res);
+
+    out->ser_header = buf->ser_header;
+    out->codec = block_codec_tag_t::zlib;
+
+    const size_t disk_size = header_size + payload_size;
+    guarantee(disk_size <= max_disk_size);
+    memset(reinterpret_cast<char *>(out) + disk_size, 0, max_disk_size - disk_size);
+
+    *compressed_out = std::move(compressed);
+    *disk_block_size_out = block_size_t::unsafe_make(disk_size);
+    return true;
+}
+
+void unpack_disk_block(const ser_buffer_t *disk_buf,
+                       block_size_t disk_block_size,
+                       block_size_t block_size,
+                       ser_buffer_t *buf_out) {
+    if (disk_block_size == block_size) {
+        memcpy(buf_out, disk_buf, block_size.ser_value());
+        return;
+    }
+
+    const compressed_ser_buffer_t *in
+        = reinterpret_cast<const compressed_ser_buffer_t *>(disk_buf);
+    const size_t header_size = offsetof(compressed_ser_buffer_t, payload);
+    guarantee(disk_block_size.ser_value() > header_size);
+    guarantee(disk_block_size.ser_value() < block_size.ser_value());
+
+    buf_out->ser_header = in->ser_header;
+
+    switch (in->codec) {
+    case block_codec_tag_t::zlib: {
+        uLongf out_size = block_size.value();
+        const int res = uncompress(reinterpret_cast<Bytef *>(buf_out->cache_data),
+                                   &out_size,
+                                   reinterpret_cast<const Bytef *>(in->payload),
+                                   disk_block_size.ser_value() - header_size);
+        guarantee(res == Z_OK, "Corrupted data block (uncompress failed with error "
+                  "%d).", res);
+        guarantee(out_size == block_size.value(),
+                  "Corrupted data block (wrong uncompressed size).");
+    } break;
+    default:
+        crash("Corrupted data block (unknown compression codec %d).",
+              static_cast<int>(in->codec));
+    }
+}
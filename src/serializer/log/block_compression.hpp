@@ -0,0 +1,37 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#ifndef SERIALIZER_LOG_BLOCK_COMPRESSION_HPP_
+#define SERIALIZER_LOG_BLOCK_COMPRESSION_HPP_
+
+#include "containers/scoped.hpp"
+#include "serializer/types.hpp"
+
+/* Blocks written by the data block manager can optionally be stored compressed.  A
+compressed block keeps its `ls_buf_data_t` header uncompressed (so that read-ahead and
+GC can still identify the block), followed by a one-byte codec tag and the compressed
+cache data.  Whether a block is compressed is recorded in the LBA: its on-disk size
+differs from its (uncompressed) block size. */
+
+enum class block_compression_t {
+    none = 0,
+    zlib = 1
+};
+
+/* Compresses the block in `buf`, of size `block_size`, into a freshly allocated
+buffer that is zero-padded to DEVICE_BLOCK_SIZE.  Returns false, leaving the output
+parameters untouched, if compression is disabled or wouldn't save at least one device
+block on disk. */
+bool compress_block(block_compression_t compression,
+                    const ser_buffer_t *buf,
+                    block_size_t block_size,
+                    scoped_device_block_aligned_ptr_t<ser_buffer_t> *compressed_out,
+                    block_size_t *disk_block_size_out);
+
+/* Copies the block stored on disk in `disk_buf` into `buf_out`, decompressing it if
+`disk_block_size` differs from `block_size`.  `buf_out` must have room for
+`block_size` bytes. */
+void unpack_disk_block(const ser_buffer_t *disk_buf,
+                       block_size_t disk_block_size,
+                       block_size_t block_size,
+                       ser_buffer_t *buf_out);
+
+#endif  // SERIALIZER_LOG_BLOCK_COMPRESSION_HPP_
@@ -6,6 +6,7 @@
 
 #include "config/args.hpp"
 #include "containers/archive/archive.hpp"
+#include "serializer/log/block_compression.hpp"
 #include "serializer/types.hpp"
 #include "rpc/serialize_macros.hpp"
 
@@ -14,11 +15,30 @@
 struct log_serializer_dynamic_config_t {
     log_serializer_dynamic_config_t() {
         read_ahead = true;
+        compression = block_compression_t::none;
+        checksum_blocks = false;
+        gc_max_disk_queue_depth = 64;
     }
 
     /* Enable reading more data than requested to let the cache warmup more quickly
        esp. on rotational drives */
     bool read_ahead;
+
+    /* How newly written data blocks get compressed.  Compressed blocks are
+       self-describing through the LBA, so this can change from run to run; it only
+       affects blocks written from now on. */
+    block_compression_t compression;
+
+    /* Whether newly written data blocks get a CRC32C checksum, which is verified
+       whenever they're read from disk (see block_checksum.hpp).  Like compression,
+       checksums are recorded per block in the LBA, so this only affects blocks
+       written from now on. */
+    bool checksum_blocks;
+
+    /* While the garbage ratio is low enough for the GC to use its low priority i/o
+       account, the GC pauses between extents for as long as more than this many disk
+       requests are outstanding (for a limited time).  Zero disables the pauses. */
+    int64_t gc_max_disk_queue_depth;
 };
 
 /* This is equivalent to log_serializer_static_config_t below, but is an on-disk
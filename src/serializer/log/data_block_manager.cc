@@ -8,16 +8,22 @@
 
 #include "arch/arch.hpp"
 #include "arch/runtime/coroutines.hpp"
+#include "arch/timing.hpp"
 #include "concurrency/mutex.hpp"
 #include "concurrency/new_mutex.hpp"
 #include "errors.hpp"
+#include "perfmon/foreground_load.hpp"
 #include "perfmon/perfmon.hpp"
+#include "serializer/block_buffer_pool.hpp"
 #include "serializer/buf_ptr.hpp"
+#include "serializer/log/block_checksum.hpp"
+#include "serializer/log/block_compression.hpp"
 #include "serializer/log/log_serializer.hpp"
 #include "stl_utils.hpp"
 
-// Max amount of bytes which can be read ahead in one i/o transaction (if enabled)
-const int64_t APPROXIMATE_READ_AHEAD_SIZE = 32 * DEFAULT_BTREE_BLOCK_SIZE;
+// Max amount of blocks which can be read ahead in one i/o transaction (if enabled).
+// The actual amount of bytes depends on the block size of the file.
+const int64_t APPROXIMATE_READ_AHEAD_BLOCKS = 32;
 
 /*****************
  * GC Parameters *
@@ -46,6 +52,15 @@ constexpr double GC_STOP_RATIO = 0.05;
 // rate down.
 constexpr double GC_HIGH_RATIO = 0.3;
 
+// How many of the extents with the most garbage the GC compares before picking the
+// one to collect next.
+const size_t GC_VICTIM_CANDIDATES = 8;
+
+// How long the GC pauses at a time while there's a lot of foreground i/o, and how
+// many pauses it takes at most between two extents.
+const int64_t GC_BACKOFF_NAP_MS = 10;
+const int GC_MAX_BACKOFF_NAPS = 10;
+
 // What's the maximum number of "young" extents we can have?
 const size_t GC_YOUNG_EXTENT_MAX_SIZE = 50;
 // What's the definition of a "young" extent in microseconds?
@@ -453,8 +468,10 @@ void data_block_manager_t::start_existing(
         const dbm_metablock_mixin_t *last_metablock) {
     guarantee(state == state_unstarted);
     dbfile = file;
-    gc_io_account_nice.init(new file_account_t(file, GC_IO_PRIORITY_NICE));
-    gc_io_account_high.init(new file_account_t(file, GC_IO_PRIORITY_HIGH));
+    gc_io_account_nice.init(new file_account_t(file, io_class_t::DATA_GC,
+                                                  GC_IO_PRIORITY_NICE));
+    gc_io_account_high.init(new file_account_t(file, io_class_t::DATA_GC,
+                                                  GC_IO_PRIORITY_HIGH));
 
     /* Reconstruct the active data block extents from the metablock. */
     const int64_t offset = last_metablock->active_extent;
@@ -479,6 +496,7 @@ void data_block_manager_t::start_existing(
     } else {
         active_extent = nullptr;
     }
+    gc_active_extent = nullptr;
 
     /* Convert any extents that we found live blocks in, but that are not active
     extents, into old extents */
@@ -571,12 +589,13 @@ void read_ahead_interval(const int64_t block_offset,
 void read_ahead_offset_and_size(int64_t off_in,
                                 uint16_t ser_block_size_in,
                                 int64_t extent_size,
+                                int64_t read_ahead_size,
                                 const std::vector<uint32_t> &boundaries,
                                 int64_t *offset_out, int64_t *size_out) {
     int64_t offset;
     int64_t end_offset;
     read_ahead_interval(off_in, ser_block_size_in, extent_size,
-                        APPROXIMATE_READ_AHEAD_SIZE,
+                        read_ahead_size,
                         DEVICE_BLOCK_SIZE,
                         boundaries,
                         &offset,
@@ -599,8 +618,10 @@ public:
 
     static void perform_read_ahead(data_block_manager_t *const parent,
                                    const int64_t off_in,
-                                   const uint16_t ser_block_size_in,
-                                   void *const buf_out,
+                                   const block_size_t block_size_in,
+                                   const block_size_t disk_block_size_in,
+                                   const uint32_t checksum_in,
+                                   ser_buffer_t *const buf_out,
                                    file_account_t *const io_account,
                                    log_serializer_stats_t *const stats) {
         const std::vector<uint32_t> boundaries = get_boundaries(parent, off_in);
@@ -610,8 +631,10 @@ public:
 
         // Finish initialization.
         read_ahead_offset_and_size(off_in,
-                                   ser_block_size_in,
+                                   disk_block_size_in.ser_value(),
                                    parent->static_config->extent_size(),
+                                   APPROXIMATE_READ_AHEAD_BLOCKS
+                                       * parent->static_config->block_size_,
                                    boundaries,
                                    &read_ahead_offset,
                                    &read_ahead_size);
@@ -647,7 +670,10 @@ public:
             if (current_offset == off_in) {
                 guarantee(!handled_required_block);
 
-                memcpy(buf_out, current_buf, ser_block_size_in);
+                const ser_buffer_t *disk_buf
+                    = reinterpret_cast<const ser_buffer_t *>(current_buf);
+                check_block_checksum(disk_buf, disk_block_size_in, checksum_in, off_in);
+                unpack_disk_block(disk_buf, disk_block_size_in, block_size_in, buf_out);
                 handled_required_block = true;
             } else {
                 const block_id_t block_id
@@ -665,14 +691,23 @@ public:
 
                 const block_size_t block_size
                     = block_size_t::unsafe_make(info.ser_block_size);
+                const block_size_t disk_block_size
+                    = block_size_t::unsafe_make(info.disk_ser_block_size);
+                guarantee(info.disk_ser_block_size <= *(lower_it + 1) - *lower_it);
+                const ser_buffer_t *disk_buf
+                    = reinterpret_cast<const ser_buffer_t *>(current_buf);
+                check_block_checksum(disk_buf, disk_block_size, info.checksum,
+                                     current_offset);
                 buf_ptr_t buf = buf_ptr_t::alloc_uninitialized(block_size);
-                memcpy(buf.ser_buffer(), current_buf, info.ser_block_size);
+                unpack_disk_block(disk_buf, disk_block_size, block_size,
+                                  buf.ser_buffer());
                 buf.fill_padding_zero();
-                guarantee(info.ser_block_size <= *(lower_it + 1) - *lower_it);
 
                 counted_t<block_token_t> token
                     = parent->serializer->generate_block_token(current_offset,
-                                                               block_size);
+                                                               block_size,
+                                                               disk_block_size,
+                                                               info.checksum);
 
                 parent->serializer->offer_buf_to_read_ahead_callbacks(
                         block_id,
@@ -697,38 +732,48 @@ bool data_block_manager_t::should_perform_read_ahead(int64_t offset) {
 }
 
 buf_ptr_t data_block_manager_t::read(int64_t off_in, block_size_t block_size,
-                                   file_account_t *io_account) {
+                                     block_size_t disk_block_size,
+                                     uint32_t checksum,
+                                     file_account_t *io_account) {
     guarantee(state == state_ready);
     if (should_perform_read_ahead(off_in)) {
         buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(block_size);
-        dbm_read_ahead_t::perform_read_ahead(this, off_in, block_size.ser_value(),
-                                             ret.ser_buffer(), io_account, stats);
+        dbm_read_ahead_t::perform_read_ahead(this, off_in, block_size, disk_block_size,
+                                             checksum, ret.ser_buffer(), io_account,
+                                             stats);
         // We have to fill the padding with zero, since only the first part of the
         // buf got memcpy'd into.
         ret.fill_padding_zero();
         return ret;
     } else {
-        if (divides(DEVICE_BLOCK_SIZE, off_in)) {
+        if (divides(DEVICE_BLOCK_SIZE, off_in) && disk_block_size == block_size) {
             buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(block_size);
             co_read(dbfile, off_in, ret.aligned_block_size(),
                     ret.ser_buffer(), io_account);
             stats->bytes_read(ret.aligned_block_size());
+            check_block_checksum(ret.ser_buffer(), disk_block_size, checksum, off_in);
             // Blocks are written DEVICE_BLOCK_SIZE-aligned -- so the block on disk
             // should have been written with zero padding.
             ret.assert_padding_zero();
             return ret;
         } else {
+            // Either the block is unaligned or it's compressed, so we read it
+            // into a separate buffer first.
             int64_t floor_off_in = floor_aligned(off_in, DEVICE_BLOCK_SIZE);
-            int64_t ceil_off_end = ceil_aligned(off_in + block_size.ser_value(),
+            int64_t ceil_off_end = ceil_aligned(off_in + disk_block_size.ser_value(),
                                                 DEVICE_BLOCK_SIZE);
-            scoped_device_block_aligned_ptr_t<char> buf(ceil_off_end - floor_off_in);
+            scoped_device_block_aligned_ptr_t<ser_buffer_t> buf
+                = take_block_buffer(ceil_off_end - floor_off_in);
             co_read(dbfile, floor_off_in, ceil_off_end - floor_off_in,
                     buf.get(), io_account);
 
+            const ser_buffer_t *disk_buf = reinterpret_cast<const ser_buffer_t *>(
+                reinterpret_cast<const char *>(buf.get()) + (off_in - floor_off_in));
+            check_block_checksum(disk_buf, disk_block_size, checksum, off_in);
             buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(block_size);
-            memcpy(ret.ser_buffer(), buf.get() + (off_in - floor_off_in),
-                   block_size.ser_value());
-            stats->bytes_read(ret.aligned_block_size());
+            unpack_disk_block(disk_buf, disk_block_size, block_size, ret.ser_buffer());
+            give_back_block_buffer(std::move(buf), ceil_off_end - floor_off_in);
+            stats->bytes_read(ceil_off_end - floor_off_in);
             // We have to fill the padding to zero, in this case.
             ret.fill_padding_zero();
             return ret;
@@ -741,15 +786,57 @@ data_block_manager_t::many_writes(const buf_write_info_t *writes,
                                   size_t writes_count,
                                   file_account_t *io_account,
                                   iocallback_t *cb) {
-    // These tokens are grouped by extent.  You can do a contiguous write in each
-    // extent.
-    std::vector<std::vector<counted_t<block_token_t> > > token_groups
-        = gimme_some_new_offsets(writes, writes_count);
+    const block_compression_t compression = serializer->dynamic_config.compression;
+    const bool checksum_blocks = serializer->dynamic_config.checksum_blocks;
 
+    std::vector<disk_write_t> disk_writes;
+    disk_writes.reserve(writes_count);
+    std::vector<buf_ptr_t> compressed_bufs;
     for (size_t i = 0; i < writes_count; ++i) {
         writes[i].buf->ser_header.block_id = writes[i].block_id;
+
+        scoped_device_block_aligned_ptr_t<ser_buffer_t> compressed;
+        block_size_t disk_block_size = block_size_t::undefined();
+        if (compress_block(compression, writes[i].buf, writes[i].block_size,
+                           &compressed, &disk_block_size)) {
+            disk_writes.push_back(disk_write_t(
+                compressed.get(),
+                writes[i].block_size,
+                disk_block_size,
+                checksum_blocks
+                    ? compute_block_checksum(compressed.get(), disk_block_size)
+                    : NO_BLOCK_CHECKSUM));
+            // Wrapping the buffer into a `buf_ptr_t` hands it back to the block
+            // buffer pool once the write is done.
+            compressed_bufs.push_back(buf_ptr_t(disk_block_size, std::move(compressed)));
+            ++stats->pm_serializer_compressed_block_writes;
+        } else {
+            disk_writes.push_back(disk_write_t(
+                writes[i].buf,
+                writes[i].block_size,
+                writes[i].block_size,
+                checksum_blocks
+                    ? compute_block_checksum(writes[i].buf, writes[i].block_size)
+                    : NO_BLOCK_CHECKSUM));
+        }
     }
 
+    return write_disk_blocks(disk_writes, std::move(compressed_bufs), &active_extent,
+                             io_account, cb);
+}
+
+std::vector<counted_t<block_token_t> >
+data_block_manager_t::write_disk_blocks(
+        const std::vector<disk_write_t> &writes,
+        std::vector<buf_ptr_t> &&owned_bufs,
+        gc_entry_t **target_extent,
+        file_account_t *io_account,
+        iocallback_t *cb) {
+    // These tokens are grouped by extent.  You can do a contiguous write in each
+    // extent.
+    std::vector<std::vector<counted_t<block_token_t> > > token_groups
+        = gimme_some_new_offsets(writes, target_extent);
+
     struct intermediate_cb_t : public iocallback_t {
         virtual void on_io_complete() {
             --ops_remaining;
@@ -762,6 +849,8 @@ data_block_manager_t::many_writes(const buf_write_info_t *writes,
 
         size_t ops_remaining;
         iocallback_t *cb;
+        // Buffers that we must keep alive until the writes are done.
+        std::vector<buf_ptr_t> owned_bufs;
     };
 
     intermediate_cb_t *const intermediate_cb = new intermediate_cb_t;
@@ -769,13 +858,14 @@ data_block_manager_t::many_writes(const buf_write_info_t *writes,
     // intermediate_cb->on_io_complete later.
     intermediate_cb->ops_remaining = token_groups.size() + 1;
     intermediate_cb->cb = cb;
+    intermediate_cb->owned_bufs = std::move(owned_bufs);
 
     size_t write_number = 0;
     for (size_t i = 0; i < token_groups.size(); ++i) {
 
         const int64_t front_offset = token_groups[i].front()->offset();
         const int64_t back_offset = token_groups[i].back()->offset()
-            + gc_entry_t::aligned_value(token_groups[i].back()->block_size());
+            + gc_entry_t::aligned_value(token_groups[i].back()->disk_block_size());
 
         guarantee(divides(DEVICE_BLOCK_SIZE, front_offset));
 
@@ -788,14 +878,14 @@ data_block_manager_t::many_writes(const buf_write_info_t *writes,
 
         for (size_t j = 0; j < token_groups[i].size(); ++j) {
             const int64_t j_offset = token_groups[i][j]->offset();
-            const block_size_t j_block_size = token_groups[i][j]->block_size();
+            const block_size_t j_block_size = token_groups[i][j]->disk_block_size();
             guarantee(j_offset == last_written_offset);
             const size_t j_aligned_size = gc_entry_t::aligned_value(j_block_size);
             total_aligned_size += j_aligned_size;
 
             // The behavior of gimme_some_new_offsets is supposed to retain order, so
             // we expect writes[write_number] to have the currently-relevant write.
-            guarantee(writes[write_number].block_size == j_block_size);
+            guarantee(writes[write_number].disk_block_size == j_block_size);
 
             iovecs[j].iov_base = writes[write_number].buf;
             iovecs[j].iov_len = j_aligned_size;
@@ -817,7 +907,7 @@ data_block_manager_t::many_writes(const buf_write_info_t *writes,
     intermediate_cb->on_io_complete();
 
     std::vector<counted_t<block_token_t> > ret;
-    ret.reserve(writes_count);
+    ret.reserve(writes.size());
     for (auto it = token_groups.begin(); it != token_groups.end(); ++it) {
         for (auto jt = it->begin(); jt != it->end(); ++jt) {
             ret.push_back(std::move(*jt));
@@ -1024,6 +1114,10 @@ void data_block_manager_t::run_gc(gc_state_t *gc_state) {
            && !should_terminate_one_gc_thread()) {
         gc_one_extent(gc_state);
 
+        if (state != state_shutting_down) {
+            back_off_for_foreground_io();
+        }
+
         if (state == state_shutting_down) {
             active_gcs.remove(gc_state);
             gc_index_write_semaphore.set_capacity(
@@ -1041,6 +1135,62 @@ void data_block_manager_t::run_gc(gc_state_t *gc_state) {
     delete gc_state;
 }
 
+void data_block_manager_t::back_off_for_foreground_io() {
+    const int64_t max_queue_depth = serializer->dynamic_config.gc_max_disk_queue_depth;
+    if (max_queue_depth <= 0) {
+        return;
+    }
+    // Once the GC has switched to its high priority i/o account, keeping the
+    // garbage ratio in check is more important than not getting in the way.
+    for (int i = 0; i < GC_MAX_BACKOFF_NAPS; ++i) {
+        if (state == state_shutting_down
+            || garbage_ratio() > GC_HIGH_RATIO
+            || get_disk_queue_depth() <= max_queue_depth) {
+            break;
+        }
+        ++stats->pm_serializer_gc_backoffs;
+        nap(GC_BACKOFF_NAP_MS);
+    }
+}
+
+gc_entry_t *data_block_manager_t::pop_gc_victim() {
+    ASSERT_NO_CORO_WAITING;
+    guarantee(!gc_pq.empty());
+
+    // `gc_pq` is ordered by garbage bytes alone, because the order of the other
+    // criteria changes over time.  Among the extents with the most garbage, we pick
+    // the one where collecting gives the best return on the i/o it costs
+    // (the "cost-benefit" policy of log-structured file systems): freeing
+    // `1 - u` of the extent costs reading it and writing `u` of it back, and extents
+    // that have been around for longer are less likely to free up by themselves.
+    const kiloticks_t now = get_kiloticks();
+    const double extent_size = static_config->extent_size();
+    std::vector<gc_entry_t *> candidates;
+    gc_entry_t *best = nullptr;
+    double best_score = -1.0;
+    while (!gc_pq.empty() && candidates.size() < GC_VICTIM_CANDIDATES) {
+        gc_entry_t *entry = gc_pq.pop();
+        entry->our_pq_entry = nullptr;
+        candidates.push_back(entry);
+
+        const double live_fraction = 1.0 - entry->garbage_bytes() / extent_size;
+        const double age_secs = 1.0 + std::max<int64_t>(
+            0, now.micros - entry->timestamp.micros) / static_cast<double>(MILLION);
+        const double score = (1.0 - live_fraction) * age_secs / (1.0 + live_fraction);
+        if (score > best_score) {
+            best = entry;
+            best_score = score;
+        }
+    }
+
+    for (gc_entry_t *entry : candidates) {
+        if (entry != best) {
+            entry->our_pq_entry = gc_pq.push(entry);
+        }
+    }
+    return best;
+}
+
 void data_block_manager_t::gc_one_extent(gc_state_t *gc_state) {
     // A buffer for blocks we're transferring.
     scoped_device_block_aligned_ptr_t<char> gc_blocks;
@@ -1078,8 +1228,7 @@ void data_block_manager_t::gc_one_extent(gc_state_t *gc_state) {
         /* grab the entry */
         guarantee (!gc_pq.empty());
         guarantee(gc_state->current_entry == nullptr);
-        gc_state->current_entry = gc_pq.pop();
-        gc_state->current_entry->our_pq_entry = nullptr;
+        gc_state->current_entry = pop_gc_victim();
 
         guarantee(gc_state->current_entry->state == gc_entry_t::state_old);
         gc_state->current_entry->state = gc_entry_t::state_in_gc;
@@ -1190,8 +1339,17 @@ void data_block_manager_t::gc_one_extent(gc_state_t *gc_state) {
                     gc_state->current_entry->extent_ref.offset()
                     + gc_state->current_entry->relative_offset(i);
 
-                gc_writes.push_back(gc_write_t(block, block_offset,
-                    gc_state->current_entry->block_size(i)));
+                block_size_t block_size = block_size_t::undefined();
+                uint32_t checksum;
+                serializer->live_block_info(block->ser_header.block_id, block_offset,
+                                            &block_size, &checksum);
+                const block_size_t disk_block_size
+                    = gc_state->current_entry->block_size(i);
+                // The block is moved along with its checksum, so it had better
+                // match.
+                check_block_checksum(block, disk_block_size, checksum, block_offset);
+                gc_writes.push_back(gc_write_t(block, block_offset, block_size,
+                                               disk_block_size, checksum));
             }
             guarantee(gc_writes.size() == num_writes);
         }
@@ -1248,21 +1406,32 @@ void data_block_manager_t::write_gcs(
         // Step 1: Write buffers to disk and assemble index operations
         ASSERT_NO_CORO_WAITING;
 
-        std::vector<buf_write_info_t> the_writes;
+        // Compressed blocks get moved as they are, so we don't go through
+        // `many_writes`.
+        std::vector<disk_write_t> the_writes;
         the_writes.reserve(writes.size());
+        size_t total_aligned_size = 0;
         for (size_t i = 0; i < writes.size(); ++i) {
             old_block_tokens.push_back(
                     serializer->generate_block_token(writes[i].old_offset,
-                                                     writes[i].block_size));
-
-            the_writes.push_back(buf_write_info_t(writes[i].buf,
-                                                  writes[i].block_size,
-                                                  writes[i].buf->ser_header.block_id));
+                                                     writes[i].block_size,
+                                                     writes[i].disk_block_size,
+                                                     writes[i].checksum));
+
+            the_writes.push_back(disk_write_t(writes[i].buf,
+                                              writes[i].block_size,
+                                              writes[i].disk_block_size,
+                                              writes[i].checksum));
+            total_aligned_size += gc_entry_t::aligned_value(writes[i].disk_block_size);
         }
+        stats->gc_bytes_written(total_aligned_size);
 
-        new_block_tokens = many_writes(the_writes.data(), the_writes.size(),
-                                       choose_gc_io_account(),
-                                       &block_write_cond);
+        new_block_tokens = write_disk_blocks(
+            the_writes,
+            std::vector<buf_ptr_t>(),
+            &gc_active_extent,
+            choose_gc_io_account(),
+            &block_write_cond);
 
         guarantee(new_block_tokens.size() == writes.size());
     }
@@ -1414,6 +1583,12 @@ void data_block_manager_t::actually_shutdown() {
         active_extent = nullptr;
     }
 
+    if (gc_active_extent != nullptr) {
+        UNUSED int64_t extent = gc_active_extent->extent_ref.release();
+        delete gc_active_extent;
+        gc_active_extent = nullptr;
+    }
+
     while (gc_entry_t *entry = young_extent_queue.head()) {
         young_extent_queue.remove(entry);
         UNUSED int64_t extent = entry->extent_ref.release();
@@ -1432,46 +1607,47 @@ void data_block_manager_t::actually_shutdown() {
 }
 
 std::vector<std::vector<counted_t<block_token_t> > >
-data_block_manager_t::gimme_some_new_offsets(const buf_write_info_t *writes,
-                                             size_t writes_count) {
+data_block_manager_t::gimme_some_new_offsets(const std::vector<disk_write_t> &writes,
+                                             gc_entry_t **target_extent) {
     ASSERT_NO_CORO_WAITING;
 
+    gc_entry_t *&active = *target_extent;
+
     // Start a new extent if necessary.
-    if (active_extent == nullptr) {
-        active_extent = new gc_entry_t(this);
+    if (active == nullptr) {
+        active = new gc_entry_t(this);
         ++stats->pm_serializer_data_extents_allocated;
     }
 
 
-    guarantee(active_extent->state == gc_entry_t::state_active);
+    guarantee(active->state == gc_entry_t::state_active);
 
     std::vector<std::vector<counted_t<block_token_t>>> ret;
 
     std::vector<counted_t<block_token_t> > tokens;
-    for (size_t i = 0; i < writes_count; ++i) {
-        block_size_t block_size = writes[i].block_size;
+    for (size_t i = 0; i < writes.size(); ++i) {
+        block_size_t block_size = writes[i].disk_block_size;
         uint32_t relative_offset = valgrind_undefined<uint32_t>(UINT32_MAX);
         unsigned int block_index = valgrind_undefined<unsigned int>(UINT_MAX);
-        if (!active_extent->new_offset(block_size,
-                                       &relative_offset, &block_index)) {
-            // Move the active_extent gc_entry_t to the young extent queue (if it's
+        if (!active->new_offset(block_size, &relative_offset, &block_index)) {
+            // Move the active gc_entry_t to the young extent queue (if it's
             // not already empty), and make a new gc_entry_t.
-            if (active_extent->num_live_blocks() == 0) {
-                gc_entry_t *old_active_extent = active_extent;
-                active_extent = new gc_entry_t(this);
-                destroy_entry(old_active_extent);
+            if (active->num_live_blocks() == 0) {
+                gc_entry_t *old_active = active;
+                active = new gc_entry_t(this);
+                destroy_entry(old_active);
             } else {
-                active_extent->state = gc_entry_t::state_young;
-                active_extent->shrink_to_fit();
-                young_extent_queue.push_back(active_extent);
+                active->state = gc_entry_t::state_young;
+                active->shrink_to_fit();
+                young_extent_queue.push_back(active);
                 mark_unyoung_entries();
-                active_extent = new gc_entry_t(this);
+                active = new gc_entry_t(this);
             }
 
             ++stats->pm_serializer_data_extents_allocated;
-            const bool succeeded = active_extent->new_offset(block_size,
-                                                             &relative_offset,
-                                                             &block_index);
+            const bool succeeded = active->new_offset(block_size,
+                                                      &relative_offset,
+                                                      &block_index);
             guarantee(succeeded);
 
             // Push the current group of tokens, if it's nonempty, onto the return
@@ -1482,11 +1658,14 @@ data_block_manager_t::gimme_some_new_offsets(const buf_write_info_t *writes,
             }
         }
 
-        const int64_t offset = active_extent->extent_ref.offset() + relative_offset;
-        active_extent->was_written = true;
-        active_extent->mark_live_tokenwise(block_index);
+        const int64_t offset = active->extent_ref.offset() + relative_offset;
+        active->was_written = true;
+        active->mark_live_tokenwise(block_index);
 
-        tokens.push_back(serializer->generate_block_token(offset, block_size));
+        tokens.push_back(serializer->generate_block_token(offset,
+                                                          writes[i].block_size,
+                                                          block_size,
+                                                          writes[i].checksum));
     }
 
     if (!tokens.empty()) {
@@ -12,11 +12,11 @@
 #include "containers/scoped.hpp"
 #include "containers/two_level_array.hpp"
 #include "perfmon/types.hpp"
+#include "serializer/buf_ptr.hpp"
 #include "serializer/log/config.hpp"
 #include "serializer/log/extent_manager.hpp"
 #include "serializer/types.hpp"
 
-class buf_ptr_t;
 class log_serializer_t;
 class data_block_manager_t;
 class gc_entry_t;
@@ -48,7 +48,11 @@ public:
     static void prepare_initial_metablock(dbm_metablock_mixin_t *mb);
     void start_existing(file_t *dbfile, const dbm_metablock_mixin_t *last_metablock);
 
+    // `disk_block_size` is the size of the block on disk, which is smaller than
+    // `block_size` if the block is stored compressed.  The block is checked against
+    // `checksum` unless that's `NO_BLOCK_CHECKSUM`.
     buf_ptr_t read(int64_t off_in, block_size_t block_size,
+                   block_size_t disk_block_size, uint32_t checksum,
                    file_account_t *io_account);
 
     /* exposed gc api */
@@ -82,18 +86,46 @@ public:
     // ratio of garbage to blocks in the system
     double garbage_ratio() const;
 
+    // Compresses and checksums the blocks according to the serializer's dynamic
+    // config before writing them.
     std::vector<counted_t<block_token_t> >
     many_writes(const buf_write_info_t *writes,
                 size_t writes_count,
                 file_account_t *io_account,
                 iocallback_t *cb);
 
-    std::vector<std::vector<counted_t<block_token_t> > >
-    gimme_some_new_offsets(const buf_write_info_t *writes, size_t writes_count);
-
     bool is_gc_active() const;
 
 private:
+    // A block write as it gets laid out on disk.  `buf` holds `disk_block_size`
+    // bytes (zero-padded to DEVICE_BLOCK_SIZE), which is less than `block_size`
+    // iff the block is compressed.  `checksum` is that of the `disk_block_size`
+    // bytes, or `NO_BLOCK_CHECKSUM`.
+    struct disk_write_t {
+        disk_write_t(ser_buffer_t *_buf, block_size_t _block_size,
+                     block_size_t _disk_block_size, uint32_t _checksum)
+            : buf(_buf), block_size(_block_size),
+              disk_block_size(_disk_block_size), checksum(_checksum) { }
+        ser_buffer_t *buf;
+        block_size_t block_size;
+        block_size_t disk_block_size;
+        uint32_t checksum;
+    };
+
+    // Writes the blocks as they are, appending them to `*target_extent` (which is
+    // either `&active_extent` or `&gc_active_extent`).  `owned_bufs` are kept alive
+    // until the writes have completed.
+    std::vector<counted_t<block_token_t> >
+    write_disk_blocks(const std::vector<disk_write_t> &writes,
+                      std::vector<buf_ptr_t> &&owned_bufs,
+                      gc_entry_t **target_extent,
+                      file_account_t *io_account,
+                      iocallback_t *cb);
+
+    std::vector<std::vector<counted_t<block_token_t> > >
+    gimme_some_new_offsets(const std::vector<disk_write_t> &writes,
+                           gc_entry_t **target_extent);
+
     void actually_shutdown();
 
     struct gc_state_t : public intrusive_list_node_t<gc_state_t>{
@@ -112,10 +144,16 @@ private:
         ser_buffer_t *buf;
         int64_t old_offset;
         block_size_t block_size;
+        // The size of `buf`, which differs from `block_size` if the block is
+        // compressed.  The GC moves compressed blocks without decompressing them.
+        block_size_t disk_block_size;
+        uint32_t checksum;
         gc_write_t(ser_buffer_t *b, int64_t _old_offset,
-                   block_size_t _block_size)
+                   block_size_t _block_size, block_size_t _disk_block_size,
+                   uint32_t _checksum)
             : buf(b), old_offset(_old_offset),
-              block_size(_block_size) { }
+              block_size(_block_size), disk_block_size(_disk_block_size),
+              checksum(_checksum) { }
     };
 
     /* Runs in a coroutine and keeps calling `gc_one_extent()` for as long as
@@ -124,6 +162,13 @@ private:
 
     void gc_one_extent(gc_state_t *gc_state);
 
+    // Pauses for a bit while the disk is busy with foreground i/o, as configured by
+    // `log_serializer_dynamic_config_t::gc_max_disk_queue_depth`.
+    void back_off_for_foreground_io();
+
+    // Removes the extent that should be GCed next from `gc_pq` and returns it.
+    gc_entry_t *pop_gc_victim();
+
     void write_gcs(
         std::vector<gc_write_t> &&writes,
         gc_state_t *gc_state,
@@ -193,8 +238,16 @@ private:
     /* Contains every extent in the gc_entry_t::state_reconstructing state */
     intrusive_list_t<gc_entry_t> reconstructed_extents;
 
-    /* Contains the extent in the gc_entry_t::state_active state. */
+    /* The extents in the gc_entry_t::state_active state.  New blocks get appended to
+    `active_extent`, and blocks that the GC moves get appended to `gc_active_extent`.
+    Blocks that survived long enough to be moved by the GC are likely to stay alive
+    for a while longer, so keeping them apart from freshly written blocks (which
+    tend to get overwritten soon) means that the GC doesn't have to copy them again
+    out of extents that have been emptied by newer writes.  Only `active_extent` is
+    stored in the metablock; on startup `gc_active_extent` becomes an old extent like
+    any other. */
     gc_entry_t *active_extent;
+    gc_entry_t *gc_active_extent;
 
     /* Contains every extent in the gc_entry_t::state_young state */
     intrusive_list_t<gc_entry_t> young_extent_queue;
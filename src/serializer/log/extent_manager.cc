@@ -2,12 +2,19 @@
 #include "serializer/log/extent_manager.hpp"
 
 #include <queue>
+#include <set>
 
 #include "arch/arch.hpp"
 #include "logger.hpp"
 #include "math.hpp"
 #include "perfmon/perfmon.hpp"
 #include "serializer/log/log_serializer.hpp"
+#include "time.hpp"
+
+// How often we tell the storage about extents that have become free, and how many
+// extents we tell it about at most each time.
+const int64_t EXTENT_DISCARD_INTERVAL_SECS = 10;
+const size_t MAX_DISCARDED_EXTENTS_PER_ROUND = 256;
 
 struct extent_info_t {
 public:
@@ -71,6 +78,21 @@ class extent_zone_t {
     // The number of free extents in the file.
     size_t held_extents_;
 
+    // Free extents that the storage should be told about with `file_t::discard()`.
+    // Extents that get freed go into `recently_freed_extents` first, and get moved to
+    // `discard_queue` by the next round of discards, so that an extent gets discarded
+    // only if it hasn't been reused for an interval.  Extents that get reused or cut
+    // off the end of the file are removed from both.
+    std::set<size_t> recently_freed_extents;
+    std::set<size_t> discard_queue;
+    ticks_t last_discard_round;
+
+    void forget_freed_extents_from(size_t first_id) {
+        recently_freed_extents.erase(recently_freed_extents.lower_bound(first_id),
+                                     recently_freed_extents.end());
+        discard_queue.erase(discard_queue.lower_bound(first_id), discard_queue.end());
+    }
+
 public:
     size_t held_extents() const {
         return held_extents_;
@@ -78,7 +100,8 @@ public:
 
     extent_zone_t(file_t *_dbfile, uint64_t _extent_size,
                   log_serializer_stats_t *_stats)
-        : extent_size(_extent_size), dbfile(_dbfile), stats(_stats), held_extents_(0) {
+        : extent_size(_extent_size), dbfile(_dbfile), stats(_stats), held_extents_(0),
+          last_discard_round(get_ticks()) {
         // (Avoid a bunch of reallocations by resize calls (avoiding O(n log n)
         // work on average).)
         extents.reserve(dbfile->get_file_size() / extent_size);
@@ -108,6 +131,8 @@ public:
                 extents[extent_id].set_state(extent_info_t::state_free);
                 free_queue.push(extent_id);
                 ++held_extents_;
+                // We don't know whether these were discarded before we shut down
+                recently_freed_extents.insert(extent_id);
             }
         }
     }
@@ -129,6 +154,8 @@ public:
             extents.push_back(extent_info_t());
         } else {
             extent = free_queue.top() * extent_size;
+            recently_freed_extents.erase(free_queue.top());
+            discard_queue.erase(free_queue.top());
             free_queue.pop();
             --held_extents_;
         }
@@ -179,6 +206,7 @@ public:
                 dbfile->set_file_size(extents.size() * extent_size);
                 stats->pm_file_size_bytes += dbfile->get_file_size() - old_file_size;
             }
+            forget_freed_extents_from(extents.size());
 
             // Prevent the existence of a relatively large free queue after the file
             // size shrinks.
@@ -213,9 +241,41 @@ public:
             info->set_state(extent_info_t::state_free);
             free_queue.push(offset_to_id(extent));
             ++held_extents_;
+            recently_freed_extents.insert(offset_to_id(extent));
             try_shrink_file();
         }
     }
+
+    // Discards the extents that have been free since the last round (up to a limit),
+    // if it's time for another round.
+    void maybe_discard_free_extents() {
+        const ticks_t now = get_ticks();
+        if (now.nanos - last_discard_round.nanos
+                < secs_to_ticks(EXTENT_DISCARD_INTERVAL_SECS).nanos) {
+            return;
+        }
+        last_discard_round = now;
+
+        size_t budget = MAX_DISCARDED_EXTENTS_PER_ROUND;
+        auto it = discard_queue.begin();
+        while (it != discard_queue.end() && budget > 0) {
+            // Discard runs of adjacent extents at once
+            const size_t first_id = *it;
+            size_t count = 0;
+            while (it != discard_queue.end() && *it == first_id + count && budget > 0) {
+                guarantee(extents[*it].state() == extent_info_t::state_free);
+                it = discard_queue.erase(it);
+                ++count;
+                --budget;
+            }
+            dbfile->discard(first_id * extent_size, count * extent_size);
+            stats->pm_serializer_discarded_extents += count;
+        }
+
+        discard_queue.insert(recently_freed_extents.begin(),
+                             recently_freed_extents.end());
+        recently_freed_extents.clear();
+    }
 };
 
 extent_manager_t::extent_manager_t(file_t *file,
@@ -319,6 +379,7 @@ void extent_manager_t::commit_transaction(extent_transaction_t *t) {
     for (auto it = extents.begin(); it != extents.end(); ++it) {
         zone->release_extent(std::move(*it));
     }
+    zone->maybe_discard_free_extents();
 }
 
 size_t extent_manager_t::held_extents() {
@@ -4,6 +4,7 @@
 
 #include <limits.h>
 
+#include "serializer/log/block_checksum.hpp"
 #include "serializer/serializer.hpp"
 
 
@@ -60,13 +61,20 @@ ATTR_PACKED(struct lba_entry_t {
     // (It probably assumes that sizeof(lba_entry_t) evenly divides
     // DEVICE_BLOCK_SIZE).
 
-    // Put the zero-padding at the beginning of the LBA entry.  We could use this, or
-    // the first 16 bits, perhaps, as a version flag.
-    uint32_t zero_reserved;
+    // The size of the block on disk if it is stored compressed (see
+    // block_compression.hpp), or zero if it's stored uncompressed.  This used to be
+    // zero-filled padding, so older files read as uncompressed.
+    uint16_t compressed_ser_block_size;
 
-    // This could be a uint16_t if you wanted it to be, as long as block sizes are
-    // all less than or equal to 4K (which is less than 64K).
-    uint32_t ser_block_size;
+    // The lower half of the block's checksum (see block_checksum.hpp).
+    uint16_t checksum_low;
+
+    uint16_t ser_block_size;
+
+    // The upper half of the block's checksum.  Both sizes used to be 32 bits wide,
+    // and the checksum is stored where their (little-endian) upper halves were.
+    // Those were always zero, so older files read as having no checksums.
+    uint16_t checksum_high;
 
     block_id_t block_id;
 
@@ -75,12 +83,30 @@ ATTR_PACKED(struct lba_entry_t {
     // An offset into the file, with is_delete set appropriately.
     flagged_off64_t offset;
 
+    // Returns the on-disk size of the block, which equals ser_block_size unless
+    // the block is compressed.
+    uint16_t disk_ser_block_size() const {
+        return compressed_ser_block_size != 0
+            ? compressed_ser_block_size
+            : ser_block_size;
+    }
+
+    // Returns the block's checksum, or NO_BLOCK_CHECKSUM.
+    uint32_t checksum() const {
+        return (static_cast<uint32_t>(checksum_high) << 16) | checksum_low;
+    }
+
     static lba_entry_t make(block_id_t block_id, repli_timestamp_t recency,
-                            flagged_off64_t offset, uint16_t ser_block_size) {
+                            flagged_off64_t offset, uint16_t ser_block_size,
+                            uint16_t disk_ser_block_size, uint32_t checksum) {
         guarantee(ser_block_size != 0 || !offset.has_value());
+        guarantee(disk_ser_block_size <= ser_block_size);
         lba_entry_t entry;
-        entry.zero_reserved = 0;
+        entry.compressed_ser_block_size
+            = disk_ser_block_size == ser_block_size ? 0 : disk_ser_block_size;
+        entry.checksum_low = static_cast<uint16_t>(checksum);
         entry.ser_block_size = ser_block_size;
+        entry.checksum_high = static_cast<uint16_t>(checksum >> 16);
         entry.block_id = block_id;
         entry.recency = recency;
         entry.offset = offset;
@@ -93,7 +119,7 @@ ATTR_PACKED(struct lba_entry_t {
 
     static lba_entry_t make_padding_entry() {
         return make(PADDING_BLOCK_ID, repli_timestamp_t::invalid,
-                    flagged_off64_t::padding(), 0);
+                    flagged_off64_t::padding(), 0, 0, NO_BLOCK_CHECKSUM);
     }
 });
 
@@ -3,10 +3,156 @@
 
 #include <inttypes.h>
 
+#include <utility>
+
+#include "math.hpp"
 #include "serializer/log/lba/disk_format.hpp"
 
+// Offsets are stored in 40 bits, in units of DEVICE_BLOCK_SIZE.
+static const uint64_t MAX_PACKED_DBLOCKS = (static_cast<uint64_t>(1) << 40) - 1;
+
+packed_block_location_t::packed_block_location_t(flagged_off64_t offset,
+                                                 uint16_t _ser_block_size,
+                                                 uint16_t _disk_ser_block_size)
+    : ser_block_size(_ser_block_size),
+      disk_ser_block_size(_disk_ser_block_size) {
+    uint64_t dblocks = 0;
+    if (offset.has_value()) {
+        // Data blocks are always written DEVICE_BLOCK_SIZE-aligned.
+        guarantee(divides(DEVICE_BLOCK_SIZE, offset.get_value()));
+        dblocks = offset.get_value() / DEVICE_BLOCK_SIZE + 1;
+        guarantee(dblocks <= MAX_PACKED_DBLOCKS,
+                  "Block offset %" PRIi64 " is too large for the in-memory index.",
+                  offset.get_value());
+    }
+    dblocks_low = static_cast<uint32_t>(dblocks);
+    dblocks_high = static_cast<uint8_t>(dblocks >> 32);
+}
+
+flagged_off64_t packed_block_location_t::offset() const {
+    const uint64_t dblocks =
+        (static_cast<uint64_t>(dblocks_high) << 32) | dblocks_low;
+    if (dblocks == 0) {
+        return flagged_off64_t::unused();
+    }
+    return flagged_off64_t::make((dblocks - 1) * DEVICE_BLOCK_SIZE);
+}
+
+recency_array_t::chunk_t::chunk_t(repli_timestamp_t first_recency)
+    : count(0) {
+    // Center the base on the first recency, so that the chunk can hold recencies
+    // both somewhat older and somewhat newer than that.
+    const uint64_t half_range = INVALID_DELTA / 2;
+    base = first_recency.longtime > half_range
+        ? first_recency.longtime - half_range
+        : 0;
+    for (size_t i = 0; i < CHUNK_SIZE; ++i) {
+        deltas[i] = INVALID_DELTA;
+    }
+}
+
+repli_timestamp_t recency_array_t::chunk_t::get(size_t index) const {
+    if (wide_recencies.has()) {
+        return wide_recencies[index];
+    }
+    if (deltas[index] == INVALID_DELTA) {
+        return repli_timestamp_t::invalid;
+    }
+    repli_timestamp_t ret;
+    ret.longtime = base + deltas[index];
+    return ret;
+}
+
+bool recency_array_t::chunk_t::try_set(size_t index, repli_timestamp_t recency) {
+    if (wide_recencies.has()) {
+        wide_recencies[index] = recency;
+    } else if (recency == repli_timestamp_t::invalid) {
+        deltas[index] = INVALID_DELTA;
+    } else if (recency.longtime >= base
+               && recency.longtime - base < INVALID_DELTA) {
+        deltas[index] = static_cast<uint32_t>(recency.longtime - base);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void recency_array_t::chunk_t::widen() {
+    rassert(!wide_recencies.has());
+    scoped_array_t<repli_timestamp_t> wide(CHUNK_SIZE);
+    for (size_t i = 0; i < CHUNK_SIZE; ++i) {
+        wide[i] = get(i);
+    }
+    wide_recencies = std::move(wide);
+}
+
+repli_timestamp_t recency_array_t::get(size_t key) const {
+    const size_t chunk_id = key / CHUNK_SIZE;
+    if (chunk_id < chunks.size() && chunks[chunk_id].has()) {
+        return chunks[chunk_id]->get(key % CHUNK_SIZE);
+    } else {
+        return repli_timestamp_t::invalid;
+    }
+}
+
+void recency_array_t::set(size_t key, repli_timestamp_t recency) {
+    const size_t chunk_id = key / CHUNK_SIZE;
+    if (chunk_id >= chunks.size() || !chunks[chunk_id].has()) {
+        if (recency == repli_timestamp_t::invalid) {
+            return;
+        }
+        if (chunk_id >= chunks.size()) {
+            chunks.resize(chunk_id + 1);
+        }
+        chunks[chunk_id].init(new chunk_t(recency));
+        ++num_chunks;
+    }
+
+    chunk_t *chunk = chunks[chunk_id].get();
+    const size_t index = key % CHUNK_SIZE;
+    if (chunk->get(index) != repli_timestamp_t::invalid) {
+        --chunk->count;
+    }
+    if (!chunk->try_set(index, recency)) {
+        chunk->widen();
+        ++num_wide_chunks;
+        const bool res = chunk->try_set(index, recency);
+        guarantee(res);
+    }
+    if (recency != repli_timestamp_t::invalid) {
+        ++chunk->count;
+    }
+
+    if (chunk->count == 0) {
+        if (chunk->wide_recencies.has()) {
+            --num_wide_chunks;
+        }
+        chunks[chunk_id].reset();
+        --num_chunks;
+
+        while (!chunks.empty() && !chunks.back().has()) {
+            chunks.pop_back();
+        }
+    }
+}
+
+size_t recency_array_t::memory_usage() const {
+    return chunks.capacity() * sizeof(scoped_ptr_t<chunk_t>)
+        + num_chunks * sizeof(chunk_t)
+        + num_wide_chunks * CHUNK_SIZE * sizeof(repli_timestamp_t);
+}
+
 in_memory_index_t::in_memory_index_t()
-    : end_block_id_(0), end_aux_block_id_(FIRST_AUX_BLOCK_ID) { }
+    : end_block_id_(0), end_aux_block_id_(FIRST_AUX_BLOCK_ID),
+      memory_usage_(memory_usage_category_t::LBA_INDEX) { }
+
+void in_memory_index_t::update_memory_usage() {
+    memory_usage_.set(locations_.memory_usage()
+                      + recencies_.memory_usage()
+                      + aux_locations_.memory_usage()
+                      + checksums_.memory_usage()
+                      + aux_checksums_.memory_usage());
+}
 
 block_id_t in_memory_index_t::end_block_id() {
     return end_block_id_;
@@ -18,19 +164,28 @@ block_id_t in_memory_index_t::end_aux_block_id() {
 
 index_block_info_t in_memory_index_t::get_block_info(block_id_t id) {
     if (is_aux_block_id(id)) {
-        index_aux_block_info_t aux_info
-            = aux_infos_.get(make_aux_block_id_relative(id));
-        return index_block_info_t(aux_info.offset,
+        const block_id_t relative_id = make_aux_block_id_relative(id);
+        packed_block_location_t location = aux_locations_.get(relative_id);
+        return index_block_info_t(location.offset(),
                                   repli_timestamp_t::invalid,
-                                  aux_info.ser_block_size);
+                                  location.ser_block_size,
+                                  location.disk_ser_block_size,
+                                  aux_checksums_.get(relative_id));
     } else {
-        return infos_.get(id);
+        packed_block_location_t location = locations_.get(id);
+        return index_block_info_t(location.offset(),
+                                  recencies_.get(id),
+                                  location.ser_block_size,
+                                  location.disk_ser_block_size,
+                                  checksums_.get(id));
     }
 }
 
 void in_memory_index_t::set_block_info(block_id_t id, repli_timestamp_t recency,
                                        flagged_off64_t offset,
-                                       uint16_t ser_block_size) {
+                                       uint16_t ser_block_size,
+                                       uint16_t disk_ser_block_size,
+                                       uint32_t checksum) {
     if (is_aux_block_id(id)) {
         if (id >= end_aux_block_id_) {
             end_aux_block_id_ = id + 1;
@@ -39,14 +194,19 @@ void in_memory_index_t::set_block_info(block_id_t id, repli_timestamp_t recency,
         // other than `invalid`, you might be doing something wrong. It will be
         // discarded anyway.
         rassert(recency == repli_timestamp_t::invalid);
-        index_aux_block_info_t info(offset, ser_block_size);
-        aux_infos_.set(make_aux_block_id_relative(id), info);
+        const block_id_t relative_id = make_aux_block_id_relative(id);
+        aux_locations_.set(relative_id,
+                           packed_block_location_t(offset, ser_block_size,
+                                                   disk_ser_block_size));
+        aux_checksums_.set(relative_id, checksum);
     } else {
         if (id >= end_block_id_) {
             end_block_id_ = id + 1;
         }
-        index_block_info_t info(offset, recency, ser_block_size);
-        infos_.set(id, info);
+        locations_.set(id, packed_block_location_t(offset, ser_block_size,
+                                                   disk_ser_block_size));
+        recencies_.set(id, recency);
+        checksums_.set(id, checksum);
     }
+    update_memory_usage();
 }
-
@@ -2,9 +2,13 @@
 #ifndef SERIALIZER_LOG_LBA_IN_MEMORY_INDEX_HPP_
 #define SERIALIZER_LOG_LBA_IN_MEMORY_INDEX_HPP_
 
+#include <vector>
+
 #include "arch/compiler.hpp"
+#include "containers/scoped.hpp"
 #include "containers/two_level_array.hpp"
 #include "config/args.hpp"
+#include "perfmon/memory_usage.hpp"
 #include "serializer/serializer.hpp"
 #include "serializer/log/lba/disk_format.hpp"
 
@@ -12,57 +16,123 @@ ATTR_PACKED(struct index_block_info_t {
     index_block_info_t()
         : offset(flagged_off64_t::unused()),
           recency(repli_timestamp_t::invalid),
-          ser_block_size(0) { }
+          ser_block_size(0),
+          disk_ser_block_size(0),
+          checksum(NO_BLOCK_CHECKSUM) { }
 
     index_block_info_t(flagged_off64_t _offset,
                        repli_timestamp_t _recency,
-                       uint16_t _ser_block_size)
+                       uint16_t _ser_block_size,
+                       uint16_t _disk_ser_block_size,
+                       uint32_t _checksum)
         : offset(_offset),
           recency(_recency),
-          ser_block_size(_ser_block_size) { }
+          ser_block_size(_ser_block_size),
+          disk_ser_block_size(_disk_ser_block_size),
+          checksum(_checksum) { }
 
     // For two_level_array_t.
     bool operator==(const index_block_info_t &other) const {
         return offset == other.offset &&
             recency == other.recency &&
-            ser_block_size == other.ser_block_size;
+            ser_block_size == other.ser_block_size &&
+            disk_ser_block_size == other.disk_ser_block_size &&
+            checksum == other.checksum;
     }
 
     flagged_off64_t offset;
     repli_timestamp_t recency;
     uint16_t ser_block_size;
+    // The size of the block on disk.  Smaller than `ser_block_size` if the block is
+    // stored compressed.
+    uint16_t disk_ser_block_size;
+    // `NO_BLOCK_CHECKSUM` if the block was written without a checksum.
+    uint32_t checksum;
 });
 
-/* This is a reduced-size block info for auxiliary blocks (currently
-blob blocks used for large values). It doesn't store a replication
-timestamp, because we don't need it for those blocks. */
-ATTR_PACKED(struct index_aux_block_info_t {
-    index_aux_block_info_t()
-        : offset(flagged_off64_t::unused()),
-          ser_block_size(0) { }
-
-    index_aux_block_info_t(flagged_off64_t _offset,
-                           uint16_t _ser_block_size)
-        : offset(_offset),
-          ser_block_size(_ser_block_size) { }
+/* The in-memory index keeps an entry for every block of the file, so its per-block
+footprint matters for huge tables. Instead of a full `index_block_info_t` (24 bytes),
+we store a `packed_block_location_t` (9 bytes) for every block, plus a 32 bit recency
+delta for each non-aux block (see `recency_array_t`). Aux blocks don't need a
+recency. Checksums are kept in arrays of their own, which don't allocate anything for
+chunks of blocks that were all written without one. */
+ATTR_PACKED(struct packed_block_location_t {
+    packed_block_location_t()
+        : dblocks_low(0), dblocks_high(0), ser_block_size(0), disk_ser_block_size(0) { }
+    packed_block_location_t(flagged_off64_t offset,
+                            uint16_t _ser_block_size,
+                            uint16_t _disk_ser_block_size);
+
+    flagged_off64_t offset() const;
 
     // For two_level_array_t.
-    bool operator==(const index_aux_block_info_t &other) const {
-        return offset == other.offset &&
-            ser_block_size == other.ser_block_size;
+    bool operator==(const packed_block_location_t &other) const {
+        return dblocks_low == other.dblocks_low &&
+            dblocks_high == other.dblocks_high &&
+            ser_block_size == other.ser_block_size &&
+            disk_ser_block_size == other.disk_ser_block_size;
     }
 
-    flagged_off64_t offset;
+    // The block's offset in units of DEVICE_BLOCK_SIZE plus one, split into the
+    // lower 32 and the upper 8 bits. Zero means that the block doesn't exist.
+    uint32_t dblocks_low;
+    uint8_t dblocks_high;
     uint16_t ser_block_size;
+    uint16_t disk_ser_block_size;
 });
 
+/* A two_level_array_t-like container of recencies. Each chunk stores its recencies
+as 32 bit deltas from a per-chunk base, which works as long as the recencies of the
+blocks in a chunk lie within about 2^31 timestamps of each other. A chunk where that
+isn't the case switches over to storing full 64 bit recencies. */
+class recency_array_t {
+public:
+    recency_array_t() : num_chunks(0), num_wide_chunks(0) { }
+
+    repli_timestamp_t get(size_t key) const;
+    void set(size_t key, repli_timestamp_t recency);
 
+    // The number of bytes the array has allocated.
+    size_t memory_usage() const;
+
+private:
+    static const size_t CHUNK_SIZE = 1 << 14;
+    static const uint32_t INVALID_DELTA = UINT32_MAX;
+
+    struct chunk_t {
+        explicit chunk_t(repli_timestamp_t first_recency);
+
+        repli_timestamp_t get(size_t index) const;
+        // Returns false if the chunk must be widened first.
+        bool try_set(size_t index, repli_timestamp_t recency);
+        void widen();
+
+        size_t count;
+        uint64_t base;
+        uint32_t deltas[CHUNK_SIZE];
+        // Once allocated, this is used instead of `deltas`.
+        scoped_array_t<repli_timestamp_t> wide_recencies;
+    };
+    std::vector<scoped_ptr_t<chunk_t> > chunks;
+    size_t num_chunks;
+    size_t num_wide_chunks;
+
+    DISABLE_COPYING(recency_array_t);
+};
 
 class in_memory_index_t {
-    two_level_array_t<index_block_info_t> infos_;
+    two_level_array_t<packed_block_location_t> locations_;
+    recency_array_t recencies_;
     block_id_t end_block_id_;
-    two_level_array_t<index_aux_block_info_t> aux_infos_;
+    two_level_array_t<packed_block_location_t> aux_locations_;
     block_id_t end_aux_block_id_;
+    two_level_array_t<uint32_t> checksums_;
+    two_level_array_t<uint32_t> aux_checksums_;
+
+    // Reports the memory the containers above have allocated as part of the
+    // `lba_index` memory usage.
+    memory_usage_tracker_t memory_usage_;
+    void update_memory_usage();
 
 public:
     in_memory_index_t();
@@ -73,7 +143,8 @@ public:
 
     index_block_info_t get_block_info(block_id_t id);
     void set_block_info(block_id_t id, repli_timestamp_t recency,
-                        flagged_off64_t offset, uint16_t ser_block_size);
+                        flagged_off64_t offset, uint16_t ser_block_size,
+                        uint16_t disk_ser_block_size, uint32_t checksum);
 
 };
 
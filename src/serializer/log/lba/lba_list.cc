@@ -13,7 +13,8 @@
 lba_list_t::lba_list_t(extent_manager_t *em,
         const lba_list_t::write_metablock_fun_t &_write_metablock_fun)
     : gc_drainer(new auto_drainer_t), write_metablock_fun(_write_metablock_fun),
-      extent_manager(em), state(state_unstarted), inline_lba_entries_count(0)
+      extent_manager(em), state(state_unstarted), inline_lba_entries_count(0),
+      compacting_for_shutdown(false)
 {
     for (int i = 0; i < LBA_SHARD_FACTOR; i++) {
         gc_active[i] = false;
@@ -101,15 +102,14 @@ public:
             // the metablock into the index:
             for (int32_t i = 0; i < owner->inline_lba_entries_count; ++i) {
                 lba_entry_t *e = &owner->inline_lba_entries[i];
-                // The on-disk format still stores 32 bit block sizes.
-                // We've never actually used them, and we now use 16 bit block sizes
-                // for the in-memory index to save a few bytes.
-                guarantee(e->ser_block_size <= std::numeric_limits<uint16_t>::max());
+                guarantee(e->disk_ser_block_size() <= e->ser_block_size);
                 owner->in_memory_index.set_block_info(
                         e->block_id,
                         e->recency,
                         e->offset,
-                        static_cast<uint16_t>(e->ser_block_size));
+                        e->ser_block_size,
+                        e->disk_ser_block_size(),
+                        e->checksum());
             }
 
             owner->state = lba_list_t::state_ready;
@@ -124,7 +124,8 @@ bool lba_list_t::start_existing(file_t *file, lba_metablock_mixin_t *last_metabl
     rassert(state == state_unstarted);
 
     dbfile = file;
-    gc_io_account.init(new file_account_t(dbfile, LBA_GC_IO_PRIORITY));
+    gc_io_account.init(new file_account_t(dbfile, io_class_t::LBA_GC,
+                                            LBA_GC_IO_PRIORITY));
 
     lba_start_fsm_t *starter = new lba_start_fsm_t(this, last_metablock);
     if (state == state_ready) {
@@ -160,10 +161,22 @@ uint16_t lba_list_t::get_ser_block_size(block_id_t block) {
     return get_block_info(block).ser_block_size;
 }
 
+uint16_t lba_list_t::get_disk_ser_block_size(block_id_t block) {
+    return get_block_info(block).disk_ser_block_size;
+}
+
 block_size_t lba_list_t::get_block_size(block_id_t block) {
     return block_size_t::unsafe_make(get_block_info(block).ser_block_size);
 }
 
+block_size_t lba_list_t::get_disk_block_size(block_id_t block) {
+    return block_size_t::unsafe_make(get_block_info(block).disk_ser_block_size);
+}
+
+uint32_t lba_list_t::get_block_checksum(block_id_t block) {
+    return get_block_info(block).checksum;
+}
+
 repli_timestamp_t lba_list_t::get_block_recency(block_id_t block) {
     return get_block_info(block).recency;
 }
@@ -192,10 +205,12 @@ segmented_vector_t<repli_timestamp_t> lba_list_t::get_block_recencies(block_id_t
 
 void lba_list_t::set_block_info(block_id_t block, repli_timestamp_t recency,
                                 flagged_off64_t offset, uint16_t ser_block_size,
+                                uint16_t disk_ser_block_size, uint32_t checksum,
                                 file_account_t *io_account, extent_transaction_t *txn) {
     rassert(state == state_ready || state == state_gc_shutting_down);
 
-    in_memory_index.set_block_info(block, recency, offset, ser_block_size);
+    in_memory_index.set_block_info(block, recency, offset, ser_block_size,
+                                   disk_ser_block_size, checksum);
 
     // If the inline LBA is full, free it up first by moving its entries to
     // the LBA extents
@@ -204,7 +219,8 @@ void lba_list_t::set_block_info(block_id_t block, repli_timestamp_t recency,
         rassert(!check_inline_lba_full());
     }
     // Then store the entry inline
-    add_inline_entry(block, recency, offset, ser_block_size);
+    add_inline_entry(block, recency, offset, ser_block_size, disk_ser_block_size,
+                     checksum);
 }
 
 bool lba_list_t::check_inline_lba_full() const {
@@ -242,6 +258,8 @@ void lba_list_t::move_inline_entries_to_extents(file_account_t *io_account, exte
                 e.recency,
                 e.offset,
                 e.ser_block_size,
+                e.disk_ser_block_size(),
+                e.checksum(),
                 io_account,
                 txn);
     }
@@ -250,11 +268,13 @@ void lba_list_t::move_inline_entries_to_extents(file_account_t *io_account, exte
 }
 
 void lba_list_t::add_inline_entry(block_id_t block, repli_timestamp_t recency,
-                                flagged_off64_t offset, uint16_t ser_block_size) {
+                                flagged_off64_t offset, uint16_t ser_block_size,
+                                uint16_t disk_ser_block_size, uint32_t checksum) {
 
     rassert(!check_inline_lba_full());
     inline_lba_entries[inline_lba_entries_count++] =
-            lba_entry_t::make(block, recency, offset, ser_block_size);
+            lba_entry_t::make(block, recency, offset, ser_block_size,
+                              disk_ser_block_size, checksum);
 }
 
 class lba_writer_t :
@@ -350,11 +370,13 @@ void lba_list_t::gc(int lba_shard, auto_drainer_t::lock_t) {
 
         flagged_off64_t off = get_block_offset(id);
         if (off.has_value()) {
-            uint16_t ser_block_size = get_ser_block_size(id);
+            const index_block_info_t info = get_block_info(id);
             disk_structures[lba_shard]->add_entry(id,
-                                                  get_block_recency(id),
+                                                  info.recency,
                                                   off,
-                                                  ser_block_size,
+                                                  info.ser_block_size,
+                                                  info.disk_ser_block_size,
+                                                  info.checksum,
                                                   gc_io_account.get(),
                                                   txns.back().get());
         }
@@ -385,8 +407,9 @@ void lba_list_t::gc(int lba_shard, auto_drainer_t::lock_t) {
             extent_manager->begin_transaction(txns.back().get());
 
             // Check if we are shutting down. If yes, we simply abort garbage
-            // collection.
-            if (state == lba_list_t::state_gc_shutting_down) {
+            // collection (unless this is the final compaction in `shutdown_gc()`).
+            if (state == lba_list_t::state_gc_shutting_down
+                && !compacting_for_shutdown) {
                 aborted = true;
                 break;
             }
@@ -444,6 +467,10 @@ bool lba_list_t::we_want_to_gc(int i) {
         return false;
     }
 
+    return has_enough_garbage(i, LBA_MIN_UNGARBAGE_FRACTION);
+}
+
+bool lba_list_t::has_enough_garbage(int i, double min_ungarbage_fraction) {
     // Don't count the extent we're currently writing to. If there is no superblock,
     // then that extent is the only one, so we don't want to GC obviously.
     if (disk_structures[i]->superblock_extent == nullptr) {
@@ -464,7 +491,7 @@ bool lba_list_t::we_want_to_gc(int i) {
     int64_t entries_total = disk_structures[i]->extents_in_superblock.size() * entries_per_extent;
     int64_t entries_live = end_block_id() / LBA_SHARD_FACTOR
                             + make_aux_block_id_relative(end_aux_block_id()) / LBA_SHARD_FACTOR;
-    if ((entries_live / static_cast<double>(entries_total)) > LBA_MIN_UNGARBAGE_FRACTION) {  // TODO: multiply both sides by common denominator
+    if ((entries_live / static_cast<double>(entries_total)) > min_ungarbage_fraction) {  // TODO: multiply both sides by common denominator
         return false;
     }
 
@@ -480,6 +507,19 @@ void lba_list_t::shutdown_gc() {
 
     // Wait for active GC coroutines to finish
     gc_drainer.reset();
+
+    // The LBA is replayed in full the next time the serializer starts up. Compact
+    // every shard that has accumulated a noticeable amount of garbage, so that a
+    // restart after a clean shutdown only has to read one entry per block.
+    // (A compacted shard is in effect a checkpoint of the in-memory index.)
+    compacting_for_shutdown = true;
+    for (int i = 0; i < LBA_SHARD_FACTOR; i++) {
+        if (has_enough_garbage(i, LBA_SHUTDOWN_MIN_UNGARBAGE_FRACTION)) {
+            gc_active[i] = true;
+            gc(i, auto_drainer_t::lock_t());
+        }
+    }
+    compacting_for_shutdown = false;
 }
 
 void lba_list_t::shutdown() {
@@ -44,7 +44,10 @@ public:
     // These return individual fields of get_block_info.
     flagged_off64_t get_block_offset(block_id_t block);
     uint16_t get_ser_block_size(block_id_t block);
+    uint16_t get_disk_ser_block_size(block_id_t block);
     block_size_t get_block_size(block_id_t block);
+    block_size_t get_disk_block_size(block_id_t block);
+    uint32_t get_block_checksum(block_id_t block);
     repli_timestamp_t get_block_recency(block_id_t block);
     segmented_vector_t<repli_timestamp_t> get_block_recencies(block_id_t first,
                                                               block_id_t step);
@@ -62,6 +65,8 @@ public:
 
     void set_block_info(block_id_t block, repli_timestamp_t recency,
                         flagged_off64_t offset, uint16_t ser_block_size,
+                        uint16_t disk_ser_block_size,
+                        uint32_t checksum,
                         file_account_t *io_account,
                         extent_transaction_t *txn);
 
@@ -117,7 +122,9 @@ private:
     void move_inline_entries_to_extents(file_account_t *io_account,
                                         extent_transaction_t *txn);
     void add_inline_entry(block_id_t block, repli_timestamp_t recency,
-                          flagged_off64_t offset, uint16_t ser_block_size);
+                          flagged_off64_t offset, uint16_t ser_block_size,
+                          uint16_t disk_ser_block_size,
+                          uint32_t checksum);
 
     lba_disk_structure_t *disk_structures[LBA_SHARD_FACTOR];
 
@@ -128,6 +135,13 @@ private:
     // gc. The integer is which shard to GC.
     bool we_want_to_gc(int i);
 
+    // Returns true if no more than `min_ungarbage_fraction` of shard `i`'s on-disk
+    // entries are live (and the shard is big enough to be worth collecting).
+    bool has_enough_garbage(int i, double min_ungarbage_fraction);
+
+    // Set while `shutdown_gc()` compacts the LBA. Keeps `gc()` from aborting early.
+    bool compacting_for_shutdown;
+
     DISABLE_COPYING(lba_list_t);
 };
 
@@ -119,8 +119,10 @@ void filepath_file_opener_t::unlink_serializer_file() {
 log_serializer_stats_t::log_serializer_stats_t(perfmon_collection_t *parent)
     : serializer_collection(),
       pm_serializer_block_reads(secs_to_ticks(1)),
+      pm_serializer_block_read_latency(secs_to_ticks(10)),
       pm_serializer_index_reads(),
       pm_serializer_block_writes(),
+      pm_serializer_compressed_block_writes(),
       pm_serializer_index_writes(secs_to_ticks(1)),
       pm_serializer_index_writes_size(secs_to_ticks(1), false),
       pm_serializer_read_bytes_per_sec(secs_to_ticks(1)),
@@ -129,18 +131,25 @@ log_serializer_stats_t::log_serializer_stats_t(perfmon_collection_t *parent)
       pm_serializer_written_bytes_total(),
       pm_extents_in_use(),
       pm_file_size_bytes(),
+      pm_serializer_discarded_extents(),
       pm_serializer_lba_extents(),
       pm_serializer_data_extents(),
       pm_serializer_data_extents_allocated(),
       pm_serializer_data_extents_gced(),
+      pm_serializer_gc_written_bytes_per_sec(secs_to_ticks(1)),
+      pm_serializer_gc_written_bytes_total(),
+      pm_serializer_gc_backoffs(),
       pm_serializer_old_garbage_block_bytes(),
       pm_serializer_old_total_block_bytes(),
       pm_serializer_lba_gcs(),
       parent_collection_membership(parent, &serializer_collection, "serializer"),
       stats_membership(&serializer_collection,
           &pm_serializer_block_reads, "serializer_block_reads",
+          &pm_serializer_block_read_latency, "serializer_block_read_latency",
           &pm_serializer_index_reads, "serializer_index_reads",
           &pm_serializer_block_writes, "serializer_block_writes",
+          &pm_serializer_compressed_block_writes,
+              "serializer_compressed_block_writes",
           &pm_serializer_index_writes, "serializer_index_writes",
           &pm_serializer_index_writes_size, "serializer_index_writes_size",
           &pm_serializer_read_bytes_per_sec, "serializer_read_bytes_per_sec",
@@ -149,10 +158,15 @@ log_serializer_stats_t::log_serializer_stats_t(perfmon_collection_t *parent)
           &pm_serializer_written_bytes_total, "serializer_written_bytes_total",
           &pm_extents_in_use, "serializer_extents_in_use",
           &pm_file_size_bytes, "serializer_file_size_bytes",
+          &pm_serializer_discarded_extents, "serializer_discarded_extents",
           &pm_serializer_lba_extents, "serializer_lba_extents",
           &pm_serializer_data_extents, "serializer_data_extents",
           &pm_serializer_data_extents_allocated, "serializer_data_extents_allocated",
           &pm_serializer_data_extents_gced, "serializer_data_extents_gced",
+          &pm_serializer_gc_written_bytes_per_sec,
+              "serializer_gc_written_bytes_per_sec",
+          &pm_serializer_gc_written_bytes_total, "serializer_gc_written_bytes_total",
+          &pm_serializer_gc_backoffs, "serializer_gc_backoffs",
           &pm_serializer_old_garbage_block_bytes, "serializer_old_garbage_block_bytes",
           &pm_serializer_old_total_block_bytes, "serializer_old_total_block_bytes",
           &pm_serializer_lba_gcs, "serializer_lba_gcs")
@@ -168,6 +182,11 @@ void log_serializer_stats_t::bytes_written(size_t count) {
     pm_serializer_written_bytes_total += count;
 }
 
+void log_serializer_stats_t::gc_bytes_written(size_t count) {
+    pm_serializer_gc_written_bytes_per_sec.record(count);
+    pm_serializer_gc_written_bytes_total += count;
+}
+
 void log_serializer_t::create(serializer_file_opener_t *file_opener,
                               static_config_t static_config) {
     log_serializer_on_disk_static_config_t *on_disk_config = &static_config;
@@ -217,7 +236,8 @@ struct ls_start_existing_fsm_t :
         file_opener->open_serializer_file_existing(&dbfile);
         ser->dbfile = dbfile.release();
         ser->index_writes_io_account.init(
-            new file_account_t(ser->dbfile, INDEX_WRITE_IO_PRIORITY));
+            new file_account_t(ser->dbfile, io_class_t::INDEX_WRITES,
+                               INDEX_WRITE_IO_PRIORITY));
 
         start_existing_state = state_read_static_header;
         // STATE A above implies STATE B here
@@ -318,7 +338,7 @@ struct ls_start_existing_fsm_t :
                     ser->lba_index->get_block_offset(next_block_to_reconstruct);
                 if (offset.has_value()) {
                     ser->data_block_manager->mark_live(offset.get_value(),
-                        ser->lba_index->get_block_size(next_block_to_reconstruct));
+                        ser->lba_index->get_disk_block_size(next_block_to_reconstruct));
                 }
 
                 ++next_block_to_reconstruct;
@@ -444,13 +464,15 @@ log_serializer_t::~log_serializer_t() {
     rassert(state == state_unstarted || state == state_shut_down);
     rassert(metablock_waiter_queue.empty());
     rassert(active_write_count == 0);
+    rassert(snapshots.empty());
 }
 
-file_account_t *log_serializer_t::make_io_account(int priority,
+file_account_t *log_serializer_t::make_io_account(io_class_t io_class,
+                                                  int priority,
                                                   int outstanding_requests_limit) {
     assert_thread();
     rassert(dbfile);
-    return new file_account_t(dbfile, priority, outstanding_requests_limit);
+    return new file_account_t(dbfile, io_class, priority, outstanding_requests_limit);
 }
 
 buf_ptr_t log_serializer_t::block_read(const counted_t<block_token_t> &token,
@@ -461,10 +483,14 @@ buf_ptr_t log_serializer_t::block_read(const counted_t<block_token_t> &token,
 
     ticks_t pm_time;
     stats->pm_serializer_block_reads.begin(&pm_time);
+    ticks_t start = get_ticks();
 
     buf_ptr_t ret = data_block_manager->read(token->offset_, token->block_size(),
-                                             io_account);
+                                             token->disk_block_size(),
+                                             token->checksum(), io_account);
 
+    stats->pm_serializer_block_read_latency.record(
+        ticks_to_secs(ticks_t{get_ticks().nanos - start.nanos}));
     stats->pm_serializer_block_reads.end(&pm_time);
     return ret;
 }
@@ -491,8 +517,14 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
              write_op_it != write_ops.end();
              ++write_op_it) {
             const index_write_op_t &op = *write_op_it;
+            for (serializer_snapshot_t *snapshot : snapshots) {
+                snapshot->on_index_write(op.block_id);
+            }
             flagged_off64_t offset = lba_index->get_block_offset(op.block_id);
             uint16_t ser_block_size = lba_index->get_ser_block_size(op.block_id);
+            uint16_t disk_ser_block_size
+                = lba_index->get_disk_ser_block_size(op.block_id);
+            uint32_t checksum = lba_index->get_block_checksum(op.block_id);
 
             if (op.token) {
                 // Update the offset pointed to, and mark garbage/liveness as necessary.
@@ -507,13 +539,17 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
                 if (token.has()) {
                     offset = flagged_off64_t::make(token->offset_);
                     ser_block_size = token->block_size().ser_value();
+                    disk_ser_block_size = token->disk_block_size().ser_value();
+                    checksum = token->checksum();
 
                     /* mark the life */
                     data_block_manager->mark_live(offset.get_value(),
-                                                  token->block_size());
+                                                  token->disk_block_size());
                 } else {
                     offset = flagged_off64_t::unused();
                     ser_block_size = 0;
+                    disk_ser_block_size = 0;
+                    checksum = NO_BLOCK_CHECKSUM;
                 }
             }
 
@@ -521,7 +557,8 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
                 : lba_index->get_block_recency(op.block_id);
 
             lba_index->set_block_info(op.block_id, recency,
-                                      offset, ser_block_size,
+                                      offset, ser_block_size, disk_ser_block_size,
+                                      checksum,
                                       index_writes_io_account.get(), &txn);
         }
     }
@@ -649,9 +686,12 @@ void log_serializer_t::write_metablock_sans_pipelining(
 }
 
 counted_t<block_token_t>
-log_serializer_t::generate_block_token(int64_t offset, block_size_t block_size) {
+log_serializer_t::generate_block_token(int64_t offset, block_size_t block_size,
+                                       block_size_t disk_block_size,
+                                       uint32_t checksum) {
     assert_thread();
-    counted_t<block_token_t> token(new block_token_t(this, offset, block_size));
+    counted_t<block_token_t> token(
+        new block_token_t(this, offset, block_size, disk_block_size, checksum));
 
     auto location = offset_tokens.find(offset);
     if (location == offset_tokens.end()) {
@@ -663,6 +703,23 @@ log_serializer_t::generate_block_token(int64_t offset, block_size_t block_size)
     return token;
 }
 
+void log_serializer_t::live_block_info(block_id_t block_id, int64_t offset,
+                                       block_size_t *block_size_out,
+                                       uint32_t *checksum_out) {
+    assert_thread();
+    const index_block_info_t info = lba_index->get_block_info(block_id);
+    if (info.offset.has_value() && info.offset.get_value() == offset) {
+        *block_size_out = block_size_t::unsafe_make(info.ser_block_size);
+        *checksum_out = info.checksum;
+        return;
+    }
+    auto it = offset_tokens.find(offset);
+    guarantee(it != offset_tokens.end(),
+              "No live block at offset %" PRIi64 ".", offset);
+    *block_size_out = it->second->block_size();
+    *checksum_out = it->second->checksum();
+}
+
 std::vector<counted_t<block_token_t> >
 log_serializer_t::block_writes(const buf_write_info_t *write_infos,
                                size_t write_infos_count,
@@ -793,8 +850,11 @@ counted_t<block_token_t> log_serializer_t::index_read(block_id_t block_id) {
 
     index_block_info_t info = lba_index->get_block_info(block_id);
     if (info.offset.has_value()) {
-        return generate_block_token(info.offset.get_value(),
-                                    block_size_t::unsafe_make(info.ser_block_size));
+        return generate_block_token(
+            info.offset.get_value(),
+            block_size_t::unsafe_make(info.ser_block_size),
+            block_size_t::unsafe_make(info.disk_ser_block_size),
+            info.checksum);
     } else {
         return counted_t<block_token_t>();
     }
@@ -808,6 +868,86 @@ bool log_serializer_t::get_delete_bit(block_id_t id) {
     return !offset.has_value();
 }
 
+scoped_ptr_t<serializer_snapshot_t> log_serializer_t::make_snapshot() {
+    assert_thread();
+    rassert(state == state_ready);
+    return scoped_ptr_t<serializer_snapshot_t>(new serializer_snapshot_t(this));
+}
+
+serializer_snapshot_t::serializer_snapshot_t(log_serializer_t *_serializer)
+    : serializer(_serializer),
+      end_block_id(_serializer->lba_index->end_block_id()),
+      end_aux_block_id(_serializer->lba_index->end_aux_block_id()),
+      next_block_id(0) {
+    serializer->assert_thread();
+    serializer->snapshots.insert(this);
+}
+
+serializer_snapshot_t::~serializer_snapshot_t() {
+    serializer->assert_thread();
+    serializer->snapshots.erase(this);
+}
+
+bool serializer_snapshot_t::next_block(block_id_t *block_id_out,
+                                       repli_timestamp_t *recency_out,
+                                       counted_t<block_token_t> *token_out) {
+    serializer->assert_thread();
+    for (;;) {
+        if (next_block_id == end_block_id) {
+            next_block_id = FIRST_AUX_BLOCK_ID;
+        }
+        if (next_block_id >= end_aux_block_id) {
+            return false;
+        }
+        const block_id_t block_id = next_block_id;
+        ++next_block_id;
+
+        auto saved = saved_entries.find(block_id);
+        if (saved != saved_entries.end()) {
+            // The block has changed since the snapshot was made.
+            *recency_out = saved->second.recency;
+            *token_out = std::move(saved->second.token);
+            saved_entries.erase(saved);
+        } else {
+            index_block_info_t info = serializer->lba_index->get_block_info(block_id);
+            if (!info.offset.has_value()) {
+                continue;
+            }
+            *recency_out = info.recency;
+            *token_out = serializer->generate_block_token(
+                info.offset.get_value(),
+                block_size_t::unsafe_make(info.ser_block_size),
+                block_size_t::unsafe_make(info.disk_ser_block_size),
+                info.checksum);
+        }
+        if (token_out->has()) {
+            *block_id_out = block_id;
+            return true;
+        }
+    }
+}
+
+void serializer_snapshot_t::on_index_write(block_id_t block_id) {
+    if (block_id < next_block_id
+        || (!is_aux_block_id(block_id) && block_id >= end_block_id)
+        || block_id >= end_aux_block_id
+        || saved_entries.count(block_id) == 1) {
+        // The snapshot doesn't need this block, or has it already.
+        return;
+    }
+    index_block_info_t info = serializer->lba_index->get_block_info(block_id);
+    saved_entry_t entry;
+    entry.recency = info.recency;
+    if (info.offset.has_value()) {
+        entry.token = serializer->generate_block_token(
+            info.offset.get_value(),
+            block_size_t::unsafe_make(info.ser_block_size),
+            block_size_t::unsafe_make(info.disk_ser_block_size),
+            info.checksum);
+    }
+    saved_entries.insert(std::make_pair(block_id, std::move(entry)));
+}
+
 segmented_vector_t<repli_timestamp_t>
 log_serializer_t::get_all_recencies(block_id_t first, block_id_t step) {
     assert_thread();
@@ -989,10 +1129,14 @@ bool log_serializer_t::should_perform_read_ahead() {
 
 block_token_t::block_token_t(log_serializer_t *serializer,
                              int64_t initial_offset,
-                             block_size_t initial_block_size)
+                             block_size_t initial_block_size,
+                             block_size_t initial_disk_block_size,
+                             uint32_t checksum)
     : serializer_(serializer), ref_count_(0),
-      block_size_(initial_block_size), offset_(initial_offset) {
+      block_size_(initial_block_size), disk_block_size_(initial_disk_block_size),
+      checksum_(checksum), offset_(initial_offset) {
     serializer_->assert_thread();
+    rassert(disk_block_size_.ser_value() <= block_size_.ser_value());
 }
 
 void block_token_t::do_destroy() {
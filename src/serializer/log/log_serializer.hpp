@@ -3,6 +3,7 @@
 #define SERIALIZER_LOG_LOG_SERIALIZER_HPP_
 
 #include <map>
+#include <set>
 #include <string>
 #include <vector>
 #include <list>
@@ -92,6 +93,52 @@ private:
 // Used internally
 struct ls_start_existing_fsm_t;
 
+/* A `serializer_snapshot_t` is a view of a log serializer's index as it was when the
+snapshot was made. Making one doesn't copy the index. Instead, the blocks are visited in
+order of block id, and `log_serializer_t::index_write()` saves the entry of any block
+that it is about to change before the snapshot has got to it, together with a token
+that keeps the old data on disk. So the snapshot only takes memory for the blocks that
+are changed while it is being read.
+
+It must be used and destroyed on the serializer's thread, before the serializer is
+destroyed. */
+class serializer_snapshot_t {
+public:
+    ~serializer_snapshot_t();
+
+    /* Sets the outputs to the next block that existed when the snapshot was made, in
+    order of block id, aux blocks last. Returns false when there are no blocks left.
+    The token can be passed to `block_read()`. Doesn't block. */
+    bool next_block(block_id_t *block_id_out,
+                    repli_timestamp_t *recency_out,
+                    counted_t<block_token_t> *token_out);
+
+private:
+    friend class log_serializer_t;
+
+    explicit serializer_snapshot_t(log_serializer_t *serializer);
+
+    /* Called by `index_write()` before it changes the block's index entry. */
+    void on_index_write(block_id_t block_id);
+
+    struct saved_entry_t {
+        repli_timestamp_t recency;
+        // Empty if the block didn't exist
+        counted_t<block_token_t> token;
+    };
+
+    log_serializer_t *const serializer;
+    const block_id_t end_block_id;
+    const block_id_t end_aux_block_id;
+
+    // The blocks before this one have been visited.
+    block_id_t next_block_id;
+
+    std::map<block_id_t, saved_entry_t> saved_entries;
+
+    DISABLE_COPYING(serializer_snapshot_t);
+};
+
 class log_serializer_t :
     public serializer_t,
     private data_block_manager::shutdown_callback_t
@@ -100,6 +147,7 @@ class log_serializer_t :
     friend class data_block_manager_t;
     friend class dbm_read_ahead_t;
     friend class block_token_t;
+    friend class serializer_snapshot_t;
 
 public:
     /* Serializer configuration. dynamic_config_t is everything that can be changed from
@@ -122,7 +170,8 @@ public:
     virtual ~log_serializer_t();
 
     using serializer_t::make_io_account;
-    file_account_t *make_io_account(int priority, int outstanding_requests_limit);
+    file_account_t *make_io_account(io_class_t io_class, int priority,
+                                    int outstanding_requests_limit);
 
     void register_read_ahead_cb(serializer_read_ahead_callback_t *cb);
     void unregister_read_ahead_cb(serializer_read_ahead_callback_t *cb);
@@ -134,6 +183,8 @@ public:
     bool get_delete_bit(block_id_t id);
     counted_t<block_token_t> index_read(block_id_t block_id);
 
+    scoped_ptr_t<serializer_snapshot_t> make_snapshot();
+
     buf_ptr_t block_read(const counted_t<block_token_t> &token,
                        file_account_t *io_account);
 
@@ -157,7 +208,14 @@ private:
     void unregister_block_token(block_token_t *token);
     void remap_block_to_new_offset(int64_t current_offset, int64_t new_offset);
     counted_t<block_token_t> generate_block_token(int64_t offset,
-                                                             block_size_t block_size);
+                                                  block_size_t block_size,
+                                                  block_size_t disk_block_size,
+                                                  uint32_t checksum);
+    // Returns the (uncompressed) size and the checksum of the live block `block_id`
+    // stored at `offset`, which must be referenced by the index or by some block
+    // token.
+    void live_block_info(block_id_t block_id, int64_t offset,
+                         block_size_t *block_size_out, uint32_t *checksum_out);
 
     void offer_buf_to_read_ahead_callbacks(
             block_id_t block_id,
@@ -207,6 +265,9 @@ private:
     // GC (which remaps offsets) will move block tokens from an "old" offset to a "new"
     // offset while simultaneously having already created tokens at the "new" offset.
     std::multimap<int64_t, block_token_t *> offset_tokens;
+
+    // The snapshots that are being read, which `index_write()` has to keep up to date.
+    std::set<serializer_snapshot_t *> snapshots;
     scoped_ptr_t<log_serializer_stats_t> stats;
     perfmon_collection_t disk_stats_collection;
     perfmon_membership_t disk_stats_membership;
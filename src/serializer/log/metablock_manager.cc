@@ -160,8 +160,9 @@ bool disk_format_version_is_recognized(uint32_t disk_format_version) {
         || disk_format_version == static_cast<uint32_t>(cluster_version_t::v2_2)
         || disk_format_version == static_cast<uint32_t>(cluster_version_t::v2_3)
         || disk_format_version == static_cast<uint32_t>(cluster_version_t::v2_4)
+        || disk_format_version == static_cast<uint32_t>(cluster_version_t::v2_5)
         || disk_format_version ==
-            static_cast<uint32_t>(cluster_version_t::v2_5_is_latest_disk);
+            static_cast<uint32_t>(cluster_version_t::v2_6_is_latest_disk);
 }
 
 
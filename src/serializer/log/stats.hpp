@@ -10,10 +10,14 @@ struct log_serializer_stats_t {
 
     void bytes_read(size_t count);
     void bytes_written(size_t count);
+    // Called for the part of the written bytes that the data block GC moved
+    void gc_bytes_written(size_t count);
 
     perfmon_duration_sampler_t pm_serializer_block_reads;
+    perfmon_latency_histogram_t pm_serializer_block_read_latency;
     perfmon_counter_t pm_serializer_index_reads;
     perfmon_counter_t pm_serializer_block_writes;
+    perfmon_counter_t pm_serializer_compressed_block_writes;
     perfmon_duration_sampler_t pm_serializer_index_writes;
     perfmon_sampler_t pm_serializer_index_writes_size;
 
@@ -25,6 +29,7 @@ struct log_serializer_stats_t {
     /* used in serializer/log/extent_manager.cc */
     perfmon_counter_t pm_extents_in_use;
     perfmon_counter_t pm_file_size_bytes;
+    perfmon_counter_t pm_serializer_discarded_extents;
 
     /* used in serializer/log/lba/extent.cc */
     perfmon_counter_t pm_serializer_lba_extents;
@@ -33,6 +38,9 @@ struct log_serializer_stats_t {
     perfmon_counter_t pm_serializer_data_extents;
     perfmon_counter_t pm_serializer_data_extents_allocated;
     perfmon_counter_t pm_serializer_data_extents_gced;
+    perfmon_rate_monitor_t pm_serializer_gc_written_bytes_per_sec;
+    perfmon_counter_t pm_serializer_gc_written_bytes_total;
+    perfmon_counter_t pm_serializer_gc_backoffs;
     perfmon_counter_t pm_serializer_old_garbage_block_bytes;
     perfmon_counter_t pm_serializer_old_total_block_bytes;
 
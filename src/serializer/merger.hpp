@@ -37,8 +37,9 @@ public:
     /* Allocates a new io account for the underlying file.
     Use delete to free it. */
     using serializer_t::make_io_account;
-    file_account_t *make_io_account(int priority, int outstanding_requests_limit) {
-        return inner->make_io_account(priority, outstanding_requests_limit);
+    file_account_t *make_io_account(io_class_t io_class, int priority,
+                                    int outstanding_requests_limit) {
+        return inner->make_io_account(io_class, priority, outstanding_requests_limit);
     }
 
     /* Some serializer implementations support read-ahead to speed up cache warmup.
@@ -85,6 +86,12 @@ public:
     /* Reads the block's actual data */
     counted_t<block_token_t> index_read(block_id_t block_id);
 
+    /* The merged index writes only reach the snapshot when they are committed to
+    `inner`, which is also when they become durable. */
+    scoped_ptr_t<serializer_snapshot_t> make_snapshot() {
+        return inner->make_snapshot();
+    }
+
     /* index_write() applies all given index operations in an atomic way */
     /* This is where merger_serializer_t merges operations */
     void index_write(new_mutex_in_line_t *mutex_acq,
@@ -12,9 +12,9 @@ void debug_print(printf_buffer_t *buf, const index_write_op_t &write_op) {
     buf->appendf("}");
 }
 
-file_account_t *serializer_t::make_io_account(int priority) {
+file_account_t *serializer_t::make_io_account(io_class_t io_class, int priority) {
     assert_thread();
-    return make_io_account(priority, UNLIMITED_OUTSTANDING_REQUESTS);
+    return make_io_account(io_class, priority, UNLIMITED_OUTSTANDING_REQUESTS);
 }
 
 ser_buffer_t *convert_buffer_cache_buf_to_ser_buffer(const void *buf) {
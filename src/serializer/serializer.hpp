@@ -7,12 +7,14 @@
 #include "arch/types.hpp"
 #include "concurrency/cond_var.hpp"
 #include "containers/optional.hpp"
+#include "containers/scoped.hpp"
 #include "containers/segmented_vector.hpp"
 #include "repli_timestamp.hpp"
 #include "serializer/types.hpp"
 
 class buf_ptr_t;
 class new_mutex_in_line_t;
+class serializer_snapshot_t;
 
 struct index_write_op_t {
     block_id_t block_id;
@@ -48,8 +50,9 @@ public:
 
     /* Allocates a new io account for the underlying file.
     Use delete to free it. */
-    file_account_t *make_io_account(int priority);
-    virtual file_account_t *make_io_account(int priority,
+    file_account_t *make_io_account(io_class_t io_class, int priority);
+    virtual file_account_t *make_io_account(io_class_t io_class,
+                                            int priority,
                                             int outstanding_requests_limit) = 0;
 
     /* Some serializer implementations support read-ahead to speed up cache warmup.
@@ -100,6 +103,11 @@ public:
     /* Reads the block's actual data */
     virtual counted_t<block_token_t> index_read(block_id_t block_id) = 0;
 
+    /* Returns a view of the blocks as they are now, which stays the same while
+    the serializer keeps being written to. Backups use this, see
+    `serializer/backup.hpp`. */
+    virtual scoped_ptr_t<serializer_snapshot_t> make_snapshot() = 0;
+
     // Applies all given index operations in an atomic way.  The mutex_acq is for a
     // mutex belonging to the _caller_, used by the caller for pipelining, for
     // ensuring that different index write operations do not cross each other.
@@ -234,8 +234,9 @@ translator_serializer_t::translator_serializer_t(serializer_t *_inner, int _mod_
     rassert(mod_id < mod_count);
 }
 
-file_account_t *translator_serializer_t::make_io_account(int priority, int outstanding_requests_limit) {
-    return inner->make_io_account(priority, outstanding_requests_limit);
+file_account_t *translator_serializer_t::make_io_account(
+        io_class_t io_class, int priority, int outstanding_requests_limit) {
+    return inner->make_io_account(io_class, priority, outstanding_requests_limit);
 }
 
 void translator_serializer_t::index_write(
@@ -275,6 +276,11 @@ counted_t<block_token_t> translator_serializer_t::index_read(block_id_t block_id
     return inner->index_read(translate_block_id(block_id));
 }
 
+scoped_ptr_t<serializer_snapshot_t> translator_serializer_t::make_snapshot() {
+    // Snapshots are taken of the whole file, through the inner serializer.
+    crash("translator_serializer_t doesn't support snapshots");
+}
+
 max_block_size_t translator_serializer_t::max_block_size() const {
     return inner->max_block_size();
 }
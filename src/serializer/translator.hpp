@@ -119,7 +119,8 @@ public:
                             config_block_id_t cfgid);
 
     /* Allocates a new io account for the underlying file */
-    file_account_t *make_io_account(int priority, int outstanding_requests_limit);
+    file_account_t *make_io_account(io_class_t io_class, int priority,
+                                    int outstanding_requests_limit);
 
     void index_write(new_mutex_in_line_t *mutex_acq,
                      const std::function<void()> &on_writes_reflected,
@@ -145,6 +146,7 @@ public:
     buf_ptr_t block_read(const counted_t<block_token_t> &token,
                        file_account_t *io_account);
     counted_t<block_token_t> index_read(block_id_t block_id);
+    scoped_ptr_t<serializer_snapshot_t> make_snapshot();
 
 public:
     void offer_read_ahead_buf(block_id_t block_id,
@@ -134,6 +134,12 @@ class block_token_t {
 public:
     int64_t offset() const { return offset_; }
     block_size_t block_size() const { return block_size_; }
+    // The number of bytes the block occupies on disk (ignoring padding).  This
+    // differs from block_size() iff the block is stored compressed.
+    block_size_t disk_block_size() const { return disk_block_size_; }
+    // The CRC32C of the block as it's stored on disk, or `NO_BLOCK_CHECKSUM` (see
+    // serializer/log/block_checksum.hpp).
+    uint32_t checksum() const { return checksum_; }
 
 private:
     friend class log_serializer_t;
@@ -144,7 +150,9 @@ private:
 
     block_token_t(log_serializer_t *serializer,
                   int64_t initial_offset,
-                  block_size_t initial_ser_block_size);
+                  block_size_t initial_ser_block_size,
+                  block_size_t initial_disk_block_size,
+                  uint32_t checksum);
 
     log_serializer_t *const serializer_;
     std::atomic<intptr_t> ref_count_;
@@ -152,6 +160,12 @@ private:
     // The block's size.
     block_size_t block_size_;
 
+    // The block's size on disk.
+    block_size_t disk_block_size_;
+
+    // The block's checksum, which stays the same when the GC moves it.
+    const uint32_t checksum_;
+
     // The block's offset on disk.
     int64_t offset_;
 
@@ -64,18 +64,27 @@ thread_allocator_t::~thread_allocator_t() {
 }
 
 thread_allocation_t::thread_allocation_t(thread_allocator_t *p)
+    : thread_allocation_t(p, INVALID_THREAD) { }
+
+thread_allocation_t::thread_allocation_t(thread_allocator_t *p, threadnum_t near)
     : thread(0), /* temporary, will be overwritten below */
       parent(p) {
     parent->assert_thread();
-    int32_t best_thread = 0;
-    for (int32_t i = 1; static_cast<size_t>(i) < parent->num_allocated.size(); ++i) {
-        if (parent->num_allocated[i] < parent->num_allocated[best_thread]) {
+    const int numa_node = near == INVALID_THREAD ? -1 : get_numa_node(near);
+    int32_t best_thread = -1;
+    for (int32_t i = 0; static_cast<size_t>(i) < parent->num_allocated.size(); ++i) {
+        if (numa_node != -1 && get_numa_node(threadnum_t(i)) != numa_node) {
+            continue;
+        }
+        if (best_thread == -1 ||
+                parent->num_allocated[i] < parent->num_allocated[best_thread]) {
             best_thread = i;
         } else if (parent->num_allocated[i] == parent->num_allocated[best_thread] &&
                    parent->secondary_lt(threadnum_t(i), threadnum_t(best_thread))) {
             best_thread = i;
         }
     }
+    guarantee(best_thread != -1);
     thread = threadnum_t(best_thread);
     ++parent->num_allocated[best_thread];
 }
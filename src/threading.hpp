@@ -111,6 +111,10 @@ private:
 class thread_allocation_t {
 public:
     explicit thread_allocation_t(thread_allocator_t *p);
+    /* Only considers the threads on the same NUMA node as `near`, if the threads are
+    pinned to NUMA nodes. Things that talk to each other a lot, like a table's CPU shards
+    and its serializer, should be allocated near each other. */
+    thread_allocation_t(thread_allocator_t *p, threadnum_t near);
     ~thread_allocation_t();
     threadnum_t get_thread() const;
 private:
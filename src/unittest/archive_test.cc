@@ -1,9 +1,12 @@
 // Copyright 2010-2012 RethinkDB, all rights reserved.
 #include <string>
+#include <vector>
 
 #include "unittest/gtest.hpp"
 
 #include "containers/archive/boost_types.hpp"
+#include "containers/archive/buffer_stream.hpp"
+#include "containers/archive/buffered_read_stream.hpp"
 #include "containers/archive/stl_types.hpp"
 
 namespace unittest {
@@ -34,6 +37,103 @@ TEST(WriteMessageTest, Variant) {
     ASSERT_EQ(15u, s.size());
 }
 
+TEST(BufferedReadStreamTest, SmallAndLargeReads) {
+    const std::string big(buffered_read_stream_t::BUFFER_SIZE * 2 + 7, 'x');
+    std::vector<std::string> strings{"a", "bc", big, "def", big, ""};
 
+    write_message_t wm;
+    for (const std::string &str : strings) {
+        serialize<cluster_version_t::LATEST_OVERALL>(&wm, str);
+    }
+    std::string data;
+    dump_to_string(&wm, &data);
+
+    buffer_read_stream_t inner(data.data(), data.size());
+    buffered_read_stream_t stream(&inner);
+    for (const std::string &expected : strings) {
+        std::string str;
+        archive_result_t res =
+            deserialize<cluster_version_t::LATEST_OVERALL>(&stream, &str);
+        ASSERT_EQ(archive_result_t::SUCCESS, res);
+        ASSERT_EQ(expected, str);
+    }
+    char c;
+    ASSERT_EQ(0, stream.read(&c, 1));
+}
+
+TEST(WriteMessageTest, RawVector) {
+    std::vector<uint64_t> v;
+    for (uint64_t i = 0; i < 100000; ++i) {
+        v.push_back(i * 0x0101010101010101ull);
+    }
+
+    write_message_t wm;
+    serialize<cluster_version_t::LATEST_OVERALL>(&wm, v);
+    ASSERT_EQ(serialized_size<cluster_version_t::LATEST_OVERALL>(v), wm.size());
+
+    // The elements are written the same way as one by one.
+    write_message_t expected_wm;
+    serialize_varint_uint64(&expected_wm, v.size());
+    for (uint64_t x : v) {
+        serialize<cluster_version_t::LATEST_OVERALL>(&expected_wm, x);
+    }
+    std::string data, expected_data;
+    dump_to_string(&wm, &data);
+    dump_to_string(&expected_wm, &expected_data);
+    ASSERT_EQ(expected_data, data);
+
+    buffer_read_stream_t stream(data.data(), data.size());
+    std::vector<uint64_t> out;
+    archive_result_t res =
+        deserialize<cluster_version_t::LATEST_OVERALL>(&stream, &out);
+    ASSERT_EQ(archive_result_t::SUCCESS, res);
+    ASSERT_EQ(v, out);
+
+    buffer_read_stream_t short_stream(data.data(), data.size() - 1);
+    res = deserialize<cluster_version_t::LATEST_OVERALL>(&short_stream, &out);
+    ASSERT_EQ(archive_result_t::SOCK_EOF, res);
+}
+
+TEST(WriteMessageTest, LargeAppends) {
+    std::string expected;
+    write_message_t wm;
+    for (int i = 0; i < 40; ++i) {
+        std::string chunk(i * 997 + (i % 3 == 0 ? write_buffer_t::MAX_CAPACITY : 1),
+                          'a' + i % 26);
+        wm.append(chunk.data(), chunk.size());
+        expected += chunk;
+    }
+    ASSERT_EQ(expected.size(), wm.size());
+
+    std::string data;
+    dump_to_string(&wm, &data);
+    ASSERT_EQ(expected, data);
+
+    intrusive_list_t<write_buffer_t> *buffers = wm.unsafe_expose_buffers();
+    for (write_buffer_t *p = buffers->head(); p; p = buffers->next(p)) {
+        ASSERT_LE(p->size, p->capacity);
+        ASSERT_LE(p->capacity, write_buffer_t::MAX_CAPACITY);
+    }
+}
+
+TEST(WriteMessageTest, PrependAndCopyTo) {
+    const std::string body(write_buffer_t::INITIAL_CAPACITY * 3, 'b');
+    write_message_t wm;
+    wm.append(body.data(), body.size());
+    wm.prepend("head", 4);
+    ASSERT_EQ(body.size() + 4, wm.size());
+
+    std::string data(wm.size(), '\0');
+    wm.copy_to(&data[0]);
+    ASSERT_EQ("head" + body, data);
+
+    // Prepending to an empty message leaves room for appending after it.
+    write_message_t small_wm;
+    small_wm.prepend("ab", 2);
+    small_wm.append("cd", 2);
+    std::string small_data;
+    dump_to_string(&small_wm, &small_data);
+    ASSERT_EQ("abcd", small_data);
+}
 
 }  // namespace unittest
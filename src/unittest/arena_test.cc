@@ -0,0 +1,58 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "unittest/gtest.hpp"
+
+#include <stdint.h>
+
+#include <map>
+#include <vector>
+
+#include "containers/arena.hpp"
+
+namespace unittest {
+
+TEST(ArenaTest, ReusesFreedBlocks) {
+    arena_t arena;
+    void *a = arena.allocate(40);
+    void *b = arena.allocate(40);
+    EXPECT_NE(a, b);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(a) % arena_t::ALIGNMENT);
+    EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(b) % arena_t::ALIGNMENT);
+    arena.deallocate(a, 40);
+    // Sizes in the same size class share a free list.
+    EXPECT_EQ(a, arena.allocate(48));
+    arena.deallocate(b, 40);
+}
+
+TEST(ArenaTest, LargeBlocks) {
+    arena_t arena;
+    char *p = static_cast<char *>(arena.allocate(arena_t::MAX_BLOCK_SIZE * 10));
+    for (size_t i = 0; i < arena_t::MAX_BLOCK_SIZE * 10; ++i) {
+        p[i] = 'x';
+    }
+    arena.deallocate(p, arena_t::MAX_BLOCK_SIZE * 10);
+}
+
+TEST(ArenaTest, Map) {
+    typedef std::map<int, std::vector<int>, std::less<int>,
+                     arena_allocator_t<std::pair<const int, std::vector<int> > > > map_t;
+    arena_t arena;
+    map_t::allocator_type allocator(&arena);
+    map_t map(allocator);
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < 10000; ++i) {
+            map[i].push_back(round);
+        }
+        for (int i = 0; i < 10000; i += 2) {
+            map.erase(i);
+        }
+    }
+    ASSERT_EQ(5000u, map.size());
+    int expected = 1;
+    for (const auto &pair : map) {
+        ASSERT_EQ(expected, pair.first);
+        ASSERT_EQ(3u, pair.second.size());
+        expected += 2;
+    }
+}
+
+}  // namespace unittest
@@ -0,0 +1,63 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "clustering/immediate_consistency/backfill_throttler.hpp"
+
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+/* `fixed_pace_backfill_throttler_t` lets every backfill in right away and paces them at
+whatever rate the test sets. */
+class fixed_pace_backfill_throttler_t : public backfill_throttler_t {
+public:
+    explicit fixed_pace_backfill_throttler_t(int64_t bytes_per_sec) {
+        set_pace(bytes_per_sec);
+    }
+    using backfill_throttler_t::set_pace;
+    using backfill_throttler_t::get_paced_bytes;
+private:
+    void enter(lock_t *, signal_t *) { }
+    void exit(lock_t *) { }
+};
+
+TPTEST(BackfillThrottler, UnlimitedPace) {
+    fixed_pace_backfill_throttler_t throttler(0);
+    backfill_throttler_t::priority_t priority;
+    priority.critical = backfill_throttler_t::priority_t::critical_t::NO;
+    priority.num_changes = 0;
+    cond_t non_interruptor;
+    backfill_throttler_t::lock_t lock(&throttler, priority, &non_interruptor);
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_TRUE(lock.pace(MEGABYTE));
+    }
+    EXPECT_EQ(1000 * MEGABYTE, throttler.get_paced_bytes());
+}
+
+TPTEST(BackfillThrottler, LimitedPace) {
+    fixed_pace_backfill_throttler_t throttler(10 * MEGABYTE);
+    backfill_throttler_t::priority_t priority;
+    priority.critical = backfill_throttler_t::priority_t::critical_t::NO;
+    priority.num_changes = 0;
+    cond_t non_interruptor;
+    backfill_throttler_t::lock_t lock(&throttler, priority, &non_interruptor);
+
+    /* A new backfill hasn't saved up any budget, so it has to wait right away and then
+    gets about a tenth of a second's worth. */
+    EXPECT_FALSE(lock.pace(KILOBYTE));
+    ticks_t start = get_ticks();
+    lock.wait_for_pace(&non_interruptor);
+    EXPECT_GE(get_ticks().nanos - start.nanos, 50 * MILLION);
+    int64_t applied = 0;
+    while (lock.pace(100 * KILOBYTE)) {
+        applied += 100 * KILOBYTE;
+        ASSERT_LT(applied, 10 * MEGABYTE);
+    }
+    EXPECT_GE(applied, 500 * KILOBYTE);
+
+    /* Lifting the limit lets it go on right away. */
+    throttler.set_pace(0);
+    lock.wait_for_pace(&non_interruptor);
+    EXPECT_TRUE(lock.pace(10 * MEGABYTE));
+}
+
+}  // namespace unittest
@@ -2,6 +2,7 @@
 #include "buffer_cache/alt.hpp"
 #include "buffer_cache/blob.hpp"
 #include "buffer_cache/cache_balancer.hpp"
+#include "buffer_cache/serialize_onto_blob.hpp"
 #include "containers/buffer_group.hpp"
 #include "containers/scoped.hpp"
 #include "math.hpp"
@@ -123,6 +124,22 @@ public:
         check(txn);
     }
 
+    bool patch_in_place(txn_t *txn, const std::string &x) {
+        SCOPED_TRACE(strprintf("patch_in_place (%zu)", x.size()));
+        write_message_t wm;
+        wm.append(x.data(), x.size());
+        bool res = patch_blob_in_place(buf_parent_t(txn), &blob_, wm);
+        if (res) {
+            expected_ = x;
+        }
+        check(txn);
+        return res;
+    }
+
+    const std::string &contents() const {
+        return expected_;
+    }
+
     void clear(txn_t *txn) {
         SCOPED_TRACE("clear");
         blob_.clear(buf_parent_t(txn));
@@ -269,6 +286,34 @@ void combinations_test(cache_t *cache) {
     }
 }
 
+void patch_in_place_test(cache_t *cache) {
+    SCOPED_TRACE("patch_in_place_test");
+    cache_conn_t cache_conn(cache);
+    txn_t txn(&cache_conn, write_durability_t::SOFT, 0);
+
+    for (int64_t size : { int64_t(100), int64_t(size_after_magic * 5 + 17) }) {
+        blob_tracker_t tk(251);
+        tk.append(&txn, std::string(size, 'a'));
+
+        std::string x = tk.contents();
+        EXPECT_TRUE(tk.patch_in_place(&txn, x));
+        x[0] = 'b';
+        x[size / 2] = 'c';
+        x[size - 1] = 'd';
+        EXPECT_TRUE(tk.patch_in_place(&txn, x));
+        if (size > size_after_magic) {
+            // Across a block boundary
+            x.replace(size_after_magic - 2, 4, "eeee");
+            EXPECT_TRUE(tk.patch_in_place(&txn, x));
+        }
+
+        EXPECT_FALSE(tk.patch_in_place(&txn, x + "f"));
+        EXPECT_FALSE(tk.patch_in_place(&txn, x.substr(1)));
+        tk.clear(&txn);
+    }
+
+    txn.commit();
+}
 
 void run_tests(cache_t *cache) {
     // The tests above hard-code constants related to these numbers.
@@ -282,6 +327,7 @@ void run_tests(cache_t *cache) {
     small_value_test(cache);
     small_value_boundary_test(cache);
     combinations_test(cache);
+    patch_in_place_test(cache);
 }
 
 TPTEST(BlobTest, AllTests) {
@@ -16,7 +16,12 @@ namespace unittest {
 
 class map_filler_callback_t : public depth_first_traversal_callback_t {
 public:
-    explicit map_filler_callback_t(std::map<store_key_t, std::string> *m_out) : m_out_(m_out) { }
+    map_filler_callback_t(std::map<store_key_t, std::string> *m_out, bool prefetch)
+        : m_out_(m_out), prefetch_(prefetch) { }
+
+    bool prefetch_child(UNUSED repli_timestamp_t timestamp) {
+        return prefetch_;
+    }
 
     continue_bool_t handle_pair(scoped_key_value_t &&keyvalue, UNUSED signal_t *interruptor) {
         store_key_t store_key(keyvalue.key());
@@ -33,6 +38,7 @@ public:
 
 private:
     std::map<store_key_t, std::string> *m_out_;
+    bool prefetch_;
     scoped_ptr_t<store_key_t> last_key;
 };
 
@@ -214,13 +220,15 @@ public:
         remove(key, repli_timestamp_t::distant_past);
     }
 
-    void range(const key_range_t &_range) {
+    // Traverses `_range`, loading children ahead of time if `prefetch` is true.
+    std::map<store_key_t, std::string> traverse(const key_range_t &_range,
+                                                bool prefetch) {
         std::map<store_key_t, std::string> bt_map;
 
         run_txn_fn(false, [&](scoped_ptr_t<real_superblock_t> &&superblock){
             cond_t interruptor;
 
-            map_filler_callback_t filler_cb(&bt_map);
+            map_filler_callback_t filler_cb(&bt_map, prefetch);
 
             btree_depth_first_traversal(
                 superblock.get(),
@@ -232,6 +240,10 @@ public:
                 &interruptor);
         });
 
+        return bt_map;
+    }
+
+    void range(const key_range_t &_range) {
         std::map<store_key_t, std::string> kv_map;
 
         for (auto it = kv.begin(), last = kv.end(); it != last; ++it) {
@@ -240,7 +252,8 @@ public:
             }
         }
 
-        expect_maps_equal(bt_map, kv_map);
+        expect_maps_equal(traverse(_range, false), kv_map);
+        expect_maps_equal(traverse(_range, true), kv_map);
     }
 
     bool should_have(const store_key_t &key) {
@@ -266,24 +279,8 @@ public:
     }
 
     void verify() {
-        std::map<store_key_t, std::string> bt_map;
-
-        run_txn_fn(false, [&](scoped_ptr_t<real_superblock_t> &&superblock){
-            cond_t interruptor;
-
-            map_filler_callback_t filler_cb(&bt_map);
-
-            btree_depth_first_traversal(
-                superblock.get(),
-                key_range_t::universe(),
-                &filler_cb,
-                access_t::read,
-                direction_t::FORWARD,
-                release_superblock_t::RELEASE,
-                &interruptor);
-        });
-
-        expect_maps_equal(bt_map, kv);
+        expect_maps_equal(traverse(key_range_t::universe(), false), kv);
+        expect_maps_equal(traverse(key_range_t::universe(), true), kv);
     }
 
     store_key_t pick_random_key(rng_t *rng) {
@@ -0,0 +1,37 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "clustering/administration/main/cache_size.hpp"
+#include "config/args.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+TEST(CacheSize, ParseCgroupMemoryValue) {
+    uint64_t value;
+    ASSERT_TRUE(parse_cgroup_memory_value("536870912\n", &value));
+    EXPECT_EQ(512 * static_cast<uint64_t>(MEGABYTE), value);
+
+    // No limit, in cgroup v2 and v1
+    EXPECT_FALSE(parse_cgroup_memory_value("max\n", &value));
+    EXPECT_FALSE(parse_cgroup_memory_value("9223372036854771712\n", &value));
+    EXPECT_FALSE(parse_cgroup_memory_value("", &value));
+}
+
+TEST(CacheSize, ParseMemoryPressure) {
+    double pressure;
+    ASSERT_TRUE(parse_memory_pressure(
+        "some avg10=12.50 avg60=3.10 avg300=0.75 total=123456\n"
+        "full avg10=4.00 avg60=1.00 avg300=0.20 total=23456\n",
+        &pressure));
+    EXPECT_EQ(12.5, pressure);
+
+    ASSERT_TRUE(parse_memory_pressure(
+        "full avg10=4.00 avg60=1.00 avg300=0.20 total=23456\n"
+        "some avg10=0.00 avg60=0.00 avg300=0.00 total=0",
+        &pressure));
+    EXPECT_EQ(0.0, pressure);
+
+    EXPECT_FALSE(parse_memory_pressure("", &pressure));
+    EXPECT_FALSE(parse_memory_pressure("some avg60=1.00\n", &pressure));
+}
+
+}  // namespace unittest
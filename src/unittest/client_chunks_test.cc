@@ -0,0 +1,66 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/runtime/coroutines.hpp"
+#include "concurrency/cond_var.hpp"
+#include "rdb_protocol/client_chunks.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+static std::vector<ql::datum_t> make_chunk(double first, size_t size) {
+    std::vector<ql::datum_t> docs;
+    for (size_t i = 0; i < size; ++i) {
+        docs.push_back(ql::datum_t(first + i));
+    }
+    return docs;
+}
+
+TPTEST(ClientChunks, InOrderUntilEmptyChunk) {
+    ql::client_chunks_t chunks;
+    cond_t non_interruptor;
+    EXPECT_TRUE(chunks.push(make_chunk(0, 2), &non_interruptor));
+    EXPECT_TRUE(chunks.push(make_chunk(2, 1), &non_interruptor));
+    EXPECT_TRUE(chunks.push(std::vector<ql::datum_t>(), &non_interruptor));
+    EXPECT_FALSE(chunks.push(make_chunk(3, 1), &non_interruptor));
+
+    EXPECT_EQ(make_chunk(0, 2), chunks.pop(&non_interruptor));
+    EXPECT_EQ(make_chunk(2, 1), chunks.pop(&non_interruptor));
+    EXPECT_FALSE(chunks.has_ended());
+    EXPECT_TRUE(chunks.pop(&non_interruptor).empty());
+    EXPECT_TRUE(chunks.has_ended());
+    EXPECT_TRUE(chunks.pop(&non_interruptor).empty());
+}
+
+TPTEST(ClientChunks, PushWaitsForRoom) {
+    ql::client_chunks_t chunks;
+    cond_t non_interruptor;
+    for (int64_t i = 0; i < ql::CLIENT_CHUNKS_BUFFER_SIZE; ++i) {
+        EXPECT_TRUE(chunks.push(make_chunk(i, 1), &non_interruptor));
+    }
+
+    /* Once the buffer is full, pushing waits until a chunk has been popped. */
+    bool pushed = false;
+    coro_t::spawn_now_dangerously([&]() {
+        EXPECT_TRUE(chunks.push(make_chunk(ql::CLIENT_CHUNKS_BUFFER_SIZE, 1),
+                                &non_interruptor));
+        pushed = true;
+    });
+    coro_t::yield();
+    EXPECT_FALSE(pushed);
+    EXPECT_EQ(make_chunk(0, 1), chunks.pop(&non_interruptor));
+    for (int i = 0; i < 10 && !pushed; ++i) {
+        coro_t::yield();
+    }
+    EXPECT_TRUE(pushed);
+
+    /* Popping waits for a chunk that hasn't been pushed yet. */
+    for (int64_t i = 1; i <= ql::CLIENT_CHUNKS_BUFFER_SIZE; ++i) {
+        EXPECT_EQ(make_chunk(i, 1), chunks.pop(&non_interruptor));
+    }
+    coro_t::spawn_sometime([&]() {
+        EXPECT_TRUE(chunks.push(make_chunk(100, 3), &non_interruptor));
+    });
+    EXPECT_EQ(make_chunk(100, 3), chunks.pop(&non_interruptor));
+}
+
+}  // namespace unittest
@@ -1,4 +1,6 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
+#include <deque>
+
 #include "unittest/gtest.hpp"
 
 #include "clustering/immediate_consistency/local_replicator.hpp"
@@ -188,4 +190,80 @@ TPTEST(ClusteringBranch, Backfill) {
     run_with_primary(&run_backfill_test);
 }
 
+/* The `LaggingDispatchee` test registers a dispatchee that never finishes a write and
+checks that the dispatcher gives up on it once too many writes have queued up, without
+holding up the writes to the primary. */
+
+class lagging_dispatchee_t : public primary_dispatcher_t::dispatchee_t {
+public:
+    lagging_dispatchee_t() : writes_started(0) { }
+    bool is_primary() const {
+        return false;
+    }
+    void do_read(const read_t &, state_timestamp_t, signal_t *, read_response_t *) {
+        unreachable();
+    }
+    void do_write_sync(const write_t &, state_timestamp_t, order_token_t,
+                       write_durability_t, signal_t *, write_response_t *) {
+        unreachable();
+    }
+    void do_write_async(const write_t &, state_timestamp_t, order_token_t,
+                        signal_t *interruptor) {
+        ++writes_started;
+        cond_t never;
+        wait_interruptible(&never, interruptor);
+    }
+    void do_dummy_write(signal_t *, write_response_t *) {
+        unreachable();
+    }
+    size_t max_queued_writes() const {
+        return 10;
+    }
+    void on_lagged_too_far() {
+        lagged_too_far.pulse();
+    }
+    int writes_started;
+    cond_t lagged_too_far;
+};
+
+void run_lagging_dispatchee_test(
+        UNUSED simple_mailbox_cluster_t *cluster,
+        primary_dispatcher_t *dispatcher,
+        UNUSED mock_store_t *store,
+        UNUSED local_replicator_t *local_replicator,
+        order_source_t *order_source) {
+    std::deque<simple_write_callback_t> write_callbacks;
+    lagging_dispatchee_t dispatchee;
+    state_timestamp_t first_timestamp;
+    scoped_ptr_t<primary_dispatcher_t::dispatchee_registration_t> registration(
+        new primary_dispatcher_t::dispatchee_registration_t(
+            dispatcher, &dispatchee, server_id_t::generate_server_id(), 1.0,
+            &first_timestamp));
+
+    const int num_writes = 1000;
+    for (int i = 0; i < num_writes; ++i) {
+        write_callbacks.emplace_back();
+        dispatcher->spawn_write(
+            mock_overwrite(strprintf("key%d", i), "value"),
+            order_source->check_in("run_lagging_dispatchee_test(write)"),
+            &write_callbacks.back());
+    }
+    dispatchee.lagged_too_far.wait_lazily_unordered();
+
+    /* The writes that were queued up for the lagging dispatchee when we gave up on it
+    were never sent to it. */
+    EXPECT_LT(dispatchee.writes_started, num_writes);
+
+    /* Deregistering interrupts the writes that are stuck in the lagging dispatchee.
+    Every write must have been acked by the local replica. */
+    registration.reset();
+    for (simple_write_callback_t &cb : write_callbacks) {
+        cb.wait_lazily_unordered();
+        EXPECT_EQ(1, cb.acks);
+    }
+}
+TPTEST(ClusteringBranch, LaggingDispatchee) {
+    run_with_primary(&run_lagging_dispatchee_test);
+}
+
 }   /* namespace unittest */
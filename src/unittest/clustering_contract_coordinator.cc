@@ -53,6 +53,9 @@ public:
         cs.config.write_ack_config = write_ack_config_t::MAJORITY;
         cs.config.durability = write_durability_t::HARD;
         cs.config.user_data = default_user_data();
+        cs.config.cpu_sharding_factor = CPU_SHARDING_FACTOR;
+        cs.config.block_size = DEFAULT_BTREE_BLOCK_SIZE;
+        cs.config.read_cache = false;
 
         key_range_t::right_bound_t prev_right(store_key_t::min());
         for (const quick_shard_args_t &qs : qss) {
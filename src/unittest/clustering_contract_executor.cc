@@ -105,6 +105,9 @@ public:
     branch_history_manager_t *get_branch_history_manager() {
         return &branch_history_manager;
     }
+    int get_cpu_sharding_factor() {
+        return CPU_SHARDING_FACTOR;
+    }
     store_view_t *get_cpu_sharded_store(size_t i) {
         return stores[i].get();
     }
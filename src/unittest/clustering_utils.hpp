@@ -254,7 +254,9 @@ public:
                                  0,
                                  heartbeat_manager.get_view(),
                                  auth_manager.get_view(),
-                                 nullptr)
+                                 nullptr,
+                                 cluster_compression_t::none,
+                                 1)
         { }
     connectivity_cluster_t *get_connectivity_cluster() {
         return &connectivity_cluster;
@@ -288,10 +290,14 @@ private:
 class test_cluster_run_t {
 public:
     explicit test_cluster_run_t(connectivity_cluster_t *c,
-                                const peer_address_t &canonical_addr = peer_address_t())
+                                const peer_address_t &canonical_addr = peer_address_t(),
+                                cluster_compression_t compression =
+                                    cluster_compression_t::none,
+                                int connections_per_peer = 1)
         : run(c, server_id_t::generate_server_id(),
             get_unittest_addresses(), canonical_addr, 0, ANY_PORT, 0,
-            heartbeat_manager.get_view(), auth_manager.get_view(), nullptr) { }
+            heartbeat_manager.get_view(), auth_manager.get_view(), nullptr,
+            compression, connections_per_peer) { }
 
     operator connectivity_cluster_t::run_t&() {
         return run;
@@ -0,0 +1,318 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "containers/archive/vector_stream.hpp"
+#include "rapidjson/document.h"
+#include "rdb_protocol/compiled_func.hpp"
+#include "rdb_protocol/env.hpp"
+#include "rdb_protocol/error.hpp"
+#include "rdb_protocol/filter_kernel.hpp"
+#include "rdb_protocol/func.hpp"
+#include "rdb_protocol/minidriver.hpp"
+#include "rdb_protocol/sym.hpp"
+#include "rdb_protocol/wire_func.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+ql::datum_t parse_row(const char *json) {
+    rapidjson::Document doc;
+    doc.Parse(json);
+    return ql::to_datum(doc, ql::configured_limits_t(), reql_version_t::LATEST);
+}
+
+std::vector<ql::datum_t> make_rows() {
+    const char *rows[] = {
+        "{\"a\": 1, \"b\": 2}",
+        "{\"a\": 3, \"b\": 2}",
+        "{\"a\": 2, \"b\": null}",
+        "{\"a\": \"str\", \"b\": [1, 2]}",
+        "{\"a\": {\"c\": 1}, \"b\": 2}",
+        "{\"a\": [{\"c\": 1}], \"b\": 2}",
+        "{\"a\": 1e308, \"b\": 1e308}",
+        "{\"b\": 2}",
+        "{}",
+        "[1, 2, 3]",
+        "null",
+        "5",
+        "{\"a\": {\"$reql_type$\": \"BINARY\", \"data\": \"\"}}"
+    };
+    std::vector<ql::datum_t> ret;
+    for (const char *row : rows) {
+        ret.push_back(parse_row(row));
+    }
+    return ret;
+}
+
+counted_t<const ql::func_t> make_func(const ql::raw_term_t &body, const ql::sym_t &arg) {
+    return ql::wire_func_t(body, make_vector(arg)).compile_wire_func();
+}
+
+/* Evaluates `f` by walking its term tree.  Passing an eval flag makes
+`reql_func_t::call()` skip the compiled body; `LITERAL_OK` makes no difference to the
+functions we test. */
+ql::datum_t interpret(ql::env_t *env,
+                      const counted_t<const ql::func_t> &f,
+                      const ql::datum_t &arg,
+                      ql::base_exc_t::type_t *error_out) {
+    try {
+        return f->call(env, arg, ql::LITERAL_OK)->as_datum();
+    } catch (const ql::base_exc_t &e) {
+        *error_out = e.get_type();
+        return ql::datum_t();
+    }
+}
+
+/* Checks that whenever the compiled function produces a result, it's the same as the
+interpreter's. */
+void check_compiled_func(ql::env_t *env,
+                         const ql::raw_term_t &body,
+                         const ql::sym_t &arg) {
+    counted_t<const ql::compiled_func_t> compiled
+        = ql::compiled_func_t::compile(make_vector(arg), body);
+    ASSERT_TRUE(compiled.has());
+    counted_t<const ql::func_t> f = make_func(body, arg);
+
+    std::vector<ql::datum_t> rows = make_rows();
+    std::vector<ql::compiled_func_t::result_t> batch_results;
+    compiled->call_batch(rows, env->limits(), &batch_results);
+    ASSERT_EQ(rows.size(), batch_results.size());
+
+    for (size_t i = 0; i < rows.size(); ++i) {
+        SCOPED_TRACE(rows[i].print());
+        ql::base_exc_t::type_t error = ql::base_exc_t::INTERNAL;
+        ql::datum_t expected = interpret(env, f, rows[i], &error);
+        ql::compiled_func_t::result_t res = compiled->call(rows[i], env->limits());
+        ASSERT_EQ(res.status, batch_results[i].status);
+        switch (res.status) {
+        case ql::compiled_func_t::status_t::OK:
+            ASSERT_TRUE(expected.has());
+            ASSERT_EQ(expected, res.value);
+            ASSERT_EQ(expected, batch_results[i].value);
+            break;
+        case ql::compiled_func_t::status_t::NON_EXISTENCE:
+            ASSERT_FALSE(expected.has());
+            ASSERT_EQ(ql::base_exc_t::NON_EXISTENCE, error);
+            break;
+        case ql::compiled_func_t::status_t::UNKNOWN:
+            break;
+        default:
+            unreachable();
+        }
+    }
+}
+
+TPTEST(CompiledFunc, AgreesWithInterpreter) {
+    cond_t interruptor;
+    ql::env_t env(&interruptor,
+                  ql::return_empty_normal_batches_t::NO,
+                  reql_version_t::LATEST);
+    ql::sym_t x(1);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+
+    check_compiled_func(&env, r.var(x).root_term(), x);
+    check_compiled_func(&env, r.var(x)["a"].root_term(), x);
+    check_compiled_func(&env, r.var(x)["a"]["c"].root_term(), x);
+    check_compiled_func(&env, r.array(r.var(x)["a"], r.var(x)["b"]).root_term(), x);
+    check_compiled_func(&env, (r.var(x)["a"] + 1.0).root_term(), x);
+    check_compiled_func(&env, (r.var(x)["a"] + r.var(x)["b"]).root_term(), x);
+    check_compiled_func(
+        &env, r.var(x)["a"].call(Term::MUL, r.var(x)["b"], 2.0).root_term(), x);
+    check_compiled_func(
+        &env, r.var(x)["a"].call(Term::SUB, r.var(x)["missing"]).root_term(), x);
+    check_compiled_func(&env, (r.var(x)["a"] == 1.0).root_term(), x);
+    check_compiled_func(&env, (r.var(x)["a"] && r.var(x)["b"]).root_term(), x);
+    check_compiled_func(
+        &env, r.var(x).call(Term::PLUCK, "a", "missing").root_term(), x);
+}
+
+TEST(CompiledFunc, RejectsUnsupportedTerms) {
+    ql::sym_t x(1);
+    ql::sym_t y(2);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+
+    ASSERT_FALSE(ql::compiled_func_t::compile(
+        make_vector(x), r.var(x)["a"].call(Term::DIV, 2.0).root_term()).has());
+    ASSERT_FALSE(ql::compiled_func_t::compile(
+        make_vector(x), r.var(x).nth(0.0).root_term()).has());
+    // Functions of two arguments aren't compiled.
+    ASSERT_FALSE(ql::compiled_func_t::compile(
+        make_vector(x, y), (r.var(x) + r.var(y)).root_term()).has());
+}
+
+/* Checks that whenever the kernel decides a row, it agrees with the interpreter. */
+void check_filter_kernel(ql::env_t *env,
+                         const ql::raw_term_t &body,
+                         const ql::sym_t &arg) {
+    counted_t<const ql::func_t> f = make_func(body, arg);
+    scoped_ptr_t<ql::filter_kernel_t> kernel = ql::filter_kernel_t::compile(f);
+    ASSERT_TRUE(kernel.has());
+
+    std::vector<ql::datum_t> rows = make_rows();
+    std::vector<ql::filter_kernel_t::result_t> results;
+    kernel->eval(rows, env->limits(), &results);
+    ASSERT_EQ(rows.size(), results.size());
+
+    for (size_t i = 0; i < rows.size(); ++i) {
+        SCOPED_TRACE(rows[i].print());
+        ql::base_exc_t::type_t error = ql::base_exc_t::INTERNAL;
+        ql::datum_t expected = interpret(env, f, rows[i], &error);
+        switch (results[i]) {
+        case ql::filter_kernel_t::result_t::MATCH:
+            ASSERT_TRUE(expected.has());
+            ASSERT_TRUE(expected.as_bool());
+            break;
+        case ql::filter_kernel_t::result_t::NO_MATCH:
+            ASSERT_TRUE(expected.has());
+            ASSERT_FALSE(expected.as_bool());
+            break;
+        case ql::filter_kernel_t::result_t::NON_EXISTENCE:
+            ASSERT_FALSE(expected.has());
+            ASSERT_EQ(ql::base_exc_t::NON_EXISTENCE, error);
+            break;
+        case ql::filter_kernel_t::result_t::UNKNOWN:
+            break;
+        default:
+            unreachable();
+        }
+    }
+}
+
+TPTEST(FilterKernel, AgreesWithInterpreter) {
+    cond_t interruptor;
+    ql::env_t env(&interruptor,
+                  ql::return_empty_normal_batches_t::NO,
+                  reql_version_t::LATEST);
+    ql::sym_t x(1);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+
+    check_filter_kernel(&env, (r.var(x)["a"] == 1.0).root_term(), x);
+    check_filter_kernel(&env, (r.var(x)["a"] < r.var(x)["b"]).root_term(), x);
+    check_filter_kernel(&env, (r.var(x).bracket("a") >= 2.0).root_term(), x);
+    check_filter_kernel(&env, (r.var(x)["a"]["c"] == 1.0).root_term(), x);
+    check_filter_kernel(&env, (!(r.var(x)["a"] <= 1.0)).root_term(), x);
+    check_filter_kernel(
+        &env, r.var(x)["a"].call(Term::NE, 1.0, 2.0).root_term(), x);
+    check_filter_kernel(
+        &env, r.var(x).has_fields("a", "b").root_term(), x);
+    check_filter_kernel(
+        &env, ((r.var(x)["a"] > 1.0) && r.var(x).has_fields("b")).root_term(), x);
+    check_filter_kernel(
+        &env, r.boolean(false).call(Term::OR,
+                                    r.var(x)["missing"] == 1.0,
+                                    r.var(x)["b"] == 2.0).root_term(), x);
+    check_filter_kernel(
+        &env, r.expr(1.0).call(Term::EQ, 2.0, r.var(x)["missing"]).root_term(), x);
+}
+
+TEST(FilterKernel, RejectsUnsupportedTerms) {
+    ql::sym_t x(1);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+
+    counted_t<const ql::func_t> division = make_func(
+        (r.var(x)["a"].call(Term::DIV, 1.0) == 2.0).root_term(), x);
+    ASSERT_FALSE(ql::filter_kernel_t::compile(division).has());
+
+    // Objects are matched against the row rather than converted to booleans.
+    counted_t<const ql::func_t> object = make_func(
+        r.object(r.optarg("a", 1.0)).root_term(), x);
+    ASSERT_FALSE(ql::filter_kernel_t::compile(object).has());
+}
+
+TEST(SindexKeyProjection, RowFromKey) {
+    ql::sym_t x(1);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+
+    counted_t<const ql::func_t> sindex_func = make_func(
+        r.array(r.var(x)["a"], r.var(x)["b"]).root_term(), x);
+    scoped_ptr_t<ql::sindex_key_projection_t> projection =
+        ql::sindex_key_projection_t::make(sindex_func, reql_version_t::LATEST);
+    ASSERT_TRUE(projection.has());
+
+    ql::datum_t sindex_val = parse_row("[1, \"x\"]");
+    store_key_t key(sindex_val.print_secondary(
+        reql_version_t::LATEST, store_key_t("pk"), r_nullopt));
+    EXPECT_EQ(parse_row("{\"a\": 1, \"b\": \"x\"}"), projection->row_from_key(key));
+
+    EXPECT_TRUE(projection->covers(
+        make_func(r.var(x).call(Term::PLUCK, "b", "a").root_term(), x)));
+    EXPECT_TRUE(projection->covers(
+        make_func((r.var(x)["a"] > 0.0).root_term(), x)));
+    EXPECT_FALSE(projection->covers(
+        make_func(r.var(x).call(Term::PLUCK, "a", "c").root_term(), x)));
+    EXPECT_FALSE(projection->covers(make_func(r.var(x).root_term(), x)));
+
+    // Functions that don't just pick out fields can't be undone.
+    EXPECT_FALSE(ql::sindex_key_projection_t::make(
+        make_func((r.var(x)["a"] + 1.0).root_term(), x),
+        reql_version_t::LATEST).has());
+}
+
+TPTEST(PartialIndexFunc, OnlyMapsAcceptedRows) {
+    cond_t interruptor;
+    ql::env_t env(&interruptor,
+                  ql::return_empty_normal_batches_t::NO,
+                  reql_version_t::LATEST);
+    ql::sym_t x(1), y(2);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+
+    counted_t<const ql::func_t> partial = ql::new_partial_index_func(
+        make_func(r.var(x)["a"].root_term(), x),
+        make_func((r.var(y)["b"] == 2.0).root_term(), y),
+        ql::backtrace_id_t::empty());
+
+    // The function has to survive being stored with the index.
+    write_message_t wm;
+    serialize<cluster_version_t::LATEST_DISK>(&wm, ql::map_wire_func_t(partial));
+    vector_stream_t stream;
+    ASSERT_EQ(0, send_write_message(&stream, &wm));
+    vector_read_stream_t read_stream(std::move(stream.vector()));
+    ql::map_wire_func_t deserialized;
+    ASSERT_EQ(archive_result_t::SUCCESS,
+              deserialize<cluster_version_t::LATEST_DISK>(&read_stream, &deserialized));
+
+    for (const counted_t<const ql::func_t> &f :
+             {partial, deserialized.compile_wire_func()}) {
+        EXPECT_EQ(ql::datum_t(1.0),
+                  f->call(&env, parse_row("{\"a\": 1, \"b\": 2}"))->as_datum());
+        EXPECT_EQ(ql::datum_t::null(),
+                  f->call(&env, parse_row("{\"a\": 3, \"b\": 1}"))->as_datum());
+        EXPECT_THROW(f->call(&env, parse_row("{\"b\": 2}")), ql::base_exc_t);
+    }
+}
+
+TEST(FieldsRead, TopLevelFields) {
+    ql::sym_t x(1), y(2);
+    ql::minidriver_t r(ql::backtrace_id_t::empty());
+    std::set<datum_string_t> fields;
+
+    ASSERT_TRUE(ql::get_top_level_fields_read(
+        make_func((r.var(x)["a"] + r.var(x)["b"]["c"]).root_term(), x), &fields));
+    EXPECT_EQ((std::set<datum_string_t>{datum_string_t("a"), datum_string_t("b")}),
+              fields);
+
+    ASSERT_TRUE(ql::get_top_level_fields_read(
+        make_func(r.var(x).call(Term::PLUCK, "d", "e").root_term(), x), &fields));
+    EXPECT_EQ((std::set<datum_string_t>{datum_string_t("d"), datum_string_t("e")}),
+              fields);
+
+    // A partial index also depends on the fields its filter reads.
+    counted_t<const ql::func_t> partial = ql::new_partial_index_func(
+        make_func(r.var(x)["a"].root_term(), x),
+        make_func((r.var(y)["status"] == "open").root_term(), y),
+        ql::backtrace_id_t::empty());
+    ASSERT_TRUE(ql::get_top_level_fields_read(partial, &fields));
+    EXPECT_EQ((std::set<datum_string_t>{datum_string_t("a"),
+                                        datum_string_t("status")}),
+              fields);
+
+    // Functions that look at the whole row, or pick fields by computed names, don't
+    // give a set of fields.
+    EXPECT_FALSE(ql::get_top_level_fields_read(
+        make_func(r.var(x).root_term(), x), &fields));
+    EXPECT_FALSE(ql::get_top_level_fields_read(
+        make_func(r.var(x).call(Term::KEYS).root_term(), x), &fields));
+    EXPECT_FALSE(ql::get_top_level_fields_read(
+        make_func(r.var(x)[r.var(x)["name"]].root_term(), x), &fields));
+}
+
+}  // namespace unittest
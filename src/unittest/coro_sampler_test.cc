@@ -0,0 +1,60 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/runtime/coro_sampler.hpp"
+#include "arch/runtime/coroutines.hpp"
+#include "concurrency/pmap.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+static uint64_t total_resumes(const coro_sampler_t::report_t &report) {
+    uint64_t resumes = 0;
+    for (const auto &site : report.spawn_sites) {
+        resumes += site.resumes;
+    }
+    return resumes;
+}
+
+TEST(CoroSamplerTest, Sampling) {
+    run_in_thread_pool([&]() {
+        coro_sampler_t::set_enabled(true);
+        pmap(100, [](int64_t) {
+            for (int i = 0; i < 2 * CORO_SAMPLER_YIELD_SAMPLE_INTERVAL; ++i) {
+                coro_t::yield();
+            }
+        });
+        coro_sampler_t::set_enabled(false);
+
+        coro_sampler_t::report_t report = coro_sampler_t::get_report(3);
+        EXPECT_FALSE(report.enabled);
+        EXPECT_LT(0.0, report.sampling_secs);
+        ASSERT_FALSE(report.spawn_sites.empty());
+        // Every yield above is followed by a resume.
+        EXPECT_LE(static_cast<uint64_t>(100 * 2 * CORO_SAMPLER_YIELD_SAMPLE_INTERVAL),
+                  total_resumes(report));
+        bool found_yield_point = false;
+        for (size_t i = 0; i < report.spawn_sites.size(); ++i) {
+            const coro_sampler_t::spawn_site_t &site = report.spawn_sites[i];
+            EXPECT_LE(site.max_running_secs, site.running_secs);
+            EXPECT_GE(3u, site.yield_points.size());
+            found_yield_point |= !site.yield_points.empty();
+            if (i > 0) {
+                EXPECT_GE(report.spawn_sites[i - 1].running_secs, site.running_secs);
+            }
+        }
+        EXPECT_TRUE(found_yield_point);
+
+        // Samples stay around after the sampler is turned off...
+        coro_t::yield();
+        EXPECT_EQ(total_resumes(report),
+                  total_resumes(coro_sampler_t::get_report(3)));
+
+        // ... but turning it on again starts from scratch.
+        coro_sampler_t::set_enabled(true);
+        coro_sampler_t::set_enabled(false);
+        EXPECT_GT(total_resumes(report),
+                  total_resumes(coro_sampler_t::get_report(3)));
+    });
+}
+
+}  // namespace unittest
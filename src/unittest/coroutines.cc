@@ -2,8 +2,12 @@
 
 #include "arch/runtime/coroutines.hpp"
 #include "arch/runtime/runtime.hpp"
+#include "arch/runtime/starter.hpp"
+#include "arch/timing.hpp"
 #include "concurrency/auto_drainer.hpp"
+#include "concurrency/pmap.hpp"
 #include "config/args.hpp"
+#include "time.hpp"
 #include "unittest/gtest.hpp"
 #include "unittest/unittest_utils.hpp"
 #include "utils.hpp"
@@ -83,6 +87,108 @@ TEST(CoroutinesTest, OnThreadOrdering) {
     }, num_threads);
 }
 
+TEST(CoroutinesTest, OnThreadManySenders) {
+    // Tests that `on_thread_t` preserves ordering when many threads are switching
+    // coroutines onto the same thread at the same time
+    int num_threads = 8;
+    int num_coros = 500; // per sending thread
+    run_in_thread_pool([&]() {
+        std::vector<int> arrived(num_threads, 0);
+        pmap(num_threads, [&](int sender) {
+            on_thread_t sender_thread((threadnum_t(sender)));
+            int returned = 0;
+            cond_t done;
+            for (int i = 0; i < num_coros; ++i) {
+                coro_t::spawn_later_ordered([&, sender, i]() {
+                    {
+                        on_thread_t t((threadnum_t(0)));
+                        EXPECT_EQ(i, arrived[sender]);
+                        ++arrived[sender];
+                    }
+                    ++returned;
+                    if (returned == num_coros) {
+                        done.pulse();
+                    }
+                });
+            }
+            done.wait_lazily_unordered();
+        });
+        for (int i = 0; i < num_threads; ++i) {
+            ASSERT_EQ(num_coros, arrived[i]);
+        }
+    }, num_threads);
+}
+
+TEST(CoroutinesTest, EventLoopSpin) {
+    // Thread switches and timers keep working when idle threads poll before sleeping
+    int num_threads = 2;
+    ::run_in_thread_pool([&]() {
+        for (int i = 0; i < 1000; ++i) {
+            on_thread_t t((threadnum_t(i % num_threads)));
+            EXPECT_EQ(i % num_threads, get_thread_id().threadnum);
+        }
+        // Long enough for the threads to stop spinning and go to sleep
+        ticks_t start = get_ticks();
+        nap(20);
+        EXPECT_LE(20 * MILLION, get_ticks().nanos - start.nanos);
+        on_thread_t t((threadnum_t(1)));
+        EXPECT_EQ(1, get_thread_id().threadnum);
+    }, num_threads, false, 500);
+}
+
+// Uses up about `depth` kilobytes of stack, and returns something that depends on all
+// of it so that the compiler can't optimize it away.
+static int use_stack(int depth) {
+    volatile char buffer[1024];
+    for (size_t i = 0; i < sizeof(buffer); ++i) {
+        buffer[i] = static_cast<char>(i + depth);
+    }
+    int res = depth == 0 ? 0 : use_stack(depth - 1);
+    for (size_t i = 0; i < sizeof(buffer); i += 64) {
+        res += buffer[i];
+    }
+    return res;
+}
+
+TEST(CoroutinesTest, IdleStacks) {
+    // Tests that the coroutines are still intact after the scheduler releases the
+    // unused parts of their stacks. There are more coroutines here than can have
+    // protected stacks, so most of them will be released while they are waiting.
+    int num_coros = 2000;
+    run_in_thread_pool([&]() {
+        cond_t go;
+        int waiting = 0;
+        int finished = 0;
+        cond_t all_finished;
+        const int expected = use_stack(32);
+        for (int i = 0; i < num_coros; ++i) {
+            coro_t::spawn_sometime([&, i]() {
+                char data[1000];
+                for (size_t j = 0; j < sizeof(data); ++j) {
+                    data[j] = static_cast<char>(i * j);
+                }
+                EXPECT_EQ(expected, use_stack(32));
+                ++waiting;
+                go.wait_lazily_unordered();
+                for (size_t j = 0; j < sizeof(data); ++j) {
+                    EXPECT_EQ(static_cast<char>(i * j), data[j]);
+                }
+                // The stack must still be usable all the way down.
+                EXPECT_EQ(expected, use_stack(32));
+                ++finished;
+                if (finished == num_coros) {
+                    all_finished.pulse();
+                }
+            });
+        }
+        while (waiting < num_coros) {
+            coro_t::yield();
+        }
+        go.pulse();
+        all_finished.wait_lazily_unordered();
+    });
+}
+
 TEST(CoroutinesTest, NotifyNow) {
     // Test that `spawn_now_dangerously` doesn't block`
     run_in_thread_pool([&]() {
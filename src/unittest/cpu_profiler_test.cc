@@ -0,0 +1,48 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/runtime/cpu_profiler.hpp"
+#include "time.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+static void burn_cpu(double secs) {
+    ticks_t start = get_ticks();
+    volatile uint64_t sum = 0;
+    while (ticks_to_secs(ticks_t{get_ticks().nanos - start.nanos}) < secs) {
+        for (int i = 0; i < 1000; ++i) {
+            sum = sum + i;
+        }
+    }
+}
+
+TEST(CpuProfilerTest, Sampling) {
+    run_in_thread_pool([&]() {
+        cpu_profiler_t::start();
+        burn_cpu(0.5);
+        cpu_profiler_t::stop();
+
+        cpu_profiler_t::status_t status = cpu_profiler_t::get_status();
+        EXPECT_FALSE(status.running);
+        EXPECT_LE(0.5, status.sampling_secs);
+        EXPECT_LT(0u, status.samples);
+        EXPECT_EQ(0u, status.dropped_samples);
+
+        // We were running in a coroutine most of the time.
+        std::string folded = cpu_profiler_t::get_folded_stacks();
+        ASSERT_FALSE(folded.empty());
+        EXPECT_NE(std::string::npos, folded.find("[coroutine "));
+        EXPECT_EQ('\n', folded.back());
+
+        // Samples stay around after the profiler is stopped...
+        burn_cpu(0.1);
+        EXPECT_EQ(status.samples, cpu_profiler_t::get_status().samples);
+
+        // ... but starting it again starts from scratch.
+        cpu_profiler_t::start();
+        cpu_profiler_t::stop();
+        EXPECT_GT(status.samples, cpu_profiler_t::get_status().samples);
+    });
+}
+
+}  // namespace unittest
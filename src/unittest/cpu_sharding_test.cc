@@ -0,0 +1,42 @@
+// Copyright 2010-2015 RethinkDB, all rights reserved.
+#include "clustering/table_contract/cpu_sharding.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+TEST(CpuShardingTest, SubspacesPartitionHashSpace) {
+    for (int factor = 1; factor <= MAX_CPU_SHARDING_FACTOR; ++factor) {
+        SCOPED_TRACE(factor);
+        uint64_t expected_beg = 0;
+        for (int i = 0; i < factor; ++i) {
+            region_t subspace = cpu_sharding_subspace(i, factor);
+            ASSERT_EQ(expected_beg, subspace.beg);
+            ASSERT_LT(subspace.beg, subspace.end);
+            ASSERT_TRUE(subspace.inner == key_range_t::universe());
+            ASSERT_EQ(i, get_cpu_shard_number(subspace, factor));
+            ASSERT_EQ(i, get_cpu_shard_approx_number(subspace, factor));
+            expected_beg = subspace.end;
+        }
+        ASSERT_EQ(HASH_REGION_HASH_SIZE, expected_beg);
+
+        /* Regions inside the last CPU shard's rounding remainder still map to the last
+        CPU shard. */
+        region_t tail(HASH_REGION_HASH_SIZE - 1, HASH_REGION_HASH_SIZE,
+                      key_range_t::universe());
+        ASSERT_EQ(factor - 1, get_cpu_shard_approx_number(tail, factor));
+    }
+}
+
+TEST(CpuShardingTest, DefaultFactorIsStable) {
+    /* Tables created before the number of CPU shards became configurable rely on
+    these exact boundaries. */
+    for (int i = 0; i < CPU_SHARDING_FACTOR; ++i) {
+        region_t subspace = cpu_sharding_subspace(i);
+        region_t explicit_subspace = cpu_sharding_subspace(i, CPU_SHARDING_FACTOR);
+        ASSERT_EQ(explicit_subspace.beg, subspace.beg);
+        ASSERT_EQ(explicit_subspace.end, subspace.end);
+        ASSERT_EQ((HASH_REGION_HASH_SIZE / CPU_SHARDING_FACTOR) * i, subspace.beg);
+    }
+}
+
+}  // namespace unittest
@@ -0,0 +1,61 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/datum_hash_map.hpp"
+#include "rdb_protocol/pseudo_time.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+TEST(DatumHashMap, HashAgreesWithEquality) {
+    ql::datum_t zero(0.0);
+    ql::datum_t negative_zero(-0.0);
+    ASSERT_EQ(zero, negative_zero);
+    EXPECT_EQ(optional_datum_hash(zero), optional_datum_hash(negative_zero));
+
+    // Times compare by their epoch time only, whatever their timezone.
+    ql::datum_t utc = ql::pseudo::make_time(1000.0, "+00:00");
+    ql::datum_t pst = ql::pseudo::make_time(1000.0, "-08:00");
+    ASSERT_EQ(utc, pst);
+    EXPECT_EQ(optional_datum_hash(utc), optional_datum_hash(pst));
+
+    ql::datum_t arr(std::vector<ql::datum_t>{zero, ql::datum_t("a")},
+                    ql::configured_limits_t::unlimited);
+    ql::datum_t arr2(std::vector<ql::datum_t>{negative_zero, ql::datum_t("a")},
+                     ql::configured_limits_t::unlimited);
+    EXPECT_EQ(optional_datum_hash(arr), optional_datum_hash(arr2));
+}
+
+TEST(DatumHashMap, InsertAndPop) {
+    ql::datum_hash_map_t<int> map;
+    const int num_keys = 1000;
+    for (int i = 0; i < num_keys; ++i) {
+        auto res = map.insert(std::make_pair(ql::datum_t(static_cast<double>(i)), i));
+        EXPECT_TRUE(res.second);
+    }
+    // The empty datum is a key like any other.
+    EXPECT_TRUE(map.insert(std::make_pair(ql::datum_t(), -1)).second);
+    ASSERT_EQ(static_cast<size_t>(num_keys + 1), map.size());
+
+    for (int i = 0; i < num_keys; ++i) {
+        auto res = map.insert(std::make_pair(ql::datum_t(static_cast<double>(i)), 0));
+        ASSERT_FALSE(res.second);
+        EXPECT_EQ(i, res.first->second);
+    }
+    EXPECT_EQ(-1, map[ql::datum_t()]);
+
+    map.pop_back();
+    EXPECT_EQ(static_cast<size_t>(num_keys), map.size());
+    EXPECT_TRUE(map.insert(std::make_pair(ql::datum_t(), -2)).second);
+    EXPECT_EQ(-2, map[ql::datum_t()]);
+
+    // Iteration is in insertion order.
+    int expected = 0;
+    for (auto &&pair : map) {
+        if (expected < num_keys) {
+            EXPECT_EQ(expected, pair.second);
+        }
+        ++expected;
+    }
+    EXPECT_EQ(num_keys + 1, expected);
+}
+
+}  // namespace unittest
@@ -4,6 +4,7 @@
 #include "rdb_protocol/datum.hpp"
 #include "rdb_protocol/datum_string.hpp"
 #include "rdb_protocol/env.hpp"
+#include "rdb_protocol/pseudo_time.hpp"
 #include "unittest/gtest.hpp"
 
 
@@ -205,4 +206,210 @@ TEST(DatumTest, OffsetScaling) {
     }
 }
 
+ql::datum_t serialize_and_deserialize(const ql::datum_t &datum) {
+    string_stream_t write_stream;
+    write_message_t wm;
+    serialize<cluster_version_t::LATEST_OVERALL>(&wm, datum);
+    int write_res = send_write_message(&write_stream, &wm);
+    EXPECT_EQ(0, write_res);
+
+    string_read_stream_t read_stream(std::move(write_stream.str()), 0);
+    ql::datum_t res;
+    archive_result_t deser_res
+        = deserialize<cluster_version_t::LATEST_OVERALL>(&read_stream, &res);
+    EXPECT_EQ(archive_result_t::SUCCESS, deser_res);
+    return res;
+}
+
+// Looks up the fields of a wide object, both in its vector form and in the serialized
+// form that `get_field()` searches without deserializing the keys.
+TEST(DatumTest, GetFieldOfWideObject) {
+    std::map<datum_string_t, ql::datum_t> fields;
+    for (int i = 0; i < 250; ++i) {
+        // Keys that are prefixes of each other, and values of mixed types and sizes
+        // so that the object needs 16 bit offsets.
+        fields[datum_string_t(strprintf("field_%d", i))] = (i % 2 == 0)
+            ? ql::datum_t(static_cast<double>(i))
+            : ql::datum_t(datum_string_t(std::string(i, 'v')));
+    }
+    ql::datum_t object((std::map<datum_string_t, ql::datum_t>(fields)));
+    ql::datum_t buf_object = serialize_and_deserialize(object);
+    ASSERT_TRUE(buf_object.get_buf_ref() != nullptr);
+
+    for (const ql::datum_t &o : {object, buf_object}) {
+        for (const auto &pair : fields) {
+            EXPECT_EQ(pair.second, o.get_field(pair.first));
+            EXPECT_EQ(pair.second, o.get_field(pair.first.to_std().c_str()));
+        }
+        for (const char *missing : {"", "field_", "field_2500", "field_9a", "zzz"}) {
+            EXPECT_FALSE(o.get_field(missing, ql::NOTHROW).has());
+        }
+    }
+
+    ql::datum_t empty = serialize_and_deserialize(
+        ql::datum_t(std::map<datum_string_t, ql::datum_t>()));
+    EXPECT_FALSE(empty.get_field("a", ql::NOTHROW).has());
+}
+
+ql::datum_t parse_json_both_ways(const std::string &json) {
+    std::vector<char> buf(json.begin(), json.end());
+    buf.push_back('\0');
+    rapidjson::ParseResult result;
+    ql::datum_t res = ql::parse_json_to_datum(
+        buf.data(), ql::configured_limits_t::unlimited, &result);
+    EXPECT_FALSE(result.IsError());
+
+    rapidjson::Document doc;
+    doc.Parse(json.c_str());
+    EXPECT_FALSE(doc.HasParseError());
+    EXPECT_EQ(ql::to_datum(doc, ql::configured_limits_t::unlimited,
+                           reql_version_t::LATEST),
+              res);
+    return res;
+}
+
+TEST(DatumTest, InlineStrings) {
+    // Around the largest string that is stored inline
+    for (size_t size : {size_t(0), size_t(1), datum_string_t::MAX_INLINE_SIZE - 1,
+                        datum_string_t::MAX_INLINE_SIZE,
+                        datum_string_t::MAX_INLINE_SIZE + 1, size_t(300)}) {
+        std::string str;
+        for (size_t i = 0; i < size; ++i) {
+            str.push_back(static_cast<char>(i % 256));
+        }
+        datum_string_t s(str);
+        ASSERT_EQ(size, s.size());
+        EXPECT_EQ(str, s.to_std());
+
+        datum_string_t copy(s);
+        EXPECT_EQ(s, copy);
+        datum_string_t moved(std::move(copy));
+        EXPECT_EQ(s, moved);
+        copy = moved;
+        EXPECT_EQ(s, copy);
+        moved = datum_string_t("other");
+        EXPECT_EQ("other", moved.to_std());
+
+        EXPECT_EQ(str + str, concat(s, s).to_std());
+        test_datum_serialization(ql::datum_t(datum_string_t(s)));
+    }
+}
+
+TEST(DatumTest, NumericKeys) {
+    for (double d : {0.0, -0.0, 1.0, -1.0, 0.5, -2.25, 1e-300, 123456789.0,
+                     9007199254740992.0, -9007199254740992.0, 9007199254740994.0,
+                     1e20, -1e300}) {
+        double value = d == 0.0 ? 0.0 : d;
+        uint64_t u;
+        memcpy(&u, &value, sizeof(u));
+        u = (u & (1ULL << 63)) ? ~u : (u ^ (1ULL << 63));
+        std::string expected = strprintf("N%.16" PRIx64 "#%" PR_RECONSTRUCTABLE_DOUBLE,
+                                         u, value);
+        EXPECT_EQ(expected, ql::datum_t(d).print_primary());
+    }
+}
+
+TEST(DatumTest, CompareTimes) {
+    ql::datum_t early = ql::pseudo::make_time(1375115782.24, "+00:00");
+    ql::datum_t late = ql::pseudo::make_time(1375147296.68, "-07:00");
+    ql::datum_t late_utc = ql::pseudo::make_time(1375147296.68, "+00:00");
+    EXPECT_LT(early, late);
+    EXPECT_GT(late, early);
+    // Times are equal if they are the same instant, whatever their time zones.
+    EXPECT_EQ(0, late.cmp(late_utc));
+    EXPECT_EQ(ql::pseudo::time_cmp(early, late), early.cmp(late));
+
+    // Times sort as the PTYPE<TIME> type against other objects.
+    ql::datum_object_builder_t builder;
+    UNUSED bool b = builder.add("epoch_time", ql::datum_t(1.0));
+    ql::datum_t object = std::move(builder).to_datum();
+    EXPECT_LT(object, early);
+}
+
+TEST(DatumTest, ArrayBuilderFromArray) {
+    std::vector<ql::datum_t> elements = {ql::datum_t(1.0), ql::datum_t("two")};
+    ql::datum_t shared(std::vector<ql::datum_t>(elements),
+                       ql::configured_limits_t::unlimited);
+    ql::datum_t copy = shared;
+
+    // Another reference to the array, so it has to be copied.
+    ql::datum_array_builder_t from_shared(std::move(copy),
+                                          ql::configured_limits_t::unlimited);
+    from_shared.add(ql::datum_t::null());
+    EXPECT_EQ(2u, shared.arr_size());
+    EXPECT_EQ(3u, std::move(from_shared).to_datum().arr_size());
+
+    // The only reference, so the elements are taken over.
+    ql::datum_array_builder_t from_unique(std::move(shared),
+                                          ql::configured_limits_t::unlimited);
+    from_unique.add(ql::datum_t::null());
+    ql::datum_t result = std::move(from_unique).to_datum();
+    ASSERT_EQ(3u, result.arr_size());
+    EXPECT_EQ(elements[0], result.get(0));
+    EXPECT_EQ(elements[1], result.get(1));
+    EXPECT_EQ(ql::datum_t::null(), result.get(2));
+}
+
+TEST(DatumTest, ParseJson) {
+    parse_json_both_ways("null");
+    parse_json_both_ways("[1, -2, 3.5, 18446744073709551615, true, false, null]");
+    parse_json_both_ways("{\"a\": {\"b\": [\"c\", {}], \"d\": \"\\u00e9\"}, \"e\": []}");
+
+    // Deep nesting is parsed without recursion.
+    std::string deep = std::string(1000, '[') + std::string(1000, ']');
+    std::vector<char> buf(deep.begin(), deep.end());
+    buf.push_back('\0');
+    rapidjson::ParseResult result;
+    ql::datum_t res = ql::parse_json_to_datum(
+        buf.data(), ql::configured_limits_t::unlimited, &result);
+    ASSERT_FALSE(result.IsError());
+    EXPECT_EQ(ql::datum_t::R_ARRAY, res.get_type());
+
+    char bad[] = "{\"a\": [1, 2}";
+    res = ql::parse_json_to_datum(bad, ql::configured_limits_t::unlimited, &result);
+    EXPECT_TRUE(result.IsError());
+    EXPECT_FALSE(res.has());
+
+    char dup[] = "{\"a\": 1, \"a\": 2}";
+    EXPECT_THROW(
+        ql::parse_json_to_datum(dup, ql::configured_limits_t::unlimited, &result),
+        ql::base_exc_t);
+}
+
+ql::datum_t decode_printed_secondary(const ql::datum_t &value) {
+    std::string key = value.print_secondary(
+        reql_version_t::LATEST, store_key_t("pkey"), r_nullopt);
+    return ql::datum_t::decode_secondary(ql::datum_t::extract_secondary(key));
+}
+
+TEST(DatumTest, DecodeSecondary) {
+    std::vector<ql::datum_t> values = {
+        ql::datum_t(1.5),
+        ql::datum_t(-0.1),
+        ql::datum_t(1e300),
+        ql::datum_t("abc"),
+        ql::datum_t(""),
+        ql::datum_t(datum_string_t(std::string("a\x00b\x01c", 7))),
+        ql::datum_t::boolean(false),
+        ql::datum_t::binary(datum_string_t(std::string("\x00\x01\x02", 3))),
+        ql::datum_t(std::vector<ql::datum_t>(), ql::configured_limits_t::unlimited)
+    };
+    values.push_back(ql::datum_t(
+        std::vector<ql::datum_t>{
+            ql::datum_t("x"),
+            ql::datum_t(std::vector<ql::datum_t>(values.begin(), values.begin() + 3),
+                        ql::configured_limits_t::unlimited),
+            ql::datum_t(std::vector<ql::datum_t>(),
+                        ql::configured_limits_t::unlimited),
+            ql::datum_t(2.0)},
+        ql::configured_limits_t::unlimited));
+    for (const ql::datum_t &value : values) {
+        EXPECT_EQ(value, decode_printed_secondary(value)) << value.print();
+    }
+
+    // Times don't keep their timezone in the key.
+    EXPECT_FALSE(decode_printed_secondary(
+        ql::pseudo::make_time(1000.0, "+00:00")).has());
+}
+
 }  // namespace unittest
@@ -56,8 +56,10 @@ TEST(DiskFormatTest, LbaMetablockMixinT) {
 }
 
 TEST(DiskFormatTest, LbaEntryT) {
-    EXPECT_EQ(0u, offsetof(lba_entry_t, zero_reserved));
+    EXPECT_EQ(0u, offsetof(lba_entry_t, compressed_ser_block_size));
+    EXPECT_EQ(2u, offsetof(lba_entry_t, checksum_low));
     EXPECT_EQ(4u, offsetof(lba_entry_t, ser_block_size));
+    EXPECT_EQ(6u, offsetof(lba_entry_t, checksum_high));
     EXPECT_EQ(8u, offsetof(lba_entry_t, block_id));
     EXPECT_EQ(16u, offsetof(lba_entry_t, recency));
     EXPECT_EQ(24u, offsetof(lba_entry_t, offset));
@@ -69,11 +71,25 @@ TEST(DiskFormatTest, LbaEntryT) {
     ASSERT_TRUE(lba_entry_t::is_padding(&ent));
     flagged_off64_t real = flagged_off64_t::unused();
     real = flagged_off64_t::make(1);
-    ent = lba_entry_t::make(1, repli_timestamp_t::invalid, real, 1234);
+    ent = lba_entry_t::make(1, repli_timestamp_t::invalid, real, 1234, 1234,
+                            NO_BLOCK_CHECKSUM);
     ASSERT_FALSE(lba_entry_t::is_padding(&ent));
+    // Uncompressed blocks keep the field zeroed, like older versions did.
+    EXPECT_EQ(0u, ent.compressed_ser_block_size);
+    EXPECT_EQ(1234u, ent.disk_ser_block_size());
+    // So do blocks without a checksum.
+    EXPECT_EQ(0u, ent.checksum_low);
+    EXPECT_EQ(0u, ent.checksum_high);
+    ent = lba_entry_t::make(1, repli_timestamp_t::invalid, real, 1234, 600,
+                            0xdeadbeef);
+    EXPECT_EQ(600u, ent.compressed_ser_block_size);
+    EXPECT_EQ(600u, ent.disk_ser_block_size());
+    EXPECT_EQ(1234u, ent.ser_block_size);
+    EXPECT_EQ(0xdeadbeefu, ent.checksum());
     flagged_off64_t deleteblock = flagged_off64_t::unused();
     deleteblock = flagged_off64_t::make(1);
-    ent = lba_entry_t::make(1, repli_timestamp_t::invalid, deleteblock, 1234);
+    ent = lba_entry_t::make(1, repli_timestamp_t::invalid, deleteblock, 1234, 1234,
+                            NO_BLOCK_CHECKSUM);
     ASSERT_FALSE(lba_entry_t::is_padding(&ent));
 }
 
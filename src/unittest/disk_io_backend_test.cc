@@ -0,0 +1,92 @@
+// Copyright 2010-2014 RethinkDB, all rights reserved.
+#include <string.h>
+#include <sys/uio.h>
+
+#include "arch/io/disk.hpp"
+#include "concurrency/cond_var.hpp"
+#include "containers/scoped.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+struct io_waiter_t : public iocallback_t, public cond_t {
+    void on_io_complete() {
+        pulse();
+    }
+};
+
+void run_read_write_test(io_backend_t io_backend) {
+    const size_t chunk_size = 4 * DEVICE_BLOCK_SIZE;
+    const int num_chunks = 64;
+
+    temp_file_t temp_file;
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired,
+                                DEFAULT_MAX_CONCURRENT_IO_REQUESTS,
+                                io_backend);
+    scoped_ptr_t<file_t> file;
+    file_open_result_t res = open_file(temp_file.name().permanent_path().c_str(),
+                                       linux_file_t::mode_read
+                                       | linux_file_t::mode_write
+                                       | linux_file_t::mode_create,
+                                       &io_backender,
+                                       &file);
+    ASSERT_NE(file_open_result_t::ERROR, res.outcome);
+    file->set_file_size(chunk_size * num_chunks);
+
+    // Write every chunk concurrently, alternating between plain writes and writevs
+    // made of single device blocks.
+    scoped_device_block_aligned_ptr_t<char> data(chunk_size * num_chunks);
+    for (size_t i = 0; i < chunk_size * num_chunks; ++i) {
+        data.get()[i] = static_cast<char>(i * 7 + i / DEVICE_BLOCK_SIZE);
+    }
+    {
+        io_waiter_t waiters[num_chunks];
+        for (int i = 0; i < num_chunks; ++i) {
+            char *chunk = data.get() + i * chunk_size;
+            if (i % 2 == 0) {
+                file->write_async(i * chunk_size, chunk_size, chunk,
+                                  DEFAULT_DISK_ACCOUNT, &waiters[i],
+                                  i % 8 == 0 ? file_t::WRAP_IN_DATASYNCS
+                                             : file_t::NO_DATASYNCS);
+            } else {
+                const size_t n = chunk_size / DEVICE_BLOCK_SIZE;
+                scoped_array_t<iovec> bufs(n);
+                for (size_t j = 0; j < n; ++j) {
+                    bufs[j].iov_base = chunk + j * DEVICE_BLOCK_SIZE;
+                    bufs[j].iov_len = DEVICE_BLOCK_SIZE;
+                }
+                file->writev_async(i * chunk_size, chunk_size, std::move(bufs),
+                                   DEFAULT_DISK_ACCOUNT, &waiters[i]);
+            }
+        }
+        for (int i = 0; i < num_chunks; ++i) {
+            waiters[i].wait();
+        }
+    }
+
+    scoped_device_block_aligned_ptr_t<char> readback(chunk_size * num_chunks);
+    memset(readback.get(), 0, chunk_size * num_chunks);
+    {
+        io_waiter_t waiters[num_chunks];
+        for (int i = 0; i < num_chunks; ++i) {
+            file->read_async(i * chunk_size, chunk_size, readback.get() + i * chunk_size,
+                             DEFAULT_DISK_ACCOUNT, &waiters[i]);
+        }
+        for (int i = 0; i < num_chunks; ++i) {
+            waiters[i].wait();
+        }
+    }
+    ASSERT_EQ(0, memcmp(data.get(), readback.get(), chunk_size * num_chunks));
+}
+
+TPTEST(DiskIoBackendTest, PoolReadWrite) {
+    run_read_write_test(io_backend_t::pool);
+}
+
+TPTEST(DiskIoBackendTest, UringReadWrite) {
+    // Falls back to the pool backend if the kernel doesn't support io_uring.
+    run_read_write_test(io_backend_t::io_uring);
+}
+
+}  // namespace unittest
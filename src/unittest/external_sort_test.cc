@@ -0,0 +1,108 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/io/disk.hpp"
+#include "rdb_protocol/datum_stream/external_sort.hpp"
+#include "rdb_protocol/env.hpp"
+#include "rdb_protocol/func.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+// Rows are `[key, position in the input]`, so that we can check stability.
+ql::datum_t make_sort_row(int key, int position) {
+    std::vector<ql::datum_t> row;
+    row.push_back(ql::datum_t(static_cast<double>(key)));
+    row.push_back(ql::datum_t(static_cast<double>(position)));
+    return ql::datum_t(std::move(row), ql::configured_limits_t::unlimited);
+}
+
+TPTEST(ExternalSort, MergesRuns) {
+    temp_directory_t temp_dir;
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    cond_t interruptor;
+    ql::env_t env(&interruptor,
+                  ql::return_empty_normal_batches_t::NO,
+                  reql_version_t::LATEST);
+
+    ql::lt_cmp_t lt_cmp(
+        std::vector<std::pair<ql::order_direction_t, counted_t<const ql::func_t> > >{
+            std::make_pair(ql::ASC, ql::new_get_field_func(
+                ql::datum_t(0.0), ql::backtrace_id_t::empty()))});
+    counted_t<ql::external_sort_datum_stream_t> stream =
+        make_counted<ql::external_sort_datum_stream_t>(
+            ql::backtrace_id_t::empty(), &io_backender, temp_dir.path(), lt_cmp);
+
+    const int num_runs = 4;
+    const int run_size = 100;
+    int position = 0;
+    for (int run = 0; run < num_runs; ++run) {
+        std::vector<ql::datum_t> rows;
+        for (int i = 0; i < run_size; ++i) {
+            rows.push_back(make_sort_row((i * 37 + run) % 50, position++));
+        }
+        if (run + 1 < num_runs) {
+            stream->spill_run(&env, std::move(rows));
+        } else {
+            stream->finish(&env, std::move(rows));
+        }
+    }
+
+    counted_t<ql::datum_stream_t> seq = stream;
+    std::vector<ql::datum_t> sorted;
+    for (;;) {
+        std::vector<ql::datum_t> batch =
+            seq->next_batch(&env, ql::batchspec_t::all());
+        if (batch.empty()) {
+            break;
+        }
+        std::move(batch.begin(), batch.end(), std::back_inserter(sorted));
+    }
+
+    ASSERT_EQ(static_cast<size_t>(num_runs * run_size), sorted.size());
+    EXPECT_TRUE(seq->is_exhausted());
+    for (size_t i = 1; i < sorted.size(); ++i) {
+        double prev_key = sorted[i - 1].get(0).as_num();
+        double key = sorted[i].get(0).as_num();
+        EXPECT_LE(prev_key, key);
+        if (prev_key == key) {
+            // Equal rows must keep their input order.
+            EXPECT_LT(sorted[i - 1].get(1).as_num(), sorted[i].get(1).as_num());
+        }
+    }
+}
+
+TPTEST(ExternalSort, SortMatchesComparison) {
+    cond_t interruptor;
+    ql::env_t env(&interruptor,
+                  ql::return_empty_normal_batches_t::NO,
+                  reql_version_t::LATEST);
+
+    // Sorts by `a` descending, then by `b`. Some rows don't have `a`.
+    ql::lt_cmp_t lt_cmp(
+        std::vector<std::pair<ql::order_direction_t, counted_t<const ql::func_t> > >{
+            std::make_pair(ql::DESC, ql::new_get_field_func(
+                ql::datum_t("a"), ql::backtrace_id_t::empty())),
+            std::make_pair(ql::ASC, ql::new_get_field_func(
+                ql::datum_t("b"), ql::backtrace_id_t::empty()))});
+
+    std::vector<ql::datum_t> rows;
+    for (int i = 0; i < 200; ++i) {
+        ql::datum_object_builder_t row;
+        if (i % 7 != 0) {
+            row.overwrite("a", ql::datum_t(static_cast<double>((i * 13) % 5)));
+        }
+        row.overwrite("b", ql::datum_t(static_cast<double>((i * 29) % 11)));
+        row.overwrite("position", ql::datum_t(static_cast<double>(i)));
+        rows.push_back(std::move(row).to_datum());
+    }
+
+    std::vector<ql::datum_t> expected = rows;
+    std::stable_sort(expected.begin(), expected.end(),
+                     [&](const ql::datum_t &l, const ql::datum_t &r) {
+                         return lt_cmp(&env, nullptr, l, r);
+                     });
+    lt_cmp.sort(&env, nullptr, &rows);
+    EXPECT_EQ(expected, rows);
+}
+
+}  // namespace unittest
@@ -0,0 +1,46 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rpc/connectivity/failure_detector.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+/* With perfectly regular arrivals, `phi` grows quickly once the peer is late. */
+TEST(FailureDetectorTest, Regular) {
+    phi_accrual_detector_t detector(100, 0.5);
+    for (int i = 0; i < 20; ++i) {
+        detector.add_interval(1);
+    }
+    EXPECT_LT(detector.phi(1), 1);
+    EXPECT_LT(detector.phi(2), 8);
+    EXPECT_GT(detector.phi(4), 8);
+    EXPECT_LT(detector.phi(3), detector.phi(4));
+}
+
+/* Irregular arrivals, as on a loaded connection, get more slack. */
+TEST(FailureDetectorTest, Irregular) {
+    phi_accrual_detector_t regular(100, 0.5), irregular(100, 0.5);
+    for (int i = 0; i < 20; ++i) {
+        regular.add_interval(2);
+        irregular.add_interval(i % 2 == 0 ? 1 : 3);
+    }
+    EXPECT_LT(irregular.phi(5), 8);
+    EXPECT_GT(regular.phi(5), 8);
+}
+
+/* Only the last `max_intervals` intervals are taken into account. */
+TEST(FailureDetectorTest, Window) {
+    phi_accrual_detector_t detector(10, 0.5);
+    for (int i = 0; i < 10; ++i) {
+        detector.add_interval(20);
+    }
+    EXPECT_LT(detector.phi(20), 1);
+    for (int i = 0; i < 10; ++i) {
+        detector.add_interval(1);
+    }
+    EXPECT_EQ(10u, detector.num_intervals());
+    EXPECT_GT(detector.phi(20), 8);
+    detector.reset();
+    EXPECT_EQ(0u, detector.num_intervals());
+}
+
+}  // namespace unittest
@@ -0,0 +1,62 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/io/fault_injection.hpp"
+#include "config/args.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+TEST(FaultInjection, ParseConfig) {
+    fault_injection_config_t config;
+    std::string error;
+    ASSERT_TRUE(parse_fault_injection_config(
+        "latency=2ms,jitter=500us,bandwidth=100M,stall=1.5s,stall-probability=0.01",
+        &config, &error));
+    EXPECT_EQ(2000, config.latency_us);
+    EXPECT_EQ(500, config.jitter_us);
+    EXPECT_EQ(static_cast<uint64_t>(100 * MEGABYTE), config.bytes_per_sec);
+    EXPECT_EQ(1500000, config.stall_us);
+    EXPECT_EQ(0.01, config.stall_probability);
+    EXPECT_TRUE(config.is_enabled());
+
+    for (const char *bad : {"", "latency", "latency=2", "latency=-1ms", "bandwidth=1T",
+                            "stall-probability=2", "speed=1ms"}) {
+        EXPECT_FALSE(parse_fault_injection_config(bad, &config, &error)) << bad;
+    }
+}
+
+TEST(FaultInjection, LatencyAndBandwidth) {
+    fault_injection_config_t config;
+    config.latency_us = 1000;
+    config.bytes_per_sec = MEGABYTE;
+    fault_injector_t injector(config);
+
+    // A megabyte takes a second to get through, plus the latency.
+    EXPECT_EQ(MILLION + 1000, injector.delay_us(MEGABYTE, 0));
+    // The next operation has to wait for the link to be free again.
+    EXPECT_EQ(MILLION + MILLION / 2 + 1000, injector.delay_us(MEGABYTE / 2, 0));
+    // Once it's idle, it's back to just the latency.
+    EXPECT_EQ(1000, injector.delay_us(0, 10 * MILLION));
+}
+
+TEST(FaultInjection, StallsHoldUpLaterOperations) {
+    fault_injection_config_t config;
+    config.stall_us = MILLION;
+    config.stall_probability = 1;
+    fault_injector_t injector(config);
+    EXPECT_EQ(MILLION, injector.delay_us(0, 0));
+    EXPECT_EQ(2 * MILLION, injector.delay_us(0, 0));
+}
+
+TEST(FaultInjection, JitterKeepsOrder) {
+    fault_injection_config_t config;
+    config.jitter_us = 10000;
+    fault_injector_t injector(config);
+    int64_t last_release_us = 0;
+    for (int64_t now_us = 0; now_us < 1000; ++now_us) {
+        int64_t release_us = now_us + injector.delay_us(100, now_us);
+        EXPECT_GE(release_us, last_release_us);
+        last_release_us = release_us;
+    }
+}
+
+}  // namespace unittest
@@ -12,6 +12,7 @@
 #include "rdb_protocol/geo/ellipsoid.hpp"
 #include "rdb_protocol/geo/exceptions.hpp"
 #include "rdb_protocol/geo/geojson.hpp"
+#include "rdb_protocol/geo/indexing.hpp"
 #include "rdb_protocol/geo/lon_lat_types.hpp"
 #include "rdb_protocol/geo/intersection.hpp"
 #include "rdb_protocol/geo/primitives.hpp"
@@ -473,6 +474,28 @@ TPTEST(GeoIndexes, GetIntersecting) {
     run_with_namespace_interface(&run_get_intersecting_test);
 }
 
+// Test that cached query shapes give the same intersection results as the GeoJSON
+TPTEST(GeoIndexes, QueryShapeCache) {
+    // To reproduce a known failure: initialize the rng seed manually.
+    const int rng_seed = randint(INT_MAX);
+    debugf("Using RNG seed %i\n", rng_seed);
+    rng_t rng(rng_seed);
+
+    std::vector<datum_t> data = generate_data(200, &rng);
+    for (int i = 0; i < 10; ++i) {
+        datum_t query_geometry = generate_polygon(&rng);
+        std::shared_ptr<const geo_query_shape_t> shape =
+            get_geo_query_shape(query_geometry, 16);
+        ASSERT_EQ(shape, get_geo_query_shape(query_geometry, 16));
+        ASSERT_NE(shape, get_geo_query_shape(query_geometry, 8));
+        ASSERT_EQ(compute_cell_covering(query_geometry, 16), shape->covering);
+        for (const datum_t &d : data) {
+            ASSERT_EQ(geo_does_intersect(query_geometry, d),
+                      shape->geometry.intersects(d));
+        }
+    }
+}
+
 } /* namespace unittest */
 
 
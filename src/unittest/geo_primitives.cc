@@ -83,8 +83,8 @@ void test_in_ex_radius(const ellipsoid_spec_t e, rng_t *rng) {
     }
 }
 
-// Verifies that the constraints described in nearest_traversal_cb_t::init_query_geometry()
-// hold
+// Verifies that the constraints described on build_polygon_with_inradius_at_least()
+// and build_polygon_with_exradius_at_most() hold
 TPTEST(GeoPrimitives, InExRadiusTest) {
     // To reproduce a known failure: initialize the rng seed manually.
     const int rng_seed = randint(INT_MAX);
@@ -0,0 +1,85 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/datum_stream/array.hpp"
+#include "rdb_protocol/datum_stream/hash_join.hpp"
+#include "rdb_protocol/env.hpp"
+#include "rdb_protocol/func.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+// Rows are `{k: key, id: id}`; a negative key means the row has no key.
+counted_t<ql::datum_stream_t> make_join_side(const std::vector<int> &keys) {
+    std::vector<ql::datum_t> rows;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        ql::datum_object_builder_t row;
+        row.overwrite("id", ql::datum_t(static_cast<double>(i)));
+        if (keys[i] >= 0) {
+            row.overwrite("k", ql::datum_t(static_cast<double>(keys[i])));
+        }
+        rows.push_back(std::move(row).to_datum());
+    }
+    return make_counted<ql::array_datum_stream_t>(
+        ql::datum_t(std::move(rows), ql::configured_limits_t::unlimited),
+        ql::backtrace_id_t::empty());
+}
+
+std::vector<ql::datum_t> hash_join(ql::env_t *env,
+                                   const std::vector<int> &left,
+                                   const std::vector<int> &right,
+                                   bool outer) {
+    ql::datum_t k("k");
+    counted_t<ql::datum_stream_t> seq =
+        make_counted<ql::hash_join_datum_stream_t>(
+            make_join_side(left),
+            make_join_side(right),
+            ql::new_get_field_func(k, ql::backtrace_id_t::empty()),
+            ql::new_get_field_func(k, ql::backtrace_id_t::empty()),
+            ql::new_constant_func(ql::datum_t::boolean(true),
+                                  ql::backtrace_id_t::empty()),
+            outer,
+            nullptr,
+            base_path_t(),
+            ql::backtrace_id_t::empty());
+    std::vector<ql::datum_t> res;
+    for (;;) {
+        std::vector<ql::datum_t> batch = seq->next_batch(env, ql::batchspec_t::all());
+        if (batch.empty()) {
+            break;
+        }
+        std::move(batch.begin(), batch.end(), std::back_inserter(res));
+    }
+    EXPECT_TRUE(seq->is_exhausted());
+    return res;
+}
+
+TPTEST(HashJoin, InnerAndOuter) {
+    cond_t interruptor;
+    ql::env_t env(&interruptor,
+                  ql::return_empty_normal_batches_t::NO,
+                  reql_version_t::LATEST);
+
+    std::vector<int> left = {1, 2, -1, 3, 1};
+    std::vector<int> right = {1, 1, 3, -1, 4};
+
+    std::vector<ql::datum_t> inner = hash_join(&env, left, right, false);
+    // Left rows 0 and 4 match right rows 0 and 1, left row 3 matches right row 2.
+    ASSERT_EQ(5u, inner.size());
+    std::vector<std::pair<double, double> > expected = {
+        {0, 0}, {0, 1}, {3, 2}, {4, 0}, {4, 1}};
+    for (size_t i = 0; i < inner.size(); ++i) {
+        EXPECT_EQ(expected[i].first,
+                  inner[i].get_field("left").get_field("id").as_num());
+        EXPECT_EQ(expected[i].second,
+                  inner[i].get_field("right").get_field("id").as_num());
+    }
+
+    // The rows without a match come out on their own, in the left-hand order.
+    std::vector<ql::datum_t> outer = hash_join(&env, left, right, true);
+    ASSERT_EQ(7u, outer.size());
+    EXPECT_EQ(1.0, outer[2].get_field("left").get_field("id").as_num());
+    EXPECT_FALSE(outer[2].get_field("right", ql::NOTHROW).has());
+    EXPECT_EQ(2.0, outer[3].get_field("left").get_field("id").as_num());
+    EXPECT_FALSE(outer[3].get_field("right", ql::NOTHROW).has());
+}
+
+}  // namespace unittest
@@ -88,6 +88,54 @@ TEST(Http, Encodings) {
     test_encoding("g_zip", false);
 }
 
+TEST(Http, GzipAlreadyEncoded) {
+    std::string body(2048, 'a');
+    std::string compressed;
+    ASSERT_TRUE(gzip_string(body, &compressed));
+    EXPECT_LT(compressed.size(), body.size());
+
+    // A response that the application has encoded itself is left alone
+    http_req_t req = http_req_encoding("gzip");
+    http_res_t res(http_status_code_t::OK);
+    res.add_header_line("Content-Encoding", "gzip");
+    res.body = compressed;
+    EXPECT_FALSE(maybe_gzip_response(req, &res));
+    EXPECT_EQ(compressed, res.body);
+}
+
+class hello_http_app_t : public http_app_t {
+public:
+    void handle(const http_req_t &, http_res_t *result, signal_t *) {
+        *result = http_res_t(http_status_code_t::OK, "text/plain", "hello");
+    }
+};
+
+TPTEST(Http, KeepAlive) {
+    hello_http_app_t app;
+    ip_address_t loopback("127.0.0.1");
+    std::set<ip_address_t> ip_addresses;
+    ip_addresses.insert(loopback);
+    http_server_t server(nullptr, ip_addresses, 0, &app);
+
+    cond_t non_interruptor;
+    tcp_conn_t http_conn(loopback, server.get_port(), &non_interruptor);
+    std::string request = "GET / HTTP/1.1\r\n\r\n";
+    for (int i = 0; i < 3; ++i) {
+        // Every request goes over the same connection
+        http_conn.write(request.data(), request.size(), &non_interruptor);
+        std::string response;
+        while (response.find("\r\n\r\nhello") == std::string::npos) {
+            http_conn.read_more_buffered(&non_interruptor);
+            const_charslice slice = http_conn.peek();
+            response.append(slice.beg, slice.end - slice.beg);
+            http_conn.pop(slice.end - slice.beg, &non_interruptor);
+        }
+        EXPECT_EQ(0u, response.find("HTTP/1.1 200 OK\r\n"));
+        EXPECT_NE(std::string::npos, response.find("content-length: 5\r\n"));
+        EXPECT_EQ(std::string::npos, response.find("connection: close"));
+    }
+}
+
 class dummy_http_app_t : public http_app_t {
 public:
     signal_t *get_handle_signal() {
@@ -1,5 +1,8 @@
 // Copyright 2010-2015 RethinkDB, all rights reserved.
+#include <algorithm>
 #include <map>
+#include <string>
+#include <vector>
 
 #include "btree/leaf_node.hpp"
 #include "btree/node.hpp"
@@ -185,6 +188,22 @@ public:
         right->Verify();
     }
 
+    void SplitAtEnd(LeafNodeTracker *right) {
+        ASSERT_EQ(bs_.ser_value(), right->bs_.ser_value());
+
+        ASSERT_TRUE(leaf::is_empty(right->node()));
+
+        store_key_t median;
+        leaf::split_at_end(&sizer_, node(), right->node(), median.btree_key());
+
+        ASSERT_FALSE(kv_.empty());
+        ASSERT_EQ(key_to_unescaped_str(kv_.rbegin()->first),
+                  key_to_unescaped_str(median));
+
+        Verify();
+        right->Verify();
+    }
+
     bool IsFull(const store_key_t& key, const std::string& value) {
         short_value_buffer_t value_buf(value);
         return leaf::is_full(&sizer_, node(), key.btree_key(), value_buf.data());
@@ -701,6 +720,28 @@ TEST(LeafNodeTest, Splitting) {
     left.Split(&right);
 }
 
+TEST(LeafNodeTest, SplittingAtEnd) {
+    // Appending keys in ascending order fills up the left node completely and then
+    // continues in the right one.
+    LeafNodeTracker left;
+    int i = 0;
+    for (;; ++i) {
+        store_key_t key(strprintf("a%05d", i));
+        if (left.IsFull(key, strprintf("A%d", i))) {
+            ASSERT_TRUE(leaf::is_past_last_key(left.node(), key.btree_key()));
+            break;
+        }
+        left.Insert(key, strprintf("A%d", i));
+    }
+    ASSERT_FALSE(
+        leaf::is_past_last_key(left.node(), store_key_t("a00000").btree_key()));
+
+    LeafNodeTracker right;
+    left.SplitAtEnd(&right);
+    ASSERT_FALSE(left.IsUnderfull());
+    ASSERT_TRUE(right.Insert(store_key_t(strprintf("a%05d", i)), strprintf("A%d", i)));
+}
+
 TEST(LeafNodeTest, Fullness) {
     LeafNodeTracker node;
     int i;
@@ -711,4 +752,37 @@ TEST(LeafNodeTest, Fullness) {
     ASSERT_TRUE(node.IsFull(store_key_t(strprintf("a%d", i)), strprintf("A%d", i)));
 }
 
+TEST(LeafNodeTest, FindKeySharedPrefixes) {
+    // Keys like secondary index keys, which share long prefixes with their neighbors,
+    // and some of which are prefixes of one another.
+    LeafNodeTracker node;
+    std::vector<store_key_t> keys;
+    for (int i = 0; i < 40; ++i) {
+        std::string prefix = std::string(30 + i % 3, 'p') + strprintf("%02d", i / 4);
+        keys.push_back(store_key_t(prefix + strprintf("%03d", i)));
+        if (i % 4 == 0) {
+            keys.push_back(store_key_t(prefix));
+        }
+    }
+    for (const store_key_t &key : keys) {
+        ASSERT_TRUE(node.Insert(key, "v"));
+    }
+
+    std::vector<store_key_t> sorted(keys);
+    std::sort(sorted.begin(), sorted.end());
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        int index;
+        ASSERT_TRUE(leaf::find_key(node.node(), sorted[i].btree_key(), &index));
+        ASSERT_EQ(static_cast<int>(i), index);
+
+        // A key just past this one, which should go right after it.
+        store_key_t missing(key_to_unescaped_str(sorted[i]) + "0");
+        if (i + 1 < sorted.size() && missing == sorted[i + 1]) {
+            continue;
+        }
+        ASSERT_FALSE(leaf::find_key(node.node(), missing.btree_key(), &index));
+        ASSERT_EQ(static_cast<int>(i + 1), index);
+    }
+}
+
 }  // namespace unittest
@@ -0,0 +1,61 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <string>
+#include <vector>
+
+#include "rpc/connectivity/message_compression.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+/* Compresses messages of various sizes one after another and checks that they
+decompress back to the originals, in order, on a single stream. */
+TEST(MessageCompressionTest, RoundTrip) {
+    message_compressor_t compressor;
+    message_decompressor_t decompressor;
+    for (size_t i = 0; i < 50; ++i) {
+        std::string message;
+        for (size_t j = 0; j < i * i * 10; ++j) {
+            message += std::to_string(j % (i + 7));
+        }
+        std::vector<char> compressed;
+        compressor.compress(message.data(), message.size(), &compressed);
+        std::vector<char> uncompressed;
+        ASSERT_TRUE(decompressor.decompress(compressed.data(), compressed.size(),
+                                            message.size(), &uncompressed));
+        ASSERT_EQ(message, std::string(uncompressed.begin(), uncompressed.end()));
+    }
+}
+
+/* Repeating a message should be cheap, because the stream remembers the earlier one. */
+TEST(MessageCompressionTest, SharedHistory) {
+    message_compressor_t compressor;
+    std::string message;
+    for (int i = 0; message.size() < 4000; ++i) {
+        message += std::to_string(i * 7919 % 10007) + ",";
+    }
+    std::vector<char> first, second;
+    compressor.compress(message.data(), message.size(), &first);
+    compressor.compress(message.data(), message.size(), &second);
+    EXPECT_LT(second.size() * 4, first.size());
+
+    message_decompressor_t decompressor;
+    std::vector<char> uncompressed;
+    ASSERT_TRUE(decompressor.decompress(first.data(), first.size(), message.size(),
+                                        &uncompressed));
+    ASSERT_TRUE(decompressor.decompress(second.data(), second.size(), message.size(),
+                                        &uncompressed));
+    EXPECT_EQ(message, std::string(uncompressed.begin(), uncompressed.end()));
+}
+
+TEST(MessageCompressionTest, WrongSize) {
+    message_compressor_t compressor;
+    const std::string message(2000, 'x');
+    std::vector<char> compressed;
+    compressor.compress(message.data(), message.size(), &compressed);
+    message_decompressor_t decompressor;
+    std::vector<char> uncompressed;
+    EXPECT_FALSE(decompressor.decompress(compressed.data(), compressed.size(),
+                                         message.size() - 1, &uncompressed));
+}
+
+}  // namespace unittest
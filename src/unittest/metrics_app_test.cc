@@ -0,0 +1,36 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "clustering/administration/http/metrics_app.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+TEST(MetricsAppTest, Format) {
+    const char *table_id = "8b3a6e5c-3e2e-4e7f-9c1e-2f0d6a1b5c4d";
+
+    ql::datum_object_builder_t shard;
+    shard.overwrite("reads_per_sec", ql::datum_t(2.5));
+    shard.overwrite("active", ql::datum_t::boolean(true));
+    ql::datum_object_builder_t table;
+    table.overwrite("shard-0", std::move(shard).to_datum());
+    table.overwrite("name", ql::datum_t(datum_string_t("foo")));
+    ql::datum_object_builder_t query_engine;
+    query_engine.overwrite("clients_active", ql::datum_t(3.0));
+    query_engine.overwrite("empty_histogram", ql::datum_t::null());
+    ql::datum_object_builder_t stats;
+    stats.overwrite("query_engine", std::move(query_engine).to_datum());
+    stats.overwrite(table_id, std::move(table).to_datum());
+
+    std::string expected = strprintf(
+        "# TYPE rethinkdb_query_engine_clients_active unknown\n"
+        "rethinkdb_query_engine_clients_active 3\n"
+        "# TYPE rethinkdb_shard_0_active unknown\n"
+        "rethinkdb_shard_0_active{table=\"%s\"} 1\n"
+        "# TYPE rethinkdb_shard_0_reads_per_sec unknown\n"
+        "rethinkdb_shard_0_reads_per_sec{table=\"%s\"} 2.5\n"
+        "# EOF\n",
+        table_id, table_id);
+    EXPECT_EQ(expected,
+              format_perfmon_stats_as_openmetrics(std::move(stats).to_datum()));
+}
+
+}  // namespace unittest
@@ -71,6 +71,13 @@ void mock_file_t::writev_async(int64_t offset, size_t length, scoped_array_t<iov
     write_async(offset, length, buf.get(), account, cb, NO_DATASYNCS);
 }
 
+void mock_file_t::discard(int64_t offset, int64_t length) {
+    guarantee(mode_ & mode_write);
+    guarantee(offset >= 0 && length >= 0
+              && static_cast<uint64_t>(offset + length) <= data_->size());
+    memset(data_->data() + offset, 0, length);
+}
+
 bool mock_file_t::coop_lock_and_check() {
     // We don't actually implement the locking behavior.
     return true;
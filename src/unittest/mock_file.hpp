@@ -23,6 +23,7 @@ public:
     int64_t get_file_size();
     void set_file_size(int64_t size);
     void set_file_size_at_least(int64_t size, int64_t extent_size);
+    void discard(int64_t offset, int64_t length);
 
     void read_async(int64_t offset, size_t length, void *buf,
                     file_account_t *account, linux_iocallback_t *cb);
@@ -32,7 +33,8 @@ public:
     void writev_async(int64_t offset, size_t length, scoped_array_t<iovec> &&bufs,
                       file_account_t *account, linux_iocallback_t *cb);
 
-    void *create_account(UNUSED int priority, UNUSED int outstanding_requests_limit) {
+    void *create_account(UNUSED io_class_t io_class, UNUSED int priority,
+                         UNUSED int outstanding_requests_limit) {
         // We don't care about accounts.  Return an arbitrary non-null pointer.
         return this;
     }
@@ -0,0 +1,71 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <sched.h>
+
+#include <set>
+
+#include "arch/runtime/numa.hpp"
+#include "arch/runtime/runtime.hpp"
+#include "arch/runtime/starter.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+TEST(NumaTest, CpuForThread) {
+    const numa_topology_t &topology = numa_topology_t::get();
+    ASSERT_LE(1, topology.num_nodes());
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    ASSERT_EQ(0, sched_getaffinity(0, sizeof(allowed), &allowed));
+    for (int n : {1, 3, 8, 200}) {
+        std::set<int> cpus;
+        int prev_node = 0;
+        for (int i = 0; i < n; ++i) {
+            int node;
+            int cpu = topology.cpu_for_thread(i, n, &node);
+            EXPECT_LE(0, node);
+            EXPECT_GT(topology.num_nodes(), node);
+            EXPECT_TRUE(CPU_ISSET(cpu, &allowed));
+            if (n <= CPU_COUNT(&allowed)) {
+                // Every thread gets its own CPU, and the nodes are filled in order.
+                EXPECT_TRUE(cpus.insert(cpu).second);
+                EXPECT_LE(prev_node, node);
+            }
+            prev_node = node;
+        }
+    }
+}
+
+void run_pinned_test() {
+    for (int i = 0; i < get_num_db_threads(); ++i) {
+        EXPECT_LE(0, get_numa_node(threadnum_t(i)));
+        on_thread_t thread_switcher((threadnum_t(i)));
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        ASSERT_EQ(0, sched_getaffinity(0, sizeof(mask), &mask));
+        EXPECT_EQ(1, CPU_COUNT(&mask));
+    }
+    // The utility thread is never pinned.
+    EXPECT_EQ(-1, get_numa_node(threadnum_t(get_num_db_threads())));
+
+    thread_allocator_t allocator([](threadnum_t a, threadnum_t b) {
+        return a.threadnum < b.threadnum;
+    });
+    thread_allocation_t first(&allocator);
+    thread_allocation_t second(&allocator, first.get_thread());
+    EXPECT_EQ(get_numa_node(first.get_thread()), get_numa_node(second.get_thread()));
+}
+
+TEST(NumaTest, PinnedThreads) {
+    ::run_in_thread_pool(&run_pinned_test, 4, true);
+}
+
+TEST(NumaTest, UnpinnedThreads) {
+    run_in_thread_pool([&]() {
+        for (int i = 0; i < get_num_threads(); ++i) {
+            EXPECT_EQ(-1, get_numa_node(threadnum_t(i)));
+        }
+    }, 4);
+}
+
+}  // namespace unittest
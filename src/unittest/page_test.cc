@@ -56,10 +56,16 @@ public:
         flush_and_destroy_txn(std::move(txn), write_durability_t::SOFT, nullptr);
     }
 
-    alt::throttler_acq_t make_throttler_acq() {
+    void hard_flush(scoped_ptr_t<test_txn_t> txn,
+                    page_txn_complete_cb_t *on_complete) {
+        flush_and_destroy_txn(std::move(txn), write_durability_t::HARD, on_complete);
+    }
+
+    alt::throttler_acq_t make_throttler_acq(
+            write_durability_t durability = write_durability_t::SOFT) {
         // KSI: We could make these tests better by varying the expected change
         // count.
-        return throttler_->begin_txn_or_throttle(write_durability_t::SOFT, 0);
+        return throttler_->begin_txn_or_throttle(durability, 0);
     }
 
 private:
@@ -68,7 +74,8 @@ private:
 
 class test_txn_t : public page_txn_t {
 public:
-    explicit test_txn_t(test_cache_t *cache);
+    explicit test_txn_t(test_cache_t *cache,
+                        write_durability_t durability = write_durability_t::SOFT);
 };
 
 class current_test_acq_t : public current_page_acq_t {
@@ -97,6 +104,10 @@ public:
         return current_page_acq_t::current_page_for_read(
                 page_cache()->default_reads_account());
     }
+
+    page_t *current_page_for_read(cache_account_t *account) {
+        return current_page_acq_t::current_page_for_read(account);
+    }
 };
 
 class test_acq_t : public page_acq_t {
@@ -105,6 +116,9 @@ public:
     void init(page_t *page, page_cache_t *_page_cache) {
         page_acq_t::init(page, _page_cache, _page_cache->default_reads_account());
     }
+    void init(page_t *page, page_cache_t *_page_cache, cache_account_t *account) {
+        page_acq_t::init(page, _page_cache, account);
+    }
 
     void *get_buf_write() {
         return page_acq_t::get_buf_write(page_cache()->max_block_size());
@@ -112,9 +126,9 @@ public:
 };
 
 
-test_txn_t::test_txn_t(test_cache_t *cache)
+test_txn_t::test_txn_t(test_cache_t *cache, write_durability_t durability)
     : page_txn_t(cache,
-                 cache->make_throttler_acq(),
+                 cache->make_throttler_acq(durability),
                  nullptr) { }
 
 
@@ -178,6 +192,126 @@ TPTEST(PageTest, OneWriteAcq, 4) {
     page_cache.flush(std::move(txn));
 }
 
+void write_page(test_cache_t *cache, page_txn_t *txn, block_id_t *block_id_inout) {
+    scoped_ptr_t<current_test_acq_t> acq;
+    if (*block_id_inout == NULL_BLOCK_ID) {
+        acq.init(new current_test_acq_t(txn, alt_create_t::create));
+        *block_id_inout = acq->block_id();
+    } else {
+        acq.init(new current_test_acq_t(txn, *block_id_inout, access_t::write));
+    }
+    test_acq_t page_acq;
+    page_acq.init(acq->current_page_for_write(), cache);
+    page_acq.get_buf_write();
+}
+
+TPTEST(PageTest, HardTxnGroupCommit, 4) {
+    mock_ser_t mock;
+    dummy_cache_balancer_t balancer(GIGABYTE);
+    test_cache_t page_cache(mock.ser.get(), &balancer, mock.throttler.get());
+    page_cache.set_group_commit_delay(20);
+    block_id_t block_id1 = NULL_BLOCK_ID;
+    block_id_t block_id2 = NULL_BLOCK_ID;
+    auto txn1 = make_scoped<test_txn_t>(&page_cache, write_durability_t::HARD);
+    auto txn2 = make_scoped<test_txn_t>(&page_cache, write_durability_t::HARD);
+    write_page(&page_cache, txn1.get(), &block_id1);
+    write_page(&page_cache, txn2.get(), &block_id2);
+    page_txn_complete_cb_t complete1;
+    page_txn_complete_cb_t complete2;
+    page_cache.hard_flush(std::move(txn1), &complete1);
+    page_cache.hard_flush(std::move(txn2), &complete2);
+    complete1.cond.wait();
+    complete2.cond.wait();
+
+    // A soft durability flush takes along hard durability txn's that are waiting for
+    // a group commit.
+    auto txn3 = make_scoped<test_txn_t>(&page_cache, write_durability_t::HARD);
+    write_page(&page_cache, txn3.get(), &block_id1);
+    page_txn_complete_cb_t complete3;
+    page_cache.set_group_commit_delay(60 * THOUSAND);
+    page_cache.hard_flush(std::move(txn3), &complete3);
+    page_cache.begin_flush_pending_txns(false, ticks_t{0});
+    complete3.cond.wait();
+}
+
+uint64_t read_page_access_time(test_cache_t *cache, block_id_t block_id,
+                               cache_account_t *account) {
+    auto txn = make_scoped<test_txn_t>(cache);
+    uint64_t access_time;
+    {
+        current_test_acq_t acq(txn.get(), block_id, access_t::read);
+        page_t *page = acq.current_page_for_read(account);
+        test_acq_t page_acq;
+        page_acq.init(page, cache, account);
+        page_acq.get_buf_read();
+        access_time = page->access_time();
+    }
+    cache->flush(std::move(txn));
+    return access_time;
+}
+
+TPTEST(PageTest, ScanDoesNotTouchPages, 4) {
+    mock_ser_t mock;
+    dummy_cache_balancer_t balancer(GIGABYTE);
+    test_cache_t page_cache(mock.ser.get(), &balancer, mock.throttler.get());
+    block_id_t block_id = NULL_BLOCK_ID;
+    {
+        auto txn = make_scoped<test_txn_t>(&page_cache);
+        write_page(&page_cache, txn.get(), &block_id);
+        page_cache.flush(std::move(txn));
+    }
+    cache_account_t scan_account
+        = page_cache.create_cache_account(io_class_t::DEFAULT, 100,
+                                          cache_access_pattern_t::SCAN);
+
+    const uint64_t regular_time = read_page_access_time(
+        &page_cache, block_id, page_cache.default_reads_account());
+    // Reading the page with a scan account leaves it as recently used as it was...
+    ASSERT_EQ(regular_time,
+              read_page_access_time(&page_cache, block_id, &scan_account));
+    // ... but a regular read still updates it.
+    ASSERT_NE(regular_time, read_page_access_time(
+        &page_cache, block_id, page_cache.default_reads_account()));
+}
+
+TPTEST(PageTest, WarmUpHotBlocks, 4) {
+    mock_ser_t mock;
+    dummy_cache_balancer_t balancer(GIGABYTE);
+    block_id_t block_id1 = NULL_BLOCK_ID;
+    block_id_t block_id2 = NULL_BLOCK_ID;
+    std::vector<block_id_t> hot_blocks;
+    {
+        test_cache_t page_cache(mock.ser.get(), &balancer, mock.throttler.get());
+        auto txn = make_scoped<test_txn_t>(&page_cache);
+        write_page(&page_cache, txn.get(), &block_id1);
+        write_page(&page_cache, txn.get(), &block_id2);
+        page_cache.flush(std::move(txn));
+
+        read_page_access_time(
+            &page_cache, block_id2, page_cache.default_reads_account());
+        read_page_access_time(
+            &page_cache, block_id1, page_cache.default_reads_account());
+        ASSERT_EQ(std::vector<block_id_t>({block_id1}), page_cache.hot_block_ids(1));
+        hot_blocks = page_cache.hot_block_ids(10);
+        ASSERT_EQ(std::vector<block_id_t>({block_id1, block_id2}), hot_blocks);
+    }
+
+    test_cache_t page_cache(mock.ser.get(), &balancer, mock.throttler.get());
+    ASSERT_EQ(0u, page_cache.evicter().evictable_disk_backed_size());
+    page_cache.warm_up(hot_blocks);
+    for (int i = 0; i < 1000; ++i) {
+        if (page_cache.evicter().evictable_disk_backed_size() > 0) {
+            break;
+        }
+        nap(1);
+    }
+    ASSERT_LT(0u, page_cache.evicter().evictable_disk_backed_size());
+    // Pages that were read in by the warm-up count as hot only once they get used.
+    ASSERT_TRUE(page_cache.hot_block_ids(10).empty());
+    read_page_access_time(&page_cache, block_id2, page_cache.default_reads_account());
+    ASSERT_EQ(std::vector<block_id_t>({block_id2}), page_cache.hot_block_ids(10));
+}
+
 TPTEST(PageTest, OneWriteAcqOneReadAcq, 4) {
     mock_ser_t mock;
     dummy_cache_balancer_t balancer(GIGABYTE);
@@ -0,0 +1,24 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "clustering/administration/auth/password_check.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+TPTEST(PasswordCheckTest, CheckAndCache) {
+    auth::username_t username("password_check_test");
+    auth::password_t password("hunter2", 64);
+
+    EXPECT_FALSE(auth::check_password(username, "hunter3", password));
+    EXPECT_TRUE(auth::check_password(username, "hunter2", password));
+    // This one is answered from the cache, which must still tell the passwords apart
+    EXPECT_TRUE(auth::check_password(username, "hunter2", password));
+    EXPECT_FALSE(auth::check_password(username, "hunter3", password));
+
+    // A new password gets a new salt, so the cached hash of the old one doesn't match
+    auth::password_t changed("hunter3", 64);
+    EXPECT_FALSE(auth::check_password(username, "hunter2", changed));
+    EXPECT_TRUE(auth::check_password(username, "hunter3", changed));
+}
+
+}  // namespace unittest
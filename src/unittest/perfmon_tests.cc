@@ -57,4 +57,43 @@ TEST(PerfmonTest, StddevComputation) {
     }
 }
 
+TEST(PerfmonTest, LatencyHistogram) {
+    // Durations below `SUB_BUCKETS` microseconds get a bucket each.
+    for (uint64_t micros = 0; micros < latency_histogram_t::SUB_BUCKETS; ++micros) {
+        EXPECT_EQ(static_cast<int>(micros),
+                  latency_histogram_t::bucket_for_micros(micros));
+    }
+    // Every bucket covers at most 1/16 of its start value.
+    for (int b = latency_histogram_t::SUB_BUCKETS; b < latency_histogram_t::NUM_BUCKETS;
+         ++b) {
+        uint64_t end = latency_histogram_t::bucket_end_micros(b);
+        uint64_t start = latency_histogram_t::bucket_end_micros(b - 1);
+        EXPECT_EQ(b, latency_histogram_t::bucket_for_micros(end - 1));
+        EXPECT_LE(end - start, start / latency_histogram_t::SUB_BUCKETS + 1);
+    }
+
+    // 1ms to 1s in 1ms steps
+    latency_histogram_t histogram;
+    for (int ms = 1; ms <= 1000; ++ms) {
+        histogram.record(ms / 1000.0);
+    }
+    EXPECT_EQ(1000u, histogram.count());
+    static const double reldiff = 1.0 / latency_histogram_t::SUB_BUCKETS;
+    EXPECT_NEAR(0.5, histogram.percentile(0.5), 0.5 * reldiff);
+    EXPECT_NEAR(0.99, histogram.percentile(0.99), 0.99 * reldiff);
+    EXPECT_NEAR(1.0, histogram.max(), reldiff);
+    EXPECT_LE(0.5, histogram.percentile(0.5));
+
+    // A slow outlier on another thread or server shows up in the combined tail.
+    latency_histogram_t other;
+    for (int i = 0; i < 10; ++i) {
+        other.record(60.0);
+    }
+    histogram.aggregate(other);
+    EXPECT_EQ(1010u, histogram.count());
+    EXPECT_NEAR(0.5, histogram.percentile(0.5), 0.5 * reldiff);
+    EXPECT_NEAR(60.0, histogram.percentile(0.999), 60.0 * reldiff);
+    EXPECT_NEAR(60.0, histogram.max(), 60.0 * reldiff);
+}
+
 }  // namespace unittest
@@ -16,7 +16,8 @@ void test_mangle(const std::string &pkey, const std::string &skey, optional<uint
         reql_version_t::v2_0,
         reql_version_t::v2_1,
         reql_version_t::v2_2,
-        reql_version_t::v2_3_is_latest
+        reql_version_t::v2_3,
+        reql_version_t::v2_6_is_latest
     };
     for (reql_version_t rv : versions) {
         ql::skey_version_t skey_version = ql::skey_version_from_reql_version(rv);
@@ -26,7 +27,8 @@ void test_mangle(const std::string &pkey, const std::string &skey, optional<uint
         std::string skey2 = skey;
         guarantee(!(skey2[0] & 0x80)); // None of our types have the top bit set.
         switch (skey_version) {
-        case ql::skey_version_t::post_1_16:
+        case ql::skey_version_t::post_1_16: // fallthru
+        case ql::skey_version_t::post_2_6:
             skey2[0] |= 0x80; // Flip the top bit to indicate 1.16+ skey_version.
             break;
         default: unreachable();
@@ -50,4 +52,42 @@ TEST(PrintSecondary, Mangle) {
                 "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb");
 }
 
+TEST(PrintSecondary, CompactUuidPrimaryKey) {
+    const std::string uuid = "0a1b2c3d-4e5f-6789-abcd-ef0123456789";
+    const std::string later_uuid = "0a1b2c3d-4e5f-6789-abcd-ef012345678a";
+    ql::datum_t skey(datum_string_t("bar"));
+    for (const std::string &pkey : {uuid, std::string("0A1B2C3D-4E5F-6789-ABCD-"
+                                                     "EF0123456789")}) {
+        store_key_t primary(ql::datum_t(datum_string_t(pkey)).print_primary());
+        std::string old_key = skey.print_secondary(
+            reql_version_t::v2_3, primary, optional<uint64_t>(3));
+        std::string new_key = skey.print_secondary(
+            reql_version_t::v2_6_is_latest, primary, optional<uint64_t>(3));
+        ASSERT_EQ(key_to_unescaped_str(primary),
+                  ql::datum_t::extract_primary(old_key));
+        ASSERT_EQ(key_to_unescaped_str(primary),
+                  ql::datum_t::extract_primary(new_key));
+        ASSERT_EQ(ql::datum_t::extract_secondary(old_key),
+                  ql::datum_t::extract_secondary(new_key));
+        ASSERT_EQ(3u, *ql::datum_t::extract_tag(new_key));
+        if (pkey == uuid) {
+            ASSERT_EQ(old_key.size() - 20, new_key.size());
+        } else {
+            // Only the lowercase form is made shorter.
+            ASSERT_EQ(old_key, new_key);
+        }
+    }
+
+    // Rows with the same secondary value stay ordered by primary key.
+    std::string key = skey.print_secondary(
+        reql_version_t::v2_6_is_latest,
+        store_key_t(ql::datum_t(datum_string_t(uuid)).print_primary()),
+        r_nullopt);
+    std::string later_key = skey.print_secondary(
+        reql_version_t::v2_6_is_latest,
+        store_key_t(ql::datum_t(datum_string_t(later_uuid)).print_primary()),
+        r_nullopt);
+    ASSERT_LT(key, later_key);
+}
+
 }  // namespace unittest
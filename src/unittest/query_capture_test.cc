@@ -0,0 +1,49 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/query_capture.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+static std::string redact_query(const std::string &query) {
+    rapidjson::Document doc;
+    doc.Parse(query.c_str());
+    EXPECT_FALSE(doc.HasParseError());
+    return redacted_query_json(doc);
+}
+
+TEST(QueryCaptureTest, RedactKeepsNamesAndSettings) {
+    // r.db("test").table("users").get_all("alice", index="name").limit(5)
+    EXPECT_EQ(
+        "[1,[71,[[78,[[15,[[14,[\"test\"]],\"users\"]],\"xxxxx\"],"
+        "{\"index\":\"name\"}],5]],"
+        "{\"db\":[14,[\"test\"]],\"durability\":\"soft\"}]",
+        redact_query(
+            "[1,[71,[[78,[[15,[[14,[\"test\"]],\"users\"]],\"alice\"],"
+            "{\"index\":\"name\"}],5]],"
+            "{\"db\":[14,[\"test\"]],\"durability\":\"soft\"}]"));
+}
+
+TEST(QueryCaptureTest, RedactValues) {
+    // r.table("users").insert({name: "bob", age: 42, tags: ["a"], admin: true})
+    EXPECT_EQ(
+        "[1,[56,[[15,[\"users\"]],"
+        "{\"name\":\"xxx\",\"age\":0,\"tags\":[2,[\"x\"]],\"admin\":true}]]]",
+        redact_query(
+            "[1,[56,[[15,[\"users\"]],"
+            "{\"name\":\"bob\",\"age\":42,\"tags\":[2,[\"a\"]],\"admin\":true}]]]"));
+
+    // Wrapped datums are redacted all the way down, except for object keys.
+    EXPECT_EQ("[1,[1,{\"a\":[\"xx\",0,null]}]]",
+              redact_query("[1,[1,{\"a\":[\"hi\",7.5,null]}]]"));
+}
+
+TEST(QueryCaptureTest, RedactKeepsFunctions) {
+    // r.table("users").filter(lambda row: row["age"] == 30)
+    EXPECT_EQ(
+        "[1,[39,[[15,[\"users\"]],[69,[[2,[1]],[17,[[170,[[10,[1]],\"age\"]],0]]]]]]]",
+        redact_query(
+            "[1,[39,[[15,[\"users\"]],"
+            "[69,[[2,[1]],[17,[[170,[[10,[1]],\"age\"]],30]]]]]]]"));
+}
+
+}  // namespace unittest
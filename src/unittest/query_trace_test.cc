@@ -0,0 +1,44 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/query_trace.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+TEST(QueryTraceTest, ParseTraceparent) {
+    ql::trace_context_t context;
+    ASSERT_TRUE(ql::trace_context_t::parse(
+        "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01", &context));
+    EXPECT_EQ("4bf92f3577b34da6a3ce929d0e0e4736", context.trace_id);
+    EXPECT_EQ("00f067aa0ba902b7", context.parent_id);
+    EXPECT_TRUE(context.sampled);
+
+    ASSERT_TRUE(ql::trace_context_t::parse(
+        "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-00", &context));
+    EXPECT_FALSE(context.sampled);
+
+    // Unknown version, uppercase, all-zero ids and bad lengths
+    EXPECT_FALSE(ql::trace_context_t::parse(
+        "01-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01", &context));
+    EXPECT_FALSE(ql::trace_context_t::parse(
+        "00-4BF92F3577B34DA6A3CE929D0E0E4736-00f067aa0ba902b7-01", &context));
+    EXPECT_FALSE(ql::trace_context_t::parse(
+        "00-00000000000000000000000000000000-00f067aa0ba902b7-01", &context));
+    EXPECT_FALSE(ql::trace_context_t::parse(
+        "00-4bf92f3577b34da6a3ce929d0e0e4736-0000000000000000-01", &context));
+    EXPECT_FALSE(ql::trace_context_t::parse(
+        "00-4bf92f3577b34da6a3ce929d0e0e473-00f067aa0ba902b7-01", &context));
+    EXPECT_FALSE(ql::trace_context_t::parse("", &context));
+}
+
+TEST(QueryTraceTest, SampledByClient) {
+    ql::trace_context_t context;
+    ASSERT_TRUE(ql::trace_context_t::parse(
+        "00-4bf92f3577b34da6a3ce929d0e0e4736-00f067aa0ba902b7-01", &context));
+    optional<ql::trace_context_t> sampled =
+        ql::trace_context_t::maybe_sample(make_optional(context));
+    ASSERT_TRUE(sampled.has_value());
+    EXPECT_EQ(context.trace_id, sampled->trace_id);
+    EXPECT_EQ(context.parent_id, sampled->parent_id);
+}
+
+}  // namespace unittest
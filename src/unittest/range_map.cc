@@ -255,5 +255,49 @@ TEST(RangeMap, RangeMap) {
     }
 }
 
+/* Many fine-grained zones, as a table with many shards has. This checks the hinted
+insertions that keep building and updating large maps cheap. */
+TEST(RangeMap, ManyZones) {
+    const int num_zones = 20000;
+    range_map_t<int, int> map(0);
+    for (int i = 0; i < num_zones; ++i) {
+        map.extend_right(i, i + 1, clone(i % 2));
+    }
+    ASSERT_EQ(num_zones, map.right_edge());
+
+    /* Overwrite every other pair of zones with a map that has its own zones */
+    for (int i = 0; i + 4 <= num_zones; i += 8) {
+        range_map_t<int, int> chunk(i, i + 2, 7);
+        chunk.extend_right(i + 2, i + 4, 8);
+        map.update(std::move(chunk));
+    }
+
+    range_map_t<int, int> masked = map.mask(100, num_zones - 100);
+    EXPECT_EQ(100, masked.left_edge());
+    EXPECT_EQ(num_zones - 100, masked.right_edge());
+    for (int i = 100; i < num_zones - 100; ++i) {
+        int expected;
+        if (i % 8 < 2) {
+            expected = 7;
+        } else if (i % 8 < 4) {
+            expected = 8;
+        } else {
+            expected = i % 2;
+        }
+        EXPECT_EQ(expected, map.lookup(i));
+        EXPECT_EQ(expected, masked.lookup(i));
+    }
+
+    range_map_t<int, int> left(-num_zones);
+    for (int i = -num_zones; i < 0; ++i) {
+        left.extend_right(i, i + 1, clone(i % 3 == 0 ? 1 : 2));
+    }
+    map.extend_left(std::move(left));
+    EXPECT_EQ(-num_zones, map.left_edge());
+    EXPECT_EQ(1, map.lookup(-3));
+    EXPECT_EQ(2, map.lookup(-2));
+    EXPECT_EQ(7, map.lookup(0));
+}
+
 } /* namespace unittest */
 
@@ -495,6 +495,7 @@ TPTEST(RDBBackfill, FillItemQueue) {
     preempt. */
     backfill_test_config_t cfg;
     cfg.backfill.item_queue_mem_size = 1;
+    cfg.backfill.max_item_queue_mem_size = 1;
     cfg.backfill.item_chunk_mem_size = 1;
     cfg.backfill.pre_item_queue_mem_size = GIGABYTE;
     cfg.min_preempt_ms = cfg.max_preempt_ms = 60 * 60 * 1000;
@@ -505,6 +506,17 @@ TPTEST(RDBBackfill, FillItemQueue) {
     run_backfill_test(cfg);
 }
 
+TPTEST(RDBBackfill, GrowItemQueue) {
+    /* Start with an item queue that only fits one chunk, but let the backfiller grow it
+    as it measures how fast the backfillee consumes items. */
+    backfill_test_config_t cfg;
+    cfg.backfill.item_queue_mem_size = 1;
+    cfg.backfill.item_chunk_mem_size = KILOBYTE;
+    cfg.backfill.max_item_queue_mem_size = GIGABYTE;
+    cfg.min_preempt_ms = cfg.max_preempt_ms = 60 * 60 * 1000;
+    run_backfill_test(cfg);
+}
+
 TPTEST(RDBBackfill, FillPreItemQueue) {
     /* Force the pre-item queue to fill up, but make the item queue unlimited and never
     preempt. */
@@ -533,6 +545,7 @@ TPTEST(RDBBackfill, FillBothQueuesAndPreemptOften) {
     */
     backfill_test_config_t cfg;
     cfg.backfill.item_queue_mem_size = 1;
+    cfg.backfill.max_item_queue_mem_size = 1;
     cfg.backfill.item_chunk_mem_size = 1;
     cfg.backfill.pre_item_queue_mem_size = 1;
     cfg.backfill.pre_item_chunk_mem_size = 1;
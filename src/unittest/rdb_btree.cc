@@ -4,6 +4,7 @@
 #include "arch/io/disk.hpp"
 #include "arch/runtime/coroutines.hpp"
 #include "arch/timing.hpp"
+#include "btree/depth_first_traversal.hpp"
 #include "btree/operations.hpp"
 #include "btree/reql_specific.hpp"
 #include "buffer_cache/cache_balancer.hpp"
@@ -373,6 +374,105 @@ TPTEST(RDBBtree, SindexEraseRange) {
     check_keys_are_NOT_present(&store, sindex_name);
 }
 
+class count_keys_callback_t : public depth_first_traversal_callback_t {
+public:
+    count_keys_callback_t() : count(0) { }
+    continue_bool_t handle_pair(scoped_key_value_t &&, signal_t *) {
+        ++count;
+        return continue_bool_t::CONTINUE;
+    }
+    int count;
+};
+
+int count_keys(store_t *store) {
+    cond_t dummy_interruptor;
+    read_token_t token;
+    store->new_read_token(&token);
+    scoped_ptr_t<txn_t> txn;
+    scoped_ptr_t<real_superblock_t> superblock;
+    store->acquire_superblock_for_read(
+        &token, &txn, &superblock, &dummy_interruptor, false);
+    count_keys_callback_t callback;
+    btree_depth_first_traversal(
+        superblock.get(), key_range_t::universe(), &callback, access_t::read,
+        direction_t::FORWARD, release_superblock_t::RELEASE, &dummy_interruptor);
+    return callback.count;
+}
+
+TPTEST(RDBBtree, EraseRangeWithoutModReports) {
+    recreate_temporary_directory(base_path_t("."));
+    temp_file_t temp_file;
+
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_cache_balancer_t balancer(GIGABYTE);
+
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    log_serializer_t::create(
+        &file_opener,
+        log_serializer_t::static_config_t());
+
+    log_serializer_t serializer(
+        log_serializer_t::dynamic_config_t(),
+        &file_opener,
+        &get_global_perfmon_collection());
+
+    store_t store(
+            region_t::universe(),
+            &serializer,
+            &balancer,
+            "unit_test_store",
+            true,
+            &get_global_perfmon_collection(),
+            nullptr,
+            &io_backender,
+            base_path_t("."),
+            generate_uuid(),
+            update_sindexes_t::UPDATE,
+            which_cpu_shard_t{0, 1});
+
+    cond_t dummy_interruptor;
+
+    insert_rows(0, TOTAL_KEYS_TO_INSERT, &store);
+    ASSERT_EQ(TOTAL_KEYS_TO_INSERT, count_keys(&store));
+
+    /* Erase everything in small passes, the way `store_t::reset_data()` does for
+    tables without secondary indexes. */
+    always_true_key_tester_t tester;
+    for (continue_bool_t done = continue_bool_t::CONTINUE;
+         done == continue_bool_t::CONTINUE;) {
+        write_token_t token;
+        store.new_write_token(&token);
+
+        scoped_ptr_t<txn_t> txn;
+        {
+            scoped_ptr_t<real_superblock_t> super_block;
+            store.acquire_superblock_for_write(
+                102,
+                write_durability_t::SOFT,
+                &token,
+                &txn,
+                &super_block,
+                &dummy_interruptor);
+
+            rdb_live_deletion_context_t deletion_context;
+            key_range_t deleted_range;
+            done = rdb_erase_small_range(
+                store.btree.get(),
+                &tester,
+                key_range_t::universe(),
+                super_block.get(),
+                &deletion_context,
+                &dummy_interruptor,
+                100,
+                nullptr,
+                &deleted_range);
+        }
+        txn->commit();
+    }
+
+    ASSERT_EQ(0, count_keys(&store));
+}
+
 TPTEST(RDBBtree, SindexInterruptionViaDrop) {
     recreate_temporary_directory(base_path_t("."));
     temp_file_t temp_file;
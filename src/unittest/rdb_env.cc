@@ -124,6 +124,11 @@ void NORETURN mock_namespace_interface_t::read_visitor_t::operator()(
     throw cannot_perform_query_exc_t("unimplemented", query_state_t::FAILED);
 }
 
+void NORETURN mock_namespace_interface_t::read_visitor_t::operator()(
+        UNUSED const sample_read_t &s) {
+    throw cannot_perform_query_exc_t("unimplemented", query_state_t::FAILED);
+}
+
 mock_namespace_interface_t::read_visitor_t::read_visitor_t(
         mock_namespace_interface_t *_parent,
         read_response_t *_response) :
@@ -419,6 +424,8 @@ bool test_rdb_env_t::instance_t::table_create(
         UNUSED const table_generate_config_params_t &config_params,
         UNUSED const std::string &primary_key,
         UNUSED write_durability_t durability,
+        UNUSED int cpu_sharding_factor,
+        UNUSED int block_size,
         UNUSED signal_t *local_interruptor,
         UNUSED ql::datum_t *result_out,
         admin_err_t *error_out) {
@@ -485,6 +492,7 @@ bool test_rdb_env_t::instance_t::table_find(const name_string_t &name,
                 table_access,
                 it->second->get_primary_key(),
                 nullptr,
+                nullptr,
                 nullptr));
         return true;
     }
@@ -503,6 +511,19 @@ bool test_rdb_env_t::instance_t::table_estimate_doc_counts(
     return false;
 }
 
+bool test_rdb_env_t::instance_t::table_shard_map(
+        UNUSED auth::user_context_t const &user_context,
+        UNUSED counted_t<const ql::db_t> db,
+        UNUSED const name_string_t &name,
+        UNUSED ql::env_t *local_env,
+        UNUSED ql::datum_t *shard_map_out,
+        admin_err_t *error_out) {
+    *error_out = admin_err_t{
+        "test_rdb_env_t::instance_t doesn't support info()",
+        query_state_t::FAILED};
+    return false;
+}
+
 bool test_rdb_env_t::instance_t::table_config(
         UNUSED auth::user_context_t const &user_context,
         UNUSED counted_t<const ql::db_t> db,
@@ -84,6 +84,7 @@ private:
         void NORETURN operator()(UNUSED const intersecting_geo_read_t &gr);
         void NORETURN operator()(UNUSED const nearest_geo_read_t &gr);
         void NORETURN operator()(UNUSED const distribution_read_t &dg);
+        void NORETURN operator()(UNUSED const sample_read_t &s);
 
         read_visitor_t(mock_namespace_interface_t *parent, read_response_t *_response);
 
@@ -191,6 +192,8 @@ public:
                 const table_generate_config_params_t &config_params,
                 const std::string &primary_key,
                 write_durability_t durability,
+                int cpu_sharding_factor,
+                int block_size,
                 signal_t *interruptor,
                 ql::datum_t *result_out,
                 admin_err_t *error_out);
@@ -215,6 +218,13 @@ public:
                 ql::env_t *env,
                 std::vector<int64_t> *doc_counts_out,
                 admin_err_t *error_out);
+        bool table_shard_map(
+                auth::user_context_t const &user_context,
+                counted_t<const ql::db_t> db,
+                const name_string_t &name,
+                ql::env_t *env,
+                ql::datum_t *shard_map_out,
+                admin_err_t *error_out);
         bool table_config(
                 auth::user_context_t const &user_context,
                 counted_t<const ql::db_t> db,
@@ -2,6 +2,7 @@
 #include "unittest/rdb_protocol.hpp"
 
 #include <functional>
+#include <set>
 #include <vector>
 
 #include "arch/io/disk.hpp"
@@ -204,6 +205,74 @@ TEST(RDBProtocol, OvershardedGetSet) {
     run_in_thread_pool_with_namespace_interface(&run_get_set_test, true);
 }
 
+/* `Sample` tests that a sample read returns distinct rows, and gives up if the table
+is too small to sample without a full scan */
+void run_sample_test(
+        namespace_interface_t *nsi,
+        order_source_t *osource,
+        const std::vector<scoped_ptr_t<store_t> > *) {
+    const int num_rows = 2000;
+    for (int i = 0; i < num_rows; ++i) {
+        write_t write(
+                point_write_t(store_key_t(strprintf("key%d", i)),
+                              ql::datum_t(static_cast<double>(i))),
+                DURABILITY_REQUIREMENT_DEFAULT,
+                profile_bool_t::DONT_PROFILE,
+                ql::configured_limits_t());
+        write_response_t response;
+
+        cond_t interruptor;
+        nsi->write(
+            auth::user_context_t(auth::permissions_t(
+                tribool::True, tribool::True, tribool::False, tribool::False)),
+            write,
+            &response,
+            osource->check_in("unittest::run_sample_test(rdb_protocol.cc-A)"),
+            &interruptor);
+    }
+
+    auto sample = [&](uint64_t num) {
+        read_t read(sample_read_t(num), profile_bool_t::DONT_PROFILE,
+                    read_mode_t::SINGLE);
+        read_response_t response;
+
+        cond_t interruptor;
+        nsi->read(
+            auth::user_context_t(auth::permissions_t(
+                tribool::True, tribool::False, tribool::False, tribool::False)),
+            read,
+            &response,
+            osource->check_in("unittest::run_sample_test(rdb_protocol.cc-B)"),
+            &interruptor);
+        sample_read_response_t *res =
+            boost::get<sample_read_response_t>(&response.response);
+        guarantee(res != nullptr);
+        return *res;
+    };
+
+    sample_read_response_t res = sample(10);
+    ASSERT_TRUE(res.complete);
+    ASSERT_EQ(10u, res.rows.size());
+    std::set<double> seen;
+    for (const ql::datum_t &row : res.rows) {
+        double value = row.as_num();
+        ASSERT_TRUE(value >= 0 && value < num_rows);
+        ASSERT_TRUE(seen.insert(value).second);
+    }
+    ASSERT_GT(res.population, num_rows / 2);
+    ASSERT_LT(res.population, num_rows * 2);
+
+    ASSERT_FALSE(sample(num_rows).complete);
+}
+
+TEST(RDBProtocol, Sample) {
+    run_in_thread_pool_with_namespace_interface(&run_sample_test, false);
+}
+
+TEST(RDBProtocol, OvershardedSample) {
+    run_in_thread_pool_with_namespace_interface(&run_sample_test, true);
+}
+
 std::string create_sindex(const std::vector<scoped_ptr_t<store_t> > *stores) {
     std::string id = uuid_to_str(generate_uuid());
 
@@ -920,6 +989,8 @@ TPTEST(RDBProtocol, ArtificialChangefeeds) {
                               false,
                               false,
                               false,
+                              false,
+                              r_nullopt,
                               ql::configured_limits_t(),
                               ql::datum_t::boolean(false),
                               keyspec_t::point_t{ql::datum_t(0.0)}),
@@ -935,6 +1006,8 @@ TPTEST(RDBProtocol, ArtificialChangefeeds) {
                                false,
                                false,
                                false,
+                               false,
+                               r_nullopt,
                                ql::configured_limits_t(),
                                ql::datum_t::boolean(false),
                                keyspec_t::point_t{ql::datum_t(10.0)}),
@@ -950,6 +1023,8 @@ TPTEST(RDBProtocol, ArtificialChangefeeds) {
                             false,
                             false,
                             false,
+                            false,
+                            r_nullopt,
                             ql::configured_limits_t(),
                             ql::datum_t::boolean(false),
                             keyspec_t::range_t{
@@ -981,7 +1056,8 @@ TPTEST(RDBProtocol, ArtificialChangefeeds) {
             index_vals_t(),
             store_key_t(ql::datum_t(static_cast<double>(i)).print_primary()),
             ql::datum_t(-static_cast<double>(i)),
-            ql::datum_t(static_cast<double>(i))}));
+            ql::datum_t(static_cast<double>(i)),
+            0}));
     }
     for (const auto &pair : bundles) {
         ql::batchspec_t bs(ql::batchspec_t::all()
@@ -70,4 +70,93 @@ TEST(Rebalance, MaxKeyLength) {
     do_rebalance(distribution, 3);
 }
 
+TEST(Rebalance, HotKey) {
+    static const uint8_t key1[1] = { 'A' };
+    static const uint8_t key2[1] = { 'F' };
+    static const uint8_t key3[1] = { 'K' };
+    static const uint8_t key4[1] = { 'P' };
+    static const uint8_t hot_key[2] = { 'P', 'Q' };
+
+    std::map<store_key_t, int64_t> distribution;
+    distribution[store_key_t(sizeof(key1), key1)] = 100;
+    distribution[store_key_t(sizeof(key2), key2)] = 100;
+    distribution[store_key_t(sizeof(key3), key3)] = 100;
+    distribution[store_key_t(sizeof(key4), key4)] = 100;
+
+    std::map<store_key_t, int64_t> loads;
+    loads[store_key_t(sizeof(hot_key), hot_key)] = 1000;
+
+    /* By key count alone, the last shard would start somewhere in the middle of the
+    key space. The hot key carries half of the combined weight, so the shard containing
+    it should end up with little else. */
+    table_shard_scheme_t split_points = do_rebalance(
+        combine_distribution_with_loads(distribution, loads), 2);
+    ASSERT_EQ(1u, split_points.split_points.size());
+    EXPECT_GE(split_points.split_points[0], store_key_t(sizeof(key4), key4));
+    EXPECT_LE(split_points.split_points[0], store_key_t(sizeof(hot_key), hot_key));
+
+    /* Without any load, we balance by key count as before. */
+    EXPECT_EQ(distribution, combine_distribution_with_loads(
+        distribution, std::map<store_key_t, int64_t>()));
+}
+
+table_shard_scheme_t shard_scheme_for(const std::string &split_points) {
+    table_shard_scheme_t shard_scheme;
+    for (char c : split_points) {
+        shard_scheme.split_points.push_back(store_key_t(std::string(1, c)));
+    }
+    return shard_scheme;
+}
+
+std::map<store_key_t, int64_t> even_distribution(char first, char last) {
+    std::map<store_key_t, int64_t> distribution;
+    for (char c = first; c <= last; ++c) {
+        distribution[store_key_t(std::string(1, c))] = 10;
+    }
+    return distribution;
+}
+
+TEST(Rebalance, SplitKeepsOldSplitPoints) {
+    /* The first shard has three times as many documents as the second, so both new
+    shards should come out of it. */
+    std::map<store_key_t, int64_t> distribution = even_distribution('A', 'L');
+    table_shard_scheme_t old_shard_scheme = shard_scheme_for("J");
+    table_shard_scheme_t new_shard_scheme;
+    ASSERT_TRUE(calculate_split_points_with_minimal_movement(
+        distribution, 4, old_shard_scheme, &new_shard_scheme));
+    ASSERT_EQ(3u, new_shard_scheme.split_points.size());
+    EXPECT_EQ(shard_scheme_for("DGJ").split_points, new_shard_scheme.split_points);
+
+    /* Each shard has only one key, so neither of them can be split. */
+    EXPECT_FALSE(calculate_split_points_with_minimal_movement(
+        even_distribution('A', 'B'), 3, shard_scheme_for("B"), &new_shard_scheme));
+}
+
+TEST(Rebalance, MergeRemovesSmallestPair) {
+    /* Shards: [A, D) with 30 documents, [D, F) with 20, [F, H) with 20 and [H, ...)
+    with 30. The two shards in the middle make the smallest pair. */
+    table_shard_scheme_t new_shard_scheme;
+    ASSERT_TRUE(calculate_split_points_with_minimal_movement(
+        even_distribution('A', 'J'), 3, shard_scheme_for("DFH"), &new_shard_scheme));
+    EXPECT_EQ(shard_scheme_for("DH").split_points, new_shard_scheme.split_points);
+
+    ASSERT_TRUE(calculate_split_points_with_minimal_movement(
+        even_distribution('A', 'J'), 1, shard_scheme_for("DFH"), &new_shard_scheme));
+    EXPECT_TRUE(new_shard_scheme.split_points.empty());
+}
+
+TEST(Rebalance, AdjustKeepsNearlyEvenSplitPoints) {
+    /* With 20 keys and four shards, the even split points are F, K and P. G is within
+    the tolerance, but S is too far off. */
+    std::map<store_key_t, int64_t> distribution = even_distribution('A', 'T');
+    table_shard_scheme_t new_shard_scheme;
+    ASSERT_TRUE(adjust_split_points_with_distribution(
+        distribution, shard_scheme_for("GKS"), 0.25, &new_shard_scheme));
+    ASSERT_EQ(3u, new_shard_scheme.split_points.size());
+    EXPECT_EQ(store_key_t("G"), new_shard_scheme.split_points[0]);
+    EXPECT_EQ(store_key_t("K"), new_shard_scheme.split_points[1]);
+    EXPECT_EQ(do_rebalance(distribution, 4).split_points[2],
+              new_shard_scheme.split_points[2]);
+}
+
 }  // namespace unittest
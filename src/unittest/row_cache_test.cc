@@ -0,0 +1,68 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/row_cache.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+static ql::datum_t make_row(size_t size) {
+    return ql::datum_t(datum_string_t(std::string(size, 'x')));
+}
+
+TEST(RowCache, InsertAndInvalidate) {
+    row_cache_t cache;
+    ql::datum_t row;
+    EXPECT_FALSE(cache.find(store_key_t("a"), &row));
+    cache.maybe_insert(store_key_t("a"), make_row(10), cache.get_generation());
+    ASSERT_TRUE(cache.find(store_key_t("a"), &row));
+    EXPECT_EQ(make_row(10), row);
+
+    cache.invalidate(store_key_t("a"));
+    EXPECT_FALSE(cache.find(store_key_t("a"), &row));
+
+    // A row read before an invalidation isn't cached, even if another key changed.
+    uint64_t generation = cache.get_generation();
+    cache.invalidate(store_key_t("b"));
+    cache.maybe_insert(store_key_t("a"), make_row(10), generation);
+    EXPECT_FALSE(cache.find(store_key_t("a"), &row));
+}
+
+TEST(RowCache, InvalidateRange) {
+    row_cache_t cache;
+    for (char c = 'a'; c <= 'e'; ++c) {
+        cache.maybe_insert(
+            store_key_t(std::string(1, c)), make_row(10), cache.get_generation());
+    }
+    cache.invalidate_range(key_range_t(key_range_t::closed, store_key_t("b"),
+                                       key_range_t::open, store_key_t("d")));
+    ql::datum_t row;
+    EXPECT_TRUE(cache.find(store_key_t("a"), &row));
+    EXPECT_FALSE(cache.find(store_key_t("b"), &row));
+    EXPECT_FALSE(cache.find(store_key_t("c"), &row));
+    EXPECT_TRUE(cache.find(store_key_t("d"), &row));
+    EXPECT_TRUE(cache.find(store_key_t("e"), &row));
+}
+
+TEST(RowCache, ScanDoesNotEvictHotRows) {
+    row_cache_t cache;
+    ql::datum_t row;
+    const int num_hot = 100;
+    for (int i = 0; i < num_hot; ++i) {
+        store_key_t key(strprintf("hot%d", i));
+        for (int j = 0; j < 5; ++j) {
+            cache.find(key, &row);
+        }
+        cache.maybe_insert(key, make_row(32 * KILOBYTE), cache.get_generation());
+    }
+    // Far more than fits, each read once
+    for (int i = 0; i < 1000; ++i) {
+        store_key_t key(strprintf("cold%d", i));
+        if (!cache.find(key, &row)) {
+            cache.maybe_insert(key, make_row(32 * KILOBYTE), cache.get_generation());
+        }
+    }
+    for (int i = 0; i < num_hot; ++i) {
+        EXPECT_TRUE(cache.find(store_key_t(strprintf("hot%d", i)), &row));
+    }
+}
+
+}  // namespace unittest
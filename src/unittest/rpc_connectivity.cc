@@ -1,5 +1,8 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
+#include <algorithm>
 #include <functional>
+#include <string>
+#include <vector>
 
 #ifdef _WIN32
 #include "windows.hpp"
@@ -46,11 +49,8 @@ public:
         public:
             explicit writer_t(int _data) : data(_data) { }
             virtual ~writer_t() { }
-            void write(write_stream_t *stream) {
-                write_message_t wm;
-                serialize<cluster_version_t::CLUSTER>(&wm, data);
-                int res = send_write_message(stream, &wm);
-                if (res) { throw fake_archive_exc_t(); }
+            void write(write_message_t *wm) {
+                serialize<cluster_version_t::CLUSTER>(wm, data);
             }
 #ifdef ENABLE_MESSAGE_PROFILER
             const char *message_profiler_tag() const {
@@ -400,13 +400,12 @@ public:
             public cluster_send_message_write_callback_t {
         public:
             virtual ~dump_spectrum_writer_t() { }
-            void write(write_stream_t *stream) {
+            void write(write_message_t *wm) {
                 char spectrum[CHAR_MAX - CHAR_MIN + 1];
                 for (int i = CHAR_MIN; i <= CHAR_MAX; i++) {
                     spectrum[i - CHAR_MIN] = i;
                 }
-                int64_t res = stream->write(spectrum, CHAR_MAX - CHAR_MIN + 1);
-                if (res != CHAR_MAX - CHAR_MIN + 1) { throw fake_archive_exc_t(); }
+                wm->append(spectrum, CHAR_MAX - CHAR_MIN + 1);
             }
 #ifdef ENABLE_MESSAGE_PROFILER
             const char *message_profiler_tag() const {
@@ -452,6 +451,153 @@ TPTEST_MULTITHREAD(RPCConnectivityTest, BinaryData, 3) {
     EXPECT_TRUE(a2.got_spectrum);
 }
 
+/* `CompressedMessages` sends messages above and below the compression threshold
+between a server that compresses what it sends and one that doesn't. */
+
+class string_test_application_t : public cluster_message_handler_t {
+public:
+    explicit string_test_application_t(connectivity_cluster_t *cm,
+                                       connectivity_cluster_t::message_tag_t tag = 'S') :
+        cluster_message_handler_t(cm, tag)
+        { }
+    void send(const std::string &message, peer_id_t peer) {
+        class string_writer_t : public cluster_send_message_write_callback_t {
+        public:
+            explicit string_writer_t(const std::string &_data) : data(_data) { }
+            virtual ~string_writer_t() { }
+            void write(write_message_t *wm) {
+                serialize<cluster_version_t::CLUSTER>(wm, data);
+            }
+#ifdef ENABLE_MESSAGE_PROFILER
+            const char *message_profiler_tag() const {
+                return "unittest";
+            }
+#endif
+            const std::string &data;
+        } writer(message);
+        auto_drainer_t::lock_t connection_keepalive;
+        connectivity_cluster_t::connection_t *connection =
+            get_connectivity_cluster()->get_connection(peer, &connection_keepalive);
+        ASSERT_TRUE(connection != nullptr);
+        get_connectivity_cluster()->send_message(connection, connection_keepalive,
+                                                 get_message_tag(), &writer);
+    }
+    void on_message(connectivity_cluster_t::connection_t *,
+                    auto_drainer_t::lock_t,
+                    read_stream_t *stream) {
+        std::string message;
+        archive_result_t res
+            = deserialize<cluster_version_t::CLUSTER>(stream, &message);
+        if (bad(res)) { throw fake_archive_exc_t(); }
+        received.push_back(message);
+    }
+    std::vector<std::string> received;
+};
+
+TPTEST(RPCConnectivityTest, CompressedMessages) {
+    connectivity_cluster_t c1, c2;
+    string_test_application_t a1(&c1), a2(&c2);
+    test_cluster_run_t cr1(&c1, peer_address_t(), cluster_compression_t::zlib);
+    test_cluster_run_t cr2(&c2);
+    cr1.join(get_cluster_local_address(&c2), 0);
+
+    let_stuff_happen();
+
+    std::vector<std::string> messages;
+    messages.push_back("small");
+    for (int i = 0; i < 5; ++i) {
+        std::string message;
+        for (int j = 0; j < 1000 * (i + 1); ++j) {
+            message += std::to_string(j * (i + 1));
+        }
+        messages.push_back(message);
+    }
+    messages.push_back("small again");
+    for (const std::string &message : messages) {
+        a1.send(message, c2.get_me());
+        a2.send(message, c1.get_me());
+    }
+
+    let_stuff_happen();
+
+    EXPECT_EQ(messages, a2.received);
+    EXPECT_EQ(messages, a1.received);
+}
+
+/* `LargeMessages` checks that messages big enough to skip the connection's write
+buffer stay in order with the small ones around them. */
+TPTEST_MULTITHREAD(RPCConnectivityTest, LargeMessages, 3) {
+    connectivity_cluster_t c1, c2;
+    string_test_application_t a1(&c1), a2(&c2);
+    test_cluster_run_t cr1(&c1);
+    test_cluster_run_t cr2(&c2);
+    cr1.join(get_cluster_local_address(&c2), 0);
+
+    let_stuff_happen();
+
+    std::vector<std::string> messages;
+    for (int i = 0; i < 10; ++i) {
+        messages.push_back("small " + std::to_string(i));
+        messages.push_back(std::string(30000 * i + 1, 'a' + i));
+    }
+    for (const std::string &message : messages) {
+        a1.send(message, c2.get_me());
+        a2.send(message, c1.get_me());
+    }
+
+    let_stuff_happen();
+
+    EXPECT_EQ(messages, a2.received);
+    EXPECT_EQ(messages, a1.received);
+}
+
+/* `ConnectionsPerPeer` sends big and small messages over several TCP connections to
+the same peer. Messages for a handler that allows reordering may arrive in any order,
+but the others must stay in order. */
+
+class reorderable_string_test_application_t : public string_test_application_t {
+public:
+    explicit reorderable_string_test_application_t(connectivity_cluster_t *cm) :
+        string_test_application_t(cm, 'R')
+        { }
+    bool allows_reordering() const {
+        return true;
+    }
+};
+
+TPTEST_MULTITHREAD(RPCConnectivityTest, ConnectionsPerPeer, 3) {
+    connectivity_cluster_t c1, c2;
+    string_test_application_t a1(&c1), a2(&c2);
+    reorderable_string_test_application_t r1(&c1), r2(&c2);
+    test_cluster_run_t cr1(&c1, peer_address_t(), cluster_compression_t::zlib, 4);
+    test_cluster_run_t cr2(&c2, peer_address_t(), cluster_compression_t::none, 3);
+    cr1.join(get_cluster_local_address(&c2), 0);
+
+    let_stuff_happen();
+
+    std::vector<std::string> messages;
+    for (int i = 0; i < 20; ++i) {
+        messages.push_back("small " + std::to_string(i));
+        messages.push_back(std::string(10000 * i, 'a' + i));
+    }
+    for (const std::string &message : messages) {
+        a1.send(message, c2.get_me());
+        a2.send(message, c1.get_me());
+        r1.send(message, c2.get_me());
+        r2.send(message, c1.get_me());
+    }
+
+    let_stuff_happen();
+
+    EXPECT_EQ(messages, a2.received);
+    EXPECT_EQ(messages, a1.received);
+    std::sort(messages.begin(), messages.end());
+    std::sort(r1.received.begin(), r1.received.end());
+    std::sort(r2.received.begin(), r2.received.end());
+    EXPECT_EQ(messages, r2.received);
+    EXPECT_EQ(messages, r1.received);
+}
+
 /* `PeerIDSemantics` makes sure that `peer_id_t::is_nil()` works as expected. */
 TPTEST_MULTITHREAD(RPCConnectivityTest, PeerIDSemantics, 3) {
     peer_id_t nil_peer;
@@ -120,6 +120,28 @@ TPTEST(RPCDirectoryTest, MapUpdate) {
         rm2.get_root_view()->get_key(std::make_pair(c1.get_me(), 102)));
 }
 
+/* `MapManyKeys` tests that a burst of changes that doesn't fit into a single message
+still reaches the peers completely. */
+TPTEST(RPCDirectoryTest, MapManyKeys) {
+    connectivity_cluster_t c1, c2;
+    directory_map_read_manager_t<int, int> rm1(&c1, 'D'), rm2(&c2, 'D');
+    watchable_map_var_t<int, int> w1, w2;
+    directory_map_write_manager_t<int, int> wm1(&c1, 'D', &w1), wm2(&c2, 'D', &w2);
+    test_cluster_run_t cr1(&c1);
+    test_cluster_run_t cr2(&c2);
+    cr2.join(get_cluster_local_address(&c1), 0);
+    let_stuff_happen();
+    const int num_keys = 3 * DIRECTORY_MAP_MAX_KEYS_PER_MESSAGE + 1;
+    for (int i = 0; i < num_keys; ++i) {
+        w1.set_key(i, i * 2);
+    }
+    let_stuff_happen();
+    for (int i = 0; i < num_keys; ++i) {
+        ASSERT_TRUE(optional<int>(i * 2) ==
+            rm2.get_root_view()->get_key(std::make_pair(c1.get_me(), i)));
+    }
+}
+
 /* `DestructorRace` tests a nasty race condition that we had at some point. */
 TPTEST(RPCDirectoryTest, DestructorRace) {
     connectivity_cluster_t c;
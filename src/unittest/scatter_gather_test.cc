@@ -0,0 +1,55 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <vector>
+
+#include "arch/timing.hpp"
+#include "concurrency/scatter_gather.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+TEST(ScatterGatherTest, RunsOnTargetThreads) {
+    int num_threads = 4;
+    run_in_thread_pool([&]() {
+        // Several items per thread, including the one we're on
+        std::vector<threadnum_t> targets;
+        for (int i = 0; i < 50; ++i) {
+            targets.push_back(threadnum_t((i * 7) % num_threads));
+        }
+        std::vector<int> calls(targets.size(), 0);
+        std::vector<int> threads(targets.size(), -1);
+        scatter_gather(targets, [&](int64_t i) {
+            // Make the items overlap on their threads
+            nap(1);
+            ++calls[i];
+            threads[i] = get_thread_id().threadnum;
+        });
+        for (size_t i = 0; i < targets.size(); ++i) {
+            EXPECT_EQ(1, calls[i]);
+            EXPECT_EQ(targets[i].threadnum, threads[i]);
+        }
+        // Nothing at all to do
+        scatter_gather(std::vector<threadnum_t>(), [&](int64_t) {
+            ADD_FAILURE();
+        });
+    }, num_threads);
+}
+
+TEST(ScatterGatherTest, AllThreads) {
+    int num_threads = 3;
+    run_in_thread_pool([&]() {
+        threadnum_t caller = get_thread_id();
+        std::vector<int> calls(num_threads, 0);
+        scatter_gather_on_all_threads([&](int32_t thread) {
+            EXPECT_EQ(thread, get_thread_id().threadnum);
+            ++calls[thread];
+        });
+        for (int t = 0; t < num_threads; ++t) {
+            EXPECT_EQ(1, calls[t]);
+        }
+        // We come back on the thread that we started on
+        EXPECT_EQ(caller.threadnum, get_thread_id().threadnum);
+    }, num_threads);
+}
+
+}  // namespace unittest
@@ -2,7 +2,11 @@
 
 #include "arch/runtime/starter.hpp"
 #include "concurrency/new_mutex.hpp"
+#include "serializer/backup.hpp"
+#include "serializer/block_buffer_pool.hpp"
 #include "serializer/buf_ptr.hpp"
+#include "serializer/log/block_checksum.hpp"
+#include "serializer/log/lba/in_memory_index.hpp"
 #include "serializer/log/log_serializer.hpp"
 #include "unittest/mock_file.hpp"
 #include "unittest/gtest.hpp"
@@ -30,7 +34,7 @@ void run_AddDeleteRepeatedly(bool perform_index_write) {
 
     buf_ptr_t buf = buf_ptr_t::alloc_zeroed(ser.max_block_size());
 
-    scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+    scoped_ptr_t<file_account_t> account(ser.make_io_account(io_class_t::DEFAULT, 1));
 
     // We run enough create/delete operations to run ourselves through the young
     // extent queue and (with perform_index_write true) kick off a GC that reproduces
@@ -90,5 +94,362 @@ TEST(SerializerTest, AddDeleteRepeatedlyWithIndex) {
     run_in_thread_pool(std::bind(run_AddDeleteRepeatedly, true), 4);
 }
 
+TPTEST(SerializerTest, CompressedBlockRoundTrip, 4) {
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+    log_serializer_t::dynamic_config_t dynamic_config;
+    dynamic_config.compression = block_compression_t::zlib;
+    log_serializer_t ser(dynamic_config,
+                         &file_opener,
+                         &get_global_perfmon_collection());
+
+    // A highly compressible block.
+    buf_ptr_t buf = buf_ptr_t::alloc_zeroed(ser.max_block_size());
+    char *data = static_cast<char *>(buf.cache_data());
+    for (uint16_t i = 0; i < buf.block_size().value(); ++i) {
+        data[i] = 'a' + (i % 7);
+    }
+
+    scoped_ptr_t<file_account_t> account(ser.make_io_account(io_class_t::DEFAULT, 1));
+
+    const block_id_t block_id = 0;
+    std::vector<buf_write_info_t> infos;
+    infos.push_back(buf_write_info_t(buf.ser_buffer(), buf.block_size(), block_id));
+
+    struct : public iocallback_t, public cond_t {
+        void on_io_complete() {
+            pulse();
+        }
+    } cb;
+
+    std::vector<counted_t<block_token_t> > tokens
+        = ser.block_writes(infos.data(), infos.size(), account.get(), &cb);
+    cb.wait();
+    ASSERT_EQ(1u, tokens.size());
+    ASSERT_EQ(buf.block_size(), tokens[0]->block_size());
+    ASSERT_LT(tokens[0]->disk_block_size().ser_value(),
+              tokens[0]->block_size().ser_value());
+
+    {
+        std::vector<index_write_op_t> write_ops;
+        write_ops.push_back(index_write_op_t(block_id, make_optional(tokens[0]),
+                                             make_optional(repli_timestamp_t::distant_past)));
+        new_mutex_in_line_t dummy_acq;
+        ser.index_write(&dummy_acq, []{ }, write_ops);
+    }
+    tokens.clear();
+
+    counted_t<block_token_t> token = ser.index_read(block_id);
+    ASSERT_TRUE(token.has());
+    ASSERT_EQ(buf.block_size(), token->block_size());
+    ASSERT_LT(token->disk_block_size().ser_value(), token->block_size().ser_value());
+
+    buf_ptr_t read_buf = ser.block_read(token, account.get());
+    ASSERT_EQ(buf.block_size(), read_buf.block_size());
+    ASSERT_EQ(block_id, read_buf.ser_buffer()->ser_header.block_id);
+    ASSERT_EQ(0, memcmp(buf.cache_data(), read_buf.cache_data(),
+                        buf.block_size().value()));
+}
+
+TEST(SerializerTest, Crc32c) {
+    // The standard check value of CRC-32C.
+    const char *data = "123456789";
+    EXPECT_EQ(0xe3069283u, crc32c(data, strlen(data)));
+    EXPECT_EQ(0u, crc32c(data, 0));
+
+    // Lengths that aren't a multiple of the word size, at unaligned addresses.
+    char buf[100];
+    for (size_t i = 0; i < sizeof(buf); ++i) {
+        buf[i] = static_cast<char>(i * 7);
+    }
+    EXPECT_NE(crc32c(buf, 99), crc32c(buf + 1, 99));
+    EXPECT_EQ(crc32c(buf + 1, 99), crc32c(std::string(buf + 1, 99).data(), 99));
+}
+
+TPTEST(SerializerTest, ChecksummedBlockRoundTrip, 4) {
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+    log_serializer_t::dynamic_config_t dynamic_config;
+    dynamic_config.compression = block_compression_t::zlib;
+    dynamic_config.checksum_blocks = true;
+    log_serializer_t ser(dynamic_config,
+                         &file_opener,
+                         &get_global_perfmon_collection());
+
+    // One block that gets compressed and one that doesn't, since their checksums
+    // cover different bytes.
+    buf_ptr_t compressible = buf_ptr_t::alloc_zeroed(ser.max_block_size());
+    buf_ptr_t incompressible = buf_ptr_t::alloc_zeroed(ser.max_block_size());
+    char *compressible_data = static_cast<char *>(compressible.cache_data());
+    char *incompressible_data = static_cast<char *>(incompressible.cache_data());
+    uint32_t state = 1;
+    for (uint16_t i = 0; i < compressible.block_size().value(); ++i) {
+        compressible_data[i] = 'a' + (i % 7);
+        state = state * 1103515245 + 12345;
+        incompressible_data[i] = static_cast<char>(state >> 16);
+    }
+
+    scoped_ptr_t<file_account_t> account(ser.make_io_account(io_class_t::DEFAULT, 1));
+
+    std::vector<buf_write_info_t> infos;
+    infos.push_back(buf_write_info_t(compressible.ser_buffer(),
+                                     compressible.block_size(), 0));
+    infos.push_back(buf_write_info_t(incompressible.ser_buffer(),
+                                     incompressible.block_size(), 1));
+
+    struct : public iocallback_t, public cond_t {
+        void on_io_complete() {
+            pulse();
+        }
+    } cb;
+
+    std::vector<counted_t<block_token_t> > tokens
+        = ser.block_writes(infos.data(), infos.size(), account.get(), &cb);
+    cb.wait();
+    ASSERT_EQ(2u, tokens.size());
+    ASSERT_LT(tokens[0]->disk_block_size().ser_value(),
+              tokens[0]->block_size().ser_value());
+    ASSERT_EQ(tokens[1]->disk_block_size().ser_value(),
+              tokens[1]->block_size().ser_value());
+    uint32_t checksums[2];
+    for (size_t i = 0; i < 2; ++i) {
+        checksums[i] = tokens[i]->checksum();
+        ASSERT_NE(NO_BLOCK_CHECKSUM, checksums[i]);
+    }
+
+    {
+        std::vector<index_write_op_t> write_ops;
+        for (block_id_t block_id = 0; block_id < 2; ++block_id) {
+            write_ops.push_back(
+                index_write_op_t(block_id, make_optional(tokens[block_id]),
+                                 make_optional(repli_timestamp_t::distant_past)));
+        }
+        new_mutex_in_line_t dummy_acq;
+        ser.index_write(&dummy_acq, []{ }, write_ops);
+    }
+    tokens.clear();
+
+    const buf_ptr_t *originals[2] = { &compressible, &incompressible };
+    for (block_id_t block_id = 0; block_id < 2; ++block_id) {
+        counted_t<block_token_t> token = ser.index_read(block_id);
+        ASSERT_TRUE(token.has());
+        ASSERT_EQ(checksums[block_id], token->checksum());
+
+        buf_ptr_t read_buf = ser.block_read(token, account.get());
+        ASSERT_EQ(block_id, read_buf.ser_buffer()->ser_header.block_id);
+        ASSERT_EQ(0, memcmp(originals[block_id]->cache_data(), read_buf.cache_data(),
+                            read_buf.block_size().value()));
+    }
+}
+
+TEST(SerializerTest, InMemoryIndexRoundTrip) {
+    in_memory_index_t index;
+
+    repli_timestamp_t early;
+    early.longtime = 10;
+    repli_timestamp_t late;
+    late.longtime = 5000000000ULL;
+    const int64_t large_offset = static_cast<int64_t>(DEVICE_BLOCK_SIZE) << 36;
+
+    index.set_block_info(1, early, flagged_off64_t::make(0), 4096, 1000, 0x12345678);
+    index.set_block_info(2, early, flagged_off64_t::make(large_offset), 4096, 4096,
+                         NO_BLOCK_CHECKSUM);
+    index.set_block_info(FIRST_AUX_BLOCK_ID + 5, repli_timestamp_t::invalid,
+                         flagged_off64_t::make(DEVICE_BLOCK_SIZE * 3), 700, 512,
+                         0xfedcba98);
+
+    index_block_info_t info = index.get_block_info(1);
+    EXPECT_EQ(0, info.offset.get_value());
+    EXPECT_EQ(early, info.recency);
+    EXPECT_EQ(4096, info.ser_block_size);
+    EXPECT_EQ(1000, info.disk_ser_block_size);
+    EXPECT_EQ(0x12345678u, info.checksum);
+    EXPECT_EQ(large_offset, index.get_block_info(2).offset.get_value());
+    EXPECT_EQ(NO_BLOCK_CHECKSUM, index.get_block_info(2).checksum);
+
+    info = index.get_block_info(FIRST_AUX_BLOCK_ID + 5);
+    EXPECT_EQ(DEVICE_BLOCK_SIZE * 3, info.offset.get_value());
+    EXPECT_EQ(repli_timestamp_t::invalid, info.recency);
+    EXPECT_EQ(700, info.ser_block_size);
+    EXPECT_EQ(512, info.disk_ser_block_size);
+    EXPECT_EQ(0xfedcba98u, info.checksum);
+
+    EXPECT_FALSE(index.get_block_info(3).offset.has_value());
+    EXPECT_EQ(repli_timestamp_t::invalid, index.get_block_info(3).recency);
+
+    // A recency far away from the others in its chunk must survive as well.
+    index.set_block_info(3, late, flagged_off64_t::make(DEVICE_BLOCK_SIZE), 4096, 4096,
+                         NO_BLOCK_CHECKSUM);
+    EXPECT_EQ(late, index.get_block_info(3).recency);
+    EXPECT_EQ(early, index.get_block_info(1).recency);
+
+    // Deleting blocks resets their entries.
+    index.set_block_info(1, repli_timestamp_t::invalid, flagged_off64_t::unused(), 0, 0,
+                         NO_BLOCK_CHECKSUM);
+    EXPECT_FALSE(index.get_block_info(1).offset.has_value());
+    EXPECT_EQ(NO_BLOCK_CHECKSUM, index.get_block_info(1).checksum);
+    EXPECT_EQ(repli_timestamp_t::invalid, index.get_block_info(1).recency);
+    EXPECT_EQ(late, index.get_block_info(3).recency);
+}
+
+TPTEST(SerializerTest, BlockBufferPoolReuse, 1) {
+    const block_size_t block_size = block_size_t::unsafe_make(4000);
+    buf_ptr_t buf = buf_ptr_t::alloc_zeroed(block_size);
+    ser_buffer_t *const first = buf.ser_buffer();
+    buf.reset();
+
+    // The freed buffer is handed out again for the next buffer of the same size...
+    buf_ptr_t reused = buf_ptr_t::alloc_zeroed(block_size);
+    ASSERT_EQ(first, reused.ser_buffer());
+    reused.assert_padding_zero();
+
+    // ...but not for one of a different size.
+    scoped_device_block_aligned_ptr_t<ser_buffer_t> other
+        = take_block_buffer(2 * DEVICE_BLOCK_SIZE);
+    ASSERT_NE(first, other.get());
+    give_back_block_buffer(std::move(other), 2 * DEVICE_BLOCK_SIZE);
+}
+
+// Writes a block filled with `fill` and points the index at it.
+static void write_filled_block(log_serializer_t *ser,
+                               file_account_t *account,
+                               block_id_t block_id,
+                               char fill) {
+    buf_ptr_t buf = buf_ptr_t::alloc_zeroed(ser->max_block_size());
+    memset(buf.cache_data(), fill, buf.block_size().value());
+    std::vector<buf_write_info_t> infos;
+    infos.push_back(buf_write_info_t(buf.ser_buffer(), buf.block_size(), block_id));
+
+    struct : public iocallback_t, public cond_t {
+        void on_io_complete() {
+            pulse();
+        }
+    } cb;
+    std::vector<counted_t<block_token_t> > tokens
+        = ser->block_writes(infos.data(), infos.size(), account, &cb);
+    cb.wait();
+
+    repli_timestamp_t recency;
+    recency.longtime = 100 + block_id;
+    std::vector<index_write_op_t> write_ops;
+    write_ops.push_back(index_write_op_t(block_id, make_optional(tokens[0]),
+                                         make_optional(recency)));
+    new_mutex_in_line_t dummy_acq;
+    ser->index_write(&dummy_acq, []{ }, write_ops);
+}
+
+static void delete_block(log_serializer_t *ser, block_id_t block_id) {
+    std::vector<index_write_op_t> write_ops;
+    write_ops.push_back(
+        index_write_op_t(block_id, make_optional(counted_t<block_token_t>())));
+    new_mutex_in_line_t dummy_acq;
+    ser->index_write(&dummy_acq, []{ }, write_ops);
+}
+
+// Returns the fill of each block, with '-' for blocks that don't exist.
+static std::string read_filled_blocks(log_serializer_t *ser,
+                                      file_account_t *account,
+                                      block_id_t end) {
+    std::string fills;
+    for (block_id_t block_id = 0; block_id < end; ++block_id) {
+        counted_t<block_token_t> token = ser->index_read(block_id);
+        if (token.has()) {
+            buf_ptr_t buf = ser->block_read(token, account);
+            fills.push_back(static_cast<char *>(buf.cache_data())[0]);
+        } else {
+            fills.push_back('-');
+        }
+    }
+    return fills;
+}
+
+TPTEST(SerializerTest, SnapshotIgnoresLaterWrites, 4) {
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+    log_serializer_t ser(log_serializer_t::dynamic_config_t(),
+                         &file_opener,
+                         &get_global_perfmon_collection());
+    scoped_ptr_t<file_account_t> account(ser.make_io_account(io_class_t::DEFAULT, 1));
+
+    write_filled_block(&ser, account.get(), 0, 'a');
+    write_filled_block(&ser, account.get(), 1, 'b');
+    write_filled_block(&ser, account.get(), 2, 'c');
+    write_filled_block(&ser, account.get(), 4, 'e');
+
+    std::string fills;
+    {
+        scoped_ptr_t<serializer_snapshot_t> snapshot = ser.make_snapshot();
+        block_id_t block_id;
+        repli_timestamp_t recency;
+        counted_t<block_token_t> token;
+        ASSERT_TRUE(snapshot->next_block(&block_id, &recency, &token));
+        EXPECT_EQ(0u, block_id);
+
+        // Changes to blocks that the snapshot hasn't got to yet don't show up in it.
+        write_filled_block(&ser, account.get(), 0, 'z');
+        write_filled_block(&ser, account.get(), 1, 'y');
+        delete_block(&ser, 2);
+        write_filled_block(&ser, account.get(), 3, 'd');
+        write_filled_block(&ser, account.get(), 5, 'f');
+
+        std::vector<block_id_t> block_ids;
+        do {
+            EXPECT_EQ(100 + block_id, recency.longtime);
+            block_ids.push_back(block_id);
+            fills.push_back(static_cast<char *>(
+                ser.block_read(token, account.get()).cache_data())[0]);
+        } while (snapshot->next_block(&block_id, &recency, &token));
+        EXPECT_EQ((std::vector<block_id_t>{0, 1, 2, 4}), block_ids);
+    }
+    EXPECT_EQ("abce", fills);
+    EXPECT_EQ("zy-def", read_filled_blocks(&ser, account.get(), 6));
+}
+
+void run_BackupRoundTrip(bool compress) {
+    temp_directory_t backup_directory;
+    const std::string backup_path = backup_directory.path().path() + "/backup";
+    cond_t non_interruptor;
+    std::string error;
+
+    {
+        mock_file_opener_t file_opener;
+        log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+        log_serializer_t ser(log_serializer_t::dynamic_config_t(),
+                             &file_opener,
+                             &get_global_perfmon_collection());
+        scoped_ptr_t<file_account_t> account(
+            ser.make_io_account(io_class_t::DEFAULT, 1));
+        for (block_id_t block_id = 0; block_id < 300; ++block_id) {
+            write_filled_block(&ser, account.get(), block_id, 'a' + block_id % 26);
+        }
+        delete_block(&ser, 7);
+        ASSERT_TRUE(write_serializer_backup(
+            &ser, backup_path, compress, &non_interruptor, &error)) << error;
+    }
+
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+    log_serializer_t ser(log_serializer_t::dynamic_config_t(),
+                         &file_opener,
+                         &get_global_perfmon_collection());
+    ASSERT_TRUE(restore_serializer_backup(
+        backup_path, &ser, &non_interruptor, &error)) << error;
+
+    scoped_ptr_t<file_account_t> account(ser.make_io_account(io_class_t::DEFAULT, 1));
+    std::string expected;
+    for (block_id_t block_id = 0; block_id < 300; ++block_id) {
+        expected.push_back(block_id == 7 ? '-' : 'a' + block_id % 26);
+    }
+    EXPECT_EQ(expected, read_filled_blocks(&ser, account.get(), 300));
+    EXPECT_EQ(repli_timestamp_t{142}, ser.get_all_recencies(0, 1)[42]);
+}
+
+TEST(SerializerTest, BackupRoundTrip) {
+    run_in_thread_pool(std::bind(run_BackupRoundTrip, false), 4);
+}
+
+TEST(SerializerTest, CompressedBackupRoundTrip) {
+    run_in_thread_pool(std::bind(run_BackupRoundTrip, true), 4);
+}
 
 }  // namespace unittest
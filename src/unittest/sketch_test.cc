@@ -0,0 +1,73 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/sketch.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+TEST(Sketch, CountDistinct) {
+    ql::hyperloglog_t hll;
+    EXPECT_EQ(0, hll.estimate());
+
+    // Small counts are exact, or nearly so.
+    for (int i = 0; i < 100; ++i) {
+        hll.add(ql::datum_t(static_cast<double>(i % 10)));
+    }
+    EXPECT_NEAR(10, hll.estimate(), 0.5);
+
+    const int num_distinct = 100000;
+    for (int i = 0; i < num_distinct; ++i) {
+        hll.add(ql::datum_t(static_cast<double>(i)));
+        hll.add(ql::datum_t(static_cast<double>(i)));
+    }
+    // Ten times the standard error, so that this doesn't fail by chance.
+    EXPECT_NEAR(num_distinct, hll.estimate(), num_distinct * 0.16);
+}
+
+TEST(Sketch, CountDistinctMerge) {
+    ql::hyperloglog_t left, right, empty;
+    for (int i = 0; i < 30000; ++i) {
+        left.add(ql::datum_t(static_cast<double>(i)));
+    }
+    // Overlaps with `left` for 10000 of its datums
+    for (int i = 20000; i < 50000; ++i) {
+        right.add(ql::datum_t(static_cast<double>(i)));
+    }
+    ql::hyperloglog_t merged;
+    merged.merge(empty);
+    merged.merge(left);
+    merged.merge(right);
+    EXPECT_NEAR(50000, merged.estimate(), 50000 * 0.16);
+}
+
+TEST(Sketch, Quantile) {
+    ql::quantile_sketch_t sketch;
+    EXPECT_TRUE(sketch.empty());
+
+    const int num_values = 100000;
+    // Add the numbers out of order, since the sketch sorts them itself.
+    for (int i = 0; i < num_values; ++i) {
+        sketch.add(static_cast<double>((i * 7919) % num_values));
+    }
+    ASSERT_FALSE(sketch.empty());
+    EXPECT_NEAR(0, sketch.quantile(0), num_values * 0.05);
+    for (double q : {0.01, 0.25, 0.5, 0.75, 0.99}) {
+        EXPECT_NEAR(q * num_values, sketch.quantile(q), num_values * 0.05);
+    }
+    EXPECT_NEAR(num_values, sketch.quantile(1), num_values * 0.05);
+}
+
+TEST(Sketch, QuantileMerge) {
+    // Each "shard" holds a different part of the range
+    std::vector<ql::quantile_sketch_t> shards(4);
+    for (int i = 0; i < 40000; ++i) {
+        shards[i / 10000].add(static_cast<double>(i));
+    }
+    ql::quantile_sketch_t merged;
+    for (const auto &shard : shards) {
+        merged.merge(shard);
+    }
+    EXPECT_NEAR(20000, merged.quantile(0.5), 40000 * 0.05);
+    EXPECT_NEAR(4000, merged.quantile(0.1), 40000 * 0.05);
+}
+
+}  // namespace unittest
@@ -0,0 +1,77 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <string.h>
+
+#include <set>
+#include <vector>
+
+#include "arch/runtime/runtime.hpp"
+#include "concurrency/slab_allocator.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+static const size_t TEST_OBJECT_SIZE = 40;
+
+TEST(SlabAllocatorTest, AllocateAndFree) {
+    slab_allocator_t allocator(TEST_OBJECT_SIZE, "test_objects");
+    run_in_thread_pool([&]() {
+        // Enough to need several slabs
+        const size_t count = 3 * slab_allocator_t::SLAB_SIZE / TEST_OBJECT_SIZE;
+        std::vector<void *> blocks;
+        std::set<void *> distinct;
+        for (size_t i = 0; i < count; ++i) {
+            void *block = allocator.allocate();
+            EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(block) % 16);
+            memset(block, static_cast<int>(i), TEST_OBJECT_SIZE);
+            blocks.push_back(block);
+            distinct.insert(block);
+        }
+        EXPECT_EQ(count, distinct.size());
+        for (size_t i = 0; i < count; ++i) {
+            // Nobody else wrote over our blocks
+            EXPECT_EQ(static_cast<char>(i), static_cast<char *>(blocks[i])[0]);
+            EXPECT_EQ(static_cast<char>(i),
+                      static_cast<char *>(blocks[i])[TEST_OBJECT_SIZE - 1]);
+        }
+        // Freed blocks get reused
+        void *reused = blocks[count / 2];
+        allocator.deallocate(reused);
+        blocks[count / 2] = allocator.allocate();
+        EXPECT_EQ(reused, blocks[count / 2]);
+        for (void *block : blocks) {
+            allocator.deallocate(block);
+        }
+    });
+}
+
+TEST(SlabAllocatorTest, CrossThreadFree) {
+    slab_allocator_t allocator(TEST_OBJECT_SIZE, "test_objects");
+    run_in_thread_pool([&]() {
+        std::vector<void *> blocks;
+        for (size_t i = 0; i < 1000; ++i) {
+            blocks.push_back(allocator.allocate());
+        }
+        {
+            on_thread_t thread_switcher((threadnum_t(1)));
+            for (void *block : blocks) {
+                allocator.deallocate(block);
+            }
+        }
+        // Once the current slab is used up, the blocks that were freed on the other
+        // thread come back to us.
+        std::set<void *> freed(blocks.begin(), blocks.end());
+        std::vector<void *> again;
+        bool got_one_back = false;
+        for (size_t i = 0; i < 2 * slab_allocator_t::SLAB_SIZE / TEST_OBJECT_SIZE; ++i) {
+            again.push_back(allocator.allocate());
+            got_one_back |= freed.count(again.back()) != 0;
+        }
+        EXPECT_TRUE(got_one_back);
+        for (void *block : again) {
+            allocator.deallocate(block);
+        }
+    }, 2);
+}
+
+}  // namespace unittest
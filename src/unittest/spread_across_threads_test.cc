@@ -0,0 +1,48 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <stdexcept>
+#include <vector>
+
+#include "concurrency/spread_across_threads.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+TEST(SpreadAcrossThreadsTest, EachChunkOnce) {
+    int num_threads = 4;
+    run_in_thread_pool([&]() {
+        const size_t num_chunks = 1000;
+        // Each chunk only writes its own entries, so the workers don't race.
+        std::vector<int> calls(num_chunks, 0);
+        std::vector<int> threads(num_chunks, -1);
+        spread_across_threads(num_chunks, num_threads, [&](size_t chunk) {
+            ++calls[chunk];
+            threads[chunk] = get_thread_id().threadnum;
+        });
+        for (size_t i = 0; i < num_chunks; ++i) {
+            EXPECT_EQ(1, calls[i]);
+            EXPECT_LE(0, threads[i]);
+            EXPECT_GT(num_threads, threads[i]);
+        }
+        // Nothing at all to do
+        spread_across_threads(0, num_threads, [&](size_t) {
+            ADD_FAILURE();
+        });
+    }, num_threads);
+}
+
+TEST(SpreadAcrossThreadsTest, Exception) {
+    int num_threads = 4;
+    run_in_thread_pool([&]() {
+        threadnum_t caller = get_thread_id();
+        EXPECT_THROW(spread_across_threads(100, num_threads, [&](size_t chunk) {
+            if (chunk == 7) {
+                throw std::runtime_error("chunk 7");
+            }
+        }), std::runtime_error);
+        // We must be back on the calling thread.
+        EXPECT_EQ(caller, get_thread_id());
+    }, num_threads);
+}
+
+}  // namespace unittest
@@ -0,0 +1,61 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <stdint.h>
+
+#include <atomic>
+#include <set>
+
+#include "arch/io/network.hpp"
+#include "arch/timing.hpp"
+#include "concurrency/cond_var.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+TEST(ThreadedTcpListenerTest, AcceptsOnDbThreads) {
+    int num_threads = 4;
+    run_in_thread_pool([&]() {
+        std::atomic<int> finished(0);
+        std::set<ip_address_t> addresses;
+        addresses.insert(ip_address_t("127.0.0.1"));
+        // Every connection is told which thread it landed on
+        threaded_tcp_listener_t listener(addresses, 0,
+            [&](scoped_ptr_t<tcp_conn_descriptor_t> &nconn) {
+                cond_t non_interruptor;
+                scoped_ptr_t<tcp_conn_t> conn;
+                nconn->make_server_connection(nullptr, &conn, &non_interruptor);
+                int32_t thread = get_thread_id().threadnum;
+                conn->write(&thread, sizeof(thread), &non_interruptor);
+                ++finished;
+            });
+        ASSERT_NE(0, listener.get_port());
+
+        const int num_conns = 32;
+        for (int i = 0; i < num_conns; ++i) {
+            cond_t non_interruptor;
+            tcp_conn_t conn(ip_address_t("127.0.0.1"), listener.get_port(),
+                            &non_interruptor);
+            int32_t thread = -1;
+            conn.read(&thread, sizeof(thread), &non_interruptor);
+            EXPECT_LE(0, thread);
+            EXPECT_GT(get_num_db_threads(), thread);
+        }
+        while (finished.load() < num_conns) {
+            nap(1);
+        }
+    }, num_threads);
+}
+
+TEST(ThreadedTcpListenerTest, PortInUse) {
+    run_in_thread_pool([&]() {
+        std::set<ip_address_t> addresses;
+        addresses.insert(ip_address_t("127.0.0.1"));
+        tcp_listener_t taken(addresses, 0,
+            [](scoped_ptr_t<tcp_conn_descriptor_t> &) { });
+        EXPECT_THROW(threaded_tcp_listener_t(addresses, taken.get_port(),
+                         [](scoped_ptr_t<tcp_conn_descriptor_t> &) { }),
+                     address_in_use_exc_t);
+    }, 2);
+}
+
+}  // namespace unittest
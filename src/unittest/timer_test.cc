@@ -1,7 +1,9 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include <algorithm>
+#include <vector>
 
 #include "arch/timing.hpp"
+#include "containers/scoped.hpp"
 #include "concurrency/pmap.hpp"
 #include "unittest/gtest.hpp"
 #include "unittest/unittest_utils.hpp"
@@ -92,5 +94,23 @@ TPTEST(TimerTest, TestChangeInterval) {
     nap(70);
 }
 
+TPTEST(TimerTest, TestLongTimers) {
+    // These go into the timer wheel rather than straight into the priority queue.
+    std::vector<scoped_ptr_t<signal_timer_t> > cancelled;
+    for (int i = 0; i < 1000; ++i) {
+        cancelled.push_back(make_scoped<signal_timer_t>(1100 + i * 100));
+    }
+    ticks_t t1 = get_ticks();
+    signal_timer_t timer(1200);
+    for (size_t i = 0; i < cancelled.size(); i += 2) {
+        EXPECT_TRUE(cancelled[i]->cancel());
+    }
+    timer.wait_lazily_unordered();
+    ticks_t t2 = get_ticks();
+    int64_t error_ns = (t2.nanos - t1.nanos) - 1200 * MILLION;
+    EXPECT_LT(llabs(error_ns), max_error_ms * MILLION);
+    EXPECT_TRUE(cancelled[1]->is_pulsed());
+    EXPECT_FALSE(cancelled[3]->is_pulsed());
+}
 
 }  // namespace unittest
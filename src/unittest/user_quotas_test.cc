@@ -0,0 +1,30 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "config/args.hpp"
+#include "rdb_protocol/user_quotas.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+TEST(UserQuotas, RateBudgetDebt) {
+    rate_budget_t budget(100, 0);
+    EXPECT_EQ(0u, budget.micros_until_available(0));
+
+    // A full bucket can be overdrawn, and is paid back at the rate.
+    budget.charge(150, 0);
+    microtime_t wait = budget.micros_until_available(0);
+    EXPECT_GE(wait, 500000u);
+    EXPECT_LE(wait, 500001u);
+    EXPECT_GT(budget.micros_until_available(250000), 0u);
+    EXPECT_EQ(0u, budget.micros_until_available(500001));
+}
+
+TEST(UserQuotas, RateBudgetHoldsOneSecond) {
+    rate_budget_t budget(100, 0);
+    // Being idle for a long time doesn't allow a burst of more than a second's worth.
+    budget.charge(250, 10 * MILLION);
+    microtime_t wait = budget.micros_until_available(10 * MILLION);
+    EXPECT_GE(wait, 1500000u);
+    EXPECT_LE(wait, 1500001u);
+}
+
+}  // namespace unittest
@@ -578,4 +578,17 @@ TEST(UTF8IterationTest, Zalgo) {
     ASSERT_EQ(66, seen);
 }
 
+TEST(UTF8ASCIITest, FindsNonASCIIAnywhere) {
+    ASSERT_TRUE(utf8::is_ascii(""));
+    ASSERT_TRUE(utf8::is_ascii(std::string("a tab\tand a delete\x7f")));
+    // Put a non-ASCII byte in both the part that's checked eight bytes at a time and
+    // the part after it.
+    const std::string str(20, 'a');
+    for (size_t i = 0; i < str.size(); ++i) {
+        std::string modified = str;
+        modified[i] = '\x80';
+        ASSERT_FALSE(utf8::is_ascii(modified)) << i;
+    }
+}
+
 } // namespace unittest
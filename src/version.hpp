@@ -21,23 +21,24 @@ enum class cluster_version_t {
     v2_3 = 8,
     v2_4 = 9,
     v2_5 = 10,
+    v2_6 = 11,
 
     // This is used in places where _something_ needs to change when a new cluster
     // version is created.  (Template instantiations, switches on version number,
     // etc.)
-    v2_5_is_latest = v2_5,
+    v2_6_is_latest = v2_6,
 
     // Like the *_is_latest version, but for code that's only concerned with disk
     // serialization. Must be changed whenever LATEST_DISK gets changed.
-    v2_5_is_latest_disk = v2_5,
+    v2_6_is_latest_disk = v2_6,
 
     // The latest version, max of CLUSTER and LATEST_DISK
-    LATEST_OVERALL = v2_5_is_latest,
+    LATEST_OVERALL = v2_6_is_latest,
 
     // The latest version for disk serialization can sometimes be different from the
     // version we use for cluster serialization.  This is also the latest version of
     // ReQL deterministic function behavior.
-    LATEST_DISK = v2_5_is_latest_disk,
+    LATEST_DISK = v2_6_is_latest_disk,
 
     // This exists as long as the clustering code only supports the use of one
     // version.  It uses cluster_version_t::CLUSTER wherever it uses this.
@@ -100,13 +101,15 @@ enum class reql_version_t {
     v2_1 = 4,
     v2_2 = 5,
     v2_3 = 6,
+    // Secondary index keys store UUID primary keys in 16 bytes.
+    v2_6 = 7,
 
     // Code that uses _is_latest may need to be updated when the
     // version changes
-    v2_3_is_latest = v2_3,
+    v2_6_is_latest = v2_6,
 
     EARLIEST = v1_16,
-    LATEST = v2_3_is_latest
+    LATEST = v2_6_is_latest
 };
 
 // Serialization of reql_version_t is defined in protocol_api.hpp.
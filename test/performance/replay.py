@@ -0,0 +1,141 @@
+#!/usr/bin/env python
+# Copyright 2010-2016 RethinkDB, all rights reserved.
+
+'''Replays a query capture against a cluster, and reports the latency distribution.
+
+A capture is recorded by a server started with `--capture-queries file`. Each captured
+client connection gets a connection of its own, which sends its queries at the same
+offsets from the start as they originally arrived, so the replay has the same
+concurrency and pacing as the original workload. Use `--speed` to replay it faster or
+slower.
+
+Queries on the same connection are sent one after the other, so if a query takes
+longer than it did originally, the following queries on that connection are delayed.
+Only the first batch of each query is read, so changefeeds and long cursors don't hold
+up the replay.'''
+
+from __future__ import print_function
+
+import argparse
+import collections
+import json
+import os
+import sys
+import threading
+import time
+
+sys.path.append(os.path.abspath(os.path.join(os.path.dirname(__file__), os.path.pardir, 'common')))
+import utils
+
+r = utils.import_python_driver()
+
+class RawTerm(r.ast.RqlQuery):
+    '''A term that is sent exactly as it was captured.'''
+    def __init__(self, json_term):
+        r.ast.RqlQuery.__init__(self)
+        self.json_term = json_term
+
+    def build(self):
+        return self.json_term
+
+def load_capture(path):
+    connections = collections.OrderedDict()
+    with open(path) as capture:
+        for line in capture:
+            line = line.strip()
+            if not line:
+                continue
+            query = json.loads(line)
+            connections.setdefault(query['connection'], []).append(query)
+    for queries in connections.values():
+        queries.sort(key=lambda query: query['time'])
+    return connections
+
+def percentile(sorted_values, fraction):
+    if not sorted_values:
+        return float('nan')
+    return sorted_values[min(len(sorted_values) - 1, int(fraction * len(sorted_values)))]
+
+def print_distribution(name, latencies):
+    latencies = sorted(latencies)
+    print('%-10s %8d %10.3f %10.3f %10.3f %10.3f %10.3f' % (
+        name, len(latencies), percentile(latencies, 0.5), percentile(latencies, 0.9),
+        percentile(latencies, 0.99), percentile(latencies, 0.999),
+        latencies[-1] if latencies else float('nan')))
+
+class Replayer(threading.Thread):
+    def __init__(self, opts, queries, start_time, results, errors):
+        threading.Thread.__init__(self)
+        self.daemon = True
+        self.opts = opts
+        self.queries = queries
+        self.start_time = start_time
+        self.results = results
+        self.errors = errors
+
+    def run_query(self, conn, query):
+        json_query = query['query']
+        term = RawTerm(json_query[1])
+        optargs = RawTerm(json_query[2] if len(json_query) > 2 else {})
+        q = r.net.Query(r.net.pQuery.START, conn._new_token(), term, optargs)
+        res = conn._instance.run_query(q, query['noreply'])
+        if isinstance(res, r.net.Cursor):
+            res.close()
+
+    def run(self):
+        conn = r.connect(self.opts.host, self.opts.port, user=self.opts.user,
+                         password=self.opts.password)
+        try:
+            for query in self.queries:
+                delay = self.start_time + query['time'] / self.opts.speed - time.time()
+                if delay > 0:
+                    time.sleep(delay)
+                before = time.time()
+                try:
+                    self.run_query(conn, query)
+                except r.ReqlError as ex:
+                    self.errors.append(str(ex))
+                self.results.append((query['latency_ms'], (time.time() - before) * 1000))
+        finally:
+            conn.close(noreply_wait=False)
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('capture', help='the file written by `--capture-queries`')
+    parser.add_argument('--host', default='localhost')
+    parser.add_argument('--port', type=int, default=28015)
+    parser.add_argument('--user', default='admin')
+    parser.add_argument('--password', default='')
+    parser.add_argument('--speed', type=float, default=1.0,
+                        help='how many times faster than the original to replay')
+    opts = parser.parse_args()
+    if opts.speed <= 0:
+        parser.error('--speed must be positive')
+
+    connections = load_capture(opts.capture)
+    num_queries = sum(len(queries) for queries in connections.values())
+    print('Replaying %d queries on %d connections' % (num_queries, len(connections)))
+
+    results = []
+    errors = []
+    start_time = time.time() + 1
+    replayers = [Replayer(opts, queries, start_time, results, errors)
+                 for queries in connections.values()]
+    for replayer in replayers:
+        replayer.start()
+    for replayer in replayers:
+        replayer.join()
+    elapsed = time.time() - start_time
+
+    print('Replayed in %.1f seconds, %d queries failed' % (elapsed, len(errors)))
+    for error in sorted(set(errors))[:10]:
+        print('  %s' % error)
+    print()
+    print('%-10s %8s %10s %10s %10s %10s %10s' %
+          ('latency ms', 'queries', 'p50', 'p90', 'p99', 'p99.9', 'max'))
+    print_distribution('captured', [captured for captured, _ in results])
+    print_distribution('replayed', [replayed for _, replayed in results])
+
+if __name__ == '__main__':
+    main()
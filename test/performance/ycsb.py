@@ -0,0 +1,702 @@
+#!/usr/bin/env python
+# Copyright 2010-2016 RethinkDB, all rights reserved.
+
+'''Runs a standard benchmark suite against a live cluster.
+
+`ycsb.py run` loads a table and runs the YCSB core workloads against it:
+
+  a  50% reads, 50% updates, zipfian keys
+  b  95% reads, 5% updates, zipfian keys
+  c  100% reads, zipfian keys
+  d  95% reads, 5% inserts, reads skewed towards the latest inserts
+  e  95% short range scans, 5% inserts, zipfian start keys
+  f  50% reads, 50% read-modify-writes, zipfian keys
+
+followed by two workloads of our own:
+
+  changefeed  one writer inserts at a fixed rate into a table with `--feeds` open
+              changefeeds, and every feed measures the time from the insert to the
+              change arriving
+  sindex      inserts and updates into a table with `--sindexes` secondary indexes
+
+Each workload runs for `--duration` seconds on `--clients` client processes with a
+connection each, after `--warmup` seconds that aren't measured. The results are
+printed as a table, and with `--output` also written as one JSON object per line: the
+settings first (including the commit and server version they were measured with), and
+then one line per workload and operation with its throughput, percentiles and latency
+histogram.
+
+`ycsb.py compare OLD NEW` compares two such files, and exits with status 1 if
+throughput dropped or the 99th percentile latency went up by more than `--threshold`
+percent in any of them.'''
+
+from __future__ import print_function
+
+import argparse
+import json
+import math
+import multiprocessing
+import os
+import random
+import subprocess
+import sys
+import threading
+import time
+
+sys.path.append(os.path.abspath(os.path.join(os.path.dirname(__file__), os.path.pardir, 'common')))
+import utils
+
+r = utils.import_python_driver()
+
+try:
+    xrange
+except NameError:
+    xrange = range
+
+YCSB_WORKLOADS = {
+    # name: ({operation: proportion}, key distribution)
+    'a': ({'read': 0.5, 'update': 0.5}, 'zipfian'),
+    'b': ({'read': 0.95, 'update': 0.05}, 'zipfian'),
+    'c': ({'read': 1.0}, 'zipfian'),
+    'd': ({'read': 0.95, 'insert': 0.05}, 'latest'),
+    'e': ({'scan': 0.95, 'insert': 0.05}, 'zipfian'),
+    'f': ({'read': 0.5, 'read-modify-write': 0.5}, 'zipfian'),
+}
+
+# The order YCSB recommends, since `d` and `e` grow the table.
+DEFAULT_WORKLOADS = 'a,b,c,f,d,e,changefeed,sindex'
+
+YCSB_TABLE = 'usertable'
+FEED_TABLE = 'feed_target'
+SINDEX_TABLE = 'sindex_target'
+
+MAX_SCAN_LENGTH = 100
+LOAD_BATCH_SIZE = 500
+
+# Inserts of each workload get keys from a range of their own.
+INSERT_KEY_RANGE = 1000000000
+
+# --- Latency histograms
+
+# Latencies are counted in logarithmic buckets of about 12% width, in microseconds.
+BUCKETS_PER_DECADE = 20
+
+def bucket_index(latency_us):
+    return int(math.ceil(math.log10(max(latency_us, 1.0)) * BUCKETS_PER_DECADE))
+
+def bucket_upper_us(index):
+    return 10 ** (float(index) / BUCKETS_PER_DECADE)
+
+class Histogram(object):
+    def __init__(self):
+        self.buckets = {}
+        self.count = 0
+        self.errors = 0
+        self.max_us = 0.0
+
+    def record(self, latency_us):
+        index = bucket_index(latency_us)
+        self.buckets[index] = self.buckets.get(index, 0) + 1
+        self.count += 1
+        self.max_us = max(self.max_us, latency_us)
+
+    def merge(self, other):
+        for index, count in other.buckets.items():
+            self.buckets[index] = self.buckets.get(index, 0) + count
+        self.count += other.count
+        self.errors += other.errors
+        self.max_us = max(self.max_us, other.max_us)
+
+    def percentile(self, fraction):
+        if self.count == 0:
+            return float('nan')
+        rank = max(1, int(math.ceil(fraction * self.count)))
+        seen = 0
+        for index in sorted(self.buckets):
+            seen += self.buckets[index]
+            if seen >= rank:
+                return min(bucket_upper_us(index), self.max_us)
+        return self.max_us
+
+    def to_json(self):
+        return [[round(bucket_upper_us(index), 1), self.buckets[index]]
+                for index in sorted(self.buckets)]
+
+# --- Key choosers
+
+def fnv_hash64(value):
+    '''YCSB scrambles key numbers with FNV-1a so that popular keys aren't adjacent.'''
+    h = 0xcbf29ce484222325
+    for _ in xrange(8):
+        h ^= value & 0xff
+        h = (h * 0x100000001b3) & 0xffffffffffffffff
+        value >>= 8
+    return h
+
+def key_name(number):
+    return 'user%d' % fnv_hash64(number)
+
+class Zipfian(object):
+    '''YCSB's zipfian generator over [0, n), with its default constant of 0.99. `n`
+    can grow, in which case zeta is extended incrementally.'''
+
+    THETA = 0.99
+
+    def __init__(self, n):
+        self.n = 0
+        self.zetan = 0.0
+        self.zeta2 = 1 + 0.5 ** self.THETA
+        self.alpha = 1.0 / (1.0 - self.THETA)
+        self.grow(n)
+
+    def grow(self, n):
+        for i in xrange(self.n, n):
+            self.zetan += 1.0 / ((i + 1) ** self.THETA)
+        self.n = n
+        self.eta = (1 - (2.0 / n) ** (1 - self.THETA)) / (1 - self.zeta2 / self.zetan)
+
+    def next(self, rng):
+        u = rng.random()
+        uz = u * self.zetan
+        if uz < 1.0:
+            return 0
+        if uz < self.zeta2:
+            return 1
+        return min(self.n - 1, int(self.n * (self.eta * u - self.eta + 1) ** self.alpha))
+
+class KeyChooser(object):
+    '''Chooses the key numbers of a client's operations. Keys [0, record_count) were
+    loaded, and the client knows about the keys it inserted itself.'''
+
+    def __init__(self, distribution, record_count, rng):
+        self.distribution = distribution
+        self.record_count = record_count
+        self.inserted = []
+        self.rng = rng
+        self.zipfian = Zipfian(record_count) if distribution != 'uniform' else None
+
+    def num_keys(self):
+        return self.record_count + len(self.inserted)
+
+    def key_at(self, index):
+        if index < self.record_count:
+            return index
+        return self.inserted[index - self.record_count]
+
+    def inserted_key(self, number):
+        self.inserted.append(number)
+        if self.distribution == 'latest':
+            self.zipfian.grow(self.num_keys())
+
+    def next(self):
+        if self.distribution == 'uniform':
+            return self.key_at(self.rng.randrange(self.num_keys()))
+        elif self.distribution == 'latest':
+            return self.key_at(self.num_keys() - 1 - self.zipfian.next(self.rng))
+        else:
+            # Scrambled, so that the popular keys are spread over the table.
+            return fnv_hash64(self.zipfian.next(self.rng)) % self.record_count
+
+# --- Documents
+
+def random_field(rng, length):
+    return ''.join(chr(rng.randrange(32, 127)) for _ in xrange(length))
+
+def make_doc(opts, rng, key):
+    doc = {'id': key}
+    for i in xrange(opts.field_count):
+        doc['field%d' % i] = random_field(rng, opts.field_length)
+    return doc
+
+# --- Clients
+
+def connect(opts):
+    return r.connect(opts.host, opts.port, db=opts.db, user=opts.user,
+                     password=opts.password)
+
+def write_options(opts):
+    return {'durability': opts.durability}
+
+class Client(object):
+    '''Runs the operations of a workload on one connection, and records their
+    latencies until `deadline`. Operations that finish before `measure_from` aren't
+    recorded.'''
+
+    def __init__(self, opts, index, measure_from, deadline):
+        self.opts = opts
+        self.index = index
+        self.measure_from = measure_from
+        self.deadline = deadline
+        self.rng = random.Random(opts.seed * 1000003 + index)
+        self.histograms = {}
+
+    def timed(self, operation, fun):
+        before = time.time()
+        try:
+            fun()
+        except r.ReqlError:
+            if before >= self.measure_from:
+                self.histograms.setdefault(operation, Histogram()).errors += 1
+            return
+        after = time.time()
+        if before >= self.measure_from:
+            self.histograms.setdefault(operation, Histogram()).record(
+                (after - before) * 1e6)
+
+    def run_ycsb(self, conn, name, phase):
+        proportions, distribution = YCSB_WORKLOADS[name]
+        if self.opts.distribution != 'zipfian' and distribution == 'zipfian':
+            distribution = self.opts.distribution
+        keys = KeyChooser(distribution, self.opts.record_count, self.rng)
+        operations = sorted(proportions.items())
+        table = r.table(YCSB_TABLE)
+        next_insert = (self.opts.record_count + phase * INSERT_KEY_RANGE
+                       + self.index)
+
+        while time.time() < self.deadline:
+            pick = self.rng.random()
+            for operation, proportion in operations:
+                pick -= proportion
+                if pick < 0:
+                    break
+
+            if operation == 'read':
+                key = key_name(keys.next())
+                self.timed(operation, lambda: table.get(key).run(conn))
+            elif operation == 'update':
+                key = key_name(keys.next())
+                field = 'field%d' % self.rng.randrange(self.opts.field_count)
+                value = random_field(self.rng, self.opts.field_length)
+                self.timed(operation, lambda: table.get(key).update(
+                    {field: value}, **write_options(self.opts)).run(conn))
+            elif operation == 'insert':
+                number = next_insert
+                next_insert += self.opts.clients
+                doc = make_doc(self.opts, self.rng, key_name(number))
+                self.timed(operation, lambda: table.insert(
+                    doc, **write_options(self.opts)).run(conn))
+                keys.inserted_key(number)
+            elif operation == 'scan':
+                key = key_name(keys.next())
+                length = self.rng.randint(1, MAX_SCAN_LENGTH)
+                self.timed(operation, lambda: list(
+                    table.between(key, r.maxval).order_by(index='id')
+                         .limit(length).run(conn)))
+            elif operation == 'read-modify-write':
+                key = key_name(keys.next())
+                field = 'field%d' % self.rng.randrange(self.opts.field_count)
+                value = random_field(self.rng, self.opts.field_length)
+                def read_modify_write():
+                    doc = table.get(key).run(conn)
+                    if doc is not None:
+                        doc[field] = value
+                        table.get(key).replace(doc, **write_options(self.opts)).run(conn)
+                self.timed(operation, read_modify_write)
+
+    def run_sindex(self, conn):
+        table = r.table(SINDEX_TABLE)
+        inserted = []
+        while time.time() < self.deadline:
+            if not inserted or self.rng.random() < 0.5:
+                doc = make_doc(self.opts, self.rng, r.uuid())
+                res = {}
+                def insert():
+                    res.update(table.insert(doc, **write_options(self.opts)).run(conn))
+                self.timed('insert', insert)
+                inserted.extend(res.get('generated_keys', []))
+            else:
+                key = inserted[self.rng.randrange(len(inserted))]
+                # Changes an indexed field, so every index gets updated.
+                field = 'field%d' % self.rng.randrange(
+                    min(self.opts.sindexes, self.opts.field_count))
+                value = random_field(self.rng, self.opts.field_length)
+                self.timed('update', lambda: table.get(key).update(
+                    {field: value}, **write_options(self.opts)).run(conn))
+
+    def run_feeds(self, conn_count, ready, stop):
+        '''Opens `conn_count` changefeeds and records how long each change took to
+        arrive, until `stop` is set.'''
+        lock = threading.Lock()
+        opened = [0]
+
+        def listen():
+            conn = connect(self.opts)
+            try:
+                feed = r.table(FEED_TABLE).changes().run(conn)
+                with lock:
+                    opened[0] += 1
+                    if opened[0] == conn_count:
+                        ready.set()
+                while not stop.is_set():
+                    try:
+                        change = feed.next(wait=0.5)
+                    except r.ReqlTimeoutError:
+                        continue
+                    now = time.time()
+                    sent = change['new_val']['sent']
+                    if sent >= self.measure_from:
+                        with lock:
+                            self.histograms.setdefault('change', Histogram()).record(
+                                (now - sent) * 1e6)
+            finally:
+                conn.close(noreply_wait=False)
+
+        threads = [threading.Thread(target=listen) for _ in xrange(conn_count)]
+        for thread in threads:
+            thread.daemon = True
+            thread.start()
+        for thread in threads:
+            thread.join()
+
+def client_process(opts, workload, phase, index, measure_from, deadline, results):
+    client = Client(opts, index, measure_from, deadline)
+    conn = connect(opts)
+    try:
+        if workload == 'sindex':
+            client.run_sindex(conn)
+        else:
+            client.run_ycsb(conn, workload, phase)
+    finally:
+        conn.close(noreply_wait=False)
+    results.put(client.histograms)
+
+def feed_process(opts, index, conn_count, measure_from, ready, stop, results):
+    client = Client(opts, index, measure_from, None)
+    client.run_feeds(conn_count, ready, stop)
+    results.put(client.histograms)
+
+def collect(results, count):
+    histograms = {}
+    for _ in xrange(count):
+        for operation, histogram in results.get().items():
+            histograms.setdefault(operation, Histogram()).merge(histogram)
+    return histograms
+
+# --- Setup
+
+def create_table(conn, opts, name, drop=True):
+    if name in r.table_list().run(conn):
+        if not drop:
+            return
+        r.table_drop(name).run(conn)
+    r.table_create(name, shards=opts.shards, replicas=opts.replicas).run(conn)
+    r.table(name).wait().run(conn)
+
+def load_process(opts, index, results):
+    conn = connect(opts)
+    rng = random.Random(opts.seed * 1000003 + index)
+    histogram = Histogram()
+    try:
+        numbers = xrange(index, opts.record_count, opts.clients)
+        batch = []
+        for number in numbers:
+            batch.append(make_doc(opts, rng, key_name(number)))
+            if len(batch) == LOAD_BATCH_SIZE or number + opts.clients >= opts.record_count:
+                before = time.time()
+                r.table(YCSB_TABLE).insert(batch, **write_options(opts)).run(conn)
+                histogram.record((time.time() - before) * 1e6)
+                batch = []
+    finally:
+        conn.close(noreply_wait=False)
+    results.put({'insert-batch': histogram})
+
+def load(opts):
+    conn = connect(opts)
+    try:
+        create_table(conn, opts, YCSB_TABLE)
+    finally:
+        conn.close()
+    results = multiprocessing.Queue()
+    start = time.time()
+    processes = [multiprocessing.Process(target=load_process, args=(opts, i, results))
+                 for i in xrange(opts.clients)]
+    for process in processes:
+        process.start()
+    histograms = collect(results, len(processes))
+    for process in processes:
+        process.join()
+    return histograms, time.time() - start
+
+def run_workload(opts, workload, phase):
+    conn = connect(opts)
+    try:
+        if workload == 'sindex':
+            create_table(conn, opts, SINDEX_TABLE)
+            for i in xrange(min(opts.sindexes, opts.field_count)):
+                r.table(SINDEX_TABLE).index_create('field%d' % i).run(conn)
+            r.table(SINDEX_TABLE).index_wait().run(conn)
+    finally:
+        conn.close()
+
+    results = multiprocessing.Queue()
+    measure_from = time.time() + opts.warmup
+    deadline = measure_from + opts.duration
+    processes = [multiprocessing.Process(
+                     target=client_process,
+                     args=(opts, workload, phase, i, measure_from, deadline, results))
+                 for i in xrange(opts.clients)]
+    for process in processes:
+        process.start()
+    histograms = collect(results, len(processes))
+    for process in processes:
+        process.join()
+    return histograms
+
+def run_changefeed(opts):
+    conn = connect(opts)
+    try:
+        create_table(conn, opts, FEED_TABLE)
+    finally:
+        conn.close()
+
+    # The feeds are spread over the client processes, so that the time they take to
+    # parse the changes doesn't add up in a single one.
+    results = multiprocessing.Queue()
+    stop = multiprocessing.Event()
+    listeners = []
+    counts = [opts.feeds // opts.clients + (1 if i < opts.feeds % opts.clients else 0)
+              for i in xrange(opts.clients)]
+    counts = [count for count in counts if count > 0]
+    events = [multiprocessing.Event() for _ in counts]
+
+    # The listeners need to know when to start measuring before they're started, so we
+    # give them generous time to open their feeds.
+    measure_from = time.time() + 10 + opts.warmup
+    for i, count in enumerate(counts):
+        listeners.append(multiprocessing.Process(
+            target=feed_process,
+            args=(opts, i, count, measure_from, events[i], stop, results)))
+    for listener in listeners:
+        listener.start()
+    for event in events:
+        if not event.wait(10):
+            stop.set()
+            raise RuntimeError('The changefeeds took longer than 10 seconds to open.')
+
+    writer = Client(opts, opts.clients, measure_from, measure_from + opts.duration)
+    conn = connect(opts)
+    try:
+        interval = 1.0 / opts.feed_write_rate
+        next_write = time.time()
+        while time.time() < writer.deadline:
+            delay = next_write - time.time()
+            if delay > 0:
+                time.sleep(delay)
+            next_write += interval
+            doc = {'sent': time.time()}
+            doc['payload'] = random_field(writer.rng, opts.field_length)
+            writer.timed('insert', lambda: r.table(FEED_TABLE).insert(
+                doc, **write_options(opts)).run(conn))
+    finally:
+        conn.close(noreply_wait=False)
+
+    # Let the last changes arrive.
+    time.sleep(1)
+    stop.set()
+    histograms = collect(results, len(listeners))
+    for listener in listeners:
+        listener.join()
+    for operation, histogram in writer.histograms.items():
+        histograms.setdefault(operation, Histogram()).merge(histogram)
+    return histograms
+
+# --- Reporting
+
+PERCENTILES = [('p50', 0.5), ('p90', 0.9), ('p99', 0.99), ('p99.9', 0.999)]
+
+def result_lines(workload, histograms, duration):
+    lines = []
+    for operation in sorted(histograms):
+        histogram = histograms[operation]
+        latency = dict((name, round(histogram.percentile(fraction), 1))
+                       for name, fraction in PERCENTILES)
+        latency['max'] = round(histogram.max_us, 1)
+        lines.append({
+            'workload': workload,
+            'operation': operation,
+            'count': histogram.count,
+            'errors': histogram.errors,
+            'ops_per_sec': round(histogram.count / duration, 1),
+            'latency_us': latency,
+            'histogram': histogram.to_json()})
+    return lines
+
+def print_results(lines):
+    for line in lines:
+        latency = line['latency_us']
+        print('%-10s %-17s %9d %6d %10.1f %9.0f %9.0f %9.0f %9.0f %9.0f' % (
+            line['workload'], line['operation'], line['count'], line['errors'],
+            line['ops_per_sec'], latency['p50'], latency['p90'], latency['p99'],
+            latency['p99.9'], latency['max']))
+    sys.stdout.flush()
+
+def current_commit():
+    try:
+        return subprocess.check_output(
+            ['git', 'rev-parse', 'HEAD'],
+            cwd=os.path.dirname(os.path.abspath(__file__))).decode().strip()
+    except (OSError, subprocess.CalledProcessError):
+        return None
+
+def server_versions(opts):
+    conn = connect(opts)
+    try:
+        return sorted(set(r.db('rethinkdb').table('server_status')['process']['version']
+                          .run(conn)))
+    finally:
+        conn.close()
+
+def run(opts):
+    workloads = [name.strip() for name in opts.workloads.split(',') if name.strip()]
+    for name in workloads:
+        if name not in YCSB_WORKLOADS and name not in ('changefeed', 'sindex'):
+            raise ValueError('Unknown workload `%s`.' % name)
+
+    conn = r.connect(opts.host, opts.port, user=opts.user, password=opts.password)
+    try:
+        if opts.db not in r.db_list().run(conn):
+            r.db_create(opts.db).run(conn)
+    finally:
+        conn.close()
+
+    settings = dict(vars(opts))
+    del settings['password']
+    settings['commit'] = opts.commit or current_commit()
+    settings['server_versions'] = server_versions(opts)
+    settings['time'] = time.strftime('%Y-%m-%dT%H:%M:%S')
+    output = open(opts.output, 'w') if opts.output else None
+    if output:
+        output.write(json.dumps({'settings': settings}) + '\n')
+
+    print('%-10s %-17s %9s %6s %10s %9s %9s %9s %9s %9s' % (
+        'workload', 'operation', 'count', 'errors', 'ops/sec', 'p50 us', 'p90 us',
+        'p99 us', 'p99.9 us', 'max us'))
+
+    def report(lines):
+        print_results(lines)
+        if output:
+            for line in lines:
+                output.write(json.dumps(line) + '\n')
+            output.flush()
+
+    loaded = False
+    for phase, workload in enumerate(workloads):
+        if workload in YCSB_WORKLOADS and not loaded:
+            # The load is reported as a workload of its own, in batches of
+            # `LOAD_BATCH_SIZE` documents.
+            histograms, elapsed = load(opts)
+            report(result_lines('load', histograms, elapsed))
+            loaded = True
+        if workload == 'changefeed':
+            histograms = run_changefeed(opts)
+        else:
+            histograms = run_workload(opts, workload, phase)
+        report(result_lines(workload, histograms, opts.duration))
+    if output:
+        output.close()
+
+def read_results(path):
+    settings = None
+    results = {}
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line:
+                continue
+            obj = json.loads(line)
+            if 'settings' in obj:
+                settings = obj['settings']
+            elif 'latency_us' in obj:
+                results[(obj['workload'], obj['operation'])] = obj
+    return settings, results
+
+def percent_change(old, new):
+    if old == 0:
+        return float('nan')
+    return (new - old) * 100.0 / old
+
+def compare(opts):
+    old_settings, old_results = read_results(opts.old)
+    new_settings, new_results = read_results(opts.new)
+    print('old: %s' % (old_settings or {}).get('commit'))
+    print('new: %s' % (new_settings or {}).get('commit'))
+    print('%-10s %-17s %10s %10s %8s %9s %9s %8s' % (
+        'workload', 'operation', 'old ops/s', 'new ops/s', 'change', 'old p99',
+        'new p99', 'change'))
+    regressions = 0
+    for key in sorted(set(old_results) & set(new_results)):
+        old = old_results[key]
+        new = new_results[key]
+        throughput_change = percent_change(old['ops_per_sec'], new['ops_per_sec'])
+        p99_change = percent_change(old['latency_us']['p99'], new['latency_us']['p99'])
+        regressed = (throughput_change < -opts.threshold
+                     or p99_change > opts.threshold)
+        if regressed:
+            regressions += 1
+        print('%-10s %-17s %10.1f %10.1f %+7.1f%% %9.0f %9.0f %+7.1f%%%s' % (
+            key[0], key[1], old['ops_per_sec'], new['ops_per_sec'], throughput_change,
+            old['latency_us']['p99'], new['latency_us']['p99'], p99_change,
+            '  REGRESSION' if regressed else ''))
+    return 1 if regressions > 0 else 0
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    subparsers = parser.add_subparsers(dest='command')
+
+    run_parser = subparsers.add_parser('run', help='run the benchmark suite')
+    run_parser.add_argument('--host', default='localhost')
+    run_parser.add_argument('--port', type=int, default=28015)
+    run_parser.add_argument('--user', default='admin')
+    run_parser.add_argument('--password', default='')
+    run_parser.add_argument('--db', default='ycsb')
+    run_parser.add_argument('--workloads', default=DEFAULT_WORKLOADS,
+                            help='comma-separated, from a-f, changefeed and sindex')
+    run_parser.add_argument('--record-count', type=int, default=100000)
+    run_parser.add_argument('--field-count', type=int, default=10)
+    run_parser.add_argument('--field-length', type=int, default=100)
+    run_parser.add_argument('--distribution', default='zipfian',
+                            choices=['zipfian', 'uniform'],
+                            help='the key distribution of workloads a-c, e and f')
+    run_parser.add_argument('--clients', type=int, default=8,
+                            help='client processes, with a connection each')
+    run_parser.add_argument('--duration', type=float, default=60,
+                            help='seconds to measure each workload for')
+    run_parser.add_argument('--warmup', type=float, default=10,
+                            help='seconds to run each workload before measuring')
+    run_parser.add_argument('--shards', type=int, default=1)
+    run_parser.add_argument('--replicas', type=int, default=1)
+    run_parser.add_argument('--durability', default='hard', choices=['hard', 'soft'])
+    run_parser.add_argument('--feeds', type=int, default=32,
+                            help='changefeeds to open in the changefeed workload')
+    run_parser.add_argument('--feed-write-rate', type=float, default=100,
+                            help='inserts per second in the changefeed workload')
+    run_parser.add_argument('--sindexes', type=int, default=4,
+                            help='secondary indexes in the sindex workload')
+    run_parser.add_argument('--seed', type=int, default=0)
+    run_parser.add_argument('--commit',
+                            help='the commit the server was built from (defaults to '
+                                 'the commit this script is checked out at)')
+    run_parser.add_argument('--output', help='the file to write the results to')
+
+    compare_parser = subparsers.add_parser('compare', help='compare two result files')
+    compare_parser.add_argument('old')
+    compare_parser.add_argument('new')
+    compare_parser.add_argument('--threshold', type=float, default=5,
+                                help='the percentage that counts as a regression')
+
+    opts = parser.parse_args()
+    if opts.command == 'run':
+        if opts.clients <= 0 or opts.duration <= 0 or opts.warmup < 0:
+            parser.error('--clients and --duration must be positive')
+        if opts.record_count <= 0 or opts.field_count <= 0 or opts.feed_write_rate <= 0:
+            parser.error('--record-count, --field-count and --feed-write-rate must be '
+                         'positive')
+        run(opts)
+    elif opts.command == 'compare':
+        sys.exit(compare(opts))
+    else:
+        parser.print_help()
+
+if __name__ == '__main__':
+    main()